@@ -33,8 +33,14 @@
 #include <cstring>
 #include "Finally.hpp"
 #include "Lv2Log.hpp"
+#include "EventReactor.hpp"
+#include <sys/epoll.h>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <time.h>
+#include <algorithm>
 
 // enumerate alsa sequencer ports
 
@@ -62,13 +68,12 @@ namespace pipedal
             virtual void ConnectPort(const std::string &name) override;
             virtual void SetConfiguration(const AlsaSequencerConfiguration &alsaSequencerConfiguration) override;
 
-            // Read a single MIDI message from the sequencer input port. A timeout of -1 blocks indefinitely.
-            // A timeout of 0 returns immediately.
             virtual bool ReadMessage(AlsaMidiMessage &message, int timeoutMs = -1) override;
 
-            // Get current real-time from the queue (useful for calculating precise timing)
             virtual bool GetQueueRealtime(uint64_t *sec, uint32_t *nsec) override;
 
+            virtual bool WriteMessage(const uint8_t *data, size_t size) override;
+
             virtual void RemoveAllConnections() override;
 
         private:
@@ -78,6 +83,15 @@ namespace pipedal
             int GetQueueId() const { return queueId; }
 
             bool WaitForMessage(int timeoutMs);
+            // Input thread only.
+            bool ReadSequencerMessage(AlsaMidiMessage &message, int timeoutMs);
+            bool ReadQueueRealtime(uint64_t *sec, uint32_t *nsec);
+            void CalibrateQueueClock();
+            void InputThreadProc();
+            void QueueOutputMessage(const uint8_t *data, size_t size);
+            void WriteOutputMessages();
+            void SendOutputMessage(const uint8_t *data, size_t size);
+            void ModifyOutputConnection(snd_seq_t *seq, int clientId, int portId, ConnectAction action);
             // Create an ALSA input queue with real-time timestamps for the given client/port
             int CreateRealtimeInputQueue();
 
@@ -95,6 +109,43 @@ namespace pipedal
             snd_seq_t *seqHandle = nullptr;
             int inPort = -1;
             int queueId = -1; // Queue for real-time timestamps
+
+            // Messages are read from the sequencer by the input thread, and handed to ReadMessage() through
+            // a single-producer/single-consumer ring of fixed-size records, so that the audio thread never
+            // makes sequencer calls, or waits on a lock. WriteMessage() hands messages back the same way.
+            static constexpr size_t MAX_MESSAGE_SIZE = 240;
+            static constexpr size_t INPUT_RING_SIZE = 512; // must be a power of 2.
+            struct MessageRecord
+            {
+                uint64_t realtimeNs;
+                uint32_t timestamp;
+                uint32_t size;
+                uint8_t data[MAX_MESSAGE_SIZE];
+            };
+            std::vector<MessageRecord> inputRing;
+            std::atomic<size_t> inputRingHead{0}; // written by the input thread.
+            std::atomic<size_t> inputRingTail{0}; // written by the reader.
+            bool releaseInputRecord = false;      // the last message read points into the ring.
+            size_t droppedMessages = 0;
+
+            // queue real time - CLOCK_MONOTONIC, so that GetQueueRealtime() doesn't have to query the sequencer.
+            std::atomic<int64_t> queueClockOffsetNs{0};
+            std::atomic<bool> queueClockValid{false};
+
+            std::atomic<bool> terminateInputThread{false};
+            std::unique_ptr<std::jthread> inputThread;
+
+            // MIDI output (input thread only, apart from the ring).
+            static constexpr size_t OUTPUT_RING_SIZE = 256; // must be a power of 2.
+            static constexpr int OUTPUT_INTERVAL_MS = 10;
+            static constexpr size_t MAX_OUTPUT_MESSAGES_PER_INTERVAL = 16; // about what a DIN MIDI port can carry.
+            int outPort = -1;
+            std::vector<MessageRecord> outputRing;
+            std::atomic<size_t> outputRingHead{0}; // written by WriteMessage().
+            std::atomic<size_t> outputRingTail{0}; // written by the input thread.
+            std::vector<MessageRecord> pendingOutput;
+            int16_t lastControlValues[16][128]; // -1 if unknown.
+            snd_midi_event_t *midiEncoder = nullptr;
         };
 
         class AlsaSequencerDeviceMonitorImpl : public AlsaSequencerDeviceMonitor
@@ -110,10 +161,16 @@ namespace pipedal
         private:
             int CreateInputQueue(snd_seq_t *seqHandle, int inPort);
 
+            bool OpenSequencer();
+            void CloseSequencer();
+            // Called on the EventReactor thread.
+            void OnSequencerReady();
+
             bool started = false;
-            void ServiceProc();
-            std::unique_ptr<std::jthread> serviceThread;
-            std::atomic<bool> terminateThread{false};
+            snd_seq_t *seqHandle = nullptr;
+            int inPort = -1;
+            int queueId = -1;
+            std::vector<EventReactor::Handle> reactorHandles;
             Callback callback;
         };
 
@@ -288,6 +345,28 @@ namespace pipedal
         }
         CreateRealtimeInputQueue();
 
+        // for feedback to controllers.
+        outPort = snd_seq_create_simple_port(seqHandle, "PiPedal:out",
+                                             SND_SEQ_PORT_CAP_READ | SND_SEQ_PORT_CAP_SUBS_READ,
+                                             SND_SEQ_PORT_TYPE_MIDI_GENERIC | SND_SEQ_PORT_TYPE_APPLICATION);
+        if (outPort < 0)
+        {
+            Lv2Log::warning("Failed to create ALSA sequencer output port: %s", snd_strerror(outPort));
+        }
+        rc = snd_midi_event_new(MAX_MESSAGE_SIZE, &midiEncoder);
+        if (rc < 0)
+        {
+            midiEncoder = nullptr;
+            Lv2Log::warning("Failed to create ALSA MIDI event encoder: %s", snd_strerror(rc));
+        }
+        for (auto &channelValues : lastControlValues)
+        {
+            for (auto &value : channelValues)
+            {
+                value = -1;
+            }
+        }
+
         snd_seq_nonblock(seqHandle, 1); // Set sequencer to non-blocking mode
 
         // Get our client and port numbers for reference
@@ -296,6 +375,11 @@ namespace pipedal
         {
             throw std::runtime_error(SS("Failed to get client ID: " << snd_strerror(myClientId)));
         }
+        inputRing.resize(INPUT_RING_SIZE);
+        outputRing.resize(OUTPUT_RING_SIZE);
+        CalibrateQueueClock();
+        inputThread = std::make_unique<std::jthread>([this]()
+                                                     { InputThreadProc(); });
     }
     void AlsaSequencerImpl::RemoveAllConnections()
     {
@@ -307,6 +391,9 @@ namespace pipedal
     }
     AlsaSequencerImpl::~AlsaSequencerImpl()
     {
+        terminateInputThread = true;
+        inputThread = nullptr; // (joins)
+
         RemoveAllConnections();
 
         if (queueId >= 0)
@@ -319,6 +406,16 @@ namespace pipedal
             snd_seq_delete_port(seqHandle, inPort);
             inPort = -1;
         }
+        if (outPort >= 0)
+        {
+            snd_seq_delete_port(seqHandle, outPort);
+            outPort = -1;
+        }
+        if (midiEncoder)
+        {
+            snd_midi_event_free(midiEncoder);
+            midiEncoder = nullptr;
+        }
         if (seqHandle)
         {
             Lv2Log::debug("Closing ALSA Sequencer");
@@ -399,6 +496,213 @@ namespace pipedal
         }
     }
     bool AlsaSequencerImpl::ReadMessage(AlsaMidiMessage &message, int timeoutMs)
+    {
+        size_t tail = inputRingTail.load(std::memory_order_relaxed);
+        if (releaseInputRecord)
+        {
+            releaseInputRecord = false;
+            inputRingTail.store(++tail, std::memory_order_release);
+        }
+        if (inputRingHead.load(std::memory_order_acquire) == tail)
+        {
+            if (timeoutMs == 0)
+            {
+                return false;
+            }
+            // Not a realtime caller, so it's ok to sleep while waiting for the input thread.
+            auto startTime = std::chrono::steady_clock::now();
+            while (inputRingHead.load(std::memory_order_acquire) == tail)
+            {
+                if (timeoutMs > 0 && std::chrono::steady_clock::now() - startTime >= std::chrono::milliseconds(timeoutMs))
+                {
+                    return false;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        const MessageRecord &record = inputRing[tail & (INPUT_RING_SIZE - 1)];
+        message.timestamp = record.timestamp;
+        message.realtime_sec = record.realtimeNs / 1000000000ull;
+        message.realtime_nsec = (uint32_t)(record.realtimeNs % 1000000000ull);
+        if (record.size <= sizeof(message.fixedBuffer))
+        {
+            memcpy(message.fixedBuffer, record.data, record.size);
+            message.Set(message.fixedBuffer, record.size);
+            inputRingTail.store(tail + 1, std::memory_order_release);
+        }
+        else
+        {
+            // points into the ring until the next call.
+            message.Set(const_cast<uint8_t *>(record.data), record.size);
+            releaseInputRecord = true;
+        }
+        return true;
+    }
+
+    void AlsaSequencerImpl::InputThreadProc()
+    {
+        AlsaMidiMessage message;
+        auto lastCalibrationTime = std::chrono::steady_clock::now();
+        auto lastOutputTime = lastCalibrationTime;
+        while (!terminateInputThread)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastCalibrationTime >= std::chrono::seconds(1))
+            {
+                lastCalibrationTime = now;
+                CalibrateQueueClock();
+            }
+            if (now - lastOutputTime >= std::chrono::milliseconds(OUTPUT_INTERVAL_MS))
+            {
+                lastOutputTime = now;
+                WriteOutputMessages();
+            }
+            try
+            {
+                if (!ReadSequencerMessage(message, OUTPUT_INTERVAL_MS))
+                {
+                    continue;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::error(SS("ALSA sequencer input error. " << e.what()));
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (message.size == 0)
+            {
+                continue;
+            }
+            if (message.size == 3 && (message.data[0] & 0xF0) == 0xB0)
+            {
+                // the controller already shows this value, so there's no need to send it back.
+                lastControlValues[message.data[0] & 0x0F][message.data[1] & 0x7F] = message.data[2];
+            }
+            if (message.size > MAX_MESSAGE_SIZE)
+            {
+                Lv2Log::debug(SS("ALSA sequencer message discarded: " << message.size << " bytes is too large."));
+                continue;
+            }
+            size_t head = inputRingHead.load(std::memory_order_relaxed);
+            if (head - inputRingTail.load(std::memory_order_acquire) >= INPUT_RING_SIZE)
+            {
+                if (droppedMessages++ == 0)
+                {
+                    Lv2Log::warning("ALSA sequencer input overrun. MIDI messages have been discarded.");
+                }
+                continue;
+            }
+            MessageRecord &record = inputRing[head & (INPUT_RING_SIZE - 1)];
+            record.realtimeNs = message.RealtimeNs();
+            record.timestamp = message.timestamp;
+            record.size = (uint32_t)message.size;
+            memcpy(record.data, message.data, message.size);
+            inputRingHead.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    bool AlsaSequencerImpl::WriteMessage(const uint8_t *data, size_t size)
+    {
+        if (size == 0 || size > MAX_MESSAGE_SIZE)
+        {
+            return false;
+        }
+        size_t head = outputRingHead.load(std::memory_order_relaxed);
+        if (head - outputRingTail.load(std::memory_order_acquire) >= OUTPUT_RING_SIZE)
+        {
+            return false; // full.
+        }
+        MessageRecord &record = outputRing[head & (OUTPUT_RING_SIZE - 1)];
+        record.realtimeNs = 0;
+        record.timestamp = 0;
+        record.size = (uint32_t)size;
+        memcpy(record.data, data, size);
+        outputRingHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void AlsaSequencerImpl::QueueOutputMessage(const uint8_t *data, size_t size)
+    {
+        uint8_t messageType = data[0] & 0xF0;
+        bool isControl = size >= 2 && (messageType == 0xA0 || messageType == 0xB0);
+        bool isChannelValue = size >= 2 && (messageType == 0xD0 || messageType == 0xE0);
+        if (isControl || isChannelValue)
+        {
+            // only the latest value of a control is worth sending.
+            for (auto &pending : pendingOutput)
+            {
+                if (pending.size == size && pending.data[0] == data[0] && (isChannelValue || pending.data[1] == data[1]))
+                {
+                    memcpy(pending.data, data, size);
+                    return;
+                }
+            }
+        }
+        MessageRecord record;
+        record.realtimeNs = 0;
+        record.timestamp = 0;
+        record.size = (uint32_t)size;
+        memcpy(record.data, data, size);
+        pendingOutput.push_back(record);
+    }
+
+    void AlsaSequencerImpl::WriteOutputMessages()
+    {
+        size_t tail = outputRingTail.load(std::memory_order_relaxed);
+        size_t head = outputRingHead.load(std::memory_order_acquire);
+        for (; tail != head; ++tail)
+        {
+            const MessageRecord &record = outputRing[tail & (OUTPUT_RING_SIZE - 1)];
+            QueueOutputMessage(record.data, record.size);
+        }
+        outputRingTail.store(tail, std::memory_order_release);
+
+        if (pendingOutput.empty())
+        {
+            return;
+        }
+        // rate-limited, so that a sweep doesn't flood the device. The rest go next time.
+        size_t nMessages = std::min(pendingOutput.size(), MAX_OUTPUT_MESSAGES_PER_INTERVAL);
+        for (size_t i = 0; i < nMessages; ++i)
+        {
+            const MessageRecord &record = pendingOutput[i];
+            if (record.size == 3 && (record.data[0] & 0xF0) == 0xB0)
+            {
+                int16_t &lastValue = lastControlValues[record.data[0] & 0x0F][record.data[1] & 0x7F];
+                if (lastValue == record.data[2])
+                {
+                    continue;
+                }
+                lastValue = record.data[2];
+            }
+            SendOutputMessage(record.data, record.size);
+        }
+        pendingOutput.erase(pendingOutput.begin(), pendingOutput.begin() + nMessages);
+        snd_seq_drain_output(seqHandle);
+    }
+
+    void AlsaSequencerImpl::SendOutputMessage(const uint8_t *data, size_t size)
+    {
+        if (outPort < 0 || !midiEncoder)
+        {
+            return;
+        }
+        snd_seq_event_t event;
+        snd_seq_ev_clear(&event);
+        snd_midi_event_reset_encode(midiEncoder);
+        long rc = snd_midi_event_encode(midiEncoder, data, (long)size, &event);
+        if (rc <= 0 || event.type == SND_SEQ_EVENT_NONE)
+        {
+            return;
+        }
+        snd_seq_ev_set_source(&event, outPort);
+        snd_seq_ev_set_subs(&event);
+        snd_seq_ev_set_direct(&event);
+        snd_seq_event_output(seqHandle, &event);
+    }
+
+    bool AlsaSequencerImpl::ReadSequencerMessage(AlsaMidiMessage &message, int timeoutMs)
     {
         // Event loop
         snd_seq_event_t *event = nullptr;
@@ -708,7 +1012,40 @@ namespace pipedal
 
         return queueId;
     }
+    static int64_t MonotonicNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+    }
+
+    void AlsaSequencerImpl::CalibrateQueueClock()
+    {
+        uint64_t sec;
+        uint32_t nsec;
+        if (ReadQueueRealtime(&sec, &nsec))
+        {
+            int64_t queueNs = (int64_t)(sec * 1000000000ull + nsec);
+            queueClockOffsetNs.store(queueNs - MonotonicNs(), std::memory_order_relaxed);
+            queueClockValid.store(true, std::memory_order_release);
+        }
+    }
+
     bool AlsaSequencerImpl::GetQueueRealtime(uint64_t *sec, uint32_t *nsec)
+    {
+        if (!queueClockValid.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        uint64_t queueNs = (uint64_t)(MonotonicNs() + queueClockOffsetNs.load(std::memory_order_relaxed));
+        if (sec)
+            *sec = queueNs / 1000000000ull;
+        if (nsec)
+            *nsec = (uint32_t)(queueNs % 1000000000ull);
+        return true;
+    }
+
+    bool AlsaSequencerImpl::ReadQueueRealtime(uint64_t *sec, uint32_t *nsec)
     {
         if (!seqHandle || queueId < 0)
         {
@@ -795,6 +1132,7 @@ namespace pipedal
                         snd_strerror(rc));
                 }
             }
+            ModifyOutputConnection(seq, clientId, portId, action);
             for (auto it = this->connections.begin(); it != this->connections.end(); ++it)
             {
                 if (it->clientId == clientId && it->portId == portId)
@@ -820,6 +1158,57 @@ namespace pipedal
                 return;
             }
             this->connections.push_back({clientId, portId});
+            ModifyOutputConnection(seq, clientId, portId, action);
+        }
+    }
+
+    void AlsaSequencerImpl::ModifyOutputConnection(snd_seq_t *seq, int clientId, int portId, ConnectAction action)
+    {
+        // Best effort: feedback only goes to devices that accept input.
+        if (outPort < 0)
+        {
+            return;
+        }
+        snd_seq_port_info_t *portInfo;
+        snd_seq_port_info_alloca(&portInfo);
+        if (snd_seq_get_any_port_info(seq, clientId, portId, portInfo) < 0)
+        {
+            return;
+        }
+        if ((snd_seq_port_info_get_capability(portInfo) & SND_SEQ_PORT_CAP_SUBS_WRITE) == 0)
+        {
+            return;
+        }
+
+        snd_seq_addr_t sender, dest;
+        sender.client = myClientId;
+        sender.port = outPort;
+        dest.client = clientId;
+        dest.port = portId;
+
+        snd_seq_port_subscribe_t *subs;
+        snd_seq_port_subscribe_alloca(&subs);
+        snd_seq_port_subscribe_set_sender(subs, &sender);
+        snd_seq_port_subscribe_set_dest(subs, &dest);
+        snd_seq_port_subscribe_set_exclusive(subs, 0);
+
+        bool subscribed = snd_seq_get_port_subscription(seq, subs) == 0;
+        if (action == ConnectAction::Unsubscribe)
+        {
+            if (subscribed)
+            {
+                snd_seq_unsubscribe_port(seq, subs);
+            }
+        }
+        else if (!subscribed)
+        {
+            int rc = snd_seq_subscribe_port(seq, subs);
+            if (rc < 0)
+            {
+                Lv2Log::warning("Failed to connect MIDI output to ALSA sequencer port %d:%d. (%s)",
+                                (int)clientId, (int)portId,
+                                snd_strerror(rc));
+            }
         }
     }
 
@@ -831,62 +1220,61 @@ namespace pipedal
     void AlsaSequencerDeviceMonitorImpl::StartMonitoring(
         Callback &&onChangeCallback)
     {
+        if (started)
+        {
+            StopMonitoring();
+        }
         started = true;
         this->callback = std::move(onChangeCallback);
-        this->serviceThread = std::make_unique<std::jthread>(
-            [this]()
-            {
-                ServiceProc();
-            });
+        if (!OpenSequencer())
+        {
+            CloseSequencer();
+            return;
+        }
+        // Announcements arrive on the shared reactor thread; there's no dedicated monitor thread.
+        std::vector<struct pollfd> pollFds;
+        int nPollFds = snd_seq_poll_descriptors_count(seqHandle, POLLIN);
+        pollFds.resize(nPollFds);
+        snd_seq_poll_descriptors(seqHandle, pollFds.data(), nPollFds, POLLIN);
+
+        auto &reactor = EventReactor::GetInstance();
+        for (const auto &pollFd : pollFds)
+        {
+            reactorHandles.push_back(
+                reactor.AddFd(pollFd.fd, EPOLLIN, [this](uint32_t)
+                              { OnSequencerReady(); }));
+        }
     }
-    void AlsaSequencerDeviceMonitorImpl::ServiceProc()
+
+    bool AlsaSequencerDeviceMonitorImpl::OpenSequencer()
     {
         int err;
-        snd_seq_t *seqHandle;
 
         err = snd_seq_open(&seqHandle, "default", SND_SEQ_OPEN_DUPLEX, 0);
-
-        Finally seq_finally(
-            [seqHandle]()
-            {
-                snd_seq_close(seqHandle);
-            });
         if (err < 0)
         {
+            seqHandle = nullptr;
             Lv2Log::error("Error opening ALSA Device Monitor sequencer: %s", snd_strerror(err));
-            return;
+            return false;
         }
         snd_seq_set_client_name(seqHandle, "Device Monitor");
 
-        int inPort = snd_seq_create_simple_port(
+        inPort = snd_seq_create_simple_port(
             seqHandle, "PiPedal:portMonitor",
                         SND_SEQ_PORT_CAP_WRITE | SND_SEQ_PORT_CAP_SUBS_WRITE,
                         SND_SEQ_PORT_TYPE_APPLICATION);
         if (inPort < 0)
         {
             Lv2Log::error("Error creating ALSA Device Monitor port: %s", snd_strerror(inPort));
-            return;
+            return false;
         }
-        Finally inPort_finaly {
-            [seqHandle, inPort]()
-            {
-                snd_seq_delete_port(seqHandle, inPort);
-            }
-        };
-
-        // Set client name
 
-        int queueId = CreateInputQueue(seqHandle,inPort);
+        queueId = CreateInputQueue(seqHandle,inPort);
         if (queueId < 0)
         {
             Lv2Log::error("Error creating ALSA Device Monitor queue: %s", snd_strerror(queueId));
-            return;
+            return false;
         }
-        Finally queue_finally(
-            [seqHandle, queueId]()
-            {
-                snd_seq_free_queue(seqHandle, queueId);
-            }); 
 
         // Subscribe to system announcements
         snd_seq_port_subscribe_t *subscription;
@@ -904,45 +1292,53 @@ namespace pipedal
         if (err < 0)
         {
             Lv2Log::error("Failed to subscribe to ALSA sequencer announcements: %s", snd_strerror(err));
-            return;
+            return false;
         }
 
-        // Create poll descriptors
-        std::vector<struct pollfd> pollFds;
-
         snd_seq_nonblock(seqHandle, 1); // Set sequencer to non-blocking mode
-        while (!terminateThread)
+        return true;
+    }
+
+    void AlsaSequencerDeviceMonitorImpl::CloseSequencer()
+    {
+        if (seqHandle)
         {
-            int nPollFds = snd_seq_poll_descriptors_count(seqHandle, POLLIN);
-            pollFds.resize(nPollFds);
-            snd_seq_poll_descriptors(seqHandle, pollFds.data(), nPollFds, POLLIN);
+            if (queueId >= 0)
+            {
+                snd_seq_free_queue(seqHandle, queueId);
+                queueId = -1;
+            }
+            if (inPort >= 0)
+            {
+                snd_seq_delete_port(seqHandle, inPort);
+                inPort = -1;
+            }
+            snd_seq_close(seqHandle);
+            seqHandle = nullptr;
+        }
+    }
 
-            // Poll for events
-            if (poll(pollFds.data(), nPollFds, 100) > 0)
+    void AlsaSequencerDeviceMonitorImpl::OnSequencerReady()
+    {
+        snd_seq_event_t *event;
+        while (snd_seq_event_input(seqHandle, &event) > 0)
+        {
+            if (event->type == SND_SEQ_EVENT_CLIENT_START)
             {
-                snd_seq_event_t *event;
-                while (snd_seq_event_input(seqHandle, &event) > 0)
-                {
-                    if (event->type == SND_SEQ_EVENT_CLIENT_START)
-                    {
-                        // Get the client name for logging/debugging
-                        snd_seq_client_info_t *client_info;
-                        snd_seq_client_info_alloca(&client_info);
-                        if (snd_seq_get_any_client_info(seqHandle, event->data.addr.client, client_info) >= 0) {
-                            std::string clientName = snd_seq_client_info_get_name(client_info);
-                            callback(MonitorAction::DeviceAdded, event->data.addr.client, clientName);
-                        }
-                    }
-                    else if (event->type == SND_SEQ_EVENT_CLIENT_EXIT)
-                    {
-                        callback(MonitorAction::DeviceRemoved, event->data.addr.client,"");
-                    }
-                    snd_seq_free_event(event);
+                // Get the client name for logging/debugging
+                snd_seq_client_info_t *client_info;
+                snd_seq_client_info_alloca(&client_info);
+                if (snd_seq_get_any_client_info(seqHandle, event->data.addr.client, client_info) >= 0) {
+                    std::string clientName = snd_seq_client_info_get_name(client_info);
+                    callback(MonitorAction::DeviceAdded, event->data.addr.client, clientName);
                 }
             }
+            else if (event->type == SND_SEQ_EVENT_CLIENT_EXIT)
+            {
+                callback(MonitorAction::DeviceRemoved, event->data.addr.client,"");
+            }
+            snd_seq_free_event(event);
         }
-
-        return;
     }
 
     void AlsaSequencerDeviceMonitorImpl::StopMonitoring()
@@ -950,8 +1346,13 @@ namespace pipedal
         if (started)
         {
             started = false;
-            terminateThread = true;
-            serviceThread = nullptr; // (joins)
+            auto &reactor = EventReactor::GetInstance();
+            for (auto handle : reactorHandles)
+            {
+                reactor.Remove(handle); // (waits for in-flight callbacks)
+            }
+            reactorHandles.clear();
+            CloseSequencer();
         }
     }
 
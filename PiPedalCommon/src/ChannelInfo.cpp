@@ -2,6 +2,8 @@
 #include "WifiRegulations.hpp"
 #include "RegDb.hpp"
 #include <set>
+#include <map>
+#include <mutex>
 #include <algorithm>
 #include "ss.hpp"
 
@@ -168,9 +170,33 @@ static bool BandwidthPermitted(int32_t frequency,WifiBandwidth bandwidth, const
     return true;
 }
 
-WifiInfo pipedal::getWifiInfo(const std::string&countryIso3661)
+// Channel lists are memoized per country (and per bandwidth limit), for the RegDb instance they were
+// computed from. A new RegDb instance (the file was updated) discards them.
+namespace
+{
+    struct ChannelCache
+    {
+        std::mutex mutex;
+        const RegDb *regDb = nullptr;
+        std::map<std::string, WifiInfo> wifiInfo;
+        std::map<std::pair<std::string, WifiBandwidth>, std::vector<int32_t>> validChannels;
+
+        // call with the mutex held.
+        void Validate(const RegDb *currentRegDb)
+        {
+            if (regDb != currentRegDb)
+            {
+                regDb = currentRegDb;
+                wifiInfo.clear();
+                validChannels.clear();
+            }
+        }
+    };
+    ChannelCache channelCache;
+}
+
+static WifiInfo LoadWifiInfo(const RegDb &regDb, const std::string&countryIso3661)
 {
-    const RegDb &regDb = RegDb::GetInstance();
     const WifiRegulations &regulations = regDb.getWifiRegulations(countryIso3661);
 
     WifiInfo info;
@@ -242,6 +268,20 @@ WifiInfo pipedal::getWifiInfo(const std::string&countryIso3661)
     return info;
 }
 
+WifiInfo pipedal::getWifiInfo(const std::string&countryIso3661)
+{
+    const RegDb &regDb = RegDb::GetInstance();
+
+    std::lock_guard<std::mutex> lock(channelCache.mutex);
+    channelCache.Validate(&regDb);
+    auto i = channelCache.wifiInfo.find(countryIso3661);
+    if (i == channelCache.wifiInfo.end())
+    {
+        i = channelCache.wifiInfo.emplace(countryIso3661, LoadWifiInfo(regDb, countryIso3661)).first;
+    }
+    return i->second;
+}
+
 
 std::vector<int32_t> pipedal::getValidChannels(const std::string&countryIso3661,int32_t maxChannelWidthMhz)
 {
@@ -263,6 +303,15 @@ std::vector<int32_t> pipedal::getValidChannels(const std::string&countryIso3661,
         maxBandwidth = WifiBandwidth::BW160;
     } 
     RegDb &regDb = RegDb::GetInstance();
+    {
+        std::lock_guard<std::mutex> lock(channelCache.mutex);
+        channelCache.Validate(&regDb);
+        auto i = channelCache.validChannels.find(std::make_pair(countryIso3661, maxBandwidth));
+        if (i != channelCache.validChannels.end())
+        {
+            return i->second;
+        }
+    }
     auto info = pipedal::getWifiInfo(countryIso3661);
 
     for (const auto&channelInfo: info.channels)
@@ -278,6 +327,10 @@ std::vector<int32_t> pipedal::getValidChannels(const std::string&countryIso3661,
         result.push_back(v);
     }
     std::sort(result.begin(),result.end());
+
+    std::lock_guard<std::mutex> lock(channelCache.mutex);
+    channelCache.Validate(&regDb);
+    channelCache.validChannels[std::make_pair(countryIso3661, maxBandwidth)] = result;
     return result;
 }
 int32_t pipedal::getWifiRegClass(const std::string &countryIso3661, int32_t channel, int32_t maxChannelWidthMhz)
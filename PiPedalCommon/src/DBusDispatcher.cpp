@@ -6,6 +6,7 @@
 #include "ss.hpp"
 #include <chrono>
 #include <cassert>
+#include <limits>
 #include "util.hpp"
 
 DBusDispatcher::DBusDispatcher(bool systemBus)
@@ -168,14 +169,11 @@ void DBusDispatcher::ThreadProc()
                 pollFds[1].revents = 0;
                 int pollTimeout = pollData.getPollTimeout();
                 int eventTimeout = GetEventTimeoutMs();
-                if (eventTimeout != -1 && eventTimeout < pollTimeout)
+                if (eventTimeout != -1 && (pollTimeout == -1 || eventTimeout < pollTimeout))
                 {
-                    pollTimeout = eventTimeout; /*+-*/
-                }
-                if (pollTimeout > 250 || pollTimeout == -1)
-                {
-                    pollTimeout = 250; // poll for quit every 250 ms.
+                    pollTimeout = eventTimeout;
                 }
+                // No upper bound: Post, Stop and SignalStop all signal eventFd, so an idle dispatcher never wakes.
                 if (pollTimeout != 0)
                 {
                     poll(pollFds, 2, pollTimeout);
@@ -239,6 +237,7 @@ void DBusDispatcher::SignalStop(std::function<void(void)> &&callback)
     this->signalStopCallback = std::move(callback);
     std::atomic_thread_fence(::std::memory_order::release);
     this->signalStopRequested = true;
+    WakeThread(); // write() on an eventfd is async-signal-safe.
 }
 
 int DBusDispatcher::GetEventTimeoutMs()
@@ -260,10 +259,11 @@ int DBusDispatcher::GetEventTimeoutMs()
         return -1;
     }
     auto clockDuration = nextTime - clock::now();
-    auto durationMs = std::chrono::duration_cast<std::chrono::milliseconds>(clockDuration);
+    // round up, so that we don't wake just before the deadline and spin.
+    auto durationMs = std::chrono::ceil<std::chrono::milliseconds>(clockDuration);
     auto ticks = durationMs.count();
-    if (ticks > 250)
-        return 250;
+    if (ticks > std::numeric_limits<int>::max())
+        return std::numeric_limits<int>::max();
     if (ticks < 0)
         return 0;
     return (int)ticks;
@@ -0,0 +1,245 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "EventReactor.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+// Matches the nice value of other background service threads.
+static constexpr int NICE_REACTOR_THREAD_PRIORITY = 10;
+
+EventReactor &EventReactor::GetInstance()
+{
+    static EventReactor instance;
+    return instance;
+}
+
+EventReactor::EventReactor(const std::string &threadName)
+    : threadName(threadName)
+{
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1)
+    {
+        throw std::runtime_error(SS("EventReactor: epoll_create1 failed. " << strerror(errno)));
+    }
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd == -1)
+    {
+        close(epollFd);
+        throw std::runtime_error(SS("EventReactor: eventfd failed. " << strerror(errno)));
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_HANDLE;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+
+    thread = std::thread([this]()
+                         { ThreadProc(); });
+    threadId = thread.get_id();
+}
+
+EventReactor::~EventReactor()
+{
+    Stop();
+    for (auto &pair : entries)
+    {
+        if (pair.second->isTimer)
+        {
+            close(pair.second->fd);
+        }
+    }
+    entries.clear();
+    close(wakeFd);
+    close(epollFd);
+}
+
+void EventReactor::Stop()
+{
+    if (thread.joinable())
+    {
+        terminateThread = true;
+        uint64_t val = 1;
+        std::ignore = write(wakeFd, &val, sizeof(val));
+        thread.join();
+    }
+}
+
+EventReactor::Handle EventReactor::AddEntry(std::shared_ptr<Entry> entry, uint32_t epollEvents)
+{
+    std::lock_guard lock{entriesMutex};
+    Handle handle = nextHandle++;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = epollEvents;
+    event.data.u64 = handle;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, entry->fd, &event) == -1)
+    {
+        throw std::runtime_error(SS("EventReactor: epoll_ctl failed. " << strerror(errno)));
+    }
+    entries[handle] = std::move(entry);
+    return handle;
+}
+
+EventReactor::Handle EventReactor::AddFd(int fd, uint32_t epollEvents, FdCallback &&callback)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->fd = fd;
+    entry->callback = std::move(callback);
+    return AddEntry(std::move(entry), epollEvents);
+}
+
+EventReactor::Handle EventReactor::AddTimer(clock::duration delay, TimerCallback &&callback)
+{
+    int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd == -1)
+    {
+        throw std::runtime_error(SS("EventReactor: timerfd_create failed. " << strerror(errno)));
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(delay).count();
+    if (ns <= 0)
+    {
+        ns = 1; // a zero it_value disarms the timer.
+    }
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+
+    auto entry = std::make_shared<Entry>();
+    entry->fd = timerFd;
+    entry->isTimer = true;
+    entry->callback = [callback = std::move(callback)](uint32_t)
+    {
+        callback();
+    };
+    try
+    {
+        return AddEntry(std::move(entry), EPOLLIN);
+    }
+    catch (const std::exception &)
+    {
+        close(timerFd);
+        throw;
+    }
+}
+
+bool EventReactor::Remove(Handle handle)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard lock{entriesMutex};
+        auto f = entries.find(handle);
+        if (f == entries.end())
+        {
+            return false;
+        }
+        entry = std::move(f->second);
+        entries.erase(f);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, entry->fd, nullptr);
+    }
+    if (entry->isTimer)
+    {
+        close(entry->fd);
+    }
+    if (std::this_thread::get_id() != threadId)
+    {
+        // wait for any in-flight callback to complete.
+        std::lock_guard dispatchLock{dispatchMutex};
+    }
+    return true;
+}
+
+void EventReactor::ThreadProc()
+{
+    SetThreadName(threadName);
+    if (setpriority(PRIO_PROCESS, (id_t)gettid(), NICE_REACTOR_THREAD_PRIORITY) != 0)
+    {
+        Lv2Log::warning("EventReactor: Failed to set thread priority.");
+    }
+
+    constexpr int MAX_EVENTS = 16;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!terminateThread)
+    {
+        int nEvents = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (nEvents == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Lv2Log::error(SS("EventReactor: epoll_wait failed. " << strerror(errno)));
+            break;
+        }
+        std::lock_guard dispatchLock{dispatchMutex};
+        for (int i = 0; i < nEvents; ++i)
+        {
+            Handle handle = events[i].data.u64;
+            if (handle == WAKE_HANDLE)
+            {
+                uint64_t counter;
+                std::ignore = read(wakeFd, &counter, sizeof(counter));
+                continue;
+            }
+            std::shared_ptr<Entry> entry;
+            {
+                std::lock_guard lock{entriesMutex};
+                auto f = entries.find(handle);
+                if (f == entries.end())
+                {
+                    continue; // removed after epoll_wait returned.
+                }
+                entry = f->second;
+                if (entry->isTimer)
+                {
+                    // one-shot.
+                    entries.erase(f);
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, entry->fd, nullptr);
+                }
+            }
+            if (entry->isTimer)
+            {
+                close(entry->fd);
+            }
+            try
+            {
+                entry->callback(events[i].events);
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::error(SS("EventReactor: Unhandled exception in callback. " << e.what()));
+            }
+        }
+    }
+}
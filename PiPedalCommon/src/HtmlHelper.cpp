@@ -385,6 +385,6 @@ std::string HtmlHelper::generateEtag(const std::filesystem::path &path)
     uint64_t crc = 0;
     crc = crc64(path.string());
     auto fTime = std::filesystem::last_write_time(path);
-    crc = crc64((uint8_t*)&fTime, sizeof(fTime));
+    crc = crc64((uint8_t*)&fTime, sizeof(fTime), crc);
     return std::to_string(crc);
 }
@@ -31,6 +31,7 @@
 #include <algorithm>
 #include <array>
 #include <memory>
+#include <mutex>
 #include "json_variant.hpp"
 #include "json.hpp"
 
@@ -44,26 +45,54 @@
 using namespace pipedal;
 using namespace std;
 
+static std::mutex g_InstanceMutex;
 static std::unique_ptr<RegDb> g_Instance;
+// Callers may still hold references to replaced instances. The file only changes when
+// the wireless-regdb package is upgraded, so there won't be many.
+static std::vector<std::unique_ptr<RegDb>> g_RetiredInstances;
+
 RegDb &RegDb::GetInstance()
 {
-    if (!g_Instance)
+    std::lock_guard<std::mutex> lock(g_InstanceMutex);
+    if (g_Instance && g_Instance->IsCurrent())
+    {
+        return *g_Instance;
+    }
+    try
     {
-        g_Instance = std::make_unique<RegDb>();
+        auto instance = std::make_unique<RegDb>();
+        if (g_Instance)
+        {
+            g_RetiredInstances.push_back(std::move(g_Instance));
+        }
+        g_Instance = std::move(instance);
+    }
+    catch (const std::exception &)
+    {
+        if (!g_Instance)
+        {
+            throw;
+        }
+        // e.g. caught mid-upgrade. Keep using the previous database.
     }
     return *g_Instance;
 }
 
+bool RegDb::IsCurrent() const
+{
+    std::error_code ec;
+    auto currentWriteTime = std::filesystem::last_write_time(path, ec);
+    return !ec && currentWriteTime == lastWriteTime;
+}
+
 const WifiRegulations &RegDb::getWifiRegulations(const std::string &countryIso3661) const
 {
-    for (const auto &regulation : this->regulations)
+    auto i = regulationIndex.find(countryIso3661);
+    if (i == regulationIndex.end())
     {
-        if (regulation.reg_alpha2 == countryIso3661)
-        {
-            return regulation;
-        }
+        throw std::runtime_error("Invalid country code.");
     }
-    throw std::runtime_error("Invalid country code.");
+    return regulations[i->second];
 }
 
 template <typename T>
@@ -209,8 +238,11 @@ RegDb::RegDb()
 {
 }
 RegDb::RegDb(const std::filesystem::path &path)
-    : pData(nullptr)
+    : pData(nullptr), path(path)
 {
+    std::error_code ec;
+    this->lastWriteTime = std::filesystem::last_write_time(path, ec);
+
     ifstream f(path);
     if (!f.is_open())
     {
@@ -247,6 +279,12 @@ RegDb::RegDb(const std::filesystem::path &path)
     {
         throw std::runtime_error(SS("Unknown file version. " << path));
     }
+    for (size_t i = 0; i < regulations.size(); ++i)
+    {
+        regulationIndex.emplace(regulations[i].reg_alpha2, i); // first match wins, as before.
+    }
+    data.clear();
+    data.shrink_to_fit();
 }
 void RegDb::Load19()
 {
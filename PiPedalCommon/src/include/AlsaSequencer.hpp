@@ -275,6 +275,9 @@ namespace pipedal
         uint8_t cc1() const { return size > 1 ? data[1] : 0; }
         uint8_t cc2() const { return size > 2 ? data[2] : 0; }
 
+        // The sequencer queue's real time when the message was received.
+        uint64_t RealtimeNs() const { return realtime_sec * 1000000000ull + realtime_nsec; }
+
 
         uint32_t timestamp;     // in microseconds (tick time if using queue)
         uint64_t realtime_sec;  // real-time timestamp seconds
@@ -323,12 +326,19 @@ namespace pipedal
         virtual void SetConfiguration(const AlsaSequencerConfiguration &alsaSequencerConfiguration) = 0;
 
         // Read a single MIDI message from the sequencer input port. A timeout of -1 blocks indefinitely.
-        // A timeout of 0 returns immediately.
+        // A timeout of 0 returns immediately, and is realtime-safe. Messages are read from the sequencer
+        // by an input thread; message.data is valid until the next call.
         virtual bool ReadMessage(AlsaMidiMessage &message, int timeoutMs = -1) = 0;
 
-        // currently non-functional
+        // The current real time of the queue that timestamps incoming messages (see AlsaMidiMessage::RealtimeNs()).
+        // Realtime-safe.
         virtual bool GetQueueRealtime(uint64_t *sec, uint32_t *nsec) = 0;
 
+        // Queue a MIDI message for the output port, which is connected to every device that accepts input.
+        // Realtime-safe. Messages are sent from the input thread, rate-limited; repeated controller values
+        // are coalesced, and controller values that the device already shows are not sent again.
+        virtual bool WriteMessage(const uint8_t *data, size_t size) = 0;
+
         virtual void RemoveAllConnections() = 0;
     };
 
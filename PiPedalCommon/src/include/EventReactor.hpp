@@ -0,0 +1,103 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <atomic>
+
+namespace pipedal
+{
+    // A single epoll loop on a low-priority thread that services housekeeping file descriptors
+    // (inotify, ALSA sequencer announcements, &c) and one-shot timers (timerfd).
+    //
+    // The thread blocks indefinitely in epoll_wait when nothing is registered or pending, so
+    // idle subsystems cost no wakeups. Callbacks run on the reactor thread, and must not block.
+    class EventReactor
+    {
+    public:
+        using clock = std::chrono::steady_clock;
+        using Handle = uint64_t;
+        using FdCallback = std::function<void(uint32_t epollEvents)>;
+        using TimerCallback = std::function<void()>;
+
+        static constexpr Handle INVALID_HANDLE = 0;
+
+        // The process-wide reactor. The thread is started on first use.
+        static EventReactor &GetInstance();
+
+        EventReactor(const std::string &threadName = "reactor");
+        ~EventReactor();
+        EventReactor(const EventReactor &) = delete;
+        EventReactor &operator=(const EventReactor &) = delete;
+
+        // Call callback whenever fd is ready for any of epollEvents (EPOLLIN, &c). The caller retains ownership of fd,
+        // and must Remove() the registration before closing it.
+        Handle AddFd(int fd, uint32_t epollEvents, FdCallback &&callback);
+
+        // Call callback once, after delay.
+        Handle AddTimer(clock::duration delay, TimerCallback &&callback);
+
+        template <class REP, class PERIOD>
+        Handle AddTimer(const std::chrono::duration<REP, PERIOD> &delay, TimerCallback &&callback)
+        {
+            return AddTimer(std::chrono::duration_cast<clock::duration>(delay), std::move(callback));
+        }
+
+        // Remove an fd or timer registration. Returns false if the handle has already been removed, or the timer
+        // has already fired. When called from any thread other than the reactor thread, waits for an in-flight
+        // callback for the handle to complete, so that callback state can be safely destroyed afterwards.
+        bool Remove(Handle handle);
+
+        void Stop();
+
+    private:
+        struct Entry
+        {
+            int fd = -1;
+            bool isTimer = false;
+            FdCallback callback;
+        };
+        static constexpr Handle WAKE_HANDLE = (Handle)-1;
+
+        Handle AddEntry(std::shared_ptr<Entry> entry, uint32_t epollEvents);
+        void ThreadProc();
+
+        std::string threadName;
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::atomic<bool> terminateThread{false};
+        std::thread thread;
+        std::thread::id threadId;
+
+        Handle nextHandle = 1;
+        std::mutex entriesMutex;
+        std::unordered_map<Handle, std::shared_ptr<Entry>> entries;
+        // Held by the reactor thread while dispatching callbacks.
+        std::mutex dispatchMutex;
+    };
+}
@@ -13,6 +13,7 @@
 #include "dbus/org.freedesktop.NetworkManager.Connection.Active.hpp"
 
 #include "dbus/org.freedesktop.NetworkManager.hpp"
+#include "dbus/org.freedesktop.DBus.hpp"
 
 #include "libnm/nm-dbus-interface.h"
 
@@ -23,6 +24,36 @@ namespace nm_impl
     std::string NetworkManagerDeviceStateToString(uint32_t state);
 };
 
+// The message bus itself. Used to find out when NetworkManager starts or stops.
+class DBusDaemon : public sdbus::ProxyInterfaces<org::freedesktop::DBus_proxy>
+{
+public:
+    using ptr = std::unique_ptr<DBusDaemon>;
+    DBusDaemon(DBusDispatcher &dispatcher)
+        : sdbus::ProxyInterfaces<org::freedesktop::DBus_proxy>(
+              dispatcher.Connection(),
+              sdbus::ServiceName("org.freedesktop.DBus"),
+              sdbus::ObjectPath("/org/freedesktop/DBus"))
+    {
+        registerProxy();
+    }
+    virtual ~DBusDaemon()
+    {
+        unregisterProxy();
+    }
+
+    static ptr Create(DBusDispatcher &dispatcher) { return std::make_unique<DBusDaemon>(dispatcher); }
+
+    // (name, oldOwner, newOwner). newOwner is empty if the name has been released.
+    DBusEvent<const std::string &, const std::string &, const std::string &> OnNameOwnerChanged;
+
+private:
+    virtual void onNameOwnerChanged(const std::string &name, const std::string &old_owner, const std::string &new_owner)
+    {
+        OnNameOwnerChanged.fire(name, old_owner, new_owner);
+    }
+};
+
 class NetworkManager : public sdbus::ProxyInterfaces<org::freedesktop::NetworkManager_proxy>
 {
 public:
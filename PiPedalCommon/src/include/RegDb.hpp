@@ -49,6 +49,8 @@ namespace pipedal
         uint8_t *pData;
         
     public:
+        // The shared instance. Reloaded if the regulatory database file has been modified since it
+        // was loaded. References to previous instances remain valid.
         static RegDb&GetInstance();
 
         RegDb();
@@ -58,19 +60,25 @@ namespace pipedal
         const std::vector<WifiRegulations>&Regulations() const { return regulations;}
  
         bool IsValid() const { return isValid; }
+        // false if the file has been modified since it was loaded.
+        bool IsCurrent() const;
 
         const WifiRegulations&getWifiRegulations(const std::string&countryIso3661) const;
 
         std::map<std::string,std::string> getRegulatoryDomains(const std::filesystem::path&namesFile="/etc/pipedal/config/iso_codes.json") const;
     private:
         bool isValid = false;
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastWriteTime;
 
+        // only held while parsing.
         std::vector<uint8_t> data;
         void *ptr() { return (void *)&(data[0]); }
         void Load19();
         void Load20();
 
         std::vector<WifiRegulations> regulations;
+        std::map<std::string,size_t> regulationIndex; // reg_alpha2 -> index into regulations.
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+
+/*
+ * This file was automatically generated by sdbus-c++-xml2cpp; DO NOT EDIT!
+ */
+
+#ifndef __sdbuscpp____src_include_dbus_org_freedesktop_DBus_hpp__proxy__H__
+#define __sdbuscpp____src_include_dbus_org_freedesktop_DBus_hpp__proxy__H__
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <string>
+#include <tuple>
+
+namespace org {
+namespace freedesktop {
+
+class DBus_proxy
+{
+public:
+    static constexpr const char* INTERFACE_NAME = "org.freedesktop.DBus";
+
+protected:
+    DBus_proxy(sdbus::IProxy& proxy)
+        : m_proxy(proxy)
+    {
+    }
+
+    DBus_proxy(const DBus_proxy&) = delete;
+    DBus_proxy& operator=(const DBus_proxy&) = delete;
+    DBus_proxy(DBus_proxy&&) = delete;
+    DBus_proxy& operator=(DBus_proxy&&) = delete;
+
+    ~DBus_proxy() = default;
+
+    void registerProxy()
+    {
+        m_proxy.uponSignal("NameOwnerChanged").onInterface(INTERFACE_NAME).call([this](const std::string& name, const std::string& old_owner, const std::string& new_owner){ this->onNameOwnerChanged(name, old_owner, new_owner); });
+    }
+
+    virtual void onNameOwnerChanged(const std::string& name, const std::string& old_owner, const std::string& new_owner) = 0;
+
+public:
+    bool NameHasOwner(const std::string& name)
+    {
+        bool result;
+        m_proxy.callMethod("NameHasOwner").onInterface(INTERFACE_NAME).withArguments(name).storeResultsTo(result);
+        return result;
+    }
+
+private:
+    sdbus::IProxy& m_proxy;
+};
+
+}} // namespaces
+
+#endif
@@ -33,6 +33,7 @@
 #include <chrono>
 #include <optional>
 #include <string_view>
+#include <charconv>
 #include <string.h>
 #include <stdexcept>
 #include <vector>
@@ -90,6 +91,24 @@ namespace pipedal
     template <typename T>
     concept IsJsonSerializable = std::derived_from<T,JsonSerializable>;
 
+    // A json value that is carried as unparsed text. Reading captures the text of the next value;
+    // writing copies it to the output verbatim.
+    class JsonRawText : public JsonSerializable
+    {
+    public:
+        JsonRawText() {}
+        JsonRawText(const std::string &text) : text_(text) {}
+        JsonRawText(std::string &&text) : text_(std::move(text)) {}
+
+        const std::string &text() const { return text_; }
+
+        virtual void write_json(json_writer &writer) const override;
+        virtual void read_json(json_reader &reader) override;
+
+    private:
+        std::string text_;
+    };
+
 
     class JsonMemberWritable
     {
@@ -296,7 +315,9 @@ namespace pipedal
 
     private:
         bool allowNaN_ = false;
-        std::ostream &os;
+        // Output goes to exactly one of os_ or buffer_.
+        std::ostream *os_ = nullptr;
+        std::string *buffer_ = nullptr;
         int indent_level;
         bool compressed;
         const int TAB_SIZE = 2;
@@ -319,18 +340,24 @@ namespace pipedal
     public:
         static std::string encode_string(const std::string &text)
         {
-            std::stringstream s;
-            json_writer writer(s);
+            std::string result;
+            json_writer writer(result);
             writer.write(text);
-            return s.str();
+            return result;
         }
         void write_raw(const char *text)
         {
-            os << text;
+            append(std::string_view(text));
         }
         using string_view = std::string_view;
         json_writer(std::ostream &os, bool compressed = true, bool allowNaN = false)
-            : os(os), compressed(compressed), allowNaN_(allowNaN), indent_level(0)
+            : os_(&os), compressed(compressed), allowNaN_(allowNaN), indent_level(0)
+        {
+            this->CRLF = compressed ? "" : "\r\n";
+        }
+        // Append output directly to a string, bypassing iostreams altogether.
+        json_writer(std::string &output, bool compressed = true, bool allowNaN = false)
+            : buffer_(&output), compressed(compressed), allowNaN_(allowNaN), indent_level(0)
         {
             this->CRLF = compressed ? "" : "\r\n";
         }
@@ -339,59 +366,93 @@ namespace pipedal
 
         void write(uint8_t value)
         {
-            os << value;
+            append((char)value);
         }
         void write(int8_t value)
         {
-            os << value;
+            append((char)value);
         }
         void write(short value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(unsigned short value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(long long value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(unsigned long long value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(long value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(unsigned long value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(int value)
         {
-            os << value;
+            write_integer(value);
         }
         void write(unsigned int value)
         {
-            os << value;
+            write_integer(value);
         }
         void write (const std::chrono::system_clock::time_point &time);
 
     private:
         static void throw_encoding_error();
 
+        void append(char c)
+        {
+            if (buffer_)
+                buffer_->push_back(c);
+            else
+                os_->put(c);
+        }
+        void append(std::string_view text)
+        {
+            if (buffer_)
+                buffer_->append(text);
+            else
+                os_->write(text.data(), (std::streamsize)text.size());
+        }
+        template <typename T>
+        void write_integer(T value)
+        {
+            char text[24];
+            auto result = std::to_chars(text, text + sizeof(text), value);
+            append(std::string_view(text, (size_t)(result.ptr - text)));
+        }
+        template <typename T>
+        void write_floating_point(T value, int precision)
+        {
+            char text[40];
+            auto result = std::to_chars(text, text + sizeof(text), value, std::chars_format::general, precision);
+            append(std::string_view(text, (size_t)(result.ptr - text)));
+        }
+
         static uint32_t continuation_byte(std::string_view::iterator &p, std::string_view::const_iterator end);
         void write_utf16_char(uint16_t uc);
 
     public:
         void indent();
-        std::ostream &output_stream() { return os; }
+        std::ostream &output_stream()
+        {
+            if (!os_)
+                throw std::logic_error("json_writer is not writing to a stream.");
+            return *os_;
+        }
 
         void write(bool value)
         {
-            os << (value ? "true" : "false");
+            append(value ? "true" : "false");
         }
         void write(
             string_view v,
@@ -416,14 +477,14 @@ namespace pipedal
             {
                 if (allowNaN_)
                 {
-                    os << "NaN";
+                    append("NaN");
                 } else {
-                    os << std::numeric_limits<float>::max();
+                    write_floating_point(std::numeric_limits<float>::max(), std::numeric_limits<float>::max_digits10);
                 }
             }
             else
             {
-                os << std::setprecision(std::numeric_limits<float>::max_digits10) << f; // round-trip format
+                write_floating_point(f, std::numeric_limits<float>::max_digits10); // round-trip format
             }
         }
         void write(float f) {
@@ -436,14 +497,14 @@ namespace pipedal
             {
                 if (allowNaN_)
                 {
-                    os << "NaN";
+                    append("NaN");
                 } else {
-                    os << std::numeric_limits<float>::max();
+                    write_floating_point(std::numeric_limits<float>::max(), std::numeric_limits<float>::max_digits10);
                 }
             }
             else
             {
-                os << std::setprecision(std::numeric_limits<double>::max_digits10) << f; // round-trip format
+                write_floating_point(f, std::numeric_limits<double>::max_digits10); // round-trip format
             }
         }
         void write(double d)
@@ -457,7 +518,7 @@ namespace pipedal
             if (std::is_fundamental<T>() || std::is_assignable<T, const char *>() || value.size() == 0)
             {
                 // simple types: all on same line.
-                os << "[ ";
+                append("[ ");
 
                 if (value.size() >= 1)
                 {
@@ -465,37 +526,39 @@ namespace pipedal
                 }
                 for (size_t i = 1; i < value.size(); ++i)
                 {
-                    os << ",";
+                    append(",");
                     write(value[i]);
                 }
-                os << "]";
+                append("]");
             }
             else
             {
                 // complex types: one line per entry.
-                os << "[" << CRLF;
+                append('[');
+                append(CRLF);
                 indent_level += TAB_SIZE;
                 bool first = true;
                 for (size_t i = 0; i < value.size(); ++i)
                 {
                     if (!first)
                     {
-                        os << ',' << CRLF;
+                        append(',');
+                        append(CRLF);
                     }
                     first = false;
                     indent();
                     write(value[i]);
                 }
                 indent_level -= TAB_SIZE;
-                os << CRLF;
+                append(CRLF);
                 indent();
-                os << "]";
+                append("]");
             }
         }
     void write(const std::vector<float> &value)
         {
             // simple types: all on same line.
-            os << "[ ";
+            append("[ ");
 
             if (value.size() >= 1)
             {
@@ -503,10 +566,10 @@ namespace pipedal
             }
             for (size_t i = 1; i < value.size(); ++i)
             {
-                os << ",";
+                append(",");
                 write(value[i]);
             }
-            os << "]";
+            append("]");
         }
 
         // template <
@@ -535,15 +598,15 @@ namespace pipedal
         void write_json_member(const char *name, const char *json_text)
         {
             write(name);
-            os << ": ";
-            os << json_text;
+            append(": ");
+            append(json_text);
         }
 
         template <typename T>
         void write_member(const char *name, const T &value)
         {
             write(name);
-            os << ": ";
+            append(": ");
             write(value);
         }
         void start_object();
@@ -556,7 +619,7 @@ namespace pipedal
             {
                 if (obj == nullptr)
                 {
-                    os << "null";
+                    append("null");
                 } else {
                     start_object();
                     obj->write(*this);
@@ -714,26 +777,53 @@ namespace pipedal
         }
     };
 
+    /**
+     * @brief Reads JSON from a contiguous buffer.
+     *
+     * The reader scans a contiguous block of text with a pointer, rather than
+     * pulling characters one at a time out of a std::istream. Readers constructed
+     * from a std::istream read the remainder of the stream into a buffer owned by the
+     * reader; readers constructed from a std::string_view parse the caller's buffer
+     * in place, and the caller must keep it alive for the lifetime of the reader.
+     */
     class json_reader
     {
     private:
-        std::istream &is_;
+        std::string buffer_; // holds stream content, when constructed from a std::istream.
+        const char *begin_ = nullptr;
+        const char *p_ = nullptr;
+        const char *end_ = nullptr;
 
         const uint16_t UTF16_SURROGATE_1_BASE = 0xD800U;
         const uint16_t UTF16_SURROGATE_2_BASE = 0xDC00U;
         const uint16_t UTF16_SURROGATE_MASK = 0x3FFU;
         bool allowNaN_ = true;
 
+        static std::string read_stream(std::istream &input);
+
     public:
         json_reader(std::istream &input, bool allowNaN = true)
-            : is_(input)
+            : buffer_(read_stream(input))
+        {
+            this->allowNaN_ = allowNaN;
+            begin_ = p_ = buffer_.data();
+            end_ = begin_ + buffer_.size();
+        }
+        json_reader(std::string_view text, bool allowNaN = true)
         {
             this->allowNaN_ = allowNaN;
+            begin_ = p_ = text.data();
+            end_ = begin_ + text.size();
         }
+        json_reader(const json_reader &) = delete;
+        json_reader &operator=(const json_reader &) = delete;
 
         bool allowNaN() const { return allowNaN_; }
         void allowNaN(bool allow) { allowNaN_ = allow; }
 
+        // Offset of the next unread character, relative to the start of the input.
+        size_t tell() const { return (size_t)(p_ - begin_); }
+
     private:
         void throw_format_error(const char *error);
 
@@ -757,10 +847,25 @@ namespace pipedal
         }
         char get()
         {
-            int ic = is_.get();
-            if (ic == -1)
+            if (p_ == end_)
                 throw_format_error("Unexpected end of file");
-            return (char)ic;
+            return *p_++;
+        }
+        int peek_raw() const
+        {
+            if (p_ == end_)
+                return -1;
+            return (unsigned char)*p_;
+        }
+
+        template <typename T>
+        void read_number(T *value)
+        {
+            skip_whitespace();
+            auto result = std::from_chars(p_, end_, *value);
+            if (result.ec != std::errc())
+                throw JsonException("Invalid format.");
+            p_ = result.ptr;
         }
 
         void skip_whitespace();
@@ -784,7 +889,7 @@ namespace pipedal
         int peek()
         {
             skip_whitespace();
-            return is_.peek();
+            return peek_raw();
         }
         template<typename U>
         void read_member(const std::string&name,U *value)
@@ -831,7 +936,7 @@ namespace pipedal
                 map.read_property(this, memberName.c_str(), pObject);
 
                 skip_whitespace();
-                if (is_.peek() == ',')
+                if (peek_raw() == ',')
                 {
                     c = get();
                 }
@@ -942,6 +1047,15 @@ namespace pipedal
     public:
         void skip_property();
 
+        // Skips the next value, and returns its unparsed text. The result points into the reader's buffer.
+        std::string_view read_raw()
+        {
+            skip_whitespace();
+            const char *start = p_;
+            skip_property();
+            return std::string_view(start, (size_t)(p_ - start));
+        }
+
         void read(std::string *value)
         {
             skip_whitespace();
@@ -955,89 +1069,39 @@ namespace pipedal
         }
         void read(uint8_t*value)
         {
+            // json_writer writes uint8_t values as a raw character.
             skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(short * value)
-        {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-
-        void read(unsigned short * value)
-        {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-
-        void read(int *value)
-        {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(long *value)
-        {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(long long *value)
-        {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(unsigned int *value)
-        {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(unsigned long *value)
-        {
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
-        }
-        void read(unsigned long long *value)
-        {
-            skip_whitespace();
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            *value = (uint8_t)get();
         }
+        void read(short * value) { read_number(value); }
+        void read(unsigned short * value) { read_number(value); }
+        void read(int *value) { read_number(value); }
+        void read(long *value) { read_number(value); }
+        void read(long long *value) { read_number(value); }
+        void read(unsigned int *value) { read_number(value); }
+        void read(unsigned long *value) { read_number(value); }
+        void read(unsigned long long *value) { read_number(value); }
 
         void read(float *value)
         {
             skip_whitespace();
             if (allowNaN_)
             {
-                if (peek() == 'N')
+                if (peek_raw() == 'N')
                 {
                     consumeToken("NaN", "Expecting a number.");
                     *value = std::nanf("");
                     return;
                 }
             }
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(double *value)
         {
             skip_whitespace();
             if (allowNaN_)
             {
-                if (peek() == 'N')
+                if (peek_raw() == 'N')
                 {
                     consumeToken("NaN", "Expecting a number.");
 
@@ -1045,10 +1109,7 @@ namespace pipedal
                     return;
                 }
             }
-
-            is_ >> *value;
-            if (is_.fail())
-                throw JsonException("Invalid format.");
+            read_number(value);
         }
         void read(std::chrono::system_clock::time_point *value);
 
@@ -1170,8 +1231,8 @@ namespace pipedal
             {
                 if (!first)
                 {
-                    writer->output_stream() << ',';
-                    writer->output_stream() << writer->CRLF;
+                    writer->write_raw(",");
+                    writer->write_raw(writer->CRLF);
                 }
                 first = false;
                 writer->indent();
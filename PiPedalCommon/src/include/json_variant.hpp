@@ -26,6 +26,7 @@
 #include <vector>
 #include <variant>
 #include <map>
+#include <memory_resource>
 
 #include <string>
 #include <stdexcept>
@@ -49,6 +50,27 @@ namespace pipedal
     class json_object;
     class json_array;
 
+    // Memory for json_object and json_array nodes (and their element storage) created on this thread while
+    // the scope is active comes from the given resource. Nodes keep the resource they were created with.
+    //
+    // With a std::pmr::monotonic_buffer_resource, building a tree costs a handful of block allocations, and
+    // the whole tree is released in one operation when the resource is destroyed. The tree (and anything
+    // shared out of it) must be released before the resource is.
+    class json_memory_scope
+    {
+    public:
+        json_memory_scope(std::pmr::memory_resource *resource);
+        ~json_memory_scope();
+        json_memory_scope(const json_memory_scope &) = delete;
+        json_memory_scope &operator=(const json_memory_scope &) = delete;
+
+        // the resource used by nodes created on this thread (std::pmr::get_default_resource() by default).
+        static std::pmr::memory_resource *current();
+
+    private:
+        std::pmr::memory_resource *previous;
+    };
+
     class json_variant
         : public JsonSerializable
     {
@@ -88,6 +110,8 @@ namespace pipedal
         json_variant(const void *) = delete; // do NOT allow implicit conversion of pointers to bool
 
         static json_variant parse(const std::string&text);
+        // Parse into nodes allocated from the given resource (see json_memory_scope).
+        static json_variant parse(const std::string &text, std::pmr::memory_resource *resource);
 
         json_variant &operator=(json_variant &&value);
         json_variant &operator=(const json_variant &value);
@@ -198,6 +222,12 @@ namespace pipedal
         std::string to_string() const;
 
     private:
+        // a node, and its shared_ptr control block, in one allocation from the node's own memory resource.
+        template <typename T>
+        static std::shared_ptr<T> make_node(T &&value)
+        {
+            return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(value.memory_resource()), std::move(value));
+        }
         void free();
         void write_double_value(json_writer &writer, double value) const;
         void write_float_value(json_writer &writer, double value) const;
@@ -234,10 +264,12 @@ namespace pipedal
     public:
         using ptr = std::shared_ptr<json_array>;
 
-        json_array() { ++allocation_count_; }
+        json_array() : values(json_memory_scope::current()) { ++allocation_count_; }
         json_array(json_array &&other);
         ~json_array() { --allocation_count_; }
 
+        std::pmr::memory_resource *memory_resource() const { return values.get_allocator().resource(); }
+
         json_variant &at(size_t index);
         const json_variant &at(size_t index) const;
 
@@ -263,8 +295,9 @@ namespace pipedal
         {
             return allocation_count_;
         }
-        using iterator = std::vector<json_variant>::iterator;
-        using const_iterator = std::vector<json_variant>::const_iterator;
+        using values_t = std::pmr::vector<json_variant>;
+        using iterator = values_t::iterator;
+        using const_iterator = values_t::const_iterator;
 
         iterator begin() { return values.begin(); }
         iterator end() { return values.end(); }
@@ -279,7 +312,7 @@ namespace pipedal
 
         void check_index(size_t size) const;
 
-        std::vector<json_variant> values;
+        values_t values;
     };
     class json_object : public JsonSerializable
     {
@@ -288,10 +321,12 @@ namespace pipedal
     public:
         using ptr = std::shared_ptr<json_object>;
 
-        json_object() { ++allocation_count_; }
+        json_object() : values(json_memory_scope::current()) { ++allocation_count_; }
         json_object(json_object &&other);
         ~json_object() { --allocation_count_; }
 
+        std::pmr::memory_resource *memory_resource() const { return values.get_allocator().resource(); }
+
         size_t size() const { return values.size(); }
         json_variant &at(const std::string &index);
         const json_variant &at(const std::string &index) const;
@@ -303,7 +338,7 @@ namespace pipedal
         bool operator!=(const json_object &other) const { return (!((*this) == other)); }
         bool contains(const std::string &index) const;
 
-        using values_t = std::vector<std::pair<std::string, json_variant>>;
+        using values_t = std::pmr::vector<std::pair<std::string, json_variant>>;
         using iterator = values_t::iterator;
         using const_iterator = values_t::const_iterator;
 
@@ -359,13 +394,13 @@ namespace pipedal
     inline json_variant::json_variant(json_array &&array)
     {
         this->content_type = ContentType::Null;
-        new (content.mem) std::shared_ptr<json_array>{new json_array(std::move(array))};
+        new (content.mem) std::shared_ptr<json_array>{make_node(std::move(array))};
         this->content_type = ContentType::Array;
     }
     inline json_variant::json_variant(json_object &&object)
     {
         this->content_type = ContentType::Null;
-        new (content.mem) std::shared_ptr<json_object>{new json_object(std::move(object))};
+        new (content.mem) std::shared_ptr<json_object>{make_node(std::move(object))};
         this->content_type = ContentType::Object;
     }
 
@@ -462,11 +497,11 @@ namespace pipedal
 
     inline /*static*/ json_variant json_variant::make_object()
     {
-        return json_variant{std::make_shared<json_object>()};
+        return json_variant{make_node(json_object())};
     };
     inline /*static */ json_variant json_variant::make_array()
     {
-        return json_variant{std::make_shared<json_array>()};
+        return json_variant{make_node(json_array())};
     };
 
     inline void json_variant::resize(size_t size)
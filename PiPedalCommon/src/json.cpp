@@ -20,6 +20,7 @@
 #include "json.hpp"
 #include <string_view>
 #include <cctype>
+#include <array>
 #include "json_variant.hpp"
 #include "util.hpp"
 #include <string_view>
@@ -51,13 +52,28 @@ void json_writer::throw_encoding_error()
 }
 void json_writer::write_utf16_char(uint16_t uc)
 {
-    os << "\\u"
-       << hex((int)((uc >> 12) & 0x0F))
-       << hex((int)((uc >> 8) & 0x0F))
-       << hex((int)((uc >> 4) & 0x0F))
-       << hex((int)((uc)&0x0F));
+    char text[6]{
+        '\\',
+        'u',
+        hex((int)((uc >> 12) & 0x0F)),
+        hex((int)((uc >> 8) & 0x0F)),
+        hex((int)((uc >> 4) & 0x0F)),
+        hex((int)((uc)&0x0F))};
+    append(std::string_view(text, sizeof(text)));
 }
 
+static constexpr std::array<bool, 256> MakeStringEscapeTable()
+{
+    std::array<bool, 256> result{};
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        result[i] = i < 0x20 || i >= 0x80 || i == '"' || i == '\\';
+    }
+    return result;
+}
+// true for bytes that json_writer::write(string_view) can't copy verbatim.
+static constexpr std::array<bool, 256> stringEscapeTable = MakeStringEscapeTable();
+
 void json_writer::write(string_view v,bool enforceValidUtf8Encoding)
 {
     // convert to utf-32.
@@ -65,9 +81,24 @@ void json_writer::write(string_view v,bool enforceValidUtf8Encoding)
     // write non-7-bit and unsafe characters as \uHHHH.
 
     auto p = v.begin();
-    os << '"';
+    append('"');
     while (p != v.end())
     {
+        // Copy runs of plain ASCII in one go.
+        auto run = p;
+        while (run != v.end() && !stringEscapeTable[(uint8_t)*run])
+        {
+            ++run;
+        }
+        if (run != p)
+        {
+            append(std::string_view(&*p, (size_t)(run - p)));
+            p = run;
+            if (p == v.end())
+            {
+                break;
+            }
+        }
         uint32_t uc;
         uint8_t c = (uint8_t)*p++;
         try {
@@ -125,7 +156,7 @@ void json_writer::write(string_view v,bool enforceValidUtf8Encoding)
             }
         } catch (const std::exception &e) {
             // invalid UTF-8 sequence.
-            os << "\\uFFFD"; // replacement character for invalid sequences.
+            append("\\uFFFD"); // replacement character for invalid sequences.
             continue;
         }
         // if ((uc >= UTF16_SURROGATE_1_BASE && uc <= UTF16_SURROGATE_1_BASE + UTF16_SURROGATE_MASK) || (uc >= UTF16_SURROGATE_2_BASE && uc <= UTF16_SURROGATE_2_BASE + UTF16_SURROGATE_MASK))
@@ -136,24 +167,24 @@ void json_writer::write(string_view v,bool enforceValidUtf8Encoding)
 
         if (uc == '"' || uc == '\\')
         {
-            os << (char)'\\';
-            os << (char)uc;
+            append('\\');
+            append((char)uc);
         }
         else if (uc >= 0x20 && uc < 0x80)
         {
-            os << (char)uc;
+            append((char)uc);
         } 
         else if (uc == '\r')
         {
-            os << "\\r";
+            append("\\r");
         }
         else if (uc == '\n')
         {
-            os << "\\n";
+            append("\\n");
         }
         else if (uc == '\t')
         {
-            os << "\\t";
+            append("\\t");
         }
         else if (uc < 0x10000ul)
         {
@@ -171,7 +202,7 @@ void json_writer::write(string_view v,bool enforceValidUtf8Encoding)
             write_utf16_char(s2);
         }
     }
-    os << '"';
+    append('"');
 }
 
 void json_writer::indent()
@@ -180,87 +211,107 @@ void json_writer::indent()
     {
         for (int i = 0; i < indent_level; ++i)
         {
-            os << " ";
+            append(' ');
         }
     }
 }
 
 void json_writer::start_object()
 {
-    os << "{" << CRLF;
+    append('{');
+    append(CRLF);
     indent_level += TAB_SIZE;
 }
 void json_writer::end_object()
 {
     indent_level -= TAB_SIZE;
-    os << CRLF;
+    append(CRLF);
     indent();
-    os << "}";
+    append('}');
 }
 
 void json_writer::start_array()
 {
     indent();
-    os << "[" << CRLF;
+    append('[');
+    append(CRLF);
     indent_level += TAB_SIZE;
 }
 void json_writer::end_array()
 {
     indent_level -= TAB_SIZE;
     indent();
-    os << "]" << CRLF;
+    append(']');
+    append(CRLF);
 }
 
 
-void json_reader::skip_whitespace()
+std::string json_reader::read_stream(std::istream &input)
 {
-    char c;
+    std::string result;
+    if (!input.good())
+    {
+        return result;
+    }
+    std::streambuf *buffer = input.rdbuf();
+    if (buffer == nullptr)
+    {
+        return result;
+    }
+    char block[16 * 1024];
     while (true)
     {
-        int ic = is_.peek();
-        if (ic == -1)
+        std::streamsize nRead = buffer->sgetn(block, sizeof(block));
+        if (nRead <= 0)
+        {
             break;
-        if (is_whitespace((char)ic))
+        }
+        result.append(block, (size_t)nRead);
+    }
+    return result;
+}
+
+void json_reader::skip_whitespace()
+{
+    while (p_ != end_)
+    {
+        char c = *p_;
+        if (is_whitespace(c))
         {
-            c = get();
+            ++p_;
         }
-        else if (ic == '/')
+        else if (c == '/')
         {
-            get();
-            int c2 = is_.peek();
+            ++p_;
+            int c2 = peek_raw();
             if (c2 == '/') {
                 // skip to end of line.
-                get();
-                while (true) {
-                    c2 = is_.peek();
-                    if (c2 == '\r' || c2 == '\n')
-                    {
-                        get(); // and continue.
-                        break;
-                    }
-                    if (c2 == -1) 
+                ++p_;
+                while (p_ != end_)
+                {
+                    char c3 = *p_++;
+                    if (c3 == '\r' || c3 == '\n')
                     {
                         break;
                     }
-                    get();
                 }
             } else if (c2 == '*') {
-                get();
+                ++p_;
                 int level = 1;
                 while (true)
                 {
                     c = get();
-                    if (c == '*' && is_.peek() == '/')
+                    if (c == '*' && peek_raw() == '/')
                     {
-                        get();
+                        ++p_;
                         if (--level == 0)
                         {
                             break;
                         }
                     }
-                    if (c == '/' && is_.peek() == '*')
+                    if (c == '/' && peek_raw() == '*')
                     {
-                        get();
+                        ++p_;
                         ++level;
                     }
                 }
@@ -276,29 +327,57 @@ void json_reader::skip_whitespace()
     }
 }
 
-static void utf32_to_utf8_stream(std::ostream &s, uint32_t uc)
+static void utf32_to_utf8_string(std::string &s, uint32_t uc)
 {
     if (uc < 0x80u)
     {
-        s << (char)uc;
+        s.push_back((char)uc);
     } else if (uc < 0x800u) {
-        s << (char)(0xC0 + (uc >> 6));
-        s << (char)(0x80 + (uc & 0x3F));
+        s.push_back((char)(0xC0 + (uc >> 6)));
+        s.push_back((char)(0x80 + (uc & 0x3F)));
 
     } else if (uc < 0x10000u) {
-        s << (char)(0xE0 + (uc >> 12));
-        s << (char)(0x80 + ((uc >> 6) & 0x3F));
-        s << (char)(0x80 + (uc & 0x3F));
+        s.push_back((char)(0xE0 + (uc >> 12)));
+        s.push_back((char)(0x80 + ((uc >> 6) & 0x3F)));
+        s.push_back((char)(0x80 + (uc & 0x3F)));
     } else if (uc < 0x0110000) {
-        s << (char)(0xF0 + (uc >> 18));
-        s << (char)(0x80 + ((uc >> 12) & 0x3F));
-        s << (char)(0x80 + ((uc >> 6) & 0x3F));
-        s << (char)(0x80 + (uc & 0x3F));
+        s.push_back((char)(0xF0 + (uc >> 18)));
+        s.push_back((char)(0x80 + ((uc >> 12) & 0x3F)));
+        s.push_back((char)(0x80 + ((uc >> 6) & 0x3F)));
+        s.push_back((char)(0x80 + (uc & 0x3F)));
     } else {
         throw std::range_error("Illegal UTF-32 character.");
     }
 }
 
+// Find the first quote or backslash in [p,end), eight bytes at a time.
+static const char *find_string_special(const char *p, const char *end, char quote)
+{
+    constexpr uint64_t ONES = 0x0101010101010101ULL;
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+    const uint64_t quotes = ONES * (uint8_t)quote;
+    const uint64_t backslashes = ONES * (uint8_t)'\\';
+
+    while (end - p >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        uint64_t q = word ^ quotes;
+        uint64_t b = word ^ backslashes;
+        // the high bit of a byte is set in the result iff some byte of q or b is zero.
+        if ((((q - ONES) & ~q) | ((b - ONES) & ~b)) & HIGH_BITS)
+        {
+            break;
+        }
+        p += 8;
+    }
+    while (p != end && *p != quote && *p != '\\')
+    {
+        ++p;
+    }
+    return p;
+}
+
 std::string json_reader::read_string()
 {
     // To completely normalize UTF-32 values we must covert to UTF-16, resolve surrogate pairs, and then convert UTF-32 to UTF-8.
@@ -312,76 +391,74 @@ std::string json_reader::read_string()
     {
         throw_format_error();
     }
-    std::stringstream s;
+    std::string s;
 
     while (true)
     {
+        const char *run = find_string_special(p_, end_, startingCharacter);
+        s.append(p_, run);
+        p_ = run;
+
         c = get();
         if (c == startingCharacter)
         {
-            if (is_.peek() == startingCharacter) //  "" -> "
+            if (peek_raw() == startingCharacter) //  "" -> "
             {
-                get();
-                s.put(c);
+                ++p_;
+                s.push_back(c);
+                continue;
             } else {
                 break;
             }
         }
-        if (c != '\\')
+        c = get();
+        switch (c)
         {
-            s << (char)c;
-        }
-        else
+        case '"':
+        case '\\':
+        default:
+            s.push_back(c);
+            break;
+        case 'r':
+            s.push_back('\r');
+            break;
+        case 'b':
+            s.push_back('\b');
+            break;
+        case 'f':
+            s.push_back('\f');
+            break;
+        case 'n':
+            s.push_back('\n');
+            break;
+        case 't':
+            s.push_back('\t');
+            break;
+        case 'u':
         {
-            c = get();
-            switch (c)
-            {
-            case '"':
-            case '\\':
-            default:
-                s << c;
-                break;
-            case 'r':
-                s << '\r';
-                break;
-            case 'b':
-                s << '\b';
-                break;
-            case 'f':
-                s << '\f';
-                break;
-            case 'n':
-                s << '\n';
-                break;
-            case 't':
-                s << '\t';
-                break;
-            case 'u':
+            uint32_t uc = read_u_escape();
+            if (uc >= UTF16_SURROGATE_1_BASE && uc <= UTF16_SURROGATE_1_BASE + UTF16_SURROGATE_MASK)
             {
-                uint32_t uc = read_u_escape();
-                if (uc >= UTF16_SURROGATE_1_BASE && uc <= UTF16_SURROGATE_1_BASE + UTF16_SURROGATE_MASK)
+                // MUST be a UTF16_SURROGATE 2 to be legal.
+                c = get();
+                if (c != '\\')
+                    throw_format_error("Invalid UTF16 surrogate pair");
+                c = get();
+                if (c != 'u')
+                    throw_format_error("Invalid UTF16 surrogate pair");
+                uint16_t uc2 = read_u_escape();
+                if (uc2 < UTF16_SURROGATE_2_BASE || uc2 > UTF16_SURROGATE_2_BASE + UTF16_SURROGATE_MASK)
                 {
-                    // MUST be a UTF16_SURROGATE 2 to be legal.
-                    c = get();
-                    if (c != '\\')
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    c = get();
-                    if (c != 'u')
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    uint16_t uc2 = read_u_escape();
-                    if (uc2 < UTF16_SURROGATE_2_BASE || uc2 > UTF16_SURROGATE_2_BASE + UTF16_SURROGATE_MASK)
-                    {
-                        throw_format_error("Invalid UTF16 surrogate pair");
-                    }
-                    uc = ((uc & UTF16_SURROGATE_MASK) << 10) + (uc2 & UTF16_SURROGATE_MASK) + 0x10000U;
+                    throw_format_error("Invalid UTF16 surrogate pair");
                 }
-                utf32_to_utf8_stream(s, uc);
-            }
-            break;
+                uc = ((uc & UTF16_SURROGATE_MASK) << 10) + (uc2 & UTF16_SURROGATE_MASK) + 0x10000U;
             }
+            utf32_to_utf8_string(s, uc);
+        }
+        break;
         }
     }
-    return s.str();
+    return s;
 }
 uint16_t json_reader::read_hex()
 {
@@ -410,7 +487,7 @@ uint16_t json_reader::read_u_escape()
 bool json_reader::is_complete()
 {
     skip_whitespace();
-    return is_.peek() == -1;
+    return p_ == end_;
 }
 
 void json_reader::consumeToken(const char*expectedToken, const char*errorMessage)
@@ -421,10 +498,10 @@ void json_reader::consumeToken(const char*expectedToken, const char*errorMessage
     while (*p != '\0')
     {
         char expectedChar = *p++;
-        int c = is_.get();
-        if (expectedChar != c) {
+        if (p_ == end_ || *p_ != expectedChar) {
             this->throw_format_error(errorMessage);
         }
+        ++p_;
     }
 }
 
@@ -441,10 +518,20 @@ void json_reader::consume(char expected)
     }
 }
 
+void JsonRawText::write_json(json_writer &writer) const
+{
+    writer.write_raw(text_.empty() ? "null" : text_.c_str());
+}
+
+void JsonRawText::read_json(json_reader &reader)
+{
+    text_ = reader.read_raw();
+}
+
 void json_reader::skip_property()
 {
     skip_whitespace();
-    int c = is_.peek();
+    int c = peek_raw();
     switch (c)
     {
     case -1:
@@ -476,22 +563,21 @@ void json_reader::skip_string()
     consume('"');
     while (true)
     {
-        int c;
-        c = get();
-        if (c == -1) throw_format_error("Premature end of file.");
+        p_ = find_string_special(p_, end_, '"');
+        char c = get();
 
         if (c == '\"')
         {
-            if (peek() == '\"')
+            if (peek_raw() == '\"')
             {
-                get();
+                ++p_;
             } else {
                 break;
             }
         }
         if (c == '\\')
         {
-            c = get(); // all of standard escapes,  enough to get past \u
+            get(); // all of standard escapes,  enough to get past \u
         }
     }
 }
@@ -500,36 +586,36 @@ void json_reader::skip_number()
 {
     skip_whitespace();
     int c;
-    if (is_.peek() == '-')
+    if (peek_raw() == '-')
     {
         get();
     }
-    if (!std::isdigit(is_.peek()))
+    if (!std::isdigit(peek_raw()))
     {
         throw_format_error("Expecting a number.");
     }
-    while (std::isdigit(is_.peek()))
+    while (std::isdigit(peek_raw()))
     {
         get();
     }
-    if (is_.peek() == '.')
+    if (peek_raw() == '.')
     {
         get();
     }
-    while (std::isdigit(is_.peek()))
+    while (std::isdigit(peek_raw()))
     {
         get();
     }
-    c = is_.peek();
+    c = peek_raw();
     if (c == 'e' || c == 'E')
     {
         get();
-        c = is_.peek();
-        if (c == '+' || c == 'i')
+        c = peek_raw();
+        if (c == '+' || c == '-')
         {
             get();
         }
-        while (std::isdigit(is_.peek()))
+        while (std::isdigit(peek_raw()))
         {
             get();
         }
@@ -553,7 +639,7 @@ void json_reader::skip_array()
         }
         skip_property();
         skip_whitespace();
-        if (is_.peek() == ',')
+        if (peek_raw() == ',')
         {
             c = get();
         }
@@ -575,7 +661,7 @@ void json_reader::skip_object()
         }
         skip_string(); // name.
         consume(':');
-        skip_object();
+        skip_property();
         if (peek() == ',')
         {
             consume(',');
@@ -597,19 +683,12 @@ std::string json_reader::readToken()
 {
     skip_whitespace();
 
-    std::stringstream s;
-    while (true)
+    const char *start = p_;
+    while (p_ != end_ && std::isalpha((unsigned char)*p_))
     {
-        int ic = is_.peek();
-        if (ic == -1)
-            break;
-        char c = (char)ic;
-        if (!std::isalpha(c))
-            break;
-        is_.get();
-        s << c;
+        ++p_;
     }
-    return s.str();
+    return std::string(start, p_);
 
 }
 
@@ -640,13 +719,12 @@ void json_reader::throw_format_error(const char*error)
     s << error;
     s << ", near: '";
     skip_whitespace();
-    if (is_.peek() == -1) {
+    if (p_ == end_) {
         s << "<eof>";
     } else {
-        for (int i = 0; i < 40; ++i)
+        for (int i = 0; i < 40 && p_ != end_; ++i)
         {
-            int c = get();
-            if (c == -1) break;
+            char c = *p_++;
             if (c == '\r') {
                 s << "\\r";
             } else if (c == '\n')
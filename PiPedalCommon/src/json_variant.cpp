@@ -159,17 +159,16 @@ void json_variant::write_double_value(json_writer &writer, double value) const
 void json_variant::read_json(json_reader &reader)
 {
     int v = reader.peek();
+    // read in place: no intermediate node to move.
     if (v == '[')
     {
-        json_array array;
-        reader.read(&array);
-        (*this) = std::move(array);
+        (*this) = make_array();
+        reader.read(memArray().get());
     }
     else if (v == '{')
     {
-        json_object object;
-        reader.read(&object);
-        (*this) = std::move(object);
+        (*this) = make_object();
+        reader.read(memObject().get());
     }
     else if (v == '\"')
     {
@@ -237,7 +236,22 @@ bool json_array::operator==(const json_array &other) const
 
 void json_array::read_json(json_reader &reader)
 {
-    reader.read(&(this->values));
+    values.clear();
+    reader.consume('[');
+    while (true)
+    {
+        if (reader.peek() == ']')
+        {
+            reader.consume(']');
+            break;
+        }
+        values.emplace_back();
+        reader.read(&values.back());
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
 }
 
 void json_array::write_json(json_writer &writer) const
@@ -319,7 +333,7 @@ void json_object::read_json(json_reader &reader)
         reader.consume(':');
         reader.read(&value);
 
-        (*this)[key] = value;
+        (*this)[key] = std::move(value);
         if (reader.peek() == ',') 
         {
             reader.consume(',');
@@ -444,7 +458,7 @@ json_variant &json_variant::operator=(std::string &&value)
 json_variant &json_variant::operator=(json_object &&value)
 {
     free();
-    new (this->content.mem) std::shared_ptr<json_object>{new json_object(std::move(value))};
+    new (this->content.mem) std::shared_ptr<json_object>{make_node(std::move(value))};
     this->content_type = ContentType::Object;
     return *this;
 }
@@ -452,7 +466,7 @@ json_variant &json_variant::operator=(json_array &&value)
 {
     free();
     this->content_type = ContentType::Array;
-    new (this->content.mem) std::shared_ptr<json_array>{new json_array(std::move(value))};
+    new (this->content.mem) std::shared_ptr<json_array>{make_node(std::move(value))};
     return *this;
 }
 json_variant &json_variant::operator=(json_variant &&value)
@@ -572,13 +586,35 @@ json_variant::json_variant(json_reader&reader)
 
 json_variant json_variant::parse(const std::string&jsonText)
 {
-    std::istringstream s(jsonText);
-    json_reader reader(s);
+    json_reader reader{std::string_view(jsonText)};
     json_variant result;
     reader.read(&result);
     return result;
 }
 
+json_variant json_variant::parse(const std::string &jsonText, std::pmr::memory_resource *resource)
+{
+    json_memory_scope scope(resource);
+    return parse(jsonText);
+}
+
+static thread_local std::pmr::memory_resource *currentJsonMemoryResource = nullptr;
+
+json_memory_scope::json_memory_scope(std::pmr::memory_resource *resource)
+    : previous(currentJsonMemoryResource)
+{
+    currentJsonMemoryResource = resource;
+}
+json_memory_scope::~json_memory_scope()
+{
+    currentJsonMemoryResource = previous;
+}
+
+/*static*/ std::pmr::memory_resource *json_memory_scope::current()
+{
+    return currentJsonMemoryResource ? currentJsonMemoryResource : std::pmr::get_default_resource();
+}
+
 
 /*static*/ json_null json_null::instance;
 /*static*/ int64_t json_array::allocation_count_ = 0; // strictly for testing purposes. not thread safe.
@@ -0,0 +1,45 @@
+#!/bin/bash
+# Run a clean, profile-guided and link-time optimized Release build.
+#
+#   1. Build instrumented binaries in ./build.
+#   2. Train them: pipedal_bench runs each of the bundled default presets, and pipedaltest runs
+#      the json, sample converter and realtime infrastructure benchmarks.
+#   3. Rebuild ./build using the collected profiles.
+#
+# Training loads real plugins: PiPedal (/etc/pipedal/config) and the ToobAmp plugins must be
+# installed on the build machine.
+
+set -e
+
+PROFILE_DIR=$(pwd)/build/pgo-profiles
+TRAINING_DIR=$(pwd)/build/pgo-training
+CMAKE_OPTIONS="-D CMAKE_BUILD_TYPE=Release -D PIPEDAL_LTO=ON -D PIPEDAL_PGO_DIR=${PROFILE_DIR} -G Ninja"
+
+# clean build
+rm -rf build
+
+# instrumented build
+cmake -S . -B build ${CMAKE_OPTIONS} -D PIPEDAL_PGO=generate
+time cmake --build ./build --target pipedal_bench pipedaltest --config Release -- -j 3
+
+# training workload
+mkdir -p ${TRAINING_DIR}
+
+# split the default bank into single-preset files for pipedal_bench --preset-file.
+python3 - default_presets/presets/Default+Bank.bank ${TRAINING_DIR} <<'PYTHON'
+import json, os, sys
+bank = json.load(open(sys.argv[1]))
+for i, preset in enumerate(bank['presets']):
+    presetFile = dict(bank, presets=[preset], selectedPreset=preset['instanceId'])
+    with open(os.path.join(sys.argv[2], f'preset{i}.piPreset'), 'w') as f:
+        json.dump(presetFile, f)
+PYTHON
+
+for preset in ${TRAINING_DIR}/*.piPreset; do
+    ./build/src/pipedal_bench --preset-file "${preset}" --periods 32,64,128 --seconds 10
+done
+./build/src/pipedaltest "[benchmark]" --benchmark-samples 20
+
+# optimized build
+cmake -S . -B build ${CMAKE_OPTIONS} -D PIPEDAL_PGO=use
+time cmake --build ./build --target all --config Release -- -j 3
@@ -3,16 +3,21 @@
 
 set -e
 
-# clean build
-rm -rf build
+if [ "$(dpkg --print-architecture)" == "arm64" ] && [ "${PIPEDAL_NO_PGO}" == "" ]; then
+    # arm64 release builds are profile-guided. (PIPEDAL_NO_PGO=1 for a plain build.)
+    ./build-pgo.sh
+else
+    # clean build
+    rm -rf build
 
-# configure for release
-mkdir -p build
-cd build
-cmake .. -D CMAKE_BUILD_TYPE=Release  -D CMAKE_VERBOSE_MAKEFILE=ON -G Ninja 
-cd ..
+    # configure for release
+    mkdir -p build
+    cd build
+    cmake .. -D CMAKE_BUILD_TYPE=Release  -D CMAKE_VERBOSE_MAKEFILE=ON -G Ninja 
+    cd ..
 
-time cmake --build ./build --target all  --config Release -- -j 3
+    time cmake --build ./build --target all  --config Release -- -j 3
+fi
 
 ./makePackage.sh
 
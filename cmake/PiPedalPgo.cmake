@@ -0,0 +1,41 @@
+# Profile-guided and link-time optimization for release builds.
+#
+#   -D PIPEDAL_PGO=generate   Instrumented build. Running the binaries writes profiles to PIPEDAL_PGO_DIR.
+#   -D PIPEDAL_PGO=use        Optimized build, using the profiles in PIPEDAL_PGO_DIR.
+#   -D PIPEDAL_LTO=ON         Link-time optimization.
+#
+# Both PGO phases must use the same build directory, since gcc matches profiles to object files by path.
+# build-pgo.sh runs the complete generate/train/use cycle.
+
+set (PIPEDAL_PGO "" CACHE STRING "Profile-guided optimization phase: empty, generate, or use.")
+set (PIPEDAL_PGO_DIR "${CMAKE_BINARY_DIR}/pgo-profiles" CACHE PATH "Directory for profile-guided optimization profiles.")
+option (PIPEDAL_LTO "Enable link-time optimization." OFF)
+
+if (PIPEDAL_PGO STREQUAL "generate")
+    message(STATUS "PGO: instrumented build. Profiles: ${PIPEDAL_PGO_DIR}")
+    # prefer-atomic: the audio, worker and web server threads all update the same counters.
+    add_compile_options(-fprofile-generate=${PIPEDAL_PGO_DIR} -fprofile-update=prefer-atomic)
+    add_link_options(-fprofile-generate=${PIPEDAL_PGO_DIR} -fprofile-update=prefer-atomic)
+elseif (PIPEDAL_PGO STREQUAL "use")
+    if (NOT EXISTS ${PIPEDAL_PGO_DIR})
+        message(FATAL_ERROR "PGO: ${PIPEDAL_PGO_DIR} not found. Build with PIPEDAL_PGO=generate, and run the training workload first.")
+    endif()
+    message(STATUS "PGO: optimized build. Profiles: ${PIPEDAL_PGO_DIR}")
+    # -fprofile-partial-training: code the training run didn't reach is optimized normally, instead of for size.
+    # -fprofile-correction: counters of multi-threaded code are not exact.
+    # -Wno-missing-profile: sources the training run never linked (tools, tests) have no profiles, which is fine.
+    add_compile_options(-fprofile-use=${PIPEDAL_PGO_DIR} -fprofile-partial-training -fprofile-correction -Wno-missing-profile)
+elseif (NOT PIPEDAL_PGO STREQUAL "")
+    message(FATAL_ERROR "PIPEDAL_PGO must be empty, 'generate', or 'use'.")
+endif()
+
+if (PIPEDAL_LTO)
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT PIPEDAL_LTO_SUPPORTED OUTPUT PIPEDAL_LTO_ERROR)
+    if (PIPEDAL_LTO_SUPPORTED)
+        message(STATUS "Link-time optimization enabled.")
+        set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+    else()
+        message(WARNING "Link-time optimization is not supported: ${PIPEDAL_LTO_ERROR}")
+    endif()
+endif()
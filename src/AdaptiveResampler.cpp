@@ -0,0 +1,268 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "AdaptiveResampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace pipedal;
+
+// PI controller gains, on the fill-level error as a fraction of the target latency.
+static constexpr double KP = 0.01;
+static constexpr double KI = 0.002;            // per second.
+static constexpr double MAX_CORRECTION = 0.005; // +/- 0.5%: far more than any real clock drift.
+static constexpr double FILL_SMOOTHING_SECONDS = 0.5;
+
+static size_t NextPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+    {
+        result *= 2;
+    }
+    return result;
+}
+
+AdaptiveResampler::AdaptiveResampler(
+    size_t channels,
+    double inputSampleRate, double outputSampleRate,
+    size_t targetLatencyFrames,
+    size_t maxLatencyFrames)
+    : channels(channels),
+      nominalRatio(inputSampleRate / outputSampleRate),
+      outputSampleRate(outputSampleRate),
+      targetFrames((double)targetLatencyFrames)
+{
+    if (channels == 0 || inputSampleRate <= 0 || outputSampleRate <= 0 || targetLatencyFrames == 0)
+    {
+        throw std::invalid_argument("Invalid AdaptiveResampler arguments.");
+    }
+    if (maxLatencyFrames == 0)
+    {
+        maxLatencyFrames = targetLatencyFrames * 3;
+    }
+    if (maxLatencyFrames < targetLatencyFrames + TAPS)
+    {
+        maxLatencyFrames = targetLatencyFrames + TAPS;
+    }
+    this->maxFrames = (double)maxLatencyFrames;
+
+    ringFrames = NextPowerOfTwo(2 * maxLatencyFrames + TAPS);
+    ringMask = ringFrames - 1;
+    ring.resize(ringFrames * channels);
+    outputFrame.resize(channels);
+    ratio = nominalRatio;
+    statRatio = ratio;
+    BuildFilter();
+}
+
+void AdaptiveResampler::BuildFilter()
+{
+    // windowed sinc, with the cutoff lowered when downsampling.
+    double cutoff = 0.9 * std::min(1.0, 1.0 / nominalRatio);
+
+    filter.resize((PHASES + 1) * TAPS);
+    for (int phase = 0; phase <= PHASES; ++phase)
+    {
+        double offset = (double)phase / PHASES;
+        float *coefficients = filter.data() + phase * TAPS;
+        double sum = 0;
+        for (int k = 0; k < TAPS; ++k)
+        {
+            // distance from the interpolated position to input frame k.
+            double d = (k - HALF_TAPS + 1) - offset;
+            double x = M_PI * cutoff * d;
+            double sinc = std::abs(x) < 1E-9 ? 1.0 : std::sin(x) / x;
+            double w = (d + HALF_TAPS) / TAPS; // 0..1 across the span.
+            double window = 0.42 - 0.5 * std::cos(2 * M_PI * w) + 0.08 * std::cos(4 * M_PI * w); // Blackman.
+            double value = sinc * window;
+            coefficients[k] = (float)value;
+            sum += value;
+        }
+        for (int k = 0; k < TAPS; ++k)
+        {
+            coefficients[k] = (float)(coefficients[k] / sum); // unity gain at DC.
+        }
+    }
+}
+
+size_t AdaptiveResampler::Write(const float *interleaved, size_t frames)
+{
+    uint64_t w = writeFrame.load(std::memory_order_relaxed);
+    uint64_t r = readFrame.load(std::memory_order_acquire);
+    size_t space = ringFrames - (size_t)(w - r);
+    size_t n = std::min(frames, space);
+    if (n < frames)
+    {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < n;)
+    {
+        size_t index = (size_t)((w + i) & ringMask);
+        size_t run = std::min(n - i, ringFrames - index);
+        std::memcpy(ring.data() + index * channels, interleaved + i * channels, run * channels * sizeof(float));
+        i += run;
+    }
+    writeFrame.store(w + n, std::memory_order_release);
+    return n;
+}
+
+void AdaptiveResampler::Interpolate(double position, float *result)
+{
+    double integerPosition = std::floor(position);
+    double phase = (position - integerPosition) * PHASES;
+    int phaseIndex = std::min((int)phase, PHASES - 1);
+    float t = (float)(phase - phaseIndex);
+    const float *c0 = filter.data() + phaseIndex * TAPS;
+    const float *c1 = c0 + TAPS;
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        result[c] = 0;
+    }
+    uint64_t first = (uint64_t)integerPosition - HALF_TAPS + 1;
+    for (int k = 0; k < TAPS; ++k)
+    {
+        float coefficient = c0[k] + (c1[k] - c0[k]) * t;
+        const float *input = Frame(first + k);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            result[c] += input[c] * coefficient;
+        }
+    }
+}
+
+void AdaptiveResampler::Read(float *const *outputs, size_t frames, bool mix)
+{
+    uint64_t written = writeFrame.load(std::memory_order_acquire);
+
+    if (state == State::Priming)
+    {
+        uint64_t buffered = written - readFrame.load(std::memory_order_relaxed);
+        if (buffered < (uint64_t)targetFrames + TAPS)
+        {
+            if (!mix)
+            {
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    std::fill(outputs[c], outputs[c] + frames, 0.0f);
+                }
+            }
+            return;
+        }
+        readPosition = (double)written - targetFrames;
+        smoothedFill = targetFrames;
+        integral = 0;
+        gain = 0;
+        state = State::Running;
+    }
+
+    double fill = (double)written - readPosition;
+    double alpha = std::min(1.0, frames / (FILL_SMOOTHING_SECONDS * outputSampleRate));
+    smoothedFill += (fill - smoothedFill) * alpha;
+
+    double error = (smoothedFill - targetFrames) / targetFrames;
+    integral = std::clamp(integral + KI * error * frames / outputSampleRate, -MAX_CORRECTION, MAX_CORRECTION);
+    double correction = std::clamp(KP * error + integral, -MAX_CORRECTION, MAX_CORRECTION);
+    ratio = nominalRatio * (1 + correction);
+
+    // the number of output frames whose input has arrived.
+    double lastPosition = (double)(written - HALF_TAPS); // exclusive.
+    size_t available = 0;
+    if (readPosition < lastPosition)
+    {
+        available = std::min(frames, (size_t)std::ceil((lastPosition - readPosition) / ratio));
+    }
+    bool underrun = available < frames;
+    bool resync = !underrun && fill > maxFrames;
+
+    float gainStep;
+    if (underrun)
+    {
+        gainStep = available == 0 ? -gain : -gain / available;
+    }
+    else if (resync)
+    {
+        gainStep = -gain / frames;
+    }
+    else
+    {
+        gainStep = 1.0f / FADE_FRAMES;
+    }
+
+    for (size_t i = 0; i < frames; ++i)
+    {
+        if (i < available)
+        {
+            Interpolate(readPosition, outputFrame.data());
+            readPosition += ratio;
+            gain = std::clamp(gain + gainStep, 0.0f, 1.0f);
+        }
+        else
+        {
+            gain = 0;
+        }
+        for (size_t c = 0; c < channels; ++c)
+        {
+            float value = i < available ? outputFrame[c] * gain : 0.0f;
+            if (mix)
+            {
+                outputs[c][i] += value;
+            }
+            else
+            {
+                outputs[c][i] = value;
+            }
+        }
+    }
+
+    if (underrun)
+    {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        state = State::Priming;
+        gain = 0;
+    }
+    else if (resync)
+    {
+        resyncs.fetch_add(1, std::memory_order_relaxed);
+        readPosition = (double)written - targetFrames;
+        smoothedFill = targetFrames;
+        gain = 0;
+    }
+    uint64_t oldestNeeded = (uint64_t)std::floor(readPosition) - HALF_TAPS + 1;
+    readFrame.store(std::min(oldestNeeded, written), std::memory_order_release);
+
+    statFill.store((float)smoothedFill, std::memory_order_relaxed);
+    statRatio.store(ratio, std::memory_order_relaxed);
+}
+
+AdaptiveResampler::Statistics AdaptiveResampler::GetStatistics() const
+{
+    Statistics result;
+    result.fillFrames = statFill.load(std::memory_order_relaxed);
+    result.targetFrames = (float)targetFrames;
+    result.ratio = statRatio.load(std::memory_order_relaxed);
+    result.underruns = underruns.load(std::memory_order_relaxed);
+    result.overruns = overruns.load(std::memory_order_relaxed);
+    result.resyncs = resyncs.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Carries audio from another clock domain (aux inputs) into the audio thread.
+     *
+     * The producer writes interleaved frames into a lock-free ring at its own pace. The audio thread reads
+     * through a polyphase windowed-sinc resampler whose ratio is trimmed by a PI controller, so that the
+     * ring's (smoothed) fill level settles at the target latency, however much the two clocks drift.
+     *
+     * Starting, underruns, and excess latency (e.g. a burst of input after a producer stall) are
+     * handled with short fades, so they don't click: on an underrun the output fades out and the ring
+     * re-primes; if the fill level exceeds maxLatencyFrames, the output fades out, skips ahead to the
+     * target latency, and fades back in.
+     */
+    class AdaptiveResampler
+    {
+    public:
+        struct Statistics
+        {
+            float fillFrames = 0;   // smoothed ring fill level.
+            float targetFrames = 0;
+            double ratio = 1.0;     // input frames consumed per output frame.
+            uint64_t underruns = 0; // the audio thread ran out of input.
+            uint64_t overruns = 0;  // input dropped because the ring was full.
+            uint64_t resyncs = 0;   // the audio thread skipped ahead to limit latency.
+        };
+
+        AdaptiveResampler(
+            size_t channels,
+            double inputSampleRate, double outputSampleRate,
+            size_t targetLatencyFrames,
+            size_t maxLatencyFrames = 0); // default: 3x targetLatencyFrames.
+
+        size_t GetChannels() const { return channels; }
+
+        // Producer thread. Returns the number of frames written.
+        size_t Write(const float *interleaved, size_t frames);
+
+        // Audio thread. Writes (or, if mix is true, adds) frames of output to outputs[0..channels-1].
+        void Read(float *const *outputs, size_t frames, bool mix = false);
+
+        // Any thread.
+        Statistics GetStatistics() const;
+
+    private:
+        static constexpr int TAPS = 16; // per phase.
+        static constexpr int HALF_TAPS = TAPS / 2;
+        static constexpr int PHASES = 256;
+        static constexpr size_t FADE_FRAMES = 256;
+
+        enum class State
+        {
+            Priming,
+            Running,
+        };
+
+        void BuildFilter();
+        float *Frame(uint64_t frame) { return ring.data() + (frame & ringMask) * channels; }
+        // produces one output frame at readPosition into outputFrame (channels samples).
+        void Interpolate(double position, float *outputFrame);
+
+        size_t channels;
+        double nominalRatio;
+        double outputSampleRate;
+        double targetFrames;
+        double maxFrames;
+
+        std::vector<float> filter; // (PHASES+1) x TAPS.
+        std::vector<float> ring;
+        uint64_t ringMask = 0;
+        size_t ringFrames = 0;
+
+        alignas(64) std::atomic<uint64_t> writeFrame{0};
+        alignas(64) std::atomic<uint64_t> readFrame{0}; // the oldest frame the reader still needs.
+
+        // audio thread.
+        State state = State::Priming;
+        double readPosition = 0;
+        double smoothedFill = 0;
+        double integral = 0;
+        double ratio = 1;
+        float gain = 0;
+        std::vector<float> outputFrame;
+
+        std::atomic<float> statFill{0};
+        std::atomic<double> statRatio{1};
+        std::atomic<uint64_t> underruns{0};
+        std::atomic<uint64_t> overruns{0};
+        std::atomic<uint64_t> resyncs{0};
+    };
+}
@@ -0,0 +1,150 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#include "pch.h"
+#include "catch.hpp"
+#include "AdaptiveResampler.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    // Simulates a stereo 1kHz sine arriving in 10ms bursts from a producer whose clock runs at
+    // (1+drift) times the nominal rate, read in 64-frame periods.
+    class DriftSimulation
+    {
+    public:
+        DriftSimulation(double drift)
+            : resampler(2, SAMPLE_RATE, SAMPLE_RATE, 1024),
+              drift(drift)
+        {
+            left.resize(PERIOD);
+            right.resize(PERIOD);
+        }
+
+        static constexpr double SAMPLE_RATE = 48000;
+        static constexpr size_t PERIOD = 64;
+        static constexpr size_t BURST = 480;
+
+        AdaptiveResampler resampler;
+        double drift;
+        double producerTime = 0; // in output frames.
+        uint64_t inputFrame = 0;
+        double outputTime = 0;
+        std::vector<float> left, right;
+        float lastSample = 0;
+        float maxStep = 0;
+        float peak = 0;
+
+        void Produce()
+        {
+            float burst[BURST * 2];
+            for (size_t i = 0; i < BURST; ++i)
+            {
+                float value = (float)std::sin(2 * M_PI * 1000 * (double)(inputFrame++) / SAMPLE_RATE);
+                burst[i * 2] = value;
+                burst[i * 2 + 1] = value;
+            }
+            resampler.Write(burst, BURST);
+            producerTime += BURST / (1 + drift);
+        }
+        // Run for the given time; if measure, track the largest sample-to-sample step and the peak.
+        void Run(double seconds, bool produce, bool measure)
+        {
+            double endTime = outputTime + seconds * SAMPLE_RATE;
+            while (outputTime < endTime)
+            {
+                while (produce && producerTime <= outputTime)
+                {
+                    Produce();
+                }
+                if (!produce)
+                {
+                    producerTime = outputTime;
+                }
+                float *outputs[2] = {left.data(), right.data()};
+                resampler.Read(outputs, PERIOD);
+                for (size_t i = 0; i < PERIOD; ++i)
+                {
+                    if (measure)
+                    {
+                        maxStep = std::max(maxStep, std::abs(left[i] - lastSample));
+                        peak = std::max(peak, std::abs(left[i]));
+                    }
+                    lastSample = left[i];
+                }
+                outputTime += PERIOD;
+            }
+        }
+    };
+}
+
+TEST_CASE("Adaptive resampler tracks clock drift", "[adaptive_resampler][Build][Dev]")
+{
+    for (double drift : {0.0, 0.001, -0.001})
+    {
+        DriftSimulation simulation(drift);
+        simulation.Run(30, true, false); // settle.
+        auto settled = simulation.resampler.GetStatistics();
+
+        simulation.Run(30, true, true);
+        auto statistics = simulation.resampler.GetStatistics();
+
+        REQUIRE(statistics.underruns == settled.underruns);
+        REQUIRE(statistics.resyncs == 0);
+        REQUIRE(statistics.overruns == 0);
+        // the fill level holds near the target, and the ratio matches the drift.
+        REQUIRE(std::abs(statistics.fillFrames - statistics.targetFrames) < 0.1f * statistics.targetFrames);
+        REQUIRE(std::abs(statistics.ratio - (1 + drift)) < 0.0002);
+        // a 1kHz sine at 48kHz changes by at most 0.131 per sample; no clicks, no loss of level.
+        REQUIRE(simulation.maxStep < 0.14f);
+        REQUIRE(simulation.peak > 0.97f);
+        REQUIRE(simulation.peak < 1.02f);
+    }
+}
+
+TEST_CASE("Adaptive resampler fades on underrun and resync", "[adaptive_resampler][Build][Dev]")
+{
+    DriftSimulation simulation(0);
+    simulation.Run(2, true, false);
+
+    // the producer stalls: the output fades out rather than stopping abruptly.
+    simulation.Run(0.5, false, true);
+    auto statistics = simulation.resampler.GetStatistics();
+    REQUIRE(statistics.underruns == 1);
+    REQUIRE(simulation.lastSample == 0.0f);
+
+    // the producer resumes, and the stream recovers.
+    simulation.Run(2, true, false);
+    REQUIRE(simulation.resampler.GetStatistics().underruns == 1);
+
+    // a burst of extra input (e.g. a clock step on the producer side) exceeds the maximum latency.
+    for (int i = 0; i < 7; ++i)
+    {
+        simulation.Produce();
+    }
+    simulation.producerTime = simulation.outputTime;
+    simulation.Run(2, true, true);
+    statistics = simulation.resampler.GetStatistics();
+    REQUIRE(statistics.underruns == 1);
+    REQUIRE(statistics.resyncs == 1);
+    REQUIRE(std::abs(statistics.fillFrames - statistics.targetFrames) < 0.1f * statistics.targetFrames);
+    REQUIRE(simulation.maxStep < 0.14f);
+}
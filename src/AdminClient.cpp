@@ -40,6 +40,7 @@ AdminClient::AdminClient()
 
 AdminClient::~AdminClient()
 {
+    StopReader();
 }
 
 bool AdminClient::CanUseAdminClient()
@@ -53,10 +54,30 @@ bool AdminClient::RequestShutdown(bool restart)
     return WriteMessage(message);
 }
 
-bool AdminClient::WriteMessage(const char *message)
+static Promise<bool> ResolvedPromise(bool value)
 {
-    std::lock_guard lock{mutex};
+    return Promise<bool>(
+        [value](ResolveFunction<bool> resolve, RejectFunction reject)
+        {
+            resolve(value);
+        });
+}
 
+bool AdminClient::Connect()
+{
+    // mutex must be held.
+    if (readerFailed)
+    {
+        // the service closed the connection (e.g. it was restarted). Reconnect.
+        // The old reader thread no longer touches client state, and may be the calling thread.
+        socket.Close();
+        if (readerThread)
+        {
+            readerThread->detach();
+            readerThread = nullptr;
+        }
+        readerFailed = false;
+    }
     if (!socket.IsOpen())
     {
         try
@@ -69,27 +90,168 @@ bool AdminClient::WriteMessage(const char *message)
             Lv2Log::error(SS("Failed to connect to PiPedal Admin service. " << e.what()));
             return false;
         }
+        readerThread = std::make_unique<std::thread>([this]()
+                                                     { ReaderProc(); });
     }
+    return true;
+}
 
-    socket.Send(message, strlen(message));
+void AdminClient::StopReader()
+{
+    std::unique_ptr<std::thread> thread;
+    {
+        std::lock_guard lock{mutex};
+        socket.Shutdown();
+        thread = std::move(readerThread);
+    }
+    if (thread)
+    {
+        thread->join();
+    }
+    std::lock_guard lock{mutex};
+    socket.Close();
+}
 
+void AdminClient::ReaderProc()
+{
     char responseBuffer[1024];
+    try
+    {
+        while (true)
+        {
+            size_t length = socket.Receive(responseBuffer, sizeof(responseBuffer) - 1);
+            if (length == 0)
+            {
+                break; // shut down.
+            }
+            responseBuffer[length] = 0;
+            CompleteRequest(responseBuffer);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("PiPedal Admin service connection failed. " << e.what()));
+    }
+
+    std::map<uint64_t, PendingRequest> abandonedRequests;
+    {
+        std::lock_guard lock{mutex};
+        readerFailed = true;
+        abandonedRequests = std::move(pendingRequests);
+        pendingRequests.clear();
+    }
+    for (auto &request : abandonedRequests)
+    {
+        request.second.reject("Lost connection to PiPedal Admin service.");
+    }
+}
 
-    socket.Receive(responseBuffer, sizeof(responseBuffer));
+void AdminClient::CompleteRequest(const char *reply)
+{
+    // reply: "#<requestId> <result> [<message>]\n"
+    const char *p = reply;
+    PendingRequest request;
+    {
+        std::lock_guard lock{mutex};
+        auto iter = pendingRequests.end();
+        if (*p == '#')
+        {
+            char *end;
+            uint64_t requestId = strtoull(p + 1, &end, 10);
+            p = end;
+            while (*p == ' ')
+            {
+                ++p;
+            }
+            iter = pendingRequests.find(requestId);
+        }
+        else
+        {
+            // untagged reply from an older service, which replies in order.
+            iter = pendingRequests.begin();
+        }
+        if (iter == pendingRequests.end())
+        {
+            Lv2Log::warning(SS("AdminClient: Unexpected reply: " << reply));
+            return;
+        }
+        request = std::move(iter->second);
+        pendingRequests.erase(iter);
+    }
 
-    int response = atoi(responseBuffer);
-    if (response == -2) // throw exception with message
+    int response = atoi(p);
+    if (response == -2) // reject with message
     {
-        const char *p = responseBuffer;
         while (*p != ' ' && *p != '\n' && *p != '\0')
         {
             ++p;
         }
         if (*p != 0)
             ++p;
-        throw PiPedalStateException(p);
+        std::string message{p};
+        if (message.length() != 0 && message[message.length() - 1] == '\n')
+        {
+            message.resize(message.length() - 1);
+        }
+        request.reject(message);
+    }
+    else
+    {
+        request.resolve(response == 0);
+    }
+}
+
+Promise<bool> AdminClient::SendRequest(const std::string &message)
+{
+    Promise<bool> result;
+    result.Work(
+        [this, &message](ResolveFunction<bool> resolve, RejectFunction reject)
+        {
+            // complete the promise without holding the mutex, since handlers may issue further requests.
+            std::string error;
+            bool connected;
+            {
+                std::lock_guard lock{mutex};
+                connected = Connect();
+                if (connected)
+                {
+                    uint64_t requestId = nextRequestId++;
+                    pendingRequests[requestId] = PendingRequest{resolve, reject};
+
+                    std::string taggedMessage = SS('#' << requestId << ' ' << message);
+                    try
+                    {
+                        socket.Send(taggedMessage.c_str(), taggedMessage.length());
+                    }
+                    catch (const std::exception &e)
+                    {
+                        pendingRequests.erase(requestId);
+                        error = e.what();
+                    }
+                }
+            }
+            if (!connected)
+            {
+                resolve(false); // (already logged)
+            }
+            else if (error.length() != 0)
+            {
+                reject(error);
+            }
+        });
+    return result;
+}
+
+bool AdminClient::WriteMessage(const std::string &message)
+{
+    try
+    {
+        return SendRequest(message).Get();
+    }
+    catch (const std::logic_error &e)
+    {
+        throw PiPedalStateException(e.what());
     }
-    return response == 0;
 }
 
 bool AdminClient::SetJackServerConfiguration(const JackServerSettings &jackServerSettings)
@@ -138,7 +300,7 @@ void AdminClient::SetWifiDirectConfig(const WifiDirectConfigSettings &settings)
     }
 }
 
-void AdminClient::SetGovernorSettings(const std::string &settings)
+Promise<bool> AdminClient::SetGovernorSettingsAsync(const std::string &governor)
 {
     if (!CanUseAdminClient())
     {
@@ -146,40 +308,62 @@ void AdminClient::SetGovernorSettings(const std::string &settings)
     }
     if (!HasCpuGovernor())
     {
-        return;
+        return ResolvedPromise(true);
     }
     std::stringstream cmd;
     cmd << "GovernorSettings ";
     json_writer writer(cmd, true);
-    writer.write(settings);
+    writer.write(governor);
     cmd << '\n';
-    bool result = WriteMessage(cmd.str().c_str());
+    return SendRequest(cmd.str());
+}
+
+void AdminClient::SetGovernorSettings(const std::string &settings)
+{
+    bool result;
+    try
+    {
+        result = SetGovernorSettingsAsync(settings).Get();
+    }
+    catch (const std::logic_error &e)
+    {
+        throw PiPedalStateException(e.what());
+    }
     if (!result)
     { // unexpected. Should throw exception on failure.
         throw PiPedalException("Operation failed.");
     }
 }
 
-void AdminClient::MonitorGovernor(const std::string &governor)
+Promise<bool> AdminClient::MonitorGovernorAsync(const std::string &governor)
 {
     if (!CanUseAdminClient())
     {
-        return;
+        return ResolvedPromise(false);
     }
     if (!HasCpuGovernor())
     {
-        return;
+        return ResolvedPromise(true);
     }
     std::stringstream cmd;
     cmd << "MonitorGovernor ";
     json_writer writer(cmd, true);
     writer.write(governor);
     cmd << '\n';
-    bool result = WriteMessage(cmd.str().c_str());
-    if (!result)
-    { // unexpected. Should throw exception on failure.
-        Lv2Log::warning("Not monitoring CPU governor status.");
-    }
+    return SendRequest(cmd.str());
+}
+
+void AdminClient::MonitorGovernor(const std::string &governor)
+{
+    MonitorGovernorAsync(governor)
+        .Then([](bool result)
+              {
+                  if (!result)
+                  {
+                      Lv2Log::warning("Not monitoring CPU governor status.");
+                  } })
+        .Catch([](const std::string &message)
+               { Lv2Log::warning(SS("Not monitoring CPU governor status. " << message)); });
 }
 void AdminClient::UnmonitorGovernor()
 {
@@ -194,11 +378,58 @@ void AdminClient::UnmonitorGovernor()
     std::stringstream cmd;
     cmd << "UnmonitorGovernor";
     cmd << '\n';
-    bool ignored = WriteMessage(cmd.str().c_str());
+    bool ignored = WriteMessage(cmd.str());
 }
 
+Promise<bool> AdminClient::SetCpuMinimumFrequencyAsync(uint64_t frequencyKHz)
+{
+    if (!CanUseAdminClient() || !HasCpuGovernor())
+    {
+        return ResolvedPromise(true);
+    }
+    std::stringstream cmd;
+    cmd << "CpuMinimumFrequency " << frequencyKHz << '\n';
+    return SendRequest(cmd.str());
+}
+
+void AdminClient::SetCpuMinimumFrequency(uint64_t frequencyKHz)
+{
+    SetCpuMinimumFrequencyAsync(frequencyKHz)
+        .Then([](bool result)
+              {
+                  if (!result)
+                  {
+                      Lv2Log::warning("Failed to set the minimum CPU frequency.");
+                  } })
+        .Catch([](const std::string &message)
+               { Lv2Log::warning(SS("Failed to set the minimum CPU frequency. " << message)); });
+}
 
-void AdminClient::InstallUpdate(const std::string&filename)
+Promise<bool> AdminClient::SetAudioIrqAffinityAsync(const std::string &cpuList)
+{
+    if (!CanUseAdminClient())
+    {
+        return ResolvedPromise(true);
+    }
+    std::stringstream cmd;
+    cmd << "AudioIrqAffinity " << cpuList << '\n';
+    return SendRequest(cmd.str());
+}
+
+void AdminClient::SetAudioIrqAffinity(const std::string &cpuList)
+{
+    SetAudioIrqAffinityAsync(cpuList)
+        .Then([](bool result)
+              {
+                  if (!result)
+                  {
+                      Lv2Log::warning("Failed to set audio IRQ affinity.");
+                  } })
+        .Catch([](const std::string &message)
+               { Lv2Log::warning(SS("Failed to set audio IRQ affinity. " << message)); });
+}
+
+Promise<bool> AdminClient::InstallUpdateAsync(const std::string &filename)
 {
     if (!CanUseAdminClient())
     {
@@ -207,5 +438,14 @@ void AdminClient::InstallUpdate(const std::string&filename)
     }
     std::stringstream cmd;
     cmd << "InstallUpdate " << filename << '\n';
-    bool ignroed = WriteMessage(cmd.str().c_str());
+    return SendRequest(cmd.str());
+}
+
+void AdminClient::InstallUpdate(const std::string &filename)
+{
+    // the update service takes over from here; the reply carries no useful information.
+    InstallUpdateAsync(filename)
+        .Then([](bool result) {})
+        .Catch([](const std::string &message)
+               { Lv2Log::error(SS("Failed to start update. " << message)); });
 }
@@ -24,13 +24,32 @@
 #include "WifiConfigSettings.hpp"
 #include "WifiDirectConfigSettings.hpp"
 #include "UnixSocket.hpp"
+#include "Promise.hpp"
 #include <mutex>
+#include <map>
+#include <thread>
+#include <memory>
 
 namespace pipedal {
 
 
+/**
+ * @brief Client for privileged operations performed by pipedaladmind.
+ * 
+ * Requests share a single persistent connection to the admin service. Each request 
+ * carries a request id that the service echoes in its reply, so callers on different 
+ * threads can have requests in flight at the same time without waiting on each other's
+ * replies.
+ * 
+ * The ...Async methods return a Promise that resolves with true on success, false if the
+ * service reports failure, and rejects with the service's error message. Then and Catch 
+ * handlers run on the client's reader thread unless an executor is attached with On(). 
+ * Handlers must not wait on other AdminClient requests.
+ * 
+ * The synchronous methods wait for the reply, and throw on errors.
+ */
 class AdminClient {
-    bool WriteMessage(const char*message);
+    bool WriteMessage(const std::string &message);
 public:
     AdminClient();
     ~AdminClient();
@@ -42,10 +61,35 @@ public:
     void SetGovernorSettings(const std::string & governor);
     void MonitorGovernor(const std::string &governor);
     void UnmonitorGovernor();
+    // "auto" governor only. kHz.
+    void SetCpuMinimumFrequency(uint64_t frequencyKHz);
+    // Route USB host controller interrupts to the given cpu list.
+    void SetAudioIrqAffinity(const std::string &cpuList);
     void InstallUpdate(const std::string&filename);
+
+    Promise<bool> SendRequest(const std::string &message);
+    Promise<bool> SetGovernorSettingsAsync(const std::string & governor);
+    Promise<bool> MonitorGovernorAsync(const std::string &governor);
+    Promise<bool> SetCpuMinimumFrequencyAsync(uint64_t frequencyKHz);
+    Promise<bool> SetAudioIrqAffinityAsync(const std::string &cpuList);
+    Promise<bool> InstallUpdateAsync(const std::string&filename);
+
 private:
+    struct PendingRequest {
+        ResolveFunction<bool> resolve;
+        RejectFunction reject;
+    };
+    bool Connect();
+    void StopReader();
+    void ReaderProc();
+    void CompleteRequest(const char *reply);
+
     std::mutex mutex;
     UnixSocket socket;
+    std::unique_ptr<std::thread> readerThread;
+    bool readerFailed = false;
+    uint64_t nextRequestId = 1;
+    std::map<uint64_t, PendingRequest> pendingRequests;
 };
 
 } // namespace
\ No newline at end of file
@@ -27,6 +27,9 @@
 #include "ss.hpp"
 #include "CommandLineParser.hpp"
 #include "CpuGovernor.hpp"
+#include "CpuList.hpp"
+#include <fstream>
+#include <cctype>
 #include <iostream>
 #include <cstdint>
 #include <iostream>
@@ -106,15 +109,53 @@ public:
         {
             std::unique_lock<std::mutex> lock(mutex);
             wake = true;
+            if (governor != this->governor)
+            {
+                this->minimumFrequency = 0;
+            }
             this->governor = governor;
         }
         cv.notify_one();
     }
+    // Only honoured while the governor is "auto".
+    void SetMinimumFrequency(uint64_t frequencyKHz)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake = true;
+            this->minimumFrequency = frequencyKHz;
+        }
+        cv.notify_one();
+    }
 
 private:
     bool wake = false;
     bool cancelled = false;
     std::string savedGovernor;
+    uint64_t minimumFrequency = 0;
+    uint64_t savedMinimumFrequency = 0;
+    uint64_t appliedMinimumFrequency = 0;
+
+    void ApplyMinimumFrequency(const std::string &governor, uint64_t minimumFrequency)
+    {
+        // 0, or not "auto": restore the minimum frequency we found at startup.
+        uint64_t frequency = (governor == AUTO_CPU_GOVERNOR && minimumFrequency != 0) ? minimumFrequency : savedMinimumFrequency;
+        if (frequency == 0 || frequency == appliedMinimumFrequency)
+        {
+            return;
+        }
+        try
+        {
+            pipedal::SetCpuMinimumFrequency(frequency);
+            appliedMinimumFrequency = frequency;
+            Lv2Log::info(SS("CPU minimum frequency set to " << (frequency / 1000) << " MHz."));
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Failed to set the CPU minimum frequency. " << e.what()));
+            appliedMinimumFrequency = frequency; // don't retry every 5 seconds.
+        }
+    }
     void ServiceProc()
     {
         if (!HasCpuGovernor())
@@ -122,11 +163,14 @@ private:
             return;
         }
         savedGovernor = pipedal::GetCpuGovernor();
-        pipedal::SetCpuGovernor(this->governor);
+        savedMinimumFrequency = pipedal::GetCpuMinimumFrequency();
+        appliedMinimumFrequency = savedMinimumFrequency;
+        pipedal::SetCpuGovernor(GetEffectiveCpuGovernor(this->governor));
         while (true)
         {
             bool cancelled;
             std::string governor;
+            uint64_t minimumFrequency;
             {
                 std::unique_lock<std::mutex> lock(mutex);
                 auto timeToWaitFor = std::chrono::system_clock::now() + 5000ms;
@@ -136,23 +180,27 @@ private:
                     [this]() { return wake; });
                 wake = false;
                 governor = this->governor;
+                minimumFrequency = this->minimumFrequency;
                 cancelled = this->cancelled;
             }
             if (cancelled)
             {
                 break;
             }
+            std::string effectiveGovernor = GetEffectiveCpuGovernor(governor);
             std::string activeGovernor = pipedal::GetCpuGovernor();
-            if (activeGovernor != governor)
+            if (activeGovernor != effectiveGovernor)
             {
                 // somebody set it so they must have wanted it.
                 // save the value so that we can restore it when done.
                 savedGovernor = activeGovernor;
 
                 // but insist on using ours!!
-                pipedal::SetCpuGovernor(governor);
+                pipedal::SetCpuGovernor(effectiveGovernor);
             }
+            ApplyMinimumFrequency(governor, minimumFrequency);
         }
+        ApplyMinimumFrequency("", 0);
         pipedal::SetCpuGovernor(savedGovernor);
     }
     std::unique_ptr<std::thread> pThread;
@@ -173,6 +221,64 @@ void StartGovernorMonitorThread(const std::string &governor)
     governorMonitorThread.Start(governor);
 }
 
+// USB host controllers, which service USB audio interfaces.
+static bool isUsbIrq(const std::string &line)
+{
+    static const char *USB_IRQ_NAMES[] = {"xhci", "ehci", "ohci", "dwc", "usb"};
+    for (const char *name : USB_IRQ_NAMES)
+    {
+        if (line.find(name) != std::string::npos)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void SetAudioIrqAffinity(const std::string &cpuList)
+{
+    std::string validatedCpuList = FormatCpuList(ParseCpuList(cpuList));
+    if (validatedCpuList.empty())
+    {
+        throw PiPedalArgumentException("Invalid arguments.");
+    }
+    std::ifstream f("/proc/interrupts");
+    if (!f.is_open())
+    {
+        throw std::runtime_error("Can't read /proc/interrupts.");
+    }
+    std::string line;
+    while (std::getline(f, line))
+    {
+        // "  NN:   count count ... controller  hwirq  name"
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        std::string irq = line.substr(0, colon);
+        irq.erase(0, irq.find_first_not_of(' '));
+        if (irq.empty() || !std::isdigit((unsigned char)irq[0]) || !isUsbIrq(line))
+        {
+            continue;
+        }
+        std::filesystem::path path = SS("/proc/irq/" << irq << "/smp_affinity_list");
+        std::ofstream out(path);
+        if (out.is_open())
+        {
+            out << validatedCpuList << std::endl;
+        }
+        if (!out.is_open() || out.fail())
+        {
+            Lv2Log::warning(SS("Can't set affinity for IRQ " << irq << "."));
+        }
+        else
+        {
+            Lv2Log::info(SS("IRQ " << irq << " affinity set to " << validatedCpuList << "."));
+        }
+    }
+}
+
 static bool startsWith(const std::string &s, const char *text)
 {
     if (s.length() < strlen(text))
@@ -258,6 +364,20 @@ private:
         buffer[length] = 0;
 
         std::string text{buffer};
+
+        // Requests from pipelining clients are tagged "#<requestId> <command>". Echo the tag in the reply.
+        std::string replyTag;
+        if (text.length() != 0 && text[0] == '#')
+        {
+            auto tagEnd = text.find_first_of(' ');
+            if (tagEnd == std::string::npos)
+            {
+                tagEnd = text.length();
+            }
+            replyTag = text.substr(0, tagEnd) + " ";
+            text = tagEnd < text.length() ? text.substr(tagEnd + 1) : "";
+        }
+
         int result = -1;
         std::string command;
         std::string args;
@@ -302,6 +422,26 @@ private:
                 StartGovernorMonitorThread(governor);
                 result = 0;
             }
+            else if (command == "AudioIrqAffinity")
+            {
+                SetAudioIrqAffinity(args);
+                result = 0;
+            }
+            else if (command == "CpuMinimumFrequency")
+            {
+                std::stringstream ss(args);
+                uint64_t frequency = 0;
+                ss >> frequency;
+                if (ss.fail())
+                {
+                    throw PiPedalArgumentException("Invalid arguments.");
+                }
+                if (HasCpuGovernor())
+                {
+                    governorMonitorThread.SetMinimumFrequency(frequency);
+                }
+                result = 0;
+            }
             else if (command == "GovernorSettings")
             {
                 std::stringstream ss(args);
@@ -387,7 +527,7 @@ private:
         catch (const std::exception &e)
         {
 
-            std::string reply = SS("-2 " << e.what() << "\n");
+            std::string reply = SS(replyTag << "-2 " << e.what() << "\n");
 
             try
             {
@@ -400,7 +540,7 @@ private:
         }
 
         std::string reply;
-        reply = SS(result << "\n");
+        reply = SS(replyTag << result << "\n");
         try
         {
             socket.SendTo(reply.c_str(), reply.length(), sender);
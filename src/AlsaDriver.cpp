@@ -41,6 +41,11 @@
 #include <iomanip>
 
 #include "CpuUse.hpp"
+#include "AlsaSampleConverters.hpp"
+#include "AdaptiveResampler.hpp"
+#include "WakeupJitter.hpp"
+#include "AudioPeriodTrace.hpp"
+#include "Tracer.hpp"
 
 #include <alsa/asoundlib.h>
 
@@ -289,6 +294,31 @@ namespace pipedal
         std::recursive_mutex restartMutex;
 
         pipedal::CpuUse cpuUse;
+        AudioPeriodTrace periodTrace;
+
+    public:
+        virtual std::vector<AudioPeriodTraceEntry> GetPeriodTrace(double seconds) override
+        {
+            return periodTrace.GetRecent(seconds);
+        }
+        virtual XrunRecoveryStatistics GetXrunRecoveryStatistics() override
+        {
+            return periodTrace.GetXrunRecoveryStatistics();
+        }
+        virtual CpuUseStatistics GetCpuUseStatistics() override
+        {
+            return cpuUse.GetStatistics();
+        }
+        virtual void ResetCpuUseStatistics() override
+        {
+            cpuUse.ResetStatistics();
+        }
+        virtual std::optional<float> TakeRecentCpuHeadroom() override
+        {
+            return cpuUse.TakeRecentHeadroom();
+        }
+
+    private:
 
 #ifdef ALSADRIVER_CONFIG_DBG
         snd_output_t *snd_output = nullptr;
@@ -325,6 +355,16 @@ namespace pipedal
         CopyFunction copyInputFn;
         CopyFunction copyOutputFn;
 
+        // Vectorized converters, if available for the current format and cpu. Otherwise copyInputFn/copyOutputFn
+        // are the scalar converters.
+        SimdLevel sampleConverterSimdLevel = GetSimdLevel();
+        CopyFunction scalarCopyInputFn = nullptr;
+        CopyFunction scalarCopyOutputFn = nullptr;
+        CaptureConverterFn captureConverterFn = nullptr;
+        PlaybackConverterFn playbackConverterFn = nullptr;
+        std::vector<float> interleavedCaptureBuffer;
+        std::vector<float> interleavedPlaybackBuffer;
+
         bool inputSwapped = false;
         bool outputSwapped = false;
 
@@ -337,6 +377,13 @@ namespace pipedal
         std::vector<uint8_t> rawCaptureBuffer;
         std::vector<uint8_t> rawPlaybackBuffer;
 
+        // The sample converters read from captureData and write to playbackData, which point either to
+        // rawCaptureBuffer/rawPlaybackBuffer, or directly into the ALSA DMA buffers in mmap mode.
+        uint8_t *captureData = nullptr;
+        uint8_t *playbackData = nullptr;
+        bool captureMmap = false;
+        bool playbackMmap = false;
+
         AudioDriverHost *driverHost = nullptr;
 
         void validate_capture_handle()
@@ -411,6 +458,37 @@ namespace pipedal
 
         bool capture_and_playback_not_synced = false;
 
+        // Aggregate mode: separate capture and playback cards that can't be linked, and so run on their own clocks.
+        // The clock master's stream drives the audio thread. The other (slave) stream runs on its own thread, and its
+        // audio crosses into (or out of) the master's clock domain through an AdaptiveResampler, which tracks the drift
+        // so that the latency stays where it started instead of creeping until a stream xruns.
+        bool aggregateMode = false;
+        bool captureIsClockMaster = false;
+        uint32_t captureSampleRate = 0;
+        uint32_t playbackSampleRate = 0;
+        std::unique_ptr<AdaptiveResampler> captureResampler;  // capture thread -> audio thread, if the playback device is the master.
+        std::unique_ptr<AdaptiveResampler> playbackResampler; // audio thread -> playback thread, if the capture device is the master.
+        std::vector<float *> aggregateCaptureBuffers;         // the audio thread's side of the resampler.
+        std::vector<float *> aggregatePlaybackBuffers;
+        std::vector<float> aggregateInterleavedBuffer;
+        std::unique_ptr<std::jthread> aggregateThread;
+        std::atomic<bool> stopAggregateThread = false;
+        std::atomic<bool> aggregateThreadFailed = false;
+        std::atomic<uint64_t> aggregateXruns = 0; // reported by the audio thread.
+        uint64_t reportedAggregateXruns = 0;
+
+        // Timer scheduling (after PulseAudio's tsched): the audio thread sleeps until the hardware timestamp of the capture
+        // stream's last pointer update predicts that a period is ready, instead of waiting for the period interrupt, which
+        // some USB interfaces deliver well after the data arrives. Playback is only filled to two periods.
+        bool timerScheduling = false;
+        static constexpr uint64_t TSCHED_WAKE_MARGIN_NS = 50'000; // aim just after the predicted time; an early wakeup costs another sleep.
+        static constexpr int TSCHED_MAX_WAKEUPS = 8;               // per period, before falling back to the interrupt.
+        snd_pcm_uframes_t playbackBufferFrames = 0;
+        WakeupJitter wakeupJitter;
+
+        // Xrun recovery prefills playback from here (playbackBufferFrames of silence) instead of clearing a buffer on the audio thread.
+        std::vector<uint8_t> silencePlaybackBuffer;
+
         std::mutex terminateSync;
 
         std::atomic<bool> terminateAudio_ = false;
@@ -495,10 +573,27 @@ namespace pipedal
                 AlsaError(SS("No playback configurations available (" << snd_strerror(err) << ")"));
             }
 
-            err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
-            if (err < 0)
+            bool &useMmap = isCaptureStream ? this->captureMmap : this->playbackMmap;
+            useMmap = false;
+            if (this->jackServerSettings.GetAlsaMmap())
+            {
+                err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED);
+                if (err >= 0)
+                {
+                    useMmap = true;
+                }
+                else
+                {
+                    Lv2Log::info(SS("ALSA mmap access not supported (" << alsa_device_name << "/" << streamType << "). Using read/write access."));
+                }
+            }
+            if (!useMmap)
             {
-                AlsaError("snd_pcm_hw_params_set_access failed.");
+                err = snd_pcm_hw_params_set_access(handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED);
+                if (err < 0)
+                {
+                    AlsaError("snd_pcm_hw_params_set_access failed.");
+                }
             }
 
             SetPreferredAlsaFormat(alsa_device_name, streamType, handle, hwParams);
@@ -649,12 +744,16 @@ namespace pipedal
                 AlsaError(SS("Cannot set avail min for " << alsa_device_name));
             }
 
-            // err = snd_pcm_sw_params_set_tstamp_mode(handle, swParams, SND_PCM_TSTAMP_ENABLE);
-            // if (err < 0)
-            // {
-            //     Lv2Log::info(SS(
-            //         "Could not enable ALSA time stamp mode for " << alsa_device_name << " (err " << err << ")"));
-            // }
+            if (this->timerScheduling)
+            {
+                // snd_pcm_htimestamp() predicts when the next period is ready.
+                err = snd_pcm_sw_params_set_tstamp_mode(handle, swParams, SND_PCM_TSTAMP_ENABLE);
+                if (err < 0)
+                {
+                    Lv2Log::info(SS(
+                        "Could not enable ALSA time stamp mode for " << alsa_device_name << " (err " << err << ")"));
+                }
+            }
 
 #if SND_LIB_MAJOR >= 1 && SND_LIB_MINOR >= 1
             err = snd_pcm_sw_params_set_tstamp_type(handle, swParams, SND_PCM_TSTAMP_TYPE_MONOTONIC);
@@ -693,6 +792,7 @@ namespace pipedal
                     &captureChannels,
                     &this->capturePeriods,
                     &this->captureHardwarePeriodSize);
+                this->captureSampleRate = this->sampleRate;
             }
             if (this->playbackHandle)
             {
@@ -706,6 +806,8 @@ namespace pipedal
                     &playbackChannels,
                     &this->playbackPeriods,
                     &this->playbackHardwarePeriodSize);
+                this->playbackSampleRate = this->sampleRate;
+                snd_pcm_hw_params_get_buffer_size(playbackHwParams, &this->playbackBufferFrames);
             }
 
 #ifdef ALSADRIVER_CONFIG_DBG
@@ -735,12 +837,9 @@ namespace pipedal
             int32_t v = EndianSwap(*(int32_t *)&v_);
             *(int32_t *)p = v;
         }
-        template <typename T>
-        static T *getCaptureBuffer(std::vector<uint8_t> &buffer) { return (T *)(buffer.data()); }
-
         void CopyCaptureFloatBe(size_t frames)
         {
-            int32_t *p = getCaptureBuffer<int32_t>(rawCaptureBuffer);
+            int32_t *p = (int32_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -758,7 +857,7 @@ namespace pipedal
 
         void CopyCaptureFloatLe(size_t frames)
         {
-            float *p = getCaptureBuffer<float>(rawCaptureBuffer);
+            float *p = (float *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -774,7 +873,7 @@ namespace pipedal
 
         void CopyCaptureS16Le(size_t frames)
         {
-            int16_t *p = getCaptureBuffer<int16_t>(rawCaptureBuffer);
+            int16_t *p = (int16_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -790,7 +889,7 @@ namespace pipedal
         }
         void CopyCaptureS16Be(size_t frames)
         {
-            int16_t *p = getCaptureBuffer<int16_t>(rawCaptureBuffer);
+            int16_t *p = (int16_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -807,7 +906,7 @@ namespace pipedal
 
         void CopyCaptureS32Le(size_t frames)
         {
-            int32_t *p = getCaptureBuffer<int32_t>(rawCaptureBuffer);
+            int32_t *p = (int32_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -823,7 +922,7 @@ namespace pipedal
         }
         void CopyCaptureS24_3Le(size_t frames)
         {
-            uint8_t *p = getCaptureBuffer<uint8_t>(rawCaptureBuffer);
+            uint8_t *p = (uint8_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -840,7 +939,7 @@ namespace pipedal
         }
         void CopyCaptureS24_3Be(size_t frames)
         {
-            uint8_t *p = (uint8_t *)rawCaptureBuffer.data();
+            uint8_t *p = captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -857,7 +956,7 @@ namespace pipedal
         }
         void CopyCaptureS24Le(size_t frames)
         {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
+            int32_t *p = (int32_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -873,7 +972,7 @@ namespace pipedal
         }
         void CopyCaptureS24Be(size_t frames)
         {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
+            int32_t *p = (int32_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -889,7 +988,7 @@ namespace pipedal
         }
         void CopyCaptureS32Be(size_t frames)
         {
-            int32_t *p = (int32_t *)rawCaptureBuffer.data();
+            int32_t *p = (int32_t *)captureData;
 
             std::vector<float *> &buffers = this->captureBuffers;
             int channels = this->captureChannels;
@@ -905,7 +1004,7 @@ namespace pipedal
         }
         void CopyPlaybackS16Le(size_t frames)
         {
-            int16_t *p = (int16_t *)rawPlaybackBuffer.data();
+            int16_t *p = (int16_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -925,7 +1024,7 @@ namespace pipedal
         }
         void CopyPlaybackS16Be(size_t frames)
         {
-            int16_t *p = (int16_t *)rawPlaybackBuffer.data();
+            int16_t *p = (int16_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -945,7 +1044,7 @@ namespace pipedal
         }
         void CopyPlaybackS32Le(size_t frames)
         {
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
+            int32_t *p = (int32_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -967,7 +1066,7 @@ namespace pipedal
         {
             // 24 bits in low bits of an int32_t.
 
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
+            int32_t *p = (int32_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -989,7 +1088,7 @@ namespace pipedal
         {
             // 24 bits in low bits of an int32_t.
 
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
+            int32_t *p = (int32_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1009,7 +1108,7 @@ namespace pipedal
         }
         void CopyPlaybackS32Be(size_t frames)
         {
-            int32_t *p = (int32_t *)rawPlaybackBuffer.data();
+            int32_t *p = (int32_t *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1029,7 +1128,7 @@ namespace pipedal
         }
         void CopyPlaybackS24_3Be(size_t frames)
         {
-            uint8_t *p = (uint8_t *)rawPlaybackBuffer.data();
+            uint8_t *p = playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1054,7 +1153,7 @@ namespace pipedal
         }
         void CopyPlaybackS24_3Le(size_t frames)
         {
-            uint8_t *p = (uint8_t *)rawPlaybackBuffer.data();
+            uint8_t *p = playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1080,7 +1179,7 @@ namespace pipedal
 
         void CopyPlaybackFloatLe(size_t frames)
         {
-            float *p = (float *)rawPlaybackBuffer.data();
+            float *p = (float *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1095,7 +1194,7 @@ namespace pipedal
         }
         void CopyPlaybackFloatBe(size_t frames)
         {
-            float *p = (float *)rawPlaybackBuffer.data();
+            float *p = (float *)playbackData;
 
             std::vector<float *> &buffers = this->playbackBuffers;
             int channels = this->playbackChannels;
@@ -1110,6 +1209,38 @@ namespace pipedal
             }
         }
 
+        void CopyCaptureSimd(size_t frames)
+        {
+            if (captureChannels == 1)
+            {
+                captureConverterFn(captureData, captureBuffers[0], frames);
+                return;
+            }
+            captureConverterFn(captureData, interleavedCaptureBuffer.data(), frames * captureChannels);
+            DeinterleaveSamples(interleavedCaptureBuffer.data(), captureBuffers.data(), captureChannels, frames);
+        }
+        void CopyPlaybackSimd(size_t frames)
+        {
+            if (playbackChannels == 1)
+            {
+                playbackConverterFn(playbackBuffers[0], playbackData, frames);
+                return;
+            }
+            InterleaveSamples(playbackBuffers.data(), interleavedPlaybackBuffer.data(), playbackChannels, frames);
+            playbackConverterFn(interleavedPlaybackBuffer.data(), playbackData, frames * playbackChannels);
+        }
+
+        void SelectCaptureConverter()
+        {
+            captureConverterFn = GetCaptureConverter(captureFormat, sampleConverterSimdLevel);
+            copyInputFn = captureConverterFn ? &AlsaDriverImpl::CopyCaptureSimd : scalarCopyInputFn;
+        }
+        void SelectPlaybackConverter(snd_pcm_format_t playbackFormat)
+        {
+            playbackConverterFn = GetPlaybackConverter(playbackFormat, sampleConverterSimdLevel);
+            copyOutputFn = playbackConverterFn ? &AlsaDriverImpl::CopyPlaybackSimd : scalarCopyOutputFn;
+        }
+
     public:
         void TestFormatEncodeDecode(snd_pcm_format_t captureFormat);
 
@@ -1158,6 +1289,7 @@ namespace pipedal
         {
             std::lock_guard lock{restartMutex};
             Lv2Log::debug("Restarting ALSA devices.");
+            StopAggregateThread();
 
             try
             {
@@ -1179,13 +1311,16 @@ namespace pipedal
                 Lv2Log::error(SS("Error opening ALSA: " << e.what()));
                 throw std::runtime_error("Unable to restart the audio stream.");
             }
-            int err;
-            
-            if ((err = snd_pcm_start(captureHandle)) < 0)
+            try
+            {
+                StartStreams();
+            }
+            catch (const std::exception &e)
             {
-                Lv2Log::error(SS("Unable to restart ALSA capture: " << snd_strerror(err)));
+                Lv2Log::error(e.what());
                 throw PiPedalStateException("Unable to restart ALSA capture.");
             }
+            StartAggregateThread();
             TraceBufferPositions(0,'+');
             audioRunning = true;
         }
@@ -1193,6 +1328,7 @@ namespace pipedal
         void PrepareCaptureFunctions(snd_pcm_format_t captureFormat)
         {
             this->captureFormat = captureFormat;
+            copyInputFn = nullptr;
 
             switch (captureFormat)
             {
@@ -1248,6 +1384,10 @@ namespace pipedal
             captureFrameSize = captureSampleSize * captureChannels;
             rawCaptureBuffer.resize(captureFrameSize * bufferSize * 2);
             memset(rawCaptureBuffer.data(), 0, rawCaptureBuffer.size());
+            interleavedCaptureBuffer.resize(captureChannels * bufferSize * 2);
+
+            scalarCopyInputFn = copyInputFn;
+            SelectCaptureConverter();
 
             AllocateBuffers(captureBuffers, captureChannels);
         }
@@ -1262,6 +1402,14 @@ namespace pipedal
                 << ", " << this->bufferSize << "x" << this->numberOfBuffers
                 << ", in: " << this->InputBufferCount() << "/" << this->captureChannels
                 << ", out: " << this->OutputBufferCount() << "/" << this->playbackChannels);
+            if (aggregateMode)
+            {
+                result += SS(", aggregated (" << (captureIsClockMaster ? "input" : "output") << " clock)");
+            }
+            if (timerScheduling)
+            {
+                result += ", timer-scheduled";
+            }
             return result;
         }
         void PreparePlaybackFunctions(snd_pcm_format_t playbackFormat)
@@ -1320,6 +1468,11 @@ namespace pipedal
             playbackFrameSize = playbackSampleSize * playbackChannels;
             rawPlaybackBuffer.resize(playbackFrameSize * bufferSize);
             memset(rawPlaybackBuffer.data(), 0, playbackFrameSize * bufferSize);
+            silencePlaybackBuffer.assign(playbackFrameSize * std::max((size_t)playbackBufferFrames, (size_t)bufferSize), 0);
+            interleavedPlaybackBuffer.resize(playbackChannels * bufferSize);
+
+            scalarCopyOutputFn = copyOutputFn;
+            SelectPlaybackConverter(playbackFormat);
 
             AllocateBuffers(playbackBuffers, playbackChannels);
         }
@@ -1337,6 +1490,7 @@ namespace pipedal
             this->numberOfBuffers = jackServerSettings.GetNumberOfBuffers();
             this->bufferSize = jackServerSettings.GetBufferSize();
             this->user_threshold = jackServerSettings.GetBufferSize();
+            this->timerScheduling = jackServerSettings.GetAlsaTimerScheduling();
 
             try
             {
@@ -1453,6 +1607,12 @@ namespace pipedal
                 snd_pcm_hw_params_get_format(playbackHwParams, &playbackFormat);
 
                 PreparePlaybackFunctions(playbackFormat);
+
+                aggregateMode = capture_and_playback_not_synced && inputName != outputName;
+                if (aggregateMode)
+                {
+                    PrepareAggregateMode(jackServerSettings.GetAlsaInputClockMaster());
+                }
             }
             catch (const std::exception &e)
             {
@@ -1461,6 +1621,260 @@ namespace pipedal
             }
         }
 
+        void PrepareAggregateMode(bool captureIsClockMaster)
+        {
+            this->captureIsClockMaster = captureIsClockMaster;
+            // the two sides of the resampler each move a period at a time, at unrelated phases.
+            size_t targetLatencyFrames = 2 * this->bufferSize;
+
+            this->captureResampler = nullptr;
+            this->playbackResampler = nullptr;
+            if (captureIsClockMaster)
+            {
+                this->sampleRate = captureSampleRate;
+                this->playbackResampler = std::make_unique<AdaptiveResampler>(
+                    playbackChannels, captureSampleRate, playbackSampleRate, targetLatencyFrames);
+                if (aggregatePlaybackBuffers.size() != (size_t)playbackChannels)
+                {
+                    FreeBuffers(aggregatePlaybackBuffers);
+                    AllocateBuffers(aggregatePlaybackBuffers, playbackChannels);
+                }
+                aggregateInterleavedBuffer.resize(playbackChannels * bufferSize);
+            }
+            else
+            {
+                this->sampleRate = playbackSampleRate;
+                this->captureResampler = std::make_unique<AdaptiveResampler>(
+                    captureChannels, captureSampleRate, playbackSampleRate, targetLatencyFrames);
+                if (aggregateCaptureBuffers.size() != (size_t)captureChannels)
+                {
+                    FreeBuffers(aggregateCaptureBuffers);
+                    AllocateBuffers(aggregateCaptureBuffers, captureChannels);
+                }
+                aggregateInterleavedBuffer.resize(captureChannels * bufferSize);
+            }
+            Lv2Log::info(SS("ALSA capture and playback devices can't be linked. Aggregating them, with the "
+                            << (captureIsClockMaster ? "capture" : "playback") << " device as the clock master ("
+                            << captureSampleRate << "/" << playbackSampleRate << ")."));
+        }
+
+        void StartStreams()
+        {
+            int err;
+            if ((err = snd_pcm_start(captureHandle)) < 0)
+            {
+                throw PiPedalStateException(SS("Unable to start ALSA capture. " << snd_strerror(err)));
+            }
+            // linked playback streams start with the capture stream.
+            if (aggregateMode && (err = snd_pcm_start(playbackHandle)) < 0)
+            {
+                throw PiPedalStateException(SS("Unable to start ALSA playback. " << snd_strerror(err)));
+            }
+        }
+
+        // Aggregate mode: recover one stream without disturbing the other, which runs on its own clock.
+        void RecoverAggregateStream(snd_pcm_t *handle, bool isCapture, int err)
+        {
+            if (err == -ESTRPIPE)
+            {
+                while ((err = snd_pcm_resume(handle)) == -EAGAIN)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                if (err >= 0)
+                {
+                    return;
+                }
+            }
+            if ((err = snd_pcm_prepare(handle)) < 0)
+            {
+                throw PiPedalStateException(SS("Can't recover ALSA " << (isCapture ? "capture" : "playback") << " stream. (" << snd_strerror(err) << ")"));
+            }
+            if (!isCapture)
+            {
+                FillOutputBuffer();
+            }
+            if ((err = snd_pcm_start(handle)) < 0)
+            {
+                throw PiPedalStateException(SS("Can't restart ALSA " << (isCapture ? "capture" : "playback") << " stream. (" << snd_strerror(err) << ")"));
+            }
+        }
+
+        // Timer scheduling: sleep until the capture stream should have `frames` frames ready. Returns the available
+        // frames, 0 if the stream stalled, or -errno.
+        snd_pcm_sframes_t TimedCaptureWait(snd_pcm_uframes_t frames, AudioPeriodTraceRecord &periodRecord)
+        {
+            uint64_t requestedNs = 0;
+            for (int wakeup = 0;; ++wakeup)
+            {
+                snd_pcm_sframes_t avail = snd_pcm_avail(captureHandle); // (syncs the hardware pointer.)
+                if (avail < 0)
+                {
+                    return avail;
+                }
+                uint64_t nowNs = AudioPeriodTrace::Now();
+                if ((snd_pcm_uframes_t)avail >= frames)
+                {
+                    if (requestedNs != 0)
+                    {
+                        uint64_t lateNs = nowNs > requestedNs ? nowNs - requestedNs : 0;
+                        wakeupJitter.Add(lateNs);
+                        periodRecord.wakeLateNs = (uint32_t)std::min<uint64_t>(lateNs, std::numeric_limits<uint32_t>::max());
+                    }
+                    return avail;
+                }
+                if (requestedNs != 0)
+                {
+                    wakeupJitter.AddEarlyWakeup();
+                }
+                if (wakeup >= TSCHED_MAX_WAKEUPS)
+                {
+                    // the stream isn't advancing as predicted. Wait for the interrupt instead.
+                    int err = snd_pcm_wait(captureHandle, 1000);
+                    if (err <= 0)
+                    {
+                        return err;
+                    }
+                    requestedNs = 0;
+                    continue;
+                }
+                // predict from the time of the last pointer update, if the driver provides one (CLOCK_MONOTONIC).
+                uint64_t positionNs = nowNs;
+                snd_pcm_uframes_t timestampAvail;
+                snd_htimestamp_t timestamp;
+                if (snd_pcm_htimestamp(captureHandle, &timestampAvail, &timestamp) == 0 && timestampAvail <= (snd_pcm_uframes_t)avail)
+                {
+                    uint64_t t = (uint64_t)timestamp.tv_sec * 1000000000ull + (uint64_t)timestamp.tv_nsec;
+                    if (t != 0 && t <= nowNs)
+                    {
+                        positionNs = t;
+                        avail = (snd_pcm_sframes_t)timestampAvail;
+                    }
+                }
+                requestedNs = positionNs + (frames - avail) * 1000000000ull / sampleRate + TSCHED_WAKE_MARGIN_NS;
+                if (requestedNs > nowNs)
+                {
+                    struct timespec ts;
+                    ts.tv_sec = (time_t)(requestedNs / 1000000000ull);
+                    ts.tv_nsec = (long)(requestedNs % 1000000000ull);
+                    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+                    {
+                    }
+                }
+            }
+        }
+
+        // Aggregate mode, with the playback device as clock master: reads the capture device at its own pace.
+        void CaptureSlaveThread()
+        {
+            SetThreadName("alsaCapture");
+            try
+            {
+                SetThreadPriority(SchedulerPriority::RealtimeAudio);
+                while (!stopAggregateThread)
+                {
+                    snd_pcm_sframes_t nFrames;
+                    if (captureMmap)
+                    {
+                        nFrames = MmapReadAndConvert(bufferSize);
+                    }
+                    else
+                    {
+                        nFrames = ReadBuffer(captureHandle, rawCaptureBuffer.data(), bufferSize);
+                        if (nFrames >= 0)
+                        {
+                            captureData = rawCaptureBuffer.data();
+                            (this->*copyInputFn)(bufferSize);
+                            nFrames = bufferSize;
+                        }
+                    }
+                    if (nFrames < 0)
+                    {
+                        ++aggregateXruns;
+                        RecoverAggregateStream(captureHandle, true, (int)nFrames);
+                        continue;
+                    }
+                    if (nFrames == 0)
+                    {
+                        continue; // timed out.
+                    }
+                    InterleaveSamples(captureBuffers.data(), aggregateInterleavedBuffer.data(), captureChannels, bufferSize);
+                    captureResampler->Write(aggregateInterleavedBuffer.data(), bufferSize);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::error(SS("ALSA capture thread: " << e.what()));
+                aggregateThreadFailed = true;
+            }
+        }
+
+        // Aggregate mode, with the capture device as clock master: writes the playback device at its own pace.
+        void PlaybackSlaveThread()
+        {
+            SetThreadName("alsaPlayback");
+            try
+            {
+                SetThreadPriority(SchedulerPriority::RealtimeAudio);
+                while (!stopAggregateThread)
+                {
+                    // (silence until the audio thread has primed the resampler.)
+                    playbackResampler->Read(playbackBuffers.data(), bufferSize);
+                    long err;
+                    if (playbackMmap)
+                    {
+                        err = MmapConvertAndWrite(bufferSize);
+                    }
+                    else
+                    {
+                        playbackData = rawPlaybackBuffer.data();
+                        (this->*copyOutputFn)(bufferSize);
+                        err = WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), bufferSize);
+                    }
+                    if (err < 0)
+                    {
+                        ++aggregateXruns;
+                        RecoverAggregateStream(playbackHandle, false, (int)err);
+                    }
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::error(SS("ALSA playback thread: " << e.what()));
+                aggregateThreadFailed = true;
+            }
+        }
+
+        void StartAggregateThread()
+        {
+            if (!aggregateMode)
+            {
+                return;
+            }
+            stopAggregateThread = false;
+            aggregateThreadFailed = false;
+            aggregateThread = std::make_unique<std::jthread>(
+                [this]()
+                {
+                    if (captureIsClockMaster)
+                    {
+                        PlaybackSlaveThread();
+                    }
+                    else
+                    {
+                        CaptureSlaveThread();
+                    }
+                });
+        }
+        void StopAggregateThread()
+        {
+            if (aggregateThread)
+            {
+                stopAggregateThread = true;
+                aggregateThread = nullptr; // jthread joins.
+            }
+        }
+
         void FillOutputBuffer()
         {
             validate_capture_handle();
@@ -1491,6 +1905,15 @@ namespace pipedal
                 }
                 if (avail == 0)
                     break;
+                if (timerScheduling && !aggregateMode)
+                {
+                    // keep the minimum fill: one period playing, and one for the next period's processing.
+                    snd_pcm_sframes_t queued = (snd_pcm_sframes_t)playbackBufferFrames - avail;
+                    snd_pcm_sframes_t targetFill = 2 * (snd_pcm_sframes_t)bufferSize;
+                    if (queued >= targetFill)
+                        break;
+                    avail = std::min(avail, targetFill - queued);
+                }
 
                 if (avail * playbackFrameSize > this->rawPlaybackBuffer.size())
                     this->rawPlaybackBuffer.resize(avail * playbackFrameSize);
@@ -1503,79 +1926,143 @@ namespace pipedal
             }
             validate_capture_handle();
         }
+        // Xrun recovery: fill the prepared playback stream with silence, to the same depth as FillOutputBuffer does at startup.
+        // No retries or sleeps. Returns -errno on failure.
+        snd_pcm_sframes_t PrefillSilence()
+        {
+            snd_pcm_sframes_t avail = snd_pcm_avail(playbackHandle);
+            if (avail < 0)
+            {
+                return avail;
+            }
+            if (timerScheduling)
+            {
+                avail = std::min(avail, 2 * (snd_pcm_sframes_t)bufferSize);
+            }
+            avail = std::min(avail, (snd_pcm_sframes_t)(silencePlaybackBuffer.size() / playbackFrameSize));
+            long err = WriteBuffer(playbackHandle, silencePlaybackBuffer.data(), avail);
+            if (err < 0)
+            {
+                return err;
+            }
+            return avail;
+        }
+
+        // Restart the capture and playback streams after an xrun. Linked streams share a trigger, so dropping, preparing
+        // and starting the capture stream does the same to the playback stream, and both hardware pointers restart
+        // together, with the same playback prefill as at startup. That restores the original capture-to-playback
+        // alignment without reopening the devices. Returns -errno if a step fails.
+        int RestartLinkedStreams()
+        {
+            bool linked = !capture_and_playback_not_synced;
+            int err;
+            if ((err = snd_pcm_drop(captureHandle)) < 0)
+            {
+                return err;
+            }
+            if (!linked && (err = snd_pcm_drop(playbackHandle)) < 0)
+            {
+                return err;
+            }
+            if ((err = snd_pcm_prepare(captureHandle)) < 0)
+            {
+                return err;
+            }
+            if (!linked && (err = snd_pcm_prepare(playbackHandle)) < 0)
+            {
+                return err;
+            }
+            snd_pcm_sframes_t prefilled = PrefillSilence();
+            if (prefilled < 0)
+            {
+                return (int)prefilled;
+            }
+            if ((err = snd_pcm_start(captureHandle)) < 0)
+            {
+                return err;
+            }
+            if (!linked && (err = snd_pcm_start(playbackHandle)) < 0)
+            {
+                return err;
+            }
+            return 0;
+        }
+
+        void XrunRecovered(uint64_t recoveryStartNs, bool restarted)
+        {
+            periodTrace.XrunRecovered(recoveryStartNs, restarted);
+            Tracer::Complete("audio", "xrun recovery", recoveryStartNs, AudioPeriodTrace::Now(), restarted ? 1 : 0);
+        }
+
         void recover_from_output_underrun(snd_pcm_t *capture_handle, snd_pcm_t *playback_handle, int err, size_t framesRead)
         {
+            uint64_t recoveryStartNs = AudioPeriodTrace::Now();
             validate_capture_handle();
+            periodTrace.Xrun('w', err);
+            Tracer::Instant("audio", "playback xrun", err);
             try
             {
+                if (aggregateMode)
+                {
+                    RecoverAggregateStream(playback_handle, false, err);
+                    XrunRecovered(recoveryStartNs, false);
+                    return;
+                }
 
                 TraceBufferPositions(framesRead, 'w');
                 if (err == -EPIPE)
                 {
-                    err = snd_pcm_prepare(playback_handle);
-                    if (err < 0)
+                    // (an xrun stops both linked streams.)
+                    if ((err = RestartLinkedStreams()) < 0)
                     {
-                        Lv2Log::error(SS("Can't recover from ALSA output underrun. (" << snd_strerror(err) << ")"));
                         throw PiPedalStateException(SS("Can't recover from ALSA output underrun. (" << snd_strerror(err) << ")"));
                     }
-                    snd_pcm_drain(capture_handle);
-                    FillOutputBuffer();
                     TraceBufferPositions(framesRead, 'x');
                 }
                 else
                 {
                     TraceBufferPositions(framesRead, 'z');
-                    Lv2Log::error(SS("Can't recover from ALSA output underrun. (" << snd_strerror(err) << ")"));
                     throw PiPedalStateException(SS("Can't recover from ALSA output error. (" << snd_strerror(err) << ")"));
                 }
             }
             catch (const std::exception &e)
             {
+                Lv2Log::error(e.what());
                 RestartAlsa();
                 audioRunning = true;
+                XrunRecovered(recoveryStartNs, true);
+                return;
             }
+            XrunRecovered(recoveryStartNs, false);
             validate_capture_handle();
         }
         void recover_from_input_underrun(snd_pcm_t *capture_handle, snd_pcm_t *playback_handle, int err, size_t bufferedFrames)
         {
+            uint64_t recoveryStartNs = AudioPeriodTrace::Now();
             validate_capture_handle();
+            periodTrace.Xrun('r', err);
+            Tracer::Instant("audio", "capture xrun", err);
 
             try
             {
+                if (aggregateMode)
+                {
+                    RecoverAggregateStream(capture_handle, true, err);
+                    XrunRecovered(recoveryStartNs, false);
+                    return;
+                }
                 TraceBufferPositions(bufferedFrames, 'r');
                 if (err == -EPIPE)
                 {
-
-                    // Unlink the streams before recovery
-                    snd_pcm_unlink(capture_handle);
-
-                    // Prepare both streams
-                    if ((err = snd_pcm_prepare(playback_handle)) < 0)
+                    if ((err = RestartLinkedStreams()) < 0)
                     {
-                        throw std::runtime_error(SS("Cannot prepare playback stream: " << snd_strerror(err)));
+                        throw PiPedalStateException(SS("Can't recover from ALSA input overrun. (" << snd_strerror(err) << ")"));
                     }
-                    if ((err = snd_pcm_prepare(capture_handle)) < 0)
-                    {
-                        throw std::runtime_error(SS("Cannot prepare capture stream: " << snd_strerror(err)));
-                    }
-
-                    // Resynchronize the streams
-                    if ((err = snd_pcm_link(capture_handle, playback_handle)) < 0)
-                    {
-                        throw std::runtime_error(SS("Cannot relink streams: " << snd_strerror(err)));
-                    }
-
-                    // Start the streams
-                    FillOutputBuffer();
-                    if ((err = snd_pcm_start(capture_handle)) < 0)
-                    {
-                        throw std::runtime_error(SS("Cannot restart capture stream: " << snd_strerror(err)));
-                    }
-
                     validate_capture_handle();
                 }
-                else if (err == ESTRPIPE)
+                else if (err == -ESTRPIPE)
                 {
+                    // (a system suspend, not an xrun. The hardware needs time to come back.)
                     audioRunning = false;
                     validate_capture_handle();
 
@@ -1583,13 +2070,9 @@ namespace pipedal
                     {
                         std::this_thread::sleep_for(std::chrono::milliseconds(1));
                     }
-                    if (err < 0)
+                    if (err < 0 && (err = RestartLinkedStreams()) < 0)
                     {
-                        err = snd_pcm_prepare(capture_handle);
-                        if (err < 0)
-                        {
-                            throw PiPedalStateException(SS("Can't recover from ALSA suspend. (" << snd_strerror(err) << ")"));
-                        }
+                        throw PiPedalStateException(SS("Can't recover from ALSA suspend. (" << snd_strerror(err) << ")"));
                     }
                     audioRunning = true;
                     validate_capture_handle();
@@ -1601,9 +2084,13 @@ namespace pipedal
             }
             catch (const std::exception &e)
             {
+                Lv2Log::error(e.what());
                 RestartAlsa();
                 audioRunning = true;
+                XrunRecovered(recoveryStartNs, true);
+                return;
             }
+            XrunRecovered(recoveryStartNs, false);
         }
 
         void DumpStatus(snd_pcm_t *handle)
@@ -1633,7 +2120,7 @@ namespace pipedal
             {
                 TraceBufferPositions(framesRead,'1');
 
-                framesRead = snd_pcm_readi(handle, buffer, frames);
+                framesRead = this->captureMmap ? snd_pcm_mmap_readi(handle, buffer, frames) : snd_pcm_readi(handle, buffer, frames);
                 if (framesRead < 0)
                 {
                     return framesRead;
@@ -1655,16 +2142,19 @@ namespace pipedal
         }
 
     protected:
-        void ReadMidiData(uint32_t audioFrame)
+        // Appends the MIDI events that have arrived since the last call. midiEventCount is reset at the start of each period.
+        void ReadMidiData()
         {
             AlsaMidiMessage message;
 
-            midiEventCount = 0;
             auto alsaSequener = this->alsaSequencer; // take an addref
             if (!alsaSequener)
             {
                 return;
             }
+            bool hasPeriodEndNs = false;
+            uint64_t periodEndNs = 0;
+            uint64_t nowNs = 0;
             while (alsaSequencer->ReadMessage(message, 0))
             {
                 size_t messageSize = message.size;
@@ -1685,8 +2175,22 @@ namespace pipedal
                 {
                     continue;
                 }
+                if (!hasPeriodEndNs)
+                {
+                    uint64_t sec;
+                    uint32_t nsec;
+                    hasPeriodEndNs = true;
+                    periodEndNs = alsaSequencer->GetQueueRealtime(&sec, &nsec) ? sec * 1000000000ull + nsec : 0;
+                    nowNs = EffectTimingClockNs();
+                }
+                uint32_t frame = periodEndNs != 0 ? MidiEventFrame(message.RealtimeNs(), periodEndNs, sampleRate, bufferSize) : 0;
+                if (midiEventCount != 0 && frame < midiEvents[midiEventCount - 1].time)
+                {
+                    frame = midiEvents[midiEventCount - 1].time; // keep the sequence in order.
+                }
                 MidiEvent *pEvent = midiEvents.data() + midiEventCount++;
-                pEvent->time = audioFrame;
+                pEvent->time = frame;
+                pEvent->receivedNs = MidiEventReceivedNs(message.RealtimeNs(), periodEndNs, nowNs);
                 pEvent->size = messageSize;
                 pEvent->buffer = midiEventMemory.data() + midiEventMemoryIndex;
 
@@ -1706,7 +2210,7 @@ namespace pipedal
 
             while (frames > 0)
             {
-                framesRead = snd_pcm_writei(handle, buf, frames);
+                framesRead = this->playbackMmap ? snd_pcm_mmap_writei(handle, buf, frames) : snd_pcm_writei(handle, buf, frames);
                 if (framesRead == -EAGAIN)
                     continue;
                 if (framesRead < 0)
@@ -1716,6 +2220,120 @@ namespace pipedal
             }
             return 0;
         }
+        // mmap mode: wait for a full period, and convert it directly out of the DMA buffer.
+        // Periods that wrap around the end of the DMA buffer go through rawCaptureBuffer instead.
+        snd_pcm_sframes_t MmapReadAndConvert(snd_pcm_uframes_t frames)
+        {
+            while (true)
+            {
+                snd_pcm_sframes_t avail = snd_pcm_avail_update(captureHandle);
+                if (avail < 0)
+                {
+                    return avail;
+                }
+                if ((snd_pcm_uframes_t)avail >= frames)
+                {
+                    break;
+                }
+                int err = snd_pcm_wait(captureHandle, 1000);
+                if (err < 0)
+                {
+                    return err;
+                }
+                if (err == 0)
+                {
+                    return 0; // timed out.
+                }
+            }
+            const snd_pcm_channel_area_t *areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t contiguousFrames = frames;
+            int err = snd_pcm_mmap_begin(captureHandle, &areas, &offset, &contiguousFrames);
+            if (err < 0)
+            {
+                return err;
+            }
+            if (contiguousFrames < frames)
+            {
+                snd_pcm_mmap_commit(captureHandle, offset, 0);
+                snd_pcm_sframes_t nFrames = ReadBuffer(captureHandle, rawCaptureBuffer.data(), frames);
+                if (nFrames < 0)
+                {
+                    return nFrames;
+                }
+                captureData = rawCaptureBuffer.data();
+                (this->*copyInputFn)(frames);
+                return frames;
+            }
+            captureData = (uint8_t *)areas[0].addr + areas[0].first / 8 + offset * captureFrameSize;
+            (this->*copyInputFn)(frames);
+
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(captureHandle, offset, frames);
+            if (committed < 0)
+            {
+                return committed;
+            }
+            if ((snd_pcm_uframes_t)committed != frames)
+            {
+                return -EPIPE;
+            }
+            return frames;
+        }
+
+        // mmap mode: convert output directly into the DMA buffer.
+        long MmapConvertAndWrite(snd_pcm_uframes_t frames)
+        {
+            while (true)
+            {
+                snd_pcm_sframes_t avail = snd_pcm_avail_update(playbackHandle);
+                if (avail < 0)
+                {
+                    return avail;
+                }
+                if ((snd_pcm_uframes_t)avail >= frames)
+                {
+                    break;
+                }
+                int err = snd_pcm_wait(playbackHandle, 1000);
+                if (err < 0)
+                {
+                    return err;
+                }
+                if (err == 0)
+                {
+                    return -EIO;
+                }
+            }
+            const snd_pcm_channel_area_t *areas;
+            snd_pcm_uframes_t offset;
+            snd_pcm_uframes_t contiguousFrames = frames;
+            int err = snd_pcm_mmap_begin(playbackHandle, &areas, &offset, &contiguousFrames);
+            if (err < 0)
+            {
+                return err;
+            }
+            if (contiguousFrames < frames)
+            {
+                snd_pcm_mmap_commit(playbackHandle, offset, 0);
+                playbackData = rawPlaybackBuffer.data();
+                (this->*copyOutputFn)(frames);
+                return WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), frames);
+            }
+            playbackData = (uint8_t *)areas[0].addr + areas[0].first / 8 + offset * playbackFrameSize;
+            (this->*copyOutputFn)(frames);
+
+            snd_pcm_sframes_t committed = snd_pcm_mmap_commit(playbackHandle, offset, frames);
+            if (committed < 0)
+            {
+                return committed;
+            }
+            if ((snd_pcm_uframes_t)committed != frames)
+            {
+                return -EPIPE;
+            }
+            return 0;
+        }
+
         void AudioThread()
         {
             SetThreadName("alsaDriver");
@@ -1729,12 +2347,8 @@ namespace pipedal
                 auto playbackState = snd_pcm_state(playbackHandle);
 
                 FillOutputBuffer();
-
-                int err;
-                if ((err = snd_pcm_start(captureHandle)) < 0)
-                {
-                    throw PiPedalStateException(SS("Unable to start ALSA capture. " << snd_strerror(err)));
-                }
+                StartStreams();
+                StartAggregateThread();
 
                 CrashGuardLock crashGuardLock;
 
@@ -1748,7 +2362,25 @@ namespace pipedal
                     {
                         break;
                     }
+                    if (aggregateMode)
+                    {
+                        if (aggregateThreadFailed)
+                        {
+                            this->driverHost->OnUnderrun();
+                            RestartAlsa();
+                        }
+                        uint64_t xruns = aggregateXruns.load(std::memory_order_relaxed);
+                        if (xruns != reportedAggregateXruns)
+                        {
+                            reportedAggregateXruns = xruns;
+                            this->driverHost->OnUnderrun();
+                        }
+                    }
                     this->midiEventCount = 0;
+                    this->midiEventMemoryIndex = 0;
+
+                    AudioPeriodTraceRecord periodRecord;
+                    periodRecord.startNs = AudioPeriodTrace::Now();
 
                     // snd_pcm_wait(captureHandle, 1);
                     ssize_t framesToRead = bufferSize;
@@ -1756,9 +2388,50 @@ namespace pipedal
                     bool xrun = false;
                     validate_capture_handle();
 
-                    while (framesToRead != 0)
+                    if (timerScheduling && !captureResampler)
                     {
-                        ReadMidiData((uint32_t)framesRead);
+                        snd_pcm_sframes_t avail = TimedCaptureWait(framesToRead, periodRecord);
+                        if (avail < 0)
+                        {
+                            this->driverHost->OnUnderrun();
+                            recover_from_input_underrun(captureHandle, playbackHandle, avail, 0);
+                            continue;
+                        }
+                        if (avail == 0)
+                        {
+                            continue; // stalled.
+                        }
+                        // (the reads below don't block now.)
+                    }
+
+                    if (captureResampler)
+                    {
+                        // the capture device is a slave: the period is paced by the playback writes.
+                        ReadMidiData();
+                        captureResampler->Read(aggregateCaptureBuffers.data(), framesToRead);
+                        framesRead = framesToRead;
+                        framesToRead = 0;
+                    }
+                    else if (captureMmap)
+                    {
+                        ReadMidiData();
+                        ssize_t nFrames = MmapReadAndConvert(framesToRead);
+                        if (nFrames < 0)
+                        {
+                            this->driverHost->OnUnderrun();
+                            recover_from_input_underrun(captureHandle, playbackHandle, nFrames, 0);
+                            xrun = true;
+                        }
+                        else
+                        {
+                            framesRead = nFrames;
+                            framesToRead = 0;
+                        }
+                    }
+
+                    while (framesToRead != 0 && !xrun)
+                    {
+                        ReadMidiData();
 
                         ssize_t thisTime = framesToRead;
                         ssize_t nFrames;
@@ -1784,23 +2457,52 @@ namespace pipedal
                     cpuUse.AddSample(ProfileCategory::Read);
                     if (framesRead == 0)
                         continue;
+                    uint64_t readEndNs = AudioPeriodTrace::Now();
+                    periodRecord.readNs = (uint32_t)(readEndNs - periodRecord.startNs);
+                    periodRecord.captureAvail = captureResampler ? (int32_t)captureResampler->GetStatistics().fillFrames
+                                                                 : (int32_t)snd_pcm_avail_update(captureHandle);
                     if (framesRead != bufferSize)
                     {
                         throw PiPedalStateException("Invalid read.");
                     }
 
-                    (this->*copyInputFn)(framesRead);
+                    if (!captureMmap && !captureResampler)
+                    {
+                        captureData = rawCaptureBuffer.data();
+                        (this->*copyInputFn)(framesRead);
+                    }
                     cpuUse.AddSample(ProfileCategory::Driver);
 
                     this->driverHost->OnProcess(framesRead);
 
                     cpuUse.AddSample(ProfileCategory::Execute);
+                    uint64_t processEndNs = AudioPeriodTrace::Now();
+                    periodRecord.processNs = (uint32_t)(processEndNs - readEndNs);
+                    periodRecord.playbackAvail = playbackResampler ? (int32_t)playbackResampler->GetStatistics().fillFrames
+                                                                   : (int32_t)snd_pcm_avail_update(playbackHandle);
 
-                    (this->*copyOutputFn)(framesRead);
-                    cpuUse.AddSample(ProfileCategory::Driver);
-                    // process.
+                    ssize_t err;
+                    if (playbackResampler)
+                    {
+                        // the playback device is a slave, written by the playback thread.
+                        InterleaveSamples(aggregatePlaybackBuffers.data(), aggregateInterleavedBuffer.data(), playbackChannels, framesRead);
+                        playbackResampler->Write(aggregateInterleavedBuffer.data(), framesRead);
+                        err = 0;
+                    }
+                    else if (playbackMmap)
+                    {
+                        // conversion and write are one step in mmap mode.
+                        err = MmapConvertAndWrite(framesRead);
+                    }
+                    else
+                    {
+                        playbackData = rawPlaybackBuffer.data();
+                        (this->*copyOutputFn)(framesRead);
+                        cpuUse.AddSample(ProfileCategory::Driver);
+                        // process.
 
-                    ssize_t err = WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), framesRead);
+                        err = WriteBuffer(playbackHandle, rawPlaybackBuffer.data(), framesRead);
+                    }
 
                     if (err < 0)
                     {
@@ -1810,6 +2512,16 @@ namespace pipedal
                         framesRead = 0;
                     }
                     cpuUse.AddSample(ProfileCategory::Write);
+                    uint64_t writeEndNs = AudioPeriodTrace::Now();
+                    periodRecord.writeNs = (uint32_t)(writeEndNs - processEndNs);
+                    periodTrace.Write(periodRecord);
+                    if (Tracer::IsEnabled())
+                    {
+                        Tracer::Complete("audio", "period", periodRecord.startNs, writeEndNs);
+                        Tracer::Complete("audio", "read", periodRecord.startNs, readEndNs);
+                        Tracer::Complete("audio", "process", readEndNs, processEndNs);
+                        Tracer::Complete("audio", "write", processEndNs, writeEndNs);
+                    }
                 }
             }
             catch (const std::exception &e)
@@ -1817,15 +2529,33 @@ namespace pipedal
                 Lv2Log::error(e.what());
                 Lv2Log::error("ALSA audio thread terminated abnormally.");
             }
+            StopAggregateThread();
+            if (timerScheduling && wakeupJitter.Count() != 0)
+            {
+                Lv2Log::info(SS("ALSA timer scheduling: " << wakeupJitter.Count() << " wakeups, late by "
+                                                         << wakeupJitter.MeanUs() << "us (mean), "
+                                                         << wakeupJitter.PercentileUs(0.99) << "us (99%), "
+                                                         << wakeupJitter.PercentileUs(0.999) << "us (99.9%), "
+                                                         << wakeupJitter.MaxUs() << "us (max); "
+                                                         << wakeupJitter.EarlyWakeups() << " early wakeups."));
+            }
+            if (aggregateMode)
+            {
+                AdaptiveResampler::Statistics stats = captureResampler ? captureResampler->GetStatistics() : playbackResampler->GetStatistics();
+                Lv2Log::debug(SS("ALSA aggregate " << (captureResampler ? "capture" : "playback") << ": ratio " << stats.ratio
+                                                   << ", latency " << stats.fillFrames << "/" << stats.targetFrames << " frames, "
+                                                   << stats.underruns << " underruns, " << stats.overruns << " overruns, "
+                                                   << stats.resyncs << " resyncs."));
+            }
 
             // if we terminated abnormally, pump messages until we have been terminated.
             if (!terminateAudio())
             {
                 this->driverHost->OnAlsaDriverStopped();
                 // zero out input buffers.
-                for (size_t i = 0; i < this->captureBuffers.size(); ++i)
+                for (size_t i = 0; i < this->activeCaptureBuffers.size(); ++i)
                 {
-                    float *pBuffer = captureBuffers[i];
+                    float *pBuffer = activeCaptureBuffers[i];
                     for (size_t j = 0; j < this->bufferSize; ++j)
                     {
                         pBuffer[j] = 0;
@@ -1886,7 +2616,7 @@ namespace pipedal
                 }
                 else
                 {
-                    this->activeCaptureBuffers[ix++] = this->captureBuffers[sourceIndex];
+                    this->activeCaptureBuffers[ix++] = captureResampler ? this->aggregateCaptureBuffers[sourceIndex] : this->captureBuffers[sourceIndex];
                 }
             }
 
@@ -1902,10 +2632,15 @@ namespace pipedal
                 }
                 else
                 {
-                    this->activePlaybackBuffers[ix++] = this->playbackBuffers[sourceIndex];
+                    this->activePlaybackBuffers[ix++] = playbackResampler ? this->aggregatePlaybackBuffers[sourceIndex] : this->playbackBuffers[sourceIndex];
                 }
             }
 
+            periodTrace.Start(this->sampleRate, this->bufferSize);
+            wakeupJitter.Reset();
+            cpuUse.SetPeriod(this->bufferSize, this->sampleRate);
+            cpuUse.ResetStatistics();
+
             audioThread = std::make_unique<std::jthread>([this]()
                                                          { AudioThread(); });
         }
@@ -1922,6 +2657,7 @@ namespace pipedal
             {
                 this->audioThread = 0; // jthread joins.
             }
+            periodTrace.Stop();
             Lv2Log::debug("Audio thread joined.");
         }
 
@@ -1976,6 +2712,8 @@ namespace pipedal
             activePlaybackBuffers.clear();
             FreeBuffers(this->playbackBuffers);
             FreeBuffers(this->captureBuffers);
+            FreeBuffers(this->aggregatePlaybackBuffers);
+            FreeBuffers(this->aggregateCaptureBuffers);
         }
         virtual void Close()
         {
@@ -2014,8 +2752,9 @@ namespace pipedal
                          std::vector<std::string> &inputAudioPorts,
                          std::vector<std::string> &outputAudioPorts)
     {
-        if (jackServerSettings.IsDummyAudioDevice())
+        if (jackServerSettings.IsDummyAudioDevice() || jackServerSettings.IsPipeWireAudioDevice())
         {
+            // (dummy:channels_<n> and pipewire:channels_<n>)
             auto nChannels = GetDummyAudioChannels(jackServerSettings.GetAlsaInputDevice());
 
             inputAudioPorts.clear();
@@ -2222,6 +2961,7 @@ namespace pipedal
         this->sampleRate = 44100;
         this->captureChannels = 2;
         this->playbackChannels = 2;
+        this->sampleConverterSimdLevel = SimdLevel::Scalar;
 
         PrepareCaptureFunctions(captureFormat);
         PreparePlaybackFunctions(captureFormat);
@@ -2244,6 +2984,8 @@ namespace pipedal
             }
         }
 
+        captureData = rawCaptureBuffer.data();
+        playbackData = rawPlaybackBuffer.data();
         (this->*copyOutputFn)(bufferSize);
 
         assert(captureFrameSize == playbackFrameSize);
@@ -2261,6 +3003,50 @@ namespace pipedal
                 assert(std::abs(error) < 4e-5);
             }
         }
+
+        // vectorized converters must be bit-exact with the scalar converters,
+        // including clipping, negative values, and odd-sized tails.
+        size_t frames = bufferSize - 3;
+        for (size_t i = 0; i < bufferSize; ++i)
+        {
+            for (size_t c = 0; c < captureChannels; ++c)
+            {
+                this->playbackBuffers[c][i] = 2.5f * (i - bufferSize / 2.0f) / bufferSize + 0.0001f * c;
+            }
+        }
+        for (size_t i = 0; i < this->rawCaptureBuffer.size(); ++i)
+        {
+            this->rawCaptureBuffer[i] = (uint8_t)(i * 37 + 11);
+        }
+        std::vector<uint8_t> rawCaptureInput = this->rawCaptureBuffer;
+
+        (this->*scalarCopyOutputFn)(frames);
+        std::vector<uint8_t> expectedPlayback = this->rawPlaybackBuffer;
+        (this->*scalarCopyInputFn)(frames);
+        std::vector<std::vector<float>> expectedCapture;
+        for (size_t c = 0; c < captureChannels; ++c)
+        {
+            expectedCapture.push_back(std::vector<float>(this->captureBuffers[c], this->captureBuffers[c] + frames));
+        }
+
+        for (SimdLevel simdLevel : GetSupportedSimdLevels())
+        {
+            this->sampleConverterSimdLevel = simdLevel;
+            SelectCaptureConverter();
+            SelectPlaybackConverter(captureFormat);
+
+            memset(this->rawPlaybackBuffer.data(), 0, this->rawPlaybackBuffer.size());
+            (this->*copyOutputFn)(frames);
+            AlsaAssert(memcmp(this->rawPlaybackBuffer.data(), expectedPlayback.data(), frames * playbackFrameSize) == 0);
+
+            this->rawCaptureBuffer = rawCaptureInput;
+            captureData = rawCaptureBuffer.data();
+            (this->*copyInputFn)(frames);
+            for (size_t c = 0; c < captureChannels; ++c)
+            {
+                AlsaAssert(memcmp(this->captureBuffers[c], expectedCapture[c].data(), frames * sizeof(float)) == 0);
+            }
+        }
     }
 
     void AlsaFormatEncodeDecodeTest(AudioDriverHost *testDriverHost)
@@ -2270,6 +3056,8 @@ namespace pipedal
             snd_pcm_format_t::SND_PCM_FORMAT_S16_BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S32_LE,
             snd_pcm_format_t::SND_PCM_FORMAT_S32_BE,
+            snd_pcm_format_t::SND_PCM_FORMAT_S24_LE,
+            snd_pcm_format_t::SND_PCM_FORMAT_S24_BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S24_3BE,
             snd_pcm_format_t::SND_PCM_FORMAT_S24_3LE,
             snd_pcm_format_t::SND_PCM_FORMAT_FLOAT_BE,
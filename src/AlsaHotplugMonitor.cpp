@@ -0,0 +1,156 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "AlsaHotplugMonitor.hpp"
+#include "Lv2Log.hpp"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <linux/netlink.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+
+using namespace pipedal;
+
+// a USB card produces a burst of events, and udev needs time to create device nodes.
+static constexpr std::chrono::milliseconds SETTLE_DELAY{1000};
+
+static constexpr uint32_t KERNEL_UEVENT_GROUP = 1;
+
+AlsaHotplugMonitor::AlsaHotplugMonitor(std::function<void()> &&onChanged)
+    : onChanged(std::move(onChanged))
+{
+    socket_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (socket_fd == -1)
+    {
+        Lv2Log::error("Failed to open the kernel uevent socket. ALSA hotplug events will not be detected.");
+        return;
+    }
+    struct sockaddr_nl address;
+    memset(&address, 0, sizeof(address));
+    address.nl_family = AF_NETLINK;
+    address.nl_pid = 0;
+    address.nl_groups = KERNEL_UEVENT_GROUP;
+    if (bind(socket_fd, (struct sockaddr *)&address, sizeof(address)) == -1)
+    {
+        Lv2Log::error("Failed to bind the kernel uevent socket. ALSA hotplug events will not be detected.");
+        close(socket_fd);
+        socket_fd = -1;
+        return;
+    }
+    socketHandle = EventReactor::GetInstance().AddFd(
+        socket_fd, EPOLLIN,
+        [this](uint32_t) { OnSocketReady(); });
+}
+
+void AlsaHotplugMonitor::Shutdown()
+{
+    if (socket_fd != -1)
+    {
+        auto &reactor = EventReactor::GetInstance();
+        // Remove() waits for in-flight callbacks, after which settleTimerHandle is stable.
+        reactor.Remove(socketHandle);
+        socketHandle = EventReactor::INVALID_HANDLE;
+        if (settleTimerHandle != EventReactor::INVALID_HANDLE)
+        {
+            reactor.Remove(settleTimerHandle);
+            settleTimerHandle = EventReactor::INVALID_HANDLE;
+        }
+        close(socket_fd);
+        socket_fd = -1;
+    }
+}
+
+AlsaHotplugMonitor::~AlsaHotplugMonitor()
+{
+    Shutdown();
+}
+
+bool AlsaHotplugMonitor::IsSoundDeviceEvent(const char *message, size_t length)
+{
+    // "ACTION@DEVPATH\0KEY=VALUE\0KEY=VALUE\0..."
+    bool soundSubsystem = false;
+    bool deviceAction = false;
+    size_t i = 0;
+    while (i < length)
+    {
+        std::string_view field{message + i, strnlen(message + i, length - i)};
+        i += field.length() + 1;
+
+        if (field == "SUBSYSTEM=sound")
+        {
+            soundSubsystem = true;
+        }
+        else if (field == "ACTION=add" || field == "ACTION=remove" || field == "ACTION=change")
+        {
+            deviceAction = true;
+        }
+    }
+    return soundSubsystem && deviceAction;
+}
+
+void AlsaHotplugMonitor::OnSocketReady()
+{
+    char buffer[8192];
+    bool changed = false;
+    while (true)
+    {
+        ssize_t num_bytes = recv(socket_fd, buffer, sizeof(buffer), 0);
+        if (num_bytes == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS)
+            {
+                Lv2Log::error("Error reading from the kernel uevent socket.");
+            }
+            if (errno == ENOBUFS)
+            {
+                changed = true; // events were lost; assume one of them mattered.
+                continue;
+            }
+            break;
+        }
+        if (IsSoundDeviceEvent(buffer, (size_t)num_bytes))
+        {
+            changed = true;
+        }
+    }
+    if (changed)
+    {
+        // restart the settle timer.
+        auto &reactor = EventReactor::GetInstance();
+        if (settleTimerHandle != EventReactor::INVALID_HANDLE)
+        {
+            reactor.Remove(settleTimerHandle);
+        }
+        settleTimerHandle = reactor.AddTimer(SETTLE_DELAY, [this]() { OnSettleTimer(); });
+    }
+}
+
+void AlsaHotplugMonitor::OnSettleTimer()
+{
+    settleTimerHandle = EventReactor::INVALID_HANDLE;
+    Lv2Log::info("ALSA devices changed.");
+    onChanged();
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <EventReactor.hpp>
+#include <cstddef>
+#include <functional>
+
+namespace pipedal
+{
+    // Listens for kernel uevents from the sound subsystem (the same events udev acts on), and calls
+    // onChanged once a burst of add/remove events has settled. Runs on the shared EventReactor thread.
+    class AlsaHotplugMonitor {
+    public:
+        AlsaHotplugMonitor(std::function<void()> &&onChanged);
+        ~AlsaHotplugMonitor();
+        void Shutdown();
+
+        // true if a kernel uevent message adds, removes or changes a sound device.
+        static bool IsSoundDeviceEvent(const char *message, size_t length);
+    private:
+        void OnSocketReady();
+        void OnSettleTimer();
+
+        std::function<void()> onChanged;
+        int socket_fd = -1;
+        EventReactor::Handle socketHandle = EventReactor::INVALID_HANDLE;
+
+        // reactor thread only.
+        EventReactor::Handle settleTimerHandle = EventReactor::INVALID_HANDLE;
+    };
+}
@@ -0,0 +1,893 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "AlsaSampleConverters.hpp"
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIPEDAL_CONVERTERS_X86 1
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(__aarch64__)
+#define PIPEDAL_CONVERTERS_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace pipedal;
+
+namespace
+{
+    // Scale factors must match the scalar converters in AlsaDriver.cpp exactly.
+    constexpr float S16_CAPTURE_SCALE = 1.0f / (std::numeric_limits<int16_t>::max() + 1L);
+    constexpr float S32_CAPTURE_SCALE = 1.0f / (std::numeric_limits<int32_t>::max() + 1LL);
+    constexpr float S24_CAPTURE_SCALE = 1.0f / (0x00FFFFFFL + 1L);
+    constexpr float S16_PLAYBACK_SCALE = std::numeric_limits<int16_t>::max();
+    constexpr double S32_PLAYBACK_SCALE = std::numeric_limits<int32_t>::max();
+    constexpr double S24_PLAYBACK_SCALE = 0x00FFFFFF;
+
+    // Scalar versions, used for the tail of each buffer.
+    namespace scalar
+    {
+        inline float Clamp(float v)
+        {
+            if (v > 1.0f)
+                v = 1.0f;
+            else if (v < -1.0f)
+                v = -1.0f;
+            return v;
+        }
+
+        template <bool SWAP>
+        void CaptureS16(const uint8_t *input, float *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint16_t v;
+                memcpy(&v, input + i * 2, sizeof(v));
+                if (SWAP)
+                    v = __builtin_bswap16(v);
+                output[i] = S16_CAPTURE_SCALE * (int16_t)v;
+            }
+        }
+        template <bool SWAP, bool S24>
+        void CaptureS32(const uint8_t *input, float *output, size_t samples)
+        {
+            constexpr float scale = S24 ? S24_CAPTURE_SCALE : S32_CAPTURE_SCALE;
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint32_t v;
+                memcpy(&v, input + i * 4, sizeof(v));
+                if (SWAP)
+                    v = __builtin_bswap32(v);
+                output[i] = scale * (int32_t)v;
+            }
+        }
+        template <bool BE>
+        void CaptureS24_3(const uint8_t *input, float *output, size_t samples)
+        {
+            const uint8_t *p = input;
+            for (size_t i = 0; i < samples; ++i)
+            {
+                int32_t v = BE ? (p[2] << 8) | (p[1] << 16) | (p[0] << 24)
+                               : (p[0] << 8) | (p[1] << 16) | (p[2] << 24);
+                p += 3;
+                output[i] = S32_CAPTURE_SCALE * v;
+            }
+        }
+        template <bool SWAP>
+        void CaptureFloat(const uint8_t *input, float *output, size_t samples)
+        {
+            if (!SWAP)
+            {
+                memcpy(output, input, samples * sizeof(float));
+                return;
+            }
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint32_t v;
+                memcpy(&v, input + i * 4, sizeof(v));
+                v = __builtin_bswap32(v);
+                memcpy(output + i, &v, sizeof(v));
+            }
+        }
+
+        template <bool SWAP>
+        void PlaybackS16(const float *input, uint8_t *output, size_t samples)
+        {
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint16_t v = (uint16_t)(int16_t)(S16_PLAYBACK_SCALE * Clamp(input[i]));
+                if (SWAP)
+                    v = __builtin_bswap16(v);
+                memcpy(output + i * 2, &v, sizeof(v));
+            }
+        }
+        template <bool SWAP, bool S24>
+        void PlaybackS32(const float *input, uint8_t *output, size_t samples)
+        {
+            constexpr double scale = S24 ? S24_PLAYBACK_SCALE : S32_PLAYBACK_SCALE;
+            for (size_t i = 0; i < samples; ++i)
+            {
+                uint32_t v = (uint32_t)(int32_t)(scale * Clamp(input[i]));
+                if (SWAP)
+                    v = __builtin_bswap32(v);
+                memcpy(output + i * 4, &v, sizeof(v));
+            }
+        }
+        template <bool BE>
+        void PlaybackS24_3(const float *input, uint8_t *output, size_t samples)
+        {
+            uint8_t *p = output;
+            for (size_t i = 0; i < samples; ++i)
+            {
+                int32_t iValue = (int32_t)(S32_PLAYBACK_SCALE * Clamp(input[i]));
+                p[BE ? 2 : 0] = (uint8_t)(iValue >> 8);
+                p[1] = (uint8_t)(iValue >> 16);
+                p[BE ? 0 : 2] = (uint8_t)(iValue >> 24);
+                p += 3;
+            }
+        }
+        template <bool SWAP>
+        void PlaybackFloat(const float *input, uint8_t *output, size_t samples)
+        {
+            CaptureFloat<SWAP>((const uint8_t *)input, (float *)output, samples);
+        }
+    }
+
+#ifdef PIPEDAL_CONVERTERS_X86
+    namespace sse2
+    {
+        inline __m128i Swap16(__m128i x)
+        {
+            return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        }
+        inline __m128i Swap32(__m128i x)
+        {
+            x = Swap16(x);
+            x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+            return _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+        inline __m128 Clamp(__m128 v)
+        {
+            return _mm_min_ps(_mm_max_ps(v, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        }
+        // 4 floats -> 4 int32, with double precision scaling (as the scalar version does).
+        inline __m128i ScaleToInt32(__m128 v, __m128d scale)
+        {
+            v = Clamp(v);
+            __m128i lo = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(v), scale));
+            __m128i hi = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), scale));
+            return _mm_unpacklo_epi64(lo, hi);
+        }
+
+        template <bool SWAP>
+        void CaptureS16(const uint8_t *input, float *output, size_t samples)
+        {
+            const __m128 scale = _mm_set1_ps(S16_CAPTURE_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)(input + i * 2));
+                if (SWAP)
+                    x = Swap16(x);
+                __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+                __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+                _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+            }
+            scalar::CaptureS16<SWAP>(input + i * 2, output + i, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        void CaptureS32(const uint8_t *input, float *output, size_t samples)
+        {
+            const __m128 scale = _mm_set1_ps(S24 ? S24_CAPTURE_SCALE : S32_CAPTURE_SCALE);
+            size_t i = 0;
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)(input + i * 4));
+                if (SWAP)
+                    x = Swap32(x);
+                _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+            }
+            scalar::CaptureS32<SWAP, S24>(input + i * 4, output + i, samples - i);
+        }
+        template <bool SWAP>
+        void CaptureFloat(const uint8_t *input, float *output, size_t samples)
+        {
+            size_t i = 0;
+            if (SWAP)
+            {
+                for (; i + 4 <= samples; i += 4)
+                {
+                    __m128i x = Swap32(_mm_loadu_si128((const __m128i *)(input + i * 4)));
+                    _mm_storeu_si128((__m128i *)(output + i), x);
+                }
+            }
+            scalar::CaptureFloat<SWAP>(input + i * 4, output + i, samples - i);
+        }
+
+        template <bool SWAP>
+        void PlaybackS16(const float *input, uint8_t *output, size_t samples)
+        {
+            const __m128 scale = _mm_set1_ps(S16_PLAYBACK_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(Clamp(_mm_loadu_ps(input + i)), scale));
+                __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(Clamp(_mm_loadu_ps(input + i + 4)), scale));
+                __m128i x = _mm_packs_epi32(lo, hi);
+                if (SWAP)
+                    x = Swap16(x);
+                _mm_storeu_si128((__m128i *)(output + i * 2), x);
+            }
+            scalar::PlaybackS16<SWAP>(input + i, output + i * 2, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        void PlaybackS32(const float *input, uint8_t *output, size_t samples)
+        {
+            const __m128d scale = _mm_set1_pd(S24 ? S24_PLAYBACK_SCALE : S32_PLAYBACK_SCALE);
+            size_t i = 0;
+            for (; i + 4 <= samples; i += 4)
+            {
+                __m128i x = ScaleToInt32(_mm_loadu_ps(input + i), scale);
+                if (SWAP)
+                    x = Swap32(x);
+                _mm_storeu_si128((__m128i *)(output + i * 4), x);
+            }
+            scalar::PlaybackS32<SWAP, S24>(input + i, output + i * 4, samples - i);
+        }
+        template <bool BE>
+        void PlaybackS24_3(const float *input, uint8_t *output, size_t samples)
+        {
+            // no byte shuffles in SSE2: vectorize the conversion, and pack bytes one at a time.
+            const __m128d scale = _mm_set1_pd(S32_PLAYBACK_SCALE);
+            alignas(16) int32_t values[4];
+            uint8_t *p = output;
+            size_t i = 0;
+            for (; i + 4 <= samples; i += 4)
+            {
+                _mm_store_si128((__m128i *)values, ScaleToInt32(_mm_loadu_ps(input + i), scale));
+                for (int j = 0; j < 4; ++j)
+                {
+                    int32_t iValue = values[j];
+                    p[BE ? 2 : 0] = (uint8_t)(iValue >> 8);
+                    p[1] = (uint8_t)(iValue >> 16);
+                    p[BE ? 0 : 2] = (uint8_t)(iValue >> 24);
+                    p += 3;
+                }
+            }
+            scalar::PlaybackS24_3<BE>(input + i, p, samples - i);
+        }
+        template <bool SWAP>
+        void PlaybackFloat(const float *input, uint8_t *output, size_t samples)
+        {
+            CaptureFloat<SWAP>((const uint8_t *)input, (float *)output, samples);
+        }
+    }
+
+    namespace avx2
+    {
+        AVX2_TARGET inline __m256i Swap16(__m256i x)
+        {
+            const __m256i mask = _mm256_setr_epi8(
+                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            return _mm256_shuffle_epi8(x, mask);
+        }
+        AVX2_TARGET inline __m128i Swap16(__m128i x)
+        {
+            const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+            return _mm_shuffle_epi8(x, mask);
+        }
+        AVX2_TARGET inline __m256i Swap32(__m256i x)
+        {
+            const __m256i mask = _mm256_setr_epi8(
+                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            return _mm256_shuffle_epi8(x, mask);
+        }
+        AVX2_TARGET inline __m256 Clamp(__m256 v)
+        {
+            return _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+        }
+        AVX2_TARGET inline __m256i ScaleToInt32(__m256 v, __m256d scale)
+        {
+            v = Clamp(v);
+            __m128i lo = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), scale));
+            __m128i hi = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), scale));
+            return _mm256_set_m128i(hi, lo);
+        }
+
+        template <bool SWAP>
+        AVX2_TARGET void CaptureS16(const uint8_t *input, float *output, size_t samples)
+        {
+            const __m256 scale = _mm256_set1_ps(S16_CAPTURE_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i *)(input + i * 2));
+                if (SWAP)
+                    x = Swap16(x);
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(x)), scale));
+            }
+            scalar::CaptureS16<SWAP>(input + i * 2, output + i, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        AVX2_TARGET void CaptureS32(const uint8_t *input, float *output, size_t samples)
+        {
+            const __m256 scale = _mm256_set1_ps(S24 ? S24_CAPTURE_SCALE : S32_CAPTURE_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = _mm256_loadu_si256((const __m256i *)(input + i * 4));
+                if (SWAP)
+                    x = Swap32(x);
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+            }
+            scalar::CaptureS32<SWAP, S24>(input + i * 4, output + i, samples - i);
+        }
+        template <bool BE>
+        AVX2_TARGET void CaptureS24_3(const uint8_t *input, float *output, size_t samples)
+        {
+            // Each 128-bit lane expands 4 packed samples to the high 24 bits of 4 int32s.
+            const __m256i mask = BE
+                                     ? _mm256_setr_epi8(
+                                           -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+                                           -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9)
+                                     : _mm256_setr_epi8(
+                                           -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                           -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+            const __m256 scale = _mm256_set1_ps(S32_CAPTURE_SCALE);
+            size_t i = 0;
+            // 16-byte loads read 4 bytes past the 24 bytes consumed by each iteration.
+            for (; i + 10 <= samples; i += 8)
+            {
+                const uint8_t *p = input + i * 3;
+                __m256i x = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p)),
+                    _mm_loadu_si128((const __m128i *)(p + 12)), 1);
+                x = _mm256_shuffle_epi8(x, mask);
+                _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+            }
+            scalar::CaptureS24_3<BE>(input + i * 3, output + i, samples - i);
+        }
+        template <bool SWAP>
+        AVX2_TARGET void CaptureFloat(const uint8_t *input, float *output, size_t samples)
+        {
+            size_t i = 0;
+            if (SWAP)
+            {
+                for (; i + 8 <= samples; i += 8)
+                {
+                    __m256i x = Swap32(_mm256_loadu_si256((const __m256i *)(input + i * 4)));
+                    _mm256_storeu_si256((__m256i *)(output + i), x);
+                }
+            }
+            scalar::CaptureFloat<SWAP>(input + i * 4, output + i, samples - i);
+        }
+
+        template <bool SWAP>
+        AVX2_TARGET void PlaybackS16(const float *input, uint8_t *output, size_t samples)
+        {
+            const __m256 scale = _mm256_set1_ps(S16_PLAYBACK_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i v = _mm256_cvttps_epi32(_mm256_mul_ps(Clamp(_mm256_loadu_ps(input + i)), scale));
+                __m128i x = _mm_packs_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+                if (SWAP)
+                    x = Swap16(x);
+                _mm_storeu_si128((__m128i *)(output + i * 2), x);
+            }
+            scalar::PlaybackS16<SWAP>(input + i, output + i * 2, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        AVX2_TARGET void PlaybackS32(const float *input, uint8_t *output, size_t samples)
+        {
+            const __m256d scale = _mm256_set1_pd(S24 ? S24_PLAYBACK_SCALE : S32_PLAYBACK_SCALE);
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = ScaleToInt32(_mm256_loadu_ps(input + i), scale);
+                if (SWAP)
+                    x = Swap32(x);
+                _mm256_storeu_si256((__m256i *)(output + i * 4), x);
+            }
+            scalar::PlaybackS32<SWAP, S24>(input + i, output + i * 4, samples - i);
+        }
+        template <bool BE>
+        AVX2_TARGET void PlaybackS24_3(const float *input, uint8_t *output, size_t samples)
+        {
+            // packs the high 24 bits of 4 int32s into 12 bytes.
+            const __m128i mask = BE
+                                     ? _mm_setr_epi8(3, 2, 1, 7, 6, 5, 11, 10, 9, 15, 14, 13, -1, -1, -1, -1)
+                                     : _mm_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+            const __m256d scale = _mm256_set1_pd(S32_PLAYBACK_SCALE);
+            alignas(16) uint8_t packed[16];
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                __m256i x = ScaleToInt32(_mm256_loadu_ps(input + i), scale);
+                uint8_t *p = output + i * 3;
+                _mm_store_si128((__m128i *)packed, _mm_shuffle_epi8(_mm256_castsi256_si128(x), mask));
+                memcpy(p, packed, 12);
+                _mm_store_si128((__m128i *)packed, _mm_shuffle_epi8(_mm256_extracti128_si256(x, 1), mask));
+                memcpy(p + 12, packed, 12);
+            }
+            scalar::PlaybackS24_3<BE>(input + i, output + i * 3, samples - i);
+        }
+        template <bool SWAP>
+        AVX2_TARGET void PlaybackFloat(const float *input, uint8_t *output, size_t samples)
+        {
+            CaptureFloat<SWAP>((const uint8_t *)input, (float *)output, samples);
+        }
+    }
+#endif
+
+#ifdef PIPEDAL_CONVERTERS_NEON
+    namespace neon
+    {
+        inline float32x4_t Clamp(float32x4_t v)
+        {
+            return vminq_f32(vmaxq_f32(v, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+        }
+        inline int32x4_t ScaleToInt32(float32x4_t v, double scale)
+        {
+            v = Clamp(v);
+            float64x2_t lo = vmulq_n_f64(vcvt_f64_f32(vget_low_f32(v)), scale);
+            float64x2_t hi = vmulq_n_f64(vcvt_high_f64_f32(v), scale);
+            return vcombine_s32(vmovn_s64(vcvtq_s64_f64(lo)), vmovn_s64(vcvtq_s64_f64(hi)));
+        }
+
+        template <bool SWAP>
+        void CaptureS16(const uint8_t *input, float *output, size_t samples)
+        {
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                uint8x16_t bytes = vld1q_u8(input + i * 2);
+                if (SWAP)
+                    bytes = vrev16q_u8(bytes);
+                int16x8_t x = vreinterpretq_s16_u8(bytes);
+                vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), S16_CAPTURE_SCALE));
+                vst1q_f32(output + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(x)), S16_CAPTURE_SCALE));
+            }
+            scalar::CaptureS16<SWAP>(input + i * 2, output + i, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        void CaptureS32(const uint8_t *input, float *output, size_t samples)
+        {
+            constexpr float scale = S24 ? S24_CAPTURE_SCALE : S32_CAPTURE_SCALE;
+            size_t i = 0;
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t bytes = vld1q_u8(input + i * 4);
+                if (SWAP)
+                    bytes = vrev32q_u8(bytes);
+                vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(vreinterpretq_s32_u8(bytes)), scale));
+            }
+            scalar::CaptureS32<SWAP, S24>(input + i * 4, output + i, samples - i);
+        }
+        template <bool BE>
+        void CaptureS24_3(const uint8_t *input, float *output, size_t samples)
+        {
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                uint8x8x3_t bytes = vld3_u8(input + i * 3);
+                uint8x8_t lsb = BE ? bytes.val[2] : bytes.val[0];
+                uint8x8_t msb = BE ? bytes.val[0] : bytes.val[2];
+                uint16x8_t lo = vshll_n_u8(lsb, 8);
+                uint16x8_t hi = vorrq_u16(vshll_n_u8(msb, 8), vmovl_u8(bytes.val[1]));
+                int32x4_t v0 = vreinterpretq_s32_u16(vzip1q_u16(lo, hi));
+                int32x4_t v1 = vreinterpretq_s32_u16(vzip2q_u16(lo, hi));
+                vst1q_f32(output + i, vmulq_n_f32(vcvtq_f32_s32(v0), S32_CAPTURE_SCALE));
+                vst1q_f32(output + i + 4, vmulq_n_f32(vcvtq_f32_s32(v1), S32_CAPTURE_SCALE));
+            }
+            scalar::CaptureS24_3<BE>(input + i * 3, output + i, samples - i);
+        }
+        template <bool SWAP>
+        void CaptureFloat(const uint8_t *input, float *output, size_t samples)
+        {
+            size_t i = 0;
+            if (SWAP)
+            {
+                for (; i + 4 <= samples; i += 4)
+                {
+                    vst1q_u8((uint8_t *)(output + i), vrev32q_u8(vld1q_u8(input + i * 4)));
+                }
+            }
+            scalar::CaptureFloat<SWAP>(input + i * 4, output + i, samples - i);
+        }
+
+        template <bool SWAP>
+        void PlaybackS16(const float *input, uint8_t *output, size_t samples)
+        {
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                int32x4_t lo = vcvtq_s32_f32(vmulq_n_f32(Clamp(vld1q_f32(input + i)), S16_PLAYBACK_SCALE));
+                int32x4_t hi = vcvtq_s32_f32(vmulq_n_f32(Clamp(vld1q_f32(input + i + 4)), S16_PLAYBACK_SCALE));
+                uint8x16_t bytes = vreinterpretq_u8_s16(vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+                if (SWAP)
+                    bytes = vrev16q_u8(bytes);
+                vst1q_u8(output + i * 2, bytes);
+            }
+            scalar::PlaybackS16<SWAP>(input + i, output + i * 2, samples - i);
+        }
+        template <bool SWAP, bool S24>
+        void PlaybackS32(const float *input, uint8_t *output, size_t samples)
+        {
+            constexpr double scale = S24 ? S24_PLAYBACK_SCALE : S32_PLAYBACK_SCALE;
+            size_t i = 0;
+            for (; i + 4 <= samples; i += 4)
+            {
+                uint8x16_t bytes = vreinterpretq_u8_s32(ScaleToInt32(vld1q_f32(input + i), scale));
+                if (SWAP)
+                    bytes = vrev32q_u8(bytes);
+                vst1q_u8(output + i * 4, bytes);
+            }
+            scalar::PlaybackS32<SWAP, S24>(input + i, output + i * 4, samples - i);
+        }
+        template <bool BE>
+        void PlaybackS24_3(const float *input, uint8_t *output, size_t samples)
+        {
+            size_t i = 0;
+            for (; i + 8 <= samples; i += 8)
+            {
+                uint32x4_t v0 = vreinterpretq_u32_s32(ScaleToInt32(vld1q_f32(input + i), S32_PLAYBACK_SCALE));
+                uint32x4_t v1 = vreinterpretq_u32_s32(ScaleToInt32(vld1q_f32(input + i + 4), S32_PLAYBACK_SCALE));
+                uint8x8_t b0 = vmovn_u16(vcombine_u16(vshrn_n_u32(v0, 8), vshrn_n_u32(v1, 8)));
+                uint8x8_t b1 = vmovn_u16(vcombine_u16(vshrn_n_u32(v0, 16), vshrn_n_u32(v1, 16)));
+                uint8x8_t b2 = vmovn_u16(vcombine_u16(vmovn_u32(vshrq_n_u32(v0, 24)), vmovn_u32(vshrq_n_u32(v1, 24))));
+                uint8x8x3_t bytes;
+                bytes.val[0] = BE ? b2 : b0;
+                bytes.val[1] = b1;
+                bytes.val[2] = BE ? b0 : b2;
+                vst3_u8(output + i * 3, bytes);
+            }
+            scalar::PlaybackS24_3<BE>(input + i, output + i * 3, samples - i);
+        }
+        template <bool SWAP>
+        void PlaybackFloat(const float *input, uint8_t *output, size_t samples)
+        {
+            CaptureFloat<SWAP>((const uint8_t *)input, (float *)output, samples);
+        }
+    }
+#endif
+
+#define PIPEDAL_CAPTURE_CONVERTER(ns, format)                                                  \
+    switch (format)                                                                            \
+    {                                                                                          \
+    case SND_PCM_FORMAT_S16_LE:                                                                \
+        return &ns::CaptureS16<false>;                                                         \
+    case SND_PCM_FORMAT_S16_BE:                                                                \
+        return &ns::CaptureS16<true>;                                                          \
+    case SND_PCM_FORMAT_S32_LE:                                                                \
+        return &ns::CaptureS32<false, false>;                                                  \
+    case SND_PCM_FORMAT_S32_BE:                                                                \
+        return &ns::CaptureS32<true, false>;                                                   \
+    case SND_PCM_FORMAT_S24_LE:                                                                \
+        return &ns::CaptureS32<false, true>;                                                   \
+    case SND_PCM_FORMAT_S24_BE:                                                                \
+        return &ns::CaptureS32<true, true>;                                                    \
+    case SND_PCM_FORMAT_FLOAT_LE:                                                              \
+        return &ns::CaptureFloat<false>;                                                       \
+    case SND_PCM_FORMAT_FLOAT_BE:                                                              \
+        return &ns::CaptureFloat<true>;                                                        \
+    default:                                                                                   \
+        break;                                                                                 \
+    }
+
+#define PIPEDAL_PLAYBACK_CONVERTER(ns, format)                                                 \
+    switch (format)                                                                            \
+    {                                                                                          \
+    case SND_PCM_FORMAT_S16_LE:                                                                \
+        return &ns::PlaybackS16<false>;                                                        \
+    case SND_PCM_FORMAT_S16_BE:                                                                \
+        return &ns::PlaybackS16<true>;                                                         \
+    case SND_PCM_FORMAT_S32_LE:                                                                \
+        return &ns::PlaybackS32<false, false>;                                                 \
+    case SND_PCM_FORMAT_S32_BE:                                                                \
+        return &ns::PlaybackS32<true, false>;                                                  \
+    case SND_PCM_FORMAT_S24_LE:                                                                \
+        return &ns::PlaybackS32<false, true>;                                                  \
+    case SND_PCM_FORMAT_S24_BE:                                                                \
+        return &ns::PlaybackS32<true, true>;                                                   \
+    case SND_PCM_FORMAT_S24_3LE:                                                               \
+        return &ns::PlaybackS24_3<false>;                                                      \
+    case SND_PCM_FORMAT_S24_3BE:                                                               \
+        return &ns::PlaybackS24_3<true>;                                                       \
+    case SND_PCM_FORMAT_FLOAT_LE:                                                              \
+        return &ns::PlaybackFloat<false>;                                                      \
+    case SND_PCM_FORMAT_FLOAT_BE:                                                              \
+        return &ns::PlaybackFloat<true>;                                                       \
+    default:                                                                                   \
+        break;                                                                                 \
+    }
+}
+
+SimdLevel pipedal::GetSimdLevel()
+{
+#if defined(PIPEDAL_CONVERTERS_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SimdLevel::Avx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SimdLevel::Sse2;
+    }
+    return SimdLevel::Scalar;
+#elif defined(PIPEDAL_CONVERTERS_NEON)
+    return SimdLevel::Neon;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+std::vector<SimdLevel> pipedal::GetSupportedSimdLevels()
+{
+    std::vector<SimdLevel> result;
+    result.push_back(SimdLevel::Scalar);
+    SimdLevel best = GetSimdLevel();
+    if (best == SimdLevel::Avx2)
+    {
+        result.push_back(SimdLevel::Sse2);
+    }
+    if (best != SimdLevel::Scalar)
+    {
+        result.push_back(best);
+    }
+    return result;
+}
+
+const char *pipedal::GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::Sse2:
+        return "SSE2";
+    case SimdLevel::Avx2:
+        return "AVX2";
+    case SimdLevel::Neon:
+        return "NEON";
+    }
+    return "unknown";
+}
+
+CaptureConverterFn pipedal::GetCaptureConverter(snd_pcm_format_t format, SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(PIPEDAL_CONVERTERS_X86)
+    case SimdLevel::Sse2:
+        // SSE2 has no byte shuffles, so S24_3 capture stays scalar.
+        PIPEDAL_CAPTURE_CONVERTER(sse2, format);
+        break;
+    case SimdLevel::Avx2:
+        if (format == SND_PCM_FORMAT_S24_3LE)
+            return &avx2::CaptureS24_3<false>;
+        if (format == SND_PCM_FORMAT_S24_3BE)
+            return &avx2::CaptureS24_3<true>;
+        PIPEDAL_CAPTURE_CONVERTER(avx2, format);
+        break;
+#endif
+#if defined(PIPEDAL_CONVERTERS_NEON)
+    case SimdLevel::Neon:
+        if (format == SND_PCM_FORMAT_S24_3LE)
+            return &neon::CaptureS24_3<false>;
+        if (format == SND_PCM_FORMAT_S24_3BE)
+            return &neon::CaptureS24_3<true>;
+        PIPEDAL_CAPTURE_CONVERTER(neon, format);
+        break;
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+PlaybackConverterFn pipedal::GetPlaybackConverter(snd_pcm_format_t format, SimdLevel level)
+{
+    switch (level)
+    {
+#if defined(PIPEDAL_CONVERTERS_X86)
+    case SimdLevel::Sse2:
+        PIPEDAL_PLAYBACK_CONVERTER(sse2, format);
+        break;
+    case SimdLevel::Avx2:
+        PIPEDAL_PLAYBACK_CONVERTER(avx2, format);
+        break;
+#endif
+#if defined(PIPEDAL_CONVERTERS_NEON)
+    case SimdLevel::Neon:
+        PIPEDAL_PLAYBACK_CONVERTER(neon, format);
+        break;
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+#if defined(PIPEDAL_CONVERTERS_X86) || defined(PIPEDAL_CONVERTERS_NEON)
+namespace
+{
+    // 4 frames of 4 channels: rows r0..r3 are written as columns o0..o3.
+    inline void Transpose4(
+        const float *r0, const float *r1, const float *r2, const float *r3,
+        float *o0, float *o1, float *o2, float *o3)
+    {
+#if defined(PIPEDAL_CONVERTERS_X86)
+        __m128 a = _mm_loadu_ps(r0), b = _mm_loadu_ps(r1), c = _mm_loadu_ps(r2), d = _mm_loadu_ps(r3);
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(o0, a);
+        _mm_storeu_ps(o1, b);
+        _mm_storeu_ps(o2, c);
+        _mm_storeu_ps(o3, d);
+#else
+        float32x4x2_t ab = vtrnq_f32(vld1q_f32(r0), vld1q_f32(r1));
+        float32x4x2_t cd = vtrnq_f32(vld1q_f32(r2), vld1q_f32(r3));
+        vst1q_f32(o0, vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])));
+        vst1q_f32(o1, vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])));
+        vst1q_f32(o2, vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])));
+        vst1q_f32(o3, vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])));
+#endif
+    }
+}
+#endif
+
+void pipedal::DeinterleaveSamples(const float *input, float *const *outputs, size_t channels, size_t frames)
+{
+    if (channels == 1)
+    {
+        memcpy(outputs[0], input, frames * sizeof(float));
+        return;
+    }
+    size_t frame = 0;
+    if (channels == 2)
+    {
+        float *left = outputs[0];
+        float *right = outputs[1];
+#if defined(PIPEDAL_CONVERTERS_X86)
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            __m128 a = _mm_loadu_ps(input + frame * 2);
+            __m128 b = _mm_loadu_ps(input + frame * 2 + 4);
+            _mm_storeu_ps(left + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + frame, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#elif defined(PIPEDAL_CONVERTERS_NEON)
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            float32x4x2_t v = vld2q_f32(input + frame * 2);
+            vst1q_f32(left + frame, v.val[0]);
+            vst1q_f32(right + frame, v.val[1]);
+        }
+#endif
+        for (; frame < frames; ++frame)
+        {
+            left[frame] = input[frame * 2];
+            right[frame] = input[frame * 2 + 1];
+        }
+        return;
+    }
+#if defined(PIPEDAL_CONVERTERS_X86) || defined(PIPEDAL_CONVERTERS_NEON)
+    // multichannel devices: 4x4 transposes, in a single pass over the interleaved buffer.
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        const float *p = input + frame * channels;
+        size_t channel = 0;
+        for (; channel + 4 <= channels; channel += 4)
+        {
+            Transpose4(
+                p + channel, p + channels + channel, p + 2 * channels + channel, p + 3 * channels + channel,
+                outputs[channel] + frame, outputs[channel + 1] + frame, outputs[channel + 2] + frame, outputs[channel + 3] + frame);
+        }
+        for (; channel < channels; ++channel)
+        {
+            float *out = outputs[channel] + frame;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                out[i] = p[i * channels + channel];
+            }
+        }
+    }
+#endif
+    const float *p = input + frame * channels;
+    for (; frame < frames; ++frame)
+    {
+        for (size_t channel = 0; channel < channels; ++channel)
+        {
+            outputs[channel][frame] = *p++;
+        }
+    }
+}
+
+void pipedal::InterleaveSamples(float *const *inputs, float *output, size_t channels, size_t frames)
+{
+    if (channels == 1)
+    {
+        memcpy(output, inputs[0], frames * sizeof(float));
+        return;
+    }
+    size_t frame = 0;
+    if (channels == 2)
+    {
+        const float *left = inputs[0];
+        const float *right = inputs[1];
+#if defined(PIPEDAL_CONVERTERS_X86)
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            __m128 l = _mm_loadu_ps(left + frame);
+            __m128 r = _mm_loadu_ps(right + frame);
+            _mm_storeu_ps(output + frame * 2, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(output + frame * 2 + 4, _mm_unpackhi_ps(l, r));
+        }
+#elif defined(PIPEDAL_CONVERTERS_NEON)
+        for (; frame + 4 <= frames; frame += 4)
+        {
+            float32x4x2_t v;
+            v.val[0] = vld1q_f32(left + frame);
+            v.val[1] = vld1q_f32(right + frame);
+            vst2q_f32(output + frame * 2, v);
+        }
+#endif
+        for (; frame < frames; ++frame)
+        {
+            output[frame * 2] = left[frame];
+            output[frame * 2 + 1] = right[frame];
+        }
+        return;
+    }
+#if defined(PIPEDAL_CONVERTERS_X86) || defined(PIPEDAL_CONVERTERS_NEON)
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        float *p = output + frame * channels;
+        size_t channel = 0;
+        for (; channel + 4 <= channels; channel += 4)
+        {
+            Transpose4(
+                inputs[channel] + frame, inputs[channel + 1] + frame, inputs[channel + 2] + frame, inputs[channel + 3] + frame,
+                p + channel, p + channels + channel, p + 2 * channels + channel, p + 3 * channels + channel);
+        }
+        for (; channel < channels; ++channel)
+        {
+            const float *in = inputs[channel] + frame;
+            for (size_t i = 0; i < 4; ++i)
+            {
+                p[i * channels + channel] = in[i];
+            }
+        }
+    }
+#endif
+    float *p = output + frame * channels;
+    for (; frame < frames; ++frame)
+    {
+        for (size_t channel = 0; channel < channels; ++channel)
+        {
+            *p++ = inputs[channel][frame];
+        }
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <alsa/asoundlib.h>
+
+namespace pipedal
+{
+    // Vectorized converters between ALSA interleaved sample formats and (interleaved) float samples.
+    //
+    // Results are bit-exact with the scalar converters in AlsaDriver.cpp, which remain the fallback for
+    // formats and instruction sets that don't have a vectorized version.
+
+    enum class SimdLevel
+    {
+        Scalar,
+        Sse2,
+        Avx2,
+        Neon
+    };
+
+    // The best instruction set supported by the current CPU.
+    SimdLevel GetSimdLevel();
+    // All instruction sets supported by the current CPU (for testing).
+    std::vector<SimdLevel> GetSupportedSimdLevels();
+    const char *GetSimdLevelName(SimdLevel level);
+
+    using CaptureConverterFn = void (*)(const uint8_t *input, float *output, size_t samples);
+    using PlaybackConverterFn = void (*)(const float *input, uint8_t *output, size_t samples);
+
+    // Returns nullptr if there is no vectorized converter for the format at the given level.
+    CaptureConverterFn GetCaptureConverter(snd_pcm_format_t format, SimdLevel level);
+    PlaybackConverterFn GetPlaybackConverter(snd_pcm_format_t format, SimdLevel level);
+
+    // Any number of channels. Multichannel data is transposed 4 channels x 4 frames at a time.
+    void DeinterleaveSamples(const float *input, float *const *outputs, size_t channels, size_t frames);
+    void InterleaveSamples(float *const *inputs, float *output, size_t channels, size_t frames);
+}
@@ -66,6 +66,35 @@ AtomConverter::AtomConverter(MapFeature &map)
     lv2_atom_forge_init(&outputForge, map.GetMap());
 }
 
+template <typename FN>
+LV2_Atom *AtomConverter::ForgeAtom(FN &&forgeFn)
+{
+    if (outputBuffer.size() == 0)
+    {
+        outputBuffer.resize(512);
+    }
+
+    while (true)
+    {
+        try {
+            LV2_Atom *result = (LV2_Atom*)(&outputBuffer[0]);
+            result->size = outputBuffer.size();
+            lv2_atom_forge_set_buffer(&outputForge,(uint8_t*)&(outputBuffer[0]),outputBuffer.size());
+            forgeFn();
+            return (LV2_Atom*)(&outputBuffer[0]);
+        } catch (const BufferOverflowException&)
+        {
+        }
+
+        if (outputBuffer.size() >= 1024*1024)
+        {
+            throw std::logic_error("Atom is too large.");
+        }
+        outputBuffer.resize(outputBuffer.size()*2);
+    }
+}
+
+
 json_variant AtomConverter::ToJson(const LV2_Atom *atom)
 {
     json_variant variant = ToVariant(const_cast<LV2_Atom*>(atom));
@@ -74,20 +103,20 @@ json_variant AtomConverter::ToJson(const LV2_Atom *atom)
 
 LV2_Atom*AtomConverter::ToAtom(const std::string&jsonString)
 {
-    json_variant jvValue;
-    std::istringstream ss(jsonString);
-    json_reader reader(ss);
-    reader.read(&jvValue);
-    return ToAtom(jvValue);
+    return ForgeAtom(
+        [this, &jsonString]()
+        {
+            json_reader reader{std::string_view(jsonString)};
+            ReaderToForge(reader, jsonString);
+        });
 }
 
-std::string AtomConverter::ToString(const LV2_Atom*atom)
+std::string AtomConverter::ToString(const LV2_Atom*atom) const
 {
-    json_variant v = ToJson(atom);
-    std::ostringstream ss;
-    json_writer writer(ss);
-    writer.write(v);
-    return ss.str();
+    std::string result;
+    json_writer writer(result);
+    WriteJson(writer, atom);
+    return result;
 }
 json_variant AtomConverter::MapPath(const json_variant&json, const std::string &pluginStoragePath)
 {
@@ -148,32 +177,13 @@ json_variant AtomConverter::MakePathVariant(const std::string&pathString)
 
 LV2_Atom*AtomConverter::ToAtom(const json_variant&json)
 {
-    if (outputBuffer.size() == 0)
-    {
-        outputBuffer.resize(512);
-    }
-
-    while (true)
-    {
-        try {
-            LV2_Atom *result = (LV2_Atom*)(&outputBuffer[0]);
-            result->size = outputBuffer.size();
-            lv2_atom_forge_set_buffer(&outputForge,(uint8_t*)&(outputBuffer[0]),outputBuffer.size());
-            ToForge(json);
-            return (LV2_Atom*)(&outputBuffer[0]);
-        } catch (const BufferOverflowException&)
-        {
-        }
-
-        if (outputBuffer.size() >= 1024*1024)
+    return ForgeAtom(
+        [this, &json]()
         {
-            throw std::logic_error("Atom is too large.");
-        }
-        outputBuffer.resize(outputBuffer.size()*2);
-    }
+            ToForge(json);
+        });
 }
 
-
 static inline void *AtomContent(LV2_Atom*atom,size_t offset = 0)
 {
     // always % sizeof(LV2_Atom)
@@ -487,7 +497,7 @@ void AtomConverter::VectorToForge(const json_variant&json)
         }
         // does this pad the frame?
         lv2_atom_forge_pop(&outputForge,&frame);
-        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(float));
+        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(T));
 
     }
     else if (childType == urids.ATOM__Int)
@@ -502,7 +512,7 @@ void AtomConverter::VectorToForge(const json_variant&json)
         }
         // does this pad the frame?
         lv2_atom_forge_pop(&outputForge,&frame);
-        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(float));
+        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(T));
     }
     else if (childType == urids.ATOM__Bool)
     {
@@ -516,7 +526,7 @@ void AtomConverter::VectorToForge(const json_variant&json)
         }
         // does this pad the frame?
         lv2_atom_forge_pop(&outputForge,&frame);
-        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(float));
+        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(T));
     }
     else if (childType == urids.ATOM__Long)
     {
@@ -530,7 +540,7 @@ void AtomConverter::VectorToForge(const json_variant&json)
         }
         // does this pad the frame?
         lv2_atom_forge_pop(&outputForge,&frame);
-        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(float));
+        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(T));
     }
     else if (childType == urids.ATOM__Double)
     {
@@ -544,7 +554,7 @@ void AtomConverter::VectorToForge(const json_variant&json)
         }
         // does this pad the frame?
         lv2_atom_forge_pop(&outputForge,&frame);
-        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(float));
+        lv2_atom_forge_pad(&outputForge,sizeof(LV2_Atom_Vector_Body)+size*sizeof(T));
     } else {
         std::string dataType = map.UridToString(childType);
         throw std::logic_error("AtomConverter: Vector dataype not supported. (" + dataType + ") Please contact support if you get this message.");
@@ -567,6 +577,472 @@ void AtomConverter::TupleToForge(const json_variant&json)
 }
 
 
+void AtomConverter::WriteTypedPropertyStart(json_writer &writer, const char *type) const
+{
+    writer.start_object();
+    writer.write(OTYPE_TAG);
+    writer.write_raw(": ");
+    writer.write(type);
+    writer.write_raw(",");
+    writer.write("value");
+    writer.write_raw(": ");
+}
+
+static inline std::string_view AtomStringValue(const LV2_Atom *atom)
+{
+    // up to the first nul, as json_variant strings would be written.
+    const char *p = (const char *)atom + sizeof(LV2_Atom);
+    return std::string_view(p, strnlen(p, atom->size));
+}
+static inline const char *UridString(MapFeature &map, LV2_URID urid)
+{
+    const char *result = map.UridToString(urid);
+    return result ? result : "";
+}
+
+void AtomConverter::WriteVector(json_writer &writer, const LV2_Atom_Vector *pVal) const
+{
+    LV2_URID childType = pVal->body.child_type;
+    uint32_t childSize = pVal->body.child_size;
+    bool supported =
+        (childType == urids.ATOM__Float && childSize == sizeof(float)) ||
+        (childType == urids.ATOM__Int && childSize == sizeof(int32_t)) ||
+        (childType == urids.ATOM__Bool && childSize == sizeof(int32_t)) ||
+        (childType == urids.ATOM__Long && childSize == sizeof(int64_t)) ||
+        (childType == urids.ATOM__Double && childSize == sizeof(double));
+    if (!supported)
+    {
+        std::string dataType = UridString(map, childType);
+        throw std::logic_error("AtomConverter: Vector dataype not supported. (" + dataType + ") Please contact support if you get this message.");
+    }
+    size_t n = (pVal->atom.size - sizeof(LV2_Atom_Vector_Body)) / childSize;
+    const void *vectorData = (const char *)pVal + sizeof(LV2_Atom_Vector);
+
+    writer.start_object();
+    writer.write(OTYPE_TAG);
+    writer.write_raw(": ");
+    writer.write(SHORT_ATOM__Vector);
+    writer.write_raw(",");
+    writer.write(VTYPE_TAG);
+    writer.write_raw(": ");
+    writer.write(TypeUridToString(childType));
+    writer.write_raw(",");
+    writer.write("value");
+    writer.write_raw(": ");
+
+    writer.start_array();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i != 0)
+        {
+            writer.write_raw(",");
+        }
+        if (childType == urids.ATOM__Float)
+        {
+            writer.write((double)((const float *)vectorData)[i]);
+        }
+        else if (childType == urids.ATOM__Int)
+        {
+            writer.write((double)((const int32_t *)vectorData)[i]);
+        }
+        else if (childType == urids.ATOM__Bool)
+        {
+            writer.write(((const int32_t *)vectorData)[i] != 0);
+        }
+        else if (childType == urids.ATOM__Long)
+        {
+            writer.write((double)((const int64_t *)vectorData)[i]);
+        }
+        else
+        {
+            writer.write(((const double *)vectorData)[i]);
+        }
+    }
+    writer.end_array();
+    writer.end_object();
+}
+
+void AtomConverter::WriteJson(json_writer &writer, const LV2_Atom *atom) const
+{
+    // Mirrors ToVariant(), including numeric types being written as doubles.
+    if (atom->type == urids.ATOM__Float)
+    {
+        writer.write((double)((const LV2_Atom_Float *)atom)->body);
+    }
+    else if (atom->type == urids.ATOM__Bool)
+    {
+        writer.write(((const LV2_Atom_Bool *)atom)->body != 0);
+    }
+    else if (atom->type == urids.ATOM__Int)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__Int);
+        writer.write((double)((const LV2_Atom_Int *)atom)->body);
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__Long)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__Long);
+        writer.write((double)((const LV2_Atom_Long *)atom)->body);
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__Double)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__Double);
+        writer.write((double)((const LV2_Atom_Double *)atom)->body);
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__URID)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__URID);
+        writer.write(UridString(map, ((const LV2_Atom_URID *)atom)->body));
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__String)
+    {
+        writer.write(AtomStringValue(atom));
+    }
+    else if (atom->type == urids.ATOM__Path)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__Path);
+        writer.write(AtomStringValue(atom));
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__URI)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__URI);
+        writer.write(AtomStringValue(atom));
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__Tuple)
+    {
+        WriteTypedPropertyStart(writer, SHORT_ATOM__Tuple);
+        writer.start_array();
+        LV2_Atom *current = (LV2_Atom *)AtomContent((LV2_Atom *)atom, 0);
+        LV2_Atom *end = (LV2_Atom *)AtomContent((LV2_Atom *)atom, atom->size);
+        bool first = true;
+        while (current < end)
+        {
+            if (!first)
+            {
+                writer.write_raw(",");
+            }
+            first = false;
+            WriteJson(writer, current);
+            current = NextAtom(current);
+        }
+        writer.end_array();
+        writer.end_object();
+    }
+    else if (atom->type == urids.ATOM__Vector)
+    {
+        WriteVector(writer, (const LV2_Atom_Vector *)atom);
+    }
+    else if (atom->type == urids.ATOM__Property)
+    {
+        throw std::logic_error("Not implemented.");
+    }
+    else if (atom->type == urids.ATOM__Object)
+    {
+        const LV2_Atom_Object *pVal = (const LV2_Atom_Object *)atom;
+
+        writer.start_object();
+        bool first = true;
+        if (pVal->body.id != 0)
+        {
+            writer.write(ID_TAG);
+            writer.write_raw(": ");
+            writer.write(UridString(map, pVal->body.id));
+            first = false;
+        }
+        if (pVal->body.otype != 0)
+        {
+            if (!first)
+            {
+                writer.write_raw(",");
+            }
+            writer.write(OTYPE_TAG);
+            writer.write_raw(": ");
+            writer.write(UridString(map, pVal->body.otype));
+            first = false;
+        }
+        LV2_Atom_Property_Body *current = (LV2_Atom_Property_Body *)AtomContent((LV2_Atom *)atom, sizeof(LV2_Atom_Object_Body));
+        LV2_Atom_Property_Body *end = (LV2_Atom_Property_Body *)AtomContent((LV2_Atom *)atom, atom->size);
+        while (current < end)
+        {
+            if (!first)
+            {
+                writer.write_raw(",");
+            }
+            first = false;
+            writer.write(UridString(map, current->key));
+            writer.write_raw(": ");
+            WriteJson(writer, &current->value);
+            current = (LV2_Atom_Property_Body *)(NextAtom(&(current->value)));
+        }
+        writer.end_object();
+    }
+    else
+    {
+        throw std::logic_error(
+            SS("AtomConverter: Datatype not supported. ("
+               << UridString(map, atom->type)
+               << ") Please contact support if you get this message."));
+    }
+}
+
+namespace
+{
+    struct ObjectTags
+    {
+        std::string otype;
+        std::string id;
+        std::string vtype;
+    };
+}
+
+// otype_, id_ and vtype_ determine how an object is forged, but json doesn't guarantee
+// that they come first. Find them with a separate reader before forging anything.
+static ObjectTags ScanObjectTags(std::string_view objectText)
+{
+    ObjectTags result;
+    json_reader reader(objectText);
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string key = reader.read_string();
+        reader.consume(':');
+        if (key == "otype_")
+        {
+            reader.read(&result.otype);
+        }
+        else if (key == "id_")
+        {
+            reader.read(&result.id);
+        }
+        else if (key == "vtype_")
+        {
+            reader.read(&result.vtype);
+        }
+        else
+        {
+            reader.skip_property();
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    return result;
+}
+
+void AtomConverter::ReaderToForge(json_reader &reader, std::string_view jsonText)
+{
+    int c = reader.peek();
+    if (c == '{')
+    {
+        ReaderObjectToForge(reader, jsonText);
+    }
+    else if (c == '"')
+    {
+        std::string str = reader.read_string();
+        CheckResult(lv2_atom_forge_string(&outputForge, str.c_str(), str.size() + 1));
+    }
+    else if (c == 't' || c == 'f')
+    {
+        bool value;
+        reader.read(&value);
+        CheckResult(lv2_atom_forge_bool(&outputForge, value));
+    }
+    else if (c == '[' || c == 'n' || c == -1)
+    {
+        throw std::logic_error("Malformed json atom.");
+    }
+    else
+    {
+        double value;
+        reader.read(&value);
+        CheckResult(lv2_atom_forge_float(&outputForge, (float)value));
+    }
+}
+
+void AtomConverter::ReaderObjectToForge(json_reader &reader, std::string_view jsonText)
+{
+    ObjectTags tags = ScanObjectTags(jsonText.substr(reader.tell()));
+
+    bool isTypedValue =
+        tags.otype == SHORT_ATOM__Int || tags.otype == SHORT_ATOM__Long || tags.otype == SHORT_ATOM__Double ||
+        tags.otype == SHORT_ATOM__Path || tags.otype == SHORT_ATOM__URI || tags.otype == SHORT_ATOM__URID ||
+        tags.otype == SHORT_ATOM__Tuple || tags.otype == SHORT_ATOM__Vector;
+
+    LV2_Atom_Forge_Frame frame;
+    if (!isTypedValue)
+    {
+        LV2_URID id = tags.id.empty() ? 0 : map.GetUrid(tags.id.c_str());
+        LV2_URID oType = tags.otype.empty() ? 0 : map.GetUrid(tags.otype.c_str());
+        CheckResult(lv2_atom_forge_object(&outputForge, &frame, id, oType));
+    }
+    bool hasValue = false;
+
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string key = reader.read_string();
+        reader.consume(':');
+        if (key == OTYPE_TAG || key == ID_TAG || key == VTYPE_TAG)
+        {
+            reader.skip_property();
+        }
+        else if (!isTypedValue)
+        {
+            CheckResult(lv2_atom_forge_key(&outputForge, map.GetUrid(key.c_str())));
+            ReaderToForge(reader, jsonText);
+        }
+        else if (key != "value" || hasValue)
+        {
+            reader.skip_property();
+        }
+        else
+        {
+            hasValue = true;
+            if (tags.otype == SHORT_ATOM__Int)
+            {
+                double value;
+                reader.read(&value);
+                CheckResult(lv2_atom_forge_int(&outputForge, (int32_t)value));
+            }
+            else if (tags.otype == SHORT_ATOM__Long)
+            {
+                double value;
+                reader.read(&value);
+                CheckResult(lv2_atom_forge_long(&outputForge, (int64_t)value));
+            }
+            else if (tags.otype == SHORT_ATOM__Double)
+            {
+                double value;
+                reader.read(&value);
+                CheckResult(lv2_atom_forge_double(&outputForge, value));
+            }
+            else if (tags.otype == SHORT_ATOM__Path)
+            {
+                std::string value = reader.read_string();
+                CheckResult(lv2_atom_forge_path(&outputForge, value.c_str(), value.length() + 1));
+            }
+            else if (tags.otype == SHORT_ATOM__URI)
+            {
+                std::string value = reader.read_string();
+                CheckResult(lv2_atom_forge_uri(&outputForge, value.c_str(), value.length() + 1));
+            }
+            else if (tags.otype == SHORT_ATOM__URID)
+            {
+                std::string value = reader.read_string();
+                CheckResult(lv2_atom_forge_urid(&outputForge, map.GetUrid(value.c_str())));
+            }
+            else if (tags.otype == SHORT_ATOM__Tuple)
+            {
+                ReaderTupleToForge(reader, jsonText);
+            }
+            else
+            {
+                ReaderVectorToForge(reader, GetTypeUrid(tags.vtype));
+            }
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.end_object();
+
+    if (isTypedValue)
+    {
+        if (!hasValue)
+        {
+            throw std::logic_error("Malformed json atom. (Missing value)");
+        }
+    }
+    else
+    {
+        lv2_atom_forge_pop(&outputForge, &frame);
+    }
+}
+
+void AtomConverter::ReaderTupleToForge(json_reader &reader, std::string_view jsonText)
+{
+    LV2_Atom_Forge_Frame frame;
+    CheckResult(lv2_atom_forge_tuple(&outputForge, &frame));
+    reader.consume('[');
+    while (reader.peek() != ']')
+    {
+        ReaderToForge(reader, jsonText);
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.consume(']');
+    lv2_atom_forge_pop(&outputForge, &frame);
+}
+
+template <typename T>
+void AtomConverter::ReaderVectorElementsToForge(json_reader &reader, LV2_URID childType)
+{
+    LV2_Atom_Forge_Frame frame;
+    CheckResult(lv2_atom_forge_vector_head(&outputForge, &frame, sizeof(T), childType));
+    size_t size = 0;
+    reader.consume('[');
+    while (reader.peek() != ']')
+    {
+        T value;
+        if (childType == urids.ATOM__Bool)
+        {
+            bool b;
+            reader.read(&b);
+            value = (T)b;
+        }
+        else
+        {
+            double d;
+            reader.read(&d);
+            value = (T)d;
+        }
+        CheckResult(lv2_atom_forge_raw(&outputForge, &value, sizeof(value)));
+        ++size;
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.consume(']');
+    lv2_atom_forge_pop(&outputForge, &frame);
+    lv2_atom_forge_pad(&outputForge, sizeof(LV2_Atom_Vector_Body) + size * sizeof(T));
+}
+
+void AtomConverter::ReaderVectorToForge(json_reader &reader, LV2_URID childType)
+{
+    if (childType == urids.ATOM__Float)
+    {
+        ReaderVectorElementsToForge<float>(reader, childType);
+    }
+    else if (childType == urids.ATOM__Int || childType == urids.ATOM__Bool)
+    {
+        ReaderVectorElementsToForge<int32_t>(reader, childType);
+    }
+    else if (childType == urids.ATOM__Long)
+    {
+        ReaderVectorElementsToForge<int64_t>(reader, childType);
+    }
+    else if (childType == urids.ATOM__Double)
+    {
+        ReaderVectorElementsToForge<double>(reader, childType);
+    }
+    else
+    {
+        std::string dataType = map.UridToString(childType);
+        throw std::logic_error("AtomConverter: Vector dataype not supported. (" + dataType + ") Please contact support if you get this message.");
+    }
+}
+
+
 LV2_URID AtomConverter::GetTypeUrid(const std::string uri)
 {
     if (stringToTypeUrid.find(uri) != stringToTypeUrid.end())
@@ -585,11 +1061,12 @@ LV2_URID AtomConverter::InitUrid(const char*uri, const char*shortUri )
     return urid;
 }
 
-std::string AtomConverter::TypeUridToString(LV2_URID urid)
+std::string AtomConverter::TypeUridToString(LV2_URID urid) const
 {
-    if (typeUridToString.find(urid) != typeUridToString.end())
+    auto f = typeUridToString.find(urid);
+    if (f != typeUridToString.end())
     {
-        return typeUridToString[urid];
+        return f->second;
     }
     return map.UridToString(urid);
 }
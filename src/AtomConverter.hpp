@@ -148,10 +148,17 @@ namespace pipedal
         /// @param json Json string that matches the structure of the prototype.
         /// @return An atom. Not valid beyond the lifetime of the AtomConverter. Memory is owned by the AtomConverter.
         /// @remarks
+        /// The json is forged directly from a json_reader, without building a json_variant.
 
         LV2_Atom*ToAtom(const std::string &jsonString);
 
-        std::string ToString(const LV2_Atom*atom);
+        /// @brief Write an atom to a json_writer, without building a json_variant.
+        /// @remarks Produces the same json as writing ToJson(atom). Doesn't modify the 
+        /// converter, so it can be called on a shared AtomConverter from any thread.
+        void WriteJson(json_writer &writer, const LV2_Atom *atom) const;
+
+        /// @brief Convert an atom to a json string. Thread-safe (see WriteJson).
+        std::string ToString(const LV2_Atom*atom) const;
 
         static json_variant MapPath(const json_variant&json, const std::string &pluginStoragePath);
         static json_variant AbstractPath(const json_variant&json, const std::string &pluginStoragePath);
@@ -173,7 +180,7 @@ namespace pipedal
         std::map<LV2_URID,std::string> typeUridToString;
 
         LV2_URID GetTypeUrid(const std::string uri);
-        std::string TypeUridToString(LV2_URID urid);
+        std::string TypeUridToString(LV2_URID urid) const;
 
 
         void InitUrids();
@@ -201,6 +208,19 @@ namespace pipedal
         void VectorToForge(const json_variant&json);
         void TupleToForge(const json_variant&json);
         void ObjectToForge(const json_variant&json);
+
+        template <typename FN>
+        LV2_Atom *ForgeAtom(FN &&forgeFn);
+
+        void ReaderToForge(json_reader &reader, std::string_view jsonText);
+        void ReaderObjectToForge(json_reader &reader, std::string_view jsonText);
+        void ReaderTupleToForge(json_reader &reader, std::string_view jsonText);
+        void ReaderVectorToForge(json_reader &reader, LV2_URID childType);
+        template <typename T>
+        void ReaderVectorElementsToForge(json_reader &reader, LV2_URID childType);
+
+        void WriteTypedPropertyStart(json_writer &writer, const char *type) const;
+        void WriteVector(json_writer &writer, const LV2_Atom_Vector *atom) const;
         
 
         class BufferOverflowException: public std::exception {
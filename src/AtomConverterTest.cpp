@@ -52,6 +52,14 @@ static void RoundTripTest(const AtomBuffer &buffer)
     REQUIRE(atomOut->size == prototype->size);
     size_t size = atomOut->size + sizeof(LV2_Atom);
     REQUIRE(std::memcmp(atomOut, prototype, size) == 0);
+
+    // direct conversion, without json_variant intermediates.
+    std::string json = converter.ToString(prototype);
+    REQUIRE(json == variant.to_string());
+
+    atomOut = converter.ToAtom(json);
+    REQUIRE(atomOut->size == prototype->size);
+    REQUIRE(std::memcmp(atomOut, prototype, size) == 0);
 }
 
 AtomBuffer MakeSimpleAtom()
@@ -101,6 +109,28 @@ AtomBuffer MakeTestTupleAtom()
     return atomBuffer;
 }
 
+AtomBuffer MakeTestVectorsAtom()
+{
+    AtomBuffer atomBuffer(512);
+    LV2_Atom_Forge t;
+    LV2_Atom_Forge *forge = &t;
+    lv2_atom_forge_init(forge, mapFeature.GetMap());
+    lv2_atom_forge_set_buffer(forge, &(atomBuffer[0]), atomBuffer.size());
+
+    LV2_Atom_Forge_Frame frame;
+    lv2_atom_forge_tuple(forge, &frame);
+    {
+        double doubleValues[] = {1.5, 2.5, 3.5};
+        lv2_atom_forge_vector(forge, sizeof(double), mapFeature.GetUrid(LV2_ATOM__Double), 3, doubleValues);
+        int32_t intValues[] = {1, -2, 3};
+        lv2_atom_forge_vector(forge, sizeof(int32_t), mapFeature.GetUrid(LV2_ATOM__Int), 3, intValues);
+        lv2_atom_forge_long(forge, -1234567);
+        lv2_atom_forge_uri(forge, "http://something.com/custom#uri", 32);
+    }
+    lv2_atom_forge_pop(forge, &frame);
+    return atomBuffer;
+}
+
 TEST_CASE("AtomConverter", "[atom_converter][Build][Dev]")
 {
     cout << "=== AtomConverter Test ====" << endl;
@@ -110,4 +140,29 @@ TEST_CASE("AtomConverter", "[atom_converter][Build][Dev]")
 
     cout << "  simpleAtom" << endl;
     RoundTripTest(MakeSimpleAtom());
+
+    cout << "  vectors" << endl;
+    RoundTripTest(MakeTestVectorsAtom());
+
+    // otype_ and vtype_ don't have to be the first properties.
+    {
+        AtomConverter converter(mapFeature);
+        AtomBuffer expected = MakeTestTupleAtom();
+        std::string json =
+            "{\"value\": [true, {\"value\": 1, \"otype_\": \"Int\"}, 2.1, {\"value\": 1.23456789, \"otype_\": \"Double\"}, \"abcd\","
+            " {\"value\": [1.1, 2.2, 3.3, 4.4], \"vtype_\": \"Float\", \"otype_\": \"Vector\"},"
+            " {\"" LV2_PATCH__property "\": {\"otype_\": \"URID\", \"value\": \"http://something.com/custom#prop\"},"
+            "  \"" LV2_PATCH__value "\": {\"value\": \"/var/pipdeal/test.wav\", \"otype_\": \"Path\"},"
+            "  \"otype_\": \"" LV2_PATCH__Set "\"}],"
+            " \"otype_\": \"Tuple\"}";
+        LV2_Atom *atomOut = converter.ToAtom(json);
+        LV2_Atom *prototype = (LV2_Atom *)&(expected[0]);
+        REQUIRE(atomOut->size == prototype->size);
+        REQUIRE(std::memcmp(atomOut, prototype, atomOut->size + sizeof(LV2_Atom)) == 0);
+    }
+    {
+        AtomConverter converter(mapFeature);
+        REQUIRE_THROWS(converter.ToAtom(std::string("{\"otype_\": \"Int\"}")));
+        REQUIRE_THROWS(converter.ToAtom(std::string("[1,2]")));
+    }
 }
@@ -26,6 +26,8 @@
 #include "JackConfiguration.hpp"
 #include <functional>
 #include "AlsaSequencer.hpp"
+#include "AudioPeriodTrace.hpp"
+#include "CpuUse.hpp"
 
 
 
@@ -41,8 +43,36 @@ namespace pipedal {
         uint32_t    time;   /**< Sample frame at which event is valid */
         uint32_t  size;   /**< Number of bytes of data in \a buffer */
         uint8_t  *buffer; /**< Raw MIDI data */
+        uint64_t receivedNs = 0; /**< EffectTimingClockNs() time at which the event arrived, 0 if unknown. */
     };
 
+    // The frame within the current period of a MIDI event received at eventNs, where periodEndNs is the
+    // (sequencer queue) time at which the period's input finished arriving. Events keep a constant latency of
+    // one period, instead of being bunched at the start of the period.
+    inline uint32_t MidiEventFrame(uint64_t eventNs, uint64_t periodEndNs, uint32_t sampleRate, uint32_t periodFrames)
+    {
+        if (periodFrames == 0)
+            return 0;
+        uint64_t periodNs = (uint64_t)periodFrames * 1000000000ull / sampleRate;
+        if (eventNs + periodNs <= periodEndNs)
+        {
+            return 0; // late.
+        }
+        uint64_t frame = (eventNs + periodNs - periodEndNs) * sampleRate / 1000000000ull;
+        return frame >= periodFrames ? periodFrames - 1 : (uint32_t)frame;
+    }
+
+    // The arrival time of a MIDI event received at eventNs (sequencer queue time), on the clock that gave nowNs,
+    // where periodEndNs is the queue time read at nowNs.
+    inline uint64_t MidiEventReceivedNs(uint64_t eventNs, uint64_t periodEndNs, uint64_t nowNs)
+    {
+        if (periodEndNs == 0 || eventNs >= periodEndNs || periodEndNs - eventNs >= nowNs)
+        {
+            return nowNs;
+        }
+        return nowNs - (periodEndNs - eventNs);
+    }
+
 
     class AudioDriverHost {
     public:
@@ -81,6 +111,14 @@ namespace pipedal {
 
         virtual std::string GetConfigurationDescription() = 0;
         virtual void DumpBufferTrace(size_t nEntries) {}
+        // The most recent periods recorded by the driver's xrun trace (if it has one), oldest first.
+        virtual std::vector<AudioPeriodTraceEntry> GetPeriodTrace(double seconds) { return {}; }
+        virtual XrunRecoveryStatistics GetXrunRecoveryStatistics() { return XrunRecoveryStatistics(); }
+        // Per-stage period time distributions since the last reset.
+        virtual CpuUseStatistics GetCpuUseStatistics() { return CpuUseStatistics(); }
+        virtual void ResetCpuUseStatistics() {}
+        // p99.9 headroom since the last call (see CpuUse::TakeRecentHeadroom).
+        virtual std::optional<float> TakeRecentCpuHeadroom() { return std::nullopt; }
 
     };
 
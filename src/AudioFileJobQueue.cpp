@@ -0,0 +1,173 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "AudioFileJobQueue.hpp"
+#include "SchedulerPriority.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+
+using namespace pipedal;
+
+static thread_local bool isJobThread = false;
+
+AudioFileJobQueue::AudioFileJobQueue(size_t threadCount, size_t maxPendingJobs)
+    : maxPendingJobs(maxPendingJobs)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        threads.emplace_back([this]()
+                             { ThreadProc(); });
+    }
+}
+
+AudioFileJobQueue::~AudioFileJobQueue()
+{
+    Close();
+}
+
+bool AudioFileJobQueue::IsJobThread()
+{
+    return isJobThread;
+}
+
+std::shared_future<void> AudioFileJobQueue::Post(const std::string &key, Job &&job)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closing)
+    {
+        return std::shared_future<void>();
+    }
+    auto f = activeJobs.find(key);
+    if (f != activeJobs.end())
+    {
+        return f->second;
+    }
+    if (queue.size() >= maxPendingJobs)
+    {
+        return std::shared_future<void>();
+    }
+    Entry entry;
+    entry.key = key;
+    entry.job = std::move(job);
+    entry.promise = std::make_shared<std::promise<void>>();
+    std::shared_future<void> result = entry.promise->get_future().share();
+    activeJobs[key] = result;
+    queue.push_back(std::move(entry));
+    cv.notify_one();
+    return result;
+}
+
+void AudioFileJobQueue::Close()
+{
+    std::deque<Entry> discarded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closing)
+        {
+            return;
+        }
+        closing = true;
+        discarded = std::move(queue);
+        queue.clear();
+        for (const auto &entry : discarded)
+        {
+            activeJobs.erase(entry.key);
+        }
+        cv.notify_all();
+    }
+    for (auto &entry : discarded)
+    {
+        entry.promise->set_exception(std::make_exception_ptr(std::runtime_error("Cancelled.")));
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+}
+
+size_t AudioFileJobQueue::GetPendingJobCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + runningJobs;
+}
+
+void AudioFileJobQueue::WaitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCv.wait(lock, [this]()
+                { return queue.empty() && runningJobs == 0; });
+}
+
+void AudioFileJobQueue::ThreadProc()
+{
+    SetThreadName("audioFileJobs");
+    SetThreadPriority(SchedulerPriority::BackgroundBatch);
+    isJobThread = true;
+
+    while (true)
+    {
+        Entry entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]()
+                    { return closing || !queue.empty(); });
+            if (closing)
+            {
+                return;
+            }
+            entry = std::move(queue.front());
+            queue.pop_front();
+            ++runningJobs;
+        }
+        std::exception_ptr error;
+        try
+        {
+            entry.job();
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS("Audio file job failed. (" << entry.key << ") " << e.what()));
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeJobs.erase(entry.key);
+            --runningJobs;
+            if (queue.empty() && runningJobs == 0)
+            {
+                idleCv.notify_all();
+            }
+        }
+        if (error)
+        {
+            entry.promise->set_exception(error);
+        }
+        else
+        {
+            entry.promise->set_value();
+        }
+    }
+}
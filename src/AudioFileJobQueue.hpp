@@ -0,0 +1,106 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+
+    /**
+     * @brief A bounded queue of background audio file jobs (ffprobe metadata scans, ffmpeg thumbnails).
+     *
+     * Jobs run on a small fixed set of worker threads at background CPU and idle I/O priority,
+     * which the ffmpeg/ffprobe child processes inherit. Jobs are keyed, so that a job that is
+     * already queued or running is not queued a second time; callers that post a duplicate key
+     * get the future of the existing job.
+     */
+    class AudioFileJobQueue
+    {
+    public:
+        using ptr = std::shared_ptr<AudioFileJobQueue>;
+        using Job = std::function<void()>;
+
+        static constexpr size_t DEFAULT_THREADS = 2;
+        static constexpr size_t DEFAULT_MAX_PENDING_JOBS = 1024;
+
+        AudioFileJobQueue(size_t threads = DEFAULT_THREADS, size_t maxPendingJobs = DEFAULT_MAX_PENDING_JOBS);
+        ~AudioFileJobQueue();
+
+        AudioFileJobQueue(const AudioFileJobQueue &) = delete;
+        AudioFileJobQueue &operator=(const AudioFileJobQueue &) = delete;
+
+        static ptr Create(size_t threads = DEFAULT_THREADS, size_t maxPendingJobs = DEFAULT_MAX_PENDING_JOBS)
+        {
+            return std::make_shared<AudioFileJobQueue>(threads, maxPendingJobs);
+        }
+
+        /**
+         * @brief Post a job.
+         *
+         * @param key Identifies the job. If a job with the same key is queued or running, the job is discarded.
+         * @param job The job. Exceptions thrown by the job are logged, and propagated through the returned future.
+         * @return A future that completes when the job (or the existing job with the same key) completes,
+         *         or an invalid future if the queue is full or closed.
+         */
+        std::shared_future<void> Post(const std::string &key, Job &&job);
+
+        // Discard queued jobs, and wait for running jobs to complete.
+        void Close();
+
+        size_t GetPendingJobCount();
+
+        // Wait until there are no queued or running jobs. Test use only.
+        void WaitForIdle();
+
+        // True if the current thread is one of the queue's worker threads.
+        static bool IsJobThread();
+
+    private:
+        struct Entry
+        {
+            std::string key;
+            Job job;
+            std::shared_ptr<std::promise<void>> promise;
+        };
+        void ThreadProc();
+
+        size_t maxPendingJobs;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable idleCv;
+        bool closing = false;
+        size_t runningJobs = 0;
+        std::deque<Entry> queue;
+        std::map<std::string, std::shared_future<void>> activeJobs; // queued or running, by key.
+        std::vector<std::thread> threads;
+    };
+}
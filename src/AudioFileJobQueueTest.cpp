@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "AudioFileJobQueue.hpp"
+#include <atomic>
+#include <stdexcept>
+
+using namespace pipedal;
+using namespace std;
+
+TEST_CASE("AudioFileJobQueue", "[audio_file_job_queue][Build][Dev]")
+{
+    SECTION("runs jobs on job threads")
+    {
+        AudioFileJobQueue queue(2);
+        std::atomic<int> count{0};
+        std::atomic<bool> allOnJobThreads{true};
+        std::vector<std::shared_future<void>> futures;
+        for (int i = 0; i < 20; ++i)
+        {
+            futures.push_back(queue.Post(
+                SS("job" << i),
+                [&]()
+                {
+                    if (!AudioFileJobQueue::IsJobThread())
+                    {
+                        allOnJobThreads = false;
+                    }
+                    ++count;
+                }));
+        }
+        for (auto &f : futures)
+        {
+            REQUIRE(f.valid());
+            f.wait();
+        }
+        REQUIRE(count == 20);
+        REQUIRE(allOnJobThreads);
+        REQUIRE(!AudioFileJobQueue::IsJobThread());
+        queue.WaitForIdle();
+        REQUIRE(queue.GetPendingJobCount() == 0);
+    }
+    SECTION("duplicate keys and a full queue")
+    {
+        AudioFileJobQueue queue(1, 2);
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::atomic<int> count{0};
+
+        auto blocker = queue.Post("blocker", [released]()
+                                  { released.wait(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // let the worker take the blocking job.
+
+        auto a = queue.Post("a", [&]()
+                            { ++count; });
+        auto aAgain = queue.Post("a", [&]()
+                                 { count += 100; });
+        auto b = queue.Post("b", [&]()
+                            { ++count; });
+        auto c = queue.Post("c", [&]()
+                            { ++count; });
+        REQUIRE(a.valid());
+        REQUIRE(aAgain.valid());
+        REQUIRE(b.valid());
+        REQUIRE(!c.valid()); // queue full.
+
+        release.set_value();
+        aAgain.wait();
+        b.wait();
+        REQUIRE(count == 2);
+    }
+    SECTION("exceptions are propagated")
+    {
+        AudioFileJobQueue queue(1);
+        auto f = queue.Post("throws", []()
+                            { throw std::runtime_error("expected"); });
+        REQUIRE_THROWS(f.get());
+        queue.Close();
+        REQUIRE(!queue.Post("closed", []() {}).valid());
+    }
+}
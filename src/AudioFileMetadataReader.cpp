@@ -30,6 +30,8 @@
 #include <sstream>
 #include <stdexcept>
 #include "TemporaryFile.hpp"
+#include "NativeAudioMetadataReader.hpp"
+#include "AudioPeaks.hpp"
 
 using namespace pipedal;
 namespace fs = std::filesystem;
@@ -161,6 +163,22 @@ static int32_t MetadataTrackToInt(const std::string &track, const std::string &d
 
 AudioFileMetadata::AudioFileMetadata(const std::filesystem::path &file)
 {
+    NativeAudioMetadata nativeMetadata;
+    if (ReadNativeAudioMetadata(file, &nativeMetadata))
+    {
+        // common formats are parsed in-process, which avoids the cost of starting ffprobe.
+        this->duration_ = nativeMetadata.duration;
+        this->album_ = nativeMetadata.album;
+        this->artist_ = nativeMetadata.artist;
+        this->albumArtist_ = nativeMetadata.albumArtist;
+        this->title_ = nativeMetadata.title;
+        this->track_ = MetadataTrackToInt(nativeMetadata.track, nativeMetadata.disc);
+        if (title_ == "")
+        {
+            this->title_ = file.stem();
+        }
+        return;
+    }
     try
     {
         const std::string json = GetJsonMetadata(file);
@@ -274,28 +292,30 @@ TemporaryFile pipedal::GetAudioFileThumbnail(const std::filesystem::path &path,
     return GetAudioFileThumbnail(path, 0, 0, outputPath);
 }
 
-std::mutex thumbnailMutex;
-
 TemporaryFile pipedal::GetAudioFileThumbnail(const std::filesystem::path &path, int32_t width, int32_t height, const std::filesystem::path &tempDirectory)
 {
-    std::lock_guard<std::mutex> lock(thumbnailMutex);
-    fs::path thumbnailDirectory = tempDirectory / "thumbnails";
-    if (!fs::exists(thumbnailDirectory))
+    NativeAudioMetadata nativeMetadata;
+    if (ReadNativeAudioMetadata(path, &nativeMetadata) && nativeMetadata.embeddedArtwork == EmbeddedArtwork::Absent)
     {
-        fs::create_directories(thumbnailDirectory);
-    } else {
-        // Clean up old thumbnails
-        for (const auto &entry : fs::directory_iterator(thumbnailDirectory))
-        {
-            if (entry.is_regular_file()) 
-            {
-                fs::remove(entry.path());
-            }
-        }
+        // don't bother starting ffmpeg.
+        throw std::runtime_error("Thumbnail not foud.");
     }
     fs::create_directories(tempDirectory);
-
     TemporaryFile tempFile(tempDirectory);
+
+    // a private output directory, so that thumbnails can be generated concurrently.
+    fs::path thumbnailDirectory = tempDirectory / ("thumbnails-" + tempFile.Path().stem().string());
+    fs::create_directories(thumbnailDirectory);
+    struct DirectoryCleanup
+    {
+        fs::path path;
+        ~DirectoryCleanup()
+        {
+            std::error_code ec;
+            fs::remove_all(path, ec);
+        }
+    } directoryCleanup{thumbnailDirectory};
+
     std::filesystem::path outputPath = thumbnailDirectory / "thumbnail-%03d.jpg";
     // ffmpeg -loglevel error -i "test2.mp3"  -vf scale=200:200  -frames:v 1 thumb-%03.jpg -y
 
@@ -320,10 +340,9 @@ TemporaryFile pipedal::GetAudioFileThumbnail(const std::filesystem::path &path,
     if (exitCode != EXIT_SUCCESS)
     {        throw std::runtime_error("Thumbnail not foud.");
     }
-    fs::remove(tempFile.Path());
     if (fs::exists(thumbnailDirectory / "thumbnail-001.jpg"))
     {
-        // Move the thumbnail to the temporary file.
+        // Move the thumbnail over the (reserved) temporary file.
         fs::rename(thumbnailDirectory / "thumbnail-001.jpg", tempFile.Path());
     }
     else
@@ -333,3 +352,53 @@ TemporaryFile pipedal::GetAudioFileThumbnail(const std::filesystem::path &path,
     return tempFile;
 }
 
+std::vector<uint8_t> pipedal::GetAudioFilePeaks(const std::filesystem::path &path)
+{
+    // ffmpeg -loglevel error -i "test2.mp3" -vn -ac 1 -ar 48000 -f f32le -
+    std::stringstream ss;
+    ss << "/usr/bin/ffmpeg -loglevel error -i " << shell_escape_filename(path.string())
+       << " -vn -ac 1 -ar " << AudioPeaks::DEFAULT_SAMPLE_RATE << " -f f32le - 2>/dev/null";
+    std::string command = ss.str();
+    FILE *output = popen(command.c_str(), "r");
+    if (output == nullptr)
+    {
+        throw std::runtime_error("Failed to execute ffmpeg command: " + command);
+    }
+    AudioPeaks peaks(AudioPeaks::DEFAULT_SAMPLE_RATE);
+    std::vector<float> buffer(16 * 1024);
+    while (true)
+    {
+        size_t nRead = fread(buffer.data(), sizeof(float), buffer.size(), output);
+        if (nRead == 0)
+        {
+            break;
+        }
+        peaks.AddSamples(buffer.data(), nRead);
+    }
+    int retcode = pclose(output);
+    if (retcode != 0 || peaks.FrameCount() == 0)
+    {
+        throw std::runtime_error("Can't decode audio file.");
+    }
+    peaks.Finish();
+    return peaks.Serialize();
+}
+
+void pipedal::DecodeAudioFile(const std::filesystem::path &path, const std::filesystem::path &outputPath)
+{
+    // ffmpeg -loglevel error -i "test2.mp3" -vn -c:a flac -f flac output.flac -y
+    std::stringstream ss;
+    ss << "/usr/bin/ffmpeg -loglevel error -i " << shell_escape_filename(path.string())
+       << " -vn -c:a flac -f flac " << shell_escape_filename(outputPath.string())
+       << " -y 2>/dev/null 1>/dev/null";
+    std::string command = ss.str();
+    int rc = system(command.c_str());
+    if (rc < 0)
+    {
+        throw std::runtime_error("Failed to execute ffmpeg command: " + command);
+    }
+    if (WEXITSTATUS(rc) != EXIT_SUCCESS || !fs::exists(outputPath))
+    {
+        throw std::runtime_error("Can't decode audio file.");
+    }
+}
@@ -25,6 +25,8 @@
 
 #include <string>
 #include <filesystem>
+#include <vector>
+#include <cstdint>
 #include "TemporaryFile.hpp"
 #include "AudioFileMetadata.hpp"
 
@@ -35,6 +37,12 @@ namespace pipedal
     TemporaryFile GetAudioFileThumbnail(const std::filesystem::path &path, int32_t width, int32_t height, const std::filesystem::path &tempDirectory);
     TemporaryFile GetAudioFileThumbnail(const std::filesystem::path &path, const std::filesystem::path &tempDirectory);
 
+    // Decode the file with ffmpeg, and return its serialized AudioPeaks.
+    std::vector<uint8_t> GetAudioFilePeaks(const std::filesystem::path &path);
+
+    // Decode the file with ffmpeg to a FLAC file.
+    void DecodeAudioFile(const std::filesystem::path &path, const std::filesystem::path &outputPath);
+
     std::string GetAudioFileMetadataString(const std::filesystem::path &path);
 
     
@@ -27,13 +27,21 @@
 #include <stdexcept>
 #include "AudioFileMetadataReader.hpp"
 #include "Locale.hpp"
+#include "PagedListing.hpp"
 #include "MimeTypes.hpp"
 #include <stdexcept>
 #include "AudioFilesDb.hpp"
+#include "AudioFileJobQueue.hpp"
+#include "ThumbnailCache.hpp"
 #include "Lv2Log.hpp"
 #include "ss.hpp"
 #include "util.hpp"
 #include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
 
 #undef _GLIBCXX_DEBUG // Ensure we are not in debug mode, as this file is not compatible with it.
 #include "SQLiteCpp/SQLiteCpp.h"
@@ -107,6 +115,38 @@ std::filesystem::path AudioDirectoryInfo::GetResourceDirectory()
 
 std::filesystem::path AudioDirectoryInfo::temporaryDirectory;
 std::filesystem::path AudioDirectoryInfo::resourceDirectory;
+std::shared_ptr<AudioFileJobQueue> AudioDirectoryInfo::jobQueue;
+AudioDirectoryInfo::DirectoryUpdatedCallback AudioDirectoryInfo::onDirectoryUpdated;
+std::shared_ptr<ThumbnailCache> AudioDirectoryInfo::thumbnailCache;
+std::shared_ptr<ThumbnailCache> AudioDirectoryInfo::decodedAudioCache;
+
+void AudioDirectoryInfo::SetJobQueue(std::shared_ptr<AudioFileJobQueue> jobQueue, DirectoryUpdatedCallback &&onDirectoryUpdated)
+{
+    AudioDirectoryInfo::jobQueue = jobQueue;
+    AudioDirectoryInfo::onDirectoryUpdated = std::move(onDirectoryUpdated);
+}
+
+void AudioDirectoryInfo::SetThumbnailCache(std::shared_ptr<ThumbnailCache> thumbnailCache)
+{
+    AudioDirectoryInfo::thumbnailCache = thumbnailCache;
+}
+
+void AudioDirectoryInfo::SetDecodedAudioCache(std::shared_ptr<ThumbnailCache> decodedAudioCache)
+{
+    AudioDirectoryInfo::decodedAudioCache = decodedAudioCache;
+}
+
+bool AudioDirectoryInfo::IsCompressedAudioFile(const std::filesystem::path &file)
+{
+    static const std::set<std::string> compressedExtensions = {
+        ".mp3", ".m4a", ".aac", ".ogg", ".oga", ".opus", ".wma"};
+    std::string extension = file.extension().string();
+    for (char &c : extension)
+    {
+        c = (char)std::tolower((unsigned char)c);
+    }
+    return compressedExtensions.contains(extension);
+}
 
 namespace
 {
@@ -118,6 +158,69 @@ namespace
         auto result = std::chrono::duration_cast<std::chrono::milliseconds>(sctp.time_since_epoch()).count();
         return result;
     }
+    // Metadata jobs that are pending for each directory, so that clients can be notified
+    // when the directory's metadata has been updated.
+    struct DirectoryJobs
+    {
+        std::set<std::string> pendingKeys;
+        std::chrono::steady_clock::time_point lastNotification;
+    };
+    static constexpr std::chrono::seconds DIRECTORY_NOTIFICATION_INTERVAL{2};
+    static std::mutex directoryJobsMutex;
+    static std::map<fs::path, DirectoryJobs> directoryJobs;
+
+    static void AddDirectoryJob(const fs::path &directory, const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(directoryJobsMutex);
+        auto &jobs = directoryJobs[directory];
+        if (jobs.pendingKeys.empty())
+        {
+            jobs.lastNotification = std::chrono::steady_clock::now();
+        }
+        jobs.pendingKeys.insert(key);
+    }
+    // Returns true if clients should be notified: all of the directory's jobs have completed, or
+    // they haven't been notified for a while.
+    static bool CompleteDirectoryJob(const fs::path &directory, const std::string &key)
+    {
+        std::lock_guard<std::mutex> lock(directoryJobsMutex);
+        auto f = directoryJobs.find(directory);
+        if (f == directoryJobs.end())
+        {
+            return false;
+        }
+        f->second.pendingKeys.erase(key);
+        if (f->second.pendingKeys.empty())
+        {
+            directoryJobs.erase(f);
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - f->second.lastNotification >= DIRECTORY_NOTIFICATION_INTERVAL)
+        {
+            f->second.lastNotification = now;
+            return true;
+        }
+        return false;
+    }
+
+    // A directory's last-modified time is only trusted for skipping rescans once it is older
+    // than this. Timestamps are coarse, so a file added shortly after a scan could otherwise
+    // leave the directory with the same last-modified time as the scan saw.
+    static constexpr int64_t TRUSTED_DIRECTORY_TIME_MS = 2000;
+
+    static int64_t TrustedDirectoryLastModified(int64_t directoryLastModified)
+    {
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+        if (now - directoryLastModified < TRUSTED_DIRECTORY_TIME_MS)
+        {
+            return 0;
+        }
+        return directoryLastModified;
+    }
+
     static int64_t GetLastWriteTime(const fs::path &file)
     {
         try
@@ -145,7 +248,14 @@ namespace
         virtual ~AudioDirectoryInfoImpl() {}
 
         virtual std::vector<AudioFileMetadata> GetFiles() override;
-        virtual ThumbnailTemporaryFile GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height) override;
+        virtual ThumbnailTemporaryFile GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height) override
+        {
+            return GetThumbnail(fileNameOnly, width, height, true);
+        }
+        virtual std::vector<uint8_t> GetPeaks(const std::string &fileNameOnly) override
+        {
+            return GetPeaks(fileNameOnly, true);
+        }
 
         virtual size_t TestGetNumberOfThumbnails() override; // test use only.
         virtual void TestSetIndexPath(const std::filesystem::path &path) override
@@ -187,11 +297,41 @@ namespace
 
         void DbDeleteFile(DbFileInfo *dbFile);
         void UpdateMetadata(DbFileInfo *dbFile);
+        static void ApplyMetadata(DbFileInfo *dbFile, const AudioFileMetadata &metadata, int64_t lastModified);
+
+        ThumbnailTemporaryFile GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height, bool useJobQueue);
+        std::vector<uint8_t> GetPeaks(const std::string &fileNameOnly, bool useJobQueue);
+        bool UseJobQueue() const { return jobQueue && !AudioFileJobQueue::IsJobThread(); }
+        // Placeholder metadata for a file whose metadata will be read by a background job.
+        void SetPlaceholderMetadata(DbFileInfo *dbFile);
+        void PostMetadataJob(const std::string &fileName);
+        std::shared_future<void> PostThumbnailJob(const std::string &fileName, int32_t width, int32_t height);
+        std::shared_future<void> PostPeaksJob(const std::string &fileName);
+        void PostDecodeJob(const std::string &fileName);
+        void RefreshMetadata(const std::string &fileName);
+        void PostThumbnailPrefetchJobs(const std::vector<DbFileInfo> &dbFiles);
+        // true if the directory hasn't changed since the index was last updated.
+        bool IsIndexCurrent(const std::vector<DbFileInfo> &dbFiles, int64_t directoryLastModified);
         static constexpr int DB_VERSION = 1;
         std::filesystem::path GetFolderFile() const;
     };
 }
 
+std::filesystem::path AudioDirectoryInfo::GetDecodedAudioFile(const std::filesystem::path &file)
+{
+    auto cache = decodedAudioCache;
+    if (!cache || !IsCompressedAudioFile(file))
+    {
+        return fs::path();
+    }
+    std::error_code ec;
+    if (!fs::exists(file, ec))
+    {
+        return fs::path();
+    }
+    return cache->Get(ThumbnailCache::MakeKey(file, GetLastWriteTime(file)));
+}
+
 AudioDirectoryInfo::Ptr AudioDirectoryInfo::Create(const std::filesystem::path &path, const std::filesystem::path &indexPath)
 {
     return std::make_shared<AudioDirectoryInfoImpl>(path, indexPath);
@@ -250,16 +390,175 @@ static int DefaultedSortOrder(int track)
     return track;
 }
 
+AudioFileSortKey pipedal::ParseAudioFileSortKey(const std::string &sortKey)
+{
+    static const std::map<std::string, AudioFileSortKey> sortKeys{
+        {"", AudioFileSortKey::Position},
+        {"position", AudioFileSortKey::Position},
+        {"title", AudioFileSortKey::Title},
+        {"artist", AudioFileSortKey::Artist},
+        {"album", AudioFileSortKey::Album},
+        {"duration", AudioFileSortKey::Duration},
+        {"fileName", AudioFileSortKey::FileName},
+    };
+    auto f = sortKeys.find(sortKey);
+    if (f == sortKeys.end())
+    {
+        throw std::invalid_argument(SS("Invalid sort key: " << sortKey));
+    }
+    return f->second;
+}
+
+const char *pipedal::ToString(AudioFileSortKey sortKey)
+{
+    switch (sortKey)
+    {
+    case AudioFileSortKey::Position:
+    default:
+        return "position";
+    case AudioFileSortKey::Title:
+        return "title";
+    case AudioFileSortKey::Artist:
+        return "artist";
+    case AudioFileSortKey::Album:
+        return "album";
+    case AudioFileSortKey::Duration:
+        return "duration";
+    case AudioFileSortKey::FileName:
+        return "fileName";
+    }
+}
+
+void AudioDirectoryInfo::SortFiles(std::vector<AudioFileMetadata> &files, AudioFileSortKey sortKey)
+{
+    if (sortKey == AudioFileSortKey::Position)
+    {
+        return;
+    }
+    // one collation key per file, rather than a full collation per comparison.
+    std::vector<std::string> texts;
+    std::vector<std::string> keys;
+    if (sortKey != AudioFileSortKey::Duration)
+    {
+        Collator::ptr collator = Locale::GetInstance()->GetCollator();
+        texts.reserve(files.size());
+        keys.reserve(files.size());
+        for (const auto &file : files)
+        {
+            switch (sortKey)
+            {
+            case AudioFileSortKey::Title:
+                texts.push_back(file.title());
+                break;
+            case AudioFileSortKey::Artist:
+                texts.push_back(file.artist());
+                break;
+            case AudioFileSortKey::Album:
+                texts.push_back(file.album());
+                break;
+            default:
+                texts.push_back(file.fileName());
+                break;
+            }
+            keys.push_back(collator->GetSortKey(texts.back()));
+        }
+    }
+    auto compareStrings = [&texts, &keys](size_t a, size_t b)
+    {
+        if (texts[a].empty() != texts[b].empty())
+        {
+            return texts[a].empty() ? 1 : -1; // missing values last.
+        }
+        return keys[a].compare(keys[b]);
+    };
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+    // stable, so that ties stay in play order.
+    std::stable_sort(
+        order.begin(), order.end(),
+        [sortKey, &files, &compareStrings](size_t ia, size_t ib)
+        {
+            const AudioFileMetadata &a = files[ia];
+            const AudioFileMetadata &b = files[ib];
+            bool aIsArtwork = isArtworkFileName(a.fileName());
+            bool bIsArtwork = isArtworkFileName(b.fileName());
+            if (aIsArtwork != bIsArtwork)
+            {
+                return aIsArtwork < bIsArtwork;
+            }
+            switch (sortKey)
+            {
+            case AudioFileSortKey::Album:
+            {
+                int result = compareStrings(ia, ib);
+                if (result != 0)
+                {
+                    return result < 0;
+                }
+                return DefaultedSortOrder(a.track()) < DefaultedSortOrder(b.track());
+            }
+            case AudioFileSortKey::Duration:
+                return a.duration() < b.duration();
+            default:
+                return compareStrings(ia, ib) < 0;
+            }
+        });
+    std::vector<AudioFileMetadata> sorted;
+    sorted.reserve(files.size());
+    for (size_t i : order)
+    {
+        sorted.push_back(std::move(files[i]));
+    }
+    files = std::move(sorted);
+}
+
+AudioFilePage AudioDirectoryInfo::GetFilesPage(AudioFileSortKey sortKey, size_t pageSize, const std::string &continuationToken)
+{
+    AudioFilePage result;
+    result.files = GetFiles();
+    result.totalFiles = result.files.size();
+    SortFiles(result.files, sortKey);
+    result.continuationToken = paged_listing::SelectPage(
+        result.files, ToString(sortKey), pageSize, continuationToken,
+        [](const AudioFileMetadata &file)
+        { return file.fileName(); });
+    return result;
+}
+
 static bool isFolderArtwork(const std::string &name)
 {
     return name.ends_with(".jpg") || name.ends_with(".png");
 }
 
-static void SortDbFiles(std::vector<DbFileInfo> &dbFiles, Collator::ptr &collator)
+// Fills in missing title sort keys, or regenerates all of them if they were generated by a different
+// collator. Returns true if any keys changed.
+static bool UpdateTitleSortKeys(std::vector<DbFileInfo> &dbFiles, Collator &collator, bool keysCurrent)
+{
+    bool changed = false;
+    for (auto &dbFile : dbFiles)
+    {
+        if (!keysCurrent || dbFile.titleSortKey().empty())
+        {
+            std::string key = collator.GetSortKey(dbFile.title());
+            if (key != dbFile.titleSortKey())
+            {
+                dbFile.titleSortKey(key);
+                dbFile.dirty(true);
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+static void SortDbFiles(std::vector<DbFileInfo> &dbFiles)
 {
     std::sort(
         dbFiles.begin(), dbFiles.end(),
-        [collator](const DbFileInfo &a, const DbFileInfo &b)
+        [](const DbFileInfo &a, const DbFileInfo &b)
         {
             if (isFolderArtwork(a.fileName()) != isFolderArtwork(b.fileName()))
             {
@@ -273,16 +572,7 @@ static void SortDbFiles(std::vector<DbFileInfo> &dbFiles, Collator::ptr &collato
             {
                 return DefaultedSortOrder(a.track()) < DefaultedSortOrder(b.track());
             }
-            if (a.title() != b.title())
-            {
-                return collator->Compare(a.title(), b.title()) < 0;
-            }
-            if (a.album() != b.album())
-            {
-                return collator->Compare(a.title(), b.title()) < 0;
-            }
-            return false;
-            ;
+            return a.titleSortKey() < b.titleSortKey();
         });
 }
 
@@ -293,8 +583,40 @@ std::vector<DbFileInfo> AudioDirectoryInfoImpl::UpdateDbFiles()
     {
         transaction = audioFilesDb->transaction();
     }
+    // read before scanning, so that changes made during the scan force a rescan next time.
+    int64_t directoryLastModified = GetLastWriteTime(path);
     std::vector<DbFileInfo> dbFiles = QueryTracks();
+    bool deferMetadata = UseJobQueue() && audioFilesDb;
+    Collator::ptr collator = Locale::GetInstance()->GetCollator();
+    bool sortKeysCurrent = audioFilesDb && audioFilesDb->GetSortKeyVersion() == collator->GetSortKeyVersion();
+    if (IsIndexCurrent(dbFiles, directoryLastModified))
+    {
+        if (UpdateTitleSortKeys(dbFiles, *collator, sortKeysCurrent))
+        {
+            for (auto &dbFile : dbFiles)
+            {
+                if (dbFile.dirty())
+                {
+                    audioFilesDb->WriteFile(&dbFile);
+                    dbFile.dirty(false);
+                }
+            }
+        }
+        if (!sortKeysCurrent)
+        {
+            audioFilesDb->SetSortKeyVersion(collator->GetSortKeyVersion());
+        }
+        transaction->commit();
+        transaction = nullptr;
+        SortDbFiles(dbFiles);
+        if (deferMetadata)
+        {
+            PostThumbnailPrefetchJobs(dbFiles);
+        }
+        return dbFiles;
+    }
     std::vector<DbFileInfo> newFiles;
+    std::vector<std::string> deferredFiles;
 
     bool updateRequired = false;
     std::map<std::string, DbFileInfo *> nameToDbRecord;
@@ -334,22 +656,50 @@ std::vector<DbFileInfo> AudioDirectoryInfoImpl::UpdateDbFiles()
             }
             {
                 int64_t lastModified = fileTimeToInt64(dirEntry.last_write_time());
+                struct stat st;
+                uint64_t inode = 0;
+                int64_t fileSize = 0;
+                if (stat(path.c_str(), &st) == 0)
+                {
+                    inode = (uint64_t)st.st_ino;
+                    fileSize = (int64_t)st.st_size;
+                }
 
                 auto f = nameToDbRecord.find(name);
                 if (f != nameToDbRecord.end())
                 {
                     DbFileInfo *dbFile = f->second;
                     dbFile->present(true);
-                    if (dbFile->lastModified() != lastModified)
+                    // a file replaced by one with a preserved timestamp (cp -p, rsync -t) still has a new inode or size.
+                    bool fileChanged = dbFile->lastModified() != lastModified ||
+                                       (dbFile->inode() != 0 && (dbFile->inode() != inode || dbFile->fileSize() != fileSize));
+                    if (dbFile->inode() != inode || dbFile->fileSize() != fileSize)
+                    {
+                        dbFile->inode(inode);
+                        dbFile->fileSize(fileSize);
+                        dbFile->dirty(true);
+                        updateRequired = true;
+                    }
+                    if (fileChanged)
                     {
                         if (audioFilesDb)
                         {
                             audioFilesDb->DeleteThumbnails(dbFile->idFile());
+                            audioFilesDb->DeletePeaks(dbFile->idFile());
                         }
                         dbFile->thumbnailType(ThumbnailType::Unknown);
                         dbFile->thumbnailFile("");
                         dbFile->thumbnailLastModified(0);
-                        UpdateMetadata(dbFile);
+                        if (deferMetadata)
+                        {
+                            // keep the old metadata until the job has read the new metadata.
+                            dbFile->lastModified(0);
+                            deferredFiles.push_back(name);
+                        }
+                        else
+                        {
+                            UpdateMetadata(dbFile);
+                        }
                         dbFile->dirty(true);
                         updateRequired = true;
                     }
@@ -361,7 +711,17 @@ std::vector<DbFileInfo> AudioDirectoryInfoImpl::UpdateDbFiles()
                     newFile.idFile(-1);
                     newFile.dirty(true);
                     newFile.present(true);
-                    UpdateMetadata(&newFile);
+                    newFile.inode(inode);
+                    newFile.fileSize(fileSize);
+                    if (deferMetadata)
+                    {
+                        SetPlaceholderMetadata(&newFile);
+                        deferredFiles.push_back(name);
+                    }
+                    else
+                    {
+                        UpdateMetadata(&newFile);
+                    }
                     newFiles.push_back(std::move(newFile));
                     updateRequired = true;
                 }
@@ -427,18 +787,16 @@ std::vector<DbFileInfo> AudioDirectoryInfoImpl::UpdateDbFiles()
         }
     }
 
-    Locale::ptr locale = Locale::GetInstance();
-    Collator::ptr collator = locale->GetCollator();
-    if (!HasPositionInfo(dbFiles))
+    bool hasPositionInfo = HasPositionInfo(dbFiles);
+    dbFiles.insert(dbFiles.end(), newFiles.begin(), newFiles.end());
+    if (UpdateTitleSortKeys(dbFiles, *collator, sortKeysCurrent))
     {
-        dbFiles.insert(dbFiles.end(), newFiles.begin(), newFiles.end());
-        SortDbFiles(dbFiles, collator);
+        updateRequired = true;
     }
-    else
+    SortDbFiles(dbFiles);
+    if (hasPositionInfo)
     {
         // We have position info, so we need to update the position.
-        dbFiles.insert(dbFiles.end(), newFiles.begin(), newFiles.end());
-        SortDbFiles(dbFiles, collator);
 
         for (size_t i = 0; i < dbFiles.size(); ++i)
         {
@@ -461,14 +819,68 @@ std::vector<DbFileInfo> AudioDirectoryInfoImpl::UpdateDbFiles()
             dbFile.dirty(false);
         }
     }
+    if (audioFilesDb)
+    {
+        int64_t trustedLastModified = TrustedDirectoryLastModified(directoryLastModified);
+        if (trustedLastModified != audioFilesDb->GetDirectoryLastModified())
+        {
+            audioFilesDb->SetDirectoryLastModified(trustedLastModified);
+        }
+        if (!sortKeysCurrent)
+        {
+            audioFilesDb->SetSortKeyVersion(collator->GetSortKeyVersion());
+        }
+    }
     if (transaction)
     {
         transaction->commit();
         transaction = nullptr;
     }
+    if (deferMetadata)
+    {
+        // in play order, so that the metadata for the first page of a listing arrives first.
+        std::set<std::string> deferred{deferredFiles.begin(), deferredFiles.end()};
+        for (const auto &dbFile : dbFiles)
+        {
+            if (deferred.contains(dbFile.fileName()))
+            {
+                PostMetadataJob(dbFile.fileName());
+            }
+        }
+        PostThumbnailPrefetchJobs(dbFiles);
+    }
     return dbFiles;
 }
 
+bool AudioDirectoryInfoImpl::IsIndexCurrent(const std::vector<DbFileInfo> &dbFiles, int64_t directoryLastModified)
+{
+    if (!audioFilesDb || directoryLastModified == 0 ||
+        audioFilesDb->GetDirectoryLastModified() != directoryLastModified)
+    {
+        return false;
+    }
+    for (const auto &dbFile : dbFiles)
+    {
+        if (dbFile.lastModified() == 0)
+        {
+            // metadata never got read (e.g. the job queue was full). Rescan to retry.
+            return false;
+        }
+    }
+    return true;
+}
+
+void AudioDirectoryInfoImpl::PostThumbnailPrefetchJobs(const std::vector<DbFileInfo> &dbFiles)
+{
+    for (const auto &dbFile : dbFiles)
+    {
+        if (dbFile.thumbnailType() == ThumbnailType::Unknown && dbFile.lastModified() != 0)
+        {
+            PostThumbnailJob(dbFile.fileName(), PREFETCH_THUMBNAIL_SIZE, PREFETCH_THUMBNAIL_SIZE);
+        }
+    }
+}
+
 void AudioDirectoryInfoImpl::DbDeleteFile(DbFileInfo *dbFile)
 {
     if (this->audioFilesDb)
@@ -588,9 +1000,22 @@ static ThumbnailTemporaryFile GetFolderTemporaryFile(const fs::path &folderFile)
     result.SetNonDeletedPath(folderFile, MimeTypes::instance().MimeTypeFromExtension(folderFile.extension().string()));
     return result;
 }
-ThumbnailTemporaryFile AudioDirectoryInfoImpl::GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height)
+ThumbnailTemporaryFile AudioDirectoryInfoImpl::GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height, bool useJobQueue)
 {
     fs::path file = this->path / fileNameOnly;
+    std::string cacheKey;
+    if (thumbnailCache)
+    {
+        // only generated thumbnails are cached, so a hit doesn't need the index at all.
+        cacheKey = ThumbnailCache::MakeKey(file, GetLastWriteTime(file), width, height);
+        fs::path cachedFile = thumbnailCache->Get(cacheKey);
+        if (!cachedFile.empty())
+        {
+            ThumbnailTemporaryFile result;
+            result.SetNonDeletedPath(cachedFile, "image/jpeg");
+            return result;
+        }
+    }
     OpenAudioDb();
     if (audioFilesDb)
     {
@@ -610,7 +1035,7 @@ ThumbnailTemporaryFile AudioDirectoryInfoImpl::GetThumbnail(const std::string &f
                     audioFilesDb->UpdateThumbnailInfo(
                         fileNameOnly,
                         ThumbnailType::Unknown);
-                    return GetThumbnail(fileNameOnly, width, height);
+                    return GetThumbnail(fileNameOnly, width, height, useJobQueue);
                 }
                 fs::path fullFolderPath = this->path / thumbnailInfo.thumbnailFile();
                 return GetFolderTemporaryFile(fullFolderPath);
@@ -621,6 +1046,16 @@ ThumbnailTemporaryFile AudioDirectoryInfoImpl::GetThumbnail(const std::string &f
 
                 if (!blob.empty())
                 {
+                    if (thumbnailCache)
+                    {
+                        fs::path cachedFile = thumbnailCache->Put(cacheKey, blob);
+                        if (!cachedFile.empty())
+                        {
+                            ThumbnailTemporaryFile result;
+                            result.SetNonDeletedPath(cachedFile, "image/jpeg");
+                            return result;
+                        }
+                    }
                     ThumbnailTemporaryFile tempFile = ThumbnailTemporaryFile::CreateTemporaryFile(GetTemporaryDirectory(), "image/jpeg");
 
                     tempFile.SetMimeType("image/jpeg");
@@ -644,6 +1079,19 @@ ThumbnailTemporaryFile AudioDirectoryInfoImpl::GetThumbnail(const std::string &f
                 return DefaultThumbnailTemporaryFile();
             }
 
+            if (useJobQueue && UseJobQueue())
+            {
+                // Generate the thumbnail on the (bounded, low-priority) job queue, and serve it from the index.
+                std::shared_future<void> job = PostThumbnailJob(fileNameOnly, width, height);
+                if (job.valid())
+                {
+                    this->audioFilesDb = nullptr; // the job needs the index lock.
+                    job.wait();
+                    OpenAudioDb();
+                    return GetThumbnail(fileNameOnly, width, height, false);
+                }
+            }
+
             try
             {
                 auto tempFile = pipedal::GetAudioFileThumbnail(
@@ -715,14 +1163,216 @@ void AudioDirectoryInfoImpl::UpdateMetadata(DbFileInfo *dbFile)
 {
     fs::path file = this->path / dbFile->fileName();
     AudioFileMetadata metadata(file);
+    ApplyMetadata(dbFile, metadata, GetLastWriteTime(file));
+}
+
+void AudioDirectoryInfoImpl::ApplyMetadata(DbFileInfo *dbFile, const AudioFileMetadata &metadata, int64_t lastModified)
+{
     dbFile->title(metadata.title());
     dbFile->track(metadata.track());
     dbFile->duration(metadata.duration());
     dbFile->album(metadata.album());
     dbFile->artist(metadata.artist());
     dbFile->albumArtist(metadata.albumArtist());
-    dbFile->lastModified(GetLastWriteTime(file));
-    dbFile->duration(metadata.duration());
+    dbFile->titleSortKey(Locale::GetInstance()->GetCollator()->GetSortKey(metadata.title()));
+    dbFile->lastModified(lastModified);
+}
+
+void AudioDirectoryInfoImpl::SetPlaceholderMetadata(DbFileInfo *dbFile)
+{
+    // lastModified stays 0 until the real metadata has been read, so that the next
+    // directory listing retries the scan if the job never completes.
+    AudioFileMetadata metadata;
+    metadata.title(fs::path(dbFile->fileName()).stem().string());
+    ApplyMetadata(dbFile, metadata, 0);
+}
+
+void AudioDirectoryInfoImpl::PostMetadataJob(const std::string &fileName)
+{
+    fs::path directory = this->path;
+    fs::path indexDirectory = this->indexPath.parent_path();
+    std::string key = SS("metadata:" << (directory / fileName).string());
+
+    AddDirectoryJob(directory, key);
+    std::shared_future<void> job = jobQueue->Post(
+        key,
+        [directory, indexDirectory, fileName, key]()
+        {
+            try
+            {
+                auto directoryInfo = std::make_shared<AudioDirectoryInfoImpl>(directory, indexDirectory);
+                directoryInfo->RefreshMetadata(fileName);
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::warning(SS("Can't read audio file metadata. " << (directory / fileName) << " " << e.what()));
+            }
+            if (CompleteDirectoryJob(directory, key) && onDirectoryUpdated)
+            {
+                onDirectoryUpdated(directory);
+            }
+            if (jobQueue)
+            {
+                auto directoryInfo = std::make_shared<AudioDirectoryInfoImpl>(directory, indexDirectory);
+                directoryInfo->PostThumbnailJob(fileName, PREFETCH_THUMBNAIL_SIZE, PREFETCH_THUMBNAIL_SIZE);
+                if (!isArtworkFileName(fileName))
+                {
+                    directoryInfo->PostPeaksJob(fileName);
+                    directoryInfo->PostDecodeJob(fileName);
+                }
+            }
+        });
+    if (!job.valid())
+    {
+        // queue full. The next directory listing will try again.
+        CompleteDirectoryJob(directory, key);
+    }
+}
+
+std::shared_future<void> AudioDirectoryInfoImpl::PostThumbnailJob(const std::string &fileName, int32_t width, int32_t height)
+{
+    fs::path directory = this->path;
+    fs::path indexDirectory = this->indexPath.parent_path();
+    return jobQueue->Post(
+        SS("thumbnail:" << (directory / fileName).string() << "@" << width << "x" << height),
+        [directory, indexDirectory, fileName, width, height]()
+        {
+            auto directoryInfo = std::make_shared<AudioDirectoryInfoImpl>(directory, indexDirectory);
+            // stores the thumbnail in the index.
+            directoryInfo->GetThumbnail(fileName, width, height, false);
+        });
+}
+
+std::shared_future<void> AudioDirectoryInfoImpl::PostPeaksJob(const std::string &fileName)
+{
+    fs::path directory = this->path;
+    fs::path indexDirectory = this->indexPath.parent_path();
+    return jobQueue->Post(
+        SS("peaks:" << (directory / fileName).string()),
+        [directory, indexDirectory, fileName]()
+        {
+            auto directoryInfo = std::make_shared<AudioDirectoryInfoImpl>(directory, indexDirectory);
+            // stores the peaks in the index.
+            directoryInfo->GetPeaks(fileName, false);
+        });
+}
+
+void AudioDirectoryInfoImpl::PostDecodeJob(const std::string &fileName)
+{
+    fs::path file = this->path / fileName;
+    if (!decodedAudioCache || !IsCompressedAudioFile(file))
+    {
+        return;
+    }
+    jobQueue->Post(
+        SS("decode:" << file.string()),
+        [file]()
+        {
+            auto cache = decodedAudioCache;
+            if (!cache || !fs::exists(file))
+            {
+                return;
+            }
+            std::string key = ThumbnailCache::MakeKey(file, GetLastWriteTime(file));
+            if (!cache->Get(key).empty())
+            {
+                return;
+            }
+            fs::path tempPath = cache->GetTemporaryPath();
+            try
+            {
+                DecodeAudioFile(file, tempPath);
+            }
+            catch (const std::exception &e)
+            {
+                std::error_code ec;
+                fs::remove(tempPath, ec);
+                throw;
+            }
+            cache->PutFile(key, tempPath);
+        });
+}
+
+std::vector<uint8_t> AudioDirectoryInfoImpl::GetPeaks(const std::string &fileNameOnly, bool useJobQueue)
+{
+    fs::path file = this->path / fileNameOnly;
+    int64_t lastModified = GetLastWriteTime(file);
+    std::vector<uint8_t> result;
+
+    OpenAudioDb();
+    if (audioFilesDb && audioFilesDb->GetPeaks(fileNameOnly, lastModified, &result))
+    {
+        return result;
+    }
+    if (audioFilesDb && useJobQueue && UseJobQueue())
+    {
+        std::shared_future<void> job = PostPeaksJob(fileNameOnly);
+        if (job.valid())
+        {
+            this->audioFilesDb = nullptr; // the job needs the index lock.
+            job.wait();
+            OpenAudioDb();
+            if (audioFilesDb && audioFilesDb->GetPeaks(fileNameOnly, lastModified, &result))
+            {
+                return result;
+            }
+            throw std::runtime_error("Can't read audio file " + file.string());
+        }
+    }
+
+    // decoding takes a while, so don't hold the index lock while doing it.
+    bool indexed = audioFilesDb != nullptr;
+    this->audioFilesDb = nullptr;
+    result = GetAudioFilePeaks(file);
+    if (indexed)
+    {
+        OpenAudioDb();
+        if (audioFilesDb)
+        {
+            try
+            {
+                audioFilesDb->SetPeaks(fileNameOnly, lastModified, result);
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::warning(SS("Can't save audio file peaks. " << file << " " << e.what()));
+            }
+        }
+    }
+    return result;
+}
+
+void AudioDirectoryInfoImpl::RefreshMetadata(const std::string &fileName)
+{
+    fs::path file = this->path / fileName;
+    if (!fs::exists(file))
+    {
+        return;
+    }
+    int64_t lastModified = GetLastWriteTime(file);
+    // run ffprobe before taking the index lock.
+    AudioFileMetadata metadata(file);
+
+    OpenAudioDb();
+    if (!audioFilesDb)
+    {
+        return;
+    }
+    auto transaction = audioFilesDb->transaction();
+    std::vector<DbFileInfo> dbFiles = QueryTracks();
+    for (auto &dbFile : dbFiles)
+    {
+        if (dbFile.fileName() == fileName)
+        {
+            if (dbFile.lastModified() != lastModified)
+            {
+                ApplyMetadata(&dbFile, metadata, lastModified);
+                audioFilesDb->WriteFile(&dbFile);
+                transaction->commit();
+            }
+            break;
+        }
+    }
 }
 
 ThumbnailTemporaryFile::ThumbnailTemporaryFile(const std::filesystem::path &temporaryDirectory)
@@ -28,11 +28,14 @@
 #include <cstdint>
 #include <vector>
 #include <filesystem>
+#include <functional>
 #include "AudioFileMetadata.hpp"
 #include "TemporaryFile.hpp"
 
 namespace pipedal
 {
+    class AudioFileJobQueue;
+    class ThumbnailCache;
 
     class ThumbnailTemporaryFile : public TemporaryFile
     {
@@ -74,6 +77,28 @@ namespace pipedal
         std::string mimeType = "image/jpeg"; // Default MIME type, can be set later.
     };
 
+    enum class AudioFileSortKey
+    {
+        Position, // the directory's play order.
+        Title,
+        Artist,
+        Album,
+        Duration,
+        FileName
+    };
+    // "position", "title", "artist", "album", "duration" or "fileName". Throws std::invalid_argument.
+    AudioFileSortKey ParseAudioFileSortKey(const std::string &sortKey);
+    const char *ToString(AudioFileSortKey sortKey);
+
+    class AudioFilePage
+    {
+    public:
+        std::vector<AudioFileMetadata> files;
+        size_t totalFiles = 0;
+        // Pass to GetFilesPage() to get the next page. Empty on the last page.
+        std::string continuationToken;
+    };
+
     class AudioDirectoryInfo
     {
     protected:
@@ -90,8 +115,24 @@ namespace pipedal
 
         virtual std::vector<AudioFileMetadata> GetFiles() = 0;
 
+        /**
+         * @brief One page of the directory's files, in the given order.
+         *
+         * Pass an empty continuationToken for the first page, and the previous page's continuationToken
+         * for subsequent pages. Metadata that is still being read by background jobs is placeholder metadata
+         * (see SetJobQueue()); jobs are queued in play order, so the first page's metadata is read first.
+         */
+        AudioFilePage GetFilesPage(AudioFileSortKey sortKey, size_t pageSize, const std::string &continuationToken = "");
+
+        // Sorts files (in play order, as returned by GetFiles()) by the given key. Artwork files stay last.
+        static void SortFiles(std::vector<AudioFileMetadata> &files, AudioFileSortKey sortKey);
+
         virtual ThumbnailTemporaryFile GetThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height) = 0;
 
+        // Serialized AudioPeaks (waveform overview) for the file. Peaks are generated in the background
+        // when metadata is scanned, and stored in the index. Throws if the file can't be decoded.
+        virtual std::vector<uint8_t> GetPeaks(const std::string &fileNameOnly) = 0;
+
         virtual std::string GetNextAudioFile(const std::string &fileNameOnly) = 0;
         virtual std::string GetPreviousAudioFile(const std::string &fileNameOnly) = 0;
 
@@ -104,6 +145,30 @@ namespace pipedal
         static void SetTemporaryDirectory(const std::filesystem::path &path);
         static void SetResourceDirectory(const std::filesystem::path &path);
 
+        using DirectoryUpdatedCallback = std::function<void(const std::filesystem::path &directory)>;
+        /**
+         * @brief Scan metadata and generate thumbnails on a background job queue.
+         *
+         * When set, GetFiles() returns placeholder metadata for new or modified files immediately,
+         * and onDirectoryUpdated is called (on a job thread) as the real metadata is written to the index.
+         * GetThumbnail() generates missing thumbnails on the job queue. When not set (e.g. in tests),
+         * all work is done synchronously.
+         */
+        static void SetJobQueue(std::shared_ptr<AudioFileJobQueue> jobQueue, DirectoryUpdatedCallback &&onDirectoryUpdated);
+
+        // Serve generated thumbnails from a disk cache, instead of copying them out of the index each time. Optional.
+        static void SetThumbnailCache(std::shared_ptr<ThumbnailCache> thumbnailCache);
+
+        // Decode compressed audio files (mp3, m4a, &c) to FLAC on the job queue when they are scanned,
+        // so that plugins don't have to decode them during playback. Optional.
+        static void SetDecodedAudioCache(std::shared_ptr<ThumbnailCache> decodedAudioCache);
+        // The decoded copy of a compressed audio file, or an empty path if there isn't one (yet).
+        static std::filesystem::path GetDecodedAudioFile(const std::filesystem::path &file);
+        static bool IsCompressedAudioFile(const std::filesystem::path &file);
+
+        // The thumbnail size requested by the web client, which is generated ahead of time.
+        static constexpr int32_t PREFETCH_THUMBNAIL_SIZE = 240;
+
         virtual size_t TestGetNumberOfThumbnails() = 0; // test use only.
         virtual void TestSetIndexPath(const std::filesystem::path &path) = 0;
 
@@ -111,6 +176,12 @@ namespace pipedal
         static std::filesystem::path GetTemporaryDirectory();
         static std::filesystem::path GetResourceDirectory();
 
+    protected:
+        static std::shared_ptr<AudioFileJobQueue> jobQueue;
+        static DirectoryUpdatedCallback onDirectoryUpdated;
+        static std::shared_ptr<ThumbnailCache> thumbnailCache;
+        static std::shared_ptr<ThumbnailCache> decodedAudioCache;
+
     private:
         static std::filesystem::path temporaryDirectory;
         static std::filesystem::path resourceDirectory;
@@ -22,6 +22,9 @@
  */
 
 #include "AudioFilesDb.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <sqlite3.h>
 #include <stdexcept>
 #include <atomic>
 #include <mutex>
@@ -97,6 +100,68 @@ namespace pipedal::impl
     };
 }
 
+namespace
+{
+    // Resets a cached statement once its results have been read, so that it doesn't hold
+    // a read transaction (and a stale WAL snapshot) open between calls.
+    class StatementReset
+    {
+    public:
+        StatementReset(SQLite::Statement &statement)
+            : statement(statement)
+        {
+            statement.tryReset();
+        }
+        ~StatementReset()
+        {
+            statement.tryReset();
+        }
+
+    private:
+        SQLite::Statement &statement;
+    };
+
+    static void ConfigureConnection(SQLite::Database &db, const fs::path &path)
+    {
+        // Index files live on SD cards. WAL mode with synchronous=NORMAL only syncs on
+        // checkpoint, instead of twice per transaction; a power failure can lose the last
+        // few transactions, but not corrupt the index, which can be rebuilt anyway.
+        db.setBusyTimeout(5000);
+        try
+        {
+            db.exec("PRAGMA journal_mode=WAL");
+            db.exec("PRAGMA synchronous=NORMAL");
+        }
+        catch (const SQLite::Exception &e)
+        {
+            // e.g. file systems that don't support shared memory. Carry on in rollback-journal mode.
+            Lv2Log::debug(SS("Can't enable WAL mode for " << path << ": " << e.what()));
+        }
+        // Keep the -wal and -shm files when the index is closed. Otherwise creating and deleting
+        // them would change the directory's last-modified time, which we use to skip rescans.
+        int persistWal = 1;
+        sqlite3_file_control(db.getHandle(), "main", SQLITE_FCNTL_PERSIST_WAL, &persistWal);
+    }
+
+    static SQLite::Statement &PrepareStatement(
+        SQLite::Database &db,
+        std::unique_ptr<SQLite::Statement> &statement,
+        const char *sql)
+    {
+        if (!statement)
+        {
+            statement = std::make_unique<SQLite::Statement>(db, sql);
+        }
+        return *statement;
+    }
+}
+
+static const char *PEAKS_TABLE_SQL =
+    "CREATE TABLE IF NOT EXISTS peaks ("
+    "idFile INTEGER PRIMARY KEY, "
+    "lastModified INT64 NOT NULL, "
+    "peaks BLOB NOT NULL)";
+
 static std::unique_ptr<DatabaseLock> getDatabaseLock(const std::filesystem::path &path)
 {
     // Create a lock file in the same directory as the database.
@@ -123,6 +188,7 @@ AudioFilesDb::AudioFilesDb(
     else
     {
         this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE);
+        ConfigureConnection(*db, dbPathName);
         UpgradeDb();
     }
 }
@@ -130,6 +196,73 @@ AudioFilesDb::AudioFilesDb(
 void AudioFilesDb::UpgradeDb()
 {
     int version = QueryVersion();
+    if (version >= DB_VERSION)
+    {
+        return;
+    }
+    try
+    {
+        SQLite::Transaction transaction(*db);
+        if (version < 2)
+        {
+            db->exec("ALTER TABLE am_dbInfo ADD COLUMN directoryLastModified INT64 NOT NULL DEFAULT 0");
+            db->exec("ALTER TABLE files ADD COLUMN inode INT64 NOT NULL DEFAULT 0");
+            db->exec("ALTER TABLE files ADD COLUMN fileSize INT64 NOT NULL DEFAULT 0");
+            db->exec("CREATE INDEX IF NOT EXISTS files_fileName ON files (fileName)");
+            db->exec("CREATE INDEX IF NOT EXISTS thumbnails_idFile ON thumbnails (idFile, width, height)");
+        }
+        if (version < 3)
+        {
+            db->exec("ALTER TABLE am_dbInfo ADD COLUMN sortKeyVersion TEXT NOT NULL DEFAULT \"\"");
+            db->exec("ALTER TABLE files ADD COLUMN titleSortKey BLOB");
+        }
+        if (version < 4)
+        {
+            db->exec(PEAKS_TABLE_SQL);
+        }
+        SQLite::Statement query(*db, "UPDATE am_dbInfo SET version = ?");
+        query.bind(1, DB_VERSION);
+        query.exec();
+        transaction.commit();
+    }
+    catch (const SQLite::Exception &e)
+    {
+        throw std::runtime_error("Failed to upgrade database: " + std::string(e.what()));
+    }
+}
+
+int64_t AudioFilesDb::GetDirectoryLastModified()
+{
+    SQLite::Statement query(*db, "SELECT directoryLastModified FROM am_dbInfo LIMIT 1");
+    if (query.executeStep())
+    {
+        return query.getColumn(0).getInt64();
+    }
+    return 0;
+}
+
+void AudioFilesDb::SetDirectoryLastModified(int64_t value)
+{
+    SQLite::Statement query(*db, "UPDATE am_dbInfo SET directoryLastModified = ?");
+    query.bind(1, value);
+    query.exec();
+}
+
+std::string AudioFilesDb::GetSortKeyVersion()
+{
+    SQLite::Statement query(*db, "SELECT sortKeyVersion FROM am_dbInfo LIMIT 1");
+    if (query.executeStep())
+    {
+        return query.getColumn(0).getText();
+    }
+    return "";
+}
+
+void AudioFilesDb::SetSortKeyVersion(const std::string &value)
+{
+    SQLite::Statement query(*db, "UPDATE am_dbInfo SET sortKeyVersion = ?");
+    query.bind(1, value);
+    query.exec();
 }
 
 int AudioFilesDb::QueryVersion()
@@ -154,12 +287,15 @@ void AudioFilesDb::CreateDb(const std::filesystem::path &dbPathName)
     {
 
         this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        ConfigureConnection(*db, dbPathName);
 
         try
         {
             db->exec("CREATE TABLE am_dbInfo ("
                      "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                     "version INTEGER NOT NULL)");
+                     "version INTEGER NOT NULL, "
+                     "directoryLastModified INT64 NOT NULL DEFAULT 0, "
+                     "sortKeyVersion TEXT NOT NULL DEFAULT \"\")");
 
             {
                 SQLite::Statement query(*db, "INSERT INTO am_dbInfo (version) VALUES (?)");
@@ -182,8 +318,12 @@ void AudioFilesDb::CreateDb(const std::filesystem::path &dbPathName)
                 "thumbnailType INTEGER NOT NULL DEFAULT 0,"
                 "position INTEGER NOT NULL DEFAULT -1,"
                 "thumbnailFile TEXT NOT NULL DEFAULT \"\","
-                "thumbnailLastModified INT64 NOT NULL DEFAULT 0"
+                "thumbnailLastModified INT64 NOT NULL DEFAULT 0,"
+                "inode INT64 NOT NULL DEFAULT 0,"
+                "fileSize INT64 NOT NULL DEFAULT 0,"
+                "titleSortKey BLOB"
                 ")");
+            db->exec("CREATE INDEX IF NOT EXISTS files_fileName ON files (fileName)");
 
             db->exec("CREATE TABLE IF NOT EXISTS thumbnails ("
                      "idThumbnail INTEGER PRIMARY KEY AUTOINCREMENT, "
@@ -191,7 +331,9 @@ void AudioFilesDb::CreateDb(const std::filesystem::path &dbPathName)
                      "thumbnail BLOB, "
                      "width INTEGER, "
                      "height INTEGER)");
+            db->exec("CREATE INDEX IF NOT EXISTS thumbnails_idFile ON thumbnails (idFile, width, height)");
 
+            db->exec(PEAKS_TABLE_SQL);
         }
         catch (const SQLite::Exception &e)
         {
@@ -207,28 +349,19 @@ void AudioFilesDb::CreateDb(const std::filesystem::path &dbPathName)
 void AudioFilesDb::DeleteFile(DbFileInfo *dbFile)
 {
     DeleteThumbnails(dbFile->idFile());
-    if (!deleteFileQuery)
-    {
-        deleteFileQuery = std::make_unique<SQLite::Statement>(
-            *db,
-            "DELETE FROM files WHERE idFile = ?");
-    }
-    deleteFileQuery->tryReset();
-    deleteFileQuery->bind(1, dbFile->idFile());
-    deleteFileQuery->exec();
+    DeletePeaks(dbFile->idFile());
+    auto &query = PrepareStatement(*db, deleteFileQuery, "DELETE FROM files WHERE idFile = ?");
+    StatementReset reset(query);
+    query.bind(1, dbFile->idFile());
+    query.exec();
 }
 
 void AudioFilesDb::DeleteThumbnails(id_t idFile)
 {
-    if (!updateThumbnailInfoQueryByName)
-    {
-        updateThumbnailInfoQueryByName = std::make_unique<SQLite::Statement>(
-            *db,
-            "DELETE FROM thumbnails WHERE idFile = ?");
-    }
-    updateThumbnailInfoQueryByName->tryReset();
-    updateThumbnailInfoQueryByName->bind(1, idFile);
-    updateThumbnailInfoQueryByName->exec();
+    auto &query = PrepareStatement(*db, deleteThumbnailsQuery, "DELETE FROM thumbnails WHERE idFile = ?");
+    StatementReset reset(query);
+    query.bind(1, idFile);
+    query.exec();
 }
 
 size_t AudioFilesDb::GetNumberOfThumbnails()
@@ -247,18 +380,15 @@ void AudioFilesDb::UpdateThumbnailInfo(
     const std::string &thumbnailFile,
     int64_t thumbnailLastModified)
 {
-    if (!updateThumbnailInfoQueryByName)
-    {
-        updateThumbnailInfoQueryByName = std::make_unique<SQLite::Statement>(
-            *db,
-            "UPDATE files SET thumbnailType = ?,thumbnailFile = ?, thumbnailLastModified = ? WHERE fileName = ?");
-    }
-    updateThumbnailInfoQueryByName->tryReset();
-    updateThumbnailInfoQueryByName->bind(1, (int32_t)thumbnailType);
-    updateThumbnailInfoQueryByName->bind(2, thumbnailFile);
-    updateThumbnailInfoQueryByName->bind(3, thumbnailLastModified);
-    updateThumbnailInfoQueryByName->bind(4, fileName);
-    updateThumbnailInfoQueryByName->exec();
+    auto &query = PrepareStatement(
+        *db, updateThumbnailInfoQueryByName,
+        "UPDATE files SET thumbnailType = ?,thumbnailFile = ?, thumbnailLastModified = ? WHERE fileName = ?");
+    StatementReset reset(query);
+    query.bind(1, (int32_t)thumbnailType);
+    query.bind(2, thumbnailFile);
+    query.bind(3, thumbnailLastModified);
+    query.bind(4, fileName);
+    query.exec();
 }
 
 void AudioFilesDb::UpdateThumbnailInfo(
@@ -267,17 +397,15 @@ void AudioFilesDb::UpdateThumbnailInfo(
     const std::string &thumbnailFile,
     int64_t thumbnailLastModified)
 {
-    if (!updateThumbnailInfoQueryById)
-    {
-        updateThumbnailInfoQueryById = std::make_unique<SQLite::Statement>(
-            *db,
-            "UPDATE files SET thumbnailType = ?,thumbnailFile = ?, thumbnailLastModified = ? WHERE idFile = ?");
-    }
-    updateThumbnailInfoQueryById->bind(1, (int32_t)thumbnailType);
-    updateThumbnailInfoQueryById->bind(2, thumbnailFile);
-    updateThumbnailInfoQueryById->bind(3, thumbnailLastModified);
-    updateThumbnailInfoQueryById->bind(4, idFile);
-    updateThumbnailInfoQueryById->exec();
+    auto &query = PrepareStatement(
+        *db, updateThumbnailInfoQueryById,
+        "UPDATE files SET thumbnailType = ?,thumbnailFile = ?, thumbnailLastModified = ? WHERE idFile = ?");
+    StatementReset reset(query);
+    query.bind(1, (int32_t)thumbnailType);
+    query.bind(2, thumbnailFile);
+    query.bind(3, thumbnailLastModified);
+    query.bind(4, idFile);
+    query.exec();
 }
 
 std::unique_ptr<SQLite::Transaction> AudioFilesDb::transaction()
@@ -289,13 +417,15 @@ std::vector<DbFileInfo> AudioFilesDb::QueryTracks()
 {
     std::vector<DbFileInfo> result;
     // get tracks fro the databse.
-    SQLite::Statement query(
-        *db,
+    auto &query = PrepareStatement(
+        *db, queryTracksQuery,
         "SELECT idFile, fileName, "
         "lastModified, title, track, album, artist,albumArtist,duration, "
         "thumbnailType, position, "
-        "thumbnailFile, thumbnailLastModified "
+        "thumbnailFile, thumbnailLastModified, "
+        "inode, fileSize, titleSortKey "
         "FROM files ");
+    StatementReset reset(query);
 
     while (query.executeStep())
     {
@@ -313,6 +443,13 @@ std::vector<DbFileInfo> AudioFilesDb::QueryTracks()
         row.position(query.getColumn(10).getInt());
         row.thumbnailFile(query.getColumn(11).getText());
         row.thumbnailLastModified(query.getColumn(12).getInt64());
+        row.inode((uint64_t)query.getColumn(13).getInt64());
+        row.fileSize(query.getColumn(14).getInt64());
+        SQLite::Column titleSortKey = query.getColumn(15);
+        if (titleSortKey.getBytes() > 0) // NULL for rows written by previous versions.
+        {
+            row.titleSortKey(std::string((const char *)titleSortKey.getBlob(), (size_t)titleSortKey.getBytes()));
+        }
         result.push_back(std::move(row));
     }
     return result;
@@ -329,10 +466,11 @@ void AudioFilesDb::WriteFile(DbFileInfo *dbFile)
                 "INSERT INTO files ("
                 "fileName, lastModified,"
                 "title,track,album,artist, albumArtist, "
-                "duration, thumbnailType,thumbnailFile, thumbnailLastModified, position "
-                ") VALUES (?, ?, ?, ?, ?,?,?,?,?,?,?,?)");
+                "duration, thumbnailType,thumbnailFile, thumbnailLastModified, position, "
+                "inode, fileSize, titleSortKey "
+                ") VALUES (?, ?, ?, ?, ?,?,?,?,?,?,?,?,?,?,?)");
         }
-        insertFileQuery->tryReset();
+        StatementReset reset(*insertFileQuery);
         insertFileQuery->bind(1, dbFile->fileName());
         insertFileQuery->bind(2, dbFile->lastModified());
         insertFileQuery->bind(3, dbFile->title());
@@ -345,6 +483,9 @@ void AudioFilesDb::WriteFile(DbFileInfo *dbFile)
         insertFileQuery->bind(10, dbFile->thumbnailFile());
         insertFileQuery->bind(11, dbFile->thumbnailLastModified());
         insertFileQuery->bind(12, dbFile->position());
+        insertFileQuery->bind(13, (int64_t)dbFile->inode());
+        insertFileQuery->bind(14, dbFile->fileSize());
+        insertFileQuery->bind(15, dbFile->titleSortKey().data(), (int)dbFile->titleSortKey().size());
         insertFileQuery->exec();
         dbFile->idFile(db->getLastInsertRowid());
     }
@@ -358,10 +499,11 @@ void AudioFilesDb::WriteFile(DbFileInfo *dbFile)
                 "fileName = ?, lastModified = ?, "
                 "title = ?, track = ?, album = ?, artist = ? , albumArtist = ?, "
                 "duration = ?, thumbnailType = ?, "
-                "thumbnailFile = ?, thumbnailLastModified = ?, position = ? "
+                "thumbnailFile = ?, thumbnailLastModified = ?, position = ?, "
+                "inode = ?, fileSize = ?, titleSortKey = ? "
                 " WHERE idFile = ?");
         }
-        updateFileQuery->tryReset();
+        StatementReset reset(*updateFileQuery);
         updateFileQuery->bind(1, dbFile->fileName());
         updateFileQuery->bind(2, dbFile->lastModified());
         updateFileQuery->bind(3, dbFile->title());
@@ -374,8 +516,11 @@ void AudioFilesDb::WriteFile(DbFileInfo *dbFile)
         updateFileQuery->bind(10, dbFile->thumbnailFile());
         updateFileQuery->bind(11, dbFile->thumbnailLastModified());
         updateFileQuery->bind(12, dbFile->position());
+        updateFileQuery->bind(13, (int64_t)dbFile->inode());
+        updateFileQuery->bind(14, dbFile->fileSize());
+        updateFileQuery->bind(15, dbFile->titleSortKey().data(), (int)dbFile->titleSortKey().size());
 
-        updateFileQuery->bind(13, dbFile->idFile());
+        updateFileQuery->bind(16, dbFile->idFile());
 
         updateFileQuery->exec();
     }
@@ -384,9 +529,10 @@ void AudioFilesDb::WriteFile(DbFileInfo *dbFile)
 ThumbnailInfo AudioFilesDb::GetThumbnailInfo(const std::string &fileNameOnly)
 {
     ThumbnailInfo result;
-    SQLite::Statement query(
-        *db,
+    auto &query = PrepareStatement(
+        *db, thumbnailInfoQuery,
         "SELECT thumbnailType, thumbnailFile, thumbnailLastModified FROM files WHERE fileName = ?");
+    StatementReset reset(query);
     query.bind(1, fileNameOnly);
     if (query.executeStep())
     {
@@ -404,9 +550,11 @@ ThumbnailInfo AudioFilesDb::GetThumbnailInfo(const std::string &fileNameOnly)
 
 std::vector<uint8_t> AudioFilesDb::GetEmbeddedThumbnail(int64_t idFile, int32_t width, int32_t height)
 {
-    SQLite::Statement query(*db,
-                            "SELECT thumbnail FROM thumbnails "
-                            "WHERE idFile = ? AND width = ? AND height = ?");
+    auto &query = PrepareStatement(
+        *db, embeddedThumbnailQuery,
+        "SELECT thumbnail FROM thumbnails "
+        "WHERE idFile = ? AND width = ? AND height = ?");
+    StatementReset reset(query);
     query.bind(1, idFile);
     query.bind(2, width);
     query.bind(3, height);
@@ -426,7 +574,8 @@ std::vector<uint8_t> AudioFilesDb::GetEmbeddedThumbnail(int64_t idFile, int32_t
 std::vector<uint8_t> AudioFilesDb::GetEmbeddedThumbnail(const std::string &fileNameOnly, int32_t width, int32_t height)
 {
     int64_t idFile;
-    SQLite::Statement query(*db, "SELECT idFile FROM files WHERE fileName = ?");
+    auto &query = PrepareStatement(*db, idFileByNameQuery, "SELECT idFile FROM files WHERE fileName = ?");
+    StatementReset reset(query);
     query.bind(1, fileNameOnly);
     if (query.executeStep())
     {
@@ -446,15 +595,18 @@ void AudioFilesDb::AddThumbnail(
     const std::vector<uint8_t> &thumbnailData)
 {
     int64_t idFile;
-    SQLite::Statement query(*db, "SELECT idFile FROM files WHERE fileName = ?");
-    query.bind(1, fileName);
-    if (query.executeStep())
     {
-        idFile = query.getColumn(0).getInt64();
-    }
-    else
-    {
-        throw std::runtime_error("File not found in database: " + fileName);
+        auto &query = PrepareStatement(*db, idFileByNameQuery, "SELECT idFile FROM files WHERE fileName = ?");
+        StatementReset reset(query);
+        query.bind(1, fileName);
+        if (query.executeStep())
+        {
+            idFile = query.getColumn(0).getInt64();
+        }
+        else
+        {
+            throw std::runtime_error("File not found in database: " + fileName);
+        }
     }
     AddThumbnail(idFile, width, height, thumbnailData);
 }
@@ -469,9 +621,10 @@ void AudioFilesDb::AddThumbnail(
         throw std::runtime_error("Thumbnail data is empty.");
     }
 
-    SQLite::Statement insertQuery(
-        *db,
+    auto &insertQuery = PrepareStatement(
+        *db, insertThumbnailQuery,
         "INSERT INTO thumbnails (idFile, thumbnail, width, height) VALUES (?, ?, ?, ?)");
+    StatementReset reset(insertQuery);
     insertQuery.bind(1, idFile);
     insertQuery.bind(2, thumbnailData.data(), thumbnailData.size());
     insertQuery.bind(3, width);
@@ -491,15 +644,291 @@ void AudioFilesDb::UpdateFilePosition(
     int64_t idFile,
     int32_t position)
 {
-    if (!updateFileQuery)
+    auto &query = PrepareStatement(*db, updatePositionQuery, "UPDATE files SET position = ? WHERE idFile = ?");
+    StatementReset reset(query);
+    query.bind(1, position);
+    query.bind(2, idFile);
+    query.exec();
+}
+
+bool AudioFilesDb::GetPeaks(const std::string &fileNameOnly, int64_t lastModified, std::vector<uint8_t> *peaks)
+{
+    auto &query = PrepareStatement(
+        *db, peaksQuery,
+        "SELECT peaks.lastModified, peaks.peaks FROM peaks "
+        "INNER JOIN files ON files.idFile = peaks.idFile "
+        "WHERE files.fileName = ?");
+    StatementReset reset(query);
+    query.bind(1, fileNameOnly);
+    if (!query.executeStep())
+    {
+        return false;
+    }
+    if (query.getColumn(0).getInt64() != lastModified)
+    {
+        return false;
+    }
+    const uint8_t *data = (const uint8_t *)query.getColumn(1).getBlob();
+    int size = query.getColumn(1).getBytes();
+    peaks->assign(data, data + size);
+    return true;
+}
+
+void AudioFilesDb::SetPeaks(const std::string &fileNameOnly, int64_t lastModified, const std::vector<uint8_t> &peaks)
+{
+    int64_t idFile;
     {
-        updateFileQuery = std::make_unique<SQLite::Statement>(
-            *db,
-            "UPDATE files SET position = ? WHERE idFile = ?");
+        auto &query = PrepareStatement(*db, idFileByNameQuery, "SELECT idFile FROM files WHERE fileName = ?");
+        StatementReset reset(query);
+        query.bind(1, fileNameOnly);
+        if (!query.executeStep())
+        {
+            throw std::runtime_error("File not found in database: " + fileNameOnly);
+        }
+        idFile = query.getColumn(0).getInt64();
     }
-    updateFileQuery->tryReset();
-    updateFileQuery->bind(1, position);
-    updateFileQuery->bind(2, idFile);
-    updateFileQuery->exec();
+    auto &query = PrepareStatement(
+        *db, insertPeaksQuery,
+        "INSERT OR REPLACE INTO peaks (idFile, lastModified, peaks) VALUES (?, ?, ?)");
+    StatementReset reset(query);
+    query.bind(1, idFile);
+    query.bind(2, lastModified);
+    query.bind(3, peaks.data(), peaks.size());
+    query.exec();
 }
 
+void AudioFilesDb::DeletePeaks(int64_t idFile)
+{
+    auto &query = PrepareStatement(*db, deletePeaksQuery, "DELETE FROM peaks WHERE idFile = ?");
+    StatementReset reset(query);
+    query.bind(1, idFile);
+    query.exec();
+}
+
+ThumbnailCacheDb::ThumbnailCacheDb(const std::filesystem::path &dbPathName)
+{
+    if (!fs::exists(dbPathName))
+    {
+        CreateDb(dbPathName);
+    }
+    else
+    {
+        this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE);
+        ConfigureConnection(*db, dbPathName);
+    }
+}
+
+void ThumbnailCacheDb::CreateDb(const std::filesystem::path &dbPathName)
+{
+    try
+    {
+        this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        ConfigureConnection(*db, dbPathName);
+
+        SQLite::Transaction transaction(*db);
+        db->exec("CREATE TABLE am_dbInfo ("
+                 "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                 "version INTEGER NOT NULL)");
+        {
+            SQLite::Statement query(*db, "INSERT INTO am_dbInfo (version) VALUES (?)");
+            query.bind(1, DB_VERSION);
+            query.exec();
+        }
+        db->exec("CREATE TABLE entries ("
+                 "idEntry INTEGER PRIMARY KEY AUTOINCREMENT, "
+                 "cacheKey TEXT NOT NULL UNIQUE, "
+                 "size INT64 NOT NULL, "
+                 "lastAccess INT64 NOT NULL)");
+        db->exec("CREATE INDEX entries_lastAccess ON entries (lastAccess)");
+        transaction.commit();
+    }
+    catch (const SQLite::Exception &e)
+    {
+        throw std::runtime_error("Failed to create thumbnail cache database: " + std::string(e.what()));
+    }
+}
+
+bool ThumbnailCacheDb::Lookup(const std::string &cacheKey, ThumbnailCacheEntry *entry)
+{
+    auto &query = PrepareStatement(
+        *db, lookupQuery,
+        "SELECT idEntry, size, lastAccess FROM entries WHERE cacheKey = ?");
+    StatementReset reset(query);
+    query.bind(1, cacheKey);
+    if (query.executeStep())
+    {
+        entry->idEntry = query.getColumn(0).getInt64();
+        entry->cacheKey = cacheKey;
+        entry->size = query.getColumn(1).getInt64();
+        entry->lastAccess = query.getColumn(2).getInt64();
+        return true;
+    }
+    return false;
+}
+
+int64_t ThumbnailCacheDb::Insert(const std::string &cacheKey, int64_t size, int64_t lastAccess)
+{
+    auto &query = PrepareStatement(
+        *db, insertQuery,
+        "INSERT OR REPLACE INTO entries (cacheKey, size, lastAccess) VALUES (?, ?, ?)");
+    StatementReset reset(query);
+    query.bind(1, cacheKey);
+    query.bind(2, size);
+    query.bind(3, lastAccess);
+    query.exec();
+    return db->getLastInsertRowid();
+}
+
+void ThumbnailCacheDb::Touch(int64_t idEntry, int64_t lastAccess)
+{
+    auto &query = PrepareStatement(*db, touchQuery, "UPDATE entries SET lastAccess = ? WHERE idEntry = ?");
+    StatementReset reset(query);
+    query.bind(1, lastAccess);
+    query.bind(2, idEntry);
+    query.exec();
+}
+
+void ThumbnailCacheDb::Delete(int64_t idEntry)
+{
+    auto &query = PrepareStatement(*db, deleteQuery, "DELETE FROM entries WHERE idEntry = ?");
+    StatementReset reset(query);
+    query.bind(1, idEntry);
+    query.exec();
+}
+
+int64_t ThumbnailCacheDb::GetTotalSize()
+{
+    SQLite::Statement query(*db, "SELECT COALESCE(SUM(size), 0) FROM entries");
+    if (query.executeStep())
+    {
+        return query.getColumn(0).getInt64();
+    }
+    return 0;
+}
+
+std::vector<ThumbnailCacheEntry> ThumbnailCacheDb::GetLeastRecentlyUsed(size_t count)
+{
+    std::vector<ThumbnailCacheEntry> result;
+    auto &query = PrepareStatement(
+        *db, leastRecentlyUsedQuery,
+        "SELECT idEntry, cacheKey, size, lastAccess FROM entries ORDER BY lastAccess LIMIT ?");
+    StatementReset reset(query);
+    query.bind(1, (int64_t)count);
+    while (query.executeStep())
+    {
+        ThumbnailCacheEntry entry;
+        entry.idEntry = query.getColumn(0).getInt64();
+        entry.cacheKey = query.getColumn(1).getText();
+        entry.size = query.getColumn(2).getInt64();
+        entry.lastAccess = query.getColumn(3).getInt64();
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+MediaBlobDb::MediaBlobDb(const std::filesystem::path &dbPathName)
+{
+    if (!fs::exists(dbPathName))
+    {
+        CreateDb(dbPathName);
+    }
+    else
+    {
+        this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE);
+        ConfigureConnection(*db, dbPathName);
+    }
+}
+
+void MediaBlobDb::CreateDb(const std::filesystem::path &dbPathName)
+{
+    try
+    {
+        this->db = std::make_unique<SQLite::Database>(dbPathName, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+        ConfigureConnection(*db, dbPathName);
+
+        SQLite::Transaction transaction(*db);
+        db->exec("CREATE TABLE am_dbInfo ("
+                 "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                 "version INTEGER NOT NULL)");
+        {
+            SQLite::Statement query(*db, "INSERT INTO am_dbInfo (version) VALUES (?)");
+            query.bind(1, DB_VERSION);
+            query.exec();
+        }
+        db->exec("CREATE TABLE blobs ("
+                 "idBlob INTEGER PRIMARY KEY AUTOINCREMENT, "
+                 "path TEXT NOT NULL UNIQUE, "
+                 "hash TEXT NOT NULL, "
+                 "size INT64 NOT NULL, "
+                 "lastModified INT64 NOT NULL, "
+                 "inode INT64 NOT NULL)");
+        db->exec("CREATE INDEX blobs_hash ON blobs (hash)");
+        transaction.commit();
+    }
+    catch (const SQLite::Exception &e)
+    {
+        throw std::runtime_error("Failed to create media blob database: " + std::string(e.what()));
+    }
+}
+
+bool MediaBlobDb::Lookup(const std::string &path, MediaBlobEntry *entry)
+{
+    auto &query = PrepareStatement(
+        *db, lookupQuery,
+        "SELECT hash, size, lastModified, inode FROM blobs WHERE path = ?");
+    StatementReset reset(query);
+    query.bind(1, path);
+    if (query.executeStep())
+    {
+        entry->path = path;
+        entry->hash = query.getColumn(0).getText();
+        entry->size = query.getColumn(1).getInt64();
+        entry->lastModified = query.getColumn(2).getInt64();
+        entry->inode = (uint64_t)query.getColumn(3).getInt64();
+        return true;
+    }
+    return false;
+}
+
+void MediaBlobDb::Insert(const MediaBlobEntry &entry)
+{
+    auto &query = PrepareStatement(
+        *db, insertQuery,
+        "INSERT OR REPLACE INTO blobs (path, hash, size, lastModified, inode) VALUES (?, ?, ?, ?, ?)");
+    StatementReset reset(query);
+    query.bind(1, entry.path);
+    query.bind(2, entry.hash);
+    query.bind(3, entry.size);
+    query.bind(4, entry.lastModified);
+    query.bind(5, (int64_t)entry.inode);
+    query.exec();
+}
+
+void MediaBlobDb::Delete(const std::string &path)
+{
+    auto &query = PrepareStatement(*db, deleteQuery, "DELETE FROM blobs WHERE path = ?");
+    StatementReset reset(query);
+    query.bind(1, path);
+    query.exec();
+}
+
+std::vector<MediaBlobEntry> MediaBlobDb::FindByHash(const std::string &hash)
+{
+    std::vector<MediaBlobEntry> result;
+    auto &query = PrepareStatement(
+        *db, findByHashQuery,
+        "SELECT path, size, lastModified, inode FROM blobs WHERE hash = ?");
+    StatementReset reset(query);
+    query.bind(1, hash);
+    while (query.executeStep())
+    {
+        MediaBlobEntry entry;
+        entry.path = query.getColumn(0).getText();
+        entry.hash = hash;
+        entry.size = query.getColumn(1).getInt64();
+        entry.lastModified = query.getColumn(2).getInt64();
+        entry.inode = (uint64_t)query.getColumn(3).getInt64();
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
@@ -41,6 +41,9 @@ namespace pipedal::impl {
         int64_t idFile_ = -1;
         bool present_ = false;
         bool dirty_ = false;
+        uint64_t inode_ = 0;
+        int64_t fileSize_ = 0;
+        std::string titleSortKey_;
     public:
         int64_t idFile() const { return idFile_;}
         void idFile(int64_t value) { idFile_ = value;}
@@ -48,6 +51,14 @@ namespace pipedal::impl {
         void present(bool value) { present_ = value;}
         bool dirty() const { return dirty_;}
         void dirty(bool value) { dirty_ = value;}
+        // 0 if not yet known (e.g. an index created by a previous version).
+        uint64_t inode() const { return inode_; }
+        void inode(uint64_t value) { inode_ = value; }
+        int64_t fileSize() const { return fileSize_; }
+        void fileSize(int64_t value) { fileSize_ = value; }
+        // Collation key for title(). Empty if not yet computed.
+        const std::string &titleSortKey() const { return titleSortKey_; }
+        void titleSortKey(const std::string &value) { titleSortKey_ = value; }
 
     };
 
@@ -69,7 +80,7 @@ namespace pipedal::impl {
     };
     class AudioFilesDb {
     public:
-        static constexpr int32_t DB_VERSION = 1;
+        static constexpr int32_t DB_VERSION = 4;
         AudioFilesDb(
             const std::filesystem::path &path,
             const std::filesystem::path &indexPath = "" // if non-empty, forces the location of the ".index.pipedal" file.
@@ -110,6 +121,21 @@ namespace pipedal::impl {
             int64_t idFile,
             int32_t position);
 
+        // Serialized AudioPeaks for the file. false if there are none, or they were generated
+        // from a different version of the file.
+        bool GetPeaks(const std::string &fileNameOnly, int64_t lastModified, std::vector<uint8_t> *peaks);
+        void SetPeaks(const std::string &fileNameOnly, int64_t lastModified, const std::vector<uint8_t> &peaks);
+        void DeletePeaks(int64_t idFile);
+
+        // The directory's last-modified time as of the last complete scan, or 0 if the
+        // directory needs to be rescanned.
+        int64_t GetDirectoryLastModified();
+        void SetDirectoryLastModified(int64_t value);
+
+        // The Collator::GetSortKeyVersion() that stored title sort keys were generated with.
+        std::string GetSortKeyVersion();
+        void SetSortKeyVersion(const std::string &value);
+
     private:
 
         void CreateDb(const std::filesystem::path &dbPathName);
@@ -128,7 +154,80 @@ namespace pipedal::impl {
         std::unique_ptr<SQLite::Statement> updateThumbnailInfoQueryByName;
         std::unique_ptr<SQLite::Statement> updateThumbnailInfoQueryById;
         std::unique_ptr<SQLite::Statement> updatePositionQuery;
+        std::unique_ptr<SQLite::Statement> deleteThumbnailsQuery;
+        std::unique_ptr<SQLite::Statement> queryTracksQuery;
+        std::unique_ptr<SQLite::Statement> idFileByNameQuery;
+        std::unique_ptr<SQLite::Statement> thumbnailInfoQuery;
+        std::unique_ptr<SQLite::Statement> embeddedThumbnailQuery;
+        std::unique_ptr<SQLite::Statement> insertThumbnailQuery;
+        std::unique_ptr<SQLite::Statement> peaksQuery;
+        std::unique_ptr<SQLite::Statement> insertPeaksQuery;
+        std::unique_ptr<SQLite::Statement> deletePeaksQuery;
         std::filesystem::path path;
     };
-}
 
+    class ThumbnailCacheEntry
+    {
+    public:
+        int64_t idEntry = -1;
+        std::string cacheKey;
+        int64_t size = 0;
+        int64_t lastAccess = 0; // seconds since the epoch.
+    };
+
+    // Index of the files in the thumbnail cache directory, in least-recently-used order.
+    class ThumbnailCacheDb {
+    public:
+        static constexpr int32_t DB_VERSION = 1;
+        ThumbnailCacheDb(const std::filesystem::path &dbPathName);
+
+        bool Lookup(const std::string &cacheKey, ThumbnailCacheEntry *entry);
+        // Returns the idEntry of the new entry.
+        int64_t Insert(const std::string &cacheKey, int64_t size, int64_t lastAccess);
+        void Touch(int64_t idEntry, int64_t lastAccess);
+        void Delete(int64_t idEntry);
+        int64_t GetTotalSize();
+        std::vector<ThumbnailCacheEntry> GetLeastRecentlyUsed(size_t count);
+
+    private:
+        void CreateDb(const std::filesystem::path &dbPathName);
+
+        std::unique_ptr<SQLite::Database> db;
+        std::unique_ptr<SQLite::Statement> lookupQuery;
+        std::unique_ptr<SQLite::Statement> insertQuery;
+        std::unique_ptr<SQLite::Statement> touchQuery;
+        std::unique_ptr<SQLite::Statement> deleteQuery;
+        std::unique_ptr<SQLite::Statement> leastRecentlyUsedQuery;
+    };
+
+    class MediaBlobEntry
+    {
+    public:
+        std::string path; // relative to the upload directory.
+        std::string hash;
+        int64_t size = 0;
+        int64_t lastModified = 0;
+        uint64_t inode = 0;
+    };
+
+    // Content hashes of the files in the plugin upload directory.
+    class MediaBlobDb {
+    public:
+        static constexpr int32_t DB_VERSION = 1;
+        MediaBlobDb(const std::filesystem::path &dbPathName);
+
+        bool Lookup(const std::string &path, MediaBlobEntry *entry);
+        void Insert(const MediaBlobEntry &entry);
+        void Delete(const std::string &path);
+        std::vector<MediaBlobEntry> FindByHash(const std::string &hash);
+
+    private:
+        void CreateDb(const std::filesystem::path &dbPathName);
+
+        std::unique_ptr<SQLite::Database> db;
+        std::unique_ptr<SQLite::Statement> lookupQuery;
+        std::unique_ptr<SQLite::Statement> insertQuery;
+        std::unique_ptr<SQLite::Statement> deleteQuery;
+        std::unique_ptr<SQLite::Statement> findByHashQuery;
+    };
+}
@@ -30,11 +30,13 @@
 #include "JackDriver.hpp"
 #include "AlsaDriver.hpp"
 #include "DummyAudioDriver.hpp"
+#include "PipeWireDriver.hpp"
 #include "AtomConverter.hpp"
 #include <unordered_map>
+#include <unordered_set>
 #include "PluginHost.hpp"
 #include "PatchPropertyWriter.hpp"
-#include "CpuTemperatureMonitor.hpp"
+#include "SysfsSampler.hpp"
 #include "restrict.hpp"
 
 using namespace pipedal;
@@ -47,10 +49,23 @@ using namespace pipedal;
 #include <thread>
 #include <semaphore.h>
 #include "VuUpdate.hpp"
+#include "EffectTiming.hpp"
+#include "Denormals.hpp"
+#include "RealtimeWatchdog.hpp"
+#include "OverloadMonitor.hpp"
+#include "ReclamationQueue.hpp"
+#include "RealtimeTripwire.hpp"
+#include "Lv2Effect.hpp"
+#include "RealtimeArena.hpp"
+#include "MidiDispatchTable.hpp"
 #include "CpuGovernor.hpp"
+#include "MetricsPage.hpp"
 
 #include "RingBuffer.hpp"
 #include "RingBufferReader.hpp"
+#include "AudioRecorder.hpp"
+#include "RealtimePedalboardSlots.hpp"
+#include "inverting_mutex.hpp"
 
 #include "PiPedalException.hpp"
 #include "pthread.h"
@@ -61,6 +76,7 @@ using namespace pipedal;
 #include "Lv2EventBufferWriter.hpp"
 #include "InheritPriorityMutex.hpp"
 #include <atomic>
+#include <condition_variable>
 
 #ifdef __linux__
 #include <sched.h>
@@ -73,45 +89,19 @@ using namespace pipedal;
 #include "AdminClient.hpp"
 
 const double VU_UPDATE_RATE_S = 1.0 / 30;
+const double EFFECT_TIMING_UPDATE_RATE_S = 1.0;
+const double OVERLOAD_CHECK_PERIOD_S = 0.25;
+const double METRICS_PUBLISH_PERIOD_S = 1.0;
 const double OVERRUN_GRACE_PERIOD_S = 15;
+// Length of each half of the fade-out/fade-in used when there isn't enough cpu to run both pedalboards.
+const double FAST_FADE_S = 0.005;
+// Fraction of the period budget that both pedalboards may use before a dual-run crossfade is refused (or cut short).
+const double CROSSFADE_CPU_LIMIT = 0.75;
+// Audio driver channels that the audio thread will process (e.g. a 4-in/4-out interface shared by pedalboard slots).
 using namespace pipedal;
 
 const int MIDI_LV2_BUFFER_SIZE = 16 * 1024;
 
-static void GetCpuFrequency(uint64_t *freqMin, uint64_t *freqMax)
-{
-    uint64_t fMax = 0;
-    uint64_t fMin = UINT64_MAX;
-    char deviceName[128];
-    try
-    {
-        for (int i = 0; true; ++i)
-        {
-
-            snprintf(deviceName, sizeof(deviceName), "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", i);
-            std::ifstream f(deviceName);
-            if (!f)
-            {
-                break;
-            }
-            uint64_t freq;
-            f >> freq;
-            if (!f)
-                break;
-            if (freq < fMin)
-                fMin = freq;
-            if (freq > fMax)
-                fMax = freq;
-        }
-    }
-    catch (const std::exception &)
-    {
-    }
-    if (fMax == 0)
-        fMin = 0;
-    *freqMin = fMin;
-    *freqMax = fMax;
-}
 static std::string GetGovernor()
 {
     return pipedal::GetCpuGovernor();
@@ -120,176 +110,176 @@ static std::string GetGovernor()
 namespace pipedal
 {
 
-    struct PathPatchProperty
+    // A snapshot, compiled on the host thread into a packed diff against the running pedalboard, so
+    // that the audio thread only has to copy values into place.
+    class IndexedSnapshot
     {
-        LV2_URID propertyUrid = 0;
-        std::vector<uint8_t> atomBuffer;
-    };
+    public:
+        IndexedSnapshot(Snapshot *snapshot, std::shared_ptr<Lv2Pedalboard> currentPedalboard, PluginHost &pluginHost)
+        {
+            std::unordered_map<uint64_t, SnapshotValue *> index;
+            for (auto &value : snapshot->values_)
+            {
+                index[value.instanceId_] = &value;
+            }
+            std::vector<IEffect *> &effects = currentPedalboard->GetEffects();
+            this->effectCount = effects.size();
+
+            for (size_t i = 0; i < effects.size(); ++i)
+            {
+                AddEffect((uint32_t)i, effects[i], getSnapshotValue(index, effects[i]->GetInstanceId()), pluginHost);
+            }
+            controlChanges.shrink_to_fit();
+        }
+        static SnapshotValue *getSnapshotValue(std::unordered_map<uint64_t, SnapshotValue *> &index, uint64_t instanceId)
+        {
+            auto iter = index.find(instanceId);
+            if (iter == index.end())
+            {
+                return nullptr;
+            }
+            return iter->second;
+        }
+
+        // Audio thread. Continuous controls are ramped to their new values over rampFrames frames.
+        void Apply(Lv2Pedalboard *pedalboard, uint32_t rampFrames)
+        {
+            std::vector<IEffect *> &effects = pedalboard->GetEffects();
+            if (effects.size() != effectCount)
+            {
+                throw std::runtime_error("Effects and values don't match");
+            }
+            for (const ControlChange &change : controlChanges)
+            {
+                if (change.controlIndex == BYPASS_CONTROL)
+                {
+                    effects[change.effectIndex]->SetBypass(change.value != 0);
+                }
+                else if (change.ramp && rampFrames != 0)
+                {
+                    pedalboard->RampControlValue(change.effectIndex, change.controlIndex, change.value, rampFrames);
+                }
+                else
+                {
+                    pedalboard->SetControlValue(change.effectIndex, change.controlIndex, change.value);
+                }
+            }
+            for (const PatchSetMessage &message : patchSetMessages)
+            {
+                ((Lv2Effect *)effects[message.effectIndex])->WriteInputAtom((const LV2_Atom *)(atomData.data() + message.offset));
+            }
+        }
+
+        size_t GetControlChangeCount() const { return controlChanges.size(); }
+        size_t GetPatchSetCount() const { return patchSetMessages.size(); }
+
+        // set by the audio thread.
+        uint64_t applyNs = 0;
 
-    class IndexedSnapshotValue
-    {
     private:
-        struct InputControlEntry
+        static constexpr int32_t BYPASS_CONTROL = -1;
+
+        struct ControlChange
+        {
+            uint32_t effectIndex;
+            int32_t controlIndex; // or BYPASS_CONTROL.
+            float value;
+            bool ramp = false;
+        };
+        struct PatchSetMessage
         {
-            bool isInputControl = false;
-            float value = 0;
+            uint32_t effectIndex;
+            uint32_t offset; // of a pre-forged patch:Set atom in atomData.
         };
 
-    public:
-        IndexedSnapshotValue(IEffect *effect, SnapshotValue *snapshotValue, PluginHost &pluginHost)
-            : pEffect(effect)
+        void AddEffect(uint32_t effectIndex, IEffect *effect, SnapshotValue *snapshotValue, PluginHost &pluginHost)
         {
+            // Values not mentioned in the snapshot revert to plugin defaults.
             auto maxInputControl = effect->GetMaxInputControl();
-            inputControlValues.resize(maxInputControl);
-            this->enabled = true;
+            std::vector<float> values(maxInputControl);
             for (uint64_t i = 0; i < maxInputControl; ++i)
             {
-                bool isInputControl = effect->IsInputControl(i);
-                if (isInputControl)
-                {
-                    inputControlValues[i] = InputControlEntry{isInputControl : true, value : effect->GetDefaultInputControlValue(i)};
-                }
-                else
+                if (effect->IsInputControl(i))
                 {
-                    inputControlValues[i] = InputControlEntry{isInputControl : false, value : 0};
+                    values[i] = effect->GetDefaultInputControlValue(i);
                 }
             }
+            bool enabled = true;
             if (snapshotValue)
             {
-                this->enabled = snapshotValue->isEnabled_;
+                enabled = snapshotValue->isEnabled_;
                 for (auto &controlValue : snapshotValue->controlValues_)
                 {
                     auto index = effect->GetControlIndex(controlValue.key());
-                    if (index >= 0 && index < inputControlValues.size())
-                    {
-                        inputControlValues[index].value = controlValue.value();
-                    }
-                }
-                this->lv2State = snapshotValue->lv2State_;
-
-                if (effect->IsLv2Effect())
-                {
-                    Lv2Effect *lv2Effect = (Lv2Effect *)effect;
-                    for (auto &pathProperty : snapshotValue->pathProperties_)
+                    if (index >= 0 && index < values.size())
                     {
-                        // only transmit changed path patch properties.
-                        if (lv2Effect->GetPathPatchProperty(pathProperty.first) != pathProperty.second)
-                        {
-                            lv2Effect->SetPathPatchProperty(pathProperty.first, pathProperty.second);
-
-                            PathPatchProperty pathPatchProperty;
-                            pathPatchProperty.propertyUrid = pluginHost.GetLv2Urid(pathProperty.first.c_str());
-                            // convert to json variant so we do a mappath operation.
-                            json_variant vProperty;
-                            std::istringstream ss(pathProperty.second);
-                            json_reader reader(ss);
-                            reader.read(&vProperty);
-                            if (!vProperty.is_null())
-                            {
-                                try
-                                {
-                                    vProperty = pluginHost.MapPath(vProperty);
-
-                                    // now to atom format (what we want on the rt thread0)
-                                    AtomConverter atomConverter(pluginHost.GetMapFeature());
-                                    LV2_Atom *atomValue = atomConverter.ToAtom(vProperty);
-
-                                    size_t atomBufferSize = (atomValue->size + sizeof(LV2_Atom) + 3) / 4 * 4;
-                                    pathPatchProperty.atomBuffer.resize(atomValue->size + sizeof(LV2_Atom));
-                                    memcpy(pathPatchProperty.atomBuffer.data(), atomValue, pathPatchProperty.atomBuffer.size());
-                                    this->pathPatchProperties.push_back(std::move(pathPatchProperty));
-                                }
-                                catch (const std::exception &e)
-                                {
-                                    Lv2Log::info(SS("IndexedSnapshotValue: Failed to map path property " << pathProperty.first << ". " << e.what()));
-                                }
-                            }
-                        }
+                        values[index] = controlValue.value();
                     }
                 }
             }
-        }
-        void ApplyValues(IEffect *effect)
-        {
+            // Always sent. (Cheap, and not all effects can report their bypass state.)
+            controlChanges.push_back(ControlChange{effectIndex, BYPASS_CONTROL, enabled ? 1.0f : 0.0f});
 
-            effect->SetBypass(this->enabled);
-            if (effect != pEffect)
-            {
-                throw std::runtime_error("Wrong effect");
-            }
-            for (size_t i = 0; i < inputControlValues.size(); ++i)
+            // Only send controls that differ from the current value. (Reading controls of the running
+            // pedalboard is racy, but a stale read only occurs if the control changed in the last few milliseconds.)
+            for (uint64_t i = 0; i < maxInputControl; ++i)
             {
-                InputControlEntry &e = inputControlValues[i];
-                if (e.isInputControl)
+                if (effect->IsInputControl(i) && effect->GetControlValue((int)i) != values[i])
                 {
-                    effect->SetControl((int)i, e.value);
+                    bool ramp = effect->IsLv2Effect() && ((Lv2Effect *)effect)->IsRampableControl((int)i);
+                    controlChanges.push_back(ControlChange{effectIndex, (int32_t)i, values[i], ramp});
                 }
             }
 
-            for (const auto &patchProperty : pathPatchProperties)
+            if (snapshotValue && effect->IsLv2Effect())
             {
-                // yyy: only if the property changed!.
-                effect->SetPatchProperty(
-                    patchProperty.propertyUrid, patchProperty.atomBuffer.size(), (LV2_Atom *)patchProperty.atomBuffer.data());
+                Lv2Effect *lv2Effect = (Lv2Effect *)effect;
+                for (auto &pathProperty : snapshotValue->pathProperties_)
+                {
+                    // only transmit changed path patch properties.
+                    if (lv2Effect->GetPathPatchProperty(pathProperty.first) != pathProperty.second)
+                    {
+                        lv2Effect->SetPathPatchProperty(pathProperty.first, pathProperty.second);
+                        AddPathProperty(effectIndex, lv2Effect, pathProperty.first, pathProperty.second, pluginHost);
+                    }
+                }
             }
-            // effect->SetLv2State(lv2State);
         }
-
-    private:
-        IEffect *pEffect;
-        Lv2PluginState lv2State;
-        bool enabled;
-        std::vector<InputControlEntry> inputControlValues;
-        std::vector<PathPatchProperty> pathPatchProperties;
-    };
-    class IndexedSnapshot
-    {
-    public:
-        IndexedSnapshot(Snapshot *snapshot, std::shared_ptr<Lv2Pedalboard> currentPedalboard, PluginHost &pluginHost)
+        void AddPathProperty(uint32_t effectIndex, Lv2Effect *lv2Effect, const std::string &propertyUri, const std::string &jsonValue, PluginHost &pluginHost)
         {
-            std::unordered_map<uint64_t, SnapshotValue *> index;
-            for (auto &value : snapshot->values_)
+            // convert to json variant so we do a mappath operation.
+            json_variant vProperty;
+            std::istringstream ss(jsonValue);
+            json_reader reader(ss);
+            reader.read(&vProperty);
+            if (vProperty.is_null())
             {
-                index[value.instanceId_] = &value;
+                return;
             }
-            std::vector<IEffect *> &effects = currentPedalboard->GetEffects();
-            snapshotValues.reserve(effects.size());
-
-            for (size_t i = 0; i < effects.size(); ++i)
+            try
             {
-                auto &effect = effects[i];
+                vProperty = pluginHost.MapPath(vProperty);
 
-                SnapshotValue *snapshotValue = getSnapshotValue(index, effect->GetInstanceId());
-                snapshotValues.push_back(IndexedSnapshotValue(effect, snapshotValue, pluginHost));
-            }
-        }
-        static SnapshotValue *getSnapshotValue(std::unordered_map<uint64_t, SnapshotValue *> &index, uint64_t instanceId)
-        {
-            auto iter = index.find(instanceId);
-            if (iter == index.end())
-            {
-                return nullptr;
-            }
-            return iter->second;
-        }
+                // now to atom format, forged into a complete patch:Set message.
+                AtomConverter atomConverter(pluginHost.GetMapFeature());
+                LV2_Atom *atomValue = atomConverter.ToAtom(vProperty);
+                std::vector<uint8_t> message = lv2Effect->ForgePatchSet(pluginHost.GetLv2Urid(propertyUri.c_str()), atomValue);
 
-        void Apply(std::vector<IEffect *> &effects)
-        {
-            if (effects.size() != snapshotValues.size())
-            {
-                throw std::runtime_error("Effects and values don't match");
+                size_t offset = atomData.size();
+                atomData.resize(offset + (message.size() + 7) / 8 * 8);
+                memcpy(atomData.data() + offset, message.data(), message.size());
+                patchSetMessages.push_back(PatchSetMessage{effectIndex, (uint32_t)offset});
             }
-            for (size_t i = 0; i < snapshotValues.size(); ++i)
+            catch (const std::exception &e)
             {
-                snapshotValues[i].ApplyValues(effects[i]);
+                Lv2Log::info(SS("IndexedSnapshot: Failed to map path property " << propertyUri << ". " << e.what()));
             }
         }
-        ~IndexedSnapshot()
-        {
-        }
 
-    private:
-        std::vector<IndexedSnapshotValue> snapshotValues;
+        size_t effectCount = 0;
+        std::vector<ControlChange> controlChanges;
+        std::vector<PatchSetMessage> patchSetMessages;
+        std::vector<uint8_t> atomData; // pre-forged patch:Set messages, 8-byte aligned.
     };
 }
 
@@ -389,6 +379,74 @@ bool SystemMidiBinding::IsMatch(const MidiEvent &event)
     }
 }
 
+namespace pipedal
+{
+    enum class SystemMidiAction : uint16_t
+    {
+        NextBank,
+        PrevBank,
+        NextProgram,
+        PrevProgram,
+        Shutdown,
+        Reboot,
+        StartHotspot,
+        StopHotspot,
+        Snapshot1,
+        Snapshot2,
+        Snapshot3,
+        Snapshot4,
+        Snapshot5,
+        Snapshot6,
+        Count
+    };
+    constexpr uint32_t ActionBit(SystemMidiAction action) { return 1u << (uint32_t)action; }
+    constexpr uint32_t SNAPSHOT_ACTION_BITS =
+        ActionBit(SystemMidiAction::Snapshot1) | ActionBit(SystemMidiAction::Snapshot2) | ActionBit(SystemMidiAction::Snapshot3) |
+        ActionBit(SystemMidiAction::Snapshot4) | ActionBit(SystemMidiAction::Snapshot5) | ActionBit(SystemMidiAction::Snapshot6);
+
+    // System MIDI bindings, and a dispatch table that indexes them by SystemMidiAction. Built on
+    // the host thread, and handed to the audio thread to replace the previous one.
+    class SystemMidiDispatch
+    {
+    public:
+        SystemMidiDispatch(const MidiBinding *bindings)
+        {
+            for (size_t i = 0; i < (size_t)SystemMidiAction::Count; ++i)
+            {
+                const MidiBinding &binding = bindings[i];
+                this->bindings[i].SetBinding(binding);
+                if (binding.bindingType() == BINDING_TYPE_NOTE)
+                {
+                    dispatchTable.Add(MidiDispatchTable::MessageType::Note, binding.channel(), (uint8_t)binding.note(), (uint16_t)i);
+                }
+                else if (binding.bindingType() == BINDING_TYPE_CONTROL)
+                {
+                    dispatchTable.Add(MidiDispatchTable::MessageType::Control, binding.channel(), (uint8_t)binding.control(), (uint16_t)i);
+                }
+            }
+            dispatchTable.Build();
+        }
+
+        // Bit mask of the SystemMidiActions that the event triggers.
+        uint32_t GetTriggeredActions(const MidiEvent &event)
+        {
+            uint32_t result = 0;
+            for (uint16_t action : dispatchTable.Find(event.buffer, event.size))
+            {
+                if (bindings[action].IsTriggered(event))
+                {
+                    result |= ActionBit((SystemMidiAction)action);
+                }
+            }
+            return result;
+        }
+
+    private:
+        SystemMidiBinding bindings[(size_t)SystemMidiAction::Count];
+        MidiDispatchTable dispatchTable;
+    };
+}
+
 class AudioHostImpl : public AudioHost, private AudioDriverHost, private IPatchWriterCallback
 {
 private:
@@ -401,10 +459,10 @@ private:
     IHost *pHost = nullptr;
     LV2_Atom_Forge inputWriterForge;
 
-    std::mutex atomConverterMutex;
     AtomConverter atomConverter;
 
-    CpuTemperatureMonitor::ptr cpuTemperatureMonitor;
+    std::shared_ptr<SysfsSampler> sysfsSampler; // CPU frequencies, temperature and throttling.
+    SwitchLatencyMonitor &switchLatencyMonitor = SwitchLatencyMonitor::GetInstance();
     static constexpr size_t DEFERRED_MIDI_BUFFER_SIZE = 1024;
 
     uint8_t deferredMidiMessages[DEFERRED_MIDI_BUFFER_SIZE];
@@ -479,7 +537,8 @@ private:
 
     std::unique_ptr<AudioDriver> audioDriver;
 
-    std::recursive_mutex mutex;
+    // priority-inheriting: the host-side reader thread runs at realtime priority, and contends with UI threads for this mutex.
+    inverting_recursive_mutex mutex;
     int64_t overrunGracePeriodSamples = 0;
 
     IAudioHostCallbacks *pNotifyCallbacks = nullptr;
@@ -490,33 +549,62 @@ private:
     }
 
     const size_t RING_BUFFER_SIZE = 64 * 1024;
+    const size_t TELEMETRY_RING_BUFFER_SIZE = 16 * 1024;
+    const size_t BULK_RING_BUFFER_SIZE = 256 * 1024;
 
     RingBuffer<true, false> inputRingBuffer;
+    // realtime->host messages, by RingBufferClass. The host thread waits on outputRingBuffer (Control);
+    // writes to the other two wake it as well.
     RingBuffer<false, true> outputRingBuffer;
+    RingBuffer<false, true> telemetryRingBuffer;
+    RingBuffer<false, true> bulkRingBuffer;
 
     RingBufferWriter<true, false> x;
 
     RealtimeRingBufferReader realtimeReader;
     RealtimeRingBufferWriter realtimeWriter;
     HostRingBufferReader hostReader;
+    HostRingBufferReader telemetryReader;
+    HostRingBufferReader bulkReader;
     HostRingBufferWriter hostWriter;
 
-    SystemMidiBinding prevBankMidiBinding;
-    SystemMidiBinding nextBankMidiBinding;
-    SystemMidiBinding nextPresetMidiBinding;
-    SystemMidiBinding prevPresetMidiBinding;
+    // The reader with the highest-priority pending message, or nullptr if there are none.
+    HostRingBufferReader *NextHostReader()
+    {
+        for (HostRingBufferReader *reader : {&hostReader, &telemetryReader, &bulkReader})
+        {
+            if (reader->readSpace() > sizeof(RingBufferCommand))
+            {
+                return reader;
+            }
+        }
+        return nullptr;
+    }
+
+    MidiBinding systemMidiBindings[(size_t)SystemMidiAction::Count]; // host thread.
+    SystemMidiDispatch *realtimeSystemMidiDispatch = nullptr;
+
+    void SetRealtimeSystemMidiDispatch(SystemMidiDispatch *systemMidiDispatch)
+    {
+        if (this->realtimeSystemMidiDispatch != nullptr)
+        {
+            realtimeWriter.FreeSystemMidiDispatch(this->realtimeSystemMidiDispatch);
+        }
+        this->realtimeSystemMidiDispatch = systemMidiDispatch;
+    }
 
-    SystemMidiBinding snapshot1MidiBinding;
-    SystemMidiBinding snapshot2MidiBinding;
-    SystemMidiBinding snapshot3MidiBinding;
-    SystemMidiBinding snapshot4MidiBinding;
-    SystemMidiBinding snapshot5MidiBinding;
-    SystemMidiBinding snapshot6MidiBinding;
+    std::vector<AtomOutputSubscription> atomOutputSubscriptions; // host thread.
+    RealtimeAtomOutputSubscriptions *realtimeAtomOutputSubscriptions = nullptr;
 
-    SystemMidiBinding startHotspotMidiBinding;
-    SystemMidiBinding stopHotspotMidiBinding;
-    SystemMidiBinding rebootMidiBinding;
-    SystemMidiBinding shutdownMidiBinding;
+    void SetRealtimeAtomOutputSubscriptions(RealtimeAtomOutputSubscriptions *subscriptions)
+    {
+        if (this->realtimeAtomOutputSubscriptions != nullptr)
+        {
+            realtimeWriter.FreeAtomOutputSubscriptions(this->realtimeAtomOutputSubscriptions);
+        }
+        this->realtimeAtomOutputSubscriptions = subscriptions;
+        realtimeWriter.SetAtomOutputFilter(subscriptions);
+    }
 
     JackChannelSelection channelSelection;
     std::atomic<bool> active = false;
@@ -525,8 +613,47 @@ private:
 
     std::shared_ptr<Lv2Pedalboard> currentPedalboard;
     std::vector<std::shared_ptr<Lv2Pedalboard>> activePedalboards; // pedalboards that have been sent to the audio queue.
+    // Objects released by the audio thread are destroyed here, so that the reader thread doesn't wait on their destructors.
+    ReclamationQueue reclamationQueue;
     Lv2Pedalboard *realtimeActivePedalboard = nullptr;
 
+    std::shared_ptr<RealtimePedalboardSlots> currentPedalboardSlots;
+    std::vector<std::shared_ptr<RealtimePedalboardSlots>> activePedalboardSlots; // sent to the audio queue.
+    RealtimePedalboardSlots *realtimePedalboardSlots = nullptr;
+
+    enum class CrossfadeMode
+    {
+        None,
+        DualRun, // old and new pedalboards both run; equal-power crossfade.
+        FadeOut, // only the old pedalboard runs, fading out.
+        FadeIn   // only the new pedalboard runs, fading in.
+    };
+    std::atomic<float> pedalboardCrossfadeMs = 0;
+    std::atomic<uint32_t> subBlockFrames = 0;
+    std::atomic<float> controlRampMs = 0;
+    uint32_t ControlRampFrames() const
+    {
+        return (uint32_t)(controlRampMs.load(std::memory_order_relaxed) * 0.001f * sampleRate);
+    }
+    // audio thread only. Non-zero while the current period is being run in sub-blocks.
+    uint32_t realtimeSubBlockFrames = 0;
+    // audio thread only.
+    CrossfadeMode crossfadeMode = CrossfadeMode::None;
+    Lv2Pedalboard *realtimeFadingPedalboard = nullptr; // the old pedalboard, still running until the crossfade completes.
+    float crossfadeValue = 0;     // DualRun: crossfade angle, 0..pi/2. FadeOut/FadeIn: gain.
+    float crossfadeIncrement = 0; // per sample.
+    uint32_t crossfadeFrames = 0; // total length of a DualRun crossfade.
+    uint64_t realtimePedalboardRunNs = 0; // peak-hold execution time of the active pedalboard.
+    std::atomic<float> pedalboardLoad = 0;  // realtimePedalboardRunNs as a fraction of the audio period.
+    size_t realtimeFrames = 0;
+    RealtimeArena realtimeArena{RealtimeArena::DEFAULT_BLOCK_SIZE, true}; // host-side realtime buffers.
+    std::vector<float *> crossfadeBuffers; // output of the old pedalboard during a DualRun crossfade.
+    size_t crossfadeBufferSize = 0;
+    // null-terminated channel tables, sized for the driver's channel counts when audio is opened.
+    float **crossfadeBufferPointers = nullptr;
+    float **processInputBuffers = nullptr;
+    float **processOutputBuffers = nullptr;
+
     uint32_t sampleRate = 0;
     uint64_t currentSample = 0;
 
@@ -546,20 +673,62 @@ private:
 
     virtual std::string AtomToJson(const LV2_Atom *pAtom) override
     {
-        std::lock_guard lock(atomConverterMutex);
-        json_variant vAtom = atomConverter.ToJson(pAtom);
+        // AtomConverter::ToString doesn't modify the converter, so no lock is needed.
+        return atomConverter.ToString(pAtom);
+    }
+
+    MetricsPage &metricsPage = MetricsPage::GetInstance();
 
-        std::stringstream s;
-        json_writer writer(s);
+    // audio thread (or with audio stopped).
+    void PublishRealtimeMetrics()
+    {
+        using namespace std::chrono;
+        MetricsPage::RealtimeMetrics metrics;
+        metrics.underruns = this->underruns.load(std::memory_order_relaxed);
+        if (metrics.underruns != 0)
+        {
+            metrics.lastUnderrunTimeMs = duration_cast<milliseconds>(this->lastUnderrunTime.load().time_since_epoch()).count();
+        }
+        metricsPage.Write(metrics);
+    }
 
-        writer.write(vAtom);
-        return s.str();
+    // Refresh the slow-changing status values in the metrics page. Any non-realtime thread.
+    MetricsPage::HostMetrics PublishHostMetrics()
+    {
+        using namespace std::chrono;
+        MetricsPage::HostMetrics metrics;
+        metrics.updateTimeMs = duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
+        SysfsSampler::Snapshot sample = sysfsSampler->GetSnapshot();
+        if (sample.temperatureC != SysfsSampler::INVALID_TEMPERATURE)
+        {
+            metrics.temperaturemC = (int32_t)(std::round(sample.temperatureC * 1000));
+        }
+        metrics.cpuFreqMin = sample.cpuFreqMinKhz;
+        metrics.cpuFreqMax = sample.cpuFreqMaxKhz;
+        metrics.throttled = sample.throttled;
+        metrics.hasCpuGovernor = HasCpuGovernor();
+        if (metrics.hasCpuGovernor)
+        {
+            metrics.SetGovernor(GetGovernor());
+        }
+        {
+            std::lock_guard guard(mutex);
+            metrics.active = IsAudioRunning();
+            metrics.restarting = this->restarting;
+            if (this->audioDriver != nullptr)
+            {
+                metrics.cpuUsage = audioDriver->CpuUse();
+            }
+        }
+        metricsPage.Write(metrics);
+        return metrics;
     }
 
     virtual void OnUnderrun()
     {
         ++this->underruns;
         this->lastUnderrunTime = std::chrono::system_clock ::now();
+        PublishRealtimeMetrics();
     }
 
     virtual void Close()
@@ -582,6 +751,7 @@ private:
         audioDriver->Close();
 
         StopReaderThread();
+        reclamationQueue.Drain();
 
         // delete any leaked snapshots.
         CleanUpSnapshots();
@@ -589,6 +759,11 @@ private:
         // release any pdealboards owned by the process thread.
         this->activePedalboards.resize(0);
         this->realtimeActivePedalboard = nullptr;
+        this->realtimePedalboardSlots = nullptr;
+        this->activePedalboardSlots.resize(0);
+        this->currentPedalboardSlots = nullptr;
+        this->realtimeFadingPedalboard = nullptr;
+        this->crossfadeMode = CrossfadeMode::None;
 
         // clean up any realtime buffers that may have been lost in transit.
         // TODO: These should be lists, really. There may be multiple items in flight..
@@ -602,8 +777,23 @@ private:
             delete realtimeMonitorPortSubscriptions;
             realtimeMonitorPortSubscriptions = nullptr;
         }
+        if (realtimeEffectTimings != nullptr)
+        {
+            delete realtimeEffectTimings;
+            realtimeEffectTimings = nullptr;
+        }
+        // the host owns the latency probe; release a waiting MeasureRoundTripLatency.
+        this->realtimeLatencyProbe = nullptr;
+        {
+            std::lock_guard probeLock(latencyProbeMutex);
+            latencyProbeAbandoned = true;
+        }
+        latencyProbeCv.notify_all();
+
         this->inputRingBuffer.reset();
         this->outputRingBuffer.reset();
+        this->telemetryRingBuffer.reset();
+        this->bulkRingBuffer.reset();
 
         audioDriver = nullptr;
     }
@@ -616,6 +806,8 @@ private:
         }
     }
     Lv2EventBufferUrids eventBufferUrids;
+    std::vector<uint64_t> midiInputSequence; // (uint64_t for atom alignment.)
+    uint32_t midiInputStartFrame = 0;
 
     void ZeroOutputBuffers(size_t nframes)
     {
@@ -642,7 +834,102 @@ private:
         }
     }
 
+    RealtimeEffectTimings *realtimeEffectTimings = nullptr;
+
+    std::atomic<bool> overloadProtection = false;
+
+    std::atomic<bool> idle = false;              // idle power mode, as the host sees it.
+    bool realtimeIdle = false;                   // audio thread.
+    std::atomic<float> idleSignalThreshold = 0;  // 0: input signal isn't tracked.
+    std::atomic<uint64_t> lastSignalNs = 0;      // EffectTimingClockNs() when the input was last above idleSignalThreshold.
+
+    // Audio thread. True if the input rose above the idle signal threshold this period.
+    bool TrackIdleSignal(size_t nframes)
+    {
+        float threshold = idleSignalThreshold.load(std::memory_order_relaxed);
+        if (threshold == 0)
+        {
+            return false;
+        }
+        for (int i = 0; i < audioDriver->InputBufferCount(); ++i)
+        {
+            const float *input = (const float *)audioDriver->GetInputBuffer(i);
+            if (input == nullptr)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < nframes; ++j)
+            {
+                if (std::abs(input[j]) > threshold)
+                {
+                    lastSignalNs.store(EffectTimingClockNs(), std::memory_order_relaxed);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    bool clientEffectTimingSubscription = false; // protected by mutex.
+    bool pmuProfiling = false;                   // protected by mutex.
+    bool denormalDetection = false;              // protected by mutex.
+    bool pmuAttached = false;                    // protected by mutex.
+    // Captured by the audio thread, so that PMU counters can follow it.
+    std::atomic<pid_t> audioThreadId{0};
+    std::atomic<pthread_t> audioPthread{};
+    // reader thread only.
+    OverloadMonitor overloadMonitor;
+    std::vector<EffectTiming> overloadEffectTimings;
+    size_t effectTimingSamplesPerUpdate = 0;
+    int64_t effectTimingSamplesRemaining = 0;
+
+    void freeRealtimeEffectTimings()
+    {
+        if (this->realtimeEffectTimings != nullptr)
+        {
+            realtimeWriter.FreeEffectTimingSubscription(this->realtimeEffectTimings);
+            this->realtimeEffectTimings = nullptr;
+        }
+    }
+
+    void writeEffectTimings()
+    {
+        // throttled in the same way as VU updates.
+        if (!realtimeEffectTimings->waitingForAcknowledge)
+        {
+            // if the telemetry ring is full, try again next time.
+            realtimeEffectTimings->waitingForAcknowledge =
+                this->realtimeWriter.SendEffectTimings(realtimeEffectTimings->GetResult());
+        }
+    }
+
+    // The host owns the latency probe; the audio thread borrows it until the measurement is complete.
+    LatencyProbe *realtimeLatencyProbe = nullptr;
+    std::mutex latencyProbeMutex;
+    std::condition_variable latencyProbeCv;
+    std::unique_ptr<LatencyProbe> latencyProbe;
+
+    AudioRecorder recorder;
+    bool latencyProbeReturned = false;
+    bool latencyProbeAbandoned = false;
+
+    void ProcessLatencyProbe(size_t nframes)
+    {
+        size_t inputChannel = realtimeLatencyProbe->GetInputChannel();
+        size_t outputChannel = realtimeLatencyProbe->GetOutputChannel();
+        ZeroOutputBuffers(nframes);
+        realtimeLatencyProbe->Process(
+            inputChannel < audioDriver->InputBufferCount() ? audioDriver->GetInputBuffer(inputChannel) : nullptr,
+            outputChannel < audioDriver->OutputBufferCount() ? audioDriver->GetOutputBuffer(outputChannel) : nullptr,
+            nframes);
+        if (realtimeLatencyProbe->IsComplete())
+        {
+            realtimeWriter.LatencyProbeComplete(realtimeLatencyProbe);
+            realtimeLatencyProbe = nullptr;
+        }
+    }
+
     RealtimeMonitorPortSubscriptions *realtimeMonitorPortSubscriptions = nullptr;
+    std::vector<MonitorPortUpdate> hostMonitorPortUpdates;
 
     void freeRealtimeMonitorPortSubscriptions()
     {
@@ -663,36 +950,62 @@ private:
 
         if (!realtimeVuBuffers->waitingForAcknowledge)
         {
-            auto pResult = realtimeVuBuffers->GetResult(currentSample);
-
-            this->realtimeWriter.SendVuUpdate(pResult);
-            realtimeVuBuffers->waitingForAcknowledge = true;
+            if (realtimeVuBuffers->GetResult(currentSample) != 0)
+            {
+                realtimeVuBuffers->waitingForAcknowledge = this->realtimeWriter.SendVuUpdate(realtimeVuBuffers);
+            }
         }
     }
 
     void processMonitorPortSubscriptions(uint32_t nframes)
     {
-        for (size_t i = 0; i < this->realtimeMonitorPortSubscriptions->subscriptions.size(); ++i)
+        // Subscriptions with the same update interval are sampled together, and only values that have
+        // changed by more than the subscription's epsilon are sent, in one message per group. A group
+        // doesn't send again until the host has acknowledged the previous message.
+        RealtimeMonitorPortSubscriptions *pSubscriptions = this->realtimeMonitorPortSubscriptions;
+        for (size_t groupIndex = 0; groupIndex < pSubscriptions->groups.size(); ++groupIndex)
         {
-            auto &portSubscription = realtimeMonitorPortSubscriptions->subscriptions[i];
+            RealtimeMonitorPortGroup &group = pSubscriptions->groups[groupIndex];
 
-            portSubscription.samplesToNextCallback -= portSubscription.sampleRate;
-            if (portSubscription.samplesToNextCallback < 0)
+            group.samplesToNextCallback -= (int)nframes;
+            if (group.samplesToNextCallback >= 0)
+            {
+                continue;
+            }
+            group.samplesToNextCallback += group.sampleInterval;
+            if (group.samplesToNextCallback < 0) // interval shorter than a period.
+            {
+                group.samplesToNextCallback = group.sampleInterval;
+            }
+            if (group.waitingForAck)
+            {
+                continue;
+            }
+            size_t count = 0;
+            MonitorPortUpdate *updates = pSubscriptions->updateBuffer.data();
+            for (size_t i = group.begin; i < group.end; ++i)
+            {
+                auto &portSubscription = pSubscriptions->subscriptions[i];
+                portSubscription.sampledValue = realtimeActivePedalboard->GetControlOutputValue(
+                    portSubscription.instanceIndex,
+                    portSubscription.portIndex);
+                if (portSubscription.HasChanged())
+                {
+                    MonitorPortUpdate &update = updates[count++];
+                    update.callbackPtr = portSubscription.callbackPtr;
+                    update.subscriptionHandle = portSubscription.subscriptionHandle;
+                    update.value = portSubscription.sampledValue;
+                }
+            }
+            if (count != 0 && this->realtimeWriter.SendMonitorPortUpdates(pSubscriptions, groupIndex, count, updates))
             {
-                portSubscription.samplesToNextCallback += portSubscription.sampleRate;
-                if (!portSubscription.waitingForAck)
+                group.waitingForAck = true;
+                for (size_t i = group.begin; i < group.end; ++i)
                 {
-                    float value = realtimeActivePedalboard->GetControlOutputValue(
-                        portSubscription.instanceIndex,
-                        portSubscription.portIndex);
-                    if (value != portSubscription.lastValue)
+                    auto &portSubscription = pSubscriptions->subscriptions[i];
+                    if (portSubscription.HasChanged())
                     {
-                        portSubscription.waitingForAck = true;
-                        portSubscription.lastValue = value;
-                        this->realtimeWriter.SendMonitorPortUpdate(
-                            portSubscription.callbackPtr,
-                            portSubscription.subscriptionHandle,
-                            value);
+                        portSubscription.CommitSampledValue();
                     }
                 }
             }
@@ -700,6 +1013,7 @@ private:
     }
 
     RealtimePatchPropertyRequest *pParameterRequests = nullptr;
+    RealtimePatchPropertyRequest *pActiveParameterRequests = nullptr; // PatchGet requests waiting for a response this period.
 
     void cancelParameterRequests()
     {
@@ -747,6 +1061,34 @@ private:
                 this->realtimeActivePedalboard->SetControlValue(body.effectIndex, body.controlIndex, body.value);
                 break;
             }
+            case RingBufferCommand::SetValues:
+            {
+                SetControlValuesBody body;
+                realtimeReader.readComplete(&body);
+                size_t dataLength;
+                realtimeReader.read(&dataLength);
+                for (uint32_t i = 0; i < body.count; ++i)
+                {
+                    ControlIndexValue value;
+                    realtimeReader.read(&value);
+                    if (value.ramp && body.rampFrames != 0)
+                    {
+                        this->realtimeActivePedalboard->RampControlValue(body.effectIndex, value.controlIndex, value.value, body.rampFrames);
+                    }
+                    else
+                    {
+                        this->realtimeActivePedalboard->SetControlValue(body.effectIndex, value.controlIndex, value.value);
+                    }
+                }
+                break;
+            }
+            case RingBufferCommand::SetIdle:
+            {
+                bool idle;
+                realtimeReader.readComplete(&idle);
+                this->realtimeIdle = idle;
+                break;
+            }
             case RingBufferCommand::SetInputVolume:
             {
                 SetVolumeBody body;
@@ -782,19 +1124,70 @@ private:
 
                 break;
             }
-            case RingBufferCommand::AckMonitorPortUpdate:
+            case RingBufferCommand::AckEffectTimings:
             {
-                int64_t subscriptionHandle = 0;
-                realtimeReader.readComplete(&subscriptionHandle);
-                if (this->realtimeMonitorPortSubscriptions != nullptr)
+                bool dummy;
+                realtimeReader.readComplete(&dummy);
+                if (this->realtimeEffectTimings)
                 {
-                    for (size_t i = 0; i < this->realtimeMonitorPortSubscriptions->subscriptions.size(); ++i)
-                    {
-                        if (this->realtimeMonitorPortSubscriptions->subscriptions[i].subscriptionHandle == subscriptionHandle)
-                        {
-                            this->realtimeMonitorPortSubscriptions->subscriptions[i].waitingForAck = false;
-                        }
-                    }
+                    this->realtimeEffectTimings->waitingForAcknowledge = false;
+                }
+                break;
+            }
+            case RingBufferCommand::SetPedalboardSlots:
+            {
+                RealtimePedalboardSlots *slots;
+                realtimeReader.readComplete(&slots);
+                if (this->realtimePedalboardSlots != nullptr)
+                {
+                    realtimeWriter.FreePedalboardSlots(this->realtimePedalboardSlots);
+                }
+                this->realtimePedalboardSlots = slots;
+                break;
+            }
+            case RingBufferCommand::SetSystemMidiDispatch:
+            {
+                SystemMidiDispatch *systemMidiDispatch;
+                realtimeReader.readComplete(&systemMidiDispatch);
+                SetRealtimeSystemMidiDispatch(systemMidiDispatch);
+                break;
+            }
+            case RingBufferCommand::SetAtomOutputSubscriptions:
+            {
+                RealtimeAtomOutputSubscriptions *subscriptions;
+                realtimeReader.readComplete(&subscriptions);
+                SetRealtimeAtomOutputSubscriptions(subscriptions);
+                break;
+            }
+            case RingBufferCommand::SetLatencyProbe:
+            {
+                LatencyProbe *probe;
+                realtimeReader.readComplete(&probe);
+                if (this->realtimeLatencyProbe != nullptr)
+                {
+                    // cancelled.
+                    realtimeWriter.LatencyProbeComplete(this->realtimeLatencyProbe);
+                }
+                this->realtimeLatencyProbe = probe;
+                break;
+            }
+            case RingBufferCommand::SetEffectTimingSubscription:
+            {
+                RealtimeEffectTimings *timings;
+                realtimeReader.readComplete(&timings);
+                this->freeRealtimeEffectTimings();
+                this->realtimeEffectTimings = timings;
+                effectTimingSamplesRemaining = effectTimingSamplesPerUpdate;
+                break;
+            }
+            case RingBufferCommand::AckMonitorPortUpdates:
+            {
+                MonitorPortUpdatesBody body;
+                realtimeReader.readComplete(&body);
+                // ignore acks for subscriptions that have since been replaced.
+                if (this->realtimeMonitorPortSubscriptions != nullptr && body.subscriptions == this->realtimeMonitorPortSubscriptions && body.groupIndex < this->realtimeMonitorPortSubscriptions->groups.size())
+                {
+                    this->realtimeMonitorPortSubscriptions->groups[body.groupIndex].waitingForAck = false;
                 }
                 break;
             }
@@ -843,8 +1236,8 @@ private:
                 if (this->realtimeVuBuffers != nullptr)
                 {
                     this->realtimeVuBuffers->waitingForAcknowledge = false;
+                    vuSamplesRemaining = this->realtimeVuBuffers->samplesPerUpdate;
                 }
-                vuSamplesRemaining = vuSamplesPerUpdate;
 
                 break;
             }
@@ -862,14 +1255,18 @@ private:
 
                 if (body.effect != nullptr)
                 {
+                    writeMidiValueChanges(); // before any changes made by the new pedalboard.
+                    writePathPropertyBuffers();
                     auto oldValue = this->realtimeActivePedalboard;
                     this->realtimeActivePedalboard = body.effect;
+                    switchLatencyMonitor.OnApplied();
 
-                    realtimeWriter.EffectReplaced(oldValue);
+                    StartPedalboardCrossfade(oldValue, body.effect);
 
                     // invalidate the possibly no-good subscriptions. Model will update them shortly.
                     freeRealtimeVuConfiguration();
                     freeRealtimeMonitorPortSubscriptions();
+                    freeRealtimeEffectTimings();
                     cancelParameterRequests();
 
                     if (realtimeActivePedalboard)
@@ -897,26 +1294,108 @@ private:
 
     void ApplySnapshot(IndexedSnapshot *snapshot)
     {
-        auto &effects = this->realtimeActivePedalboard->GetEffects();
-        snapshot->Apply(effects);
+        uint64_t startNs = EffectTimingClockNs();
+        snapshot->Apply(this->realtimeActivePedalboard, ControlRampFrames());
+        snapshot->applyNs = EffectTimingClockNs() - startNs;
+        switchLatencyMonitor.OnApplied();
     }
     virtual void AckMidiProgramRequest(uint64_t requestId)
     {
+        switchLatencyMonitor.OnAcknowledged();
         hostWriter.AckMidiProgramRequest(requestId);
     }
     virtual void AckSnapshotRequest(uint64_t snapshotRequestId)
     {
+        switchLatencyMonitor.OnAcknowledged();
         hostWriter.AckMidiSnapshotRequest(snapshotRequestId);
     }
 
+    // MIDI value changes are coalesced on the realtime thread, and sent to the host once per VU update interval,
+    // so that an expression pedal doesn't generate a UI notification for every CC message.
+    static constexpr size_t MAX_PENDING_MIDI_VALUE_CHANGES = 64;
+    MidiValueChange pendingMidiValueChanges[MAX_PENDING_MIDI_VALUE_CHANGES];
+    size_t pendingMidiValueChangeCount = 0;
+    int64_t midiValueSamplesRemaining = 0;
+    std::vector<MidiValueChange> hostMidiValueChanges;
+    std::vector<VuUpdate> hostVuUpdates;
+
+    void writeMidiValueChanges()
+    {
+        if (pendingMidiValueChangeCount != 0)
+        {
+            realtimeWriter.MidiValuesChanged(pendingMidiValueChangeCount, pendingMidiValueChanges);
+            pendingMidiValueChangeCount = 0;
+        }
+    }
+    void updateMidiValueChanges(size_t nframes)
+    {
+        midiValueSamplesRemaining -= nframes;
+        if (midiValueSamplesRemaining > 0)
+        {
+            return;
+        }
+        if (pendingMidiValueChangeCount == 0)
+        {
+            // idle: send the next change at the end of the period in which it arrives.
+            midiValueSamplesRemaining = 0;
+            return;
+        }
+        writeMidiValueChanges();
+        midiValueSamplesRemaining += vuSamplesPerUpdate;
+    }
+
     void OnMidiValueChanged(uint64_t instanceId, int controlIndex, float value)
     {
-        realtimeWriter.MidiValueChanged(instanceId, controlIndex, value);
+        for (size_t i = 0; i < pendingMidiValueChangeCount; ++i)
+        {
+            MidiValueChange &change = pendingMidiValueChanges[i];
+            if (change.instanceId == (int64_t)instanceId && change.controlIndex == controlIndex)
+            {
+                change.value = value;
+                return;
+            }
+        }
+        if (pendingMidiValueChangeCount == MAX_PENDING_MIDI_VALUE_CHANGES)
+        {
+            writeMidiValueChanges();
+        }
+        MidiValueChange &change = pendingMidiValueChanges[pendingMidiValueChangeCount++];
+        change.instanceId = (int64_t)instanceId;
+        change.controlIndex = controlIndex;
+        change.value = value;
+    }
+    // Path property buffers published during a period are sent to the host in a single message at the end of the period.
+    static constexpr size_t MAX_PENDING_PATH_PROPERTY_BUFFERS = 64;
+    PatchPropertyWriter::Buffer *pendingPathPropertyBuffers[MAX_PENDING_PATH_PROPERTY_BUFFERS];
+    size_t pendingPathPropertyBufferCount = 0;
+    std::vector<PatchPropertyWriter::Buffer *> hostPathPropertyBuffers;
+
+    bool writePathPropertyBuffers()
+    {
+        if (pendingPathPropertyBufferCount != 0)
+        {
+            if (!realtimeWriter.SendPathPropertyBuffers(pendingPathPropertyBufferCount, pendingPathPropertyBuffers))
+            {
+                // ringbuffer full. Keep them, and try again next period.
+                return false;
+            }
+            pendingPathPropertyBufferCount = 0;
+        }
+        return true;
     }
+
     static void fnMidiValueChanged(void *data, uint64_t instanceId, int controlIndex, float value)
     {
         ((AudioHostImpl *)data)->OnMidiValueChanged(instanceId, controlIndex, value);
     }
+    static void fnMidiOutput(void *data, size_t size, const uint8_t *message)
+    {
+        AudioHostImpl *this_ = (AudioHostImpl *)data;
+        if (this_->alsaSequencer)
+        {
+            this_->alsaSequencer->WriteMessage(message, size);
+        }
+    }
     static bool isBankChange(MidiEvent &event)
     {
         return (event.size == 3 && event.buffer[0] == 0xB0 && event.buffer[1] == 0x00);
@@ -924,7 +1403,11 @@ private:
 
     bool onMidiEvent(Lv2EventBufferWriter &eventBufferWriter, Lv2EventBufferWriter::LV2_EvBuf_Iterator &iterator, MidiEvent &event)
     {
-        // eventBufferWriter.writeMidiEvent(iterator, 0, event.size, event.buffer);
+        if (this->realtimeActivePedalboard->HasMidiInput())
+        {
+            uint32_t frameOffset = event.time > midiInputStartFrame ? event.time - midiInputStartFrame : 0;
+            eventBufferWriter.writeMidiEvent(iterator, frameOffset, event.size, event.buffer);
+        }
 
         this->realtimeActivePedalboard->OnMidiMessage(event.size, event.buffer, this, fnMidiValueChanged);
         if (listenForMidiEvent)
@@ -953,20 +1436,23 @@ private:
         return true;
     }
 
-    void OnSnapshotTriggered(int snapshotIndex)
+    void OnSnapshotTriggered(int snapshotIndex, const MidiEvent &event)
     {
         // midiProgramChangePending = true;
         this->midiSnapshotRequestPending = true;
+        switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
         this->realtimeWriter.OnRealtimeMidiSnapshotRequest(snapshotIndex, ++snapshotRequestId);
     }
 
     void ProcessMidiEvent(Lv2EventBufferWriter &eventBufferWriter, Lv2EventBufferWriter::LV2_EvBuf_Iterator &iterator, MidiEvent &event)
     {
         uint8_t midiCommand = (uint8_t)(event.buffer[0] & 0xF0);
+        uint32_t triggeredActions = realtimeSystemMidiDispatch ? realtimeSystemMidiDispatch->GetTriggeredActions(event) : 0;
         if (midiCommand == 0xC0) // midi program change.
         {
             this->deferredMidiMessageCount = 0; // we can discard previous control changes.
             midiProgramChangePending = true;
+            switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
 
             this->realtimeWriter.OnMidiProgramChange(++(this->midiProgramChangeId), selectedBank, event.buffer[1]);
         }
@@ -974,48 +1460,51 @@ private:
         {
             this->selectedBank = event.buffer[2];
         }
-        else if (this->nextBankMidiBinding.IsTriggered(event))
+        else if (triggeredActions & ActionBit(SystemMidiAction::NextBank))
         {
             this->deferredMidiMessageCount = 0; // we can discard previous control changes.
             midiProgramChangePending = true;
+            switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
 
             this->realtimeWriter.OnNextMidiBank(++(this->midiProgramChangeId), 1);
         }
-        else if (this->prevBankMidiBinding.IsTriggered(event))
+        else if (triggeredActions & ActionBit(SystemMidiAction::PrevBank))
         {
             this->deferredMidiMessageCount = 0; // we can discard previous control changes.
             midiProgramChangePending = true;
+            switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
 
             this->realtimeWriter.OnNextMidiBank(++(this->midiProgramChangeId), -1);
         }
-        else if (nextPresetMidiBinding.IsTriggered(event))
+        else if (triggeredActions & ActionBit(SystemMidiAction::NextProgram))
         {
             this->deferredMidiMessageCount = 0; // we can discard previous control changes.
             midiProgramChangePending = true;
+            switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
 
-            midiProgramChangePending = true;
             this->realtimeWriter.OnNextMidiProgram(++(this->midiProgramChangeId), 1);
         }
-        else if (prevPresetMidiBinding.IsTriggered(event))
+        else if (triggeredActions & ActionBit(SystemMidiAction::PrevProgram))
         {
             this->deferredMidiMessageCount = 0; // we can discard previous control changes.
             midiProgramChangePending = true;
+            switchLatencyMonitor.OnMidiDispatched(event.receivedNs);
             this->realtimeWriter.OnNextMidiProgram(++(this->midiProgramChangeId), -1);
         }
 
-        else if (shutdownMidiBinding.IsTriggered(event))
+        else if (triggeredActions & ActionBit(SystemMidiAction::Shutdown))
         {
             this->realtimeWriter.OnRealtimeMidiEvent(RealtimeMidiEventType::Shutdown);
         }
-        if (rebootMidiBinding.IsTriggered(event))
+        if (triggeredActions & ActionBit(SystemMidiAction::Reboot))
         {
             this->realtimeWriter.OnRealtimeMidiEvent(RealtimeMidiEventType::Reboot);
         }
-        if (startHotspotMidiBinding.IsTriggered(event))
+        if (triggeredActions & ActionBit(SystemMidiAction::StartHotspot))
         {
             this->realtimeWriter.OnRealtimeMidiEvent(RealtimeMidiEventType::StartHotspot);
         }
-        if (stopHotspotMidiBinding.IsTriggered(event))
+        if (triggeredActions & ActionBit(SystemMidiAction::StopHotspot))
         {
             this->realtimeWriter.OnRealtimeMidiEvent(RealtimeMidiEventType::StopHotspot);
         }
@@ -1032,29 +1521,16 @@ private:
             }
             return;
         }
-        else if (this->snapshot1MidiBinding.IsTriggered(event))
-        {
-            OnSnapshotTriggered(0);
-        }
-        else if (this->snapshot2MidiBinding.IsTriggered(event))
-        {
-            OnSnapshotTriggered(1);
-        }
-        else if (this->snapshot3MidiBinding.IsTriggered(event))
-        {
-            OnSnapshotTriggered(2);
-        }
-        else if (this->snapshot4MidiBinding.IsTriggered(event))
-        {
-            OnSnapshotTriggered(3);
-        }
-        else if (this->snapshot5MidiBinding.IsTriggered(event))
-        {
-            OnSnapshotTriggered(4);
-        }
-        else if (this->snapshot6MidiBinding.IsTriggered(event))
+        else if (triggeredActions & SNAPSHOT_ACTION_BITS)
         {
-            OnSnapshotTriggered(5);
+            for (int i = 0; i < 6; ++i)
+            {
+                if (triggeredActions & ActionBit((SystemMidiAction)((int)SystemMidiAction::Snapshot1 + i)))
+                {
+                    OnSnapshotTriggered(i, event);
+                    break;
+                }
+            }
         }
         else
         {
@@ -1063,7 +1539,7 @@ private:
     }
 
     void ProcessDeferredMidiMessages(
-        Lv2EventBufferWriter eventBufferWriter,
+        Lv2EventBufferWriter &eventBufferWriter,
         Lv2EventBufferWriter::LV2_EvBuf_Iterator &iterator)
     {
         MidiEvent event;
@@ -1101,12 +1577,21 @@ private:
             }
         }
     }
-    void ProcessMidiInput()
+    // Process MIDI events with times in [startFrame,endFrame).
+    void ProcessMidiInput(uint32_t startFrame = 0, uint32_t endFrame = UINT32_MAX)
     {
-        Lv2EventBufferWriter eventBufferWriter(this->eventBufferUrids);
+        // The sub-block's MIDI is written once, and shared by all of the plugins with MIDI input.
+        Lv2EventBufferWriter eventBufferWriter(
+            this->eventBufferUrids,
+            (uint8_t *)this->midiInputSequence.data(),
+            this->midiInputSequence.size() * sizeof(this->midiInputSequence[0]));
         Lv2EventBufferWriter::LV2_EvBuf_Iterator iterator = eventBufferWriter.begin();
+        this->midiInputStartFrame = startFrame;
 
-        ProcessDeferredMidiMessages(eventBufferWriter, iterator);
+        if (startFrame == 0)
+        {
+            ProcessDeferredMidiMessages(eventBufferWriter, iterator);
+        }
 
         {
             size_t n = audioDriver->GetMidiInputEventCount();
@@ -1114,14 +1599,36 @@ private:
 
             for (size_t i = 0; i < n; ++i)
             {
-                ProcessMidiEvent(eventBufferWriter, iterator, events[i]);
+                if (events[i].time >= startFrame && events[i].time < endFrame)
+                {
+                    ProcessMidiEvent(eventBufferWriter, iterator, events[i]);
+                }
             }
         }
+        if (!eventBufferWriter.empty())
+        {
+            this->realtimeActivePedalboard->WriteMidiInput(eventBufferWriter.sequence());
+        }
     }
 
-#define RESET_XRUN_SAMPLES 22050ul // 1/2 a second-ish.
+    // Audio thread. Called by Lv2Pedalboard::RunSubBlocks before each sub-block of the active pedalboard.
+    static void OnSubBlock(void *handle, uint32_t offset, uint32_t frames)
+    {
+        AudioHostImpl *this_ = (AudioHostImpl *)handle;
+        Lv2Pedalboard *pedalboard = this_->realtimeActivePedalboard;
+        if (offset != 0)
+        {
+            // collect atom output from the previous sub-block before the buffers are reused.
+            pedalboard->GatherPatchProperties(this_->pActiveParameterRequests);
+            pedalboard->GatherPathPatchProperties(this_);
+            pedalboard->WriteMidiOutput(this_, fnMidiOutput);
+            pedalboard->ResetAtomBuffers();
+        }
+        bool lastSubBlock = offset + frames >= this_->realtimeFrames;
+        this_->ProcessMidiInput(offset, lastSubBlock ? UINT32_MAX : offset + frames);
+    }
 
-    std::mutex audioStoppedMutex;
+#define RESET_XRUN_SAMPLES 22050ul // 1/2 a second-ish.
 
     bool IsAudioRunning()
     {
@@ -1140,8 +1647,227 @@ private:
         Lv2Log::info("Audio thread terminated.");
     }
 
+    void FinishPedalboardCrossfade()
+    {
+        if (realtimeFadingPedalboard != nullptr)
+        {
+            realtimeWriter.EffectReplaced(realtimeFadingPedalboard);
+            realtimeFadingPedalboard = nullptr;
+        }
+        crossfadeMode = CrossfadeMode::None;
+    }
+
+    // Audio thread. Decides how to get from oldPedalboard to newPedalboard. oldPedalboard is released
+    // (EffectReplaced) once the crossfade completes.
+    void StartPedalboardCrossfade(Lv2Pedalboard *oldPedalboard, Lv2Pedalboard *newPedalboard)
+    {
+        if (crossfadeMode == CrossfadeMode::FadeOut)
+        {
+            // the pending pedalboard never made a sound. Keep fading out, and then fade in the new one.
+            realtimeWriter.EffectReplaced(oldPedalboard);
+            return;
+        }
+        FinishPedalboardCrossfade();
+
+        float crossfadeMs = pedalboardCrossfadeMs.load(std::memory_order_relaxed);
+        // Borrowed effects are shared with the old pedalboard, so the old pedalboard can't run any more.
+        if (crossfadeMs <= 0 || oldPedalboard == nullptr || newPedalboard->HasBorrowedEffects() || realtimeFrames == 0)
+        {
+            realtimeWriter.EffectReplaced(oldPedalboard);
+            return;
+        }
+        realtimeFadingPedalboard = oldPedalboard;
+
+        // Assume the new pedalboard costs about the same as the old one. If it doesn't, the crossfade gets cut short.
+        double budgetNs = realtimeFrames * 1E9 / sampleRate;
+        bool canDualRun =
+            !crossfadeBuffers.empty() && realtimeFrames <= crossfadeBufferSize &&
+            realtimePedalboardRunNs * 2 < budgetNs * CROSSFADE_CPU_LIMIT;
+        if (canDualRun)
+        {
+            crossfadeMode = CrossfadeMode::DualRun;
+            crossfadeFrames = std::max((uint32_t)1, (uint32_t)(crossfadeMs * 0.001 * sampleRate));
+            crossfadeValue = 0;
+            crossfadeIncrement = (float)(M_PI / 2 / crossfadeFrames);
+        }
+        else
+        {
+            uint32_t fadeFrames = std::max((uint32_t)1, (uint32_t)(std::min(crossfadeMs * 0.001 / 2, FAST_FADE_S) * sampleRate));
+            crossfadeMode = CrossfadeMode::FadeOut;
+            crossfadeValue = 1;
+            crossfadeIncrement = 1.0f / fadeFrames;
+        }
+    }
+
+    float **GetCrossfadeBuffers(size_t nChannels)
+    {
+        for (size_t i = 0; i < nChannels; ++i)
+        {
+            crossfadeBufferPointers[i] = crossfadeBuffers[i];
+        }
+        crossfadeBufferPointers[nChannels] = nullptr;
+        return crossfadeBufferPointers;
+    }
+
+    bool TimedRun(Lv2Pedalboard *pedalboard, float **inputBuffers, float **outputBuffers, uint32_t nframes, RealtimeEffectTimings *effectTimings, uint64_t *elapsedNs)
+    {
+        uint64_t startNs = EffectTimingClockNs();
+        bool result;
+        if (pedalboard == realtimeActivePedalboard && realtimeSubBlockFrames != 0)
+        {
+            result = pedalboard->RunSubBlocks(
+                inputBuffers, outputBuffers, nframes, realtimeSubBlockFrames,
+                this, OnSubBlock,
+                &realtimeWriter, effectTimings);
+        }
+        else
+        {
+            result = pedalboard->Run(inputBuffers, outputBuffers, nframes, &realtimeWriter, effectTimings);
+        }
+        *elapsedNs = EffectTimingClockNs() - startNs;
+        return result;
+    }
+
+    // Audio thread. Run the active pedalboard, and the old pedalboard too if a crossfade is in progress.
+    bool RunPedalboards(Lv2Pedalboard *pedalboard, float **inputBuffers, float **outputBuffers, uint32_t nframes)
+    {
+        // (fewer than the driver's outputs if there are pedalboard slots.)
+        size_t nOutputs = 0;
+        while (outputBuffers[nOutputs] != nullptr)
+        {
+            ++nOutputs;
+        }
+        uint64_t runNs = 0;
+        bool processed;
+
+        switch (crossfadeMode)
+        {
+        case CrossfadeMode::None:
+        default:
+            processed = TimedRun(pedalboard, inputBuffers, outputBuffers, nframes, this->realtimeEffectTimings, &runNs);
+            break;
+        case CrossfadeMode::DualRun:
+        {
+            uint64_t oldRunNs = 0;
+            realtimeFadingPedalboard->ResetAtomBuffers();
+            float **oldOutputs = GetCrossfadeBuffers(nOutputs);
+            processed = TimedRun(realtimeFadingPedalboard, inputBuffers, oldOutputs, nframes, nullptr, &oldRunNs);
+            processed = TimedRun(pedalboard, inputBuffers, outputBuffers, nframes, this->realtimeEffectTimings, &runNs) && processed;
+            if (!processed)
+            {
+                FinishPedalboardCrossfade();
+                break;
+            }
+            // equal-power gains, advanced by rotation so there are only two sin/cos evaluations per period.
+            float angle = crossfadeValue;
+            float cosDelta = std::cos(crossfadeIncrement), sinDelta = std::sin(crossfadeIncrement);
+            // samples past the end of the crossfade are left as they are (new pedalboard only).
+            uint32_t fadeFrames = (uint32_t)std::min(
+                (double)nframes,
+                (double)std::ceil(((float)(M_PI / 2) - angle) / crossfadeIncrement));
+            for (size_t c = 0; c < nOutputs; ++c)
+            {
+                float *restrict out = outputBuffers[c];
+                const float *restrict old = oldOutputs[c];
+                float gOld = std::cos(angle), gNew = std::sin(angle);
+                for (uint32_t i = 0; i < fadeFrames; ++i)
+                {
+                    out[i] = out[i] * gNew + old[i] * gOld;
+                    float t = gOld * cosDelta - gNew * sinDelta;
+                    gNew = gNew * cosDelta + gOld * sinDelta;
+                    gOld = t;
+                }
+            }
+            crossfadeValue += crossfadeIncrement * nframes;
+            if (crossfadeValue >= (float)(M_PI / 2))
+            {
+                FinishPedalboardCrossfade();
+            }
+            else if (oldRunNs + runNs > nframes * 1E9 / sampleRate * CROSSFADE_CPU_LIMIT)
+            {
+                // Both pedalboards don't fit. finish the crossfade over the next period.
+                crossfadeIncrement = ((float)(M_PI / 2) - crossfadeValue) / nframes;
+            }
+            runNs = std::max(runNs, oldRunNs);
+            break;
+        }
+        case CrossfadeMode::FadeOut:
+        {
+            realtimeFadingPedalboard->ResetAtomBuffers();
+            processed = TimedRun(realtimeFadingPedalboard, inputBuffers, outputBuffers, nframes, nullptr, &runNs);
+            float gain = 0;
+            for (size_t c = 0; c < nOutputs; ++c)
+            {
+                float *restrict out = outputBuffers[c];
+                gain = crossfadeValue;
+                for (uint32_t i = 0; i < nframes; ++i)
+                {
+                    out[i] *= gain;
+                    gain = std::max(0.0f, gain - crossfadeIncrement);
+                }
+            }
+            crossfadeValue = gain;
+            if (gain <= 0 || !processed)
+            {
+                realtimeWriter.EffectReplaced(realtimeFadingPedalboard);
+                realtimeFadingPedalboard = nullptr;
+                crossfadeMode = CrossfadeMode::FadeIn;
+                crossfadeValue = 0;
+            }
+            processed = true;
+            break;
+        }
+        case CrossfadeMode::FadeIn:
+        {
+            processed = TimedRun(pedalboard, inputBuffers, outputBuffers, nframes, this->realtimeEffectTimings, &runNs);
+            float gain = 1;
+            for (size_t c = 0; c < nOutputs; ++c)
+            {
+                float *restrict out = outputBuffers[c];
+                gain = crossfadeValue;
+                for (uint32_t i = 0; i < nframes; ++i)
+                {
+                    out[i] *= gain;
+                    gain = std::min(1.0f, gain + crossfadeIncrement);
+                }
+            }
+            crossfadeValue = gain;
+            if (gain >= 1)
+            {
+                crossfadeMode = CrossfadeMode::None;
+            }
+            break;
+        }
+        }
+        // peak-hold, decaying by ~1.5% per period.
+        if (runNs > realtimePedalboardRunNs)
+        {
+            realtimePedalboardRunNs = runNs;
+        }
+        else
+        {
+            realtimePedalboardRunNs -= realtimePedalboardRunNs >> 6;
+        }
+        if (overloadProtection.load(std::memory_order_relaxed))
+        {
+            pedalboardLoad.store((float)(realtimePedalboardRunNs * 1E-9 * sampleRate / nframes), std::memory_order_relaxed);
+        }
+        return processed;
+    }
+
     virtual void OnProcess(size_t nframes)
     {
+        if (audioThreadId.load(std::memory_order_relaxed) == 0)
+        {
+            // once per stream. (Outside the tripwire scope: attaching the watchdog registers a thread_local destructor.)
+            audioPthread.store(pthread_self(), std::memory_order_relaxed);
+            audioThreadId.store(gettid(), std::memory_order_release);
+            RealtimeWatchdog::AttachThread("audio");
+        }
+        RealtimeTripwire::ThreadScope tripwireScope;
+        RealtimeWatchdog::PeriodScope watchdogPeriod;
+        // every period, since plugins occasionally change it.
+        Denormals::ApplyPolicy();
         try
         {
             float * restrict in , * restrict out;
@@ -1152,6 +1878,7 @@ private:
             {
                 pedalboard->ResetAtomBuffers();
             }
+            this->realtimeFrames = nframes;
             while (true)
             {
 
@@ -1163,15 +1890,39 @@ private:
                 pedalboard = this->realtimeActivePedalboard;
             }
 
+            bool signal = TrackIdleSignal(nframes);
+            if (realtimeIdle)
+            {
+                if (!signal && audioDriver->GetMidiInputEventCount() == 0 &&
+                    pParameterRequests == nullptr && realtimeLatencyProbe == nullptr)
+                {
+                    ZeroOutputBuffers(nframes);
+                    this->currentSample += nframes;
+                    return;
+                }
+                // run this period, so the first note isn't lost.
+                realtimeIdle = false;
+                realtimeWriter.IdleWake();
+            }
+
             bool processed = false;
 
             if (pedalboard != nullptr)
             {
-                ProcessMidiInput();
-                float *inputBuffers[4];
-                float *outputBuffers[4];
+                // (the active pedalboard doesn't run while the old pedalboard fades out.)
+                uint32_t subBlockFrames = this->subBlockFrames.load(std::memory_order_relaxed);
+                this->realtimeSubBlockFrames =
+                    (subBlockFrames != 0 && subBlockFrames < nframes && crossfadeMode != CrossfadeMode::FadeOut)
+                        ? subBlockFrames
+                        : 0;
+                if (this->realtimeSubBlockFrames == 0)
+                {
+                    ProcessMidiInput();
+                }
+                float **inputBuffers = this->processInputBuffers;
+                float **outputBuffers = this->processOutputBuffers;
                 bool buffersValid = true;
-                for (int i = 0; i < audioDriver->InputBufferCount(); ++i)
+                for (int i = 0; buffersValid && i < audioDriver->InputBufferCount(); ++i)
                 {
                     float *input = (float *)audioDriver->GetInputBuffer(i);
                     if (input == nullptr)
@@ -1183,7 +1934,7 @@ private:
                 }
                 inputBuffers[audioDriver->InputBufferCount()] = nullptr;
 
-                for (int i = 0; i < audioDriver->OutputBufferCount(); ++i)
+                for (int i = 0; buffersValid && i < audioDriver->OutputBufferCount(); ++i)
                 {
                     float *output = audioDriver->GetOutputBuffer(i);
                     if (output == nullptr)
@@ -1195,22 +1946,55 @@ private:
                 }
                 outputBuffers[audioDriver->OutputBufferCount()] = nullptr;
 
+                if (!buffersValid && this->realtimeSubBlockFrames != 0)
+                {
+                    ProcessMidiInput();
+                }
                 if (buffersValid)
                 {
-                    pedalboard->ProcessParameterRequests(pParameterRequests,nframes);
+                    pActiveParameterRequests = pedalboard->ProcessParameterRequests(pParameterRequests,nframes);
 
-                    processed = pedalboard->Run(inputBuffers, outputBuffers, (uint32_t)nframes, &realtimeWriter);
+                    float **pedalboardInputs = inputBuffers;
+                    float **pedalboardOutputs = outputBuffers;
+                    RealtimePedalboardSlots *slots = this->realtimePedalboardSlots;
+                    if (slots != nullptr)
+                    {
+                        pedalboardInputs = slots->GetMainInputs(inputBuffers);
+                        pedalboardOutputs = slots->GetMainOutputs(outputBuffers);
+                        slots->Start(inputBuffers, outputBuffers, (uint32_t)nframes);
+                    }
+                    processed = RunPedalboards(pedalboard, pedalboardInputs, pedalboardOutputs, (uint32_t)nframes);
+                    if (slots != nullptr)
+                    {
+                        slots->Wait((uint32_t)nframes);
+                    }
                     if (processed)
                     {
+                        if (recorder.IsRecording())
+                        {
+                            recorder.Write(
+                                inputBuffers, (uint32_t)audioDriver->InputBufferCount(),
+                                outputBuffers, (uint32_t)audioDriver->OutputBufferCount(),
+                                (uint32_t)nframes, this->sampleRate);
+                        }
+                        if (this->realtimeEffectTimings != nullptr)
+                        {
+                            effectTimingSamplesRemaining -= nframes;
+                            if (effectTimingSamplesRemaining <= 0)
+                            {
+                                writeEffectTimings();
+                                effectTimingSamplesRemaining += effectTimingSamplesPerUpdate;
+                            }
+                        }
                         if (this->realtimeVuBuffers != nullptr)
                         {
-                            pedalboard->ComputeVus(this->realtimeVuBuffers, (uint32_t)nframes, inputBuffers, outputBuffers);
+                            pedalboard->ComputeVus(this->realtimeVuBuffers, (uint32_t)nframes, pedalboardInputs, pedalboardOutputs);
 
                             vuSamplesRemaining -= nframes;
                             if (vuSamplesRemaining <= 0)
                             {
                                 writeVu();
-                                vuSamplesRemaining += vuSamplesPerUpdate;
+                                vuSamplesRemaining += this->realtimeVuBuffers->samplesPerUpdate;
                             }
                         }
                         if (this->realtimeMonitorPortSubscriptions != nullptr)
@@ -1218,8 +2002,11 @@ private:
                             processMonitorPortSubscriptions(nframes);
                         }
                     }
-                    pedalboard->GatherPatchProperties(pParameterRequests);
+                    pedalboard->GatherPatchProperties(pActiveParameterRequests);
+                    pActiveParameterRequests = nullptr;
                     pedalboard->GatherPathPatchProperties(this);
+                    pedalboard->WriteMidiOutput(this, fnMidiOutput);
+                    updateMidiValueChanges(nframes);
                 }
             }
 
@@ -1227,16 +2014,22 @@ private:
             {
                 ZeroOutputBuffers(nframes);
             }
+            if (realtimeLatencyProbe != nullptr)
+            {
+                ProcessLatencyProbe(nframes);
+            }
 
             if (pParameterRequests != nullptr)
             {
                 this->realtimeWriter.ParameterRequestComplete(pParameterRequests);
                 pParameterRequests = nullptr;
             }
+            writePathPropertyBuffers();
             // provide a grace period for undderruns, while spinning up. (15 second-ish)
             if (currentSample <= this->overrunGracePeriodSamples && currentSample + nframes > this->overrunGracePeriodSamples)
             {
                 this->underruns = 0;
+                PublishRealtimeMetrics();
             }
             this->currentSample += nframes;
         }
@@ -1251,19 +2044,25 @@ public:
     AudioHostImpl(IHost *pHost)
         : inputRingBuffer(RING_BUFFER_SIZE),
           outputRingBuffer(RING_BUFFER_SIZE),
+          telemetryRingBuffer(TELEMETRY_RING_BUFFER_SIZE),
+          bulkRingBuffer(BULK_RING_BUFFER_SIZE),
           realtimeReader(&this->inputRingBuffer),
-          realtimeWriter(&this->outputRingBuffer),
+          realtimeWriter(&this->outputRingBuffer, &this->telemetryRingBuffer, &this->bulkRingBuffer),
           hostReader(&this->outputRingBuffer),
+          telemetryReader(&this->telemetryRingBuffer),
+          bulkReader(&this->bulkRingBuffer),
           hostWriter(&this->inputRingBuffer),
           eventBufferUrids(pHost),
           pHost(pHost),
           uris(pHost),
           atomConverter(pHost->GetMapFeature())
     {
-        realtimeAtomBuffer.resize(32 * 1024);
         lv2_atom_forge_init(&inputWriterForge, pHost->GetMapFeature().GetMap());
+        midiInputSequence.resize(pHost->GetAtomBufferSize() / sizeof(uint64_t));
+        telemetryRingBuffer.shareReaderWakeup(outputRingBuffer);
+        bulkRingBuffer.shareReaderWakeup(outputRingBuffer);
 
-        cpuTemperatureMonitor = CpuTemperatureMonitor::Get();
+        sysfsSampler = SysfsSampler::GetShared();
         this->alsaSequencer = AlsaSequencer::Create();
         this->alsaDeviceMonitor = AlsaSequencerDeviceMonitor::Create();
 
@@ -1284,6 +2083,10 @@ public:
         CleanRestartThreads(true);
         audioDriver = nullptr;
         this->alsaSequencer = nullptr;
+        delete realtimeSystemMidiDispatch;
+        realtimeSystemMidiDispatch = nullptr;
+        delete realtimeAtomOutputSubscriptions;
+        realtimeAtomOutputSubscriptions = nullptr;
     }
 
     virtual JackConfiguration GetServerConfiguration()
@@ -1323,9 +2126,62 @@ public:
         }
     }
     std::vector<uint8_t> atomBuffer;
-    std::vector<uint8_t> realtimeAtomBuffer;
 
     bool terminateThread;
+    std::unordered_set<uintptr_t> reportedRealtimeLocks;
+
+    void LogRealtimeTripwireLocks()
+    {
+        // a mutex that the audio thread shares with non-realtime threads must inherit priority, or a
+        // preempted host thread holding it will stall the audio thread.
+        for (const auto &lock : RealtimeTripwire::GetLocks())
+        {
+            if (lock.priorityInheriting || lock.hostLocks == 0 || reportedRealtimeLocks.contains(lock.address))
+            {
+                continue;
+            }
+            reportedRealtimeLocks.insert(lock.address);
+            Lv2Log::warning(SS("Realtime lock on a mutex without priority inheritance (0x" << std::hex << lock.address << std::dec
+                                                                                           << "), shared with non-realtime threads. Realtime locks: " << lock.realtimeLocks
+                                                                                           << ", contended: " << lock.realtimeContentions
+                                                                                           << ", non-realtime locks: " << lock.hostLocks));
+        }
+    }
+    void LogRealtimeTripwireSites()
+    {
+        LogRealtimeTripwireLocks();
+        std::vector<RealtimeTripwireSite> sites = RealtimeTripwire::TakeNewSites();
+        if (sites.empty())
+        {
+            return;
+        }
+        std::lock_guard guard(mutex);
+        for (const auto &site : sites)
+        {
+            std::string source = "host";
+            if (site.instanceId != 0)
+            {
+                source = SS("instance " << site.instanceId);
+                if (this->currentPedalboard)
+                {
+                    Lv2Effect *lv2Effect = dynamic_cast<Lv2Effect *>(this->currentPedalboard->GetEffect(site.instanceId));
+                    if (lv2Effect)
+                    {
+                        source = lv2Effect->GetUri();
+                    }
+                }
+            }
+            std::stringstream s;
+            s << "Realtime " << RealtimeTripwireEventName(site.event) << " on the audio thread (" << source << "), "
+              << site.count << " time(s):";
+            for (const auto &frame : site.backtrace)
+            {
+                s << "\n    " << frame;
+            }
+            Lv2Log::warning(s.str());
+        }
+    }
+
     void ThreadProc()
     {
         SetThreadName("rtsvc");
@@ -1336,6 +2192,7 @@ public:
         {
 
             uint64_t lastUnderrunCount = this->underruns;
+            uint64_t lastDroppedMessageCount = 0;
 
             using clock = std::chrono::steady_clock;
             using clock_time = std::chrono::steady_clock::time_point;
@@ -1346,20 +2203,75 @@ public:
                 std::chrono::duration_cast<clock_duration>(std::chrono::seconds(30));
             clock_time waitTime = std::chrono::steady_clock::now();
 
+            clock_duration overloadCheckPeriod =
+                std::chrono::duration_cast<clock_duration>(std::chrono::duration<double>(OVERLOAD_CHECK_PERIOD_S));
+            clock_time overloadCheckTime = waitTime;
+            clock_time overloadEpoch = waitTime;
+            overloadMonitor.Reset();
+
+            clock_duration metricsPeriod =
+                std::chrono::duration_cast<clock_duration>(std::chrono::duration<double>(METRICS_PUBLISH_PERIOD_S));
+            clock_time metricsTime = waitTime;
+
             while (true)
             {
 
                 // wait for an event.
                 // 0 -> ready. -1: timed out. -2: closing.
 
-                auto result = hostReader.wait_until(sizeof(RingBufferCommand), waitTime);
+                // no periodic work while idle, other than the 30-second checks.
+                bool hostIdle = idle.load(std::memory_order_relaxed);
+                bool checkOverload = overloadProtection.load() && !hostIdle;
+                clock_time wakeTime = hostIdle ? waitTime : std::min(waitTime, metricsTime);
+                if (checkOverload)
+                {
+                    wakeTime = std::min(wakeTime, overloadCheckTime);
+                }
+                auto result = outputRingBuffer.readWaitAny_until(
+                    [this]() { return NextHostReader() != nullptr; },
+                    wakeTime);
                 if (result == RingBufferStatus::Closed)
                 {
                     return;
                 }
-                else if (result == RingBufferStatus::TimedOut)
+                if (!hostIdle && clock::now() >= metricsTime)
+                {
+                    metricsTime = clock::now() + metricsPeriod;
+                    PublishHostMetrics();
+                    AttachPmuCounters();
+                }
+                if (checkOverload)
+                {
+                    clock_time now = clock::now();
+                    if (now >= overloadCheckTime)
+                    {
+                        overloadCheckTime = now + overloadCheckPeriod;
+                        double t = std::chrono::duration<double>(now - overloadEpoch).count();
+                        if (overloadMonitor.Update(t, pedalboardLoad.load(std::memory_order_relaxed), underruns.load()))
+                        {
+                            Lv2Log::warning("Audio thread overloaded.");
+                            if (this->pNotifyCallbacks && !overloadEffectTimings.empty())
+                            {
+                                this->pNotifyCallbacks->OnNotifyOverload(overloadEffectTimings);
+                            }
+                        }
+                    }
+                }
+                else
+                {
+                    overloadMonitor.Reset();
+                }
+                if (result == RingBufferStatus::TimedOut)
                 {
+                    if (clock::now() < waitTime)
+                    {
+                        continue; // woken for overload checks or metrics.
+                    }
                     // timeout.
+                    if (RealtimeTripwire::Enabled)
+                    {
+                        LogRealtimeTripwireSites();
+                    }
                     if (underruns != lastUnderrunCount)
                     {
                         if (underrunMessagesGiven < 60) // limit how much log file clutter we generate.
@@ -1369,50 +2281,68 @@ public:
                             ++underrunMessagesGiven;
                         }
                     }
+                    uint64_t droppedMessages =
+                        telemetryRingBuffer.getOverflowCount() + bulkRingBuffer.getOverflowCount();
+                    if (droppedMessages != lastDroppedMessageCount)
+                    {
+                        Lv2Log::info("Audio thread dropped messages: %lu telemetry, %lu bulk.",
+                                     (unsigned long)telemetryRingBuffer.getOverflowCount(),
+                                     (unsigned long)bulkRingBuffer.getOverflowCount());
+                        lastDroppedMessageCount = droppedMessages;
+                    }
                     waitTime += waitPeriod;
                 }
                 else
                 {
+                    // Drain everything that's available in one pass. Work that needs `mutex` is
+                    // collected in hostBatch, and applied under one lock when the pass is done.
+                    size_t batchMessages = 0;
                     while (true)
                     {
-                        size_t space = hostReader.readSpace();
-                        if (space <= sizeof(RingBufferCommand))
+                        // re-select after every message, so that control messages overtake queued telemetry and bulk data.
+                        HostRingBufferReader *pReader = NextHostReader();
+                        if (pReader == nullptr)
                         {
                             break;
                         }
+                        if (++batchMessages > MAX_HOST_BATCH_MESSAGES)
+                        {
+                            FlushHostBatch();
+                            batchMessages = 1;
+                        }
+                        HostRingBufferReader &reader = *pReader;
                         RingBufferCommand command;
-                        if (hostReader.read(&command))
+                        if (reader.read(&command))
                         {
                             if (command == RingBufferCommand::OnMidiListen)
                             {
                                 MidiNotifyBody body;
-                                hostReader.read(&body);
+                                reader.read(&body);
                                 if (this->pNotifyCallbacks)
                                 {
                                     pNotifyCallbacks->OnNotifyMidiListen(body.cc0_, body.cc1_, body.cc2_);
                                 }
                             }
-                            else if (command == RingBufferCommand::MidiValueChanged)
+                            else if (command == RingBufferCommand::MidiValuesChanged)
                             {
-                                MidiValueChangedBody body;
-                                hostReader.read(&body);
+                                size_t count;
+                                reader.read(&count);
+                                size_t extraBytes;
+                                reader.read(&extraBytes);
+                                hostMidiValueChanges.resize(count);
+                                reader.read(extraBytes, (uint8_t *)hostMidiValueChanges.data());
 
                                 if (this->pNotifyCallbacks)
                                 {
-                                    this->pNotifyCallbacks->OnNotifyMidiValueChanged(body.instanceId, body.controlIndex, body.value);
+                                    this->pNotifyCallbacks->OnNotifyMidiValuesChanged(hostMidiValueChanges);
                                 }
                             }
                             else if (command == RingBufferCommand::ParameterRequestComplete)
                             {
                                 RealtimePatchPropertyRequest *pRequest = nullptr;
-                                hostReader.read(&pRequest);
+                                reader.read(&pRequest);
 
-                                std::shared_ptr<Lv2Pedalboard> currentpedalboard;
-
-                                {
-                                    std::lock_guard guard(mutex);
-                                    currentPedalboard = this->currentPedalboard;
-                                }
+                                const std::shared_ptr<Lv2Pedalboard> &currentPedalboard = GetBatchCurrentPedalboard();
 
                                 while (pRequest != nullptr)
                                 {
@@ -1423,7 +2353,7 @@ public:
                                         {
                                             if (pRequest->GetSize() != 0)
                                             {
-                                                IEffect *pEffect = currentPedalboard->GetEffect(pRequest->instanceId);
+                                                IEffect *pEffect = currentPedalboard ? currentPedalboard->GetEffect(pRequest->instanceId) : nullptr;
                                                 if (pEffect == nullptr)
                                                 {
                                                     pRequest->errorMessage = "Effect no longer available.";
@@ -1446,51 +2376,77 @@ public:
                                     pRequest = pNext;
                                 }
                             }
-                            else if (command == RingBufferCommand::SendMonitorPortUpdate)
+                            else if (command == RingBufferCommand::SendMonitorPortUpdates)
                             {
-                                MonitorPortUpdate body;
-                                hostReader.read(&body);
+                                MonitorPortUpdatesBody body;
+                                reader.read(&body);
+                                size_t extraBytes;
+                                reader.read(&extraBytes);
+                                hostMonitorPortUpdates.resize(extraBytes / sizeof(MonitorPortUpdate));
+                                reader.read(extraBytes, (uint8_t *)hostMonitorPortUpdates.data());
 
                                 if (this->pNotifyCallbacks != nullptr)
                                 {
-                                    this->pNotifyCallbacks->OnNotifyMonitorPort(body);
+                                    for (const MonitorPortUpdate &update : hostMonitorPortUpdates)
+                                    {
+                                        this->pNotifyCallbacks->OnNotifyMonitorPort(update);
+                                    }
                                 }
-                                this->hostWriter.AckMonitorPortUpdate(body.subscriptionHandle); // please sir, can I have some more?
+                                this->hostWriter.AckMonitorPortUpdates(body); // please sir, can I have some more?
                             }
                             else if (command == RingBufferCommand::SendVuUpdate)
                             {
-                                const std::vector<VuUpdate> *updates = nullptr;
-                                hostReader.read(&updates);
+                                const RealtimeVuBuffers *updates = nullptr;
+                                reader.read(&updates);
 
                                 if (this->pNotifyCallbacks)
                                 {
-                                    this->pNotifyCallbacks->OnNotifyVusSubscription(*updates);
+                                    hostVuUpdates.assign(
+                                        updates->vuUpdateResponseData.begin(),
+                                        updates->vuUpdateResponseData.begin() + updates->responseCount);
+                                    this->pNotifyCallbacks->OnNotifyVusSubscription(hostVuUpdates);
                                 }
                                 this->hostWriter.AckVuUpdate(); // please sir, can I have some more?
                             }
+                            else if (command == RingBufferCommand::SendEffectTimings)
+                            {
+                                const RealtimeEffectTimings *timings = nullptr;
+                                reader.read(&timings);
+
+                                auto statistics = timings->GetStatistics();
+                                if (overloadProtection)
+                                {
+                                    overloadEffectTimings = statistics;
+                                }
+                                if (this->pNotifyCallbacks)
+                                {
+                                    this->pNotifyCallbacks->OnNotifyEffectTimings(statistics);
+                                }
+                                this->hostWriter.AckEffectTimings();
+                            }
                             else if (command == RingBufferCommand::Lv2StateChanged)
                             {
                                 uint64_t instanceId;
-                                hostReader.read(&instanceId);
+                                reader.read(&instanceId);
                                 this->pNotifyCallbacks->OnNotifyLv2StateChanged(instanceId);
                             }
                             else if (command == RingBufferCommand::MaybeLv2StateChanged)
                             {
                                 uint64_t instanceId;
-                                hostReader.read(&instanceId);
+                                reader.read(&instanceId);
                                 this->pNotifyCallbacks->OnNotifyMaybeLv2StateChanged(instanceId);
                             }
                             else if (command == RingBufferCommand::AtomOutput)
                             {
                                 uint64_t instanceId;
-                                hostReader.read(&instanceId);
+                                reader.read(&instanceId);
                                 size_t extraBytes;
-                                hostReader.read(&extraBytes);
+                                reader.read(&extraBytes);
                                 if (atomBuffer.size() < extraBytes)
                                 {
                                     atomBuffer.resize(extraBytes);
                                 }
-                                hostReader.read(extraBytes, &(atomBuffer[0]));
+                                reader.read(extraBytes, &(atomBuffer[0]));
 
                                 IEffect *pEffect = currentPedalboard->GetEffect(instanceId);
                                 if (pEffect != nullptr && this->pNotifyCallbacks)
@@ -1526,37 +2482,90 @@ public:
                             else if (command == RingBufferCommand::FreeVuSubscriptions)
                             {
                                 RealtimeVuBuffers *config;
-                                hostReader.read(&config);
-                                delete config;
+                                reader.read(&config);
+                                reclamationQueue.Delete(config);
+                            }
+                            else if (command == RingBufferCommand::FreePedalboardSlots)
+                            {
+                                RealtimePedalboardSlots *slots;
+                                reader.read(&slots);
+                                OnPedalboardSlotsReleased(slots);
+                            }
+                            else if (command == RingBufferCommand::FreeSystemMidiDispatch)
+                            {
+                                SystemMidiDispatch *systemMidiDispatch;
+                                reader.read(&systemMidiDispatch);
+                                reclamationQueue.Delete(systemMidiDispatch);
+                            }
+                            else if (command == RingBufferCommand::FreeAtomOutputSubscriptions)
+                            {
+                                RealtimeAtomOutputSubscriptions *subscriptions;
+                                reader.read(&subscriptions);
+                                reclamationQueue.Delete(subscriptions);
+                            }
+                            else if (command == RingBufferCommand::IdleWake)
+                            {
+                                uint64_t unused;
+                                reader.read(&unused);
+                                idle = false;
+                                sysfsSampler->SetIdle(false);
+                                pNotifyCallbacks->OnNotifyIdleWake();
+                            }
+                            else if (command == RingBufferCommand::LatencyProbeComplete)
+                            {
+                                LatencyProbe *probe;
+                                reader.read(&probe);
+                                {
+                                    std::lock_guard probeLock(latencyProbeMutex);
+                                    if (probe == latencyProbe.get())
+                                    {
+                                        latencyProbeReturned = true;
+                                    }
+                                }
+                                latencyProbeCv.notify_all();
+                            }
+                            else if (command == RingBufferCommand::FreeEffectTimingSubscription)
+                            {
+                                RealtimeEffectTimings *timings;
+                                reader.read(&timings);
+                                reclamationQueue.Delete(timings);
                             }
                             else if (command == RingBufferCommand::FreeMonitorPortSubscription)
                             {
                                 RealtimeMonitorPortSubscriptions *pSubscriptions;
-                                hostReader.read(&pSubscriptions);
-                                delete pSubscriptions;
+                                reader.read(&pSubscriptions);
+                                reclamationQueue.Delete(pSubscriptions);
                             }
                             else if (command == RingBufferCommand::EffectReplaced)
                             {
                                 EffectReplacedBody body;
-                                hostReader.read(&body);
+                                reader.read(&body);
                                 OnActivePedalboardReleased(body.oldEffect);
                             }
                             else if (command == RingBufferCommand::FreeSnapshot)
                             {
                                 IndexedSnapshot *snapshot;
-                                hostReader.read(&snapshot);
+                                reader.read(&snapshot);
                                 OnFreeSnapshot(snapshot);
                             }
-                            else if (command == RingBufferCommand::SendPathPropertyBuffer)
+                            else if (command == RingBufferCommand::SendPathPropertyBuffers)
                             {
-                                PatchPropertyWriter::Buffer *buffer = nullptr;
-                                hostReader.read(&buffer);
-                                OnPathPropertyReceived(buffer);
+                                size_t count;
+                                reader.read(&count);
+                                size_t extraBytes;
+                                reader.read(&extraBytes);
+                                hostPathPropertyBuffers.resize(count);
+                                reader.read(extraBytes, (uint8_t *)hostPathPropertyBuffers.data());
+                                for (PatchPropertyWriter::Buffer *buffer : hostPathPropertyBuffers)
+                                {
+                                    OnPathPropertyReceived(buffer);
+                                }
                             }
                             else if (command == RingBufferCommand::AudioTerminatedAbnormally)
                             {
                                 AudioStoppedBody body;
-                                hostReader.read(&body);
+                                reader.read(&body);
+                                FlushHostBatch();
                                 HandleAudioTerminatedAbnormally();
                                 return;
                             }
@@ -1564,32 +2573,36 @@ public:
                                                     MidiProgramChange)
                             {
                                 RealtimeMidiProgramRequest programRequest;
-                                hostReader.read(&programRequest);
+                                reader.read(&programRequest);
+                                switchLatencyMonitor.OnNotified();
                                 OnMidiProgramRequest(programRequest);
                             }
                             else if (command == RingBufferCommand::NextMidiProgram)
                             {
                                 RealtimeNextMidiProgramRequest request;
-                                hostReader.read(&request);
+                                reader.read(&request);
+                                switchLatencyMonitor.OnNotified();
                                 pNotifyCallbacks->OnNotifyNextMidiProgram(request);
                             }
                             else if (command == RingBufferCommand::NextMidiBank)
                             {
                                 RealtimeNextMidiProgramRequest request;
-                                hostReader.read(&request);
+                                reader.read(&request);
+                                switchLatencyMonitor.OnNotified();
                                 pNotifyCallbacks->OnNotifyNextMidiBank(request);
                             }
 
                             else if (command == RingBufferCommand::RealtimeMidiEvent)
                             {
                                 RealtimeMidiEventRequest request;
-                                hostReader.read(&request);
+                                reader.read(&request);
                                 pNotifyCallbacks->OnNotifyMidiRealtimeEvent(request.eventType);
                             }
                             else if (command == RingBufferCommand::RealtimeMidiSnapshotRequest)
                             {
                                 RealtimeMidiSnapshotRequest request;
-                                hostReader.read(&request);
+                                reader.read(&request);
+                                switchLatencyMonitor.OnNotified();
                                 pNotifyCallbacks->OnNotifyMidiRealtimeSnapshotRequest(
                                     request.snapshotIndex,
                                     request.snapshotRequestId);
@@ -1598,13 +2611,13 @@ public:
                             {
                                 size_t size;
                                 int64_t instanceId;
-                                hostReader.read(&instanceId);
-                                hostReader.read(&size);
+                                reader.read(&instanceId);
+                                reader.read(&size);
                                 if (this->atomBuffer.size() < size + 1)
                                 {
                                     this->atomBuffer.resize(size + 1);
                                 }
-                                hostReader.read(size, &(atomBuffer[0]));
+                                reader.read(size, &(atomBuffer[0]));
                                 char *p = (char *)&(atomBuffer[0]);
                                 p[size] = 0;
                                 std::string message(p);
@@ -1616,6 +2629,7 @@ public:
                             }
                         }
                     }
+                    FlushHostBatch();
                 }
             }
         }
@@ -1684,6 +2698,11 @@ public:
             this->isDummyAudioDriver = true;
             this->audioDriver = std::unique_ptr<AudioDriver>(CreateDummyAudioDriver(this, jackServerSettings.GetAlsaInputDevice()));
         }
+        else if (jackServerSettings.IsPipeWireAudioDevice())
+        {
+            this->isDummyAudioDriver = false;
+            this->audioDriver = std::unique_ptr<AudioDriver>(CreatePipeWireDriver(this));
+        }
         else
         {
             this->isDummyAudioDriver = false;
@@ -1697,14 +2716,30 @@ public:
 
         this->currentSample = 0;
         this->underruns = 0;
+        PublishRealtimeMetrics();
+        this->audioThreadId = 0;
 
         this->inputRingBuffer.reset();
         this->outputRingBuffer.reset();
+        this->telemetryRingBuffer.reset();
+        this->bulkRingBuffer.reset();
         this->hostReader.Reset();
         this->hostWriter.Reset();
         this->realtimeReader.Reset();
         this->realtimeWriter.Reset();
 
+        // a dispatch table in transit may have been lost when the ring buffers were reset.
+        delete this->realtimeSystemMidiDispatch;
+        this->realtimeSystemMidiDispatch = new SystemMidiDispatch(this->systemMidiBindings);
+        delete this->realtimeAtomOutputSubscriptions;
+        this->realtimeAtomOutputSubscriptions = nullptr;
+        if (this->atomOutputSubscriptions.size() != 0)
+        {
+            this->realtimeAtomOutputSubscriptions = new RealtimeAtomOutputSubscriptions();
+            this->realtimeAtomOutputSubscriptions->subscriptions = this->atomOutputSubscriptions;
+        }
+        this->realtimeWriter.SetAtomOutputFilter(this->realtimeAtomOutputSubscriptions);
+
         this->channelSelection = channelSelection;
 
         StartReaderThread();
@@ -1717,9 +2752,22 @@ public:
 
             this->overrunGracePeriodSamples = (uint64_t)(((uint64_t)this->sampleRate) * OVERRUN_GRACE_PERIOD_S);
             this->vuSamplesPerUpdate = (size_t)(sampleRate * VU_UPDATE_RATE_S);
+            this->effectTimingSamplesPerUpdate = (size_t)(sampleRate * EFFECT_TIMING_UPDATE_RATE_S);
+
+            this->crossfadeBuffers.clear();
+            this->realtimeArena.Clear();
+            this->crossfadeBufferSize = pHost->GetMaxAudioBufferSize();
+            for (size_t i = 0; i < audioDriver->OutputBufferCount(); ++i)
+            {
+                this->crossfadeBuffers.push_back(realtimeArena.Allocate<float>(crossfadeBufferSize));
+            }
+            this->crossfadeBufferPointers = realtimeArena.Allocate<float *>(audioDriver->OutputBufferCount() + 1);
+            this->processInputBuffers = realtimeArena.Allocate<float *>(audioDriver->InputBufferCount() + 1);
+            this->processOutputBuffers = realtimeArena.Allocate<float *>(audioDriver->OutputBufferCount() + 1);
 
             active = true;
             audioStopped = false;
+            this->realtimeIdle = idle.load();
             audioDriver->Activate();
             Lv2Log::info(SS("Audio started. " << audioDriver->GetConfigurationDescription()));
         }
@@ -1748,22 +2796,166 @@ public:
         }
         buffer->OnBufferReadComplete();
     }
+    // Host thread: work from one pass over the ring buffers that needs `mutex`.
+    struct HostBatch
+    {
+        std::vector<Lv2Pedalboard *> releasedPedalboards;
+        std::vector<RealtimePedalboardSlots *> releasedSlots;
+        std::vector<IndexedSnapshot *> freedSnapshots;
+        std::shared_ptr<Lv2Pedalboard> currentPedalboard;
+        bool currentPedalboardValid = false;
+    };
+    HostBatch hostBatch;
+    static constexpr size_t MAX_HOST_BATCH_MESSAGES = 256;
+
+    // The current pedalboard, read once per batch.
+    const std::shared_ptr<Lv2Pedalboard> &GetBatchCurrentPedalboard()
+    {
+        if (!hostBatch.currentPedalboardValid)
+        {
+            std::lock_guard guard(mutex);
+            hostBatch.currentPedalboard = this->currentPedalboard;
+            hostBatch.currentPedalboardValid = true;
+        }
+        return hostBatch.currentPedalboard;
+    }
+
     void OnActivePedalboardReleased(Lv2Pedalboard *pPedalboard)
     {
         if (pPedalboard)
+        {
+            hostBatch.releasedPedalboards.push_back(pPedalboard);
+        }
+    }
+
+    void OnPedalboardSlotsReleased(RealtimePedalboardSlots *slots)
+    {
+        hostBatch.releasedSlots.push_back(slots);
+    }
+
+    void OnFreeSnapshot(IndexedSnapshot *snapshot)
+    {
+        hostBatch.freedSnapshots.push_back(snapshot);
+    }
+
+    void FlushHostBatch()
+    {
+        hostBatch.currentPedalboard.reset();
+        hostBatch.currentPedalboardValid = false;
+
+        if (hostBatch.releasedPedalboards.empty() && hostBatch.releasedSlots.empty() && hostBatch.freedSnapshots.empty())
+        {
+            return;
+        }
+        std::vector<std::shared_ptr<Lv2Pedalboard>> releasedPedalboards;
+        std::vector<std::shared_ptr<RealtimePedalboardSlots>> releasedSlots;
         {
             std::lock_guard guard(mutex);
 
-            for (auto it = activePedalboards.begin(); it != activePedalboards.end(); ++it)
+            for (Lv2Pedalboard *pPedalboard : hostBatch.releasedPedalboards)
             {
-                if ((*it).get() == pPedalboard)
+                for (auto it = activePedalboards.begin(); it != activePedalboards.end(); ++it)
                 {
-                    // erase it, relinquishing shared_ptr ownership, usually deleting the object.
-                    activePedalboards.erase(it);
-                    return;
+                    if ((*it).get() == pPedalboard)
+                    {
+                        releasedPedalboards.push_back(std::move(*it));
+                        activePedalboards.erase(it);
+                        break;
+                    }
+                }
+            }
+            for (RealtimePedalboardSlots *slots : hostBatch.releasedSlots)
+            {
+                for (auto it = activePedalboardSlots.begin(); it != activePedalboardSlots.end(); ++it)
+                {
+                    if ((*it).get() == slots)
+                    {
+                        releasedSlots.push_back(std::move(*it));
+                        activePedalboardSlots.erase(it);
+                        break;
+                    }
+                }
+            }
+            for (IndexedSnapshot *snapshot : hostBatch.freedSnapshots)
+            {
+                for (auto i = pendingSnapshots.begin(); i != pendingSnapshots.end(); ++i)
+                {
+                    if (*i == snapshot)
+                    {
+                        pendingSnapshots.erase(i);
+                        break;
+                    }
+                }
+                this->lastSnapshotApplyUs = snapshot->applyNs * 0.001f;
+            }
+        }
+        // relinquish shared_ptr ownership, usually deleting the pedalboards (on the reclamation thread).
+        for (auto &pedalboard : releasedPedalboards)
+        {
+            reclamationQueue.Retire(std::move(pedalboard));
+        }
+        // joins the slots' helper threads, and usually deletes their pedalboards.
+        for (auto &slots : releasedSlots)
+        {
+            reclamationQueue.Retire(std::move(slots));
+        }
+        for (IndexedSnapshot *snapshot : hostBatch.freedSnapshots)
+        {
+            Lv2Log::debug(SS("Snapshot applied in " << (snapshot->applyNs * 0.001) << "us ("
+                                                    << snapshot->GetControlChangeCount() << " controls, "
+                                                    << snapshot->GetPatchSetCount() << " path properties)"));
+            reclamationQueue.Delete(snapshot);
+        }
+        hostBatch.releasedPedalboards.clear();
+        hostBatch.releasedSlots.clear();
+        hostBatch.freedSnapshots.clear();
+    }
+
+    virtual void SetPedalboardSlots(
+        const std::vector<int> &mainInputChannels, const std::vector<int> &mainOutputChannels,
+        const std::vector<AudioPedalboardSlot> &slots) override
+    {
+        std::lock_guard guard(mutex);
+        if (!active)
+        {
+            return;
+        }
+        std::shared_ptr<RealtimePedalboardSlots> realtimeSlots;
+        if (slots.size() != 0 ||
+            mainInputChannels.size() != audioDriver->InputBufferCount() ||
+            mainOutputChannels.size() != audioDriver->OutputBufferCount())
+        {
+            auto checkChannels = [](const std::vector<int> &channels, size_t channelCount)
+            {
+                for (int channel : channels)
+                {
+                    if (channel < 0 || (size_t)channel >= channelCount)
+                    {
+                        throw PiPedalArgumentException("Invalid channel.");
+                    }
                 }
+            };
+            checkChannels(mainInputChannels, audioDriver->InputBufferCount());
+            checkChannels(mainOutputChannels, audioDriver->OutputBufferCount());
+            for (const auto &slot : slots)
+            {
+                checkChannels(slot.inputChannels, audioDriver->InputBufferCount());
+                checkChannels(slot.outputChannels, audioDriver->OutputBufferCount());
             }
+            realtimeSlots = std::make_shared<RealtimePedalboardSlots>(
+                audioDriver->OutputBufferCount(), mainInputChannels, mainOutputChannels, slots);
+            for (const auto &slot : slots)
+            {
+                slot.pedalboard->Activate();
+            }
+            activePedalboardSlots.push_back(realtimeSlots);
         }
+        else if (!currentPedalboardSlots)
+        {
+            return;
+        }
+        currentPedalboardSlots = realtimeSlots;
+        hostWriter.SetPedalboardSlots(realtimeSlots.get());
     }
 
     virtual void SetPedalboard(const std::shared_ptr<Lv2Pedalboard> &pedalboard)
@@ -1775,10 +2967,26 @@ public:
         {
             pedalboard->Activate();
             this->activePedalboards.push_back(pedalboard);
+            switchLatencyMonitor.OnSubmitted();
             hostWriter.ReplaceEffect(pedalboard.get());
         }
     }
 
+    virtual void SetPedalboardCrossfade(float milliseconds) override
+    {
+        this->pedalboardCrossfadeMs = milliseconds;
+    }
+
+    virtual void SetSubBlockFrames(uint32_t frames) override
+    {
+        this->subBlockFrames = frames;
+    }
+
+    virtual void SetControlRamp(float milliseconds) override
+    {
+        this->controlRampMs = milliseconds;
+    }
+
     virtual void SetBypass(uint64_t instanceId, bool enabled)
     {
         std::lock_guard guard(mutex);
@@ -1801,15 +3009,25 @@ public:
             auto effectIndex = currentPedalboard->GetIndexOfInstanceId(instanceId);
             if (effectIndex != -1)
             {
+                // One message for the whole preset, with control indices resolved here rather than on the audio thread.
+                IEffect *effect = currentPedalboard->GetEffects()[effectIndex];
+                Lv2Effect *lv2Effect = effect->IsLv2Effect() ? (Lv2Effect *)effect : nullptr;
+                std::vector<ControlIndexValue> indexedValues;
+                indexedValues.reserve(values.size());
                 for (size_t i = 0; i < values.size(); ++i)
                 {
                     const ControlValue &value = values[i];
-                    int controlIndex = this->currentPedalboard->GetControlIndex(instanceId, value.key());
-                    if (controlIndex != -1 && effectIndex != -1)
+                    int controlIndex = effect->GetControlIndex(value.key());
+                    if (controlIndex != -1)
                     {
-                        hostWriter.SetControlValue(effectIndex, controlIndex, value.value());
+                        bool ramp = lv2Effect != nullptr && lv2Effect->IsRampableControl(controlIndex);
+                        indexedValues.push_back(ControlIndexValue{controlIndex, value.value(), ramp});
                     }
                 }
+                if (!indexedValues.empty())
+                {
+                    hostWriter.SetControlValues(effectIndex, ControlRampFrames(), indexedValues.size(), indexedValues.data());
+                }
             }
         }
     }
@@ -1830,6 +3048,20 @@ public:
         }
     }
 
+    virtual bool SetControlValue(Lv2Pedalboard *pedalboard, int effectIndex, int controlIndex, float value) override
+    {
+        std::lock_guard guard(mutex);
+        if (this->currentPedalboard.get() != pedalboard || pedalboard == nullptr)
+        {
+            return false;
+        }
+        if (active)
+        {
+            hostWriter.SetControlValue(effectIndex, controlIndex, value);
+        }
+        return true;
+    }
+
     virtual void SetInputVolume(float value)
     {
         std::lock_guard guard(mutex);
@@ -1849,6 +3081,7 @@ public:
     }
 
     std::vector<IndexedSnapshot *> pendingSnapshots;
+    float lastSnapshotApplyUs = 0;
 
     virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost) override
     {
@@ -1857,6 +3090,7 @@ public:
         {
             IndexedSnapshot *indexedSnapshot = new IndexedSnapshot(&snapshot, this->currentPedalboard, pluginHost);
             pendingSnapshots.push_back(indexedSnapshot);
+            switchLatencyMonitor.OnSubmitted();
             this->hostWriter.LoadSnapshot(indexedSnapshot);
         }
     }
@@ -1869,21 +3103,6 @@ public:
         const std::string &pathPatchPropertyUri,
         const std::string &jsonAtom) override;
 
-    void OnFreeSnapshot(IndexedSnapshot *snapshot)
-    {
-        {
-            std::lock_guard guard(mutex);
-            for (auto i = pendingSnapshots.begin(); i != pendingSnapshots.end(); ++i)
-            {
-                if (*i == snapshot)
-                {
-                    pendingSnapshots.erase(i);
-                    break;
-                }
-            }
-        }
-        delete snapshot;
-    }
     void CleanUpSnapshots()
     {
         for (auto i = pendingSnapshots.begin(); i != pendingSnapshots.end(); ++i)
@@ -1894,14 +3113,14 @@ public:
         pendingSnapshots.clear();
     }
 
-    virtual void SetVuSubscriptions(const std::vector<int64_t> &instanceIds)
+    virtual void SetVuSubscriptions(const std::vector<VuSubscriptionRate> &subscriptions)
     {
         std::lock_guard guard(mutex);
 
         if (active && this->currentPedalboard)
         {
 
-            if (instanceIds.size() == 0)
+            if (subscriptions.size() == 0)
             {
                 this->hostWriter.SetVuSubscriptions(nullptr);
             }
@@ -1909,13 +3128,25 @@ public:
             {
                 RealtimeVuBuffers *vuConfig = new RealtimeVuBuffers();
 
-                for (size_t i = 0; i < instanceIds.size(); ++i)
+                float maxUpdatesPerSecond = 0;
+                for (const auto &subscription : subscriptions)
+                {
+                    maxUpdatesPerSecond = std::max(maxUpdatesPerSecond, std::min(subscription.updatesPerSecond, MAX_VU_UPDATES_PER_SECOND));
+                }
+                if (maxUpdatesPerSecond <= 0)
                 {
-                    int64_t instanceId = instanceIds[i];
+                    maxUpdatesPerSecond = MAX_VU_UPDATES_PER_SECOND;
+                }
+                vuConfig->samplesPerUpdate = std::max(1, (int)(this->GetSampleRate() / maxUpdatesPerSecond));
+
+                for (size_t i = 0; i < subscriptions.size(); ++i)
+                {
+                    int64_t instanceId = subscriptions[i].instanceId;
+                    size_t entriesBefore = vuConfig->vuUpdateWorkingData.size();
                     auto effect = this->currentPedalboard->GetEffect(instanceId);
                     if (effect)
                     {
-                        int index = this->currentPedalboard->GetIndexOfInstanceId(instanceIds[i]);
+                        int index = this->currentPedalboard->GetIndexOfInstanceId(instanceId);
                         vuConfig->enabledIndexes.push_back(index);
                         VuUpdate v;
                         v.instanceId_ = instanceId;
@@ -1944,6 +3175,13 @@ public:
                         vuConfig->vuUpdateWorkingData.push_back(v);
                         vuConfig->vuUpdateResponseData.push_back(v);
                     }
+                    if (vuConfig->vuUpdateWorkingData.size() != entriesBefore)
+                    {
+                        float updatesPerSecond = std::min(subscriptions[i].updatesPerSecond, maxUpdatesPerSecond);
+                        int ticks = updatesPerSecond > 0 ? std::max(1, (int)std::round(maxUpdatesPerSecond / updatesPerSecond)) : 1;
+                        vuConfig->ticksPerUpdate.push_back(ticks);
+                        vuConfig->ticksRemaining.push_back(ticks);
+                    }
                 }
 
                 this->hostWriter.SetVuSubscriptions(vuConfig);
@@ -1951,6 +3189,119 @@ public:
         }
     }
 
+    virtual void SetIdle(bool idle) override
+    {
+        std::lock_guard guard(mutex);
+        if (this->idle.load() == idle)
+        {
+            return;
+        }
+        this->idle = idle;
+        sysfsSampler->SetIdle(idle);
+        if (active)
+        {
+            hostWriter.SetIdle(idle);
+        }
+        Lv2Log::info(idle ? "Audio idle." : "Audio resumed.");
+    }
+
+    virtual void SetIdleSignalThreshold(float threshold) override
+    {
+        lastSignalNs = EffectTimingClockNs();
+        idleSignalThreshold = threshold;
+    }
+
+    virtual double GetSecondsSinceSignal() override
+    {
+        uint64_t now = EffectTimingClockNs();
+        uint64_t last = lastSignalNs.load(std::memory_order_relaxed);
+        return now > last ? (now - last) * 1E-9 : 0;
+    }
+
+    virtual void SetOverloadProtection(bool enabled) override
+    {
+        std::lock_guard guard(mutex);
+        if (overloadProtection != enabled)
+        {
+            overloadProtection = enabled;
+            SetEffectTimingSubscription(clientEffectTimingSubscription);
+        }
+    }
+
+    virtual void SetPmuProfiling(bool enabled) override
+    {
+        std::lock_guard guard(mutex);
+        if (pmuProfiling != enabled)
+        {
+            pmuProfiling = enabled;
+            SetEffectTimingSubscription(clientEffectTimingSubscription);
+        }
+    }
+
+    virtual void SetDenormalDetection(bool enabled) override
+    {
+        std::lock_guard guard(mutex);
+        if (denormalDetection != enabled)
+        {
+            denormalDetection = enabled;
+            SetEffectTimingSubscription(clientEffectTimingSubscription);
+        }
+    }
+
+    // Audio service thread. The audio thread id isn't known until the stream has started, so resend
+    // the timing subscription once it is.
+    void AttachPmuCounters()
+    {
+        std::lock_guard guard(mutex);
+        if (pmuProfiling && !pmuAttached && audioThreadId.load(std::memory_order_acquire) != 0)
+        {
+            SetEffectTimingSubscription(clientEffectTimingSubscription);
+        }
+    }
+
+    virtual void SetEffectTimingSubscription(bool enabled)
+    {
+        std::lock_guard guard(mutex);
+        clientEffectTimingSubscription = enabled;
+        enabled = enabled || overloadProtection || pmuProfiling || denormalDetection;
+        pmuAttached = false;
+        if (active && this->currentPedalboard)
+        {
+            if (!enabled)
+            {
+                this->hostWriter.SetEffectTimingSubscription(nullptr);
+            }
+            else
+            {
+                std::vector<int64_t> instanceIds;
+                for (auto &effect : this->currentPedalboard->GetEffects())
+                {
+                    instanceIds.push_back(effect->GetInstanceId());
+                }
+                RealtimeEffectTimings *timings = new RealtimeEffectTimings(instanceIds);
+                pid_t threadId = audioThreadId.load(std::memory_order_acquire);
+                if (pmuProfiling && threadId != 0)
+                {
+                    auto counters = std::make_unique<PerfCounterGroup>(threadId);
+                    if (counters->IsValid())
+                    {
+                        timings->EnablePmu(std::move(counters), audioPthread.load(std::memory_order_relaxed));
+                    }
+                    else
+                    {
+                        Lv2Log::warning("PMU profiling: hardware performance counters are not available. (Check /proc/sys/kernel/perf_event_paranoid.)");
+                    }
+                    pmuAttached = true; // don't retry.
+                }
+                if (denormalDetection)
+                {
+                    timings->EnableDenormalDetection();
+                }
+                this->hostWriter.SetEffectTimingSubscription(timings);
+            }
+        }
+    }
+
     RealtimeMonitorPortSubscription MakeRealtimeSubscription(const MonitorPortSubscription &subscription)
     {
         RealtimeMonitorPortSubscription result;
@@ -1959,8 +3310,8 @@ public:
         IEffect *pEffect = this->currentPedalboard->GetEffect(subscription.instanceid);
 
         result.portIndex = pEffect->GetControlIndex(subscription.key);
-        result.sampleRate = (int)(this->GetSampleRate() * subscription.updateInterval);
-        result.samplesToNextCallback = result.sampleRate;
+        result.sampleInterval = (int)(this->GetSampleRate() * subscription.updateInterval);
+        result.epsilon = subscription.epsilon;
         PortMonitorCallback *ptr = new PortMonitorCallback(subscription.onUpdate);
         result.callbackPtr = ptr;
         return result;
@@ -1987,6 +3338,7 @@ public:
                         MakeRealtimeSubscription(subscriptions[i]));
                 }
             }
+            pSubscriptions->Prepare();
             this->hostWriter.SetMonitorPortSubscriptions(pSubscriptions);
         }
     }
@@ -2101,6 +3453,108 @@ public:
         this->hostWriter.ParameterRequest(pParameterRequest);
     }
 
+    virtual std::vector<AudioPeriodTraceEntry> GetAudioPeriodTrace(double seconds) override
+    {
+        std::lock_guard guard(mutex);
+        if (this->audioDriver == nullptr)
+        {
+            return {};
+        }
+        return this->audioDriver->GetPeriodTrace(seconds);
+    }
+
+    virtual void ResetCpuUseStatistics() override
+    {
+        std::lock_guard guard(mutex);
+        if (this->audioDriver != nullptr)
+        {
+            this->audioDriver->ResetCpuUseStatistics();
+        }
+        switchLatencyMonitor.Reset();
+    }
+
+    virtual std::filesystem::path StartRecording(const std::filesystem::path &directory) override
+    {
+        return recorder.Start(directory);
+    }
+    virtual void StopRecording() override
+    {
+        recorder.Stop();
+    }
+
+    virtual LatencyProbe::Result MeasureRoundTripLatency(int inputChannel, int outputChannel) override
+    {
+        std::chrono::milliseconds timeout;
+        {
+            std::lock_guard guard(mutex);
+            if (!active || !this->audioDriver)
+            {
+                throw PiPedalStateException("Audio is not running.");
+            }
+            if (inputChannel < 0 || (size_t)inputChannel >= audioDriver->InputBufferCount() ||
+                outputChannel < 0 || (size_t)outputChannel >= audioDriver->OutputBufferCount())
+            {
+                throw PiPedalArgumentException("Invalid channel.");
+            }
+            std::lock_guard probeLock(latencyProbeMutex);
+            if (latencyProbe)
+            {
+                throw PiPedalStateException("A latency measurement is already running.");
+            }
+            latencyProbe = std::make_unique<LatencyProbe>(this->sampleRate, inputChannel, outputChannel);
+            latencyProbeReturned = false;
+            latencyProbeAbandoned = false;
+            timeout = std::chrono::milliseconds(2000 + latencyProbe->GetDurationFrames() * 1000 / this->sampleRate);
+            this->hostWriter.SetLatencyProbe(latencyProbe.get());
+        }
+
+        auto finished = [this]()
+        { return latencyProbeReturned || latencyProbeAbandoned; };
+
+        std::unique_lock probeLock(latencyProbeMutex);
+        if (!latencyProbeCv.wait_for(probeLock, timeout, finished))
+        {
+            // ask for it back.
+            probeLock.unlock();
+            {
+                std::lock_guard guard(mutex);
+                if (active)
+                {
+                    this->hostWriter.SetLatencyProbe(nullptr);
+                }
+            }
+            probeLock.lock();
+            if (!latencyProbeCv.wait_for(probeLock, std::chrono::seconds(2), finished))
+            {
+                latencyProbe.release(); // leaked deliberately: the audio thread may still be using it.
+                throw PiPedalStateException("Latency measurement timed out.");
+            }
+        }
+        std::unique_ptr<LatencyProbe> probe = std::move(latencyProbe);
+        probeLock.unlock();
+
+        if (!probe->IsComplete())
+        {
+            throw PiPedalStateException("Latency measurement was cancelled.");
+        }
+        return probe->Analyze();
+    }
+
+    virtual std::optional<float> TakeRecentCpuHeadroom() override
+    {
+        std::lock_guard guard(mutex);
+        if (this->audioDriver == nullptr || !IsAudioRunning())
+        {
+            return std::nullopt;
+        }
+        return this->audioDriver->TakeRecentCpuHeadroom();
+    }
+
+    virtual float GetCpuTemperatureC() override
+    {
+        return sysfsSampler->GetTemperatureC();
+    }
+
     virtual JackHostStatus getJackStatus()
     {
         CleanRestartThreads(false);
@@ -2108,46 +3562,111 @@ public:
         using std::chrono::duration_cast;
         using std::chrono::milliseconds;
 
+        // Slow-changing values come from the metrics page, which the audio service thread refreshes
+        // once a second while audio is running.
+        MetricsPage::HostMetrics hostMetrics = metricsPage.ReadHost();
+        auto nowMs = duration_cast<milliseconds>(std::chrono::system_clock ::now().time_since_epoch()).count();
+        if (nowMs - hostMetrics.updateTimeMs > (int64_t)(METRICS_PUBLISH_PERIOD_S * 2000))
+        {
+            hostMetrics = PublishHostMetrics(); // audio isn't running, so nobody else is publishing.
+        }
+        MetricsPage::RealtimeMetrics realtimeMetrics = metricsPage.ReadRealtime();
+
         std::lock_guard guard(mutex);
 
         JackHostStatus result;
-        result.underruns_ = this->underruns;
-        auto dt = duration_cast<milliseconds>(std::chrono::system_clock ::now().time_since_epoch()).count() - duration_cast<milliseconds>(this->lastUnderrunTime.load().time_since_epoch()).count();
+        result.underruns_ = realtimeMetrics.underruns;
+        auto dt = nowMs - duration_cast<milliseconds>(this->lastUnderrunTime.load().time_since_epoch()).count();
 
         result.msSinceLastUnderrun_ = (uint64_t)dt;
 
-        result.temperaturemC_ = (int32_t)(std::round(cpuTemperatureMonitor->GetTemperatureC() * 1000));
+        result.temperaturemC_ = hostMetrics.temperaturemC;
 
         result.active_ = IsAudioRunning();
         result.restarting_ = this->restarting;
 
+        result.cpuUsage_ = hostMetrics.cpuUsage;
         if (this->audioDriver != nullptr)
         {
-            result.cpuUsage_ = audioDriver->CpuUse();
+            result.cpuUseStatistics_ = audioDriver->GetCpuUseStatistics();
+            result.xrunRecovery_ = audioDriver->GetXrunRecoveryStatistics();
+            result.switchLatency_ = switchLatencyMonitor.GetStatistics();
         }
-        GetCpuFrequency(&result.cpuFreqMin_, &result.cpuFreqMax_);
-        result.hasCpuGovernor_ = HasCpuGovernor();
-        if (result.hasCpuGovernor_)
+        result.cpuFreqMin_ = hostMetrics.cpuFreqMin;
+        result.cpuFreqMax_ = hostMetrics.cpuFreqMax;
+        result.throttled_ = hostMetrics.throttled;
+        result.hasCpuGovernor_ = hostMetrics.hasCpuGovernor;
+        result.governor_ = hostMetrics.GetGovernor();
+        if (this->currentPedalboard)
         {
-            result.governor_ = GetGovernor();
+            result.parallelSplitTimings_ = this->currentPedalboard->GetParallelSplitTimings();
+            result.taskGroupTimings_ = this->currentPedalboard->GetTaskGroupTimings();
+            result.monoModeEffects_ = this->currentPedalboard->GetMonoModeEffectCount();
+            result.monoModeSavedLoad_ = this->currentPedalboard->GetMonoModeSavedLoad();
         }
-        else
+        result.fileStreams_ = pHost->GetFileStreamStatistics();
+        result.lastSnapshotApplyUs_ = this->lastSnapshotApplyUs;
+        result.droppedControlMessages_ = this->outputRingBuffer.getOverflowCount();
+        result.droppedTelemetryMessages_ = this->telemetryRingBuffer.getOverflowCount();
+        result.droppedBulkMessages_ = this->bulkRingBuffer.getOverflowCount();
         {
-            result.governor_ = "";
+            std::lock_guard guard(mutex);
+            if (this->currentPedalboardSlots)
+            {
+                result.pedalboardSlotUs_ = this->currentPedalboardSlots->GetSlotRunUs();
+            }
+        }
+        result.recording_ = this->recorder.IsRecording();
+        result.recordedFrames_ = this->recorder.GetFramesWritten();
+        result.droppedRecordingFrames_ = this->recorder.GetDroppedFrames();
+        if (auto hostWorkerThread = pHost->GetHostWorkerThread())
+        {
+            result.lv2Worker_ = hostWorkerThread->GetStats();
+        }
+        if (RealtimeTripwire::Enabled)
+        {
+            RealtimeTripwireCounts counts = RealtimeTripwire::GetCounts();
+            result.realtimeTripwire_ = true;
+            result.realtimeAllocations_ = counts.allocations + counts.frees;
+            result.realtimeLocks_ = counts.locks;
+            result.realtimeLockContentions_ = counts.lockContentions;
+            result.realtimeSyscalls_ = counts.syscalls;
         }
 
         return result;
     }
     std::atomic<bool> listenForMidiEvent = false;
-    std::atomic<bool> listenForAtomOutput = false;
 
     virtual void SetListenForMidiEvent(bool listen)
     {
         this->listenForMidiEvent = listen;
     }
-    virtual void SetListenForAtomOutput(bool listen)
+    virtual void SetAtomOutputSubscriptions(const std::vector<AtomOutputSubscription> &subscriptions) override
     {
-        this->listenForAtomOutput = listen;
+        std::lock_guard guard(mutex);
+        if (subscriptions == this->atomOutputSubscriptions)
+        {
+            return;
+        }
+        this->atomOutputSubscriptions = subscriptions;
+
+        RealtimeAtomOutputSubscriptions *realtimeSubscriptions = nullptr;
+        if (subscriptions.size() != 0)
+        {
+            realtimeSubscriptions = new RealtimeAtomOutputSubscriptions();
+            realtimeSubscriptions->subscriptions = subscriptions;
+        }
+        if (active)
+        {
+            hostWriter.SetAtomOutputSubscriptions(realtimeSubscriptions);
+        }
+        else
+        {
+            // the audio thread isn't running.
+            delete this->realtimeAtomOutputSubscriptions;
+            this->realtimeAtomOutputSubscriptions = realtimeSubscriptions;
+            realtimeWriter.SetAtomOutputFilter(realtimeSubscriptions);
+        }
     }
 };
 
@@ -2167,70 +3686,52 @@ static std::string UriToFieldName(const std::string &uri)
 
 void AudioHostImpl::SetSystemMidiBindings(const std::vector<MidiBinding> &bindings)
 {
+    static const std::pair<const char *, SystemMidiAction> actionSymbols[] = {
+        {"nextBank", SystemMidiAction::NextBank},
+        {"prevBank", SystemMidiAction::PrevBank},
+        {"nextProgram", SystemMidiAction::NextProgram},
+        {"prevProgram", SystemMidiAction::PrevProgram},
+        {"startHotspot", SystemMidiAction::StartHotspot},
+        {"stopHotspot", SystemMidiAction::StopHotspot},
+        {"reboot", SystemMidiAction::Reboot},
+        {"shutdown", SystemMidiAction::Shutdown},
+        {"snapshot1", SystemMidiAction::Snapshot1},
+        {"snapshot2", SystemMidiAction::Snapshot2},
+        {"snapshot3", SystemMidiAction::Snapshot3},
+        {"snapshot4", SystemMidiAction::Snapshot4},
+        {"snapshot5", SystemMidiAction::Snapshot5},
+        {"snapshot6", SystemMidiAction::Snapshot6},
+    };
+    std::lock_guard guard(mutex);
+
     for (auto i = bindings.begin(); i != bindings.end(); ++i)
     {
-
-        if (i->symbol() == "nextBank")
-        {
-            this->nextBankMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "prevBank")
-        {
-            this->prevBankMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "nextProgram")
-        {
-            this->nextPresetMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "prevProgram")
-        {
-            this->prevPresetMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "startHotspot")
-        {
-            this->startHotspotMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "stopHotspot")
-        {
-            this->stopHotspotMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "reboot")
-        {
-            this->rebootMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "shutdown")
-        {
-            this->shutdownMidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot1")
-        {
-            this->snapshot1MidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot2")
-        {
-            this->snapshot2MidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot3")
-        {
-            this->snapshot3MidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot4")
-        {
-            this->snapshot4MidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot5")
+        bool found = false;
+        for (const auto &actionSymbol : actionSymbols)
         {
-            this->snapshot5MidiBinding.SetBinding(*i);
-        }
-        else if (i->symbol() == "snapshot6")
-        {
-            this->snapshot6MidiBinding.SetBinding(*i);
+            if (i->symbol() == actionSymbol.first)
+            {
+                this->systemMidiBindings[(size_t)actionSymbol.second] = *i;
+                found = true;
+                break;
+            }
         }
-        else
+        if (!found)
         {
             Lv2Log::error(SS("Invalid system midi binding: " << i->symbol()));
         }
     }
+    SystemMidiDispatch *systemMidiDispatch = new SystemMidiDispatch(this->systemMidiBindings);
+    if (active)
+    {
+        hostWriter.SetSystemMidiDispatch(systemMidiDispatch);
+    }
+    else
+    {
+        // the audio thread isn't running.
+        delete this->realtimeSystemMidiDispatch;
+        this->realtimeSystemMidiDispatch = systemMidiDispatch;
+    }
 }
 
 AudioHost *AudioHost::CreateInstance(IHost *pHost)
@@ -2285,7 +3786,7 @@ bool AudioHostImpl::UpdatePluginState(PedalboardItem &pedalboardItem)
         try
         {
             Lv2PluginState state;
-            if (!effect->GetLv2State(&state))
+            if (!effect->GetLv2StateIfChanged(&state))
             {
                 return false;
             }
@@ -2308,7 +3809,16 @@ bool AudioHostImpl::UpdatePluginState(PedalboardItem &pedalboardItem)
 void AudioHostImpl::OnWritePatchPropertyBuffer(
     PatchPropertyWriter::Buffer *buffer)
 {
-    this->realtimeWriter.SendPathPropertyBuffer(buffer);
+    if (pendingPathPropertyBufferCount == MAX_PENDING_PATH_PROPERTY_BUFFERS)
+    {
+        if (!writePathPropertyBuffers())
+        {
+            // no way to deliver it. Drop the update, and return the buffer to the writer.
+            buffer->OnBufferReadComplete();
+            return;
+        }
+    }
+    pendingPathPropertyBuffers[pendingPathPropertyBufferCount++] = buffer;
 }
 
 void AudioHostImpl::SetAlsaSequencerConfiguration(const AlsaSequencerConfiguration &alsaSequencerConfiguration)
@@ -2328,6 +3838,33 @@ JSON_MAP_REFERENCE(JackHostStatus, msSinceLastUnderrun)
 JSON_MAP_REFERENCE(JackHostStatus, temperaturemC)
 JSON_MAP_REFERENCE(JackHostStatus, cpuFreqMin)
 JSON_MAP_REFERENCE(JackHostStatus, cpuFreqMax)
+JSON_MAP_REFERENCE(JackHostStatus, throttled)
 JSON_MAP_REFERENCE(JackHostStatus, hasCpuGovernor)
 JSON_MAP_REFERENCE(JackHostStatus, governor)
+JSON_MAP_REFERENCE(JackHostStatus, parallelSplitTimings)
+JSON_MAP_REFERENCE(JackHostStatus, taskGroupTimings)
+JSON_MAP_REFERENCE(JackHostStatus, fileStreams)
+JSON_MAP_REFERENCE(JackHostStatus, monoModeEffects)
+JSON_MAP_REFERENCE(JackHostStatus, monoModeSavedLoad)
+JSON_MAP_REFERENCE(JackHostStatus, realtimeTripwire)
+JSON_MAP_REFERENCE(JackHostStatus, realtimeAllocations)
+JSON_MAP_REFERENCE(JackHostStatus, realtimeLocks)
+JSON_MAP_REFERENCE(JackHostStatus, realtimeLockContentions)
+JSON_MAP_REFERENCE(JackHostStatus, realtimeSyscalls)
+JSON_MAP_REFERENCE(JackHostStatus, lastSnapshotApplyUs)
+JSON_MAP_REFERENCE(JackHostStatus, droppedControlMessages)
+JSON_MAP_REFERENCE(JackHostStatus, droppedTelemetryMessages)
+JSON_MAP_REFERENCE(JackHostStatus, droppedBulkMessages)
+JSON_MAP_REFERENCE(JackHostStatus, pedalboardSlotUs)
+JSON_MAP_REFERENCE(JackHostStatus, recording)
+JSON_MAP_REFERENCE(JackHostStatus, recordedFrames)
+JSON_MAP_REFERENCE(JackHostStatus, droppedRecordingFrames)
+JSON_MAP_REFERENCE(JackHostStatus, lv2Worker)
+JSON_MAP_REFERENCE(JackHostStatus, cpuUseStatistics)
+JSON_MAP_REFERENCE(JackHostStatus, xrunRecovery)
+JSON_MAP_REFERENCE(JackHostStatus, switchLatency)
+JSON_MAP_REFERENCE(JackHostStatus, webSocketQueuedBytes)
+JSON_MAP_REFERENCE(JackHostStatus, webSocketStalledDisconnects)
+JSON_MAP_REFERENCE(JackHostStatus, caches)
+JSON_MAP_REFERENCE(JackHostStatus, pluginMemory)
 JSON_MAP_END()
@@ -24,14 +24,25 @@
 
 #include "Lv2Pedalboard.hpp"
 #include "VuUpdate.hpp"
+#include "EffectTiming.hpp"
+#include "LatencyProbe.hpp"
+#include "RealtimePedalboardSlots.hpp"
+#include "CpuUse.hpp"
+#include "AudioPeriodTrace.hpp"
+#include "SwitchLatencyMonitor.hpp"
+#include "CacheRegistry.hpp"
+#include "MemoryFootprint.hpp"
+#include "Worker.hpp"
 #include "json.hpp"
 #include "AudioHost.hpp"
 #include "JackServerSettings.hpp"
 #include <functional>
+#include <filesystem>
 #include "PiPedalAlsa.hpp"
 #include "Promise.hpp"
 #include "json_variant.hpp"
 #include "RealtimeMidiEventType.hpp"
+#include "RealtimePatchPropertyRequest.hpp"
 
 namespace pipedal
 {
@@ -51,106 +62,44 @@ namespace pipedal
         int64_t subscriptionHandle;
         float value;
     };
-    class RealtimePatchPropertyRequest
+    class MonitorPortSubscription
+    {
+    public:
+        int64_t subscriptionHandle;
+        int64_t instanceid;
+        std::string key;
+        float updateInterval;
+        PortMonitorCallback onUpdate;
+        float epsilon = 0; // changes smaller than epsilon are not reported.
+    };
+
+    static constexpr float MAX_VU_UPDATES_PER_SECOND = 30;
+
+    class VuSubscriptionRate
     {
     public:
-        int64_t clientId;
         int64_t instanceId;
-        LV2_URID uridUri;
-        std::string uri;
-
-        enum class RequestType
-        {
-            PatchGet,
-            PatchSet
-        };
-        RequestType requestType;
-
-        std::function<void(RealtimePatchPropertyRequest *)> onPatchRequestComplete;
-        std::function<void(const std::string &jsonResjult)> onSuccess;
-        std::function<void(const std::string &error)> onError;
-
-        const char *errorMessage = nullptr;
-        std::string jsonResponse;
-        int64_t sampleTimeout = 0;
-
-        RealtimePatchPropertyRequest *pNext = nullptr;
-
-        void SetSize(size_t size)
-        {
-            responseLength = size;
-            if (responseLength > sizeof(atomBuffer))
-            {
-                longAtomBuffer.resize(size);
-            }
-        }
-        size_t GetSize() const { return responseLength; }
-        uint8_t *GetBuffer()
-        {
-            if (responseLength > sizeof(atomBuffer))
-            {
-                return &(longAtomBuffer[0]);
-            }
-            return atomBuffer;
-        }
-
-    private:
-        int responseLength = 0;
-        uint8_t atomBuffer[2048];
-        std::vector<uint8_t> longAtomBuffer;
+        float updatesPerSecond; // (0, MAX_VU_UPDATES_PER_SECOND]
+    };
 
+    // A plugin patch property that a client listens to. The audio thread only relays
+    // patch:Set outputs that match a subscription.
+    class AtomOutputSubscription
+    {
     public:
-        RealtimePatchPropertyRequest(
-            std::function<void(RealtimePatchPropertyRequest *)> onPatchRequestcomplete_,
-            int64_t clientId_,
-            int64_t instanceId_,
-            LV2_URID uridUri_,
-            std::function<void(const std::string &jsonResjult)> onSuccess_,
-            std::function<void(const std::string &error)> onError_,
-            size_t sampleTimeout)
-            : onPatchRequestComplete(onPatchRequestcomplete_),
-              clientId(clientId_),
-              instanceId(instanceId_),
-              uridUri(uridUri_),
-              onSuccess(onSuccess_),
-              onError(onError_),
-              sampleTimeout((int64_t)sampleTimeout)
-
-        {
-            requestType = RequestType::PatchGet;
-        }
-        RealtimePatchPropertyRequest(
-            std::function<void(RealtimePatchPropertyRequest *)> onPatchRequestcomplete_,
-            int64_t clientId_,
-            int64_t instanceId_,
-            LV2_URID uridUri_,
-            LV2_Atom *atomValue,
-            std::function<void(const std::string &jsonResjult)> onSuccess_,
-            std::function<void(const std::string &error)> onError_,
-            size_t sampleTimeout)
-            : onPatchRequestComplete(onPatchRequestcomplete_),
-              clientId(clientId_),
-              instanceId(instanceId_),
-              uridUri(uridUri_),
-              onSuccess(onSuccess_),
-              onError(onError_),
-              sampleTimeout(sampleTimeout)
-        {
-            requestType = RequestType::PatchSet;
-            size_t size = atomValue->size + sizeof(LV2_Atom);
-            SetSize(size);
-            memcpy(GetBuffer(), atomValue, size);
-        }
+        uint64_t instanceId;
+        LV2_URID propertyUrid; // 0 for all properties of the instance.
+
+        bool operator==(const AtomOutputSubscription &other) const = default;
     };
 
-    class MonitorPortSubscription
+    // A control value changed by a MIDI binding.
+    class MidiValueChange
     {
     public:
-        int64_t subscriptionHandle;
-        int64_t instanceid;
-        std::string key;
-        float updateInterval;
-        PortMonitorCallback onUpdate;
+        int64_t instanceId;
+        int controlIndex;
+        float value;
     };
 
     class IAudioHostCallbacks
@@ -159,8 +108,13 @@ namespace pipedal
         virtual void OnNotifyLv2StateChanged(uint64_t instanceId) = 0;
         virtual void OnNotifyMaybeLv2StateChanged(uint64_t instanceId) = 0;
         virtual void OnNotifyVusSubscription(const std::vector<VuUpdate> &updates) = 0;
+        virtual void OnNotifyEffectTimings(const std::vector<EffectTiming> &timings) = 0;
+        // Overload protection: the audio thread has been overloaded for a while, and an effect should be
+        // bypassed. timings are the most recent effect timings.
+        virtual void OnNotifyOverload(const std::vector<EffectTiming> &timings) = 0;
         virtual void OnNotifyMonitorPort(const MonitorPortUpdate &update) = 0;
-        virtual void OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value) = 0;
+        // Coalesced: only the last value of each control in a VU update interval.
+        virtual void OnNotifyMidiValuesChanged(const std::vector<MidiValueChange> &changes) = 0;
         virtual void OnNotifyMidiListen(uint8_t cc0, uint8_t cc1, uint8_t cc2) = 0;
 
         virtual void OnNotifyPathPatchPropertyReceived(
@@ -180,6 +134,9 @@ namespace pipedal
         virtual void OnNotifyMidiRealtimeEvent(RealtimeMidiEventType eventType) = 0;
         virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex,int64_t snapshotRequestId) = 0;
 
+        // The audio thread left idle mode because input signal or MIDI arrived.
+        virtual void OnNotifyIdleWake() = 0;
+
         virtual void OnAlsaDriverTerminatedAbnormally() = 0;
         virtual void OnAlsaSequencerDeviceAdded(int client, const std::string &clientName) = 0;
         virtual void OnAlsaSequencerDeviceRemoved(int client) = 0;
@@ -197,8 +154,38 @@ namespace pipedal
         int32_t temperaturemC_ = -100000;
         uint64_t cpuFreqMax_ = 0;
         uint64_t cpuFreqMin_ = 0;
+        int32_t throttled_ = -1; // Raspberry Pi firmware throttling flags (SysfsSampler::THROTTLED_*). -1 if not available.
         bool hasCpuGovernor_ = true;
         std::string governor_;
+        std::vector<ParallelSplitTiming> parallelSplitTimings_;
+        std::vector<TaskGroupTiming> taskGroupTimings_;
+        std::vector<FileStreamStatistics> fileStreams_;
+        uint64_t monoModeEffects_ = 0; // dual-mode plugins running mono in the current pedalboard.
+        float monoModeSavedLoad_ = 0;  // estimated load they save, as a fraction of the period.
+        // realtime tripwire counts (ENABLE_RT_TRIPWIRE builds only).
+        bool realtimeTripwire_ = false;
+        uint64_t realtimeAllocations_ = 0; // allocations and frees.
+        uint64_t realtimeLocks_ = 0;
+        uint64_t realtimeLockContentions_ = 0; // realtime locks that had to wait for another thread.
+        uint64_t realtimeSyscalls_ = 0;
+        float lastSnapshotApplyUs_ = 0; // audio-thread time taken to apply the most recent snapshot.
+        // audio-thread messages dropped because their ring buffer was full, by RingBufferClass.
+        uint64_t droppedControlMessages_ = 0;
+        uint64_t droppedTelemetryMessages_ = 0;
+        uint64_t droppedBulkMessages_ = 0;
+        std::vector<float> pedalboardSlotUs_; // helper-thread run time of each additional pedalboard slot.
+        bool recording_ = false;
+        uint64_t recordedFrames_ = 0;
+        uint64_t droppedRecordingFrames_ = 0; // frames lost because the recorder's disk writes fell behind.
+        Lv2WorkerStats lv2Worker_;
+        CpuUseStatistics cpuUseStatistics_;
+        XrunRecoveryStatistics xrunRecovery_;
+        std::vector<SwitchLatencyStatistics> switchLatency_; // footswitch MIDI message -> first period with the new preset, by stage.
+        // filled in by the socket server.
+        uint64_t webSocketQueuedBytes_ = 0; // bytes waiting in websocket send buffers, all clients.
+        uint64_t webSocketStalledDisconnects_ = 0; // clients disconnected because they stopped reading.
+        std::vector<CacheUsage> caches_; // memory use of caches that are trimmed under memory pressure.
+        std::vector<PluginMemoryFootprint> pluginMemory_; // filled in by the model: plugins in the current pedalboard.
 
         DECLARE_JSON_MAP(JackHostStatus);
     };
@@ -220,7 +207,7 @@ namespace pipedal
         virtual void SetNotificationCallbacks(IAudioHostCallbacks *pNotifyCallbacks) = 0;
 
         virtual void SetListenForMidiEvent(bool listen) = 0;
-        virtual void SetListenForAtomOutput(bool listen) = 0;
+        virtual void SetAtomOutputSubscriptions(const std::vector<AtomOutputSubscription> &subscriptions) = 0;
 
         //virtual bool UpdatePluginStates(Pedalboard &pedalboard) = 0;
         virtual bool UpdatePluginState(PedalboardItem &pedalboardItem) = 0;
@@ -236,8 +223,26 @@ namespace pipedal
         virtual JackConfiguration GetServerConfiguration() = 0;
 
         virtual void SetPedalboard(const std::shared_ptr<Lv2Pedalboard> &pedalboard) = 0;
+        // Length of the crossfade between the old and new pedalboard on SetPedalboard. 0 to switch instantly.
+        // Additional pedalboards, each run on its own core, on its own audio driver channels. The main pedalboard
+        // runs on mainInputChannels/mainOutputChannels (all of the driver's channels, if there are no slots).
+        // Pedalboards are sent to the audio thread only while audio is running; send them again after Open().
+        virtual void SetPedalboardSlots(
+            const std::vector<int> &mainInputChannels, const std::vector<int> &mainOutputChannels,
+            const std::vector<AudioPedalboardSlot> &slots) = 0;
+
+        virtual void SetPedalboardCrossfade(float milliseconds) = 0;
+        // Split each audio period into sub-blocks of this many frames, so that MIDI control changes take effect
+        // within the period. 0 to run whole periods.
+        virtual void SetSubBlockFrames(uint32_t frames) = 0;
+        // Time over which continuous controls move to new values when a plugin preset or snapshot is loaded.
+        // 0 to apply them immediately.
+        virtual void SetControlRamp(float milliseconds) = 0;
 
         virtual void SetControlValue(uint64_t instanceId, const std::string &symbol, float value) = 0;
+        // As SetControlValue, with indices already resolved against pedalboard. Returns false (and does nothing)
+        // if pedalboard is no longer the current pedalboard.
+        virtual bool SetControlValue(Lv2Pedalboard *pedalboard, int effectIndex, int controlIndex, float value) = 0;
         virtual void SetInputVolume(float value) = 0;
         virtual void SetOutputVolume(float value) = 0;
         virtual void SetPluginPreset(uint64_t instanceId, const std::vector<ControlValue> &values) = 0;
@@ -245,7 +250,28 @@ namespace pipedal
 
         virtual bool IsOpen() const = 0;
 
-        virtual void SetVuSubscriptions(const std::vector<int64_t> &instanceIds) = 0;
+        // The realtime thread only accumulates VUs for the given instances, each sent at its own rate.
+        virtual void SetVuSubscriptions(const std::vector<VuSubscriptionRate> &subscriptions) = 0;
+        // Enable or disable per-effect execution timing for the current pedalboard.
+        virtual void SetEffectTimingSubscription(bool enabled) = 0;
+        // If enabled, OnNotifyOverload is called when the audio thread stays overloaded. (Requires effect timings,
+        // so callers must also call SetEffectTimingSubscription after each pedalboard change.)
+        virtual void SetOverloadProtection(bool enabled) = 0;
+        // Idle power mode. While idle, the pedalboard doesn't run (outputs are silent), and the host's periodic
+        // metrics and overload checks are suspended. The audio thread leaves idle mode by itself as soon as input
+        // rises above the idle signal threshold or MIDI arrives, and calls IAudioHostCallbacks::OnNotifyIdleWake.
+        virtual void SetIdle(bool idle) = 0;
+        // Linear peak level. 0 to stop tracking input signal.
+        virtual void SetIdleSignalThreshold(float threshold) = 0;
+        // Seconds since the input was last above the idle signal threshold.
+        virtual double GetSecondsSinceSignal() = 0;
+        // If enabled, effect timings include hardware counter results (IPC, cache and branch miss rates) for
+        // effects that run on the audio thread. Adds a pair of read() calls around each effect. (Requires effect
+        // timings, as for SetOverloadProtection.)
+        virtual void SetPmuProfiling(bool enabled) = 0;
+        // If enabled, effect timings report how often each effect's output contained subnormal values. Scans the
+        // output buffers of each effect after it runs. (Requires effect timings, as for SetOverloadProtection.)
+        virtual void SetDenormalDetection(bool enabled) = 0;
         virtual void SetMonitorPortSubscriptions(const std::vector<MonitorPortSubscription> &subscriptions) = 0;
 
         virtual void SetSystemMidiBindings(const std::vector<MidiBinding> &bindings) = 0;
@@ -256,6 +282,20 @@ namespace pipedal
 
 
         virtual JackHostStatus getJackStatus() = 0;
+        // The audio driver's per-period trace for the last `seconds` (xrun forensics).
+        virtual std::vector<AudioPeriodTraceEntry> GetAudioPeriodTrace(double seconds) = 0;
+        virtual void ResetCpuUseStatistics() = 0;
+        // Measures output-to-input latency through a loopback cable, in place of the pedalboard's output.
+        // Blocks for the duration of the measurement (a few seconds).
+        virtual LatencyProbe::Result MeasureRoundTripLatency(int inputChannel, int outputChannel) = 0;
+        // Records the pedalboard's input and output to <directory>/<timestamp>-input.wav and -output.wav.
+        // Returns the path of the recording, without the suffix.
+        virtual std::filesystem::path StartRecording(const std::filesystem::path &directory) = 0;
+        virtual void StopRecording() = 0;
+        // DSP headroom since the last call; nullopt if audio isn't running.
+        virtual std::optional<float> TakeRecentCpuHeadroom() = 0;
+        // CpuTemperatureMonitor::INVALID_TEMPERATURE if not available.
+        virtual float GetCpuTemperatureC() = 0;
 
         virtual void LoadSnapshot(Snapshot &snapshot, PluginHost &pluginHost) = 0;
 
@@ -0,0 +1,176 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "AudioMixKernels.hpp"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+using namespace pipedal;
+
+void pipedal::CopyAudio(const float *input, float *output, uint32_t samples)
+{
+    if (input != output)
+    {
+        std::memmove(output, input, samples * sizeof(float));
+    }
+}
+
+void pipedal::ScaleAudio(const float *input, float gain, float *output, uint32_t samples)
+{
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        __m128 vGain = _mm_set1_ps(gain);
+        for (; i + 4 <= samples; i += 4)
+        {
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), vGain));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        for (; i + 4 <= samples; i += 4)
+        {
+            vst1q_f32(output + i, vmulq_n_f32(vld1q_f32(input + i), gain));
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        output[i] = input[i] * gain;
+    }
+}
+
+void pipedal::ScaleAudioRamp(const float *input, float gain, float dGain, float *output, uint32_t samples)
+{
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        const __m128 vIndex = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 vDGain = _mm_set1_ps(dGain);
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 vi = _mm_add_ps(_mm_set1_ps((float)i), vIndex);
+            __m128 vGain = _mm_add_ps(_mm_set1_ps(gain), _mm_mul_ps(vi, vDGain));
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_loadu_ps(input + i), vGain));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        static const float index[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        const float32x4_t vIndex = vld1q_f32(index);
+        float32x4_t vGain0 = vdupq_n_f32(gain);
+        for (; i + 4 <= samples; i += 4)
+        {
+            float32x4_t vi = vaddq_f32(vdupq_n_f32((float)i), vIndex);
+            float32x4_t vGain = vmlaq_n_f32(vGain0, vi, dGain);
+            vst1q_f32(output + i, vmulq_f32(vld1q_f32(input + i), vGain));
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        output[i] = input[i] * (gain + i * dGain);
+    }
+}
+
+void pipedal::MixAudio(
+    const float *a, float gainA,
+    const float *b, float gainB,
+    float *output, uint32_t samples)
+{
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        __m128 vGainA = _mm_set1_ps(gainA);
+        __m128 vGainB = _mm_set1_ps(gainB);
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 va = _mm_mul_ps(_mm_loadu_ps(a + i), vGainA);
+            __m128 vb = _mm_mul_ps(_mm_loadu_ps(b + i), vGainB);
+            _mm_storeu_ps(output + i, _mm_add_ps(va, vb));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        float32x4_t vGainA = vdupq_n_f32(gainA);
+        float32x4_t vGainB = vdupq_n_f32(gainB);
+        for (; i + 4 <= samples; i += 4)
+        {
+            float32x4_t v = vmulq_f32(vld1q_f32(a + i), vGainA);
+            v = vmlaq_f32(v, vld1q_f32(b + i), vGainB);
+            vst1q_f32(output + i, v);
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        output[i] = a[i] * gainA + b[i] * gainB;
+    }
+}
+
+void pipedal::MixAudioRamp(
+    const float *a, float gainA, float dGainA,
+    const float *b, float gainB, float dGainB,
+    float *output, uint32_t samples)
+{
+    // Gains are computed from the block index rather than accumulated, so rounding errors don't build up over long ramps.
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        const __m128 vIndex = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        __m128 vDGainA = _mm_set1_ps(dGainA);
+        __m128 vDGainB = _mm_set1_ps(dGainB);
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 vi = _mm_add_ps(_mm_set1_ps((float)i), vIndex);
+            __m128 vGainA = _mm_add_ps(_mm_set1_ps(gainA), _mm_mul_ps(vi, vDGainA));
+            __m128 vGainB = _mm_add_ps(_mm_set1_ps(gainB), _mm_mul_ps(vi, vDGainB));
+            __m128 va = _mm_mul_ps(_mm_loadu_ps(a + i), vGainA);
+            __m128 vb = _mm_mul_ps(_mm_loadu_ps(b + i), vGainB);
+            _mm_storeu_ps(output + i, _mm_add_ps(va, vb));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        static const float index[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        const float32x4_t vIndex = vld1q_f32(index);
+        float32x4_t vGainA0 = vdupq_n_f32(gainA);
+        float32x4_t vGainB0 = vdupq_n_f32(gainB);
+        for (; i + 4 <= samples; i += 4)
+        {
+            float32x4_t vi = vaddq_f32(vdupq_n_f32((float)i), vIndex);
+            float32x4_t vGainA = vmlaq_n_f32(vGainA0, vi, dGainA);
+            float32x4_t vGainB = vmlaq_n_f32(vGainB0, vi, dGainB);
+            float32x4_t v = vmulq_f32(vld1q_f32(a + i), vGainA);
+            v = vmlaq_f32(v, vld1q_f32(b + i), vGainB);
+            vst1q_f32(output + i, v);
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        output[i] = a[i] * (gainA + i * dGainA) + b[i] * (gainB + i * dGainB);
+    }
+}
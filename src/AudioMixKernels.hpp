@@ -0,0 +1,49 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+
+namespace pipedal
+{
+    // Block audio kernels shared by the bypass, split and volume code. Vectorized with SSE2 or NEON
+    // where available. The output buffer may be the same buffer as any of the inputs.
+
+    // out[i] = in[i]
+    void CopyAudio(const float *input, float *output, uint32_t samples);
+
+    // out[i] = in[i]*gain
+    void ScaleAudio(const float *input, float gain, float *output, uint32_t samples);
+
+    // As ScaleAudio, with a linear gain ramp: the gain applied to sample i is gain + i*dGain.
+    void ScaleAudioRamp(const float *input, float gain, float dGain, float *output, uint32_t samples);
+
+    // out[i] = a[i]*gainA + b[i]*gainB
+    void MixAudio(
+        const float *a, float gainA,
+        const float *b, float gainB,
+        float *output, uint32_t samples);
+
+    // As MixAudio, with linear gain ramps: the gains applied to sample i are gainA + i*dGainA and gainB + i*dGainB.
+    void MixAudioRamp(
+        const float *a, float gainA, float dGainA,
+        const float *b, float gainB, float dGainB,
+        float *output, uint32_t samples);
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <cmath>
+#include <vector>
+#include "AudioMixKernels.hpp"
+#include "DbDezipper.hpp"
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    // odd length, so that the scalar tail is exercised as well as the vector loop.
+    constexpr uint32_t N_SAMPLES = 67;
+
+    std::vector<float> TestSignal(float frequency)
+    {
+        std::vector<float> result(N_SAMPLES);
+        for (uint32_t i = 0; i < N_SAMPLES; ++i)
+        {
+            result[i] = std::sin(i * frequency);
+        }
+        return result;
+    }
+}
+
+TEST_CASE("AudioMixKernels test", "[audio_mix_kernels][Build][Dev]")
+{
+    auto a = TestSignal(0.1f);
+    auto b = TestSignal(0.37f);
+
+    SECTION("CopyAudio")
+    {
+        std::vector<float> output(N_SAMPLES);
+        CopyAudio(a.data(), output.data(), N_SAMPLES);
+        REQUIRE(output == a);
+    }
+    SECTION("MixAudio")
+    {
+        std::vector<float> output(N_SAMPLES);
+        MixAudio(a.data(), 0.25f, b.data(), 0.75f, output.data(), N_SAMPLES);
+        for (uint32_t i = 0; i < N_SAMPLES; ++i)
+        {
+            REQUIRE(std::abs(output[i] - (a[i] * 0.25f + b[i] * 0.75f)) < 1E-6f);
+        }
+    }
+    SECTION("ScaleAudioRamp")
+    {
+        float dx = -0.5f / N_SAMPLES;
+        std::vector<float> output(N_SAMPLES);
+        ScaleAudioRamp(a.data(), 1.0f, dx, output.data(), N_SAMPLES);
+        for (uint32_t i = 0; i < N_SAMPLES; ++i)
+        {
+            REQUIRE(std::abs(output[i] - a[i] * (1.0f + i * dx)) < 1E-5f);
+        }
+    }
+    SECTION("MixAudioRamp in place")
+    {
+        float dx = 1.0f / N_SAMPLES;
+        std::vector<float> output = a;
+        MixAudioRamp(output.data(), 0.0f, dx, b.data(), 1.0f, -dx, output.data(), N_SAMPLES);
+        for (uint32_t i = 0; i < N_SAMPLES; ++i)
+        {
+            float expected = a[i] * (i * dx) + b[i] * (1 - i * dx);
+            REQUIRE(std::abs(output[i] - expected) < 1E-5f);
+        }
+    }
+}
+
+TEST_CASE("DbDezipper block apply test", "[audio_mix_kernels][Build][Dev]")
+{
+    DbDezipper ticked, applied;
+    for (DbDezipper *dezipper : {&ticked, &applied})
+    {
+        dezipper->SetSampleRate(48000);
+        dezipper->SetRate(0.1f);
+        dezipper->Reset(0);
+        dezipper->SetTarget(-20);
+    }
+    // block sizes that start and end both on and off segment boundaries.
+    uint32_t blockSizes[] = {7, 64, 65, 1, 128, 33, 500, 1000, 3000, 4000};
+    std::vector<float> buffer(4000);
+    for (uint32_t blockSize : blockSizes)
+    {
+        std::fill(buffer.begin(), buffer.end(), 1.0f);
+        applied.Apply(buffer.data(), blockSize);
+        for (uint32_t i = 0; i < blockSize; ++i)
+        {
+            REQUIRE(std::abs(buffer[i] - ticked.Tick()) < 1E-4f);
+        }
+        if (blockSize == 128)
+        {
+            ticked.SetTarget(3);
+            applied.SetTarget(3);
+        }
+    }
+    REQUIRE(ticked.IsIdle());
+    REQUIRE(applied.IsIdle());
+}
@@ -0,0 +1,180 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "AudioPeaks.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace pipedal;
+
+static int16_t toInt16(float value)
+{
+    value = std::clamp(value, -1.0f, 1.0f);
+    return (int16_t)(value * 32767.0f);
+}
+
+AudioPeaks::AudioPeaks(uint32_t sampleRate)
+    : sampleRate(sampleRate)
+{
+    for (uint32_t samplesPerBucket : LEVEL_SAMPLES_PER_BUCKET)
+    {
+        Level level;
+        level.samplesPerBucket = samplesPerBucket;
+        levels.push_back(std::move(level));
+    }
+}
+
+void AudioPeaks::AddSamples(const float *samples, size_t count)
+{
+    const uint32_t samplesPerBucket = levels[0].samplesPerBucket;
+    for (size_t i = 0; i < count; ++i)
+    {
+        float value = samples[i];
+        if (bucketSamples == 0)
+        {
+            bucketMin = bucketMax = value;
+        }
+        else
+        {
+            bucketMin = std::min(bucketMin, value);
+            bucketMax = std::max(bucketMax, value);
+        }
+        if (++bucketSamples == samplesPerBucket)
+        {
+            FlushBucket();
+        }
+    }
+    frameCount += count;
+}
+
+void AudioPeaks::FlushBucket()
+{
+    levels[0].minMax.push_back(toInt16(bucketMin));
+    levels[0].minMax.push_back(toInt16(bucketMax));
+    bucketSamples = 0;
+}
+
+void AudioPeaks::Finish()
+{
+    if (bucketSamples != 0)
+    {
+        FlushBucket();
+    }
+    for (size_t l = 1; l < levels.size(); ++l)
+    {
+        const Level &finer = levels[l - 1];
+        Level &level = levels[l];
+        size_t ratio = level.samplesPerBucket / finer.samplesPerBucket;
+        size_t finerBuckets = finer.BucketCount();
+
+        level.minMax.clear();
+        level.minMax.reserve(((finerBuckets + ratio - 1) / ratio) * 2);
+        for (size_t i = 0; i < finerBuckets; i += ratio)
+        {
+            size_t end = std::min(i + ratio, finerBuckets);
+            int16_t minValue = finer.minMax[i * 2];
+            int16_t maxValue = finer.minMax[i * 2 + 1];
+            for (size_t j = i + 1; j < end; ++j)
+            {
+                minValue = std::min(minValue, finer.minMax[j * 2]);
+                maxValue = std::max(maxValue, finer.minMax[j * 2 + 1]);
+            }
+            level.minMax.push_back(minValue);
+            level.minMax.push_back(maxValue);
+        }
+    }
+}
+
+template <typename T>
+static void write(std::vector<uint8_t> &output, T value)
+{
+    size_t pos = output.size();
+    output.resize(pos + sizeof(T));
+    std::memcpy(output.data() + pos, &value, sizeof(T));
+}
+
+template <typename T>
+static T read(const std::vector<uint8_t> &input, size_t *pos)
+{
+    if (*pos + sizeof(T) > input.size())
+    {
+        throw std::runtime_error("Invalid peak data.");
+    }
+    T value;
+    std::memcpy(&value, input.data() + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return value;
+}
+
+static constexpr char PEAKS_MAGIC[4] = {'P', 'K', 'S', '1'};
+
+std::vector<uint8_t> AudioPeaks::Serialize() const
+{
+    size_t size = sizeof(PEAKS_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+    for (const auto &level : levels)
+    {
+        size += 2 * sizeof(uint32_t) + level.minMax.size() * sizeof(int16_t);
+    }
+    std::vector<uint8_t> result;
+    result.reserve(size);
+    result.insert(result.end(), PEAKS_MAGIC, PEAKS_MAGIC + sizeof(PEAKS_MAGIC));
+    write<uint32_t>(result, sampleRate);
+    write<uint64_t>(result, frameCount);
+    write<uint32_t>(result, (uint32_t)levels.size());
+    for (const auto &level : levels)
+    {
+        write<uint32_t>(result, level.samplesPerBucket);
+        write<uint32_t>(result, (uint32_t)level.BucketCount());
+        size_t pos = result.size();
+        result.resize(pos + level.minMax.size() * sizeof(int16_t));
+        std::memcpy(result.data() + pos, level.minMax.data(), level.minMax.size() * sizeof(int16_t));
+    }
+    return result;
+}
+
+AudioPeaks AudioPeaks::Deserialize(const std::vector<uint8_t> &data)
+{
+    if (data.size() < sizeof(PEAKS_MAGIC) || std::memcmp(data.data(), PEAKS_MAGIC, sizeof(PEAKS_MAGIC)) != 0)
+    {
+        throw std::runtime_error("Invalid peak data.");
+    }
+    size_t pos = sizeof(PEAKS_MAGIC);
+    AudioPeaks result(read<uint32_t>(data, &pos));
+    result.frameCount = read<uint64_t>(data, &pos);
+    uint32_t levelCount = read<uint32_t>(data, &pos);
+    result.levels.clear();
+    for (uint32_t i = 0; i < levelCount; ++i)
+    {
+        Level level;
+        level.samplesPerBucket = read<uint32_t>(data, &pos);
+        uint32_t bucketCount = read<uint32_t>(data, &pos);
+        size_t bytes = (size_t)bucketCount * 2 * sizeof(int16_t);
+        if (pos + bytes > data.size())
+        {
+            throw std::runtime_error("Invalid peak data.");
+        }
+        level.minMax.resize((size_t)bucketCount * 2);
+        std::memcpy(level.minMax.data(), data.data() + pos, bytes);
+        pos += bytes;
+        result.levels.push_back(std::move(level));
+    }
+    return result;
+}
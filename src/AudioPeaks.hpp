@@ -0,0 +1,88 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Multi-resolution min/max peaks of an audio file, for drawing waveforms without decoding the file.
+     *
+     * Each level holds the min and max sample value of consecutive buckets of samplesPerBucket samples.
+     * Coarser levels are built from the finest level, so bucket boundaries line up across levels.
+     *
+     * The serialized form (served to the web client) is little-endian:
+     *
+     *     char[4]  "PKS1"
+     *     uint32   sampleRate
+     *     uint64   frameCount
+     *     uint32   levelCount
+     *     levelCount x {
+     *         uint32   samplesPerBucket
+     *         uint32   bucketCount
+     *         int16    minMax[bucketCount*2]   // min, max, min, max, ... (full scale = 32767)
+     *     }
+     */
+    class AudioPeaks
+    {
+    public:
+        static constexpr uint32_t DEFAULT_SAMPLE_RATE = 48000;
+        // Each level must be a multiple of the previous one.
+        static constexpr uint32_t LEVEL_SAMPLES_PER_BUCKET[] = {256, 4096, 65536};
+
+        class Level
+        {
+        public:
+            uint32_t samplesPerBucket = 0;
+            std::vector<int16_t> minMax; // interleaved min, max for each bucket.
+
+            size_t BucketCount() const { return minMax.size() / 2; }
+        };
+
+        AudioPeaks(uint32_t sampleRate = DEFAULT_SAMPLE_RATE);
+
+        // Accumulate mono samples. Call Finish() after the last samples.
+        void AddSamples(const float *samples, size_t count);
+        void Finish();
+
+        uint32_t SampleRate() const { return sampleRate; }
+        uint64_t FrameCount() const { return frameCount; }
+        const std::vector<Level> &Levels() const { return levels; }
+
+        std::vector<uint8_t> Serialize() const;
+        // Throws std::runtime_error if the data is not valid.
+        static AudioPeaks Deserialize(const std::vector<uint8_t> &data);
+
+    private:
+        void FlushBucket();
+
+        uint32_t sampleRate;
+        uint64_t frameCount = 0;
+        std::vector<Level> levels;
+
+        float bucketMin = 0;
+        float bucketMax = 0;
+        uint32_t bucketSamples = 0;
+    };
+}
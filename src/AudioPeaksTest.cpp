@@ -0,0 +1,72 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "AudioPeaks.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace pipedal;
+
+TEST_CASE("AudioPeaks test", "[audioPeaks][Build][Dev]")
+{
+    // a ramp from -1 to 1 over 70000 samples, added in odd-sized blocks.
+    const size_t N = 70000;
+    std::vector<float> samples(N);
+    for (size_t i = 0; i < N; ++i)
+    {
+        samples[i] = -1.0f + 2.0f * i / (N - 1);
+    }
+    AudioPeaks peaks;
+    for (size_t i = 0; i < N; i += 1001)
+    {
+        peaks.AddSamples(samples.data() + i, std::min((size_t)1001, N - i));
+    }
+    peaks.Finish();
+
+    REQUIRE(peaks.FrameCount() == N);
+    const auto &levels = peaks.Levels();
+    REQUIRE(levels.size() == 3);
+    REQUIRE(levels[0].BucketCount() == (N + 255) / 256);
+    REQUIRE(levels[1].BucketCount() == (N + 4095) / 4096);
+    REQUIRE(levels[2].BucketCount() == 2);
+
+    // the ramp is monotonic, so each bucket's min is its first sample, and max its last.
+    REQUIRE(levels[0].minMax[0] == -32767);
+    REQUIRE(levels[0].minMax[1] == (int16_t)(samples[255] * 32767.0f));
+    REQUIRE(levels[1].minMax[1] == (int16_t)(samples[4095] * 32767.0f));
+    REQUIRE(levels[2].minMax[0] == -32767);
+    REQUIRE(levels[2].minMax[3] == 32767);
+
+    std::vector<uint8_t> data = peaks.Serialize();
+    AudioPeaks copy = AudioPeaks::Deserialize(data);
+    REQUIRE(copy.SampleRate() == peaks.SampleRate());
+    REQUIRE(copy.FrameCount() == peaks.FrameCount());
+    REQUIRE(copy.Levels().size() == levels.size());
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        REQUIRE(copy.Levels()[i].samplesPerBucket == levels[i].samplesPerBucket);
+        REQUIRE(copy.Levels()[i].minMax == levels[i].minMax);
+    }
+
+    data.resize(data.size() - 1);
+    REQUIRE_THROWS(AudioPeaks::Deserialize(data));
+}
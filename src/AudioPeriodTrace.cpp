@@ -0,0 +1,329 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "AudioPeriodTrace.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sched.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+JSON_MAP_BEGIN(AudioPeriodTraceEntry)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, time)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, event)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, readUs)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, processUs)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, writeUs)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, captureAvail)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, playbackAvail)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, wakeLateUs)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, cpu)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, cpuFreqMhz)
+    JSON_MAP_REFERENCE(AudioPeriodTraceEntry, temperatureC)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(XrunRecoveryStatistics)
+    JSON_MAP_REFERENCE(XrunRecoveryStatistics, recoveries)
+    JSON_MAP_REFERENCE(XrunRecoveryStatistics, restarts)
+    JSON_MAP_REFERENCE(XrunRecoveryStatistics, lastUs)
+    JSON_MAP_REFERENCE(XrunRecoveryStatistics, meanUs)
+    JSON_MAP_REFERENCE(XrunRecoveryStatistics, maxUs)
+JSON_MAP_END()
+
+static std::mutex dumpDirectoryMutex;
+static fs::path dumpDirectory;
+
+void AudioPeriodTrace::SetDumpDirectory(const std::filesystem::path &path)
+{
+    std::lock_guard<std::mutex> lock(dumpDirectoryMutex);
+    dumpDirectory = path;
+}
+
+static fs::path GetDumpDirectory()
+{
+    std::lock_guard<std::mutex> lock(dumpDirectoryMutex);
+    return dumpDirectory;
+}
+
+AudioPeriodTrace::AudioPeriodTrace()
+{
+}
+
+AudioPeriodTrace::~AudioPeriodTrace()
+{
+    Stop();
+}
+
+void AudioPeriodTrace::Start(uint32_t sampleRate, uint32_t periodSize)
+{
+    Stop();
+    this->sampleRate = sampleRate;
+    this->periodSize = periodSize;
+    size_t size = (size_t)std::ceil(TRACE_SECONDS * sampleRate / periodSize);
+    ring.clear();
+    ring.resize(std::max(size, (size_t)16));
+    writeCount = 0;
+    xrunTimeNs = 0;
+    frozen = false;
+
+    sysfsSampler = SysfsSampler::GetShared();
+    terminateMonitor = false;
+    monitorThread = std::make_unique<std::jthread>([this]()
+                                                   { MonitorThreadProc(); });
+}
+
+void AudioPeriodTrace::Stop()
+{
+    if (monitorThread)
+    {
+        terminateMonitor = true;
+        monitorThread->join();
+        monitorThread = nullptr;
+    }
+}
+
+void AudioPeriodTrace::Write(AudioPeriodTraceRecord &record)
+{
+    if (ring.empty() || frozen.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    int cpu = sched_getcpu(); // vDSO.
+    record.cpu = (int16_t)cpu;
+    record.cpuFreqKhz = sysfsSampler->GetCpuFrequencyKhz(cpu);
+    float temperature = sysfsSampler->GetTemperatureC();
+    record.temperatureDeciC = temperature == SysfsSampler::INVALID_TEMPERATURE ? 0 : (int16_t)std::round(temperature * 10);
+
+    uint64_t index = writeCount.load(std::memory_order_relaxed);
+    ring[index % ring.size()] = record;
+    writeCount.store(index + 1, std::memory_order_release);
+}
+
+void AudioPeriodTrace::Xrun(char event, int32_t error)
+{
+    AudioPeriodTraceRecord record;
+    record.startNs = Now();
+    record.event = event;
+    record.captureAvail = error;
+    record.playbackAvail = error;
+    Write(record);
+
+    uint64_t expected = 0;
+    xrunTimeNs.compare_exchange_strong(expected, record.startNs);
+}
+
+void AudioPeriodTrace::XrunRecovered(uint64_t startNs, bool restarted)
+{
+    AudioPeriodTraceRecord record;
+    record.startNs = Now();
+    uint64_t recoveryNs = record.startNs - startNs;
+    record.event = 'R';
+    record.readNs = (uint32_t)std::min<uint64_t>(recoveryNs, UINT32_MAX);
+    Write(record);
+
+    lastXrunRecoveryNs.store(recoveryNs, std::memory_order_relaxed);
+    totalXrunRecoveryNs.fetch_add(recoveryNs, std::memory_order_relaxed);
+    if (recoveryNs > maxXrunRecoveryNs.load(std::memory_order_relaxed))
+    {
+        maxXrunRecoveryNs.store(recoveryNs, std::memory_order_relaxed); // (only the audio thread writes.)
+    }
+    if (restarted)
+    {
+        xrunRestarts.fetch_add(1, std::memory_order_relaxed);
+    }
+    xrunRecoveries.fetch_add(1, std::memory_order_release);
+}
+
+XrunRecoveryStatistics AudioPeriodTrace::GetXrunRecoveryStatistics() const
+{
+    XrunRecoveryStatistics result;
+    result.recoveries_ = xrunRecoveries.load(std::memory_order_acquire);
+    result.restarts_ = xrunRestarts.load(std::memory_order_relaxed);
+    result.lastUs_ = lastXrunRecoveryNs.load(std::memory_order_relaxed) * 0.001f;
+    result.maxUs_ = maxXrunRecoveryNs.load(std::memory_order_relaxed) * 0.001f;
+    if (result.recoveries_ != 0)
+    {
+        result.meanUs_ = totalXrunRecoveryNs.load(std::memory_order_relaxed) * 0.001f / result.recoveries_;
+    }
+    return result;
+}
+
+std::vector<AudioPeriodTraceRecord> AudioPeriodTrace::Snapshot()
+{
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    std::vector<AudioPeriodTraceRecord> result;
+    if (ring.empty())
+    {
+        return result;
+    }
+    frozen.store(true, std::memory_order_seq_cst);
+    uint64_t end = writeCount.load(std::memory_order_acquire);
+    // a write that started before the freeze may still be landing in the oldest slot, so skip it.
+    uint64_t begin = end > ring.size() - 1 ? end - (ring.size() - 1) : 0;
+    result.reserve(end - begin);
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        result.push_back(ring[i % ring.size()]);
+    }
+    frozen.store(false, std::memory_order_release);
+    return result;
+}
+
+std::vector<AudioPeriodTraceEntry> AudioPeriodTrace::GetRecent(double seconds)
+{
+    std::vector<AudioPeriodTraceRecord> records = Snapshot();
+    std::vector<AudioPeriodTraceEntry> result;
+    if (records.empty())
+    {
+        return result;
+    }
+    uint64_t lastNs = records.back().startNs;
+    uint64_t windowNs = (uint64_t)(std::max(0.0, seconds) * 1E9);
+    for (const auto &record : records)
+    {
+        if (lastNs - record.startNs > windowNs)
+        {
+            continue;
+        }
+        AudioPeriodTraceEntry entry;
+        entry.time_ = -(double)(lastNs - record.startNs) * 1E-9;
+        entry.event_ = std::string(1, record.event);
+        entry.readUs_ = record.readNs * 0.001f;
+        entry.processUs_ = record.processNs * 0.001f;
+        entry.writeUs_ = record.writeNs * 0.001f;
+        entry.captureAvail_ = record.captureAvail;
+        entry.playbackAvail_ = record.playbackAvail;
+        entry.wakeLateUs_ = record.wakeLateNs * 0.001f;
+        entry.cpu_ = record.cpu;
+        entry.cpuFreqMhz_ = record.cpuFreqKhz * 0.001f;
+        entry.temperatureC_ = record.temperatureDeciC * 0.1f;
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+void AudioPeriodTrace::WriteTraceFile(const std::filesystem::path &path)
+{
+    std::vector<AudioPeriodTraceRecord> records = Snapshot();
+
+    std::ofstream f(path);
+    if (!f)
+    {
+        throw std::runtime_error(SS("Can't write to " << path << "."));
+    }
+    double budgetUs = sampleRate == 0 ? 0 : periodSize * 1E6 / sampleRate;
+    f << "# PiPedal audio period trace. Sample rate: " << sampleRate << " Period: " << periodSize
+      << " frames (" << std::fixed << std::setprecision(1) << budgetUs << "us)" << std::endl;
+    f << "# event codes: r = capture xrun, w = playback xrun, R = xrun recovered (read_us: recovery time). avail: frames, or -errno for xruns." << std::endl;
+    f << "# time_ms event cpu freq_mhz temp_c read_us process_us write_us capture_avail playback_avail wake_late_us" << std::endl;
+    if (records.empty())
+    {
+        return;
+    }
+    uint64_t lastNs = records.back().startNs;
+    for (const auto &record : records)
+    {
+        f << std::fixed << std::setprecision(3) << -(double)(lastNs - record.startNs) * 1E-6
+          << " " << (record.event == ' ' ? '-' : record.event)
+          << " " << record.cpu
+          << " " << record.cpuFreqKhz / 1000
+          << " " << std::setprecision(1) << record.temperatureDeciC * 0.1
+          << " " << record.readNs * 0.001
+          << " " << record.processNs * 0.001
+          << " " << record.writeNs * 0.001
+          << " " << record.captureAvail
+          << " " << record.playbackAvail
+          << " " << record.wakeLateNs * 0.001
+          << std::endl;
+    }
+}
+
+void AudioPeriodTrace::DumpXrun()
+{
+    fs::path directory = GetDumpDirectory();
+    if (directory.empty())
+    {
+        return;
+    }
+    try
+    {
+        fs::create_directories(directory);
+
+        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        struct tm tmNow;
+        localtime_r(&now, &tmNow);
+        char name[64];
+        strftime(name, sizeof(name), "xrun-%Y%m%d-%H%M%S.txt", &tmNow);
+        fs::path path = directory / name;
+        WriteTraceFile(path);
+        Lv2Log::info(SS("Audio xrun trace written to " << path));
+
+        // only keep the most recent traces.
+        std::vector<fs::path> files;
+        for (const auto &entry : fs::directory_iterator(directory))
+        {
+            if (entry.path().filename().string().starts_with("xrun-"))
+            {
+                files.push_back(entry.path());
+            }
+        }
+        if (files.size() > MAX_DUMP_FILES)
+        {
+            std::sort(files.begin(), files.end()); // names sort by time.
+            for (size_t i = 0; i < files.size() - MAX_DUMP_FILES; ++i)
+            {
+                fs::remove(files[i]);
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't write audio xrun trace. " << e.what()));
+    }
+}
+
+void AudioPeriodTrace::MonitorThreadProc()
+{
+    while (!terminateMonitor)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        uint64_t xrunNs = xrunTimeNs.load();
+        if (xrunNs != 0)
+        {
+            uint64_t now = Now();
+            if (now - xrunNs >= DUMP_DELAY_NS)
+            {
+                if (lastDumpNs == 0 || now - lastDumpNs >= MIN_DUMP_INTERVAL_NS)
+                {
+                    lastDumpNs = now;
+                    DumpXrun();
+                }
+                xrunTimeNs = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,155 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "json.hpp"
+#include "SysfsSampler.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+namespace pipedal
+{
+    // One audio period, as recorded by the audio thread.
+    struct AudioPeriodTraceRecord
+    {
+        uint64_t startNs = 0;      // CLOCK_MONOTONIC, when the period's read started.
+        uint32_t readNs = 0;       // includes waiting for input, so startNs+readNs is the wakeup time.
+        uint32_t processNs = 0;
+        uint32_t writeNs = 0;
+        int32_t captureAvail = 0;  // frames left in the capture buffer after reading. (-errno for xruns).
+        int32_t playbackAvail = 0; // free frames in the playback buffer before writing.
+        uint32_t wakeLateNs = 0;   // timer scheduling: how long after the requested time the audio thread woke.
+        uint32_t cpuFreqKhz = 0;
+        int16_t cpu = -1;
+        int16_t temperatureDeciC = 0;
+        char event = ' '; // ' ': a normal period. 'r': capture xrun. 'w': playback xrun. 'R': xrun recovered (readNs: recovery time).
+    };
+
+    // An AudioPeriodTraceRecord, for the websocket API.
+    class AudioPeriodTraceEntry
+    {
+    public:
+        double time_ = 0; // seconds, relative to the most recent period.
+        std::string event_;
+        float readUs_ = 0;
+        float processUs_ = 0;
+        float writeUs_ = 0;
+        int32_t captureAvail_ = 0;
+        int32_t playbackAvail_ = 0;
+        float wakeLateUs_ = 0;
+        int32_t cpu_ = -1;
+        float cpuFreqMhz_ = 0;
+        float temperatureC_ = 0;
+
+        DECLARE_JSON_MAP(AudioPeriodTraceEntry);
+    };
+
+    // How long the driver took to get audio running again after xruns.
+    class XrunRecoveryStatistics
+    {
+    public:
+        uint64_t recoveries_ = 0;
+        uint64_t restarts_ = 0; // recoveries that had to close and reopen the audio devices.
+        float lastUs_ = 0;
+        float meanUs_ = 0;
+        float maxUs_ = 0;
+
+        DECLARE_JSON_MAP(XrunRecoveryStatistics);
+    };
+
+    /**
+     * @brief Always-on flight recorder for audio periods.
+     *
+     * The audio thread writes one fixed-size record per period into a ring that holds the last
+     * TRACE_SECONDS of audio. When an xrun is reported, a monitor thread waits briefly (to capture the
+     * recovery), freezes the ring, and writes it to a file in the dump directory. CPU frequencies and temperature,
+     * which would be too expensive to read on the audio thread, come from the SysfsSampler.
+     */
+    class AudioPeriodTrace
+    {
+    public:
+        static constexpr double TRACE_SECONDS = 10;
+
+        // Where xrun traces are written. Empty (the default) to not write them.
+        static void SetDumpDirectory(const std::filesystem::path &path);
+
+        AudioPeriodTrace();
+        ~AudioPeriodTrace();
+
+        void Start(uint32_t sampleRate, uint32_t periodSize);
+        void Stop();
+
+        static uint64_t Now()
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+        }
+
+        // Audio thread. Fills in cpu, frequency, and temperature.
+        void Write(AudioPeriodTraceRecord &record);
+        // Audio thread.
+        void Xrun(char event, int32_t error);
+        // Audio thread. startNs: when the xrun was detected. restarted: the audio devices were reopened.
+        void XrunRecovered(uint64_t startNs, bool restarted);
+
+        XrunRecoveryStatistics GetXrunRecoveryStatistics() const;
+
+        // Any thread except the audio thread. The most recent periods, oldest first.
+        std::vector<AudioPeriodTraceEntry> GetRecent(double seconds);
+
+        void WriteTraceFile(const std::filesystem::path &path);
+
+    private:
+        static constexpr uint64_t DUMP_DELAY_NS = 500'000'000;       // capture the recovery too.
+        static constexpr uint64_t MIN_DUMP_INTERVAL_NS = 10'000'000'000;
+        static constexpr size_t MAX_DUMP_FILES = 20;
+
+        std::vector<AudioPeriodTraceRecord> Snapshot();
+        void MonitorThreadProc();
+        void DumpXrun();
+
+        uint32_t sampleRate = 0;
+        uint32_t periodSize = 0;
+        std::vector<AudioPeriodTraceRecord> ring;
+        std::atomic<uint64_t> writeCount{0};
+        std::atomic<bool> frozen{false};
+        std::atomic<uint64_t> xrunTimeNs{0}; // 0: no xrun pending.
+        std::atomic<uint64_t> xrunRecoveries{0};
+        std::atomic<uint64_t> xrunRestarts{0};
+        std::atomic<uint64_t> lastXrunRecoveryNs{0};
+        std::atomic<uint64_t> totalXrunRecoveryNs{0};
+        std::atomic<uint64_t> maxXrunRecoveryNs{0};
+        uint64_t lastDumpNs = 0;
+
+        std::shared_ptr<SysfsSampler> sysfsSampler;
+
+        std::mutex snapshotMutex;
+        std::atomic<bool> terminateMonitor{false};
+        std::unique_ptr<std::jthread> monitorThread;
+    };
+}
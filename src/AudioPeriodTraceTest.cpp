@@ -0,0 +1,125 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "AudioPeriodTrace.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+TEST_CASE("Audio period trace", "[audio_period_trace][Build][Dev]")
+{
+    AudioPeriodTrace trace;
+    trace.Start(48000, 480); // 100 periods per second; 1000 records.
+
+    uint64_t t0 = 1000000000;
+    for (int i = 0; i < 1500; ++i)
+    {
+        AudioPeriodTraceRecord record;
+        record.startNs = t0 + i * 10000000ull;
+        record.processNs = (uint32_t)i;
+        trace.Write(record);
+    }
+    auto all = trace.GetRecent(1000);
+    // one record is skipped because it may be mid-write.
+    REQUIRE(all.size() == 999);
+    REQUIRE(all.back().time_ == 0);
+    REQUIRE(all.back().processUs_ == 1499 * 0.001f);
+    REQUIRE(all.front().processUs_ == 501 * 0.001f);
+
+    auto recent = trace.GetRecent(0.5);
+    REQUIRE(recent.size() == 51);
+    REQUIRE(recent.front().time_ == -0.5);
+    trace.Stop();
+}
+
+TEST_CASE("Audio period trace xrun dump", "[audio_period_trace][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "pipedalAudioPeriodTraceTest";
+    fs::remove_all(directory);
+    AudioPeriodTrace::SetDumpDirectory(directory);
+    {
+        AudioPeriodTrace trace;
+        trace.Start(48000, 64);
+        for (int i = 0; i < 10; ++i)
+        {
+            AudioPeriodTraceRecord record;
+            record.startNs = AudioPeriodTrace::Now();
+            trace.Write(record);
+        }
+        trace.Xrun('r', -32);
+
+        auto start = std::chrono::steady_clock::now();
+        while (!fs::exists(directory) || fs::directory_iterator(directory) == fs::directory_iterator())
+        {
+            REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    AudioPeriodTrace::SetDumpDirectory("");
+
+    fs::path dumpFile = fs::directory_iterator(directory)->path();
+    std::ifstream f(dumpFile);
+    std::string line;
+    size_t xrunLines = 0, lines = 0;
+    while (std::getline(f, line))
+    {
+        if (line.starts_with("#"))
+            continue;
+        ++lines;
+        if (line.find(" r ") != std::string::npos)
+            ++xrunLines;
+    }
+    REQUIRE(lines == 11);
+    REQUIRE(xrunLines == 1);
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Audio period trace xrun recovery", "[audio_period_trace][Build][Dev]")
+{
+    AudioPeriodTrace trace;
+    trace.Start(48000, 480);
+
+    REQUIRE(trace.GetXrunRecoveryStatistics().recoveries_ == 0);
+
+    uint64_t now = AudioPeriodTrace::Now();
+    trace.XrunRecovered(now - 2'000'000, false);
+    trace.XrunRecovered(now - 1'000'000, true);
+
+    XrunRecoveryStatistics statistics = trace.GetXrunRecoveryStatistics();
+    REQUIRE(statistics.recoveries_ == 2);
+    REQUIRE(statistics.restarts_ == 1);
+    REQUIRE(statistics.maxUs_ >= 2000);
+    REQUIRE(statistics.lastUs_ >= 1000);
+    REQUIRE(statistics.lastUs_ < statistics.maxUs_);
+    REQUIRE(statistics.meanUs_ >= 1500);
+
+    auto recent = trace.GetRecent(1000);
+    REQUIRE(recent.size() == 2);
+    REQUIRE(recent[0].event_ == "R");
+    REQUIRE(recent[0].readUs_ >= 2000);
+    REQUIRE(recent[1].readUs_ >= 1000);
+    trace.Stop();
+}
@@ -0,0 +1,260 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "AudioRecorder.hpp"
+#include "SchedulerPriority.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <chrono>
+#include <ctime>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+namespace
+{
+    // fallocate()'d ahead of the write position, so that the file system can allocate contiguous extents,
+    // and so that the write path doesn't stall on block allocation.
+    constexpr uint64_t PREALLOCATION_BYTES = 32 * 1024 * 1024;
+    // stay well clear of the 4GB WAV limit.
+    constexpr uint64_t MAX_FILE_DATA_BYTES = 0xF0000000ull;
+    constexpr std::chrono::milliseconds WRITER_POLL_INTERVAL{50};
+}
+
+AudioRecorder::AudioRecorder(size_t ringBufferSize)
+    : ringBufferSize(ringBufferSize)
+{
+}
+
+AudioRecorder::~AudioRecorder()
+{
+    Stop();
+}
+
+void AudioRecorder::WaitForRealtimeWrite()
+{
+    // recording has been cleared, so at most one more period is in flight.
+    while (realtimeWriting.load())
+    {
+        std::this_thread::yield();
+    }
+}
+
+fs::path AudioRecorder::Start(const fs::path &directory)
+{
+    Stop();
+
+    if (!ringBuffer)
+    {
+        // allocated on first use, and kept, since the audio thread may be reading the pointer.
+        try
+        {
+            ringBuffer = std::make_unique<RingBuffer<false, false>>(ringBufferSize, true);
+        }
+        catch (const std::exception &)
+        {
+            Lv2Log::warning("AudioRecorder: Can't lock the recording buffer in memory.");
+            ringBuffer = std::make_unique<RingBuffer<false, false>>(ringBufferSize, false);
+        }
+    }
+    ringBuffer->reset();
+
+    fs::create_directories(directory);
+    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    struct tm tmNow;
+    localtime_r(&now, &tmNow);
+    char name[64];
+    strftime(name, sizeof(name), "%Y%m%d-%H%M%S", &tmNow);
+
+    basePath = directory / name;
+    part = 0;
+    fileFormat = PacketHeader{};
+    writeFailed = false;
+    reportedDroppedFrames = 0;
+    framesWritten = 0;
+    droppedFrames = 0;
+
+    closing = false;
+    thread = std::make_unique<std::thread>([this]()
+                                           { ThreadProc(); });
+    recording.store(true);
+    Lv2Log::info(SS("AudioRecorder: Recording to " << basePath.string() << "-*.wav"));
+    return basePath;
+}
+
+void AudioRecorder::Stop()
+{
+    if (!thread)
+    {
+        return;
+    }
+    recording.store(false);
+    WaitForRealtimeWrite();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    cv.notify_all();
+    thread->join();
+    thread = nullptr;
+    Lv2Log::info(SS("AudioRecorder: Recording stopped. ("
+                    << framesWritten.load() << " frames written, " << droppedFrames.load() << " frames dropped.)"));
+}
+
+void AudioRecorder::Write(float *const *inputs, uint32_t inputChannels, float *const *outputs, uint32_t outputChannels, uint32_t frames, uint32_t sampleRate)
+{
+    realtimeWriting.store(true);
+    if (recording.load())
+    {
+        PacketHeader header{inputChannels, outputChannels, frames, sampleRate};
+        size_t channelBytes = frames * sizeof(float);
+        RingBufferWriteSpans spans = ringBuffer->beginWrite(sizeof(header) + (inputChannels + outputChannels) * channelBytes);
+        if (!spans)
+        {
+            droppedFrames.fetch_add(frames, std::memory_order_relaxed);
+        }
+        else
+        {
+            size_t offset = 0;
+            spans.write(offset, &header, sizeof(header));
+            offset += sizeof(header);
+            for (uint32_t c = 0; c < inputChannels; ++c)
+            {
+                spans.write(offset, inputs[c], channelBytes);
+                offset += channelBytes;
+            }
+            for (uint32_t c = 0; c < outputChannels; ++c)
+            {
+                spans.write(offset, outputs[c], channelBytes);
+                offset += channelBytes;
+            }
+            ringBuffer->commitWrite(spans);
+        }
+    }
+    realtimeWriting.store(false);
+}
+
+void AudioRecorder::OpenFiles(const PacketHeader &header)
+{
+    CloseFiles();
+    ++part;
+    std::string suffix = part == 1 ? "" : SS("-" << part);
+    fs::path inputPath = basePath.string() + suffix + "-input.wav";
+    fs::path outputPath = basePath.string() + suffix + "-output.wav";
+    inputWriter.Open(inputPath, header.inputChannels, header.sampleRate);
+    inputWriter.SetPreallocation(PREALLOCATION_BYTES);
+    outputWriter.Open(outputPath, header.outputChannels, header.sampleRate);
+    outputWriter.SetPreallocation(PREALLOCATION_BYTES);
+    fileFormat = header;
+}
+
+void AudioRecorder::CloseFiles()
+{
+    inputWriter.Close();
+    outputWriter.Close();
+}
+
+bool AudioRecorder::ReadPacket()
+{
+    PacketHeader header;
+    if (!ringBuffer->read(sizeof(header), (uint8_t *)&header))
+    {
+        return false;
+    }
+    size_t channels = header.inputChannels + header.outputChannels;
+    readBuffer.resize(channels * header.frames);
+    if (!ringBuffer->read(readBuffer.size() * sizeof(float), (uint8_t *)readBuffer.data()))
+    {
+        throw std::logic_error("AudioRecorder: Incomplete packet.");
+    }
+    if (writeFailed)
+    {
+        droppedFrames.fetch_add(header.frames, std::memory_order_relaxed);
+        return true;
+    }
+    try
+    {
+        uint64_t fileBytes = (outputWriter.GetFrameCount() + header.frames) * std::max(header.inputChannels, header.outputChannels) * sizeof(float);
+        if (!inputWriter.IsOpen() ||
+            header.inputChannels != fileFormat.inputChannels ||
+            header.outputChannels != fileFormat.outputChannels ||
+            header.sampleRate != fileFormat.sampleRate ||
+            fileBytes > MAX_FILE_DATA_BYTES)
+        {
+            OpenFiles(header);
+        }
+        channelPointers.resize(channels);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            channelPointers[c] = readBuffer.data() + c * header.frames;
+        }
+        inputWriter.Write(channelPointers.data(), header.frames);
+        outputWriter.Write(channelPointers.data() + header.inputChannels, header.frames);
+        framesWritten.fetch_add(header.frames, std::memory_order_relaxed);
+    }
+    catch (const std::exception &e)
+    {
+        // keep draining, so that the audio thread sees a ring with space in it.
+        Lv2Log::error(SS("AudioRecorder: " << e.what()));
+        writeFailed = true;
+        droppedFrames.fetch_add(header.frames, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void AudioRecorder::ThreadProc()
+{
+    SetThreadName("recorder");
+    SetThreadPriority(SchedulerPriority::BackgroundBatch);
+
+    while (true)
+    {
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait_for(lock, WRITER_POLL_INTERVAL, [this]()
+                        { return closing; });
+            done = closing;
+        }
+        while (ReadPacket())
+        {
+        }
+        uint64_t dropped = droppedFrames.load(std::memory_order_relaxed);
+        if (dropped != reportedDroppedFrames && !writeFailed)
+        {
+            Lv2Log::warning(SS("AudioRecorder: Disk writes can't keep up. " << (dropped - reportedDroppedFrames) << " frames dropped."));
+            reportedDroppedFrames = dropped;
+        }
+        if (done)
+        {
+            break;
+        }
+    }
+    try
+    {
+        CloseFiles();
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("AudioRecorder: " << e.what()));
+    }
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "RingBuffer.hpp"
+#include "WavFile.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+
+    /**
+     * @brief Records the pedalboard's input (DI) and output to WAV files, without disturbing the audio thread.
+     *
+     * The audio thread copies each period into a large preallocated ring buffer. A background thread drains
+     * the ring, and writes to disk. If the disk can't keep up, periods that don't fit in the ring are
+     * dropped, and counted; the audio thread never waits.
+     *
+     * Each recording produces a pair of files, <name>-input.wav and <name>-output.wav. If the channel count
+     * or sample rate changes during a recording (or a file approaches the 4GB WAV limit), a new pair of files
+     * is started, with a -2, -3, &c. suffix.
+     */
+    class AudioRecorder
+    {
+    public:
+        // About 10 seconds of stereo in, stereo out at 48kHz.
+        static constexpr size_t DEFAULT_RING_BUFFER_SIZE = 8 * 1024 * 1024;
+
+        AudioRecorder(size_t ringBufferSize = DEFAULT_RING_BUFFER_SIZE);
+        ~AudioRecorder();
+        AudioRecorder(const AudioRecorder &) = delete;
+        AudioRecorder &operator=(const AudioRecorder &) = delete;
+
+        // Returns the path of the recording, without the -input.wav/-output.wav suffix.
+        std::filesystem::path Start(const std::filesystem::path &directory);
+        void Stop();
+
+        bool IsRecording() const { return recording.load(std::memory_order_relaxed); }
+
+        // Realtime thread only. Never blocks.
+        void Write(float *const *inputs, uint32_t inputChannels, float *const *outputs, uint32_t outputChannels, uint32_t frames, uint32_t sampleRate);
+
+        uint64_t GetFramesWritten() const { return framesWritten.load(std::memory_order_relaxed); }
+        uint64_t GetDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+
+    private:
+        struct PacketHeader
+        {
+            uint32_t inputChannels;
+            uint32_t outputChannels;
+            uint32_t frames;
+            uint32_t sampleRate;
+        };
+
+        void ThreadProc();
+        // Returns false if the ring is empty.
+        bool ReadPacket();
+        void OpenFiles(const PacketHeader &header);
+        void CloseFiles();
+        void WaitForRealtimeWrite();
+
+        size_t ringBufferSize;
+        std::unique_ptr<RingBuffer<false, false>> ringBuffer;
+
+        std::atomic<bool> recording = false;
+        std::atomic<bool> realtimeWriting = false;
+        std::atomic<uint64_t> framesWritten = 0;
+        std::atomic<uint64_t> droppedFrames = 0;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool closing = false;
+        std::unique_ptr<std::thread> thread;
+
+        // writer thread only.
+        std::filesystem::path basePath;
+        int part = 0;
+        PacketHeader fileFormat{};
+        bool writeFailed = false;
+        uint64_t reportedDroppedFrames = 0;
+        WavWriter inputWriter;
+        WavWriter outputWriter;
+        std::vector<float> readBuffer;
+        std::vector<float *> channelPointers;
+    };
+}
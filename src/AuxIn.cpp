@@ -1,4 +1,5 @@
 #include "AuxIn.hpp"
+#include "AdaptiveResampler.hpp"
 #include <stdexcept>
 #include <thread>
 
@@ -7,10 +8,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
-#include <iostream>
 #include <atomic>
+#include <vector>
 
 #include <poll.h>
+#include <cstring>
 #include <sys/types.h>
 
 namespace fs = std::filesystem;
@@ -21,33 +23,42 @@ namespace pipedal
     class AuxInAlsaDeviceImpl : public AuxInAlsaDevice
     {
     public:
-        AuxInAlsaDeviceImpl(const std::filesystem::path &path);
+        AuxInAlsaDeviceImpl(const std::filesystem::path &path, std::shared_ptr<AdaptiveResampler> sink);
         virtual ~AuxInAlsaDeviceImpl() override;
         void Open(const fs::path &path);
         void Close();
 
     private:
         fs::path path;
+        std::shared_ptr<AdaptiveResampler> sink;
         void ThreadProc();
+        void WriteSamples(const int16_t *samples, size_t count);
 
         std::unique_ptr<std::thread> thread;
         int fd = -1;
         int cancelWrite = -1;
         int cancelRead = -1;
         size_t total_read = 0;
+        size_t pendingBytes = 0; // a partial frame left over from the previous read.
+        std::vector<float> floatBuffer;
     };
 
-    AuxInAlsaDevice::ptr AuxInAlsaDevice::Create(const std::filesystem::path &path)
+    AuxInAlsaDevice::ptr AuxInAlsaDevice::Create(const std::filesystem::path &path, std::shared_ptr<AdaptiveResampler> sink)
     {
-        return std::make_shared<AuxInAlsaDeviceImpl>(path);
+        return std::make_shared<AuxInAlsaDeviceImpl>(path, sink);
     }
 
 }
 
 using namespace pipedal;
 
-AuxInAlsaDeviceImpl::AuxInAlsaDeviceImpl(const fs::path &path)
+AuxInAlsaDeviceImpl::AuxInAlsaDeviceImpl(const fs::path &path, std::shared_ptr<AdaptiveResampler> sink)
+    : sink(sink)
 {
+    if (!sink || sink->GetChannels() != 2)
+    {
+        throw std::invalid_argument("AuxIn requires a stereo sink.");
+    }
     this->path = path;
     Open(path);
 
@@ -125,10 +136,21 @@ void AuxInAlsaDeviceImpl::Open(const fs::path &path)
     setNonBlocking(cancelRead);
 }
 
+void AuxInAlsaDeviceImpl::WriteSamples(const int16_t *samples, size_t count)
+{
+    constexpr float SCALE = 1.0f / 32768;
+    floatBuffer.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        floatBuffer[i] = samples[i] * SCALE;
+    }
+    sink->Write(floatBuffer.data(), count / 2);
+}
+
 void AuxInAlsaDeviceImpl::ThreadProc()
 {
     constexpr size_t BUFFER_SIZE = 65536;
-    ssize_t bytes_read;
+    constexpr size_t FRAME_BYTES = 2 * sizeof(int16_t);
     int16_t samples[BUFFER_SIZE];
 
     while (1)
@@ -151,18 +173,30 @@ void AuxInAlsaDeviceImpl::ThreadProc()
         }
         if (poll_fds[0].revents)
         {
-            ssize_t bytes_read = read(fd, &samples, sizeof(samples));
+            ssize_t bytes_read = read(fd, ((char *)samples) + pendingBytes, sizeof(samples) - pendingBytes);
             if (bytes_read < 0)
             {
                 throw std::runtime_error("Auxin read failed.");
             }
-            if (poll_fds[0].revents & POLLHUP)
+            if (bytes_read > 0)
             {
-                std::cout << " End of stream. " << total_read << std::endl;
+                total_read += bytes_read;
+                size_t bytes = pendingBytes + bytes_read;
+                size_t frameBytes = bytes - bytes % FRAME_BYTES;
+                WriteSamples(samples, frameBytes / sizeof(int16_t));
+                pendingBytes = bytes - frameBytes;
+                if (pendingBytes != 0)
+                {
+                    memmove(samples, ((char *)samples) + frameBytes, pendingBytes);
+                }
+            }
+            if (bytes_read == 0 && (poll_fds[0].revents & POLLHUP))
+            {
+                // the writer closed the fifo. Reopen it, and wait for the next writer.
                 close(fd);
                 fd = -1;
-                // reopen the fifo.
                 total_read = 0;
+                pendingBytes = 0;
                 fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
                 if (fd == -1)
                 {
@@ -170,19 +204,6 @@ void AuxInAlsaDeviceImpl::ThreadProc()
                 }
                 setBlocking(fd);
             }
-            else if (bytes_read > 0)
-            {
-                total_read += bytes_read;
-                std::cout << " Read " << bytes_read << std::endl;
-                sleep(1);
-                // Process the audio data, mix it with your main input
-                // Your mixing code here...
-
-                // For example, if main_buffer has your main input:
-                // for (int i = 0; i < bytes_read/sizeof(int16_t); i++) {
-                //     mixed_buffer[i] = main_buffer[i] + buffer[i];
-                // }
-            }
         }
     }
 }
@@ -23,6 +23,7 @@
 #include <filesystem>
 
 namespace pipedal {
+    class AdaptiveResampler;
 
     class AuxInAlsaDevice {
     protected:
@@ -33,6 +34,8 @@ namespace pipedal {
         using ptr = std::shared_ptr<self>;
 
 
-        static ptr Create(const std::filesystem::path&path);
+        // Reads interleaved 16-bit stereo from the fifo at path, and writes it to sink, which carries it
+        // across to the audio thread's clock domain.
+        static ptr Create(const std::filesystem::path&path, std::shared_ptr<AdaptiveResampler> sink);
     };
 }
@@ -19,10 +19,13 @@
 
 
 #include "AuxIn.hpp"
+#include "AdaptiveResampler.hpp"
+#include <unistd.h>
 using namespace pipedal;
 
 int main(int argc, char**argv) {
-    AuxInAlsaDevice::ptr auxIn = AuxInAlsaDevice::Create("/var/pipedal/pipedal_aux_input_fifo");
+    auto resampler = std::make_shared<AdaptiveResampler>(2, 48000, 48000, 1024);
+    AuxInAlsaDevice::ptr auxIn = AuxInAlsaDevice::Create("/var/pipedal/pipedal_aux_input_fifo", resampler);
 
     sleep(10000);
 }
\ No newline at end of file
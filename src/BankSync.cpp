@@ -0,0 +1,242 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "BankSync.hpp"
+#include "Pedalboard.hpp"
+#include "Blake3.hpp"
+#include "SysExec.hpp"
+#include "ss.hpp"
+#include <regex>
+#include <sys/wait.h>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace pipedal;
+
+JSON_MAP_BEGIN(BankSyncPreset)
+    JSON_MAP_REFERENCE(BankSyncPreset, name)
+    JSON_MAP_REFERENCE(BankSyncPreset, hash)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BankSyncBank)
+    JSON_MAP_REFERENCE(BankSyncBank, name)
+    JSON_MAP_REFERENCE(BankSyncBank, presets)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BankSyncMedia)
+    JSON_MAP_REFERENCE(BankSyncMedia, path)
+    JSON_MAP_REFERENCE(BankSyncMedia, hash)
+    JSON_MAP_REFERENCE(BankSyncMedia, size)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BankSyncManifest)
+    JSON_MAP_REFERENCE(BankSyncManifest, banks)
+    JSON_MAP_REFERENCE(BankSyncManifest, media)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(BankSyncResult)
+    JSON_MAP_REFERENCE(BankSyncResult, banksUpdated)
+    JSON_MAP_REFERENCE(BankSyncResult, presetsTransferred)
+    JSON_MAP_REFERENCE(BankSyncResult, presetsUnchanged)
+    JSON_MAP_REFERENCE(BankSyncResult, mediaFilesTransferred)
+    JSON_MAP_REFERENCE(BankSyncResult, mediaFilesLinked)
+    JSON_MAP_REFERENCE(BankSyncResult, bytesTransferred)
+JSON_MAP_END()
+
+std::string BankSync::GetPresetHash(const Pedalboard &preset)
+{
+    std::ostringstream s;
+    json_writer writer(s, true);
+    writer.write(preset);
+    std::string json = s.str();
+
+    Blake3Hasher hasher;
+    hasher.Update(json.data(), json.size());
+    return hasher.FinalizeHex();
+}
+
+BankSyncPlan BankSync::Diff(
+    const BankSyncManifest &local,
+    const std::map<std::string, std::string> &localMediaHashes,
+    const BankSyncManifest &remote)
+{
+    BankSyncPlan plan;
+
+    std::unordered_map<std::string, const BankSyncBank *> localBanks;
+    for (const auto &bank : local.banks_)
+    {
+        localBanks[bank.name_] = &bank;
+    }
+    for (const auto &remoteBank : remote.banks_)
+    {
+        std::unordered_map<std::string, const std::string *> localHashes;
+        bool sameOrder = false;
+        auto f = localBanks.find(remoteBank.name_);
+        if (f != localBanks.end())
+        {
+            const BankSyncBank &localBank = *(f->second);
+            for (const auto &preset : localBank.presets_)
+            {
+                localHashes[preset.name_] = &preset.hash_;
+            }
+            sameOrder = localBank.presets_.size() == remoteBank.presets_.size();
+            for (size_t i = 0; sameOrder && i < localBank.presets_.size(); ++i)
+            {
+                sameOrder = localBank.presets_[i].name_ == remoteBank.presets_[i].name_;
+            }
+        }
+        bool changed = !sameOrder;
+        for (const auto &preset : remoteBank.presets_)
+        {
+            auto localHash = localHashes.find(preset.name_);
+            if (localHash != localHashes.end() && *(localHash->second) == preset.hash_)
+            {
+                ++plan.unchangedPresets;
+            }
+            else
+            {
+                plan.presets.push_back({remoteBank.name_, preset.name_});
+                changed = true;
+            }
+        }
+        if (changed)
+        {
+            plan.banks.push_back(remoteBank.name_);
+        }
+    }
+    for (const auto &media : remote.media_)
+    {
+        auto localHash = localMediaHashes.find(media.path_);
+        if (localHash == localMediaHashes.end() || localHash->second != media.hash_)
+        {
+            plan.media.push_back(media);
+        }
+    }
+    return plan;
+}
+
+std::string BankSync::NormalizePeerUrl(const std::string &peer)
+{
+    // only plain host names and addresses, since the url ends up on a curl command line.
+    static const std::regex peerRegex{R"(^(http://)?([A-Za-z0-9.\-]+|\[[0-9A-Fa-f:.]+\])(:[0-9]{1,5})?/?$)"};
+    std::smatch match;
+    if (!std::regex_match(peer, match, peerRegex))
+    {
+        throw std::invalid_argument(SS("Invalid server address: " << peer));
+    }
+    return SS("http://" << match[2].str() << match[3].str());
+}
+
+std::string BankSync::UrlEncode(const std::string &text)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    std::string result;
+    result.reserve(text.length());
+    for (char c : text)
+    {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' || c == '~')
+        {
+            result += c;
+        }
+        else
+        {
+            uint8_t b = (uint8_t)c;
+            result += '%';
+            result += hexDigits[b >> 4];
+            result += hexDigits[b & 0x0F];
+        }
+    }
+    return result;
+}
+
+static std::string ShellQuote(const std::string &text)
+{
+    std::string result = "'";
+    for (char c : text)
+    {
+        if (c == '\'')
+        {
+            result += "'\\''";
+        }
+        else
+        {
+            result += c;
+        }
+    }
+    result += "'";
+    return result;
+}
+
+BankSyncClient::BankSyncClient(const std::string &peer)
+    : baseUrl(BankSync::NormalizePeerUrl(peer))
+{
+}
+
+std::string BankSyncClient::Get(const std::string &resource)
+{
+    std::string url = baseUrl + resource;
+    auto result = sysExecForOutput("curl", SS("-s -f --connect-timeout 10 --max-time 120 " << ShellQuote(url)), true);
+    if (result.exitCode != EXIT_SUCCESS)
+    {
+        throw std::runtime_error(SS("Can't fetch " << url << " (curl error " << WEXITSTATUS(result.exitCode) << ")"));
+    }
+    bytesTransferred += result.output.length();
+    return std::move(result.output);
+}
+
+BankSyncManifest BankSyncClient::GetManifest()
+{
+    std::istringstream s(Get("/var/sync/manifest"));
+    json_reader reader(s);
+    BankSyncManifest result;
+    reader.read(&result);
+    return result;
+}
+
+Pedalboard BankSyncClient::GetPreset(const std::string &bank, const std::string &preset)
+{
+    std::istringstream s(Get(SS("/var/sync/preset?bank=" << BankSync::UrlEncode(bank) << "&preset=" << BankSync::UrlEncode(preset))));
+    json_reader reader(s);
+    Pedalboard result;
+    reader.read(&result);
+    return result;
+}
+
+void BankSyncClient::DownloadMedia(const BankSyncMedia &media, const std::filesystem::path &path)
+{
+    std::string url = SS(baseUrl << "/var/sync/media?hash=" << BankSync::UrlEncode(media.hash_));
+    // abandon stalled transfers (< 1KB/s for 30 seconds) rather than large ones.
+    auto result = sysExecForOutput(
+        "curl",
+        SS("-s -f --connect-timeout 10 --speed-limit 1024 --speed-time 30 -o " << ShellQuote(path.string()) << " " << ShellQuote(url)),
+        true);
+    if (result.exitCode != EXIT_SUCCESS)
+    {
+        throw std::runtime_error(SS("Can't fetch " << media.path_ << " (curl error " << WEXITSTATUS(result.exitCode) << ")"));
+    }
+    std::error_code ec;
+    bytesTransferred += std::filesystem::file_size(path, ec);
+    if (Blake3Hasher::HashFile(path) != media.hash_)
+    {
+        throw std::runtime_error(SS("Media file " << media.path_ << " is damaged."));
+    }
+}
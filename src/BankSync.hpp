@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    class Pedalboard;
+
+    class BankSyncPreset
+    {
+    public:
+        std::string name_;
+        std::string hash_; // BankSync::GetPresetHash()
+
+        DECLARE_JSON_MAP(BankSyncPreset);
+    };
+
+    class BankSyncBank
+    {
+    public:
+        std::string name_;
+        std::vector<BankSyncPreset> presets_;
+
+        DECLARE_JSON_MAP(BankSyncBank);
+    };
+
+    class BankSyncMedia
+    {
+    public:
+        std::string path_; // relative to the upload directory.
+        std::string hash_; // MediaBlobIndex content hash.
+        uint64_t size_ = 0;
+
+        DECLARE_JSON_MAP(BankSyncMedia);
+    };
+
+    // What a rig has to offer a peer: the content hash of each preset in each bank, and of each
+    // media file (and .mdata file) that the presets use.
+    class BankSyncManifest
+    {
+    public:
+        std::vector<BankSyncBank> banks_;
+        std::vector<BankSyncMedia> media_;
+
+        DECLARE_JSON_MAP(BankSyncManifest);
+    };
+
+    // The transfers needed to bring a rig's banks up to date with a peer's manifest.
+    class BankSyncPlan
+    {
+    public:
+        struct PresetTransfer
+        {
+            std::string bank;
+            std::string preset;
+        };
+        // Banks that are missing, have changed presets, or whose presets are in a different order.
+        std::vector<std::string> banks;
+        std::vector<PresetTransfer> presets;
+        size_t unchangedPresets = 0;
+        // Media files that are missing or different. They may still be available locally under another name.
+        std::vector<BankSyncMedia> media;
+    };
+
+    class BankSyncResult
+    {
+    public:
+        int64_t banksUpdated_ = 0;
+        int64_t presetsTransferred_ = 0;
+        int64_t presetsUnchanged_ = 0;
+        int64_t mediaFilesTransferred_ = 0;
+        int64_t mediaFilesLinked_ = 0; // found locally by content hash.
+        uint64_t bytesTransferred_ = 0;
+
+        DECLARE_JSON_MAP(BankSyncResult);
+    };
+
+    /**
+     * @brief Incremental bank sync between PiPedal servers.
+     *
+     * The receiving server fetches the peer's manifest (/var/sync/manifest), and compares it with its own banks.
+     * Only presets whose content hash differs are fetched (/var/sync/preset), and only media files that
+     * can't be found locally by content hash are downloaded (/var/sync/media). Banks are matched by name, and
+     * presets by name within a bank; banks that the peer doesn't have are left alone.
+     */
+    class BankSync
+    {
+    public:
+        static std::string GetPresetHash(const Pedalboard &preset);
+
+        // localMediaHashes: content hashes of the local files at the peer's media paths (missing files omitted).
+        static BankSyncPlan Diff(
+            const BankSyncManifest &local,
+            const std::map<std::string, std::string> &localMediaHashes,
+            const BankSyncManifest &remote);
+
+        // "host", "host:port" or "http://host:port" as a base url ("http://host:port"). Throws if invalid.
+        static std::string NormalizePeerUrl(const std::string &peer);
+        static std::string UrlEncode(const std::string &text);
+    };
+
+    // Fetches sync resources from a peer server (with curl).
+    class BankSyncClient
+    {
+    public:
+        BankSyncClient(const std::string &peer);
+
+        BankSyncManifest GetManifest();
+        Pedalboard GetPreset(const std::string &bank, const std::string &preset);
+        // Download a media file to path, and check its content hash.
+        void DownloadMedia(const BankSyncMedia &media, const std::filesystem::path &path);
+
+        uint64_t GetBytesTransferred() const { return bytesTransferred; }
+
+    private:
+        std::string Get(const std::string &resource);
+        std::string baseUrl;
+        uint64_t bytesTransferred = 0;
+    };
+}
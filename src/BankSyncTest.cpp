@@ -0,0 +1,113 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "BankSync.hpp"
+
+using namespace pipedal;
+
+static BankSyncBank MakeBank(const std::string &name, const std::vector<std::pair<std::string, std::string>> &presets)
+{
+    BankSyncBank bank;
+    bank.name_ = name;
+    for (const auto &preset : presets)
+    {
+        bank.presets_.push_back(BankSyncPreset{preset.first, preset.second});
+    }
+    return bank;
+}
+
+TEST_CASE("BankSync diff", "[bank_sync][Build][Dev]")
+{
+    BankSyncManifest local;
+    local.banks_.push_back(MakeBank("Live", {{"Clean", "h1"}, {"Crunch", "h2"}, {"Lead", "h3"}}));
+    local.banks_.push_back(MakeBank("Local only", {{"Test", "h9"}}));
+
+    SECTION("Identical")
+    {
+        BankSyncPlan plan = BankSync::Diff(local, {}, local);
+        REQUIRE(plan.banks.empty());
+        REQUIRE(plan.presets.empty());
+        REQUIRE(plan.unchangedPresets == 4);
+    }
+    SECTION("Changed and added presets")
+    {
+        BankSyncManifest remote;
+        remote.banks_.push_back(MakeBank("Live", {{"Clean", "h1"}, {"Crunch", "h2x"}, {"Lead", "h3"}, {"Ambient", "h4"}}));
+        BankSyncPlan plan = BankSync::Diff(local, {}, remote);
+        REQUIRE(plan.banks == std::vector<std::string>{"Live"});
+        REQUIRE(plan.presets.size() == 2);
+        REQUIRE(plan.presets[0].bank == "Live");
+        REQUIRE(plan.presets[0].preset == "Crunch");
+        REQUIRE(plan.presets[1].preset == "Ambient");
+        REQUIRE(plan.unchangedPresets == 2);
+    }
+    SECTION("Reordered and removed presets")
+    {
+        BankSyncManifest remote;
+        remote.banks_.push_back(MakeBank("Live", {{"Lead", "h3"}, {"Clean", "h1"}}));
+        BankSyncPlan plan = BankSync::Diff(local, {}, remote);
+        REQUIRE(plan.banks == std::vector<std::string>{"Live"});
+        REQUIRE(plan.presets.empty());
+        REQUIRE(plan.unchangedPresets == 2);
+    }
+    SECTION("New bank")
+    {
+        BankSyncManifest remote;
+        remote.banks_.push_back(MakeBank("Venue", {{"Clean", "h1"}}));
+        BankSyncPlan plan = BankSync::Diff(local, {}, remote);
+        REQUIRE(plan.banks == std::vector<std::string>{"Venue"});
+        REQUIRE(plan.presets.size() == 1);
+        REQUIRE(plan.unchangedPresets == 0);
+    }
+    SECTION("Media")
+    {
+        BankSyncManifest remote = local;
+        remote.media_.push_back(BankSyncMedia{"ir/room.wav", "m1", 1000});
+        remote.media_.push_back(BankSyncMedia{"ir/hall.wav", "m2", 2000});
+        remote.media_.push_back(BankSyncMedia{"nam/amp.nam", "m3", 3000});
+        std::map<std::string, std::string> localMediaHashes{
+            {"ir/room.wav", "m1"},
+            {"ir/hall.wav", "old"},
+        };
+        BankSyncPlan plan = BankSync::Diff(local, localMediaHashes, remote);
+        REQUIRE(plan.media.size() == 2);
+        REQUIRE(plan.media[0].path_ == "ir/hall.wav");
+        REQUIRE(plan.media[1].path_ == "nam/amp.nam");
+        REQUIRE(plan.media[1].size_ == 3000);
+    }
+}
+
+TEST_CASE("BankSync peer urls", "[bank_sync][Build][Dev]")
+{
+    REQUIRE(BankSync::NormalizePeerUrl("pipedal2.local") == "http://pipedal2.local");
+    REQUIRE(BankSync::NormalizePeerUrl("192.168.1.20:8080") == "http://192.168.1.20:8080");
+    REQUIRE(BankSync::NormalizePeerUrl("http://pipedal2:81/") == "http://pipedal2:81");
+    REQUIRE(BankSync::NormalizePeerUrl("[fe80::1]:80") == "http://[fe80::1]:80");
+    REQUIRE_THROWS(BankSync::NormalizePeerUrl(""));
+    REQUIRE_THROWS(BankSync::NormalizePeerUrl("host;rm -rf /"));
+    REQUIRE_THROWS(BankSync::NormalizePeerUrl("http://host/path"));
+    REQUIRE_THROWS(BankSync::NormalizePeerUrl("ftp://host"));
+
+    REQUIRE(BankSync::UrlEncode("Clean Tone") == "Clean%20Tone");
+    REQUIRE(BankSync::UrlEncode("a&b=c/d'") == "a%26b%3Dc%2Fd%27");
+    REQUIRE(BankSync::UrlEncode("\xC3\xA9") == "%C3%A9");
+}
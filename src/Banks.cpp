@@ -19,6 +19,15 @@
 
 #include "pch.h"
 #include "Banks.hpp"
+#include "BinaryBank.hpp"
+#include "ss.hpp"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace pipedal;
 
@@ -54,9 +63,544 @@ JSON_MAP_BEGIN(BankFile)
     JSON_MAP_REFERENCE(BankFile,presets)
 JSON_MAP_END()
 
-JSON_MAP_BEGIN(BankFileEntry)
-    JSON_MAP_REFERENCE(BankFileEntry,instanceId)
-    JSON_MAP_REFERENCE(BankFileEntry,preset)
+JSON_MAP_BEGIN(BankFileIndexEntry)
+    JSON_MAP_REFERENCE(BankFileIndexEntry,instanceId)
+    JSON_MAP_REFERENCE(BankFileIndexEntry,name)
+    JSON_MAP_REFERENCE(BankFileIndexEntry,offset)
+    JSON_MAP_REFERENCE(BankFileIndexEntry,length)
 JSON_MAP_END()
 
+JSON_MAP_BEGIN(BankFileIndex)
+    JSON_MAP_REFERENCE(BankFileIndex,version)
+    JSON_MAP_REFERENCE(BankFileIndex,fileSize)
+    JSON_MAP_REFERENCE(BankFileIndex,lastModified)
+    JSON_MAP_REFERENCE(BankFileIndex,inode)
+    JSON_MAP_REFERENCE(BankFileIndex,name)
+    JSON_MAP_REFERENCE(BankFileIndex,nextInstanceId)
+    JSON_MAP_REFERENCE(BankFileIndex,selectedPreset)
+    JSON_MAP_REFERENCE(BankFileIndex,presets)
+JSON_MAP_END()
+
+BankFileSource::BankFileSource(const std::filesystem::path &path, size_t cacheSize)
+    : path_(path), cacheSize(std::max<size_t>(1, cacheSize))
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        throw PiPedalException(SS("Can't open " << path << ". " << strerror(errno)));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        int savedErrno = errno;
+        ::close(fd);
+        throw PiPedalException(SS("Can't read " << path << ". " << strerror(savedErrno)));
+    }
+    fileSize_ = (int64_t)st.st_size;
+    lastModified_ = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    inode_ = (int64_t)st.st_ino;
+    if (fileSize_ != 0)
+    {
+        void *mapping = ::mmap(nullptr, (size_t)fileSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            int savedErrno = errno;
+            ::close(fd);
+            throw PiPedalException(SS("Can't read " << path << ". " << strerror(savedErrno)));
+        }
+        data_ = (const char *)mapping;
+    }
+    ::close(fd);
+    isBinary_ = BinaryBankReader::IsBinaryBankFile(View(0, (uint64_t)fileSize_));
+}
+
+BankFileSource::~BankFileSource()
+{
+    if (data_)
+    {
+        ::munmap((void *)data_, (size_t)fileSize_);
+    }
+}
+
+std::string_view BankFileSource::View(uint64_t offset, uint64_t length) const
+{
+    if (offset > (uint64_t)fileSize_ || length > (uint64_t)fileSize_ - offset)
+    {
+        throw PiPedalException(SS("Bank file index is out of date. (" << path_ << ")"));
+    }
+    if (length == 0)
+    {
+        return std::string_view();
+    }
+    return std::string_view(data_ + offset, (size_t)length);
+}
+
+const std::vector<std::string_view> &BankFileSource::BinaryStrings() const
+{
+    if (!binaryStrings_)
+    {
+        binaryStrings_ = BinaryBankReader::ReadStringTable(View(0, (uint64_t)fileSize_));
+    }
+    return binaryStrings_.value();
+}
+
+void BankFileSource::OnLoaded(BankFileEntry *entry)
+{
+    if (!loadedEntries.empty() && loadedEntries.front() == entry)
+    {
+        return;
+    }
+    for (auto i = loadedEntries.begin(); i != loadedEntries.end(); ++i)
+    {
+        if (*i == entry)
+        {
+            loadedEntries.splice(loadedEntries.begin(), loadedEntries, i);
+            return;
+        }
+    }
+    loadedEntries.push_front(entry);
+    while (loadedEntries.size() > cacheSize)
+    {
+        BankFileEntry *oldest = loadedEntries.back();
+        loadedEntries.pop_back();
+        oldest->Unload();
+    }
+}
+
+void BankFileSource::OnReleased(BankFileEntry *entry)
+{
+    loadedEntries.remove(entry);
+}
+
+BankFileEntry::~BankFileEntry()
+{
+    Detach();
+}
+
+void BankFileEntry::Detach()
+{
+    if (source_)
+    {
+        source_->OnReleased(this);
+        source_ = nullptr;
+    }
+}
+
+const std::string &BankFileEntry::name() const
+{
+    if (preset_)
+    {
+        return preset_->name();
+    }
+    return sourceName_;
+}
+
+const Pedalboard &BankFileEntry::preset() const
+{
+    if (!preset_)
+    {
+        if (!source_)
+        {
+            throw std::logic_error("Preset has no content.");
+        }
+        std::string_view text = source_->View(offset_, length_);
+        if (source_->IsBinary())
+        {
+            preset_ = BinaryBankReader::ReadPreset(text, source_->BinaryStrings());
+        }
+        else
+        {
+            json_reader reader(text);
+            Pedalboard pedalboard;
+            reader.read(&pedalboard);
+            preset_ = std::move(pedalboard);
+        }
+    }
+    if (source_)
+    {
+        source_->OnLoaded(const_cast<BankFileEntry *>(this));
+    }
+    return preset_.value();
+}
+
+Pedalboard &BankFileEntry::mutablePreset()
+{
+    preset();
+    Detach();
+    return preset_.value();
+}
+
+void BankFileEntry::preset(const Pedalboard &value)
+{
+    Detach();
+    preset_ = value;
+}
+
+void BankFileEntry::Attach(BankFileSource::ptr source, const BankFileIndexEntry &location)
+{
+    if (source_ != source)
+    {
+        Detach();
+        source_ = std::move(source);
+    }
+    sourceName_ = location.name();
+    offset_ = location.offset();
+    length_ = location.length();
+    if (preset_)
+    {
+        source_->OnLoaded(this);
+    }
+}
+
+void BankFileEntry::Unload()
+{
+    if (source_)
+    {
+        preset_.reset();
+    }
+}
+
+void BankFileEntry::WritePresetJson(json_writer &writer) const
+{
+    if (!preset_ && source_ && !source_->IsBinary())
+    {
+        // copy the text without parsing it.
+        writer.write_raw(source_->Read(offset_, length_).c_str());
+    }
+    else
+    {
+        writer.write(preset());
+    }
+}
+
+void BankFileEntry::WritePresetBinary(BinaryBankWriter &writer) const
+{
+    if (!preset_ && source_ && writer.CanCopyFrom(*source_))
+    {
+        // copy the record without decoding it.
+        writer.WritePresetRecord(source_->View(offset_, length_));
+    }
+    else
+    {
+        writer.WritePreset(preset());
+    }
+}
+
+void BankFileEntry::write_json(json_writer &writer) const
+{
+    writer.start_object();
+    writer.write_member("instanceId", instanceId_);
+    writer.write_raw(",");
+    writer.write("preset");
+    writer.write_raw(": ");
+    WritePresetJson(writer);
+    writer.end_object();
+}
+
+void BankFileEntry::read_json(json_reader &reader)
+{
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string memberName = reader.read_string();
+        reader.consume(':');
+        if (memberName == "instanceId")
+        {
+            reader.read(&instanceId_);
+        }
+        else if (memberName == "preset")
+        {
+            Pedalboard pedalboard;
+            reader.read(&pedalboard);
+            preset(pedalboard);
+        }
+        else
+        {
+            reader.skip_property();
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.end_object();
+}
+
+std::string BankFile::Serialize(BankFileIndex *pIndex) const
+{
+    std::ostringstream s;
+    json_writer writer(s, true);
+
+    pIndex->version(BankFileIndex::CURRENT_VERSION);
+    pIndex->name(name_);
+    pIndex->nextInstanceId(nextInstanceId_);
+    pIndex->selectedPreset(selectedPreset_);
+    pIndex->presets().clear();
+    pIndex->presets().reserve(presets_.size());
+
+    writer.start_object();
+    writer.write_member("name", name_);
+    writer.write_raw(",");
+    writer.write_member("nextInstanceId", nextInstanceId_);
+    writer.write_raw(",");
+    writer.write_member("selectedPreset", selectedPreset_);
+    writer.write_raw(",");
+    writer.write("presets");
+    writer.write_raw(": ");
+    writer.start_array();
+    for (size_t i = 0; i < presets_.size(); ++i)
+    {
+        const BankFileEntry &entry = *presets_[i];
+        if (i != 0)
+        {
+            writer.write_raw(",");
+        }
+        writer.start_object();
+        writer.write_member("instanceId", entry.instanceId());
+        writer.write_raw(",");
+        writer.write("preset");
+        writer.write_raw(": ");
+
+        BankFileIndexEntry location;
+        location.instanceId(entry.instanceId());
+        location.name(entry.name());
+        location.offset((uint64_t)s.tellp());
+        entry.WritePresetJson(writer);
+        location.length((uint64_t)s.tellp() - location.offset());
+        pIndex->presets().push_back(std::move(location));
+
+        writer.end_object();
+    }
+    writer.end_array();
+    writer.end_object();
+    return s.str();
+}
+
+std::string BankFile::SerializeBinary(BankFileIndex *pIndex) const
+{
+    // If the presets came from a binary bank file, extend its string table so that unmodified
+    // presets can be copied as-is.
+    const BankFileSource *copySource = nullptr;
+    for (const auto &entry : presets_)
+    {
+        if (entry->source() && entry->source()->IsBinary())
+        {
+            copySource = entry->source();
+            break;
+        }
+    }
+    BinaryBankWriter writer(copySource);
+
+    pIndex->version(BankFileIndex::CURRENT_VERSION);
+    pIndex->name(name_);
+    pIndex->nextInstanceId(nextInstanceId_);
+    pIndex->selectedPreset(selectedPreset_);
+    pIndex->presets().clear();
+    pIndex->presets().reserve(presets_.size());
+    for (const auto &entry : presets_)
+    {
+        BankFileIndexEntry location;
+        location.instanceId(entry->instanceId());
+        location.name(entry->name());
+        location.offset(writer.Position());
+        entry->WritePresetBinary(writer);
+        location.length(writer.Position() - location.offset());
+        pIndex->presets().push_back(std::move(location));
+    }
+    return writer.Finish(*pIndex);
+}
+
+void BankFile::Attach(const std::filesystem::path &path, BankFileIndex *pIndex)
+{
+    if (pIndex->presets().size() != presets_.size())
+    {
+        throw std::logic_error("Bank file index doesn't match.");
+    }
+    auto source = std::make_shared<BankFileSource>(path);
+    pIndex->fileSize(source->fileSize());
+    pIndex->lastModified(source->lastModified());
+    pIndex->inode(source->inode());
+    for (size_t i = 0; i < presets_.size(); ++i)
+    {
+        presets_[i]->Attach(source, pIndex->presets()[i]);
+    }
+}
+
+static std::string ScanPresetName(json_reader &reader)
+{
+    std::string name;
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string memberName = reader.read_string();
+        reader.consume(':');
+        if (memberName == "name")
+        {
+            reader.read(&name);
+        }
+        else
+        {
+            reader.skip_property();
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.end_object();
+    return name;
+}
+
+static void ScanPresets(json_reader &reader, BankFileIndex *pIndex)
+{
+    reader.consume('[');
+    while (reader.peek() != ']')
+    {
+        BankFileIndexEntry location;
+        reader.start_object();
+        while (reader.peek() != '}')
+        {
+            std::string memberName = reader.read_string();
+            reader.consume(':');
+            if (memberName == "instanceId")
+            {
+                int64_t instanceId = 0;
+                reader.read(&instanceId);
+                location.instanceId(instanceId);
+            }
+            else if (memberName == "preset")
+            {
+                reader.peek();
+                location.offset((uint64_t)reader.tell());
+                location.name(ScanPresetName(reader));
+                location.length((uint64_t)reader.tell() - location.offset());
+            }
+            else
+            {
+                reader.skip_property();
+            }
+            if (reader.peek() == ',')
+            {
+                reader.consume(',');
+            }
+        }
+        reader.end_object();
+        if (location.length() == 0)
+        {
+            throw PiPedalException("Bank file entry has no preset.");
+        }
+        pIndex->presets().push_back(std::move(location));
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.consume(']');
+}
+
+// Build an index by scanning the bank file's json, without parsing presets.
+static BankFileIndex ScanBankFile(const BankFileSource &source)
+{
+    BankFileIndex index;
+    index.version(BankFileIndex::CURRENT_VERSION);
+    index.fileSize(source.fileSize());
+    index.lastModified(source.lastModified());
+    index.inode(source.inode());
+
+    std::string_view text = source.View(0, (uint64_t)source.fileSize());
+    json_reader reader(text);
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string memberName = reader.read_string();
+        reader.consume(':');
+        if (memberName == "name")
+        {
+            reader.read(&index.name());
+        }
+        else if (memberName == "nextInstanceId")
+        {
+            int64_t value = 0;
+            reader.read(&value);
+            index.nextInstanceId(value);
+        }
+        else if (memberName == "selectedPreset")
+        {
+            int64_t value = 0;
+            reader.read(&value);
+            index.selectedPreset(value);
+        }
+        else if (memberName == "presets")
+        {
+            ScanPresets(reader, &index);
+        }
+        else
+        {
+            reader.skip_property();
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    reader.end_object();
+    return index;
+}
+
+std::optional<BankFileIndex> BankFile::LoadIndexed(
+    const std::filesystem::path &path,
+    const std::filesystem::path &indexPath)
+{
+    auto source = std::make_shared<BankFileSource>(path);
+
+    BankFileIndex index;
+    bool indexValid = false;
+    if (source->IsBinary())
+    {
+        index = BinaryBankReader::ReadIndex(source->View(0, (uint64_t)source->fileSize()), source->BinaryStrings());
+        indexValid = true;
+    }
+    else
+    {
+        try
+        {
+            std::ifstream f(indexPath);
+            if (f.is_open())
+            {
+                json_reader reader(f);
+                reader.read(&index);
+                indexValid =
+                    index.version() == BankFileIndex::CURRENT_VERSION &&
+                    index.fileSize() == source->fileSize() &&
+                    index.lastModified() == source->lastModified() &&
+                    index.inode() == source->inode();
+            }
+        }
+        catch (const std::exception &)
+        {
+            indexValid = false;
+        }
+    }
+    std::optional<BankFileIndex> result;
+    if (!indexValid)
+    {
+        index = ScanBankFile(*source);
+        result = index;
+    }
+
+    clear();
+    this->name_ = index.name();
+    this->nextInstanceId_ = index.nextInstanceId();
+    this->selectedPreset_ = index.selectedPreset();
+    presets_.reserve(index.presets().size());
+    for (const auto &location : index.presets())
+    {
+        auto entry = std::make_unique<BankFileEntry>();
+        entry->instanceId(location.instanceId());
+        entry->Attach(source, location);
+        presets_.push_back(std::move(entry));
+    }
+    return result;
+}
+
 
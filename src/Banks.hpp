@@ -22,6 +22,11 @@
 #include "json.hpp"
 #include "Pedalboard.hpp"
 #include "PiPedalException.hpp"
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string_view>
 
 namespace pipedal
 {
@@ -82,16 +87,147 @@ namespace pipedal
         DECLARE_JSON_MAP(PresetIndex);
     };
 
-    class BankFileEntry
+    class BankFileEntry;
+    class BinaryBankWriter;
+
+    // Position of one preset's json text within a bank file.
+    class BankFileIndexEntry
     {
-        int64_t instanceId_;
-        Pedalboard preset_;
+        int64_t instanceId_ = 0;
+        std::string name_;
+        uint64_t offset_ = 0;
+        uint64_t length_ = 0;
 
     public:
         GETTER_SETTER(instanceId);
-        GETTER_SETTER_REF(preset);
+        GETTER_SETTER_REF(name);
+        GETTER_SETTER(offset);
+        GETTER_SETTER(length);
+
+        DECLARE_JSON_MAP(BankFileIndexEntry);
+    };
+
+    // Sidecar index for a bank file (<bank file>.index). Holds everything needed to list the
+    // bank's presets, and the location of each preset in the bank file, so that presets can be
+    // parsed on demand. Only valid while the bank file's size, mtime and inode match.
+    class BankFileIndex
+    {
+        int64_t version_ = 0;
+        int64_t fileSize_ = 0;
+        int64_t lastModified_ = 0;
+        int64_t inode_ = 0;
+        std::string name_;
+        int64_t nextInstanceId_ = 0;
+        int64_t selectedPreset_ = -1;
+        std::vector<BankFileIndexEntry> presets_;
+
+    public:
+        static constexpr int64_t CURRENT_VERSION = 1;
+
+        GETTER_SETTER(version);
+        GETTER_SETTER(fileSize);
+        GETTER_SETTER(lastModified);
+        GETTER_SETTER(inode);
+        GETTER_SETTER_REF(name);
+        GETTER_SETTER(nextInstanceId);
+        GETTER_SETTER(selectedPreset);
+        GETTER_SETTER_VEC(presets);
 
-        DECLARE_JSON_MAP(BankFileEntry);
+        DECLARE_JSON_MAP(BankFileIndex);
+    };
+
+    // An open bank file from which unloaded presets are parsed on demand.
+    //
+    // Keeps the most recently used parsed presets in memory, and unloads the rest. The file is
+    // memory-mapped; the mapping keeps the contents valid even after the file has been replaced
+    // by a rename.
+    class BankFileSource
+    {
+    public:
+        using ptr = std::shared_ptr<BankFileSource>;
+
+        static constexpr size_t DEFAULT_CACHE_SIZE = 8;
+
+        BankFileSource(const std::filesystem::path &path, size_t cacheSize = DEFAULT_CACHE_SIZE);
+        ~BankFileSource();
+        BankFileSource(const BankFileSource &) = delete;
+        BankFileSource &operator=(const BankFileSource &) = delete;
+
+        const std::filesystem::path &path() const { return path_; }
+        int64_t fileSize() const { return fileSize_; }
+        int64_t lastModified() const { return lastModified_; }
+        int64_t inode() const { return inode_; }
+
+        std::string Read(uint64_t offset, uint64_t length) const { return std::string(View(offset, length)); }
+        std::string_view View(uint64_t offset, uint64_t length) const;
+
+        // Whether the file is a binary bank file (see BinaryBank.hpp) rather than json.
+        bool IsBinary() const { return isBinary_; }
+        // The binary bank file's string table.
+        const std::vector<std::string_view> &BinaryStrings() const;
+
+    private:
+        friend class BankFileEntry;
+        void OnLoaded(BankFileEntry *entry);
+        void OnReleased(BankFileEntry *entry);
+
+        std::filesystem::path path_;
+        const char *data_ = nullptr;
+        int64_t fileSize_ = 0;
+        int64_t lastModified_ = 0;
+        int64_t inode_ = 0;
+        bool isBinary_ = false;
+        mutable std::optional<std::vector<std::string_view>> binaryStrings_;
+        size_t cacheSize;
+        std::list<BankFileEntry *> loadedEntries; // most recently used first.
+    };
+
+    class BankFileEntry : public JsonSerializable
+    {
+        int64_t instanceId_ = 0;
+        mutable std::optional<Pedalboard> preset_;
+
+        // Where to find the preset if it isn't loaded. Set only while preset_ matches the file.
+        BankFileSource::ptr source_;
+        std::string sourceName_;
+        uint64_t offset_ = 0;
+        uint64_t length_ = 0;
+
+        void Detach();
+
+    public:
+        BankFileEntry() {}
+        ~BankFileEntry();
+        BankFileEntry(const BankFileEntry &) = delete;
+        BankFileEntry &operator=(const BankFileEntry &) = delete;
+
+        GETTER_SETTER(instanceId);
+
+        // The preset's name, without loading the preset.
+        const std::string &name() const;
+
+        // Loads the preset if necessary. The reference remains valid until
+        // BankFileSource::DEFAULT_CACHE_SIZE other presets in the bank have been loaded.
+        const Pedalboard &preset() const;
+        // Loads the preset, and keeps it in memory until the bank is next written.
+        Pedalboard &mutablePreset();
+        void preset(const Pedalboard &value);
+
+        bool isLoaded() const { return preset_.has_value(); }
+        // The file the preset was loaded from, if it is unmodified.
+        const BankFileSource *source() const { return source_.get(); }
+
+        // Mark the preset as an unmodified copy of the given location in source.
+        void Attach(BankFileSource::ptr source, const BankFileIndexEntry &location);
+        void Unload();
+
+        // The preset's json text.
+        void WritePresetJson(json_writer &writer) const;
+        // The preset's binary bank file record.
+        void WritePresetBinary(BinaryBankWriter &writer) const;
+
+        virtual void write_json(json_writer &writer) const;
+        virtual void read_json(json_reader &reader);
     };
     class BankFile
     {
@@ -127,6 +263,19 @@ namespace pipedal
             presets_.erase(presets_.begin() + from);
             presets_.insert(presets_.begin() + to, std::move(t));
         }
+        // Json text of the bank file, and the location of each of its presets.
+        std::string Serialize(BankFileIndex *pIndex) const;
+        // Contents of a binary bank file (see BinaryBank.hpp), and the location of each of its presets.
+        std::string SerializeBinary(BankFileIndex *pIndex) const;
+        // Parse the bank file, leaving presets unloaded. Json bank files use indexPath if it's current;
+        // otherwise, scans the bank file and returns the new index, which should be saved. Binary
+        // bank files carry their own index.
+        std::optional<BankFileIndex> LoadIndexed(
+            const std::filesystem::path &path,
+            const std::filesystem::path &indexPath);
+        // After writing Serialize()'s or SerializeBinary()'s output to path, unload and attach presets to the new file.
+        void Attach(const std::filesystem::path &path, BankFileIndex *pIndex);
+
         void updateNextIndex()
         {
             int64_t t = 0;
@@ -181,7 +330,7 @@ namespace pipedal
         {
             for (size_t i = 0; i < presets_.size(); ++i)
             {
-                if (presets_[i]->preset().name() == name)
+                if (presets_[i]->name() == name)
                 {
                     return true;
                 }
@@ -198,7 +347,7 @@ namespace pipedal
             {
                 if (presets_[i]->instanceId() == instanceId)
                 {
-                    presets_[i]->preset().name(name);
+                    presets_[i]->mutablePreset().name(name);
                     return true;
                 }
             }
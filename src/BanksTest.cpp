@@ -0,0 +1,382 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Banks.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static Pedalboard MakePreset(const std::string &name, float inputVolume)
+{
+    Pedalboard pedalboard = Pedalboard::MakeDefault();
+    pedalboard.name(name);
+    pedalboard.input_volume_db(inputVolume);
+    return pedalboard;
+}
+
+static void WriteFile(const fs::path &path, const std::string &content)
+{
+    std::ofstream f(path, std::ios_base::binary | std::ios_base::trunc);
+    f << content;
+}
+
+static BankFileIndex WriteBank(const fs::path &path, BankFile &bankFile)
+{
+    BankFileIndex index;
+    WriteFile(path, bankFile.Serialize(&index));
+    bankFile.Attach(path, &index);
+    return index;
+}
+
+static BankFileIndex WriteBinaryBank(const fs::path &path, BankFile &bankFile)
+{
+    BankFileIndex index;
+    WriteFile(path, bankFile.SerializeBinary(&index));
+    bankFile.Attach(path, &index);
+    return index;
+}
+
+static std::string PresetJson(const Pedalboard &preset)
+{
+    std::string result;
+    json_writer writer(result);
+    writer.write(preset);
+    return result;
+}
+
+// A preset that uses every persistent field.
+static Pedalboard MakeFullPreset(const std::string &name)
+{
+    Pedalboard pedalboard = Pedalboard::MakeDefault();
+    pedalboard.name(name);
+    pedalboard.output_volume_db(-3.5f);
+    pedalboard.parallelSplits(true);
+    pedalboard.pipeline(true);
+
+    PedalboardItem split = pedalboard.MakeSplit();
+    PedalboardItem plugin = pedalboard.MakeEmptyItem();
+    plugin.uri("http://example.com/plugins/amp");
+    plugin.pluginName("Amp");
+    plugin.isEnabled(false);
+    plugin.controlValues_.push_back(ControlValue("gain", 0.25f));
+    plugin.controlValues_.push_back(ControlValue("level", -12.0f));
+    plugin.title_ = "Lead";
+    plugin.iconColor_ = "#FF0000";
+    plugin.useModUi_ = true;
+    plugin.sideChainInputId_ = 7;
+    plugin.hardBypass_ = true;
+    plugin.essential_ = true;
+    plugin.alwaysRun_ = true;
+    plugin.stateUpdateCount_ = 3;
+    plugin.lilvPresetUri_ = "http://example.com/plugins/amp#preset1";
+    plugin.pathProperties_["http://example.com/plugins/amp#model"] = "/var/pipedal/model.nam";
+
+    MidiBinding binding = MidiBinding::SystemBinding("gain");
+    binding.channel(3);
+    binding.control(74);
+    binding.minValue(0.5f);
+    binding.switchControlType(SwitchControlTypeT::TOGGLE_ON_VALUE);
+    plugin.midiBindings_.push_back(binding);
+    MidiChannelBinding channelBinding;
+    channelBinding.channel(9);
+    channelBinding.midiDevices().push_back("Keystation");
+    plugin.midiChannelBinding_ = channelBinding;
+
+    plugin.lv2State_.isValid_ = true;
+    Lv2PluginStateEntry &entry = plugin.lv2State_.values_["http://example.com/plugins/amp#blob"];
+    entry.flags_ = 3;
+    entry.atomType_ = "http://lv2plug.in/ns/ext/atom#Chunk";
+    std::vector<uint8_t> blob;
+    for (int i = 0; i < 1000; ++i)
+    {
+        blob.push_back((uint8_t)(i * 7));
+    }
+    entry.value_ = std::move(blob);
+    split.topChain_.push_back(plugin);
+    split.bottomChain_.push_back(pedalboard.MakeEmptyItem());
+    pedalboard.items().push_back(split);
+    pedalboard.items().push_back(plugin);
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->name_ = "Clean";
+    snapshot->color_ = "blue";
+    SnapshotValue value;
+    value.instanceId_ = (uint64_t)plugin.instanceId();
+    value.isEnabled_ = false;
+    value.controlValues_.push_back(ControlValue("gain", 0.75f));
+    value.lv2State_ = plugin.lv2State_;
+    value.pathProperties_ = plugin.pathProperties_;
+    snapshot->values_.push_back(value);
+    pedalboard.snapshots().push_back(snapshot);
+    pedalboard.selectedSnapshot(0);
+    pedalboard.selectedPlugin(plugin.instanceId());
+    return pedalboard;
+}
+
+static void WriteIndex(const fs::path &path, const BankFileIndex &index)
+{
+    std::ostringstream s;
+    json_writer writer(s, true);
+    writer.write(index);
+    WriteFile(path, s.str());
+}
+
+TEST_CASE("Indexed bank files", "[bank_file_index][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "BankFileIndexTest";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    fs::path bankPath = directory / "Test.bank";
+    fs::path indexPath = directory / "Test.bank.index";
+
+    constexpr size_t N_PRESETS = 20;
+    BankFile original;
+    original.name("Test");
+    for (size_t i = 0; i < N_PRESETS; ++i)
+    {
+        original.addPreset(MakePreset(SS("Preset " << i), (float)i));
+    }
+    original.selectedPreset(original.presets()[3]->instanceId());
+
+    SECTION("serialized banks are readable as plain json")
+    {
+        BankFileIndex index;
+        std::istringstream s(original.Serialize(&index));
+        json_reader reader(s);
+        BankFile bankFile;
+        reader.read(&bankFile);
+
+        REQUIRE(bankFile.name() == "Test");
+        REQUIRE(bankFile.selectedPreset() == original.selectedPreset());
+        REQUIRE(bankFile.presets().size() == N_PRESETS);
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            REQUIRE(bankFile.presets()[i]->instanceId() == original.presets()[i]->instanceId());
+            REQUIRE(bankFile.presets()[i]->preset().name() == SS("Preset " << i));
+        }
+    }
+    SECTION("presets load on demand")
+    {
+        WriteBank(bankPath, original);
+
+        BankFile bankFile;
+        auto newIndex = bankFile.LoadIndexed(bankPath, indexPath);
+        REQUIRE(newIndex.has_value()); // no index yet, so the bank was scanned.
+        REQUIRE(bankFile.selectedPreset() == original.selectedPreset());
+        REQUIRE(bankFile.nextInstanceId() == original.nextInstanceId());
+        REQUIRE(bankFile.presets().size() == N_PRESETS);
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            REQUIRE(!bankFile.presets()[i]->isLoaded());
+            REQUIRE(bankFile.presets()[i]->name() == SS("Preset " << i));
+        }
+        REQUIRE(bankFile.hasName("Preset 7"));
+
+        const Pedalboard &preset = bankFile.presets()[5]->preset();
+        REQUIRE(preset.name() == "Preset 5");
+        REQUIRE(preset.input_volume_db() == 5.0f);
+        REQUIRE(bankFile.presets()[5]->isLoaded());
+        REQUIRE(!bankFile.presets()[6]->isLoaded());
+
+        WriteIndex(indexPath, newIndex.value());
+        BankFile indexedBankFile;
+        REQUIRE(!indexedBankFile.LoadIndexed(bankPath, indexPath).has_value());
+        REQUIRE(indexedBankFile.presets().size() == N_PRESETS);
+        REQUIRE(indexedBankFile.presets()[19]->preset().input_volume_db() == 19.0f);
+    }
+    SECTION("only recently used presets stay loaded")
+    {
+        WriteBank(bankPath, original);
+        BankFile bankFile;
+        bankFile.LoadIndexed(bankPath, indexPath);
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            REQUIRE(bankFile.presets()[i]->preset().input_volume_db() == (float)i);
+        }
+        size_t loaded = 0;
+        for (auto &entry : bankFile.presets())
+        {
+            if (entry->isLoaded())
+                ++loaded;
+        }
+        REQUIRE(loaded == BankFileSource::DEFAULT_CACHE_SIZE);
+        REQUIRE(bankFile.presets()[N_PRESETS - 1]->isLoaded());
+        REQUIRE(!bankFile.presets()[0]->isLoaded());
+    }
+    SECTION("modified presets survive rewrites")
+    {
+        WriteBank(bankPath, original);
+        BankFile bankFile;
+        bankFile.LoadIndexed(bankPath, indexPath);
+
+        bankFile.renamePreset(bankFile.presets()[2]->instanceId(), "Renamed");
+        bankFile.presets()[4]->preset(MakePreset("Replaced", 100));
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            bankFile.presets()[i]->preset();
+        }
+        // modified presets can't be unloaded until they have been written.
+        REQUIRE(bankFile.presets()[2]->isLoaded());
+        REQUIRE(bankFile.presets()[4]->isLoaded());
+
+        // rewrite a bank whose unmodified presets are copied from the file being replaced.
+        BankFileIndex index = WriteBank(bankPath, bankFile);
+        WriteIndex(indexPath, index);
+
+        BankFile reloaded;
+        REQUIRE(!reloaded.LoadIndexed(bankPath, indexPath).has_value());
+        REQUIRE(reloaded.presets()[2]->name() == "Renamed");
+        REQUIRE(reloaded.presets()[2]->preset().input_volume_db() == 2.0f);
+        REQUIRE(reloaded.presets()[4]->preset().name() == "Replaced");
+        REQUIRE(reloaded.presets()[4]->preset().input_volume_db() == 100.0f);
+        REQUIRE(reloaded.presets()[10]->preset().input_volume_db() == 10.0f);
+    }
+    SECTION("stale indexes are ignored")
+    {
+        BankFileIndex index = WriteBank(bankPath, original);
+        WriteIndex(indexPath, index);
+
+        // a bank file written with the ordinary (pretty-printed) json writer.
+        std::ostringstream s;
+        json_writer writer(s, false);
+        BankFile other;
+        other.addPreset(MakePreset("Other", 1));
+        writer.write(other);
+        WriteFile(bankPath, s.str());
+
+        BankFile bankFile;
+        REQUIRE(bankFile.LoadIndexed(bankPath, indexPath).has_value());
+        REQUIRE(bankFile.presets().size() == 1);
+        REQUIRE(bankFile.presets()[0]->name() == "Other");
+        REQUIRE(bankFile.presets()[0]->preset().input_volume_db() == 1.0f);
+    }
+    fs::remove_all(directory);
+}
+
+TEST_CASE("Binary bank files", "[binary_bank_file][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "BinaryBankFileTest";
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    fs::path bankPath = directory / "Test.bank";
+    fs::path indexPath = directory / "Test.bank.index";
+
+    constexpr size_t N_PRESETS = 10;
+    BankFile original;
+    original.name("Test");
+    for (size_t i = 0; i < N_PRESETS; ++i)
+    {
+        original.addPreset(MakeFullPreset(SS("Preset " << i)));
+    }
+    original.selectedPreset(original.presets()[3]->instanceId());
+
+    SECTION("presets round trip")
+    {
+        WriteBinaryBank(bankPath, original);
+
+        BankFile bankFile;
+        REQUIRE(!bankFile.LoadIndexed(bankPath, indexPath).has_value()); // no sidecar index required.
+        REQUIRE(!fs::exists(indexPath));
+        REQUIRE(bankFile.name() == "Test");
+        REQUIRE(bankFile.selectedPreset() == original.selectedPreset());
+        REQUIRE(bankFile.nextInstanceId() == original.nextInstanceId());
+        REQUIRE(bankFile.presets().size() == N_PRESETS);
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            REQUIRE(!bankFile.presets()[i]->isLoaded());
+            REQUIRE(bankFile.presets()[i]->name() == SS("Preset " << i));
+            REQUIRE(bankFile.presets()[i]->instanceId() == original.presets()[i]->instanceId());
+        }
+        for (size_t i = 0; i < N_PRESETS; ++i)
+        {
+            REQUIRE(PresetJson(bankFile.presets()[i]->preset()) == PresetJson(MakeFullPreset(SS("Preset " << i))));
+        }
+    }
+    SECTION("binary banks are smaller than json banks")
+    {
+        BankFileIndex index;
+        std::string json = original.Serialize(&index);
+        std::string binary = original.SerializeBinary(&index);
+        REQUIRE(binary.size() * 2 < json.size());
+    }
+    SECTION("unmodified presets are copied")
+    {
+        WriteBinaryBank(bankPath, original);
+        // a rewrite of an unmodified bank reproduces the file.
+        std::string firstWrite;
+        {
+            BankFileIndex index;
+            BankFile bankFile;
+            bankFile.LoadIndexed(bankPath, indexPath);
+            firstWrite = bankFile.SerializeBinary(&index);
+            REQUIRE(!bankFile.presets()[0]->isLoaded());
+        }
+        {
+            std::ifstream f(bankPath, std::ios_base::binary);
+            std::stringstream s;
+            s << f.rdbuf();
+            REQUIRE(s.str() == firstWrite);
+        }
+        BankFile bankFile;
+        bankFile.LoadIndexed(bankPath, indexPath);
+        bankFile.renamePreset(bankFile.presets()[2]->instanceId(), "Renamed");
+        WriteBinaryBank(bankPath, bankFile);
+
+        BankFile reloaded;
+        reloaded.LoadIndexed(bankPath, indexPath);
+        REQUIRE(reloaded.presets()[2]->name() == "Renamed");
+        Pedalboard expected = MakeFullPreset("Renamed");
+        REQUIRE(PresetJson(reloaded.presets()[2]->preset()) == PresetJson(expected));
+        REQUIRE(PresetJson(reloaded.presets()[5]->preset()) == PresetJson(MakeFullPreset("Preset 5")));
+    }
+    SECTION("json and binary banks convert")
+    {
+        BankFileIndex originalIndex;
+        std::string originalJson = original.Serialize(&originalIndex);
+
+        // json -> binary
+        WriteBank(bankPath, original);
+        BankFile jsonBank;
+        jsonBank.LoadIndexed(bankPath, indexPath);
+        WriteBinaryBank(bankPath, jsonBank);
+
+        // binary -> json, without loading presets first.
+        BankFile binaryBank;
+        binaryBank.LoadIndexed(bankPath, indexPath);
+        BankFileIndex index;
+        std::string json = binaryBank.Serialize(&index);
+
+        REQUIRE(json == originalJson);
+    }
+    SECTION("corrupt binary banks are rejected")
+    {
+        BankFileIndex index;
+        std::string binary = original.SerializeBinary(&index);
+        WriteFile(bankPath, binary.substr(0, binary.size() - 10));
+        BankFile bankFile;
+        REQUIRE_THROWS(bankFile.LoadIndexed(bankPath, indexPath));
+    }
+    fs::remove_all(directory);
+}
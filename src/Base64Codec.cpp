@@ -0,0 +1,235 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "Base64Codec.hpp"
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__aarch64__)
+// vqtbl4q_u8 (64-byte table lookups) is A64-only.
+#include <arm_neon.h>
+#endif
+
+using namespace pipedal;
+
+namespace
+{
+    constexpr char ENCODING_TABLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    constexpr uint8_t INVALID = 0xFF;
+
+    // two output characters for every 12-bit input value.
+    constexpr std::array<uint16_t, 4096> MakeEncodingTable12()
+    {
+        std::array<uint16_t, 4096> result{};
+        for (size_t i = 0; i < 4096; ++i)
+        {
+            // stored in memory order (little-endian).
+            result[i] = (uint16_t)((uint8_t)ENCODING_TABLE[i >> 6] | ((uint16_t)(uint8_t)ENCODING_TABLE[i & 0x3F] << 8));
+        }
+        return result;
+    }
+    constexpr std::array<uint8_t, 256> MakeDecodingTable()
+    {
+        std::array<uint8_t, 256> result{};
+        for (size_t i = 0; i < 256; ++i)
+        {
+            result[i] = INVALID;
+        }
+        for (size_t i = 0; i < 64; ++i)
+        {
+            result[(uint8_t)ENCODING_TABLE[i]] = (uint8_t)i;
+        }
+        return result;
+    }
+    const std::array<uint16_t, 4096> encodingTable12 = MakeEncodingTable12();
+    const std::array<uint8_t, 256> decodingTable = MakeDecodingTable();
+
+    inline void Store2(char *p, uint16_t chars)
+    {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        chars = (uint16_t)((chars >> 8) | (chars << 8));
+#endif
+        std::memcpy(p, &chars, 2);
+    }
+
+    [[noreturn]] void ThrowInvalid()
+    {
+        throw std::invalid_argument("Invalid base64 data.");
+    }
+}
+
+std::string pipedal::Base64Encode(const uint8_t *data, size_t size)
+{
+    std::string result(4 * ((size + 2) / 3), '\0');
+    char *p = result.data();
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    {
+        uint8x16x4_t lut = {vld1q_u8((const uint8_t *)ENCODING_TABLE), vld1q_u8((const uint8_t *)ENCODING_TABLE + 16),
+                            vld1q_u8((const uint8_t *)ENCODING_TABLE + 32), vld1q_u8((const uint8_t *)ENCODING_TABLE + 48)};
+        const uint8x16_t mask30 = vdupq_n_u8(0x30);
+        const uint8x16_t mask3C = vdupq_n_u8(0x3C);
+        const uint8x16_t mask3F = vdupq_n_u8(0x3F);
+        // 48 input bytes (de-interleaved into byte 0, 1, and 2 of each group) -> 64 characters.
+        for (; i + 48 <= size; i += 48)
+        {
+            uint8x16x3_t in = vld3q_u8(data + i);
+            uint8x16x4_t out;
+            out.val[0] = vshrq_n_u8(in.val[0], 2);
+            out.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(in.val[0], 4), mask30), vshrq_n_u8(in.val[1], 4));
+            out.val[2] = vorrq_u8(vandq_u8(vshlq_n_u8(in.val[1], 2), mask3C), vshrq_n_u8(in.val[2], 6));
+            out.val[3] = vandq_u8(in.val[2], mask3F);
+            out.val[0] = vqtbl4q_u8(lut, out.val[0]);
+            out.val[1] = vqtbl4q_u8(lut, out.val[1]);
+            out.val[2] = vqtbl4q_u8(lut, out.val[2]);
+            out.val[3] = vqtbl4q_u8(lut, out.val[3]);
+            vst4q_u8((uint8_t *)p, out);
+            p += 64;
+        }
+    }
+#endif
+    for (; i + 3 <= size; i += 3)
+    {
+        uint32_t n = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        Store2(p, encodingTable12[n >> 12]);
+        Store2(p + 2, encodingTable12[n & 0xFFF]);
+        p += 4;
+    }
+    if (i < size)
+    {
+        uint32_t n = (uint32_t)data[i] << 16;
+        if (i + 1 < size)
+        {
+            n |= (uint32_t)data[i + 1] << 8;
+        }
+        p[0] = ENCODING_TABLE[(n >> 18) & 0x3F];
+        p[1] = ENCODING_TABLE[(n >> 12) & 0x3F];
+        p[2] = (i + 1 < size) ? ENCODING_TABLE[(n >> 6) & 0x3F] : '=';
+        p[3] = '=';
+    }
+    return result;
+}
+
+std::vector<uint8_t> pipedal::Base64Decode(std::string_view text)
+{
+    size_t length = text.length();
+    if (length % 4 != 0)
+    {
+        ThrowInvalid();
+    }
+    if (length == 0)
+    {
+        return std::vector<uint8_t>();
+    }
+    size_t padding = 0;
+    if (text[length - 1] == '=')
+    {
+        ++padding;
+        if (text[length - 2] == '=')
+        {
+            ++padding;
+        }
+    }
+    std::vector<uint8_t> result(length / 4 * 3 - padding);
+    const uint8_t *in = (const uint8_t *)text.data();
+    uint8_t *out = result.data();
+
+    // the last group (which may be padded) is always decoded by the scalar code.
+    size_t bodyLength = length - 4;
+    size_t i = 0;
+
+#if defined(__aarch64__)
+    {
+        uint8_t table[128];
+        for (size_t c = 0; c < 128; ++c)
+        {
+            table[c] = decodingTable[c];
+        }
+        uint8x16x4_t lut0 = {vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32), vld1q_u8(table + 48)};
+        uint8x16x4_t lut1 = {vld1q_u8(table + 64), vld1q_u8(table + 80), vld1q_u8(table + 96), vld1q_u8(table + 112)};
+        const uint8x16_t offset64 = vdupq_n_u8(64);
+        // 64 characters (de-interleaved into character 0, 1, 2 and 3 of each group) -> 48 bytes.
+        for (; i + 64 <= bodyLength; i += 64)
+        {
+            uint8x16x4_t chars = vld4q_u8(in + i);
+            uint8x16_t errors = vdupq_n_u8(0);
+            uint8x16_t values[4];
+            for (int j = 0; j < 4; ++j)
+            {
+                // characters 0-63 from lut0, 64-127 from lut1. Characters >= 128 have their high bit set.
+                uint8x16_t value = vqtbl4q_u8(lut0, chars.val[j]);
+                value = vqtbx4q_u8(value, lut1, vsubq_u8(chars.val[j], offset64));
+                errors = vorrq_u8(errors, vorrq_u8(value, chars.val[j]));
+                values[j] = value;
+            }
+            if (vmaxvq_u8(errors) & 0x80)
+            {
+                ThrowInvalid();
+            }
+            uint8x16x3_t bytes;
+            bytes.val[0] = vorrq_u8(vshlq_n_u8(values[0], 2), vshrq_n_u8(values[1], 4));
+            bytes.val[1] = vorrq_u8(vshlq_n_u8(values[1], 4), vshrq_n_u8(values[2], 2));
+            bytes.val[2] = vorrq_u8(vshlq_n_u8(values[2], 6), values[3]);
+            vst3q_u8(out, bytes);
+            out += 48;
+        }
+    }
+#endif
+    uint8_t errors = 0;
+    for (; i < bodyLength; i += 4)
+    {
+        uint8_t a = decodingTable[in[i]];
+        uint8_t b = decodingTable[in[i + 1]];
+        uint8_t c = decodingTable[in[i + 2]];
+        uint8_t d = decodingTable[in[i + 3]];
+        errors |= a | b | c | d;
+        uint32_t n = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+        out[0] = (uint8_t)(n >> 16);
+        out[1] = (uint8_t)(n >> 8);
+        out[2] = (uint8_t)n;
+        out += 3;
+    }
+    // the last group.
+    {
+        uint8_t a = decodingTable[in[i]];
+        uint8_t b = decodingTable[in[i + 1]];
+        uint8_t c = padding >= 2 ? 0 : decodingTable[in[i + 2]];
+        uint8_t d = padding >= 1 ? 0 : decodingTable[in[i + 3]];
+        errors |= a | b | c | d;
+        if (errors & 0x80)
+        {
+            ThrowInvalid();
+        }
+        uint32_t n = ((uint32_t)a << 18) | ((uint32_t)b << 12) | ((uint32_t)c << 6) | d;
+        out[0] = (uint8_t)(n >> 16);
+        if (padding < 2)
+        {
+            out[1] = (uint8_t)(n >> 8);
+        }
+        if (padding < 1)
+        {
+            out[2] = (uint8_t)n;
+        }
+    }
+    return result;
+}
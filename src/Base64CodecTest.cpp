@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Base64Codec.hpp"
+#include "Base64.hpp"
+#include <random>
+#include <stdexcept>
+
+using namespace pipedal;
+
+TEST_CASE("Base64Codec", "[base64_codec][Build][Dev]")
+{
+    REQUIRE(Base64Encode(std::vector<uint8_t>{}) == "");
+    REQUIRE(Base64Encode(std::vector<uint8_t>{'f'}) == "Zg==");
+    REQUIRE(Base64Encode(std::vector<uint8_t>{'f', 'o'}) == "Zm8=");
+    REQUIRE(Base64Encode(std::vector<uint8_t>{'f', 'o', 'o'}) == "Zm9v");
+    REQUIRE(Base64Decode("Zm9vYg==") == std::vector<uint8_t>{'f', 'o', 'o', 'b'});
+
+    // matches the reference encoder, at sizes that exercise the vectorized and scalar paths.
+    std::mt19937 random(1234);
+    for (size_t size : {1, 2, 3, 47, 48, 49, 50, 95, 96, 97, 200, 1000, 65537})
+    {
+        std::vector<uint8_t> data(size);
+        for (auto &byte : data)
+        {
+            byte = (uint8_t)random();
+        }
+        std::string encoded = Base64Encode(data);
+        REQUIRE(encoded == macaron::Base64::Encode(data));
+        REQUIRE(Base64Decode(encoded) == data);
+    }
+
+    std::string valid = Base64Encode(std::vector<uint8_t>(300, 0x5A));
+    REQUIRE_THROWS(Base64Decode("Zm9"));
+    for (size_t position : {0, 10, 100, 250, 398})
+    {
+        for (char c : {'!', '=', '\x80', '\xFF', '-'})
+        {
+            std::string invalid = valid;
+            invalid[position] = c;
+            REQUIRE_THROWS(Base64Decode(invalid));
+        }
+    }
+}
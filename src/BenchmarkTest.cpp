@@ -0,0 +1,426 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+// Micro-benchmarks for core infrastructure. Hidden from default runs; run with
+//
+//     pipedaltest "[benchmark]" --reporter xml --out benchmarks.xml
+//
+// from the project root (or build the "benchmark" target), and compare two runs with
+// profiler_tools/compare_benchmarks.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RingBuffer.hpp"
+#include "MapFeature.hpp"
+#include "json.hpp"
+#include "json_variant.hpp"
+#include "Banks.hpp"
+#include "AtomConverter.hpp"
+#include "LRUCache.hpp"
+#include "Base64Codec.hpp"
+#include "Base64.hpp"
+#include "AlsaSampleConverters.hpp"
+#include "DbDezipper.hpp"
+#include "VuUpdate.hpp"
+#include "SplitEffect.hpp"
+#include "lv2/atom/forge.h"
+#include "lv2/patch/patch.h"
+#include "ss.hpp"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr size_t FRAMES = 64;
+
+    std::vector<float> MakeSignal(size_t samples)
+    {
+        std::vector<float> result(samples);
+        for (size_t i = 0; i < samples; ++i)
+        {
+            result[i] = 0.5f * std::sin(i * 0.031f);
+        }
+        return result;
+    }
+
+    std::string ReadFile(const fs::path &path)
+    {
+        std::ifstream f(path);
+        std::stringstream s;
+        s << f.rdbuf();
+        return s.str();
+    }
+
+    std::vector<uint8_t> MakeBenchmarkAtom(MapFeature &mapFeature)
+    {
+        std::vector<uint8_t> atomBuffer(1024);
+        LV2_Atom_Forge forge;
+        lv2_atom_forge_init(&forge, mapFeature.GetMap());
+        lv2_atom_forge_set_buffer(&forge, atomBuffer.data(), atomBuffer.size());
+
+        // a typical patch:Set with a path value, as sent by file property controls.
+        LV2_Atom_Forge_Frame frame;
+        lv2_atom_forge_object(&forge, &frame, 0, mapFeature.GetUrid(LV2_PATCH__Set));
+        lv2_atom_forge_key(&forge, mapFeature.GetUrid(LV2_PATCH__property));
+        lv2_atom_forge_urid(&forge, mapFeature.GetUrid("http://two-play.com/plugins/toob-nam#modelFile"));
+        lv2_atom_forge_key(&forge, mapFeature.GetUrid(LV2_PATCH__value));
+        std::string path = "/var/pipedal/audio_uploads/NeuralAmpModels/Fender Deluxe Reverb.nam";
+        lv2_atom_forge_path(&forge, path.c_str(), path.size() + 1);
+        lv2_atom_forge_pop(&forge, &frame);
+        return atomBuffer;
+    }
+
+    struct ConverterFormat
+    {
+        const char *name;
+        snd_pcm_format_t format;
+        size_t bytesPerSample;
+    };
+
+    const ConverterFormat converterFormats[] = {
+        {"S16_LE", SND_PCM_FORMAT_S16_LE, 2},
+        {"S24_LE", SND_PCM_FORMAT_S24_LE, 4},
+        {"S24_3LE", SND_PCM_FORMAT_S24_3LE, 3},
+        {"S32_LE", SND_PCM_FORMAT_S32_LE, 4},
+        {"FLOAT_LE", SND_PCM_FORMAT_FLOAT_LE, 4},
+        {"S32_BE", SND_PCM_FORMAT_S32_BE, 4},
+    };
+}
+
+TEST_CASE("RingBuffer benchmark", "[benchmark][.]")
+{
+    RingBuffer<false, false> ringBuffer(65536, false);
+    std::vector<uint8_t> data(1024);
+    std::vector<uint8_t> output(1024);
+
+    // control changes (~16 bytes), vu updates (~64), effect timings (~256), atom output (~1k).
+    for (size_t size : {16, 64, 256, 1024})
+    {
+        BENCHMARK(SS("RingBuffer write/read " << size << " bytes"))
+        {
+            ringBuffer.write(size, data.data());
+            ringBuffer.read(size, output.data());
+            return output[0];
+        };
+    }
+}
+
+TEST_CASE("MapFeature benchmark", "[benchmark][.]")
+{
+    MapFeature mapFeature;
+    std::vector<std::string> uris;
+    std::vector<LV2_URID> urids;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        uris.push_back(SS("http://two-play.com/plugins/benchmark#uri" << i));
+        urids.push_back(mapFeature.GetUrid(uris.back().c_str()));
+    }
+    LV2_URID_Map *map = mapFeature.GetMap();
+    LV2_URID_Unmap *unmap = mapFeature.GetUnmap();
+
+    size_t n = 0;
+    BENCHMARK("MapFeature map (existing uri)")
+    {
+        n = (n + 1) % uris.size();
+        return map->map(map->handle, uris[n].c_str());
+    };
+    BENCHMARK("MapFeature unmap")
+    {
+        n = (n + 1) % urids.size();
+        return unmap->unmap(unmap->handle, urids[n]);
+    };
+}
+
+TEST_CASE("json bank file benchmark", "[benchmark][.]")
+{
+    fs::path bankPath = fs::current_path() / "default_presets" / "presets" / "Default+Bank.bank";
+    std::string text = ReadFile(bankPath);
+    if (text.empty())
+    {
+        WARN("Bank file not found (run from the project root): " << bankPath);
+        return;
+    }
+    BankFile bankFile;
+    {
+        std::stringstream s(text);
+        json_reader reader(s);
+        reader.read(&bankFile);
+    }
+
+    BENCHMARK("json_reader bank file")
+    {
+        std::stringstream s(text);
+        json_reader reader(s);
+        BankFile result;
+        reader.read(&result);
+        return result.presets().size();
+    };
+    BENCHMARK("json_writer bank file")
+    {
+        std::stringstream s;
+        json_writer writer(s, true);
+        writer.write(bankFile);
+        return s.str().size();
+    };
+}
+
+TEST_CASE("AtomConverter benchmark", "[benchmark][.]")
+{
+    MapFeature mapFeature;
+    AtomConverter converter(mapFeature);
+    std::vector<uint8_t> atomBuffer = MakeBenchmarkAtom(mapFeature);
+    const LV2_Atom *atom = (const LV2_Atom *)atomBuffer.data();
+    std::string json = converter.ToString(atom);
+    json_variant variant = converter.ToJson(atom);
+
+    BENCHMARK("AtomConverter atom to json string")
+    {
+        return converter.ToString(atom).size();
+    };
+    BENCHMARK("AtomConverter json string to atom")
+    {
+        return converter.ToAtom(json)->size;
+    };
+    BENCHMARK("AtomConverter json_variant round trip")
+    {
+        json_variant v = converter.ToJson(atom);
+        return converter.ToAtom(v)->size;
+    };
+}
+
+TEST_CASE("LRUCache benchmark", "[benchmark][.]")
+{
+    constexpr int KEYS = 1024;
+    LRUCache<int, int> cache(KEYS / 2);
+    for (int i = 0; i < KEYS / 2; ++i)
+    {
+        cache.put(i, i);
+    }
+    int n = 0;
+    BENCHMARK("LRUCache get (hit)")
+    {
+        int value = 0;
+        n = (n + 1) % (KEYS / 2);
+        cache.get(n, value);
+        return value;
+    };
+    BENCHMARK("LRUCache get/put (50% misses)")
+    {
+        int value = 0;
+        n = (n + 7) % KEYS;
+        if (!cache.get(n, value))
+        {
+            cache.put(n, n);
+        }
+        return value;
+    };
+}
+
+TEST_CASE("Base64 benchmark", "[benchmark][.]")
+{
+    std::vector<uint8_t> data(4096);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = (uint8_t)(i * 31);
+    }
+    std::string encoded = Base64Encode(data);
+
+    BENCHMARK("Base64 encode 4k")
+    {
+        return Base64Encode(data).size();
+    };
+    BENCHMARK("Base64 decode 4k")
+    {
+        return Base64Decode(encoded).size();
+    };
+    // the previous header-only implementation, for comparison.
+    BENCHMARK("macaron::Base64 encode 4k")
+    {
+        return macaron::Base64::Encode(data).size();
+    };
+    BENCHMARK("macaron::Base64 decode 4k")
+    {
+        return macaron::Base64::Decode(encoded).size();
+    };
+}
+
+TEST_CASE("AlsaDriver sample converter benchmark", "[benchmark][.]")
+{
+    constexpr size_t CHANNELS = 2;
+    constexpr size_t SAMPLES = FRAMES * CHANNELS;
+    std::vector<float> floats = MakeSignal(SAMPLES);
+    std::vector<float> output(SAMPLES);
+    std::vector<uint8_t> raw(SAMPLES * 4);
+
+    for (SimdLevel level : GetSupportedSimdLevels())
+    {
+        for (const auto &format : converterFormats)
+        {
+            CaptureConverterFn capture = GetCaptureConverter(format.format, level);
+            PlaybackConverterFn playback = GetPlaybackConverter(format.format, level);
+            if (playback)
+            {
+                BENCHMARK(SS("Playback " << format.name << " " << GetSimdLevelName(level)))
+                {
+                    playback(floats.data(), raw.data(), SAMPLES);
+                    return raw[0];
+                };
+            }
+            if (capture)
+            {
+                BENCHMARK(SS("Capture " << format.name << " " << GetSimdLevelName(level)))
+                {
+                    capture(raw.data(), output.data(), SAMPLES);
+                    return output[0];
+                };
+            }
+        }
+    }
+
+    std::vector<float> left(FRAMES), right(FRAMES);
+    float *channels[2]{left.data(), right.data()};
+    BENCHMARK("DeinterleaveSamples stereo")
+    {
+        DeinterleaveSamples(floats.data(), channels, CHANNELS, FRAMES);
+        return left[0];
+    };
+    BENCHMARK("InterleaveSamples stereo")
+    {
+        InterleaveSamples(channels, output.data(), CHANNELS, FRAMES);
+        return output[0];
+    };
+
+    constexpr size_t MULTI_CHANNELS = 8;
+    std::vector<float> multiInterleaved = MakeSignal(FRAMES * MULTI_CHANNELS);
+    std::vector<std::vector<float>> multiBuffers(MULTI_CHANNELS, std::vector<float>(FRAMES));
+    std::vector<float *> multiChannels;
+    for (auto &buffer : multiBuffers)
+    {
+        multiChannels.push_back(buffer.data());
+    }
+    BENCHMARK("DeinterleaveSamples 8 channels")
+    {
+        DeinterleaveSamples(multiInterleaved.data(), multiChannels.data(), MULTI_CHANNELS, FRAMES);
+        return multiBuffers[0][0];
+    };
+    BENCHMARK("InterleaveSamples 8 channels")
+    {
+        InterleaveSamples(multiChannels.data(), multiInterleaved.data(), MULTI_CHANNELS, FRAMES);
+        return multiInterleaved[0];
+    };
+}
+
+TEST_CASE("DbDezipper and VU benchmark", "[benchmark][.]")
+{
+    std::vector<float> signalL = MakeSignal(FRAMES);
+    std::vector<float> signalR = MakeSignal(FRAMES);
+    std::vector<float> buffer(FRAMES);
+
+    DbDezipper dezipper;
+    dezipper.SetSampleRate(48000);
+    dezipper.SetRate(0.1f);
+    dezipper.Reset(0);
+    BENCHMARK("DbDezipper Apply (idle)")
+    {
+        dezipper.Apply(buffer.data(), FRAMES);
+        return buffer[0];
+    };
+    float target = -20;
+    BENCHMARK("DbDezipper Apply (ramping)")
+    {
+        // alternate targets, so that the dezipper never settles.
+        target = target == -20 ? 0 : -20;
+        dezipper.SetTarget(target);
+        dezipper.Apply(buffer.data(), FRAMES);
+        return buffer[0];
+    };
+
+    BENCHMARK("VuAbsMax")
+    {
+        float maxValue = 0;
+        VuAbsMax(signalL.data(), FRAMES, &maxValue);
+        return maxValue;
+    };
+    BENCHMARK("VuAbsMax with sum of squares")
+    {
+        float maxValue = 0, sumOfSquares = 0;
+        VuAbsMax(signalL.data(), FRAMES, &maxValue, &sumOfSquares);
+        return maxValue + sumOfSquares;
+    };
+    BENCHMARK("VuAbsMaxStereo")
+    {
+        float maxL = 0, maxR = 0;
+        VuAbsMaxStereo(signalL.data(), signalR.data(), FRAMES, &maxL, &maxR);
+        return maxL + maxR;
+    };
+}
+
+TEST_CASE("SplitEffect mixer benchmark", "[benchmark][.]")
+{
+    // every split type, with mono or stereo pedalboard input, and mono or stereo chains.
+    std::vector<float> signalL = MakeSignal(FRAMES);
+    std::vector<float> signalR = MakeSignal(FRAMES);
+    std::vector<std::vector<float>> buffers(10, std::vector<float>(FRAMES));
+
+    const char *splitTypeNames[] = {"A/B", "mix", "L/R"};
+    for (int splitType = 0; splitType < 3; ++splitType)
+    {
+        for (size_t nInputs : {1, 2})
+        {
+            for (size_t nChain : {1, 2})
+            {
+                std::vector<float *> inputs{signalL.data()};
+                if (nInputs == 2)
+                {
+                    inputs.push_back(signalR.data());
+                }
+                std::vector<float *> top, bottom;
+                for (size_t i = 0; i < nChain; ++i)
+                {
+                    top.push_back(buffers[i].data());
+                    bottom.push_back(buffers[2 + i].data());
+                }
+                SplitEffect split(1, 48000, inputs);
+                split.SetChainBuffers(top, bottom, top, bottom, false);
+                for (int i = 0; i < split.GetNumberOfOutputAudioBuffers(); ++i)
+                {
+                    split.SetAudioOutputBuffer(i, buffers[4 + i].data());
+                }
+                split.SetControl(SplitEffect::SPLIT_TYPE_CTL, (float)splitType);
+                split.SetControl(SplitEffect::MIX_CTL, 0.3f);
+                split.Activate();
+
+                BENCHMARK(SS("SplitEffect " << splitTypeNames[splitType] << " " << nInputs << " in, " << nChain << " chain channel(s)"))
+                {
+                    split.PreMix(FRAMES);
+                    split.PostMix(FRAMES);
+                    return buffers[4][0];
+                };
+            }
+        }
+    }
+}
@@ -0,0 +1,1172 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "BinaryBank.hpp"
+#include "Banks.hpp"
+#include "Pedalboard.hpp"
+#include "PiPedalException.hpp"
+#include "ss.hpp"
+#include <bit>
+#include <cstring>
+
+using namespace pipedal;
+
+static_assert(std::endian::native == std::endian::little, "Binary bank files assume a little-endian host.");
+
+static constexpr char BINARY_BANK_MAGIC[8] = {'P', 'i', 'P', 'B', 'a', 'n', 'k', '\0'};
+static constexpr uint32_t BINARY_BANK_VERSION = 1;
+static constexpr size_t HEADER_SIZE = 48;
+static constexpr size_t STRING_TABLE_OFFSET_POSITION = 16;
+
+// Field numbers. Never reuse or renumber a field; add new ones at the end.
+struct PedalboardFields
+{
+    static constexpr uint32_t Name = 1;
+    static constexpr uint32_t InputVolumeDb = 2;
+    static constexpr uint32_t OutputVolumeDb = 3;
+    static constexpr uint32_t Item = 4;
+    static constexpr uint32_t NextInstanceId = 5;
+    static constexpr uint32_t Snapshot = 6;
+    static constexpr uint32_t EmptySnapshot = 7;
+    static constexpr uint32_t SelectedSnapshot = 8;
+    static constexpr uint32_t SelectedPlugin = 9;
+    static constexpr uint32_t ParallelSplits = 10;
+    static constexpr uint32_t Pipeline = 11;
+};
+struct PedalboardItemFields
+{
+    static constexpr uint32_t InstanceId = 1;
+    static constexpr uint32_t Uri = 2;
+    static constexpr uint32_t PluginName = 3;
+    static constexpr uint32_t IsEnabled = 4;
+    static constexpr uint32_t ControlKeys = 5;
+    static constexpr uint32_t ControlValues = 6;
+    static constexpr uint32_t TopChainItem = 7;
+    static constexpr uint32_t BottomChainItem = 8;
+    static constexpr uint32_t MidiBinding = 9;
+    static constexpr uint32_t MidiChannelBinding = 10;
+    static constexpr uint32_t StateUpdateCount = 11;
+    static constexpr uint32_t Lv2State = 12;
+    static constexpr uint32_t LilvPresetUri = 13;
+    static constexpr uint32_t PathPropertyKeys = 14;
+    static constexpr uint32_t PathPropertyValues = 15;
+    static constexpr uint32_t Title = 16;
+    static constexpr uint32_t UseModUi = 17;
+    static constexpr uint32_t IconColor = 18;
+    static constexpr uint32_t SideChainInputId = 19;
+    static constexpr uint32_t HardBypass = 20;
+    static constexpr uint32_t Essential = 21;
+    static constexpr uint32_t AlwaysRun = 22;
+};
+struct Lv2StateFields
+{
+    static constexpr uint32_t IsValid = 1;
+    static constexpr uint32_t Entry = 2;
+};
+struct Lv2StateEntryFields
+{
+    static constexpr uint32_t Key = 1;
+    static constexpr uint32_t Flags = 2;
+    static constexpr uint32_t AtomType = 3;
+    static constexpr uint32_t Value = 4;
+};
+struct MidiBindingFields
+{
+    static constexpr uint32_t Channel = 1;
+    static constexpr uint32_t Symbol = 2;
+    static constexpr uint32_t BindingType = 3;
+    static constexpr uint32_t Note = 4;
+    static constexpr uint32_t Control = 5;
+    static constexpr uint32_t MinControlValue = 6;
+    static constexpr uint32_t MaxControlValue = 7;
+    static constexpr uint32_t MinValue = 8;
+    static constexpr uint32_t MaxValue = 9;
+    static constexpr uint32_t RotaryScale = 10;
+    static constexpr uint32_t LinearControlType = 11;
+    static constexpr uint32_t SwitchControlType = 12;
+};
+struct MidiChannelBindingFields
+{
+    static constexpr uint32_t DeviceSelection = 1;
+    static constexpr uint32_t MidiDevices = 2;
+    static constexpr uint32_t Channel = 3;
+    static constexpr uint32_t AcceptProgramChanges = 4;
+    static constexpr uint32_t AcceptCommonMessages = 5;
+};
+struct SnapshotFields
+{
+    static constexpr uint32_t Name = 1;
+    static constexpr uint32_t Color = 2;
+    static constexpr uint32_t IsModified = 3;
+    static constexpr uint32_t Value = 4;
+};
+struct SnapshotValueFields
+{
+    static constexpr uint32_t InstanceId = 1;
+    static constexpr uint32_t IsEnabled = 2;
+    static constexpr uint32_t ControlKeys = 3;
+    static constexpr uint32_t ControlValues = 4;
+    static constexpr uint32_t Lv2State = 5;
+    static constexpr uint32_t PathPropertyKeys = 6;
+    static constexpr uint32_t PathPropertyValues = 7;
+};
+struct DirectoryFields
+{
+    static constexpr uint32_t Name = 1;
+    static constexpr uint32_t NextInstanceId = 2;
+    static constexpr uint32_t SelectedPreset = 3;
+    static constexpr uint32_t Preset = 4;
+};
+struct DirectoryEntryFields
+{
+    static constexpr uint32_t InstanceId = 1;
+    static constexpr uint32_t Name = 2;
+    static constexpr uint32_t Offset = 3;
+    static constexpr uint32_t Length = 4;
+};
+
+[[noreturn]] static void ThrowInvalidFile()
+{
+    throw PiPedalException("Invalid binary bank file.");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BinaryBankWriter
+
+BinaryBankWriter::BinaryBankWriter(const BankFileSource *copySource)
+    : copySource(copySource)
+{
+    output.append(BINARY_BANK_MAGIC, sizeof(BINARY_BANK_MAGIC));
+    output.resize(HEADER_SIZE, '\0');
+    AppendUint32(sizeof(BINARY_BANK_MAGIC), BINARY_BANK_VERSION);
+
+    if (copySource)
+    {
+        for (std::string_view s : copySource->BinaryStrings())
+        {
+            if (stringIds.find(std::string(s)) != stringIds.end())
+            {
+                // shouldn't happen, but ids would no longer match the source's.
+                this->copySource = nullptr;
+                break;
+            }
+            Intern(std::string(s));
+        }
+    }
+}
+
+void BinaryBankWriter::AppendVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        output.push_back((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    output.push_back((char)value);
+}
+
+void BinaryBankWriter::AppendUint32(size_t position, uint32_t value)
+{
+    std::memcpy(output.data() + position, &value, sizeof(value));
+}
+void BinaryBankWriter::AppendUint64(size_t position, uint64_t value)
+{
+    std::memcpy(output.data() + position, &value, sizeof(value));
+}
+
+void BinaryBankWriter::WriteTag(uint32_t field, BinaryWireType type)
+{
+    AppendVarint(((uint64_t)field << 3) | (uint64_t)type);
+}
+
+uint32_t BinaryBankWriter::Intern(const std::string &value)
+{
+    auto result = stringIds.emplace(value, (uint32_t)strings.size());
+    if (result.second)
+    {
+        strings.push_back(&result.first->first);
+    }
+    return result.first->second;
+}
+
+void BinaryBankWriter::WriteVarint(uint32_t field, uint64_t value)
+{
+    WriteTag(field, BinaryWireType::Varint);
+    AppendVarint(value);
+}
+
+void BinaryBankWriter::WriteSigned(uint32_t field, int64_t value)
+{
+    WriteVarint(field, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+void BinaryBankWriter::WriteFloat(uint32_t field, float value)
+{
+    WriteTag(field, BinaryWireType::Float);
+    output.append((const char *)&value, sizeof(value));
+}
+
+void BinaryBankWriter::WriteString(uint32_t field, const std::string &value)
+{
+    WriteTag(field, BinaryWireType::String);
+    AppendVarint(Intern(value));
+}
+
+void BinaryBankWriter::WriteBytes(uint32_t field, const void *data, size_t size)
+{
+    WriteTag(field, BinaryWireType::Bytes);
+    AppendVarint(size);
+    output.append((const char *)data, size);
+}
+
+void BinaryBankWriter::WriteFloatArray(uint32_t field, const std::vector<float> &values)
+{
+    WriteTag(field, BinaryWireType::FloatArray);
+    AppendVarint(values.size());
+    output.append((const char *)values.data(), values.size() * sizeof(float));
+}
+
+void BinaryBankWriter::WriteStringArray(uint32_t field, const std::vector<uint32_t> &stringIds)
+{
+    WriteTag(field, BinaryWireType::StringArray);
+    AppendVarint(stringIds.size());
+    for (uint32_t id : stringIds)
+    {
+        AppendVarint(id);
+    }
+}
+
+size_t BinaryBankWriter::BeginObject(uint32_t field)
+{
+    WriteTag(field, BinaryWireType::Object);
+    size_t position = output.size();
+    output.resize(position + sizeof(uint32_t));
+    return position;
+}
+
+void BinaryBankWriter::EndObject(size_t position)
+{
+    size_t length = output.size() - position - sizeof(uint32_t);
+    if (length > UINT32_MAX)
+    {
+        throw PiPedalException("Preset is too large.");
+    }
+    AppendUint32(position, (uint32_t)length);
+}
+
+static void WriteControlValues(
+    BinaryBankWriter &writer,
+    uint32_t keysField, uint32_t valuesField,
+    const std::vector<ControlValue> &controlValues)
+{
+    if (controlValues.empty())
+    {
+        return;
+    }
+    std::vector<uint32_t> keys;
+    std::vector<float> values;
+    keys.reserve(controlValues.size());
+    values.reserve(controlValues.size());
+    for (const auto &controlValue : controlValues)
+    {
+        keys.push_back(writer.Intern(controlValue.key()));
+        values.push_back(controlValue.value());
+    }
+    writer.WriteStringArray(keysField, keys);
+    writer.WriteFloatArray(valuesField, values);
+}
+
+static void WritePathProperties(
+    BinaryBankWriter &writer,
+    uint32_t keysField, uint32_t valuesField,
+    const std::map<std::string, std::string> &pathProperties)
+{
+    if (pathProperties.empty())
+    {
+        return;
+    }
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> values;
+    for (const auto &pathProperty : pathProperties)
+    {
+        keys.push_back(writer.Intern(pathProperty.first));
+        values.push_back(writer.Intern(pathProperty.second));
+    }
+    writer.WriteStringArray(keysField, keys);
+    writer.WriteStringArray(valuesField, values);
+}
+
+static void WriteLv2State(BinaryBankWriter &writer, uint32_t field, const Lv2PluginState &state)
+{
+    size_t object = writer.BeginObject(field);
+    writer.WriteBool(Lv2StateFields::IsValid, state.isValid_);
+    for (const auto &value : state.values_)
+    {
+        const Lv2PluginStateEntry &entry = value.second;
+        size_t entryObject = writer.BeginObject(Lv2StateFields::Entry);
+        writer.WriteString(Lv2StateEntryFields::Key, value.first);
+        writer.WriteSigned(Lv2StateEntryFields::Flags, entry.flags_);
+        writer.WriteString(Lv2StateEntryFields::AtomType, entry.atomType_);
+        writer.WriteBytes(Lv2StateEntryFields::Value, entry.value_.data(), entry.value_.size());
+        writer.EndObject(entryObject);
+    }
+    writer.EndObject(object);
+}
+
+static void WriteMidiBinding(BinaryBankWriter &writer, const MidiBinding &binding)
+{
+    size_t object = writer.BeginObject(PedalboardItemFields::MidiBinding);
+    writer.WriteSigned(MidiBindingFields::Channel, binding.channel());
+    writer.WriteString(MidiBindingFields::Symbol, binding.symbol());
+    writer.WriteSigned(MidiBindingFields::BindingType, binding.bindingType());
+    writer.WriteSigned(MidiBindingFields::Note, binding.note());
+    writer.WriteSigned(MidiBindingFields::Control, binding.control());
+    writer.WriteSigned(MidiBindingFields::MinControlValue, binding.minControlValue());
+    writer.WriteSigned(MidiBindingFields::MaxControlValue, binding.maxControlValue());
+    writer.WriteFloat(MidiBindingFields::MinValue, binding.minValue());
+    writer.WriteFloat(MidiBindingFields::MaxValue, binding.maxValue());
+    writer.WriteFloat(MidiBindingFields::RotaryScale, binding.rotaryScale());
+    writer.WriteSigned(MidiBindingFields::LinearControlType, binding.linearControlType());
+    writer.WriteSigned(MidiBindingFields::SwitchControlType, (int64_t)binding.switchControlType());
+    writer.EndObject(object);
+}
+
+static void WriteMidiChannelBinding(BinaryBankWriter &writer, const MidiChannelBinding &binding)
+{
+    size_t object = writer.BeginObject(PedalboardItemFields::MidiChannelBinding);
+    writer.WriteSigned(MidiChannelBindingFields::DeviceSelection, (int64_t)binding.deviceSelection());
+    std::vector<uint32_t> devices;
+    for (const auto &device : binding.midiDevices())
+    {
+        devices.push_back(writer.Intern(device));
+    }
+    writer.WriteStringArray(MidiChannelBindingFields::MidiDevices, devices);
+    writer.WriteSigned(MidiChannelBindingFields::Channel, binding.channel());
+    writer.WriteBool(MidiChannelBindingFields::AcceptProgramChanges, binding.acceptProgramChanges());
+    writer.WriteBool(MidiChannelBindingFields::AcceptCommonMessages, binding.acceptCommonMessages());
+    writer.EndObject(object);
+}
+
+static void WritePedalboardItem(BinaryBankWriter &writer, uint32_t field, const PedalboardItem &item)
+{
+    size_t object = writer.BeginObject(field);
+    writer.WriteSigned(PedalboardItemFields::InstanceId, item.instanceId_);
+    writer.WriteString(PedalboardItemFields::Uri, item.uri_);
+    writer.WriteString(PedalboardItemFields::PluginName, item.pluginName_);
+    writer.WriteBool(PedalboardItemFields::IsEnabled, item.isEnabled_);
+    WriteControlValues(writer, PedalboardItemFields::ControlKeys, PedalboardItemFields::ControlValues, item.controlValues_);
+    for (const auto &child : item.topChain_)
+    {
+        WritePedalboardItem(writer, PedalboardItemFields::TopChainItem, child);
+    }
+    for (const auto &child : item.bottomChain_)
+    {
+        WritePedalboardItem(writer, PedalboardItemFields::BottomChainItem, child);
+    }
+    for (const auto &binding : item.midiBindings_)
+    {
+        WriteMidiBinding(writer, binding);
+    }
+    if (item.midiChannelBinding_)
+    {
+        WriteMidiChannelBinding(writer, item.midiChannelBinding_.value());
+    }
+    writer.WriteVarint(PedalboardItemFields::StateUpdateCount, item.stateUpdateCount_);
+    WriteLv2State(writer, PedalboardItemFields::Lv2State, item.lv2State_);
+    writer.WriteString(PedalboardItemFields::LilvPresetUri, item.lilvPresetUri_);
+    WritePathProperties(writer, PedalboardItemFields::PathPropertyKeys, PedalboardItemFields::PathPropertyValues, item.pathProperties_);
+    writer.WriteString(PedalboardItemFields::Title, item.title_);
+    writer.WriteBool(PedalboardItemFields::UseModUi, item.useModUi_);
+    writer.WriteString(PedalboardItemFields::IconColor, item.iconColor_);
+    writer.WriteSigned(PedalboardItemFields::SideChainInputId, item.sideChainInputId_);
+    writer.WriteBool(PedalboardItemFields::HardBypass, item.hardBypass_);
+    writer.WriteBool(PedalboardItemFields::Essential, item.essential_);
+    writer.WriteBool(PedalboardItemFields::AlwaysRun, item.alwaysRun_);
+    writer.EndObject(object);
+}
+
+static void WriteSnapshot(BinaryBankWriter &writer, const Snapshot &snapshot)
+{
+    size_t object = writer.BeginObject(PedalboardFields::Snapshot);
+    writer.WriteString(SnapshotFields::Name, snapshot.name_);
+    writer.WriteString(SnapshotFields::Color, snapshot.color_);
+    writer.WriteBool(SnapshotFields::IsModified, snapshot.isModified_);
+    for (const auto &value : snapshot.values_)
+    {
+        size_t valueObject = writer.BeginObject(SnapshotFields::Value);
+        writer.WriteVarint(SnapshotValueFields::InstanceId, value.instanceId_);
+        writer.WriteBool(SnapshotValueFields::IsEnabled, value.isEnabled_);
+        WriteControlValues(writer, SnapshotValueFields::ControlKeys, SnapshotValueFields::ControlValues, value.controlValues_);
+        WriteLv2State(writer, SnapshotValueFields::Lv2State, value.lv2State_);
+        WritePathProperties(writer, SnapshotValueFields::PathPropertyKeys, SnapshotValueFields::PathPropertyValues, value.pathProperties_);
+        writer.EndObject(valueObject);
+    }
+    writer.EndObject(object);
+}
+
+void BinaryBankWriter::WritePreset(const Pedalboard &preset)
+{
+    WriteString(PedalboardFields::Name, preset.name());
+    WriteFloat(PedalboardFields::InputVolumeDb, preset.input_volume_db());
+    WriteFloat(PedalboardFields::OutputVolumeDb, preset.output_volume_db());
+    for (const auto &item : preset.items())
+    {
+        WritePedalboardItem(*this, PedalboardFields::Item, item);
+    }
+    WriteVarint(PedalboardFields::NextInstanceId, preset.nextInstanceId());
+    for (const auto &snapshot : preset.snapshots())
+    {
+        if (snapshot)
+        {
+            WriteSnapshot(*this, *snapshot);
+        }
+        else
+        {
+            WriteBool(PedalboardFields::EmptySnapshot, true);
+        }
+    }
+    WriteSigned(PedalboardFields::SelectedSnapshot, preset.selectedSnapshot());
+    WriteSigned(PedalboardFields::SelectedPlugin, preset.selectedPlugin());
+    WriteBool(PedalboardFields::ParallelSplits, preset.parallelSplits());
+    WriteBool(PedalboardFields::Pipeline, preset.pipeline());
+}
+
+void BinaryBankWriter::WritePresetRecord(std::string_view record)
+{
+    output.append(record);
+}
+
+std::string BinaryBankWriter::Finish(const BankFileIndex &index)
+{
+    // the directory interns the preset names, so write it before the string table.
+    std::string presetRecords;
+    std::swap(output, presetRecords);
+
+    WriteString(DirectoryFields::Name, index.name());
+    WriteSigned(DirectoryFields::NextInstanceId, index.nextInstanceId());
+    WriteSigned(DirectoryFields::SelectedPreset, index.selectedPreset());
+    for (const auto &location : index.presets())
+    {
+        size_t object = BeginObject(DirectoryFields::Preset);
+        WriteSigned(DirectoryEntryFields::InstanceId, location.instanceId());
+        WriteString(DirectoryEntryFields::Name, location.name());
+        WriteVarint(DirectoryEntryFields::Offset, location.offset());
+        WriteVarint(DirectoryEntryFields::Length, location.length());
+        EndObject(object);
+    }
+    std::string directory;
+    std::swap(output, directory);
+
+    output = std::move(presetRecords);
+    uint64_t stringTableOffset = output.size();
+    AppendVarint(strings.size());
+    for (const std::string *s : strings)
+    {
+        AppendVarint(s->size());
+        output.append(*s);
+    }
+    uint64_t directoryOffset = output.size();
+    output.append(directory);
+
+    AppendUint64(STRING_TABLE_OFFSET_POSITION, stringTableOffset);
+    AppendUint64(STRING_TABLE_OFFSET_POSITION + 8, directoryOffset - stringTableOffset);
+    AppendUint64(STRING_TABLE_OFFSET_POSITION + 16, directoryOffset);
+    AppendUint64(STRING_TABLE_OFFSET_POSITION + 24, output.size() - directoryOffset);
+    return std::move(output);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// BinaryBankReader
+
+BinaryBankReader::BinaryBankReader(std::string_view data, const std::vector<std::string_view> &strings)
+    : p(data.data()), end(data.data() + data.size()), strings(&strings)
+{
+}
+
+const char *BinaryBankReader::Take(size_t size)
+{
+    if ((size_t)(end - p) < size)
+    {
+        ThrowInvalidFile();
+    }
+    const char *result = p;
+    p += size;
+    return result;
+}
+
+uint64_t BinaryBankReader::ReadRawVarint()
+{
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (p == end)
+        {
+            ThrowInvalidFile();
+        }
+        uint8_t c = (uint8_t)*p++;
+        result |= (uint64_t)(c & 0x7F) << shift;
+        if ((c & 0x80) == 0)
+        {
+            return result;
+        }
+    }
+    ThrowInvalidFile();
+}
+
+void BinaryBankReader::Expect(BinaryWireType type)
+{
+    if (fieldType != type)
+    {
+        ThrowInvalidFile();
+    }
+}
+
+std::string_view BinaryBankReader::StringAt(uint64_t index)
+{
+    if (index >= strings->size())
+    {
+        ThrowInvalidFile();
+    }
+    return (*strings)[index];
+}
+
+bool BinaryBankReader::ReadField(uint32_t *field, BinaryWireType *type)
+{
+    if (p == end)
+    {
+        return false;
+    }
+    uint64_t tag = ReadRawVarint();
+    if ((tag & 7) > (uint64_t)BinaryWireType::StringArray || (tag >> 3) > UINT32_MAX)
+    {
+        ThrowInvalidFile();
+    }
+    fieldType = (BinaryWireType)(tag & 7);
+    *field = (uint32_t)(tag >> 3);
+    *type = fieldType;
+    return true;
+}
+
+uint64_t BinaryBankReader::ReadVarint()
+{
+    Expect(BinaryWireType::Varint);
+    return ReadRawVarint();
+}
+
+int64_t BinaryBankReader::ReadSigned()
+{
+    uint64_t value = ReadVarint();
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+float BinaryBankReader::ReadFloat()
+{
+    Expect(BinaryWireType::Float);
+    float result;
+    std::memcpy(&result, Take(sizeof(result)), sizeof(result));
+    return result;
+}
+
+std::string BinaryBankReader::ReadString()
+{
+    Expect(BinaryWireType::String);
+    return std::string(StringAt(ReadRawVarint()));
+}
+
+std::vector<uint8_t> BinaryBankReader::ReadBytes()
+{
+    Expect(BinaryWireType::Bytes);
+    size_t size = (size_t)ReadRawVarint();
+    const uint8_t *data = (const uint8_t *)Take(size);
+    return std::vector<uint8_t>(data, data + size);
+}
+
+void BinaryBankReader::ReadFloatArray(std::vector<float> *values)
+{
+    Expect(BinaryWireType::FloatArray);
+    uint64_t count = ReadRawVarint();
+    if (count > (uint64_t)(end - p) / sizeof(float))
+    {
+        ThrowInvalidFile();
+    }
+    values->resize((size_t)count);
+    std::memcpy(values->data(), Take(count * sizeof(float)), count * sizeof(float));
+}
+
+void BinaryBankReader::ReadStringArray(std::vector<std::string> *values)
+{
+    Expect(BinaryWireType::StringArray);
+    uint64_t count = ReadRawVarint();
+    if (count > (uint64_t)(end - p))
+    {
+        ThrowInvalidFile();
+    }
+    values->clear();
+    values->reserve((size_t)count);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        values->push_back(std::string(StringAt(ReadRawVarint())));
+    }
+}
+
+BinaryBankReader BinaryBankReader::ReadObject()
+{
+    Expect(BinaryWireType::Object);
+    uint32_t length;
+    std::memcpy(&length, Take(sizeof(length)), sizeof(length));
+    const char *data = Take(length);
+    return BinaryBankReader(std::string_view(data, length), *strings);
+}
+
+void BinaryBankReader::Skip()
+{
+    switch (fieldType)
+    {
+    case BinaryWireType::Varint:
+    case BinaryWireType::String:
+        ReadRawVarint();
+        break;
+    case BinaryWireType::Float:
+        Take(sizeof(float));
+        break;
+    case BinaryWireType::Bytes:
+        Take((size_t)ReadRawVarint());
+        break;
+    case BinaryWireType::Object:
+        ReadObject();
+        break;
+    case BinaryWireType::FloatArray:
+    {
+        uint64_t count = ReadRawVarint();
+        if (count > (uint64_t)(end - p) / sizeof(float))
+        {
+            ThrowInvalidFile();
+        }
+        Take(count * sizeof(float));
+        break;
+    }
+    case BinaryWireType::StringArray:
+    {
+        uint64_t count = ReadRawVarint();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            ReadRawVarint();
+        }
+        break;
+    }
+    }
+}
+
+static std::vector<ControlValue> MakeControlValues(const std::vector<std::string> &keys, const std::vector<float> &values)
+{
+    if (keys.size() != values.size())
+    {
+        ThrowInvalidFile();
+    }
+    std::vector<ControlValue> result;
+    result.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        result.push_back(ControlValue(keys[i], values[i]));
+    }
+    return result;
+}
+
+static std::map<std::string, std::string> MakePathProperties(const std::vector<std::string> &keys, const std::vector<std::string> &values)
+{
+    if (keys.size() != values.size())
+    {
+        ThrowInvalidFile();
+    }
+    std::map<std::string, std::string> result;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        result[keys[i]] = values[i];
+    }
+    return result;
+}
+
+static void ReadLv2State(BinaryBankReader reader, Lv2PluginState *state)
+{
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case Lv2StateFields::IsValid:
+            state->isValid_ = reader.ReadBool();
+            break;
+        case Lv2StateFields::Entry:
+        {
+            BinaryBankReader entryReader = reader.ReadObject();
+            std::string key;
+            Lv2PluginStateEntry entry;
+            while (entryReader.ReadField(&field, &type))
+            {
+                switch (field)
+                {
+                case Lv2StateEntryFields::Key:
+                    key = entryReader.ReadString();
+                    break;
+                case Lv2StateEntryFields::Flags:
+                    entry.flags_ = (int32_t)entryReader.ReadSigned();
+                    break;
+                case Lv2StateEntryFields::AtomType:
+                    entry.atomType_ = entryReader.ReadString();
+                    break;
+                case Lv2StateEntryFields::Value:
+                    entry.value_ = entryReader.ReadBytes();
+                    break;
+                default:
+                    entryReader.Skip();
+                    break;
+                }
+            }
+            state->values_[key] = std::move(entry);
+            break;
+        }
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+}
+
+static MidiBinding ReadMidiBinding(BinaryBankReader reader)
+{
+    MidiBinding binding;
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case MidiBindingFields::Channel:
+            binding.channel((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::Symbol:
+            binding.symbol(reader.ReadString());
+            break;
+        case MidiBindingFields::BindingType:
+            binding.bindingType((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::Note:
+            binding.note((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::Control:
+            binding.control((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::MinControlValue:
+            binding.minControlValue((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::MaxControlValue:
+            binding.maxControlValue((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::MinValue:
+            binding.minValue(reader.ReadFloat());
+            break;
+        case MidiBindingFields::MaxValue:
+            binding.maxValue(reader.ReadFloat());
+            break;
+        case MidiBindingFields::RotaryScale:
+            binding.rotaryScale(reader.ReadFloat());
+            break;
+        case MidiBindingFields::LinearControlType:
+            binding.linearControlType((int)reader.ReadSigned());
+            break;
+        case MidiBindingFields::SwitchControlType:
+            binding.switchControlType((SwitchControlTypeT)reader.ReadSigned());
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    return binding;
+}
+
+static MidiChannelBinding ReadMidiChannelBinding(BinaryBankReader reader)
+{
+    MidiChannelBinding binding;
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case MidiChannelBindingFields::DeviceSelection:
+            binding.deviceSelection((MidiDeviceSelection)reader.ReadSigned());
+            break;
+        case MidiChannelBindingFields::MidiDevices:
+            reader.ReadStringArray(&binding.midiDevices());
+            break;
+        case MidiChannelBindingFields::Channel:
+            binding.channel((int32_t)reader.ReadSigned());
+            break;
+        case MidiChannelBindingFields::AcceptProgramChanges:
+            binding.acceptProgramChanges(reader.ReadBool());
+            break;
+        case MidiChannelBindingFields::AcceptCommonMessages:
+            binding.acceptCommonMessages(reader.ReadBool());
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    return binding;
+}
+
+static PedalboardItem ReadPedalboardItem(BinaryBankReader reader)
+{
+    PedalboardItem item;
+    std::vector<std::string> controlKeys, pathKeys, pathValues;
+    std::vector<float> controlValues;
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case PedalboardItemFields::InstanceId:
+            item.instanceId_ = reader.ReadSigned();
+            break;
+        case PedalboardItemFields::Uri:
+            item.uri_ = reader.ReadString();
+            break;
+        case PedalboardItemFields::PluginName:
+            item.pluginName_ = reader.ReadString();
+            break;
+        case PedalboardItemFields::IsEnabled:
+            item.isEnabled_ = reader.ReadBool();
+            break;
+        case PedalboardItemFields::ControlKeys:
+            reader.ReadStringArray(&controlKeys);
+            break;
+        case PedalboardItemFields::ControlValues:
+            reader.ReadFloatArray(&controlValues);
+            break;
+        case PedalboardItemFields::TopChainItem:
+            item.topChain_.push_back(ReadPedalboardItem(reader.ReadObject()));
+            break;
+        case PedalboardItemFields::BottomChainItem:
+            item.bottomChain_.push_back(ReadPedalboardItem(reader.ReadObject()));
+            break;
+        case PedalboardItemFields::MidiBinding:
+            item.midiBindings_.push_back(ReadMidiBinding(reader.ReadObject()));
+            break;
+        case PedalboardItemFields::MidiChannelBinding:
+            item.midiChannelBinding_ = ReadMidiChannelBinding(reader.ReadObject());
+            break;
+        case PedalboardItemFields::StateUpdateCount:
+            item.stateUpdateCount_ = (uint32_t)reader.ReadVarint();
+            break;
+        case PedalboardItemFields::Lv2State:
+            ReadLv2State(reader.ReadObject(), &item.lv2State_);
+            break;
+        case PedalboardItemFields::LilvPresetUri:
+            item.lilvPresetUri_ = reader.ReadString();
+            break;
+        case PedalboardItemFields::PathPropertyKeys:
+            reader.ReadStringArray(&pathKeys);
+            break;
+        case PedalboardItemFields::PathPropertyValues:
+            reader.ReadStringArray(&pathValues);
+            break;
+        case PedalboardItemFields::Title:
+            item.title_ = reader.ReadString();
+            break;
+        case PedalboardItemFields::UseModUi:
+            item.useModUi_ = reader.ReadBool();
+            break;
+        case PedalboardItemFields::IconColor:
+            item.iconColor_ = reader.ReadString();
+            break;
+        case PedalboardItemFields::SideChainInputId:
+            item.sideChainInputId_ = reader.ReadSigned();
+            break;
+        case PedalboardItemFields::HardBypass:
+            item.hardBypass_ = reader.ReadBool();
+            break;
+        case PedalboardItemFields::Essential:
+            item.essential_ = reader.ReadBool();
+            break;
+        case PedalboardItemFields::AlwaysRun:
+            item.alwaysRun_ = reader.ReadBool();
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    item.controlValues_ = MakeControlValues(controlKeys, controlValues);
+    item.pathProperties_ = MakePathProperties(pathKeys, pathValues);
+    return item;
+}
+
+static SnapshotValue ReadSnapshotValue(BinaryBankReader reader)
+{
+    SnapshotValue value;
+    value.instanceId_ = 0;
+    std::vector<std::string> controlKeys, pathKeys, pathValues;
+    std::vector<float> controlValues;
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case SnapshotValueFields::InstanceId:
+            value.instanceId_ = reader.ReadVarint();
+            break;
+        case SnapshotValueFields::IsEnabled:
+            value.isEnabled_ = reader.ReadBool();
+            break;
+        case SnapshotValueFields::ControlKeys:
+            reader.ReadStringArray(&controlKeys);
+            break;
+        case SnapshotValueFields::ControlValues:
+            reader.ReadFloatArray(&controlValues);
+            break;
+        case SnapshotValueFields::Lv2State:
+            ReadLv2State(reader.ReadObject(), &value.lv2State_);
+            break;
+        case SnapshotValueFields::PathPropertyKeys:
+            reader.ReadStringArray(&pathKeys);
+            break;
+        case SnapshotValueFields::PathPropertyValues:
+            reader.ReadStringArray(&pathValues);
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    value.controlValues_ = MakeControlValues(controlKeys, controlValues);
+    value.pathProperties_ = MakePathProperties(pathKeys, pathValues);
+    return value;
+}
+
+static std::shared_ptr<Snapshot> ReadSnapshot(BinaryBankReader reader)
+{
+    auto snapshot = std::make_shared<Snapshot>();
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case SnapshotFields::Name:
+            snapshot->name_ = reader.ReadString();
+            break;
+        case SnapshotFields::Color:
+            snapshot->color_ = reader.ReadString();
+            break;
+        case SnapshotFields::IsModified:
+            snapshot->isModified_ = reader.ReadBool();
+            break;
+        case SnapshotFields::Value:
+            snapshot->values_.push_back(ReadSnapshotValue(reader.ReadObject()));
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    return snapshot;
+}
+
+Pedalboard BinaryBankReader::ReadPreset(std::string_view record, const std::vector<std::string_view> &strings)
+{
+    Pedalboard pedalboard;
+    BinaryBankReader reader(record, strings);
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case PedalboardFields::Name:
+            pedalboard.name(reader.ReadString());
+            break;
+        case PedalboardFields::InputVolumeDb:
+            pedalboard.input_volume_db(reader.ReadFloat());
+            break;
+        case PedalboardFields::OutputVolumeDb:
+            pedalboard.output_volume_db(reader.ReadFloat());
+            break;
+        case PedalboardFields::Item:
+            pedalboard.items().push_back(ReadPedalboardItem(reader.ReadObject()));
+            break;
+        case PedalboardFields::NextInstanceId:
+            pedalboard.nextInstanceId(reader.ReadVarint());
+            break;
+        case PedalboardFields::Snapshot:
+            pedalboard.snapshots().push_back(ReadSnapshot(reader.ReadObject()));
+            break;
+        case PedalboardFields::EmptySnapshot:
+            reader.ReadBool();
+            pedalboard.snapshots().push_back(nullptr);
+            break;
+        case PedalboardFields::SelectedSnapshot:
+            pedalboard.selectedSnapshot(reader.ReadSigned());
+            break;
+        case PedalboardFields::SelectedPlugin:
+            pedalboard.selectedPlugin(reader.ReadSigned());
+            break;
+        case PedalboardFields::ParallelSplits:
+            pedalboard.parallelSplits(reader.ReadBool());
+            break;
+        case PedalboardFields::Pipeline:
+            pedalboard.pipeline(reader.ReadBool());
+            break;
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    return pedalboard;
+}
+
+static uint64_t ReadHeaderUint64(std::string_view fileData, size_t position)
+{
+    uint64_t result;
+    std::memcpy(&result, fileData.data() + position, sizeof(result));
+    return result;
+}
+
+// The range of the file described by the header at position, validated.
+static std::string_view HeaderRange(std::string_view fileData, size_t position)
+{
+    uint64_t offset = ReadHeaderUint64(fileData, position);
+    uint64_t length = ReadHeaderUint64(fileData, position + 8);
+    if (offset < HEADER_SIZE || offset > fileData.size() || length > fileData.size() - offset)
+    {
+        ThrowInvalidFile();
+    }
+    return fileData.substr((size_t)offset, (size_t)length);
+}
+
+static void CheckHeader(std::string_view fileData)
+{
+    if (!BinaryBankReader::IsBinaryBankFile(fileData))
+    {
+        ThrowInvalidFile();
+    }
+    uint32_t version;
+    std::memcpy(&version, fileData.data() + sizeof(BINARY_BANK_MAGIC), sizeof(version));
+    if (version > BINARY_BANK_VERSION)
+    {
+        throw PiPedalException(SS("Bank file was written by a newer version of PiPedal (binary format version " << version << ")."));
+    }
+}
+
+bool BinaryBankReader::IsBinaryBankFile(std::string_view fileData)
+{
+    return fileData.size() >= HEADER_SIZE &&
+           std::memcmp(fileData.data(), BINARY_BANK_MAGIC, sizeof(BINARY_BANK_MAGIC)) == 0;
+}
+
+std::vector<std::string_view> BinaryBankReader::ReadStringTable(std::string_view fileData)
+{
+    CheckHeader(fileData);
+    std::string_view table = HeaderRange(fileData, STRING_TABLE_OFFSET_POSITION);
+    std::vector<std::string_view> noStrings;
+    BinaryBankReader reader(table, noStrings);
+
+    uint64_t count = reader.ReadRawVarint();
+    if (count > table.size())
+    {
+        ThrowInvalidFile();
+    }
+    std::vector<std::string_view> result;
+    result.reserve((size_t)count);
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        size_t length = (size_t)reader.ReadRawVarint();
+        const char *data = reader.Take(length);
+        result.push_back(std::string_view(data, length));
+    }
+    return result;
+}
+
+BankFileIndex BinaryBankReader::ReadIndex(std::string_view fileData, const std::vector<std::string_view> &strings)
+{
+    CheckHeader(fileData);
+    BankFileIndex index;
+    BinaryBankReader reader(HeaderRange(fileData, STRING_TABLE_OFFSET_POSITION + 16), strings);
+    uint32_t field;
+    BinaryWireType type;
+    while (reader.ReadField(&field, &type))
+    {
+        switch (field)
+        {
+        case DirectoryFields::Name:
+            index.name(reader.ReadString());
+            break;
+        case DirectoryFields::NextInstanceId:
+            index.nextInstanceId(reader.ReadSigned());
+            break;
+        case DirectoryFields::SelectedPreset:
+            index.selectedPreset(reader.ReadSigned());
+            break;
+        case DirectoryFields::Preset:
+        {
+            BinaryBankReader entryReader = reader.ReadObject();
+            BankFileIndexEntry location;
+            while (entryReader.ReadField(&field, &type))
+            {
+                switch (field)
+                {
+                case DirectoryEntryFields::InstanceId:
+                    location.instanceId(entryReader.ReadSigned());
+                    break;
+                case DirectoryEntryFields::Name:
+                    location.name(entryReader.ReadString());
+                    break;
+                case DirectoryEntryFields::Offset:
+                    location.offset(entryReader.ReadVarint());
+                    break;
+                case DirectoryEntryFields::Length:
+                    location.length(entryReader.ReadVarint());
+                    break;
+                default:
+                    entryReader.Skip();
+                    break;
+                }
+            }
+            if (location.offset() < HEADER_SIZE ||
+                location.offset() > fileData.size() ||
+                location.length() > fileData.size() - location.offset())
+            {
+                ThrowInvalidFile();
+            }
+            index.presets().push_back(std::move(location));
+            break;
+        }
+        default:
+            reader.Skip();
+            break;
+        }
+    }
+    return index;
+}
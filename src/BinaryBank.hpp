@@ -0,0 +1,151 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace pipedal
+{
+    class BankFileIndex;
+    class BankFileSource;
+    class Pedalboard;
+
+    /*
+        Binary bank file format.
+
+        A compact alternative to json bank files, for banks with large plugin states.
+        Control values are stored as raw float arrays, Lv2 state values as raw bytes, and
+        every string (plugin URIs, symbols, state keys, names) is stored once in a string
+        table and referred to by index. All values are little-endian.
+
+            header          magic[8], uint32 version, uint32 reserved,
+                            uint64 string table offset, uint64 string table length,
+                            uint64 directory offset, uint64 directory length
+            presets         one record per preset
+            string table    varint count, then (varint length, bytes) for each string
+            directory       bank name, nextInstanceId, selectedPreset, and the
+                            instanceId, name, offset and length of each preset record
+
+        Records are sequences of tagged fields (varint (field << 3) | wire type), so readers
+        skip fields they don't know about. Nested objects are length-prefixed.
+
+        Json remains the interchange format: preset bundles and bank exports are always json.
+    */
+
+    enum class BinaryWireType : uint8_t
+    {
+        Varint = 0,     // unsigned or zigzag-encoded signed integer.
+        Float = 1,      // 4-byte float.
+        Bytes = 2,      // varint length, then raw bytes.
+        String = 3,     // varint string table index.
+        Object = 4,     // uint32 length, then fields.
+        FloatArray = 5, // varint count, then raw floats.
+        StringArray = 6 // varint count, then varint string table indices.
+    };
+
+    class BinaryBankWriter
+    {
+    public:
+        // Records of unloaded presets from copySource can be copied without decoding them, since
+        // the string table starts with copySource's strings.
+        BinaryBankWriter(const BankFileSource *copySource = nullptr);
+
+        bool CanCopyFrom(const BankFileSource &source) const { return &source == copySource; }
+
+        // Current offset in the file.
+        uint64_t Position() const { return output.size(); }
+
+        void WritePreset(const Pedalboard &preset);
+        void WritePresetRecord(std::string_view record);
+
+        // Append the string table and directory, and return the file contents.
+        std::string Finish(const BankFileIndex &index);
+
+        void WriteVarint(uint32_t field, uint64_t value);
+        void WriteSigned(uint32_t field, int64_t value);
+        void WriteBool(uint32_t field, bool value) { WriteVarint(field, value ? 1 : 0); }
+        void WriteFloat(uint32_t field, float value);
+        void WriteString(uint32_t field, const std::string &value);
+        void WriteBytes(uint32_t field, const void *data, size_t size);
+        void WriteFloatArray(uint32_t field, const std::vector<float> &values);
+        void WriteStringArray(uint32_t field, const std::vector<uint32_t> &stringIds);
+
+        // Returns the position to pass to EndObject.
+        size_t BeginObject(uint32_t field);
+        void EndObject(size_t position);
+
+        uint32_t Intern(const std::string &value);
+
+    private:
+        void WriteTag(uint32_t field, BinaryWireType type);
+        void AppendVarint(uint64_t value);
+        void AppendUint32(size_t position, uint32_t value);
+        void AppendUint64(size_t position, uint64_t value);
+
+        const BankFileSource *copySource = nullptr;
+        std::string output;
+        std::unordered_map<std::string, uint32_t> stringIds;
+        std::vector<const std::string *> strings;
+    };
+
+    class BinaryBankReader
+    {
+    public:
+        static bool IsBinaryBankFile(std::string_view fileData);
+        // Views into fileData.
+        static std::vector<std::string_view> ReadStringTable(std::string_view fileData);
+        static BankFileIndex ReadIndex(std::string_view fileData, const std::vector<std::string_view> &strings);
+        static Pedalboard ReadPreset(std::string_view record, const std::vector<std::string_view> &strings);
+
+        BinaryBankReader(std::string_view data, const std::vector<std::string_view> &strings);
+
+        // Returns false at the end of the record.
+        bool ReadField(uint32_t *field, BinaryWireType *type);
+
+        uint64_t ReadVarint();
+        int64_t ReadSigned();
+        bool ReadBool() { return ReadVarint() != 0; }
+        float ReadFloat();
+        std::string ReadString();
+        std::vector<uint8_t> ReadBytes();
+        void ReadFloatArray(std::vector<float> *values);
+        void ReadStringArray(std::vector<std::string> *values);
+        BinaryBankReader ReadObject();
+        // Skip the value of the field just read.
+        void Skip();
+
+    private:
+        void Expect(BinaryWireType type);
+        uint64_t ReadRawVarint();
+        const char *Take(size_t size);
+        std::string_view StringAt(uint64_t index);
+
+        const char *p;
+        const char *end;
+        const std::vector<std::string_view> *strings;
+        BinaryWireType fieldType = BinaryWireType::Varint;
+    };
+}
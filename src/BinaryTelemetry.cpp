@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "BinaryTelemetry.hpp"
+#include "VuUpdate.hpp"
+#include <bit>
+#include <stdexcept>
+
+using namespace pipedal;
+
+BinaryTelemetryWriter::BinaryTelemetryWriter(FrameType frameType)
+    : frameType(frameType)
+{
+    frame.reserve(HEADER_SIZE + 8 * VU_UPDATE_SIZE);
+    WriteU32((uint32_t)frameType);
+    WriteU32(0); // count; patched as entries are added.
+}
+
+void BinaryTelemetryWriter::WriteU32(uint32_t value)
+{
+    frame.push_back((uint8_t)value);
+    frame.push_back((uint8_t)(value >> 8));
+    frame.push_back((uint8_t)(value >> 16));
+    frame.push_back((uint8_t)(value >> 24));
+}
+void BinaryTelemetryWriter::WriteI64(int64_t value)
+{
+    uint64_t v = (uint64_t)value;
+    WriteU32((uint32_t)v);
+    WriteU32((uint32_t)(v >> 32));
+}
+void BinaryTelemetryWriter::WriteFloat(float value)
+{
+    WriteU32(std::bit_cast<uint32_t>(value));
+}
+
+void BinaryTelemetryWriter::IncrementCount()
+{
+    ++count;
+    uint8_t *pCount = &frame[4];
+    pCount[0] = (uint8_t)count;
+    pCount[1] = (uint8_t)(count >> 8);
+    pCount[2] = (uint8_t)(count >> 16);
+    pCount[3] = (uint8_t)(count >> 24);
+}
+
+void BinaryTelemetryWriter::AddVuUpdate(const VuUpdate &vuUpdate)
+{
+    if (frameType != FrameType::VuUpdate)
+    {
+        throw std::logic_error("Wrong telemetry frame type.");
+    }
+    uint32_t flags = 0;
+    if (vuUpdate.isStereoInput_)
+        flags |= VU_FLAG_STEREO_INPUT;
+    if (vuUpdate.isStereoOutput_)
+        flags |= VU_FLAG_STEREO_OUTPUT;
+    if (vuUpdate.isIdle_)
+        flags |= VU_FLAG_IDLE;
+
+    WriteI64(vuUpdate.instanceId_);
+    WriteU32((uint32_t)(int32_t)vuUpdate.sampleTime_);
+    WriteU32(flags);
+    WriteFloat(vuUpdate.inputMaxValueL_);
+    WriteFloat(vuUpdate.inputMaxValueR_);
+    WriteFloat(vuUpdate.outputMaxValueL_);
+    WriteFloat(vuUpdate.outputMaxValueR_);
+
+    IncrementCount();
+}
+
+void BinaryTelemetryWriter::AddMonitorPortOutput(int64_t subscriptionHandle, float value)
+{
+    if (frameType != FrameType::MonitorPortOutput)
+    {
+        throw std::logic_error("Wrong telemetry frame type.");
+    }
+    WriteI64(subscriptionHandle);
+    WriteFloat(value);
+    WriteU32(0);
+
+    IncrementCount();
+}
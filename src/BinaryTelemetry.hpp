@@ -0,0 +1,82 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace pipedal
+{
+    class VuUpdate;
+
+    /**
+     * @brief Writer for binary websocket telemetry frames.
+     *
+     * High-rate telemetry (VU updates and monitor port output) can be sent to clients that have
+     * negotiated it as binary websocket frames instead of JSON text, which saves formatting floats
+     * on the server and parsing them on the client. All values are little-endian, and 4-byte aligned.
+     *
+     *     uint32 frameType
+     *     uint32 count
+     *     count entries:
+     *        VuUpdate (32 bytes):          int64 instanceId, int32 sampleTime, uint32 flags,
+     *                                      float inputL, float inputR, float outputL, float outputR
+     *        MonitorPortOutput (16 bytes): int64 subscriptionHandle, float value, uint32 reserved
+     *
+     * VuUpdate flags: bit 0 = stereo input, bit 1 = stereo output, bit 2 = effect idle (input silent).
+     */
+    class BinaryTelemetryWriter
+    {
+    public:
+        enum class FrameType : uint32_t
+        {
+            VuUpdate = 1,
+            MonitorPortOutput = 2,
+        };
+        static constexpr size_t HEADER_SIZE = 8;
+        static constexpr size_t VU_UPDATE_SIZE = 32;
+        static constexpr size_t MONITOR_PORT_OUTPUT_SIZE = 16;
+
+        static constexpr uint32_t VU_FLAG_STEREO_INPUT = 1;
+        static constexpr uint32_t VU_FLAG_STEREO_OUTPUT = 2;
+        static constexpr uint32_t VU_FLAG_IDLE = 4;
+
+        BinaryTelemetryWriter(FrameType frameType);
+
+        void AddVuUpdate(const VuUpdate &vuUpdate);
+        void AddMonitorPortOutput(int64_t subscriptionHandle, float value);
+
+        FrameType GetFrameType() const { return frameType; }
+        uint32_t GetCount() const { return count; }
+        const std::vector<uint8_t> &GetFrame() const { return frame; }
+
+    private:
+        void WriteU32(uint32_t value);
+        void WriteI64(int64_t value);
+        void WriteFloat(float value);
+        void IncrementCount();
+
+        FrameType frameType;
+        uint32_t count = 0;
+        std::vector<uint8_t> frame;
+    };
+}
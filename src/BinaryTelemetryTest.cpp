@@ -0,0 +1,105 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "BinaryTelemetry.hpp"
+#include "VuUpdate.hpp"
+#include <cstring>
+
+using namespace pipedal;
+using namespace std;
+
+static uint32_t ReadU32(const std::vector<uint8_t> &frame, size_t offset)
+{
+    return (uint32_t)frame[offset] | ((uint32_t)frame[offset + 1] << 8) | ((uint32_t)frame[offset + 2] << 16) | ((uint32_t)frame[offset + 3] << 24);
+}
+static int64_t ReadI64(const std::vector<uint8_t> &frame, size_t offset)
+{
+    return (int64_t)((uint64_t)ReadU32(frame, offset) | ((uint64_t)ReadU32(frame, offset + 4) << 32));
+}
+static float ReadFloat(const std::vector<uint8_t> &frame, size_t offset)
+{
+    uint32_t v = ReadU32(frame, offset);
+    float result;
+    std::memcpy(&result, &v, sizeof(result));
+    return result;
+}
+
+TEST_CASE("BinaryTelemetry VU frame", "[binary_telemetry][Build][Dev]")
+{
+    BinaryTelemetryWriter writer(BinaryTelemetryWriter::FrameType::VuUpdate);
+    REQUIRE(writer.GetFrame().size() == BinaryTelemetryWriter::HEADER_SIZE);
+
+    VuUpdate mono;
+    mono.instanceId_ = 7;
+    mono.sampleTime_ = 1234;
+    mono.inputMaxValueL_ = 0.5f;
+    mono.outputMaxValueL_ = 0.25f;
+    mono.isIdle_ = true;
+
+    VuUpdate stereo;
+    stereo.instanceId_ = -2; // input/output pseudo-instances have negative ids.
+    stereo.isStereoInput_ = true;
+    stereo.isStereoOutput_ = true;
+    stereo.inputMaxValueL_ = 0.1f;
+    stereo.inputMaxValueR_ = 0.2f;
+    stereo.outputMaxValueL_ = 0.3f;
+    stereo.outputMaxValueR_ = 1.5f;
+
+    writer.AddVuUpdate(mono);
+    writer.AddVuUpdate(stereo);
+
+    const auto &frame = writer.GetFrame();
+    REQUIRE(frame.size() == BinaryTelemetryWriter::HEADER_SIZE + 2 * BinaryTelemetryWriter::VU_UPDATE_SIZE);
+    REQUIRE(ReadU32(frame, 0) == (uint32_t)BinaryTelemetryWriter::FrameType::VuUpdate);
+    REQUIRE(ReadU32(frame, 4) == 2);
+
+    size_t offset = BinaryTelemetryWriter::HEADER_SIZE;
+    REQUIRE(ReadI64(frame, offset) == 7);
+    REQUIRE(ReadU32(frame, offset + 8) == 1234);
+    REQUIRE(ReadU32(frame, offset + 12) == BinaryTelemetryWriter::VU_FLAG_IDLE);
+    REQUIRE(ReadFloat(frame, offset + 16) == 0.5f);
+    REQUIRE(ReadFloat(frame, offset + 24) == 0.25f);
+
+    offset += BinaryTelemetryWriter::VU_UPDATE_SIZE;
+    REQUIRE(ReadI64(frame, offset) == -2);
+    REQUIRE(ReadU32(frame, offset + 12) == (BinaryTelemetryWriter::VU_FLAG_STEREO_INPUT | BinaryTelemetryWriter::VU_FLAG_STEREO_OUTPUT));
+    REQUIRE(ReadFloat(frame, offset + 16) == 0.1f);
+    REQUIRE(ReadFloat(frame, offset + 20) == 0.2f);
+    REQUIRE(ReadFloat(frame, offset + 24) == 0.3f);
+    REQUIRE(ReadFloat(frame, offset + 28) == 1.5f);
+}
+
+TEST_CASE("BinaryTelemetry monitor port frame", "[binary_telemetry][Build][Dev]")
+{
+    BinaryTelemetryWriter writer(BinaryTelemetryWriter::FrameType::MonitorPortOutput);
+    writer.AddMonitorPortOutput(0x123456789LL, -3.75f);
+
+    const auto &frame = writer.GetFrame();
+    REQUIRE(frame.size() == BinaryTelemetryWriter::HEADER_SIZE + BinaryTelemetryWriter::MONITOR_PORT_OUTPUT_SIZE);
+    REQUIRE(ReadU32(frame, 0) == (uint32_t)BinaryTelemetryWriter::FrameType::MonitorPortOutput);
+    REQUIRE(ReadU32(frame, 4) == 1);
+    REQUIRE(ReadI64(frame, 8) == 0x123456789LL);
+    REQUIRE(ReadFloat(frame, 16) == -3.75f);
+
+    VuUpdate vuUpdate;
+    REQUIRE_THROWS(writer.AddVuUpdate(vuUpdate));
+}
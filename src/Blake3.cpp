@@ -0,0 +1,296 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "Blake3.hpp"
+#include "ss.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    constexpr uint32_t IV[8] = {
+        0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+        0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+    constexpr uint8_t MSG_PERMUTATION[16] = {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8};
+
+    constexpr uint32_t CHUNK_START = 1 << 0;
+    constexpr uint32_t CHUNK_END = 1 << 1;
+    constexpr uint32_t PARENT = 1 << 2;
+    constexpr uint32_t ROOT = 1 << 3;
+
+    inline uint32_t rotr(uint32_t value, int bits)
+    {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    inline void g(uint32_t *state, int a, int b, int c, int d, uint32_t mx, uint32_t my)
+    {
+        state[a] = state[a] + state[b] + mx;
+        state[d] = rotr(state[d] ^ state[a], 16);
+        state[c] = state[c] + state[d];
+        state[b] = rotr(state[b] ^ state[c], 12);
+        state[a] = state[a] + state[b] + my;
+        state[d] = rotr(state[d] ^ state[a], 8);
+        state[c] = state[c] + state[d];
+        state[b] = rotr(state[b] ^ state[c], 7);
+    }
+
+    inline void compressRound(uint32_t *state, const uint32_t *m)
+    {
+        g(state, 0, 4, 8, 12, m[0], m[1]);
+        g(state, 1, 5, 9, 13, m[2], m[3]);
+        g(state, 2, 6, 10, 14, m[4], m[5]);
+        g(state, 3, 7, 11, 15, m[6], m[7]);
+        g(state, 0, 5, 10, 15, m[8], m[9]);
+        g(state, 1, 6, 11, 12, m[10], m[11]);
+        g(state, 2, 7, 8, 13, m[12], m[13]);
+        g(state, 3, 4, 9, 14, m[14], m[15]);
+    }
+
+    void compress(
+        const uint32_t cv[8], const uint32_t blockWords[16],
+        uint64_t counter, uint32_t blockLen, uint32_t flags,
+        uint32_t out[16])
+    {
+        uint32_t state[16] = {
+            cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+            IV[0], IV[1], IV[2], IV[3],
+            (uint32_t)counter, (uint32_t)(counter >> 32), blockLen, flags};
+        uint32_t m[16];
+        memcpy(m, blockWords, sizeof(m));
+        for (int r = 0; r < 7; ++r)
+        {
+            compressRound(state, m);
+            if (r != 6)
+            {
+                uint32_t permuted[16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    permuted[i] = m[MSG_PERMUTATION[i]];
+                }
+                memcpy(m, permuted, sizeof(m));
+            }
+        }
+        for (int i = 0; i < 8; ++i)
+        {
+            out[i] = state[i] ^ state[i + 8];
+            out[i + 8] = state[i + 8] ^ cv[i];
+        }
+    }
+
+    void wordsFromBytes(const uint8_t *bytes, uint32_t words[16])
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            const uint8_t *p = bytes + 4 * i;
+            words[i] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+        }
+    }
+
+    // The input to a compression that hasn't been performed yet: either the last block of a chunk, or a parent node.
+    struct Output
+    {
+        uint32_t inputCv[8];
+        uint32_t blockWords[16];
+        uint64_t counter;
+        uint32_t blockLen;
+        uint32_t flags;
+
+        void ChainingValue(uint32_t cv[8]) const
+        {
+            uint32_t out[16];
+            compress(inputCv, blockWords, counter, blockLen, flags, out);
+            memcpy(cv, out, 8 * sizeof(uint32_t));
+        }
+        void RootBytes(uint8_t output[32]) const
+        {
+            uint32_t out[16];
+            compress(inputCv, blockWords, 0, blockLen, flags | ROOT, out);
+            for (int i = 0; i < 8; ++i)
+            {
+                output[4 * i] = (uint8_t)out[i];
+                output[4 * i + 1] = (uint8_t)(out[i] >> 8);
+                output[4 * i + 2] = (uint8_t)(out[i] >> 16);
+                output[4 * i + 3] = (uint8_t)(out[i] >> 24);
+            }
+        }
+    };
+
+    Output parentOutput(const uint32_t leftCv[8], const uint32_t rightCv[8])
+    {
+        Output output;
+        memcpy(output.inputCv, IV, sizeof(output.inputCv));
+        memcpy(output.blockWords, leftCv, 8 * sizeof(uint32_t));
+        memcpy(output.blockWords + 8, rightCv, 8 * sizeof(uint32_t));
+        output.counter = 0;
+        output.blockLen = 64;
+        output.flags = PARENT;
+        return output;
+    }
+}
+
+void Blake3Hasher::ChunkState::Reset(uint64_t chunkCounter)
+{
+    memcpy(cv, IV, sizeof(cv));
+    this->chunkCounter = chunkCounter;
+    memset(block, 0, sizeof(block));
+    blockLen = 0;
+    blocksCompressed = 0;
+}
+
+uint32_t Blake3Hasher::ChunkState::StartFlag() const
+{
+    return blocksCompressed == 0 ? CHUNK_START : 0;
+}
+
+void Blake3Hasher::ChunkState::Update(const uint8_t *data, size_t size)
+{
+    while (size != 0)
+    {
+        // a full block is only compressed once more input arrives, since the last block of a chunk gets CHUNK_END.
+        if (blockLen == BLOCK_LEN)
+        {
+            uint32_t blockWords[16];
+            wordsFromBytes(block, blockWords);
+            uint32_t out[16];
+            compress(cv, blockWords, chunkCounter, BLOCK_LEN, StartFlag(), out);
+            memcpy(cv, out, sizeof(cv));
+            ++blocksCompressed;
+            memset(block, 0, sizeof(block));
+            blockLen = 0;
+        }
+        size_t thisTime = std::min(BLOCK_LEN - blockLen, size);
+        memcpy(block + blockLen, data, thisTime);
+        blockLen += (uint8_t)thisTime;
+        data += thisTime;
+        size -= thisTime;
+    }
+}
+
+static Output ChunkOutput(const uint32_t cv[8], const uint8_t *block, uint8_t blockLen, uint64_t chunkCounter, uint32_t startFlag)
+{
+    Output output;
+    memcpy(output.inputCv, cv, sizeof(output.inputCv));
+    wordsFromBytes(block, output.blockWords);
+    output.counter = chunkCounter;
+    output.blockLen = blockLen;
+    output.flags = startFlag | CHUNK_END;
+    return output;
+}
+
+Blake3Hasher::Blake3Hasher()
+{
+    chunkState.Reset(0);
+}
+
+void Blake3Hasher::AddChunkChainingValue(const uint32_t cv[8], uint64_t totalChunks)
+{
+    // merge completed subtrees: each trailing zero bit in the chunk count closes one.
+    uint32_t newCv[8];
+    memcpy(newCv, cv, sizeof(newCv));
+    while ((totalChunks & 1) == 0)
+    {
+        --cvStackLength;
+        parentOutput(cvStack[cvStackLength], newCv).ChainingValue(newCv);
+        totalChunks >>= 1;
+    }
+    memcpy(cvStack[cvStackLength], newCv, sizeof(newCv));
+    ++cvStackLength;
+}
+
+void Blake3Hasher::Update(const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (size != 0)
+    {
+        if (chunkState.Length() == CHUNK_LEN)
+        {
+            uint32_t chunkCv[8];
+            ChunkOutput(chunkState.cv, chunkState.block, chunkState.blockLen, chunkState.chunkCounter, chunkState.StartFlag())
+                .ChainingValue(chunkCv);
+            uint64_t totalChunks = chunkState.chunkCounter + 1;
+            AddChunkChainingValue(chunkCv, totalChunks);
+            chunkState.Reset(totalChunks);
+        }
+        size_t thisTime = std::min(CHUNK_LEN - chunkState.Length(), size);
+        chunkState.Update(p, thisTime);
+        p += thisTime;
+        size -= thisTime;
+    }
+}
+
+void Blake3Hasher::Finalize(uint8_t output[32]) const
+{
+    Output node = ChunkOutput(chunkState.cv, chunkState.block, chunkState.blockLen, chunkState.chunkCounter, chunkState.StartFlag());
+    for (size_t i = cvStackLength; i != 0; --i)
+    {
+        uint32_t rightCv[8];
+        node.ChainingValue(rightCv);
+        node = parentOutput(cvStack[i - 1], rightCv);
+    }
+    node.RootBytes(output);
+}
+
+std::string Blake3Hasher::FinalizeHex() const
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    uint8_t hash[32];
+    Finalize(hash);
+    std::string result;
+    result.reserve(64);
+    for (uint8_t b : hash)
+    {
+        result.push_back(HEX_DIGITS[b >> 4]);
+        result.push_back(HEX_DIGITS[b & 0x0F]);
+    }
+    return result;
+}
+
+std::string Blake3Hasher::HashFile(const std::filesystem::path &path)
+{
+    std::ifstream f(path, std::ios_base::in | std::ios_base::binary);
+    if (!f.is_open())
+    {
+        throw std::runtime_error(SS("Can't read " << path << "."));
+    }
+    constexpr size_t BUFFER_SIZE = 256 * 1024;
+    std::vector<char> buffer(BUFFER_SIZE);
+    Blake3Hasher hasher;
+    while (f)
+    {
+        f.read(buffer.data(), (std::streamsize)BUFFER_SIZE);
+        std::streamsize nRead = f.gcount();
+        if (nRead <= 0)
+        {
+            break;
+        }
+        hasher.Update(buffer.data(), (size_t)nRead);
+    }
+    if (f.bad())
+    {
+        throw std::runtime_error(SS("Error reading " << path << "."));
+    }
+    return hasher.FinalizeHex();
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <filesystem>
+
+namespace pipedal
+{
+    /**
+     * @brief Incremental BLAKE3 hash (portable implementation, 256-bit output).
+     *
+     * Used to identify media files by content. Only the default (unkeyed) hash mode is supported.
+     */
+    class Blake3Hasher
+    {
+    public:
+        Blake3Hasher();
+
+        void Update(const void *data, size_t size);
+        void Finalize(uint8_t output[32]) const;
+        // The hash as 64 lower-case hex digits.
+        std::string FinalizeHex() const;
+
+        static std::string HashFile(const std::filesystem::path &path);
+
+    private:
+        static constexpr size_t BLOCK_LEN = 64;
+        static constexpr size_t CHUNK_LEN = 1024;
+        static constexpr size_t MAX_DEPTH = 54;
+
+        struct ChunkState
+        {
+            uint32_t cv[8];
+            uint64_t chunkCounter = 0;
+            uint8_t block[BLOCK_LEN];
+            uint8_t blockLen = 0;
+            uint8_t blocksCompressed = 0;
+
+            void Reset(uint64_t chunkCounter);
+            size_t Length() const { return BLOCK_LEN * blocksCompressed + blockLen; }
+            uint32_t StartFlag() const;
+            void Update(const uint8_t *data, size_t size);
+        };
+
+        void AddChunkChainingValue(const uint32_t cv[8], uint64_t totalChunks);
+
+        ChunkState chunkState;
+        uint32_t cvStack[MAX_DEPTH][8];
+        size_t cvStackLength = 0;
+    };
+}
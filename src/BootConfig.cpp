@@ -26,6 +26,9 @@
 #include "util.hpp"
 #include <set>
 #include "SystemConfigFile.hpp"
+#include "CpuList.hpp"
+#include <cctype>
+#include <cstring>
 
 namespace fs = std::filesystem;
 
@@ -152,6 +155,29 @@ BootConfig::BootConfig()
         {
             this->threadedIrqs = true;
         }
+        else if (arg.starts_with("isolcpus="))
+        {
+            // isolcpus=[flag,...,]cpu-list
+            std::vector<int> cpus;
+            try
+            {
+                for (const auto &item : split(arg.substr(strlen("isolcpus=")), ','))
+                {
+                    if (!item.empty() && std::isdigit((unsigned char)item[0]))
+                    {
+                        for (int cpu : ParseCpuList(item))
+                        {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                }
+            }
+            catch (const std::exception &)
+            {
+                cpus.clear();
+            }
+            this->isolatedCpus = FormatCpuList(cpus);
+        }
     }
     this->canSetThreadIrqs = this->kernelType == "PREEMPT" || this->kernelType == "PREEMPT_DYNAMIC";
 }
@@ -162,7 +188,7 @@ BootConfig::~BootConfig()
 }
 bool BootConfig::operator==(BootConfig &other) const
 {
-    return this->bootLoader == other.bootLoader && this->kernelType == other.kernelType && this->preemptMode == other.preemptMode && this->threadedIrqs == other.threadedIrqs;
+    return this->bootLoader == other.bootLoader && this->kernelType == other.kernelType && this->preemptMode == other.preemptMode && this->threadedIrqs == other.threadedIrqs && this->isolatedCpus == other.isolatedCpus;
 }
 
 bool BootConfig::CanWriteConfig()
@@ -347,7 +373,7 @@ std::string BootConfig::SetCmdlineArgs(const std::string &cmdLine)
     std::vector<std::string> newBootArgs;
     for (const auto &value : bootArgs)
     {
-        if (value != "threadirqs" && !value.starts_with("preempt="))
+        if (value != "threadirqs" && !value.starts_with("preempt=") && !value.starts_with("isolcpus=") && !value.starts_with("nohz_full="))
         {
             newBootArgs.push_back(value);
         }
@@ -360,6 +386,11 @@ std::string BootConfig::SetCmdlineArgs(const std::string &cmdLine)
     {
         newBootArgs.push_back(commandLineOption(this->dynamicScheduler));
     }
+    if (!this->isolatedCpus.empty())
+    {
+        newBootArgs.push_back("isolcpus=" + this->isolatedCpus);
+        newBootArgs.push_back("nohz_full=" + this->isolatedCpus);
+    }
     std::stringstream ss;
     bool firstArg = true;
     for (const std::string &arg : newBootArgs)
@@ -463,3 +494,12 @@ void BootConfig::ThreadedIrqs(bool value)
         this->changed = true;
     }
 }
+void BootConfig::IsolatedCpus(const std::string &cpuList)
+{
+    std::string value = FormatCpuList(ParseCpuList(cpuList));
+    if (value != isolatedCpus)
+    {
+        this->isolatedCpus = value;
+        this->changed = true;
+    }
+}
@@ -59,6 +59,11 @@ namespace pipedal {
         const DynamicSchedulerT DynamicScheduler() const { return dynamicScheduler; }
         void DynamicScheduler(DynamicSchedulerT value);
 
+        // Cpus reserved for realtime audio, as a cpu list (e.g. "2-3"); written as isolcpus= and nohz_full=.
+        // Empty if none. Throws std::invalid_argument for malformed cpu lists.
+        const std::string &IsolatedCpus() const { return isolatedCpus; }
+        void IsolatedCpus(const std::string &cpuList);
+
 
         bool  CanWriteConfig();
 
@@ -79,6 +84,7 @@ namespace pipedal {
         DynamicSchedulerT dynamicScheduler = DynamicSchedulerT::NotApplicable;
         bool canSetThreadIrqs = false;
         bool threadedIrqs = false;
+        std::string isolatedCpus;
 
     };
 };
\ No newline at end of file
@@ -0,0 +1,464 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "CacheRegistry.hpp"
+#include "Lv2Log.hpp"
+#include "SchedulerPriority.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <malloc.h>
+#include <poll.h>
+#include <sstream>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+namespace
+{
+    constexpr int POLL_INTERVAL_MS = 2000;
+    // Don't trim again until the previous trim has had a chance to take effect.
+    constexpr auto TRIM_COOLDOWN = std::chrono::seconds(10);
+
+    // stall time / window (us). Unprivileged triggers require a window that's a multiple of 2s.
+    constexpr const char *PSI_TRIGGER = "some 200000 2000000";
+
+    constexpr double PSI_MODERATE = 10.0;
+    constexpr double PSI_CRITICAL = 40.0;
+    constexpr double CGROUP_MODERATE = 0.90;
+    constexpr double CGROUP_CRITICAL = 0.97;
+    constexpr double AVAILABLE_MODERATE = 0.10;
+    constexpr double AVAILABLE_CRITICAL = 0.05;
+
+    std::string ReadFile(const std::string &path)
+    {
+        std::ifstream f(path);
+        if (!f)
+        {
+            return "";
+        }
+        std::stringstream s;
+        s << f.rdbuf();
+        return s.str();
+    }
+
+    const char *TrimLevelName(TrimLevel level)
+    {
+        switch (level)
+        {
+        case TrimLevel::Moderate:
+            return "moderate";
+        case TrimLevel::Critical:
+            return "critical";
+        default:
+            return "none";
+        }
+    }
+}
+
+CacheRegistry::Registration::~Registration()
+{
+    registry->Unregister(id);
+}
+
+CacheRegistry &CacheRegistry::GetInstance()
+{
+    static CacheRegistry instance;
+    return instance;
+}
+
+CacheRegistry::CacheRegistry()
+{
+}
+
+CacheRegistry::~CacheRegistry()
+{
+    StopMonitoring();
+}
+
+CacheRegistry::Registration::ptr CacheRegistry::Register(
+    const std::string &name,
+    CachePriority priority,
+    std::function<size_t()> getMemoryUse,
+    std::function<void(TrimLevel level)> trim)
+{
+    std::lock_guard lock(mutex);
+    Entry entry;
+    entry.id = nextId++;
+    entry.name = name;
+    entry.priority = priority;
+    entry.getMemoryUse = std::move(getMemoryUse);
+    entry.trim = std::move(trim);
+    entries.push_back(std::move(entry));
+    return Registration::ptr(new Registration(this, entries.back().id));
+}
+
+void CacheRegistry::Unregister(uint64_t id)
+{
+    // waits for an in-progress trim to complete.
+    std::lock_guard lock(mutex);
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->id == id)
+        {
+            entries.erase(it);
+            break;
+        }
+    }
+}
+
+size_t CacheRegistry::Trim(TrimLevel level)
+{
+    if (level == TrimLevel::None)
+    {
+        return 0;
+    }
+    size_t released = 0;
+    {
+        std::lock_guard lock(mutex);
+        std::vector<Entry *> sorted;
+        for (auto &entry : entries)
+        {
+            sorted.push_back(&entry);
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Entry *left, const Entry *right)
+                         { return left->priority < right->priority; });
+
+        size_t i = 0;
+        while (i < sorted.size())
+        {
+            CachePriority priority = sorted[i]->priority;
+            for (; i < sorted.size() && sorted[i]->priority == priority; ++i)
+            {
+                Entry *entry = sorted[i];
+                size_t before = entry->getMemoryUse();
+                entry->trim(level);
+                size_t after = entry->getMemoryUse();
+                if (before > after)
+                {
+                    released += before - after;
+                    Lv2Log::debug(SS("CacheRegistry: " << entry->name << " released " << (before - after) << " bytes."));
+                }
+            }
+            if (level == TrimLevel::Moderate && released != 0)
+            {
+                break;
+            }
+        }
+    }
+    // return freed heap pages to the system.
+    malloc_trim(0);
+    return released;
+}
+
+std::vector<CacheUsage> CacheRegistry::GetUsage()
+{
+    std::lock_guard lock(mutex);
+    std::vector<CacheUsage> result;
+    result.reserve(entries.size());
+    for (auto &entry : entries)
+    {
+        CacheUsage usage;
+        usage.name_ = entry.name;
+        usage.bytes_ = entry.getMemoryUse();
+        usage.priority_ = (int32_t)entry.priority;
+        result.push_back(std::move(usage));
+    }
+    return result;
+}
+
+double CacheRegistry::ParsePsiSomeAvg10(const std::string &text)
+{
+    // some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+    std::istringstream s(text);
+    std::string line;
+    while (std::getline(s, line))
+    {
+        if (line.starts_with("some "))
+        {
+            auto pos = line.find("avg10=");
+            if (pos == std::string::npos)
+            {
+                return -1;
+            }
+            try
+            {
+                return std::stod(line.substr(pos + 6));
+            }
+            catch (const std::exception &)
+            {
+                return -1;
+            }
+        }
+    }
+    return -1;
+}
+
+bool CacheRegistry::ParseMemInfo(const std::string &text, uint64_t *memTotal, uint64_t *memAvailable)
+{
+    bool hasTotal = false, hasAvailable = false;
+    std::istringstream s(text);
+    std::string line;
+    while (std::getline(s, line))
+    {
+        std::istringstream ls(line);
+        std::string key;
+        uint64_t value = 0;
+        std::string units;
+        if (!(ls >> key >> value))
+        {
+            continue;
+        }
+        ls >> units;
+        uint64_t multiplier = units == "kB" ? 1024 : 1;
+        if (key == "MemTotal:")
+        {
+            *memTotal = value * multiplier;
+            hasTotal = true;
+        }
+        else if (key == "MemAvailable:")
+        {
+            *memAvailable = value * multiplier;
+            hasAvailable = true;
+        }
+    }
+    return hasTotal && hasAvailable;
+}
+
+std::string CacheRegistry::ParseCgroupPath(const std::string &text)
+{
+    std::istringstream s(text);
+    std::string line;
+    while (std::getline(s, line))
+    {
+        if (line.starts_with("0::"))
+        {
+            return line.substr(3);
+        }
+    }
+    return "";
+}
+
+uint64_t CacheRegistry::ParseCgroupMemoryMax(const std::string &text)
+{
+    if (text.starts_with("max"))
+    {
+        return 0;
+    }
+    try
+    {
+        return std::stoull(text);
+    }
+    catch (const std::exception &)
+    {
+        return 0;
+    }
+}
+
+CacheRegistry::MemoryPressure CacheRegistry::ReadMemoryPressure()
+{
+    MemoryPressure result;
+    result.psiSomeAvg10 = ParsePsiSomeAvg10(ReadFile("/proc/pressure/memory"));
+    ParseMemInfo(ReadFile("/proc/meminfo"), &result.memTotal, &result.memAvailable);
+
+    std::string cgroupPath = ParseCgroupPath(ReadFile("/proc/self/cgroup"));
+    if (!cgroupPath.empty())
+    {
+        std::string cgroupDirectory = "/sys/fs/cgroup" + cgroupPath;
+        result.cgroupMax = ParseCgroupMemoryMax(ReadFile(cgroupDirectory + "/memory.max"));
+        if (result.cgroupMax != 0)
+        {
+            std::string current = ReadFile(cgroupDirectory + "/memory.current");
+            try
+            {
+                result.cgroupCurrent = current.empty() ? 0 : std::stoull(current);
+            }
+            catch (const std::exception &)
+            {
+                result.cgroupCurrent = 0;
+            }
+        }
+    }
+    return result;
+}
+
+TrimLevel CacheRegistry::GetTrimLevel(const MemoryPressure &pressure)
+{
+    TrimLevel result = TrimLevel::None;
+    auto raise = [&result](TrimLevel level)
+    {
+        if (level > result)
+        {
+            result = level;
+        }
+    };
+    if (pressure.psiSomeAvg10 >= 0)
+    {
+        if (pressure.psiSomeAvg10 > PSI_CRITICAL)
+        {
+            raise(TrimLevel::Critical);
+        }
+        else if (pressure.psiSomeAvg10 > PSI_MODERATE)
+        {
+            raise(TrimLevel::Moderate);
+        }
+    }
+    if (pressure.cgroupMax != 0)
+    {
+        double used = (double)pressure.cgroupCurrent / (double)pressure.cgroupMax;
+        if (used > CGROUP_CRITICAL)
+        {
+            raise(TrimLevel::Critical);
+        }
+        else if (used > CGROUP_MODERATE)
+        {
+            raise(TrimLevel::Moderate);
+        }
+    }
+    if (pressure.memTotal != 0)
+    {
+        double available = (double)pressure.memAvailable / (double)pressure.memTotal;
+        if (available < AVAILABLE_CRITICAL)
+        {
+            raise(TrimLevel::Critical);
+        }
+        else if (available < AVAILABLE_MODERATE)
+        {
+            raise(TrimLevel::Moderate);
+        }
+    }
+    return result;
+}
+
+void CacheRegistry::StartMonitoring()
+{
+    std::lock_guard lock(monitorMutex);
+    if (monitorThread)
+    {
+        return;
+    }
+    stopEventFd = eventfd(0, EFD_CLOEXEC);
+    if (stopEventFd == -1)
+    {
+        Lv2Log::error("CacheRegistry: Can't create eventfd.");
+        return;
+    }
+    monitorThread = std::make_unique<std::thread>([this]()
+                                                  { MonitorThreadProc(); });
+}
+
+void CacheRegistry::StopMonitoring()
+{
+    std::lock_guard lock(monitorMutex);
+    if (!monitorThread)
+    {
+        return;
+    }
+    uint64_t value = 1;
+    if (write(stopEventFd, &value, sizeof(value)) != sizeof(value))
+    {
+        Lv2Log::error("CacheRegistry: Can't signal monitor thread.");
+    }
+    monitorThread->join();
+    monitorThread = nullptr;
+    close(stopEventFd);
+    stopEventFd = -1;
+}
+
+void CacheRegistry::MonitorThreadProc()
+{
+    SetThreadName("cacheMonitor");
+    SetThreadPriority(SchedulerPriority::Background);
+
+    // A PSI trigger wakes us as soon as memory stalls exceed the threshold. Without one (PSI disabled,
+    // as it is by default on Raspberry Pi OS kernels) we fall back to polling.
+    int psiFd = open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (psiFd != -1)
+    {
+        if (write(psiFd, PSI_TRIGGER, strlen(PSI_TRIGGER) + 1) < 0)
+        {
+            close(psiFd);
+            psiFd = -1;
+        }
+    }
+    Lv2Log::debug(psiFd != -1 ? "CacheRegistry: Monitoring memory pressure (PSI trigger)." : "CacheRegistry: Monitoring memory pressure (polled).");
+
+    struct pollfd pfds[2];
+    pfds[0].fd = stopEventFd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = psiFd;
+    pfds[1].events = POLLPRI;
+    nfds_t nfds = psiFd != -1 ? 2 : 1;
+
+    auto lastTrimTime = std::chrono::steady_clock::time_point();
+    while (true)
+    {
+        pfds[0].revents = 0;
+        pfds[1].revents = 0;
+        int ret = poll(pfds, nfds, POLL_INTERVAL_MS);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            Lv2Log::error("CacheRegistry: Poll error.");
+            break;
+        }
+        if (pfds[0].revents & POLLIN)
+        {
+            break;
+        }
+        if (nfds == 2 && (pfds[1].revents & POLLERR))
+        {
+            // the PSI trigger has gone away. Keep polling.
+            close(psiFd);
+            psiFd = -1;
+            nfds = 1;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastTrimTime < TRIM_COOLDOWN)
+        {
+            continue;
+        }
+        TrimLevel level = GetTrimLevel(ReadMemoryPressure());
+        if (level != TrimLevel::None)
+        {
+            size_t released = Trim(level);
+            Lv2Log::info(SS("Memory pressure (" << TrimLevelName(level) << "). Caches released " << released << " bytes."));
+            lastTrimTime = now;
+        }
+    }
+    if (psiFd != -1)
+    {
+        close(psiFd);
+    }
+}
+
+JSON_MAP_BEGIN(CacheUsage)
+JSON_MAP_REFERENCE(CacheUsage, name)
+JSON_MAP_REFERENCE(CacheUsage, bytes)
+JSON_MAP_REFERENCE(CacheUsage, priority)
+JSON_MAP_END()
@@ -0,0 +1,163 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "json.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    // Caches with lower priorities are trimmed first.
+    enum class CachePriority
+    {
+        Discardable = 0, // cheap to reload (e.g. static web files).
+        Regenerable = 1, // costs some CPU to rebuild (e.g. generated templates).
+        Expensive = 2,   // slow to rebuild, and directly affects preset-switch latency (preloaded pedalboards).
+    };
+
+    enum class TrimLevel
+    {
+        None,
+        Moderate, // release memory that is least likely to be needed.
+        Critical, // release everything that can be released.
+    };
+
+    class CacheUsage
+    {
+    public:
+        std::string name_;
+        uint64_t bytes_ = 0;
+        int32_t priority_ = 0;
+
+        DECLARE_JSON_MAP(CacheUsage);
+    };
+
+    /**
+     * @brief Process-wide registry of in-memory caches that can be shrunk when the system runs short of memory.
+     *
+     * A monitor thread watches memory pressure (PSI in /proc/pressure/memory, the service's cgroup
+     * memory.max limit, and MemAvailable as a fallback on kernels without PSI), and asks registered caches
+     * to trim themselves, lowest priority first.
+     *
+     * Only caches whose contents can be rebuilt on demand should register. Memory the audio thread
+     * depends on (the active pedalboard, realtime buffers) must never be registered.
+     *
+     * Trim and memory-use callbacks are called with the registry lock held, and may be called from the
+     * monitor thread or a socket thread. They must not call back into the registry, or take locks that
+     * are held while a cache is being registered or unregistered.
+     */
+    class CacheRegistry
+    {
+    public:
+        class Registration
+        {
+        public:
+            using ptr = std::unique_ptr<Registration>;
+            ~Registration();
+            Registration(const Registration &) = delete;
+            Registration &operator=(const Registration &) = delete;
+
+        private:
+            friend class CacheRegistry;
+            Registration(CacheRegistry *registry, uint64_t id) : registry(registry), id(id) {}
+            CacheRegistry *registry;
+            uint64_t id;
+        };
+
+        struct MemoryPressure
+        {
+            double psiSomeAvg10 = -1;  // percent. -1 if PSI isn't available.
+            uint64_t cgroupCurrent = 0;
+            uint64_t cgroupMax = 0;    // 0 if the cgroup has no memory limit.
+            uint64_t memTotal = 0;
+            uint64_t memAvailable = 0;
+        };
+
+        static CacheRegistry &GetInstance();
+
+        CacheRegistry();
+        ~CacheRegistry();
+        CacheRegistry(const CacheRegistry &) = delete;
+        CacheRegistry &operator=(const CacheRegistry &) = delete;
+
+        // The cache is unregistered when the returned registration is destroyed. Destroy it before the cache.
+        Registration::ptr Register(
+            const std::string &name,
+            CachePriority priority,
+            std::function<size_t()> getMemoryUse,
+            std::function<void(TrimLevel level)> trim);
+
+        /**
+         * @brief Ask registered caches to release memory.
+         *
+         * Moderate trims stop after the first priority group that released anything. Critical trims
+         * trim every cache.
+         * @return The (approximate) number of bytes released.
+         */
+        size_t Trim(TrimLevel level);
+
+        std::vector<CacheUsage> GetUsage();
+
+        void StartMonitoring();
+        void StopMonitoring();
+
+        static MemoryPressure ReadMemoryPressure();
+        static TrimLevel GetTrimLevel(const MemoryPressure &pressure);
+
+        // Parsers for /proc and /sys files, exposed for testing.
+
+        // The "some avg10" value of /proc/pressure/memory, or -1.
+        static double ParsePsiSomeAvg10(const std::string &text);
+        // MemTotal and MemAvailable from /proc/meminfo, in bytes.
+        static bool ParseMemInfo(const std::string &text, uint64_t *memTotal, uint64_t *memAvailable);
+        // The cgroup v2 path from /proc/self/cgroup (the "0::" line), or empty.
+        static std::string ParseCgroupPath(const std::string &text);
+        // The contents of memory.max. 0 for "max" (no limit).
+        static uint64_t ParseCgroupMemoryMax(const std::string &text);
+
+    private:
+        struct Entry
+        {
+            uint64_t id = 0;
+            std::string name;
+            CachePriority priority = CachePriority::Discardable;
+            std::function<size_t()> getMemoryUse;
+            std::function<void(TrimLevel level)> trim;
+        };
+
+        void Unregister(uint64_t id);
+        void MonitorThreadProc();
+
+        std::mutex mutex;
+        uint64_t nextId = 1;
+        std::vector<Entry> entries;
+
+        std::mutex monitorMutex;
+        int stopEventFd = -1;
+        std::unique_ptr<std::thread> monitorThread;
+    };
+}
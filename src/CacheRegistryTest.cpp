@@ -0,0 +1,111 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "CacheRegistry.hpp"
+
+using namespace pipedal;
+using namespace std;
+
+TEST_CASE("CacheRegistry parsers", "[cache_registry][Build][Dev]")
+{
+    REQUIRE(CacheRegistry::ParsePsiSomeAvg10(
+                "some avg10=12.50 avg60=3.00 avg300=1.00 total=12345\n"
+                "full avg10=2.00 avg60=0.00 avg300=0.00 total=100\n") == 12.5);
+    REQUIRE(CacheRegistry::ParsePsiSomeAvg10("") == -1);
+
+    uint64_t memTotal = 0, memAvailable = 0;
+    REQUIRE(CacheRegistry::ParseMemInfo(
+        "MemTotal:        3884136 kB\n"
+        "MemFree:          987652 kB\n"
+        "MemAvailable:    2000000 kB\n",
+        &memTotal, &memAvailable));
+    REQUIRE(memTotal == 3884136ull * 1024);
+    REQUIRE(memAvailable == 2000000ull * 1024);
+    REQUIRE(!CacheRegistry::ParseMemInfo("MemTotal: 1 kB\n", &memTotal, &memAvailable));
+
+    REQUIRE(CacheRegistry::ParseCgroupPath("0::/system.slice/pipedald.service\n") == "/system.slice/pipedald.service");
+    REQUIRE(CacheRegistry::ParseCgroupPath("1:name=systemd:/\n") == "");
+
+    REQUIRE(CacheRegistry::ParseCgroupMemoryMax("max\n") == 0);
+    REQUIRE(CacheRegistry::ParseCgroupMemoryMax("536870912\n") == 536870912);
+}
+
+TEST_CASE("CacheRegistry trim levels", "[cache_registry][Build][Dev]")
+{
+    CacheRegistry::MemoryPressure pressure;
+    pressure.memTotal = 1000;
+    pressure.memAvailable = 500;
+    REQUIRE(CacheRegistry::GetTrimLevel(pressure) == TrimLevel::None);
+
+    pressure.psiSomeAvg10 = 20;
+    REQUIRE(CacheRegistry::GetTrimLevel(pressure) == TrimLevel::Moderate);
+    pressure.psiSomeAvg10 = 0;
+
+    pressure.cgroupMax = 1000;
+    pressure.cgroupCurrent = 980;
+    REQUIRE(CacheRegistry::GetTrimLevel(pressure) == TrimLevel::Critical);
+    pressure.cgroupMax = 0;
+
+    pressure.memAvailable = 80;
+    REQUIRE(CacheRegistry::GetTrimLevel(pressure) == TrimLevel::Moderate);
+    pressure.memAvailable = 20;
+    REQUIRE(CacheRegistry::GetTrimLevel(pressure) == TrimLevel::Critical);
+}
+
+TEST_CASE("CacheRegistry trim order", "[cache_registry][Build][Dev]")
+{
+    CacheRegistry registry;
+
+    size_t discardable = 100, regenerable = 200, expensive = 400;
+    std::vector<std::string> trimmed;
+
+    auto r1 = registry.Register(
+        "expensive", CachePriority::Expensive,
+        [&]() { return expensive; },
+        [&](TrimLevel) { trimmed.push_back("expensive"); expensive = 0; });
+    auto r2 = registry.Register(
+        "discardable", CachePriority::Discardable,
+        [&]() { return discardable; },
+        [&](TrimLevel) { trimmed.push_back("discardable"); discardable = 0; });
+    {
+        auto r3 = registry.Register(
+            "regenerable", CachePriority::Regenerable,
+            [&]() { return regenerable; },
+            [&](TrimLevel) { trimmed.push_back("regenerable"); regenerable = 0; });
+
+        auto usage = registry.GetUsage();
+        REQUIRE(usage.size() == 3);
+
+        // moderate trims stop after the first priority group that releases memory.
+        REQUIRE(registry.Trim(TrimLevel::Moderate) == 100);
+        REQUIRE(trimmed == std::vector<std::string>{"discardable"});
+
+        REQUIRE(registry.Trim(TrimLevel::Moderate) == 200);
+        REQUIRE(trimmed.back() == "regenerable");
+        regenerable = 200;
+    }
+    // unregistered caches aren't trimmed.
+    REQUIRE(registry.GetUsage().size() == 2);
+    trimmed.clear();
+    discardable = 100;
+    REQUIRE(registry.Trim(TrimLevel::Critical) == 500);
+    REQUIRE(trimmed == std::vector<std::string>{"discardable", "expensive"});
+}
@@ -1513,14 +1513,12 @@ void ListValidCountryCodes()
         }
 
         auto collator = Locale::GetInstance()->GetCollator();
-        auto compare = [&collator](
-                           pair &left,
-                           pair &right)
-        {
-            return collator->Compare(
-                       left.second, right.second) < 0;
-        };
-        std::sort(list.begin(), list.end(), compare);
+        collator->Sort(
+            list,
+            [](const pair &entry) -> const std::string &
+            {
+                return entry.second;
+            });
 
         for (const auto &entry : list)
         {
@@ -0,0 +1,95 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "ControlHandles.hpp"
+#include "Lv2Pedalboard.hpp"
+
+using namespace pipedal;
+
+int32_t ControlHandleAllocator::GetHandle(int64_t instanceId, const std::string &symbol)
+{
+    auto key = std::make_pair(instanceId, symbol);
+    auto iter = handles.find(key);
+    if (iter != handles.end())
+    {
+        return iter->second;
+    }
+    int32_t handle = (int32_t)handles.size();
+    handles[key] = handle;
+    return handle;
+}
+
+ControlHandleTable::ControlHandleTable(
+    int64_t version, int64_t epochVersion,
+    Pedalboard &pedalboard, const std::shared_ptr<Lv2Pedalboard> &lv2Pedalboard,
+    ControlHandleAllocator &allocator)
+    : version(version), epochVersion(epochVersion), lv2Pedalboard(lv2Pedalboard)
+{
+    for (PedalboardItem *item : pedalboard.GetAllPlugins())
+    {
+        int effectIndex = lv2Pedalboard ? lv2Pedalboard->GetIndexOfInstanceId(item->instanceId()) : -1;
+        for (const ControlValue &controlValue : item->controlValues())
+        {
+            int controlIndex = -1;
+            if (effectIndex != -1)
+            {
+                controlIndex = lv2Pedalboard->GetControlIndex(item->instanceId(), controlValue.key());
+            }
+            size_t handle = (size_t)allocator.GetHandle(item->instanceId(), controlValue.key());
+            if (handle >= entries.size())
+            {
+                entries.resize(handle + 1, Entry{-1, "", -1, -1});
+            }
+            entries[handle] = Entry{item->instanceId(), controlValue.key(), effectIndex, controlIndex};
+        }
+    }
+}
+
+ControlHandles ControlHandleTable::GetHandles() const
+{
+    ControlHandles result;
+    result.version_ = version;
+    result.handles_.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].instanceId == -1)
+        {
+            continue;
+        }
+        ControlHandle handle;
+        handle.instanceId_ = entries[i].instanceId;
+        handle.symbol_ = entries[i].symbol;
+        handle.handle_ = (int32_t)i;
+        result.handles_.push_back(std::move(handle));
+    }
+    return result;
+}
+
+JSON_MAP_BEGIN(ControlHandle)
+    JSON_MAP_REFERENCE(ControlHandle, instanceId)
+    JSON_MAP_REFERENCE(ControlHandle, symbol)
+    JSON_MAP_REFERENCE(ControlHandle, handle)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(ControlHandles)
+    JSON_MAP_REFERENCE(ControlHandles, version)
+    JSON_MAP_REFERENCE(ControlHandles, handles)
+JSON_MAP_END()
@@ -0,0 +1,115 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Pedalboard.hpp"
+#include "json.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pipedal
+{
+    class Lv2Pedalboard;
+
+    // A numeric handle for an (instanceId, symbol) pair, so that clients can send
+    // setControlByHandle/previewControlByHandle messages without symbol strings.
+    class ControlHandle
+    {
+    public:
+        int64_t instanceId_ = -1;
+        std::string symbol_;
+        int32_t handle_ = -1;
+
+        DECLARE_JSON_MAP(ControlHandle);
+    };
+
+    // Handles are stable: a handle always refers to the same (instanceId, symbol) pair, so a handle issued for an
+    // earlier pedalboard version stays valid for as long as the control exists. Clients should fetch handles
+    // again after onPedalboardChanged or onPedalboardPatched, to pick up new controls.
+    class ControlHandles
+    {
+    public:
+        int64_t version_ = -1;
+        std::vector<ControlHandle> handles_;
+
+        DECLARE_JSON_MAP(ControlHandles);
+    };
+
+    // Assigns handles to (instanceId, symbol) pairs. Handles are never reused for a different pair
+    // until the allocator is cleared.
+    class ControlHandleAllocator
+    {
+    public:
+        // Clear the allocator (invalidating all issued handles) once it holds this many handles.
+        static constexpr size_t MAX_HANDLES = 16384;
+
+        int32_t GetHandle(int64_t instanceId, const std::string &symbol);
+        size_t Size() const { return handles.size(); }
+        void Clear() { handles.clear(); }
+
+    private:
+        std::map<std::pair<int64_t, std::string>, int32_t> handles;
+    };
+
+    // Host-side resolution of handles, built once per pedalboard version. Immutable once built.
+    class ControlHandleTable
+    {
+    public:
+        struct Entry
+        {
+            int64_t instanceId;
+            std::string symbol;
+            // indices into lv2Pedalboard, or -1 if the control doesn't map onto a realtime effect control.
+            int effectIndex;
+            int controlIndex;
+        };
+
+        // Handles issued for versions before epochVersion (when the allocator was last cleared) are rejected.
+        ControlHandleTable(
+            int64_t version, int64_t epochVersion,
+            Pedalboard &pedalboard, const std::shared_ptr<Lv2Pedalboard> &lv2Pedalboard,
+            ControlHandleAllocator &allocator);
+
+        int64_t GetVersion() const { return version; }
+        const std::shared_ptr<Lv2Pedalboard> &GetLv2Pedalboard() const { return lv2Pedalboard; }
+
+        // nullptr if the handle was issued before the allocator was cleared, or its control no longer exists.
+        const Entry *Find(int64_t version, int32_t handle) const
+        {
+            if (version < epochVersion || version > this->version || handle < 0 || (size_t)handle >= entries.size())
+            {
+                return nullptr;
+            }
+            const Entry *entry = &entries[handle];
+            return entry->instanceId == -1 ? nullptr : entry;
+        }
+        ControlHandles GetHandles() const;
+
+    private:
+        int64_t version;
+        int64_t epochVersion;
+        std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+        std::vector<Entry> entries; // indexed by handle. instanceId is -1 for handles of controls that no longer exist.
+    };
+}
@@ -0,0 +1,88 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ControlHandles.hpp"
+
+using namespace pipedal;
+
+static PedalboardItem MakeItem(Pedalboard &pedalboard, const std::vector<std::string> &symbols)
+{
+    PedalboardItem item = pedalboard.MakeEmptyItem();
+    for (const auto &symbol : symbols)
+    {
+        item.controlValues().push_back(ControlValue(symbol, 0.5f));
+    }
+    return item;
+}
+
+TEST_CASE("ControlHandles", "[control_handles][Build][Dev]")
+{
+    Pedalboard pedalboard = Pedalboard::MakeDefault();
+    pedalboard.items().clear();
+    pedalboard.items().push_back(MakeItem(pedalboard, {"gain", "tone"}));
+    pedalboard.items().push_back(MakeItem(pedalboard, {"level"}));
+    int64_t id0 = pedalboard.items()[0].instanceId();
+    int64_t id1 = pedalboard.items()[1].instanceId();
+
+    ControlHandleAllocator allocator;
+    ControlHandleTable table1(1, 0, pedalboard, nullptr, allocator);
+    ControlHandles handles = table1.GetHandles();
+    REQUIRE(handles.version_ == 1);
+    REQUIRE(handles.handles_.size() == 3);
+
+    int32_t toneHandle = -1, levelHandle = -1;
+    for (const auto &handle : handles.handles_)
+    {
+        if (handle.instanceId_ == id0 && handle.symbol_ == "tone")
+            toneHandle = handle.handle_;
+        if (handle.instanceId_ == id1 && handle.symbol_ == "level")
+            levelHandle = handle.handle_;
+    }
+    REQUIRE(toneHandle != -1);
+    REQUIRE(levelHandle != -1);
+    const ControlHandleTable::Entry *entry = table1.Find(1, toneHandle);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->instanceId == id0);
+    REQUIRE(entry->symbol == "tone");
+    REQUIRE(entry->effectIndex == -1); // no audio pedalboard.
+
+    REQUIRE(table1.Find(2, toneHandle) == nullptr); // from the future.
+    REQUIRE(table1.Find(1, 1000) == nullptr);
+    REQUIRE(table1.Find(1, -1) == nullptr);
+
+    // Remove the first item: handles of the remaining controls don't change, and old handles
+    // for controls that still exist stay valid.
+    pedalboard.items().erase(pedalboard.items().begin());
+    ControlHandleTable table2(2, 0, pedalboard, nullptr, allocator);
+    REQUIRE(table2.GetHandles().handles_.size() == 1);
+    REQUIRE(table2.Find(1, toneHandle) == nullptr);
+    entry = table2.Find(1, levelHandle);
+    REQUIRE(entry != nullptr);
+    REQUIRE(entry->instanceId == id1);
+    REQUIRE(entry->symbol == "level");
+
+    // Handles issued before the allocator was cleared are rejected.
+    allocator.Clear();
+    ControlHandleTable table3(3, 3, pedalboard, nullptr, allocator);
+    REQUIRE(table3.Find(2, levelHandle) == nullptr);
+    REQUIRE(table3.Find(3, table3.GetHandles().handles_[0].handle_) != nullptr);
+}
@@ -0,0 +1,106 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "CpuFrequencyPolicy.hpp"
+#include "CpuTemperatureMonitor.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <iomanip>
+
+using namespace pipedal;
+
+CpuFrequencyPolicy::CpuFrequencyPolicy(const std::vector<uint64_t> &frequencies)
+    : CpuFrequencyPolicy(frequencies, Settings())
+{
+}
+
+CpuFrequencyPolicy::CpuFrequencyPolicy(const std::vector<uint64_t> &frequencies, const Settings &settings)
+    : settings(settings), frequencies(frequencies)
+{
+    std::sort(this->frequencies.begin(), this->frequencies.end());
+    if (this->frequencies.empty())
+    {
+        this->frequencies.push_back(0);
+    }
+}
+
+uint64_t CpuFrequencyPolicy::GetMinimumFrequency() const
+{
+    return frequencies[level];
+}
+
+CpuFrequencyPolicy::Decision CpuFrequencyPolicy::SetLevel(size_t level, std::string reason)
+{
+    Decision result;
+    result.changed = level != this->level;
+    this->level = level;
+    result.minimumFrequency = frequencies[level];
+    result.reason = SS(reason << " Minimum frequency: " << (result.minimumFrequency / 1000) << " MHz.");
+    return result;
+}
+
+CpuFrequencyPolicy::Decision CpuFrequencyPolicy::Update(std::optional<float> headroomPercent, float temperatureC)
+{
+    const size_t maxLevel = frequencies.size() - 1;
+    bool hasTemperature = temperatureC > CpuTemperatureMonitor::INVALID_TEMPERATURE;
+    std::string headroomText = headroomPercent ? SS(std::fixed << std::setprecision(1) << *headroomPercent << "%") : std::string("n/a");
+    std::string temperatureText = hasTemperature ? SS(std::fixed << std::setprecision(1) << temperatureC << "C") : std::string("n/a");
+    std::string conditions = SS("(headroom " << headroomText << ", temperature " << temperatureText << ")");
+
+    // temperature takes priority over load.
+    if (hasTemperature && temperatureC >= settings.throttleTemperatureC - settings.temperatureMarginC)
+    {
+        idleCount = 0;
+        if (level > 0)
+        {
+            return SetLevel(level - 1, SS("Approaching the throttling temperature; lowering. " << conditions));
+        }
+        return SetLevel(level, SS("Approaching the throttling temperature; at the lowest setting. " << conditions));
+    }
+    bool canRaise = !hasTemperature || temperatureC < settings.throttleTemperatureC - 2 * settings.temperatureMarginC;
+
+    if (headroomPercent && *headroomPercent < settings.lowHeadroomPercent)
+    {
+        idleCount = 0;
+        if (!canRaise)
+        {
+            return SetLevel(level, SS("Low headroom, but too warm to raise. " << conditions));
+        }
+        if (*headroomPercent < settings.criticalHeadroomPercent)
+        {
+            return SetLevel(maxLevel, SS("Critical headroom; raising to maximum. " << conditions));
+        }
+        return SetLevel(std::min(level + 1, maxLevel), SS("Low headroom; raising. " << conditions));
+    }
+    if (!headroomPercent || *headroomPercent > settings.idleHeadroomPercent)
+    {
+        if (++idleCount >= settings.idleUpdates)
+        {
+            idleCount = 0;
+            if (level > 0)
+            {
+                return SetLevel(level - 1, SS("Idle; relaxing. " << conditions));
+            }
+        }
+        return SetLevel(level, SS("Idle; holding. " << conditions));
+    }
+    idleCount = 0;
+    return SetLevel(level, SS("Holding. " << conditions));
+}
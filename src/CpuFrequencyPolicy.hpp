@@ -0,0 +1,81 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Chooses a minimum CPU frequency for the "auto" governor setting.
+     *
+     * ondemand reacts to load too slowly when a big preset loads; performance overheats Pis in
+     * small enclosures. The policy raises the minimum frequency when DSP headroom gets low, relaxes
+     * it after a sustained period of plenty of headroom, and backs off when the CPU temperature
+     * approaches the throttling point, no matter what the load is.
+     *
+     * Call Update() at regular intervals. Not thread-safe.
+     */
+    class CpuFrequencyPolicy
+    {
+    public:
+        class Settings
+        {
+        public:
+            float lowHeadroomPercent = 35;        // raise the minimum frequency below this.
+            float criticalHeadroomPercent = 15;   // go straight to the maximum frequency below this.
+            float idleHeadroomPercent = 65;       // relax when headroom has been above this...
+            int idleUpdates = 5;                  // ...for this many updates.
+            float throttleTemperatureC = 80;      // Raspberry Pi firmware throttles at 80C.
+            float temperatureMarginC = 5;         // back off within this distance of the throttle point,
+                                                  // and don't raise within twice this distance.
+        };
+
+        class Decision
+        {
+        public:
+            uint64_t minimumFrequency = 0; // kHz.
+            bool changed = false;
+            std::string reason;
+        };
+
+        // frequencies: available frequencies, in kHz.
+        CpuFrequencyPolicy(const std::vector<uint64_t> &frequencies);
+        CpuFrequencyPolicy(const std::vector<uint64_t> &frequencies, const Settings &settings);
+
+        // headroomPercent: p99.9 headroom since the last update; nullopt if audio isn't running.
+        // temperatureC: CpuTemperatureMonitor::INVALID_TEMPERATURE if not available.
+        Decision Update(std::optional<float> headroomPercent, float temperatureC);
+
+        uint64_t GetMinimumFrequency() const;
+
+    private:
+        Decision SetLevel(size_t level, std::string reason);
+
+        Settings settings;
+        std::vector<uint64_t> frequencies;
+        size_t level = 0;
+        int idleCount = 0;
+    };
+}
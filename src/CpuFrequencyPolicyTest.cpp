@@ -0,0 +1,84 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "CpuFrequencyPolicy.hpp"
+#include "CpuTemperatureMonitor.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("Cpu frequency policy", "[cpu_frequency_policy][Build][Dev]")
+{
+    std::vector<uint64_t> frequencies{1800000, 600000, 1200000, 1500000};
+    CpuFrequencyPolicy policy(frequencies);
+    const float COOL = 50;
+    REQUIRE(policy.GetMinimumFrequency() == 600000);
+
+    // raise one step at a time when headroom is low.
+    auto decision = policy.Update(30.0f, COOL);
+    REQUIRE(decision.changed);
+    REQUIRE(decision.minimumFrequency == 1200000);
+    REQUIRE(!policy.Update(50.0f, COOL).changed);
+
+    // straight to the top when headroom is critical.
+    decision = policy.Update(5.0f, COOL);
+    REQUIRE(decision.minimumFrequency == 1800000);
+
+    // relax only after a sustained idle period.
+    for (int i = 0; i < 4; ++i)
+    {
+        REQUIRE(!policy.Update(90.0f, COOL).changed);
+    }
+    decision = policy.Update(90.0f, COOL);
+    REQUIRE(decision.changed);
+    REQUIRE(decision.minimumFrequency == 1500000);
+
+    // audio not running counts as idle.
+    for (int i = 0; i < 5; ++i)
+    {
+        decision = policy.Update(std::nullopt, CpuTemperatureMonitor::INVALID_TEMPERATURE);
+    }
+    REQUIRE(decision.minimumFrequency == 1200000);
+}
+
+TEST_CASE("Cpu frequency policy temperature", "[cpu_frequency_policy][Build][Dev]")
+{
+    CpuFrequencyPolicy policy({600000, 1200000, 1500000, 1800000});
+    policy.Update(5.0f, 50);
+    REQUIRE(policy.GetMinimumFrequency() == 1800000);
+
+    // back off near the throttling point, even with low headroom.
+    auto decision = policy.Update(5.0f, 76);
+    REQUIRE(decision.changed);
+    REQUIRE(decision.minimumFrequency == 1500000);
+
+    // warm: don't raise.
+    decision = policy.Update(5.0f, 72);
+    REQUIRE(!decision.changed);
+    REQUIRE(decision.minimumFrequency == 1500000);
+
+    decision = policy.Update(5.0f, 60);
+    REQUIRE(decision.minimumFrequency == 1800000);
+
+    // no frequencies available.
+    CpuFrequencyPolicy empty({});
+    REQUIRE(!empty.Update(5.0f, 50).changed);
+    REQUIRE(empty.GetMinimumFrequency() == 0);
+}
@@ -23,6 +23,7 @@
 #include <filesystem>
 #include "PiPedalException.hpp"
 #include <unistd.h>
+#include <algorithm>
 
 using namespace pipedal;
 
@@ -144,6 +145,90 @@ std::vector<std::string> pipedal::GetAvailableGovernors() {
     return std::vector<std::string> {
         "performance",
         "ondemand",
-        "powersave"
+        "powersave",
+        AUTO_CPU_GOVERNOR
     };
 }
+
+std::string pipedal::GetEffectiveCpuGovernor(const std::string &governor)
+{
+    if (governor == AUTO_CPU_GOVERNOR)
+    {
+        return "ondemand";
+    }
+    return governor;
+}
+
+static uint64_t readSysfsFrequency(const std::filesystem::path &path)
+{
+    uint64_t result = 0;
+    std::ifstream f(path);
+    if (f.is_open())
+    {
+        f >> result;
+        if (f.fail())
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+std::vector<uint64_t> pipedal::GetCpuFrequencies()
+{
+    std::vector<uint64_t> result;
+    {
+        std::ifstream f("/sys/devices/system/cpu/cpu0/cpufreq/scaling_available_frequencies");
+        if (f.is_open())
+        {
+            uint64_t frequency;
+            while (f >> frequency)
+            {
+                result.push_back(frequency);
+            }
+        }
+    }
+    if (result.empty())
+    {
+        // e.g. intel_pstate: synthesize steps between the hardware limits.
+        constexpr int STEPS = 5;
+        uint64_t minFrequency = readSysfsFrequency("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_min_freq");
+        uint64_t maxFrequency = readSysfsFrequency("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
+        if (minFrequency != 0 && maxFrequency > minFrequency)
+        {
+            for (int i = 0; i < STEPS; ++i)
+            {
+                result.push_back(minFrequency + (maxFrequency - minFrequency) * i / (STEPS - 1));
+            }
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+uint64_t pipedal::GetCpuMinimumFrequency()
+{
+    return readSysfsFrequency("/sys/devices/system/cpu/cpu0/cpufreq/scaling_min_freq");
+}
+
+void pipedal::SetCpuMinimumFrequency(uint64_t frequencyKHz)
+{
+    std::string value = SS(frequencyKHz);
+    for (int nCpu = 0; ; ++nCpu)
+    {
+        std::filesystem::path base = SS("/sys/devices/system/cpu/cpu" << nCpu);
+        if (!std::filesystem::is_directory(base))
+            break;
+
+        std::filesystem::path sysFsPath = base / "cpufreq" / "scaling_min_freq";
+        if (!std::filesystem::exists(sysFsPath))
+        {
+            return;
+        }
+        if (!writeAndVerify(sysFsPath, value))
+        {
+            throw PiPedalException(SS("Write to " << sysFsPath << " failed."));
+        }
+    }
+}
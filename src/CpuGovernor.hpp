@@ -21,12 +21,27 @@
 #pragma once 
 #include <string>
 #include <vector>
+#include <cstdint>
 
 namespace pipedal {
+    // Not a kernel governor: PiPedal adjusts the minimum CPU frequency to suit the current DSP load and
+    // CPU temperature (see CpuFrequencyPolicy), using the governor returned by GetEffectiveCpuGovernor.
+    constexpr char AUTO_CPU_GOVERNOR[] = "auto";
+
     bool HasCpuGovernor(); 
     std::string GetCpuGovernor();
 
     void SetCpuGovernor(const std::string &governor);
 
     std::vector<std::string> GetAvailableGovernors();
+
+    // The kernel governor to use for a governor setting.
+    std::string GetEffectiveCpuGovernor(const std::string &governor);
+
+    // Frequencies in kHz, ascending. Empty if the CPU doesn't have scalable frequencies.
+    std::vector<uint64_t> GetCpuFrequencies();
+    // kHz. 0 if not available.
+    uint64_t GetCpuMinimumFrequency();
+    // Sets scaling_min_freq on all cores (requires root).
+    void SetCpuMinimumFrequency(uint64_t frequencyKHz);
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "CpuList.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+using namespace pipedal;
+
+static int parseCpu(const std::string &cpuList, const std::string &text)
+{
+    if (text.empty() || text.length() > 4 || !std::all_of(text.begin(), text.end(), [](char c)
+                                                          { return std::isdigit((unsigned char)c); }))
+    {
+        throw std::invalid_argument(SS("Invalid cpu list: '" << cpuList << "'"));
+    }
+    return std::stoi(text);
+}
+
+std::vector<int> pipedal::ParseCpuList(const std::string &cpuList)
+{
+    std::vector<int> result;
+    size_t start = 0;
+    while (start < cpuList.length())
+    {
+        size_t end = cpuList.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = cpuList.length();
+        }
+        std::string item = cpuList.substr(start, end - start);
+        size_t dash = item.find('-');
+        if (dash == std::string::npos)
+        {
+            result.push_back(parseCpu(cpuList, item));
+        }
+        else
+        {
+            int first = parseCpu(cpuList, item.substr(0, dash));
+            int last = parseCpu(cpuList, item.substr(dash + 1));
+            if (last < first)
+            {
+                throw std::invalid_argument(SS("Invalid cpu list: '" << cpuList << "'"));
+            }
+            for (int cpu = first; cpu <= last; ++cpu)
+            {
+                result.push_back(cpu);
+            }
+        }
+        start = end + 1;
+        if (end + 1 == cpuList.length()) // trailing ','
+        {
+            throw std::invalid_argument(SS("Invalid cpu list: '" << cpuList << "'"));
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+std::string pipedal::FormatCpuList(const std::vector<int> &cpus_)
+{
+    std::vector<int> cpus = cpus_;
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+
+    std::stringstream s;
+    size_t i = 0;
+    while (i < cpus.size())
+    {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+        {
+            ++j;
+        }
+        if (i != 0)
+        {
+            s << ',';
+        }
+        s << cpus[i];
+        if (j != i)
+        {
+            s << '-' << cpus[j];
+        }
+        i = j + 1;
+    }
+    return s.str();
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "CpuList.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("Cpu list", "[cpu_list][Build][Dev]")
+{
+    REQUIRE(ParseCpuList("").empty());
+    REQUIRE(ParseCpuList("3") == std::vector<int>{3});
+    REQUIRE(ParseCpuList("2-3") == std::vector<int>{2, 3});
+    REQUIRE(ParseCpuList("5,1-2,2") == std::vector<int>{1, 2, 5});
+
+    REQUIRE_THROWS(ParseCpuList("1,"));
+    REQUIRE_THROWS(ParseCpuList("3-1"));
+    REQUIRE_THROWS(ParseCpuList("a"));
+    REQUIRE_THROWS(ParseCpuList("1--2"));
+
+    REQUIRE(FormatCpuList({}) == "");
+    REQUIRE(FormatCpuList({3}) == "3");
+    REQUIRE(FormatCpuList({5, 1, 2, 3}) == "1-3,5");
+    REQUIRE(FormatCpuList(ParseCpuList("0,2-3,7")) == "0,2-3,7");
+}
@@ -33,9 +33,6 @@ using namespace pipedal;
 
 
 
-static constexpr std::string_view THERMAL_PATH = "/sys/class/thermal/";
-
-
 static std::optional<std::string> readFile(const fs::path& path) {
     std::ifstream file(path);
     if (!file) {
@@ -50,7 +47,7 @@ static std::optional<std::string> readFile(const fs::path& path) {
 
 static bool isCpuThermal(const fs::path &zone_path) {
     auto type = readFile(zone_path / "type");
-    return type && (*type == "cpu-thermal") || (*type == "x86_pkg_temp");
+    return type && ((*type == "cpu-thermal") || (*type == "x86_pkg_temp"));
 }
 
 
@@ -88,11 +85,11 @@ public:
     }
 };
 
-static std::vector<fs::path> findCpuThermalZones() {
+std::vector<fs::path> CpuTemperatureMonitor::FindCpuThermalZones(const fs::path &thermalPath) {
     std::vector<fs::path> cpu_zones;
     std::error_code ec;
     
-    for (const auto& entry : fs::directory_iterator(THERMAL_PATH, ec)) {
+    for (const auto& entry : fs::directory_iterator(thermalPath, ec)) {
         if (ec) {
             std::cerr << "Error reading directory: " << ec.message() << '\n';
             continue;
@@ -112,7 +109,7 @@ static std::vector<fs::path> findCpuThermalZones() {
 CpuTemperatureMonitor::ptr CpuTemperatureMonitor::Get()
 {
 
-    std::vector<fs::path> cpuZones = findCpuThermalZones();
+    std::vector<fs::path> cpuZones = FindCpuThermalZones();
 
     return std::make_unique<CpuTemperatureMonitorImpl>(std::move(cpuZones));
 }
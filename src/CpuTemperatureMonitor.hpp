@@ -22,6 +22,7 @@
 #include <filesystem>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace pipedal {
 
@@ -36,6 +37,9 @@ namespace pipedal {
 
         static ptr Get(); // may return empty pointer.
 
+        // The thermal zones (e.g. /sys/class/thermal/thermal_zone0) that measure CPU temperature.
+        static std::vector<std::filesystem::path> FindCpuThermalZones(const std::filesystem::path &thermalPath = "/sys/class/thermal");
+
         // degrees Celcius * 1000;
         virtual float GetTemperatureC() = 0;
     
@@ -23,6 +23,9 @@
  */
 
 #include "CpuUse.hpp"
+#include <sched.h>
+#include <algorithm>
+#include <cmath>
 
 using namespace pipedal;
 using namespace std;
@@ -35,4 +38,185 @@ CpuUse::CpuUseAverager::CpuUseAverager()
         samples[i] = 0;
     }
     sampleTotal = 0;
-}
\ No newline at end of file
+}
+
+JSON_MAP_BEGIN(CpuStageStatistics)
+    JSON_MAP_REFERENCE(CpuStageStatistics, stage)
+    JSON_MAP_REFERENCE(CpuStageStatistics, core)
+    JSON_MAP_REFERENCE(CpuStageStatistics, periods)
+    JSON_MAP_REFERENCE(CpuStageStatistics, meanUs)
+    JSON_MAP_REFERENCE(CpuStageStatistics, p50Us)
+    JSON_MAP_REFERENCE(CpuStageStatistics, p99Us)
+    JSON_MAP_REFERENCE(CpuStageStatistics, p999Us)
+    JSON_MAP_REFERENCE(CpuStageStatistics, maxUs)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(CpuUseStatistics)
+    JSON_MAP_REFERENCE(CpuUseStatistics, periodUs)
+    JSON_MAP_REFERENCE(CpuUseStatistics, processP999Percent)
+    JSON_MAP_REFERENCE(CpuUseStatistics, headroomPercent)
+    JSON_MAP_REFERENCE(CpuUseStatistics, stages)
+    JSON_MAP_REFERENCE(CpuUseStatistics, cores)
+JSON_MAP_END()
+
+CpuUseHistogram::CpuUseHistogram()
+{
+    Clear();
+}
+
+void CpuUseHistogram::Clear()
+{
+    count.store(0, std::memory_order_relaxed);
+    sumNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    for (auto &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    resetRequested.store(false, std::memory_order_relaxed);
+}
+
+void CpuUseHistogram::GetStatistics(CpuStageStatistics *result) const
+{
+    uint32_t counts[BUCKETS];
+    uint64_t total = 0;
+    if (!resetRequested.load(std::memory_order_relaxed)) // otherwise, pending until the next Record().
+    {
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+    }
+    uint64_t maxNs = this->maxNs.load(std::memory_order_relaxed);
+    result->periods_ = total;
+    if (total == 0)
+    {
+        result->meanUs_ = result->p50Us_ = result->p99Us_ = result->p999Us_ = result->maxUs_ = 0;
+        return;
+    }
+    uint64_t count = std::max(this->count.load(std::memory_order_relaxed), (uint64_t)1);
+    result->meanUs_ = (float)((double)sumNs.load(std::memory_order_relaxed) / count * 0.001);
+    result->maxUs_ = maxNs / 1000.0f;
+
+    auto percentile = [&](double fraction) -> float
+    {
+        // the percentile falls in the bucket that contains this value.
+        uint64_t threshold = std::max((uint64_t)1, (uint64_t)std::ceil(total * fraction));
+        uint64_t n = 0;
+        for (size_t i = 0; i < BUCKETS; ++i)
+        {
+            n += counts[i];
+            if (n >= threshold)
+            {
+                return std::min(EffectTimingHistogram::BucketUpperBound(i), maxNs) / 1000.0f;
+            }
+        }
+        return maxNs / 1000.0f;
+    };
+    result->p50Us_ = percentile(0.5);
+    result->p99Us_ = percentile(0.99);
+    result->p999Us_ = percentile(0.999);
+}
+
+void CpuUse::RecordPeriod()
+{
+    SampleT total = 0;
+    for (size_t i = 0; i < NUM_PROFILE_CATEGORIES; ++i)
+    {
+        total += periodTimes[i];
+    }
+    if (total == 0)
+    {
+        return; // the first period.
+    }
+    for (size_t i = 0; i < NUM_PROFILE_CATEGORIES; ++i)
+    {
+        if (i != (size_t)ProfileCategory::Init)
+        {
+            stageHistograms[i].Record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(DurationT(periodTimes[i])).count());
+        }
+    }
+    SampleT processTime = periodTimes[(size_t)ProfileCategory::Driver] + periodTimes[(size_t)ProfileCategory::Execute];
+    uint64_t processNs = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(DurationT(processTime)).count();
+    processHistogram.Record(processNs);
+    recentProcessHistogram.Record(processNs);
+    int core = sched_getcpu(); // vDSO.
+    if (core >= 0 && core < (int)MAX_CORES)
+    {
+        coreProcessHistograms[core].Record(processNs);
+    }
+    for (auto &t : periodTimes)
+    {
+        t = 0;
+    }
+}
+
+CpuUseStatistics CpuUse::GetStatistics() const
+{
+    static const char *stageNames[NUM_PROFILE_CATEGORIES] = {"init", "read", "driver", "execute", "write"};
+
+    CpuUseStatistics result;
+    uint64_t periodNs = this->periodNs.load();
+    result.periodUs_ = periodNs / 1000.0f;
+
+    for (size_t i = 0; i < NUM_PROFILE_CATEGORIES; ++i)
+    {
+        if (i == (size_t)ProfileCategory::Init)
+        {
+            continue;
+        }
+        CpuStageStatistics stage;
+        stage.stage_ = stageNames[i];
+        stageHistograms[i].GetStatistics(&stage);
+        result.stages_.push_back(std::move(stage));
+    }
+    CpuStageStatistics process;
+    process.stage_ = "process";
+    processHistogram.GetStatistics(&process);
+    if (periodNs != 0)
+    {
+        result.processP999Percent_ = process.p999Us_ * 100.0f / result.periodUs_;
+        result.headroomPercent_ = 100.0f - result.processP999Percent_;
+    }
+    result.stages_.push_back(std::move(process));
+
+    for (size_t core = 0; core < MAX_CORES; ++core)
+    {
+        CpuStageStatistics coreStatistics;
+        coreProcessHistograms[core].GetStatistics(&coreStatistics);
+        if (coreStatistics.periods_ != 0)
+        {
+            coreStatistics.stage_ = "process";
+            coreStatistics.core_ = (int32_t)core;
+            result.cores_.push_back(std::move(coreStatistics));
+        }
+    }
+    return result;
+}
+
+void CpuUse::ResetStatistics()
+{
+    for (auto &histogram : stageHistograms)
+    {
+        histogram.RequestReset();
+    }
+    processHistogram.RequestReset();
+    for (auto &histogram : coreProcessHistograms)
+    {
+        histogram.RequestReset();
+    }
+}
+
+std::optional<float> CpuUse::TakeRecentHeadroom()
+{
+    uint64_t periodNs = this->periodNs.load();
+    CpuStageStatistics statistics;
+    recentProcessHistogram.GetStatistics(&statistics);
+    recentProcessHistogram.RequestReset();
+    if (periodNs == 0 || statistics.periods_ == 0)
+    {
+        return std::nullopt;
+    }
+    return 100.0f - statistics.p999Us_ * 100.0f / (periodNs / 1000.0f);
+}
@@ -24,8 +24,14 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "EffectTiming.hpp"
 
 namespace pipedal
 {
@@ -42,6 +48,80 @@ namespace pipedal
     };
     constexpr size_t NUM_PROFILE_CATEGORIES = (size_t)ProfileCategory::MaxCategory;
 
+    // Time spent in one stage of the audio period, per period.
+    class CpuStageStatistics
+    {
+    public:
+        std::string stage_; // "read", "driver", "execute", "write", or "process" (driver + execute).
+        int32_t core_ = -1; // -1: all cores.
+        uint64_t periods_ = 0;
+        float meanUs_ = 0;
+        float p50Us_ = 0;
+        float p99Us_ = 0;
+        float p999Us_ = 0;
+        float maxUs_ = 0; // the worst period since the statistics were reset.
+
+        DECLARE_JSON_MAP(CpuStageStatistics);
+    };
+
+    class CpuUseStatistics
+    {
+    public:
+        float periodUs_ = 0;
+        // The p99.9 processing time (driver + execute) as a percentage of the period. A board is close to
+        // falling over well before its average CPU use gets anywhere near 100%.
+        float processP999Percent_ = 0;
+        float headroomPercent_ = 100; // 100 - processP999Percent_.
+        std::vector<CpuStageStatistics> stages_;
+        std::vector<CpuStageStatistics> cores_; // "process" stage, by the core the audio thread ran on.
+
+        DECLARE_JSON_MAP(CpuUseStatistics);
+    };
+
+    /**
+     * @brief A log-scale histogram of period times (EffectTimingHistogram buckets) that can be read while the
+     * audio thread is writing it.
+     *
+     * Single writer. Readers see a slightly inconsistent view while a Record() is in progress, which
+     * doesn't matter for statistics. Resets are requested by readers, and carried out by the writer.
+     */
+    class CpuUseHistogram
+    {
+    public:
+        static constexpr size_t BUCKETS = EffectTimingHistogram::BUCKETS;
+
+        CpuUseHistogram();
+
+        // Audio thread.
+        void Record(uint64_t ns)
+        {
+            if (resetRequested.load(std::memory_order_relaxed))
+            {
+                Clear();
+            }
+            count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            sumNs.store(sumNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+            if (ns > maxNs.load(std::memory_order_relaxed))
+            {
+                maxNs.store(ns, std::memory_order_relaxed);
+            }
+            auto &bucket = buckets[EffectTimingHistogram::BucketIndex(ns)];
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        // Any thread.
+        void RequestReset() { resetRequested.store(true, std::memory_order_relaxed); }
+        void GetStatistics(CpuStageStatistics *result) const;
+
+    private:
+        void Clear();
+
+        std::atomic<bool> resetRequested{false};
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sumNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::atomic<uint32_t> buckets[BUCKETS];
+    };
+
     class CpuUse
     {
 
@@ -93,6 +173,16 @@ namespace pipedal
         float currentCpuUse = 0;
         float currentOverhead = 0;
 
+        static constexpr size_t MAX_CORES = 16;
+        SampleT periodTimes[NUM_PROFILE_CATEGORIES] = {}; // the current period, by category.
+        CpuUseHistogram stageHistograms[NUM_PROFILE_CATEGORIES];
+        CpuUseHistogram processHistogram;
+        CpuUseHistogram recentProcessHistogram; // since the last TakeRecentHeadroom().
+        CpuUseHistogram coreProcessHistograms[MAX_CORES];
+        std::atomic<uint64_t> periodNs{0};
+
+        void RecordPeriod();
+
         CpuUseAverager &GetCategory(ProfileCategory category) {
             return profileTimes[(size_t)category];
         }
@@ -109,6 +199,7 @@ namespace pipedal
         void AddSample(ProfileCategory category, TimeT time)
         {
             profileTimes[(size_t)category].AddSample((time-lastSample));
+            periodTimes[(size_t)category] += (time-lastSample).count();
             lastSample = time;
         }
         void AddSample(ProfileCategory category) 
@@ -118,9 +209,24 @@ namespace pipedal
         void AddSample(ProfileCategory category, TimeT startTime, TimeT endTime)
         {
             profileTimes[(size_t)category].AddSample((endTime-startTime));
+            periodTimes[(size_t)category] += (endTime-startTime).count();
         }
 
+        // The nominal length of a period, for the headroom calculation.
+        void SetPeriod(uint32_t frames, uint32_t sampleRate)
+        {
+            periodNs = sampleRate == 0 ? 0 : (uint64_t)frames * 1000000000ull / sampleRate;
+        }
+
+        // Any thread.
+        CpuUseStatistics GetStatistics() const;
+        void ResetStatistics();
+        // p99.9 headroom since the last call. nullopt if no periods have been processed since then.
+        std::optional<float> TakeRecentHeadroom();
+
+        // Audio thread, once per period.
         void UpdateCpuUse() {
+            RecordPeriod();
             
             SampleT readTime = GetCategory(ProfileCategory::Read).GetTotal();
             SampleT writeTime = GetCategory(ProfileCategory::Driver).GetTotal();
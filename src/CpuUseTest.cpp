@@ -0,0 +1,103 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "CpuUse.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("Cpu use histogram", "[cpu_use][Build][Dev]")
+{
+    CpuUseHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        histogram.Record(i * 1000); // 1us..1000us
+    }
+    CpuStageStatistics statistics;
+    histogram.GetStatistics(&statistics);
+    REQUIRE(statistics.periods_ == 1000);
+    REQUIRE(statistics.maxUs_ == 1000.0f);
+    REQUIRE(std::abs(statistics.meanUs_ - 500.5f) < 0.01f);
+    // quarter-octave buckets: within 19% above the exact value.
+    REQUIRE(statistics.p50Us_ >= 500.0f);
+    REQUIRE(statistics.p50Us_ <= 500.0f * 1.19f);
+    REQUIRE(statistics.p99Us_ >= 990.0f);
+    REQUIRE(statistics.p999Us_ <= 1000.0f);
+
+    histogram.RequestReset();
+    histogram.Record(5000);
+    histogram.GetStatistics(&statistics);
+    REQUIRE(statistics.periods_ == 1);
+    REQUIRE(statistics.p50Us_ == 5.0f);
+    REQUIRE(statistics.maxUs_ == 5.0f);
+}
+
+TEST_CASE("Cpu use statistics", "[cpu_use][Build][Dev]")
+{
+    CpuUse cpuUse;
+    cpuUse.SetPeriod(48, 48000); // 1ms.
+    auto t = cpuUse.Now();
+    cpuUse.SetStartTime(t);
+    cpuUse.UpdateCpuUse(); // nothing recorded yet.
+    for (int i = 0; i < 100; ++i)
+    {
+        t += std::chrono::microseconds(600);
+        cpuUse.AddSample(ProfileCategory::Read, t);
+        t += std::chrono::microseconds(100);
+        cpuUse.AddSample(ProfileCategory::Driver, t);
+        t += std::chrono::microseconds(200);
+        cpuUse.AddSample(ProfileCategory::Execute, t);
+        cpuUse.UpdateCpuUse();
+    }
+    CpuUseStatistics statistics = cpuUse.GetStatistics();
+    REQUIRE(statistics.periodUs_ == 1000.0f);
+    REQUIRE(statistics.stages_.size() == 5);
+    REQUIRE(statistics.stages_.back().stage_ == "process");
+    REQUIRE(statistics.stages_.back().periods_ == 100);
+    REQUIRE(statistics.stages_.back().maxUs_ == 300.0f);
+    REQUIRE(statistics.processP999Percent_ == 30.0f);
+    REQUIRE(statistics.headroomPercent_ == 70.0f);
+    REQUIRE(statistics.cores_.size() >= 1);
+
+    cpuUse.ResetStatistics();
+    cpuUse.UpdateCpuUse();
+    REQUIRE(cpuUse.GetStatistics().stages_.back().periods_ == 0);
+}
+
+TEST_CASE("Cpu use recent headroom", "[cpu_use][Build][Dev]")
+{
+    CpuUse cpuUse;
+    cpuUse.SetPeriod(48, 48000); // 1ms.
+    REQUIRE(!cpuUse.TakeRecentHeadroom().has_value());
+
+    auto t = cpuUse.Now();
+    cpuUse.SetStartTime(t);
+    for (int i = 0; i < 10; ++i)
+    {
+        t += std::chrono::microseconds(250);
+        cpuUse.AddSample(ProfileCategory::Execute, t);
+        cpuUse.UpdateCpuUse();
+    }
+    auto headroom = cpuUse.TakeRecentHeadroom();
+    REQUIRE(headroom.has_value());
+    REQUIRE(*headroom == 75.0f);
+    REQUIRE(!cpuUse.TakeRecentHeadroom().has_value());
+}
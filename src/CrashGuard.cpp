@@ -34,6 +34,7 @@ int CrashGuard::crashCount = 0;
 std::mutex CrashGuard::mutex;
 std::filesystem::path CrashGuard::fileName;
 int64_t CrashGuard::depth = 0;
+std::set<std::string> CrashGuard::hungPlugins;
 
 static uint64_t getCurrentTimeMillis()
 {
@@ -83,6 +84,89 @@ void CrashGuard::SetCrashGuardFileName(const std::filesystem::path &path)
             Lv2Log::info("CrashGuard: Detected previous crash, count = %d", (int)crashCount);
         }
     }
+    {
+        std::lock_guard lock{mutex};
+        hungPlugins.clear();
+        std::ifstream f{HungPluginsFileName()};
+        std::string uri;
+        while (std::getline(f, uri))
+        {
+            if (!uri.empty())
+            {
+                hungPlugins.insert(uri);
+            }
+        }
+        for (const auto &hungUri : hungPlugins)
+        {
+            Lv2Log::info("CrashGuard: Plugin previously hung: %s", hungUri.c_str());
+        }
+    }
+}
+
+std::filesystem::path CrashGuard::HungPluginsFileName()
+{
+    if (fileName.empty())
+    {
+        return fileName;
+    }
+    return fileName.parent_path() / "hung_plugins.data";
+}
+
+void CrashGuard::SaveHungPlugins()
+{
+    // mutex must be held.
+    fs::path path = HungPluginsFileName();
+    if (path.empty())
+    {
+        return;
+    }
+    try
+    {
+        if (hungPlugins.empty())
+        {
+            if (fs::exists(path))
+            {
+                fs::remove(path);
+            }
+            return;
+        }
+        ofstream_synced f{path};
+        for (const auto &uri : hungPlugins)
+        {
+            f << uri << '\n';
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error("CrashGuard: Failed to write %s. (%s)", path.c_str(), e.what());
+    }
+}
+
+void CrashGuard::RecordHungPlugin(const std::string &uri)
+{
+    std::lock_guard lock{mutex};
+    if (hungPlugins.insert(uri).second)
+    {
+        SaveHungPlugins();
+    }
+}
+bool CrashGuard::IsHungPlugin(const std::string &uri)
+{
+    std::lock_guard lock{mutex};
+    return hungPlugins.contains(uri);
+}
+void CrashGuard::ClearHungPlugin(const std::string &uri)
+{
+    std::lock_guard lock{mutex};
+    if (hungPlugins.erase(uri) != 0)
+    {
+        SaveHungPlugins();
+    }
+}
+std::set<std::string> CrashGuard::GetHungPlugins()
+{
+    std::lock_guard lock{mutex};
+    return hungPlugins;
 }
 bool CrashGuard::HasCrashed()
 {
@@ -26,6 +26,8 @@
 #include <mutex>
 #include <atomic>
 #include <filesystem>
+#include <set>
+#include <string>
 
 namespace pipedal
 {
@@ -53,7 +55,18 @@ namespace pipedal
         static void EnterCrashGuardZone();
         static void LeaveCrashGuardZone();
 
+        // Plugins that the realtime watchdog has caught hanging. Persisted alongside the crash guard file,
+        // so that they stay bypassed across restarts until the user explicitly re-enables them.
+        static void RecordHungPlugin(const std::string &uri);
+        static bool IsHungPlugin(const std::string &uri);
+        static void ClearHungPlugin(const std::string &uri);
+        static std::set<std::string> GetHungPlugins();
+
     private:
+        static void SaveHungPlugins();
+        static std::filesystem::path HungPluginsFileName();
+
+        static std::set<std::string> hungPlugins;
         static int crashCount;
         static std::mutex mutex;
         static std::filesystem::path fileName;
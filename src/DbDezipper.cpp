@@ -22,6 +22,7 @@
  */
 
 #include "DbDezipper.hpp"
+#include "AudioMixKernels.hpp"
 
 using namespace pipedal;
 
@@ -107,3 +108,61 @@ void DbDezipper::Reset(float db)
     targetDb = db;
     count = -1;
 }
+
+uint32_t DbDezipper::NextRun(uint32_t maxSamples, float *gain, float *dGain)
+{
+    if (count == 0)
+    {
+        NextSegment();
+        if (count >= 0)
+        {
+            // Tick() consumes the first sample of a segment on the call that starts it.
+            ++count;
+        }
+    }
+    if (count < 0)
+    {
+        *gain = x;
+        *dGain = 0;
+        return maxSamples;
+    }
+    uint32_t samples = (uint32_t)count < maxSamples ? (uint32_t)count : maxSamples;
+    *gain = x;
+    *dGain = dx;
+    x += samples * dx;
+    count -= (int32_t)samples;
+    return samples;
+}
+
+void DbDezipper::Apply(float *buffer, uint32_t samples)
+{
+    Apply(&buffer, &buffer, 1, samples);
+}
+
+void DbDezipper::Apply(const float *const *inputs, float *const *outputs, size_t channels, uint32_t samples)
+{
+    uint32_t offset = 0;
+    while (offset < samples)
+    {
+        float gain, dGain;
+        uint32_t n = NextRun(samples - offset, &gain, &dGain);
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const float *input = inputs[c] + offset;
+            float *output = outputs[c] + offset;
+            if (dGain != 0)
+            {
+                ScaleAudioRamp(input, gain, dGain, output, n);
+            }
+            else if (gain == 1)
+            {
+                CopyAudio(input, output, n); // no-op in place.
+            }
+            else
+            {
+                ScaleAudio(input, gain, output, n);
+            }
+        }
+        offset += n;
+    }
+}
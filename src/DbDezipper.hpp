@@ -24,6 +24,8 @@
 #pragma once
 
 #include "PiPedalMath.hpp"
+#include <cstddef>
+#include <cstdint>
 
 namespace pipedal
 {
@@ -47,6 +49,8 @@ namespace pipedal
         }
 
         bool IsIdle() const { return count < 0;}
+        // True if the gain is exactly 1 and not ramping, so that Apply() would only copy.
+        bool IsUnity() const { return count < 0 && x == 1.0f; }
         inline float Tick()
         {
             if (count >= 0)
@@ -63,7 +67,15 @@ namespace pipedal
             return x;
         }
 
+        // Apply the gain to a block of samples in place. Equivalent to calling Tick() for each sample.
+        void Apply(float *buffer, uint32_t samples);
+        // Apply the same gain to each channel, from inputs[c] to outputs[c]. Equivalent to calling Tick() for each frame.
+        void Apply(const float *const *inputs, float *const *outputs, size_t channels, uint32_t samples);
+
     private:
+        // The number of samples (at most maxSamples) over which the gain is gain + i*dGain. Advances the dezipper past them.
+        uint32_t NextRun(uint32_t maxSamples, float *gain, float *dGain);
+
         float minDb = -96;
         double sampleRate = 44100;
         float rate = 0.1;
@@ -0,0 +1,126 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+namespace pipedal
+{
+    /**
+     * @brief Flush-to-zero handling for threads that run plugins in realtime.
+     *
+     * Filters and reverbs whose tails decay into the subnormal range run many times more slowly on most
+     * FPUs. With flush-to-zero enabled, subnormal results are replaced by zero: on x86, MXCSR.FTZ and
+     * MXCSR.DAZ (subnormal inputs are treated as zero too); on ARM, FPCR.FZ (AArch64) or FPSCR.FZ (VFP),
+     * which does both.
+     *
+     * The setting is per-thread, and plugins occasionally change it, so realtime threads reapply
+     * the policy once per period with ApplyDenormalPolicy(), which only writes the control register
+     * if it has changed.
+     */
+    class Denormals
+    {
+    public:
+        // Enabled by default. Disable to find plugins that produce subnormals (see HasSubnormals).
+        static void SetFlushToZero(bool enabled) { flushToZero.store(enabled, std::memory_order_relaxed); }
+        static bool GetFlushToZero() { return flushToZero.load(std::memory_order_relaxed); }
+
+        // Realtime-safe. Sets or clears flush-to-zero on the calling thread, according to the current policy.
+        static void ApplyPolicy()
+        {
+            SetThreadFlushToZero(GetFlushToZero());
+        }
+
+        static void SetThreadFlushToZero(bool enabled)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            constexpr unsigned int FTZ_DAZ = 0x8040; // FTZ (bit 15) | DAZ (bit 6)
+            unsigned int csr = _mm_getcsr();
+            unsigned int newCsr = enabled ? (csr | FTZ_DAZ) : (csr & ~FTZ_DAZ);
+            if (newCsr != csr)
+            {
+                _mm_setcsr(newCsr);
+            }
+#elif defined(__aarch64__)
+            constexpr uint64_t FZ = 1ull << 24;
+            uint64_t fpcr;
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+            uint64_t newFpcr = enabled ? (fpcr | FZ) : (fpcr & ~FZ);
+            if (newFpcr != fpcr)
+            {
+                __asm__ __volatile__("msr fpcr, %0" : : "r"(newFpcr));
+            }
+#elif defined(__arm__) && defined(__ARM_FP)
+            constexpr uint32_t FZ = 1u << 24;
+            uint32_t fpscr;
+            __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+            uint32_t newFpscr = enabled ? (fpscr | FZ) : (fpscr & ~FZ);
+            if (newFpscr != fpscr)
+            {
+                __asm__ __volatile__("vmsr fpscr, %0" : : "r"(newFpscr));
+            }
+#else
+            (void)enabled;
+#endif
+        }
+
+        // True if flush-to-zero is set on the calling thread. (False on architectures without support.)
+        static bool GetThreadFlushToZero()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return (_mm_getcsr() & 0x8040) == 0x8040;
+#elif defined(__aarch64__)
+            uint64_t fpcr;
+            __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+            return (fpcr & (1ull << 24)) != 0;
+#elif defined(__arm__) && defined(__ARM_FP)
+            uint32_t fpscr;
+            __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+            return (fpscr & (1u << 24)) != 0;
+#else
+            return false;
+#endif
+        }
+
+        // Realtime-safe. Uses integer compares, since floating point compares treat subnormals as
+        // zero when DAZ is set.
+        static bool HasSubnormals(const float *buffer, size_t frames)
+        {
+            uint32_t found = 0;
+            for (size_t i = 0; i < frames; ++i)
+            {
+                uint32_t bits;
+                std::memcpy(&bits, &buffer[i], sizeof(bits));
+                found |= ((bits & 0x7F800000u) == 0) & ((bits & 0x007FFFFFu) != 0);
+            }
+            return found != 0;
+        }
+
+    private:
+        static std::atomic<bool> flushToZero;
+    };
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Denormals.hpp"
+#include "EffectTiming.hpp"
+#include <limits>
+#include <vector>
+
+using namespace pipedal;
+
+TEST_CASE("Denormals test", "[denormals][Build][Dev]")
+{
+    std::vector<float> buffer(64, 0.5f);
+    buffer[10] = -0.0f;
+    buffer[11] = std::numeric_limits<float>::min(); // smallest normal.
+    REQUIRE(!Denormals::HasSubnormals(buffer.data(), buffer.size()));
+    buffer[63] = std::numeric_limits<float>::denorm_min();
+    REQUIRE(Denormals::HasSubnormals(buffer.data(), buffer.size()));
+    REQUIRE(!Denormals::HasSubnormals(buffer.data(), 63));
+    buffer[63] = -std::numeric_limits<float>::min() / 4;
+    REQUIRE(Denormals::HasSubnormals(buffer.data(), buffer.size()));
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    bool originalSetting = Denormals::GetThreadFlushToZero();
+    volatile float small = std::numeric_limits<float>::min();
+    volatile float scale = 0.25f;
+
+    Denormals::SetThreadFlushToZero(false);
+    REQUIRE(!Denormals::GetThreadFlushToZero());
+    REQUIRE(small * scale != 0.0f);
+
+    Denormals::SetThreadFlushToZero(true);
+    REQUIRE(Denormals::GetThreadFlushToZero());
+    float result = small * scale;
+    REQUIRE(!Denormals::HasSubnormals(&result, 1));
+
+    Denormals::SetThreadFlushToZero(originalSetting);
+#endif
+}
+
+TEST_CASE("Denormal detection effect timing test", "[denormals][Build][Dev]")
+{
+    RealtimeEffectTimings timings({1, 2});
+    REQUIRE(!timings.IsDetectingDenormals());
+    REQUIRE(timings.GetResult()->GetStatistics()[0].subnormalPercent_ == -1);
+
+    timings.EnableDenormalDetection();
+    REQUIRE(timings.IsDetectingDenormals());
+    for (int i = 0; i < 4; ++i)
+    {
+        timings.Record(0, 1000);
+        timings.Record(1, 1000);
+    }
+    timings.RecordSubnormals(1);
+    auto statistics = timings.GetResult()->GetStatistics();
+    REQUIRE(statistics[0].subnormalPercent_ == 0);
+    REQUIRE(statistics[1].subnormalPercent_ == 25);
+
+    // counts are reset for the next interval.
+    statistics = timings.GetResult()->GetStatistics();
+    REQUIRE(statistics[1].subnormalPercent_ == 0);
+}
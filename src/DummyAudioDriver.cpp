@@ -41,6 +41,7 @@
 #include "CrashGuard.hpp"
 
 #include "CpuUse.hpp"
+#include "WavFile.hpp"
 
 #include <alsa/asoundlib.h>
 
@@ -96,11 +97,20 @@ namespace pipedal
 
         AudioDriverHost *driverHost = nullptr;
         uint32_t channels = 2;
+        bool freeRunning = false;
+        DummyAudioDriverOptions options;
+
+        WavReader inputFile;
+        WavWriter outputFile;
+        uint64_t tailFramesRemaining = 0;
+        bool renderComplete = false;
 
     public:
-        DummyDriverImpl(AudioDriverHost *driverHost,const std::string&deviceName)
+        DummyDriverImpl(AudioDriverHost *driverHost,const std::string&deviceName, const DummyAudioDriverOptions &options)
             : driverHost(driverHost)
             , channels(GetDummyAudioChannels(deviceName))
+            , freeRunning(options.freeRunning)
+            , options(options)
         {
             captureChannels = channels;
             playbackChannels = channels;
@@ -233,7 +243,68 @@ namespace pipedal
             this->bufferSize = jackServerSettings.GetBufferSize();
             AllocateBuffers(captureBuffers, channels);
             AllocateBuffers(playbackBuffers, channels);
-     
+
+            if (!options.inputFile.empty())
+            {
+                inputFile.Open(options.inputFile);
+                if (inputFile.GetSampleRate() != this->sampleRate)
+                {
+                    DummyError(SS("The sample rate of " << options.inputFile << " (" << inputFile.GetSampleRate()
+                                  << ") doesn't match the audio sample rate (" << this->sampleRate << ")."));
+                }
+                tailFramesRemaining = (uint64_t)(options.tailSeconds * this->sampleRate);
+            }
+            renderComplete = false;
+        }
+
+        // Returns false once the input file and tail have been rendered.
+        bool ReadInputFile()
+        {
+            if (renderComplete)
+            {
+                return false;
+            }
+            if (!inputFile.IsOpen())
+            {
+                return true;
+            }
+            size_t framesRead = inputFile.Read(this->activeCaptureBuffers.data(), this->activeCaptureBuffers.size(), this->bufferSize);
+            if (framesRead < this->bufferSize)
+            {
+                for (float *buffer : this->activeCaptureBuffers)
+                {
+                    std::fill(buffer + framesRead, buffer + this->bufferSize, 0.0f);
+                }
+                if (framesRead == 0)
+                {
+                    if (tailFramesRemaining == 0)
+                    {
+                        CompleteRender();
+                        return false;
+                    }
+                    tailFramesRemaining -= std::min(tailFramesRemaining, (uint64_t)this->bufferSize);
+                }
+            }
+            return true;
+        }
+        void CompleteRender()
+        {
+            renderComplete = true;
+            if (outputFile.IsOpen())
+            {
+                outputFile.Close();
+            }
+            if (options.onRenderComplete)
+            {
+                options.onRenderComplete();
+            }
+        }
+        void WriteOutputFile()
+        {
+            if (outputFile.IsOpen())
+            {
+                outputFile.Write(this->activePlaybackBuffers.data(), this->bufferSize);
+            }
         }
 
         std::jthread *audioThread;
@@ -241,11 +312,19 @@ namespace pipedal
 
         bool block = false;
 
-        void ReadMidiData(uint32_t audioFrame)
+        void ReadMidiData()
         {
             AlsaMidiMessage message;
 
             midiEventCount = 0;
+            midiEventMemoryIndex = 0;
+            if (!alsaSequencer)
+            {
+                return;
+            }
+            bool hasPeriodEndNs = false;
+            uint64_t periodEndNs = 0;
+            uint64_t nowNs = 0;
             while(alsaSequencer->ReadMessage(message,0))
             {
                 size_t messageSize = message.size;
@@ -263,8 +342,22 @@ namespace pipedal
                 if (message.data[0] == 0xFF && message.size > 1) {
                     continue;
                 }
+                if (!hasPeriodEndNs)
+                {
+                    uint64_t sec;
+                    uint32_t nsec;
+                    hasPeriodEndNs = true;
+                    periodEndNs = alsaSequencer->GetQueueRealtime(&sec, &nsec) ? sec * 1000000000ull + nsec : 0;
+                    nowNs = EffectTimingClockNs();
+                }
+                uint32_t frame = periodEndNs != 0 ? MidiEventFrame(message.RealtimeNs(), periodEndNs, sampleRate, bufferSize) : 0;
+                if (midiEventCount != 0 && frame < midiEvents[midiEventCount - 1].time)
+                {
+                    frame = midiEvents[midiEventCount - 1].time; // keep the sequence in order.
+                }
                 MidiEvent *pEvent = midiEvents.data() + midiEventCount++;
-                pEvent->time = audioFrame;
+                pEvent->time = frame;
+                pEvent->receivedNs = MidiEventReceivedNs(message.RealtimeNs(), periodEndNs, nowNs);
                 pEvent->size = messageSize; 
                 pEvent->buffer = midiEventMemory.data() + midiEventMemoryIndex;
 
@@ -297,13 +390,23 @@ namespace pipedal
                         break;
                     }
 
-                    ReadMidiData((uint32_t)0);
+                    if (!ReadInputFile())
+                    {
+                        // rendering is complete. Idle until deactivated.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                        continue;
+                    }
+                    ReadMidiData();
 
                     ssize_t framesRead = this->bufferSize;
                     this->driverHost->OnProcess(framesRead);
+                    WriteOutputFile();
 
-                    /// no attempt at realtime. Just as long as we run occasionally.
-                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    if (!freeRunning)
+                    {
+                        /// no attempt at realtime. Just as long as we run occasionally.
+                        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    }
 
 
                 }
@@ -378,6 +481,11 @@ namespace pipedal
                 }
             }
 
+            if (!options.outputFile.empty())
+            {
+                outputFile.Open(options.outputFile, (uint32_t)this->activePlaybackBuffers.size(), this->sampleRate);
+            }
+
             audioThread = new std::jthread([this]()
                                            { AudioThread(); });
         }
@@ -451,6 +559,8 @@ namespace pipedal
             Deactivate();
             DummyCleanup();
             DeleteBuffers();
+            inputFile.Close();
+            outputFile.Close();
         }
 
         virtual float CpuUse()
@@ -464,9 +574,15 @@ namespace pipedal
         }
     };
 
-    AudioDriver *CreateDummyAudioDriver(AudioDriverHost *driverHost,const std::string&deviceName)
+    AudioDriver *CreateDummyAudioDriver(AudioDriverHost *driverHost,const std::string&deviceName, bool freeRunning)
+    {
+        DummyAudioDriverOptions options;
+        options.freeRunning = freeRunning;
+        return new DummyDriverImpl(driverHost,deviceName,options);
+    }
+    AudioDriver *CreateDummyAudioDriver(AudioDriverHost *driverHost,const std::string&deviceName, const DummyAudioDriverOptions &options)
     {
-        return new DummyDriverImpl(driverHost,deviceName);
+        return new DummyDriverImpl(driverHost,deviceName,options);
     }
 
     bool GetDummyChannels(const JackServerSettings &jackServerSettings,
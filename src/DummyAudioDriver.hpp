@@ -26,13 +26,32 @@
 
 #include "AudioDriver.hpp"
 #include "JackServerSettings.hpp"
+#include <filesystem>
+#include <functional>
 
 namespace pipedal {
 
     AlsaDeviceInfo MakeDummyDeviceInfo(uint32_t channels);
 
     uint32_t GetDummyAudioChannels(const std::string &deviceName);
-    AudioDriver* CreateDummyAudioDriver(AudioDriverHost*driverHost,const std::string&deviceId);
+    class DummyAudioDriverOptions {
+    public:
+        // Call OnProcess back-to-back, as fast as the host can keep up (benchmarking, offline rendering),
+        // instead of every 20ms.
+        bool freeRunning = false;
+        // Feed capture buffers from a WAV file (which must match the audio sample rate) instead of silence.
+        std::filesystem::path inputFile;
+        // Record the playback buffers to a 32-bit float WAV file.
+        std::filesystem::path outputFile;
+        // Once inputFile has been consumed, process this many seconds of silence (e.g. for reverb tails),
+        // then stop processing, close outputFile, and call onRenderComplete (on the audio thread).
+        double tailSeconds = 0;
+        std::function<void()> onRenderComplete;
+    };
+
+    // freeRunning: call OnProcess back-to-back, as fast as the host can keep up (benchmarking), instead of every 20ms.
+    AudioDriver* CreateDummyAudioDriver(AudioDriverHost*driverHost,const std::string&deviceId, bool freeRunning = false);
+    AudioDriver* CreateDummyAudioDriver(AudioDriverHost*driverHost,const std::string&deviceId, const DummyAudioDriverOptions &options);
 
 }
 
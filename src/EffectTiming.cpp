@@ -0,0 +1,193 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "EffectTiming.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+JSON_MAP_BEGIN(EffectTiming)
+    JSON_MAP_REFERENCE(EffectTiming, instanceId)
+    JSON_MAP_REFERENCE(EffectTiming, periods)
+    JSON_MAP_REFERENCE(EffectTiming, minUs)
+    JSON_MAP_REFERENCE(EffectTiming, meanUs)
+    JSON_MAP_REFERENCE(EffectTiming, p99Us)
+    JSON_MAP_REFERENCE(EffectTiming, maxUs)
+    JSON_MAP_REFERENCE(EffectTiming, pmu)
+    JSON_MAP_REFERENCE(EffectTiming, cyclesPerPeriod)
+    JSON_MAP_REFERENCE(EffectTiming, instructionsPerPeriod)
+    JSON_MAP_REFERENCE(EffectTiming, ipc)
+    JSON_MAP_REFERENCE(EffectTiming, l1dMpki)
+    JSON_MAP_REFERENCE(EffectTiming, l2Mpki)
+    JSON_MAP_REFERENCE(EffectTiming, branchMpki)
+    JSON_MAP_REFERENCE(EffectTiming, stalledCyclesPercent)
+    JSON_MAP_REFERENCE(EffectTiming, subnormalPercent)
+JSON_MAP_END()
+
+void EffectTimingHistogram::Reset()
+{
+    count = 0;
+    sumNs = 0;
+    minNs = UINT64_MAX;
+    maxNs = 0;
+    std::fill(std::begin(buckets), std::end(buckets), 0);
+}
+
+uint64_t EffectTimingHistogram::BucketUpperBound(size_t index)
+{
+    if (index < 4)
+    {
+        return index;
+    }
+    if (index >= BUCKETS - 1)
+    {
+        return UINT64_MAX;
+    }
+    size_t log2 = index / 4;
+    uint64_t subBucket = index % 4;
+    return ((5 + subBucket) << (log2 - 2)) - 1;
+}
+
+void EffectTimingHistogram::GetStatistics(EffectTiming *result) const
+{
+    result->periods_ = count;
+    if (count == 0)
+    {
+        result->minUs_ = result->meanUs_ = result->p99Us_ = result->maxUs_ = 0;
+        return;
+    }
+    result->minUs_ = minNs * 0.001f;
+    result->maxUs_ = maxNs * 0.001f;
+    result->meanUs_ = (float)((double)sumNs / count * 0.001);
+
+    uint64_t threshold = count - count / 100; // the 99th percentile falls in the bucket that contains this value.
+    uint64_t total = 0;
+    uint64_t p99Ns = maxNs;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        total += buckets[i];
+        if (total >= threshold)
+        {
+            p99Ns = std::min(BucketUpperBound(i), maxNs);
+            break;
+        }
+    }
+    result->p99Us_ = p99Ns * 0.001f;
+}
+
+const RealtimeEffectTimings *RealtimeEffectTimings::GetResult()
+{
+    std::copy(workingData.begin(), workingData.end(), responseData.begin());
+    for (auto &histogram : workingData)
+    {
+        histogram.Reset();
+    }
+    if (pmuCounters)
+    {
+        std::copy(workingPmu.begin(), workingPmu.end(), responsePmu.begin());
+        std::fill(workingPmu.begin(), workingPmu.end(), PmuTotals());
+    }
+    if (!workingSubnormals.empty())
+    {
+        std::copy(workingSubnormals.begin(), workingSubnormals.end(), responseSubnormals.begin());
+        std::fill(workingSubnormals.begin(), workingSubnormals.end(), 0);
+    }
+    return this;
+}
+
+void RealtimeEffectTimings::EnablePmu(std::unique_ptr<PerfCounterGroup> &&counters, pthread_t countedThread)
+{
+    this->pmuCounters = std::move(counters);
+    this->pmuThread = countedThread;
+    workingPmu.resize(instanceIds.size());
+    responsePmu.resize(instanceIds.size());
+    pmuCounters->Reset();
+    pmuCounters->Enable();
+}
+
+void RealtimeEffectTimings::EnableDenormalDetection()
+{
+    workingSubnormals.resize(instanceIds.size());
+    responseSubnormals.resize(instanceIds.size());
+}
+
+void RealtimeEffectTimings::GetPmuStatistics(const PmuTotals &totals, const PerfCounterGroup &counters, EffectTiming *result)
+{
+    result->pmu_ = true;
+    if (totals.periods == 0)
+    {
+        return;
+    }
+    auto value = [&totals](PmuEvent event)
+    { return (double)totals.values[(size_t)event]; };
+
+    double cycles = value(PmuEvent::Cycles);
+    result->cyclesPerPeriod_ = (float)(cycles / totals.periods);
+    if (!counters.HasEvent(PmuEvent::Instructions))
+    {
+        return;
+    }
+    double instructions = value(PmuEvent::Instructions);
+    result->instructionsPerPeriod_ = (float)(instructions / totals.periods);
+    if (cycles > 0)
+    {
+        result->ipc_ = (float)(instructions / cycles);
+        if (counters.HasEvent(PmuEvent::StalledCycles))
+        {
+            result->stalledCyclesPercent_ = (float)(100.0 * value(PmuEvent::StalledCycles) / cycles);
+        }
+    }
+    if (instructions > 0)
+    {
+        double kiloInstructions = instructions / 1000.0;
+        if (counters.HasEvent(PmuEvent::L1DMisses))
+        {
+            result->l1dMpki_ = (float)(value(PmuEvent::L1DMisses) / kiloInstructions);
+        }
+        if (counters.HasEvent(PmuEvent::L2Misses))
+        {
+            result->l2Mpki_ = (float)(value(PmuEvent::L2Misses) / kiloInstructions);
+        }
+        if (counters.HasEvent(PmuEvent::BranchMisses))
+        {
+            result->branchMpki_ = (float)(value(PmuEvent::BranchMisses) / kiloInstructions);
+        }
+    }
+}
+
+std::vector<EffectTiming> RealtimeEffectTimings::GetStatistics() const
+{
+    std::vector<EffectTiming> result;
+    result.resize(responseData.size());
+    for (size_t i = 0; i < responseData.size(); ++i)
+    {
+        result[i].instanceId_ = instanceIds[i];
+        responseData[i].GetStatistics(&result[i]);
+        if (pmuCounters)
+        {
+            GetPmuStatistics(responsePmu[i], *pmuCounters, &result[i]);
+        }
+        if (!responseSubnormals.empty())
+        {
+            result[i].subnormalPercent_ = result[i].periods_ == 0 ? 0 : (float)(100.0 * responseSubnormals[i] / result[i].periods_);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "json.hpp"
+#include "PerfCounterGroup.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <time.h>
+#include <pthread.h>
+
+namespace pipedal
+{
+    // Execution time statistics for one effect over an update interval.
+    class EffectTiming
+    {
+    public:
+        int64_t instanceId_ = -1;
+        uint64_t periods_ = 0;
+        float minUs_ = 0;
+        float meanUs_ = 0;
+        float p99Us_ = 0;
+        float maxUs_ = 0;
+
+        // Hardware counters (PMU profiling only). Rates are -1 if the counter isn't available.
+        bool pmu_ = false;
+        float cyclesPerPeriod_ = -1;
+        float instructionsPerPeriod_ = -1;
+        float ipc_ = -1;
+        float l1dMpki_ = -1; // misses per 1000 instructions.
+        float l2Mpki_ = -1;
+        float branchMpki_ = -1;
+        float stalledCyclesPercent_ = -1;
+
+        // Percentage of periods in which the effect's output contained subnormal values (denormal
+        // detection only); -1 if not detecting.
+        float subnormalPercent_ = -1;
+
+        DECLARE_JSON_MAP(EffectTiming);
+    };
+
+    // Timestamps for effect timing, in nanoseconds. (vDSO, so no syscall on the audio thread.)
+    inline uint64_t EffectTimingClockNs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    }
+
+    /**
+     * @brief A log-scale histogram of execution times, with four buckets per octave.
+     *
+     * Written by the audio thread only (or the realtime helper thread, for effects that run there).
+     * Fixed size, so it can be copied without allocating.
+     */
+    class EffectTimingHistogram
+    {
+    public:
+        static constexpr size_t BUCKETS = 128;
+
+        void Record(uint64_t ns)
+        {
+            ++count;
+            sumNs += ns;
+            if (ns < minNs)
+                minNs = ns;
+            if (ns > maxNs)
+                maxNs = ns;
+            ++buckets[BucketIndex(ns)];
+        }
+        void Reset();
+        void GetStatistics(EffectTiming *result) const;
+
+        static size_t BucketIndex(uint64_t ns)
+        {
+            if (ns < 4)
+            {
+                return (size_t)ns;
+            }
+            size_t log2 = 63 - __builtin_clzll(ns);
+            size_t index = log2 * 4 + ((ns >> (log2 - 2)) & 3);
+            return index < BUCKETS ? index : BUCKETS - 1;
+        }
+        // The largest value that falls into the given bucket.
+        static uint64_t BucketUpperBound(size_t index);
+
+    private:
+        uint64_t count = 0;
+        uint64_t sumNs = 0;
+        uint64_t minNs = UINT64_MAX;
+        uint64_t maxNs = 0;
+        uint32_t buckets[BUCKETS] = {};
+    };
+
+    // Per-effect timing buffers, owned by the audio thread while timing is enabled. Like RealtimeVuBuffers,
+    // the working set is copied into a response set which is sent to the host thread, and isn't touched
+    // again until the host acknowledges it.
+    class RealtimeEffectTimings
+    {
+    public:
+        // instanceIds are indexed by realtime effect index.
+        RealtimeEffectTimings(const std::vector<int64_t> &instanceIds)
+            : instanceIds(instanceIds),
+              workingData(instanceIds.size()),
+              responseData(instanceIds.size())
+        {
+        }
+
+        bool waitingForAcknowledge = false;
+
+        void Record(size_t effectIndex, uint64_t ns)
+        {
+            workingData[effectIndex].Record(ns);
+        }
+
+        // Host thread, before the subscription is handed to the audio thread. Counts are only recorded
+        // for effects that run on countedThread (the thread that counters follow), and not for effects
+        // that run on the parallel helper thread.
+        void EnablePmu(std::unique_ptr<PerfCounterGroup> &&counters, pthread_t countedThread);
+
+        // Audio thread. False if PMU profiling isn't enabled, or if not called on the counted thread.
+        bool ReadPmu(PmuSample *sample) const
+        {
+            return pmuCounters && pthread_equal(pthread_self(), pmuThread) && pmuCounters->Read(sample);
+        }
+        void RecordPmu(size_t effectIndex, const PmuSample &start, const PmuSample &end)
+        {
+            PmuTotals &totals = workingPmu[effectIndex];
+            ++totals.periods;
+            for (size_t i = 0; i < PMU_EVENT_COUNT; ++i)
+            {
+                totals.values[i] += end.values[i] - start.values[i];
+            }
+        }
+
+        // Host thread, before the subscription is handed to the audio thread.
+        void EnableDenormalDetection();
+        bool IsDetectingDenormals() const { return !workingSubnormals.empty(); }
+        // Audio thread. The effect produced subnormal output this period.
+        void RecordSubnormals(size_t effectIndex)
+        {
+            ++workingSubnormals[effectIndex];
+        }
+
+        // Audio thread.
+        const RealtimeEffectTimings *GetResult();
+        // Host thread, on the result of GetResult().
+        std::vector<EffectTiming> GetStatistics() const;
+
+    private:
+        struct PmuTotals
+        {
+            uint64_t periods = 0;
+            uint64_t values[PMU_EVENT_COUNT] = {};
+        };
+        static void GetPmuStatistics(const PmuTotals &totals, const PerfCounterGroup &counters, EffectTiming *result);
+
+        std::vector<int64_t> instanceIds;
+        std::vector<EffectTimingHistogram> workingData;
+        std::vector<EffectTimingHistogram> responseData;
+
+        std::unique_ptr<PerfCounterGroup> pmuCounters;
+        pthread_t pmuThread{};
+        std::vector<PmuTotals> workingPmu;
+        std::vector<PmuTotals> responsePmu;
+
+        std::vector<uint64_t> workingSubnormals; // periods with subnormal output.
+        std::vector<uint64_t> responseSubnormals;
+    };
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "EffectTiming.hpp"
+#include <cmath>
+
+using namespace pipedal;
+
+TEST_CASE("EffectTimingHistogram test", "[effect_timing][Build][Dev]")
+{
+    // every value lies within the bounds of its bucket.
+    for (uint64_t ns = 1; ns < 100000000; ns = ns < 100 ? ns + 1 : ns * 101 / 100)
+    {
+        size_t bucket = EffectTimingHistogram::BucketIndex(ns);
+        REQUIRE(ns <= EffectTimingHistogram::BucketUpperBound(bucket));
+        if (bucket > 8)
+        {
+            REQUIRE(ns > EffectTimingHistogram::BucketUpperBound(bucket - 1));
+        }
+    }
+
+    EffectTimingHistogram histogram;
+    for (int i = 0; i < 1000; ++i)
+    {
+        histogram.Record(i < 990 ? 1000 : 50000);
+    }
+    EffectTiming timing;
+    histogram.GetStatistics(&timing);
+    REQUIRE(timing.periods_ == 1000);
+    REQUIRE(std::abs(timing.minUs_ - 1.0f) < 1e-4f);
+    REQUIRE(std::abs(timing.maxUs_ - 50.0f) < 1e-4f);
+    REQUIRE(timing.p99Us_ >= 1.0f);
+    REQUIRE(timing.p99Us_ < 1.25f);
+
+    histogram.Reset();
+    histogram.GetStatistics(&timing);
+    REQUIRE(timing.periods_ == 0);
+}
+
+TEST_CASE("PerfCounterGroup test", "[effect_timing][Build][Dev]")
+{
+    // PMU counters may be unavailable (virtual machines, perf_event_paranoid > 2), in which case there's nothing to check.
+    PerfCounterGroup counters;
+    if (!counters.IsValid())
+    {
+        return;
+    }
+    REQUIRE(counters.HasEvent(PmuEvent::Cycles));
+
+    PmuSample start, end;
+    counters.Reset();
+    counters.Enable();
+    REQUIRE(counters.Read(&start));
+    volatile double sum = 0;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        sum = sum + std::sqrt((double)i);
+    }
+    REQUIRE(counters.Read(&end));
+    counters.Disable();
+    REQUIRE(end[PmuEvent::Cycles] > start[PmuEvent::Cycles]);
+    if (counters.HasEvent(PmuEvent::Instructions))
+    {
+        REQUIRE(end[PmuEvent::Instructions] - start[PmuEvent::Instructions] > 1000000);
+    }
+
+    RealtimeEffectTimings timings({1, 2});
+    timings.EnablePmu(std::make_unique<PerfCounterGroup>(), pthread_self());
+    PmuSample sample;
+    REQUIRE(timings.ReadPmu(&sample));
+    timings.Record(0, 1000);
+    timings.RecordPmu(0, start, end);
+    auto statistics = timings.GetResult()->GetStatistics();
+    REQUIRE(statistics.size() == 2);
+    REQUIRE(statistics[0].pmu_);
+    REQUIRE(statistics[0].cyclesPerPeriod_ > 0);
+    REQUIRE(statistics[1].cyclesPerPeriod_ == -1); // didn't run.
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "EventReactor.hpp"
+#include <atomic>
+#include <chrono>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+namespace
+{
+    template <typename PREDICATE>
+    bool WaitFor(PREDICATE predicate)
+    {
+        auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!predicate())
+        {
+            if (std::chrono::steady_clock::now() > timeout)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return true;
+    }
+}
+
+TEST_CASE("EventReactor timers", "[event_reactor][Build][Dev]")
+{
+    EventReactor reactor{"reactorTest"};
+
+    std::atomic<int> fired{0};
+    reactor.AddTimer(std::chrono::milliseconds(10), [&fired]()
+                     { ++fired; });
+    auto cancelled = reactor.AddTimer(std::chrono::milliseconds(50), [&fired]()
+                                      { fired += 100; });
+    REQUIRE(reactor.Remove(cancelled));
+    REQUIRE(!reactor.Remove(cancelled));
+
+    REQUIRE(WaitFor([&fired]()
+                    { return fired.load() != 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    REQUIRE(fired.load() == 1);
+}
+
+TEST_CASE("EventReactor fds", "[event_reactor][Build][Dev]")
+{
+    EventReactor reactor{"reactorTest"};
+
+    int fd = eventfd(0, EFD_NONBLOCK);
+    std::atomic<uint64_t> received{0};
+    auto handle = reactor.AddFd(fd, EPOLLIN, [fd, &received](uint32_t)
+                                {
+        uint64_t value;
+        if (read(fd,&value,sizeof(value)) == sizeof(value))
+        {
+            received += value;
+        } });
+
+    uint64_t value = 3;
+    std::ignore = write(fd, &value, sizeof(value));
+    REQUIRE(WaitFor([&received]()
+                    { return received.load() == 3; }));
+
+    REQUIRE(reactor.Remove(handle));
+    std::ignore = write(fd, &value, sizeof(value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    REQUIRE(received.load() == 3);
+    close(fd);
+}
@@ -0,0 +1,340 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "ExecutionPlan.hpp"
+#include "IEffect.hpp"
+#include "Lv2Effect.hpp"
+#include "SplitEffect.hpp"
+#include "SilenceGate.hpp"
+#include "EffectTiming.hpp"
+#include "RealtimeTripwire.hpp"
+#include "Tracer.hpp"
+#include "Denormals.hpp"
+#include "RealtimeWatchdog.hpp"
+#include <algorithm>
+#include <sys/mman.h>
+
+using namespace pipedal;
+
+ExecutionPlan::~ExecutionPlan()
+{
+    Free();
+}
+
+void ExecutionPlan::Free()
+{
+    if (steps)
+    {
+#ifndef NO_MLOCK
+        if (mlocked)
+        {
+            munlock(steps, nSteps * sizeof(PlanStep));
+            mlocked = false;
+        }
+#endif
+        delete[] steps;
+        steps = nullptr;
+    }
+    nSteps = 0;
+}
+
+void ExecutionPlan::AddRunEffect(IEffect *effect, int32_t timingIndex, const char *traceName)
+{
+    PlanStep step{PlanOpcode::RunEffect};
+    step.target = effect;
+    step.timingIndex = timingIndex;
+    step.instanceId = (int64_t)effect->GetInstanceId();
+    step.traceName = traceName;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::AddRunLv2Effect(Lv2Effect *effect, bool withBufferStaging, int32_t timingIndex, const char *traceName)
+{
+    PlanStep step{withBufferStaging ? PlanOpcode::RunLv2EffectWithBufferStaging : PlanOpcode::RunLv2Effect};
+    step.target = effect;
+    step.timingIndex = timingIndex;
+    step.instanceId = (int64_t)effect->GetInstanceId();
+    step.traceName = traceName;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::AddRunSilenceGate(SilenceGate *gate, int32_t timingIndex, const char *traceName)
+{
+    PlanStep step{PlanOpcode::RunSilenceGate};
+    step.target = gate;
+    step.timingIndex = timingIndex;
+    step.instanceId = (int64_t)gate->GetEffect()->GetInstanceId();
+    step.traceName = traceName;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::AddSplitPreMix(SplitEffect *split)
+{
+    PlanStep step{PlanOpcode::SplitPreMix};
+    step.target = split;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::AddSplitPostMix(SplitEffect *split)
+{
+    PlanStep step{PlanOpcode::SplitPostMix};
+    step.target = split;
+    pendingSteps.push_back(step);
+}
+
+size_t ExecutionPlan::AddSplitChainGate(SplitEffect *split, bool topChain)
+{
+    PlanStep step{PlanOpcode::SplitChainGate};
+    step.target = split;
+    step.controlIndex = topChain ? 1 : 0;
+    pendingSteps.push_back(step);
+    return pendingSteps.size() - 1;
+}
+
+void ExecutionPlan::EndSplitChainGate(size_t gateIndex)
+{
+    pendingSteps[gateIndex].jumpSteps = (int32_t)(pendingSteps.size() - gateIndex - 1);
+}
+
+void ExecutionPlan::AddSetControl(IEffect *effect, int32_t controlIndex, float value)
+{
+    PlanStep step{PlanOpcode::SetControl};
+    step.target = effect;
+    step.controlIndex = controlIndex;
+    step.value = value;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::AddCall(PlanStep::CallFn fn, void *data)
+{
+    PlanStep step{PlanOpcode::Call};
+    step.fn = fn;
+    step.target = data;
+    pendingSteps.push_back(step);
+}
+
+void ExecutionPlan::Seal(bool mLock)
+{
+    Free();
+    nSteps = pendingSteps.size();
+    if (nSteps != 0)
+    {
+        steps = new PlanStep[nSteps];
+        for (size_t i = 0; i < nSteps; ++i)
+        {
+            steps[i] = pendingSteps[i];
+        }
+#ifndef NO_MLOCK
+        if (mLock)
+        {
+            // best effort. mlockall() will usually have locked it already.
+            this->mlocked = mlock(steps, nSteps * sizeof(PlanStep)) == 0;
+        }
+#endif
+    }
+    pendingSteps.clear();
+    pendingSteps.shrink_to_fit();
+}
+
+void ExecutionPlan::Execute(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter, RealtimeEffectTimings *timings) const
+{
+    if (timings)
+    {
+        ExecuteSteps<true>(frames, realtimeRingBufferWriter, timings);
+    }
+    else
+    {
+        ExecuteSteps<false>(frames, realtimeRingBufferWriter, nullptr);
+    }
+}
+
+// The effect run by a RunEffect/RunLv2Effect/RunSilenceGate step; otherwise nullptr.
+static IEffect *StepEffect(const PlanStep &step)
+{
+    switch (step.opcode)
+    {
+    case PlanOpcode::RunEffect:
+        return (IEffect *)step.target;
+    case PlanOpcode::RunLv2Effect:
+    case PlanOpcode::RunLv2EffectWithBufferStaging:
+        return (Lv2Effect *)step.target;
+    case PlanOpcode::RunSilenceGate:
+        return ((SilenceGate *)step.target)->GetEffect();
+    default:
+        return nullptr;
+    }
+}
+
+// True if an effect in the steps has input messages that would be lost if it weren't run this period.
+static bool HasPendingInputMessages(const PlanStep *begin, const PlanStep *end)
+{
+    for (const PlanStep *p = begin; p != end; ++p)
+    {
+        IEffect *effect = StepEffect(*p);
+        if (effect && effect->HasPendingInputMessages())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Denormal detection: true if the effect run by the step left subnormals in its output buffers.
+static bool HasSubnormalOutput(const PlanStep &step, uint32_t frames)
+{
+    IEffect *effect = StepEffect(step);
+    if (!effect)
+    {
+        return false;
+    }
+    for (int i = 0; i < effect->GetNumberOfOutputAudioBuffers(); ++i)
+    {
+        if (Denormals::HasSubnormals(effect->GetAudioOutputBuffer(i), frames))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// In place of running an effect that the watchdog has marked as hung: outputs are copied from the
+// corresponding (or last) input, or silenced if the effect has no inputs.
+static void RunSkippedEffect(const PlanStep &step, uint32_t frames)
+{
+    IEffect *effect = StepEffect(step);
+    int inputs = effect->GetNumberOfInputAudioBuffers();
+    for (int i = 0; i < effect->GetNumberOfOutputAudioBuffers(); ++i)
+    {
+        float *output = effect->GetAudioOutputBuffer(i);
+        if (inputs == 0)
+        {
+            std::fill(output, output + frames, 0.0f);
+        }
+        else
+        {
+            float *input = effect->GetAudioInputBuffer(std::min(i, inputs - 1));
+            if (input != output)
+            {
+                std::copy(input, input + frames, output);
+            }
+        }
+    }
+}
+
+template <bool TIMED>
+void ExecutionPlan::ExecuteSteps(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter, RealtimeEffectTimings *timings) const
+{
+    const PlanStep *p = steps;
+    const PlanStep *end = steps + nSteps;
+    const bool tracing = Tracer::IsEnabled();
+    for (; p != end; ++p)
+    {
+        if (p->instanceId != -1 && RealtimeWatchdog::IsSkipped(p->target, p->instanceId))
+        {
+            RunSkippedEffect(*p, frames);
+            continue;
+        }
+        RealtimeWatchdog::EffectScope watchdogScope(p->instanceId != -1 ? p->target : nullptr, p->instanceId);
+        uint64_t traceStartNs = 0;
+        if (tracing && p->traceName)
+        {
+            traceStartNs = Tracer::Now();
+        }
+        uint64_t startNs = 0;
+        PmuSample pmuStart;
+        bool pmu = false;
+        if (TIMED && p->timingIndex >= 0)
+        {
+            pmu = timings->ReadPmu(&pmuStart);
+            startNs = EffectTimingClockNs();
+        }
+        switch (p->opcode)
+        {
+        case PlanOpcode::RunEffect:
+        {
+            RealtimeTripwire::EffectScope tripwireScope((IEffect *)p->target);
+            ((IEffect *)p->target)->Run(frames, realtimeRingBufferWriter);
+            break;
+        }
+        case PlanOpcode::RunLv2Effect:
+        {
+            RealtimeTripwire::EffectScope tripwireScope((Lv2Effect *)p->target);
+            ((Lv2Effect *)p->target)->Lv2Effect::Run(frames, realtimeRingBufferWriter);
+            break;
+        }
+        case PlanOpcode::RunLv2EffectWithBufferStaging:
+        {
+            RealtimeTripwire::EffectScope tripwireScope((Lv2Effect *)p->target);
+            ((Lv2Effect *)p->target)->Lv2Effect::RunWithBufferStaging(frames, realtimeRingBufferWriter);
+            break;
+        }
+        case PlanOpcode::RunSilenceGate:
+        {
+            RealtimeTripwire::EffectScope tripwireScope(((SilenceGate *)p->target)->GetEffect());
+            ((SilenceGate *)p->target)->Run(frames, realtimeRingBufferWriter);
+            break;
+        }
+        case PlanOpcode::SplitPreMix:
+            ((SplitEffect *)p->target)->PreMix(frames);
+            break;
+        case PlanOpcode::SplitPostMix:
+            ((SplitEffect *)p->target)->PostMix(frames);
+            break;
+        case PlanOpcode::SplitChainGate:
+        {
+            SplitEffect *split = (SplitEffect *)p->target;
+            bool topChain = p->controlIndex != 0;
+            if (split->IsChainDormant(topChain))
+            {
+                if (!HasPendingInputMessages(p + 1, p + 1 + p->jumpSteps))
+                {
+                    p += p->jumpSteps;
+                    continue;
+                }
+                // run the chain on silence so that its effects receive their messages. (Its output isn't mixed.)
+                split->SilenceChainInputs(topChain, frames);
+            }
+            break;
+        }
+        case PlanOpcode::SetControl:
+            ((IEffect *)p->target)->SetControl(p->controlIndex, p->value);
+            break;
+        case PlanOpcode::Call:
+            p->fn(p->target, frames);
+            break;
+        }
+        if (TIMED && p->timingIndex >= 0)
+        {
+            timings->Record((size_t)p->timingIndex, EffectTimingClockNs() - startNs);
+            PmuSample pmuEnd;
+            if (pmu && timings->ReadPmu(&pmuEnd))
+            {
+                timings->RecordPmu((size_t)p->timingIndex, pmuStart, pmuEnd);
+            }
+            if (timings->IsDetectingDenormals() && HasSubnormalOutput(*p, frames))
+            {
+                timings->RecordSubnormals((size_t)p->timingIndex);
+            }
+        }
+        if (tracing && p->traceName)
+        {
+            Tracer::Complete("effect", p->traceName, traceStartNs, Tracer::Now());
+        }
+    }
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace pipedal
+{
+    class IEffect;
+    class Lv2Effect;
+    class SplitEffect;
+    class SilenceGate;
+    class RealtimeRingBufferWriter;
+    class RealtimeEffectTimings;
+
+    enum class PlanOpcode : uint8_t
+    {
+        RunEffect,                     // IEffect::Run (virtual).
+        RunLv2Effect,                  // Lv2Effect::Run, called directly.
+        RunLv2EffectWithBufferStaging, // Lv2Effect::RunWithBufferStaging.
+        RunSilenceGate,                // SilenceGate::Run, which skips the effect while it is idle.
+        SplitPreMix,
+        SplitPostMix,
+        SplitChainGate,                // skips the split chain that follows while the split has made it dormant, unless its effects have input messages.
+        SetControl,                    // reset a trigger control to its default value.
+        Call,                          // plain function pointer.
+    };
+
+    struct PlanStep
+    {
+        using CallFn = void (*)(void *data, uint32_t frames);
+
+        PlanOpcode opcode;
+        int32_t controlIndex = 0;      // SetControl; for SplitChainGate, 1 for the top chain, 0 for the bottom chain.
+        int32_t jumpSteps = 0;         // SplitChainGate: the number of steps in the chain.
+        float value = 0;
+        int32_t timingIndex = -1; // realtime effect index, for RunEffect/RunLv2Effect steps.
+        void *target = nullptr;
+        CallFn fn = nullptr;
+        const char *traceName = nullptr; // Tracer event name, for effect steps.
+        int64_t instanceId = -1;         // for RunEffect/RunLv2Effect/RunSilenceGate steps.
+    };
+
+    /**
+     * @brief A flat list of processing steps for a pedalboard, executed by a switch-based interpreter.
+     *
+     * Steps are appended while the pedalboard is being prepared. Seal() then copies them
+     * into a single contiguous (and if possible, mlocked) block which Execute() walks on the
+     * audio thread. Audio buffers are bound to the effects during preparation, so steps
+     * don't need to carry buffer pointers.
+     */
+    class ExecutionPlan
+    {
+    public:
+        ExecutionPlan() {}
+        ~ExecutionPlan();
+
+        ExecutionPlan(const ExecutionPlan &) = delete;
+        ExecutionPlan &operator=(const ExecutionPlan &) = delete;
+
+        // traceName: a string literal or Tracer::Intern()ed string, or nullptr to not trace the step.
+        void AddRunEffect(IEffect *effect, int32_t timingIndex = -1, const char *traceName = nullptr);
+        void AddRunLv2Effect(Lv2Effect *effect, bool withBufferStaging, int32_t timingIndex = -1, const char *traceName = nullptr);
+        void AddRunSilenceGate(SilenceGate *gate, int32_t timingIndex = -1, const char *traceName = nullptr);
+        void AddSplitPreMix(SplitEffect *split);
+        void AddSplitPostMix(SplitEffect *split);
+        // Returns the index of the gate step, to be passed to EndSplitChainGate() once the chain's steps have been added.
+        size_t AddSplitChainGate(SplitEffect *split, bool topChain);
+        void EndSplitChainGate(size_t gateIndex);
+        void AddSetControl(IEffect *effect, int32_t controlIndex, float value);
+        void AddCall(PlanStep::CallFn fn, void *data);
+
+        // Must be called after the last step has been added, and before Execute().
+        void Seal(bool mLock = true);
+
+        size_t size() const { return nSteps; }
+        const PlanStep &operator[](size_t index) const { return steps[index]; }
+
+        // Audio thread. If timings is non-null, the execution time of each effect is recorded.
+        void Execute(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter, RealtimeEffectTimings *timings = nullptr) const;
+
+    private:
+        template <bool TIMED>
+        void ExecuteSteps(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter, RealtimeEffectTimings *timings) const;
+        void Free();
+
+        std::vector<PlanStep> pendingSteps;
+        PlanStep *steps = nullptr;
+        size_t nSteps = 0;
+        bool mlocked = false;
+    };
+}
@@ -0,0 +1,385 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <iostream>
+#include "ExecutionPlan.hpp"
+#include "IEffect.hpp"
+#include "SplitEffect.hpp"
+#include "SilenceGate.hpp"
+#include "RealtimeWatchdog.hpp"
+#include "EffectTiming.hpp"
+#include "Denormals.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    // A minimal effect that applies a gain, so that per-stage dispatch cost dominates.
+    class GainEffect : public IEffect
+    {
+    public:
+        GainEffect(float *input, float *output) : input(input), output(output) {}
+
+        float gain = 0.999f;
+        float *input;
+        float *output;
+        uint32_t runCount = 0;
+        uint64_t instanceId = 0;
+        std::chrono::milliseconds runDelay{0}; // simulates a hung plugin.
+        bool messagePending = false; // an atom input message, received when the effect runs.
+        uint32_t messagesReceived = 0;
+
+        virtual uint64_t GetInstanceId() const override { return instanceId; }
+        virtual bool IsLv2Effect() const override { return false; }
+        virtual uint64_t GetMaxInputControl() const override { return 1; }
+        virtual bool IsInputControl(uint64_t index) const override { return index == 0; }
+        virtual float GetDefaultInputControlValue(uint64_t index) const override { return 1; }
+        virtual int GetControlIndex(const std::string &symbol) const override { return 0; }
+        virtual void SetControl(int index, float value) override { gain = value; }
+        virtual void SetPatchProperty(LV2_URID uridUri, size_t size, LV2_Atom *value) override {}
+        virtual void RequestPatchProperty(LV2_URID uridUri) override {}
+        virtual void RequestAllPathPatchProperties() override {}
+        virtual float GetControlValue(int index) const override { return gain; }
+        virtual void SetBypass(bool enable) override {}
+        virtual float GetOutputControlValue(int controlIndex) const override { return 0; }
+        virtual int GetNumberOfInputAudioPorts() const override { return 1; }
+        virtual int GetNumberOfOutputAudioPorts() const override { return 1; }
+        virtual int GetNumberOfInputAudioBuffers() const override { return 1; }
+        virtual int GetNumberOfOutputAudioBuffers() const override { return 1; }
+        virtual float *GetAudioInputBuffer(int index) const override { return input; }
+        virtual float *GetAudioOutputBuffer(int index) const override { return output; }
+        virtual void ResetAtomBuffers() override { messagePending = false; }
+        virtual bool HasPendingInputMessages() const override { return messagePending; }
+        virtual bool GetRequestStateChangedNotification() const override { return false; }
+        virtual void SetRequestStateChangedNotification(bool value) override {}
+        virtual void PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize) override {}
+        virtual void SetAudioInputBuffer(int index, float *buffer) override { input = buffer; }
+        virtual void SetAudioOutputBuffer(int index, float *buffer) override { output = buffer; }
+        virtual void Activate() override {}
+        virtual void Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter) override
+        {
+            ++runCount;
+            if (runDelay.count() != 0)
+            {
+                std::this_thread::sleep_for(runDelay);
+            }
+            if (messagePending)
+            {
+                ++messagesReceived;
+                messagePending = false;
+            }
+            for (uint32_t i = 0; i < samples; ++i)
+            {
+                output[i] = input[i] * gain;
+            }
+        }
+        virtual void Deactivate() override {}
+        virtual bool IsVst3() const override { return false; }
+        virtual bool GetLv2State(Lv2PluginState *state) override { return false; }
+        virtual void SetLv2State(Lv2PluginState &state) override {}
+        virtual bool HasErrorMessage() const override { return false; }
+        virtual const char *TakeErrorMessage() override { return nullptr; }
+    };
+
+    class EffectChain
+    {
+    public:
+        EffectChain(size_t nEffects, uint32_t frames)
+            : buffers(nEffects + 1, std::vector<float>(frames, 1.0f))
+        {
+            for (size_t i = 0; i < nEffects; ++i)
+            {
+                effects.push_back(std::make_unique<GainEffect>(buffers[i].data(), buffers[i + 1].data()));
+            }
+        }
+        std::vector<std::vector<float>> buffers;
+        std::vector<std::unique_ptr<GainEffect>> effects;
+    };
+
+    void CountCall(void *data, uint32_t frames)
+    {
+        (*(uint32_t *)data) += frames;
+    }
+}
+
+TEST_CASE("ExecutionPlan test", "[execution_plan][Build][Dev]")
+{
+    constexpr uint32_t FRAMES = 16;
+    EffectChain chain(3, FRAMES);
+
+    uint32_t callCount = 0;
+    ExecutionPlan plan;
+    for (auto &effect : chain.effects)
+    {
+        plan.AddRunEffect(effect.get());
+        plan.AddSetControl(effect.get(), 0, 0.5f);
+    }
+    plan.AddCall(&CountCall, &callCount);
+    REQUIRE(plan.size() == 0); // not visible until sealed.
+    plan.Seal(false);
+    REQUIRE(plan.size() == 7);
+    REQUIRE(plan[0].opcode == PlanOpcode::RunEffect);
+    REQUIRE(plan[1].opcode == PlanOpcode::SetControl);
+    REQUIRE(plan[6].opcode == PlanOpcode::Call);
+
+    plan.Execute(FRAMES, nullptr);
+
+    for (auto &effect : chain.effects)
+    {
+        REQUIRE(effect->runCount == 1);
+        REQUIRE(effect->gain == 0.5f);
+    }
+    REQUIRE(callCount == FRAMES);
+    // steps execute in order: the first pass runs at the initial gain.
+    REQUIRE(chain.buffers[3][0] == 0.999f * 0.999f * 0.999f);
+
+    plan.Execute(FRAMES, nullptr);
+    REQUIRE(chain.buffers[3][0] == 0.125f);
+    REQUIRE(callCount == FRAMES * 2);
+}
+
+TEST_CASE("ExecutionPlan skips dormant split chains", "[execution_plan][Build][Dev]")
+{
+    constexpr uint32_t FRAMES = 64;
+    std::vector<float> input(FRAMES, 1.0f), output(FRAMES);
+    EffectChain top(2, FRAMES);
+    EffectChain bottom(1, FRAMES);
+    for (auto &effect : bottom.effects)
+    {
+        effect->gain = 0.5f;
+    }
+
+    SplitEffect split(1, 48000, {input.data()});
+    split.SetChainBuffers({top.buffers[0].data()}, {bottom.buffers[0].data()}, {top.buffers[2].data()}, {bottom.buffers[1].data()}, false);
+    split.SetAudioOutputBuffer(0, output.data());
+    split.Activate(); // A/B, with A selected.
+
+    ExecutionPlan plan;
+    plan.AddSplitPreMix(&split);
+    size_t gate = plan.AddSplitChainGate(&split, true);
+    for (auto &effect : top.effects)
+    {
+        plan.AddRunEffect(effect.get());
+    }
+    plan.EndSplitChainGate(gate);
+    gate = plan.AddSplitChainGate(&split, false);
+    for (auto &effect : bottom.effects)
+    {
+        plan.AddRunEffect(effect.get());
+    }
+    plan.EndSplitChainGate(gate);
+    plan.AddSplitPostMix(&split);
+    plan.Seal(false);
+
+    plan.Execute(FRAMES, nullptr);
+    REQUIRE(top.effects[1]->runCount == 1);
+    REQUIRE(bottom.effects[0]->runCount == 0);
+    REQUIRE(output[0] == 0.999f * 0.999f);
+
+    // selecting B wakes the bottom chain, which warms up before the crossfade; then the top chain goes dormant.
+    split.SetControl(SplitEffect::SELECT_CTL, 1);
+    REQUIRE(!split.IsChainDormant(false));
+    for (int i = 0; i < 1000 && !split.IsChainDormant(true); ++i)
+    {
+        plan.Execute(FRAMES, nullptr);
+    }
+    REQUIRE(split.IsChainDormant(true));
+    uint32_t topRuns = top.effects[1]->runCount;
+    plan.Execute(FRAMES, nullptr);
+    REQUIRE(top.effects[1]->runCount == topRuns);
+    REQUIRE(top.effects[0]->runCount == topRuns);
+    REQUIRE(output[0] == 0.5f);
+
+    // a message for an effect in the dormant chain runs the chain (on silence) for one period, so that it isn't lost.
+    top.effects[1]->messagePending = true;
+    plan.Execute(FRAMES, nullptr);
+    top.effects[1]->ResetAtomBuffers();
+    REQUIRE(top.effects[1]->messagesReceived == 1);
+    REQUIRE(top.effects[1]->runCount == topRuns + 1);
+    REQUIRE(top.buffers[0][0] == 0.0f);
+    REQUIRE(output[0] == 0.5f);
+    REQUIRE(split.IsChainDormant(true));
+    plan.Execute(FRAMES, nullptr);
+    REQUIRE(top.effects[1]->runCount == topRuns + 1);
+}
+
+TEST_CASE("ExecutionPlan keeps split chains with sidechain sources running", "[execution_plan][Build][Dev]")
+{
+    constexpr uint32_t FRAMES = 64;
+    std::vector<float> input(FRAMES, 1.0f), output(FRAMES);
+    EffectChain top(1, FRAMES);
+    EffectChain bottom(1, FRAMES);
+
+    SplitEffect split(1, 48000, {input.data()});
+    split.SetChainBuffers({top.buffers[0].data()}, {bottom.buffers[0].data()}, {top.buffers[1].data()}, {bottom.buffers[1].data()}, false);
+    split.SetAudioOutputBuffer(0, output.data());
+    // the top chain's output is read by a sidechain outside the split.
+    split.SetChainCanBeDormant(true, false);
+    split.Activate();
+
+    ExecutionPlan plan;
+    plan.AddSplitPreMix(&split);
+    size_t gate = plan.AddSplitChainGate(&split, true);
+    plan.AddRunEffect(top.effects[0].get());
+    plan.EndSplitChainGate(gate);
+    gate = plan.AddSplitChainGate(&split, false);
+    plan.AddRunEffect(bottom.effects[0].get());
+    plan.EndSplitChainGate(gate);
+    plan.AddSplitPostMix(&split);
+    plan.Seal(false);
+
+    plan.Execute(FRAMES, nullptr);
+    REQUIRE(bottom.effects[0]->runCount == 0);
+
+    split.SetControl(SplitEffect::SELECT_CTL, 1);
+    for (int i = 0; i < 1000; ++i)
+    {
+        plan.Execute(FRAMES, nullptr);
+    }
+    REQUIRE(!split.IsChainDormant(true));
+    REQUIRE(top.effects[0]->runCount == 1001);
+    REQUIRE(top.buffers[1][0] == 0.999f); // not stale.
+    REQUIRE(output[0] == 0.999f);
+}
+
+TEST_CASE("ExecutionPlan skips hung gated effects", "[execution_plan][Build][Dev]")
+{
+    constexpr uint32_t FRAMES = 64;
+    std::vector<float> input(FRAMES, 0.5f), output(FRAMES);
+    GainEffect effect(input.data(), output.data());
+    effect.instanceId = 42;
+    effect.runDelay = std::chrono::milliseconds(300);
+    SilenceGate gate(&effect, false, 48000);
+
+    ExecutionPlan plan;
+    plan.AddRunSilenceGate(&gate);
+    plan.Seal(false);
+
+    std::atomic<int64_t> hungInstanceId{-1};
+    RealtimeWatchdog::Start(0.05, [&](const RealtimeWatchdog::HungEffect &hungEffect)
+                            { hungInstanceId = hungEffect.instanceId; });
+    std::thread audioThread([&]()
+                            {
+        RealtimeWatchdog::AttachThread("testAudio");
+        for (int i = 0; i < 2; ++i)
+        {
+            RealtimeWatchdog::PeriodScope periodScope;
+            plan.Execute(FRAMES, nullptr);
+        } });
+    audioThread.join();
+    RealtimeWatchdog::Stop();
+
+    REQUIRE(hungInstanceId == 42);
+    // the second period passed the input through instead of running the effect.
+    REQUIRE(effect.runCount == 1);
+    REQUIRE(output[0] == 0.5f);
+    RealtimeWatchdog::ClearSkipped(42);
+}
+
+TEST_CASE("ExecutionPlan detects subnormals from gated effects", "[execution_plan][Build][Dev]")
+{
+    constexpr uint32_t FRAMES = 64;
+    bool flushToZero = Denormals::GetThreadFlushToZero();
+    Denormals::SetThreadFlushToZero(false);
+
+    // the tail of a decaying reverb.
+    std::vector<float> input(FRAMES, 1e-39f), output(FRAMES);
+    GainEffect effect(input.data(), output.data());
+    SilenceGate gate(&effect, false, 48000);
+
+    ExecutionPlan plan;
+    plan.AddRunSilenceGate(&gate, 0);
+    plan.Seal(false);
+
+    RealtimeEffectTimings timings({1});
+    timings.EnableDenormalDetection();
+    plan.Execute(FRAMES, nullptr, &timings);
+    Denormals::SetThreadFlushToZero(flushToZero);
+
+    REQUIRE(effect.runCount == 1);
+    REQUIRE(timings.GetResult()->GetStatistics()[0].subnormalPercent_ == 100);
+}
+
+TEST_CASE("ExecutionPlan benchmark", "[execution_plan_benchmark][Dev]")
+{
+    using namespace std::chrono;
+    constexpr uint32_t FRAMES = 64;
+    constexpr size_t N_EFFECTS = 24;
+    constexpr int ITERATIONS = 200000;
+
+    EffectChain chain(N_EFFECTS, FRAMES);
+
+    // the previous implementation: a vector of std::function.
+    std::vector<std::function<void(uint32_t)>> processActions;
+    for (auto &effect : chain.effects)
+    {
+        IEffect *pEffect = effect.get();
+        processActions.push_back(
+            [pEffect](uint32_t frames)
+            {
+                pEffect->Run(frames, nullptr);
+            });
+        processActions.push_back(
+            [pEffect](uint32_t frames)
+            {
+                pEffect->SetControl(0, 0.999f);
+            });
+    }
+
+    ExecutionPlan plan;
+    for (auto &effect : chain.effects)
+    {
+        plan.AddRunEffect(effect.get());
+        plan.AddSetControl(effect.get(), 0, 0.999f);
+    }
+    plan.Seal();
+
+    auto start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        for (size_t a = 0; a < processActions.size(); ++a)
+        {
+            processActions[a](FRAMES);
+        }
+    }
+    auto functionTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        plan.Execute(FRAMES, nullptr);
+    }
+    auto planTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    cout << "ExecutionPlan benchmark (" << N_EFFECTS << " effects, " << FRAMES << " frames)" << endl;
+    cout << "    std::function: " << (functionTime / (double)ITERATIONS) << " ns/period" << endl;
+    cout << "    ExecutionPlan: " << (planTime / (double)ITERATIONS) << " ns/period" << endl;
+
+    REQUIRE(chain.effects[0]->runCount == ITERATIONS * 2);
+}
@@ -18,6 +18,7 @@
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "FileEntry.hpp"
+#include "PagedListing.hpp"
 
 using namespace pipedal;
 
@@ -40,4 +41,15 @@ JSON_MAP_BEGIN(FileRequestResult)
     JSON_MAP_REFERENCE(FileRequestResult,isProtected)
     JSON_MAP_REFERENCE(FileRequestResult,breadcrumbs)
     JSON_MAP_REFERENCE(FileRequestResult,currentDirectory)
+    JSON_MAP_REFERENCE(FileRequestResult,totalFiles)
+    JSON_MAP_REFERENCE(FileRequestResult,continuationToken)
 JSON_MAP_END()
+
+void FileRequestResult::SelectPage(const std::string &sortKey, uint64_t pageSize, const std::string &continuationToken)
+{
+    totalFiles_ = files_.size();
+    continuationToken_ = paged_listing::SelectPage(
+        files_, sortKey, (size_t)pageSize, continuationToken,
+        [](const FileEntry &file) -> const std::string &
+        { return file.pathname_; });
+}
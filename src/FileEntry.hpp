@@ -62,6 +62,13 @@ namespace pipedal {
         bool isProtected_ = false;
         std::vector<BreadcrumbEntry> breadcrumbs_;
         std::string currentDirectory_;
+        uint64_t totalFiles_ = 0;
+        // Requests the next page. Empty on the last page.
+        std::string continuationToken_;
+
+        // Keeps only the files on the page that follows continuationToken (pageSize 0: all remaining files).
+        // See PagedListing.hpp.
+        void SelectPage(const std::string &sortKey, uint64_t pageSize, const std::string &continuationToken);
         DECLARE_JSON_MAP(FileRequestResult);
 
     };
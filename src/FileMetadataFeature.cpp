@@ -144,7 +144,15 @@ uint32_t FileMetadataFeature::getFileMetadata(
 
     try
     {
-        if (fs::exists(path))
+        if (strcmp(key, PIPEDAL__FILE_METADATA_DECODED_FILE_KEY) == 0)
+        {
+            result = AudioDirectoryInfo::GetDecodedAudioFile(absolute_path).string();
+            if (result.empty())
+            {
+                return 0;
+            }
+        }
+        else if (fs::exists(path))
         {
             std::ifstream f(path);
             json_reader reader(f);
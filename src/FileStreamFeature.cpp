@@ -0,0 +1,585 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "FileStreamFeature.hpp"
+#include "SchedulerPriority.hpp"
+#include "Futex.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+// Largest single read performed by the i/o thread, so that a seek doesn't wait behind a long read.
+static constexpr uint64_t MAX_READ_CHUNK = 64 * 1024;
+// How often the i/o thread polls streams when it hasn't been woken.
+static constexpr std::chrono::milliseconds IO_POLL_INTERVAL{20};
+
+static PIPEDAL_FileStream_Status ErrnoStatus(int error)
+{
+    switch (error)
+    {
+    case ENOENT:
+    case ENOTDIR:
+    case ENAMETOOLONG:
+    case ELOOP:
+        return PIPEDAL_FILE_STREAM_INVALID_PATH;
+    case EACCES:
+    case EPERM:
+        return PIPEDAL_FILE_STREAM_PERMISSION_DENIED;
+    default:
+        return PIPEDAL_FILE_STREAM_ERR_UNKNOWN;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Stream
+
+FileStreamFeature::Stream::Stream(int fd, const std::string &path, uint64_t fileSize, uint64_t readAheadBytes, uint64_t cueWindowBytes)
+    : fd(fd), path(path), fileSize(fileSize), ring(readAheadBytes)
+{
+    for (auto &cue : cues)
+    {
+        cue.data.resize(cueWindowBytes);
+    }
+    // Cue point 0 is the start of the file; the read-ahead window starts where it ends.
+    cues[0].requestSequence.store(1);
+    uint64_t fillStart = std::min(fileSize, cueWindowBytes);
+    pendingFillStart.store(fillStart);
+    seekGeneration.store(1);
+    ringStart = fillStart;
+    activeCue = 0;
+}
+
+FileStreamFeature::Stream::~Stream()
+{
+    munlock(ring.data(), ring.size());
+    for (auto &cue : cues)
+    {
+        munlock(cue.data.data(), cue.data.size());
+    }
+    if (fd != -1)
+    {
+        close(fd);
+    }
+}
+
+void FileStreamFeature::Stream::LockMemory(bool *warned)
+{
+    // Keep the buffers resident, so that the realtime thread never takes a page fault on them.
+    bool locked = mlock(ring.data(), ring.size()) == 0;
+    for (auto &cue : cues)
+    {
+        locked = locked && mlock(cue.data.data(), cue.data.size()) == 0;
+    }
+    if (!locked && !*warned)
+    {
+        *warned = true;
+        Lv2Log::warning(SS("FileStreamFeature: Can't lock stream buffers in memory. (" << strerror(errno) << ")"));
+    }
+}
+
+void FileStreamFeature::Stream::StartSeek(uint64_t fillStart)
+{
+    pendingFillStart.store(fillStart, std::memory_order_relaxed);
+    seekGeneration.store(seekGeneration.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    ringStart = fillStart;
+}
+
+void FileStreamFeature::Stream::Seek(uint64_t newPosition)
+{
+    newPosition = std::min(newPosition, fileSize);
+    seeks.fetch_add(1, std::memory_order_relaxed);
+
+    if (activeCue != -1)
+    {
+        const CueWindow &cue = cues[activeCue];
+        if (IsCueReady(cue) && newPosition >= cue.loadedPosition && newPosition < cue.loadedPosition + cue.loadedBytes)
+        {
+            position = newPosition;
+            readPosition.store(position, std::memory_order_release);
+            return;
+        }
+    }
+    // Forward, within the read-ahead window? (Backward seeks may land on data the i/o thread is overwriting.)
+    else if (IsRingValid() && newPosition >= position && newPosition < filledEnd.load(std::memory_order_acquire))
+    {
+        position = newPosition;
+        readPosition.store(position, std::memory_order_release);
+        return;
+    }
+    position = newPosition;
+    readPosition.store(position, std::memory_order_release);
+
+    activeCue = -1;
+    for (uint32_t i = 0; i < MAX_CUE_POINTS; ++i)
+    {
+        CueWindow &cue = cues[i];
+        if (IsCueReady(cue) && newPosition >= cue.loadedPosition && newPosition < cue.loadedPosition + cue.loadedBytes)
+        {
+            activeCue = (int)i;
+            cueHits.fetch_add(1, std::memory_order_relaxed);
+            // refill the read-ahead window from the end of the cue window.
+            StartSeek(cue.loadedPosition + cue.loadedBytes);
+            return;
+        }
+    }
+    StartSeek(newPosition);
+}
+
+PIPEDAL_FileStream_Status FileStreamFeature::Stream::SetCuePoint(uint32_t cueIndex, uint64_t cuePosition)
+{
+    if (cueIndex >= MAX_CUE_POINTS || cuePosition > fileSize)
+    {
+        return PIPEDAL_FILE_STREAM_INVALID_PARAMETER;
+    }
+    CueWindow &cue = cues[cueIndex];
+    if (IsCueReady(cue) && cue.loadedPosition == cuePosition)
+    {
+        return PIPEDAL_FILE_STREAM_SUCCESS;
+    }
+    if (activeCue == (int)cueIndex)
+    {
+        // the read-ahead window doesn't cover the rest of the cue window, so resynchronize it.
+        activeCue = -1;
+        StartSeek(position);
+    }
+    cue.requestedPosition.store(cuePosition, std::memory_order_relaxed);
+    cue.requestSequence.store(cue.requestSequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return PIPEDAL_FILE_STREAM_SUCCESS;
+}
+
+uint64_t FileStreamFeature::Stream::Available() const
+{
+    uint64_t result = 0;
+    uint64_t p = position;
+    if (activeCue != -1)
+    {
+        const CueWindow &cue = cues[activeCue];
+        if (IsCueReady(cue) && p >= cue.loadedPosition && p < cue.loadedPosition + cue.loadedBytes)
+        {
+            result = cue.loadedPosition + cue.loadedBytes - p;
+            p += result;
+        }
+    }
+    if (IsRingValid() && p >= ringStart)
+    {
+        uint64_t end = filledEnd.load(std::memory_order_acquire);
+        if (end > p)
+        {
+            result += end - p;
+        }
+    }
+    return result;
+}
+
+uint64_t FileStreamFeature::Stream::Read(void *buffer, uint64_t bytes)
+{
+    uint8_t *output = (uint8_t *)buffer;
+    uint64_t copied = 0;
+    bytes = std::min(bytes, fileSize - position);
+    while (copied < bytes)
+    {
+        uint64_t remaining = bytes - copied;
+        if (activeCue != -1)
+        {
+            const CueWindow &cue = cues[activeCue];
+            if (!IsCueReady(cue))
+            {
+                break; // still loading.
+            }
+            uint64_t cueEnd = cue.loadedPosition + cue.loadedBytes;
+            if (position >= cue.loadedPosition && position < cueEnd)
+            {
+                uint64_t n = std::min(remaining, cueEnd - position);
+                memcpy(output + copied, cue.data.data() + (position - cue.loadedPosition), n);
+                copied += n;
+                position += n;
+                continue;
+            }
+            activeCue = -1;
+            if (position < ringStart)
+            {
+                StartSeek(position);
+            }
+        }
+        if (!IsRingValid() || position < ringStart)
+        {
+            break;
+        }
+        uint64_t end = filledEnd.load(std::memory_order_acquire);
+        if (end <= position)
+        {
+            break;
+        }
+        uint64_t n = std::min(remaining, end - position);
+        uint64_t ringOffset = position % ring.size();
+        uint64_t n1 = std::min(n, ring.size() - ringOffset);
+        memcpy(output + copied, ring.data() + ringOffset, n1);
+        if (n1 < n)
+        {
+            memcpy(output + copied + n1, ring.data(), n - n1);
+        }
+        copied += n;
+        position += n;
+    }
+    readPosition.store(position, std::memory_order_release);
+    bytesRead.fetch_add(copied, std::memory_order_relaxed);
+    if (copied < bytes)
+    {
+        starvedReads.fetch_add(1, std::memory_order_relaxed);
+    }
+    return copied;
+}
+
+bool FileStreamFeature::Stream::NeedsService() const
+{
+    if (!IsRingValid())
+    {
+        return true;
+    }
+    for (const auto &cue : cues)
+    {
+        if (!IsCueReady(cue))
+        {
+            return true;
+        }
+    }
+    uint64_t end = filledEnd.load(std::memory_order_relaxed);
+    return end < fileSize && end < readPosition.load(std::memory_order_relaxed) + ring.size() / 2;
+}
+
+bool FileStreamFeature::Stream::Service()
+{
+    // cue windows first: they're what makes seeks glitch-free.
+    for (auto &cue : cues)
+    {
+        uint32_t sequence = cue.requestSequence.load(std::memory_order_acquire);
+        if (sequence == cue.loadedSequence.load(std::memory_order_relaxed))
+        {
+            continue;
+        }
+        uint64_t cuePosition = cue.requestedPosition.load(std::memory_order_relaxed);
+        uint64_t bytes = std::min((uint64_t)cue.data.size(), fileSize - cuePosition);
+        uint64_t loaded = 0;
+        while (loaded < bytes)
+        {
+            ssize_t n = pread(fd, cue.data.data() + loaded, bytes - loaded, (off_t)(cuePosition + loaded));
+            if (n <= 0)
+            {
+                if (n < 0 && errno == EINTR)
+                    continue;
+                break;
+            }
+            loaded += (uint64_t)n;
+        }
+        cue.loadedPosition = cuePosition;
+        cue.loadedBytes = loaded;
+        cue.loadedSequence.store(sequence, std::memory_order_release);
+    }
+
+    uint32_t generation = seekGeneration.load(std::memory_order_acquire);
+    if (generation != ioGeneration)
+    {
+        ioGeneration = generation;
+        ioFilled = pendingFillStart.load(std::memory_order_relaxed);
+        filledEnd.store(ioFilled, std::memory_order_relaxed);
+        ackGeneration.store(generation, std::memory_order_release);
+        posix_fadvise(fd, (off_t)ioFilled, (off_t)ring.size(), POSIX_FADV_WILLNEED);
+    }
+
+    uint64_t limit = std::min(readPosition.load(std::memory_order_acquire) + ring.size(), fileSize);
+    if (ioFilled >= limit)
+    {
+        return false;
+    }
+    uint64_t ringOffset = ioFilled % ring.size();
+    uint64_t chunk = std::min({limit - ioFilled, MAX_READ_CHUNK, ring.size() - ringOffset});
+    ssize_t n = pread(fd, ring.data() + ringOffset, chunk, (off_t)ioFilled);
+    if (n <= 0)
+    {
+        return n < 0 && errno == EINTR;
+    }
+    if (seekGeneration.load(std::memory_order_acquire) != generation)
+    {
+        return true; // stale; start again from the new position.
+    }
+    ioFilled += (uint64_t)n;
+    filledEnd.store(ioFilled, std::memory_order_release);
+    return ioFilled < limit;
+}
+
+FileStreamStatistics FileStreamFeature::Stream::GetStatistics() const
+{
+    FileStreamStatistics result;
+    result.path_ = path;
+    result.fileSize_ = fileSize;
+    result.bufferBytes_ = ring.size();
+    uint64_t end = filledEnd.load(std::memory_order_relaxed);
+    uint64_t p = readPosition.load(std::memory_order_relaxed);
+    result.bufferedBytes_ = end > p ? end - p : 0;
+    result.bytesRead_ = bytesRead.load(std::memory_order_relaxed);
+    result.seeks_ = seeks.load(std::memory_order_relaxed);
+    result.cueHits_ = cueHits.load(std::memory_order_relaxed);
+    result.starvedReads_ = starvedReads.load(std::memory_order_relaxed);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// FileStreamFeature
+
+FileStreamFeature::FileStreamFeature()
+{
+    feature.URI = PIPEDAL__FILE_STREAM_FEATURE;
+    feature.data = &interface;
+    interface.handle = (void *)this;
+    interface.open = &FileStreamFeature::S_open;
+    interface.close = &FileStreamFeature::S_close;
+    interface.size = &FileStreamFeature::S_size;
+    interface.read = &FileStreamFeature::S_read;
+    interface.tell = &FileStreamFeature::S_tell;
+    interface.seek = &FileStreamFeature::S_seek;
+    interface.available = &FileStreamFeature::S_available;
+    interface.setCuePoint = &FileStreamFeature::S_setCuePoint;
+    interface.maxCuePoints = &FileStreamFeature::S_maxCuePoints;
+}
+
+FileStreamFeature::~FileStreamFeature()
+{
+    closing.store(true);
+    wakeSequence.fetch_add(1);
+    futex_wake(&wakeSequence);
+    if (ioThread)
+    {
+        ioThread->join();
+        ioThread = nullptr;
+    }
+    if (!streams.empty())
+    {
+        Lv2Log::warning(SS("FileStreamFeature: " << streams.size() << " stream(s) were not closed."));
+    }
+}
+
+PIPEDAL_FileStream *FileStreamFeature::Open(
+    const char *path,
+    PIPEDAL_FileStream_AccessPattern accessPattern,
+    uint64_t readAheadBytes,
+    uint64_t cueWindowBytes,
+    PIPEDAL_FileStream_Status *status)
+{
+    if (path == nullptr || path[0] != '/')
+    {
+        *status = PIPEDAL_FILE_STREAM_INVALID_PATH;
+        return nullptr;
+    }
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        *status = ErrnoStatus(errno);
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        *status = PIPEDAL_FILE_STREAM_INVALID_PATH;
+        return nullptr;
+    }
+    posix_fadvise(fd, 0, 0, accessPattern == PIPEDAL_FILE_STREAM_RANDOM ? POSIX_FADV_RANDOM : POSIX_FADV_SEQUENTIAL);
+
+    if (readAheadBytes == 0)
+    {
+        readAheadBytes = DEFAULT_READ_AHEAD_BYTES;
+    }
+    if (cueWindowBytes == 0)
+    {
+        cueWindowBytes = DEFAULT_CUE_WINDOW_BYTES;
+    }
+    auto stream = std::make_shared<Stream>(fd, path, (uint64_t)st.st_size, readAheadBytes, cueWindowBytes);
+    Stream *result = stream.get();
+
+    std::lock_guard lock{mutex};
+    stream->LockMemory(&warnedMlock);
+    streams.push_back(std::move(stream));
+    if (!ioThread)
+    {
+        ioThread = std::make_unique<std::thread>([this]()
+                                                 { IoThreadProc(); });
+    }
+    WakeIoThread();
+    *status = PIPEDAL_FILE_STREAM_SUCCESS;
+    return (PIPEDAL_FileStream *)result;
+}
+
+void FileStreamFeature::Close(PIPEDAL_FileStream *stream)
+{
+    std::shared_ptr<Stream> closed; // released after the lock.
+    std::lock_guard lock{mutex};
+    for (auto i = streams.begin(); i != streams.end(); ++i)
+    {
+        if (i->get() == (Stream *)stream)
+        {
+            closed = std::move(*i);
+            streams.erase(i);
+            return;
+        }
+    }
+    Lv2Log::error("FileStreamFeature: close called with an invalid stream.");
+}
+
+void FileStreamFeature::WakeIoThread()
+{
+    wakeSequence.fetch_add(1);
+    if (ioThreadSleeping.load())
+    {
+        futex_wake(&wakeSequence);
+    }
+}
+
+void FileStreamFeature::IoThreadProc()
+{
+    SetThreadName("fileStream");
+    SetThreadPriority(SchedulerPriority::AudioService);
+
+    std::vector<std::shared_ptr<Stream>> currentStreams;
+    while (!closing.load())
+    {
+        uint32_t sequence = wakeSequence.load();
+        {
+            std::lock_guard lock{mutex};
+            currentStreams = streams;
+        }
+        bool moreWork = true;
+        while (moreWork && !closing.load())
+        {
+            moreWork = false;
+            // round-robin one chunk per stream, so that one stream can't starve the others.
+            for (auto &stream : currentStreams)
+            {
+                if (stream->Service())
+                {
+                    moreWork = true;
+                }
+            }
+        }
+        currentStreams.clear();
+
+        ioThreadSleeping.store(true);
+        if (wakeSequence.load() == sequence)
+        {
+            futex_wait_for(&wakeSequence, sequence, IO_POLL_INTERVAL);
+        }
+        ioThreadSleeping.store(false);
+    }
+}
+
+std::vector<FileStreamStatistics> FileStreamFeature::GetStatistics()
+{
+    std::lock_guard lock{mutex};
+    std::vector<FileStreamStatistics> result;
+    for (const auto &stream : streams)
+    {
+        result.push_back(stream->GetStatistics());
+    }
+    return result;
+}
+
+PIPEDAL_FileStream *FileStreamFeature::S_open(PIPEDAL_FILE_STREAM_Handle handle, const char *absolute_path, PIPEDAL_FileStream_AccessPattern accessPattern, uint64_t readAheadBytes, uint64_t cueWindowBytes, PIPEDAL_FileStream_Status *status)
+{
+    PIPEDAL_FileStream_Status ignored;
+    if (status == nullptr)
+    {
+        status = &ignored;
+    }
+    try
+    {
+        return ((FileStreamFeature *)handle)->Open(absolute_path, accessPattern, readAheadBytes, cueWindowBytes, status);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("FileStreamFeature: " << e.what()));
+        *status = PIPEDAL_FILE_STREAM_ERR_UNKNOWN;
+        return nullptr;
+    }
+}
+void FileStreamFeature::S_close(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream)
+{
+    if (stream)
+    {
+        ((FileStreamFeature *)handle)->Close(stream);
+    }
+}
+uint64_t FileStreamFeature::S_size(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream)
+{
+    return ((Stream *)stream)->Size();
+}
+uint64_t FileStreamFeature::S_read(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, void *buffer, uint64_t bytes)
+{
+    Stream *pStream = (Stream *)stream;
+    uint64_t result = pStream->Read(buffer, bytes);
+    if (pStream->NeedsService())
+    {
+        ((FileStreamFeature *)handle)->WakeIoThread();
+    }
+    return result;
+}
+uint64_t FileStreamFeature::S_tell(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream)
+{
+    return ((Stream *)stream)->Tell();
+}
+void FileStreamFeature::S_seek(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint64_t position)
+{
+    ((Stream *)stream)->Seek(position);
+    ((FileStreamFeature *)handle)->WakeIoThread();
+}
+uint64_t FileStreamFeature::S_available(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream)
+{
+    return ((Stream *)stream)->Available();
+}
+PIPEDAL_FileStream_Status FileStreamFeature::S_setCuePoint(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint32_t cueIndex, uint64_t position)
+{
+    PIPEDAL_FileStream_Status result = ((Stream *)stream)->SetCuePoint(cueIndex, position);
+    ((FileStreamFeature *)handle)->WakeIoThread();
+    return result;
+}
+uint32_t FileStreamFeature::S_maxCuePoints(PIPEDAL_FILE_STREAM_Handle handle)
+{
+    return MAX_CUE_POINTS;
+}
+
+JSON_MAP_BEGIN(FileStreamStatistics)
+    JSON_MAP_REFERENCE(FileStreamStatistics, path)
+    JSON_MAP_REFERENCE(FileStreamStatistics, fileSize)
+    JSON_MAP_REFERENCE(FileStreamStatistics, bufferBytes)
+    JSON_MAP_REFERENCE(FileStreamStatistics, bufferedBytes)
+    JSON_MAP_REFERENCE(FileStreamStatistics, bytesRead)
+    JSON_MAP_REFERENCE(FileStreamStatistics, seeks)
+    JSON_MAP_REFERENCE(FileStreamStatistics, cueHits)
+    JSON_MAP_REFERENCE(FileStreamStatistics, starvedReads)
+JSON_MAP_END()
@@ -0,0 +1,175 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "lv2ext/pipedal.lv2/ext/FileStreamFeature.h"
+#include "json.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    // Buffer statistics for a stream opened through the fileStream extension.
+    class FileStreamStatistics
+    {
+    public:
+        std::string path_;
+        uint64_t fileSize_ = 0;
+        uint64_t bufferBytes_ = 0;   // size of the read-ahead window.
+        uint64_t bufferedBytes_ = 0; // data currently available to the realtime thread.
+        uint64_t bytesRead_ = 0;
+        uint64_t seeks_ = 0;
+        uint64_t cueHits_ = 0;     // seeks served from a cue window.
+        uint64_t starvedReads_ = 0; // reads that couldn't be satisfied because the data hadn't been loaded yet.
+
+        DECLARE_JSON_MAP(FileStreamStatistics);
+    };
+
+    /**
+     * @brief Host side of the fileStream LV2 extension.
+     *
+     * One per PluginHost. A single i/o thread keeps the read-ahead window and cue windows of every open
+     * stream filled. Each stream is single-producer (the i/o thread), single-consumer (the plugin's
+     * realtime thread); data is handed over through atomics, so the realtime side never blocks.
+     */
+    class FileStreamFeature
+    {
+    public:
+        static constexpr uint64_t DEFAULT_READ_AHEAD_BYTES = 1024 * 1024;
+        static constexpr uint64_t DEFAULT_CUE_WINDOW_BYTES = 256 * 1024;
+        static constexpr uint32_t MAX_CUE_POINTS = 4;
+
+        FileStreamFeature();
+        ~FileStreamFeature();
+        FileStreamFeature(const FileStreamFeature &) = delete;
+        FileStreamFeature &operator=(const FileStreamFeature &) = delete;
+
+        const LV2_Feature *GetFeature() { return &feature; }
+
+        std::vector<FileStreamStatistics> GetStatistics();
+
+    public:
+        class Stream
+        {
+        public:
+            Stream(int fd, const std::string &path, uint64_t fileSize, uint64_t readAheadBytes, uint64_t cueWindowBytes);
+            ~Stream();
+
+            // Host thread.
+            void LockMemory(bool *warned);
+
+            // Realtime thread.
+            uint64_t Read(void *buffer, uint64_t bytes);
+            void Seek(uint64_t position);
+            uint64_t Tell() const { return position; }
+            uint64_t Available() const;
+            PIPEDAL_FileStream_Status SetCuePoint(uint32_t cueIndex, uint64_t position);
+            uint64_t Size() const { return fileSize; }
+
+            // I/O thread. Returns true if there is more work to do.
+            bool Service();
+
+            FileStreamStatistics GetStatistics() const;
+            // True if the i/o thread should be woken.
+            bool NeedsService() const;
+
+        private:
+            struct CueWindow
+            {
+                std::vector<uint8_t> data;
+                // written by the realtime thread.
+                std::atomic<uint64_t> requestedPosition{0};
+                std::atomic<uint32_t> requestSequence{0};
+                // written by the i/o thread.
+                uint64_t loadedPosition = 0;
+                uint64_t loadedBytes = 0;
+                std::atomic<uint32_t> loadedSequence{0};
+            };
+            // Realtime thread.
+            bool IsRingValid() const { return ackGeneration.load(std::memory_order_acquire) == seekGeneration.load(std::memory_order_relaxed); }
+            bool IsCueReady(const CueWindow &cue) const { return cue.loadedSequence.load(std::memory_order_acquire) == cue.requestSequence.load(std::memory_order_relaxed); }
+            void StartSeek(uint64_t fillStart);
+
+            int fd = -1;
+            std::string path;
+            uint64_t fileSize = 0;
+
+            std::vector<uint8_t> ring; // file offset o is at ring[o % ring.size()].
+            CueWindow cues[MAX_CUE_POINTS];
+
+            // Realtime thread state.
+            uint64_t position = 0;
+            uint64_t ringStart = 0; // the file position from which the current generation of the ring is filled.
+            int activeCue = -1;
+
+            // written by the realtime thread.
+            alignas(64) std::atomic<uint64_t> readPosition{0};
+            std::atomic<uint64_t> pendingFillStart{0};
+            std::atomic<uint32_t> seekGeneration{0};
+
+            // written by the i/o thread.
+            alignas(64) std::atomic<uint64_t> filledEnd{0};
+            std::atomic<uint32_t> ackGeneration{0};
+            uint32_t ioGeneration = 0;
+            uint64_t ioFilled = 0;
+
+            // statistics.
+            std::atomic<uint64_t> bytesRead{0};
+            std::atomic<uint64_t> seeks{0};
+            std::atomic<uint64_t> cueHits{0};
+            std::atomic<uint64_t> starvedReads{0};
+        };
+
+    private:
+        PIPEDAL_FileStream *Open(const char *path, PIPEDAL_FileStream_AccessPattern accessPattern, uint64_t readAheadBytes, uint64_t cueWindowBytes, PIPEDAL_FileStream_Status *status);
+        void Close(PIPEDAL_FileStream *stream);
+        // Realtime-safe.
+        void WakeIoThread();
+        void IoThreadProc();
+
+        static PIPEDAL_FileStream *S_open(PIPEDAL_FILE_STREAM_Handle handle, const char *absolute_path, PIPEDAL_FileStream_AccessPattern accessPattern, uint64_t readAheadBytes, uint64_t cueWindowBytes, PIPEDAL_FileStream_Status *status);
+        static void S_close(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+        static uint64_t S_size(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+        static uint64_t S_read(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, void *buffer, uint64_t bytes);
+        static uint64_t S_tell(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+        static void S_seek(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint64_t position);
+        static uint64_t S_available(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+        static PIPEDAL_FileStream_Status S_setCuePoint(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint32_t cueIndex, uint64_t position);
+        static uint32_t S_maxCuePoints(PIPEDAL_FILE_STREAM_Handle handle);
+
+        LV2_Feature feature;
+        PIPEDAL_FileStream_Interface interface;
+
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Stream>> streams;
+        std::unique_ptr<std::thread> ioThread;
+        std::atomic<uint32_t> wakeSequence{0};
+        std::atomic<bool> ioThreadSleeping{false};
+        std::atomic<bool> closing{false};
+        bool warnedMlock = false;
+    };
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "FileStreamFeature.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static uint8_t TestByte(uint64_t position)
+{
+    return (uint8_t)((position * 7 + (position >> 10)) & 0xFF);
+}
+
+static void WriteTestFile(const fs::path &path, uint64_t size)
+{
+    fs::create_directories(path.parent_path());
+    std::vector<char> data(size);
+    for (uint64_t i = 0; i < size; ++i)
+    {
+        data[i] = (char)TestByte(i);
+    }
+    std::ofstream f(path, std::ios_base::trunc | std::ios_base::binary);
+    f.write(data.data(), (std::streamsize)data.size());
+}
+
+// Read until `bytes` bytes have been read, polling while the stream is starved. Returns false on timeout.
+static bool ReadFully(const PIPEDAL_FileStream_Interface *interface, PIPEDAL_FileStream *stream, std::vector<uint8_t> &buffer, uint64_t bytes)
+{
+    buffer.resize(bytes);
+    uint64_t total = 0;
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (total < bytes)
+    {
+        uint64_t n = interface->read(interface->handle, stream, buffer.data() + total, std::min<uint64_t>(bytes - total, 4096));
+        total += n;
+        if (n == 0)
+        {
+            if (std::chrono::steady_clock::now() > timeout)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+static bool WaitForAvailable(const PIPEDAL_FileStream_Interface *interface, PIPEDAL_FileStream *stream, uint64_t bytes)
+{
+    auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (interface->available(interface->handle, stream) < bytes)
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static bool MatchesFile(const std::vector<uint8_t> &buffer, uint64_t position)
+{
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        if (buffer[i] != TestByte(position + i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("FileStreamFeature read and seek", "[file_stream][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "FileStreamTest";
+    fs::path file = directory / "track.raw";
+    constexpr uint64_t FILE_SIZE = 1000 * 1000;
+    constexpr uint64_t READ_AHEAD = 64 * 1024;
+    constexpr uint64_t CUE_WINDOW = 16 * 1024;
+    WriteTestFile(file, FILE_SIZE);
+
+    FileStreamFeature feature;
+    const PIPEDAL_FileStream_Interface *interface = (const PIPEDAL_FileStream_Interface *)feature.GetFeature()->data;
+
+    PIPEDAL_FileStream_Status status;
+    PIPEDAL_FileStream *missing = interface->open(interface->handle, (directory / "missing.raw").c_str(), PIPEDAL_FILE_STREAM_SEQUENTIAL, 0, 0, &status);
+    REQUIRE(missing == nullptr);
+    REQUIRE(status == PIPEDAL_FILE_STREAM_INVALID_PATH);
+
+    PIPEDAL_FileStream *stream = interface->open(interface->handle, file.c_str(), PIPEDAL_FILE_STREAM_SEQUENTIAL, READ_AHEAD, CUE_WINDOW, &status);
+    REQUIRE(status == PIPEDAL_FILE_STREAM_SUCCESS);
+    REQUIRE(stream != nullptr);
+    REQUIRE(interface->size(interface->handle, stream) == FILE_SIZE);
+
+    std::vector<uint8_t> buffer;
+
+    // sequential, through the cue window at the start of the file into the read-ahead window.
+    REQUIRE(ReadFully(interface, stream, buffer, 300 * 1000));
+    REQUIRE(MatchesFile(buffer, 0));
+    REQUIRE(interface->tell(interface->handle, stream) == 300 * 1000);
+
+    // seeking back to the start is served from cue point 0 without waiting.
+    interface->seek(interface->handle, stream, 100);
+    REQUIRE(interface->available(interface->handle, stream) >= CUE_WINDOW - 100);
+    REQUIRE(interface->read(interface->handle, stream, buffer.data(), 1000) == 1000);
+    buffer.resize(1000);
+    REQUIRE(MatchesFile(buffer, 100));
+    // ... and the read-ahead window refills behind it.
+    REQUIRE(ReadFully(interface, stream, buffer, 100 * 1000));
+    REQUIRE(MatchesFile(buffer, 1100));
+
+    // a loop point.
+    constexpr uint64_t LOOP_START = 500 * 1000;
+    REQUIRE(interface->setCuePoint(interface->handle, stream, 1, LOOP_START) == PIPEDAL_FILE_STREAM_SUCCESS);
+    REQUIRE(interface->setCuePoint(interface->handle, stream, FileStreamFeature::MAX_CUE_POINTS, 0) == PIPEDAL_FILE_STREAM_INVALID_PARAMETER);
+    interface->seek(interface->handle, stream, LOOP_START);
+    REQUIRE(WaitForAvailable(interface, stream, CUE_WINDOW));
+    REQUIRE(ReadFully(interface, stream, buffer, 200 * 1000));
+    REQUIRE(MatchesFile(buffer, LOOP_START));
+
+    // an uncued seek.
+    interface->seek(interface->handle, stream, 900 * 1000);
+    REQUIRE(ReadFully(interface, stream, buffer, 100 * 1000));
+    REQUIRE(MatchesFile(buffer, 900 * 1000));
+    // end of file.
+    REQUIRE(interface->read(interface->handle, stream, buffer.data(), 100) == 0);
+
+    std::vector<FileStreamStatistics> statistics = feature.GetStatistics();
+    REQUIRE(statistics.size() == 1);
+    REQUIRE(statistics[0].fileSize_ == FILE_SIZE);
+    REQUIRE(statistics[0].bufferBytes_ == READ_AHEAD);
+    REQUIRE(statistics[0].seeks_ == 3);
+    REQUIRE(statistics[0].cueHits_ >= 1);
+
+    interface->close(interface->handle, stream);
+    REQUIRE(feature.GetStatistics().empty());
+    fs::remove_all(directory);
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+namespace pipedal
+{
+    // Thin wrappers for process-private futexes on a 32-bit atomic. Waking is realtime-safe (one syscall,
+    // no locks), which makes these suitable for waking non-realtime threads from the audio thread.
+
+    inline void futex_wait(std::atomic<uint32_t> *address, uint32_t expectedValue)
+    {
+        syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, expectedValue, nullptr, nullptr, 0);
+    }
+    // Returns false if the wait timed out.
+    inline bool futex_wait_for(std::atomic<uint32_t> *address, uint32_t expectedValue, std::chrono::nanoseconds timeout)
+    {
+        if (timeout.count() <= 0)
+        {
+            return false;
+        }
+        struct timespec ts;
+        ts.tv_sec = (time_t)(timeout.count() / 1000000000);
+        ts.tv_nsec = (long)(timeout.count() % 1000000000);
+        long rc = syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, expectedValue, &ts, nullptr, 0);
+        return !(rc == -1 && errno == ETIMEDOUT);
+    }
+    inline void futex_wake(std::atomic<uint32_t> *address)
+    {
+        syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    // As above, for futexes in memory that is shared with another process.
+    inline bool futex_wait_for_shared(std::atomic<uint32_t> *address, uint32_t expectedValue, std::chrono::nanoseconds timeout)
+    {
+        if (timeout.count() <= 0)
+        {
+            return false;
+        }
+        struct timespec ts;
+        ts.tv_sec = (time_t)(timeout.count() / 1000000000);
+        ts.tv_nsec = (long)(timeout.count() % 1000000000);
+        long rc = syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT, expectedValue, &ts, nullptr, 0);
+        return !(rc == -1 && errno == ETIMEDOUT);
+    }
+    inline void futex_wake_shared(std::atomic<uint32_t> *address)
+    {
+        syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
@@ -25,30 +25,30 @@
 #pragma once
 namespace pipedal
 {
+    // Only the fields of the github releases API response that the updater uses. Everything else is skipped while parsing.
     class GithubAsset
     {
     public:
-        GithubAsset(json_variant &v);
         std::string name;
         std::string browser_download_url;
-        std::string updated_at;
+
+        DECLARE_JSON_MAP(GithubAsset);
     };
     class GithubRelease
     {
     public:
-        GithubRelease(json_variant &v);
-
         const GithubAsset *GetDownloadForCurrentArchitecture() const;
         const GithubAsset *GetGpgKeyForAsset(const std::string &name) const;
+        // A binary patch from fromVersion's package to the named package (e.g. pipedal_1.2.41_arm64.deb.from_1.2.39.zstpatch).
+        const GithubAsset *GetDeltaForAsset(const std::string &name, const std::string &fromVersion) const;
 
         bool draft = true;
         bool prerelease = true;
         std::string name;
-        std::string url;
-        std::string version;
-        std::string body;
         std::vector<GithubAsset> assets;
         std::string published_at;
+
+        DECLARE_JSON_MAP(GithubRelease);
     };
 
 
@@ -64,6 +64,9 @@ namespace pipedal
         uint64_t ratelimit_remaining_ = 60;
         uint64_t ratelimit_used_ = 0;
         std::string ratelimit_resource_;
+        // validators for conditional requests.
+        std::string etag_;
+        std::string last_modified_;
         bool limit_exceeded() const { return code_ != 200 && ratelimit_limit_ != 0 && ratelimit_limit_ == ratelimit_used_; }
         void Load(const std::filesystem::path &filename);
         void Save(const std::filesystem::path &filename);
@@ -0,0 +1,51 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "GzipCompress.hpp"
+#include <cstring>
+#include <zlib.h>
+
+using namespace pipedal;
+
+std::shared_ptr<const std::string> pipedal::GzipCompress(const std::string &text)
+{
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // windowBits + 16: write a gzip header and trailer, rather than a raw zlib stream.
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return nullptr;
+    }
+    std::string result;
+    result.resize(deflateBound(&stream, text.length()));
+    stream.next_in = (Bytef *)text.data();
+    stream.avail_in = (uInt)text.length();
+    stream.next_out = (Bytef *)result.data();
+    stream.avail_out = (uInt)result.length();
+    int rc = deflate(&stream, Z_FINISH);
+    size_t length = stream.total_out;
+    deflateEnd(&stream);
+    if (rc != Z_STREAM_END)
+    {
+        return nullptr;
+    }
+    result.resize(length);
+    return std::make_shared<const std::string>(std::move(result));
+}
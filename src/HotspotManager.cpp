@@ -63,6 +63,9 @@ namespace pipedal::impl
         virtual void SetNetworkChangingListener(NetworkChangingListener &&listener) override;
         virtual void SetHasWifiListener(HasWifiListener &&listener) override;
 
+        virtual void SetAudioActive(bool active) override;
+        virtual void RequestScan() override;
+
     private:
         enum class State
         {
@@ -98,8 +101,7 @@ namespace pipedal::impl
         void onAccessPointsChanged();
         void CancelAccessPointsChangedTimer();
         void WaitForNetworkManager();
-        void StartWaitForNetworkManagerTimer();
-        void CancelWaitForNetworkManagerTimer();
+        void WatchForNetworkManager();
         void UpdateNetworkManagerStatus();
         void CancelDeviceChangedTimer();
         void ReleaseNetworkManager();
@@ -117,8 +119,7 @@ namespace pipedal::impl
 
         void MaybeStartHotspot();
 
-        void StartScanTimer();
-        void StopScanTimer();
+        void ScanIfIdle();
         void ScanNow();
 
         Connection::ptr FindExistingConnection();
@@ -130,6 +131,7 @@ namespace pipedal::impl
         std::unique_ptr<std::thread> thread;
         void ThreadProc();
         WifiConfigSettings wifiConfigSettings;
+        DBusDaemon::ptr dbusDaemon;
         NetworkManager::ptr networkManager;
         Device::ptr ethernetDevice;
         Device::ptr wlanDevice;
@@ -148,9 +150,10 @@ namespace pipedal::impl
         DBusEventHandle onDeviceAddedHandle = INVALID_DBUS_EVENT_HANDLE;
         DBusEventHandle onDeviceRemovedHandle = INVALID_DBUS_EVENT_HANDLE;
         DBusDispatcher::PostHandle devicesChangedTimerHandle = 0;
-        DBusDispatcher::PostHandle networkManagerTimerHandle = 0;
         DBusDispatcher::PostHandle accessPointsChangedTimerHandle = 0;
-        DBusDispatcher::PostHandle scanTimerHandle = 0;
+
+        std::atomic<bool> audioActive{false};
+        clock::time_point lastScanTime;
     };
 }
 using namespace pipedal::impl;
@@ -175,7 +178,6 @@ void HotspotManagerImpl::onClose()
     this->closed = true; // avoids a memory barrier probelm.
 
     CancelDeviceChangedTimer();
-    CancelWaitForNetworkManagerTimer();
     CancelAccessPointsChangedTimer();
 
     if (networkManager && activeConnection)
@@ -192,6 +194,7 @@ void HotspotManagerImpl::onClose()
     }
 
     ReleaseNetworkManager();
+    dbusDaemon = nullptr;
 
     Lv2Log::debug("HotspotManager: state=Closed");
     SetState(State::Closed);
@@ -256,7 +259,6 @@ void HotspotManagerImpl::UpdateNetworkManagerStatus()
         {
             if (state == State::Initial || state == State::WaitingForNetworkManager)
             {
-                CancelWaitForNetworkManagerTimer();
                 this->onInitialize();
             }
             return;
@@ -273,7 +275,7 @@ void HotspotManagerImpl::UpdateNetworkManagerStatus()
     }
     else
     {
-        this->StartWaitForNetworkManagerTimer();
+        this->WatchForNetworkManager(); // (in case NetworkManager went away while we were checking)
     }
 }
 
@@ -287,9 +289,7 @@ void HotspotManagerImpl::CancelDeviceChangedTimer()
 }
 void HotspotManagerImpl::ReleaseNetworkManager()
 {
-    StopScanTimer();
     CancelAccessPointsChangedTimer();
-    CancelWaitForNetworkManagerTimer();
     CancelDeviceChangedTimer();
 
     DisableHotspot();
@@ -306,7 +306,17 @@ void HotspotManagerImpl::ReleaseNetworkManager()
 
 void HotspotManagerImpl::onDevicesChanged()
 {
-    UpdateNetworkManagerStatus();
+    // NetworkManager adds devices in bursts when it starts. Coalesce them.
+    if (!devicesChangedTimerHandle)
+    {
+        devicesChangedTimerHandle = dbusDispatcher.PostDelayed(
+            std::chrono::milliseconds(500),
+            [this]()
+            {
+                devicesChangedTimerHandle = 0;
+                UpdateNetworkManagerStatus();
+            });
+    }
 }
 Device::ptr HotspotManagerImpl::GetDevice(uint32_t nmDeviceType)
 {
@@ -418,7 +428,7 @@ void HotspotManagerImpl::onStartMonitoring()
 
         SetHasWifi(true);
 
-        StartScanTimer();
+        ScanIfIdle();
         onAccessPointChanged();
     }
     catch (const std::exception &e)
@@ -428,25 +438,36 @@ void HotspotManagerImpl::onStartMonitoring()
     }
 }
 
-void HotspotManagerImpl::StartWaitForNetworkManagerTimer()
+// No polling. NetworkManager appearing on the bus, or adding a device, triggers another check.
+void HotspotManagerImpl::WatchForNetworkManager()
 {
-
-    CancelWaitForNetworkManagerTimer();
-    networkManagerTimerHandle = dbusDispatcher.PostDelayed(
-        std::chrono::seconds(5),
-        [this]()
+    try
+    {
+        if (!dbusDaemon)
         {
-            networkManagerTimerHandle = 0;
-            this->UpdateNetworkManagerStatus();
-        });
-}
-void HotspotManagerImpl::CancelWaitForNetworkManagerTimer()
-{
-
-    if (networkManagerTimerHandle)
+            dbusDaemon = DBusDaemon::Create(dbusDispatcher);
+            dbusDaemon->OnNameOwnerChanged.add(
+                [this](const std::string &name, const std::string &, const std::string &newOwner)
+                {
+                    if (name == "org.freedesktop.NetworkManager" && !newOwner.empty())
+                    {
+                        onDevicesChanged();
+                    }
+                });
+        }
+        if (!networkManager)
+        {
+            networkManager = NetworkManager::Create(dbusDispatcher);
+            this->onDeviceAddedHandle = networkManager->OnDeviceAdded.add(
+                [this](const sdbus::ObjectPath &)
+                {
+                    onDevicesChanged();
+                });
+        }
+    }
+    catch (const std::exception &e)
     {
-        dbusDispatcher.CancelPost(networkManagerTimerHandle);
-        networkManagerTimerHandle = 0;
+        Lv2Log::error(SS("HotspotManager: Can't monitor NetworkManager. " << e.what()));
     }
 }
 
@@ -455,7 +476,7 @@ void HotspotManagerImpl::WaitForNetworkManager()
     Lv2Log::debug("HotspotManager: state=WaitingForNetworkManager");
     SetState(State::WaitingForNetworkManager);
     ReleaseNetworkManager();
-    StartWaitForNetworkManagerTimer();
+    WatchForNetworkManager();
 }
 void HotspotManagerImpl::onReload()
 {
@@ -487,7 +508,7 @@ void HotspotManagerImpl::onReload()
         // force a reload.
         StopHotspot();
         SetState(State::Monitoring);
-        StartScanTimer(); // or stop it as the case may be.
+        ScanIfIdle();
         MaybeStartHotspot();
         return;
     }
@@ -991,55 +1012,61 @@ void HotspotManagerImpl::StopHotspot()
     }
 }
 
-static const std::chrono::seconds scanInterval{60};
+// Explicit scan requests closer together than this are ignored.
+static const std::chrono::seconds minimumScanInterval{10};
 
-void HotspotManagerImpl::StartScanTimer()
+void HotspotManagerImpl::SetAudioActive(bool active)
 {
-    StopScanTimer();
-    ScanNow();
+    this->audioActive = active;
 }
-void HotspotManagerImpl::StopScanTimer()
+
+void HotspotManagerImpl::RequestScan()
 {
-    if (this->scanTimerHandle)
+    if (closed)
     {
-        dbusDispatcher.CancelPost(this->scanTimerHandle);
-        this->scanTimerHandle = 0;
+        return;
     }
+    dbusDispatcher.Post(
+        [this]()
+        {
+            ScanNow();
+        });
 }
-void HotspotManagerImpl::ScanNow()
-{
-    this->scanTimerHandle = 0;
 
-    if (wlanWirelessDevice)
+void HotspotManagerImpl::ScanIfIdle()
+{
+    // On some Pis the Wi-Fi chip shares the SDIO bus, and scans cause audible xruns. Access point
+    // changes reported by NetworkManager's own scans still arrive as signals.
+    if (audioActive)
     {
+        Lv2Log::debug("HotspotManager: Audio is running. Wi-Fi scan skipped.");
+        return;
+    }
+    ScanNow();
+}
 
-        std::map<std::string, sdbus::Variant> options;
-
-        try
-        {
-            if (this->wifiConfigSettings.NeedsScan())
-            {
-
-                Lv2Log::debug("Scanning");
-                wlanWirelessDevice->RequestScan(options);
-            }
-            else
-            {
-                return;
-            }
-        }
-        catch (const std::exception &e)
-        {
-            Lv2Log::error(SS("HotspotMonitor: Wi-Fi RequestScan failed." << e.what()));
-            return;
-        }
+void HotspotManagerImpl::ScanNow()
+{
+    if (!wlanWirelessDevice || !this->wifiConfigSettings.NeedsScan())
+    {
+        return;
+    }
+    auto now = clock::now();
+    if (lastScanTime != clock::time_point() && now - lastScanTime < minimumScanInterval)
+    {
+        return;
+    }
+    lastScanTime = now;
 
-        this->scanTimerHandle = this->dbusDispatcher.PostDelayed(
-            std::chrono::duration_cast<std::chrono::steady_clock::duration>(scanInterval),
-            [this]()
-            {
-                ScanNow();
-            });
+    std::map<std::string, sdbus::Variant> options;
+    try
+    {
+        Lv2Log::debug("Scanning");
+        wlanWirelessDevice->RequestScan(options);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("HotspotMonitor: Wi-Fi RequestScan failed." << e.what()));
     }
 }
 
@@ -59,6 +59,11 @@ namespace pipedal {
         virtual void SetHasWifiListener(HasWifiListener &&listener) = 0;
         virtual bool GetHasWifi() = 0;
 
+        // Wi-Fi scans are suspended while audio is running.
+        virtual void SetAudioActive(bool active) = 0;
+        // An explicit scan (e.g. the user opened the Wi-Fi settings), which is performed even if audio is running.
+        virtual void RequestScan() = 0;
+
 
         using PostHandle = uint64_t;
         using PostCallback = std::function<void()>;
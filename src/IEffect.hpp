@@ -27,6 +27,7 @@ namespace pipedal {
     class RealtimePatchPropertyRequest;
     class RealtimeRingBufferWriter;
     class Lv2PluginState;
+    class PluginMemoryFootprint;
 
     class IEffect {
     public:
@@ -59,6 +60,8 @@ namespace pipedal {
         virtual float *GetAudioSidechainBuffer(int index) const { throw std::runtime_error("Not implemented"); }
         virtual float *GetAudioOutputBuffer(int index) const = 0;
         virtual void ResetAtomBuffers() = 0;
+        // True if the effect has messages this period (patch messages, worker responses) that it must be run to receive.
+        virtual bool HasPendingInputMessages() const { return false; }
 
         virtual bool GetRequestStateChangedNotification() const = 0;
         virtual void SetRequestStateChangedNotification(bool value) = 0;
@@ -77,9 +80,19 @@ namespace pipedal {
 
         virtual bool IsVst3() const = 0;
         virtual bool GetLv2State(Lv2PluginState*state) = 0;
+        // As GetLv2State, but returns false without saving if the state hasn't changed since the last call.
+        virtual bool GetLv2StateIfChanged(Lv2PluginState*state) { return GetLv2State(state); }
+        // As GetLv2StateIfChanged, but may be called on a background thread. *version receives the
+        // GetLv2StateVersion() of the returned state.
+        virtual bool CaptureLv2StateIfChanged(Lv2PluginState*state, uint64_t *version) { *version = 0; return GetLv2StateIfChanged(state); }
+        // Incremented each time a changed state is returned by GetLv2StateIfChanged or CaptureLv2StateIfChanged.
+        virtual uint64_t GetLv2StateVersion() const { return 0; }
         virtual void SetLv2State(Lv2PluginState&state) = 0;
         
         virtual bool HasErrorMessage() const = 0;
         virtual const char*TakeErrorMessage()  = 0;
+
+        // Memory used by the instance, measured while it was created. null if not measured.
+        virtual PluginMemoryFootprint *GetMemoryFootprint() { return nullptr; }
     };
 } //namespace
\ No newline at end of file
@@ -19,6 +19,10 @@
 #pragma once
 
 #include <lilv/lilv.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace pipedal {
     class MapFeature;
@@ -26,6 +30,8 @@ namespace pipedal {
     class Lv2PluginInfo;
     class IEffect;
     class HostWorkerThread;
+    class RealtimeArena;
+    class FileStreamStatistics;
 
     class IHost
     {
@@ -47,9 +53,24 @@ namespace pipedal {
         virtual int GetNumberOfOutputAudioChannels() const = 0;
         virtual std::shared_ptr<Lv2PluginInfo> GetPluginInfo(const std::string &uri) const = 0;
 
-        virtual IEffect *CreateEffect(PedalboardItem &pedalboard) = 0;
+        // Effects take their realtime buffers from realtimeArena, if given.
+        virtual IEffect *CreateEffect(PedalboardItem &pedalboard, const std::shared_ptr<RealtimeArena> &realtimeArena = nullptr) = 0;
 
         virtual std::string GetPluginStoragePath() const = 0;
 
+        // The LV2 worker thread pool shared by all plugins.
+        virtual std::shared_ptr<HostWorkerThread> GetHostWorkerThread() = 0;
+
+        // Buffer statistics for streams that plugins have opened with the fileStream extension.
+        virtual std::vector<FileStreamStatistics> GetFileStreamStatistics() = 0;
+
+        // Measured cost of running a plugin, as a fraction of the audio period; or a negative value if it hasn't been measured.
+        virtual float GetEstimatedPluginLoad(const std::string &uri) const = 0;
+
+        // The lilv world isn't thread-safe. Held while effects that are being created concurrently use it.
+        virtual std::mutex &GetLilvWorldMutex() = 0;
+        // False if the plugin must not be instantiated concurrently with other plugins.
+        virtual bool CanCreateEffectConcurrently(const std::string &uri) const = 0;
+
     };
 }
\ No newline at end of file
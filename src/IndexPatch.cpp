@@ -0,0 +1,211 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "IndexPatch.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace pipedal;
+
+template <typename ENTRY>
+static bool MakeEntries(const std::vector<ENTRY> &from, const std::vector<ENTRY> &to, IndexPatch *patch)
+{
+    patch->removed_.clear();
+    patch->added_.clear();
+    patch->renamed_.clear();
+    patch->order_.clear();
+
+    std::unordered_map<int64_t, const ENTRY *> fromEntries;
+    for (const ENTRY &entry : from)
+    {
+        fromEntries[entry.instanceId()] = &entry;
+    }
+    std::unordered_set<int64_t> toIds;
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+        const ENTRY &entry = to[i];
+        toIds.insert(entry.instanceId());
+        auto f = fromEntries.find(entry.instanceId());
+        if (f == fromEntries.end())
+        {
+            patch->added_.push_back(IndexPatchEntry{entry.instanceId(), entry.name(), (int64_t)i});
+        }
+        else if (f->second->name() != entry.name())
+        {
+            patch->renamed_.push_back(IndexPatchEntry{entry.instanceId(), entry.name(), -1});
+        }
+    }
+    // the order that removals and insertions alone would produce.
+    std::vector<int64_t> patchedOrder;
+    patchedOrder.reserve(to.size());
+    for (const ENTRY &entry : from)
+    {
+        if (!toIds.contains(entry.instanceId()))
+        {
+            patch->removed_.push_back(entry.instanceId());
+        }
+        else
+        {
+            patchedOrder.push_back(entry.instanceId());
+        }
+    }
+    for (const IndexPatchEntry &added : patch->added_)
+    {
+        patchedOrder.insert(patchedOrder.begin() + added.position_, added.instanceId_);
+    }
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+        if (patchedOrder[i] != to[i].instanceId())
+        {
+            for (const ENTRY &entry : to)
+            {
+                patch->order_.push_back(entry.instanceId());
+            }
+            break;
+        }
+    }
+    // names make up most of the full index.
+    return (patch->added_.size() + patch->renamed_.size()) * 2 <= to.size();
+}
+
+template <typename ENTRY>
+static bool ApplyEntries(const IndexPatch &patch, std::vector<ENTRY> &entries)
+{
+    std::unordered_set<int64_t> removed{patch.removed_.begin(), patch.removed_.end()};
+    std::vector<ENTRY> result;
+    result.reserve(entries.size() + patch.added_.size());
+    for (ENTRY &entry : entries)
+    {
+        if (!removed.contains(entry.instanceId()))
+        {
+            result.push_back(std::move(entry));
+        }
+    }
+    if (result.size() + removed.size() != entries.size())
+    {
+        return false;
+    }
+    for (const IndexPatchEntry &added : patch.added_)
+    {
+        if (added.position_ < 0 || (size_t)added.position_ > result.size())
+        {
+            return false;
+        }
+        ENTRY entry;
+        entry.instanceId(added.instanceId_);
+        entry.name(added.name_);
+        result.insert(result.begin() + added.position_, std::move(entry));
+    }
+    std::unordered_map<int64_t, size_t> positions;
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        positions[result[i].instanceId()] = i;
+    }
+    for (const IndexPatchEntry &renamed : patch.renamed_)
+    {
+        auto f = positions.find(renamed.instanceId_);
+        if (f == positions.end())
+        {
+            return false;
+        }
+        result[f->second].name(renamed.name_);
+    }
+    if (!patch.order_.empty())
+    {
+        if (patch.order_.size() != result.size())
+        {
+            return false;
+        }
+        std::vector<ENTRY> ordered;
+        ordered.reserve(result.size());
+        for (int64_t instanceId : patch.order_)
+        {
+            auto f = positions.find(instanceId);
+            if (f == positions.end())
+            {
+                return false;
+            }
+            ordered.push_back(result[f->second]);
+            positions.erase(f); // each entry once.
+        }
+        result = std::move(ordered);
+    }
+    entries = std::move(result);
+    return true;
+}
+
+bool IndexPatch::HasEntryChanges() const
+{
+    return !removed_.empty() || !added_.empty() || !renamed_.empty() || !order_.empty();
+}
+
+bool IndexPatch::Make(const PresetIndex &from, const PresetIndex &to, IndexPatch *patch)
+{
+    patch->selectedInstanceId_ = to.selectedInstanceId();
+    patch->presetChanged_ = to.presetChanged();
+    return MakeEntries(from.presets(), to.presets(), patch);
+}
+
+bool IndexPatch::Make(const BankIndex &from, const BankIndex &to, IndexPatch *patch)
+{
+    patch->selectedInstanceId_ = to.selectedBank();
+    patch->presetChanged_ = false;
+    return MakeEntries(from.entries(), to.entries(), patch);
+}
+
+bool IndexPatch::Apply(PresetIndex *index) const
+{
+    if (!ApplyEntries(*this, index->presets()))
+    {
+        return false;
+    }
+    index->selectedInstanceId(selectedInstanceId_);
+    index->presetChanged(presetChanged_);
+    return true;
+}
+
+bool IndexPatch::Apply(BankIndex *index) const
+{
+    if (!ApplyEntries(*this, index->entries()))
+    {
+        return false;
+    }
+    index->selectedBank(selectedInstanceId_);
+    return true;
+}
+
+JSON_MAP_BEGIN(IndexPatchEntry)
+    JSON_MAP_REFERENCE(IndexPatchEntry, instanceId)
+    JSON_MAP_REFERENCE(IndexPatchEntry, name)
+    JSON_MAP_REFERENCE(IndexPatchEntry, position)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(IndexPatch)
+    JSON_MAP_REFERENCE(IndexPatch, clientId)
+    JSON_MAP_REFERENCE(IndexPatch, baseVersion)
+    JSON_MAP_REFERENCE(IndexPatch, version)
+    JSON_MAP_REFERENCE(IndexPatch, selectedInstanceId)
+    JSON_MAP_REFERENCE(IndexPatch, presetChanged)
+    JSON_MAP_REFERENCE(IndexPatch, removed)
+    JSON_MAP_REFERENCE(IndexPatch, added)
+    JSON_MAP_REFERENCE(IndexPatch, renamed)
+    JSON_MAP_REFERENCE(IndexPatch, order)
+JSON_MAP_END()
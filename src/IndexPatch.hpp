@@ -0,0 +1,74 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Banks.hpp"
+#include "json.hpp"
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    class IndexPatchEntry
+    {
+    public:
+        int64_t instanceId_ = -1;
+        std::string name_;
+        int64_t position_ = -1; // in the patched index. Not used for renames.
+
+        DECLARE_JSON_MAP(IndexPatchEntry);
+    };
+
+    // An incremental update of the preset index or the bank index, sent to clients in place of the
+    // full index when only a few entries have changed.
+    //
+    // Applied in order: remove entries, insert added entries at their positions (ascending), rename
+    // entries, and then, if order_ is not empty, put the entries in that order. A patch only applies to a
+    // client whose copy of the index is at baseVersion; other clients must fetch the full index.
+    class IndexPatch
+    {
+    public:
+        int64_t clientId_ = -1;
+        int64_t baseVersion_ = 0;
+        int64_t version_ = 0;
+
+        int64_t selectedInstanceId_ = -1;
+        bool presetChanged_ = false; // preset index only.
+
+        std::vector<int64_t> removed_;
+        std::vector<IndexPatchEntry> added_;
+        std::vector<IndexPatchEntry> renamed_;
+        std::vector<int64_t> order_; // instanceIds of all entries, if entries have moved.
+
+        // True if entries were added, removed, renamed or moved.
+        bool HasEntryChanges() const;
+
+        // Returns false if so many entries changed that the full index is smaller.
+        static bool Make(const PresetIndex &from, const PresetIndex &to, IndexPatch *patch);
+        static bool Make(const BankIndex &from, const BankIndex &to, IndexPatch *patch);
+
+        // Applies the patch's entry changes. Returns false if the patch doesn't fit the index.
+        bool Apply(PresetIndex *index) const;
+        bool Apply(BankIndex *index) const;
+
+        DECLARE_JSON_MAP(IndexPatch);
+    };
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "IndexPatch.hpp"
+
+using namespace pipedal;
+
+static PresetIndex MakePresetIndex(const std::vector<int64_t> &instanceIds)
+{
+    PresetIndex index;
+    for (int64_t instanceId : instanceIds)
+    {
+        index.presets().push_back(PresetIndexEntry(instanceId, "Preset " + std::to_string(instanceId)));
+    }
+    index.selectedInstanceId(instanceIds.empty() ? -1 : instanceIds[0]);
+    return index;
+}
+
+static std::vector<int64_t> InstanceIds(const PresetIndex &index)
+{
+    std::vector<int64_t> result;
+    for (const auto &entry : index.presets())
+    {
+        result.push_back(entry.instanceId());
+    }
+    return result;
+}
+
+static void RequireRoundTrip(const PresetIndex &from, const PresetIndex &to)
+{
+    IndexPatch patch;
+    REQUIRE(IndexPatch::Make(from, to, &patch));
+    PresetIndex patched = from;
+    REQUIRE(patch.Apply(&patched));
+    REQUIRE(InstanceIds(patched) == InstanceIds(to));
+    for (size_t i = 0; i < to.presets().size(); ++i)
+    {
+        REQUIRE(patched.presets()[i].name() == to.presets()[i].name());
+    }
+    REQUIRE(patched.selectedInstanceId() == to.selectedInstanceId());
+    REQUIRE(patched.presetChanged() == to.presetChanged());
+}
+
+TEST_CASE("IndexPatch", "[index_patch][Build][Dev]")
+{
+    PresetIndex from = MakePresetIndex({1, 2, 3, 4, 5, 6, 7, 8});
+
+    // no change.
+    {
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, from, &patch));
+        REQUIRE(!patch.HasEntryChanges());
+    }
+    // save as: one entry added.
+    {
+        PresetIndex to = from;
+        to.presets().insert(to.presets().begin() + 3, PresetIndexEntry(9, "New"));
+        to.selectedInstanceId(9);
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, to, &patch));
+        REQUIRE(patch.added_.size() == 1);
+        REQUIRE(patch.added_[0].position_ == 3);
+        REQUIRE(patch.removed_.empty());
+        REQUIRE(patch.order_.empty());
+        RequireRoundTrip(from, to);
+    }
+    // rename, and the modified flag.
+    {
+        PresetIndex to = from;
+        to.presets()[5].name("Renamed");
+        to.presetChanged(true);
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, to, &patch));
+        REQUIRE(patch.renamed_.size() == 1);
+        REQUIRE(patch.renamed_[0].instanceId_ == 6);
+        RequireRoundTrip(from, to);
+    }
+    // delete.
+    {
+        PresetIndex to = MakePresetIndex({1, 3, 4, 5, 7, 8});
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, to, &patch));
+        REQUIRE(patch.removed_ == std::vector<int64_t>{2, 6});
+        REQUIRE(patch.order_.empty());
+        RequireRoundTrip(from, to);
+    }
+    // move.
+    {
+        PresetIndex to = MakePresetIndex({1, 5, 2, 3, 4, 6, 7, 8});
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, to, &patch));
+        REQUIRE(patch.added_.empty());
+        REQUIRE(patch.order_.size() == 8);
+        RequireRoundTrip(from, to);
+    }
+    // added, removed and moved at once.
+    {
+        PresetIndex to = MakePresetIndex({10, 8, 1, 3, 4, 5, 7});
+        RequireRoundTrip(from, to);
+    }
+    // a new bank: the full index is smaller.
+    {
+        PresetIndex to = MakePresetIndex({11, 12, 13, 14});
+        IndexPatch patch;
+        REQUIRE(!IndexPatch::Make(from, to, &patch));
+    }
+    // a patch that doesn't fit.
+    {
+        PresetIndex to = MakePresetIndex({1, 2, 3, 4, 5, 6, 7});
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(from, to, &patch));
+        PresetIndex other = MakePresetIndex({1, 2, 3});
+        REQUIRE(!patch.Apply(&other));
+    }
+    // banks.
+    {
+        BankIndex fromBanks;
+        for (int64_t i = 1; i <= 4; ++i)
+        {
+            BankIndexEntry entry;
+            entry.instanceId(i);
+            entry.name("Bank " + std::to_string(i));
+            fromBanks.entries().push_back(entry);
+        }
+        fromBanks.selectedBank(1);
+        BankIndex toBanks = fromBanks;
+        toBanks.move(0, 2);
+        toBanks.entries()[0].name("Renamed");
+        toBanks.selectedBank(2);
+        IndexPatch patch;
+        REQUIRE(IndexPatch::Make(fromBanks, toBanks, &patch));
+        BankIndex patched = fromBanks;
+        REQUIRE(patch.Apply(&patched));
+        REQUIRE(patched.selectedBank() == 2);
+        for (size_t i = 0; i < toBanks.entries().size(); ++i)
+        {
+            REQUIRE(patched.entries()[i].instanceId() == toBanks.entries()[i].instanceId());
+            REQUIRE(patched.entries()[i].name() == toBanks.entries()[i].name());
+        }
+    }
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "InternedString.hpp"
+#include <mutex>
+#include <unordered_set>
+
+using namespace pipedal;
+
+namespace
+{
+    std::mutex &PoolMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+    std::unordered_set<std::string> &Pool()
+    {
+        // deliberately leaked, so interned strings outlive static destructors.
+        static std::unordered_set<std::string> *pool = new std::unordered_set<std::string>();
+        return *pool;
+    }
+    const std::string *EmptyString()
+    {
+        static const std::string *empty = new std::string();
+        return empty;
+    }
+}
+
+const std::string *InternedString::Intern(const std::string &value)
+{
+    if (value.empty())
+    {
+        return EmptyString();
+    }
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    // unordered_set nodes are stable, so the address of the element stays valid across rehashes.
+    return &*(Pool().insert(value).first);
+}
+
+InternedString::InternedString()
+    : value(EmptyString())
+{
+}
+
+InternedString::InternedString(const std::string &value)
+    : value(Intern(value))
+{
+}
+
+InternedString::InternedString(const char *value)
+    : value(Intern(std::string(value)))
+{
+}
+
+void InternedString::write_json(json_writer &writer) const
+{
+    writer.write(*value);
+}
+
+void InternedString::read_json(json_reader &reader)
+{
+    std::string text;
+    reader.read(&text);
+    value = Intern(text);
+}
+
+size_t InternedString::PoolSize()
+{
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    return Pool().size();
+}
+
+std::vector<InternedString> pipedal::Intern(const std::vector<std::string> &values)
+{
+    std::vector<InternedString> result;
+    result.reserve(values.size());
+    for (const auto &value : values)
+    {
+        result.push_back(InternedString(value));
+    }
+    return result;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "json.hpp"
+
+namespace pipedal
+{
+    /**
+     * @brief A string stored once in a process-wide table.
+     *
+     * Plugin metadata repeats the same URIs (port classes, features, buffer types, port groups)
+     * across thousands of ports. An InternedString is a pointer to the single shared copy, so
+     * equal strings cost one pointer each, and compare by pointer. Interned strings are never freed.
+     *
+     * Serializes as a plain json string.
+     */
+    class InternedString : public JsonSerializable
+    {
+    public:
+        InternedString();
+        InternedString(const std::string &value);
+        InternedString(const char *value);
+        InternedString(const InternedString &) = default;
+        InternedString &operator=(const InternedString &) = default;
+
+        const std::string &str() const { return *value; }
+        operator const std::string &() const { return *value; }
+        const char *c_str() const { return value->c_str(); }
+        size_t length() const { return value->length(); }
+        size_t size() const { return value->size(); }
+        bool empty() const { return value->empty(); }
+
+        bool operator==(const InternedString &other) const { return value == other.value; }
+        bool operator==(const std::string &other) const { return *value == other; }
+        bool operator==(const char *other) const { return *value == other; }
+
+        virtual void write_json(json_writer &writer) const override;
+        virtual void read_json(json_reader &reader) override;
+
+        // The number of distinct strings that have been interned.
+        static size_t PoolSize();
+
+    private:
+        static const std::string *Intern(const std::string &value);
+        const std::string *value;
+    };
+
+    std::vector<InternedString> Intern(const std::vector<std::string> &values);
+}
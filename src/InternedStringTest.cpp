@@ -0,0 +1,61 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "InternedString.hpp"
+#include "json.hpp"
+#include <sstream>
+
+using namespace pipedal;
+
+TEST_CASE("InternedString", "[interned_string][Build][Dev]")
+{
+    std::string uri = "http://lv2plug.in/ns/lv2core#ControlPort";
+    InternedString a{uri};
+    InternedString b{"http://lv2plug.in/ns/lv2core#ControlPort"};
+    InternedString c{"http://lv2plug.in/ns/lv2core#InputPort"};
+    InternedString empty;
+
+    REQUIRE(&a.str() == &b.str()); // one shared copy.
+    REQUIRE(a == b);
+    REQUIRE(!(a == c));
+    REQUIRE(a == uri);
+    REQUIRE(uri == a);
+    REQUIRE(a == "http://lv2plug.in/ns/lv2core#ControlPort");
+    REQUIRE(empty.empty());
+    REQUIRE(empty == "");
+    REQUIRE(InternedString("") == empty);
+
+    // serializes as a plain string.
+    std::vector<InternedString> values = Intern({uri, "http://lv2plug.in/ns/lv2core#InputPort"});
+    std::stringstream s;
+    json_writer writer(s, true);
+    writer.write(values);
+    REQUIRE(s.str().find("\"http://lv2plug.in/ns/lv2core#ControlPort\"") != std::string::npos);
+
+    std::stringstream input(s.str());
+    json_reader reader(input);
+    std::vector<InternedString> readValues;
+    reader.read(&readValues);
+    REQUIRE(readValues.size() == 2);
+    REQUIRE(&readValues[0].str() == &a.str());
+    REQUIRE(readValues[1] == c);
+}
@@ -259,4 +259,7 @@ JSON_MAP_REFERENCE(JackServerSettings, alsaOutputDevice)
 JSON_MAP_REFERENCE(JackServerSettings, sampleRate)
 JSON_MAP_REFERENCE(JackServerSettings, bufferSize)
 JSON_MAP_REFERENCE(JackServerSettings, numberOfBuffers)
+JSON_MAP_REFERENCE(JackServerSettings, alsaMmap)
+JSON_MAP_REFERENCE(JackServerSettings, alsaInputClockMaster)
+JSON_MAP_REFERENCE(JackServerSettings, alsaTimerScheduling)
 JSON_MAP_END()
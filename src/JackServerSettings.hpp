@@ -38,6 +38,12 @@ namespace pipedal
         uint64_t sampleRate_ = 0;
         uint32_t bufferSize_ = 64;
         uint32_t numberOfBuffers_ = 3;
+        bool alsaMmap_ = false; // transfer audio directly from/to the ALSA DMA buffers, if the device supports it.
+        // Separate input and output cards run on their own clocks. The clock master's stream drives the audio thread;
+        // the other is resampled to follow it. false: the output device is the clock master.
+        bool alsaInputClockMaster_ = false;
+        // wake the audio thread with timers when a period is due, instead of waiting for the period interrupt.
+        bool alsaTimerScheduling_ = false;
 
     public:
         JackServerSettings();
@@ -64,10 +70,16 @@ namespace pipedal
         const std::string &GetAlsaInputDevice()  const { return alsaInputDevice_; }
         const std::string &GetAlsaOutputDevice() const { return alsaOutputDevice_; }
         const std::string &GetLegacyAlsaDevice() const { return alsaDevice_; } //legacy
+        bool GetAlsaMmap() const { return alsaMmap_; }
+        bool GetAlsaInputClockMaster() const { return alsaInputClockMaster_; }
+        bool GetAlsaTimerScheduling() const { return alsaTimerScheduling_; }
 
         void SetAlsaInputDevice(const std::string &d){ alsaInputDevice_ = d; }
         void SetAlsaOutputDevice(const std::string &d){ alsaOutputDevice_ = d; }
         void SetLegacyAlsaDevice(const std::string &d) { alsaDevice_ = d; }
+        void SetAlsaMmap(bool value) { alsaMmap_ = value; }
+        void SetAlsaInputClockMaster(bool value) { alsaInputClockMaster_ = value; }
+        void SetAlsaTimerScheduling(bool value) { alsaTimerScheduling_ = value; }
         
         void UseDummyAudioDevice() {
             this->valid_ = true;
@@ -82,6 +94,10 @@ namespace pipedal
                 || this->alsaDevice_.starts_with("dummy:")
                 || this->alsaInputDevice_.starts_with("dummy:");
         }
+        // "pipewire:channels_<n>": a PipeWire filter node, instead of an ALSA device.
+        bool IsPipeWireAudioDevice() const {
+            return this->alsaInputDevice_.starts_with("pipewire:");
+        }
 
         void ReadJackDaemonConfiguration();
 
@@ -104,7 +120,10 @@ namespace pipedal
                    this->alsaDevice_       == other.alsaDevice_ &&
                    this->sampleRate_       == other.sampleRate_ &&
                    this->bufferSize_       == other.bufferSize_ &&
-                   this->numberOfBuffers_  == other.numberOfBuffers_;
+                   this->numberOfBuffers_  == other.numberOfBuffers_ &&
+                   this->alsaMmap_         == other.alsaMmap_ &&
+                   this->alsaInputClockMaster_ == other.alsaInputClockMaster_ &&
+                   this->alsaTimerScheduling_ == other.alsaTimerScheduling_;
         }
 
         DECLARE_JSON_MAP(JackServerSettings);
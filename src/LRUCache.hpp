@@ -44,80 +44,492 @@
  */
 #pragma once 
 
-#include <unordered_map>
-#include <list>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
-template <typename KEY, typename VALUE>
+// The default LRUCache hash. Transparent for std::string keys, so that lookups can use a
+// std::string_view or const char * without constructing a std::string.
+template <typename KEY>
+struct LRUCacheHash : public std::hash<KEY>
+{
+};
+
+template <>
+struct LRUCacheHash<std::string>
+{
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const { return std::hash<std::string_view>{}(value); }
+};
+
+// The default LRUCache weigher: every entry weighs 1, so the capacity is a number of entries.
+struct LRUCacheUnitWeight
+{
+    template <typename KEY, typename VALUE>
+    size_t operator()(const KEY &, const VALUE &) const { return 1; }
+};
+
+/**
+ * @brief A least-recently-used cache.
+ *
+ * Entries live in a single slab (a vector of nodes, linked by index into an LRU list), indexed by an
+ * open-addressed hash table of slab indices, so puts don't allocate once the slab has grown to
+ * its working size. Unit-weighted caches reserve the slab up front.
+ *
+ * The capacity is measured by WEIGHER, a function object that returns the weight of a (key, value)
+ * pair; by default each entry weighs 1. When a put takes the total weight over capacity, least-recently-
+ * used entries are evicted (but never the entry that was just added).
+ *
+ * Lookups take any type that HASH and KEY_EQUAL accept if HASH is transparent (e.g. std::string_view
+ * for std::string keys), or KEY otherwise.
+ *
+ * Not thread-safe. See ShardedLRUCache.
+ */
+template <typename KEY, typename VALUE,
+          typename HASH = LRUCacheHash<KEY>,
+          typename KEY_EQUAL = std::equal_to<>,
+          typename WEIGHER = LRUCacheUnitWeight>
 class LRUCache {
 public:
     struct CacheNode {
         KEY key;
         VALUE value;
-        CacheNode(KEY k, VALUE v) : key(k), value(v) {}
+        template <typename K, typename... ARGS>
+            requires(!std::is_same_v<std::remove_cvref_t<K>, CacheNode>)
+        CacheNode(K &&k, ARGS &&...args) : key(std::forward<K>(k)), value(std::forward<ARGS>(args)...) {}
     };
+
+    template <typename K>
+    static constexpr bool is_lookup_key =
+        std::is_same_v<std::remove_cvref_t<K>, KEY> || requires { typename HASH::is_transparent; };
+
 private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr size_t MAX_RESERVED_NODES = 4096;
+
+    struct Slot {
+        std::optional<CacheNode> node;
+        size_t hash = 0;
+        size_t weight = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL; // the free list link, when not in use.
+    };
+
     size_t capacity;
-    std::list<CacheNode> cache_list; // Doubly-linked list for LRU order
-    std::unordered_map<KEY, typename std::list<CacheNode>::iterator> cache_map; // Map key to list iterator
+    HASH hasher;
+    KEY_EQUAL keyEqual;
+    WEIGHER weigher;
+
+    std::vector<Slot> slots;
+    uint32_t head = NIL; // most recently used.
+    uint32_t tail = NIL; // least recently used.
+    uint32_t freeList = NIL;
+    size_t count = 0;
+    size_t totalWeight = 0;
+
+    std::vector<uint32_t> table; // slot indices, or NIL.
+    int tableShift = 64 - 3;
 
 public:
-    explicit LRUCache(size_t cap) : capacity(cap) {
+    class const_iterator {
+    public:
+        const_iterator(const LRUCache *cache, uint32_t index) : cache(cache), index(index) {}
+        const CacheNode &operator*() const { return *(cache->slots[index].node); }
+        const CacheNode *operator->() const { return &*(cache->slots[index].node); }
+        const_iterator &operator++()
+        {
+            index = cache->slots[index].next;
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return index == other.index; }
+        bool operator!=(const const_iterator &other) const { return index != other.index; }
+
+    private:
+        const LRUCache *cache;
+        uint32_t index;
+    };
+
+    // The entries, most recently used first.
+    class CacheView {
+    public:
+        CacheView(const LRUCache *cache) : cache(cache) {}
+        const_iterator begin() const { return const_iterator(cache, cache->head); }
+        const_iterator end() const { return const_iterator(cache, NIL); }
+        size_t size() const { return cache->count; }
+        bool empty() const { return cache->count == 0; }
+
+    private:
+        const LRUCache *cache;
+    };
+
+    explicit LRUCache(size_t cap, const WEIGHER &weigher = WEIGHER()) : capacity(cap), weigher(weigher) {
         if (cap == 0) {
             throw std::invalid_argument("Cache capacity must be greater than 0");
         }
+        if constexpr (std::is_same_v<WEIGHER, LRUCacheUnitWeight>) {
+            size_t reserved = std::min(cap, MAX_RESERVED_NODES);
+            slots.reserve(reserved + 1);
+            Rehash((reserved + 1) * 2);
+        } else {
+            Rehash(8);
+        }
     }
 
     // Get value by key, return false if not found
-    bool get(const KEY& key, VALUE& value) {
-        auto it = cache_map.find(key);
-        if (it == cache_map.end()) {
+    template <typename K>
+        requires is_lookup_key<K>
+    bool get(const K &key, VALUE &value) {
+        VALUE *result = find(key);
+        if (!result) {
             return false;
         }
-        // Move to front (most recently used)
-        cache_list.splice(cache_list.begin(), cache_list, it->second);
-        value = it->second->value;
+        value = *result;
         return true;
     }
 
+    // The entry's value (moved to the front), or nullptr. Valid until the next non-const call.
+    template <typename K>
+        requires is_lookup_key<K>
+    VALUE *find(const K &key) {
+        size_t bucket;
+        uint32_t index = FindSlot(key, hasher(key), &bucket);
+        if (index == NIL) {
+            return nullptr;
+        }
+        MoveToFront(index);
+        return &(slots[index].node->value);
+    }
+
     // Put key-value pair into cache
-    void put(const KEY& key, const VALUE& value) {
-        auto it = cache_map.find(key);
-        if (it != cache_map.end()) {
-            // Update existing key
-            cache_list.splice(cache_list.begin(), cache_list, it->second);
-            it->second->value = value;
-            return;
+    void put(const KEY &key, const VALUE &value) {
+        auto [result, inserted] = try_emplace(key, value);
+        if (!inserted) {
+            *result = value;
+            UpdateWeight(head);
+            Evict();
         }
+    }
 
-        // Add new key-value pair
-        cache_list.emplace_front(key, value);
-        cache_map[key] = cache_list.begin();
+    /**
+     * @brief Insert an entry constructed from args, if the key isn't already present.
+     *
+     * @return The entry's value, and true if it was inserted. An existing entry is moved to the front, but not modified.
+     */
+    template <typename K, typename... ARGS>
+        requires is_lookup_key<K>
+    std::pair<VALUE *, bool> try_emplace(K &&key, ARGS &&...args) {
+        size_t hash = hasher(key);
+        size_t bucket;
+        uint32_t index = FindSlot(key, hash, &bucket);
+        if (index != NIL) {
+            MoveToFront(index);
+            return {&(slots[index].node->value), false};
+        }
+        if ((count + 1) * 2 > table.size()) {
+            Rehash((count + 1) * 2);
+            FindSlot(key, hash, &bucket);
+        }
+        index = AllocateSlot();
+        Slot &slot = slots[index];
+        slot.node.emplace(std::forward<K>(key), std::forward<ARGS>(args)...);
+        slot.hash = hash;
+        slot.weight = 0;
+        table[bucket] = index;
+        ++count;
+        LinkFront(index);
+        UpdateWeight(index);
+        Evict();
+        return {&(slot.node->value), true};
+    }
 
-        // Evict least recently used if over capacity
-        if (cache_map.size() > capacity) {
-            auto lru = cache_list.back();
-            cache_map.erase(lru.key);
-            cache_list.pop_back();
+    // Remove key-value pair, return false if not found
+    template <typename K>
+        requires is_lookup_key<K>
+    bool erase(const K &key) {
+        size_t bucket;
+        uint32_t index = FindSlot(key, hasher(key), &bucket);
+        if (index == NIL) {
+            return false;
         }
+        EraseSlot(index, bucket);
+        return true;
     }
 
     // Check if key exists
-    bool contains(const KEY& key) const {
-        return cache_map.find(key) != cache_map.end();
+    template <typename K>
+        requires is_lookup_key<K>
+    bool contains(const K &key) const {
+        size_t bucket;
+        return FindSlot(key, hasher(key), &bucket) != NIL;
+    }
+
+    void clear() {
+        slots.clear();
+        head = tail = freeList = NIL;
+        count = 0;
+        totalWeight = 0;
+        std::fill(table.begin(), table.end(), NIL);
     }
 
     // Get current size
     size_t size() const {
-        return cache_map.size();
+        return count;
+    }
+    // The total weight of the entries (the same as size() for unit-weighted caches).
+    size_t weight() const {
+        return totalWeight;
     }
 
     // Get capacity
     size_t get_capacity() const {
         return capacity;
     }
-    const std::list<CacheNode> &cache() const {
-        return cache_list;
+    CacheView cache() const {
+        return CacheView(this);
+    }
+
+private:
+    size_t Bucket(size_t hash) const {
+        // Fibonacci hashing, since std::hash is the identity for integers.
+        return (size_t)(((uint64_t)hash * 0x9E3779B97F4A7C15ull) >> tableShift);
+    }
+    size_t BucketMask() const { return table.size() - 1; }
+
+    template <typename K>
+    uint32_t FindSlot(const K &key, size_t hash, size_t *bucket) const {
+        size_t i = Bucket(hash);
+        while (true) {
+            uint32_t index = table[i];
+            if (index == NIL) {
+                *bucket = i;
+                return NIL;
+            }
+            const Slot &slot = slots[index];
+            if (slot.hash == hash && keyEqual(slot.node->key, key)) {
+                *bucket = i;
+                return index;
+            }
+            i = (i + 1) & BucketMask();
+        }
+    }
+
+    void Rehash(size_t minimumSize) {
+        size_t size = 8;
+        int shift = 64 - 3;
+        while (size < minimumSize) {
+            size *= 2;
+            --shift;
+        }
+        if (size <= table.size()) {
+            return;
+        }
+        table.assign(size, NIL);
+        tableShift = shift;
+        for (uint32_t index = head; index != NIL; index = slots[index].next) {
+            size_t i = Bucket(slots[index].hash);
+            while (table[i] != NIL) {
+                i = (i + 1) & BucketMask();
+            }
+            table[i] = index;
+        }
+    }
+
+    uint32_t AllocateSlot() {
+        if (freeList != NIL) {
+            uint32_t index = freeList;
+            freeList = slots[index].next;
+            return index;
+        }
+        slots.emplace_back();
+        return (uint32_t)(slots.size() - 1);
+    }
+
+    void LinkFront(uint32_t index) {
+        Slot &slot = slots[index];
+        slot.prev = NIL;
+        slot.next = head;
+        if (head != NIL) {
+            slots[head].prev = index;
+        }
+        head = index;
+        if (tail == NIL) {
+            tail = index;
+        }
+    }
+    void Unlink(uint32_t index) {
+        Slot &slot = slots[index];
+        if (slot.prev != NIL) {
+            slots[slot.prev].next = slot.next;
+        } else {
+            head = slot.next;
+        }
+        if (slot.next != NIL) {
+            slots[slot.next].prev = slot.prev;
+        } else {
+            tail = slot.prev;
+        }
+    }
+    void MoveToFront(uint32_t index) {
+        if (index != head) {
+            Unlink(index);
+            LinkFront(index);
+        }
+    }
+
+    void UpdateWeight(uint32_t index) {
+        Slot &slot = slots[index];
+        totalWeight -= slot.weight;
+        slot.weight = weigher(slot.node->key, slot.node->value);
+        totalWeight += slot.weight;
+    }
+
+    void Evict() {
+        while (totalWeight > capacity && count > 1) {
+            size_t bucket;
+            uint32_t index = FindSlot(slots[tail].node->key, slots[tail].hash, &bucket);
+            EraseSlot(index, bucket);
+        }
+    }
+
+    void EraseSlot(uint32_t index, size_t bucket) {
+        // backward-shift deletion, so that probe sequences stay unbroken without tombstones.
+        size_t i = bucket;
+        size_t j = bucket;
+        while (true) {
+            j = (j + 1) & BucketMask();
+            uint32_t other = table[j];
+            if (other == NIL) {
+                break;
+            }
+            size_t ideal = Bucket(slots[other].hash);
+            // move the entry back unless its ideal bucket lies cyclically in (i, j].
+            bool inRange = (i <= j) ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+            if (!inRange) {
+                table[i] = other;
+                i = j;
+            }
+        }
+        table[i] = NIL;
+
+        Unlink(index);
+        Slot &slot = slots[index];
+        totalWeight -= slot.weight;
+        slot.weight = 0;
+        slot.node.reset();
+        slot.next = freeList;
+        freeList = index;
+        --count;
     }
 };
 
+/**
+ * @brief A thread-safe LRUCache, split into independently locked shards to reduce lock contention.
+ *
+ * Eviction is per shard, so each shard holds at most capacity/SHARDS (rounded up). Values are
+ * returned by copy, since a pointer into a shard would outlive the shard's lock.
+ */
+template <typename KEY, typename VALUE,
+          size_t SHARDS = 16,
+          typename HASH = LRUCacheHash<KEY>,
+          typename KEY_EQUAL = std::equal_to<>,
+          typename WEIGHER = LRUCacheUnitWeight>
+class ShardedLRUCache {
+public:
+    using cache_type = LRUCache<KEY, VALUE, HASH, KEY_EQUAL, WEIGHER>;
+
+    explicit ShardedLRUCache(size_t capacity, const WEIGHER &weigher = WEIGHER()) : capacity(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Cache capacity must be greater than 0");
+        }
+        size_t shardCapacity = (capacity + SHARDS - 1) / SHARDS;
+        for (size_t i = 0; i < SHARDS; ++i) {
+            shards[i] = std::make_unique<Shard>(shardCapacity, weigher);
+        }
+    }
+
+    template <typename K>
+        requires cache_type::template is_lookup_key<K>
+    bool get(const K &key, VALUE &value) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.get(key, value);
+    }
+
+    void put(const KEY &key, const VALUE &value) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.cache.put(key, value);
+    }
+
+    // Returns true if the entry was inserted, false if the key was already present.
+    template <typename K, typename... ARGS>
+        requires cache_type::template is_lookup_key<K>
+    bool try_emplace(K &&key, ARGS &&...args) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.try_emplace(std::forward<K>(key), std::forward<ARGS>(args)...).second;
+    }
+
+    template <typename K>
+        requires cache_type::template is_lookup_key<K>
+    bool erase(const K &key) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.erase(key);
+    }
+
+    template <typename K>
+        requires cache_type::template is_lookup_key<K>
+    bool contains(const K &key) const {
+        Shard &shard = GetShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.cache.contains(key);
+    }
+
+    void clear() {
+        for (auto &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->cache.clear();
+        }
+    }
+
+    size_t size() const {
+        size_t result = 0;
+        for (auto &shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            result += shard->cache.size();
+        }
+        return result;
+    }
+
+    size_t get_capacity() const {
+        return capacity;
+    }
+
+private:
+    struct alignas(64) Shard {
+        Shard(size_t capacity, const WEIGHER &weigher) : cache(capacity, weigher) {}
+        std::mutex mutex;
+        cache_type cache;
+    };
+
+    template <typename K>
+    Shard &GetShard(const K &key) const {
+        // use the high bits, since each shard's hash table uses the low bits.
+        uint64_t hash = (uint64_t)HASH{}(key) * 0xC2B2AE3D27D4EB4Full;
+        return *shards[(size_t)(hash >> 32) % SHARDS];
+    }
+
+    size_t capacity;
+    std::unique_ptr<Shard> shards[SHARDS];
+};
@@ -22,6 +22,11 @@
 #include "LRUCache.hpp"
 #include <string>
 #include <iostream>
+#include <chrono>
+#include <list>
+#include <random>
+#include <thread>
+#include <unordered_map>
 
 using namespace std;
 
@@ -60,8 +65,184 @@ TEST_CASE( "LRUCache test", "[lrucache]" ) {
     }
     cout << ']' << endl;
 
+    REQUIRE(lruCache.erase(1) == true);
+    REQUIRE(lruCache.erase(1) == false);
+    REQUIRE(lruCache.contains(1) == false);
+    REQUIRE(lruCache.size() == 4);
+    REQUIRE(lruCache.get(5,value) == true);
+}
+
+TEST_CASE( "LRUCache heterogeneous lookup", "[lrucache]" ) {
+    LRUCache<std::string,int> lruCache(3);
+
+    REQUIRE(lruCache.try_emplace(std::string_view("a"), 1).second == true);
+    REQUIRE(lruCache.try_emplace("a", 2).second == false);
+    int value;
+    REQUIRE(lruCache.get(std::string_view("a"), value));
+    REQUIRE(value == 1);
+    REQUIRE(lruCache.contains("a"));
+
+    lruCache.put("b",2);
+    lruCache.put("c",3);
+    REQUIRE(lruCache.find("a") != nullptr); // a is now the most recently used.
+    lruCache.put("d",4);
+    REQUIRE(!lruCache.contains("b"));
+    REQUIRE(lruCache.contains("a"));
+    REQUIRE(lruCache.erase(std::string_view("c")));
+    REQUIRE(lruCache.size() == 2);
+
+    // erase-heavy churn, to exercise backward-shift deletion.
+    LRUCache<int,int> intCache(64);
+    std::mt19937 random(1);
+    std::unordered_map<int,int> expected;
+    for (int i = 0; i < 100000; ++i)
+    {
+        int key = (int)(random() % 200);
+        if (random() % 3 == 0) {
+            intCache.erase(key);
+            expected.erase(key);
+        } else {
+            intCache.put(key,i);
+            expected[key] = i;
+        }
+        REQUIRE(intCache.size() <= 64);
+    }
+    for (const auto &node: intCache.cache())
+    {
+        REQUIRE(expected[node.key] == node.value);
+        REQUIRE(intCache.contains(node.key));
+    }
+}
+
+namespace {
+    struct StringWeight {
+        size_t operator()(const std::string &, const std::string &value) const { return value.size(); }
+    };
+}
+
+TEST_CASE( "LRUCache weighted capacity", "[lrucache]" ) {
+    LRUCache<std::string,std::string,LRUCacheHash<std::string>,std::equal_to<>,StringWeight> lruCache(100);
+
+    lruCache.put("a",std::string(40,'a'));
+    lruCache.put("b",std::string(40,'b'));
+    REQUIRE(lruCache.weight() == 80);
+    lruCache.put("c",std::string(40,'c'));
+    REQUIRE(!lruCache.contains("a"));
+    REQUIRE(lruCache.weight() == 80);
 
+    // replacing a value updates its weight.
+    lruCache.put("b",std::string(10,'b'));
+    REQUIRE(lruCache.weight() == 50);
 
+    // an entry heavier than the capacity is kept on its own.
+    lruCache.put("d",std::string(200,'d'));
+    REQUIRE(lruCache.size() == 1);
+    REQUIRE(lruCache.contains("d"));
+}
+
+TEST_CASE( "ShardedLRUCache", "[lrucache]" ) {
+    ShardedLRUCache<std::string,int> lruCache(1600);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&lruCache,t]() {
+            for (int i = 0; i < 10000; ++i)
+            {
+                std::string key = std::to_string((i * 7 + t) % 1000);
+                int value;
+                if (!lruCache.get(key,value))
+                {
+                    lruCache.put(key,i);
+                }
+            }
+        });
+    }
+    for (auto &thread: threads)
+    {
+        thread.join();
+    }
+    REQUIRE(lruCache.size() <= 1600);
+    REQUIRE(lruCache.size() == 1000);
+    REQUIRE(lruCache.try_emplace("x",1) == true);
+    REQUIRE(lruCache.contains(std::string_view("x")));
+    REQUIRE(lruCache.erase("x"));
+}
+
+namespace {
+    // The previous std::list + std::unordered_map implementation, for comparison.
+    template <typename KEY, typename VALUE>
+    class ListLRUCache {
+    public:
+        ListLRUCache(size_t capacity) : capacity(capacity) {}
+        bool get(const KEY &key, VALUE &value) {
+            auto it = map.find(key);
+            if (it == map.end()) {
+                return false;
+            }
+            list.splice(list.begin(), list, it->second);
+            value = it->second->second;
+            return true;
+        }
+        void put(const KEY &key, const VALUE &value) {
+            auto it = map.find(key);
+            if (it != map.end()) {
+                list.splice(list.begin(), list, it->second);
+                it->second->second = value;
+                return;
+            }
+            list.emplace_front(key, value);
+            map[key] = list.begin();
+            if (map.size() > capacity) {
+                map.erase(list.back().first);
+                list.pop_back();
+            }
+        }
+    private:
+        size_t capacity;
+        std::list<std::pair<KEY,VALUE>> list;
+        std::unordered_map<KEY, typename std::list<std::pair<KEY,VALUE>>::iterator> map;
+    };
+
+    template <typename CACHE>
+    double BenchmarkCache(CACHE &cache, const std::vector<std::string> &keys)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int value = 0;
+        int hits = 0;
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            if (cache.get(keys[i], value)) {
+                ++hits;
+            } else {
+                cache.put(keys[i],(int)i);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(hits > 0);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / (double)keys.size();
+    }
+}
+
+TEST_CASE( "LRUCache benchmark", "[lrucache_benchmark]" ) {
+    constexpr size_t CAPACITY = 1000;
+    std::mt19937 random(1);
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 2000000; ++i)
+    {
+        // skewed, so that the hit rate is neither 0 nor 1.
+        size_t n = random() % 4000;
+        n = (n * n) / 4000;
+        keys.push_back("/var/pipedal/audio_uploads/" + std::to_string(n));
+    }
 
+    ListLRUCache<std::string,int> listCache(CAPACITY);
+    LRUCache<std::string,int> slabCache(CAPACITY);
+    ShardedLRUCache<std::string,int> shardedCache(CAPACITY);
 
-}
\ No newline at end of file
+    double listNs = BenchmarkCache(listCache,keys);
+    double slabNs = BenchmarkCache(slabCache,keys);
+    double shardedNs = BenchmarkCache(shardedCache,keys);
+    cout << "std::list LRU cache: " << listNs << " ns/op" << endl;
+    cout << "LRUCache: " << slabNs << " ns/op" << endl;
+    cout << "ShardedLRUCache (uncontended): " << shardedNs << " ns/op" << endl;
+}
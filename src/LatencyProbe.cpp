@@ -0,0 +1,232 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "LatencyProbe.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace pipedal;
+
+static constexpr int MIN_ORDER = 12;
+static constexpr int MAX_ORDER = 16;
+
+std::vector<float> LatencyProbe::MaximumLengthSequence(int order)
+{
+    // Fibonacci LFSR taps for primitive polynomials.
+    static const std::vector<int> TAPS[] = {
+        {10, 7},
+        {11, 9},
+        {12, 6, 4, 1},
+        {13, 4, 3, 1},
+        {14, 5, 3, 1},
+        {15, 14},
+        {16, 15, 13, 4},
+    };
+    if (order < 10 || order > MAX_ORDER)
+    {
+        throw std::invalid_argument("Unsupported MLS order.");
+    }
+    const std::vector<int> &taps = TAPS[order - 10];
+    size_t length = (size_t(1) << order) - 1;
+
+    std::vector<float> result(length);
+    uint32_t state = 1;
+    for (size_t i = 0; i < length; ++i)
+    {
+        result[i] = (state & 1) ? 1.0f : -1.0f;
+        uint32_t bit = 0;
+        for (int tap : taps)
+        {
+            bit ^= state >> (order - tap);
+        }
+        state = (state >> 1) | ((bit & 1) << (order - 1));
+    }
+    return result;
+}
+
+LatencyProbe::LatencyProbe(double sampleRate, size_t inputChannel, size_t outputChannel)
+    : inputChannel(inputChannel),
+      outputChannel(outputChannel)
+{
+    int order = MIN_ORDER;
+    while (order < MAX_ORDER && (double)((size_t(1) << order) - 1) < sampleRate * 0.1)
+    {
+        ++order;
+    }
+    sequence = MaximumLengthSequence(order);
+    recording.resize(sequence.size() * PERIODS);
+    settleFrames = (size_t)(sampleRate * 0.25);
+}
+
+void LatencyProbe::Process(const float *input, float *output, size_t frames)
+{
+    if (output)
+    {
+        std::fill(output, output + frames, 0.0f);
+    }
+
+    size_t length = sequence.size();
+    for (size_t i = 0; i < frames; ++i)
+    {
+        if (frame >= settleFrames)
+        {
+            size_t t = frame - settleFrames;
+            if (t < recording.size())
+            {
+                if (output)
+                {
+                    output[i] = sequence[t % length] * LEVEL;
+                }
+                recording[t] = input ? input[i] : 0.0f;
+            }
+        }
+        ++frame;
+    }
+    if (frame >= GetDurationFrames())
+    {
+        complete.store(true, std::memory_order_release);
+    }
+}
+
+LatencyProbe::Result LatencyProbe::Analyze() const
+{
+    if (!IsComplete())
+    {
+        throw std::logic_error("Latency probe has not completed.");
+    }
+    size_t length = sequence.size();
+
+    // average the steady-state periods.
+    std::vector<float> average(length, 0.0f);
+    for (size_t period = 1; period < PERIODS; ++period)
+    {
+        const float *p = recording.data() + period * length;
+        for (size_t n = 0; n < length; ++n)
+        {
+            average[n] += p[n];
+        }
+    }
+    for (size_t n = 0; n < length; ++n)
+    {
+        average[n] *= 1.0f / (PERIODS - 1);
+    }
+
+    // circular cross-correlation with the sequence.
+    std::vector<double> correlation(length);
+    const float *s = sequence.data();
+    const float *a = average.data();
+    for (size_t lag = 0; lag < length; ++lag)
+    {
+        float sum = 0;
+        for (size_t n = lag; n < length; ++n)
+        {
+            sum += a[n] * s[n - lag];
+        }
+        for (size_t n = 0; n < lag; ++n)
+        {
+            sum += a[n] * s[n + length - lag];
+        }
+        correlation[lag] = sum;
+    }
+
+    size_t peakLag = 0;
+    for (size_t lag = 1; lag < length; ++lag)
+    {
+        if (std::abs(correlation[lag]) > std::abs(correlation[peakLag]))
+        {
+            peakLag = lag;
+        }
+    }
+    double sumSquares = 0;
+    size_t count = 0;
+    for (size_t lag = 0; lag < length; ++lag)
+    {
+        size_t distance = lag > peakLag ? lag - peakLag : peakLag - lag;
+        distance = std::min(distance, length - distance);
+        if (distance > 2)
+        {
+            sumSquares += correlation[lag] * correlation[lag];
+            ++count;
+        }
+    }
+    double peak = std::abs(correlation[peakLag]);
+    double rms = std::sqrt(sumSquares / std::max(count, (size_t)1));
+
+    Result result;
+    result.peakRatio = rms == 0 ? (peak == 0 ? 0.0f : 1e6f) : (float)(peak / rms);
+    double level = peak / ((double)length * LEVEL);
+    result.signalLevelDb = level <= 1.5e-5 ? -96.0f : (float)(20 * std::log10(level));
+    result.signalDetected = result.peakRatio >= MIN_PEAK_RATIO;
+    result.latencyFrames = result.signalDetected ? (int64_t)peakLag : 0;
+    return result;
+}
+
+bool LatencyMeasurement::SameConfiguration(const LatencyMeasurement &other) const
+{
+    return inputDevice_ == other.inputDevice_ &&
+           outputDevice_ == other.outputDevice_ &&
+           sampleRate_ == other.sampleRate_ &&
+           bufferSize_ == other.bufferSize_ &&
+           numberOfBuffers_ == other.numberOfBuffers_ &&
+           inputChannel_ == other.inputChannel_ &&
+           outputChannel_ == other.outputChannel_;
+}
+
+int64_t LatencyMeasurement::Recommend(
+    const std::vector<LatencyMeasurement> &measurements,
+    const std::string &inputDevice, const std::string &outputDevice)
+{
+    int64_t result = -1;
+    for (size_t i = 0; i < measurements.size(); ++i)
+    {
+        const auto &measurement = measurements[i];
+        if (measurement.stable_ && measurement.inputDevice_ == inputDevice && measurement.outputDevice_ == outputDevice)
+        {
+            if (result == -1 || measurement.latencyMs_ < measurements[result].latencyMs_)
+            {
+                result = (int64_t)i;
+            }
+        }
+    }
+    return result;
+}
+
+JSON_MAP_BEGIN(LatencyMeasurement)
+    JSON_MAP_REFERENCE(LatencyMeasurement, inputDevice)
+    JSON_MAP_REFERENCE(LatencyMeasurement, outputDevice)
+    JSON_MAP_REFERENCE(LatencyMeasurement, sampleRate)
+    JSON_MAP_REFERENCE(LatencyMeasurement, bufferSize)
+    JSON_MAP_REFERENCE(LatencyMeasurement, numberOfBuffers)
+    JSON_MAP_REFERENCE(LatencyMeasurement, inputChannel)
+    JSON_MAP_REFERENCE(LatencyMeasurement, outputChannel)
+    JSON_MAP_REFERENCE(LatencyMeasurement, signalDetected)
+    JSON_MAP_REFERENCE(LatencyMeasurement, latencyFrames)
+    JSON_MAP_REFERENCE(LatencyMeasurement, latencyMs)
+    JSON_MAP_REFERENCE(LatencyMeasurement, peakRatio)
+    JSON_MAP_REFERENCE(LatencyMeasurement, signalLevelDb)
+    JSON_MAP_REFERENCE(LatencyMeasurement, stressSeconds)
+    JSON_MAP_REFERENCE(LatencyMeasurement, xruns)
+    JSON_MAP_REFERENCE(LatencyMeasurement, cpuUsage)
+    JSON_MAP_REFERENCE(LatencyMeasurement, stable)
+    JSON_MAP_REFERENCE(LatencyMeasurement, time)
+    JSON_MAP_REFERENCE(LatencyMeasurement, recommended)
+JSON_MAP_END()
@@ -0,0 +1,125 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Measures round-trip (output to input) latency through a loopback cable, on the live audio stream.
+     *
+     * Plays a maximum-length sequence (MLS) at -20dBFS on one output channel for several periods of the
+     * sequence, and records one input channel. The recorded periods (after the first, which contains the
+     * onset) are averaged, and circularly cross-correlated with the sequence; the lag of the correlation
+     * peak is the round-trip latency. Unlike a single impulse, an MLS measurement tolerates noise and
+     * modest signal levels, and isn't fooled by a polarity-inverting interface.
+     *
+     * The sequence is long enough to measure latencies of up to a tenth of a second (at least).
+     *
+     * Process() runs on the audio thread, and doesn't allocate. Analyze() runs afterwards, on any other thread.
+     */
+    class LatencyProbe
+    {
+    public:
+        class Result
+        {
+        public:
+            bool signalDetected = false;
+            int64_t latencyFrames = 0;
+            float peakRatio = 0;       // correlation peak / rms of the rest of the correlation.
+            float signalLevelDb = -96; // level of the recovered sequence, relative to the level played.
+        };
+
+        LatencyProbe(double sampleRate, size_t inputChannel = 0, size_t outputChannel = 0);
+
+        size_t GetInputChannel() const { return inputChannel; }
+        size_t GetOutputChannel() const { return outputChannel; }
+        size_t GetSequenceLength() const { return sequence.size(); }
+        // total length of the test, in frames.
+        size_t GetDurationFrames() const { return settleFrames + recording.size(); }
+
+        // Audio thread. input and output are the selected channels' buffers, either of which may be null.
+        // Overwrites output; the caller silences the other outputs.
+        void Process(const float *input, float *output, size_t frames);
+        bool IsComplete() const { return complete.load(std::memory_order_acquire); }
+
+        // After IsComplete().
+        Result Analyze() const;
+
+        // The MLS of the given order (2^order-1 values of +1/-1). Orders 10 through 16.
+        static std::vector<float> MaximumLengthSequence(int order);
+
+    private:
+        static constexpr float LEVEL = 0.1f; // -20dBFS.
+        static constexpr size_t PERIODS = 5; // the first of which isn't measured.
+        static constexpr float MIN_PEAK_RATIO = 10;
+
+        size_t inputChannel;
+        size_t outputChannel;
+        size_t settleFrames;
+        std::vector<float> sequence;
+        std::vector<float> recording;
+
+        size_t frame = 0;
+        std::atomic<bool> complete{false};
+    };
+
+    // A stored latency measurement, for a particular audio configuration.
+    class LatencyMeasurement
+    {
+    public:
+        std::string inputDevice_;
+        std::string outputDevice_;
+        uint64_t sampleRate_ = 0;
+        uint32_t bufferSize_ = 0;
+        uint32_t numberOfBuffers_ = 0;
+        int32_t inputChannel_ = 0;
+        int32_t outputChannel_ = 0;
+
+        bool signalDetected_ = false;
+        int64_t latencyFrames_ = 0;
+        float latencyMs_ = 0;
+        float peakRatio_ = 0;
+        float signalLevelDb_ = -96;
+
+        float stressSeconds_ = 0; // how long the configuration ran afterwards, with the current preset.
+        uint64_t xruns_ = 0;      // during the measurement and the stress run.
+        float cpuUsage_ = 0;      // percent, at the end of the stress run.
+        bool stable_ = false;     // signal detected, and no xruns.
+        std::string time_;        // ISO 8601, UTC.
+        bool recommended_ = false; // not stored: the lowest-latency stable configuration for the current devices.
+
+        bool SameConfiguration(const LatencyMeasurement &other) const;
+
+        // The index of the stable measurement with the lowest latency for the given devices; or -1.
+        static int64_t Recommend(
+            const std::vector<LatencyMeasurement> &measurements,
+            const std::string &inputDevice, const std::string &outputDevice);
+
+        DECLARE_JSON_MAP(LatencyMeasurement);
+    };
+}
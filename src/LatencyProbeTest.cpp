@@ -0,0 +1,97 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "LatencyProbe.hpp"
+#include <cmath>
+#include <deque>
+#include <random>
+
+using namespace pipedal;
+
+TEST_CASE("Maximum length sequences", "[latency_probe][Build][Dev]")
+{
+    for (int order = 10; order <= 16; ++order)
+    {
+        auto sequence = LatencyProbe::MaximumLengthSequence(order);
+        size_t length = sequence.size();
+        REQUIRE(length == (size_t(1) << order) - 1);
+
+        // balanced, and a two-valued circular autocorrelation.
+        double sum = 0;
+        for (float v : sequence)
+        {
+            sum += v;
+        }
+        REQUIRE(sum == 1);
+        for (size_t lag = 1; lag < 40; ++lag)
+        {
+            double correlation = 0;
+            for (size_t n = 0; n < length; ++n)
+            {
+                correlation += sequence[n] * sequence[(n + lag) % length];
+            }
+            REQUIRE(correlation == -1);
+        }
+    }
+}
+
+// Runs a probe through a simulated loopback cable: delay, gain, and noise.
+static LatencyProbe::Result SimulateLoopback(size_t delay, float gain, float noise)
+{
+    constexpr size_t PERIOD = 64;
+    LatencyProbe probe(48000);
+
+    std::deque<float> cable(delay, 0.0f);
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> distribution(-noise, noise);
+
+    std::vector<float> in1(PERIOD), out0(PERIOD);
+    size_t maxPeriods = probe.GetDurationFrames() / PERIOD + 2;
+    for (size_t i = 0; i < maxPeriods && !probe.IsComplete(); ++i)
+    {
+        for (size_t f = 0; f < PERIOD; ++f)
+        {
+            cable.push_back(out0[f]); // from the previous period.
+            in1[f] = cable.front() * gain + distribution(random);
+            cable.pop_front();
+        }
+        probe.Process(in1.data(), out0.data(), PERIOD);
+    }
+    REQUIRE(probe.IsComplete());
+    return probe.Analyze();
+}
+
+TEST_CASE("Latency probe loopback", "[latency_probe][Build][Dev]")
+{
+    // each period's output is the cable input after the next period's input, so
+    // the round trip through the simulation adds one period (64 frames).
+    for (size_t delay : {0, 37, 300, 2000})
+    {
+        auto result = SimulateLoopback(delay, -0.5f, 0.05f);
+        REQUIRE(result.signalDetected);
+        REQUIRE(result.latencyFrames == (int64_t)delay + 64);
+        REQUIRE(std::abs(result.signalLevelDb - 20 * std::log10(0.5f)) < 0.5f);
+    }
+    // no cable.
+    auto result = SimulateLoopback(100, 0.0f, 0.05f);
+    REQUIRE(!result.signalDetected);
+}
@@ -142,6 +142,7 @@ public:
     typedef void (*ucol_close_t)(UCollator *);
     typedef UCollationResult (*ucol_strcoll_t)(const UCollator *, const UChar *, int32_t, const UChar *, int32_t);
     using ucol_setStrength_t = typeof(&ucol_setStrength);
+    using ucol_getSortKey_t = typeof(&ucol_getSortKey);
 
     static ptr icuLoader;
     static std::mutex icuLoaderMutex;
@@ -171,6 +172,8 @@ public:
     ucol_close_t ucol_close_fn;
     ucol_strcoll_t ucol_strcoll_fn;
     ucol_setStrength_t ucol_setStrength_fn;
+    ucol_getSortKey_t ucol_getSortKey_fn;
+    int icuVersion = -1; // -1: the fallback implementation.
 
     DynamicIcuLoader() : library_handle(nullptr),
                          ucol_open_fn(nullptr),
@@ -184,6 +187,8 @@ public:
         this->ucol_close_fn = &ucol_close;
         this->ucol_strcoll_fn = &ucol_strcoll;
         this->ucol_setStrength_fn = &ucol_setStrength;
+        this->ucol_getSortKey_fn = &ucol_getSortKey;
+        this->icuVersion = U_ICU_VERSION_MAJOR_NUM;
 #endif
     }
 
@@ -239,6 +244,12 @@ private:
             {
                 throw std::runtime_error(SS("Error loading ucol_setStrength: " << dlerror()));
             }
+            this->ucol_getSortKey_fn = reinterpret_cast<ucol_getSortKey_t>(dlsym(library_handle, VersionedName("ucol_getSortKey",version).c_str()));
+            if (!ucol_getSortKey_fn)
+            {
+                throw std::runtime_error(SS("Error loading ucol_getSortKey: " << dlerror()));
+            }
+            this->icuVersion = version;
         }
         catch (const std::exception &e)
         {
@@ -247,7 +258,38 @@ private:
             this->ucol_close_fn = fallback_ucol_close_func;
             this->ucol_strcoll_fn = fallback_ucol_strcoll_func;
             this->ucol_setStrength_fn = fallback_ucol_setStrength_func;
+            this->ucol_getSortKey_fn = fallback_ucol_getSortKey_func;
+            this->icuVersion = -1;
+        }
+    }
+
+    static int32_t fallback_ucol_getSortKey_func(const UCollator *, const UChar *source, int32_t sourceLength, uint8_t *result, int32_t resultLength)
+    {
+        // case-folded UTF-16BE, and a terminating 0, as ICU does.
+        if (sourceLength < 0)
+        {
+            sourceLength = 0;
+            while (source[sourceLength] != 0)
+            {
+                ++sourceLength;
+            }
+        }
+        int32_t length = sourceLength * 2 + 1;
+        if (result && resultLength >= length)
+        {
+            for (int32_t i = 0; i < sourceLength; ++i)
+            {
+                UChar c = source[i];
+                if (c >= 'A' && c <= 'Z')
+                {
+                    c += 'a' - 'A';
+                }
+                result[i * 2] = (uint8_t)(c >> 8);
+                result[i * 2 + 1] = (uint8_t)c;
+            }
+            result[length - 1] = 0;
         }
+        return length;
     }
 
     static void fallback_ucol_setStrength_func(UCollator *coll,
@@ -359,9 +401,13 @@ public:
 
     virtual int Compare(const std::string &left, const std::string &right);
     virtual int Compare(const std::u16string &left, const std::u16string &right);
+    virtual std::string GetSortKey(const std::string &text);
+    virtual std::string GetSortKey(const std::u16string &text);
+    virtual const std::string &GetSortKeyVersion() const { return sortKeyVersion; }
 
 private:
     UCollator *collator = nullptr;
+    std::string sortKeyVersion;
     std::shared_ptr<LocaleImpl> localeImpl;
 
     DynamicIcuLoader::ptr icuLoader;
@@ -389,6 +435,43 @@ CollatorImpl::CollatorImpl(std::shared_ptr<LocaleImpl> localeImpl, const char *l
         throw std::runtime_error(SS("Failed to create collator: " << status));
     }
     icuLoader->ucol_setStrength_fn(collator,UCollationStrength::UCOL_PRIMARY);
+    if (icuLoader->icuVersion == -1)
+    {
+        sortKeyVersion = "fallback";
+    }
+    else
+    {
+        sortKeyVersion = SS(localeStr << "/icu" << icuLoader->icuVersion);
+    }
+}
+
+std::string CollatorImpl::GetSortKey(const std::u16string &text)
+{
+    // ICU keys contain no 0 bytes other than the terminator, which is dropped.
+    std::string result;
+    result.resize(text.length() * 2 + 16);
+    while (true)
+    {
+        int32_t length = icuLoader->ucol_getSortKey_fn(
+            collator,
+            reinterpret_cast<const UChar *>(text.c_str()), (int32_t)text.length(),
+            reinterpret_cast<uint8_t *>(result.data()), (int32_t)result.size());
+        if (length <= 0)
+        {
+            return std::string();
+        }
+        if ((size_t)length <= result.size())
+        {
+            result.resize(length - 1);
+            return result;
+        }
+        result.resize(length);
+    }
+}
+
+std::string CollatorImpl::GetSortKey(const std::string &text)
+{
+    return GetSortKey(Utf8ToUtf16(text));
 }
 
 int CollatorImpl::Compare(const std::u16string &left, const std::u16string&right) 
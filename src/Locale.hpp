@@ -19,8 +19,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace pipedal {
     class Collator {
@@ -28,8 +31,40 @@ namespace pipedal {
         using ptr = std::shared_ptr<Collator>;
         virtual int Compare(const std::string &left, const std::string&right) = 0;
         virtual int Compare(const std::u16string &left, const std::u16string&right) = 0;
+
+        // A key that orders like Compare() when compared bytewise (std::string's operator<). Sorts should
+        // compute one key per item instead of calling Compare() O(n log n) times.
+        virtual std::string GetSortKey(const std::string &text) = 0;
+        virtual std::string GetSortKey(const std::u16string &text) = 0;
+        // Identifies the collation rules (locale and ICU version) that generate sort keys. Stored keys
+        // must be regenerated when it changes.
+        virtual const std::string &GetSortKeyVersion() const = 0;
+
+        // Sorts items by the collation order of getText(item), computing each item's sort key once.
+        template <typename T, typename GetText>
+        void Sort(std::vector<T> &items, GetText getText);
+
         virtual ~Collator();
     };
+
+    template <typename T, typename GetText>
+    void Collator::Sort(std::vector<T> &items, GetText getText)
+    {
+        std::vector<std::pair<std::string, size_t>> keys;
+        keys.reserve(items.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            keys.emplace_back(GetSortKey(getText(items[i])), i);
+        }
+        std::sort(keys.begin(), keys.end());
+        std::vector<T> sorted;
+        sorted.reserve(items.size());
+        for (const auto &key : keys)
+        {
+            sorted.push_back(std::move(items[key.second]));
+        }
+        items = std::move(sorted);
+    }
     class Locale {
     protected:
         Locale() { }
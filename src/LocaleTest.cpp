@@ -282,4 +282,35 @@ TEST_CASE( "Locale test", "[locale]" ) {
 
 
 
-}
\ No newline at end of file
+}
+static void SortKeyTest(const char *localeName)
+{
+    Locale::ptr locale = Locale::GetTestInstance(localeName);
+    Collator::ptr collator = locale->GetCollator();
+    std::vector<std::string> strings{"Äbcae", "Abcde", "Ä", "A", "a", "b", "B", "c", "ç", "e", "è", "Å", "Z", "", "zz", "Abc10", "Abc9"};
+    for (const auto &left : strings)
+    {
+        for (const auto &right : strings)
+        {
+            int compare = collator->Compare(left, right);
+            int keyCompare = collator->GetSortKey(left).compare(collator->GetSortKey(right));
+            REQUIRE((compare < 0) == (keyCompare < 0));
+            REQUIRE((compare == 0) == (keyCompare == 0));
+        }
+    }
+    REQUIRE(!collator->GetSortKeyVersion().empty());
+
+    std::vector<std::string> sorted = strings;
+    collator->Sort(sorted, [](const std::string &s) -> const std::string & { return s; });
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        REQUIRE(collator->Compare(sorted[i - 1], sorted[i]) <= 0);
+    }
+}
+
+TEST_CASE("Locale sort keys", "[locale_sort_keys][Build][Dev]")
+{
+    SortKeyTest("en_US");
+    SortKeyTest("de_DE");
+    SortKeyTest("da_DK");
+}
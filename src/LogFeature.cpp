@@ -18,8 +18,10 @@
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "LogFeature.hpp"
-#include <mutex>
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <time.h>
 #include "Lv2Log.hpp"
 
 
@@ -46,50 +48,93 @@ int LogFeature::vprintfFn(LV2_Log_Handle handle,
 	return logFeature->vprintf(type, fmt, ap);
 }
 
+static uint64_t MonotonicNs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
 int LogFeature::vprintf(LV2_URID type,const char*fmt, va_list va)
 {
-	std::lock_guard<std::mutex> guard(logMutex);
+	if (!this->logMessageListener)
+	{
+		return 0;
+	}
+	LogLevel level;
+	if (type == uris.ridError)
+	{
+		level = LogLevel::Error;
+	}
+	else if (type == uris.ridWarning)
+	{
+		level = LogLevel::Warning;
+	}
+	else if (type == uris.ridTrace)
+	{
+		level = LogLevel::Debug;
+	}
+	else
+	{
+		level = LogLevel::Info;
+	}
+	// errors are always sent, since they are displayed to the user.
+	if (level != LogLevel::Error && level > Lv2Log::log_level())
+	{
+		return 0;
+	}
 
-	int result = 0;
-	if (this->logMessageListener)
+	uint64_t now = MonotonicNs();
+	uint64_t windowStart = rateWindowStartNs.load(std::memory_order_relaxed);
+	if (now - windowStart >= 1000000000ull)
 	{
-		const char* prefix = "";
-		char buffer[1024];
-		strcpy(buffer,messagePrefix.c_str());
-		char *p = buffer+messagePrefix.length();
-
-
-		result = vsnprintf(p, sizeof(buffer)-messagePrefix.length(), fmt, va);
-		buffer[sizeof(buffer)-1] = '\0';
-		
-		// strip trailing \n
-		size_t len = strlen(buffer);
-		if (len != 0 && buffer[len-1] == '\n')
+		if (rateWindowStartNs.compare_exchange_strong(windowStart, now, std::memory_order_relaxed))
 		{
-			buffer[len-1] = '\0';
+			rateWindowCount.store(0, std::memory_order_relaxed);
 		}
+	}
+	if (rateWindowCount.fetch_add(1, std::memory_order_relaxed) >= MAX_MESSAGES_PER_SECOND)
+	{
+		suppressedCount.fetch_add(1, std::memory_order_relaxed);
+		return 0;
+	}
 
-		if (type == uris.ridError)
-		{
-			logMessageListener->OnLogError(buffer);
-		}
-		else if (type == uris.ridWarning)
-		{
-			logMessageListener->OnLogWarning(buffer);
-		}
-		else if (type == uris.ridNote)
-		{
-			logMessageListener->OnLogInfo(buffer);
-		}
-		else if (type == uris.ridTrace)
-		{
-			logMessageListener->OnLogDebug(buffer);
-		}
-		else {
-			logMessageListener->OnLogInfo(buffer);
-		}
+	char buffer[1024];
+	size_t prefixLength = std::min(messagePrefix.length(), sizeof(buffer) - 1);
+	memcpy(buffer, messagePrefix.c_str(), prefixLength);
+	buffer[prefixLength] = '\0';
+
+	int result = vsnprintf(buffer + prefixLength, sizeof(buffer) - prefixLength, fmt, va);
+	buffer[sizeof(buffer) - 1] = '\0';
+
+	// strip trailing \n
+	size_t len = strlen(buffer);
+	if (len != 0 && buffer[len - 1] == '\n')
+	{
+		buffer[--len] = '\0';
 	}
-    return result;
+	uint32_t suppressed = suppressedCount.exchange(0, std::memory_order_relaxed);
+	if (suppressed != 0)
+	{
+		snprintf(buffer + len, sizeof(buffer) - len, " (%u messages suppressed)", (unsigned)suppressed);
+	}
+
+	switch (level)
+	{
+	case LogLevel::Error:
+		logMessageListener->OnLogError(buffer);
+		break;
+	case LogLevel::Warning:
+		logMessageListener->OnLogWarning(buffer);
+		break;
+	case LogLevel::Debug:
+		logMessageListener->OnLogDebug(buffer);
+		break;
+	default:
+		logMessageListener->OnLogInfo(buffer);
+		break;
+	}
+	return result;
 }
 
 
@@ -135,13 +180,10 @@ void LogFeature::LogNote(const char*fmt,...)
 
 }
 void LogFeature::LogTrace(const char*fmt,...)
-{
 {
 	va_list va;
 	va_start(va, fmt);
 
-	vprintf(uris.ridNote,fmt,va);
-
-}
+	vprintf(uris.ridTrace,fmt,va);
 
 }
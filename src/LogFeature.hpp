@@ -30,7 +30,8 @@
 #include "MapFeature.hpp"
 #include <map>
 #include <string>
-#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 
 namespace pipedal {
@@ -50,7 +51,14 @@ namespace pipedal {
 		LV2_URID nextAtom = 0;
 		LV2_Feature feature;
 		LV2_Log_Log log;
-		std::mutex logMutex;
+
+		// Plugins may log from the audio thread, so vprintf neither locks nor allocates. Each instance
+		// is limited to MAX_MESSAGES_PER_SECOND; the count of suppressed messages is appended to the
+		// next message that gets through.
+		static constexpr uint32_t MAX_MESSAGES_PER_SECOND = 20;
+		std::atomic<uint64_t> rateWindowStartNs{0};
+		std::atomic<uint32_t> rateWindowCount{0};
+		std::atomic<uint32_t> suppressedCount{0};
 		struct Uri {
 			void Map(MapFeature* map)
 			{
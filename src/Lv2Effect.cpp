@@ -20,6 +20,7 @@
 #include "pch.h"
 #include "restrict.hpp"
 #include "Lv2Effect.hpp"
+#include "AudioMixKernels.hpp"
 #include "PiPedalException.hpp"
 #include <lv2/lv2plug.in/ns/ext/worker/worker.h>
 #include <lilv/lilv.h>
@@ -40,14 +41,17 @@
 #include "lv2/units/units.h"
 #include "lv2/atom/util.h"
 #include "AudioHost.hpp"
+#include "Lv2EventBufferWriter.hpp"
 #include <exception>
 #include "RingBufferReader.hpp"
 #include "Worker.hpp"
+#include "RealtimeLog.hpp"
 
 using namespace pipedal;
 namespace fs = std::filesystem;
 
 const float BYPASS_TIME_S = 0.1f;
+const float HARD_BYPASS_WARM_UP_TIME_S = 0.05f;
 
 static fs::path makeAbsolutePath(const std::filesystem::path &path, const std::filesystem::path &parentPath)
 {
@@ -61,17 +65,17 @@ static fs::path makeAbsolutePath(const std::filesystem::path &path, const std::f
 inline void Lv2Effect::CheckStagingBufferSentries()
 {
 #ifndef NDEBUG
-    for (size_t i = 0; i < inputStagingBuffers.size(); ++i)
+    for (size_t i = 0; i < inputStagingBufferPointers.size(); ++i)
     {
-        if (inputStagingBuffers[i].at(stagingBufferSize) != 99.9f)
+        if (inputStagingBufferPointers[i][stagingBufferSize] != 99.9f)
         {
             throw std::logic_error("Staging buffer sentry overwritten.");
         }
 
     }
-    for (size_t i = 0; i < outputStagingBuffers.size(); ++i)
+    for (size_t i = 0; i < outputStagingBufferPointers.size(); ++i)
     {
-        if (outputStagingBuffers[i].at(stagingBufferSize) != 99.9f)
+        if (outputStagingBufferPointers[i][stagingBufferSize] != 99.9f)
         {
             throw std::logic_error("Staging buffer sentry overwritten.");
         }
@@ -83,10 +87,18 @@ inline void Lv2Effect::CheckStagingBufferSentries()
 Lv2Effect::Lv2Effect(
     IHost *pHost_,
     const std::shared_ptr<Lv2PluginInfo> &info_,
-    PedalboardItem &pedalboardItem)
-    : pHost(pHost_), pInstance(nullptr), info(info_), urids(pHost), instanceId(pedalboardItem.instanceId())
+    PedalboardItem &pedalboardItem,
+    std::shared_ptr<RealtimeArena> realtimeArena_)
+    : pHost(pHost_), pInstance(nullptr), info(info_), urids(pHost), instanceId(pedalboardItem.instanceId()),
+      realtimeArena(realtimeArena_ ? realtimeArena_ : std::make_shared<RealtimeArena>(16 * 1024))
 {
     auto pWorld = pHost_->getWorld();
+    MemoryMeasurement memoryMeasurement;
+    memoryFootprint.instanceId_ = (uint64_t)pedalboardItem.instanceId();
+    memoryFootprint.uri_ = info_->uri();
+
+    // effects may be created concurrently. Released before the plugin's state is restored, which is usually the expensive part.
+    std::unique_lock<std::mutex> worldLock(pHost_->GetLilvWorldMutex());
 
     size_t stagedBufferSize = GetStagedBufferSize();
 
@@ -95,10 +107,12 @@ Lv2Effect::Lv2Effect(
     optionsFeature.Prepare(pHost->GetMapFeature(), 44100, stagedBufferSize, pHost->GetAtomBufferSize());
 
     this->bypassStartingSamples = (uint32_t)(pHost->GetSampleRate() * BYPASS_TIME_S);
+    this->warmUpSamples = (uint32_t)(pHost->GetSampleRate() * HARD_BYPASS_WARM_UP_TIME_S);
 
     this->bypass = pedalboardItem.isEnabled();
+    this->hardBypass = pedalboardItem.hardBypass();
 
-    this->workerThread = std::make_unique<HostWorkerThread>();
+    this->workerThread = pHost->GetHostWorkerThread();
     if (info_->WantsWorkerThread())
     {
         workerThread->StartThread();
@@ -187,6 +201,13 @@ Lv2Effect::Lv2Effect(
 
     this->features.push_back(this->fileBrowserFilesFeature.GetFeature());
 
+    // Only plugins that ask for the task group extension get one (and only then are the pool threads started).
+    if (info_->IsFeatureDeclared(LV2_TASKGROUP__taskGroup))
+    {
+        taskGroupFeature.Initialize();
+        this->features.push_back(taskGroupFeature.GetFeature());
+    }
+
     this->work_schedule_feature = nullptr;
     if (true) // info_->hasExtension(LV2_WORKER__interface))
     {
@@ -269,9 +290,12 @@ Lv2Effect::Lv2Effect(
     }
 
     ConnectControlPorts();
+    worldLock.unlock();
+    memoryFootprint.instantiateBytes_ = memoryMeasurement.GetBytes();
 
     if (!pedalboardItem.lilvPresetUri().empty())
     {
+        worldLock.lock(); // (rare) and presetNode is freed at the end of the block.
         AutoLilvNode presetNode = lilv_new_uri(pWorld, pedalboardItem.lilvPresetUri().c_str());
         lilv_world_load_resource(pWorld, presetNode);
         LilvState *pState = lilv_state_new_from_world(pWorld, pHost->GetMapFeature().GetMap(), presetNode);
@@ -299,15 +323,18 @@ Lv2Effect::Lv2Effect(
                 try
                 {
                     // REsTORE from LV2_STATE__state default state.
-                    AutoLilvNode pluginNode = lilv_new_uri(pWorld, info->uri().c_str());
-                    LilvState *pState = lilv_state_new_from_world(pWorld, pHost->GetMapFeature().GetMap(), pluginNode);
-                    if (pState)
                     {
-                        if (this->stateInterface)
+                        std::lock_guard<std::mutex> lock(pHost->GetLilvWorldMutex());
+                        AutoLilvNode pluginNode = lilv_new_uri(pWorld, info->uri().c_str());
+                        LilvState *pState = lilv_state_new_from_world(pWorld, pHost->GetMapFeature().GetMap(), pluginNode);
+                        if (pState)
                         {
-                            this->stateInterface->RestoreState(pState);
+                            if (this->stateInterface)
+                            {
+                                this->stateInterface->RestoreState(pState);
+                            }
+                            lilv_state_free(pState);
                         }
-                        lilv_state_free(pState);
                     }
                     pedalboardItem.lv2State(this->stateInterface->Save());
                     RestoreState(pedalboardItem); // do it with OUR map/unmap file handling.
@@ -319,6 +346,9 @@ Lv2Effect::Lv2Effect(
             }
         }
     }
+    uint64_t totalBytes = memoryMeasurement.GetBytes();
+    memoryFootprint.restoreBytes_ = totalBytes > memoryFootprint.instantiateBytes_ ? totalBytes - memoryFootprint.instantiateBytes_ : 0;
+    memoryFootprint.exclusive_ = memoryMeasurement.IsExclusive();
 }
 bool Lv2Effect::RestoreState(PedalboardItem &pedalboardItem)
 {
@@ -330,6 +360,7 @@ bool Lv2Effect::RestoreState(PedalboardItem &pedalboardItem)
             if (pedalboardItem.lv2State().isValid_)
             {
                 this->stateInterface->Restore(pedalboardItem.lv2State());
+                this->savedStateHash = pedalboardItem.lv2State().Hash();
                 return true;
             }
             return false;
@@ -403,11 +434,16 @@ void Lv2Effect::PreparePortIndices()
                 if (port->supports_midi())
                 {
                     this->inputMidiPortIndices.push_back(portIndex);
+                    this->inputMidiAtomBufferIndices.push_back(this->inputAtomPortIndices.size());
                 }
                 this->inputAtomPortIndices.push_back(portIndex);
             }
             else
             {
+                if (port->supports_midi())
+                {
+                    this->outputMidiAtomBufferIndices.push_back(this->outputAtomPortIndices.size());
+                }
                 this->outputAtomPortIndices.push_back(portIndex);
                 if (port->supports_midi())
                 {
@@ -417,7 +453,6 @@ void Lv2Effect::PreparePortIndices()
         }
         else if (port->is_control_port())
         {
-            controlIndex[port->symbol()] = portIndex;
             if (port->is_input())
             {
                 this->isInputControlPort.at(portIndex) = true;
@@ -463,16 +498,20 @@ void Lv2Effect::PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize)
         outputAudioBuffers.resize(std::max((size_t)numberOfInputs, outputAudioPortIndices.size()));
 
         // allocate a working buffer which we will mix with passed-through data.
-        outputMixBuffers.resize(outputAudioPortIndices.size());
-        for (size_t i = 0; i < outputMixBuffers.size(); ++i)
+        // (borrowed effects are prepared again by each pedalboard that uses them.)
+        if (outputMixBuffers.size() != outputAudioPortIndices.size())
         {
-            outputMixBuffers.at(i).resize(maxBufferSize);
+            outputMixBuffers.resize(outputAudioPortIndices.size());
+            for (size_t i = 0; i < outputMixBuffers.size(); ++i)
+            {
+                outputMixBuffers.at(i) = realtimeArena->Allocate<float>(maxBufferSize);
+            }
         }
         // connect the plugin to the mix buffer instead of output buffer.
         for (size_t i = 0; i < outputAudioPortIndices.size(); ++i)
         {
             int pluginIndex = this->outputAudioPortIndices.at(i);
-            lilv_instance_connect_port(this->pInstance, pluginIndex, outputMixBuffers.at(i).data());
+            lilv_instance_connect_port(this->pInstance, pluginIndex, outputMixBuffers.at(i));
         }
     }
 }
@@ -606,14 +645,71 @@ void Lv2Effect::SetAudioOutputBuffer(int index, float *buffer)
     }
 }
 
+void Lv2Effect::SetBufferOwner(const void *owner)
+{
+    while (bufferOwnerLock.test_and_set(std::memory_order_acquire))
+    {
+        // the realtime thread holds it for a few instructions at most.
+    }
+    this->bufferOwner = owner;
+    bufferOwnerLock.clear(std::memory_order_release);
+}
+
+bool Lv2Effect::RebindAudioInputBuffer(const void *owner, int index, float *buffer)
+{
+    if (bufferOwnerLock.test_and_set(std::memory_order_acquire))
+    {
+        return false;
+    }
+    bool result = owner == this->bufferOwner && inputAudioPortIndices.size() == inputAudioBuffers.size();
+    if (result)
+    {
+        this->inputAudioBuffers[index] = buffer;
+        if (stagingBufferSize == 0) // (staged inputs are copied from inputAudioBuffers.)
+        {
+            lilv_instance_connect_port(this->pInstance, this->inputAudioPortIndices[index], buffer);
+        }
+    }
+    bufferOwnerLock.clear(std::memory_order_release);
+    return result;
+}
+
+bool Lv2Effect::RebindAudioOutputBuffer(const void *owner, int index, float *buffer)
+{
+    if (bufferOwnerLock.test_and_set(std::memory_order_acquire))
+    {
+        return false;
+    }
+    bool result = owner == this->bufferOwner && this->inputAudioPortIndices.size() != 0;
+    if (result)
+    {
+        this->outputAudioBuffers[index] = buffer;
+        if (stagingBufferSize == 0 && (size_t)index < this->outputAudioPortIndices.size())
+        {
+            lilv_instance_connect_port(this->pInstance, this->outputAudioPortIndices[index], buffer);
+        }
+    }
+    bufferOwnerLock.clear(std::memory_order_release);
+    return result;
+}
+
 int Lv2Effect::GetControlIndex(const std::string &key) const
 {
-    auto i = controlIndex.find(key);
-    if (i == controlIndex.end())
+    return info->GetControlIndex(key);
+}
+
+bool Lv2Effect::IsRampableControl(int index) const
+{
+    for (const auto &port : info->ports())
     {
-        return -1;
+        if (port->index() == (uint32_t)index)
+        {
+            return port->is_control_port() && port->is_input() &&
+                   !port->toggled_property() && !port->integer_property() &&
+                   !port->enumeration_property() && !port->trigger_property();
+        }
     }
-    return i->second;
+    return false;
 }
 
 Lv2Effect::~Lv2Effect()
@@ -640,6 +736,7 @@ Lv2Effect::~Lv2Effect()
     }
     if (pInstance)
     {
+        std::lock_guard<std::mutex> lock(pHost->GetLilvWorldMutex());
         lilv_instance_free(pInstance);
         pInstance = nullptr;
     }
@@ -658,9 +755,23 @@ void Lv2Effect::Activate()
     {
         return;
     }
+    std::lock_guard stateLock(stateMutex);
     this->activated = true;
+    if (worker)
+    {
+        // the worker is closed by Deactivate().
+        worker->Reopen();
+    }
     this->AssignUnconnectedPorts();
-    lilv_instance_activate(pInstance);
+    {
+        MemoryMeasurement memoryMeasurement;
+        lilv_instance_activate(pInstance);
+        if (memoryFootprint.activateBytes_ == 0) // the first activation.
+        {
+            memoryFootprint.activateBytes_ = memoryMeasurement.GetBytes();
+            memoryFootprint.exclusive_ = memoryFootprint.exclusive_ && memoryMeasurement.IsExclusive();
+        }
+    }
     if (this->bypassControlIndex == -1)
     {
         this->BypassDezipperSet(this->bypass ? 1.0f : 0.0f);
@@ -791,7 +902,7 @@ void Lv2Effect::AssignUnconnectedPorts()
         {
             int pluginIndex = this->inputAudioPortIndices.at(i);
 
-            float *buffer = bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize());
+            float *buffer = realtimeArena->Allocate<float>(pHost->GetMaxAudioBufferSize());
             lilv_instance_connect_port(pInstance, pluginIndex, buffer);
         }
     }
@@ -802,7 +913,7 @@ void Lv2Effect::AssignUnconnectedPorts()
         {
             if (GetAudioOutputBuffer(i) == nullptr)
             {
-                float *buffer = bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize());
+                float *buffer = realtimeArena->Allocate<float>(pHost->GetMaxAudioBufferSize());
                 int pluginIndex = this->outputAudioPortIndices.at(i);
                 lilv_instance_connect_port(pInstance, pluginIndex, buffer);
             }
@@ -814,7 +925,7 @@ void Lv2Effect::AssignUnconnectedPorts()
         {
             int pluginIndex = this->inputAtomPortIndices.at(i);
 
-            uint8_t *buffer = bufferPool.AllocateBuffer<uint8_t>(pHost->GetAtomBufferSize());
+            uint8_t *buffer = realtimeArena->Allocate<uint8_t>(pHost->GetAtomBufferSize());
             if (stagedInputAtomBufferPointer && i == 0)
             {
                 lilv_instance_connect_port(pInstance, pluginIndex, stagedInputAtomBufferPointer);
@@ -834,7 +945,7 @@ void Lv2Effect::AssignUnconnectedPorts()
         {
             int pluginIndex = this->outputAtomPortIndices.at(i);
 
-            uint8_t *buffer = bufferPool.AllocateBuffer<uint8_t>(pHost->GetAtomBufferSize());
+            uint8_t *buffer = realtimeArena->Allocate<uint8_t>(pHost->GetAtomBufferSize());
             ResetOutputAtomBuffer((char *)buffer);
 
             if (stagedOutputAtomBufferPointer && i == 0)
@@ -857,6 +968,7 @@ void Lv2Effect::Deactivate()
     {
         return;
     }
+    std::lock_guard stateLock(stateMutex);
     activated = false;
     if (worker)
     {
@@ -865,14 +977,6 @@ void Lv2Effect::Deactivate()
     lilv_instance_deactivate(pInstance);
 }
 
-static inline void CopyBuffer(float *restrict input, float *restrict output, uint32_t frames)
-{
-    for (uint32_t i = 0; i < frames; ++i)
-    {
-        output[i] = input[i];
-    }
-}
-
 size_t Lv2Effect::stageToOutput(size_t outputIndex, size_t nFrames)
 {
     size_t thisTime = nFrames - outputIndex;
@@ -940,33 +1044,76 @@ size_t Lv2Effect::stageToInput(size_t inputSampleOffset, size_t samples)
 
     if (stagingInputIx == this->stagingBufferSize)
     {
-        // close off the atom input frame.
-        if (stagedInputAtomBufferPointer)
-        {
-            lv2_atom_forge_pop(&this->stagedInputForgeRt, &staged_input_frame);
-        }
-        if (stagedOutputAtomBufferPointer)
-        {
-            ResetOutputAtomBuffer((char *)stagedOutputAtomBufferPointer);
-        }
+        runStagedBlock();
+        this->stagingInputIx = 0;
+        this->stagingOutputIx = 0;
+    }
+    return inputSampleOffset;
+}
+
+void Lv2Effect::runStagedBlock()
+{
+    // close off the atom input frame.
+    if (stagedInputAtomBufferPointer)
+    {
+        lv2_atom_forge_pop(&this->stagedInputForgeRt, &staged_input_frame);
+    }
+    if (stagedOutputAtomBufferPointer)
+    {
+        ResetOutputAtomBuffer((char *)stagedOutputAtomBufferPointer);
+    }
 
-        lilv_instance_run(pInstance, this->stagingBufferSize);
+    lilv_instance_run(pInstance, this->stagingBufferSize);
 
-        if (worker)
-        {
+    if (worker)
+    {
 
-            worker->EmitResponses();
+        worker->EmitResponses();
+    }
+    if (stagedOutputAtomBufferPointer)
+    {
+        copyAtomBufferEventSequence((LV2_Atom_Sequence *)stagedOutputAtomBufferPointer, this->outputForgeRt);
+    }
+    this->resetStagedInputAtomBuffer();
+}
+
+void Lv2Effect::runStagedSlices(uint32_t samples)
+{
+    // Point the plugin's audio ports at successive slices of the host buffers. Equivalent to
+    // staging when nothing is buffered (same blocks, same latency), but without the copies.
+    for (uint32_t offset = 0; offset < samples; offset += this->stagingBufferSize)
+    {
+        for (size_t i = 0; i < this->inputAudioPortIndices.size(); ++i)
+        {
+            lilv_instance_connect_port(pInstance, inputAudioPortIndices[i], this->inputAudioBuffers[i] + offset);
         }
-        if (stagedOutputAtomBufferPointer)
+        for (size_t i = 0; i < this->inputSidechainPortIndices.size(); ++i)
         {
-            copyAtomBufferEventSequence((LV2_Atom_Sequence *)stagedOutputAtomBufferPointer, this->outputForgeRt);
+            lilv_instance_connect_port(pInstance, inputSidechainPortIndices[i], this->inputSidechainBuffers[i] + offset);
         }
+        for (size_t i = 0; i < this->outputAudioPortIndices.size(); ++i)
+        {
+            lilv_instance_connect_port(pInstance, outputAudioPortIndices[i], this->outputAudioBuffers[i] + offset);
+        }
+        runStagedBlock();
+    }
+    connectStagingAudioPorts();
+}
 
-        this->stagingInputIx = 0;
-        this->stagingOutputIx = 0;
-        this->resetStagedInputAtomBuffer();
+void Lv2Effect::connectStagingAudioPorts()
+{
+    for (size_t i = 0; i < this->inputAudioPortIndices.size(); ++i)
+    {
+        lilv_instance_connect_port(pInstance, inputAudioPortIndices[i], inputStagingBufferPointers[i]);
+    }
+    for (size_t i = 0; i < this->inputSidechainPortIndices.size(); ++i)
+    {
+        lilv_instance_connect_port(pInstance, inputSidechainPortIndices[i], sidechainStagingBufferPointers[i]);
+    }
+    for (size_t i = 0; i < this->outputAudioPortIndices.size(); ++i)
+    {
+        lilv_instance_connect_port(pInstance, outputAudioPortIndices[i], outputStagingBufferPointers[i]);
     }
-    return inputSampleOffset;
 }
 
 void Lv2Effect::resetStagedInputAtomBuffer()
@@ -981,6 +1128,7 @@ void Lv2Effect::resetStagedInputAtomBuffer()
 }
 void Lv2Effect::RunWithBufferStaging(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter)
 {
+    AppendMidiInput(true);
     // accumulte control input sequence until we can execute a run operation.
     if (this->inputAtomBuffers.size() != 0)
     {
@@ -989,6 +1137,15 @@ void Lv2Effect::RunWithBufferStaging(uint32_t samples, RealtimeRingBufferWriter
         LV2_Atom_Sequence *controlInput = (LV2_Atom_Sequence *)GetAtomInputBuffer(0);
         copyAtomBufferEventSequence(controlInput, this->stagedInputForgeRt);
     }
+    // Only suspend on a staging block boundary, so that no staged input (or messages) are held back.
+    // Output left in the staging buffer is discarded during warm-up.
+    if (this->stagingInputIx == 0 && this->hardBypass.load(std::memory_order_relaxed) && CanSuspendPlugin())
+    {
+        SuspendPlugin();
+        MixOutput(samples, realtimeRingBufferWriter);
+        return;
+    }
+    UpdateWarmUp(samples);
     // Prepare ACTUAL control output port.
     if (this->stagedOutputAtomBufferPointer)
     {
@@ -998,6 +1155,14 @@ void Lv2Effect::RunWithBufferStaging(uint32_t samples, RealtimeRingBufferWriter
         lv2_atom_forge_sequence_head(&this->outputForgeRt, &output_frame, urids.units__frame);
     }
 
+    if (this->stagingDirectSlices && samples % this->stagingBufferSize == 0 &&
+        this->stagingInputIx == 0 && this->stagingOutputIx == this->stagingBufferSize)
+    {
+        runStagedSlices(samples);
+        MixOutput(samples, realtimeRingBufferWriter);
+        return;
+    }
+
     uint32_t inputSampleOffset = 0;
     uint32_t outputSampleOffset = 0;
 
@@ -1059,28 +1224,22 @@ inline void Lv2Effect::MixOutput(uint32_t samples, RealtimeRingBufferWriter *rea
                 {
                     input = this->inputAudioBuffers.at(i);
                 }
-                float *restrict pluginOutput = this->outputMixBuffers.at(i).data();
+                float *restrict pluginOutput = this->outputMixBuffers.at(i);
                 float *restrict finalOutput = this->outputAudioBuffers.at(i);
 
-                for (uint32_t i = 0; i < samples; ++i)
-                {
-                    finalOutput[i] = input[i] * inputLevel + pluginOutput[i] * pluginLevel;
-                }
+                MixAudio(input, inputLevel, pluginOutput, pluginLevel, finalOutput, samples);
             }
         }
         else if (this->outputAudioPortIndices.size() == 1 && this->outputAudioBuffers.size() == 2)
         {
             // 1 plugin output into 2 outputs.
-            float *restrict pluginOutput = this->outputMixBuffers.at(0).data();
+            float *restrict pluginOutput = this->outputMixBuffers.at(0);
             for (size_t i = 0; i < this->outputMixBuffers.size(); ++i)
             {
                 float *restrict input = this->inputAudioBuffers.at(i);
                 float *restrict finalOutput = this->outputAudioBuffers.at(i);
 
-                for (uint32_t i = 0; i < samples; ++i)
-                {
-                    finalOutput[i] = input[i] * inputLevel + pluginOutput[i] * pluginLevel;
-                }
+                MixAudio(input, inputLevel, pluginOutput, pluginLevel, finalOutput, samples);
             }
         }
         else
@@ -1091,109 +1250,165 @@ inline void Lv2Effect::MixOutput(uint32_t samples, RealtimeRingBufferWriter *rea
     }
 
     // do soft bypass.
-    if (this->bypassSamplesRemaining == 0)
+    if (this->bypassSamplesRemaining == 0 && this->currentBypass != 0)
     {
-        if (this->currentBypass == 0)
-        {
-            // replace the contents of the output buffer(s) with the input buffer(s).
-            if (this->outputAudioBuffers.size() == 1)
-            {
-                CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-            }
-            else
-            {
-                if (this->inputAudioBuffers.size() == 1)
-                {
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(1), samples);
-                }
-                else
-                {
-                    CopyBuffer(this->inputAudioBuffers.at(0), this->outputAudioBuffers.at(0), samples);
-                    CopyBuffer(this->inputAudioBuffers.at(1), this->outputAudioBuffers.at(1), samples);
-                }
-            }
-        } // else leave the output alone.
+        // leave the output alone.
     }
     else
     {
-        double currentBypass = this->currentBypass;
-        double currentBypassDx = this->currentBypassDx;
-        int32_t bypassSamplesRemaining = (int)this->bypassSamplesRemaining;
-
-        if (this->outputAudioBuffers.size() == 1)
+        float *inputL;
+        float *inputR;
+        if (this->inputAudioBuffers.size() == 1)
         {
-            float *restrict input = this->inputAudioBuffers.at(0);
-            float *restrict output = this->outputAudioBuffers.at(0);
-            for (uint32_t i = 0; i < samples; ++i)
-            {
-                output[i] = currentBypass * output[i] + (1 - currentBypass) * input[i];
-
-                if (--bypassSamplesRemaining == 0)
-                {
-                    currentBypassDx = 0;
-                    currentBypass = this->targetBypass;
-                }
-                currentBypass += currentBypassDx;
-            }
+            inputL = inputR = inputAudioBuffers.at(0);
         }
         else
         {
-            float *restrict inputL;
-            float *restrict inputR;
-            if (this->inputAudioBuffers.size() == 1)
+            inputL = inputAudioBuffers.at(0);
+            inputR = inputAudioBuffers.at(1);
+        }
+        float *outputL = outputAudioBuffers.at(0);
+        float *outputR = outputAudioBuffers.size() == 1 ? nullptr : outputAudioBuffers.at(1);
+
+        // the ramp: output = currentBypass * output + (1 - currentBypass) * input.
+        uint32_t rampSamples = std::min(samples, this->bypassSamplesRemaining);
+        if (rampSamples != 0)
+        {
+            float currentBypass = (float)this->currentBypass;
+            float currentBypassDx = (float)this->currentBypassDx;
+            MixAudioRamp(outputL, currentBypass, currentBypassDx, inputL, 1 - currentBypass, -currentBypassDx, outputL, rampSamples);
+            if (outputR)
+            {
+                MixAudioRamp(outputR, currentBypass, currentBypassDx, inputR, 1 - currentBypass, -currentBypassDx, outputR, rampSamples);
+            }
+            this->bypassSamplesRemaining -= rampSamples;
+            if (this->bypassSamplesRemaining == 0)
             {
-                inputL = inputR = inputAudioBuffers.at(0);
+                this->currentBypass = this->targetBypass;
+                this->currentBypassDx = 0;
             }
             else
             {
-                inputL = inputAudioBuffers.at(0);
-                inputR = inputAudioBuffers.at(1);
+                this->currentBypass += rampSamples * this->currentBypassDx;
             }
-            float *restrict outputL = outputAudioBuffers.at(0);
-            float *restrict outputR = outputAudioBuffers.at(1);
-            for (uint32_t i = 0; i < samples; ++i)
+        }
+        // after the ramp: replace the contents of the output buffer(s) with the input buffer(s) if bypassed.
+        if (rampSamples < samples && this->currentBypass == 0)
+        {
+            CopyAudio(inputL + rampSamples, outputL + rampSamples, samples - rampSamples);
+            if (outputR)
             {
-                outputL[i] = currentBypass * outputL[i] + (1 - currentBypass) * inputL[i];
-                outputR[i] = currentBypass * outputR[i] + (1 - currentBypass) * inputR[i];
-                if (--bypassSamplesRemaining == 0)
-                {
-                    currentBypassDx = 0;
-                    currentBypass = this->targetBypass;
-                }
-                currentBypass += currentBypassDx;
+                CopyAudio(inputR + rampSamples, outputR + rampSamples, samples - rampSamples);
             }
         }
-        if (bypassSamplesRemaining <= 0)
+    }
+    // a null writer means we're running on a realtime helper thread. The audio thread relays messages after the helper completes.
+    if (realtimeRingBufferWriter)
+    {
+        RelayPatchSetMessages(this->instanceId, realtimeRingBufferWriter);
+    }
+}
+
+bool Lv2Effect::CanSuspendPlugin() const
+{
+    // Only when the host does the bypass (the plugin's own bypass control would need the plugin to run),
+    // the bypass ramp has completed, and there are no input messages that the plugin needs to see.
+    if (this->bypassControlIndex != -1 || this->bypass || this->bypassSamplesRemaining != 0 || this->currentBypass != 0)
+    {
+        return false;
+    }
+    return !HasPendingInputMessages();
+}
+
+void Lv2Effect::SuspendPlugin()
+{
+    // MixOutput copies the input to the output.
+    this->pluginSuspended = true;
+    for (char *outputAtomBuffer : this->outputAtomBuffers)
+    {
+        ResetInputAtomBuffer(outputAtomBuffer); // (an empty sequence)
+    }
+}
+
+void Lv2Effect::UpdateWarmUp(uint32_t samples)
+{
+    if (this->warmUpSamplesRemaining != 0)
+    {
+        if (samples >= this->warmUpSamplesRemaining)
         {
-            this->bypassSamplesRemaining = 0;
-            this->currentBypass = this->targetBypass;
-            this->currentBypassDx = 0;
+            this->warmUpSamplesRemaining = 0;
+            BypassDezipperTo(1.0f);
         }
         else
         {
-            this->currentBypass = currentBypass;
-            this->currentBypassDx = currentBypassDx;
-            this->bypassSamplesRemaining = bypassSamplesRemaining;
+            this->warmUpSamplesRemaining -= samples;
+        }
+    }
+}
+
+bool Lv2Effect::HasPendingInputMessages() const
+{
+    for (char *inputAtomBuffer : this->inputAtomBuffers)
+    {
+        if (((LV2_Atom_Sequence *)inputAtomBuffer)->atom.size > sizeof(LV2_Atom_Sequence_Body))
+        {
+            return true;
+        }
+    }
+    return worker && worker->HasPendingResponses();
+}
+
+void Lv2Effect::AppendMidiInput(bool stagedOnly)
+{
+    const LV2_Atom_Sequence *events = this->pendingMidiInput;
+    if (events == nullptr)
+    {
+        return;
+    }
+    this->pendingMidiInput = nullptr;
+    uint32_t bytes = events->atom.size - sizeof(LV2_Atom_Sequence_Body);
+    if (bytes == 0)
+    {
+        return;
+    }
+    for (size_t bufferIndex : this->inputMidiAtomBufferIndices)
+    {
+        if (bufferIndex == 0)
+        {
+            // The control input sequence is still open in inputForgeRt. MIDI goes after any patch messages (at frame 0).
+            lv2_atom_forge_raw(&this->inputForgeRt, LV2_ATOM_CONTENTS_CONST(LV2_Atom_Sequence, events), bytes);
+        }
+        else if (!stagedOnly)
+        {
+            // (only the first atom input port goes through the staging buffers.)
+            Lv2EventBufferWriter::Append((LV2_Atom_Sequence *)this->inputAtomBuffers[bufferIndex], pHost->GetAtomBufferSize(), events);
         }
     }
-    RelayPatchSetMessages(this->instanceId, realtimeRingBufferWriter);
 }
 
 void Lv2Effect::Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter)
 {
+    AppendMidiInput(false);
     // close off the atom input frame.
     if (this->inputAtomBuffers.size() != 0)
     {
         lv2_atom_forge_pop(&this->inputForgeRt, &input_frame);
     }
-    lilv_instance_run(pInstance, samples);
+    if (this->hardBypass.load(std::memory_order_relaxed) && CanSuspendPlugin())
+    {
+        SuspendPlugin();
+    }
+    else
+    {
+        lilv_instance_run(pInstance, samples);
+    }
 
     if (worker)
     {
         // relay worker response
         worker->EmitResponses();
     }
+    UpdateWarmUp(samples);
 
     MixOutput(samples, realtimeRingBufferWriter);
 }
@@ -1312,6 +1527,37 @@ void Lv2Effect::SetPatchProperty(LV2_URID uridUri, size_t size, LV2_Atom *value)
     this->requestStateChangedNotification = true;
 }
 
+std::vector<uint8_t> Lv2Effect::ForgePatchSet(LV2_URID uridUri, const LV2_Atom *value)
+{
+    std::vector<uint8_t> buffer(sizeof(LV2_Atom_Object) + 64 + value->size);
+
+    LV2_Atom_Forge forge;
+    lv2_atom_forge_init(&forge, this->pHost->GetLv2UridMap());
+    lv2_atom_forge_set_buffer(&forge, buffer.data(), buffer.size());
+
+    LV2_Atom_Forge_Frame objectFrame;
+    LV2_Atom_Forge_Ref set = lv2_atom_forge_object(&forge, &objectFrame, 0, urids.patch__Set);
+    lv2_atom_forge_key(&forge, urids.patch__property);
+    lv2_atom_forge_urid(&forge, uridUri);
+    lv2_atom_forge_key(&forge, urids.patch__value);
+    lv2_atom_forge_write(&forge, value, sizeof(LV2_Atom) + value->size);
+    lv2_atom_forge_pop(&forge, &objectFrame);
+    if (!set)
+    {
+        throw std::runtime_error("Patch property is too large.");
+    }
+    LV2_Atom *atom = (LV2_Atom *)buffer.data();
+    buffer.resize(sizeof(LV2_Atom) + atom->size);
+    return buffer;
+}
+
+void Lv2Effect::WriteInputAtom(const LV2_Atom *atom)
+{
+    lv2_atom_forge_frame_time(&inputForgeRt, 0);
+    lv2_atom_forge_write(&inputForgeRt, atom, sizeof(LV2_Atom) + atom->size);
+    this->requestStateChangedNotification = true;
+}
+
 void Lv2Effect::RelayPatchSetMessages(uint64_t instanceId, RealtimeRingBufferWriter *realtimeRingBufferWriter)
 {
     LV2_Atom_Sequence *controlOutput = (LV2_Atom_Sequence *)GetAtomOutputBuffer();
@@ -1336,7 +1582,12 @@ void Lv2Effect::RelayPatchSetMessages(uint64_t instanceId, RealtimeRingBufferWri
             else if (obj->body.otype == urids.patch__Set) // patch_Set is handled elsewhere.
             {
                 maybeStateChanged = true;
-                realtimeRingBufferWriter->AtomOutput(instanceId, obj->atom.size + sizeof(obj->atom), (uint8_t *)obj);
+                // only relay properties that a client is listening to, and only the latest value of each in this cycle.
+                LV2_URID property = GetPatchSetProperty(obj);
+                if (property != 0 && realtimeRingBufferWriter->WantsAtomOutput(instanceId, property) && !HasLaterPatchSet(controlOutput, ev, property))
+                {
+                    realtimeRingBufferWriter->AtomOutput(instanceId, obj->atom.size + sizeof(obj->atom), (uint8_t *)obj);
+                }
             }
         }
     }
@@ -1351,6 +1602,87 @@ void Lv2Effect::RelayPatchSetMessages(uint64_t instanceId, RealtimeRingBufferWri
     }
 }
 
+LV2_URID Lv2Effect::GetPatchSetProperty(const LV2_Atom_Object *patchSet)
+{
+    const LV2_Atom *property = nullptr;
+    lv2_atom_object_get(patchSet, urids.patch__property, &property, 0);
+    if (property == nullptr || property->type != urids.atom__URID)
+    {
+        return 0;
+    }
+    return ((const LV2_Atom_URID *)property)->body;
+}
+
+bool Lv2Effect::HasLaterPatchSet(const LV2_Atom_Sequence *sequence, const LV2_Atom_Event *event, LV2_URID property)
+{
+    for (const LV2_Atom_Event *ev = lv2_atom_sequence_next(event);
+         !lv2_atom_sequence_is_end(&sequence->body, sequence->atom.size, ev);
+         ev = lv2_atom_sequence_next(ev))
+    {
+        if (lv2_atom_forge_is_object_type(&this->outputForgeRt, ev->body.type))
+        {
+            const LV2_Atom_Object *obj = (const LV2_Atom_Object *)&ev->body;
+            if (obj->body.otype == urids.patch__Set && GetPatchSetProperty(obj) == property)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void Lv2Effect::WriteMidiOutput(void *handle, MidiOutputFn *pfnMidiOutput)
+{
+    for (size_t bufferIndex : outputMidiAtomBufferIndices)
+    {
+        LV2_Atom_Sequence *midiOutput = (LV2_Atom_Sequence *)this->outputAtomBuffers[bufferIndex];
+        if (midiOutput == nullptr)
+        {
+            continue;
+        }
+        LV2_ATOM_SEQUENCE_FOREACH(midiOutput, ev)
+        {
+            if (ev->body.type == urids.midi__Event && ev->body.size != 0)
+            {
+                pfnMidiOutput(handle, ev->body.size, (const uint8_t *)LV2_ATOM_BODY_CONST(&ev->body));
+            }
+        }
+    }
+}
+
+bool Lv2Effect::HasPatchSetOutput()
+{
+    LV2_Atom_Sequence *controlOutput = (LV2_Atom_Sequence *)GetAtomOutputBuffer();
+    if (controlOutput == nullptr)
+    {
+        return false;
+    }
+    LV2_ATOM_SEQUENCE_FOREACH(controlOutput, ev)
+    {
+        if (lv2_atom_forge_is_object_type(&this->outputForgeRt, ev->body.type))
+        {
+            const LV2_Atom_Object *obj = (const LV2_Atom_Object *)&ev->body;
+            if (obj->body.otype == urids.patch__Set)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool Lv2Effect::HasPendingPathPropertyWrites()
+{
+    for (auto &writer : this->pathPropertyWriters)
+    {
+        if (writer.GetCurrentWriteBuffer() != nullptr)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Lv2Effect::GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter)
 {
     if (pathPropertyWriters.size() != 0)
@@ -1388,10 +1720,11 @@ void Lv2Effect::GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter)
                         {
                             if (key == pathPropertyWriter.patchPropertyUrid)
                             {
-                                auto buffer = pathPropertyWriter.AquireWriteBuffer();
-                                size_t atom_size = value->size + sizeof(LV2_Atom);
-                                buffer->memory.resize(atom_size);
-                                memcpy(buffer->memory.data(), value, atom_size);
+                                if (value->size + sizeof(LV2_Atom) <= PatchPropertyWriter::MAX_VALUE_SIZE)
+                                {
+                                    auto buffer = pathPropertyWriter.AquireWriteBuffer();
+                                    buffer->SetValue(value);
+                                }
                                 break;
                             }
                         }
@@ -1441,7 +1774,11 @@ void Lv2Effect::GatherPatchProperties(RealtimePatchPropertyRequest *pRequest)
                         if (key == pRequest->uridUri)
                         {
                             int atom_size = value->size + sizeof(LV2_Atom);
-                            pRequest->SetSize(atom_size);
+                            if (!pRequest->SetSize(atom_size))
+                            {
+                                pRequest->errorMessage = "Property value is too large.";
+                                break;
+                            }
                             memcpy(pRequest->GetBuffer(), value, atom_size);
                             break;
                         }
@@ -1464,7 +1801,8 @@ void Lv2Effect::SetLv2State(Lv2PluginState &state)
     }
     try
     {
-
+        std::lock_guard stateLock(stateMutex);
+        this->savedStateHash.reset();
         this->stateInterface->Restore(state);
     }
     catch (const std::exception &e)
@@ -1472,6 +1810,35 @@ void Lv2Effect::SetLv2State(Lv2PluginState &state)
         Lv2Log::error("Failed to restore LV2 state.");
     }
 }
+bool Lv2Effect::GetLv2StateIfChanged(Lv2PluginState *state)
+{
+    uint64_t version;
+    return CaptureLv2StateIfChanged(state, &version);
+}
+
+bool Lv2Effect::CaptureLv2StateIfChanged(Lv2PluginState *state, uint64_t *version)
+{
+    if (!this->stateInterface)
+        return false;
+    std::lock_guard stateLock(stateMutex);
+    *version = stateVersion;
+    if (savedStateHash)
+    {
+        // Hashing doesn't copy the state, which can be several megabytes.
+        uint64_t hash;
+        if (this->stateInterface->SaveHash(&hash) && hash == savedStateHash.value())
+        {
+            return false;
+        }
+    }
+    uint64_t hash = 0;
+    *state = this->stateInterface->Save(&hash);
+    state->isValid_ = true;
+    savedStateHash = hash;
+    *version = ++stateVersion;
+    return true;
+}
+
 bool Lv2Effect::GetLv2State(Lv2PluginState *state)
 {
     if (!this->stateInterface)
@@ -1484,6 +1851,7 @@ bool Lv2Effect::GetLv2State(Lv2PluginState *state)
             return false;
         }
 
+        std::lock_guard stateLock(stateMutex);
         *state = this->stateInterface->Save();
         state->isValid_ = true;
         return true;
@@ -1503,17 +1871,18 @@ void Lv2Effect::OnLogError(const char *message)
     this->hasErrorMessage = true;
 }
 
+// Plugins may log from the audio thread. Lv2Log sinks block, so messages go through the realtime log.
 void Lv2Effect::OnLogWarning(const char *message)
 {
-    Lv2Log::warning(message);
+    RealtimeLog::Global().Post(LogLevel::Warning, message);
 }
 void Lv2Effect::OnLogInfo(const char *message)
 {
-    Lv2Log::info(message);
+    RealtimeLog::Global().Post(LogLevel::Info, message);
 }
 void Lv2Effect::OnLogDebug(const char *message)
 {
-    Lv2Log::debug(message);
+    RealtimeLog::Global().Post(LogLevel::Debug, message);
 }
 
 bool Lv2Effect::GetRequestStateChangedNotification() const { return requestStateChangedNotification; }
@@ -1554,15 +1923,20 @@ void Lv2Effect::EnableBufferStaging(size_t bufferSize )
     stagingBufferSize = bufferSize;
     stagingOutputIx = bufferSize;
     stagingInputIx = 0;
-    inputStagingBuffers.resize(nInputs);
-    outputStagingBuffers.resize(nOutputs);
+    size_t periodSize = pHost->GetMaxAudioBufferSize();
+    stagingDirectSlices =
+        bufferSize != 0 && bufferSize <= periodSize && periodSize % bufferSize == 0 &&
+        inputAudioPortIndices.size() != 0 &&
+        inputAudioPortIndices.size() == nInputs &&
+        inputSidechainPortIndices.size() == nSidechainInputs &&
+        outputAudioPortIndices.size() == nOutputs;
     inputStagingBufferPointers.resize(nInputs);
+    sidechainStagingBufferPointers.resize(nSidechainInputs);
     outputStagingBufferPointers.resize(nOutputs);
 
     if (inputAtomBuffers.size() != 0)
     {
-        stagedInputAtomBuffer.resize(pHost->GetAtomBufferSize());
-        stagedInputAtomBufferPointer = stagedInputAtomBuffer.data();
+        stagedInputAtomBufferPointer = realtimeArena->Allocate<uint8_t>(pHost->GetAtomBufferSize());
         resetStagedInputAtomBuffer();
     }
     else
@@ -1572,26 +1946,22 @@ void Lv2Effect::EnableBufferStaging(size_t bufferSize )
     stagedOutputAtomBufferPointer = nullptr;
     if (outputAtomBuffers.size() != 0)
     {
-        stagedOutputAtomBuffer.resize(pHost->GetAtomBufferSize());
-        stagedOutputAtomBufferPointer = stagedOutputAtomBuffer.data();
+        stagedOutputAtomBufferPointer = realtimeArena->Allocate<uint8_t>(pHost->GetAtomBufferSize());
     }
     for (size_t i = 0; i < nInputs; ++i)
     {
-        inputStagingBuffers.at(i).resize(bufferSize + 1);
-        inputStagingBuffers[i][bufferSize] = 99.9f; // guard entry
-        inputStagingBufferPointers.at(i) = inputStagingBuffers.at(i).data();
+        inputStagingBufferPointers.at(i) = realtimeArena->Allocate<float>(bufferSize + 1);
+        inputStagingBufferPointers[i][bufferSize] = 99.9f; // guard entry
     }
     for (size_t i = 0; i < nSidechainInputs; ++i)
     {
-        sidechainStagingBuffers.at(i).resize(bufferSize + 1);
-        sidechainStagingBuffers[i][bufferSize] = 99.9f; // guard entry
-        sidechainStagingBufferPointers.at(i) = sidechainStagingBuffers.at(i).data();
+        sidechainStagingBufferPointers.at(i) = realtimeArena->Allocate<float>(bufferSize + 1);
+        sidechainStagingBufferPointers[i][bufferSize] = 99.9f; // guard entry
     }
     for (size_t i = 0; i < nOutputs; ++i)
     {
-        outputStagingBuffers.at(i).resize(bufferSize + 1);
-        outputStagingBuffers[i][bufferSize] = 99.9f; // guard entry
-        outputStagingBufferPointers.at(i) = outputStagingBuffers.at(i).data();
+        outputStagingBufferPointers.at(i) = realtimeArena->Allocate<float>(bufferSize + 1);
+        outputStagingBufferPointers[i][bufferSize] = 99.9f; // guard entry
     }
 }
 
@@ -1632,6 +2002,64 @@ bool Lv2Effect::RequiresBufferStaging() const
     return GetStagedBufferSize() != pHost->GetMaxAudioBufferSize();
 }
 
+bool Lv2Effect::IsConnectionOptional(int portIndex) const
+{
+    for (const auto &port : info->ports())
+    {
+        if (port->index() == portIndex)
+        {
+            return port->connection_optional();
+        }
+    }
+    return false;
+}
+
+bool Lv2Effect::CanRunMono() const
+{
+    return inputAudioPortIndices.size() == 2 && outputAudioPortIndices.size() == 2 &&
+           IsConnectionOptional(inputAudioPortIndices[1]) && IsConnectionOptional(outputAudioPortIndices[1]);
+}
+
+void Lv2Effect::SetMonoMode()
+{
+    if (monoMode || !CanRunMono())
+    {
+        return;
+    }
+    monoMode = true;
+    lilv_instance_connect_port(pInstance, inputAudioPortIndices[1], nullptr);
+    lilv_instance_connect_port(pInstance, outputAudioPortIndices[1], nullptr);
+    inputAudioPortIndices.resize(1);
+    outputAudioPortIndices.resize(1);
+    inputAudioBuffers.resize(1);
+    outputAudioBuffers.resize(1);
+    if (stagingBufferSize != 0)
+    {
+        inputStagingBufferPointers.resize(1);
+        outputStagingBufferPointers.resize(1);
+    }
+}
+
+bool Lv2Effect::HasBlockLengthRequirements() const
+{
+    return info->minBlockLength() != -1 || info->maxBlockLength() != -1 || info->powerOf2BlockLength();
+}
+
+bool Lv2Effect::CanRunInPlace() const
+{
+    // The host-side bypass and zero-input mixes read the input after the plugin has run, so only
+    // plugins that do their own bypass, and have matching audio inputs and outputs, qualify.
+    if (this->bypassControlIndex == -1 || RequiresBufferStaging())
+    {
+        return false;
+    }
+    if (inputAudioPortIndices.size() == 0 || inputAudioPortIndices.size() != outputAudioPortIndices.size() || inputAudioBuffers.size() != outputAudioBuffers.size())
+    {
+        return false;
+    }
+    return !info->IsInPlaceBroken();
+}
+
 float *Lv2Effect::GetAudioInputBuffer(int index) const
 {
     if (index < 0 || index >= this->inputAudioBuffers.size())
@@ -23,14 +23,19 @@
 #include "PluginHost.hpp"
 #include "Pedalboard.hpp"
 #include <lilv/lilv.h>
-#include "BufferPool.hpp"
+#include "RealtimeArena.hpp"
 #include "FileBrowserFilesFeature.hpp"
+#include "TaskGroupFeature.hpp"
 #include "PatchPropertyWriter.hpp"
 #include <unordered_map>
+#include <optional>
+#include <atomic>
+#include <mutex>
 #include "MapPathFeature.hpp"
 #include "OptionsFeature.hpp"
 
 #include "IEffect.hpp"
+#include "MemoryFootprint.hpp"
 #include "Worker.hpp"
 #include "lv2/patch/patch.h"
 #include "lv2/log/log.h"
@@ -62,10 +67,16 @@ namespace pipedal
         std::shared_ptr<HostWorkerThread> workerThread;
         std::unique_ptr<Worker> worker;
 
-        std::unordered_map<std::string,int> controlIndex;
 
         FileBrowserFilesFeature fileBrowserFilesFeature;
+        TaskGroupFeature taskGroupFeature;
         std::unique_ptr<StateInterface> stateInterface;
+        // Hash of the state last restored, or returned by GetLv2StateIfChanged.
+        std::optional<uint64_t> savedStateHash;
+        // Serializes state interface calls and activation, which state capture on a background thread
+        // would otherwise race (LV2 state save may not run concurrently with instantiation-class functions).
+        std::mutex stateMutex;
+        std::atomic<uint64_t> stateVersion = 0;
         bool RestoreState(PedalboardItem&pedalboardItem);
         LogFeature logFeature;
         std::map<std::string,AtomBuffer> patchPropertyPrototypes;
@@ -88,6 +99,10 @@ namespace pipedal
 
         std::vector<int> inputMidiPortIndices;
         std::vector<int> outputMidiPortIndices;
+        std::vector<size_t> outputMidiAtomBufferIndices; // indices into outputAtomBuffers.
+        std::vector<size_t> inputMidiAtomBufferIndices; // indices into inputAtomBuffers.
+        const LV2_Atom_Sequence *pendingMidiInput = nullptr;
+        void AppendMidiInput(bool stagedOnly);
 
         std::vector<int> midiInputIndices;
 
@@ -107,8 +122,6 @@ namespace pipedal
         std::vector<bool> isInputTriggerControlPort;;
         int bypassControlIndex = -1;
 
-        virtual std::string GetUri() const { return info->uri(); }
-
         std::vector<const Lv2PortInfo *> realtimePortInfo;
 
         void PreparePortIndices();
@@ -184,7 +197,7 @@ namespace pipedal
         Urids urids;
 
         uint64_t instanceId;
-        BufferPool bufferPool;
+        std::shared_ptr<RealtimeArena> realtimeArena; // shared with the pedalboard that created the effect.
 
         static LV2_Worker_Status worker_schedule_fn(LV2_Worker_Schedule_Handle handle,
                                                     uint32_t size,
@@ -204,25 +217,65 @@ namespace pipedal
         double currentBypassDx = 0;
         uint32_t bypassSamplesRemaining = 0;
 
+        // Hard bypass: once the bypass ramp has completed, the plugin isn't run at all. When it's
+        // re-enabled, it runs for warmUpSamples (with its output discarded) before it is faded in.
+        // hardBypass is written by the control thread when a running effect is reused by a new pedalboard.
+        std::atomic<bool> hardBypass = false;
+        bool pluginSuspended = false;
+        uint32_t warmUpSamples = 0;
+        uint32_t warmUpSamplesRemaining = 0;
+        bool CanSuspendPlugin() const;
+        void SuspendPlugin();
+        void UpdateWarmUp(uint32_t samples);
+
         bool requestStateChangedNotification = false;
 
         float zeroInputMix = 0.5f;
         int actualAudioInputs = 0;
         int actualAudioOutputs = 0;
-        std::vector<std::vector<float>> outputMixBuffers;
+        std::vector<float *> outputMixBuffers;
         void BypassDezipperTo(float value);
         void BypassDezipperSet(float value);
 
         bool borrowedEffect = false;
         bool activated = false;
+        PluginMemoryFootprint memoryFootprint;
+
+        // The pedalboard allowed to rebind audio ports on the realtime thread. Claimed by each pedalboard that
+        // prepares the effect (under bufferOwnerLock), so that a pedalboard that is being replaced stops
+        // rebinding a borrowed effect before the new pedalboard assigns its buffers.
+        std::atomic_flag bufferOwnerLock = ATOMIC_FLAG_INIT;
+        const void *bufferOwner = nullptr;
         void EnableBufferStaging(size_t bufferSize);
         void CheckStagingBufferSentries();
 
     public:
         bool RequiresBufferStaging() const;
+        // True if the plugin declares minimum, maximum, or power-of-two block lengths.
+        bool HasBlockLengthRequirements() const;
+        // True if the plugin is stereo, but declares its second audio input and output connectionOptional,
+        // so that it can run with only its first channel connected.
+        bool CanRunMono() const;
+        // Disconnect the optional second channel. Must be called before the effect's audio buffers are set.
+        void SetMonoMode();
+        bool IsMonoMode() const { return monoMode; }
+        // True if the plugin's outputs can be connected to its input buffers.
+        bool CanRunInPlace() const;
         bool IsBorrowedEffect() const { return borrowedEffect; }
         void SetBorrowedEffect(bool value) { borrowedEffect = value; }
+        bool GetHardBypass() const { return hardBypass.load(std::memory_order_relaxed); }
+        void SetHardBypass(bool value) { hardBypass.store(value, std::memory_order_relaxed); }
         void UpdateAudioPorts();
+        // Non-RT thread. Must be called before the effect's audio buffers are set.
+        void SetBufferOwner(const void *owner);
+        // RT thread. Connect an audio input or output to another buffer for the following Run() calls (the
+        // pedalboard binds audio driver buffers this way). False if owner no longer owns the effect.
+        bool RebindAudioInputBuffer(const void *owner, int index, float *buffer);
+        bool RebindAudioOutputBuffer(const void *owner, int index, float *buffer);
+        std::string GetUri() const { return info->uri(); }
+        // Non RT-thread. True for continuous input controls, which can be ramped to a new value without
+        // passing through meaningless intermediate values (unlike switches, enumerations and integers).
+        bool IsRampableControl(int index) const;
         
         // non RT-thread use only.
         std::string GetPathPatchProperty(const std::string&propertyUri);
@@ -231,10 +284,17 @@ namespace pipedal
 
         virtual bool IsLv2Effect() const { return true; }
         virtual bool GetLv2State(Lv2PluginState*state) override;
+        virtual bool GetLv2StateIfChanged(Lv2PluginState*state) override;
+        virtual bool CaptureLv2StateIfChanged(Lv2PluginState*state, uint64_t *version) override;
+        virtual uint64_t GetLv2StateVersion() const override { return stateVersion; }
         virtual void SetLv2State(Lv2PluginState&state) override;
 
         virtual void RequestPatchProperty(LV2_URID uridUri) ;
         virtual void SetPatchProperty(LV2_URID uridUri,size_t size, LV2_Atom*value) override;
+        // non RT-thread use only. Forge a complete patch:Set message, for later use with WriteInputAtom.
+        std::vector<uint8_t> ForgePatchSet(LV2_URID uridUri, const LV2_Atom *value);
+        // Append a pre-forged atom to the control input.
+        void WriteInputAtom(const LV2_Atom *atom);
         virtual void RequestAllPathPatchProperties();
 
         virtual bool GetRequestStateChangedNotification() const override;
@@ -242,8 +302,27 @@ namespace pipedal
 
         virtual void GatherPatchProperties(RealtimePatchPropertyRequest*pRequest);
         void GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter);        
+        bool HasPathProperties() const { return pathPropertyWriters.size() != 0; }
+        // Realtime thread. True if the last run() produced a patch:Set message.
+        bool HasPatchSetOutput();
+        // Realtime thread. True if a path property update is waiting for an in-flight update to be delivered.
+        bool HasPendingPathPropertyWrites();
+
+        typedef void(MidiOutputFn)(void *handle, size_t size, const uint8_t *message);
+        // Realtime thread. Relays MIDI events from the plugin's MIDI output ports after run().
+        void WriteMidiOutput(void *handle, MidiOutputFn *pfnMidiOutput);
+        bool HasMidiOutput() const { return outputMidiAtomBufferIndices.size() != 0; }
+        // Realtime thread. MIDI events for the plugin's MIDI input ports in the next run(). The sequence is 
+        // built once per period and shared by all plugins with MIDI input, so it must stay valid until then.
+        void SetMidiInput(const LV2_Atom_Sequence *events) { pendingMidiInput = events; }
+        bool HasMidiInput() const { return inputMidiAtomBufferIndices.size() != 0; }
         virtual bool IsVst3() const { return false; }
         virtual void RelayPatchSetMessages(uint64_t instanceId,RealtimeRingBufferWriter *realtimeRingBufferWriter) ;
+    private:
+        LV2_URID GetPatchSetProperty(const LV2_Atom_Object *patchSet);
+        // True if a patch:Set for the same property follows the event in the sequence.
+        bool HasLaterPatchSet(const LV2_Atom_Sequence *sequence, const LV2_Atom_Event *event, LV2_URID property);
+    public:
 
         virtual uint8_t*GetAtomInputBuffer() {
             if (this->inputAtomBuffers.size() == 0) return nullptr;
@@ -264,20 +343,24 @@ namespace pipedal
         size_t stagingBufferSize = 0;
         size_t stagingInputIx = 0;
         size_t stagingOutputIx = 0;
-        std::vector<std::vector<float>> inputStagingBuffers;
-        std::vector<std::vector<float>> sidechainStagingBuffers;
-        std::vector<std::vector<float>> outputStagingBuffers;
         std::vector<float*> inputStagingBufferPointers;
         std::vector<float*> sidechainStagingBufferPointers;
         std::vector<float*> outputStagingBufferPointers;
 
-        std::vector<uint8_t> stagedInputAtomBuffer;
         void *stagedInputAtomBufferPointer = nullptr;
-        std::vector<uint8_t> stagedOutputAtomBuffer;
         void *stagedOutputAtomBufferPointer = nullptr;
 
+        // True if the staged block size divides the period, so that staged runs can be made directly
+        // on slices of the host's buffers, without copying audio through the staging buffers.
+        bool stagingDirectSlices = false;
+        bool monoMode = false;
+        bool IsConnectionOptional(int portIndex) const;
+
         size_t stageToOutput(size_t outputIndex, size_t nFrames);
         size_t stageToInput(size_t inputIndex, size_t nFrames);
+        void runStagedBlock();
+        void runStagedSlices(uint32_t samples);
+        void connectStagingAudioPorts();
 
 
         LV2_Atom_Forge stagedInputForgeRt;
@@ -288,20 +371,29 @@ namespace pipedal
         void resetStagedInputAtomBuffer();
 
     public:
+        // If realtimeArena is null, the effect allocates its own.
         Lv2Effect(
             IHost *pHost,
             const std::shared_ptr<Lv2PluginInfo> &info,
-            PedalboardItem &pedalboardItem);
+            PedalboardItem &pedalboardItem,
+            std::shared_ptr<RealtimeArena> realtimeArena = nullptr);
         ~Lv2Effect();
 
         bool HasErrorMessage() const { return this->hasErrorMessage; }
         const char*TakeErrorMessage() { this->hasErrorMessage = false; return this->errorMessage; }
+        virtual PluginMemoryFootprint *GetMemoryFootprint() override { return &memoryFootprint; }
 
         virtual void PrepareNoInputEffect(int numberOfInputs,size_t maxBufferSize) override;
 
 
         virtual void ResetAtomBuffers();
+        virtual bool HasPendingInputMessages() const override;
         virtual uint64_t GetInstanceId() const { return instanceId; }
+
+        // True if the plugin declares the taskGroup extension.
+        bool UsesTaskGroup() const { return taskGroupFeature.IsInitialized(); }
+        // Host thread.
+        TaskGroupTiming GetTaskGroupTiming() const { return taskGroupFeature.GetTiming((int64_t)instanceId); }
         virtual int GetNumberOfInputAudioPorts() const override { return inputAudioPortIndices.size(); }
         virtual int GetNumberOfOutputAudioPorts() const override { return outputAudioPortIndices.size(); }
 
@@ -376,7 +468,15 @@ namespace pipedal
             {
                 this->bypass = bypass;
                 if (bypassControlIndex == -1) {
-                    BypassDezipperTo(bypass? 1.0f: 0.0f);
+                    if (bypass && pluginSuspended)
+                    {
+                        // let stale state flush out of the plugin before it's heard.
+                        pluginSuspended = false;
+                        warmUpSamplesRemaining = warmUpSamples;
+                    } else {
+                        warmUpSamplesRemaining = 0;
+                        BypassDezipperTo(bypass? 1.0f: 0.0f);
+                    }
                 } else {
                     controlValues[bypassControlIndex] = bypass? 1.0f: 0.0f;
                 }
@@ -131,6 +131,43 @@ namespace pipedal
             return iterator.offset < size();
         }
 
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        // The events written so far.
+        const LV2_Atom_Sequence *sequence() const
+        {
+            return evbuf;
+        }
+
+        // Append all of the events in `events` after the events already in `sequence`, with a single bounds
+        // check and copy. `capacity` is the size of the buffer that holds `sequence`. The appended events
+        // must not be earlier than the last event already in the sequence.
+        static bool Append(LV2_Atom_Sequence *sequence, size_t capacity, const LV2_Atom_Sequence *events)
+        {
+            size_t bytes = events->atom.size - sizeof(LV2_Atom_Sequence_Body); // (each event is already padded.)
+            size_t used = (sequence->atom.size + 7) & (~7);
+            if (capacity < sizeof(LV2_Atom) + used + bytes)
+            {
+                return false;
+            }
+            memcpy((uint8_t *)LV2_ATOM_BODY(&sequence->atom) + used, LV2_ATOM_CONTENTS_CONST(LV2_Atom_Sequence, events), bytes);
+            sequence->atom.size = used + bytes;
+            return true;
+        }
+
+        bool append(LV2_EvBuf_Iterator &iterator, const LV2_Atom_Sequence *events)
+        {
+            if (!Append(evbuf, bufferSize, events))
+            {
+                return false;
+            }
+            iterator.offset = padSize(size());
+            return true;
+        }
+
         bool write(
             LV2_EvBuf_Iterator &iterator,
             uint32_t frameOffset,
@@ -166,9 +203,7 @@ namespace pipedal
             void *midiData
             )
         {
-            
-            write(iterator,frameOffset,urids.midi_Event,midiSize,midiData);
-            return false;
+            return write(iterator,frameOffset,urids.midi_Event,midiSize,midiData);
         }
     };
 
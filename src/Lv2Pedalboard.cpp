@@ -24,17 +24,42 @@
 #include "SplitEffect.hpp"
 #include "RingBufferReader.hpp"
 #include "VuUpdate.hpp"
+#include "EffectTiming.hpp"
+#include "RealtimeTripwire.hpp"
 #include "AudioHost.hpp"
 #include "Lv2EventBufferWriter.hpp"
 #include "Lv2Log.hpp"
 #include "CrashGuard.hpp"
 #include "restrict.hpp"
+#include "PipelinePartition.hpp"
+#include "Tracer.hpp"
+#include <set>
+#include <algorithm>
+#include <thread>
 
 using namespace pipedal;
 
-float *Lv2Pedalboard::CreateNewAudioBuffer()
+float *Lv2Pedalboard::CreateNewAudioBuffer(bool reusable)
 {
-    return bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize());
+    if (!reusable)
+    {
+        ++audioBufferCount;
+        return realtimeArena->Allocate<float>(pHost->GetMaxAudioBufferSize());
+    }
+    float *result;
+    if (freeAudioBuffers.size() != 0)
+    {
+        // most recently released first, since it's the most likely to still be in cache.
+        result = freeAudioBuffers.back();
+        freeAudioBuffers.pop_back();
+    }
+    else
+    {
+        ++audioBufferCount;
+        result = realtimeArena->Allocate<float>(pHost->GetMaxAudioBufferSize());
+    }
+    liveAudioBuffers.insert(result);
+    return result;
 }
 
 std::vector<float *> Lv2Pedalboard::AllocateAudioBuffers(int nChannels)
@@ -42,11 +67,62 @@ std::vector<float *> Lv2Pedalboard::AllocateAudioBuffers(int nChannels)
     std::vector<float *> result;
     for (int i = 0; i < nChannels; ++i)
     {
-        result.push_back(bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize()));
+        result.push_back(CreateNewAudioBuffer());
     }
     return result;
 }
 
+void Lv2Pedalboard::ReleaseAudioBuffers(const std::vector<float *> &buffers, const std::vector<float *> &stillInUse)
+{
+    for (float *buffer : buffers)
+    {
+        if (std::find(stillInUse.begin(), stillInUse.end(), buffer) != stillInUse.end())
+        {
+            continue;
+        }
+        // buffers that were never shared (pedalboard inputs, sidechain sources &c) aren't live, and stay where they are.
+        if (liveAudioBuffers.erase(buffer) != 0)
+        {
+            if (deferAudioBufferRelease)
+            {
+                deferredFreeAudioBuffers.push_back(buffer);
+            }
+            else
+            {
+                freeAudioBuffers.push_back(buffer);
+            }
+        }
+    }
+}
+
+bool Lv2Pedalboard::CanRunInPlace(IEffect *effect, const std::vector<float *> &inputBuffers)
+{
+    if (!effect->IsLv2Effect() || !((Lv2Effect *)effect)->CanRunInPlace())
+    {
+        return false;
+    }
+    if (effect->GetNumberOfOutputAudioBuffers() != (int)inputBuffers.size())
+    {
+        return false; // e.g. a mono input feeding both inputs of a stereo plugin.
+    }
+    if (inputBuffers.size() == 2 && inputBuffers[0] == inputBuffers[1])
+    {
+        return false;
+    }
+    for (size_t i = 0; i < inputBuffers.size(); ++i)
+    {
+        if (!liveAudioBuffers.contains(inputBuffers[i]))
+        {
+            return false; // read elsewhere.
+        }
+        if (effect->GetAudioInputBuffer((int)i) != inputBuffers[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 int Lv2Pedalboard::GetControlIndex(uint64_t instanceId, const std::string &symbol)
 {
     for (int i = 0; i < realtimeEffects.size(); ++i)
@@ -64,19 +140,25 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
     std::vector<PedalboardItem> &items,
     std::vector<float *> inputBuffers,
     Lv2PedalboardErrorList &errorList,
-    ExistingEffectMap *existingEffects)
+    ExistingEffectMap *existingEffects,
+    size_t begin,
+    size_t end)
 {
-    for (int i = 0; i < items.size(); ++i)
+    end = std::min(end, items.size());
+    for (size_t i = begin; i < end; ++i)
     {
         auto &item = items[i];
         if (!item.isEmpty())
         {
             std::shared_ptr<IEffect> pEffect = nullptr;
+            auto vuTap = std::make_unique<VuTap>();
+            std::vector<float *> splitChainBuffers; // read by the split's post-mix.
 
             if (item.isSplit())
             {
                 auto pSplit = new SplitEffect(item.instanceId(), pHost->GetSampleRate(), inputBuffers);
                 pEffect = std::shared_ptr<IEffect>(pSplit);
+                vuTap->effect = pSplit;
 
                 int topInputChannels = inputBuffers.size();
                 int bottomInputChannels = inputBuffers.size();
@@ -84,22 +166,75 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                 std::vector<float *> topInputs = AllocateAudioBuffers(topInputChannels);
                 std::vector<float *> bottomInputs = AllocateAudioBuffers(bottomInputChannels);
 
-                auto preMixAction = [pSplit](uint32_t frames)
-                { pSplit->PreMix(frames); };
+                this->preparingPlan->AddSplitPreMix(pSplit);
+
+                std::vector<float *> topResult;
+                std::vector<float *> bottomResult;
+
+                bool runInParallel = parallelSplitsEnabled && splitDepth == 0 && CanRunInParallel(item);
+                ++splitDepth;
+                if (runInParallel)
+                {
+                    // The top chain runs on the realtime helper thread while the audio thread runs the bottom chain.
+                    auto parallelSplit = std::make_unique<ParallelSplit>();
+                    ParallelSplit *pParallelSplit = parallelSplit.get();
+                    pParallelSplit->pedalboard = this;
+                    pParallelSplit->instanceId = item.instanceId();
+                    this->parallelSplits.push_back(std::move(parallelSplit));
+
+                    ExecutionPlan *audioThreadPlan = this->preparingPlan;
+                    this->preparingPlan = &pParallelSplit->helperPlan;
+                    this->preparingParallelSplit = pParallelSplit;
+                    // buffers the top chain is done with can't be used by the bottom chain, which runs at the same time.
+                    this->deferAudioBufferRelease = true;
+
+                    size_t topGate = this->preparingPlan->AddSplitChainGate(pSplit, true);
+                    topResult = PrepareItems(item.topChain(), topInputs, errorList, existingEffects);
+                    this->preparingPlan->EndSplitChainGate(topGate);
+
+                    this->deferAudioBufferRelease = false;
+                    this->preparingParallelSplit = nullptr;
+                    this->preparingPlan = audioThreadPlan;
+
+                    this->preparingPlan->AddCall(&Lv2Pedalboard::StartParallelSplit, pParallelSplit);
+
+                    size_t bottomGate = this->preparingPlan->AddSplitChainGate(pSplit, false);
+                    bottomResult = PrepareItems(item.bottomChain(), bottomInputs, errorList, existingEffects);
+                    this->preparingPlan->EndSplitChainGate(bottomGate);
 
-                this->processActions.push_back(preMixAction);
+                    this->preparingPlan->AddCall(&Lv2Pedalboard::WaitForParallelSplit, pParallelSplit);
 
-                std::vector<float *> topResult = PrepareItems(item.topChain(), topInputs, errorList, existingEffects);
-                std::vector<float *> bottomResult = PrepareItems(item.bottomChain(), bottomInputs, errorList, existingEffects);
+                    freeAudioBuffers.insert(freeAudioBuffers.end(), deferredFreeAudioBuffers.begin(), deferredFreeAudioBuffers.end());
+                    deferredFreeAudioBuffers.clear();
+                }
+                else
+                {
+                    // A/B splits stop running the deselected chain (see SplitEffect::IsChainDormant()), except to
+                    // deliver input messages to its effects.
+                    size_t topGate = this->preparingPlan->AddSplitChainGate(pSplit, true);
+                    topResult = PrepareItems(item.topChain(), topInputs, errorList, existingEffects);
+                    this->preparingPlan->EndSplitChainGate(topGate);
+                    size_t bottomGate = this->preparingPlan->AddSplitChainGate(pSplit, false);
+                    bottomResult = PrepareItems(item.bottomChain(), bottomInputs, errorList, existingEffects);
+                    this->preparingPlan->EndSplitChainGate(bottomGate);
+                }
+                --splitDepth;
+
+                this->preparingPlan->AddSplitPostMix(pSplit);
+                this->preparingPlan->AddCall(&Lv2Pedalboard::MeasureOutputVu, vuTap.get());
+
+                splitChainBuffers.insert(splitChainBuffers.end(), topInputs.begin(), topInputs.end());
+                splitChainBuffers.insert(splitChainBuffers.end(), bottomInputs.begin(), bottomInputs.end());
+                splitChainBuffers.insert(splitChainBuffers.end(), topResult.begin(), topResult.end());
+                splitChainBuffers.insert(splitChainBuffers.end(), bottomResult.begin(), bottomResult.end());
 
-                this->processActions.push_back(
-                    [pSplit](uint32_t frames)
-                    { pSplit->PostMix(frames); });
                 auto controlValue = item.GetControlValue("splitType");
                 // if split is L/R, always output stereo.
 
                 bool forceStereo = (controlValue != nullptr && controlValue->value() == 2);
                 pSplit->SetChainBuffers(topInputs, bottomInputs, topResult, bottomResult, forceStereo);
+                pSplit->SetChainCanBeDormant(true, !HasSidechainReaderOutside(item.topChain()));
+                pSplit->SetChainCanBeDormant(false, !HasSidechainReaderOutside(item.bottomChain()));
 
                 for (int i = 0; i < item.controlValues().size(); ++i)
                 {
@@ -115,20 +250,38 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
             {
                 std::shared_ptr<IEffect> pLv2Effect;
 
-                if (existingEffects && existingEffects->contains(item.instanceId()))
+                bool borrowEffect = existingEffects && existingEffects->contains(item.instanceId());
+                if (borrowEffect && inputBuffers.size() != 1)
+                {
+                    // a plugin running mono can't take a stereo input. Make a new instance.
+                    IEffect *existingEffect = existingEffects->at(item.instanceId()).get();
+                    borrowEffect = !(existingEffect->IsLv2Effect() && ((Lv2Effect *)existingEffect)->IsMonoMode());
+                }
+                if (borrowEffect)
                 {
                     pLv2Effect = existingEffects->at(item.instanceId());
                     ((Lv2Effect *)pLv2Effect.get())->SetBorrowedEffect(true);
+                    ((Lv2Effect *)pLv2Effect.get())->SetHardBypass(item.hardBypass());
+                    this->hasBorrowedEffects = true;
                 }
                 else
                 {
-                    try
+                    auto iCreated = createdEffects.find(item.instanceId());
+                    if (iCreated != createdEffects.end())
                     {
-                        pLv2Effect = std::shared_ptr<IEffect>(this->pHost->CreateEffect(item));
+                        pLv2Effect = std::move(iCreated->second); // (null if creation failed.)
+                        createdEffects.erase(iCreated);
                     }
-                    catch (const std::exception &e)
+                    else
                     {
-                        Lv2Log::warning(SS(e.what()));
+                        try
+                        {
+                            pLv2Effect = std::shared_ptr<IEffect>(this->pHost->CreateEffect(item, this->realtimeArena));
+                        }
+                        catch (const std::exception &e)
+                        {
+                            Lv2Log::warning(SS(e.what()));
+                        }
                     }
 
                     if (pLv2Effect && pLv2Effect->HasErrorMessage())
@@ -143,8 +296,29 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                 {
 
                     pEffect = pLv2Effect;
+                    if (pLv2Effect->IsLv2Effect())
+                    {
+                        // a pedalboard that is being replaced must not rebind a borrowed effect's ports from here on.
+                        ((Lv2Effect *)pLv2Effect.get())->SetBufferOwner(this);
+                    }
 
                     uint64_t instanceId = pEffect->GetInstanceId();
+                    if (!borrowEffect && inputBuffers.size() == 1 && pLv2Effect->IsLv2Effect())
+                    {
+                        // keep the chain mono until the first plugin that is truly stereo.
+                        Lv2Effect *lv2Effect = (Lv2Effect *)pLv2Effect.get();
+                        if (lv2Effect->CanRunMono())
+                        {
+                            lv2Effect->SetMonoMode();
+                            ++this->monoModeEffectCount;
+                            float load = pHost->GetEstimatedPluginLoad(item.uri());
+                            if (load > 0)
+                            {
+                                // assumes that cost is proportional to the number of channels.
+                                this->monoModeSavedLoad += load * 0.5f;
+                            }
+                        }
+                    }
                     pLv2Effect->PrepareNoInputEffect(inputBuffers.size(), pHost->GetMaxAudioBufferSize());
 
                     if (inputBuffers.size() == 1)
@@ -224,37 +398,58 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                 // just use one buffer for all plugins
                                 if (!this->pedalboardSidechainBuffer)
                                 {
-                                    this->pedalboardSidechainBuffer = CreateNewAudioBuffer();
+                                    this->pedalboardSidechainBuffer = CreateNewAudioBuffer(false); // must stay zero.
                                 }
                                 pLv2Effect->SetAudioSidechainBuffer(i, this->pedalboardSidechainBuffer);
                             }
                         }
                     }
 
-                    // check to see whether we need buffer staging.
-                    bool requiresBufferStaging = false;
+                    vuTap->effect = pLv2Effect.get();
+                    vuTap->inPlace = !sidechainSourceIds.contains(item.instanceId()) && CanRunInPlace(pLv2Effect.get(), inputBuffers);
+                    if (vuTap->inPlace)
+                    {
+                        this->preparingPlan->AddCall(&Lv2Pedalboard::MeasureInputVu, vuTap.get());
+                    }
+                    const char *traceName = Tracer::Intern(item.pluginName());
                     if (pLv2Effect->IsLv2Effect())
                     {
                         Lv2Effect *lv2Effect = (Lv2Effect *)pLv2Effect.get();
 
-                        if (lv2Effect->RequiresBufferStaging())
+                        if (this->preparingParallelSplit)
                         {
-                            requiresBufferStaging = true;
-                            this->processActions.push_back(
-                                [lv2Effect, this](uint32_t frames)
-                                {
-                                    lv2Effect->RunWithBufferStaging(frames, this->ringBufferWriter);
-                                });
+                            this->preparingParallelSplit->helperEffects.push_back(lv2Effect);
+                        }
+                        // (pEffect is added to realtimeEffects below.)
+                        if (lv2Effect->HasBlockLengthRequirements() && !lv2Effect->RequiresBufferStaging())
+                        {
+                            this->hasUnstagedBlockLengthRequirements = true;
+                        }
+                        if (SilenceGate::CanGate(lv2Effect, pHost->GetPluginInfo(item.uri()).get(), item))
+                        {
+                            auto gate = std::make_unique<SilenceGate>(lv2Effect, lv2Effect->RequiresBufferStaging(), pHost->GetSampleRate());
+                            vuTap->silenceGate = gate.get();
+                            this->preparingPlan->AddRunSilenceGate(gate.get(), (int32_t)this->realtimeEffects.size(), traceName);
+                            this->silenceGates.push_back(std::move(gate));
+                        }
+                        else
+                        {
+                            this->preparingPlan->AddRunLv2Effect(lv2Effect, lv2Effect->RequiresBufferStaging(), (int32_t)this->realtimeEffects.size(), traceName);
                         }
                     }
-
-                    if (!requiresBufferStaging)
+                    else
                     {
-                        this->processActions.push_back(
-                            [pLv2Effect, this](uint32_t frames)
-                            {
-                                pLv2Effect->Run(frames, this->ringBufferWriter);
-                            });
+                        this->preparingPlan->AddRunEffect(pLv2Effect.get(), (int32_t)this->realtimeEffects.size(), traceName);
+                    }
+                    this->preparingPlan->AddCall(&Lv2Pedalboard::MeasureOutputVu, vuTap.get());
+                    if (pLv2Effect->IsLv2Effect() && ((Lv2Effect *)pLv2Effect.get())->HasPathProperties())
+                    {
+                        auto tap = std::make_unique<PathPropertyTap>();
+                        tap->pedalboard = this;
+                        tap->effect = (Lv2Effect *)pLv2Effect.get();
+                        tap->index = this->pathPropertyTaps.size();
+                        this->preparingPlan->AddCall(&Lv2Pedalboard::CheckPathPropertyOutput, tap.get());
+                        this->pathPropertyTaps.push_back(std::move(tap));
                     }
 
                     // reset any trigger controls to default state after processing
@@ -273,11 +468,7 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                                     if (controlIndex >= 0)
                                     {
                                         float defaultValue = control->default_value();
-                                        this->processActions.push_back(
-                                            [pLv2Effect, controlIndex, defaultValue](int32_t frames)
-                                            {
-                                                pLv2Effect->SetControl(controlIndex, defaultValue);
-                                            });
+                                        this->preparingPlan->AddSetControl(pLv2Effect.get(), controlIndex, defaultValue);
                                     }
                                 }
                             }
@@ -290,22 +481,40 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
                 this->effects.push_back(pEffect); // for ownership.
 
                 this->realtimeEffects.push_back(pEffect.get()); // because std::shared_ptr is not threadsafe.
+                this->vuTaps.push_back(std::move(vuTap));
 
                 std::vector<float *> effectOutput;
 
-                if (pEffect->GetNumberOfOutputAudioBuffers() == 1)
+                if (this->vuTaps.back()->inPlace)
                 {
-                    effectOutput.push_back(CreateNewAudioBuffer());
+                    effectOutput = inputBuffers;
                 }
-                else if (pEffect->GetNumberOfOutputAudioBuffers() >= 2)
+                else
                 {
-                    effectOutput.push_back(CreateNewAudioBuffer());
-                    effectOutput.push_back(CreateNewAudioBuffer());
+                    // Outputs that the effect doesn't write every period can't be shared: they would pick up other effects' audio.
+                    // Nor can the outputs of sidechain sources, which are read by later effects.
+                    bool reusable =
+                        !sidechainSourceIds.contains(item.instanceId()) &&
+                        (item.isSplit() ||
+                         (pEffect->IsLv2Effect() &&
+                          (pEffect->GetNumberOfInputAudioPorts() == 0 || pEffect->GetNumberOfOutputAudioPorts() >= pEffect->GetNumberOfOutputAudioBuffers())));
+
+                    if (pEffect->GetNumberOfOutputAudioBuffers() == 1)
+                    {
+                        effectOutput.push_back(CreateNewAudioBuffer(reusable));
+                    }
+                    else if (pEffect->GetNumberOfOutputAudioBuffers() >= 2)
+                    {
+                        effectOutput.push_back(CreateNewAudioBuffer(reusable));
+                        effectOutput.push_back(CreateNewAudioBuffer(reusable));
+                    }
                 }
                 for (size_t i = 0; i < effectOutput.size(); ++i)
                 {
                     pEffect->SetAudioOutputBuffer(i, effectOutput[i]);
                 }
+                ReleaseAudioBuffers(inputBuffers, effectOutput);
+                ReleaseAudioBuffers(splitChainBuffers);
                 inputBuffers = effectOutput;
             }
         }
@@ -313,230 +522,929 @@ std::vector<float *> Lv2Pedalboard::PrepareItems(
     return inputBuffers;
 }
 
-void Lv2Pedalboard::Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects)
+static void CollectInstanceIds(const std::vector<PedalboardItem> &items, std::set<int64_t> &instanceIds)
 {
-    this->pHost = pHost;
-
-    inputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
-    outputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
-    inputVolume.SetMinDb(-60);
-    outputVolume.SetMinDb(-60);
-
-    inputVolume.SetTarget(pedalboard.input_volume_db());
-    outputVolume.SetTarget(pedalboard.output_volume_db());
-
-    for (int i = 0; i < pHost->GetNumberOfInputAudioChannels(); ++i)
+    for (const auto &item : items)
     {
-        this->pedalboardInputBuffers.push_back(bufferPool.AllocateBuffer<float>(pHost->GetMaxAudioBufferSize()));
+        instanceIds.insert(item.instanceId());
+        if (item.isSplit())
+        {
+            CollectInstanceIds(item.topChain(), instanceIds);
+            CollectInstanceIds(item.bottomChain(), instanceIds);
+        }
     }
+}
 
-    auto outputs = PrepareItems(pedalboard.items(), this->pedalboardInputBuffers, errorList, existingEffects);
-    int nOutputs = pHost->GetNumberOfOutputAudioChannels();
-    if (nOutputs == 1)
+static bool HasSidechainInputFrom(const std::vector<PedalboardItem> &items, const std::set<int64_t> &instanceIds)
+{
+    for (const auto &item : items)
     {
-        this->pedalboardOutputBuffers.push_back(outputs[0]);
+        if (instanceIds.contains(item.sideChainInputId()))
+        {
+            return true;
+        }
+        if (item.isSplit())
+        {
+            if (HasSidechainInputFrom(item.topChain(), instanceIds) || HasSidechainInputFrom(item.bottomChain(), instanceIds))
+            {
+                return true;
+            }
+        }
     }
-    else
+    return false;
+}
+
+static void CollectSidechainSourceIds(const std::vector<PedalboardItem> &items, std::set<int64_t> &instanceIds)
+{
+    for (const auto &item : items)
     {
-        if (outputs.size() == 1)
+        if (item.sideChainInputId() >= 0)
         {
-            this->pedalboardOutputBuffers.push_back(outputs[0]);
-            this->pedalboardOutputBuffers.push_back(outputs[0]);
+            instanceIds.insert(item.sideChainInputId());
         }
-        else
+        if (item.isSplit())
         {
-            this->pedalboardOutputBuffers.push_back(outputs[0]);
-            this->pedalboardOutputBuffers.push_back(outputs[1]);
+            CollectSidechainSourceIds(item.topChain(), instanceIds);
+            CollectSidechainSourceIds(item.bottomChain(), instanceIds);
         }
     }
-    PrepareMidiMap(pedalboard);
 }
 
-void Lv2Pedalboard::PrepareMidiMap(const PedalboardItem &pedalboardItem)
+static void CountSidechainReaders(const std::vector<PedalboardItem> &items, std::map<int64_t, size_t> &readerCounts)
 {
-    if (pedalboardItem.midiBindings().size() != 0)
+    for (const auto &item : items)
     {
-        Lv2PluginInfo::ptr pluginInfo;
-        if (pedalboardItem.uri() == SPLIT_PEDALBOARD_ITEM_URI)
+        if (item.sideChainInputId() >= 0)
         {
-            pluginInfo = GetSplitterPluginInfo();
+            ++readerCounts[item.sideChainInputId()];
         }
-        else
+        if (item.isSplit())
         {
-            pluginInfo = pHost->GetPluginInfo(pedalboardItem.uri());
+            CountSidechainReaders(item.topChain(), readerCounts);
+            CountSidechainReaders(item.bottomChain(), readerCounts);
         }
+    }
+}
 
-        int effectIndex = this->GetIndexOfInstanceId(pedalboardItem.instanceId());
-
-        if (pluginInfo && effectIndex != -1)
+static bool HasPedalboardInputSidechain(const std::vector<PedalboardItem> &items)
+{
+    for (const auto &item : items)
+    {
+        if (item.sideChainInputId() == -2)
         {
-            for (size_t bindingIndex = 0; bindingIndex < pedalboardItem.midiBindings().size(); ++bindingIndex)
+            return true;
+        }
+        if (item.isSplit())
+        {
+            if (HasPedalboardInputSidechain(item.topChain()) || HasPedalboardInputSidechain(item.bottomChain()))
             {
-                auto &binding = pedalboardItem.midiBindings()[bindingIndex];
-                {
-                    const Lv2PortInfo *pPortInfo;
-                    int controlIndex;
-                    if (binding.symbol() == "__bypass")
-                    {
-                        pPortInfo = GetBypassPortInfo();
-                        controlIndex = -1;
-                    }
-                    else
-                    {
-                        try
-                        {
-                            pPortInfo = &pluginInfo->getPort(binding.symbol());
-                            controlIndex = this->GetControlIndex(pedalboardItem.instanceId(), binding.symbol());
-                        }
-                        catch (const std::exception &ignored)
-                        {
-                            continue;
-                        }
-                    }
-
-                    MidiMapping mapping;
-                    mapping.pluginInfo = pluginInfo; // for lifetime management. <shrugs> We're holding internal pointers to this. May save us in a disorderly shutdown.
-                    mapping.pPortInfo = pPortInfo;
-                    mapping.effectIndex = effectIndex;
-                    mapping.controlIndex = controlIndex;
-                    mapping.midiBinding = binding;
-                    mapping.instanceId = pedalboardItem.instanceId();
-
-                    if (pPortInfo->mod_momentaryOffByDefault() || pPortInfo->mod_momentaryOnByDefault())
-                    {
-                        mapping.mappingType = MidiControlType::MomentarySwitch;
-                    }
-                    else if (pPortInfo->trigger_property())
-                    {
-                        mapping.mappingType = MidiControlType::Trigger;
-                    }
-                    else if (pPortInfo->IsSwitch())
-                    {
-                        mapping.mappingType = MidiControlType::Toggle;
-                    }
-                    else if (pPortInfo->enumeration_property())
-                    {
-                        mapping.mappingType = MidiControlType::Select;
-                    }
-                    else
-                    {
-                        mapping.mappingType = MidiControlType::Dial;
-                    }
-                    if (binding.bindingType() == BINDING_TYPE_NOTE)
-                    {
-                        mapping.key = 0x9000 | binding.note(); // i.e. midi note on.
-                    }
-                    else if (binding.bindingType() == BINDING_TYPE_CONTROL)
-                    {
-                        mapping.key = 0xB000 | binding.control(); // i.e. midi control
-                    }
-                    else
-                    {
-                        mapping.key = -1;
-                    }
-                    if (mapping.key != -1)
-                    {
-                        midiMappings.push_back(std::move(mapping));
-                    }
-                }
+                return true;
             }
         }
     }
-    for (size_t i = 0; i < pedalboardItem.topChain().size(); ++i)
-    {
-        PrepareMidiMap(pedalboardItem.topChain()[i]);
-    }
-    for (size_t i = 0; i < pedalboardItem.bottomChain().size(); ++i)
+    return false;
+}
+
+static bool HasNonEmptyItems(const std::vector<PedalboardItem> &items)
+{
+    for (const auto &item : items)
     {
-        PrepareMidiMap(pedalboardItem.bottomChain()[i]);
+        if (!item.isEmpty())
+        {
+            return true;
+        }
     }
+    return false;
 }
-void Lv2Pedalboard::PrepareMidiMap(const Pedalboard &pedalboard)
+
+bool Lv2Pedalboard::CanRunInParallel(const PedalboardItem &splitItem)
 {
-    for (size_t i = 0; i < pedalboard.items().size(); ++i)
+    if (!HasNonEmptyItems(splitItem.topChain()) || !HasNonEmptyItems(splitItem.bottomChain()))
     {
-        auto &item = pedalboard.items()[i];
-        PrepareMidiMap(item);
+        return false; // nothing to gain.
+    }
+    // a sidechain connection between the two chains would be a data race.
+    std::set<int64_t> topIds;
+    std::set<int64_t> bottomIds;
+    CollectInstanceIds(splitItem.topChain(), topIds);
+    CollectInstanceIds(splitItem.bottomChain(), bottomIds);
+    if (HasSidechainInputFrom(splitItem.topChain(), bottomIds) || HasSidechainInputFrom(splitItem.bottomChain(), topIds))
+    {
+        return false;
     }
-    std::sort(this->midiMappings.begin(), this->midiMappings.end(),
-              [](const MidiMapping &left, const MidiMapping &right)
-              { return left.key < right.key; });
+    return true;
 }
 
-void Lv2Pedalboard::UpdateAudioPorts()
+// True if an item outside the chain reads a sidechain from an item in the chain.
+bool Lv2Pedalboard::HasSidechainReaderOutside(const std::vector<PedalboardItem> &chain)
 {
-    for (int i = 0; i < this->effects.size(); ++i)
+    std::set<int64_t> chainIds;
+    std::map<int64_t, size_t> chainReaderCounts;
+    CollectInstanceIds(chain, chainIds);
+    CountSidechainReaders(chain, chainReaderCounts);
+    for (int64_t instanceId : chainIds)
     {
-        IEffect *effect = this->realtimeEffects[i];
-        if (effect->IsLv2Effect())
+        auto i = this->sidechainReaderCounts.find(instanceId);
+        if (i != this->sidechainReaderCounts.end() && i->second > chainReaderCounts[instanceId])
         {
-            Lv2Effect *lv2Effect = (Lv2Effect *)effect;
-            lv2Effect->UpdateAudioPorts();
+            return true;
         }
     }
+    return false;
 }
 
-void Lv2Pedalboard::Activate()
+void Lv2Pedalboard::RunHelperPlan(void *data, uint32_t frames)
 {
-    CrashGuardLock crashGuardLock;
+    RealtimeTripwire::ThreadScope tripwireScope;
+    ParallelSplit *parallelSplit = (ParallelSplit *)data;
+    // effects on the helper thread must not write to the (single-writer) realtime ring buffer.
+    parallelSplit->helperPlan.Execute(frames, nullptr, parallelSplit->pedalboard->effectTimings);
+}
 
-    for (int i = 0; i < this->effects.size(); ++i)
-    {
-        this->realtimeEffects[i]->Activate();
-    }
+void Lv2Pedalboard::StartParallelSplit(void *data, uint32_t frames)
+{
+    ParallelSplit *parallelSplit = (ParallelSplit *)data;
+    parallelSplit->startTime = std::chrono::steady_clock::now();
+    parallelSplit->pedalboard->helperThread->Start(&Lv2Pedalboard::RunHelperPlan, parallelSplit, frames);
 }
-void Lv2Pedalboard::Deactivate()
+
+void Lv2Pedalboard::WaitForParallelSplit(void *data, uint32_t frames)
 {
-    for (int i = 0; i < this->effects.size(); ++i)
+    using namespace std::chrono;
+
+    ParallelSplit *parallelSplit = (ParallelSplit *)data;
+    Lv2Pedalboard *pedalboard = parallelSplit->pedalboard;
+
+    auto waitStart = steady_clock::now();
+    pedalboard->helperThread->Wait();
+    auto waitEnd = steady_clock::now();
+
+    // messages from helper-thread effects have to be written by the audio thread.
+    for (Lv2Effect *effect : parallelSplit->helperEffects)
     {
-        this->realtimeEffects[i]->Deactivate();
+        effect->RelayPatchSetMessages(effect->GetInstanceId(), pedalboard->ringBufferWriter);
     }
+
+    constexpr float SMOOTHING = 1.0f / 32;
+    float audioThreadUs = duration_cast<nanoseconds>(waitStart - parallelSplit->startTime).count() * 0.001f;
+    float waitUs = duration_cast<nanoseconds>(waitEnd - waitStart).count() * 0.001f;
+    float helperUs = pedalboard->helperThread->GetLastJobNs() * 0.001f;
+
+    float v = parallelSplit->audioThreadUs.load(std::memory_order_relaxed);
+    parallelSplit->audioThreadUs.store(v + (audioThreadUs - v) * SMOOTHING, std::memory_order_relaxed);
+    v = parallelSplit->waitUs.load(std::memory_order_relaxed);
+    parallelSplit->waitUs.store(v + (waitUs - v) * SMOOTHING, std::memory_order_relaxed);
+    v = parallelSplit->helperUs.load(std::memory_order_relaxed);
+    parallelSplit->helperUs.store(v + (helperUs - v) * SMOOTHING, std::memory_order_relaxed);
 }
 
-static void Copy(float *restrict input, float *restrict output, uint32_t samples)
+std::vector<ParallelSplitTiming> Lv2Pedalboard::GetParallelSplitTimings() const
 {
-    for (uint32_t i = 0; i < samples; ++i)
+    std::vector<ParallelSplitTiming> result;
+    for (const auto &parallelSplit : parallelSplits)
     {
-        output[i] = input[i];
+        ParallelSplitTiming timing;
+        timing.instanceId_ = parallelSplit->instanceId;
+        timing.helperUs_ = parallelSplit->helperUs.load(std::memory_order_relaxed);
+        timing.audioThreadUs_ = parallelSplit->audioThreadUs.load(std::memory_order_relaxed);
+        timing.waitUs_ = parallelSplit->waitUs.load(std::memory_order_relaxed);
+        result.push_back(timing);
     }
+    return result;
 }
-bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *ringBufferWriter)
+
+std::vector<TaskGroupTiming> Lv2Pedalboard::GetTaskGroupTimings() const
 {
-    this->ringBufferWriter = ringBufferWriter;
-    for (size_t i = 0; i < this->pedalboardInputBuffers.size(); ++i)
+    std::vector<TaskGroupTiming> result;
+    for (IEffect *effect : realtimeEffects)
     {
-        if (inputBuffers[i] == nullptr)
+        if (effect->IsLv2Effect() && ((Lv2Effect *)effect)->UsesTaskGroup())
         {
-            return false;
+            result.push_back(((Lv2Effect *)effect)->GetTaskGroupTiming());
         }
     }
+    return result;
+}
 
-    for (size_t i = 0; i < samples; ++i)
-    {
-        float volume = this->inputVolume.Tick();
-        for (int c = 0; c < this->pedalboardInputBuffers.size(); ++c)
-        {
-            this->pedalboardInputBuffers[c][i] = inputBuffers[c][i] * volume;
-        }
-    }
-    for (int i = 0; i < this->processActions.size(); ++i)
+static void CollectItemInstanceIds(const PedalboardItem &item, std::set<int64_t> &instanceIds)
+{
+    instanceIds.insert(item.instanceId());
+    if (item.isSplit())
     {
-        processActions[i](samples);
+        CollectInstanceIds(item.topChain(), instanceIds);
+        CollectInstanceIds(item.bottomChain(), instanceIds);
     }
+}
+
+static void CollectItemSidechainSourceIds(const PedalboardItem &item, std::set<int64_t> &instanceIds)
+{
+    if (item.sideChainInputId() >= 0)
+    {
+        instanceIds.insert(item.sideChainInputId());
+    }
+    if (item.isSplit())
+    {
+        CollectSidechainSourceIds(item.topChain(), instanceIds);
+        CollectSidechainSourceIds(item.bottomChain(), instanceIds);
+    }
+}
+
+static void CollectPluginUris(const std::vector<PedalboardItem> &items, std::vector<std::string> &uris)
+{
+    for (const auto &item : items)
+    {
+        if (item.isSplit())
+        {
+            CollectPluginUris(item.topChain(), uris);
+            CollectPluginUris(item.bottomChain(), uris);
+        }
+        else if (!item.isEmpty())
+        {
+            uris.push_back(item.uri());
+        }
+    }
+}
+
+float Lv2Pedalboard::EstimateItemLoad(const PedalboardItem &item, float unknownPluginLoad)
+{
+    if (item.isEmpty())
+    {
+        return 0;
+    }
+    if (item.isSplit())
+    {
+        float result = 0;
+        for (const auto &child : item.topChain())
+        {
+            result += EstimateItemLoad(child, unknownPluginLoad);
+        }
+        for (const auto &child : item.bottomChain())
+        {
+            result += EstimateItemLoad(child, unknownPluginLoad);
+        }
+        return result;
+    }
+    float load = pHost->GetEstimatedPluginLoad(item.uri());
+    return load < 0 ? unknownPluginLoad : load;
+}
+
+size_t Lv2Pedalboard::ChoosePipelineCut(const std::vector<PedalboardItem> &items)
+{
+    // plugins that haven't been measured yet are assumed to cost as much as the average plugin that has.
+    std::vector<std::string> uris;
+    CollectPluginUris(items, uris);
+    float knownLoad = 0;
+    size_t nKnown = 0;
+    for (const auto &uri : uris)
+    {
+        float load = pHost->GetEstimatedPluginLoad(uri);
+        if (load >= 0)
+        {
+            knownLoad += load;
+            ++nKnown;
+        }
+    }
+    float unknownPluginLoad = nKnown == 0 ? 1.0f : std::max(knownLoad / nKnown, 1E-4f);
+
+    std::vector<float> costs;
+    std::vector<std::set<int64_t>> instanceIds(items.size());
+    std::vector<std::set<int64_t>> sidechainSourceIds(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        costs.push_back(EstimateItemLoad(items[i], unknownPluginLoad));
+        CollectItemInstanceIds(items[i], instanceIds[i]);
+        CollectItemSidechainSourceIds(items[i], sidechainSourceIds[i]);
+    }
+    // a sidechain connection between the two stages would be a data race.
+    std::vector<bool> canCutBefore(items.size(), true);
+    for (size_t reader = 0; reader < items.size(); ++reader)
+    {
+        for (int64_t sourceId : sidechainSourceIds[reader])
+        {
+            for (size_t source = 0; source < items.size(); ++source)
+            {
+                if (instanceIds[source].contains(sourceId))
+                {
+                    for (size_t cut = std::min(reader, source) + 1; cut <= std::max(reader, source); ++cut)
+                    {
+                        canCutBefore[cut] = false;
+                    }
+                }
+            }
+        }
+    }
+    return PipelinePartition::ChooseCut(costs, canCutBefore);
+}
+
+std::vector<float *> Lv2Pedalboard::PreparePipeline(
+    std::vector<PedalboardItem> &items,
+    size_t cut,
+    Lv2PedalboardErrorList &errorList,
+    ExistingEffectMap *existingEffects)
+{
+    // The first stage runs on the realtime helper thread, while the audio thread runs the second stage on the
+    // first stage's output from the previous period.
+    auto stage = std::make_unique<ParallelSplit>();
+    ParallelSplit *pStage = stage.get();
+    pStage->pedalboard = this;
+    this->parallelSplits.push_back(std::move(stage));
+
+    ExecutionPlan *audioThreadPlan = this->preparingPlan;
+    this->preparingPlan = &pStage->helperPlan;
+    this->preparingParallelSplit = pStage;
+    // buffers the first stage is done with can't be used by the second stage, which runs at the same time.
+    this->deferAudioBufferRelease = true;
+
+    pStage->handoffSources = PrepareItems(items, this->pedalboardInputBuffers, errorList, existingEffects, 0, cut);
+
+    this->deferAudioBufferRelease = false;
+    this->deferredFreeAudioBuffers.clear();
+    this->preparingParallelSplit = nullptr;
+    this->preparingPlan = audioThreadPlan;
+
+    for (size_t i = 0; i < pStage->handoffSources.size(); ++i)
+    {
+        pStage->handoffTargets.push_back(CreateNewAudioBuffer(false));
+    }
+
+    this->preparingPlan->AddCall(&Lv2Pedalboard::StartParallelSplit, pStage);
+    std::vector<float *> outputs = PrepareItems(items, pStage->handoffTargets, errorList, existingEffects, cut);
+    this->preparingPlan->AddCall(&Lv2Pedalboard::WaitForParallelSplit, pStage);
+    this->preparingPlan->AddCall(&Lv2Pedalboard::CommitPipelineHandoff, pStage);
+    return outputs;
+}
+
+void Lv2Pedalboard::CommitPipelineHandoff(void *data, uint32_t frames)
+{
+    ParallelSplit *stage = (ParallelSplit *)data;
+    for (size_t i = 0; i < stage->handoffSources.size(); ++i)
+    {
+        std::copy_n(stage->handoffSources[i], frames, stage->handoffTargets[i]);
+    }
+}
+
+static void CollectNewPlugins(std::vector<PedalboardItem> &items, ExistingEffectMap *existingEffects, std::vector<PedalboardItem *> &result)
+{
+    for (auto &item : items)
+    {
+        if (item.isSplit())
+        {
+            CollectNewPlugins(item.topChain(), existingEffects, result);
+            CollectNewPlugins(item.bottomChain(), existingEffects, result);
+        }
+        else if (!item.isEmpty() && !(existingEffects && existingEffects->contains(item.instanceId())))
+        {
+            result.push_back(&item);
+        }
+    }
+}
+
+void Lv2Pedalboard::CreateEffectsConcurrently(std::vector<PedalboardItem> &items, ExistingEffectMap *existingEffects)
+{
+    // Plugins are instantiated, and their state restored (which may load models and impulse files),
+    // on a pool of threads. Buffers are connected afterwards, on this thread, by PrepareItems.
+    std::vector<PedalboardItem *> newPlugins;
+    CollectNewPlugins(items, existingEffects, newPlugins);
+
+    // Instances of the same plugin are created one at a time, as are plugins that can't be created concurrently
+    // with any other plugin (which are created after all the others).
+    std::vector<std::vector<PedalboardItem *>> jobs;
+    std::map<std::string, size_t> jobsByUri;
+    std::vector<PedalboardItem *> serialPlugins;
+    for (PedalboardItem *item : newPlugins)
+    {
+        if (!pHost->CanCreateEffectConcurrently(item->uri()))
+        {
+            serialPlugins.push_back(item);
+            continue;
+        }
+        auto iJob = jobsByUri.find(item->uri());
+        if (iJob == jobsByUri.end())
+        {
+            jobsByUri[item->uri()] = jobs.size();
+            jobs.push_back({item});
+        }
+        else
+        {
+            jobs[iJob->second].push_back(item);
+        }
+    }
+    if (jobs.size() < 2)
+    {
+        return; // nothing to gain. PrepareItems creates them.
+    }
+
+    std::vector<std::shared_ptr<IEffect>> results(newPlugins.size());
+    std::map<PedalboardItem *, size_t> resultIndex;
+    for (size_t i = 0; i < newPlugins.size(); ++i)
+    {
+        resultIndex[newPlugins[i]] = i;
+    }
+    auto createEffect = [this](PedalboardItem *item) -> std::shared_ptr<IEffect>
+    {
+        try
+        {
+            return std::shared_ptr<IEffect>(this->pHost->CreateEffect(*item, this->realtimeArena));
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS(e.what()));
+            return nullptr;
+        }
+    };
+
+    unsigned int nThreads = std::max(1u, std::thread::hardware_concurrency());
+    nThreads = std::min<unsigned int>(nThreads, (unsigned int)jobs.size());
+
+    std::atomic<size_t> nextJob{0};
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < nThreads; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                while (true)
+                {
+                    size_t job = nextJob.fetch_add(1);
+                    if (job >= jobs.size())
+                    {
+                        break;
+                    }
+                    for (PedalboardItem *item : jobs[job])
+                    {
+                        results[resultIndex.at(item)] = createEffect(item);
+                    }
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (PedalboardItem *item : serialPlugins)
+    {
+        results[resultIndex.at(item)] = createEffect(item);
+    }
+    for (size_t i = 0; i < newPlugins.size(); ++i)
+    {
+        createdEffects[newPlugins[i]->instanceId()] = std::move(results[i]);
+    }
+    Lv2Log::debug(SS("Created " << newPlugins.size() << " plugins on " << nThreads << " threads."));
+}
+
+void Lv2Pedalboard::Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects,
+                            int inputChannels, int outputChannels)
+{
+    if (inputChannels < 0)
+    {
+        inputChannels = pHost->GetNumberOfInputAudioChannels();
+    }
+    if (outputChannels < 0)
+    {
+        outputChannels = pHost->GetNumberOfOutputAudioChannels();
+    }
+    this->pHost = pHost;
+    this->parallelSplitsEnabled = pedalboard.parallelSplits();
+    this->realtimeArena = std::make_shared<RealtimeArena>(RealtimeArena::DEFAULT_BLOCK_SIZE, true);
+
+    inputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
+    outputVolume.SetSampleRate((float)(this->pHost->GetSampleRate()));
+    inputVolume.SetMinDb(-60);
+    outputVolume.SetMinDb(-60);
+
+    inputVolume.SetTarget(pedalboard.input_volume_db());
+    outputVolume.SetTarget(pedalboard.output_volume_db());
+
+    for (int i = 0; i < inputChannels; ++i)
+    {
+        // also read by sidechains and the input VU, so never shared.
+        this->pedalboardInputBuffers.push_back(CreateNewAudioBuffer(false));
+    }
+    CollectSidechainSourceIds(pedalboard.items(), this->sidechainSourceIds);
+    CountSidechainReaders(pedalboard.items(), this->sidechainReaderCounts);
+    CreateEffectsConcurrently(pedalboard.items(), existingEffects);
+
+    std::vector<float *> outputs;
+    size_t pipelineCut = pedalboard.pipeline() ? ChoosePipelineCut(pedalboard.items()) : 0;
+    if (pipelineCut != 0)
+    {
+        // the helper thread is busy with the first stage for the whole period.
+        this->parallelSplitsEnabled = false;
+        outputs = PreparePipeline(pedalboard.items(), pipelineCut, errorList, existingEffects);
+        Lv2Log::debug(SS("Pipelined pedalboard: the second stage starts at item " << pipelineCut << "."));
+    }
+    else
+    {
+        outputs = PrepareItems(pedalboard.items(), this->pedalboardInputBuffers, errorList, existingEffects);
+    }
+    createdEffects.clear();
+    Lv2Log::debug(SS("Pedalboard uses " << audioBufferCount << " audio buffers for " << realtimeEffects.size() << " effects."));
+    if (monoModeEffectCount != 0)
+    {
+        Lv2Log::debug(SS(monoModeEffectCount << " dual-mode plugin(s) running mono. Estimated saving: "
+                                             << (monoModeSavedLoad * 100) << "% of the period."));
+    }
+    // a mono chain feeds every output; a stereo chain feeds each pair of outputs.
+    for (int i = 0; i < outputChannels; ++i)
+    {
+        this->pedalboardOutputBuffers.push_back(outputs[i % outputs.size()]);
+    }
+    this->subBlockInputs.resize(this->pedalboardInputBuffers.size() + 1);
+    this->subBlockOutputs.resize(this->pedalboardOutputBuffers.size() + 1);
+    if (pipelineCut == 0)
+    {
+        PrepareDriverBufferSites(pedalboard.items(), outputs);
+    }
+    this->volumeInputBuffers = this->pedalboardInputBuffers;
+    this->volumeOutputBuffers = this->pedalboardOutputBuffers;
+    PrepareMidiMap(pedalboard);
+    for (IEffect *effect : this->realtimeEffects)
+    {
+        if (effect->IsLv2Effect() && ((Lv2Effect *)effect)->HasMidiOutput())
+        {
+            this->midiOutputEffects.push_back((Lv2Effect *)effect);
+        }
+        if (effect->IsLv2Effect() && ((Lv2Effect *)effect)->HasMidiInput())
+        {
+            this->midiInputEffects.push_back((Lv2Effect *)effect);
+        }
+    }
+    this->pendingPathProperties.Reserve(this->pathPropertyTaps.size());
+
+    this->processPlan.Seal();
+    for (auto &parallelSplit : this->parallelSplits)
+    {
+        parallelSplit->helperPlan.Seal();
+    }
+    if (this->parallelSplits.size() != 0)
+    {
+        this->helperThread = RealtimeHelperThread::Create(RealtimeHelperThread::DefaultHelperCpu());
+    }
+    Lv2Log::debug(SS("Pedalboard realtime arena: " << realtimeArena->BytesAllocated() << " bytes in use, "
+                                                   << realtimeArena->BytesReserved() << " bytes reserved"
+                                                   << (realtimeArena->UsesHugePages() ? " (hugepages)." : ".")));
+}
+
+void Lv2Pedalboard::PrepareDriverBufferSites(const std::vector<PedalboardItem> &items, const std::vector<float *> &outputs)
+{
+    const PedalboardItem *firstItem = nullptr;
+    const PedalboardItem *lastItem = nullptr;
+    for (const auto &item : items)
+    {
+        if (!item.isEmpty())
+        {
+            if (!firstItem)
+            {
+                firstItem = &item;
+            }
+            lastItem = &item;
+        }
+    }
+    if (!firstItem)
+    {
+        return;
+    }
+    // the input side: the first effect's inputs must be the only readers of the pedalboard's input buffers.
+    IEffect *first = firstItem->isSplit() ? nullptr : GetEffect(firstItem->instanceId());
+    if (first && first->IsLv2Effect() && !HasPedalboardInputSidechain(items))
+    {
+        Lv2Effect *effect = (Lv2Effect *)first;
+        bool inPlace = false;
+        for (int i = 0; i < effect->GetNumberOfOutputAudioBuffers(); ++i)
+        {
+            for (int j = 0; j < effect->GetNumberOfInputAudioBuffers(); ++j)
+            {
+                inPlace |= effect->GetAudioOutputBuffer(i) == effect->GetAudioInputBuffer(j);
+            }
+        }
+        for (int i = 0; !inPlace && i < effect->GetNumberOfInputAudioBuffers(); ++i)
+        {
+            for (size_t c = 0; c < this->pedalboardInputBuffers.size(); ++c)
+            {
+                if (effect->GetAudioInputBuffer(i) == this->pedalboardInputBuffers[c])
+                {
+                    this->driverInputSites.push_back({effect, i, c, this->pedalboardInputBuffers[c]});
+                }
+            }
+        }
+    }
+    // the output side: each output channel must be a distinct output of the last effect.
+    IEffect *last = lastItem->isSplit() ? nullptr : GetEffect(lastItem->instanceId());
+    if (last && last->IsLv2Effect() && !this->sidechainSourceIds.contains(lastItem->instanceId()) && outputs.size() == this->pedalboardOutputBuffers.size())
+    {
+        Lv2Effect *effect = (Lv2Effect *)last;
+        std::vector<DriverBufferSite> sites;
+        for (size_t c = 0; c < outputs.size(); ++c)
+        {
+            for (int i = 0; i < effect->GetNumberOfOutputAudioBuffers(); ++i)
+            {
+                if (effect->GetAudioOutputBuffer(i) == outputs[c])
+                {
+                    sites.push_back({effect, i, c, outputs[c]});
+                    break;
+                }
+            }
+        }
+        bool usable = sites.size() == outputs.size() && effect->GetNumberOfInputAudioBuffers() != 0;
+        for (size_t i = 0; usable && i < sites.size(); ++i)
+        {
+            for (size_t j = 0; j < i; ++j)
+            {
+                usable &= sites[i].pedalboardBuffer != sites[j].pedalboardBuffer;
+            }
+            for (int j = 0; j < effect->GetNumberOfInputAudioBuffers(); ++j)
+            {
+                usable &= sites[i].pedalboardBuffer != effect->GetAudioInputBuffer(j);
+            }
+        }
+        if (usable)
+        {
+            this->driverOutputSites = std::move(sites);
+        }
+    }
+    if (driverInputSites.size() != 0 || driverOutputSites.size() != 0)
+    {
+        Lv2Log::debug(SS("Driver buffers bound directly to " << driverInputSites.size() << " effect input(s) and "
+                                                             << driverOutputSites.size() << " effect output(s) at unity volume."));
+    }
+}
+
+size_t Lv2Pedalboard::BindDriverBuffers(std::vector<DriverBufferSite> &sites, bool inputSites, float *const *driverBuffers, bool bindDriverBuffers)
+{
+    size_t bound = 0;
+    for (auto &site : sites)
+    {
+        float *target = bindDriverBuffers ? driverBuffers[site.channel] : site.pedalboardBuffer;
+        float *current = inputSites ? site.effect->GetAudioInputBuffer(site.bufferIndex) : site.effect->GetAudioOutputBuffer(site.bufferIndex);
+        if (current != target)
+        {
+            bool rebound = inputSites ? site.effect->RebindAudioInputBuffer(this, site.bufferIndex, target)
+                                      : site.effect->RebindAudioOutputBuffer(this, site.bufferIndex, target);
+            if (rebound)
+            {
+                current = target;
+            }
+        }
+        if (current == driverBuffers[site.channel])
+        {
+            ++bound;
+        }
+    }
+    return bound;
+}
+
+void Lv2Pedalboard::PrepareMidiMap(const PedalboardItem &pedalboardItem)
+{
+    if (pedalboardItem.midiBindings().size() != 0)
+    {
+        Lv2PluginInfo::ptr pluginInfo;
+        if (pedalboardItem.uri() == SPLIT_PEDALBOARD_ITEM_URI)
+        {
+            pluginInfo = GetSplitterPluginInfo();
+        }
+        else
+        {
+            pluginInfo = pHost->GetPluginInfo(pedalboardItem.uri());
+        }
+
+        int effectIndex = this->GetIndexOfInstanceId(pedalboardItem.instanceId());
+
+        if (pluginInfo && effectIndex != -1)
+        {
+            for (size_t bindingIndex = 0; bindingIndex < pedalboardItem.midiBindings().size(); ++bindingIndex)
+            {
+                auto &binding = pedalboardItem.midiBindings()[bindingIndex];
+                {
+                    const Lv2PortInfo *pPortInfo;
+                    int controlIndex;
+                    if (binding.symbol() == "__bypass")
+                    {
+                        pPortInfo = GetBypassPortInfo();
+                        controlIndex = -1;
+                    }
+                    else
+                    {
+                        try
+                        {
+                            pPortInfo = &pluginInfo->getPort(binding.symbol());
+                            controlIndex = this->GetControlIndex(pedalboardItem.instanceId(), binding.symbol());
+                        }
+                        catch (const std::exception &ignored)
+                        {
+                            continue;
+                        }
+                    }
+
+                    MidiMapping mapping;
+                    mapping.pluginInfo = pluginInfo; // for lifetime management. <shrugs> We're holding internal pointers to this. May save us in a disorderly shutdown.
+                    mapping.pPortInfo = pPortInfo;
+                    mapping.effectIndex = effectIndex;
+                    mapping.controlIndex = controlIndex;
+                    mapping.midiBinding = binding;
+                    mapping.instanceId = pedalboardItem.instanceId();
+
+                    if (pPortInfo->mod_momentaryOffByDefault() || pPortInfo->mod_momentaryOnByDefault())
+                    {
+                        mapping.mappingType = MidiControlType::MomentarySwitch;
+                    }
+                    else if (pPortInfo->trigger_property())
+                    {
+                        mapping.mappingType = MidiControlType::Trigger;
+                    }
+                    else if (pPortInfo->IsSwitch())
+                    {
+                        mapping.mappingType = MidiControlType::Toggle;
+                    }
+                    else if (pPortInfo->enumeration_property())
+                    {
+                        mapping.mappingType = MidiControlType::Select;
+                    }
+                    else
+                    {
+                        mapping.mappingType = MidiControlType::Dial;
+                    }
+                    if (binding.bindingType() == BINDING_TYPE_NOTE)
+                    {
+                        midiDispatchTable.Add(MidiDispatchTable::MessageType::Note, binding.channel(), (uint8_t)binding.note(), (uint16_t)midiMappings.size());
+                        midiMappings.push_back(std::move(mapping));
+                    }
+                    else if (binding.bindingType() == BINDING_TYPE_CONTROL)
+                    {
+                        midiDispatchTable.Add(MidiDispatchTable::MessageType::Control, binding.channel(), (uint8_t)binding.control(), (uint16_t)midiMappings.size());
+                        midiMappings.push_back(std::move(mapping));
+                    }
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < pedalboardItem.topChain().size(); ++i)
+    {
+        PrepareMidiMap(pedalboardItem.topChain()[i]);
+    }
+    for (size_t i = 0; i < pedalboardItem.bottomChain().size(); ++i)
+    {
+        PrepareMidiMap(pedalboardItem.bottomChain()[i]);
+    }
+}
+void Lv2Pedalboard::PrepareMidiMap(const Pedalboard &pedalboard)
+{
+    for (size_t i = 0; i < pedalboard.items().size(); ++i)
+    {
+        auto &item = pedalboard.items()[i];
+        PrepareMidiMap(item);
+    }
+    midiDispatchTable.Build();
+}
+
+void Lv2Pedalboard::UpdateAudioPorts()
+{
+    for (int i = 0; i < this->effects.size(); ++i)
+    {
+        IEffect *effect = this->realtimeEffects[i];
+        if (effect->IsLv2Effect())
+        {
+            Lv2Effect *lv2Effect = (Lv2Effect *)effect;
+            lv2Effect->UpdateAudioPorts();
+        }
+    }
+}
+
+void Lv2Pedalboard::Activate()
+{
+    CrashGuardLock crashGuardLock;
+
+    for (int i = 0; i < this->effects.size(); ++i)
+    {
+        this->realtimeEffects[i]->Activate();
+    }
+}
+void Lv2Pedalboard::Deactivate()
+{
+    for (int i = 0; i < this->effects.size(); ++i)
+    {
+        this->realtimeEffects[i]->Deactivate();
+    }
+}
+
+static void Copy(float *restrict input, float *restrict output, uint32_t samples)
+{
+    for (uint32_t i = 0; i < samples; ++i)
+    {
+        output[i] = input[i];
+    }
+}
+bool Lv2Pedalboard::Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *ringBufferWriter, RealtimeEffectTimings *effectTimings)
+{
+    this->ringBufferWriter = ringBufferWriter;
+    this->effectTimings = effectTimings;
+    for (size_t i = 0; i < this->pedalboardInputBuffers.size(); ++i)
+    {
+        if (inputBuffers[i] == nullptr)
+        {
+            return false;
+        }
+    }
+
+    if (this->controlRampCount != 0)
+    {
+        AdvanceControlRamps(samples);
+    }
+    size_t nInputs = this->pedalboardInputBuffers.size();
+    size_t nOutputs = this->pedalboardOutputBuffers.size();
+    bool inputsBound = false;
+    if (this->driverInputSites.size() != 0)
+    {
+        bool bind = this->inputVolume.IsUnity();
+        inputsBound = BindDriverBuffers(this->driverInputSites, true, inputBuffers, bind) == this->driverInputSites.size() && bind;
+        for (size_t i = 0; i < nInputs; ++i)
+        {
+            this->volumeInputBuffers[i] = inputsBound ? inputBuffers[i] : this->pedalboardInputBuffers[i];
+        }
+    }
+    if (!inputsBound)
+    {
+        this->inputVolume.Apply(inputBuffers, this->pedalboardInputBuffers.data(), nInputs, samples);
+    }
+    if (this->driverOutputSites.size() != 0)
+    {
+        // the driver's outputs are only usable if they are distinct, and distinct from its inputs.
+        bool bind = this->outputVolume.IsUnity();
+        for (size_t i = 0; bind && i < nOutputs; ++i)
+        {
+            for (size_t j = 0; j < i; ++j)
+            {
+                bind &= outputBuffers[i] != outputBuffers[j];
+            }
+            for (size_t j = 0; j < nInputs; ++j)
+            {
+                bind &= outputBuffers[i] != inputBuffers[j];
+            }
+        }
+        BindDriverBuffers(this->driverOutputSites, false, outputBuffers, bind);
+        // (a site the pedalboard no longer owns may still be bound to the driver: the volume is applied in place there.)
+        for (auto &site : this->driverOutputSites)
+        {
+            this->volumeOutputBuffers[site.channel] = site.effect->GetAudioOutputBuffer(site.bufferIndex) == outputBuffers[site.channel]
+                                                          ? outputBuffers[site.channel]
+                                                          : site.pedalboardBuffer;
+        }
+    }
+    this->processPlan.Execute(samples, ringBufferWriter, effectTimings);
     for (size_t i = 0; i < this->effects.size(); ++i)
     {
         IEffect *effect = effects[i].get();
-        if (effect->HasErrorMessage())
+        // (no writer on realtime helper threads.)
+        if (ringBufferWriter != nullptr && effect->HasErrorMessage())
         {
             ringBufferWriter->WriteLv2ErrorMessage(effect->GetInstanceId(), effect->TakeErrorMessage());
         }
     }
-    for (size_t i = 0; i < samples; ++i)
+    // (in place, and so a no-op at unity, for outputs the last effect wrote to directly.)
+    this->outputVolume.Apply(this->volumeOutputBuffers.data(), outputBuffers, nOutputs, samples);
+    return true;
+}
+
+bool Lv2Pedalboard::RunSubBlocks(
+    float **inputBuffers, float **outputBuffers, uint32_t samples, uint32_t subBlockFrames,
+    void *handle, SubBlockFn *pfnSubBlock,
+    RealtimeRingBufferWriter *ringBufferWriter, RealtimeEffectTimings *effectTimings)
+{
+    size_t nInputs = this->pedalboardInputBuffers.size();
+    size_t nOutputs = this->pedalboardOutputBuffers.size();
+    bool inputsValid = true;
+    for (size_t i = 0; i < nInputs; ++i)
+    {
+        if (inputBuffers[i] == nullptr)
+        {
+            inputsValid = false;
+            break;
+        }
+    }
+    if (subBlockFrames == 0 || subBlockFrames >= samples || !inputsValid || hasUnstagedBlockLengthRequirements)
+    {
+        pfnSubBlock(handle, 0, samples);
+        return Run(inputBuffers, outputBuffers, samples, ringBufferWriter, effectTimings);
+    }
+    float **subInputs = this->subBlockInputs.data();
+    float **subOutputs = this->subBlockOutputs.data();
+    subInputs[nInputs] = nullptr;
+    subOutputs[nOutputs] = nullptr;
+
+    for (uint32_t offset = 0; offset < samples; offset += subBlockFrames)
     {
-        float volume = outputVolume.Tick();
-        for (size_t c = 0; c < this->pedalboardOutputBuffers.size(); ++c)
+        uint32_t frames = std::min(subBlockFrames, samples - offset);
+        for (size_t i = 0; i < nInputs; ++i)
+        {
+            subInputs[i] = inputBuffers[i] + offset;
+        }
+        for (size_t i = 0; i < nOutputs; ++i)
         {
-            outputBuffers[c][i] = this->pedalboardOutputBuffers[c][i] * volume;
+            subOutputs[i] = outputBuffers[i] + offset;
+        }
+        pfnSubBlock(handle, offset, frames);
+        if (!Run(subInputs, subOutputs, frames, ringBufferWriter, effectTimings))
+        {
+            return false;
         }
     }
     return true;
@@ -550,17 +1458,207 @@ float Lv2Pedalboard::GetControlOutputValue(int effectIndex, int portIndex)
 
 void Lv2Pedalboard::SetControlValue(int effectIndex, int index, float value)
 {
+    if (this->controlRampCount != 0)
+    {
+        CancelControlRamp(effectIndex, index);
+    }
     auto effect = realtimeEffects[effectIndex];
     effect->SetControl(index, value);
 }
+
+void Lv2Pedalboard::CancelControlRamp(int effectIndex, int portIndex)
+{
+    for (size_t i = 0; i < controlRampCount; ++i)
+    {
+        if (controlRamps[i].effectIndex == effectIndex && controlRamps[i].portIndex == portIndex)
+        {
+            controlRamps[i] = controlRamps[--controlRampCount];
+            return;
+        }
+    }
+}
+
+void Lv2Pedalboard::RampControlValue(int effectIndex, int portIndex, float value, uint32_t frames)
+{
+    if (this->controlRampCount != 0)
+    {
+        CancelControlRamp(effectIndex, portIndex);
+    }
+    IEffect *effect = realtimeEffects[effectIndex];
+    float currentValue = effect->GetControlValue(portIndex);
+    if (frames == 0 || currentValue == value || controlRampCount == MAX_CONTROL_RAMPS)
+    {
+        effect->SetControl(portIndex, value);
+        return;
+    }
+    ControlRamp &ramp = controlRamps[controlRampCount++];
+    ramp.effectIndex = effectIndex;
+    ramp.portIndex = portIndex;
+    ramp.value = currentValue;
+    ramp.increment = (value - currentValue) / frames;
+    ramp.target = value;
+    ramp.framesRemaining = frames;
+}
+
+void Lv2Pedalboard::AdvanceControlRamps(uint32_t samples)
+{
+    size_t i = 0;
+    while (i < controlRampCount)
+    {
+        ControlRamp &ramp = controlRamps[i];
+        IEffect *effect = realtimeEffects[ramp.effectIndex];
+        if (ramp.framesRemaining <= samples)
+        {
+            effect->SetControl(ramp.portIndex, ramp.target);
+            ramp = controlRamps[--controlRampCount];
+        }
+        else
+        {
+            ramp.framesRemaining -= samples;
+            ramp.value += ramp.increment * samples;
+            effect->SetControl(ramp.portIndex, ramp.value);
+            ++i;
+        }
+    }
+}
 void Lv2Pedalboard::SetBypass(int effectIndex, bool enabled)
 {
     auto effect = realtimeEffects[effectIndex];
     effect->SetBypass(enabled);
 }
 
+namespace
+{
+    // Per-period peak values, keyed by buffer, so that a buffer that feeds more than one meter
+    // (e.g. the pedalboard output, when the output volume is at 0dB) only gets measured once.
+    class VuPeakCache
+    {
+    public:
+        VuPeakCache(uint32_t samples) : samples(samples) {}
+
+        float Peak(const float *buffer)
+        {
+            float result;
+            if (Find(buffer, &result))
+            {
+                return result;
+            }
+            result = 0;
+            VuAbsMax(buffer, samples, &result);
+            Add(buffer, result);
+            return result;
+        }
+        void Peak(const float *bufferL, const float *bufferR, float *peakL, float *peakR)
+        {
+            bool haveL = Find(bufferL, peakL);
+            bool haveR = Find(bufferR, peakR);
+            if (!haveL && !haveR && bufferL != bufferR)
+            {
+                *peakL = 0;
+                *peakR = 0;
+                VuAbsMaxStereo(bufferL, bufferR, samples, peakL, peakR);
+                Add(bufferL, *peakL);
+                Add(bufferR, *peakR);
+                return;
+            }
+            if (!haveL)
+            {
+                *peakL = Peak(bufferL);
+            }
+            if (!haveR)
+            {
+                *peakR = Peak(bufferR);
+            }
+        }
+
+    private:
+        bool Find(const float *buffer, float *peak)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (buffers[i] == buffer)
+                {
+                    *peak = peaks[i];
+                    return true;
+                }
+            }
+            return false;
+        }
+        void Add(const float *buffer, float peak)
+        {
+            if (count < MAX_ENTRIES) // if full, just measure again.
+            {
+                buffers[count] = buffer;
+                peaks[count] = peak;
+                ++count;
+            }
+        }
+        static constexpr size_t MAX_ENTRIES = 64;
+        uint32_t samples;
+        size_t count = 0;
+        const float *buffers[MAX_ENTRIES];
+        float peaks[MAX_ENTRIES];
+    };
+}
+
+static void MeasurePeaks(IEffect *effect, bool output, uint32_t frames, int *channels, float *peakL, float *peakR)
+{
+    int n = output ? effect->GetNumberOfOutputAudioBuffers() : effect->GetNumberOfInputAudioBuffers();
+    *peakL = *peakR = 0;
+    if (n == 1)
+    {
+        VuAbsMax(output ? effect->GetAudioOutputBuffer(0) : effect->GetAudioInputBuffer(0), frames, peakL);
+    }
+    else if (n >= 2)
+    {
+        if (output)
+        {
+            VuAbsMaxStereo(effect->GetAudioOutputBuffer(0), effect->GetAudioOutputBuffer(1), frames, peakL, peakR);
+        }
+        else
+        {
+            VuAbsMaxStereo(effect->GetAudioInputBuffer(0), effect->GetAudioInputBuffer(1), frames, peakL, peakR);
+        }
+    }
+    *channels = n;
+}
+
+void Lv2Pedalboard::MeasureInputVu(void *data, uint32_t frames)
+{
+    VuTap *tap = (VuTap *)data;
+    if (!tap->enabled)
+    {
+        tap->inputChannels = 0;
+        return;
+    }
+    MeasurePeaks(tap->effect, false, frames, &tap->inputChannels, &tap->inputPeakL, &tap->inputPeakR);
+}
+
+void Lv2Pedalboard::MeasureOutputVu(void *data, uint32_t frames)
+{
+    VuTap *tap = (VuTap *)data;
+    if (!tap->enabled)
+    {
+        tap->inputChannels = tap->outputChannels = 0;
+        return;
+    }
+    if (!tap->inPlace)
+    {
+        MeasurePeaks(tap->effect, false, frames, &tap->inputChannels, &tap->inputPeakL, &tap->inputPeakR);
+    }
+    MeasurePeaks(tap->effect, true, frames, &tap->outputChannels, &tap->outputPeakL, &tap->outputPeakR);
+}
+
 void Lv2Pedalboard::ComputeVus(RealtimeVuBuffers *vuConfiguration, uint32_t samples, float **inputBuffers, float **outputBuffers)
 {
+    VuPeakCache peakCache(samples);
+    float peakL, peakR;
+
+    for (auto &tap : this->vuTaps)
+    {
+        tap->enabled = false;
+    }
+
     for (size_t i = 0; i < vuConfiguration->enabledIndexes.size(); ++i)
     {
         int index = vuConfiguration->enabledIndexes[i];
@@ -570,52 +1668,54 @@ void Lv2Pedalboard::ComputeVus(RealtimeVuBuffers *vuConfiguration, uint32_t samp
             if (this->pedalboardInputBuffers.size() > 1)
             {
                 GetInputBuffers();
-                pUpdate->AccumulateInputs(inputBuffers[0], inputBuffers[1], samples);
-                pUpdate->AccumulateOutputs(&(this->pedalboardInputBuffers[0][0]), &(this->pedalboardInputBuffers[1][0]), samples); // after outputVolume applied.
+                peakCache.Peak(inputBuffers[0], inputBuffers[1], &peakL, &peakR);
+                pUpdate->AccumulateInputPeaks(peakL, peakR);
+                peakCache.Peak(this->volumeInputBuffers[0], this->volumeInputBuffers[1], &peakL, &peakR); // after input volume applied.
+                pUpdate->AccumulateOutputPeaks(peakL, peakR);
             }
             else
             {
-                pUpdate->AccumulateInputs(inputBuffers[0], samples);
-                pUpdate->AccumulateOutputs(&(this->pedalboardInputBuffers[0][0]), samples); // after input volume applied.
+                pUpdate->AccumulateInputPeaks(peakCache.Peak(inputBuffers[0]));
+                pUpdate->AccumulateOutputPeaks(peakCache.Peak(this->volumeInputBuffers[0])); // after input volume applied.
             }
         }
         else if (index == Pedalboard::OUTPUT_VOLUME_ID)
         {
             if (this->pedalboardOutputBuffers.size() > 1)
             {
-                pUpdate->AccumulateInputs(&(this->pedalboardOutputBuffers[0][0]), &(this->pedalboardOutputBuffers[1][0]), samples);
-                pUpdate->AccumulateOutputs(outputBuffers[0], outputBuffers[1], samples);
+                peakCache.Peak(this->volumeOutputBuffers[0], this->volumeOutputBuffers[1], &peakL, &peakR);
+                pUpdate->AccumulateInputPeaks(peakL, peakR);
+                peakCache.Peak(outputBuffers[0], outputBuffers[1], &peakL, &peakR);
+                pUpdate->AccumulateOutputPeaks(peakL, peakR);
             }
             else
             {
-                pUpdate->AccumulateInputs(&(this->pedalboardOutputBuffers[0][0]), samples);
-                pUpdate->AccumulateOutputs(outputBuffers[0], samples);
+                pUpdate->AccumulateInputPeaks(peakCache.Peak(this->volumeOutputBuffers[0]));
+                pUpdate->AccumulateOutputPeaks(peakCache.Peak(outputBuffers[0]));
             }
         }
         else
         {
-            auto effect = this->realtimeEffects[index];
+            // measured by the plan, as it ran. (Taps that have just been enabled have nothing to report until the next period.)
+            VuTap *tap = this->vuTaps[index].get();
+            tap->enabled = true;
+            pUpdate->isIdle_ = tap->silenceGate && tap->silenceGate->IsIdle();
 
-            if (effect->GetNumberOfInputAudioBuffers() == 1)
+            if (tap->inputChannels == 1)
             {
-                pUpdate->AccumulateInputs(effect->GetAudioInputBuffer(0), samples);
+                pUpdate->AccumulateInputPeaks(tap->inputPeakL);
             }
-            else if (effect->GetNumberOfInputAudioBuffers() >= 2)
+            else if (tap->inputChannels >= 2)
             {
-                pUpdate->AccumulateInputs(
-                    effect->GetAudioInputBuffer(0),
-                    effect->GetAudioInputBuffer(1), samples);
+                pUpdate->AccumulateInputPeaks(tap->inputPeakL, tap->inputPeakR);
             }
-            if (effect->GetNumberOfOutputAudioBuffers() == 1)
+            if (tap->outputChannels == 1)
             {
-                pUpdate->AccumulateOutputs(effect->GetAudioOutputBuffer(0), samples);
+                pUpdate->AccumulateOutputPeaks(tap->outputPeakL);
             }
-            else if (effect->GetNumberOfOutputAudioBuffers() >= 2)
+            else if (tap->outputChannels >= 2)
             {
-                pUpdate->AccumulateOutputs(
-                    effect->GetAudioOutputBuffer(0),
-                    effect->GetAudioOutputBuffer(1),
-                    samples);
+                pUpdate->AccumulateOutputPeaks(tap->outputPeakL, tap->outputPeakR);
             }
         }
     }
@@ -630,22 +1730,36 @@ void Lv2Pedalboard::ResetAtomBuffers()
     }
 }
 
-void Lv2Pedalboard::GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter)
+void Lv2Pedalboard::CheckPathPropertyOutput(void *data, uint32_t frames)
 {
-    for (auto &pEffect : this->effects)
+    // runs on the thread that ran the effect.
+    PathPropertyTap *tap = (PathPropertyTap *)data;
+    if (!tap->pedalboard->pendingPathProperties.IsPending(tap->index) && tap->effect->HasPatchSetOutput())
     {
-        if (pEffect->IsLv2Effect())
+        tap->pedalboard->pendingPathProperties.Add(tap->index);
+    }
+}
+
+void Lv2Pedalboard::GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter)
+{
+    // all helper threads have finished by the time this is called.
+    this->pendingPathProperties.Visit(
+        [this, cbPatchWriter](size_t index)
         {
-            Lv2Effect *pLv2Effect = (Lv2Effect *)pEffect.get();
+            Lv2Effect *pLv2Effect = this->pathPropertyTaps[index]->effect;
             pLv2Effect->GatherPathPatchProperties(cbPatchWriter);
-        }
-    }
+            // an update that couldn't be delivered yet stays pending.
+            return pLv2Effect->HasPendingPathPropertyWrites();
+        });
 }
 
-void Lv2Pedalboard::ProcessParameterRequests(RealtimePatchPropertyRequest *pParameterRequests, size_t samplesThisTime)
+RealtimePatchPropertyRequest *Lv2Pedalboard::ProcessParameterRequests(RealtimePatchPropertyRequest *pParameterRequests, size_t samplesThisTime)
 {
+    RealtimePatchPropertyRequest *pActiveRequests = nullptr;
     while (pParameterRequests != nullptr)
     {
+        pParameterRequests->pEffect = nullptr;
+        pParameterRequests->pNextActive = nullptr;
         pParameterRequests->sampleTimeout -= samplesThisTime;
         IEffect *pEffect = this->GetEffect(pParameterRequests->instanceId);
 
@@ -671,6 +1785,9 @@ void Lv2Pedalboard::ProcessParameterRequests(RealtimePatchPropertyRequest *pPara
                 if (pParameterRequests->requestType == RealtimePatchPropertyRequest::RequestType::PatchGet)
                 {
                     pLv2Effect->RequestPatchProperty(pParameterRequests->uridUri);
+                    pParameterRequests->pEffect = pLv2Effect;
+                    pParameterRequests->pNextActive = pActiveRequests;
+                    pActiveRequests = pParameterRequests;
                 }
                 else if (pParameterRequests->requestType == RealtimePatchPropertyRequest::RequestType::PatchSet)
                 {
@@ -684,34 +1801,19 @@ void Lv2Pedalboard::ProcessParameterRequests(RealtimePatchPropertyRequest *pPara
         }
         pParameterRequests = pParameterRequests->pNext;
     }
+    return pActiveRequests;
 }
 
-void Lv2Pedalboard::GatherPatchProperties(RealtimePatchPropertyRequest *pParameterRequests)
+void Lv2Pedalboard::GatherPatchProperties(RealtimePatchPropertyRequest *pActiveRequests)
 {
-    while (pParameterRequests != nullptr)
+    // Only requests whose effects exist (resolved by ProcessParameterRequests in the same period).
+    while (pActiveRequests != nullptr)
     {
-        if (pParameterRequests->requestType == RealtimePatchPropertyRequest::RequestType::PatchGet)
+        if (pActiveRequests->GetSize() == 0 && pActiveRequests->errorMessage == nullptr)
         {
-            IEffect *effect = this->GetEffect(pParameterRequests->instanceId);
-            if (effect == nullptr)
-            {
-                pParameterRequests->errorMessage = "No such effect.";
-            }
-            else if (effect->IsVst3())
-            {
-                pParameterRequests->errorMessage = "Not supported for VST3";
-            }
-            else
-            {
-                if (effect->IsLv2Effect())
-                {
-                    Lv2Effect *pLv2Effect = dynamic_cast<Lv2Effect *>(effect);
-                    pLv2Effect->GatherPatchProperties(pParameterRequests);
-                }
-            }
+            pActiveRequests->pEffect->GatherPatchProperties(pActiveRequests);
         }
-
-        pParameterRequests = pParameterRequests->pNext;
+        pActiveRequests = pActiveRequests->pNextActive;
     }
 }
 
@@ -720,205 +1822,219 @@ void Lv2Pedalboard::OnMidiMessage(size_t size, uint8_t *message,
                                   MidiCallbackFn *pfnCallback)
 
 {
-    if (midiMappings.size() == 0)
-        return;
-
-    if (size < 2)
+    auto targets = midiDispatchTable.Find(message, size);
+    if (targets.empty())
         return;
-    uint8_t cmd = message[0];
-    uint8_t channel = cmd & 0x0F;
-    cmd &= 0xF0;
 
+    uint8_t cmd = message[0] & 0xF0;
     uint8_t value;
-    uint8_t index;
     if (cmd == 0x80) // note off.
     {
-        index = message[1];
-        cmd = 0x90;
-        index = message[1];
         value = 0;
     }
     else if (cmd == 0x90) // note on.
     {
         if (size < 3)
             return;
-        index = message[1];
         value = message[2] == 0 ? 0 : 127; // zero velocity = note off.
     }
-    else if (cmd == 0xB0) // midi control.
+    else // midi control.
     {
-        if (size < 3)
-            return;
-        index = message[1];
         value = message[2] & 0x7F;
     }
-    int searchKey = (cmd << 8) | index;
-    int min = 0;
-    int max = midiMappings.size() - 1;
-    while (max > min)
+    float range = value / 127.0;
+
+    for (uint16_t target : targets)
     {
-        int mid = (min + max) / 2;
-        if (midiMappings[mid].key < searchKey)
-        {
-            min = mid + 1;
-        }
-        else if (midiMappings[mid].key > searchKey)
+        auto &mapping = midiMappings[target];
+        switch (mapping.mappingType)
         {
-            max = mid - 1;
-        }
-        else
+        case MidiControlType::Trigger:
         {
-            if (mid == 0)
-            {
-                min = max = mid;
-            }
-            else
+            bool triggered = false;
+            if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TRIGGER_ON_RISING_EDGE || mapping.midiBinding.bindingType() == BINDING_TYPE_NOTE)
             {
-                if (midiMappings[mid - 1].key == searchKey)
+                if (mapping.lastValue < range)
                 {
-                    max = mid - 1;
+                    if (!mapping.lastValueIncreasing)
+                    {
+                        triggered = true;
+                    }
+                    mapping.lastValueIncreasing = true;
+                    mapping.lastValue = range;
                 }
                 else
                 {
-                    min = max = mid;
+                    mapping.lastValueIncreasing = false;
+                    mapping.lastValue = range;
+                }
+            }
+            else
+            {
+                triggered = true;
+            }
+            if (triggered)
+            {
+                IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
+                float value = mapping.pPortInfo->max_value();
+                if (value == mapping.pPortInfo->default_value())
+                {
+                    value = mapping.pPortInfo->min_value();
                 }
+                this->SetControlValue(mapping.effectIndex, mapping.controlIndex, value);
+                // do NOT notify anyone!
             }
+            break;
         }
-    }
-    if (midiMappings[min].key == searchKey)
-    {
-        float range = value / 127.0;
-
-        for (int i = min; i < midiMappings.size(); ++i)
+        case MidiControlType::Toggle:
         {
-            auto &mapping = midiMappings[i];
-            if (mapping.key != searchKey)
-                break;
+            bool triggered = false;
+
+            range = std::round(range);
 
-            if (mapping.midiBinding.channel() == -1 || mapping.midiBinding.channel() == channel)
+            if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TOGGLE_ON_RISING_EDGE)
             {
-                switch (mapping.mappingType)
+                if (range > mapping.lastValue)
                 {
-                case MidiControlType::Trigger:
-                {
-                    bool triggered = false;
-                    if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TRIGGER_ON_RISING_EDGE || mapping.midiBinding.bindingType() == BINDING_TYPE_NOTE)
-                    {
-                        if (mapping.lastValue < range)
-                        {
-                            if (!mapping.lastValueIncreasing)
-                            {
-                                triggered = true;
-                            }
-                            mapping.lastValueIncreasing = true;
-                            mapping.lastValue = range;
-                        }
-                        else
-                        {
-                            mapping.lastValueIncreasing = false;
-                            mapping.lastValue = range;
-                        }
-                    }
-                    else
+                    if (!mapping.lastValueIncreasing)
                     {
                         triggered = true;
                     }
-                    if (triggered)
-                    {
-                        IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                        float value = mapping.pPortInfo->max_value();
-                        if (value == mapping.pPortInfo->default_value())
-                        {
-                            value = mapping.pPortInfo->min_value();
-                        }
-                        this->SetControlValue(mapping.effectIndex, mapping.controlIndex, value);
-                        // do NOT notify anyone!
-                    }
-                    break;
+                    mapping.lastValueIncreasing = true;
+                    mapping.lastValue = range;
                 }
-                case MidiControlType::Toggle:
+                else
                 {
-                    bool triggered = false;
-
-                    range = std::round(range);
-
-                    if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TOGGLE_ON_RISING_EDGE)
-                    {
-                        if (range > mapping.lastValue)
-                        {
-                            if (!mapping.lastValueIncreasing)
-                            {
-                                triggered = true;
-                            }
-                            mapping.lastValueIncreasing = true;
-                            mapping.lastValue = range;
-                        }
-                        else
-                        {
-                            mapping.lastValueIncreasing = false;
-                            mapping.lastValue = range;
-                        }
-                        if (triggered)
-                        {
-                            IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                            float currentValue = pEffect->GetControlValue(mapping.controlIndex);
-
-                            currentValue = currentValue == 0 ? 1 : 0;
-                            pEffect->SetControl(mapping.controlIndex, currentValue);
-                            pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
-                        }
-                    }
-                    else if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TOGGLE_ON_VALUE)
-                    {
-                        triggered = true;
-                        mapping.lastValue = range;
-                        IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                        float currentValue = pEffect->GetControlValue(mapping.controlIndex);
-                        if (currentValue != range)
-                        {
-                            pEffect->SetControl(mapping.controlIndex, range);
-                            pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), range);
-                        }
-                    }
-                    else
-                    {
-                        // any control value toggles.
-                        triggered = true;
-                        mapping.lastValue = range;
-                        IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                        float currentValue = pEffect->GetControlValue(mapping.controlIndex);
-                        currentValue = currentValue == 0 ? 1 : 0;
-                        pEffect->SetControl(mapping.controlIndex, currentValue);
-                        pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
-                    }
-                    break;
+                    mapping.lastValueIncreasing = false;
+                    mapping.lastValue = range;
                 }
-                case MidiControlType::MomentarySwitch:
+                if (triggered)
                 {
                     IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                    pEffect->SetControl(mapping.controlIndex, range != 0 ? mapping.pPortInfo->max_value() : mapping.pPortInfo->min_value());
-                    // do NOT notify anyone!
-                }
-                break;
+                    float currentValue = pEffect->GetControlValue(mapping.controlIndex);
 
-                case MidiControlType::Select:
-                case MidiControlType::Dial:
-                {
-                    IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
-                    float range = mapping.midiBinding.calculateRange(value);
-                    float currentValue = mapping.pPortInfo->rangeToValue(range);
-                    if (pEffect->GetControlValue(mapping.controlIndex) != currentValue)
-                    {
-                        this->SetControlValue(mapping.effectIndex, mapping.controlIndex, currentValue);
-                        pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
-                    }
-                    break;
+                    currentValue = currentValue == 0 ? 1 : 0;
+                    pEffect->SetControl(mapping.controlIndex, currentValue);
+                    pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
                 }
-                case MidiControlType::None:
-                default:
-                    break;
+            }
+            else if (mapping.midiBinding.switchControlType() == SwitchControlTypeT::TOGGLE_ON_VALUE)
+            {
+                triggered = true;
+                mapping.lastValue = range;
+                IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
+                float currentValue = pEffect->GetControlValue(mapping.controlIndex);
+                if (currentValue != range)
+                {
+                    pEffect->SetControl(mapping.controlIndex, range);
+                    pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), range);
                 }
             }
+            else
+            {
+                // any control value toggles.
+                triggered = true;
+                mapping.lastValue = range;
+                IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
+                float currentValue = pEffect->GetControlValue(mapping.controlIndex);
+                currentValue = currentValue == 0 ? 1 : 0;
+                pEffect->SetControl(mapping.controlIndex, currentValue);
+                pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
+            }
+            break;
+        }
+        case MidiControlType::MomentarySwitch:
+        {
+            IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
+            pEffect->SetControl(mapping.controlIndex, range != 0 ? mapping.pPortInfo->max_value() : mapping.pPortInfo->min_value());
+            // do NOT notify anyone!
+        }
+        break;
+
+        case MidiControlType::Select:
+        case MidiControlType::Dial:
+        {
+            IEffect *pEffect = this->realtimeEffects[mapping.effectIndex];
+            float range = mapping.midiBinding.calculateRange(value);
+            float currentValue = mapping.pPortInfo->rangeToValue(range);
+            if (pEffect->GetControlValue(mapping.controlIndex) != currentValue)
+            {
+                this->SetControlValue(mapping.effectIndex, mapping.controlIndex, currentValue);
+                pfnCallback(callbackHandle, mapping.instanceId, mapping.pPortInfo->index(), currentValue);
+            }
+            break;
+        }
+        case MidiControlType::None:
+        default:
+            break;
+        }
+        // the controller already shows the new value.
+        mapping.lastFeedbackValue = GetMidiFeedbackValue(mapping);
+    }
+}
+
+int16_t Lv2Pedalboard::GetMidiFeedbackValue(const MidiMapping &mapping)
+{
+    switch (mapping.mappingType)
+    {
+    case MidiControlType::Toggle:
+    {
+        float value = this->realtimeEffects[mapping.effectIndex]->GetControlValue(mapping.controlIndex);
+        return value != 0 ? 127 : 0;
+    }
+    case MidiControlType::Select:
+    case MidiControlType::Dial:
+    {
+        float value = this->realtimeEffects[mapping.effectIndex]->GetControlValue(mapping.controlIndex);
+        return mapping.midiBinding.calculateControlValue(mapping.pPortInfo->valueToRange(value));
+    }
+    default:
+        return -1; // triggers and momentary switches have no state to show.
+    }
+}
+
+void Lv2Pedalboard::WriteMidiInput(const LV2_Atom_Sequence *events)
+{
+    for (Lv2Effect *effect : this->midiInputEffects)
+    {
+        effect->SetMidiInput(events);
+    }
+}
+
+void Lv2Pedalboard::WriteMidiOutput(void *handle, Lv2Effect::MidiOutputFn *pfnMidiOutput)
+{
+    for (Lv2Effect *effect : this->midiOutputEffects)
+    {
+        effect->WriteMidiOutput(handle, pfnMidiOutput);
+    }
+    for (auto &mapping : this->midiMappings)
+    {
+        int16_t value = GetMidiFeedbackValue(mapping);
+        if (value == mapping.lastFeedbackValue)
+        {
+            continue;
+        }
+        mapping.lastFeedbackValue = value;
+
+        uint8_t channel = mapping.midiBinding.channel() < 0 ? 0 : (uint8_t)(mapping.midiBinding.channel() & 0x0F);
+        uint8_t message[3];
+        if (mapping.midiBinding.bindingType() == BINDING_TYPE_NOTE)
+        {
+            message[0] = 0x90 | channel; // (velocity 0 = note off)
+            message[1] = (uint8_t)(mapping.midiBinding.note() & 0x7F);
         }
+        else
+        {
+            message[0] = 0xB0 | channel;
+            message[1] = (uint8_t)(mapping.midiBinding.control() & 0x7F);
+        }
+        message[2] = (uint8_t)value;
+        pfnMidiOutput(handle, sizeof(message), message);
     }
-}
\ No newline at end of file
+}
+JSON_MAP_BEGIN(ParallelSplitTiming)
+    JSON_MAP_REFERENCE(ParallelSplitTiming,instanceId)
+    JSON_MAP_REFERENCE(ParallelSplitTiming,helperUs)
+    JSON_MAP_REFERENCE(ParallelSplitTiming,audioThreadUs)
+    JSON_MAP_REFERENCE(ParallelSplitTiming,waitUs)
+JSON_MAP_END()
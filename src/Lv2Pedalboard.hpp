@@ -21,11 +21,20 @@
 #include "Pedalboard.hpp"
 #include "PluginHost.hpp"
 #include "Lv2Effect.hpp"
-#include "BufferPool.hpp"
+#include "RealtimeArena.hpp"
 #include <functional>
 #include <lv2/urid/urid.h>
 #include <functional>
 #include "DbDezipper.hpp"
+#include "RealtimeHelperThread.hpp"
+#include "ExecutionPlan.hpp"
+#include "MidiDispatchTable.hpp"
+#include "SilenceGate.hpp"
+#include "PendingIndexList.hpp"
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <set>
 
 namespace pipedal
 {
@@ -34,6 +43,7 @@ namespace pipedal
     class RealtimeVuBuffers;
     class RealtimePatchPropertyRequest;
     class RealtimeRingBufferWriter;
+    class RealtimeEffectTimings;
 
     using ExistingEffectMap = std::map<uint64_t, std::shared_ptr<IEffect>>;
 
@@ -47,6 +57,18 @@ namespace pipedal
     {
     };
 
+    // Smoothed execution times for a split whose chains run in parallel (or for the stages of a pipelined pedalboard).
+    class ParallelSplitTiming
+    {
+    public:
+        int64_t instanceId_ = -1; // -1 for a pipelined pedalboard, whose first stage runs on the helper thread.
+        float helperUs_ = 0;      // top chain, on the realtime helper thread.
+        float audioThreadUs_ = 0; // bottom chain, on the audio thread.
+        float waitUs_ = 0;        // time the audio thread spent waiting for the helper to finish.
+
+        DECLARE_JSON_MAP(ParallelSplitTiming);
+    };
+
     class Lv2Pedalboard
     {
         IHost *pHost = nullptr;
@@ -54,26 +76,158 @@ namespace pipedal
         DbDezipper inputVolume;
         DbDezipper outputVolume;
 
-        BufferPool bufferPool;
+        // Audio buffers are shared between effects whose lifetimes don't overlap: once the last step that
+        // reads a buffer has been prepared, the buffer goes back on freeAudioBuffers for the next effect.
+        // All realtime buffers for the pedalboard and its effects come from this arena.
+        std::shared_ptr<RealtimeArena> realtimeArena;
+        std::set<float *> liveAudioBuffers;
+        std::vector<float *> freeAudioBuffers;
+        std::vector<float *> deferredFreeAudioBuffers; // released by the helper-thread chain of a parallel split.
+        bool deferAudioBufferRelease = false;
+        std::set<int64_t> sidechainSourceIds;
+        std::map<int64_t, size_t> sidechainReaderCounts; // the number of items that read each sidechain source.
+        size_t audioBufferCount = 0;
+
         std::vector<float *> pedalboardInputBuffers;
-        std::vector<float *> pedalboardOutputBuffers;
+        std::vector<float *> pedalboardOutputBuffers; // one per output channel (channels past the chain's repeat its outputs).
+        std::vector<float *> subBlockInputs;          // null-terminated channel tables for RunSubBlocks.
+        std::vector<float *> subBlockOutputs;
         float *pedalboardSidechainBuffer = nullptr;
 
+        // While the input (or output) volume is at unity, the first effect reads the driver's input buffers (and the
+        // last effect writes the driver's output buffers) directly, instead of through a copy made by the volume.
+        struct DriverBufferSite
+        {
+            Lv2Effect *effect;
+            int bufferIndex;         // the effect's audio input (or output) buffer.
+            size_t channel;          // the driver channel.
+            float *pedalboardBuffer; // bound when the volume isn't at unity.
+        };
+        std::vector<DriverBufferSite> driverInputSites;
+        std::vector<DriverBufferSite> driverOutputSites;
+        std::vector<float *> volumeInputBuffers;  // the input volume's outputs, and the output volume's inputs, this period (for VUs).
+        std::vector<float *> volumeOutputBuffers;
+        void PrepareDriverBufferSites(const std::vector<PedalboardItem> &items, const std::vector<float *> &outputs);
+        // Bind each site to driverBuffers (or back to its pedalboard buffer). Returns the number of sites left bound to driverBuffers.
+        size_t BindDriverBuffers(std::vector<DriverBufferSite> &sites, bool inputSites, float *const *driverBuffers, bool bindDriverBuffers);
+
         std::vector<std::shared_ptr<IEffect>> effects;
         std::vector<IEffect *> realtimeEffects;
 
+        struct ControlRamp
+        {
+            int effectIndex;
+            int portIndex;
+            float value;
+            float increment; // per frame.
+            float target;
+            uint32_t framesRemaining;
+        };
+        static constexpr size_t MAX_CONTROL_RAMPS = 256;
+        ControlRamp controlRamps[MAX_CONTROL_RAMPS];
+        size_t controlRampCount = 0;
+        void CancelControlRamp(int effectIndex, int portIndex);
+
+        // True if an unstaged plugin relies on the period meeting its block length requirements,
+        // which sub-blocks would violate.
+        bool hasUnstagedBlockLengthRequirements = false;
+
+        size_t monoModeEffectCount = 0;
+        float monoModeSavedLoad = 0;
+        void AdvanceControlRamps(uint32_t samples);
+
         using Action = std::function<void()>;
-        using ProcessAction = std::function<void(uint32_t frames)>;
 
         std::vector<Action> activateActions;
 
-        std::vector<ProcessAction> processActions;
+        ExecutionPlan processPlan;
+        ExecutionPlan *preparingPlan = &processPlan; // the plan PrepareItems() is currently adding steps to.
 
         std::vector<Action> deactivateActions;
 
-        float *CreateNewAudioBuffer();
+        // A buffer that may be shared with other effects, or (if !reusable) one that is never shared.
+        float *CreateNewAudioBuffer(bool reusable = true);
+        void ReleaseAudioBuffers(const std::vector<float *> &buffers, const std::vector<float *> &stillInUse = {});
+        bool CanRunInPlace(IEffect *effect, const std::vector<float *> &inputBuffers);
+
+        // Effect VUs are measured while the plan runs, since audio buffers get overwritten by later effects.
+        class VuTap
+        {
+        public:
+            IEffect *effect = nullptr;
+            SilenceGate *silenceGate = nullptr; // non-null if the effect is idled while silent.
+            bool inPlace = false; // the input has to be measured before the effect runs.
+            bool enabled = false;
+            int inputChannels = 0;
+            int outputChannels = 0;
+            float inputPeakL = 0;
+            float inputPeakR = 0;
+            float outputPeakL = 0;
+            float outputPeakR = 0;
+        };
+        std::vector<std::unique_ptr<VuTap>> vuTaps; // by realtime effect index.
+        std::vector<std::unique_ptr<SilenceGate>> silenceGates;
+        static void MeasureInputVu(void *data, uint32_t frames);
+        static void MeasureOutputVu(void *data, uint32_t frames);
+
+        // Effects with path properties flag themselves as pending after a run() that produces
+        // patch:Set output, so that the end-of-period gather only visits effects with work to do.
+        class PathPropertyTap
+        {
+        public:
+            Lv2Pedalboard *pedalboard = nullptr;
+            Lv2Effect *effect = nullptr;
+            size_t index = 0;
+        };
+        std::vector<std::unique_ptr<PathPropertyTap>> pathPropertyTaps;
+        PendingIndexList pendingPathProperties;
+        static void CheckPathPropertyOutput(void *data, uint32_t frames);
 
         RealtimeRingBufferWriter *ringBufferWriter;
+        RealtimeEffectTimings *effectTimings = nullptr; // non-null while per-effect timing is enabled.
+
+        // Splits whose top chain runs on the realtime helper thread, while the bottom chain runs on the audio thread.
+        // Also the first stage of a pipelined pedalboard (instanceId -1), which runs on the helper thread while the
+        // audio thread runs the second stage on the first stage's output from the previous period.
+        class ParallelSplit
+        {
+        public:
+            Lv2Pedalboard *pedalboard = nullptr;
+            int64_t instanceId = -1;
+            ExecutionPlan helperPlan;
+            std::vector<Lv2Effect *> helperEffects; // effects whose output messages are relayed by the audio thread after the helper completes.
+            // Pipeline stages only: the first stage's output buffers, and the second stage's input buffers they are copied to
+            // once both stages have finished.
+            std::vector<float *> handoffSources;
+            std::vector<float *> handoffTargets;
+
+            std::chrono::steady_clock::time_point startTime;
+            std::atomic<float> helperUs = 0;
+            std::atomic<float> audioThreadUs = 0;
+            std::atomic<float> waitUs = 0;
+        };
+        bool parallelSplitsEnabled = false;
+        int splitDepth = 0;
+        ParallelSplit *preparingParallelSplit = nullptr; // non-null while preparing the helper-thread chain of a split.
+        bool hasBorrowedEffects = false;
+
+        std::vector<std::unique_ptr<ParallelSplit>> parallelSplits;
+        RealtimeHelperThread::ptr helperThread;
+
+        static void RunHelperPlan(void *data, uint32_t frames);
+        static void StartParallelSplit(void *data, uint32_t frames);
+        static void WaitForParallelSplit(void *data, uint32_t frames);
+        static void CommitPipelineHandoff(void *data, uint32_t frames);
+        bool CanRunInParallel(const PedalboardItem &splitItem);
+        bool HasSidechainReaderOutside(const std::vector<PedalboardItem> &chain);
+
+        float EstimateItemLoad(const PedalboardItem &item, float unknownPluginLoad);
+        size_t ChoosePipelineCut(const std::vector<PedalboardItem> &items);
+        std::vector<float *> PreparePipeline(
+            std::vector<PedalboardItem> &items,
+            size_t cut,
+            Lv2PedalboardErrorList &errorList,
+            ExistingEffectMap *existingEffects);
 
         enum class MidiControlType
         {
@@ -92,21 +246,33 @@ namespace pipedal
             int instanceId = -1;
             int effectIndex = -1;
             int controlIndex = -1;
-            int key; // key to the note or control. internal use only.
             bool hasLastValue = false;
             bool lastValueIncreasing = false;
             float lastValue = 0;
+            int16_t lastFeedbackValue = -1; // last value sent to (or received from) the controller.
             MidiControlType mappingType;
             MidiBinding midiBinding;
         };
 
         std::vector<MidiMapping> midiMappings;
+        MidiDispatchTable midiDispatchTable; // indexes midiMappings.
+        std::vector<Lv2Effect *> midiOutputEffects;
+        std::vector<Lv2Effect *> midiInputEffects;
+
+        int16_t GetMidiFeedbackValue(const MidiMapping &mapping);
+
+        // Effects created ahead of PrepareItems (null if creation failed), by instance id.
+        std::map<int64_t, std::shared_ptr<IEffect>> createdEffects;
+        void CreateEffectsConcurrently(std::vector<PedalboardItem> &items, ExistingEffectMap *existingEffects);
 
+        // Prepares items [begin, end).
         std::vector<float *> PrepareItems(
             std::vector<PedalboardItem> &items,
             std::vector<float *> inputBuffers,
             Lv2PedalboardErrorList &errorList,
-            ExistingEffectMap *existingEffects);
+            ExistingEffectMap *existingEffects,
+            size_t begin = 0,
+            size_t end = SIZE_MAX);
 
         void PrepareMidiMap(const Pedalboard &pedalboard);
         void PrepareMidiMap(const PedalboardItem &pedalboardItem);
@@ -120,10 +286,16 @@ namespace pipedal
         ~Lv2Pedalboard() {}
 
 
-        void Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects = nullptr);
+        // inputChannels, outputChannels: -1 to use the host's channel counts.
+        void Prepare(IHost *pHost, Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, ExistingEffectMap *existingEffects = nullptr,
+                     int inputChannels = -1, int outputChannels = -1);
 
         std::vector<IEffect *> &GetEffects() { return realtimeEffects; }
+
+        size_t GetRealtimeMemoryInUse() const { return realtimeArena ? realtimeArena->BytesAllocated() : 0; }
         std::vector<std::shared_ptr<IEffect>> &GetSharedEffectList() { return effects; }
+        // True if any effect instances were taken over from a previous pedalboard. The previous pedalboard must not run once this one has been installed.
+        bool HasBorrowedEffects() const { return hasBorrowedEffects; }
 
 
         int GetIndexOfInstanceId(uint64_t instanceId)
@@ -150,12 +322,29 @@ namespace pipedal
         void Deactivate();
         void UpdateAudioPorts();
         
-        bool Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *realtimeWriter);
+        // If effectTimings is non-null, the execution time of each effect is recorded, by realtime effect index.
+        bool Run(float **inputBuffers, float **outputBuffers, uint32_t samples, RealtimeRingBufferWriter *realtimeWriter, RealtimeEffectTimings *effectTimings = nullptr);
+
+        // Called before each sub-block is run, with the offset and length of the sub-block within the period.
+        using SubBlockFn = void(void *handle, uint32_t offset, uint32_t frames);
+
+        // Run the period as a sequence of sub-blocks of subBlockFrames frames (the last one may be shorter), so that
+        // control changes made by pfnSubBlock take effect at sub-block boundaries instead of once per period.
+        // 0, or a sub-block that is at least as long as the period, runs the whole period at once, as does a pedalboard
+        // containing a plugin with block length requirements that only the full period satisfies. Atom buffers are
+        // not reset between sub-blocks; pfnSubBlock must collect atom output from the previous sub-block and call
+        // ResetAtomBuffers() when offset != 0.
+        bool RunSubBlocks(float **inputBuffers, float **outputBuffers, uint32_t samples, uint32_t subBlockFrames,
+                          void *handle, SubBlockFn *pfnSubBlock,
+                          RealtimeRingBufferWriter *realtimeWriter, RealtimeEffectTimings *effectTimings = nullptr);
 
         void ResetAtomBuffers();
 
-        void ProcessParameterRequests(RealtimePatchPropertyRequest *pParameterRequests, size_t samplesThisTime);
-        void GatherPatchProperties(RealtimePatchPropertyRequest *pParameterRequests);
+        // Sends the requests to their effects. Requests that can't be sent are completed with an error.
+        // Returns the PatchGet requests that are waiting for a response, linked through pNextActive.
+        RealtimePatchPropertyRequest *ProcessParameterRequests(RealtimePatchPropertyRequest *pParameterRequests, size_t samplesThisTime);
+        // pActiveRequests: as returned by ProcessParameterRequests.
+        void GatherPatchProperties(RealtimePatchPropertyRequest *pActiveRequests);
         void GatherPathPatchProperties(IPatchWriterCallback *cbPatchWriter);
 
         std::vector<float *> &GetInputBuffers() { return this->pedalboardInputBuffers; }
@@ -163,6 +352,9 @@ namespace pipedal
 
         int GetControlIndex(uint64_t instanceId, const std::string &symbol);
         void SetControlValue(int effectIndex, int portIndex, float value);
+        // Audio thread. Move a control linearly to value over the next frames frames. The control is updated at
+        // the start of each Run() (once per period, or once per sub-block). Cancelled by SetControlValue.
+        void RampControlValue(int effectIndex, int portIndex, float value, uint32_t frames);
         void SetInputVolume(float value) { this->inputVolume.SetTarget(value); }
         void SetOutputVolume(float value) { this->outputVolume.SetTarget(value); }
         void SetBypass(int effectIndex, bool enabled);
@@ -171,10 +363,29 @@ namespace pipedal
 
         float GetControlOutputValue(int effectIndex, int portIndex);
 
+        // Host thread. Empty unless the pedalboard was prepared with parallel splits.
+        std::vector<ParallelSplitTiming> GetParallelSplitTimings() const;
+        // Host thread. Statistics for effects that use the taskGroup extension.
+        std::vector<TaskGroupTiming> GetTaskGroupTimings() const;
+
+        // Dual-mode (optionally stereo) plugins that run mono because their input is mono, and the estimated
+        // load (fraction of the period) saved by not running their second channel.
+        size_t GetMonoModeEffectCount() const { return monoModeEffectCount; }
+        float GetMonoModeSavedLoad() const { return monoModeSavedLoad; }
+
         typedef void(MidiCallbackFn)(void *data, uint64_t intanceId, int controlIndex, float value);
         void OnMidiMessage(size_t size, uint8_t *data,
                            void *callbackHandle,
                            MidiCallbackFn *pfnCallback);
+
+        // Realtime thread. Relays MIDI output from plugins, and sends the current value of MIDI-bound
+        // controls back to the controller when it changes, so that LEDs and motor faders stay in sync.
+        void WriteMidiOutput(void *handle, Lv2Effect::MidiOutputFn *pfnMidiOutput);
+
+        bool HasMidiInput() const { return midiInputEffects.size() != 0; }
+        // Realtime thread. Deliver the sub-block's incoming MIDI to every plugin with a MIDI input port. The
+        // sequence is shared (read-only) by the plugins, and copied into their input buffers when they run.
+        void WriteMidiInput(const LV2_Atom_Sequence *events);
     };
 
 } // namespace
\ No newline at end of file
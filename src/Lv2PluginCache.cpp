@@ -0,0 +1,294 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "Lv2PluginCache.hpp"
+#include "PluginHost.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include "config.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+// Bump when the content of Lv2PluginInfo changes without a change in PROJECT_VER.
+static const char *CACHE_FORMAT_VERSION = "2"; // 2: plugin infos hold a ModGui summary.
+
+namespace
+{
+    class SignatureBuilder
+    {
+    public:
+        void Add(const std::string &value)
+        {
+            for (char c : value)
+            {
+                Add((uint8_t)c);
+            }
+            Add((uint8_t)0);
+        }
+        void Add(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                Add((uint8_t)(value >> (i * 8)));
+            }
+        }
+        std::string ToString() const
+        {
+            std::stringstream s;
+            s << std::hex << std::setw(16) << std::setfill('0') << hash;
+            return s.str();
+        }
+
+    private:
+        void Add(uint8_t value)
+        {
+            // FNV-1a
+            hash ^= value;
+            hash *= 0x100000001b3ull;
+        }
+        uint64_t hash = 0xcbf29ce484222325ull;
+    };
+
+    uint64_t MTimeNs(const fs::path &path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+        {
+            return 0;
+        }
+        return (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    }
+
+    void AddBundleSignature(SignatureBuilder &builder, const fs::path &bundlePath)
+    {
+        builder.Add(bundlePath.string());
+        builder.Add(MTimeNs(bundlePath));
+
+        // top-level files only. (Bundles may contain large trees of model files, which lilv doesn't read.)
+        std::vector<std::pair<std::string, uint64_t>> files;
+        std::error_code ec;
+        for (auto &entry : fs::directory_iterator(bundlePath, ec))
+        {
+            if (entry.is_regular_file(ec))
+            {
+                files.push_back({entry.path().filename().string(), MTimeNs(entry.path()) ^ (uint64_t)entry.file_size(ec)});
+            }
+        }
+        std::sort(files.begin(), files.end());
+        for (const auto &file : files)
+        {
+            builder.Add(file.first);
+            builder.Add(file.second);
+        }
+    }
+}
+
+JSON_MAP_BEGIN(Lv2PluginCache::Bundle)
+JSON_MAP_REFERENCE(Lv2PluginCache::Bundle, bundlePath)
+JSON_MAP_REFERENCE(Lv2PluginCache::Bundle, signature)
+JSON_MAP_REFERENCE(Lv2PluginCache::Bundle, plugins)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(Lv2PluginCache::CacheFile)
+JSON_MAP_REFERENCE(Lv2PluginCache::CacheFile, version)
+JSON_MAP_REFERENCE(Lv2PluginCache::CacheFile, otherBundlesSignature)
+JSON_MAP_REFERENCE(Lv2PluginCache::CacheFile, bundles)
+JSON_MAP_END()
+
+Lv2PluginCache::Lv2PluginCache(const fs::path &cacheFilePath)
+    : cacheFilePath(cacheFilePath)
+{
+}
+
+std::string Lv2PluginCache::NormalizeBundlePath(const std::string &path)
+{
+    std::string result = fs::path(path).lexically_normal().string();
+    while (result.length() > 1 && result.back() == '/')
+    {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::string Lv2PluginCache::GetBundleSignature(const fs::path &bundlePath)
+{
+    SignatureBuilder builder;
+    AddBundleSignature(builder, bundlePath);
+    return builder.ToString();
+}
+
+std::string Lv2PluginCache::GetOtherBundlesSignature(const std::string &lv2Path, const std::set<std::string> &pluginBundlePaths)
+{
+    SignatureBuilder builder;
+    builder.Add(std::string(PROJECT_VER));
+
+    std::stringstream s(lv2Path);
+    std::string directory;
+    while (std::getline(s, directory, ':'))
+    {
+        if (directory.starts_with("~/"))
+        {
+            const char *home = getenv("HOME");
+            directory = std::string(home ? home : "") + directory.substr(1);
+        }
+        builder.Add(directory);
+
+        std::vector<fs::path> bundles;
+        std::error_code ec;
+        for (auto &entry : fs::directory_iterator(directory, ec))
+        {
+            if (entry.is_directory(ec) && !pluginBundlePaths.contains(NormalizeBundlePath(entry.path().string())))
+            {
+                bundles.push_back(entry.path());
+            }
+        }
+        std::sort(bundles.begin(), bundles.end());
+        for (const auto &bundle : bundles)
+        {
+            AddBundleSignature(builder, bundle);
+        }
+    }
+    return builder.ToString();
+}
+
+void Lv2PluginCache::Load(const std::string &lv2Path, const std::set<std::string> &pluginBundlePaths)
+{
+    if (cacheFilePath.empty())
+    {
+        return;
+    }
+    this->otherBundlesSignature = GetOtherBundlesSignature(lv2Path, pluginBundlePaths);
+
+    std::ifstream f(cacheFilePath);
+    if (!f.is_open())
+    {
+        return;
+    }
+    try
+    {
+        CacheFile cacheFile;
+        json_reader reader(f);
+        reader.read(&cacheFile);
+
+        if (cacheFile.version_ != SS(PROJECT_VER << "/" << CACHE_FORMAT_VERSION))
+        {
+            Lv2Log::info("Plugin cache is from a different version. Rebuilding.");
+            return;
+        }
+        if (cacheFile.otherBundlesSignature_ != this->otherBundlesSignature)
+        {
+            Lv2Log::info("Non-plugin LV2 bundles have changed. Rebuilding plugin cache.");
+            return;
+        }
+        this->cachedBundles = std::move(cacheFile.bundles_);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't read plugin cache. " << e.what()));
+        this->cachedBundles.clear();
+    }
+}
+
+bool Lv2PluginCache::TryGet(const std::string &bundlePath, const std::set<std::string> &pluginUris, PluginList *result)
+{
+    if (cacheFilePath.empty())
+    {
+        return false;
+    }
+    std::string path = NormalizeBundlePath(bundlePath);
+    for (auto &bundle : cachedBundles)
+    {
+        if (bundle.bundlePath_ == path)
+        {
+            std::set<std::string> cachedUris;
+            for (const auto &plugin : bundle.plugins_)
+            {
+                cachedUris.insert(plugin->uri());
+            }
+            if (cachedUris == pluginUris && bundle.signature_ == GetBundleSignature(path))
+            {
+                *result = bundle.plugins_;
+                currentBundles.push_back(bundle);
+                ++hits;
+                return true;
+            }
+            break;
+        }
+    }
+    ++misses;
+    return false;
+}
+
+void Lv2PluginCache::Put(const std::string &bundlePath, const PluginList &plugins)
+{
+    if (cacheFilePath.empty())
+    {
+        return;
+    }
+    Bundle bundle;
+    bundle.bundlePath_ = NormalizeBundlePath(bundlePath);
+    bundle.signature_ = GetBundleSignature(bundle.bundlePath_);
+    bundle.plugins_ = plugins;
+    currentBundles.push_back(std::move(bundle));
+    changed = true;
+}
+
+void Lv2PluginCache::Save()
+{
+    if (cacheFilePath.empty())
+    {
+        return;
+    }
+    if (!changed && currentBundles.size() == cachedBundles.size())
+    {
+        return;
+    }
+    CacheFile cacheFile;
+    cacheFile.version_ = SS(PROJECT_VER << "/" << CACHE_FORMAT_VERSION);
+    cacheFile.otherBundlesSignature_ = this->otherBundlesSignature;
+    cacheFile.bundles_ = this->currentBundles;
+
+    fs::path tempPath = cacheFilePath.string() + ".$$$";
+    try
+    {
+        {
+            std::ofstream f(tempPath);
+            if (!f.is_open())
+            {
+                throw std::runtime_error(SS("Can't write to " << tempPath));
+            }
+            json_writer writer(f, true, true); // allow NaN (some plugins have NaN port ranges).
+            writer.write(cacheFile);
+        }
+        fs::rename(tempPath, cacheFilePath);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't save plugin cache. " << e.what()));
+        std::error_code ec;
+        fs::remove(tempPath, ec);
+    }
+}
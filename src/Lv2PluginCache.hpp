@@ -0,0 +1,102 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    class Lv2PluginInfo;
+
+    /**
+     * @brief Persistent cache of Lv2PluginInfo, keyed by bundle.
+     *
+     * Building an Lv2PluginInfo forces lilv to parse the plugin's data files, which is where most
+     * of plugin scanning time goes (lilv_world_load_all only reads manifests). Cached entries are
+     * valid as long as their bundle's signature (the mtimes and sizes of the files in the bundle
+     * directory) hasn't changed. Bundles that don't contain plugins (preset bundles, for example)
+     * can add data to any plugin, so a change to any of them invalidates the whole cache.
+     */
+    class Lv2PluginCache
+    {
+    public:
+        using PluginList = std::vector<std::shared_ptr<Lv2PluginInfo>>;
+
+        // An empty cacheFilePath disables the cache.
+        Lv2PluginCache(const std::filesystem::path &cacheFilePath);
+
+        /**
+         * @brief Load the cache file.
+         *
+         * @param lv2Path The LV2_PATH that was scanned.
+         * @param pluginBundlePaths Paths of all bundles that contain plugins.
+         */
+        void Load(const std::string &lv2Path, const std::set<std::string> &pluginBundlePaths);
+
+        // Cached plugins for the bundle, if the bundle is unchanged, and provides exactly the plugins in pluginUris.
+        bool TryGet(const std::string &bundlePath, const std::set<std::string> &pluginUris, PluginList *result);
+        void Put(const std::string &bundlePath, const PluginList &plugins);
+
+        // Writes the cache, if it changed. Bundles that weren't seen since Load() are dropped.
+        void Save();
+
+        size_t GetHits() const { return hits; }
+        size_t GetMisses() const { return misses; }
+
+        static std::string NormalizeBundlePath(const std::string &path);
+        static std::string GetBundleSignature(const std::filesystem::path &bundlePath);
+
+    private:
+        class Bundle
+        {
+        public:
+            std::string bundlePath_;
+            std::string signature_;
+            PluginList plugins_;
+
+            DECLARE_JSON_MAP(Bundle);
+        };
+        class CacheFile
+        {
+        public:
+            std::string version_;
+            std::string otherBundlesSignature_;
+            std::vector<Bundle> bundles_;
+
+            DECLARE_JSON_MAP(CacheFile);
+        };
+
+        std::string GetOtherBundlesSignature(const std::string &lv2Path, const std::set<std::string> &pluginBundlePaths);
+
+        std::filesystem::path cacheFilePath;
+        std::string otherBundlesSignature;
+        std::vector<Bundle> cachedBundles;
+        std::vector<Bundle> currentBundles;
+        bool changed = false;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Lv2PluginCache.hpp"
+#include "PluginHost.hpp"
+#include "ss.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+namespace
+{
+    std::shared_ptr<Lv2PluginInfo> MakePluginInfo(const std::string &uri, const std::string &bundlePath)
+    {
+        auto result = std::make_shared<Lv2PluginInfo>();
+        result->uri(uri);
+        result->bundle_path(bundlePath);
+        result->name("Test Plugin");
+        result->is_valid(true);
+        auto port = std::make_shared<Lv2PortInfo>();
+        port->symbol("gain");
+        port->max_value(1.0f);
+        port->is_atom_port(true);
+        result->ports().push_back(port);
+
+        auto fileProperty = std::make_shared<UiFileProperty>("Model", "http://example.com/test#model", "models");
+        std::vector<UiFileProperty::ptr> fileProperties{fileProperty};
+        result->piPedalUI(std::make_shared<PiPedalUI>(std::move(fileProperties)));
+        return result;
+    }
+    void WriteFile(const fs::path &path, const std::string &text)
+    {
+        std::ofstream f(path);
+        f << text;
+    }
+}
+
+TEST_CASE("Lv2PluginCache test", "[lv2_plugin_cache][Build][Dev]")
+{
+    fs::path testDirectory = fs::temp_directory_path() / SS("pipedal_lv2cache_test_" << getpid());
+    fs::path lv2Directory = testDirectory / "lv2";
+    fs::path bundlePath = lv2Directory / "test.lv2";
+    fs::path cacheFile = testDirectory / "lv2cache.json";
+    fs::remove_all(testDirectory);
+    fs::create_directories(bundlePath);
+    WriteFile(bundlePath / "manifest.ttl", "# manifest");
+
+    const std::string uri = "http://example.com/test";
+    std::set<std::string> bundlePaths{Lv2PluginCache::NormalizeBundlePath(bundlePath.string() + "/")};
+    std::set<std::string> uris{uri};
+
+    {
+        Lv2PluginCache cache(cacheFile);
+        cache.Load(lv2Directory.string(), bundlePaths);
+        Lv2PluginCache::PluginList plugins;
+        REQUIRE(!cache.TryGet(bundlePath.string(), uris, &plugins));
+        cache.Put(bundlePath.string(), {MakePluginInfo(uri, bundlePath.string())});
+        cache.Save();
+    }
+    {
+        // unchanged: cached values round-trip.
+        Lv2PluginCache cache(cacheFile);
+        cache.Load(lv2Directory.string(), bundlePaths);
+        Lv2PluginCache::PluginList plugins;
+        REQUIRE(cache.TryGet(bundlePath.string() + "/", uris, &plugins));
+        REQUIRE(plugins.size() == 1);
+        REQUIRE(plugins[0]->uri() == uri);
+        REQUIRE(plugins[0]->ports().size() == 1);
+        REQUIRE(plugins[0]->ports()[0]->symbol() == "gain");
+        REQUIRE(plugins[0]->ports()[0]->is_atom_port());
+        // the PiPedalUI isn't parsed until it's used.
+        REQUIRE(!plugins[0]->lazyPiPedalUI().isParsed());
+        REQUIRE(plugins[0]->lazyPiPedalUI().GetMemberJson("fileProperties").find("\"models\"") != std::string::npos);
+        REQUIRE(!plugins[0]->lazyPiPedalUI().isParsed());
+        REQUIRE(plugins[0]->piPedalUI());
+        REQUIRE(plugins[0]->lazyPiPedalUI().isParsed());
+        REQUIRE(plugins[0]->piPedalUI()->fileProperties().size() == 1);
+        REQUIRE(plugins[0]->piPedalUI()->fileProperties()[0]->directory() == "models");
+
+        // a different set of plugins in the bundle is a miss.
+        REQUIRE(!cache.TryGet(bundlePath.string(), {uri, "http://example.com/other"}, &plugins));
+        cache.Save();
+    }
+    {
+        // a modified bundle is a miss.
+        WriteFile(bundlePath / "test.ttl", "# plugin data");
+        Lv2PluginCache cache(cacheFile);
+        cache.Load(lv2Directory.string(), bundlePaths);
+        Lv2PluginCache::PluginList plugins;
+        REQUIRE(!cache.TryGet(bundlePath.string(), uris, &plugins));
+        cache.Put(bundlePath.string(), {MakePluginInfo(uri, bundlePath.string())});
+        cache.Save();
+    }
+    {
+        // a new non-plugin bundle (e.g. presets) invalidates everything.
+        fs::create_directories(lv2Directory / "presets.lv2");
+        WriteFile(lv2Directory / "presets.lv2" / "manifest.ttl", "# presets");
+        Lv2PluginCache cache(cacheFile);
+        cache.Load(lv2Directory.string(), bundlePaths);
+        Lv2PluginCache::PluginList plugins;
+        REQUIRE(!cache.TryGet(bundlePath.string(), uris, &plugins));
+    }
+    fs::remove_all(testDirectory);
+}
+
+TEST_CASE("LazyPiPedalUI test", "[lv2_plugin_cache][Build][Dev]")
+{
+    auto fileProperty = std::make_shared<UiFileProperty>("Model", "http://example.com/test#model", "models");
+    std::vector<UiFileProperty::ptr> fileProperties{fileProperty};
+    LazyPiPedalUI source{std::make_shared<PiPedalUI>(std::move(fileProperties))};
+    REQUIRE(source.isParsed());
+
+    std::string json = source.GetMemberJson("fileProperties");
+    REQUIRE(json.find("\"models\"") != std::string::npos);
+    REQUIRE(source.GetMemberJson("noSuchMember") == "[]");
+
+    std::ostringstream os;
+    json_writer writer(os);
+    writer.write(source);
+    std::string text = os.str();
+
+    // round trip without parsing.
+    LazyPiPedalUI lazy;
+    {
+        json_reader reader(text);
+        reader.read(&lazy);
+    }
+    REQUIRE(!lazy.empty());
+    REQUIRE(!lazy.isParsed());
+    REQUIRE(lazy.GetMemberJson("fileProperties") == json);
+    std::ostringstream os2;
+    json_writer writer2(os2);
+    writer2.write(lazy);
+    REQUIRE(os2.str() == text);
+    REQUIRE(!lazy.isParsed());
+
+    LazyPiPedalUI copy = lazy;
+    PiPedalUI::ptr ui = copy.get();
+    REQUIRE(lazy.isParsed()); // copies share the parsed value.
+    REQUIRE(ui->fileProperties().size() == 1);
+    REQUIRE(ui->fileProperties()[0]->directory() == "models");
+    REQUIRE(lazy.get() == ui);
+
+    LazyPiPedalUI nullUi;
+    {
+        json_reader reader(std::string_view("null"));
+        reader.read(&nullUi);
+    }
+    REQUIRE(nullUi.empty());
+    REQUIRE(!nullUi.get());
+}
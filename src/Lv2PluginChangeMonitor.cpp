@@ -20,34 +20,57 @@
 #include "Lv2PluginChangeMonitor.hpp"
 #include "Lv2Log.hpp"
 #include <sys/inotify.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <poll.h>
-#include <Finally.hpp>
 #include <chrono>
-#include <sys/eventfd.h>
 #include "PiPedalModel.hpp"
 #include "util.hpp"
+#include <vector>
 
 using namespace pipedal;
 
+// wait for changes to settle before reloading plugins.
+static constexpr std::chrono::seconds UPDATE_DELAY{5};
+
 Lv2PluginChangeMonitor::Lv2PluginChangeMonitor(PiPedalModel&model)
 :model(model)
 {
-    shutdown_eventfd = eventfd(0, 0);
-    monitorThread = std::make_unique<std::thread>([this]() { ThreadProc();});
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd == -1) {
+        Lv2Log::error("Failed to initialize inotify");
+        return;
+    }
+
+    // Add the directory to the inotify watch list
+    watch_descriptor = inotify_add_watch(inotify_fd, lv2Directory.c_str(), IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+    if (watch_descriptor == -1) {
+        Lv2Log::error("Failed to add directory to inotify watch list");
+        close(inotify_fd);
+        inotify_fd = -1;
+        return;
+    }
+    inotifyHandle = EventReactor::GetInstance().AddFd(
+        inotify_fd, EPOLLIN,
+        [this](uint32_t) { OnInotifyReady(); });
 }
 
 void Lv2PluginChangeMonitor::Shutdown()
 {
-    if (monitorThread)
+    if (inotify_fd != -1)
     {
-        terminateThread = true;
-        uint64_t val = 1;
-        auto _ = write(shutdown_eventfd,(void*)&val, sizeof(val));
-        monitorThread->join();
-        monitorThread = nullptr;
-        close(shutdown_eventfd);
+        auto &reactor = EventReactor::GetInstance();
+        // Remove() waits for in-flight callbacks, after which updateTimerHandle is stable.
+        reactor.Remove(inotifyHandle);
+        inotifyHandle = EventReactor::INVALID_HANDLE;
+        if (updateTimerHandle != EventReactor::INVALID_HANDLE)
+        {
+            reactor.Remove(updateTimerHandle);
+            updateTimerHandle = EventReactor::INVALID_HANDLE;
+        }
+        inotify_rm_watch(inotify_fd, watch_descriptor);
+        close(inotify_fd);
+        inotify_fd = -1;
     }
 }
 
@@ -56,92 +79,46 @@ Lv2PluginChangeMonitor::~Lv2PluginChangeMonitor()
     Shutdown();
 }
 
-void Lv2PluginChangeMonitor::ThreadProc()
+void Lv2PluginChangeMonitor::OnInotifyReady()
 {
-    SetThreadName("Lv2Change");
-    using clock = std::chrono::steady_clock;
-
-    int inotify_fd = inotify_init();
-    if (inotify_fd == -1) {
-        Lv2Log::error("Failed to initialize inotify");
-        return;
-    }
-
-    Finally f1 ([inotify_fd]() {
-        close(inotify_fd);
-
-    });
-    // Add the directory to the inotify watch list
-    int watch_descriptor = inotify_add_watch(inotify_fd, "/usr/lib/lv2", IN_MODIFY | IN_CREATE | IN_DELETE);
-    if (watch_descriptor == -1) {
-        Lv2Log::error("Failed to add directory to inotify watch list");
-        return;
-    }
-    Finally f2([inotify_fd,watch_descriptor]() {
-        inotify_rm_watch(inotify_fd, watch_descriptor);
-    });
-
-    bool updating = false;
-    clock::time_point updateTime;
-
-    // Monitor for file system events
-    while (true) {
-        struct pollfd pfds[2] = {
-            {.fd = inotify_fd, .events = POLLIN},
-            {.fd = shutdown_eventfd, .events = POLLIN}
-        };
-        int ret = poll(pfds, 2,500);  // infinite wait
-        if (ret == -1) {
-            Lv2Log::error("Error in poll()");
-            break;
-        }
-        if (ret == 0)
+    char buffer[4096];
+    ssize_t num_bytes = read(inotify_fd, buffer, sizeof(buffer));
+    if (num_bytes == -1) {
+        if (errno != EAGAIN)
         {
-            // timeout.
-            if (updating && clock::now() >= updateTime)
-            {
-                updating = false;
-                model.OnLv2PluginsChanged();
-            }
-            continue;
-        }
-        if (pfds[1].revents & POLLIN) {
-            // Shutdown event received
-            break;
-        } 
-
-        char buffer[4096];
-        ssize_t num_bytes = read(inotify_fd, buffer, sizeof(buffer));
-        if (num_bytes == -1) {
             Lv2Log::error("Error reading from inotify");
-            break;
         }
+        return;
+    }
 
-        size_t i = 0;
-        bool updated = false;
-        while (i < static_cast<size_t>(num_bytes)) {
-            struct inotify_event* event = reinterpret_cast<struct inotify_event*>(&buffer[i]);
-            if (event->len > 0) {
-                if (event->mask & IN_MODIFY) {
-                    updated = true;                    
-                } else if (event->mask & IN_CREATE) {
-                    updated = true;
-                } else if (event->mask & IN_DELETE) {
-                    updated = true;
-                }
+    size_t i = 0;
+    bool updated = false;
+    while (i < static_cast<size_t>(num_bytes)) {
+        struct inotify_event* event = reinterpret_cast<struct inotify_event*>(&buffer[i]);
+        if (event->len > 0) {
+            if (event->mask & (IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) {
+                updated = true;
+                changedBundles.insert((lv2Directory / event->name).string());
             }
-            i += sizeof(struct inotify_event) + event->len;
         }
-        if (updated)
+        i += sizeof(struct inotify_event) + event->len;
+    }
+    if (updated)
+    {
+        // restart the settle timer.
+        auto &reactor = EventReactor::GetInstance();
+        if (updateTimerHandle != EventReactor::INVALID_HANDLE)
         {
-            updating = true;
-            updateTime = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::seconds(5));
+            reactor.Remove(updateTimerHandle);
         }
+        updateTimerHandle = reactor.AddTimer(UPDATE_DELAY, [this]() { OnUpdateTimer(); });
     }
-
-    // Clean up
 }
 
-
-
-
+void Lv2PluginChangeMonitor::OnUpdateTimer()
+{
+    updateTimerHandle = EventReactor::INVALID_HANDLE;
+    std::vector<std::string> bundlePaths{changedBundles.begin(), changedBundles.end()};
+    changedBundles.clear();
+    model.OnLv2PluginsChanged(bundlePaths);
+}
@@ -19,24 +19,34 @@
 
 #pragma once
 
-#include <thread>
-#include <atomic>
+#include <EventReactor.hpp>
+#include <filesystem>
+#include <set>
+#include <string>
 
 namespace pipedal
 {
     class PiPedalModel;
+
+    // Watches /usr/lib/lv2 with inotify, reporting changed bundles once changes have settled.
+    // Runs on the shared EventReactor thread.
     class Lv2PluginChangeMonitor {
     public:
         Lv2PluginChangeMonitor(PiPedalModel&model);
         ~Lv2PluginChangeMonitor();
         void Shutdown();
     private:
-        void ThreadProc();
+        void OnInotifyReady();
+        void OnUpdateTimer();
 
-        int shutdown_eventfd;
-        bool isClosed = false;
         PiPedalModel&model;
-        std::unique_ptr<std::thread> monitorThread;
-        std::atomic<bool> terminateThread {false};
+        const std::filesystem::path lv2Directory = "/usr/lib/lv2";
+        int inotify_fd = -1;
+        int watch_descriptor = -1;
+        EventReactor::Handle inotifyHandle = EventReactor::INVALID_HANDLE;
+
+        // reactor thread only.
+        EventReactor::Handle updateTimerHandle = EventReactor::INVALID_HANDLE;
+        std::set<std::string> changedBundles;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "Lv2StateBlobStore.hpp"
+#include "HtmlHelper.hpp"
+#include "ofstream_synced.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace pipedal;
+
+static std::mutex instanceMutex;
+static Lv2StateBlobStore::ptr instance;
+static thread_local int outOfLineDepth = 0;
+
+Lv2StateBlobStore::Lv2StateBlobStore(const std::filesystem::path &directory)
+    : directory(directory)
+{
+    std::filesystem::create_directories(directory);
+}
+
+void Lv2StateBlobStore::SetInstance(ptr newInstance)
+{
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    instance = newInstance;
+}
+
+Lv2StateBlobStore::ptr Lv2StateBlobStore::GetInstance()
+{
+    std::lock_guard<std::mutex> lock(instanceMutex);
+    return instance;
+}
+
+Lv2StateBlobStore::OutOfLineScope::OutOfLineScope()
+{
+    ++outOfLineDepth;
+}
+
+Lv2StateBlobStore::OutOfLineScope::~OutOfLineScope()
+{
+    --outOfLineDepth;
+}
+
+bool Lv2StateBlobStore::IsOutOfLine()
+{
+    return outOfLineDepth != 0 && GetInstance() != nullptr;
+}
+
+std::string Lv2StateBlobStore::MakeKey(const std::vector<uint8_t> &value)
+{
+    uint64_t crc = HtmlHelper::crc64((uint8_t *)value.data(), value.size());
+    std::stringstream s;
+    s << std::hex << std::setw(16) << std::setfill('0') << crc << std::dec << "-" << value.size();
+    return s.str();
+}
+
+bool Lv2StateBlobStore::IsValidKey(const std::string &key)
+{
+    // keys come from clients, so they must not be able to name arbitrary files.
+    if (key.length() < 18 || key.length() > 40 || key[16] != '-')
+    {
+        return false;
+    }
+    for (size_t i = 0; i < key.length(); ++i)
+    {
+        char c = key[i];
+        if (i < 16)
+        {
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')))
+            {
+                return false;
+            }
+        }
+        else if (i > 16 && !(c >= '0' && c <= '9'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::filesystem::path Lv2StateBlobStore::GetPath(const std::string &key) const
+{
+    return directory / (key + ".bin");
+}
+
+std::string Lv2StateBlobStore::Put(const std::vector<uint8_t> &value)
+{
+    std::string key = MakeKey(value);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (knownKeys.contains(key))
+    {
+        return key;
+    }
+    std::filesystem::path path = GetPath(key);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec))
+    {
+        std::filesystem::path tempPath = path.string() + ".$$$";
+        {
+            pipedal::ofstream_synced f(tempPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!f.is_open())
+            {
+                throw std::runtime_error(SS("Can't write to " << tempPath << "."));
+            }
+            f.write((const char *)value.data(), value.size());
+            if (!f)
+            {
+                throw std::runtime_error(SS("Can't write to " << tempPath << "."));
+            }
+        }
+        std::filesystem::rename(tempPath, path);
+    }
+    knownKeys.insert(key);
+    return key;
+}
+
+bool Lv2StateBlobStore::Get(const std::string &key, std::vector<uint8_t> *value) const
+{
+    if (!IsValidKey(key))
+    {
+        return false;
+    }
+    std::ifstream f(GetPath(key), std::ios_base::in | std::ios_base::binary);
+    if (!f.is_open())
+    {
+        return false;
+    }
+    std::vector<uint8_t> result{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+    if (MakeKey(result) != key)
+    {
+        Lv2Log::error(SS("Lv2 state value " << key << " is corrupt."));
+        return false;
+    }
+    *value = std::move(result);
+    return true;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Content-addressed storage for large LV2 state values.
+     *
+     * While an OutOfLineScope is active on the current thread, Lv2PluginStateEntry writes values of
+     * OUT_OF_LINE_THRESHOLD bytes or more to the store, and serializes a reference to the value
+     * instead of the value itself. References are resolved whenever state is read.
+     *
+     * Storage enables out-of-line values for its own files, and the websocket enables them for
+     * client messages (clients treat plugin state as opaque, and echo references back).
+     * Exported files always carry values inline.
+     *
+     * Thread-safe.
+     */
+    class Lv2StateBlobStore
+    {
+    public:
+        using ptr = std::shared_ptr<Lv2StateBlobStore>;
+
+        static constexpr size_t OUT_OF_LINE_THRESHOLD = 16 * 1024;
+
+        Lv2StateBlobStore(const std::filesystem::path &directory);
+
+        static void SetInstance(ptr instance);
+        static ptr GetInstance();
+
+        // "<crc64 of value>-<size>".
+        static std::string MakeKey(const std::vector<uint8_t> &value);
+        static bool IsValidKey(const std::string &key);
+
+        // Returns the value's key.
+        std::string Put(const std::vector<uint8_t> &value);
+        bool Get(const std::string &key, std::vector<uint8_t> *value) const;
+
+        class OutOfLineScope
+        {
+        public:
+            OutOfLineScope();
+            ~OutOfLineScope();
+        };
+        // True if the current thread is in an OutOfLineScope, and a store has been installed.
+        static bool IsOutOfLine();
+
+    private:
+        std::filesystem::path GetPath(const std::string &key) const;
+
+        std::filesystem::path directory;
+        mutable std::mutex mutex;
+        std::set<std::string> knownKeys; // keys that are known to be on disk.
+    };
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Lv2StateBlobStore.hpp"
+#include <filesystem>
+
+using namespace pipedal;
+
+TEST_CASE("Lv2StateBlobStore", "[lv2_state_blob_store][Build][Dev]")
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "pipedal_lv2_state_blob_test";
+    std::filesystem::remove_all(directory);
+
+    std::vector<uint8_t> value(Lv2StateBlobStore::OUT_OF_LINE_THRESHOLD * 4);
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        value[i] = (uint8_t)(i * 7);
+    }
+    {
+        Lv2StateBlobStore store(directory);
+        std::string key = store.Put(value);
+        REQUIRE(key == Lv2StateBlobStore::MakeKey(value));
+        REQUIRE(Lv2StateBlobStore::IsValidKey(key));
+        REQUIRE(store.Put(value) == key); // content-addressed.
+
+        std::vector<uint8_t> otherValue = value;
+        otherValue[10] ^= 1;
+        REQUIRE(store.Put(otherValue) != key);
+    }
+    {
+        // values survive the store.
+        Lv2StateBlobStore store(directory);
+        std::vector<uint8_t> result;
+        REQUIRE(store.Get(Lv2StateBlobStore::MakeKey(value), &result));
+        REQUIRE(result == value);
+
+        // keys from clients can't name other files.
+        REQUIRE(!Lv2StateBlobStore::IsValidKey("../../etc/passwd"));
+        REQUIRE(!Lv2StateBlobStore::IsValidKey("0123456789abcdef-12/"));
+        REQUIRE(!store.Get("0123456789abcdef-12", &result));
+    }
+
+    // out-of-line values need both a scope and an installed store.
+    REQUIRE(!Lv2StateBlobStore::IsOutOfLine());
+    Lv2StateBlobStore::SetInstance(std::make_shared<Lv2StateBlobStore>(directory));
+    REQUIRE(!Lv2StateBlobStore::IsOutOfLine());
+    {
+        Lv2StateBlobStore::OutOfLineScope outOfLine;
+        REQUIRE(Lv2StateBlobStore::IsOutOfLine());
+    }
+    REQUIRE(!Lv2StateBlobStore::IsOutOfLine());
+    Lv2StateBlobStore::SetInstance(nullptr);
+
+    std::filesystem::remove_all(directory);
+}
@@ -19,6 +19,7 @@
 
 #include "MapFeature.hpp"
 #include <mutex>
+#include <stdexcept>
 
 using namespace pipedal;
 
@@ -48,35 +49,175 @@ MapFeature::MapFeature()
 
 MapFeature::~MapFeature()
 {
-    for (auto i = stdUnmap.begin(); i != stdUnmap.end(); ++i)
+    for (auto &chunk : unmapChunks)
     {
-        delete i->second;
+        std::atomic<Entry*> *slots = chunk.load();
+        if (slots)
+        {
+            for (size_t i = 0; i < UNMAP_CHUNK_SIZE; ++i)
+            {
+                delete slots[i].load();
+            }
+            delete[] slots;
+        }
     }
 }
 
-LV2_URID MapFeature::GetUrid(const char* uri)
+MapFeature::Table::Table(size_t capacity)
+    : mask(capacity - 1),
+      slots(new std::atomic<Entry *>[capacity])
 {
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
 
-	std::lock_guard<std::mutex> guard(mapMutex);
-
-	LV2_URID result = stdMap[uri];
-	if (result == 0)
-	{
-		stdMap[uri] = ++nextAtom;
-		result = nextAtom;
-        std::string *stringRef = new std::string(uri);
-        stdUnmap[result] = stringRef;
-	}
-	return result;
+MapFeature::Entry *MapFeature::Table::Find(uint64_t hash, const char *uri) const
+{
+    // linear probing. (the shard index uses the top bits of the hash; the slot index uses the bottom bits.)
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        Entry *entry = slots[i].load(std::memory_order_acquire);
+        if (entry == nullptr)
+        {
+            return nullptr;
+        }
+        if (entry->hash == hash && entry->uri == uri)
+        {
+            return entry;
+        }
+    }
 }
 
-const char*MapFeature::UridToString(LV2_URID urid)
+void MapFeature::Table::Insert(Entry *entry)
 {
-	std::lock_guard<std::mutex> guard(mapMutex);
+    for (size_t i = entry->hash & mask;; i = (i + 1) & mask)
+    {
+        if (slots[i].load(std::memory_order_relaxed) == nullptr)
+        {
+            slots[i].store(entry, std::memory_order_release);
+            ++count;
+            return;
+        }
+    }
+}
 
-    std::string*pResult = stdUnmap[urid];
-    if (pResult == nullptr) return nullptr;
+uint64_t MapFeature::Hash(const char *uri)
+{
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char *p = uri; *p != 0; ++p)
+    {
+        hash ^= (uint8_t)*p;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
 
-    return pResult->c_str();
+std::atomic<MapFeature::Entry *> *MapFeature::GetUnmapSlot(LV2_URID urid, bool allocate)
+{
+    size_t chunkIndex = urid >> UNMAP_CHUNK_BITS;
+    if (chunkIndex >= MAX_UNMAP_CHUNKS)
+    {
+        if (allocate)
+        {
+            throw std::runtime_error("Too many URIDs.");
+        }
+        return nullptr;
+    }
+    std::atomic<Entry *> *chunk = unmapChunks[chunkIndex].load(std::memory_order_acquire);
+    if (chunk == nullptr)
+    {
+        if (!allocate)
+        {
+            return nullptr;
+        }
+        std::lock_guard<inverting_mutex> guard(unmapMutex);
+        chunk = unmapChunks[chunkIndex].load(std::memory_order_acquire);
+        if (chunk == nullptr)
+        {
+            chunk = new std::atomic<Entry *>[UNMAP_CHUNK_SIZE];
+            for (size_t i = 0; i < UNMAP_CHUNK_SIZE; ++i)
+            {
+                chunk[i].store(nullptr, std::memory_order_relaxed);
+            }
+            unmapChunks[chunkIndex].store(chunk, std::memory_order_release);
+        }
+    }
+    return &chunk[urid & (UNMAP_CHUNK_SIZE - 1)];
+}
 
+LV2_URID MapFeature::GetUrid(const char *uri)
+{
+    uint64_t hash = Hash(uri);
+    Shard &shard = GetShard(hash);
+
+    Table *table = shard.table.load(std::memory_order_acquire);
+    if (table)
+    {
+        Entry *entry = table->Find(hash, uri);
+        if (entry)
+        {
+            return entry->urid;
+        }
+    }
+
+    std::lock_guard<inverting_mutex> guard(shard.mutex);
+
+    // again, under the lock (and against the current table).
+    table = shard.table.load(std::memory_order_acquire);
+    if (table)
+    {
+        Entry *entry = table->Find(hash, uri);
+        if (entry)
+        {
+            return entry->urid;
+        }
+    }
+    if (table == nullptr || (table->count + 1) * 2 > table->mask + 1)
+    {
+        size_t capacity = table ? (table->mask + 1) * 2 : INITIAL_SHARD_CAPACITY;
+        std::unique_ptr<Table> newTable = std::make_unique<Table>(capacity);
+        if (table)
+        {
+            for (size_t i = 0; i <= table->mask; ++i)
+            {
+                Entry *entry = table->slots[i].load(std::memory_order_relaxed);
+                if (entry)
+                {
+                    newTable->Insert(entry);
+                }
+            }
+        }
+        table = newTable.get();
+        shard.tables.push_back(std::move(newTable));
+        shard.table.store(table, std::memory_order_release);
+    }
+
+    LV2_URID urid = nextAtom.fetch_add(1) + 1;
+    Entry *entry = new Entry{hash, urid, uri};
+    // publish to unmap first, so that anyone who can see the urid can unmap it.
+    GetUnmapSlot(urid, true)->store(entry, std::memory_order_release);
+    table->Insert(entry);
+    return urid;
+}
+
+const char *MapFeature::UridToString(LV2_URID urid)
+{
+    if (urid == 0)
+    {
+        return nullptr;
+    }
+    std::atomic<Entry *> *slot = GetUnmapSlot(urid, false);
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    Entry *entry = slot->load(std::memory_order_acquire);
+    if (entry == nullptr)
+    {
+        return nullptr;
+    }
+    return entry->uri.c_str();
 }
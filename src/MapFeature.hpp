@@ -27,28 +27,74 @@
 #include "lv2/midi/midi.h"
 #include "lv2/urid/urid.h"
 #include "lv2/atom/atom.h"
-#include <map>
 #include <string>
 #include <mutex>
+#include "inverting_mutex.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
 
 
 namespace pipedal {
+	/**
+	 * @brief The host's LV2 URID map.
+	 *
+	 * Read-mostly. URIs are kept in sharded, open-addressed hash tables that readers probe without
+	 * locking; a shard's mutex is only taken to insert a new URI. When a shard's table fills, a larger
+	 * copy is published, and the old one is retired (but not deleted until the MapFeature is destroyed,
+	 * since readers may still be probing it). Unmap is an index into a chunked array.
+	 */
 	class MapFeature {
 
 	private:
-		LV2_URID nextAtom = 0;
+		struct Entry {
+			uint64_t hash;
+			LV2_URID urid;
+			std::string uri;
+		};
+		struct Table {
+			Table(size_t capacity);
+			size_t mask;
+			size_t count = 0;
+			std::unique_ptr<std::atomic<Entry*>[]> slots;
+
+			Entry *Find(uint64_t hash, const char*uri) const;
+			void Insert(Entry *entry);
+		};
+		struct Shard {
+			inverting_mutex mutex;
+			std::atomic<Table*> table { nullptr };
+			std::vector<std::unique_ptr<Table>> tables; // the current table, and retired tables.
+		};
+
+		static constexpr size_t SHARD_BITS = 4;
+		static constexpr size_t SHARD_COUNT = 1 << SHARD_BITS;
+		static constexpr size_t INITIAL_SHARD_CAPACITY = 256;
+		static constexpr size_t UNMAP_CHUNK_BITS = 10;
+		static constexpr size_t UNMAP_CHUNK_SIZE = 1 << UNMAP_CHUNK_BITS;
+		static constexpr size_t MAX_UNMAP_CHUNKS = 4096;
+
+		static uint64_t Hash(const char*uri);
+		Shard&GetShard(uint64_t hash) { return shards[hash >> (64-SHARD_BITS)]; }
+		std::atomic<Entry*>*GetUnmapSlot(LV2_URID urid, bool allocate);
+
 		LV2_Feature mapFeature;
 		LV2_Feature unmapFeature;
 		LV2_URID_Map map;
 		LV2_URID_Unmap unmap;
-		std::map<std::string, LV2_URID> stdMap;
-		std::map<LV2_URID, std::string*> stdUnmap;
-		std::mutex mapMutex;
+
+		Shard shards[SHARD_COUNT];
+		std::atomic<LV2_URID> nextAtom { 0 };
+		inverting_mutex unmapMutex; // only for allocating unmap chunks.
+		std::atomic<std::atomic<Entry*>*> unmapChunks[MAX_UNMAP_CHUNKS] {};
 
 
 	public:
 		MapFeature();
         ~MapFeature();
+		MapFeature(const MapFeature&) = delete;
+		MapFeature&operator=(const MapFeature&) = delete;
 	public:
 		const LV2_Feature* GetMapFeature()
 		{
@@ -0,0 +1,207 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "MapFeature.hpp"
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    std::vector<std::string> MakeUris(size_t n)
+    {
+        std::vector<std::string> result;
+        for (size_t i = 0; i < n; ++i)
+        {
+            result.push_back("http://example.com/plugins/test#property" + std::to_string(i));
+        }
+        return result;
+    }
+
+    // the previous implementation.
+    class LockedMap
+    {
+    public:
+        LV2_URID GetUrid(const char *uri)
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            LV2_URID &result = map[uri];
+            if (result == 0)
+            {
+                result = (LV2_URID)map.size();
+            }
+            return result;
+        }
+
+    private:
+        std::mutex mutex;
+        std::map<std::string, LV2_URID> map;
+    };
+
+    template <typename T>
+    double TimeLookups(T &map, const std::vector<std::string> &uris, int nThreads, int iterations)
+    {
+        using namespace std::chrono;
+        auto start = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < nThreads; ++t)
+        {
+            threads.emplace_back(
+                [&map, &uris, iterations]()
+                {
+                    for (int i = 0; i < iterations; ++i)
+                    {
+                        for (const auto &uri : uris)
+                        {
+                            map.GetUrid(uri.c_str());
+                        }
+                    }
+                });
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        auto elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+        return elapsed / (double)(iterations * uris.size());
+    }
+}
+
+TEST_CASE("MapFeature test", "[map_feature][Build][Dev]")
+{
+    MapFeature map;
+    auto uris = MakeUris(10000); // enough to grow every shard several times.
+
+    std::vector<LV2_URID> urids;
+    for (const auto &uri : uris)
+    {
+        LV2_URID urid = map.GetUrid(uri.c_str());
+        REQUIRE(urid != 0);
+        urids.push_back(urid);
+    }
+    for (size_t i = 0; i < uris.size(); ++i)
+    {
+        REQUIRE(map.GetUrid(uris[i].c_str()) == urids[i]);
+        REQUIRE(strcmp(map.UridToString(urids[i]), uris[i].c_str()) == 0);
+    }
+    REQUIRE(map.UridToString(0) == nullptr);
+    REQUIRE(map.UridToString(100000) == nullptr);
+
+    // through the LV2 feature.
+    LV2_URID_Map *lv2Map = map.GetMap();
+    LV2_URID_Unmap *lv2Unmap = map.GetUnmap();
+    REQUIRE(lv2Map->map(lv2Map->handle, uris[5].c_str()) == urids[5]);
+    REQUIRE(strcmp(lv2Unmap->unmap(lv2Unmap->handle, urids[5]), uris[5].c_str()) == 0);
+}
+
+TEST_CASE("MapFeature concurrent insert", "[map_feature][Build][Dev]")
+{
+    MapFeature map;
+    auto uris = MakeUris(20011); // prime, so that every thread visits every uri.
+    constexpr int N_THREADS = 8;
+
+    // every thread maps every uri, in a different order. All threads must agree.
+    std::vector<std::vector<LV2_URID>> results(N_THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < N_THREADS; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                auto &result = results[t];
+                result.resize(uris.size());
+                for (size_t i = 0; i < uris.size(); ++i)
+                {
+                    size_t ix = (i * (2 * t + 1) + t * 977) % uris.size();
+                    result[ix] = map.GetUrid(uris[ix].c_str());
+                    const char *unmapped = map.UridToString(result[ix]);
+                    if (unmapped == nullptr || uris[ix] != unmapped)
+                    {
+                        result[ix] = 0;
+                    }
+                }
+            });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (size_t i = 0; i < uris.size(); ++i)
+    {
+        REQUIRE(results[0][i] != 0);
+        for (int t = 1; t < N_THREADS; ++t)
+        {
+            REQUIRE(results[t][i] == results[0][i]);
+        }
+    }
+    // urids are dense.
+    std::vector<bool> seen(uris.size() + 1);
+    for (LV2_URID urid : results[0])
+    {
+        REQUIRE(urid <= uris.size());
+        REQUIRE(!seen[urid]);
+        seen[urid] = true;
+    }
+}
+
+TEST_CASE("MapFeature benchmark", "[map_feature_benchmark][Dev]")
+{
+    auto uris = MakeUris(2000);
+    constexpr int ITERATIONS = 200;
+
+    MapFeature map;
+    LockedMap lockedMap;
+    for (const auto &uri : uris)
+    {
+        map.GetUrid(uri.c_str());
+        lockedMap.GetUrid(uri.c_str());
+    }
+
+    cout << "MapFeature benchmark (" << uris.size() << " uris, lookups of existing uris)" << endl;
+    for (int nThreads : {1, 4})
+    {
+        double lockedNs = TimeLookups(lockedMap, uris, nThreads, ITERATIONS);
+        double mapNs = TimeLookups(map, uris, nThreads, ITERATIONS);
+        cout << "    " << nThreads << " thread(s): std::map+mutex: " << lockedNs << " ns/lookup  MapFeature: " << mapNs << " ns/lookup" << endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const char *result = nullptr;
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        for (LV2_URID urid = 1; urid <= uris.size(); ++urid)
+        {
+            result = map.UridToString(urid);
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    cout << "    unmap: " << elapsed / (double)(ITERATIONS * uris.size()) << " ns/unmap" << endl;
+    REQUIRE(result != nullptr);
+}
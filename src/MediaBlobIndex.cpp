@@ -0,0 +1,193 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "MediaBlobIndex.hpp"
+#include "AudioFilesDb.hpp"
+#include "Blake3.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <sys/stat.h>
+
+using namespace pipedal;
+using namespace pipedal::impl;
+namespace fs = std::filesystem;
+
+MediaBlobIndex::MediaBlobIndex(const std::filesystem::path &uploadDirectory)
+    : uploadDirectory(uploadDirectory)
+{
+    fs::create_directories(uploadDirectory);
+    db = std::make_unique<MediaBlobDb>(uploadDirectory / ".mediaBlobs.pipedal");
+}
+
+MediaBlobIndex::~MediaBlobIndex()
+{
+}
+
+bool MediaBlobIndex::GetFileStat(const std::filesystem::path &path, FileStat *result)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+    result->size = (int64_t)st.st_size;
+    result->lastModified = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    result->inode = (uint64_t)st.st_ino;
+    return true;
+}
+
+std::string MediaBlobIndex::RelativePath(const std::filesystem::path &path) const
+{
+    return path.lexically_normal().lexically_relative(uploadDirectory).string();
+}
+
+std::string MediaBlobIndex::GetHash(const std::filesystem::path &file, const FileStat &stat)
+{
+    std::string relativePath = RelativePath(file);
+    MediaBlobEntry entry;
+    if (db->Lookup(relativePath, &entry) &&
+        entry.size == stat.size && entry.lastModified == stat.lastModified && entry.inode == stat.inode)
+    {
+        return entry.hash;
+    }
+    entry.path = relativePath;
+    entry.hash = Blake3Hasher::HashFile(file);
+    entry.size = stat.size;
+    entry.lastModified = stat.lastModified;
+    entry.inode = stat.inode;
+    db->Insert(entry);
+    return entry.hash;
+}
+
+std::string MediaBlobIndex::GetHash(const std::filesystem::path &file)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    FileStat stat;
+    if (!GetFileStat(file, &stat))
+    {
+        throw std::runtime_error(SS("File not found: " << file));
+    }
+    return GetHash(file, stat);
+}
+
+std::filesystem::path MediaBlobIndex::FindFile(const std::string &hash, const std::filesystem::path &excluding, FileStat *pStat)
+{
+    std::string excludingPath = excluding.empty() ? std::string() : RelativePath(excluding);
+    for (const auto &entry : db->FindByHash(hash))
+    {
+        if (entry.path == excludingPath)
+        {
+            continue;
+        }
+        fs::path path = uploadDirectory / entry.path;
+        FileStat stat;
+        if (!GetFileStat(path, &stat))
+        {
+            db->Delete(entry.path); // deleted since it was indexed.
+            continue;
+        }
+        if (stat.size != entry.size || stat.lastModified != entry.lastModified || stat.inode != entry.inode)
+        {
+            // replaced since it was indexed.
+            if (GetHash(path, stat) != hash)
+            {
+                continue;
+            }
+        }
+        *pStat = stat;
+        return path;
+    }
+    return fs::path();
+}
+
+std::filesystem::path MediaBlobIndex::FindFile(const std::string &hash, const std::filesystem::path &excluding)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    FileStat stat;
+    return FindFile(hash, excluding, &stat);
+}
+
+bool MediaBlobIndex::Deduplicate(const std::filesystem::path &file)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    FileStat fileStat;
+    if (!GetFileStat(file, &fileStat))
+    {
+        return false;
+    }
+    std::string hash = GetHash(file, fileStat);
+    FileStat existingStat;
+    fs::path existing = FindFile(hash, file, &existingStat);
+    if (existing.empty() || existingStat.inode == fileStat.inode)
+    {
+        return false;
+    }
+    // link to a temporary name and rename it into place, so that file is never missing.
+    fs::path tempPath = file.string() + ".$$$";
+    std::error_code ec;
+    fs::remove(tempPath, ec);
+    fs::create_hard_link(existing, tempPath, ec);
+    if (ec)
+    {
+        Lv2Log::debug(SS("Can't link " << file << " to " << existing << ": " << ec.message()));
+        return false;
+    }
+    fs::rename(tempPath, file, ec);
+    if (ec)
+    {
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    MediaBlobEntry entry;
+    entry.path = RelativePath(file);
+    entry.hash = hash;
+    entry.size = existingStat.size;
+    entry.lastModified = existingStat.lastModified;
+    entry.inode = existingStat.inode;
+    db->Insert(entry);
+    return true;
+}
+
+bool MediaBlobIndex::LinkTo(const std::string &hash, const std::filesystem::path &newFile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    FileStat existingStat;
+    fs::path existing = FindFile(hash, newFile, &existingStat);
+    if (existing.empty())
+    {
+        return false;
+    }
+    std::error_code ec;
+    fs::create_directories(newFile.parent_path(), ec);
+    fs::create_hard_link(existing, newFile, ec);
+    if (ec)
+    {
+        Lv2Log::debug(SS("Can't link " << newFile << " to " << existing << ": " << ec.message()));
+        return false;
+    }
+    MediaBlobEntry entry;
+    entry.path = RelativePath(newFile);
+    entry.hash = hash;
+    entry.size = existingStat.size;
+    entry.lastModified = existingStat.lastModified;
+    entry.inode = existingStat.inode;
+    db->Insert(entry);
+    return true;
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace pipedal
+{
+    namespace impl
+    {
+        class MediaBlobDb;
+    }
+
+    /**
+     * @brief Content-addressed index of the files in the plugin upload directory.
+     *
+     * Files are identified by their BLAKE3 hash. Hashes are cached in an SQLite database in the
+     * upload directory, keyed by path and validated against each file's size, modification
+     * time and inode, so that a file is only rehashed when it changes.
+     *
+     * Files with identical content are deduplicated by replacing them with hard links to a
+     * single copy. Uploaded media files are never modified in place (uploads are written to a
+     * temporary file and renamed into place), so linked copies can't diverge.
+     */
+    class MediaBlobIndex
+    {
+    public:
+        using ptr = std::unique_ptr<MediaBlobIndex>;
+
+        MediaBlobIndex(const std::filesystem::path &uploadDirectory);
+        ~MediaBlobIndex();
+
+        // The content hash of a file in the upload directory.
+        std::string GetHash(const std::filesystem::path &file);
+
+        // An existing file with the given content hash (other than excluding), or an empty path.
+        std::filesystem::path FindFile(const std::string &hash, const std::filesystem::path &excluding = {});
+
+        // Replace file with a hard link to an existing file with the same content. Returns true if it was linked.
+        bool Deduplicate(const std::filesystem::path &file);
+
+        // Create newFile as a hard link to an existing file with the given content hash.
+        // Returns false if there is no such file, or it can't be linked (e.g. it's on another filesystem).
+        bool LinkTo(const std::string &hash, const std::filesystem::path &newFile);
+
+    private:
+        struct FileStat
+        {
+            int64_t size = 0;
+            int64_t lastModified = 0;
+            uint64_t inode = 0;
+        };
+        static bool GetFileStat(const std::filesystem::path &path, FileStat *result);
+        std::string RelativePath(const std::filesystem::path &path) const;
+        std::string GetHash(const std::filesystem::path &file, const FileStat &stat);
+        std::filesystem::path FindFile(const std::string &hash, const std::filesystem::path &excluding, FileStat *stat);
+
+        std::filesystem::path uploadDirectory;
+        std::mutex mutex;
+        std::unique_ptr<impl::MediaBlobDb> db;
+    };
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Blake3.hpp"
+#include "MediaBlobIndex.hpp"
+#include <filesystem>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static std::string Blake3OfTestInput(size_t length)
+{
+    // the input used by the official BLAKE3 test vectors.
+    std::vector<uint8_t> input(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        input[i] = (uint8_t)(i % 251);
+    }
+    Blake3Hasher hasher;
+    hasher.Update(input.data(), input.size());
+    return hasher.FinalizeHex();
+}
+
+static void WriteTestFile(const fs::path &path, const std::string &content)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream f(path, std::ios_base::trunc | std::ios_base::binary);
+    f << content;
+}
+
+static uint64_t GetInode(const fs::path &path)
+{
+    struct stat st;
+    REQUIRE(stat(path.c_str(), &st) == 0);
+    return st.st_ino;
+}
+
+TEST_CASE("Blake3", "[media_blob_index][Build][Dev]")
+{
+    REQUIRE(Blake3OfTestInput(0) == "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262");
+    REQUIRE(Blake3OfTestInput(1) == "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213");
+    REQUIRE(Blake3OfTestInput(1024) == "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7");
+    REQUIRE(Blake3OfTestInput(1025) == "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444");
+    REQUIRE(Blake3OfTestInput(102400) == "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085");
+
+    // incremental updates that don't line up with block or chunk boundaries.
+    std::vector<uint8_t> input(5000);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = (uint8_t)(i % 251);
+    }
+    Blake3Hasher hasher;
+    for (size_t i = 0; i < input.size(); i += 7)
+    {
+        hasher.Update(input.data() + i, std::min<size_t>(7, input.size() - i));
+    }
+    REQUIRE(hasher.FinalizeHex() == Blake3OfTestInput(5000));
+}
+
+TEST_CASE("MediaBlobIndex", "[media_blob_index][Build][Dev]")
+{
+    fs::path uploadDirectory = fs::temp_directory_path() / "MediaBlobIndexTest";
+    fs::remove_all(uploadDirectory);
+
+    fs::path fileA = uploadDirectory / "NeuralAmpModels" / "a.nam";
+    fs::path fileB = uploadDirectory / "ToobNam" / "b.nam";
+    fs::path fileC = uploadDirectory / "ToobNam" / "c.nam";
+    WriteTestFile(fileA, "model data");
+    WriteTestFile(fileB, "model data");
+    WriteTestFile(fileC, "other model data");
+
+    SECTION("duplicates are linked")
+    {
+        MediaBlobIndex index(uploadDirectory);
+        REQUIRE(!index.Deduplicate(fileA)); // nothing to link to yet.
+        REQUIRE(index.Deduplicate(fileB));
+        REQUIRE(GetInode(fileA) == GetInode(fileB));
+        REQUIRE(!index.Deduplicate(fileB)); // already linked.
+
+        REQUIRE(!index.Deduplicate(fileC));
+        REQUIRE(GetInode(fileC) != GetInode(fileA));
+        REQUIRE(!fs::exists(fileB.string() + ".$$$"));
+    }
+    SECTION("link by hash")
+    {
+        MediaBlobIndex index(uploadDirectory);
+        std::string hash = index.GetHash(fileA);
+        REQUIRE(hash == index.GetHash(fileB));
+        REQUIRE(hash != index.GetHash(fileC));
+
+        fs::path newFile = uploadDirectory / "ToobNam" / "imported" / "a.nam";
+        REQUIRE(index.LinkTo(hash, newFile));
+        REQUIRE(GetInode(newFile) == GetInode(fileA));
+        REQUIRE(!index.LinkTo(Blake3OfTestInput(3), uploadDirectory / "missing.nam"));
+    }
+    SECTION("stale entries are ignored")
+    {
+        std::string hash;
+        {
+            MediaBlobIndex index(uploadDirectory);
+            hash = index.GetHash(fileA);
+        }
+        // replace a with different content, the way uploads do.
+        fs::path tempFile = fileA.string() + ".tmp";
+        WriteTestFile(tempFile, "new model data");
+        fs::rename(tempFile, fileA);
+
+        MediaBlobIndex index(uploadDirectory);
+        REQUIRE(index.FindFile(hash).empty());
+        REQUIRE(index.GetHash(fileA) != hash);
+        REQUIRE(!index.Deduplicate(fileB));
+
+        fs::remove(fileA);
+        REQUIRE(index.FindFile(index.GetHash(fileC), fileC).empty());
+    }
+    fs::remove_all(uploadDirectory);
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "MemoryFootprint.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <malloc.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace pipedal;
+
+static std::atomic<uint32_t> activeMeasurements;
+static std::atomic<uint64_t> measurementSequence; // incremented whenever a measurement starts.
+
+MemoryMeasurement::MemoryMeasurement()
+{
+    overlapped = activeMeasurements.fetch_add(1) != 0;
+    startSequence = ++measurementSequence;
+    startHeapBytes = GetHeapBytes();
+    startResidentBytes = GetResidentBytes();
+}
+
+MemoryMeasurement::~MemoryMeasurement()
+{
+    --activeMeasurements;
+}
+
+bool MemoryMeasurement::IsExclusive() const
+{
+    return !overlapped && measurementSequence.load() == startSequence;
+}
+
+uint64_t MemoryMeasurement::GetBytes() const
+{
+    uint64_t heapBytes = GetHeapBytes();
+    uint64_t residentBytes = GetResidentBytes();
+    uint64_t heapGrowth = heapBytes > startHeapBytes ? heapBytes - startHeapBytes : 0;
+    uint64_t residentGrowth = residentBytes > startResidentBytes ? residentBytes - startResidentBytes : 0;
+    return std::max(heapGrowth, residentGrowth);
+}
+
+uint64_t MemoryMeasurement::GetHeapBytes()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+uint64_t MemoryMeasurement::ParseStatmResidentBytes(const std::string &text, uint64_t pageSize)
+{
+    // size resident shared text lib data dt (in pages)
+    std::istringstream s(text);
+    uint64_t size = 0, resident = 0;
+    if (!(s >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * pageSize;
+}
+
+uint64_t MemoryMeasurement::GetResidentBytes()
+{
+    // statm is much cheaper to read than smaps_rollup, which walks every mapping.
+    std::ifstream f("/proc/self/statm");
+    if (!f)
+    {
+        return 0;
+    }
+    std::string line;
+    std::getline(f, line);
+    static uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+    return ParseStatmResidentBytes(line, pageSize);
+}
+
+JSON_MAP_BEGIN(PluginMemoryFootprint)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, instanceId)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, uri)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, instantiateBytes)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, restoreBytes)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, activateBytes)
+JSON_MAP_REFERENCE(PluginMemoryFootprint, exclusive)
+JSON_MAP_END()
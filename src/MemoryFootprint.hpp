@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include "json.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace pipedal
+{
+    // Memory used by one plugin instance, measured while it was created.
+    class PluginMemoryFootprint
+    {
+    public:
+        uint64_t instanceId_ = 0;
+        std::string uri_;
+        uint64_t instantiateBytes_ = 0;
+        uint64_t restoreBytes_ = 0; // state restore (which is where most plugins load models and impulse files).
+        uint64_t activateBytes_ = 0;
+        // false if other plugins were being created at the same time, in which case the figures include their allocations too.
+        bool exclusive_ = true;
+
+        bool recorded = false; // (not serialized) already added to the plugin cost database.
+
+        uint64_t TotalBytes() const { return instantiateBytes_ + restoreBytes_ + activateBytes_; }
+
+        DECLARE_JSON_MAP(PluginMemoryFootprint);
+    };
+
+    /**
+     * @brief Measures memory growth of the process over a scope.
+     *
+     * Growth is the larger of the change in malloc heap use (mallinfo2), and the change in resident set
+     * size (/proc/self/statm), which also captures memory-mapped model files and pages touched outside
+     * malloc. Both are process-wide, so concurrent allocations on other threads are included;
+     * IsExclusive() reports whether any other MemoryMeasurement overlapped this one.
+     */
+    class MemoryMeasurement
+    {
+    public:
+        MemoryMeasurement();
+        ~MemoryMeasurement();
+        MemoryMeasurement(const MemoryMeasurement &) = delete;
+        MemoryMeasurement &operator=(const MemoryMeasurement &) = delete;
+
+        // Bytes of growth since the measurement started.
+        uint64_t GetBytes() const;
+        bool IsExclusive() const;
+
+        static uint64_t GetHeapBytes();
+        static uint64_t GetResidentBytes();
+        // The resident set size, in bytes, from the contents of /proc/self/statm.
+        static uint64_t ParseStatmResidentBytes(const std::string &text, uint64_t pageSize);
+
+    private:
+        uint64_t startHeapBytes;
+        uint64_t startResidentBytes;
+        uint64_t startSequence;
+        bool overlapped;
+    };
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "MemoryFootprint.hpp"
+#include <cstring>
+#include <memory>
+#include <thread>
+
+using namespace pipedal;
+
+TEST_CASE("MemoryMeasurement", "[memory_footprint][Build][Dev]")
+{
+    REQUIRE(MemoryMeasurement::ParseStatmResidentBytes("12345 678 90 1 0 2000 0\n", 4096) == 678 * 4096);
+    REQUIRE(MemoryMeasurement::ParseStatmResidentBytes("", 4096) == 0);
+
+    REQUIRE(MemoryMeasurement::GetResidentBytes() != 0);
+
+    constexpr size_t SIZE = 32 * 1024 * 1024;
+    {
+        MemoryMeasurement measurement;
+        std::unique_ptr<char[]> block{new char[SIZE]};
+        memset(block.get(), 1, SIZE); // make it resident.
+        REQUIRE(measurement.GetBytes() >= SIZE);
+        REQUIRE(measurement.IsExclusive());
+    }
+    {
+        MemoryMeasurement measurement;
+        std::thread t([]()
+                      { MemoryMeasurement other; });
+        t.join();
+        REQUIRE(!measurement.IsExclusive());
+    }
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "MetricsPage.hpp"
+#include "Lv2Log.hpp"
+#include <cstring>
+#include <sstream>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+static constexpr char SHARED_PAGE_NAME[] = "/pipedal_metrics";
+
+MetricsPage &MetricsPage::GetInstance()
+{
+    static MetricsPage instance{SHARED_PAGE_NAME};
+    return instance;
+}
+
+MetricsPage::MetricsPage(const std::string &shmName)
+    : shmName(shmName)
+{
+    void *memory = MAP_FAILED;
+    if (!this->shmName.empty())
+    {
+        int fd = shm_open(this->shmName.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd != -1)
+        {
+            fchmod(fd, 0644); // not subject to umask.
+            if (ftruncate(fd, sizeof(PageData)) == 0)
+            {
+                memory = mmap(nullptr, sizeof(PageData), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+        }
+        if (memory == MAP_FAILED)
+        {
+            Lv2Log::warning("Unable to create shared metrics page %s. (%s)", this->shmName.c_str(), strerror(errno));
+            this->shmName.clear();
+        }
+    }
+    if (memory == MAP_FAILED)
+    {
+        memory = mmap(nullptr, sizeof(PageData), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+    }
+    // readers ignore the page until magic is set.
+    pageData = new (memory) PageData();
+    pageData->layoutVersion = LAYOUT_VERSION;
+    pageData->pid = (int32_t)getpid();
+    pageData->realtime.Write(RealtimeMetrics());
+    pageData->host.Write(HostMetrics());
+    std::atomic_thread_fence(std::memory_order_release);
+    pageData->magic = MAGIC;
+}
+
+MetricsPage::~MetricsPage()
+{
+    munmap(pageData, sizeof(PageData));
+    if (!shmName.empty())
+    {
+        shm_unlink(shmName.c_str());
+    }
+}
+
+void MetricsPage::Write(const RealtimeMetrics &metrics)
+{
+    pageData->realtime.Write(metrics);
+}
+void MetricsPage::Write(const HostMetrics &metrics)
+{
+    pageData->host.Write(metrics);
+}
+
+MetricsPage::RealtimeMetrics MetricsPage::ReadRealtime() const
+{
+    return pageData->realtime.Read();
+}
+MetricsPage::HostMetrics MetricsPage::ReadHost() const
+{
+    return pageData->host.Read();
+}
+
+MetricsPage::Snapshot MetricsPage::Read() const
+{
+    Snapshot result;
+    result.realtime = ReadRealtime();
+    result.host = ReadHost();
+    return result;
+}
+
+void MetricsPage::HostMetrics::SetGovernor(const std::string &governor)
+{
+    size_t length = std::min(governor.length(), sizeof(this->governor) - 1);
+    memcpy(this->governor, governor.c_str(), length);
+    this->governor[length] = '\0';
+}
+
+std::string MetricsPage::HostMetrics::GetGovernor() const
+{
+    return std::string(governor, strnlen(governor, sizeof(governor)));
+}
+
+static void WriteMetric(std::ostream &s, const char *name, const char *type, const char *help, double value)
+{
+    s << "# HELP " << name << " " << help << "\n"
+      << "# TYPE " << name << " " << type << "\n"
+      << name << " " << value << "\n";
+}
+
+std::string MetricsPage::ToPrometheusText(const Snapshot &snapshot)
+{
+    std::ostringstream s;
+    s.precision(15); // enough for ms timestamps, without binary noise.
+    const auto &host = snapshot.host;
+    const auto &realtime = snapshot.realtime;
+
+    WriteMetric(s, "pipedal_audio_active", "gauge", "1 if audio is running.", host.active);
+    WriteMetric(s, "pipedal_audio_restarting", "gauge", "1 if the audio stream is restarting.", host.restarting);
+    WriteMetric(s, "pipedal_audio_underruns_total", "counter", "Audio underruns since the audio stream started.", (double)realtime.underruns);
+    if (realtime.lastUnderrunTimeMs != 0)
+    {
+        WriteMetric(s, "pipedal_audio_last_underrun_timestamp_seconds", "gauge", "Time of the most recent underrun.", realtime.lastUnderrunTimeMs / 1000.0);
+    }
+    WriteMetric(s, "pipedal_audio_cpu_use_percent", "gauge", "Audio thread CPU use.", host.cpuUsage);
+    if (host.temperaturemC > -100000)
+    {
+        WriteMetric(s, "pipedal_cpu_temperature_celsius", "gauge", "CPU temperature.", host.temperaturemC / 1000.0);
+    }
+    if (host.cpuFreqMax != 0)
+    {
+        WriteMetric(s, "pipedal_cpu_frequency_min_hertz", "gauge", "Lowest current core frequency.", host.cpuFreqMin * 1000.0);
+        WriteMetric(s, "pipedal_cpu_frequency_max_hertz", "gauge", "Highest current core frequency.", host.cpuFreqMax * 1000.0);
+    }
+    if (host.throttled != -1)
+    {
+        WriteMetric(s, "pipedal_cpu_throttled_flags", "gauge", "Raspberry Pi firmware throttling flags (as reported by vcgencmd get_throttled).", host.throttled);
+    }
+    if (host.hasCpuGovernor)
+    {
+        s << "# HELP pipedal_cpu_governor_info The current CPU governor.\n"
+          << "# TYPE pipedal_cpu_governor_info gauge\n"
+          << "pipedal_cpu_governor_info{governor=\"" << host.GetGovernor() << "\"} 1\n";
+    }
+    if (host.updateTimeMs != 0)
+    {
+        WriteMetric(s, "pipedal_metrics_update_timestamp_seconds", "gauge", "Time the host metrics were last updated.", host.updateTimeMs / 1000.0);
+    }
+    return s.str();
+}
@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Seqlock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+namespace pipedal
+{
+    /**
+     * @brief Audio status metrics, published in a shared-memory page.
+     *
+     * The audio thread and the audio service thread write directly into the page; the websocket status request,
+     * the /var/metrics (Prometheus) endpoint, and external monitoring tools read it without taking any locks.
+     *
+     * The page is /dev/shm/pipedal_metrics (mode 0644). External readers should check magic and layoutVersion,
+     * and read each section with the seqlock protocol: read sequence (retry if odd), copy the data, then re-read
+     * sequence (retry if it changed).
+     */
+    class MetricsPage
+    {
+    public:
+        static constexpr uint32_t MAGIC = 0x584D5050; // "PPMX"
+        static constexpr uint32_t LAYOUT_VERSION = 2;
+
+        // Written by the audio thread.
+        struct RealtimeMetrics
+        {
+            uint64_t underruns = 0;
+            int64_t lastUnderrunTimeMs = 0; // system clock, ms since the epoch. 0 if none.
+        };
+
+        // Written by the audio service thread, about once a second.
+        struct HostMetrics
+        {
+            int64_t updateTimeMs = 0; // system clock, ms since the epoch.
+            uint8_t active = 0;
+            uint8_t restarting = 0;
+            uint8_t hasCpuGovernor = 0;
+            float cpuUsage = 0;            // percent.
+            int32_t temperaturemC = -100000; // -100000 if not available.
+            uint64_t cpuFreqMin = 0;        // kHz.
+            uint64_t cpuFreqMax = 0;        // kHz.
+            int32_t throttled = -1;         // Raspberry Pi firmware throttling flags. -1 if not available.
+            char governor[32] = {};         // nul-terminated.
+
+            void SetGovernor(const std::string &governor);
+            std::string GetGovernor() const;
+        };
+
+        struct Snapshot
+        {
+            RealtimeMetrics realtime;
+            HostMetrics host;
+        };
+
+        // The process-wide page, /dev/shm/pipedal_metrics. Falls back to private memory if shared memory isn't available.
+        static MetricsPage &GetInstance();
+
+        // shmName: a shm_open name (e.g. "/pipedal_metrics"), or empty for a private, in-process page.
+        MetricsPage(const std::string &shmName);
+        ~MetricsPage();
+        MetricsPage(const MetricsPage &) = delete;
+        MetricsPage &operator=(const MetricsPage &) = delete;
+
+        bool IsShared() const { return !shmName.empty(); }
+
+        // Realtime-safe (no allocation, no locks, no syscalls).
+        void Write(const RealtimeMetrics &metrics);
+        void Write(const HostMetrics &metrics);
+
+        // Lock-free. Retries while a writer is mid-update.
+        RealtimeMetrics ReadRealtime() const;
+        HostMetrics ReadHost() const;
+        Snapshot Read() const;
+
+        // Prometheus text exposition format.
+        static std::string ToPrometheusText(const Snapshot &snapshot);
+
+    private:
+        struct PageData
+        {
+            uint32_t magic;
+            uint32_t layoutVersion;
+            int32_t pid;
+            Seqlock<RealtimeMetrics> realtime;
+            Seqlock<HostMetrics> host;
+        };
+        static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+                      "Shared-memory seqlocks require address-free (lock-free) atomics.");
+
+        std::string shmName;
+        PageData *pageData = nullptr;
+    };
+}
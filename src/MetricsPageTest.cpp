@@ -0,0 +1,105 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "MetricsPage.hpp"
+#include <atomic>
+#include <thread>
+
+using namespace pipedal;
+
+TEST_CASE("MetricsPage read/write", "[metrics_page][Build][Dev]")
+{
+    MetricsPage page{""};
+
+    MetricsPage::RealtimeMetrics realtime;
+    realtime.underruns = 3;
+    realtime.lastUnderrunTimeMs = 1700000000123;
+    page.Write(realtime);
+
+    MetricsPage::HostMetrics host;
+    host.active = 1;
+    host.cpuUsage = 42.5f;
+    host.temperaturemC = 51234;
+    host.cpuFreqMin = 600000;
+    host.cpuFreqMax = 1800000;
+    host.throttled = 0x50000;
+    host.hasCpuGovernor = 1;
+    host.SetGovernor("performance");
+    host.updateTimeMs = 1700000000000;
+    page.Write(host);
+
+    MetricsPage::Snapshot snapshot = page.Read();
+    REQUIRE(snapshot.realtime.underruns == 3);
+    REQUIRE(snapshot.realtime.lastUnderrunTimeMs == 1700000000123);
+    REQUIRE(snapshot.host.cpuUsage == 42.5f);
+    REQUIRE(snapshot.host.temperaturemC == 51234);
+    REQUIRE(snapshot.host.GetGovernor() == "performance");
+
+    std::string text = MetricsPage::ToPrometheusText(snapshot);
+    REQUIRE(text.find("pipedal_audio_underruns_total 3\n") != std::string::npos);
+    REQUIRE(text.find("# TYPE pipedal_audio_underruns_total counter\n") != std::string::npos);
+    REQUIRE(text.find("pipedal_cpu_temperature_celsius 51.234\n") != std::string::npos);
+    REQUIRE(text.find("pipedal_cpu_governor_info{governor=\"performance\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("pipedal_cpu_throttled_flags 327680\n") != std::string::npos);
+
+    host.SetGovernor(std::string(100, 'x')); // truncated, still terminated.
+    REQUIRE(host.GetGovernor().length() == sizeof(host.governor) - 1);
+}
+
+TEST_CASE("MetricsPage seqlock", "[metrics_page][Build][Dev]")
+{
+    MetricsPage page{""};
+
+    // Readers must never see a half-written section.
+    std::atomic<bool> done{false};
+    std::thread writer([&]()
+                       {
+        MetricsPage::RealtimeMetrics metrics;
+        for (uint64_t i = 1; i <= 200000; ++i)
+        {
+            metrics.underruns = i;
+            metrics.lastUnderrunTimeMs = (int64_t)i;
+            page.Write(metrics);
+        }
+        done = true; });
+
+    bool torn = false;
+    uint64_t lastSeen = 0;
+    bool backwards = false;
+    while (!done)
+    {
+        auto metrics = page.ReadRealtime();
+        if ((int64_t)metrics.underruns != metrics.lastUnderrunTimeMs)
+        {
+            torn = true;
+        }
+        if (metrics.underruns < lastSeen)
+        {
+            backwards = true;
+        }
+        lastSeen = metrics.underruns;
+    }
+    writer.join();
+    REQUIRE(!torn);
+    REQUIRE(!backwards);
+    REQUIRE(page.ReadRealtime().underruns == 200000);
+}
@@ -21,6 +21,7 @@
 
 #include "json.hpp"
 #include <cstdint>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <lv2/urid/urid.h>
@@ -141,6 +142,24 @@ public:
         else if (controlRange > 1) controlRange = 1;
         return maxValue_*controlRange+minValue_*(1.0f-controlRange);
     }
+    // inverse of calculateRange: the controller value that would produce range.
+    uint8_t calculateControlValue(float range) const
+    {
+        float controlRange;
+        if (maxValue_ == minValue_)
+        {
+            controlRange = 0;
+        } else {
+            controlRange = (range-minValue_)/(maxValue_-minValue_);
+        }
+        if (!(controlRange >= 0)) controlRange = 0;
+        else if (controlRange > 1) controlRange = 1;
+        float value = minControlValue_ + controlRange*((float)maxControlValue_-(float)minControlValue_);
+        int result = (int)std::round(value);
+        if (result < 0) result = 0;
+        else if (result > 127) result = 127;
+        return (uint8_t)result;
+    }
     DECLARE_JSON_MAP(MidiBinding);
 
 };
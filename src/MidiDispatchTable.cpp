@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "MidiDispatchTable.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace pipedal;
+
+void MidiDispatchTable::Add(MessageType messageType, int channel, uint8_t index, uint16_t target)
+{
+    if (channel == -1)
+    {
+        for (uint8_t c = 0; c < CHANNELS; ++c)
+        {
+            entries.push_back(Entry{(uint32_t)SlotIndex(messageType, c, index), target});
+        }
+    }
+    else
+    {
+        entries.push_back(Entry{(uint32_t)SlotIndex(messageType, (uint8_t)channel, index), target});
+    }
+}
+
+void MidiDispatchTable::Build()
+{
+    if (entries.size() > UINT16_MAX)
+    {
+        throw std::runtime_error("Too many MIDI bindings.");
+    }
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Entry &left, const Entry &right)
+                     { return left.slot < right.slot; });
+
+    targets.clear();
+    slots.clear();
+    if (entries.empty())
+    {
+        return;
+    }
+    slots.resize(MESSAGE_TYPES * CHANNELS * INDEXES);
+    targets.reserve(entries.size());
+    for (const Entry &entry : entries)
+    {
+        Slot &slot = slots[entry.slot];
+        if (slot.begin == slot.end)
+        {
+            slot.begin = (uint16_t)targets.size();
+        }
+        targets.push_back(entry.target);
+        slot.end = (uint16_t)targets.size();
+    }
+    entries.clear();
+}
+
+void MidiDispatchTable::Clear()
+{
+    entries.clear();
+    slots.clear();
+    targets.clear();
+}
+
+MidiDispatchTable::Range MidiDispatchTable::Find(const uint8_t *message, size_t size) const
+{
+    if (size < 2)
+        return Range();
+    uint8_t channel = message[0] & 0x0F;
+    switch (message[0] & 0xF0)
+    {
+    case 0x80: // note off.
+    case 0x90: // note on.
+        return Find(MessageType::Note, channel, message[1]);
+    case 0xB0:
+        if (size < 3)
+            return Range();
+        return Find(MessageType::Control, channel, message[1]);
+    case 0xC0:
+        return Find(MessageType::ProgramChange, channel, message[1]);
+    default:
+        return Range();
+    }
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Maps MIDI note, control and program change messages directly to the bindings they trigger.
+     *
+     * Targets are added on a non-realtime thread, and Build() lays them out as a dense
+     * [message type][channel][note/control/program] table of ranges into a single array of
+     * targets, so that Find() is a table lookup. Targets bound to the same message are
+     * returned in the order they were added.
+     */
+    class MidiDispatchTable
+    {
+    public:
+        enum class MessageType : uint8_t
+        {
+            Note = 0, // note on and note off.
+            Control = 1,
+            ProgramChange = 2,
+        };
+        static constexpr size_t MESSAGE_TYPES = 3;
+        static constexpr size_t CHANNELS = 16;
+        static constexpr size_t INDEXES = 128;
+
+        struct Range
+        {
+            const uint16_t *begin_ = nullptr;
+            const uint16_t *end_ = nullptr;
+
+            const uint16_t *begin() const { return begin_; }
+            const uint16_t *end() const { return end_; }
+            bool empty() const { return begin_ == end_; }
+            size_t size() const { return (size_t)(end_ - begin_); }
+        };
+
+        // channel == -1 binds all channels.
+        void Add(MessageType messageType, int channel, uint8_t index, uint16_t target);
+        void Build();
+        void Clear();
+
+        bool IsEmpty() const { return targets.empty(); }
+
+        Range Find(MessageType messageType, uint8_t channel, uint8_t index) const
+        {
+            if (slots.empty())
+                return Range();
+            const Slot &slot = slots[SlotIndex(messageType, channel, index)];
+            return Range{targets.data() + slot.begin, targets.data() + slot.end};
+        }
+        // Realtime-safe.
+        Range Find(const uint8_t *message, size_t size) const;
+
+    private:
+        static size_t SlotIndex(MessageType messageType, uint8_t channel, uint8_t index)
+        {
+            return ((size_t)messageType * CHANNELS + (channel & 0x0F)) * INDEXES + (index & 0x7F);
+        }
+        struct Slot
+        {
+            uint16_t begin = 0;
+            uint16_t end = 0;
+        };
+        struct Entry
+        {
+            uint32_t slot;
+            uint16_t target;
+        };
+        std::vector<Entry> entries;
+        std::vector<Slot> slots;
+        std::vector<uint16_t> targets;
+    };
+}
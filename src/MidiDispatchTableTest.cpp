@@ -0,0 +1,73 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <vector>
+#include "MidiDispatchTable.hpp"
+
+using namespace pipedal;
+
+static std::vector<uint16_t> FindTargets(const MidiDispatchTable &table, std::vector<uint8_t> message)
+{
+    std::vector<uint16_t> result;
+    for (uint16_t target : table.Find(message.data(), message.size()))
+    {
+        result.push_back(target);
+    }
+    return result;
+}
+
+TEST_CASE("MidiDispatchTable test", "[midi_dispatch_table][Build][Dev]")
+{
+    using MessageType = MidiDispatchTable::MessageType;
+
+    MidiDispatchTable table;
+    REQUIRE(FindTargets(table, {0xB0, 7, 100}).empty());
+
+    table.Add(MessageType::Control, -1, 7, 3);
+    table.Add(MessageType::Note, 2, 60, 1);
+    table.Add(MessageType::Control, 4, 7, 0);
+    table.Add(MessageType::ProgramChange, -1, 5, 2);
+    table.Build();
+    REQUIRE(!table.IsEmpty());
+
+    // all channels.
+    REQUIRE(FindTargets(table, {0xB0, 7, 100}) == std::vector<uint16_t>{3});
+    REQUIRE(FindTargets(table, {0xBF, 7, 0}) == std::vector<uint16_t>{3});
+    // in the order added.
+    REQUIRE(FindTargets(table, {0xB4, 7, 100}) == std::vector<uint16_t>{3, 0});
+    REQUIRE(FindTargets(table, {0xB0, 8, 100}).empty());
+
+    // note on and note off, on one channel only.
+    REQUIRE(FindTargets(table, {0x92, 60, 100}) == std::vector<uint16_t>{1});
+    REQUIRE(FindTargets(table, {0x82, 60, 0}) == std::vector<uint16_t>{1});
+    REQUIRE(FindTargets(table, {0x93, 60, 100}).empty());
+
+    REQUIRE(FindTargets(table, {0xC9, 5}) == std::vector<uint16_t>{2});
+
+    // other messages, and short messages.
+    REQUIRE(FindTargets(table, {0xE0, 7, 100}).empty());
+    REQUIRE(FindTargets(table, {0xB0, 7}).empty());
+    REQUIRE(FindTargets(table, {0xB0}).empty());
+
+    table.Clear();
+    REQUIRE(table.IsEmpty());
+    REQUIRE(FindTargets(table, {0xB0, 7, 100}).empty());
+}
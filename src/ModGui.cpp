@@ -187,40 +187,77 @@ ModGui::ModGui(
 }
 
 
-ModGui::ptr ModGui::Create(PluginHost *lv2Host, const LilvPlugin *lilvPlugin)
+bool ModGui::FindModGuiNode(PluginHost *lv2Host, const LilvPlugin *lilvPlugin, AutoLilvNode *modGuiNode, std::string *resourceDirectory)
 {
-
     LilvWorld *pWorld = lv2Host->getWorld();
     ModGuiUris &modGuiUrids = *(lv2Host->mod_gui_uris);
 
-    AutoLilvNode modGuiUri;
-    std::string resourceDirectory;
+    AutoLilvNode &modGuiUri = *modGuiNode;
 
     AutoLilvNodes modGuiNodes = lilv_plugin_get_value(lilvPlugin,modGuiUrids.mod_gui__gui);
-
     if (!modGuiNodes) {
-        return nullptr; // no mod gui found.
+        return false; // no mod gui found.
     }
     LILV_FOREACH(nodes, it, modGuiNodes.Get()) {
         AutoLilvNode node  = lilv_nodes_get(modGuiNodes.Get(), it);
 
         AutoLilvNode resourceDir = lilv_world_get(pWorld, node, modGuiUrids.mod_gui__resourceDirectory,nullptr);
         if (resourceDir) {
-            resourceDirectory = lilv_file_uri_parse(lilv_node_as_string(resourceDir),nullptr);
+            *resourceDirectory = lilv_file_uri_parse(lilv_node_as_string(resourceDir),nullptr);
             modGuiUri = lilv_node_duplicate(node);
         } else {
-            resourceDirectory.clear();
+            resourceDirectory->clear();
             modGuiUri.Free();
         }
     }
     if (!modGuiUri) {
-        return nullptr; // no mod gui found.
+        return false; // no mod gui found.
     }
+    return true;
+}
 
+ModGui::ptr ModGui::Create(PluginHost *lv2Host, const LilvPlugin *lilvPlugin)
+{
+    AutoLilvNode modGuiUri;
+    std::string resourceDirectory;
+    if (!FindModGuiNode(lv2Host, lilvPlugin, &modGuiUri, &resourceDirectory))
+    {
+        return nullptr;
+    }
 
     return std::shared_ptr<ModGui>(new ModGui(lv2Host, lilvPlugin, resourceDirectory, modGuiUri.Get()));
 }
 
+ModGui::ptr ModGui::CreateSummary(PluginHost *lv2Host, const LilvPlugin *lilvPlugin)
+{
+    AutoLilvNode modGuiUri;
+    std::string resourceDirectory;
+    if (!FindModGuiNode(lv2Host, lilvPlugin, &modGuiUri, &resourceDirectory))
+    {
+        return nullptr;
+    }
+    LilvWorld *pWorld = lv2Host->getWorld();
+    ModGuiUris &modGuiUrids = *lv2Host->mod_gui_uris;
+
+    ModGui::ptr result = std::make_shared<ModGui>();
+    result->pluginUri_ = lilv_node_as_uri(lilv_plugin_get_uri(lilvPlugin));
+    result->resourceDirectory_ = resourceDirectory;
+
+    AutoLilvNode modguiIcon = lilv_world_get(pWorld, modGuiUri, modGuiUrids.mod_gui__iconTemplate, nullptr);
+    if (modguiIcon) {
+        result->iconTemplate_ = NonNull(lilv_file_uri_parse(lilv_node_as_string(modguiIcon), nullptr));
+    }
+    AutoLilvNode modguiStylesheet = lilv_world_get(pWorld, modGuiUri, modGuiUrids.mod_gui__stylesheet, nullptr);
+    if (modguiStylesheet) {
+        result->stylesheet_ = NonNull(lilv_file_uri_parse(lilv_node_as_string(modguiStylesheet), nullptr));
+    }
+    AutoLilvNode knob = lilv_world_get(pWorld, modGuiUri, modGuiUrids.mod_gui__knob, nullptr);
+    if (knob) {
+        result->knob_ = NonNull(lilv_node_as_string(knob));
+    }
+    return result;
+}
+
 
 ModGuiPort::ModGuiPort(PluginHost *lv2Host, const LilvNode *portNode)
 {
@@ -323,24 +360,23 @@ static std::string AtomTypeToRangesType(const std::string& atomType)
     return "?";
 }
 json_variant pipedal::MakeModGuiTemplateData(
-    std::shared_ptr<Lv2PluginInfo> pluginInfo)
+    std::shared_ptr<Lv2PluginInfo> pluginInfo,
+    const ModGui &modGui)
 {
     json_variant context = json_variant::make_object();
     auto &contextObj = *(context.as_object());
 
-    auto modGui = pluginInfo->modGui();
-
-    contextObj["brand"] = modGui->brand();
-    contextObj["label"] = modGui->label();
-    contextObj["model"] = modGui->model();
-    contextObj["panel"] = modGui->panel();
-    contextObj["color"] = modGui->color();
-    contextObj["knob"] = modGui->knob();
+    contextObj["brand"] = modGui.brand();
+    contextObj["label"] = modGui.label();
+    contextObj["model"] = modGui.model();
+    contextObj["panel"] = modGui.panel();
+    contextObj["color"] = modGui.color();
+    contextObj["knob"] = modGui.knob();
 
     json_variant controls = json_variant::make_array();
     auto &controlArray = *controls.as_array();
     size_t ix = 0;
-    for (const auto& modGuiPort : modGui->ports())
+    for (const auto& modGuiPort : modGui.ports())
     {
         const Lv2PortInfo &pluginPort = pluginInfo->getPort(modGuiPort.symbol());
         if (!pluginPort.is_control_port() || !pluginPort.is_input() || pluginPort.not_on_gui())
@@ -92,7 +92,11 @@ namespace pipedal
     public:
         using self = ModGui;
         using ptr = std::shared_ptr<self>;
+        // The full ModGui, including ports. Requires the plugin's data files to have been loaded.
         static ptr Create(PluginHost *lv2Host, const LilvPlugin *lilvPlugin);
+        // Just the fields that the plugin list needs (resourceDirectory, iconTemplate, stylesheet and knob),
+        // or null if the plugin has no ModGui. Use PluginHost::GetModGui() to get the rest.
+        static ptr CreateSummary(PluginHost *lv2Host, const LilvPlugin *lilvPlugin);
 
         ModGui() = default;
         virtual ~ModGui() = default;
@@ -103,6 +107,8 @@ namespace pipedal
         ModGui &operator=(ModGui &&) = default;
 
     private:
+        static bool FindModGuiNode(PluginHost *lv2Host, const LilvPlugin *lilvPlugin, AutoLilvNode *modGuiNode, std::string *resourceDirectory);
+
         std::string pluginUri_;
         
         std::string resourceDirectory_;
@@ -174,7 +180,8 @@ namespace pipedal
     };
 
     json_variant MakeModGuiTemplateData(
-        std::shared_ptr<Lv2PluginInfo> pluginInfo
+        std::shared_ptr<Lv2PluginInfo> pluginInfo,
+        const ModGui &modGui
     );
 
 }
\ No newline at end of file
@@ -49,7 +49,9 @@ public:
             if (plugin->modGui())
             {
                 modGuicount++;
-                const auto&modGui = plugin->modGui();
+                REQUIRE(!plugin->modGui()->iconTemplate().empty());
+                const auto&modGui = model.GetModGui(plugin->uri());
+                REQUIRE(modGui != nullptr);
                 REQUIRE(!modGui->iconTemplate().empty());
                 REQUIRE(modGui->javascript().empty());
                 REQUIRE(!modGui->stylesheet().empty());
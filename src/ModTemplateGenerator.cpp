@@ -24,6 +24,9 @@
 #include "ModTemplateGenerator.hpp"
 #include <fstream>
 #include <sstream>
+#include <map>
+#include <mutex>
+#include <vector>
 #include "util.hpp"
 
 namespace fs = std::filesystem;
@@ -117,12 +120,47 @@ namespace pipedal
             VariableContext *parent;
         };
 
-        static std::string GenerateTemplateFromString(
-            const std::string &content,
-            VariableContext &context)
+        struct TemplateNode
         {
+            enum class NodeType
+            {
+                Text,
+                Variable,       // {{name}}
+                RawVariable,    // {{{name}}}
+                Section,        // {{#name}}...{{/name}}
+                IndexedSection, // {{#name.N}}...{{/name.N}}
+                Error,          // thrown if rendered, which is when the original parse failure would have been seen.
+            };
+            NodeType nodeType = NodeType::Text;
+            std::string text; // text, variable name, or error message.
+            std::string arrayName;
+            int64_t arrayIndex = 0;
+            std::vector<TemplateNode> children;
+        };
 
-            std::stringstream ss;
+        static void ParseTemplate(
+            const std::string &content,
+            std::vector<TemplateNode> &nodes)
+        {
+            std::string text;
+            auto flushText = [&text, &nodes]()
+            {
+                if (!text.empty())
+                {
+                    TemplateNode node;
+                    node.text = std::move(text);
+                    nodes.push_back(std::move(node));
+                    text.clear();
+                }
+            };
+            auto addError = [&nodes, &flushText](const std::string &message)
+            {
+                flushText();
+                TemplateNode node;
+                node.nodeType = TemplateNode::NodeType::Error;
+                node.text = message;
+                nodes.push_back(std::move(node));
+            };
 
             size_t ix = 0;
             size_t end = content.length();
@@ -132,7 +170,7 @@ namespace pipedal
                 char c = content[ix++];
                 if (c != '{')
                 {
-                    ss << c;
+                    text += c;
                     continue;
                 }
                 if (ix >= end)
@@ -142,8 +180,8 @@ namespace pipedal
                 c = content[ix++];
                 if (c != '{')
                 {
-                    ss << '{';
-                    ss << c;
+                    text += '{';
+                    text += c;
                     continue;
                 }
                 if (ix < end && content[ix] == '{')
@@ -153,21 +191,15 @@ namespace pipedal
                     size_t endTagPos = content.find("}}}", ix);
                     if (endTagPos == std::string::npos)
                     {
-                        throw std::runtime_error("Unmatched opening tag '{{{' in template.");
+                        addError("Unmatched opening tag '{{{' in template.");
+                        return;
                     }
-                    std::string variableString = content.substr(ix, endTagPos - ix);
+                    flushText();
+                    TemplateNode node;
+                    node.nodeType = TemplateNode::NodeType::RawVariable;
+                    node.text = content.substr(ix, endTagPos - ix);
+                    nodes.push_back(std::move(node));
                     ix = endTagPos + 3; // Move past the closing '}}}'
-                    auto result = context.getVariable("_" + variableString);
-                    if (result.is_null())
-                    {
-                        result = ""; // Default to empty string if variable not found
-                    }
-                    if (!result.is_string())
-                    {
-                        throw std::runtime_error("Variable '" + variableString + "' is not a string.");
-                    }
-                    ss << result.as_string();
-                    continue;
                 }
                 else
                 {
@@ -175,23 +207,19 @@ namespace pipedal
                     size_t endTagPos = content.find("}}", ix);
                     if (endTagPos == std::string::npos)
                     {
-                        throw std::runtime_error("Unmatched opening tag '{{' in template.");
+                        addError("Unmatched opening tag '{{' in template.");
+                        return;
                     }
                     std::string variableString = content.substr(ix, endTagPos - ix);
                     ix = endTagPos + 2; // Move past the closing '}}'
                     if (!variableString.starts_with("#"))
                     {
                         // a straightforward variable substitution.
-                        json_variant value = context.getVariable(variableString);
-                        if (value.is_null())
-                        {
-                            value = ""; // Default to empty string if variable not found
-                        }
-                        if (!value.is_string())
-                        {
-                            throw std::runtime_error("Variable '" + variableString + "' is not a string.");
-                        }
-                        ss << value.as_string();
+                        flushText();
+                        TemplateNode node;
+                        node.nodeType = TemplateNode::NodeType::Variable;
+                        node.text = std::move(variableString);
+                        nodes.push_back(std::move(node));
                     }
                     else
                     {
@@ -201,83 +229,175 @@ namespace pipedal
                         size_t endTagPos = content.find(endTag, ix);
                         if (endTagPos == std::string::npos)
                         {
-                            throw std::runtime_error("Unmatched opening tag for  '" + variableString + "' in template.");
+                            addError("Unmatched opening tag for  '" + variableString + "' in template.");
+                            return;
                         }
+                        flushText();
 
-                        std::string arrayContent = content.substr(ix, endTagPos - ix);
-
+                        TemplateNode node;
+                        node.nodeType = TemplateNode::NodeType::Section;
+                        node.text = variableName;
                         if (variableEndsWithNumber(variableName))
                         {
-                            std::string arrayName;
-                            int64_t arrayIndex = 0;
-                            splitIndexedArrayVariable(variableName, arrayName, arrayIndex);
-
-                            json_variant array = context.getVariable(arrayName);
-                            auto &arrayValue = *array.as_array();
-                            if (arrayIndex >= 0 && arrayIndex < static_cast<int64_t>(arrayValue.size()))
+                            node.nodeType = TemplateNode::NodeType::IndexedSection;
+                            try
                             {
-                                json_variant contextValue = arrayValue[(size_t)arrayIndex];
-                                // variable frame.
-                                VariableContext itemContext{contextValue, &context};
-
-                                ss << GenerateTemplateFromString(
-                                    arrayContent,
-                                    itemContext);
+                                splitIndexedArrayVariable(variableName, node.arrayName, node.arrayIndex);
                             }
-                        }
-                        else
-                        {
-                            json_variant variable = context.getVariable(variableName);
-                            if (variable.is_array())
-                            {
-                                auto &arrayValue = *variable.as_array();
-
-                                for (auto iter = arrayValue.begin(); iter != arrayValue.end(); ++iter)
-                                {
-                                    // variable frame.
-                                    VariableContext itemContext{*iter, &context};
-
-                                    ss << GenerateTemplateFromString(
-                                        arrayContent,
-                                        itemContext);
-                                }
-                            } else if (variable.is_object()) 
+                            catch (const std::exception &e)
                             {
-                                VariableContext itemContext(variable,&context);
-                                ss << GenerateTemplateFromString(
-                                    arrayContent,
-                                    itemContext);
+                                addError(e.what());
+                                return;
                             }
                         }
+                        ParseTemplate(content.substr(ix, endTagPos - ix), node.children);
+                        nodes.push_back(std::move(node));
 
                         ix = endTagPos + endTag.length(); // Move past the closing tag
                     }
                 }
             }
-            return ss.str();
+            flushText();
         }
+
+        static void RenderTemplate(
+            const std::vector<TemplateNode> &nodes,
+            VariableContext &context,
+            std::string &output)
+        {
+            for (const TemplateNode &node : nodes)
+            {
+                switch (node.nodeType)
+                {
+                case TemplateNode::NodeType::Text:
+                    output += node.text;
+                    break;
+                case TemplateNode::NodeType::RawVariable:
+                {
+                    auto result = context.getVariable("_" + node.text);
+                    if (result.is_null())
+                    {
+                        result = ""; // Default to empty string if variable not found
+                    }
+                    if (!result.is_string())
+                    {
+                        throw std::runtime_error("Variable '" + node.text + "' is not a string.");
+                    }
+                    output += result.as_string();
+                    break;
+                }
+                case TemplateNode::NodeType::Variable:
+                {
+                    json_variant value = context.getVariable(node.text);
+                    if (value.is_null())
+                    {
+                        value = ""; // Default to empty string if variable not found
+                    }
+                    if (!value.is_string())
+                    {
+                        throw std::runtime_error("Variable '" + node.text + "' is not a string.");
+                    }
+                    output += value.as_string();
+                    break;
+                }
+                case TemplateNode::NodeType::IndexedSection:
+                {
+                    json_variant array = context.getVariable(node.arrayName);
+                    auto &arrayValue = *array.as_array();
+                    if (node.arrayIndex >= 0 && node.arrayIndex < static_cast<int64_t>(arrayValue.size()))
+                    {
+                        json_variant contextValue = arrayValue[(size_t)node.arrayIndex];
+                        // variable frame.
+                        VariableContext itemContext{contextValue, &context};
+                        RenderTemplate(node.children, itemContext, output);
+                    }
+                    break;
+                }
+                case TemplateNode::NodeType::Section:
+                {
+                    json_variant variable = context.getVariable(node.text);
+                    if (variable.is_array())
+                    {
+                        auto &arrayValue = *variable.as_array();
+
+                        for (auto iter = arrayValue.begin(); iter != arrayValue.end(); ++iter)
+                        {
+                            // variable frame.
+                            VariableContext itemContext{*iter, &context};
+                            RenderTemplate(node.children, itemContext, output);
+                        }
+                    }
+                    else if (variable.is_object())
+                    {
+                        VariableContext itemContext(variable, &context);
+                        RenderTemplate(node.children, itemContext, output);
+                    }
+                    break;
+                }
+                case TemplateNode::NodeType::Error:
+                    throw std::runtime_error(node.text);
+                }
+            }
+        }
+
+        class ModTemplateImpl : public ModTemplate
+        {
+        public:
+            ModTemplateImpl(const std::string &templateString)
+            {
+                ParseTemplate(templateString, nodes);
+            }
+            virtual std::string Render(const json_variant &data) const override
+            {
+                VariableContext context{data, nullptr};
+                std::string result;
+                RenderTemplate(nodes, context, result);
+                return result;
+            }
+
+        private:
+            std::vector<TemplateNode> nodes;
+        };
+
+        struct CachedTemplate
+        {
+            fs::file_time_type lastWriteTime;
+            uintmax_t fileSize = 0;
+            ModTemplate::ptr modTemplate;
+        };
+        static std::mutex templateCacheMutex;
+        static std::map<fs::path, CachedTemplate> templateCache;
     }
     using namespace impl;
 
-    std::string GenerateFromTemplateString(
-        const std::string &templateString,
-        const json_variant &data)
+    ModTemplate::ptr ModTemplate::Parse(const std::string &templateString)
     {
-        VariableContext context{data, nullptr};
-        return impl::GenerateTemplateFromString(
-            templateString,
-            context);
+        return std::make_shared<ModTemplateImpl>(templateString);
     }
 
-    std::string GenerateFromTemplateFile(
-        const std::filesystem::path &templateFilePath,
-        const json_variant &data)
+    ModTemplate::ptr ModTemplate::Load(const std::filesystem::path &templateFilePath)
     {
-        std::string templateContent;
-        if (!fs::exists(templateFilePath))
+        std::error_code ec;
+        fs::file_time_type lastWriteTime = fs::last_write_time(templateFilePath, ec);
+        if (ec)
+        {
+            throw std::runtime_error("Template file not found: " + templateFilePath.string());
+        }
+        uintmax_t fileSize = fs::file_size(templateFilePath, ec);
+        if (ec)
         {
             throw std::runtime_error("Template file not found: " + templateFilePath.string());
         }
+        {
+            std::lock_guard<std::mutex> lock(templateCacheMutex);
+            auto ff = templateCache.find(templateFilePath);
+            if (ff != templateCache.end() && ff->second.lastWriteTime == lastWriteTime && ff->second.fileSize == fileSize)
+            {
+                return ff->second.modTemplate;
+            }
+        }
+
+        std::string templateContent;
         std::ifstream file(templateFilePath);
         if (!file.is_open())
         {
@@ -287,9 +407,24 @@ namespace pipedal
                                std::istreambuf_iterator<char>());
         file.close();
 
-        return GenerateFromTemplateString(
-            templateContent,
-            data);
+        ModTemplate::ptr result = Parse(templateContent);
+
+        std::lock_guard<std::mutex> lock(templateCacheMutex);
+        templateCache[templateFilePath] = CachedTemplate{lastWriteTime, fileSize, result};
+        return result;
     }
 
-}
\ No newline at end of file
+    std::string GenerateFromTemplateString(
+        const std::string &templateString,
+        const json_variant &data)
+    {
+        return ModTemplate::Parse(templateString)->Render(data);
+    }
+
+    std::string GenerateFromTemplateFile(
+        const std::filesystem::path &templateFilePath,
+        const json_variant &data)
+    {
+        return ModTemplate::Load(templateFilePath)->Render(data);
+    }
+}
@@ -25,10 +25,32 @@
 
 #include <filesystem>
 #include <string>
+#include <memory>
 #include "json_variant.hpp"
 
 namespace pipedal
 {
+    // A template that has been parsed once, and can be rendered repeatedly.
+    class ModTemplate
+    {
+    protected:
+        ModTemplate() {}
+
+    public:
+        using self = ModTemplate;
+        using ptr = std::shared_ptr<const self>;
+
+        virtual ~ModTemplate() = default;
+
+        static ptr Parse(const std::string &templateString);
+
+        // Parsed files are cached, and reparsed only when the file changes. Returns the same
+        // pointer until then.
+        static ptr Load(const std::filesystem::path &templateFilePath);
+
+        virtual std::string Render(const json_variant &data) const = 0;
+    };
+
     std::string GenerateFromTemplateString(
         const std::string& templateString,
         const json_variant& data
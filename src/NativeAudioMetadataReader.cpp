@@ -0,0 +1,996 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "NativeAudioMetadataReader.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+namespace
+{
+    // Bounds-checked view of a region of the file.
+    class Span
+    {
+    public:
+        Span() {}
+        Span(const uint8_t *data, size_t size) : data(data), size_(size) {}
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+        const uint8_t *begin() const { return data; }
+
+        bool has(size_t offset, size_t length) const
+        {
+            return offset <= size_ && length <= size_ - offset;
+        }
+        Span sub(size_t offset, size_t length) const
+        {
+            if (!has(offset, length))
+            {
+                return Span();
+            }
+            return Span(data + offset, length);
+        }
+        Span from(size_t offset) const
+        {
+            if (offset > size_)
+            {
+                return Span();
+            }
+            return Span(data + offset, size_ - offset);
+        }
+        uint8_t u8(size_t offset) const { return has(offset, 1) ? data[offset] : 0; }
+        uint16_t u16be(size_t offset) const
+        {
+            return has(offset, 2) ? (uint16_t)((data[offset] << 8) | data[offset + 1]) : 0;
+        }
+        uint16_t u16le(size_t offset) const
+        {
+            return has(offset, 2) ? (uint16_t)((data[offset + 1] << 8) | data[offset]) : 0;
+        }
+        uint32_t u24be(size_t offset) const
+        {
+            return has(offset, 3) ? ((uint32_t)data[offset] << 16) | ((uint32_t)data[offset + 1] << 8) | data[offset + 2] : 0;
+        }
+        uint32_t u32be(size_t offset) const
+        {
+            if (!has(offset, 4))
+                return 0;
+            return ((uint32_t)data[offset] << 24) | ((uint32_t)data[offset + 1] << 16) | ((uint32_t)data[offset + 2] << 8) | data[offset + 3];
+        }
+        uint32_t u32le(size_t offset) const
+        {
+            if (!has(offset, 4))
+                return 0;
+            return ((uint32_t)data[offset + 3] << 24) | ((uint32_t)data[offset + 2] << 16) | ((uint32_t)data[offset + 1] << 8) | data[offset];
+        }
+        uint64_t u64be(size_t offset) const
+        {
+            return ((uint64_t)u32be(offset) << 32) | u32be(offset + 4);
+        }
+        // ID3v2 28-bit syncsafe integer.
+        uint32_t syncsafe(size_t offset) const
+        {
+            if (!has(offset, 4))
+                return 0;
+            return ((uint32_t)(data[offset] & 0x7F) << 21) | ((uint32_t)(data[offset + 1] & 0x7F) << 14) | ((uint32_t)(data[offset + 2] & 0x7F) << 7) | (data[offset + 3] & 0x7F);
+        }
+        bool matches(size_t offset, const char *tag) const
+        {
+            size_t length = strlen(tag);
+            return has(offset, length) && memcmp(data + offset, tag, length) == 0;
+        }
+
+    private:
+        const uint8_t *data = nullptr;
+        size_t size_ = 0;
+    };
+
+    void AppendUtf8(std::string &s, uint32_t c)
+    {
+        if (c < 0x80)
+        {
+            s += (char)c;
+        }
+        else if (c < 0x800)
+        {
+            s += (char)(0xC0 | (c >> 6));
+            s += (char)(0x80 | (c & 0x3F));
+        }
+        else if (c < 0x10000)
+        {
+            s += (char)(0xE0 | (c >> 12));
+            s += (char)(0x80 | ((c >> 6) & 0x3F));
+            s += (char)(0x80 | (c & 0x3F));
+        }
+        else
+        {
+            s += (char)(0xF0 | (c >> 18));
+            s += (char)(0x80 | ((c >> 12) & 0x3F));
+            s += (char)(0x80 | ((c >> 6) & 0x3F));
+            s += (char)(0x80 | (c & 0x3F));
+        }
+    }
+
+    std::string TrimNulls(std::string s)
+    {
+        size_t nul = s.find('\0');
+        if (nul != std::string::npos)
+        {
+            s.resize(nul);
+        }
+        while (!s.empty() && s.back() == ' ')
+        {
+            s.pop_back();
+        }
+        return s;
+    }
+
+    std::string Latin1ToUtf8(Span text)
+    {
+        std::string result;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            uint8_t c = text.u8(i);
+            if (c == 0)
+                break;
+            AppendUtf8(result, c);
+        }
+        return result;
+    }
+
+    std::string Utf16ToUtf8(Span text, bool bigEndian)
+    {
+        std::string result;
+        size_t i = 0;
+        if (text.size() >= 2)
+        {
+            // BOM
+            if (text.u8(0) == 0xFF && text.u8(1) == 0xFE)
+            {
+                bigEndian = false;
+                i = 2;
+            }
+            else if (text.u8(0) == 0xFE && text.u8(1) == 0xFF)
+            {
+                bigEndian = true;
+                i = 2;
+            }
+        }
+        for (; i + 1 < text.size(); i += 2)
+        {
+            uint32_t c = bigEndian ? text.u16be(i) : text.u16le(i);
+            if (c == 0)
+                break;
+            if (c >= 0xD800 && c < 0xDC00 && i + 3 < text.size())
+            {
+                uint32_t c2 = bigEndian ? text.u16be(i + 2) : text.u16le(i + 2);
+                if (c2 >= 0xDC00 && c2 < 0xE000)
+                {
+                    c = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+                    i += 2;
+                }
+            }
+            AppendUtf8(result, c);
+        }
+        return result;
+    }
+
+    std::string Utf8String(Span text)
+    {
+        return TrimNulls(std::string((const char *)text.begin(), text.size()));
+    }
+
+    bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i]))
+                return false;
+        }
+        return true;
+    }
+
+    void SetIfEmpty(std::string &target, const std::string &value)
+    {
+        if (target.empty())
+        {
+            target = value;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    // ID3
+
+    // Decode an ID3v2 text frame body.
+    std::string Id3Text(Span body)
+    {
+        if (body.empty())
+        {
+            return "";
+        }
+        uint8_t encoding = body.u8(0);
+        Span text = body.from(1);
+        switch (encoding)
+        {
+        case 0:
+            return TrimNulls(Latin1ToUtf8(text));
+        case 1:
+            return TrimNulls(Utf16ToUtf8(text, false));
+        case 2:
+            return TrimNulls(Utf16ToUtf8(text, true));
+        case 3:
+            return Utf8String(text);
+        default:
+            return "";
+        }
+    }
+
+    void ApplyId3Frame(const std::string &id, Span body, NativeAudioMetadata *metadata)
+    {
+        if (id == "TIT2" || id == "TT2")
+            SetIfEmpty(metadata->title, Id3Text(body));
+        else if (id == "TPE1" || id == "TP1")
+            SetIfEmpty(metadata->artist, Id3Text(body));
+        else if (id == "TALB" || id == "TAL")
+            SetIfEmpty(metadata->album, Id3Text(body));
+        else if (id == "TPE2" || id == "TP2")
+            SetIfEmpty(metadata->albumArtist, Id3Text(body));
+        else if (id == "TRCK" || id == "TRK")
+            SetIfEmpty(metadata->track, Id3Text(body));
+        else if (id == "TPOS" || id == "TPA")
+            SetIfEmpty(metadata->disc, Id3Text(body));
+        else if (id == "APIC" || id == "PIC")
+            metadata->embeddedArtwork = EmbeddedArtwork::Present;
+    }
+
+    // Returns the total size of the tag (including header and footer), or 0 if there's no tag.
+    // Returns false if the tag is present but can't be parsed.
+    bool ParseId3v2(Span data, NativeAudioMetadata *metadata, size_t *tagSize)
+    {
+        *tagSize = 0;
+        if (!data.matches(0, "ID3") || !data.has(0, 10))
+        {
+            return true;
+        }
+        uint8_t version = data.u8(3);
+        uint8_t flags = data.u8(5);
+        size_t size = data.syncsafe(6);
+        *tagSize = 10 + size + ((flags & 0x10) ? 10 : 0);
+        if (version < 2 || version > 4)
+        {
+            return false;
+        }
+        if (flags & 0x80)
+        {
+            // whole-tag unsynchronisation. Rare enough to leave to ffprobe.
+            return false;
+        }
+        Span tag = data.sub(10, size);
+        if (tag.empty())
+        {
+            return false;
+        }
+        size_t pos = 0;
+        if ((flags & 0x40) && version >= 3)
+        {
+            // extended header.
+            if (version == 3)
+            {
+                pos = 4 + tag.u32be(0);
+            }
+            else
+            {
+                pos = tag.syncsafe(0);
+            }
+        }
+        size_t idLength = version == 2 ? 3 : 4;
+        size_t headerLength = version == 2 ? 6 : 10;
+        while (tag.has(pos, headerLength))
+        {
+            if (tag.u8(pos) == 0)
+            {
+                break; // padding.
+            }
+            std::string id((const char *)tag.begin() + pos, idLength);
+            size_t frameSize;
+            uint16_t frameFlags = 0;
+            if (version == 2)
+            {
+                frameSize = tag.u24be(pos + 3);
+            }
+            else if (version == 3)
+            {
+                frameSize = tag.u32be(pos + 4);
+                frameFlags = tag.u16be(pos + 8);
+            }
+            else
+            {
+                frameSize = tag.syncsafe(pos + 4);
+                frameFlags = tag.u16be(pos + 8);
+            }
+            Span body = tag.sub(pos + headerLength, frameSize);
+            if (body.empty() && frameSize != 0)
+            {
+                break;
+            }
+            pos += headerLength + frameSize;
+
+            bool skip = false;
+            if (version == 3)
+            {
+                skip = (frameFlags & 0x00C0) != 0; // compressed or encrypted.
+                if (frameFlags & 0x0020)
+                {
+                    body = body.from(1); // group id.
+                }
+            }
+            else if (version == 4)
+            {
+                skip = (frameFlags & 0x000E) != 0; // compressed, encrypted or unsynchronised.
+                if (frameFlags & 0x0040)
+                {
+                    body = body.from(1); // group id.
+                }
+                if (frameFlags & 0x0001)
+                {
+                    body = body.from(4); // data length indicator.
+                }
+            }
+            if (skip)
+            {
+                if (id == "APIC")
+                {
+                    metadata->embeddedArtwork = EmbeddedArtwork::Present;
+                }
+                continue;
+            }
+            ApplyId3Frame(id, body, metadata);
+        }
+        return true;
+    }
+
+    bool ParseId3v1(Span data, NativeAudioMetadata *metadata)
+    {
+        if (data.size() < 128)
+        {
+            return false;
+        }
+        Span tag = data.from(data.size() - 128);
+        if (!tag.matches(0, "TAG"))
+        {
+            return false;
+        }
+        SetIfEmpty(metadata->title, TrimNulls(Latin1ToUtf8(tag.sub(3, 30))));
+        SetIfEmpty(metadata->artist, TrimNulls(Latin1ToUtf8(tag.sub(33, 30))));
+        SetIfEmpty(metadata->album, TrimNulls(Latin1ToUtf8(tag.sub(63, 30))));
+        if (tag.u8(125) == 0 && tag.u8(126) != 0)
+        {
+            // ID3v1.1 track number.
+            SetIfEmpty(metadata->track, std::to_string(tag.u8(126)));
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    // MP3
+
+    struct MpegFrameHeader
+    {
+        int version = 0; // 1 = MPEG1, 2 = MPEG2, 25 = MPEG2.5
+        int layer = 0;
+        int bitrate = 0; // bits per second.
+        int sampleRate = 0;
+        int samplesPerFrame = 0;
+        bool mono = false;
+        size_t frameLength = 0;
+    };
+
+    bool ParseMpegFrameHeader(Span data, size_t offset, MpegFrameHeader *header)
+    {
+        static const int BITRATES_V1[3][16] = {
+            {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448, -1},
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, -1},
+            {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, -1},
+        };
+        static const int BITRATES_V2[3][16] = {
+            {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256, -1},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, -1},
+            {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, -1},
+        };
+        static const int SAMPLE_RATES[3] = {44100, 48000, 32000};
+
+        uint32_t h = data.u32be(offset);
+        if (!data.has(offset, 4) || (h & 0xFFE00000) != 0xFFE00000)
+        {
+            return false;
+        }
+        int versionBits = (h >> 19) & 3;
+        int layerBits = (h >> 17) & 3;
+        int bitrateIndex = (h >> 12) & 0xF;
+        int sampleRateIndex = (h >> 10) & 3;
+        int padding = (h >> 9) & 1;
+        int channelMode = (h >> 6) & 3;
+        if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || sampleRateIndex == 3)
+        {
+            return false; // reserved, or free-format.
+        }
+        header->version = versionBits == 3 ? 1 : (versionBits == 2 ? 2 : 25);
+        header->layer = 4 - layerBits;
+        int kbps = header->version == 1 ? BITRATES_V1[header->layer - 1][bitrateIndex] : BITRATES_V2[header->layer - 1][bitrateIndex];
+        header->bitrate = kbps * 1000;
+        header->sampleRate = SAMPLE_RATES[sampleRateIndex];
+        if (header->version == 2)
+            header->sampleRate /= 2;
+        else if (header->version == 25)
+            header->sampleRate /= 4;
+        header->mono = channelMode == 3;
+        if (header->layer == 1)
+        {
+            header->samplesPerFrame = 384;
+            header->frameLength = (size_t)((12 * header->bitrate / header->sampleRate + padding) * 4);
+        }
+        else if (header->layer == 2 || header->version == 1)
+        {
+            header->samplesPerFrame = 1152;
+            header->frameLength = (size_t)(144 * header->bitrate / header->sampleRate + padding);
+        }
+        else
+        {
+            header->samplesPerFrame = 576;
+            header->frameLength = (size_t)(72 * header->bitrate / header->sampleRate + padding);
+        }
+        return header->frameLength > 4;
+    }
+
+    bool ParseMp3(Span data, NativeAudioMetadata *metadata)
+    {
+        size_t id3Size = 0;
+        if (!ParseId3v2(data, metadata, &id3Size))
+        {
+            return false;
+        }
+        bool hasId3v1 = ParseId3v1(data, metadata);
+        size_t audioEnd = data.size() - (hasId3v1 ? 128 : 0);
+
+        // find the first frame. Require the following frame header to be valid too, to avoid false syncs.
+        constexpr size_t MAX_SYNC_SEARCH = 64 * 1024;
+        MpegFrameHeader header;
+        size_t frameOffset = id3Size;
+        bool found = false;
+        for (size_t end = std::min(audioEnd, id3Size + MAX_SYNC_SEARCH); frameOffset + 4 <= end; ++frameOffset)
+        {
+            if (data.u8(frameOffset) != 0xFF)
+            {
+                continue;
+            }
+            MpegFrameHeader next;
+            if (ParseMpegFrameHeader(data, frameOffset, &header) &&
+                (frameOffset + header.frameLength + 4 > audioEnd || ParseMpegFrameHeader(data, frameOffset + header.frameLength, &next)))
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found || header.layer != 3)
+        {
+            return false;
+        }
+
+        // Xing/Info (lame), or VBRI (fraunhofer) header in the first frame.
+        size_t sideInfoSize = header.version == 1 ? (header.mono ? 17 : 32) : (header.mono ? 9 : 17);
+        size_t xingOffset = frameOffset + 4 + sideInfoSize;
+        uint32_t frames = 0;
+        if (data.matches(xingOffset, "Xing") || data.matches(xingOffset, "Info"))
+        {
+            uint32_t flags = data.u32be(xingOffset + 4);
+            if (flags & 1)
+            {
+                frames = data.u32be(xingOffset + 8);
+            }
+        }
+        else if (data.matches(frameOffset + 36, "VBRI"))
+        {
+            frames = data.u32be(frameOffset + 36 + 14);
+        }
+        if (frames != 0)
+        {
+            metadata->duration = (float)((double)frames * header.samplesPerFrame / header.sampleRate);
+        }
+        else
+        {
+            // assume CBR.
+            metadata->duration = (float)((double)(audioEnd - frameOffset) * 8 / header.bitrate);
+        }
+        if (metadata->embeddedArtwork == EmbeddedArtwork::Unknown)
+        {
+            metadata->embeddedArtwork = EmbeddedArtwork::Absent;
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    // WAV
+
+    bool ParseWav(Span data, NativeAudioMetadata *metadata)
+    {
+        if (!data.matches(0, "RIFF") || !data.matches(8, "WAVE"))
+        {
+            return false; // including RF64, which ffprobe handles.
+        }
+        uint32_t byteRate = 0;
+        uint64_t dataSize = 0;
+        bool hasData = false;
+        size_t pos = 12;
+        while (data.has(pos, 8))
+        {
+            uint32_t chunkSize = data.u32le(pos + 4);
+            Span chunk = data.sub(pos + 8, chunkSize);
+            if (data.matches(pos, "fmt "))
+            {
+                if (chunk.size() < 16)
+                {
+                    return false;
+                }
+                byteRate = chunk.u32le(8);
+            }
+            else if (data.matches(pos, "data"))
+            {
+                hasData = true;
+                // the data chunk of a file that's still being written may claim more than is there.
+                dataSize = std::min<uint64_t>(chunkSize, data.size() - (pos + 8));
+            }
+            else if (data.matches(pos, "LIST") && chunk.matches(0, "INFO"))
+            {
+                size_t infoPos = 4;
+                while (chunk.has(infoPos, 8))
+                {
+                    uint32_t infoSize = chunk.u32le(infoPos + 4);
+                    std::string value = Utf8String(chunk.sub(infoPos + 8, infoSize));
+                    if (chunk.matches(infoPos, "INAM"))
+                        SetIfEmpty(metadata->title, value);
+                    else if (chunk.matches(infoPos, "IART"))
+                        SetIfEmpty(metadata->artist, value);
+                    else if (chunk.matches(infoPos, "IPRD"))
+                        SetIfEmpty(metadata->album, value);
+                    else if (chunk.matches(infoPos, "ITRK") || chunk.matches(infoPos, "IPRT"))
+                        SetIfEmpty(metadata->track, value);
+                    infoPos += 8 + infoSize + (infoSize & 1);
+                }
+            }
+            else if (data.matches(pos, "id3 ") || data.matches(pos, "ID3 "))
+            {
+                size_t tagSize;
+                ParseId3v2(chunk, metadata, &tagSize);
+            }
+            if (chunk.empty() && chunkSize != 0 && !data.matches(pos, "data"))
+            {
+                break; // truncated.
+            }
+            pos += 8 + (size_t)chunkSize + (chunkSize & 1);
+        }
+        if (byteRate == 0 || !hasData)
+        {
+            return false;
+        }
+        metadata->duration = (float)((double)dataSize / byteRate);
+        if (metadata->embeddedArtwork == EmbeddedArtwork::Unknown)
+        {
+            metadata->embeddedArtwork = EmbeddedArtwork::Absent;
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    // FLAC
+
+    void ApplyVorbisComment(std::string_view comment, NativeAudioMetadata *metadata)
+    {
+        size_t equals = comment.find('=');
+        if (equals == std::string_view::npos)
+        {
+            return;
+        }
+        std::string_view key = comment.substr(0, equals);
+        std::string value{comment.substr(equals + 1)};
+        if (EqualsIgnoreCase(key, "TITLE"))
+            SetIfEmpty(metadata->title, value);
+        else if (EqualsIgnoreCase(key, "ARTIST"))
+            SetIfEmpty(metadata->artist, value);
+        else if (EqualsIgnoreCase(key, "ALBUM"))
+            SetIfEmpty(metadata->album, value);
+        else if (EqualsIgnoreCase(key, "ALBUMARTIST") || EqualsIgnoreCase(key, "ALBUM ARTIST") || EqualsIgnoreCase(key, "ALBUM_ARTIST"))
+            SetIfEmpty(metadata->albumArtist, value);
+        else if (EqualsIgnoreCase(key, "TRACKNUMBER") || EqualsIgnoreCase(key, "TRACK"))
+            SetIfEmpty(metadata->track, value);
+        else if (EqualsIgnoreCase(key, "DISCNUMBER") || EqualsIgnoreCase(key, "DISC"))
+            SetIfEmpty(metadata->disc, value);
+    }
+
+    bool ParseFlac(Span data, NativeAudioMetadata *metadata)
+    {
+        // some taggers put an ID3v2 tag in front of the stream.
+        size_t id3Size = 0;
+        ParseId3v2(data, metadata, &id3Size);
+        Span flac = data.from(id3Size);
+        if (!flac.matches(0, "fLaC"))
+        {
+            return false;
+        }
+        bool hasStreamInfo = false;
+        bool hasPicture = false;
+        size_t pos = 4;
+        while (flac.has(pos, 4))
+        {
+            uint8_t blockHeader = flac.u8(pos);
+            bool last = (blockHeader & 0x80) != 0;
+            int blockType = blockHeader & 0x7F;
+            uint32_t blockLength = flac.u24be(pos + 1);
+            Span block = flac.sub(pos + 4, blockLength);
+            if (block.empty() && blockLength != 0)
+            {
+                break;
+            }
+            if (blockType == 0 && block.size() >= 18)
+            {
+                // STREAMINFO: sample rate (20 bits), channels (3), bits per sample (5), total samples (36).
+                uint64_t bits = block.u64be(10);
+                uint32_t sampleRate = (uint32_t)(bits >> 44);
+                uint64_t totalSamples = bits & 0xFFFFFFFFFull;
+                if (sampleRate != 0)
+                {
+                    metadata->duration = (float)((double)totalSamples / sampleRate);
+                }
+                hasStreamInfo = true;
+            }
+            else if (blockType == 4)
+            {
+                // VORBIS_COMMENT, little-endian.
+                size_t vendorLength = block.u32le(0);
+                size_t commentPos = 4 + vendorLength;
+                uint32_t count = block.u32le(commentPos);
+                commentPos += 4;
+                for (uint32_t i = 0; i < count && block.has(commentPos, 4); ++i)
+                {
+                    uint32_t length = block.u32le(commentPos);
+                    Span comment = block.sub(commentPos + 4, length);
+                    if (comment.empty() && length != 0)
+                    {
+                        break;
+                    }
+                    ApplyVorbisComment(std::string_view((const char *)comment.begin(), comment.size()), metadata);
+                    commentPos += 4 + length;
+                }
+            }
+            else if (blockType == 6)
+            {
+                hasPicture = true;
+            }
+            pos += 4 + blockLength;
+            if (last)
+            {
+                break;
+            }
+        }
+        if (!hasStreamInfo)
+        {
+            return false;
+        }
+        if (hasPicture)
+        {
+            metadata->embeddedArtwork = EmbeddedArtwork::Present;
+        }
+        else if (metadata->embeddedArtwork == EmbeddedArtwork::Unknown)
+        {
+            metadata->embeddedArtwork = EmbeddedArtwork::Absent;
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////////
+    // MP4
+
+    struct Atom
+    {
+        char type[5] = {0};
+        Span body;
+    };
+
+    // Iterate over the atoms in a container.
+    class AtomReader
+    {
+    public:
+        AtomReader(Span data) : data(data) {}
+
+        bool Next(Atom *atom)
+        {
+            if (!data.has(pos, 8))
+            {
+                return false;
+            }
+            uint64_t size = data.u32be(pos);
+            size_t headerSize = 8;
+            memcpy(atom->type, data.begin() + pos + 4, 4);
+            if (size == 1)
+            {
+                if (!data.has(pos, 16))
+                    return false;
+                size = data.u64be(pos + 8);
+                headerSize = 16;
+            }
+            else if (size == 0)
+            {
+                size = data.size() - pos;
+            }
+            if (size < headerSize || size > data.size() - pos)
+            {
+                return false;
+            }
+            atom->body = data.sub(pos + headerSize, (size_t)size - headerSize);
+            pos += (size_t)size;
+            return true;
+        }
+
+    private:
+        Span data;
+        size_t pos = 0;
+    };
+
+    bool FindAtom(Span container, const char *type, Span *result)
+    {
+        AtomReader reader(container);
+        Atom atom;
+        while (reader.Next(&atom))
+        {
+            if (memcmp(atom.type, type, 4) == 0)
+            {
+                *result = atom.body;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The payload of the 'data' atom of an ilst item.
+    Span IlstItemData(Span item)
+    {
+        Span dataAtom;
+        if (!FindAtom(item, "data", &dataAtom))
+        {
+            return Span();
+        }
+        return dataAtom.from(8); // type + locale.
+    }
+
+    std::string IlstNumberPair(Span item)
+    {
+        // reserved u16, number u16, total u16.
+        Span data = IlstItemData(item);
+        if (data.size() < 4)
+        {
+            return "";
+        }
+        uint16_t number = data.u16be(2);
+        uint16_t total = data.u16be(4);
+        if (number == 0)
+        {
+            return "";
+        }
+        if (total != 0)
+        {
+            return std::to_string(number) + "/" + std::to_string(total);
+        }
+        return std::to_string(number);
+    }
+
+    bool ParseMp4(Span data, NativeAudioMetadata *metadata)
+    {
+        Atom ftyp;
+        AtomReader top(data);
+        if (!top.Next(&ftyp) || memcmp(ftyp.type, "ftyp", 4) != 0)
+        {
+            return false;
+        }
+        Span moov;
+        if (!FindAtom(data, "moov", &moov))
+        {
+            return false;
+        }
+        Span mvhd;
+        if (!FindAtom(moov, "mvhd", &mvhd))
+        {
+            return false;
+        }
+        uint32_t timescale;
+        uint64_t duration;
+        if (mvhd.u8(0) == 1)
+        {
+            timescale = mvhd.u32be(20);
+            duration = mvhd.u64be(24);
+        }
+        else
+        {
+            timescale = mvhd.u32be(12);
+            duration = mvhd.u32be(16);
+        }
+        if (timescale == 0)
+        {
+            return false;
+        }
+        metadata->duration = (float)((double)duration / timescale);
+
+        bool hasVideo = false;
+        {
+            AtomReader tracks(moov);
+            Atom trak;
+            while (tracks.Next(&trak))
+            {
+                Span mdia, hdlr;
+                if (memcmp(trak.type, "trak", 4) == 0 && FindAtom(trak.body, "mdia", &mdia) && FindAtom(mdia, "hdlr", &hdlr))
+                {
+                    // version/flags, pre_defined, handler_type
+                    if (hdlr.matches(8, "vide"))
+                    {
+                        hasVideo = true;
+                    }
+                }
+            }
+        }
+
+        bool hasCoverArt = false;
+        Span udta, meta, ilst;
+        if (FindAtom(moov, "udta", &udta) && FindAtom(udta, "meta", &meta))
+        {
+            // 'meta' is a full box in MP4, but not in QuickTime files.
+            if (!meta.matches(4, "hdlr"))
+            {
+                meta = meta.from(4);
+            }
+            if (FindAtom(meta, "ilst", &ilst))
+            {
+                AtomReader items(ilst);
+                Atom item;
+                while (items.Next(&item))
+                {
+                    std::string_view type(item.type, 4);
+                    if (type == "\xA9nam")
+                        SetIfEmpty(metadata->title, Utf8String(IlstItemData(item.body)));
+                    else if (type == "\xA9" "ART")
+                        SetIfEmpty(metadata->artist, Utf8String(IlstItemData(item.body)));
+                    else if (type == "\xA9" "alb")
+                        SetIfEmpty(metadata->album, Utf8String(IlstItemData(item.body)));
+                    else if (type == "aART")
+                        SetIfEmpty(metadata->albumArtist, Utf8String(IlstItemData(item.body)));
+                    else if (type == "trkn")
+                        SetIfEmpty(metadata->track, IlstNumberPair(item.body));
+                    else if (type == "disk")
+                        SetIfEmpty(metadata->disc, IlstNumberPair(item.body));
+                    else if (type == "covr")
+                        hasCoverArt = true;
+                }
+            }
+        }
+        if (hasCoverArt)
+        {
+            metadata->embeddedArtwork = EmbeddedArtwork::Present;
+        }
+        else
+        {
+            // ffmpeg generates thumbnails for video files from a video frame.
+            metadata->embeddedArtwork = hasVideo ? EmbeddedArtwork::Unknown : EmbeddedArtwork::Absent;
+        }
+        return true;
+    }
+
+    // Unmaps the file when it goes out of scope.
+    class MappedFile
+    {
+    public:
+        MappedFile(const std::filesystem::path &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd == -1)
+            {
+                return;
+            }
+            struct stat st;
+            if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+            {
+                void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED)
+                {
+                    data = (const uint8_t *)p;
+                    size = (size_t)st.st_size;
+                    // tags live at the start of the file (and the end, for ID3v1 and some MP4 files).
+                    madvise(p, size, MADV_RANDOM);
+                }
+            }
+            close(fd);
+        }
+        ~MappedFile()
+        {
+            if (data)
+            {
+                munmap((void *)data, size);
+            }
+        }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const uint8_t *data = nullptr;
+        size_t size = 0;
+    };
+}
+
+bool pipedal::ParseNativeAudioMetadata(const uint8_t *data, size_t size, NativeAudioMetadata *metadata)
+{
+    Span span(data, size);
+    *metadata = NativeAudioMetadata();
+
+    if (span.matches(0, "RIFF"))
+    {
+        return ParseWav(span, metadata);
+    }
+    if (span.matches(4, "ftyp"))
+    {
+        return ParseMp4(span, metadata);
+    }
+    if (span.matches(0, "fLaC"))
+    {
+        return ParseFlac(span, metadata);
+    }
+    if (span.matches(0, "ID3"))
+    {
+        // FLAC with a leading ID3 tag, or MP3.
+        size_t id3Size = 0;
+        NativeAudioMetadata ignored;
+        if (ParseId3v2(span, &ignored, &id3Size) && span.matches(id3Size, "fLaC"))
+        {
+            return ParseFlac(span, metadata);
+        }
+        return ParseMp3(span, metadata);
+    }
+    if (span.u8(0) == 0xFF && (span.u8(1) & 0xE0) == 0xE0)
+    {
+        return ParseMp3(span, metadata);
+    }
+    return false;
+}
+
+bool pipedal::ReadNativeAudioMetadata(const std::filesystem::path &path, NativeAudioMetadata *metadata)
+{
+    MappedFile file(path);
+    if (!file.data)
+    {
+        return false;
+    }
+    return ParseNativeAudioMetadata(file.data, file.size, metadata);
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace pipedal
+{
+    enum class EmbeddedArtwork
+    {
+        Unknown, // ffmpeg has to be asked (e.g. video files, which get a thumbnail from a video frame).
+        Present,
+        Absent
+    };
+
+    struct NativeAudioMetadata
+    {
+        float duration = 0; // seconds.
+        std::string title;
+        std::string artist;
+        std::string album;
+        std::string albumArtist;
+        std::string track; // as tagged, e.g. "3" or "3/12".
+        std::string disc;
+        EmbeddedArtwork embeddedArtwork = EmbeddedArtwork::Unknown;
+    };
+
+    /**
+     * @brief Read audio file metadata in-process, without spawning ffprobe.
+     *
+     * Handles WAV (RIFF, with LIST/INFO and id3 chunks), FLAC, MP3 (ID3v1, ID3v2.2-2.4, Xing/Info/VBRI
+     * headers) and MP4/M4A (iTunes ilst atoms). The file is mapped, and only the header and tag pages
+     * are touched.
+     *
+     * @return false if the format isn't recognized or can't be parsed, in which case the caller should
+     *         fall back to ffprobe.
+     */
+    bool ReadNativeAudioMetadata(const std::filesystem::path &path, NativeAudioMetadata *metadata);
+
+    // Parse an in-memory image of a file. (Test use, and the implementation of ReadNativeAudioMetadata).
+    bool ParseNativeAudioMetadata(const uint8_t *data, size_t size, NativeAudioMetadata *metadata);
+}
@@ -0,0 +1,233 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "NativeAudioMetadataReader.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    class Bytes
+    {
+    public:
+        std::vector<uint8_t> data;
+
+        Bytes &str(const std::string &s)
+        {
+            data.insert(data.end(), s.begin(), s.end());
+            return *this;
+        }
+        Bytes &u8(uint8_t v)
+        {
+            data.push_back(v);
+            return *this;
+        }
+        Bytes &be16(uint16_t v) { return u8(v >> 8).u8(v & 0xFF); }
+        Bytes &be24(uint32_t v) { return u8((v >> 16) & 0xFF).u8((v >> 8) & 0xFF).u8(v & 0xFF); }
+        Bytes &be32(uint32_t v) { return be16(v >> 16).be16(v & 0xFFFF); }
+        Bytes &le16(uint16_t v) { return u8(v & 0xFF).u8(v >> 8); }
+        Bytes &le32(uint32_t v) { return le16(v & 0xFFFF).le16(v >> 16); }
+        Bytes &syncsafe(uint32_t v) { return u8((v >> 21) & 0x7F).u8((v >> 14) & 0x7F).u8((v >> 7) & 0x7F).u8(v & 0x7F); }
+        Bytes &zeros(size_t n)
+        {
+            data.insert(data.end(), n, 0);
+            return *this;
+        }
+        Bytes &append(const Bytes &other)
+        {
+            data.insert(data.end(), other.data.begin(), other.data.end());
+            return *this;
+        }
+        size_t size() const { return data.size(); }
+    };
+
+    Bytes Atom(const std::string &type, const Bytes &body)
+    {
+        Bytes result;
+        result.be32((uint32_t)(body.size() + 8)).str(type).append(body);
+        return result;
+    }
+    Bytes IlstText(const std::string &type, const std::string &text)
+    {
+        Bytes data;
+        data.be32(1).be32(0).str(text);
+        return Atom(type, Atom("data", data));
+    }
+
+    NativeAudioMetadata Parse(const Bytes &bytes)
+    {
+        NativeAudioMetadata metadata;
+        REQUIRE(ParseNativeAudioMetadata(bytes.data.data(), bytes.data.size(), &metadata));
+        return metadata;
+    }
+}
+
+TEST_CASE("Native audio metadata", "[native_audio_metadata][Build][Dev]")
+{
+    SECTION("WAV")
+    {
+        Bytes info;
+        info.str("INFO");
+        info.str("INAM").le32(6).str("Title").u8(0);
+        info.str("IART").le32(3).str("Art").u8(0); // odd length, padded.
+
+        Bytes body;
+        body.str("WAVE");
+        body.str("fmt ").le32(16).le16(1).le16(2).le32(48000).le32(48000 * 4).le16(4).le16(16);
+        body.str("LIST").le32((uint32_t)info.size()).append(info);
+        body.str("data").le32(48000 * 4 * 2).zeros(48000 * 4 * 2);
+
+        Bytes wav;
+        wav.str("RIFF").le32((uint32_t)body.size()).append(body);
+
+        auto metadata = Parse(wav);
+        REQUIRE(std::abs(metadata.duration - 2.0f) < 0.001f);
+        REQUIRE(metadata.title == "Title");
+        REQUIRE(metadata.artist == "Art");
+        REQUIRE(metadata.embeddedArtwork == EmbeddedArtwork::Absent);
+    }
+    SECTION("FLAC")
+    {
+        Bytes streamInfo;
+        streamInfo.be16(4096).be16(4096).be24(0).be24(0);
+        // 44100 Hz (20 bits), 2 channels (3 bits: 1), 16 bits (5 bits: 15), 441000 samples (36 bits).
+        uint64_t bits = ((uint64_t)44100 << 44) | ((uint64_t)1 << 41) | ((uint64_t)15 << 36) | 441000;
+        streamInfo.be32((uint32_t)(bits >> 32)).be32((uint32_t)bits).zeros(16);
+
+        Bytes comments;
+        comments.le32(6).str("vendor").le32(3);
+        comments.le32(11).str("TITLE=Flacy");
+        comments.le32(17).str("albumartist=Group");
+        comments.le32(14).str("TRACKNUMBER=07");
+
+        Bytes flac;
+        flac.str("fLaC");
+        flac.u8(0).be24((uint32_t)streamInfo.size()).append(streamInfo);
+        flac.u8(4).be24((uint32_t)comments.size()).append(comments);
+        flac.u8(0x80 | 6).be24(4).zeros(4);
+
+        auto metadata = Parse(flac);
+        REQUIRE(std::abs(metadata.duration - 10.0f) < 0.001f);
+        REQUIRE(metadata.title == "Flacy");
+        REQUIRE(metadata.albumArtist == "Group");
+        REQUIRE(metadata.track == "07");
+        REQUIRE(metadata.embeddedArtwork == EmbeddedArtwork::Present);
+    }
+    SECTION("MP3 with ID3v2.3 and a Xing header")
+    {
+        Bytes frames;
+        // TIT2, latin-1 with a non-ascii character.
+        frames.str("TIT2").be32(6).be16(0).u8(0).str("Caf").u8(0xE9).u8(0);
+        // TPE1, UTF-16 with BOM.
+        frames.str("TPE1").be32(7).be16(0).u8(1).u8(0xFF).u8(0xFE).le16('A').le16('B');
+        frames.str("TRCK").be32(5).be16(0).u8(0).str("3/12");
+        frames.zeros(16); // padding.
+
+        Bytes mp3;
+        mp3.str("ID3").u8(3).u8(0).u8(0).syncsafe((uint32_t)frames.size()).append(frames);
+
+        // MPEG1 layer III, 128kbps, 44100Hz, stereo: 417 byte frames.
+        const uint32_t FRAME_HEADER = 0xFFFB9000;
+        const size_t FRAME_LENGTH = 417;
+        Bytes firstFrame;
+        firstFrame.be32(FRAME_HEADER).zeros(32).str("Xing").be32(1).be32(1000);
+        firstFrame.zeros(FRAME_LENGTH - firstFrame.size());
+        mp3.append(firstFrame);
+        mp3.be32(FRAME_HEADER).zeros(FRAME_LENGTH - 4);
+
+        auto metadata = Parse(mp3);
+        REQUIRE(metadata.title == "Caf\xC3\xA9");
+        REQUIRE(metadata.artist == "AB");
+        REQUIRE(metadata.track == "3/12");
+        REQUIRE(std::abs(metadata.duration - 1000.0f * 1152 / 44100) < 0.001f);
+        REQUIRE(metadata.embeddedArtwork == EmbeddedArtwork::Absent);
+    }
+    SECTION("CBR MP3 with ID3v1")
+    {
+        Bytes mp3;
+        const uint32_t FRAME_HEADER = 0xFFFB9000;
+        const size_t FRAME_LENGTH = 417;
+        for (int i = 0; i < 100; ++i)
+        {
+            mp3.be32(FRAME_HEADER).zeros(FRAME_LENGTH - 4);
+        }
+        Bytes id3v1;
+        id3v1.str("TAG").str("Old Title").zeros(30 - 9).str("Old Artist").zeros(30 - 10).zeros(30 + 4 + 28).u8(0).u8(5).u8(0);
+        mp3.append(id3v1);
+
+        auto metadata = Parse(mp3);
+        REQUIRE(metadata.title == "Old Title");
+        REQUIRE(metadata.artist == "Old Artist");
+        REQUIRE(metadata.track == "5");
+        REQUIRE(std::abs(metadata.duration - 100.0f * FRAME_LENGTH * 8 / 128000) < 0.001f);
+    }
+    SECTION("M4A")
+    {
+        Bytes mvhd;
+        mvhd.be32(0).be32(0).be32(0).be32(1000).be32(90500).zeros(80);
+
+        Bytes ilst;
+        ilst.append(IlstText("\xA9nam", "Mp4 Title"));
+        ilst.append(IlstText("\xA9" "ART", "Mp4 Artist"));
+        Bytes trkn;
+        trkn.be32(0).be32(0).be16(0).be16(4).be16(9).be16(0);
+        ilst.append(Atom("trkn", Atom("data", trkn)));
+        ilst.append(IlstText("covr", "jpegdata"));
+
+        Bytes meta;
+        meta.be32(0).append(Atom("hdlr", Bytes().zeros(25))).append(Atom("ilst", ilst));
+
+        Bytes moov;
+        moov.append(Atom("mvhd", mvhd)).append(Atom("udta", Atom("meta", meta)));
+
+        Bytes mp4;
+        mp4.append(Atom("ftyp", Bytes().str("M4A ").be32(0)));
+        mp4.append(Atom("mdat", Bytes().zeros(100)));
+        mp4.append(Atom("moov", moov));
+
+        auto metadata = Parse(mp4);
+        REQUIRE(std::abs(metadata.duration - 90.5f) < 0.001f);
+        REQUIRE(metadata.title == "Mp4 Title");
+        REQUIRE(metadata.artist == "Mp4 Artist");
+        REQUIRE(metadata.track == "4/9");
+        REQUIRE(metadata.embeddedArtwork == EmbeddedArtwork::Present);
+    }
+    SECTION("unrecognized and truncated files")
+    {
+        NativeAudioMetadata metadata;
+        Bytes ogg;
+        ogg.str("OggS").zeros(100);
+        REQUIRE(!ParseNativeAudioMetadata(ogg.data.data(), ogg.size(), &metadata));
+
+        Bytes truncated;
+        truncated.str("RIFF").le32(1000).str("WAVE").str("fmt ").le32(16).le16(1);
+        REQUIRE(!ParseNativeAudioMetadata(truncated.data.data(), truncated.size(), &metadata));
+
+        Bytes badId3;
+        badId3.str("ID3").u8(3).u8(0).u8(0).syncsafe(100000).str("TIT2");
+        REQUIRE(!ParseNativeAudioMetadata(badId3.data.data(), badId3.size(), &metadata));
+    }
+}
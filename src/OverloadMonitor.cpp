@@ -0,0 +1,79 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "OverloadMonitor.hpp"
+
+using namespace pipedal;
+
+OverloadMonitor::OverloadMonitor(double windowSeconds, double cooldownSeconds, float loadLimit)
+    : windowSeconds(windowSeconds),
+      cooldownSeconds(cooldownSeconds),
+      loadLimit(loadLimit)
+{
+}
+
+void OverloadMonitor::Reset()
+{
+    overloaded = false;
+    hasShed = false;
+}
+
+bool OverloadMonitor::Update(double timeSeconds, float load, uint64_t underruns)
+{
+    if (load < loadLimit)
+    {
+        overloaded = false;
+        return false;
+    }
+    if (!overloaded)
+    {
+        overloaded = true;
+        overloadStartTime = timeSeconds;
+        overloadStartUnderruns = underruns;
+        return false;
+    }
+    if (timeSeconds - overloadStartTime < windowSeconds || underruns == overloadStartUnderruns)
+    {
+        return false;
+    }
+    if (hasShed && timeSeconds - lastShedTime < cooldownSeconds)
+    {
+        return false;
+    }
+    hasShed = true;
+    lastShedTime = timeSeconds;
+    overloaded = false; // start a new window.
+    return true;
+}
+
+int64_t OverloadMonitor::SelectEffectToShed(const std::vector<EffectTiming> &timings, const std::function<bool(int64_t instanceId)> &canShed)
+{
+    int64_t result = -1;
+    float maxUs = 0;
+    for (const auto &timing : timings)
+    {
+        if (timing.periods_ != 0 && timing.meanUs_ > maxUs && canShed(timing.instanceId_))
+        {
+            result = timing.instanceId_;
+            maxUs = timing.meanUs_;
+        }
+    }
+    return result;
+}
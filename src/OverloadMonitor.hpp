@@ -0,0 +1,68 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "EffectTiming.hpp"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Decides when the audio thread has been overloaded for long enough to shed an effect.
+     *
+     * Fed periodically with the (peak-hold) pedalboard execution time as a fraction of the audio period,
+     * and the running underrun count. Fires when the load has stayed above the limit for the whole window
+     * and underruns occurred during it, and no effect has been shed within the cooldown period (which
+     * gives effect timings a chance to catch up with the last change).
+     */
+    class OverloadMonitor
+    {
+    public:
+        static constexpr double DEFAULT_WINDOW_SECONDS = 2.0;
+        static constexpr double DEFAULT_COOLDOWN_SECONDS = 5.0;
+        static constexpr float DEFAULT_LOAD_LIMIT = 0.9f;
+
+        OverloadMonitor(
+            double windowSeconds = DEFAULT_WINDOW_SECONDS,
+            double cooldownSeconds = DEFAULT_COOLDOWN_SECONDS,
+            float loadLimit = DEFAULT_LOAD_LIMIT);
+
+        // Returns true if an effect should be shed now.
+        bool Update(double timeSeconds, float load, uint64_t underruns);
+        void Reset();
+
+        // The instance id of the effect with the highest mean execution time for which canShed returns true, or -1.
+        static int64_t SelectEffectToShed(const std::vector<EffectTiming> &timings, const std::function<bool(int64_t instanceId)> &canShed);
+
+    private:
+        double windowSeconds;
+        double cooldownSeconds;
+        float loadLimit;
+
+        bool overloaded = false;
+        double overloadStartTime = 0;
+        uint64_t overloadStartUnderruns = 0;
+        bool hasShed = false;
+        double lastShedTime = 0;
+    };
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "OverloadMonitor.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("OverloadMonitor", "[overload_monitor][Build][Dev]")
+{
+    constexpr double DT = 0.25;
+    OverloadMonitor monitor(2.0, 5.0, 0.9f);
+
+    double t = 0;
+    uint64_t underruns = 0;
+    // light load, with the odd underrun (e.g. from the driver): never fires.
+    for (int i = 0; i < 100; ++i, t += DT)
+    {
+        REQUIRE(!monitor.Update(t, 0.5f, ++underruns));
+    }
+    // heavy load without underruns: never fires.
+    for (int i = 0; i < 100; ++i, t += DT)
+    {
+        REQUIRE(!monitor.Update(t, 0.95f, underruns));
+    }
+    REQUIRE(!monitor.Update(t, 0.5f, underruns));
+    t += DT;
+
+    // overloaded, with underruns. Fires once the window has elapsed.
+    int fired = 0;
+    double firstFired;
+    double start = t;
+    for (int i = 0; i < 8; ++i, t += DT)
+    {
+        if (monitor.Update(t, 1.2f, ++underruns))
+        {
+            ++fired;
+        }
+    }
+    REQUIRE(fired == 0);
+    REQUIRE(monitor.Update(t, 1.2f, ++underruns));
+    firstFired = t;
+    t += DT;
+
+    // still overloaded: waits for the cooldown.
+    while (!monitor.Update(t, 1.2f, ++underruns))
+    {
+        t += DT;
+        REQUIRE(t - firstFired < 10);
+    }
+    REQUIRE(t - firstFired >= 5.0);
+    REQUIRE(t - start >= 7.0);
+
+    // a dip below the limit restarts the window.
+    t += 10;
+    REQUIRE(!monitor.Update(t, 1.2f, ++underruns));
+    t += 1.5;
+    REQUIRE(!monitor.Update(t, 0.5f, ++underruns));
+    t += DT;
+    REQUIRE(!monitor.Update(t, 1.2f, ++underruns));
+    t += 1.5;
+    REQUIRE(!monitor.Update(t, 1.2f, ++underruns));
+    t += 1.0;
+    REQUIRE(monitor.Update(t, 1.2f, ++underruns));
+}
+
+TEST_CASE("OverloadMonitor effect selection", "[overload_monitor][Build][Dev]")
+{
+    std::vector<EffectTiming> timings(4);
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+        timings[i].instanceId_ = (int64_t)i + 10;
+        timings[i].periods_ = 100;
+    }
+    timings[0].meanUs_ = 50;
+    timings[1].meanUs_ = 400; // essential.
+    timings[2].meanUs_ = 300;
+    timings[3].meanUs_ = 500;
+    timings[3].periods_ = 0; // no data.
+
+    auto canShed = [](int64_t instanceId)
+    { return instanceId != 11; };
+    REQUIRE(OverloadMonitor::SelectEffectToShed(timings, canShed) == 12);
+    REQUIRE(OverloadMonitor::SelectEffectToShed(timings, [](int64_t)
+                                                { return false; }) == -1);
+}
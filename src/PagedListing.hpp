@@ -0,0 +1,97 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Cursor-based paging for listings that can change between requests.
+     *
+     * A continuation token records the sort key, and the position and name of the last item on the previous
+     * page. The next page starts after that item, even if items ahead of it have been added or removed in the
+     * meantime; if it has been removed, the next page starts at the same position.
+     */
+    namespace paged_listing
+    {
+        inline std::string MakeToken(const std::string &sortKey, size_t position, const std::string &lastName)
+        {
+            return sortKey + ":" + std::to_string(position) + ":" + lastName;
+        }
+
+        // The index of the first item of the page that follows continuationToken.
+        template <typename T, typename GetName>
+        size_t ResumePosition(const std::vector<T> &items, const std::string &sortKey, const std::string &continuationToken, GetName getName)
+        {
+            size_t p0 = continuationToken.find(':');
+            size_t p1 = p0 == std::string::npos ? std::string::npos : continuationToken.find(':', p0 + 1);
+            if (p1 == std::string::npos || continuationToken.substr(0, p0) != sortKey)
+            {
+                throw std::invalid_argument("Invalid continuation token.");
+            }
+            size_t position;
+            try
+            {
+                position = std::stoull(continuationToken.substr(p0 + 1, p1 - p0 - 1));
+            }
+            catch (const std::exception &)
+            {
+                throw std::invalid_argument("Invalid continuation token.");
+            }
+            std::string lastName = continuationToken.substr(p1 + 1);
+            if (position != 0 && position <= items.size() && getName(items[position - 1]) == lastName)
+            {
+                return position;
+            }
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                if (getName(items[i]) == lastName)
+                {
+                    return i + 1;
+                }
+            }
+            return std::min(position, items.size());
+        }
+
+        // Keeps only the items on the page that follows continuationToken (or the first page, if the
+        // token is empty). Returns the token for the next page, or an empty string if this is the last page.
+        // A pageSize of 0 selects all remaining items.
+        template <typename T, typename GetName>
+        std::string SelectPage(std::vector<T> &items, const std::string &sortKey, size_t pageSize, const std::string &continuationToken, GetName getName)
+        {
+            size_t start = continuationToken.empty() ? 0 : ResumePosition(items, sortKey, continuationToken, getName);
+            size_t end = pageSize == 0 ? items.size() : std::min(items.size(), start + pageSize);
+            std::string nextToken;
+            if (end < items.size())
+            {
+                nextToken = MakeToken(sortKey, end, getName(items[end - 1]));
+            }
+            items.erase(items.begin() + end, items.end());
+            items.erase(items.begin(), items.begin() + start);
+            return nextToken;
+        }
+    }
+}
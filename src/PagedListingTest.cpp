@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PagedListing.hpp"
+#include <string>
+#include <vector>
+
+using namespace pipedal;
+
+static std::string GetName(const std::string &item)
+{
+    return item;
+}
+
+static std::vector<std::string> Items(const std::vector<std::string> &items, const std::string &sortKey, size_t pageSize, std::string *token)
+{
+    std::vector<std::string> result = items;
+    *token = paged_listing::SelectPage(result, sortKey, pageSize, *token, GetName);
+    return result;
+}
+
+TEST_CASE("PagedListing", "[paged_listing][Build][Dev]")
+{
+    std::vector<std::string> items{"a", "b", "c", "d", "e"};
+    std::string token;
+
+    REQUIRE(Items(items, "title", 2, &token) == std::vector<std::string>{"a", "b"});
+    REQUIRE(!token.empty());
+    std::string secondPage = token;
+    REQUIRE(Items(items, "title", 2, &token) == std::vector<std::string>{"c", "d"});
+    REQUIRE(Items(items, "title", 2, &token) == std::vector<std::string>{"e"});
+    REQUIRE(token.empty());
+
+    // items added ahead of the cursor don't repeat items on the next page.
+    token = secondPage;
+    REQUIRE(Items({"0", "a", "b", "c", "d", "e"}, "title", 2, &token) == std::vector<std::string>{"c", "d"});
+
+    // if the last item has been removed, the next page starts at the same position.
+    token = secondPage;
+    REQUIRE(Items({"a", "c", "d", "e"}, "title", 2, &token) == std::vector<std::string>{"d", "e"});
+    REQUIRE(token.empty());
+
+    // names may contain ':'
+    std::vector<std::string> paths{"/x:1", "/x:2", "/x:3"};
+    token.clear();
+    REQUIRE(Items(paths, "", 1, &token) == std::vector<std::string>{"/x:1"});
+    REQUIRE(Items(paths, "", 0, &token) == std::vector<std::string>{"/x:2", "/x:3"});
+
+    // tokens are only valid for the sort key that produced them.
+    token = secondPage;
+    REQUIRE_THROWS(Items(items, "artist", 2, &token));
+    token = "garbage";
+    REQUIRE_THROWS(Items(items, "title", 2, &token));
+    token = "title:x:a";
+    REQUIRE_THROWS(Items(items, "title", 2, &token));
+}
@@ -21,19 +21,24 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <atomic>
+#include <memory>
 #include <stdexcept>
 #include "util.hpp"
 #include <lv2/atom/atom.h>
+#include <lv2/urid/urid.h>
 namespace pipedal
 {
 
     // A mechanism for writing (path) patch properties back to the non-realtime threads.
     // Has the following characteristics:
-    // 1. Only one property in flight to the non-realtime thread at any givien moment.
-    // 2. No blocking, no spinning on the realtime thread. RT operations require nothing other than atomic operations.
+    // 1. A ring of BUFFER_COUNT buffers per property, so that updates in consecutive periods don't
+    //    have to wait for the non-realtime thread to finish reading the previous update.
+    // 2. No blocking, no spinning, no allocation on the realtime thread. RT operations require nothing other than atomic operations.
     // 3. Multiple responses in the same RT frame are coaslesced into one response (the latest).
-    // 4. Responses that are found while a property notification is in flight are coaslesced.
+    // 4. If all buffers are in flight, responses are coalesced until one becomes free.
+    // 5. Buffers from all writers are published to the host in one message per period (see IPatchWriterCallback).
 
     class IPatchWriterCallback;
 
@@ -50,29 +55,25 @@ namespace pipedal
         };
 
     public:
+        static constexpr size_t BUFFER_COUNT = 4;
+        // Largest value (LV2_Atom header included) that can be written. Larger values are dropped.
+        static constexpr size_t MAX_VALUE_SIZE = 4096 + 64;
+
+        class Buffer;
+
         PatchPropertyWriter(int64_t instanceId, LV2_URID patchPropertyUrid)
-            : instanceId(instanceId), patchPropertyUrid(patchPropertyUrid),
-              buffer0(new Buffer(instanceId, patchPropertyUrid)),
-              buffer1(new Buffer(instanceId, patchPropertyUrid))
+            : instanceId(instanceId), patchPropertyUrid(patchPropertyUrid)
         {
+            for (size_t i = 0; i < BUFFER_COUNT; ++i)
+            {
+                buffers.push_back(std::make_unique<Buffer>(instanceId, patchPropertyUrid));
+            }
         }
         // no copy.
         PatchPropertyWriter(const PatchPropertyWriter&) = delete;
         // move
-        PatchPropertyWriter(PatchPropertyWriter&&other) {
-            std::swap(this->buffer0,other.buffer0);
-            std::swap(this->buffer1,other.buffer1);
-            this->currentWriteBuffer = nullptr;
-            this->instanceId = other.instanceId;
-            this->patchPropertyUrid = other.patchPropertyUrid;
+        PatchPropertyWriter(PatchPropertyWriter&&other) = default;
 
-        }
-
-        ~PatchPropertyWriter()
-        {
-            delete buffer0;
-            delete buffer1;
-        }
         class Buffer
         {
         public:
@@ -81,7 +82,7 @@ namespace pipedal
             Buffer(int64_t instanceId, LV2_URID propertyUrid)
                 : instanceId(instanceId), patchPropertyUrid(propertyUrid)
             {
-                memory.reserve(1024);
+                memory.reserve(MAX_VALUE_SIZE);
             }
 
             void OnBufferWriteStarted()
@@ -118,6 +119,18 @@ namespace pipedal
                 }
                 state = StateT::Empty;
             }
+            // RT thread only. Returns false if the value is too large.
+            bool SetValue(const LV2_Atom *value)
+            {
+                size_t atomSize = value->size + sizeof(LV2_Atom);
+                if (atomSize > memory.capacity())
+                {
+                    return false;
+                }
+                memory.resize(atomSize);
+                memcpy(memory.data(), value, atomSize);
+                return true;
+            }
             int64_t instanceId;
             LV2_URID patchPropertyUrid;
 
@@ -132,16 +145,14 @@ namespace pipedal
             {
                 return currentWriteBuffer;
             }
-            if (buffer0->state == StateT::Empty)
+            // The host returns buffers in the order in which they were published, so the next buffer
+            // in the ring is the one that has been in flight longest.
+            Buffer *buffer = buffers[nextWriteBuffer].get();
+            if (buffer->state == StateT::Empty)
             {
-                buffer0->OnBufferWriteStarted();
-                currentWriteBuffer = buffer0;
-                return currentWriteBuffer;
-            }
-            if (buffer1->state == StateT::Empty)
-            {
-                buffer1->OnBufferWriteStarted();
-                currentWriteBuffer = buffer1;
+                buffer->OnBufferWriteStarted();
+                currentWriteBuffer = buffer;
+                nextWriteBuffer = (nextWriteBuffer + 1) % BUFFER_COUNT;
                 return currentWriteBuffer;
             }
             throw std::runtime_error("Bad state. Unable to aquire a write buffer.");
@@ -160,14 +171,16 @@ namespace pipedal
             return currentWriteBuffer;
         }
 
+        // RT thread only. Publishes the current buffer, if there is one, and if a buffer is free
+        // for the next write.
         void FlushWrites(IPatchWriterCallback*cbWrite);
 
         int64_t instanceId;
         LV2_URID patchPropertyUrid;
 
     private:
-        Buffer *buffer0 = 0;
-        Buffer *buffer1 = 0;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+        size_t nextWriteBuffer = 0;
         Buffer *currentWriteBuffer = nullptr;
     };
 
@@ -182,14 +195,14 @@ namespace pipedal
     {
         auto buffer = GetCurrentWriteBuffer();
         if (buffer)
-        {   
-            // is the OTHER buffer empty?
-            if (buffer0->state == StateT::Empty || buffer1->state == StateT::Empty)
+        {
+            // is there a buffer for the next write?
+            if (buffers[nextWriteBuffer]->state == StateT::Empty)
             {
                 OnBufferWritten();
                 cbWrite->OnWritePatchPropertyBuffer(buffer);
             } else {
-                // we have an update in flight, so just keep accumulating, and maybe write next time.
+                // all the other buffers are in flight, so just keep accumulating, and maybe write next time.
             }
         }
     }
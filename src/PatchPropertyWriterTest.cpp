@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PatchPropertyWriter.hpp"
+
+using namespace pipedal;
+
+namespace
+{
+    class TestPatchWriterCallback : public IPatchWriterCallback
+    {
+    public:
+        std::vector<PatchPropertyWriter::Buffer *> published;
+
+        virtual void OnWritePatchPropertyBuffer(PatchPropertyWriter::Buffer *buffer) override
+        {
+            published.push_back(buffer);
+        }
+    };
+
+    void WriteInt(PatchPropertyWriter &writer, int32_t value)
+    {
+        LV2_Atom_Int atom;
+        atom.atom.size = sizeof(int32_t);
+        atom.atom.type = 1;
+        atom.body = value;
+        REQUIRE(writer.AquireWriteBuffer()->SetValue(&atom.atom));
+    }
+    int32_t ReadInt(PatchPropertyWriter::Buffer *buffer)
+    {
+        buffer->OnBufferReadStarted();
+        int32_t result = ((LV2_Atom_Int *)buffer->memory.data())->body;
+        buffer->OnBufferReadComplete();
+        return result;
+    }
+}
+
+TEST_CASE("PatchPropertyWriter", "[patch_property_writer][Build][Dev]")
+{
+    PatchPropertyWriter writer(7, 11);
+    TestPatchWriterCallback callback;
+
+    // nothing to flush.
+    writer.FlushWrites(&callback);
+    REQUIRE(callback.published.empty());
+
+    // consecutive periods don't wait for the reader.
+    for (int32_t i = 0; i < (int32_t)PatchPropertyWriter::BUFFER_COUNT - 1; ++i)
+    {
+        WriteInt(writer, i);
+        writer.FlushWrites(&callback);
+    }
+    REQUIRE(callback.published.size() == PatchPropertyWriter::BUFFER_COUNT - 1);
+    REQUIRE(callback.published[0]->instanceId == 7);
+    REQUIRE(callback.published[0]->patchPropertyUrid == 11);
+
+    // with all other buffers in flight, writes are coalesced.
+    WriteInt(writer, 100);
+    writer.FlushWrites(&callback);
+    WriteInt(writer, 101);
+    writer.FlushWrites(&callback);
+    REQUIRE(callback.published.size() == PatchPropertyWriter::BUFFER_COUNT - 1);
+    REQUIRE(writer.GetCurrentWriteBuffer() != nullptr);
+
+    // reading frees buffers in publication order.
+    for (int32_t i = 0; i < (int32_t)PatchPropertyWriter::BUFFER_COUNT - 1; ++i)
+    {
+        REQUIRE(ReadInt(callback.published[i]) == i);
+    }
+    writer.FlushWrites(&callback);
+    REQUIRE(callback.published.size() == PatchPropertyWriter::BUFFER_COUNT);
+    REQUIRE(ReadInt(callback.published.back()) == 101);
+    REQUIRE(writer.GetCurrentWriteBuffer() == nullptr);
+
+    // oversized values are rejected.
+    std::vector<uint8_t> large(PatchPropertyWriter::MAX_VALUE_SIZE + 1);
+    LV2_Atom *largeAtom = (LV2_Atom *)large.data();
+    largeAtom->size = (uint32_t)(large.size() - sizeof(LV2_Atom));
+    largeAtom->type = 1;
+    REQUIRE(!writer.AquireWriteBuffer()->SetValue(largeAtom));
+}
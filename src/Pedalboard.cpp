@@ -132,6 +132,39 @@ bool Pedalboard::SetItemUseModUi(int64_t pedalItemId, bool enabled)
     return false;
 
 }
+bool Pedalboard::SetItemHardBypass(int64_t pedalItemId, bool enabled)
+{
+    PedalboardItem*item = GetItem(pedalItemId);
+    if (!item) return false;
+    if (item->hardBypass() != enabled)
+    {
+        item->hardBypass(enabled);
+        return true;
+    }
+    return false;
+}
+bool Pedalboard::SetItemEssential(int64_t pedalItemId, bool essential)
+{
+    PedalboardItem*item = GetItem(pedalItemId);
+    if (!item) return false;
+    if (item->essential() != essential)
+    {
+        item->essential(essential);
+        return true;
+    }
+    return false;
+}
+bool Pedalboard::SetItemAlwaysRun(int64_t pedalItemId, bool alwaysRun)
+{
+    PedalboardItem*item = GetItem(pedalItemId);
+    if (!item) return false;
+    if (item->alwaysRun() != alwaysRun)
+    {
+        item->alwaysRun(alwaysRun);
+        return true;
+    }
+    return false;
+}
 bool Pedalboard::SetItemEnabled(int64_t pedalItemId, bool enabled)
 {
     PedalboardItem*item = GetItem(pedalItemId);
@@ -330,6 +363,10 @@ bool Pedalboard::IsStructureIdentical(const Pedalboard &other) const
     {
         return false;
     }
+    if (this->parallelSplits_ != other.parallelSplits_ || this->pipeline_ != other.pipeline_) // changes the realtime execution plan.
+    {
+        return false;
+    }
     if (this->items_.size() != other.items_.size()) 
     {
         return false;
@@ -358,6 +395,14 @@ bool PedalboardItem::IsStructurallyIdentical(const PedalboardItem&other) const
     {
         return false;
     }
+    if (this->hardBypass() != other.hardBypass())
+    {
+        return false;
+    }
+    if (this->alwaysRun() != other.alwaysRun())
+    {
+        return false;
+    }
     if (this->isSplit()) // so is the other by virtue of idential uris.
     {
         // provisionally, it seems ok to change the split type.
@@ -535,6 +580,9 @@ JSON_MAP_BEGIN(PedalboardItem)
     JSON_MAP_REFERENCE(PedalboardItem,useModUi)
     JSON_MAP_REFERENCE(PedalboardItem,iconColor)
     JSON_MAP_REFERENCE(PedalboardItem,sideChainInputId)
+    JSON_MAP_REFERENCE(PedalboardItem,hardBypass)
+    JSON_MAP_REFERENCE(PedalboardItem,essential)
+    JSON_MAP_REFERENCE(PedalboardItem,alwaysRun)
 JSON_MAP_END()
 
 
@@ -547,6 +595,8 @@ JSON_MAP_BEGIN(Pedalboard)
     JSON_MAP_REFERENCE(Pedalboard,snapshots)
     JSON_MAP_REFERENCE(Pedalboard,selectedSnapshot)
     JSON_MAP_REFERENCE(Pedalboard,selectedPlugin)
+    JSON_MAP_REFERENCE(Pedalboard,parallelSplits)
+    JSON_MAP_REFERENCE(Pedalboard,pipeline)
 JSON_MAP_END()
 
 JSON_MAP_BEGIN(SnapshotValue)
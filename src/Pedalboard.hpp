@@ -108,6 +108,9 @@ public:
     bool useModUi_ = false;
     std::string iconColor_;
     int64_t sideChainInputId_ = -1;
+    bool hardBypass_ = false; // don't run the plugin at all while it's bypassed.
+    bool essential_ = false; // never bypassed by overload protection.
+    bool alwaysRun_ = false; // never idled by the silence gate.
 
     // non persistent state.
     PropertyMap patchProperties;
@@ -140,6 +143,9 @@ public:
     GETTER_SETTER_REF(iconColor)
     GETTER_SETTER(useModUi)
     GETTER_SETTER(sideChainInputId)
+    GETTER_SETTER(hardBypass)
+    GETTER_SETTER(essential)
+    GETTER_SETTER(alwaysRun)
     
     Lv2PluginState&lv2State() { return lv2State_; } // non-const version.
     GETTER_SETTER_REF(lilvPresetUri)
@@ -230,8 +236,15 @@ class Pedalboard {
 
     int64_t selectedPlugin_ = -1;
 
+    // Run the top and bottom chains of splits concurrently on a realtime helper thread.
+    bool parallelSplits_ = false;
+
+    // Split the top-level chain into two stages that run concurrently on the audio thread and a realtime
+    // helper thread, at the cost of one period of extra latency. Takes precedence over parallelSplits.
+    bool pipeline_ = false;
+
 public:
-    // deep copy, breaking shared pointers.
+    // deep copy, breaking shared pointers to (mutable) snapshots. Immutable LV2 state values stay shared.
     Pedalboard DeepCopy(); 
     static constexpr int64_t INPUT_VOLUME_ID = -2; // synthetic PedalboardItem for input volume.
     static constexpr int64_t OUTPUT_VOLUME_ID = -3; // synthetic PedalboardItem for output volume.
@@ -239,6 +252,9 @@ public:
     bool SetItemTitle(int64_t pedalItemId, const std::string &title, const std::string&iconColor);
     bool SetItemEnabled(int64_t pedalItemId, bool enabled);
     bool SetItemUseModUi(int64_t pedalItemId, bool enabled);
+    bool SetItemHardBypass(int64_t pedalItemId, bool enabled);
+    bool SetItemEssential(int64_t pedalItemId, bool essential);
+    bool SetItemAlwaysRun(int64_t pedalItemId, bool alwaysRun);
     void  SetCurrentSnapshotModified(bool modified);
 
     bool IsStructureIdentical(const Pedalboard &other) const; // caan we just send a snapshot-style uddate instead of reloading plugins? All settings are ignored.
@@ -258,6 +274,9 @@ public:
     GETTER_SETTER_VEC(snapshots)
     GETTER_SETTER(selectedSnapshot)
     GETTER_SETTER(selectedPlugin)
+    GETTER_SETTER(parallelSplits)
+    GETTER_SETTER(pipeline)
+    GETTER_SETTER(nextInstanceId)
 
 
     DECLARE_JSON_MAP(Pedalboard);
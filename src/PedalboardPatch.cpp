@@ -0,0 +1,119 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "PedalboardPatch.hpp"
+
+using namespace pipedal;
+
+static void AppendStructure(const std::vector<PedalboardItem> &items, std::vector<const PedalboardItem *> &flatItems, std::string &structure)
+{
+    for (const PedalboardItem &item : items)
+    {
+        flatItems.push_back(&item);
+        structure += std::to_string(item.instanceId());
+        if (item.isSplit())
+        {
+            structure += '[';
+            AppendStructure(item.topChain(), flatItems, structure);
+            structure += '|';
+            AppendStructure(item.bottomChain(), flatItems, structure);
+            structure += ']';
+        }
+        structure += ',';
+    }
+}
+
+template <typename T>
+static std::string ToJson(const T &value)
+{
+    std::ostringstream s;
+    json_writer writer(s, true);
+    writer.write(value);
+    return s.str();
+}
+
+static std::string ItemSettingsJson(const PedalboardItem &item)
+{
+    if (item.isSplit())
+    {
+        // the chains are compared item by item.
+        PedalboardItem settings = item;
+        settings.topChain().clear();
+        settings.bottomChain().clear();
+        return ToJson(settings);
+    }
+    return ToJson(item);
+}
+
+bool PedalboardPatch::Make(const Pedalboard &from, const Pedalboard &to, PedalboardPatch *patch)
+{
+    std::vector<const PedalboardItem *> fromItems, toItems;
+    std::string fromStructure, toStructure;
+    AppendStructure(from.items(), fromItems, fromStructure);
+    AppendStructure(to.items(), toItems, toStructure);
+    if (fromStructure != toStructure)
+    {
+        return false;
+    }
+    if (ToJson(from.snapshots()) != ToJson(to.snapshots()))
+    {
+        return false;
+    }
+
+    patch->items_.clear();
+    for (size_t i = 0; i < toItems.size(); ++i)
+    {
+        const PedalboardItem &fromItem = *fromItems[i];
+        const PedalboardItem &toItem = *toItems[i];
+        if (ItemSettingsJson(fromItem) != ItemSettingsJson(toItem))
+        {
+            if (toItem.isSplit())
+            {
+                return false;
+            }
+            patch->items_.push_back(toItem);
+        }
+    }
+    patch->name_ = to.name();
+    patch->input_volume_db_ = to.input_volume_db();
+    patch->output_volume_db_ = to.output_volume_db();
+    patch->nextInstanceId_ = to.nextInstanceId();
+    patch->selectedSnapshot_ = to.selectedSnapshot();
+    patch->selectedPlugin_ = to.selectedPlugin();
+    patch->parallelSplits_ = to.parallelSplits();
+    patch->pipeline_ = to.pipeline();
+    return true;
+}
+
+JSON_MAP_BEGIN(PedalboardPatch)
+    JSON_MAP_REFERENCE(PedalboardPatch, clientId)
+    JSON_MAP_REFERENCE(PedalboardPatch, baseVersion)
+    JSON_MAP_REFERENCE(PedalboardPatch, version)
+    JSON_MAP_REFERENCE(PedalboardPatch, name)
+    JSON_MAP_REFERENCE(PedalboardPatch, input_volume_db)
+    JSON_MAP_REFERENCE(PedalboardPatch, output_volume_db)
+    JSON_MAP_REFERENCE(PedalboardPatch, nextInstanceId)
+    JSON_MAP_REFERENCE(PedalboardPatch, selectedSnapshot)
+    JSON_MAP_REFERENCE(PedalboardPatch, selectedPlugin)
+    JSON_MAP_REFERENCE(PedalboardPatch, parallelSplits)
+    JSON_MAP_REFERENCE(PedalboardPatch, pipeline)
+    JSON_MAP_REFERENCE(PedalboardPatch, items)
+JSON_MAP_END()
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Pedalboard.hpp"
+#include "json.hpp"
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    // An incremental update of the pedalboard, sent to clients in place of the full pedalboard
+    // when only item settings and top-level properties have changed.
+    //
+    // Items are replaced whole, keyed by instanceId. A patch only applies to a client whose copy
+    // of the pedalboard is at baseVersion; other clients must fetch the full pedalboard.
+    class PedalboardPatch
+    {
+    public:
+        int64_t clientId_ = -1;
+        int64_t baseVersion_ = 0;
+        int64_t version_ = 0;
+
+        std::string name_;
+        float input_volume_db_ = 0;
+        float output_volume_db_ = 0;
+        uint64_t nextInstanceId_ = 0;
+        int64_t selectedSnapshot_ = -1;
+        int64_t selectedPlugin_ = -1;
+        bool parallelSplits_ = false;
+        bool pipeline_ = false;
+
+        // Non-split items whose settings changed.
+        std::vector<PedalboardItem> items_;
+
+        // Returns false if the change can't be expressed as a patch: items were added, removed or moved,
+        // the settings of a split changed, or the snapshots changed.
+        static bool Make(const Pedalboard &from, const Pedalboard &to, PedalboardPatch *patch);
+
+        DECLARE_JSON_MAP(PedalboardPatch);
+    };
+}
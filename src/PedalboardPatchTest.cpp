@@ -0,0 +1,113 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PedalboardPatch.hpp"
+
+using namespace pipedal;
+
+static Pedalboard MakePedalboard()
+{
+    Pedalboard pedalboard = Pedalboard::MakeDefault();
+    pedalboard.items().clear();
+    PedalboardItem split = pedalboard.MakeSplit();
+    split.topChain().push_back(pedalboard.MakeEmptyItem());
+    split.bottomChain().push_back(pedalboard.MakeEmptyItem());
+    pedalboard.items().push_back(pedalboard.MakeEmptyItem());
+    pedalboard.items().push_back(split);
+    return pedalboard;
+}
+
+TEST_CASE("PedalboardPatch", "[pedalboard_patch][Build][Dev]")
+{
+    Pedalboard from = MakePedalboard();
+
+    // item settings and top-level properties.
+    {
+        Pedalboard to = from;
+        to.name("Renamed");
+        to.items()[1].topChain()[0].useModUi(true);
+        to.items()[0].title("Boost");
+        PedalboardPatch patch;
+        REQUIRE(PedalboardPatch::Make(from, to, &patch));
+        REQUIRE(patch.name_ == "Renamed");
+        REQUIRE(patch.items_.size() == 2);
+        REQUIRE(patch.items_[0].instanceId() == to.items()[0].instanceId());
+        REQUIRE(patch.items_[1].instanceId() == to.items()[1].topChain()[0].instanceId());
+        REQUIRE(patch.items_[1].useModUi());
+    }
+    // no change.
+    {
+        PedalboardPatch patch;
+        REQUIRE(PedalboardPatch::Make(from, from, &patch));
+        REQUIRE(patch.items_.size() == 0);
+    }
+    // moving an item changes the structure.
+    {
+        Pedalboard to = from;
+        std::swap(to.items()[1].topChain(), to.items()[1].bottomChain());
+        PedalboardPatch patch;
+        REQUIRE(!PedalboardPatch::Make(from, to, &patch));
+    }
+    // adding an item.
+    {
+        Pedalboard to = from;
+        to.items().push_back(to.MakeEmptyItem());
+        PedalboardPatch patch;
+        REQUIRE(!PedalboardPatch::Make(from, to, &patch));
+    }
+    // split settings are sent with the full pedalboard.
+    {
+        Pedalboard to = from;
+        to.items()[1].title("Split");
+        PedalboardPatch patch;
+        REQUIRE(!PedalboardPatch::Make(from, to, &patch));
+    }
+    // snapshots.
+    {
+        Pedalboard to = from;
+        to.snapshots().push_back(std::make_shared<Snapshot>());
+        PedalboardPatch patch;
+        REQUIRE(!PedalboardPatch::Make(from, to, &patch));
+    }
+}
+
+TEST_CASE("Pedalboard copies share LV2 state values", "[pedalboard_patch][Build][Dev]")
+{
+    Pedalboard pedalboard = MakePedalboard();
+    PedalboardItem &item = pedalboard.items()[0];
+    item.lv2State().isValid_ = true;
+    Lv2PluginStateEntry &entry = item.lv2State().values_["http://example.com/plugins/amp#model"];
+    entry.atomType_ = "http://lv2plug.in/ns/ext/atom#Chunk";
+    entry.value_ = std::vector<uint8_t>(100000, 7);
+
+    Pedalboard copy = pedalboard.DeepCopy();
+    const Lv2PluginStateEntry &copiedEntry = copy.items()[0].lv2State().values_["http://example.com/plugins/amp#model"];
+    REQUIRE(copiedEntry.value_.IsSharedWith(entry.value_));
+    REQUIRE(copy.items()[0].lv2State() == item.lv2State());
+
+    // assignment replaces the value; it doesn't modify the shared copy.
+    entry.value_ = std::vector<uint8_t>(100000, 8);
+    REQUIRE(!copiedEntry.value_.IsSharedWith(entry.value_));
+    REQUIRE(copiedEntry.value_[0] == 7);
+    REQUIRE(entry.value_[0] == 8);
+    REQUIRE(copy.items()[0].lv2State() != item.lv2State());
+}
@@ -0,0 +1,390 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "PedalboardPreloader.hpp"
+#include "PluginHost.hpp"
+#include "Lv2Pedalboard.hpp"
+#include "SchedulerPriority.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include "json.hpp"
+#include <fcntl.h>
+#include <malloc.h>
+#include <sstream>
+#include <unistd.h>
+
+using namespace pipedal;
+
+PedalboardPreloader::PedalboardPreloader(PluginHost &pluginHost, size_t maxPreloads, size_t memoryLimitBytes)
+    : pluginHost(pluginHost),
+      maxPreloads(maxPreloads),
+      memoryLimitBytes(memoryLimitBytes)
+{
+    thread = std::make_unique<std::thread>([this]()
+                                           { ThreadProc(); });
+    cacheRegistration = CacheRegistry::GetInstance().Register(
+        "preloaded pedalboards", CachePriority::Expensive,
+        [this]()
+        { return GetMemoryUse(); },
+        [this](TrimLevel level)
+        { Trim(level == TrimLevel::Critical); });
+}
+
+PedalboardPreloader::~PedalboardPreloader()
+{
+    cacheRegistration = nullptr; // waits for an in-progress trim.
+    {
+        std::lock_guard lock(mutex);
+        closing = true;
+        cv.notify_all();
+    }
+    if (thread)
+    {
+        thread->join();
+        thread = nullptr;
+    }
+    Release(entries);
+}
+
+void PedalboardPreloader::Release(EntryList &entries)
+{
+    for (auto &entry : entries)
+    {
+        if (entry.lv2Pedalboard)
+        {
+            entry.lv2Pedalboard->Deactivate();
+            entry.lv2Pedalboard = nullptr;
+        }
+    }
+    entries.clear();
+}
+
+size_t PedalboardPreloader::GetHeapBytes()
+{
+    // approximate: includes allocations made concurrently by other threads.
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+PedalboardPreloader::EntryList::iterator PedalboardPreloader::FindEntry(int64_t presetId)
+{
+    for (auto it = entries.begin(); it != entries.end(); ++it)
+    {
+        if (it->presetId == presetId)
+        {
+            return it;
+        }
+    }
+    return entries.end();
+}
+
+bool PedalboardPreloader::IsRequested(int64_t presetId) const
+{
+    for (size_t i = 0; i < requests.size() && i < maxPreloads; ++i)
+    {
+        if (requests[i].presetId == presetId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PedalboardPreloader::GetNextRequest(Request *request)
+{
+    for (size_t i = 0; i < requests.size() && i < maxPreloads; ++i)
+    {
+        int64_t presetId = requests[i].presetId;
+        if (FindEntry(presetId) == entries.end() && !skippedPresetIds.contains(presetId))
+        {
+            *request = requests[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+PedalboardPreloader::EntryList PedalboardPreloader::EvictEntries()
+{
+    EntryList result;
+    size_t memoryUse = 0;
+    for (const auto &entry : entries)
+    {
+        memoryUse += entry.memoryBytes;
+    }
+    while (!entries.empty() && (entries.size() > maxPreloads || memoryUse > memoryLimitBytes))
+    {
+        Entry &entry = entries.back();
+        memoryUse -= entry.memoryBytes;
+        if (IsRequested(entry.presetId))
+        {
+            // don't rebuild it just to evict it again.
+            skippedPresetIds.insert(entry.presetId);
+            Lv2Log::info(SS("Preset " << entry.presetId << " not preloaded. (Preload memory limit exceeded.)"));
+        }
+        result.splice(result.begin(), entries, std::prev(entries.end()));
+    }
+    return result;
+}
+
+void PedalboardPreloader::SetRequests(std::vector<Request> &&requests)
+{
+    EntryList released;
+    {
+        std::lock_guard lock(mutex);
+        this->requests = std::move(requests);
+        skippedPresetIds.clear();
+
+        // move requested entries to the front of the LRU list, in priority order.
+        for (auto request = this->requests.rbegin(); request != this->requests.rend(); ++request)
+        {
+            auto it = FindEntry(request->presetId);
+            if (it == entries.end())
+            {
+                continue;
+            }
+            if (!it->pedalboard.IsStructureIdentical(request->pedalboard))
+            {
+                // the preset has been edited. Build it again.
+                released.splice(released.end(), entries, it);
+                continue;
+            }
+            entries.splice(entries.begin(), entries, it);
+        }
+        EntryList evicted = EvictEntries();
+        released.splice(released.end(), evicted);
+        cv.notify_all();
+    }
+    Release(released);
+}
+
+void PedalboardPreloader::SetPrefetchFiles(std::vector<std::filesystem::path> &&files)
+{
+    std::lock_guard lock(mutex);
+    std::set<std::filesystem::path> stillPrefetched;
+    for (const auto &file : files)
+    {
+        if (prefetchedFiles.contains(file))
+        {
+            stillPrefetched.insert(file);
+        }
+    }
+    prefetchedFiles = std::move(stillPrefetched);
+    prefetchFiles = std::move(files);
+    cv.notify_all();
+}
+
+void PedalboardPreloader::PrefetchFile(const std::filesystem::path &path)
+{
+    // Read (rather than posix_fadvise), so that the reads are issued at this thread's I/O priority.
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return;
+    }
+    char buffer[64 * 1024];
+    while (read(fd, buffer, sizeof(buffer)) > 0)
+    {
+    }
+    close(fd);
+}
+
+void PedalboardPreloader::Clear()
+{
+    EntryList released;
+    {
+        std::lock_guard lock(mutex);
+        ++generation;
+        requests.clear();
+        skippedPresetIds.clear();
+        released.splice(released.end(), entries);
+    }
+    Release(released);
+}
+
+static std::string ToJson(const Pedalboard &pedalboard)
+{
+    std::stringstream s;
+    json_writer writer(s);
+    writer.write(pedalboard);
+    return s.str();
+}
+
+std::shared_ptr<Lv2Pedalboard> PedalboardPreloader::Take(int64_t presetId, const Pedalboard &pedalboard, bool *settingsChanged)
+{
+    EntryList released;
+    std::shared_ptr<Lv2Pedalboard> result;
+    {
+        std::unique_lock lock(mutex);
+        // a preload that's in progress will be done sooner than a fresh load.
+        cv.wait(lock, [this, presetId]()
+                { return loadingPresetId != presetId; });
+
+        for (auto it = requests.begin(); it != requests.end(); ++it)
+        {
+            if (it->presetId == presetId)
+            {
+                requests.erase(it);
+                break;
+            }
+        }
+        auto it = FindEntry(presetId);
+        if (it == entries.end())
+        {
+            return nullptr;
+        }
+        released.splice(released.end(), entries, it);
+        Entry &entry = released.front();
+        if (entry.pedalboard.IsStructureIdentical(pedalboard))
+        {
+            *settingsChanged = ToJson(entry.pedalboard) != ToJson(pedalboard);
+            result = std::move(entry.lv2Pedalboard);
+        }
+    }
+    Release(released);
+    return result;
+}
+
+size_t PedalboardPreloader::GetPreloadedCount()
+{
+    std::lock_guard lock(mutex);
+    return entries.size();
+}
+
+size_t PedalboardPreloader::GetMemoryUse()
+{
+    std::lock_guard lock(mutex);
+    size_t result = 0;
+    for (const auto &entry : entries)
+    {
+        result += entry.memoryBytes;
+    }
+    return result;
+}
+
+void PedalboardPreloader::Trim(bool releaseAll)
+{
+    EntryList released;
+    {
+        std::lock_guard lock(mutex);
+        size_t keep = releaseAll ? 0 : entries.size() / 2;
+        while (entries.size() > keep)
+        {
+            skippedPresetIds.insert(entries.back().presetId);
+            released.splice(released.begin(), entries, std::prev(entries.end()));
+        }
+    }
+    Release(released);
+}
+
+void PedalboardPreloader::ThreadProc()
+{
+    SetThreadName("preload");
+    SetThreadPriority(SchedulerPriority::BackgroundBatch); // nice, and idle I/O priority.
+
+    while (true)
+    {
+        Request request;
+        uint64_t requestGeneration;
+        {
+            std::filesystem::path prefetchFile;
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [this, &request, &prefetchFile]()
+                    {
+                        prefetchFile.clear();
+                        if (closing || GetNextRequest(&request))
+                        {
+                            return true;
+                        }
+                        while (!prefetchFiles.empty())
+                        {
+                            prefetchFile = std::move(prefetchFiles.front());
+                            prefetchFiles.erase(prefetchFiles.begin());
+                            if (!prefetchedFiles.contains(prefetchFile))
+                            {
+                                return true;
+                            }
+                        }
+                        return false; });
+            if (closing)
+            {
+                return;
+            }
+            if (!prefetchFile.empty())
+            {
+                // preset requests take priority, so check them again after each file.
+                prefetchedFiles.insert(prefetchFile);
+                lock.unlock();
+                PrefetchFile(prefetchFile);
+                continue;
+            }
+            requestGeneration = generation;
+            loadingPresetId = request.presetId;
+        }
+
+        std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+        size_t memoryBytes = 0;
+        try
+        {
+            size_t heapBefore = GetHeapBytes();
+            Lv2PedalboardErrorList errorMessages;
+            lv2Pedalboard = std::shared_ptr<Lv2Pedalboard>(pluginHost.CreateLv2Pedalboard(request.pedalboard, errorMessages));
+            lv2Pedalboard->Activate();
+            size_t heapAfter = GetHeapBytes();
+            memoryBytes = heapAfter > heapBefore ? heapAfter - heapBefore : 0;
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS("Failed to preload preset " << request.presetId << ". " << e.what()));
+            lv2Pedalboard = nullptr;
+        }
+
+        EntryList released;
+        {
+            std::lock_guard lock(mutex);
+            loadingPresetId = -1;
+            if (!lv2Pedalboard)
+            {
+                skippedPresetIds.insert(request.presetId);
+            }
+            else if (requestGeneration == generation && IsRequested(request.presetId) && FindEntry(request.presetId) == entries.end())
+            {
+                Entry entry;
+                entry.presetId = request.presetId;
+                entry.pedalboard = std::move(request.pedalboard);
+                entry.lv2Pedalboard = std::move(lv2Pedalboard);
+                entry.memoryBytes = memoryBytes;
+                entries.push_front(std::move(entry));
+                released = EvictEntries();
+            }
+            else
+            {
+                // stale.
+                Entry entry;
+                entry.lv2Pedalboard = std::move(lv2Pedalboard);
+                released.push_back(std::move(entry));
+            }
+            cv.notify_all();
+        }
+        Release(released);
+    }
+}
@@ -0,0 +1,142 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Pedalboard.hpp"
+#include "CacheRegistry.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    class PluginHost;
+    class Lv2Pedalboard;
+
+    /**
+     * @brief Instantiates and activates pedalboards for nearby presets ahead of time.
+     *
+     * Building an Lv2Pedalboard for a preset with NAM models or convolution reverbs can take
+     * hundreds of milliseconds. The preloader builds them on a background thread for the presets
+     * most likely to be selected next, so that a preset switch only has to hand the audio
+     * thread a pointer.
+     *
+     * The preload thread runs at idle I/O priority, so that the model and impulse files it reads don't
+     * compete with foreground file access. When there are no presets left to load, it also reads
+     * prefetch files (e.g. the bank files of adjacent banks) into the page cache.
+     *
+     * Preloaded pedalboards are held in LRU order, and evicted when there are more than
+     * maxPreloads of them, or when their (approximate) combined memory use exceeds the memory limit.
+     *
+     * All public methods are called on the model (host) thread, except Trim(), which the CacheRegistry
+     * calls under memory pressure. Trimming only releases preloads; a pedalboard that has been taken
+     * (i.e. the active pedalboard) is no longer owned by the preloader.
+     */
+    class PedalboardPreloader
+    {
+    public:
+        struct Request
+        {
+            int64_t presetId = -1;
+            Pedalboard pedalboard;
+        };
+
+        PedalboardPreloader(PluginHost &pluginHost, size_t maxPreloads, size_t memoryLimitBytes);
+        ~PedalboardPreloader();
+
+        PedalboardPreloader(const PedalboardPreloader &) = delete;
+        PedalboardPreloader &operator=(const PedalboardPreloader &) = delete;
+
+        // Replace the set of presets to preload, most important first. Presets that are already loaded are kept.
+        void SetRequests(std::vector<Request> &&requests);
+
+        // Replace the set of files to read into the page cache, most important first.
+        void SetPrefetchFiles(std::vector<std::filesystem::path> &&files);
+
+        // Discard all preloaded pedalboards (e.g. because the audio configuration has changed).
+        void Clear();
+
+        /**
+         * @brief Take the preloaded pedalboard for a preset.
+         *
+         * If a preload for the preset is in progress, waits for it to complete.
+         *
+         * @param presetId The preset.
+         * @param pedalboard The pedalboard that is about to be loaded.
+         * @param settingsChanged Set to true if the preload was built from a version of the pedalboard with
+         *        different control values or state, which must then be sent to the audio thread as a snapshot.
+         * @return The (activated) Lv2Pedalboard, or null if no structurally identical preload is available.
+         */
+        std::shared_ptr<Lv2Pedalboard> Take(int64_t presetId, const Pedalboard &pedalboard, bool *settingsChanged);
+
+        size_t GetPreloadedCount();
+        size_t GetMemoryUse();
+
+        // Release the least recently requested half of the preloads, or all of them. Released presets
+        // aren't preloaded again until the next SetRequests().
+        void Trim(bool releaseAll);
+
+    private:
+        struct Entry
+        {
+            int64_t presetId = -1;
+            Pedalboard pedalboard;
+            std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+            size_t memoryBytes = 0;
+        };
+        using EntryList = std::list<Entry>;
+
+        void ThreadProc();
+        bool IsRequested(int64_t presetId) const;
+        EntryList::iterator FindEntry(int64_t presetId);
+        // Returns entries that have to be released (outside the lock).
+        EntryList EvictEntries();
+
+        bool GetNextRequest(Request *request);
+        static void PrefetchFile(const std::filesystem::path &path);
+        static void Release(EntryList &entries);
+        static size_t GetHeapBytes();
+
+        PluginHost &pluginHost;
+        size_t maxPreloads;
+        size_t memoryLimitBytes;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool closing = false;
+        uint64_t generation = 0; // incremented by Clear(), so that in-progress preloads are discarded.
+        std::vector<Request> requests;
+        EntryList entries; // most recently requested first.
+        std::set<int64_t> skippedPresetIds; // failed, or too large to keep. Retried after the next SetRequests().
+        std::vector<std::filesystem::path> prefetchFiles;
+        std::set<std::filesystem::path> prefetchedFiles; // already read, since the last SetPrefetchFiles().
+        int64_t loadingPresetId = -1;
+        std::unique_ptr<std::thread> thread;
+        CacheRegistry::Registration::ptr cacheRegistration;
+    };
+}
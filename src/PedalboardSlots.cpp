@@ -0,0 +1,114 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "PedalboardSlots.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+using namespace pipedal;
+
+static void ValidatePorts(const std::string &slotName, const std::vector<std::string> &ports, std::set<std::string> &claimedPorts)
+{
+    if (ports.size() < 1 || ports.size() > 2)
+    {
+        throw std::invalid_argument(SS("Pedalboard slot '" << slotName << "' must have one or two input and output channels."));
+    }
+    for (const auto &port : ports)
+    {
+        if (!claimedPorts.insert(port).second)
+        {
+            throw std::invalid_argument(SS("Channel " << port << " is used by more than one pedalboard slot."));
+        }
+    }
+}
+
+void PedalboardSlots::Validate() const
+{
+    if (slots_.size() > MAX_SLOTS)
+    {
+        throw std::invalid_argument(SS("Too many pedalboard slots (maximum " << MAX_SLOTS << ")."));
+    }
+    std::set<std::string> claimedInputs, claimedOutputs;
+    for (const auto &slot : slots_)
+    {
+        ValidatePorts(slot.name_, slot.inputAudioPorts_, claimedInputs);
+        ValidatePorts(slot.name_, slot.outputAudioPorts_, claimedOutputs);
+    }
+}
+
+static std::vector<std::string> UnclaimedPorts(const std::vector<std::string> &selectedPorts, const std::vector<PedalboardSlot> &slots, bool inputs)
+{
+    std::vector<std::string> result;
+    for (const auto &port : selectedPorts)
+    {
+        bool claimed = false;
+        for (const auto &slot : slots)
+        {
+            const auto &slotPorts = inputs ? slot.inputAudioPorts_ : slot.outputAudioPorts_;
+            if (std::find(slotPorts.begin(), slotPorts.end(), port) != slotPorts.end())
+            {
+                claimed = true;
+                break;
+            }
+        }
+        if (!claimed)
+        {
+            result.push_back(port);
+        }
+    }
+    return result;
+}
+
+JackChannelSelection PedalboardSlots::GetMainChannelSelection(const JackChannelSelection &selection) const
+{
+    return JackChannelSelection(
+        UnclaimedPorts(selection.GetInputAudioPorts(), slots_, true),
+        UnclaimedPorts(selection.GetOutputAudioPorts(), slots_, false),
+        selection.LegacyGetInputMidiDevices());
+}
+
+std::vector<int> PedalboardSlots::GetChannelIndices(const std::vector<std::string> &ports, const std::vector<std::string> &selectedPorts)
+{
+    std::vector<int> result;
+    for (const auto &port : ports)
+    {
+        auto it = std::find(selectedPorts.begin(), selectedPorts.end(), port);
+        if (it != selectedPorts.end())
+        {
+            result.push_back((int)(it - selectedPorts.begin()));
+        }
+    }
+    return result;
+}
+
+JSON_MAP_BEGIN(PedalboardSlot)
+    JSON_MAP_REFERENCE(PedalboardSlot, name)
+    JSON_MAP_REFERENCE(PedalboardSlot, inputAudioPorts)
+    JSON_MAP_REFERENCE(PedalboardSlot, outputAudioPorts)
+    JSON_MAP_REFERENCE(PedalboardSlot, bankId)
+    JSON_MAP_REFERENCE(PedalboardSlot, presetId)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(PedalboardSlots)
+    JSON_MAP_REFERENCE(PedalboardSlots, slots)
+JSON_MAP_END()
@@ -0,0 +1,67 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include "JackConfiguration.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+
+    // An additional pedalboard that runs alongside the main pedalboard, on its own channels and its own core
+    // (e.g. bass on inputs 3-4 while guitar uses inputs 1-2). A slot plays a saved preset from any bank.
+    class PedalboardSlot
+    {
+    public:
+        std::string name_;
+        // audio ports (as in JackChannelSelection) claimed by the slot. One or two of each.
+        std::vector<std::string> inputAudioPorts_;
+        std::vector<std::string> outputAudioPorts_;
+        int64_t bankId_ = -1;
+        int64_t presetId_ = -1;
+
+        DECLARE_JSON_MAP(PedalboardSlot);
+    };
+
+    // The additional pedalboard slots. The main pedalboard (the one the UI edits) isn't listed; it gets the
+    // selected ports that no slot claims.
+    class PedalboardSlots
+    {
+    public:
+        static constexpr size_t MAX_SLOTS = 3;
+
+        std::vector<PedalboardSlot> slots_;
+
+        // Throws std::invalid_argument if a slot has the wrong number of ports, or a port is claimed twice.
+        void Validate() const;
+
+        // The channel selection for the main pedalboard.
+        JackChannelSelection GetMainChannelSelection(const JackChannelSelection &selection) const;
+
+        // Positions of ports in selectedPorts (i.e. audio driver channel indices). Ports that aren't selected are omitted.
+        static std::vector<int> GetChannelIndices(const std::vector<std::string> &ports, const std::vector<std::string> &selectedPorts);
+
+        DECLARE_JSON_MAP(PedalboardSlots);
+    };
+}
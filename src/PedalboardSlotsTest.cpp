@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PedalboardSlots.hpp"
+#include <stdexcept>
+
+using namespace pipedal;
+
+static PedalboardSlot MakeSlot(const std::string &name, std::vector<std::string> inputs, std::vector<std::string> outputs)
+{
+    PedalboardSlot slot;
+    slot.name_ = name;
+    slot.inputAudioPorts_ = inputs;
+    slot.outputAudioPorts_ = outputs;
+    return slot;
+}
+
+TEST_CASE("PedalboardSlots", "[pedalboard_slots][Build][Dev]")
+{
+    JackChannelSelection selection(
+        {"system:capture_1", "system:capture_2", "system:capture_3", "system:capture_4"},
+        {"system:playback_1", "system:playback_2", "system:playback_3", "system:playback_4"},
+        {});
+
+    PedalboardSlots slots;
+    slots.slots_.push_back(MakeSlot("Bass", {"system:capture_3", "system:capture_4"}, {"system:playback_3", "system:playback_4"}));
+    slots.Validate();
+
+    JackChannelSelection main = slots.GetMainChannelSelection(selection);
+    REQUIRE(main.GetInputAudioPorts() == std::vector<std::string>{"system:capture_1", "system:capture_2"});
+    REQUIRE(main.GetOutputAudioPorts() == std::vector<std::string>{"system:playback_1", "system:playback_2"});
+
+    REQUIRE(PedalboardSlots::GetChannelIndices(slots.slots_[0].inputAudioPorts_, selection.GetInputAudioPorts()) == std::vector<int>{2, 3});
+    REQUIRE(PedalboardSlots::GetChannelIndices(main.GetOutputAudioPorts(), selection.GetOutputAudioPorts()) == std::vector<int>{0, 1});
+    // unselected ports are omitted.
+    REQUIRE(PedalboardSlots::GetChannelIndices({"system:capture_9", "system:capture_1"}, selection.GetInputAudioPorts()) == std::vector<int>{0});
+
+    // a port can only belong to one slot.
+    slots.slots_.push_back(MakeSlot("Keys", {"system:capture_4"}, {"system:playback_1"}));
+    REQUIRE_THROWS(slots.Validate());
+
+    // one or two channels each way.
+    slots.slots_.pop_back();
+    slots.slots_.push_back(MakeSlot("Keys", {}, {"system:playback_1"}));
+    REQUIRE_THROWS(slots.Validate());
+}
@@ -0,0 +1,99 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace pipedal
+{
+    /**
+     * @brief A fixed-capacity, lock-free set of indices that have work pending.
+     *
+     * Items flag themselves with Add() from whichever thread processes them during a period. The
+     * audio thread then visits only the flagged items at the end of the period, instead of polling
+     * every item. Visit() must not run concurrently with Add().
+     */
+    class PendingIndexList
+    {
+    public:
+        PendingIndexList() {}
+        PendingIndexList(const PendingIndexList &) = delete;
+        PendingIndexList &operator=(const PendingIndexList &) = delete;
+
+        // Not realtime-safe. Discards any pending indices.
+        void Reserve(size_t capacity)
+        {
+            this->capacity = capacity;
+            slots = capacity == 0 ? nullptr : std::make_unique<size_t[]>(capacity);
+            pending = capacity == 0 ? nullptr : std::make_unique<std::atomic<bool>[]>(capacity);
+            for (size_t i = 0; i < capacity; ++i)
+            {
+                pending[i].store(false, std::memory_order_relaxed);
+            }
+            count.store(0, std::memory_order_relaxed);
+        }
+        size_t Capacity() const { return capacity; }
+
+        // Realtime-safe, any thread. Returns false if the index was already pending.
+        bool Add(size_t index)
+        {
+            if (pending[index].exchange(true, std::memory_order_acq_rel))
+            {
+                return false;
+            }
+            slots[count.fetch_add(1, std::memory_order_acq_rel)] = index;
+            return true;
+        }
+
+        bool IsPending(size_t index) const { return pending[index].load(std::memory_order_acquire); }
+        size_t Size() const { return count.load(std::memory_order_acquire); }
+
+        // Audio thread. Calls fn(index) for each pending index, in the order they were added.
+        // Indices for which fn returns true stay pending for the next visit.
+        template <typename FN>
+        void Visit(FN &&fn)
+        {
+            size_t n = count.load(std::memory_order_acquire);
+            size_t kept = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t index = slots[i];
+                if (fn(index))
+                {
+                    slots[kept++] = index;
+                }
+                else
+                {
+                    pending[index].store(false, std::memory_order_release);
+                }
+            }
+            count.store(kept, std::memory_order_release);
+        }
+
+    private:
+        size_t capacity = 0;
+        std::unique_ptr<size_t[]> slots;
+        std::unique_ptr<std::atomic<bool>[]> pending;
+        std::atomic<size_t> count{0};
+    };
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PendingIndexList.hpp"
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+
+TEST_CASE("PendingIndexList", "[pending_index_list][Build][Dev]")
+{
+    PendingIndexList list;
+    list.Reserve(8);
+
+    // an index is only added once per visit.
+    REQUIRE(list.Add(3));
+    REQUIRE(list.Add(5));
+    REQUIRE(!list.Add(3));
+    REQUIRE(list.Size() == 2);
+    REQUIRE(list.IsPending(3));
+    REQUIRE(!list.IsPending(4));
+
+    std::vector<size_t> visited;
+    list.Visit([&](size_t index)
+               {
+        visited.push_back(index);
+        return index == 5; // still has work pending.
+    });
+    REQUIRE(visited == std::vector<size_t>{3, 5});
+    REQUIRE(list.Size() == 1);
+    REQUIRE(!list.IsPending(3));
+    REQUIRE(list.IsPending(5));
+
+    REQUIRE(list.Add(3));
+    visited.clear();
+    list.Visit([&](size_t index)
+               {
+        visited.push_back(index);
+        return false; });
+    REQUIRE(visited == std::vector<size_t>{5, 3});
+    REQUIRE(list.Size() == 0);
+
+    // concurrent adds from several threads.
+    constexpr size_t N = 8;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&list]()
+                             {
+            for (size_t i = 0; i < N; ++i)
+            {
+                list.Add(i);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(list.Size() == N);
+    size_t sum = 0;
+    list.Visit([&](size_t index)
+               {
+        sum += index;
+        return false; });
+    REQUIRE(sum == N * (N - 1) / 2);
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "PerfCounterGroup.hpp"
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+using namespace pipedal;
+
+static long perf_event_open(struct perf_event_attr *hw_event, pid_t pid,
+                            int cpu, int group_fd, unsigned long flags)
+{
+    return syscall(__NR_perf_event_open, hw_event, pid, cpu, group_fd, flags);
+}
+
+static constexpr uint64_t CacheConfig(uint64_t cache, uint64_t op, uint64_t result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+
+namespace
+{
+    struct EventDefinition
+    {
+        const char *name;
+        uint32_t type;
+        uint64_t config;
+    };
+
+    // Indexed by PmuEvent.
+    const EventDefinition eventDefinitions[PMU_EVENT_COUNT] = {
+        {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {"l1dMisses", PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {"l2Misses", PERF_TYPE_HW_CACHE, CacheConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {"branchMisses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {"stalledCycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND},
+    };
+}
+
+PerfCounterGroup::PerfCounterGroup(pid_t threadId)
+{
+    for (size_t i = 0; i < PMU_EVENT_COUNT; ++i)
+    {
+        fds[i] = -1;
+        slots[i] = -1;
+    }
+    for (size_t i = 0; i < PMU_EVENT_COUNT; ++i)
+    {
+        struct perf_event_attr pe;
+        memset(&pe, 0, sizeof(pe));
+        pe.type = eventDefinitions[i].type;
+        pe.size = sizeof(pe);
+        pe.config = eventDefinitions[i].config;
+        pe.disabled = groupFd == -1 ? 1 : 0; // siblings follow the leader.
+        pe.exclude_kernel = 1;
+        pe.exclude_hv = 1;
+        pe.read_format = PERF_FORMAT_GROUP;
+
+        int fd = (int)perf_event_open(&pe, threadId, -1, groupFd, PERF_FLAG_FD_CLOEXEC);
+        if (fd == -1)
+        {
+            if (i == (size_t)PmuEvent::Cycles)
+            {
+                return; // no usable PMU.
+            }
+            continue;
+        }
+        if (groupFd == -1)
+        {
+            groupFd = fd;
+        }
+        fds[i] = fd;
+        slots[i] = (int)nSlots++;
+    }
+}
+
+PerfCounterGroup::~PerfCounterGroup()
+{
+    // siblings first.
+    for (size_t i = PMU_EVENT_COUNT; i-- > 0;)
+    {
+        if (fds[i] != -1)
+        {
+            close(fds[i]);
+        }
+    }
+}
+
+void PerfCounterGroup::Enable()
+{
+    if (groupFd != -1)
+    {
+        ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+void PerfCounterGroup::Disable()
+{
+    if (groupFd != -1)
+    {
+        ioctl(groupFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+void PerfCounterGroup::Reset()
+{
+    if (groupFd != -1)
+    {
+        ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+bool PerfCounterGroup::Read(PmuSample *sample) const
+{
+    if (groupFd == -1)
+    {
+        return false;
+    }
+    // PERF_FORMAT_GROUP: { nr; values[nr] }
+    uint64_t buffer[1 + PMU_EVENT_COUNT];
+    ssize_t nRead = read(groupFd, buffer, sizeof(buffer));
+    if (nRead < (ssize_t)sizeof(uint64_t) || buffer[0] != nSlots)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < PMU_EVENT_COUNT; ++i)
+    {
+        sample->values[i] = slots[i] == -1 ? 0 : buffer[1 + slots[i]];
+    }
+    return true;
+}
+
+const char *PerfCounterGroup::EventName(PmuEvent event)
+{
+    return eventDefinitions[(size_t)event].name;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace pipedal
+{
+    enum class PmuEvent
+    {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        L2Misses, // last-level cache read misses (L2 on a Pi 4, L3 on a Pi 5).
+        BranchMisses,
+        StalledCycles, // backend stalls.
+    };
+    constexpr size_t PMU_EVENT_COUNT = 6;
+
+    struct PmuSample
+    {
+        uint64_t values[PMU_EVENT_COUNT] = {};
+
+        uint64_t operator[](PmuEvent event) const { return values[(size_t)event]; }
+    };
+
+    /**
+     * @brief A perf_event group of hardware counters (cycles, instructions, cache and branch misses, stalls).
+     *
+     * Uses the generic perf hardware events, so it works on both aarch64 and x86_64. Events that the
+     * CPU (or a virtualized kernel) doesn't support are left out of the group, and read as zero.
+     *
+     * The counters follow one thread. All counters in the group are read with a single read() call,
+     * so Read() may be called from any thread, including the audio thread while profiling.
+     */
+    class PerfCounterGroup
+    {
+    public:
+        // threadId: the thread to count (a tid), or 0 for the calling thread. User-mode counts only.
+        PerfCounterGroup(pid_t threadId = 0);
+        ~PerfCounterGroup();
+        PerfCounterGroup(const PerfCounterGroup &) = delete;
+        PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+        // False if perf counters aren't available (e.g. perf_event_paranoid, or no PMU).
+        bool IsValid() const { return groupFd != -1; }
+        bool HasEvent(PmuEvent event) const { return slots[(size_t)event] != -1; }
+
+        void Enable();
+        void Disable();
+        void Reset();
+
+        // Current counts since the last Reset().
+        bool Read(PmuSample *sample) const;
+
+        static const char *EventName(PmuEvent event);
+
+    private:
+        int groupFd = -1;
+        int fds[PMU_EVENT_COUNT];
+        // Position of each event in the group's read buffer, or -1 if not available.
+        int slots[PMU_EVENT_COUNT];
+        size_t nSlots = 0;
+    };
+}
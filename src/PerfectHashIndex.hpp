@@ -0,0 +1,191 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief A read-only map from strings to integers, with a collision-free hash.
+     *
+     * Keys are hashed into small buckets, and each bucket gets a seed that places all of its keys in
+     * empty slots ("hash and displace"). A lookup costs two hashes, one slot and at most one string
+     * compare. Meant for small, fixed key sets (a plugin's control port symbols) that are built
+     * once and looked up often.
+     */
+    class PerfectHashIndex
+    {
+    public:
+        using Entry = std::pair<std::string, int32_t>;
+
+        PerfectHashIndex() {}
+        // If a key appears more than once, the last value wins.
+        PerfectHashIndex(const std::vector<Entry> &entries)
+        {
+            for (const auto &entry : entries)
+            {
+                bool found = false;
+                for (auto &existing : this->entries)
+                {
+                    if (existing.first == entry.first)
+                    {
+                        existing.second = entry.second;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    this->entries.push_back(entry);
+                }
+            }
+            if (this->entries.empty())
+            {
+                return;
+            }
+            size_t bucketCount = 1;
+            while (bucketCount * 2 < this->entries.size())
+            {
+                bucketCount *= 2;
+            }
+            size_t tableSize = 1;
+            while (tableSize < this->entries.size() * 2)
+            {
+                tableSize *= 2;
+            }
+            while (!TryBuild(bucketCount, tableSize))
+            {
+                tableSize *= 2;
+            }
+        }
+
+        // -1 if not found.
+        int32_t Find(std::string_view key) const
+        {
+            if (slots.empty())
+            {
+                return -1;
+            }
+            uint64_t seed = bucketSeeds[Hash(key, 0) & bucketMask];
+            int32_t entryIndex = slots[Hash(key, seed) & slotMask];
+            if (entryIndex < 0 || entries[entryIndex].first != key)
+            {
+                return -1;
+            }
+            return entries[entryIndex].second;
+        }
+        size_t size() const { return entries.size(); }
+        bool empty() const { return entries.empty(); }
+        size_t TableSize() const { return slots.size(); }
+
+        static uint64_t Hash(std::string_view key, uint64_t seed)
+        {
+            // FNV-1a, seeded, with a final mix so that the low bits depend on every byte.
+            uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+            for (char c : key)
+            {
+                h ^= (uint8_t)c;
+                h *= 0x100000001b3ULL;
+            }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+    private:
+        static constexpr uint64_t MAX_SEED_TRIES = 4096;
+
+        bool TryBuild(size_t bucketCount, size_t tableSize)
+        {
+            bucketMask = bucketCount - 1;
+            slotMask = tableSize - 1;
+            bucketSeeds.assign(bucketCount, 0);
+            slots.assign(tableSize, -1);
+
+            std::vector<std::vector<int32_t>> buckets(bucketCount);
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                buckets[Hash(entries[i].first, 0) & bucketMask].push_back((int32_t)i);
+            }
+            std::vector<size_t> order(bucketCount);
+            for (size_t i = 0; i < bucketCount; ++i)
+            {
+                order[i] = i;
+            }
+            // place the largest buckets while the table is emptiest.
+            std::stable_sort(order.begin(), order.end(), [&buckets](size_t left, size_t right)
+                             { return buckets[left].size() > buckets[right].size(); });
+
+            std::vector<uint64_t> bucketSlots;
+            for (size_t bucket : order)
+            {
+                const auto &keys = buckets[bucket];
+                if (keys.empty())
+                {
+                    break;
+                }
+                bool placed = false;
+                for (uint64_t seed = 1; seed <= MAX_SEED_TRIES && !placed; ++seed)
+                {
+                    bucketSlots.clear();
+                    placed = true;
+                    for (int32_t key : keys)
+                    {
+                        uint64_t slot = Hash(entries[key].first, seed) & slotMask;
+                        if (slots[slot] != -1 || std::find(bucketSlots.begin(), bucketSlots.end(), slot) != bucketSlots.end())
+                        {
+                            placed = false;
+                            break;
+                        }
+                        bucketSlots.push_back(slot);
+                    }
+                    if (placed)
+                    {
+                        bucketSeeds[bucket] = seed;
+                        for (size_t i = 0; i < keys.size(); ++i)
+                        {
+                            slots[bucketSlots[i]] = keys[i];
+                        }
+                    }
+                }
+                if (!placed)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        uint64_t bucketMask = 0;
+        uint64_t slotMask = 0;
+        std::vector<uint64_t> bucketSeeds;
+        std::vector<int32_t> slots; // indices into entries, or -1.
+        std::vector<Entry> entries;
+    };
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PerfectHashIndex.hpp"
+#include <string>
+
+using namespace pipedal;
+
+TEST_CASE("PerfectHashIndex", "[perfect_hash_index][Build][Dev]")
+{
+    PerfectHashIndex emptyIndex;
+    REQUIRE(emptyIndex.Find("gain") == -1);
+
+    std::vector<PerfectHashIndex::Entry> entries{
+        {"gain", 3},
+        {"bypass", 0},
+        {"level", 7},
+        {"gain", 4}, // last one wins.
+    };
+    PerfectHashIndex index(entries);
+    REQUIRE(index.size() == 3);
+    REQUIRE(index.Find("gain") == 4);
+    REQUIRE(index.Find("bypass") == 0);
+    REQUIRE(index.Find("level") == 7);
+    REQUIRE(index.Find("levels") == -1);
+    REQUIRE(index.Find("") == -1);
+
+    // a plugin-sized symbol set.
+    std::vector<PerfectHashIndex::Entry> many;
+    for (int32_t i = 0; i < 500; ++i)
+    {
+        many.push_back({"port_" + std::to_string(i), i});
+    }
+    PerfectHashIndex manyIndex(many);
+    for (int32_t i = 0; i < 500; ++i)
+    {
+        REQUIRE(manyIndex.Find("port_" + std::to_string(i)) == i);
+    }
+    REQUIRE(manyIndex.Find("port_500") == -1);
+    REQUIRE(manyIndex.TableSize() <= 2048);
+}
@@ -30,6 +30,7 @@
 #include "Lv2Log.hpp"
 #include <mutex>
 #include "AlsaDriver.hpp"
+#include "PipeWireDriver.hpp"
 #include <iomanip>
 #include <chrono>
 #include <thread>
@@ -60,7 +61,8 @@ void PrintHelp()
     pp << Indent(0) << "Syntax\n\n";
     pp << Indent(2) << "pipedal_latency_test [<options>] <input-device> [<output-device>]\n\n";
     pp << "where <input-device> is the name of an ALSA capture device and <output-device> is the name of a playback device. "
-          "If <output-device> is omitted, the input device will be used for both capture and playback. Typically the device names start with 'hw:'.\n\n";
+          "If <output-device> is omitted, the input device will be used for both capture and playback. Typically the device names start with 'hw:'. "
+          "Use 'pipewire:channels_<n>' to test the PipeWire driver (connect the pipedal node's ports to the device under test with pw-link or qpwgraph).\n\n";
     pp << Indent(0) << "Options\n\n";
     pp << Indent(15);
 
@@ -97,7 +99,8 @@ void PrintHelp()
     pp << Indent(0) << "Examples\n\n";
     pp << Indent(2) << "pipedal_latency_test --list\n\n";
     pp << Indent(2) << "pipedal_latency_test hw:M2 hw:M2\n";
-    pp << Indent(2) << "pipedal_latency_test hw:M2 hw:Device2\n\n";
+    pp << Indent(2) << "pipedal_latency_test hw:M2 hw:Device2\n";
+    pp << Indent(2) << "pipedal_latency_test pipewire:channels_2\n\n";
 }
 
 void ListDevices()
@@ -121,6 +124,11 @@ void ListDevices()
             pp << HangingIndent() << (device.id_) << "\t"
                << device.longName_ << "\n";
         }
+        if (IsPipeWireAvailable())
+        {
+            auto pipeWireDevice = MakePipeWireDeviceInfo(2);
+            pp << HangingIndent() << pipeWireDevice.id_ << "\t" << pipeWireDevice.longName_ << "\n";
+        }
     }
 }
 
@@ -208,7 +216,14 @@ public:
                 inputAudioPorts, outputAudioPorts,
                 std::vector<AlsaMidiDeviceInfo>());
 
-            audioDriver = CreateAlsaDriver(this);
+            if (serverSettings.IsPipeWireAudioDevice())
+            {
+                audioDriver = CreatePipeWireDriver(this);
+            }
+            else
+            {
+                audioDriver = CreateAlsaDriver(this);
+            }
 
             latencyMonitor.Init(jackConfiguration.sampleRate());
             audioDriver->Open(serverSettings, channelSelection);
@@ -24,6 +24,7 @@
 #include "Lv2Log.hpp"
 #include <mutex>
 #include <algorithm>
+#include <set>
 #include "Finally.hpp"
 
 using namespace pipedal;
@@ -33,19 +34,25 @@ static uint32_t RATES[] = {
 
 std::mutex alsaMutex;
 
-bool PiPedalAlsaDevices::getCachedDevice(const std::string &name, AlsaDeviceInfo *pResult)
+bool PiPedalAlsaDevices::getCachedDevice(const std::string &cardId, const std::string &name, AlsaDeviceInfo *pResult)
 {
-    auto it = cachedDevices.find(name);
-    if (it != cachedDevices.end())
+    auto it = cachedDevices.find(cardId);
+    if (it != cachedDevices.end() && it->second.name_ == name)
     {
         *pResult = it->second;
         return true;
     }
     return false;
 }
-void PiPedalAlsaDevices::cacheDevice(const std::string &name, const AlsaDeviceInfo &deviceInfo)
+void PiPedalAlsaDevices::cacheDevice(const std::string &cardId, const AlsaDeviceInfo &deviceInfo)
 {
-    cachedDevices[name] = deviceInfo;
+    cachedDevices[cardId] = deviceInfo;
+}
+
+void PiPedalAlsaDevices::Invalidate()
+{
+    std::lock_guard guard{alsaMutex};
+    enumerationValid = false;
 }
 
 static bool isSupportedAudioDevice(const AlsaDeviceInfo &d)
@@ -158,7 +165,14 @@ std::vector<AlsaDeviceInfo> PiPedalAlsaDevices::GetAlsaDevices()
 
     std::lock_guard guard{alsaMutex};
 
+    if (enumerationValid)
+    {
+        return enumeratedDevices;
+    }
+
     std::vector<AlsaDeviceInfo> result;
+    std::set<std::string> presentCards;
+    bool complete = true;
 
     int cardNum = -1; // Start with first card
     int err;
@@ -206,12 +220,13 @@ std::vector<AlsaDeviceInfo> PiPedalAlsaDevices::GetAlsaDevices()
 
             info.name_ = snd_ctl_card_info_get_name(alsaInfo);
             info.longName_ = snd_ctl_card_info_get_longname(alsaInfo);
+            presentCards.insert(info.id_);
 
             // we can't read our own device if it's open so use data that gets
             // cached before we open audio devices.
 
             AlsaDeviceInfo cachedInfo;
-            if (getCachedDevice(info.name_, &cachedInfo))
+            if (getCachedDevice(info.id_, info.name_, &cachedInfo))
             {
                 // may have been plugged into a different USB connector.
                 cachedInfo.cardId_ = info.cardId_;
@@ -311,12 +326,17 @@ std::vector<AlsaDeviceInfo> PiPedalAlsaDevices::GetAlsaDevices()
                 }
                 if (!info.captureBusy_ && !info.playbackBusy_)
                 {
-                    cacheDevice(info.name_, info);
+                    cacheDevice(info.id_, info);
                     result.push_back(info);
                 }
+                else
+                {
+                    complete = false;
+                }
             } else {
                 if (info.captureBusy_ || info.playbackBusy_)
                 {
+                    complete = false;
                     result.push_back(info);
                 }
 
@@ -324,6 +344,10 @@ std::vector<AlsaDeviceInfo> PiPedalAlsaDevices::GetAlsaDevices()
         }
     }
 
+    // a card id that comes back later may belong to a different device.
+    std::erase_if(cachedDevices, [&presentCards](const auto &entry)
+                  { return !presentCards.contains(entry.first); });
+
     Lv2Log::debug("GetAlsaDevices --");
 
     std::vector<AlsaDeviceInfo> filtered;
@@ -342,6 +366,12 @@ std::vector<AlsaDeviceInfo> PiPedalAlsaDevices::GetAlsaDevices()
                 ));
         }
     }
+    // busy cards that haven't been probed yet get another try on the next call.
+    if (complete)
+    {
+        enumeratedDevices = filtered;
+        enumerationValid = true;
+    }
     return filtered;
 }
 
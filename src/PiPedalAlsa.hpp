@@ -72,13 +72,22 @@ namespace pipedal {
 
     class PiPedalAlsaDevices {
 
-        std::map<std::string,AlsaDeviceInfo> cachedDevices;
+        std::map<std::string,AlsaDeviceInfo> cachedDevices; // probed capabilities, by card id.
 
-        bool getCachedDevice(const std::string&name, AlsaDeviceInfo*pResult);
-        void cacheDevice(const std::string&name, const AlsaDeviceInfo&deviceInfo);
+        // the last complete enumeration, valid until Invalidate() is called.
+        std::vector<AlsaDeviceInfo> enumeratedDevices;
+        bool enumerationValid = false;
+
+        bool getCachedDevice(const std::string&cardId, const std::string&name, AlsaDeviceInfo*pResult);
+        void cacheDevice(const std::string&cardId, const AlsaDeviceInfo&deviceInfo);
     public:
         
+        // Returns cached results unless a card has been added or removed since the last call.
+        // Cards are only opened (which can disturb audio on some USB devices) the first time they are seen.
         std::vector<AlsaDeviceInfo> GetAlsaDevices();
+
+        // Discard the cached card list. Called when udev reports that a sound card was added or removed.
+        void Invalidate();
     };
     // we use ALSA sequencers now instead of ALSA rawmidi devices.
     // Used by test suite to verify migration behaviour.
@@ -27,6 +27,7 @@
 #include <iomanip>
 
 #include "PiPedalAlsa.hpp"
+#include "AlsaHotplugMonitor.hpp"
 
 using namespace pipedal;
 using namespace std;
@@ -145,3 +146,17 @@ TEST_CASE("ALSA Test", "[pipedal_alsa_test][Build][Dev]")
 
     DiscoveryTest();
 }
+
+TEST_CASE("ALSA hotplug events", "[pipedal_alsa_hotplug][Build][Dev]")
+{
+    auto isSoundEvent = [](const std::string &message)
+    {
+        return AlsaHotplugMonitor::IsSoundDeviceEvent(message.c_str(), message.length());
+    };
+    using namespace std::string_literals;
+    REQUIRE(isSoundEvent("add@/devices/usb1/1-1/sound/card1\0ACTION=add\0DEVPATH=/devices/usb1/1-1/sound/card1\0SUBSYSTEM=sound\0SEQNUM=1234"s));
+    REQUIRE(isSoundEvent("remove@/devices/usb1/1-1/sound/card1\0ACTION=remove\0SUBSYSTEM=sound\0"s));
+    REQUIRE(!isSoundEvent("add@/devices/usb1/1-2\0ACTION=add\0SUBSYSTEM=usb\0"s));
+    REQUIRE(!isSoundEvent("bind@/devices/usb1/1-1/sound/card1\0ACTION=bind\0SUBSYSTEM=sound\0"s));
+    REQUIRE(!isSoundEvent(""s));
+}
@@ -98,11 +98,38 @@ JSON_MAP_REFERENCE(PiPedalConfiguration, mlock)
 JSON_MAP_REFERENCE(PiPedalConfiguration, reactServerAddresses)
 JSON_MAP_REFERENCE(PiPedalConfiguration, socketServerAddress)
 JSON_MAP_REFERENCE(PiPedalConfiguration, threads)
+JSON_MAP_REFERENCE(PiPedalConfiguration, requestWorkerThreads)
+JSON_MAP_REFERENCE(PiPedalConfiguration, audioFileJobThreads)
+JSON_MAP_REFERENCE(PiPedalConfiguration, lv2WorkerThreads)
+JSON_MAP_REFERENCE(PiPedalConfiguration, thumbnailCacheMegabytes)
+JSON_MAP_REFERENCE(PiPedalConfiguration, decodedAudioCacheMegabytes)
+JSON_MAP_REFERENCE(PiPedalConfiguration, presetWriteDelaySeconds)
+JSON_MAP_REFERENCE(PiPedalConfiguration, binaryBankFiles)
 JSON_MAP_REFERENCE(PiPedalConfiguration, logLevel)
 JSON_MAP_REFERENCE(PiPedalConfiguration, logHttpRequests)
 JSON_MAP_REFERENCE(PiPedalConfiguration, maxUploadSize)
 JSON_MAP_REFERENCE(PiPedalConfiguration, accessPointGateway)
 JSON_MAP_REFERENCE(PiPedalConfiguration, accessPointServerAddress)
 JSON_MAP_REFERENCE(PiPedalConfiguration, isVst3Enabled)
+JSON_MAP_REFERENCE(PiPedalConfiguration, preloadPresets)
+JSON_MAP_REFERENCE(PiPedalConfiguration, preloadMemoryLimitMb)
+JSON_MAP_REFERENCE(PiPedalConfiguration, pedalboardCrossfadeMs)
+JSON_MAP_REFERENCE(PiPedalConfiguration, subBlockFrames)
+JSON_MAP_REFERENCE(PiPedalConfiguration, controlRampMs)
+JSON_MAP_REFERENCE(PiPedalConfiguration, realtimeHugePages)
+JSON_MAP_REFERENCE(PiPedalConfiguration, realtimeCpus)
+JSON_MAP_REFERENCE(PiPedalConfiguration, audioIrqAffinity)
+JSON_MAP_REFERENCE(PiPedalConfiguration, overloadProtection)
+JSON_MAP_REFERENCE(PiPedalConfiguration, idleTimeoutMinutes)
+JSON_MAP_REFERENCE(PiPedalConfiguration, idleSignalThresholdDb)
+JSON_MAP_REFERENCE(PiPedalConfiguration, recordPluginCosts)
+JSON_MAP_REFERENCE(PiPedalConfiguration, pmuProfiling)
+JSON_MAP_REFERENCE(PiPedalConfiguration, flushDenormalsToZero)
+JSON_MAP_REFERENCE(PiPedalConfiguration, denormalDetection)
+JSON_MAP_REFERENCE(PiPedalConfiguration, watchdogTimeoutMs)
+JSON_MAP_REFERENCE(PiPedalConfiguration, traceEvents)
+JSON_MAP_REFERENCE(PiPedalConfiguration, parallelPluginInstantiation)
+JSON_MAP_REFERENCE(PiPedalConfiguration, serialInstantiationPlugins)
+JSON_MAP_REFERENCE(PiPedalConfiguration, sandboxedPlugins)
 JSON_MAP_REFERENCE(PiPedalConfiguration, end)
 JSON_MAP_END()
@@ -42,16 +42,63 @@ private:
     std::vector<std::string> reactServerAddresses_ = {"*:5000"};
     std::string socketServerAddress_ = "0.0.0.0:8080";
     uint32_t threads_ = 5;
+    uint32_t requestWorkerThreads_ = 2;
+    uint32_t audioFileJobThreads_ = 2;
+    uint32_t lv2WorkerThreads_ = 2;
+    uint32_t thumbnailCacheMegabytes_ = 64;
+    uint32_t decodedAudioCacheMegabytes_ = 0;
+    uint32_t presetWriteDelaySeconds_ = 5;
+    bool binaryBankFiles_ = false;
     bool logHttpRequests_ = false;
     int logLevel_ = 0;
     uint64_t maxUploadSize_ = 1024*1024;
     std::string accessPointGateway_;
     std::string accessPointServerAddress_;
     bool isVst3Enabled_ = true;
+    uint32_t preloadPresets_ = 0;
+    uint32_t preloadMemoryLimitMb_ = 256;
+    float pedalboardCrossfadeMs_ = 0;
+    uint32_t subBlockFrames_ = 0;
+    float controlRampMs_ = 0;
+    std::string realtimeHugePages_ = "none";
+    std::string realtimeCpus_;
+    bool audioIrqAffinity_ = true;
+    bool overloadProtection_ = false;
+    uint32_t idleTimeoutMinutes_ = 0;
+    float idleSignalThresholdDb_ = -60;
+    bool recordPluginCosts_ = true;
+    bool pmuProfiling_ = false;
+    bool flushDenormalsToZero_ = true;
+    bool denormalDetection_ = false;
+    uint32_t watchdogTimeoutMs_ = 1000;
+    bool traceEvents_ = false;
+    bool parallelPluginInstantiation_ = true;
+    std::vector<std::string> serialInstantiationPlugins_;
+    std::vector<std::string> sandboxedPlugins_;
     bool end_ = false; // dummy target for /var/pipedal/config/config.json
 
 public:
     bool IsVst3Enabled() const { return isVst3Enabled_; }
+    uint32_t GetPreloadPresets() const { return preloadPresets_; }
+    size_t GetPreloadMemoryLimit() const { return (size_t)preloadMemoryLimitMb_ * 1024 * 1024; }
+    float GetPedalboardCrossfadeMs() const { return pedalboardCrossfadeMs_; }
+    uint32_t GetSubBlockFrames() const { return subBlockFrames_; }
+    float GetControlRampMs() const { return controlRampMs_; }
+    const std::string &GetRealtimeHugePages() const { return realtimeHugePages_; }
+    const std::string &GetRealtimeCpus() const { return realtimeCpus_; }
+    bool GetAudioIrqAffinity() const { return audioIrqAffinity_; }
+    bool GetOverloadProtection() const { return overloadProtection_; }
+    uint32_t GetIdleTimeoutMinutes() const { return idleTimeoutMinutes_; }
+    float GetIdleSignalThresholdDb() const { return idleSignalThresholdDb_; }
+    bool GetRecordPluginCosts() const { return recordPluginCosts_; }
+    bool GetPmuProfiling() const { return pmuProfiling_; }
+    bool GetFlushDenormalsToZero() const { return flushDenormalsToZero_; }
+    bool GetDenormalDetection() const { return denormalDetection_; }
+    uint32_t GetWatchdogTimeoutMs() const { return watchdogTimeoutMs_; }
+    bool GetTraceEvents() const { return traceEvents_; }
+    bool GetParallelPluginInstantiation() const { return parallelPluginInstantiation_; }
+    const std::vector<std::string> &GetSerialInstantiationPlugins() const { return serialInstantiationPlugins_; }
+    const std::vector<std::string> &GetSandboxedPlugins() const { return sandboxedPlugins_; }
     std::filesystem::path GetConfigFilePath() const {
         return docRoot_ / "config.jason";
     }
@@ -94,6 +141,13 @@ public:
     uint16_t GetSocketServerPort() const;
 
     uint32_t GetThreads() const { return threads_; }
+    uint32_t GetRequestWorkerThreads() const { return requestWorkerThreads_; }
+    uint32_t GetAudioFileJobThreads() const { return audioFileJobThreads_; }
+    uint32_t GetLv2WorkerThreads() const { return lv2WorkerThreads_; }
+    uint32_t GetPresetWriteDelaySeconds() const { return presetWriteDelaySeconds_; }
+    bool GetBinaryBankFiles() const { return binaryBankFiles_; }
+    uint64_t GetThumbnailCacheSize() const { return (uint64_t)thumbnailCacheMegabytes_ * 1024 * 1024; }
+    uint64_t GetDecodedAudioCacheSize() const { return (uint64_t)decodedAudioCacheMegabytes_ * 1024 * 1024; }
 
     DECLARE_JSON_MAP(PiPedalConfiguration);
 };
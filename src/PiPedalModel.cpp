@@ -27,15 +27,19 @@
 #include "AudioHost.hpp"
 #include "Lv2Log.hpp"
 #include <set>
+#include <map>
 #include "PiPedalConfiguration.hpp"
 #include "AdminClient.hpp"
 #include "SplitEffect.hpp"
 #include "CpuGovernor.hpp"
+#include "SchedulerPriority.hpp"
+#include "CpuList.hpp"
 #include "RegDb.hpp"
 #include "RingBufferReader.hpp"
 #include "PiPedalUI.hpp"
 #include "atom_object.hpp"
 #include "Lv2PluginChangeMonitor.hpp"
+#include "AlsaHotplugMonitor.hpp"
 #include "HotspotManager.hpp"
 #include "DBusToLv2Log.hpp"
 #include "SysExec.hpp"
@@ -44,8 +48,24 @@
 #include "DBusLog.hpp"
 #include "AvahiService.hpp"
 #include "DummyAudioDriver.hpp"
+#include "PipeWireDriver.hpp"
 #include "AudioFiles.hpp"
+#include "AudioFileJobQueue.hpp"
+#include "PresetBundle.hpp"
+#include "ThumbnailCache.hpp"
 #include "CrashGuard.hpp"
+#include "RealtimeArena.hpp"
+#include "OverloadMonitor.hpp"
+#include "HtmlHelper.hpp"
+#include "Tracer.hpp"
+#include "Denormals.hpp"
+#include "GzipCompress.hpp"
+#include "CacheRegistry.hpp"
+#include "ThreadPool.hpp"
+#include "TemporaryFile.hpp"
+#include "PiPedalMath.hpp"
+#include <ctime>
+#include <iomanip>
 
 #ifndef NO_MLOCK
 #include <sys/mman.h>
@@ -78,8 +98,7 @@ PiPedalModel::PiPedalModel()
     : pluginHost(),
       atomConverter(pluginHost.GetMapFeature())
 {
-    this->updater = Updater::Create();
-    this->updater->Start();
+    this->updater = Updater::Create(); // started by StartUpdater(), once we're up and running.
     this->currentUpdateStatus = updater->GetCurrentStatus();
     this->pedalboard = Pedalboard::MakeDefault();
 #if JACK_HOST
@@ -133,6 +152,10 @@ void PrepareSnapshostsForSave(Pedalboard &pedalboard)
 void PiPedalModel::Close()
 {
     std::unique_ptr<AudioHost> oldAudioHost;
+    std::unique_ptr<PedalboardPreloader> oldPreloader;
+    std::shared_ptr<AudioFileJobQueue> oldAudioFileJobQueue;
+    std::unique_ptr<std::jthread> oldLatencyMeasurementThread;
+    std::unique_ptr<std::jthread> oldBankSyncThread;
     {
         std::lock_guard<std::recursive_mutex> lock(mutex);
         if (closed)
@@ -143,26 +166,78 @@ void PiPedalModel::Close()
 
         CancelAudioRetry();
 
+        if (storageFlushPostHandle)
+        {
+            CancelPost(storageFlushPostHandle);
+            storageFlushPostHandle = 0;
+        }
+        for (auto &[instanceId, pendingCapture] : pendingLv2StateCaptures)
+        {
+            CancelPost(pendingCapture.postHandle);
+        }
+        pendingLv2StateCaptures.clear();
+        UpdateCpuFrequencyPolicy("");
+        if (idleCheckPostHandle)
+        {
+            CancelPost(idleCheckPostHandle);
+            idleCheckPostHandle = 0;
+        }
+        try
+        {
+            storage.SetWriteBehind(nullptr); // flushes pending writes.
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Failed to save presets. " << e.what()));
+        }
+
         if (avahiService)
         {
             this->avahiService = nullptr; // and close.
         }
 
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->Close();
         }
-        this->subscribers.resize(0);
+        {
+            std::lock_guard subscribersLock(subscribersMutex);
+            this->subscribers = std::make_shared<const std::vector<IPiPedalModelSubscriber::ptr>>();
+        }
 
         oldAudioHost = std::move(this->audioHost);
+        oldLatencyMeasurementThread = std::move(this->latencyMeasurementThread);
+        oldBankSyncThread = std::move(this->bankSyncThread);
+        oldPreloader = std::move(this->pedalboardPreloader);
+        oldAudioFileJobQueue = std::move(this->audioFileJobQueue);
     } // end lock.
 
+    if (oldAudioFileJobQueue)
+    {
+        // lockless, since jobs notify subscribers.
+        oldAudioFileJobQueue->Close();
+        AudioDirectoryInfo::SetJobQueue(nullptr, nullptr);
+        oldAudioFileJobQueue = nullptr;
+    }
+    AudioDirectoryInfo::SetThumbnailCache(nullptr);
+    AudioDirectoryInfo::SetDecodedAudioCache(nullptr);
+    CacheRegistry::GetInstance().StopMonitoring();
+
     // lockless to avoid deadlocks while shutting down the audio thread.
     if (oldAudioHost)
     {
-        oldAudioHost->Close();
+        oldAudioHost->Close(); // cancels any latency measurement in progress.
+    }
+    RealtimeWatchdog::Stop();
+    oldLatencyMeasurementThread = nullptr; // requests stop, and joins.
+    oldBankSyncThread = nullptr;            // stops after the current transfer.
+    oldPreloader = nullptr; // waits for an in-progress preload.
+
+    if (pluginCostDatabase)
+    {
+        pluginCostDatabase->Save();
     }
 }
 
@@ -172,6 +247,7 @@ PiPedalModel::~PiPedalModel()
     hotspotManager = nullptr; // turn off the hotspot.
 
     pluginChangeMonitor = nullptr; // stop monitorin LV2 directories.
+    alsaHotplugMonitor = nullptr;
     try
     {
         adminClient.UnmonitorGovernor();
@@ -185,6 +261,7 @@ PiPedalModel::~PiPedalModel()
         CurrentPreset currentPreset;
         currentPreset.modified_ = this->hasPresetChanged;
         currentPreset.preset_ = this->pedalboard;
+        RestoreShedItemHardBypass(currentPreset.preset_);
         storage.SaveCurrentPreset(currentPreset);
     }
     catch (...)
@@ -213,11 +290,75 @@ void PiPedalModel::Init(const PiPedalConfiguration &configuration)
     pluginHost.SetConfiguration(configuration);
     storage.SetConfigRoot(configuration.GetDocRoot());
     storage.SetDataRoot(configuration.GetLocalStoragePath());
+    storage.SetBinaryBankFiles(configuration.GetBinaryBankFiles());
     storage.Initialize();
     pluginHost.SetPluginStoragePath(storage.GetPluginUploadDirectory());
+    if (configuration.GetPresetWriteDelaySeconds() != 0)
+    {
+        storage.SetWriteBehind(
+            [this]()
+            {
+                ScheduleStorageFlush();
+            });
+    }
 
     this->systemMidiBindings = storage.GetSystemMidiBindings();
 
+    // shrink caches when the system is running short of memory.
+    CacheRegistry::GetInstance().StartMonitoring();
+
+    // ALSA device enumeration is cached until a sound card is added or removed.
+    alsaHotplugMonitor = std::make_unique<AlsaHotplugMonitor>(
+        [this]()
+        {
+            alsaDevices.Invalidate();
+        });
+
+    // scan audio file metadata and generate thumbnails in the background.
+    this->audioFileJobQueue = AudioFileJobQueue::Create(std::max<uint32_t>(1, configuration.GetAudioFileJobThreads()));
+    AudioDirectoryInfo::SetJobQueue(
+        this->audioFileJobQueue,
+        [this](const std::filesystem::path &directory)
+        {
+            FireAudioFilesChanged(directory);
+        });
+    if (configuration.GetThumbnailCacheSize() != 0)
+    {
+        try
+        {
+            AudioDirectoryInfo::SetThumbnailCache(
+                ThumbnailCache::Create(
+                    std::filesystem::path(configuration.GetLocalStoragePath()) / "thumbnail_cache",
+                    configuration.GetThumbnailCacheSize()));
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Can't open the thumbnail cache. " << e.what()));
+        }
+    }
+    if (configuration.GetDecodedAudioCacheSize() != 0)
+    {
+        try
+        {
+            AudioDirectoryInfo::SetDecodedAudioCache(
+                std::make_shared<ThumbnailCache>(
+                    std::filesystem::path(configuration.GetLocalStoragePath()) / "decoded_audio_cache",
+                    configuration.GetDecodedAudioCacheSize(),
+                    60, // plugins open files a while after asking for them. (Open files survive eviction.)
+                    ".flac"));
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Can't open the decoded audio cache. " << e.what()));
+        }
+    }
+
+    pluginCostDatabase = std::make_shared<PluginCostDatabase>(
+        std::filesystem::path(configuration.GetLocalStoragePath()) / "plugincost.json");
+    pluginCostDatabase->Load();
+    pluginHost.SetPluginCostDatabase(pluginCostDatabase);
+    lastPluginCostSave = std::chrono::steady_clock::now();
+
 #if JACK_HOST
     this->jackConfiguration = this->jackConfiguration.JackInitialize();
 #else
@@ -244,6 +385,13 @@ void PiPedalModel::LoadLv2PluginInfo()
 
     pluginChangeMonitor = std::make_unique<Lv2PluginChangeMonitor>(*this);
     pluginHost.LoadLilv(configuration.GetLv2Path().c_str());
+    pluginHost.SetSearchFavorites(storage.GetFavorites());
+
+    if (configuration.GetPreloadPresets() != 0)
+    {
+        pedalboardPreloader = std::make_unique<PedalboardPreloader>(
+            pluginHost, configuration.GetPreloadPresets(), configuration.GetPreloadMemoryLimit());
+    }
 
     // Copy all presets out of Lilv data to json files
     // so that we can close lilv while we're actually
@@ -286,6 +434,10 @@ void PiPedalModel::Load()
     this->webPort = (uint16_t)configuration.GetSocketServerPort();
 
     adminClient.MonitorGovernor(storage.GetGovernorSettings());
+    if (CpuAffinityPlan::Enabled() && configuration.GetAudioIrqAffinity())
+    {
+        adminClient.SetAudioIrqAffinity(FormatCpuList(CpuAffinityPlan::RealtimeCpus()));
+    }
 
     // pluginHost.Load(configuration.GetLv2Path().c_str());
 
@@ -320,8 +472,36 @@ void PiPedalModel::Load()
 
     UpdateDefaults(&this->pedalboard);
 
+    // keep plugins that the watchdog caught hanging bypassed until the user re-enables them.
+    for (PedalboardItem *item : this->pedalboard.GetAllPlugins())
+    {
+        if (CrashGuard::IsHungPlugin(item->uri()))
+        {
+            Lv2Log::warning(SS("Bypassing '" << item->pluginName() << "', which previously hung the audio thread."));
+            shedItemHardBypass[item->instanceId()] = item->hardBypass();
+            item->isEnabled(false);
+            item->hardBypass(true);
+        }
+    }
+
+    if (configuration.GetRealtimeHugePages() == "transparent")
+    {
+        RealtimeArena::SetHugePages(RealtimeArena::HugePages::Transparent);
+    }
+    else if (configuration.GetRealtimeHugePages() == "explicit")
+    {
+        RealtimeArena::SetHugePages(RealtimeArena::HugePages::Explicit);
+    }
+    else if (configuration.GetRealtimeHugePages() != "none")
+    {
+        Lv2Log::warning(SS("Invalid realtimeHugePages setting: " << configuration.GetRealtimeHugePages()));
+    }
+
+    AudioPeriodTrace::SetDumpDirectory(storage.GetDataRoot() / "xruns");
+
     std::unique_ptr<AudioHost> p{AudioHost::CreateInstance(pluginHost.asIHost())};
     this->audioHost = std::move(p);
+    UpdateCpuFrequencyPolicy(storage.GetGovernorSettings());
 
     this->audioHost->SetNotificationCallbacks(this);
 
@@ -330,6 +510,42 @@ void PiPedalModel::Load()
     this->audioHost->SetSystemMidiBindings(this->systemMidiBindings);
 
     audioHost->SetAlsaSequencerConfiguration(storage.GetAlsaSequencerConfiguration());
+    audioHost->SetPedalboardCrossfade(configuration.GetPedalboardCrossfadeMs());
+    audioHost->SetSubBlockFrames(configuration.GetSubBlockFrames());
+    audioHost->SetControlRamp(configuration.GetControlRampMs());
+    audioHost->SetOverloadProtection(configuration.GetOverloadProtection());
+    if (configuration.GetIdleTimeoutMinutes() != 0)
+    {
+        audioHost->SetIdleSignalThreshold(db2a(configuration.GetIdleSignalThresholdDb()));
+        ScheduleIdleCheck();
+    }
+    pmuProfiling = configuration.GetPmuProfiling();
+    audioHost->SetPmuProfiling(pmuProfiling);
+    Denormals::SetFlushToZero(configuration.GetFlushDenormalsToZero());
+    denormalDetection = configuration.GetDenormalDetection();
+    audioHost->SetDenormalDetection(denormalDetection);
+    if (configuration.GetWatchdogTimeoutMs() != 0)
+    {
+        RealtimeWatchdog::Start(
+            configuration.GetWatchdogTimeoutMs() * 0.001,
+            [this](const RealtimeWatchdog::HungEffect &hungEffect)
+            {
+                // on the watchdog thread.
+                try
+                {
+                    this->Post([this, hungEffect]()
+                               { this->OnEffectHung(hungEffect); });
+                }
+                catch (const std::exception &e)
+                {
+                    Lv2Log::error(SS("Watchdog: " << e.what()));
+                }
+            });
+    }
+    if (configuration.GetTraceEvents())
+    {
+        Tracer::Start();
+    }
 
     if (configuration.GetMLock())
     {
@@ -346,13 +562,21 @@ void PiPedalModel::Load()
     RestartAudio();
 }
 
+PiPedalModel::SubscriberList PiPedalModel::GetSubscribers() const
+{
+    std::lock_guard lock(subscribersMutex);
+    return this->subscribers;
+}
+
 IPiPedalModelSubscriber *PiPedalModel::GetNotificationSubscriber(int64_t clientId)
 {
-    for (size_t i = 0; i < subscribers.size(); ++i)
+    // Subscribers are removed with the model mutex held, so the result is valid while the caller holds it.
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
-        if (subscribers[i]->GetClientId() == clientId)
+        if (subscriber->GetClientId() == clientId)
         {
-            return subscribers[i].get();
+            return subscriber.get();
         }
     }
     return nullptr;
@@ -360,21 +584,31 @@ IPiPedalModelSubscriber *PiPedalModel::GetNotificationSubscriber(int64_t clientI
 
 void PiPedalModel::AddNotificationSubscription(std::shared_ptr<IPiPedalModelSubscriber> pSubscriber)
 {
+    {
+        std::lock_guard lock(subscribersMutex);
+        auto newSubscribers = std::make_shared<std::vector<IPiPedalModelSubscriber::ptr>>(*this->subscribers);
+        newSubscribers->push_back(pSubscriber);
+        this->subscribers = std::move(newSubscribers);
+    }
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    this->subscribers.push_back(pSubscriber);
+    ExitIdleMode();
 }
 void PiPedalModel::RemoveNotificationSubsription(std::shared_ptr<IPiPedalModelSubscriber> pSubscriber)
 {
     {
         std::lock_guard<std::recursive_mutex> lock(mutex);
 
-        for (auto it = this->subscribers.begin(); it != this->subscribers.end(); ++it)
         {
-            if ((*it).get() == pSubscriber.get())
+            std::lock_guard subscribersLock(subscribersMutex);
+            auto newSubscribers = std::make_shared<std::vector<IPiPedalModelSubscriber::ptr>>();
+            for (auto &subscriber : *this->subscribers)
             {
-                this->subscribers.erase(it);
-                break;
+                if (subscriber.get() != pSubscriber.get())
+                {
+                    newSubscribers->push_back(subscriber);
+                }
             }
+            this->subscribers = std::move(newSubscribers);
         }
         int64_t clientId = pSubscriber->GetClientId();
 
@@ -394,6 +628,23 @@ void PiPedalModel::RemoveNotificationSubsription(std::shared_ptr<IPiPedalModelSu
 
 void PiPedalModel::PreviewControl(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value)
 {
+    PreviewControl(clientId, pedalItemId, symbol, value, nullptr, nullptr);
+}
+
+void PiPedalModel::PreviewControl(
+    int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value,
+    const ControlHandleTable *handleTable, const ControlHandleTable::Entry *handle)
+{
+    if (handle != nullptr && handle->controlIndex != -1)
+    {
+        Lv2Pedalboard *handlePedalboard = handleTable->GetLv2Pedalboard().get();
+        if (!handlePedalboard->GetEffects()[handle->effectIndex]->IsVst3() &&
+            audioHost->SetControlValue(handlePedalboard, handle->effectIndex, handle->controlIndex, value))
+        {
+            return;
+        }
+        // else the audio pedalboard was replaced since the handles were issued. Do it the slow way.
+    }
     IEffect *effect = lv2Pedalboard->GetEffect(pedalItemId);
     if (!effect)
     {
@@ -417,8 +668,8 @@ void PiPedalModel::PreviewControl(int64_t clientId, int64_t pedalItemId, const s
 void PiPedalModel::OnNotifyLv2StateChanged(uint64_t instanceId)
 {
     // a sent PATCH_Set, or an explicit state changed notification.
-    OnNotifyMaybeLv2StateChanged(instanceId);
-    this->SetPresetChanged(-1, true, false);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    ScheduleLv2StateCapture(instanceId, true);
 }
 
 // The plugin notified us that a  path path property changed. The state *purrobably changed.
@@ -426,23 +677,128 @@ void PiPedalModel::OnNotifyMaybeLv2StateChanged(uint64_t instanceId)
 {
     // one or more received PATCH_Sets, which MAY change the state.
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    PedalboardItem *item = pedalboard.GetItem(instanceId);
-    if (item != nullptr)
+    ScheduleLv2StateCapture(instanceId, false);
+}
+
+static constexpr auto LV2_STATE_CAPTURE_DELAY = std::chrono::milliseconds(250);
+static constexpr auto LV2_STATE_CAPTURE_MAX_DELAY = std::chrono::milliseconds(1000); // while notifications keep coming.
+
+void PiPedalModel::ScheduleLv2StateCapture(uint64_t instanceId, bool explicitChange)
+{
+    // called with the lock held.
+    if (closed || !audioHost || pedalboard.GetItem(instanceId) == nullptr)
+    {
+        return;
+    }
+    auto now = clock::now();
+    auto ff = pendingLv2StateCaptures.find(instanceId);
+    if (ff != pendingLv2StateCaptures.end())
     {
-        if (!audioHost)
+        ff->second.explicitChange = ff->second.explicitChange || explicitChange;
+        if (now - ff->second.firstRequestTime >= LV2_STATE_CAPTURE_MAX_DELAY)
         {
-            return;
+            return; // let the pending capture run.
         }
-        bool changed = this->audioHost->UpdatePluginState(*item);
-        if (changed)
+        CancelPost(ff->second.postHandle);
+    }
+    else
+    {
+        ff = pendingLv2StateCaptures.insert({instanceId, PendingLv2StateCapture{0, now, explicitChange}}).first;
+    }
+    try
+    {
+        ff->second.postHandle = PostDelayed(
+            LV2_STATE_CAPTURE_DELAY,
+            [this, instanceId]()
+            {
+                // the capture may take a while. Keep it off the dispatcher thread.
+                if (!ThreadPool::Shared().Execute(
+                        [this, instanceId]()
+                        { CaptureLv2State(instanceId); }))
+                {
+                    CaptureLv2State(instanceId);
+                }
+            });
+    }
+    catch (const std::exception &)
+    {
+        // no dispatcher (yet).
+        pendingLv2StateCaptures.erase(ff);
+        PedalboardItem *item = pedalboard.GetItem(instanceId);
+        if (this->audioHost->UpdatePluginState(*item))
         {
-
             item->stateUpdateCount(item->stateUpdateCount() + 1);
+            FireLv2StateChanged(instanceId, item->lv2State());
+            if (explicitChange)
+            {
+                this->SetPresetChanged(-1, true, false);
+            }
+        }
+    }
+}
 
-            Lv2PluginState newState = item->lv2State();
-
-            FireLv2StateChanged(instanceId, newState);
+void PiPedalModel::CaptureLv2State(uint64_t instanceId)
+{
+    // Hold a reference to the pedalboard, so that the effect stays alive while its state is saved
+    // without the model lock.
+    std::shared_ptr<Lv2Pedalboard> capturePedalboard;
+    bool explicitChange;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        auto ff = pendingLv2StateCaptures.find(instanceId);
+        if (ff == pendingLv2StateCaptures.end())
+        {
+            return; // cancelled.
         }
+        explicitChange = ff->second.explicitChange;
+        pendingLv2StateCaptures.erase(ff);
+        if (closed || !lv2Pedalboard)
+        {
+            return;
+        }
+        capturePedalboard = lv2Pedalboard;
+    }
+    IEffect *effect = capturePedalboard->GetEffect(instanceId);
+    if (!effect)
+    {
+        return;
+    }
+    Lv2PluginState state;
+    uint64_t stateVersion = 0;
+    try
+    {
+        // unchanged (by hash) states are not copied or propagated.
+        if (!effect->CaptureLv2StateIfChanged(&state, &stateVersion))
+        {
+            return;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Failed to capture plugin state. " << e.what()));
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (closed || !lv2Pedalboard || lv2Pedalboard->GetEffect(instanceId) != effect)
+    {
+        return; // no longer the current instance.
+    }
+    if (effect->GetLv2StateVersion() != stateVersion)
+    {
+        return; // a more recent state has already been captured (e.g. by SyncLv2State).
+    }
+    PedalboardItem *item = pedalboard.GetItem(instanceId);
+    if (item == nullptr || state == item->lv2State())
+    {
+        return;
+    }
+    item->lv2State(state);
+    item->stateUpdateCount(item->stateUpdateCount() + 1);
+    FireLv2StateChanged(instanceId, item->lv2State());
+    if (explicitChange)
+    {
+        this->SetPresetChanged(-1, true, false);
     }
 }
 
@@ -454,8 +810,8 @@ void PiPedalModel::SetInputVolume(float value)
 
         this->pedalboard.input_volume_db(value);
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnInputVolumeChanged(value);
         }
@@ -470,8 +826,8 @@ void PiPedalModel::SetOutputVolume(float value)
         std::lock_guard<std::recursive_mutex> lock(mutex);
         this->pedalboard.output_volume_db(value);
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnOutputVolumeChanged(value);
         }
@@ -490,9 +846,110 @@ void PiPedalModel::PreviewOutputVolume(float value)
 
 void PiPedalModel::SetControl(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value)
 {
+    std::unique_lock<std::recursive_mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock())
     {
-        std::lock_guard<std::recursive_mutex> lock(mutex);
+        // The model is busy (loading a preset, importing a bundle...). Don't hold up the
+        // caller; the change is applied as soon as the model is free.
+        bool post;
+        {
+            std::lock_guard pendingLock(pendingControlChangesMutex);
+            post = pendingControlChanges.empty();
+            bool merged = false;
+            for (auto &change : pendingControlChanges)
+            {
+                if (change.pedalItemId == pedalItemId && change.symbol == symbol)
+                {
+                    change.clientId = clientId;
+                    change.value = value;
+                    merged = true;
+                    break;
+                }
+            }
+            if (!merged)
+            {
+                pendingControlChanges.push_back(PendingControlChange{clientId, pedalItemId, symbol, value});
+            }
+        }
+        if (post)
+        {
+            Post(
+                [this]
+                {
+                    std::lock_guard<std::recursive_mutex> lock(this->mutex);
+                    ApplyPendingControlChanges();
+                });
+        }
+        return;
+    }
+    // earlier changes that were queued while the model was busy go first.
+    ApplyPendingControlChanges();
+    ApplyControlChange(clientId, pedalItemId, symbol, value);
+}
+
+std::shared_ptr<const ControlHandleTable> PiPedalModel::GetControlHandleTable() const
+{
+    std::lock_guard lock(controlHandlesMutex);
+    return controlHandleTable;
+}
+
+ControlHandles PiPedalModel::GetControlHandles()
+{
+    auto table = GetControlHandleTable();
+    if (!table)
+    {
+        return ControlHandles();
+    }
+    return table->GetHandles();
+}
+
+void PiPedalModel::SetControlByHandle(int64_t clientId, int64_t version, int32_t handle, float value)
+{
+    auto table = GetControlHandleTable();
+    const ControlHandleTable::Entry *entry = table ? table->Find(version, handle) : nullptr;
+    if (entry == nullptr)
+    {
+        return; // stale handle.
+    }
+    std::unique_lock<std::recursive_mutex> lock(mutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        SetControl(clientId, entry->instanceId, entry->symbol, value); // queues the change.
+        return;
+    }
+    ApplyPendingControlChanges();
+    ApplyControlChange(clientId, entry->instanceId, entry->symbol, value, table.get(), entry);
+}
+
+void PiPedalModel::PreviewControlByHandle(int64_t clientId, int64_t version, int32_t handle, float value)
+{
+    auto table = GetControlHandleTable();
+    const ControlHandleTable::Entry *entry = table ? table->Find(version, handle) : nullptr;
+    if (entry == nullptr)
+    {
+        return;
+    }
+    PreviewControl(clientId, entry->instanceId, entry->symbol, value, table.get(), entry);
+}
+
+void PiPedalModel::ApplyPendingControlChanges()
+{
+    std::vector<PendingControlChange> changes;
+    {
+        std::lock_guard pendingLock(pendingControlChangesMutex);
+        std::swap(changes, pendingControlChanges);
+    }
+    for (const auto &change : changes)
+    {
+        ApplyControlChange(change.clientId, change.pedalItemId, change.symbol, change.value);
+    }
+}
 
+void PiPedalModel::ApplyControlChange(
+    int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value,
+    const ControlHandleTable *handleTable, const ControlHandleTable::Entry *handle)
+{
+    {
         if (!this->pedalboard.SetControlValue(pedalItemId, symbol, value))
         {
             return;
@@ -507,13 +964,13 @@ void PiPedalModel::SetControl(int64_t clientId, int64_t pedalItemId, const std::
             this->FirePedalboardChanged(clientId);
             return;
         }
-        PreviewControl(clientId, pedalItemId, symbol, value);
+        PreviewControl(clientId, pedalItemId, symbol, value, handleTable, handle);
 
         {
 
             // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-            std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-            for (auto &subscriber : t)
+            SubscriberList t = GetSubscribers();
+            for (auto &subscriber : *t)
             {
                 subscriber->OnControlChanged(clientId, pedalItemId, symbol, value);
             }
@@ -527,8 +984,8 @@ void PiPedalModel::FireJackConfigurationChanged(const JackConfiguration &jackCon
 {
     // noify subscribers.
 
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnJackConfigurationChanged(jackConfiguration);
     }
@@ -536,11 +993,30 @@ void PiPedalModel::FireJackConfigurationChanged(const JackConfiguration &jackCon
 
 void PiPedalModel::FireBanksChanged(int64_t clientId)
 {
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    const BankIndex &banks = this->storage.GetBanks();
+
+    IndexPatch patch;
+    bool patched = hasBroadcastBanks && IndexPatch::Make(broadcastBanks, banks, &patch);
+    patch.clientId_ = clientId;
+    patch.baseVersion_ = bankIndexVersion;
+    patch.version_ = ++bankIndexVersion;
+    broadcastBanks = banks;
+    hasBroadcastBanks = true;
+
     // noify subscribers.
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    SharedNotification notification; // serialized once, for all subscribers.
+    for (auto &subscriber : *t)
     {
-        subscriber->OnBankIndexChanged(this->storage.GetBanks());
+        if (patched)
+        {
+            subscriber->OnBankIndexPatched(patch, notification);
+        }
+        else
+        {
+            subscriber->OnBankIndexChanged(banks, bankIndexVersion, notification);
+        }
     }
 }
 
@@ -553,15 +1029,47 @@ void PiPedalModel::FirePedalboardChanged(int64_t clientId, bool loadAudioThread)
         {
             LoadCurrentPedalboard();
 
+            TraceScope traceScope("preset", "UpdateSubscriptions");
             UpdateRealtimeVuSubscriptions();
             UpdateRealtimeMonitorPortSubscriptions();
+
+            UpdateRealtimeEffectTimingSubscriptions();
+            UpdatePresetPreloads();
         }
     }
     // noify subscribers.
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    TraceScope traceScope("preset", "NotifySubscribers");
+    PedalboardPatch patch;
+    bool patched = hasBroadcastPedalboard && PedalboardPatch::Make(broadcastPedalboard, this->pedalboard, &patch);
+    patch.clientId_ = clientId;
+    patch.baseVersion_ = pedalboardVersion;
+    patch.version_ = ++pedalboardVersion;
+    broadcastPedalboard = this->pedalboard.DeepCopy(); // snapshots are modified in place.
+    hasBroadcastPedalboard = true;
+    {
+        if (controlHandleAllocator.Size() >= ControlHandleAllocator::MAX_HANDLES)
+        {
+            controlHandleAllocator.Clear();
+            controlHandleEpochVersion = pedalboardVersion;
+        }
+        auto table = std::make_shared<const ControlHandleTable>(
+            pedalboardVersion, controlHandleEpochVersion, this->pedalboard, this->lv2Pedalboard, controlHandleAllocator);
+        std::lock_guard lock(controlHandlesMutex);
+        controlHandleTable = std::move(table);
+    }
+
+    SubscriberList t = GetSubscribers();
+    SharedNotification notification; // serialized once, for all subscribers.
+    for (auto &subscriber : *t)
     {
-        subscriber->OnPedalboardChanged(clientId, this->pedalboard);
+        if (patched)
+        {
+            subscriber->OnPedalboardPatched(patch, notification);
+        }
+        else
+        {
+            subscriber->OnPedalboardChanged(clientId, this->pedalboard, pedalboardVersion, notification);
+        }
     }
 }
 void PiPedalModel::SetPedalboard(int64_t clientId, Pedalboard &pedalboard)
@@ -637,6 +1145,7 @@ void PiPedalModel::UpdateCurrentPedalboard(int64_t clientId, Pedalboard &pedalbo
         // apply the error messages to the lv2Pedalboard.
         // return true if the error messages have changed
         audioHost->SetPedalboard(lv2Pedalboard);
+        RecordPluginMemory(*lv2Pedalboard);
         this->pedalboard = pedalboard;
         previousPedalboard = this->pedalboard;
         previousPedalboardLoaded = true;
@@ -645,6 +1154,8 @@ void PiPedalModel::UpdateCurrentPedalboard(int64_t clientId, Pedalboard &pedalbo
         UpdateRealtimeVuSubscriptions();
         UpdateRealtimeMonitorPortSubscriptions();
 
+        UpdateRealtimeEffectTimingSubscriptions();
+
         this->FirePedalboardChanged(clientId, false);
         this->SetPresetChanged(clientId, true);
     }
@@ -657,8 +1168,8 @@ void PiPedalModel::SetPedalboardItemUseModUi(int64_t clientId, int64_t instanceI
         this->pedalboard.SetItemUseModUi(instanceId, enabled);
 
         // Notify clients.
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnItemUseModUiChanged(clientId, instanceId, enabled);
         }
@@ -666,15 +1177,66 @@ void PiPedalModel::SetPedalboardItemUseModUi(int64_t clientId, int64_t instanceI
     }
 }
 
+void PiPedalModel::SetPedalboardItemHardBypass(int64_t clientId, int64_t instanceId, bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    this->shedItemHardBypass.erase(instanceId); // the user's setting replaces the one that was saved.
+    if (this->pedalboard.SetItemHardBypass(instanceId, enabled))
+    {
+        // a structural change, so the audio thread gets a new pedalboard (which borrows the existing effects).
+        this->FirePedalboardChanged(clientId, true);
+        this->SetPresetChanged(clientId, true);
+    }
+}
+
+void PiPedalModel::SetPedalboardItemEssential(int64_t clientId, int64_t instanceId, bool essential)
+{
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    if (this->pedalboard.SetItemEssential(instanceId, essential))
+    {
+        // the audio thread doesn't need to know.
+        this->FirePedalboardChanged(clientId, false);
+        this->SetPresetChanged(clientId, true);
+    }
+}
+
+void PiPedalModel::SetPedalboardItemAlwaysRun(int64_t clientId, int64_t instanceId, bool alwaysRun)
+{
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    if (this->pedalboard.SetItemAlwaysRun(instanceId, alwaysRun))
+    {
+        // the audio thread gets a new pedalboard, with or without a silence gate for the effect.
+        this->FirePedalboardChanged(clientId, true);
+        this->SetPresetChanged(clientId, true);
+    }
+}
+
 void PiPedalModel::SetPedalboardItemEnable(int64_t clientId, int64_t pedalItemId, bool enabled)
 {
     std::lock_guard<std::recursive_mutex> guard{mutex};
     {
         this->pedalboard.SetItemEnabled(pedalItemId, enabled);
+        bool hardBypassRestored = false;
+        if (enabled)
+        {
+            // the user is giving a plugin the watchdog bypassed another chance.
+            RealtimeWatchdog::ClearSkipped(pedalItemId);
+            const PedalboardItem *item = this->pedalboard.GetItem(pedalItemId);
+            if (item)
+            {
+                CrashGuard::ClearHungPlugin(item->uri());
+            }
+            auto shed = this->shedItemHardBypass.find(pedalItemId);
+            if (shed != this->shedItemHardBypass.end())
+            {
+                hardBypassRestored = this->pedalboard.SetItemHardBypass(pedalItemId, shed->second);
+                this->shedItemHardBypass.erase(shed);
+            }
+        }
 
         // Notify clients.
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnItemEnabledChanged(clientId, pedalItemId, enabled);
         }
@@ -682,6 +1244,10 @@ void PiPedalModel::SetPedalboardItemEnable(int64_t clientId, int64_t pedalItemId
 
         // Notify audo thread.
         this->audioHost->SetBypass(pedalItemId, enabled);
+        if (hardBypassRestored)
+        {
+            this->FirePedalboardChanged(clientId, true);
+        }
     }
 }
 
@@ -693,7 +1259,23 @@ void PiPedalModel::GetPresets(PresetIndex *pResult)
     pResult->presetChanged(this->hasPresetChanged);
 }
 
-Pedalboard PiPedalModel::GetPreset(int64_t instanceId)
+void PiPedalModel::GetPresets(PresetIndex *pResult, int64_t *version)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    GetPresets(pResult);
+    IndexPatch patch;
+    if (!hasBroadcastPresets || !IndexPatch::Make(broadcastPresets, *pResult, &patch) || patch.HasEntryChanges())
+    {
+        // changed without a notification. Clients with older copies resync when the next patch arrives.
+        broadcastPresets = *pResult;
+        hasBroadcastPresets = true;
+        ++presetIndexVersion;
+    }
+    *version = presetIndexVersion;
+}
+
+Pedalboard PiPedalModel::GetPreset(int64_t instanceId)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     return this->storage.GetPreset(instanceId);
@@ -732,8 +1314,8 @@ void PiPedalModel::FireSnapshotModified(int64_t snapshotIndex, bool modified)
     std::lock_guard<std::recursive_mutex> guard{mutex};
     {
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnSnapshotModified(snapshotIndex, modified);
         }
@@ -745,8 +1327,8 @@ void PiPedalModel::FireSelectedSnapshotChanged(int64_t selectedSnapshot)
     std::lock_guard<std::recursive_mutex> guard{mutex};
     {
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnSelectedSnapshotChanged(selectedSnapshot);
         }
@@ -762,8 +1344,8 @@ void PiPedalModel::FirePresetChanged(bool changed)
         PresetIndex presets;
         GetPresets(&presets);
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnPresetChanged(changed);
         }
@@ -778,11 +1360,28 @@ void PiPedalModel::FirePresetsChanged(int64_t clientId)
         PresetIndex presets;
         GetPresets(&presets);
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        IndexPatch patch;
+        bool patched = hasBroadcastPresets && IndexPatch::Make(broadcastPresets, presets, &patch);
+        patch.clientId_ = clientId;
+        patch.baseVersion_ = presetIndexVersion;
+        patch.version_ = ++presetIndexVersion;
+        broadcastPresets = presets;
+        hasBroadcastPresets = true;
+
+        SubscriberList t = GetSubscribers();
+        SharedNotification notification;
+        for (auto &subscriber : *t)
         {
-            subscriber->OnPresetsChanged(clientId, presets);
+            if (patched)
+            {
+                subscriber->OnPresetsPatched(patch, notification);
+            }
+            else
+            {
+                subscriber->OnPresetsChanged(clientId, presets, presetIndexVersion, notification);
+            }
         }
+        UpdatePresetPreloads();
     }
 }
 void PiPedalModel::FirePluginPresetsChanged(const std::string &pluginUri)
@@ -790,14 +1389,39 @@ void PiPedalModel::FirePluginPresetsChanged(const std::string &pluginUri)
     std::lock_guard<std::recursive_mutex> guard{mutex};
     {
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnPluginPresetsChanged(pluginUri);
         }
     }
 }
 
+void PiPedalModel::FireAudioFilesChanged(const std::filesystem::path &directory)
+{
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    {
+        // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
+        {
+            subscriber->OnAudioFilesChanged(directory.string());
+        }
+    }
+}
+
+void PiPedalModel::FirePresetBundleProgress(const PresetBundleProgress &progress)
+{
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    {
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
+        {
+            subscriber->OnPresetBundleProgress(progress);
+        }
+    }
+}
+
 void PiPedalModel::UpdateVst3Settings(Pedalboard &pedalboard)
 {
     // get the vst3 state bundle from lv2Pedalboard for the current pedalboard.
@@ -825,9 +1449,9 @@ void PiPedalModel::UpdateVst3Settings(Pedalboard &pedalboard)
 void PiPedalModel::FireLv2StateChanged(int64_t instanceId, const Lv2PluginState &lv2State)
 {
     std::lock_guard<std::recursive_mutex> guard{mutex};
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
+    SubscriberList t = GetSubscribers();
 
-    for (auto &subscriber : t)
+    for (auto &subscriber : *t)
     {
         subscriber->OnLv2StateChanged(instanceId, lv2State);
     }
@@ -859,7 +1483,9 @@ void PiPedalModel::SaveCurrentPreset(int64_t clientId)
     SyncLv2State();
     PrepareSnapshostsForSave(pedalboard);
 
-    storage.SaveCurrentPreset(this->pedalboard);
+    Pedalboard savedPedalboard = this->pedalboard;
+    RestoreShedItemHardBypass(savedPedalboard);
+    storage.SaveCurrentPreset(savedPedalboard);
     this->SetPresetChanged(clientId, false);
 }
 
@@ -896,6 +1522,7 @@ int64_t PiPedalModel::SaveCurrentPresetAs(int64_t clientId, int64_t bankInstance
     PrepareSnapshostsForSave(pedalboard);
 
     UpdateVst3Settings(pedalboard);
+    RestoreShedItemHardBypass(pedalboard);
     pedalboard.name(name);
     int64_t result = storage.SaveCurrentPresetAs(pedalboard, bankInstanceId, name, saveAfterInstanceId);
     FirePresetsChanged(clientId);
@@ -932,6 +1559,7 @@ int64_t PiPedalModel::UploadBank(BankFile &bankFile, int64_t uploadAfter)
 void PiPedalModel::NextBank(Direction direction)
 {
     std::lock_guard<std::recursive_mutex> guard{mutex};
+    lastBankNavigationBackward = direction == Direction::Decrease;
 
     auto bankIndex = this->GetBankIndex();
     if (bankIndex.entries().size() == 0)
@@ -971,6 +1599,9 @@ void PiPedalModel::NextBank(Direction direction)
 }
 void PiPedalModel::NextPreset(Direction direction)
 {
+    std::lock_guard<std::recursive_mutex> guard{mutex};
+    lastPresetNavigationBackward = direction == Direction::Decrease;
+
     PresetIndex index;
 
     storage.GetPresetIndex(&index);
@@ -1115,16 +1746,39 @@ void PiPedalModel::OnNotifyMidiProgramChange(RealtimeMidiProgramRequest &midiPro
 
 void PiPedalModel::LoadPreset(int64_t clientId, int64_t instanceId)
 {
+    TraceScope traceScope("preset", "LoadPreset", instanceId);
     std::lock_guard<std::recursive_mutex> guard{mutex};
 
-    if (storage.LoadPreset(instanceId))
+    bool loaded;
     {
-        this->pedalboard = storage.GetCurrentPreset();
-        UpdateDefaults(&this->pedalboard);
+        TraceScope phaseScope("preset", "storage.LoadPreset");
+        loaded = storage.LoadPreset(instanceId);
+    }
+    if (loaded)
+    {
+        {
+            TraceScope phaseScope("preset", "UpdateDefaults");
+            this->shedItemHardBypass.clear();
+            this->pedalboard = storage.GetCurrentPreset();
+            UpdateDefaults(&this->pedalboard);
+        }
 
         this->hasPresetChanged = false; // no fire.
         this->FirePedalboardChanged(clientId);
         this->FirePresetsChanged(clientId); // fire now.
+
+        PresetLoadEstimate estimate = EstimatePedalboardLoad(this->pedalboard);
+        if (estimate.p99Load_ > 1.0f)
+        {
+            std::string message = SS(
+                "This preset may overload the audio thread (estimated load " << (int)std::round(estimate.p99Load_ * 100) << "%).");
+            Lv2Log::warning(message);
+            SubscriberList t = GetSubscribers();
+            for (auto &subscriber : *t)
+            {
+                subscriber->OnErrorMessage(message);
+            }
+        }
     }
 }
 
@@ -1207,6 +1861,354 @@ bool PiPedalModel::RenamePreset(int64_t clientId, int64_t instanceId, const std:
     }
 }
 
+void PiPedalModel::MeasureLatency(
+    int64_t clientId, int inputChannel, int outputChannel, float stressSeconds,
+    std::function<void(const LatencyMeasurement &)> onSuccess,
+    std::function<void(const std::string &)> onError)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (closed || !audioHost)
+    {
+        throw PiPedalStateException("Audio is not running.");
+    }
+    if (latencyMeasurementRunning)
+    {
+        throw PiPedalStateException("A latency measurement is already running.");
+    }
+    latencyMeasurementThread = nullptr; // join the previous (finished) measurement.
+
+    LatencyMeasurement measurement;
+    measurement.inputDevice_ = jackServerSettings.GetAlsaInputDevice();
+    measurement.outputDevice_ = jackServerSettings.GetAlsaOutputDevice();
+    measurement.sampleRate_ = jackServerSettings.GetSampleRate();
+    measurement.bufferSize_ = jackServerSettings.GetBufferSize();
+    measurement.numberOfBuffers_ = jackServerSettings.GetNumberOfBuffers();
+    measurement.inputChannel_ = inputChannel;
+    measurement.outputChannel_ = outputChannel;
+    measurement.stressSeconds_ = std::clamp(stressSeconds, 0.0f, 120.0f);
+
+    latencyMeasurementRunning = true;
+    latencyMeasurementThread = std::make_unique<std::jthread>(
+        [this, clientId, measurement, onSuccess, onError](std::stop_token stopToken)
+        {
+            LatencyMeasurementThreadProc(stopToken, clientId, measurement, onSuccess, onError);
+        });
+}
+
+void PiPedalModel::LatencyMeasurementThreadProc(
+    std::stop_token stopToken,
+    int64_t clientId,
+    LatencyMeasurement measurement,
+    std::function<void(const LatencyMeasurement &)> onSuccess,
+    std::function<void(const std::string &)> onError)
+{
+    SetThreadName("latency");
+    std::string error;
+    try
+    {
+        AudioHost *host;
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            if (closed || !audioHost)
+            {
+                throw PiPedalStateException("Audio is not running.");
+            }
+            // Close() joins this thread before deleting the audio host.
+            host = this->audioHost.get();
+        }
+        uint64_t underruns = host->getJackStatus().underruns_;
+
+        LatencyProbe::Result result = host->MeasureRoundTripLatency(measurement.inputChannel_, measurement.outputChannel_);
+        measurement.signalDetected_ = result.signalDetected;
+        measurement.latencyFrames_ = result.latencyFrames;
+        measurement.latencyMs_ = measurement.sampleRate_ == 0 ? 0 : 1000.0f * result.latencyFrames / measurement.sampleRate_;
+        measurement.peakRatio_ = result.peakRatio;
+        measurement.signalLevelDb_ = result.signalLevelDb;
+
+        auto stressEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds((int64_t)(measurement.stressSeconds_ * 1000));
+        while (std::chrono::steady_clock::now() < stressEnd)
+        {
+            if (stopToken.stop_requested())
+            {
+                throw PiPedalStateException("Latency measurement cancelled.");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        JackHostStatus status = host->getJackStatus();
+        measurement.xruns_ = status.underruns_ >= underruns ? status.underruns_ - underruns : status.underruns_;
+        measurement.cpuUsage_ = status.cpuUsage_;
+        measurement.stable_ = measurement.signalDetected_ && measurement.xruns_ == 0;
+
+        std::time_t now = std::time(nullptr);
+        std::stringstream ss;
+        ss << std::put_time(std::gmtime(&now), "%Y-%m-%dT%H:%M:%S") << "Z";
+        measurement.time_ = ss.str();
+    }
+    catch (const std::exception &e)
+    {
+        error = e.what();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    latencyMeasurementRunning = false;
+    if (closed)
+    {
+        return;
+    }
+    if (error.empty())
+    {
+        try
+        {
+            storage.AddLatencyMeasurement(measurement);
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Failed to save latency measurement. " << e.what()));
+        }
+    }
+    // only if the client is still connected.
+    if (GetNotificationSubscriber(clientId) != nullptr)
+    {
+        if (error.empty())
+        {
+            onSuccess(measurement);
+        }
+        else
+        {
+            onError(error);
+        }
+    }
+}
+
+BankSyncManifest PiPedalModel::GetBankSyncManifest()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return storage.GetBankSyncManifest();
+}
+
+Pedalboard PiPedalModel::GetBankSyncPreset(const std::string &bankName, const std::string &presetName)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return storage.GetBankSyncPreset(bankName, presetName);
+}
+
+std::filesystem::path PiPedalModel::GetBankSyncMediaFile(const std::string &hash)
+{
+    if (hash.length() != 64 || hash.find_first_not_of("0123456789abcdef") != std::string::npos)
+    {
+        return std::filesystem::path();
+    }
+    return storage.GetMediaBlobIndex().FindFile(hash);
+}
+
+void PiPedalModel::SyncBanksFrom(
+    int64_t clientId, const std::string &peer,
+    std::function<void(const BankSyncResult &)> onSuccess,
+    std::function<void(const std::string &)> onError)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (closed)
+    {
+        throw PiPedalStateException("Shutting down.");
+    }
+    if (bankSyncRunning)
+    {
+        throw PiPedalStateException("A bank sync is already running.");
+    }
+    BankSync::NormalizePeerUrl(peer); // throws if invalid.
+    bankSyncThread = nullptr; // join the previous (finished) sync.
+
+    bankSyncRunning = true;
+    bankSyncThread = std::make_unique<std::jthread>(
+        [this, clientId, peer, onSuccess, onError](std::stop_token stopToken)
+        {
+            BankSyncThreadProc(stopToken, clientId, peer, onSuccess, onError);
+        });
+}
+
+void PiPedalModel::SyncMediaFile(BankSyncClient &client, const BankSyncMedia &media, BankSyncResult *result)
+{
+    namespace fs = std::filesystem;
+    fs::path uploadDirectory = GetPluginUploadDirectory();
+    fs::path targetPath = (uploadDirectory / media.path_).lexically_normal();
+    std::string relativePath = targetPath.lexically_relative(uploadDirectory).string();
+    if (relativePath.empty() || relativePath.starts_with(".."))
+    {
+        Lv2Log::warning(SS("Bank sync: invalid media path " << media.path_));
+        return;
+    }
+    MediaBlobIndex &mediaBlobIndex = storage.GetMediaBlobIndex();
+
+    // Written beside the target, and then renamed into place, since uploaded files may be hard links
+    // to other files with the same content, and must not be modified in place.
+    TemporaryFile tempFile(targetPath.parent_path());
+    fs::remove(tempFile.Path());
+    if (mediaBlobIndex.LinkTo(media.hash_, tempFile.Path()))
+    {
+        ++result->mediaFilesLinked_;
+    }
+    else
+    {
+        client.DownloadMedia(media, tempFile.Path());
+        ++result->mediaFilesTransferred_;
+    }
+    fs::rename(tempFile.Path(), targetPath);
+    tempFile.Detach();
+    mediaBlobIndex.GetHash(targetPath);
+}
+
+void PiPedalModel::BankSyncThreadProc(
+    std::stop_token stopToken,
+    int64_t clientId,
+    std::string peer,
+    std::function<void(const BankSyncResult &)> onSuccess,
+    std::function<void(const std::string &)> onError)
+{
+    SetThreadName("bankSync");
+    namespace fs = std::filesystem;
+    BankSyncResult result;
+    std::string error;
+    bool banksChanged = false;
+    try
+    {
+        BankSyncClient client(peer);
+        BankSyncManifest remoteManifest = client.GetManifest();
+        BankSyncManifest localManifest = GetBankSyncManifest();
+
+        fs::path uploadDirectory = GetPluginUploadDirectory();
+        MediaBlobIndex &mediaBlobIndex = storage.GetMediaBlobIndex();
+        std::map<std::string, std::string> localMediaHashes;
+        for (const auto &media : remoteManifest.media_)
+        {
+            fs::path path = uploadDirectory / media.path_;
+            std::error_code ec;
+            if (fs::is_regular_file(path, ec))
+            {
+                localMediaHashes[media.path_] = mediaBlobIndex.GetHash(path);
+            }
+        }
+        BankSyncPlan plan = BankSync::Diff(localManifest, localMediaHashes, remoteManifest);
+        result.presetsUnchanged_ = (int64_t)plan.unchangedPresets;
+
+        // media first, so that synced presets never refer to missing files.
+        uint64_t bytesTotal = 0;
+        for (const auto &media : plan.media)
+        {
+            bytesTotal += media.size_;
+        }
+        uint64_t bytesProcessed = 0;
+        for (const auto &media : plan.media)
+        {
+            if (stopToken.stop_requested())
+            {
+                throw PiPedalStateException("Bank sync cancelled.");
+            }
+            FirePresetBundleProgress(PresetBundleProgress{"sync", bytesProcessed, bytesTotal});
+            SyncMediaFile(client, media, &result);
+            bytesProcessed += media.size_;
+        }
+        FirePresetBundleProgress(PresetBundleProgress{"sync", bytesTotal, bytesTotal});
+
+        for (const auto &bankName : plan.banks)
+        {
+            std::map<std::string, Pedalboard> changedPresets;
+            for (const auto &transfer : plan.presets)
+            {
+                if (transfer.bank == bankName)
+                {
+                    if (stopToken.stop_requested())
+                    {
+                        throw PiPedalStateException("Bank sync cancelled.");
+                    }
+                    changedPresets[transfer.preset] = client.GetPreset(transfer.bank, transfer.preset);
+                }
+            }
+            std::vector<std::string> presetNames;
+            for (const auto &bank : remoteManifest.banks_)
+            {
+                if (bank.name_ == bankName)
+                {
+                    for (const auto &preset : bank.presets_)
+                    {
+                        presetNames.push_back(preset.name_);
+                    }
+                }
+            }
+
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            if (closed)
+            {
+                return;
+            }
+            bool currentPresetChanged = storage.SyncBank(bankName, presetNames, changedPresets);
+            banksChanged = true;
+            ++result.banksUpdated_;
+            result.presetsTransferred_ += (int64_t)changedPresets.size();
+            if (currentPresetChanged && !this->hasPresetChanged)
+            {
+                // (unsaved edits to the current preset are kept.)
+                this->shedItemHardBypass.clear();
+                this->pedalboard = storage.GetCurrentPreset();
+                UpdateDefaults(&this->pedalboard);
+                this->FirePedalboardChanged(-1);
+            }
+        }
+        result.bytesTransferred_ = client.GetBytesTransferred();
+    }
+    catch (const std::exception &e)
+    {
+        error = e.what();
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bankSyncRunning = false;
+    if (closed)
+    {
+        return;
+    }
+    if (banksChanged)
+    {
+        FireBanksChanged(-1);
+        FirePresetsChanged(-1);
+    }
+    if (error.empty())
+    {
+        Lv2Log::info(SS(
+            "Bank sync from " << peer << ": " << result.banksUpdated_ << " banks updated, "
+                              << result.presetsTransferred_ << " presets and " << result.mediaFilesTransferred_
+                              << " media files transferred (" << result.bytesTransferred_ << " bytes)."));
+    }
+    else
+    {
+        Lv2Log::error(SS("Bank sync from " << peer << " failed. " << error));
+    }
+    // only if the client is still connected.
+    if (GetNotificationSubscriber(clientId) != nullptr)
+    {
+        if (error.empty())
+        {
+            onSuccess(result);
+        }
+        else
+        {
+            onError(error);
+        }
+    }
+}
+
+std::vector<LatencyMeasurement> PiPedalModel::GetLatencyMeasurements()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<LatencyMeasurement> result = storage.GetLatencyMeasurements();
+    int64_t recommended = LatencyMeasurement::Recommend(
+        result, jackServerSettings.GetAlsaInputDevice(), jackServerSettings.GetAlsaOutputDevice());
+    if (recommended != -1)
+    {
+        result[recommended].recommended_ = true;
+    }
+    return result;
+}
+
 GovernorSettings PiPedalModel::GetGovernorSettings()
 {
     {
@@ -1219,13 +2221,16 @@ GovernorSettings PiPedalModel::GetGovernorSettings()
 }
 void PiPedalModel::SetGovernorSettings(const std::string &governor)
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
+    // (without holding the model lock while the admin service applies the change.)
     adminClient.SetGovernorSettings(governor);
 
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     this->storage.SetGovernorSettings(governor);
+    UpdateCpuFrequencyPolicy(governor);
 
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnGovernorSettingsChanged(governor);
     }
@@ -1252,8 +2257,8 @@ void PiPedalModel::SetWifiConfigSettings(const WifiConfigSettings &wifiConfigSet
     {
         WifiConfigSettings settingsWithNoSecrets = storage.GetWifiConfigSettings(); // (the passwordless version)
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnWifiConfigSettingsChanged(settingsWithNoSecrets);
         }
@@ -1277,7 +2282,7 @@ void PiPedalModel::UpdateDnsSd()
 {
     if (!avahiService)
     {
-        throw std::runtime_error("Not ready.");
+        return; // still starting. StartHotspotMonitoring() announces the current settings.
     }
     ServiceConfiguration deviceIdFile;
     deviceIdFile.Load();
@@ -1308,17 +2313,18 @@ void PiPedalModel::UpdateDnsSd()
 }
 void PiPedalModel::SetWifiDirectConfigSettings(const WifiDirectConfigSettings &wifiDirectConfigSettings)
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-
+    // (without holding the model lock while the admin service applies the change.)
     adminClient.SetWifiDirectConfig(wifiDirectConfigSettings);
 
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
     this->storage.SetWifiDirectConfigSettings(wifiDirectConfigSettings);
 
     {
         WifiDirectConfigSettings tWifiDirectConfigSettings = storage.GetWifiDirectConfigSettings(); // (the passwordless version)
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnWifiDirectConfigSettingsChanged(tWifiDirectConfigSettings);
         }
@@ -1346,8 +2352,8 @@ void PiPedalModel::SetShowStatusMonitor(bool show)
         storage.SetShowStatusMonitor(show);
 
         // Notify clients.
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnShowStatusMonitorChanged(show);
         }
@@ -1373,6 +2379,14 @@ void PiPedalModel::RestartAudio(bool useDummyAudioDriver)
         {
             CancelAudioRetry();
         }
+        // The running pedalboard's plugin instances can be kept if the new
+        // configuration is compatible with the one they were instantiated for.
+        std::shared_ptr<Lv2Pedalboard> retainedPedalboard = previousPedalboardLoaded ? this->lv2Pedalboard : nullptr;
+        double previousSampleRate = pluginHost.GetSampleRate();
+        size_t previousMaxBufferSize = pluginHost.GetMaxAudioBufferSize();
+        int previousInputChannels = pluginHost.GetNumberOfInputAudioChannels();
+        int previousOutputChannels = pluginHost.GetNumberOfOutputAudioChannels();
+
         if (this->audioHost->IsOpen())
         {
 
@@ -1383,11 +2397,13 @@ void PiPedalModel::RestartAudio(bool useDummyAudioDriver)
 
         // Still bugs wrt/ restarting the circular buffers for the audio thread.
 
-        // do a complete reload.
-
         this->audioHost->SetPedalboard(nullptr);
+        if (retainedPedalboard)
+        {
+            // the audio thread is stopped, so it's safe to deactivate on this thread.
+            retainedPedalboard->Deactivate();
+        }
 
-        previousPedalboardLoaded = false;
         auto jackServerSettings = this->jackServerSettings;
         if (useDummyAudioDriver)
         {
@@ -1417,19 +2433,50 @@ void PiPedalModel::RestartAudio(bool useDummyAudioDriver)
         {
             throw std::runtime_error("Audio configuration not valid.");
         }
+        auto mainChannelSelection = GetMainChannelSelection(channelSelection);
+        if (retainedPedalboard &&
+            (jackConfiguration.sampleRate() != previousSampleRate ||
+             jackConfiguration.blockLength() > previousMaxBufferSize ||
+             (int)mainChannelSelection.GetInputAudioPorts().size() != previousInputChannels ||
+             (int)mainChannelSelection.GetOutputAudioPorts().size() != previousOutputChannels))
+        {
+            retainedPedalboard = nullptr;
+        }
+        if (!retainedPedalboard)
+        {
+            // do a complete reload.
+            RetainSharedResourcesForRebuild();
+            if (pedalboardPreloader)
+            {
+                pedalboardPreloader->Clear(); // built for the old audio configuration.
+            }
+            previousPedalboardLoaded = false;
+        }
+
         this->audioHost->Open(jackServerSettings, channelSelection);
+        hotspotManager->SetAudioActive(true);
 
-        this->pluginHost.OnConfigurationChanged(jackConfiguration, channelSelection);
+        this->pluginHost.OnConfigurationChanged(jackConfiguration, mainChannelSelection);
 
         FireChannelSelectionChanged(-1);
-        LoadCurrentPedalboard();
+        if (retainedPedalboard)
+        {
+            Lv2Log::info("Audio restarted. Plugin instances retained.");
+            this->audioHost->SetPedalboard(retainedPedalboard); // reactivates.
+        }
+        LoadCurrentPedalboard(); // sends a snapshot if the retained pedalboard is still current.
+        LoadPedalboardSlots();
 
         this->UpdateRealtimeVuSubscriptions();
         UpdateRealtimeMonitorPortSubscriptions();
+
+        UpdateRealtimeEffectTimingSubscriptions();
+        UpdatePresetPreloads();
     }
     catch (const std::exception &e)
     {
         this->audioHost->Close();
+        hotspotManager->SetAudioActive(false);
         if (useDummyAudioDriver)
         {
             Lv2Log::error(SS("Failed to start dummy audio driver. " << e.what()));
@@ -1490,8 +2537,8 @@ void PiPedalModel::SetAlsaSequencerConfiguration(const AlsaSequencerConfiguratio
     {
         this->storage.SetAlsaSequencerConfiguration(alsaSequencerConfiguration);
         // notify subscribers.
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnAlsaSequencerConfigurationChanged(alsaSequencerConfiguration);
         }
@@ -1523,7 +2570,11 @@ void PiPedalModel::SetJackChannelSelection(int64_t clientId, const JackChannelSe
         std::lock_guard<std::recursive_mutex> lock(mutex); // copy atomically.
         this->storage.SetJackChannelSelection(channelSelection);
 
-        this->pluginHost.OnConfigurationChanged(jackConfiguration, channelSelection);
+        this->pluginHost.OnConfigurationChanged(jackConfiguration, GetMainChannelSelection(channelSelection));
+        if (pedalboardPreloader)
+        {
+            pedalboardPreloader->Clear();
+        }
 
         CancelAudioRetry();
     }
@@ -1540,54 +2591,218 @@ void PiPedalModel::FireChannelSelectionChanged(int64_t clientId)
         // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
         JackChannelSelection channelSelection = storage.GetJackChannelSelection(this->jackConfiguration);
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnChannelSelectionChanged(clientId, channelSelection);
         }
     }
 }
 
-JackChannelSelection PiPedalModel::GetJackChannelSelection()
+JackChannelSelection PiPedalModel::GetMainChannelSelection(const JackChannelSelection &channelSelection)
 {
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    JackChannelSelection t = this->storage.GetJackChannelSelection(this->jackConfiguration);
-
-    return t;
+    const PedalboardSlots &slots = storage.GetPedalboardSlots();
+    if (slots.slots_.empty())
+    {
+        return channelSelection;
+    }
+    JackChannelSelection result = slots.GetMainChannelSelection(channelSelection);
+    if (!result.isValid())
+    {
+        Lv2Log::error("Pedalboard slots claim all of the selected channels. Pedalboard slots are disabled.");
+        return channelSelection;
+    }
+    return result;
 }
 
-int64_t PiPedalModel::AddVuSubscription(int64_t instanceId)
-{
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    int64_t subscriptionId = ++nextSubscriptionId;
-    activeVuSubscriptions.push_back(VuSubscription{subscriptionId, instanceId});
-
-    UpdateRealtimeVuSubscriptions();
-
-    return subscriptionId;
-}
-void PiPedalModel::RemoveVuSubscription(int64_t subscriptionHandle)
+void PiPedalModel::LoadPedalboardSlots()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    for (auto i = activeVuSubscriptions.begin(); i != activeVuSubscriptions.end(); ++i)
+    if (!audioHost || !audioHost->IsOpen())
     {
-        if ((*i).subscriptionHandle == subscriptionHandle)
-        {
-            activeVuSubscriptions.erase(i);
-            break;
-        }
+        return;
     }
-    UpdateRealtimeVuSubscriptions();
-}
+    JackChannelSelection channelSelection = storage.GetJackChannelSelection(this->jackConfiguration);
+    JackChannelSelection mainChannelSelection = GetMainChannelSelection(channelSelection);
+    const auto &selectedInputs = channelSelection.GetInputAudioPorts();
+    const auto &selectedOutputs = channelSelection.GetOutputAudioPorts();
 
-void PiPedalModel::OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value)
-{
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-    PedalboardItem *item = this->pedalboard.GetItem(instanceId);
-    if (item)
+    std::vector<AudioPedalboardSlot> audioSlots;
+    if (mainChannelSelection.GetInputAudioPorts().size() != selectedInputs.size() ||
+        mainChannelSelection.GetOutputAudioPorts().size() != selectedOutputs.size())
     {
-        Lv2PluginInfo::ptr pPluginInfo;
-        if (item->uri() == SPLIT_PEDALBOARD_ITEM_URI)
+        for (const auto &slot : storage.GetPedalboardSlots().slots_)
+        {
+            AudioPedalboardSlot audioSlot;
+            audioSlot.inputChannels = PedalboardSlots::GetChannelIndices(slot.inputAudioPorts_, selectedInputs);
+            audioSlot.outputChannels = PedalboardSlots::GetChannelIndices(slot.outputAudioPorts_, selectedOutputs);
+            if (audioSlot.inputChannels.size() != slot.inputAudioPorts_.size() ||
+                audioSlot.outputChannels.size() != slot.outputAudioPorts_.size())
+            {
+                Lv2Log::warning(SS("Pedalboard slot '" << slot.name_ << "' uses channels that aren't selected. The slot is disabled."));
+                continue;
+            }
+            if (slot.presetId_ == -1)
+            {
+                continue;
+            }
+            try
+            {
+                Pedalboard pedalboard = storage.GetPresetFromBank(slot.bankId_, slot.presetId_);
+                // the slot already has a core to itself.
+                pedalboard.parallelSplits(false);
+                pedalboard.pipeline(false);
+                Lv2PedalboardErrorList errorMessages;
+                audioSlot.pedalboard = std::shared_ptr<Lv2Pedalboard>(pluginHost.CreateLv2Pedalboard(
+                    pedalboard, errorMessages,
+                    (int)audioSlot.inputChannels.size(), (int)audioSlot.outputChannels.size()));
+                for (const auto &error : errorMessages)
+                {
+                    Lv2Log::error(SS("Pedalboard slot '" << slot.name_ << "': " << error.message));
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::error(SS("Pedalboard slot '" << slot.name_ << "': Can't load preset. " << e.what()));
+                continue;
+            }
+            audioSlots.push_back(std::move(audioSlot));
+        }
+    }
+    std::vector<int> mainInputChannels = PedalboardSlots::GetChannelIndices(mainChannelSelection.GetInputAudioPorts(), selectedInputs);
+    std::vector<int> mainOutputChannels = PedalboardSlots::GetChannelIndices(mainChannelSelection.GetOutputAudioPorts(), selectedOutputs);
+    try
+    {
+        audioHost->SetPedalboardSlots(mainInputChannels, mainOutputChannels, audioSlots);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("Can't start pedalboard slots. " << e.what()));
+    }
+}
+
+PedalboardSlots PiPedalModel::GetPedalboardSlots()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return storage.GetPedalboardSlots();
+}
+
+void PiPedalModel::SetPedalboardSlots(const PedalboardSlots &pedalboardSlots)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        try
+        {
+            storage.SetPedalboardSlots(pedalboardSlots);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw PiPedalArgumentException(e.what());
+        }
+        this->pluginHost.OnConfigurationChanged(jackConfiguration, GetMainChannelSelection(storage.GetJackChannelSelection(jackConfiguration)));
+        if (pedalboardPreloader)
+        {
+            pedalboardPreloader->Clear();
+        }
+        CancelAudioRetry();
+    }
+    RestartAudio(); // no lock, as for SetJackChannelSelection.
+}
+
+void PiPedalModel::SetPedalboardSlotPreset(size_t slot, int64_t bankId, int64_t presetId)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    PedalboardSlots slots = storage.GetPedalboardSlots();
+    if (slot >= slots.slots_.size())
+    {
+        throw PiPedalArgumentException("Invalid pedalboard slot.");
+    }
+    storage.GetPresetFromBank(bankId, presetId); // throws if it doesn't exist.
+    slots.slots_[slot].bankId_ = bankId;
+    slots.slots_[slot].presetId_ = presetId;
+    storage.SetPedalboardSlots(slots);
+    LoadPedalboardSlots();
+}
+
+JackChannelSelection PiPedalModel::GetJackChannelSelection()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    JackChannelSelection t = this->storage.GetJackChannelSelection(this->jackConfiguration);
+
+    return t;
+}
+
+int64_t PiPedalModel::AddVuSubscription(int64_t instanceId, float updatesPerSecond)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    int64_t subscriptionId = ++nextSubscriptionId;
+    activeVuSubscriptions.push_back(VuSubscription{subscriptionId, instanceId, updatesPerSecond});
+
+    UpdateRealtimeVuSubscriptions();
+
+    return subscriptionId;
+}
+void PiPedalModel::RemoveVuSubscription(int64_t subscriptionHandle)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for (auto i = activeVuSubscriptions.begin(); i != activeVuSubscriptions.end(); ++i)
+    {
+        if ((*i).subscriptionHandle == subscriptionHandle)
+        {
+            activeVuSubscriptions.erase(i);
+            break;
+        }
+    }
+    UpdateRealtimeVuSubscriptions();
+}
+void PiPedalModel::SetVuSubscriptionRates(const std::vector<int64_t> &subscriptionHandles, float updatesPerSecond)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bool changed = false;
+    for (auto &subscription : activeVuSubscriptions)
+    {
+        if (std::find(subscriptionHandles.begin(), subscriptionHandles.end(), subscription.subscriptionHandle) != subscriptionHandles.end() && subscription.updatesPerSecond != updatesPerSecond)
+        {
+            subscription.updatesPerSecond = updatesPerSecond;
+            changed = true;
+        }
+    }
+    if (changed)
+    {
+        UpdateRealtimeVuSubscriptions();
+    }
+}
+
+void PiPedalModel::OnNotifyMidiValuesChanged(const std::vector<MidiValueChange> &changes)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    std::vector<ControlValueChange> controlChanges;
+    controlChanges.reserve(changes.size());
+    bool changed = false;
+
+    // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
+    SubscriberList t = GetSubscribers();
+
+    for (const MidiValueChange &change : changes)
+    {
+        PedalboardItem *item = this->pedalboard.GetItem(change.instanceId);
+        if (!item)
+        {
+            continue;
+        }
+        if (change.controlIndex == -1)
+        {
+            this->pedalboard.SetItemEnabled(change.instanceId, change.value != 0);
+            for (auto &subscriber : *t)
+            {
+                subscriber->OnItemEnabledChanged(-1, change.instanceId, change.value != 0);
+            }
+            changed = true;
+            continue;
+        }
+        Lv2PluginInfo::ptr pPluginInfo;
+        if (item->uri() == SPLIT_PEDALBOARD_ITEM_URI)
         {
             pPluginInfo = GetSplitterPluginInfo();
         }
@@ -1595,81 +2810,515 @@ void PiPedalModel::OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, f
         {
             pPluginInfo = pluginHost.GetPluginInfo(item->uri());
         }
-        if (pPluginInfo)
+        if (!pPluginInfo)
         {
-            if (portIndex == -1)
+            continue;
+        }
+        for (const auto &port : pPluginInfo->ports())
+        {
+            if (port->index() == change.controlIndex)
             {
-                this->pedalboard.SetItemEnabled(instanceId, value != 0);
-                // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-                std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-                for (auto &subscriber : t)
-                {
-                    subscriber->OnItemEnabledChanged(-1, instanceId, value != 0);
-                }
-
-                this->SetPresetChanged(-1, true);
-                return;
+                this->pedalboard.SetControlValue(change.instanceId, port->symbol(), change.value);
+                controlChanges.push_back(ControlValueChange{change.instanceId, port->symbol(), change.value});
+                changed = true;
+                break;
             }
-            else
-            {
-                for (int i = 0; i < pPluginInfo->ports().size(); ++i)
-                {
-                    auto &port = pPluginInfo->ports()[i];
-                    if (port->index() == portIndex)
-                    {
-                        std::string symbol = port->symbol();
+        }
+    }
+    if (controlChanges.size() != 0)
+    {
+        // one notification per client for the whole batch.
+        for (auto &subscriber : *t)
+        {
+            subscriber->OnMidiValuesChanged(controlChanges);
+        }
+    }
+    if (changed)
+    {
+        this->SetPresetChanged(-1, true);
+    }
+}
 
-                        this->pedalboard.SetControlValue(instanceId, symbol, value);
-                        {
+void PiPedalModel::OnNotifyVusSubscription(const std::vector<VuUpdate> &updates)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
+    {
+        subscriber->OnVuMeterUpdate(updates);
+    }
+}
 
-                            // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-                            std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-                            for (auto &subscriber : t)
-                            {
-                                subscriber->OnMidiValueChanged(instanceId, symbol, value);
-                            }
+void PiPedalModel::UpdateRealtimeVuSubscriptions()
+{
+    // fastest rate requested for each instance. Instances that nobody is watching are omitted.
+    std::map<int64_t, float> instanceRates;
 
-                            this->SetPresetChanged(-1, true);
-                            return;
-                        }
-                    }
-                }
+    for (int i = 0; i < activeVuSubscriptions.size(); ++i)
+    {
+        auto instanceId = activeVuSubscriptions[i].instanceid;
+        float updatesPerSecond = activeVuSubscriptions[i].updatesPerSecond;
+        if (updatesPerSecond <= 0)
+        {
+            continue;
+        }
+        if (pedalboard.HasItem(instanceId) || instanceId == Pedalboard::INPUT_VOLUME_ID || instanceId == Pedalboard::OUTPUT_VOLUME_ID)
+        {
+            float &rate = instanceRates[instanceId];
+            rate = std::max(rate, updatesPerSecond);
+        }
+    }
+    if (audioHost)
+    {
+        std::vector<VuSubscriptionRate> subscriptions;
+        for (const auto &instanceRate : instanceRates)
+        {
+            subscriptions.push_back(VuSubscriptionRate{instanceRate.first, instanceRate.second});
+        }
+        audioHost->SetVuSubscriptions(subscriptions);
+    }
+}
+
+std::string PiPedalModel::StartRecording()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!audioHost)
+    {
+        throw PiPedalStateException("Audio is not running.");
+    }
+    std::filesystem::path directory = storage.GetPluginUploadDirectory() / "shared" / "audio" / "Recordings";
+    return audioHost->StartRecording(directory).filename().string();
+}
+
+void PiPedalModel::StopRecording()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (audioHost)
+    {
+        audioHost->StopRecording();
+    }
+}
+
+void PiPedalModel::SetPmuProfiling(bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    pmuProfiling = enabled;
+    if (audioHost)
+    {
+        audioHost->SetPmuProfiling(enabled);
+    }
+}
+
+void PiPedalModel::SetDenormalDetection(bool enabled)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    denormalDetection = enabled;
+    lastDenormalWarnings.clear();
+    if (audioHost)
+    {
+        audioHost->SetDenormalDetection(enabled);
+    }
+}
+
+void PiPedalModel::WarnDenormals(const std::vector<EffectTiming> &timings)
+{
+    // at most once a minute per effect.
+    auto now = std::chrono::steady_clock::now();
+    for (const auto &timing : timings)
+    {
+        if (timing.subnormalPercent_ <= 0)
+        {
+            continue;
+        }
+        auto i = lastDenormalWarnings.find(timing.instanceId_);
+        if (i != lastDenormalWarnings.end() && now - i->second < std::chrono::seconds(60))
+        {
+            continue;
+        }
+        lastDenormalWarnings[timing.instanceId_] = now;
+        const PedalboardItem *item = this->pedalboard.GetItem(timing.instanceId_);
+        std::string name = item == nullptr ? "(unknown)" : (item->title().empty() ? item->pluginName() : item->title());
+        Lv2Log::warning(SS("Denormals: " << name << " (" << timing.instanceId_ << ") produced subnormal output in "
+                                         << std::fixed << std::setprecision(1) << timing.subnormalPercent_ << "% of periods."));
+    }
+}
+
+int64_t PiPedalModel::AddEffectTimingSubscription()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    int64_t subscriptionId = ++nextSubscriptionId;
+    activeEffectTimingSubscriptions.push_back(subscriptionId);
+
+    UpdateRealtimeEffectTimingSubscriptions();
+
+    return subscriptionId;
+}
+void PiPedalModel::RemoveEffectTimingSubscription(int64_t subscriptionHandle)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    for (auto i = activeEffectTimingSubscriptions.begin(); i != activeEffectTimingSubscriptions.end(); ++i)
+    {
+        if (*i == subscriptionHandle)
+        {
+            activeEffectTimingSubscriptions.erase(i);
+            break;
+        }
+    }
+    UpdateRealtimeEffectTimingSubscriptions();
+}
+
+void PiPedalModel::OnNotifyEffectTimings(const std::vector<EffectTiming> &timings)
+{
+    bool save = false;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (denormalDetection)
+        {
+            WarnDenormals(timings);
+        }
+        if (configuration.GetRecordPluginCosts())
+        {
+            RecordPluginCosts(timings);
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastPluginCostSave > std::chrono::seconds(60))
+            {
+                lastPluginCostSave = now;
+                save = true;
             }
         }
+        if (activeEffectTimingSubscriptions.size() != 0)
+        {
+            // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
+            SubscriberList t = GetSubscribers();
+            for (auto &subscriber : *t)
+            {
+                subscriber->OnEffectTimingUpdate(timings);
+            }
+        }
+    }
+    if (save)
+    {
+        pluginCostDatabase->Save(); // file i/o outside the model lock.
     }
 }
 
-void PiPedalModel::OnNotifyVusSubscription(const std::vector<VuUpdate> &updates)
+void PiPedalModel::RecordPluginCosts(const std::vector<EffectTiming> &timings)
+{
+    if (!pluginCostDatabase || !jackConfiguration.isValid())
+    {
+        return;
+    }
+    uint32_t sampleRate = (uint32_t)jackConfiguration.sampleRate();
+    uint32_t blockSize = (uint32_t)jackConfiguration.blockLength();
+    uint32_t subBlockFrames = configuration.GetSubBlockFrames();
+    if (subBlockFrames != 0 && subBlockFrames < blockSize)
+    {
+        // timings are per run() call, i.e. per sub-block.
+        blockSize = subBlockFrames;
+    }
+    for (const auto &timing : timings)
+    {
+        const PedalboardItem *item = this->pedalboard.GetItem(timing.instanceId_);
+        // Skip bypassed effects, which may not be running at all.
+        if (item == nullptr || item->isSplit() || item->isEmpty() || !item->isEnabled())
+        {
+            continue;
+        }
+        pluginCostDatabase->Record(item->uri(), sampleRate, blockSize, timing);
+    }
+}
+
+void PiPedalModel::RecordPluginMemory(Lv2Pedalboard &lv2Pedalboard)
+{
+    if (!pluginCostDatabase || !jackConfiguration.isValid() || !configuration.GetRecordPluginCosts())
+    {
+        return;
+    }
+    for (auto &effect : lv2Pedalboard.GetSharedEffectList())
+    {
+        PluginMemoryFootprint *footprint = effect->GetMemoryFootprint();
+        // footprints measured while other plugins were being created include their allocations as well.
+        if (footprint == nullptr || footprint->recorded || !footprint->exclusive_)
+        {
+            continue;
+        }
+        footprint->recorded = true;
+        pluginCostDatabase->RecordMemory(
+            footprint->uri_,
+            (uint32_t)jackConfiguration.sampleRate(),
+            (uint32_t)jackConfiguration.blockLength(),
+            footprint->TotalBytes());
+    }
+}
+
+std::vector<PluginMemoryFootprint> PiPedalModel::GetPluginMemoryFootprints()
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    for (size_t i = 0; i < updates.size(); ++i)
+    std::vector<PluginMemoryFootprint> result;
+    if (!lv2Pedalboard)
     {
-        // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        return result;
+    }
+    for (auto &effect : lv2Pedalboard->GetSharedEffectList())
+    {
+        PluginMemoryFootprint *footprint = effect->GetMemoryFootprint();
+        if (footprint)
         {
-            subscriber->OnVuMeterUpdate(updates);
+            result.push_back(*footprint);
         }
     }
+    return result;
 }
 
-void PiPedalModel::UpdateRealtimeVuSubscriptions()
+PresetLoadEstimate PiPedalModel::EstimatePedalboardLoad(Pedalboard &pedalboard)
 {
-    std::set<int64_t> addedInstances;
+    PresetLoadEstimate result;
+    if (!pluginCostDatabase || !jackConfiguration.isValid())
+    {
+        return result;
+    }
+    std::vector<std::string> uris;
+    for (PedalboardItem *item : pedalboard.GetAllPlugins())
+    {
+        if (!item->isSplit() && !item->isEmpty() && !(item->hardBypass() && !item->isEnabled()))
+        {
+            uris.push_back(item->uri());
+        }
+    }
+    return pluginCostDatabase->EstimatePreset(
+        uris, (uint32_t)jackConfiguration.sampleRate(), (uint32_t)jackConfiguration.blockLength());
+}
 
-    for (int i = 0; i < activeVuSubscriptions.size(); ++i)
+std::vector<PluginCostEstimate> PiPedalModel::GetPluginCostEstimates()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!pluginCostDatabase || !jackConfiguration.isValid())
     {
-        auto instanceId = activeVuSubscriptions[i].instanceid;
-        if (pedalboard.HasItem(instanceId) || instanceId == Pedalboard::INPUT_VOLUME_ID || instanceId == Pedalboard::OUTPUT_VOLUME_ID)
+        return {};
+    }
+    return pluginCostDatabase->EstimateAll(
+        (uint32_t)jackConfiguration.sampleRate(), (uint32_t)jackConfiguration.blockLength());
+}
+
+PresetLoadEstimate PiPedalModel::EstimatePresetLoad(int64_t presetId)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    Pedalboard preset = storage.GetPreset(presetId);
+    return EstimatePedalboardLoad(preset);
+}
+
+void PiPedalModel::OnNotifyOverload(const std::vector<EffectTiming> &timings)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    int64_t instanceId = OverloadMonitor::SelectEffectToShed(
+        timings,
+        [this](int64_t instanceId)
+        {
+            const PedalboardItem *item = this->pedalboard.GetItem(instanceId);
+            return item != nullptr && !item->isSplit() && item->isEnabled() && !item->essential();
+        });
+    if (instanceId == -1)
+    {
+        Lv2Log::warning("Audio thread overloaded, but there are no effects that can be bypassed.");
+        return;
+    }
+    PedalboardItem *item = this->pedalboard.GetItem(instanceId);
+    std::string name = item->title().empty() ? item->pluginName() : item->title();
+
+    DisableAndHardBypassItem(instanceId);
+
+    std::string message = SS("Audio overload. '" << name << "' has been bypassed.");
+    Lv2Log::warning(message);
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
+    {
+        subscriber->OnErrorMessage(message);
+    }
+}
+
+void PiPedalModel::DisableAndHardBypassItem(int64_t instanceId)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    SetPedalboardItemEnable(-1, instanceId, false); // (marks the preset as changed.)
+    // and hard bypass, so that the plugin stops running. The hard bypass is transient: it isn't saved with the preset
+    // (so the preset isn't marked as changed), and the item's own setting is restored when the user enables it again.
+    PedalboardItem *item = this->pedalboard.GetItem(instanceId);
+    if (item && !this->shedItemHardBypass.contains(instanceId))
+    {
+        this->shedItemHardBypass[instanceId] = item->hardBypass();
+    }
+    if (this->pedalboard.SetItemHardBypass(instanceId, true))
+    {
+        this->FirePedalboardChanged(-1, true);
+    }
+}
+
+void PiPedalModel::RestoreShedItemHardBypass(Pedalboard &pedalboard)
+{
+    for (const auto &[instanceId, hardBypass] : this->shedItemHardBypass)
+    {
+        PedalboardItem *item = pedalboard.GetItem(instanceId);
+        if (item)
         {
-            addedInstances.insert(activeVuSubscriptions[i].instanceid);
+            item->hardBypass(hardBypass);
         }
     }
+}
+
+void PiPedalModel::OnEffectHung(const RealtimeWatchdog::HungEffect &hungEffect)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    if (hungEffect.instanceId == -1)
+    {
+        Lv2Log::error(SS("Watchdog: " << hungEffect.threadName << " thread stalled for " << hungEffect.seconds << "s."));
+        return;
+    }
+    PedalboardItem *item = this->pedalboard.GetItem(hungEffect.instanceId);
+    if (!item)
+    {
+        // the pedalboard has changed since.
+        Lv2Log::error(SS("Watchdog: a plugin that is no longer loaded hung the " << hungEffect.threadName << " thread."));
+        return;
+    }
+    std::string name = item->title().empty() ? item->pluginName() : item->title();
+    Lv2Log::error(SS("Watchdog: '" << name << "' (" << item->uri() << ") did not return from run() for " << hungEffect.seconds << "s."));
+
+    CrashGuard::RecordHungPlugin(item->uri());
+    DisableAndHardBypassItem(hungEffect.instanceId);
+
+    std::string message = SS("'" << name << "' stopped responding, and has been bypassed.");
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
+    {
+        subscriber->OnErrorMessage(message);
+    }
+}
+
+void PiPedalModel::UpdateRealtimeEffectTimingSubscriptions()
+{
+    if (audioHost)
+    {
+        audioHost->SetEffectTimingSubscription(
+            activeEffectTimingSubscriptions.size() != 0 || configuration.GetRecordPluginCosts());
+    }
+}
+
+void PiPedalModel::UpdateRealtimeAtomOutputSubscriptions()
+{
     if (audioHost)
     {
-        std::vector<int64_t> instanceids(addedInstances.begin(), addedInstances.end());
-        audioHost->SetVuSubscriptions(instanceids);
+        std::vector<AtomOutputSubscription> subscriptions;
+        for (const auto &listener : atomOutputListeners)
+        {
+            AtomOutputSubscription subscription{listener.instanceId, listener.propertyUrid};
+            if (std::find(subscriptions.begin(), subscriptions.end(), subscription) == subscriptions.end())
+            {
+                subscriptions.push_back(subscription);
+            }
+        }
+        audioHost->SetAtomOutputSubscriptions(subscriptions);
+    }
+}
+
+void PiPedalModel::UpdatePresetPreloads()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    if (!pedalboardPreloader || !audioHost || !audioHost->IsOpen())
+    {
+        return;
+    }
+    PresetIndex presetIndex;
+    storage.GetPresetIndex(&presetIndex);
+    const auto &presets = presetIndex.presets();
+    int64_t currentPresetId = storage.GetCurrentPresetId();
+
+    int64_t currentIndex = -1;
+    for (size_t i = 0; i < presets.size(); ++i)
+    {
+        if (presets[i].instanceId() == currentPresetId)
+        {
+            currentIndex = (int64_t)i;
+            break;
+        }
+    }
+    if (currentIndex == -1)
+    {
+        pedalboardPreloader->SetRequests({});
+        return;
+    }
+
+    // next, previous, next+1, previous-1, ... (wrapping, as NextPreset/PreviousPreset do),
+    // starting in the direction of the last footswitch navigation.
+    std::vector<PedalboardPreloader::Request> requests;
+    int64_t nPresets = (int64_t)presets.size();
+    int64_t firstDirection = lastPresetNavigationBackward ? -1 : 1;
+    for (int64_t distance = 1; distance < nPresets && requests.size() < configuration.GetPreloadPresets(); ++distance)
+    {
+        for (int64_t direction : {firstDirection, -firstDirection})
+        {
+            int64_t index = ((currentIndex + direction * distance) % nPresets + nPresets) % nPresets;
+            int64_t presetId = presets[index].instanceId();
+            if (presetId == currentPresetId || requests.size() >= configuration.GetPreloadPresets())
+            {
+                continue;
+            }
+            bool duplicate = false;
+            for (const auto &request : requests)
+            {
+                if (request.presetId == presetId)
+                {
+                    duplicate = true;
+                    break;
+                }
+            }
+            if (duplicate)
+            {
+                continue;
+            }
+            PedalboardPreloader::Request request;
+            request.presetId = presetId;
+            request.pedalboard = storage.GetPreset(presetId);
+            UpdateDefaults(&request.pedalboard);
+            requests.push_back(std::move(request));
+        }
+    }
+    pedalboardPreloader->SetRequests(std::move(requests));
+
+    // warm the page cache with the bank files that NextBank/PreviousBank would load.
+    std::vector<std::filesystem::path> prefetchFiles;
+    const BankIndex &bankIndex = storage.GetBanks();
+    const auto &banks = bankIndex.entries();
+    int64_t nBanks = (int64_t)banks.size();
+    int64_t currentBank = -1;
+    for (int64_t i = 0; i < nBanks; ++i)
+    {
+        if (banks[i].instanceId() == bankIndex.selectedBank())
+        {
+            currentBank = i;
+            break;
+        }
+    }
+    if (currentBank != -1 && nBanks > 1)
+    {
+        int64_t firstBankDirection = lastBankNavigationBackward ? -1 : 1;
+        for (int64_t direction : {firstBankDirection, -firstBankDirection})
+        {
+            int64_t index = ((currentBank + direction) % nBanks + nBanks) % nBanks;
+            if (index == currentBank)
+            {
+                continue;
+            }
+            for (auto &path : storage.GetBankFilePaths(banks[index].instanceId()))
+            {
+                prefetchFiles.push_back(std::move(path));
+            }
+        }
     }
+    pedalboardPreloader->SetPrefetchFiles(std::move(prefetchFiles));
 }
 
 void PiPedalModel::UpdateRealtimeMonitorPortSubscriptions()
@@ -1681,12 +3330,12 @@ void PiPedalModel::UpdateRealtimeMonitorPortSubscriptions()
     audioHost->SetMonitorPortSubscriptions(this->activeMonitorPortSubscriptions);
 }
 
-int64_t PiPedalModel::MonitorPort(int64_t instanceId, const std::string &key, float updateInterval, PortMonitorCallback onUpdate)
+int64_t PiPedalModel::MonitorPort(int64_t instanceId, const std::string &key, float updateInterval, PortMonitorCallback onUpdate, float epsilon)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     int64_t subscriptionId = ++nextSubscriptionId;
     activeMonitorPortSubscriptions.push_back(
-        MonitorPortSubscription{subscriptionId, instanceId, key, updateInterval, onUpdate});
+        MonitorPortSubscription{subscriptionId, instanceId, key, updateInterval, onUpdate, epsilon});
 
     UpdateRealtimeMonitorPortSubscriptions();
 
@@ -1704,23 +3353,90 @@ void PiPedalModel::UnmonitorPort(int64_t subscriptionHandle)
             UpdateRealtimeMonitorPortSubscriptions();
             break;
         }
-    }
-}
-
-void PiPedalModel::OnNotifyMonitorPort(const MonitorPortUpdate &update)
-{
-    std::lock_guard<std::recursive_mutex> lock(mutex);
-
-    for (auto i = activeMonitorPortSubscriptions.begin(); i != activeMonitorPortSubscriptions.end(); ++i)
-    {
-        if ((*i).subscriptionHandle == update.subscriptionHandle)
+    }
+}
+
+void PiPedalModel::OnNotifyMonitorPort(const MonitorPortUpdate &update)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    for (auto i = activeMonitorPortSubscriptions.begin(); i != activeMonitorPortSubscriptions.end(); ++i)
+    {
+        if ((*i).subscriptionHandle == update.subscriptionHandle)
+        {
+
+            // make the call ONLY if the subscription handle is still valid.
+            (*update.callbackPtr)(update.subscriptionHandle, update.value);
+            break;
+        }
+    }
+}
+
+void PiPedalModel::OnPatchPropertyRequestComplete(RealtimePatchPropertyRequest *pParameter)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bool cancelled = true;
+    for (auto i = this->outstandingParameterRequests.begin();
+         i != this->outstandingParameterRequests.end(); ++i)
+    {
+        if ((*i) == pParameter)
+        {
+            cancelled = false;
+            this->outstandingParameterRequests.erase(i);
+            break;
+        }
+    }
+    if (!cancelled)
+    {
+        if (pParameter->errorMessage != nullptr)
+        {
+            if (pParameter->onError)
+            {
+                pParameter->onError(pParameter->errorMessage);
+            }
+        }
+        else if (pParameter->requestType == RealtimePatchPropertyRequest::RequestType::PatchSet)
+        {
+            if (pParameter->onSetSuccess)
+            {
+                pParameter->onSetSuccess();
+            }
+        }
+        else if (pParameter->GetSize() == 0)
+        {
+            if (pParameter->onError)
+            {
+                // For plugins that don't respond (e.g. a buncha MOD plugins), use the value we last set on the plugin!
+                bool foundValue = false;
+                auto pedalboardItem = this->pedalboard.GetItem(pParameter->instanceId);
+                if (pedalboardItem)
+                {
+                    auto f = pedalboardItem->pathProperties_.find(pParameter->uri);
+                    if (f != pedalboardItem->pathProperties_.end())
+                    {
+                        pParameter->jsonResponse = f->second;
+                        if (pParameter->onSuccess)
+                        {
+                            foundValue = true;
+                            pParameter->onSuccess(pParameter->jsonResponse);
+                        }
+                    }
+                }
+                if (!foundValue)
+                {
+                    pParameter->onError("No response.");
+                }
+            }
+        }
+        else
         {
-
-            // make the call ONLY if the subscription handle is still valid.
-            (*update.callbackPtr)(update.subscriptionHandle, update.value);
-            break;
+            if (pParameter->onSuccess)
+            {
+                pParameter->onSuccess(pParameter->jsonResponse);
+            }
         }
     }
+    patchPropertyRequestPool.Release(pParameter);
 }
 
 void PiPedalModel::SendSetPatchProperty(
@@ -1760,49 +3476,14 @@ void PiPedalModel::SendSetPatchProperty(
     }
     LV2_Atom *atomValue = atomConverter.ToAtom(value);
 
-    std::function<void(RealtimePatchPropertyRequest *)> onRequestComplete{
-        [this, onSuccess](RealtimePatchPropertyRequest *pParameter)
-        {
-            {
-                std::lock_guard<std::recursive_mutex> lock(mutex);
-                bool cancelled = true;
-                for (auto i = this->outstandingParameterRequests.begin();
-                     i != this->outstandingParameterRequests.end(); ++i)
-                {
-                    if ((*i) == pParameter)
-                    {
-                        cancelled = false;
-                        this->outstandingParameterRequests.erase(i);
-                        break;
-                    }
-                }
-                if (!cancelled)
-                {
-                    if (pParameter->errorMessage != nullptr)
-                    {
-                        if (pParameter->onError)
-                        {
-                            pParameter->onError(pParameter->errorMessage);
-                        }
-                    }
-                    else
-                    {
-                        if (onSuccess)
-                        {
-                            onSuccess();
-                        }
-                    }
-                }
-                delete pParameter;
-            }
-        }};
-
     LV2_URID urid = this->pluginHost.GetLv2Urid(propertyUri.c_str());
     size_t sampleTimeout = 0.5 * audioHost->GetSampleRate();
-    RealtimePatchPropertyRequest *request = new RealtimePatchPropertyRequest(
-        onRequestComplete,
-        clientId, instanceId, urid, atomValue, nullptr, onError,
-        sampleTimeout);
+    RealtimePatchPropertyRequest *request = patchPropertyRequestPool.AcquireSet(
+        clientId, instanceId, urid, atomValue, sampleTimeout);
+    request->onPatchRequestComplete = [this](RealtimePatchPropertyRequest *pParameter)
+    { OnPatchPropertyRequestComplete(pParameter); };
+    request->onSetSuccess = std::move(onSuccess);
+    request->onError = std::move(onError);
 
     outstandingParameterRequests.push_back(request);
     if (this->audioHost)
@@ -1818,69 +3499,6 @@ void PiPedalModel::SendGetPatchProperty(
     std::function<void(const std::string &jsonResult)> onSuccess,
     std::function<void(const std::string &error)> onError)
 {
-    std::function<void(RealtimePatchPropertyRequest *)> onRequestComplete{
-        [this](RealtimePatchPropertyRequest *pParameter)
-        {
-            {
-                std::lock_guard<std::recursive_mutex> lock(mutex);
-                bool cancelled = true;
-                for (auto i = this->outstandingParameterRequests.begin();
-                     i != this->outstandingParameterRequests.end(); ++i)
-                {
-                    if ((*i) == pParameter)
-                    {
-                        cancelled = false;
-                        this->outstandingParameterRequests.erase(i);
-                        break;
-                    }
-                }
-                if (!cancelled)
-                {
-                    if (pParameter->errorMessage != nullptr)
-                    {
-                        if (pParameter->onError)
-                        {
-                            pParameter->onError(pParameter->errorMessage);
-                        }
-                    }
-                    else if (pParameter->GetSize() == 0 && pParameter->requestType == RealtimePatchPropertyRequest::RequestType::PatchGet)
-                    {
-                        if (pParameter->onError)
-                        {
-                            // For plugins that don't respond (e.g. a buncha MOD plugins), use the value we last set on the plugin!
-                            bool foundValue = false;
-                            std::lock_guard<std::recursive_mutex> lock(mutex);
-                            auto pedalboardItem = this->pedalboard.GetItem(pParameter->instanceId);
-                            if (pedalboardItem)
-                            {
-                                if (pedalboardItem->pathProperties_.contains(pParameter->uri))
-                                {
-                                    pParameter->jsonResponse = pedalboardItem->pathProperties_[pParameter->uri];
-                                    if (pParameter->onSuccess)
-                                    {
-                                        foundValue = true;
-                                        pParameter->onSuccess(pParameter->jsonResponse);
-                                    }
-                                }
-                            }
-                            if (!foundValue)
-                            {
-                                pParameter->onError("No response.");
-                            }
-                        }
-                    }
-                    else
-                    {
-                        if (pParameter->onSuccess)
-                        {
-                            pParameter->onSuccess(pParameter->jsonResponse);
-                        }
-                    }
-                }
-                delete pParameter;
-            }
-        }};
-
     LV2_URID urid = this->pluginHost.GetLv2Urid(uri.c_str());
 
     std::lock_guard<std::recursive_mutex> lock(mutex);
@@ -1888,12 +3506,15 @@ void PiPedalModel::SendGetPatchProperty(
     if (!this->audioHost)
     {
         onError("Audio stopped.");
+        return;
     }
     size_t sampleTimeout = 0.3 * audioHost->GetSampleRate();
-    RealtimePatchPropertyRequest *request = new RealtimePatchPropertyRequest(
-        onRequestComplete,
-        clientId, instanceId, urid, onSuccess, onError, sampleTimeout);
-    request->uri = uri;
+    RealtimePatchPropertyRequest *request = patchPropertyRequestPool.AcquireGet(
+        clientId, instanceId, urid, uri, sampleTimeout);
+    request->onPatchRequestComplete = [this](RealtimePatchPropertyRequest *pParameter)
+    { OnPatchPropertyRequestComplete(pParameter); };
+    request->onSuccess = std::move(onSuccess);
+    request->onError = std::move(onError);
 
     outstandingParameterRequests.push_back(request);
     this->audioHost->sendRealtimeParameterRequest(request);
@@ -1905,6 +3526,21 @@ BankIndex PiPedalModel::GetBankIndex() const
     return storage.GetBanks();
 }
 
+BankIndex PiPedalModel::GetBankIndex(int64_t *version)
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    const BankIndex &banks = storage.GetBanks();
+    IndexPatch patch;
+    if (!hasBroadcastBanks || !IndexPatch::Make(broadcastBanks, banks, &patch) || patch.HasEntryChanges())
+    {
+        broadcastBanks = banks;
+        hasBroadcastBanks = true;
+        ++bankIndexVersion;
+    }
+    *version = bankIndexVersion;
+    return banks;
+}
+
 void PiPedalModel::RenameBank(int64_t clientId, int64_t bankId, const std::string &newName)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
@@ -1929,6 +3565,7 @@ void PiPedalModel::OpenBank(int64_t clientId, int64_t bankId)
 
     FirePresetsChanged(clientId);
 
+    this->shedItemHardBypass.clear();
     this->pedalboard = storage.GetCurrentPreset();
 
     UpdateDefaults(&this->pedalboard);
@@ -1963,8 +3600,8 @@ void PiPedalModel::SetJackServerSettings(const JackServerSettings &jackServerSet
     this->jackServerSettings = jackServerSettings;
 
     // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnJackServerSettingsChanged(jackServerSettings);
     }
@@ -1987,6 +3624,7 @@ void PiPedalModel::SetJackServerSettings(const JackServerSettings &jackServerSet
         CurrentPreset currentPreset;
         currentPreset.modified_ = this->hasPresetChanged;
         currentPreset.preset_ = this->pedalboard;
+        RestoreShedItemHardBypass(currentPreset.preset_);
         storage.SaveCurrentPreset(currentPreset);
 
         this->jackConfiguration.SetIsRestarting(true);
@@ -2024,6 +3662,7 @@ void PiPedalModel::SetJackServerSettings(const JackServerSettings &jackServerSet
                     audioHost->SetPedalboard(lv2Pedalboard);
                     UpdateRealtimeVuSubscriptions();
                     UpdateRealtimeMonitorPortSubscriptions();
+                    UpdateRealtimeEffectTimingSubscriptions();
 #endif
                 }
             });
@@ -2031,11 +3670,77 @@ void PiPedalModel::SetJackServerSettings(const JackServerSettings &jackServerSet
 #endif
 }
 
+template <typename T>
+static std::shared_ptr<const std::string> ToJsonString(const T &value)
+{
+    std::string json;
+    json_writer writer(json, true);
+    writer.write(value);
+    return std::make_shared<const std::string>(std::move(json));
+}
+
+void PiPedalModel::UpdatePluginCatalog()
+{
+    // call with mutex held.
+    if (!uiPluginsJson)
+    {
+        uiPluginsJson = ToJsonString(pluginHost.GetUiPlugins());
+        uiPluginsJsonGz = GzipCompress(*uiPluginsJson);
+        std::stringstream s;
+        s << std::hex << std::setw(16) << std::setfill('0') << HtmlHelper::crc64(*uiPluginsJson);
+        uiPluginsVersion = s.str();
+    }
+}
+
+std::shared_ptr<const std::string> PiPedalModel::GetUiPluginsJson()
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    UpdatePluginCatalog();
+    return uiPluginsJson;
+}
+
+PiPedalModel::PluginCatalog PiPedalModel::GetPluginCatalog()
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    UpdatePluginCatalog();
+    return PluginCatalog{uiPluginsJson, uiPluginsJsonGz, uiPluginsVersion};
+}
+
+std::string PiPedalModel::GetPluginCatalogVersion()
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    UpdatePluginCatalog();
+    return uiPluginsVersion;
+}
+
+PluginSearchResult PiPedalModel::SearchPlugins(const PluginSearchRequest &request)
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    return pluginHost.SearchPlugins(request);
+}
+
+std::shared_ptr<const std::string> PiPedalModel::GetPluginClassesJson()
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    if (!pluginClassesJson)
+    {
+        pluginClassesJson = ToJsonString(pluginHost.GetLv2PluginClass());
+    }
+    return pluginClassesJson;
+}
+
 std::shared_ptr<Lv2PluginInfo> PiPedalModel::GetPluginInfo(const std::string &uri)
 {
+    std::lock_guard<std::recursive_mutex> guard(mutex); // plugin lists change on incremental plugin reloads.
     return pluginHost.GetPluginInfo(uri);
 }
 
+ModGui::ptr PiPedalModel::GetModGui(const std::string &uri)
+{
+    std::lock_guard<std::recursive_mutex> guard(mutex);
+    return pluginHost.GetModGui(uri);
+}
+
 
 void PiPedalModel::UpdateDefaults(SnapshotValue&snapshotValue, const PedalboardItem*pedalboardItem_)
 {
@@ -2296,8 +4001,8 @@ void PiPedalModel::LoadPluginPreset(int64_t pluginInstanceId, uint64_t presetIns
             // fast path for control changes only.
             audioHost->SetPluginPreset(pluginInstanceId, presetValues.controls);
 
-            std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-            for (auto &subscriber : t)
+            SubscriberList t = GetSubscribers();
+            for (auto &subscriber : *t)
             {
                 subscriber->OnLoadPluginPreset(pluginInstanceId, presetValues.controls);
             }
@@ -2325,10 +4030,7 @@ void PiPedalModel::DeleteAtomOutputListeners(int64_t clientId)
             --i;
         }
     }
-    if (audioHost)
-    {
-        audioHost->SetListenForAtomOutput(atomOutputListeners.size() != 0);
-    }
+    UpdateRealtimeAtomOutputSubscriptions();
 }
 
 void PiPedalModel::DeleteMidiListeners(int64_t clientId)
@@ -2375,6 +4077,7 @@ void PiPedalModel::OnPatchSetReply(uint64_t instanceId, LV2_URID patchSetPropert
 
     bool hasAtomJson = false;
     std::string atomJson;
+    bool listenersRemoved = false;
 
     for (int i = 0; i < atomOutputListeners.size(); ++i)
     {
@@ -2395,12 +4098,13 @@ void PiPedalModel::OnPatchSetReply(uint64_t instanceId, LV2_URID patchSetPropert
             {
                 atomOutputListeners.erase(atomOutputListeners.begin() + i);
                 --i;
+                listenersRemoved = true;
             }
         }
     }
-    if (audioHost)
+    if (listenersRemoved)
     {
-        audioHost->SetListenForAtomOutput(atomOutputListeners.size() != 0);
+        UpdateRealtimeAtomOutputSubscriptions();
     }
 }
 
@@ -2431,8 +4135,8 @@ void PiPedalModel::OnNotifyPathPatchPropertyReceived(
         std::string abstractAtomString = storage.ToAbstractPathFromJson(atomString);
         pedalboardItem->pathProperties_[pathPatchPropertyUri] = abstractAtomString;
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnNotifyPathPatchPropertyChanged(
                 instanceId,
@@ -2509,7 +4213,7 @@ void PiPedalModel::MonitorPatchProperty(int64_t clientId, int64_t clientHandle,
     }
     AtomOutputListener listener{clientId, clientHandle, instanceId, propertyUrid};
     atomOutputListeners.push_back(listener);
-    audioHost->SetListenForAtomOutput(true);
+    UpdateRealtimeAtomOutputSubscriptions();
 
     PedalboardItem *item = this->pedalboard.GetItem(instanceId);
     if (item)
@@ -2524,7 +4228,8 @@ void PiPedalModel::MonitorPatchProperty(int64_t clientId, int64_t clientHandle,
                 {
                     std::string json = storage.FromAbstractPathJson(value);
 
-                    for (auto &subscriber : this->subscribers)
+                    SubscriberList t = GetSubscribers();
+                    for (auto &subscriber : *t)
                     {
                         if (subscriber->GetClientId() == clientId)
                         {
@@ -2552,15 +4257,16 @@ void PiPedalModel::CancelMonitorPatchProperty(int64_t clientId, int64_t clientHa
             break;
         }
     }
-    if (midiEventListeners.size() == 0)
-    {
-        audioHost->SetListenForMidiEvent(false);
-    }
+    UpdateRealtimeAtomOutputSubscriptions();
 }
 
 std::vector<AlsaDeviceInfo> PiPedalModel::GetAlsaDevices()
 {
     std::vector<AlsaDeviceInfo> result = this->alsaDevices.GetAlsaDevices();
+    if (IsPipeWireAvailable())
+    {
+        result.push_back(MakePipeWireDeviceInfo(2));
+    }
 #ifdef JUNK
     // Useful for debugging non-stereo device configurations
     result.push_back(MakeDummyDeviceInfo(1));
@@ -2585,10 +4291,11 @@ void PiPedalModel::SetFavorites(const std::map<std::string, bool> &favorites)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
     storage.SetFavorites(favorites);
+    pluginHost.SetSearchFavorites(favorites);
 
     // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnFavoritesChanged(favorites);
     }
@@ -2608,8 +4315,8 @@ void PiPedalModel::SetSystemMidiBindings(std::vector<MidiBinding> &bindings)
         this->audioHost->SetSystemMidiBindings(bindings);
     }
 
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnSystemMidiBindingsChanged(bindings);
     }
@@ -2626,7 +4333,7 @@ PedalboardItem *PiPedalModel::GetPedalboardItemForFileProperty(const UiFilePrope
     }
     return nullptr;
 }
-FileRequestResult PiPedalModel::GetFileList2(const std::string &relativePath_, const UiFileProperty &fileProperty)
+FileRequestResult PiPedalModel::GetFileList2(const std::string &relativePath_, const UiFileProperty &fileProperty, const std::string &sortKey)
 {
     std::string relativePath = relativePath_;
     try
@@ -2656,7 +4363,7 @@ FileRequestResult PiPedalModel::GetFileList2(const std::string &relativePath_, c
                 }
             }
         }
-        return this->storage.GetFileList2(relativePath, fileProperty);
+        return this->storage.GetFileList2(relativePath, fileProperty, sortKey);
     }
     catch (const std::exception &e)
     {
@@ -2735,6 +4442,16 @@ std::string PiPedalModel::UploadUserFile(const std::string &directory, int64_t i
     }
     return storage.UploadUserFile(directory, fileProperty, filename, stream, contentLength);
 }
+std::string PiPedalModel::UploadUserFile(const std::string &directory, int64_t instanceId, const std::string &patchProperty, const std::string &filename, const std::filesystem::path &sourceFile, size_t contentLength)
+{
+    UiFileProperty::ptr fileProperty = FindLoadedPatchProperty(instanceId, patchProperty);
+    if (!fileProperty)
+    {
+        Lv2Log::error(SS("Upload fle: Permission denied. No currently-loaded plugin provides that patch property: " << patchProperty));
+        throw std::runtime_error("Permission denied.");
+    }
+    return storage.UploadUserFile(directory, fileProperty, filename, sourceFile, contentLength);
+}
 
 uint64_t PiPedalModel::CreateNewPreset()
 {
@@ -2781,23 +4498,48 @@ void PiPedalModel::SetSelectedPedalboardPlugin(uint64_t clientId, uint64_t pedal
 bool PiPedalModel::LoadCurrentPedalboard()
 {
     CrashGuardLock crashGuardLock;
+    TraceScope traceScope("preset", "LoadCurrentPedalboard");
     if (previousPedalboardLoaded && pedalboard.IsStructureIdentical(previousPedalboard))
     {
         // then we can send a snapshot update instead!
+        TraceScope phaseScope("preset", "LoadSnapshot");
         Snapshot snapshot = pedalboard.MakeSnapshotFromCurrentSettings(previousPedalboard);
         audioHost->LoadSnapshot(snapshot, pluginHost);
         this->previousPedalboard = this->pedalboard;
         return true;
     }
 
-    Lv2PedalboardErrorList errorMessages;
-    std::shared_ptr<Lv2Pedalboard> lv2Pedalboard{this->pluginHost.CreateLv2Pedalboard(this->pedalboard, errorMessages)};
+    std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
+    bool preloadSettingsChanged = false;
+    if (pedalboardPreloader)
+    {
+        lv2Pedalboard = pedalboardPreloader->Take(storage.GetCurrentPresetId(), this->pedalboard, &preloadSettingsChanged);
+    }
+    bool preloaded = lv2Pedalboard != nullptr;
+    if (!preloaded)
+    {
+        TraceScope phaseScope("preset", "CreateLv2Pedalboard");
+        uint64_t startNs = EffectTimingClockNs();
+        Lv2PedalboardErrorList errorMessages;
+        lv2Pedalboard = std::shared_ptr<Lv2Pedalboard>(this->pluginHost.CreateLv2Pedalboard(this->pedalboard, errorMessages));
+        SwitchLatencyMonitor::GetInstance().AddInstantiateTime(EffectTimingClockNs() - startNs);
+    }
     this->lv2Pedalboard = lv2Pedalboard;
 
     // apply the error messages to the lv2Pedalboard.
     // return true if the error messages have changed
     CheckForResourceInitialization(this->pedalboard);
-    audioHost->SetPedalboard(lv2Pedalboard);
+    {
+        TraceScope phaseScope("preset", "AudioHost.SetPedalboard");
+        audioHost->SetPedalboard(lv2Pedalboard);
+    }
+    RecordPluginMemory(*lv2Pedalboard);
+    if (preloaded && preloadSettingsChanged)
+    {
+        // the preset was edited after it was preloaded (structure is identical).
+        Snapshot snapshot = pedalboard.MakeSnapshotFromCurrentSettings(pedalboard);
+        audioHost->LoadSnapshot(snapshot, pluginHost);
+    }
     previousPedalboard = this->pedalboard;
     previousPedalboardLoaded = true;
     return true;
@@ -2808,9 +4550,8 @@ void PiPedalModel::OnNotifyLv2RealtimeError(int64_t instanceId, const std::strin
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
     // Notify clients.
-    size_t n = subscribers.size();
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnErrorMessage(error);
     }
@@ -2820,14 +4561,50 @@ std::filesystem::path PiPedalModel::GetPluginUploadDirectory() const
     return storage.GetPluginUploadDirectory();
 }
 
-void PiPedalModel::OnLv2PluginsChanged()
+void PiPedalModel::OnLv2PluginsChanged(const std::vector<std::string> &bundlePaths)
 {
-    Lv2Log::info("Lv2 plugins have changed. Reloading plugins.");
     std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    std::set<std::string> inUsePluginUris;
+    for (PedalboardItem *item : this->pedalboard.GetAllPlugins())
+    {
+        inUsePluginUris.insert(item->uri());
+    }
+    if (pedalboardPreloader)
+    {
+        pedalboardPreloader->Clear(); // may hold instances of plugins that are about to be unloaded.
+    }
+
+    Lv2PluginListDelta delta;
+    if (pluginHost.ReloadBundles(bundlePaths, inUsePluginUris, &delta))
+    {
+        for (const auto &uiPlugin : delta.updated_)
+        {
+            auto plugin = pluginHost.GetPluginInfo(uiPlugin.uri());
+            if (plugin && plugin->has_factory_presets() && !storage.HasPluginPresets(plugin->uri()))
+            {
+                storage.SavePluginPresets(plugin->uri(), pluginHost.GetFactoryPluginPresets(plugin->uri()));
+            }
+        }
+        if (!delta.empty())
+        {
+            uiPluginsJson = nullptr;
+            // Notify clients.
+            SubscriberList t = GetSubscribers();
+            for (auto &subscriber : *t)
+            {
+                subscriber->OnLv2PluginsUpdated(delta);
+            }
+        }
+        UpdatePresetPreloads();
+        return;
+    }
+
+    Lv2Log::info("Lv2 plugins have changed. Reloading plugins.");
     {
         // Notify clients.
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-        for (auto &subscriber : t)
+        SubscriberList t = GetSubscribers();
+        for (auto &subscriber : *t)
         {
             subscriber->OnLv2PluginsChanging();
         }
@@ -2861,8 +4638,8 @@ void PiPedalModel::FireUpdateStatusChanged(const UpdateStatus &updateStatus)
 {
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnUpdateStatusChanged(updateStatus);
     }
@@ -2902,15 +4679,28 @@ static bool HasAlsaDevice(const std::vector<AlsaDeviceInfo> devices, const std::
 
 void PiPedalModel::StartHotspotMonitoring()
 {
-    this->avahiService = std::make_unique<AvahiService>();
+    char threadName[16]{};
+    pthread_getname_np(pthread_self(), threadName, sizeof(threadName));
+
+    // connecting to avahi can be slow at boot time, so don't hold the model mutex while we do.
+    auto avahiService = std::make_unique<AvahiService>();
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        this->avahiService = std::move(avahiService);
 
-    SetThreadName("avahi"); // hack to name the avahi service thread.
-    UpdateDnsSd();          // now that the server is running, publish a  DNS-SD announcement.
-    SetThreadName("main");
+        SetThreadName("avahi"); // hack to name the avahi service thread.
+        UpdateDnsSd();          // now that the server is running, publish a  DNS-SD announcement.
+        pthread_setname_np(pthread_self(), threadName);
+    }
 
     this->hotspotManager->Open();
 }
 
+void PiPedalModel::StartUpdater()
+{
+    updater->Start();
+}
+
 void PiPedalModel::WaitForAudioDeviceToComeOnline()
 {
     auto serverSettings = this->GetJackServerSettings();
@@ -2932,6 +4722,7 @@ void PiPedalModel::WaitForAudioDeviceToComeOnline()
             for (int i = 0; i < 5; ++i)
             {
                 sleep(2);
+                alsaDevices.Invalidate();
                 devices = GetAlsaDevices();
                 if (HasAlsaDevice(devices, serverSettings.GetAlsaInputDevice()))
                 {
@@ -2985,6 +4776,189 @@ bool PiPedalModel::CancelPost(PostHandle handle)
     return hotspotManager->CancelPost(handle);
 }
 
+void PiPedalModel::UpdateCpuFrequencyPolicy(const std::string &governor)
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    bool enable = governor == AUTO_CPU_GOVERNOR && !closed && audioHost && HasCpuGovernor() && adminClient.CanUseAdminClient();
+    if (!enable)
+    {
+        if (cpuFrequencyPolicyPostHandle)
+        {
+            CancelPost(cpuFrequencyPolicyPostHandle);
+            cpuFrequencyPolicyPostHandle = 0;
+        }
+        cpuFrequencyPolicy = nullptr;
+        return;
+    }
+    if (cpuFrequencyPolicy)
+    {
+        return;
+    }
+    std::vector<uint64_t> frequencies = GetCpuFrequencies();
+    if (frequencies.empty())
+    {
+        Lv2Log::warning("CPU frequency policy: CPU frequencies are not available.");
+        return;
+    }
+    cpuFrequencyPolicy = std::make_unique<CpuFrequencyPolicy>(frequencies);
+    Lv2Log::info(SS("CPU frequency policy: started. Minimum frequency: " << (cpuFrequencyPolicy->GetMinimumFrequency() / 1000) << " MHz."));
+    adminClient.SetCpuMinimumFrequency(cpuFrequencyPolicy->GetMinimumFrequency());
+    audioHost->TakeRecentCpuHeadroom(); // discard history.
+    ScheduleCpuFrequencyPolicyUpdate();
+}
+
+void PiPedalModel::RetainSharedResourcesForRebuild()
+{
+    // Plugin instances are replaced asynchronously, so retain until the rebuild has settled.
+    if (sharedResourceRetentionPostHandle == 0 || !CancelPost(sharedResourceRetentionPostHandle))
+    {
+        pluginHost.BeginRetainingSharedResources();
+    }
+    pluginHost.RetainPathPropertyFiles(this->pedalboard);
+    sharedResourceRetentionPostHandle = PostDelayed(
+        std::chrono::seconds(15),
+        [this]()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            sharedResourceRetentionPostHandle = 0;
+            pluginHost.EndRetainingSharedResources();
+        });
+}
+
+void PiPedalModel::ScheduleCpuFrequencyPolicyUpdate()
+{
+    cpuFrequencyPolicyPostHandle = PostDelayed(
+        std::chrono::seconds(2),
+        [this]()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            cpuFrequencyPolicyPostHandle = 0;
+            if (closed || !cpuFrequencyPolicy || !audioHost)
+            {
+                return;
+            }
+            auto decision = cpuFrequencyPolicy->Update(audioHost->TakeRecentCpuHeadroom(), audioHost->GetCpuTemperatureC());
+            if (decision.changed)
+            {
+                Lv2Log::info(SS("CPU frequency policy: " << decision.reason));
+                adminClient.SetCpuMinimumFrequency(decision.minimumFrequency);
+            }
+            else
+            {
+                Lv2Log::debug(SS("CPU frequency policy: " << decision.reason));
+            }
+            ScheduleCpuFrequencyPolicyUpdate();
+        });
+}
+
+void PiPedalModel::ScheduleIdleCheck()
+{
+    if (idleCheckPostHandle)
+    {
+        CancelPost(idleCheckPostHandle);
+    }
+    idleCheckPostHandle = PostDelayed(
+        std::chrono::seconds(30),
+        [this]()
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            idleCheckPostHandle = 0;
+            if (closed || idle || !audioHost)
+            {
+                return;
+            }
+            double timeoutSeconds = configuration.GetIdleTimeoutMinutes() * 60.0;
+            if (GetSubscribers()->empty() && audioHost->GetSecondsSinceSignal() >= timeoutSeconds)
+            {
+                EnterIdleMode();
+                return;
+            }
+            ScheduleIdleCheck();
+        });
+}
+
+void PiPedalModel::EnterIdleMode()
+{
+    idle = true;
+    audioHost->SetIdle(true);
+    if (cpuFrequencyPolicy)
+    {
+        // park at the lowest frequency, without waking up to re-evaluate it.
+        if (cpuFrequencyPolicyPostHandle)
+        {
+            CancelPost(cpuFrequencyPolicyPostHandle);
+            cpuFrequencyPolicyPostHandle = 0;
+        }
+        std::vector<uint64_t> frequencies = GetCpuFrequencies();
+        if (!frequencies.empty())
+        {
+            adminClient.SetCpuMinimumFrequency(*std::min_element(frequencies.begin(), frequencies.end()));
+        }
+    }
+}
+
+void PiPedalModel::ExitIdleMode()
+{
+    if (!idle || closed)
+    {
+        return;
+    }
+    idle = false;
+    audioHost->SetIdle(false); // (already awake if the audio thread woke up by itself.)
+    if (cpuFrequencyPolicy)
+    {
+        adminClient.SetCpuMinimumFrequency(cpuFrequencyPolicy->GetMinimumFrequency());
+        audioHost->TakeRecentCpuHeadroom(); // discard history.
+        if (!cpuFrequencyPolicyPostHandle)
+        {
+            ScheduleCpuFrequencyPolicyUpdate();
+        }
+    }
+    ScheduleIdleCheck();
+}
+
+void PiPedalModel::OnNotifyIdleWake()
+{
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    ExitIdleMode();
+}
+
+void PiPedalModel::ScheduleStorageFlush()
+{
+    // called from Storage, with the lock held.
+    if (storageFlushPostHandle)
+    {
+        return;
+    }
+    try
+    {
+        storageFlushPostHandle = PostDelayed(
+            std::chrono::seconds(configuration.GetPresetWriteDelaySeconds()),
+            [this]()
+            {
+                std::lock_guard<std::recursive_mutex> lock(mutex);
+                storageFlushPostHandle = 0;
+                try
+                {
+                    storage.FlushPendingWrites();
+                }
+                catch (const std::exception &e)
+                {
+                    Lv2Log::error(SS("Failed to save presets. " << e.what()));
+                    if (!closed)
+                    {
+                        ScheduleStorageFlush(); // retry.
+                    }
+                }
+            });
+    }
+    catch (const std::exception &)
+    {
+        // no dispatcher (yet).
+        storage.FlushPendingWrites();
+    }
+}
+
 void PiPedalModel::CancelNetworkChangingTimer()
 {
     if (networkChangingDelayHandle)
@@ -2994,6 +4968,14 @@ void PiPedalModel::CancelNetworkChangingTimer()
     }
 }
 
+void PiPedalModel::RequestWifiScan()
+{
+    if (this->hotspotManager)
+    {
+        this->hotspotManager->RequestScan();
+    }
+}
+
 std::vector<std::string> PiPedalModel::GetKnownWifiNetworks()
 {
     if (!this->hotspotManager)
@@ -3015,8 +4997,8 @@ void PiPedalModel::OnNetworkChanging(bool ethernetConnected, bool hotspotConnect
                     });
 
     // take a snapshot incase a client unsusbscribes in the notification handler (in which case the mutex won't protect us)
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
-    for (auto &subscriber : t)
+    SubscriberList t = GetSubscribers();
+    for (auto &subscriber : *t)
     {
         subscriber->OnNetworkChanging(hotspotConnected);
     }
@@ -3114,9 +5096,9 @@ void PiPedalModel::SetHasWifi(bool hasWifi)
     {
         this->hasWifi = hasWifi;
 
-        std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
+        SubscriberList t = GetSubscribers();
 
-        for (auto &subscriber : t)
+        for (auto &subscriber : *t)
         {
             subscriber->OnHasWifiChanged(hasWifi);
         }
@@ -3246,9 +5228,9 @@ void PiPedalModel::SetTone3000Auth(const std::string &apiKey)
     std::lock_guard<std::recursive_mutex> lock(mutex);
     storage.SetTone3000Auth(apiKey);
 
-    std::vector<IPiPedalModelSubscriber::ptr> t{subscribers.begin(), subscribers.end()};
+    SubscriberList t = GetSubscribers();
     bool hasAuth = apiKey != "";
-    for (auto &subscriber : t)
+    for (auto &subscriber : *t)
     {
         subscriber->OnTone3000AuthChanged(hasAuth);
     }
@@ -36,10 +36,17 @@
 #include "WifiConfigSettings.hpp"
 #include "WifiDirectConfigSettings.hpp"
 #include "AdminClient.hpp"
+#include "CpuFrequencyPolicy.hpp"
 #include <thread>
 #include "Promise.hpp"
 #include "AtomConverter.hpp"
+#include "PedalboardPreloader.hpp"
 #include "FileEntry.hpp"
+#include "PluginCostDatabase.hpp"
+#include "PedalboardPatch.hpp"
+#include "IndexPatch.hpp"
+#include "ControlHandles.hpp"
+#include "RealtimeWatchdog.hpp"
 #include <unordered_map>
 
 namespace pipedal
@@ -48,9 +55,42 @@ namespace pipedal
     struct RealtimeMidiProgramRequest;
     struct RealtimeNextMidiProgramRequest;
     class Lv2PluginChangeMonitor;
+    class AlsaHotplugMonitor;
     class Updater;
     class AvahiService;
     class Lv2PluginState;
+    class AudioFileJobQueue;
+    class PresetBundleProgress;
+
+    class ControlValueChange
+    {
+    public:
+        int64_t instanceId;
+        std::string symbol;
+        float value;
+    };
+
+    // The serialized text of a notification that is sent to every subscriber. The first
+    // subscriber that sends it encodes it; the others reuse the same text.
+    class SharedNotification
+    {
+    public:
+        SharedNotification() {}
+        SharedNotification(const SharedNotification &) = delete;
+        SharedNotification &operator=(const SharedNotification &) = delete;
+
+        // Any thread. encode is called at most once (unless it throws).
+        const std::string &GetText(const std::function<void(std::string &text)> &encode)
+        {
+            std::call_once(encoded, [&encode, this]()
+                           { encode(this->text); });
+            return text;
+        }
+
+    private:
+        std::once_flag encoded;
+        std::string text;
+    };
 
     class IPiPedalModelSubscriber
     {
@@ -66,19 +106,23 @@ namespace pipedal
         virtual void OnUpdateStatusChanged(const UpdateStatus &updateStatus) = 0;
         virtual void OnLv2StateChanged(int64_t pedalItemId, const Lv2PluginState &newState) = 0;
         virtual void OnVst3ControlChanged(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value, const std::string &state) = 0;
-        virtual void OnPedalboardChanged(int64_t clientId, const Pedalboard &pedalboard) = 0;
-        virtual void OnPresetsChanged(int64_t clientId, const PresetIndex &presets) = 0;
+        virtual void OnPedalboardChanged(int64_t clientId, const Pedalboard &pedalboard, int64_t version, SharedNotification &notification) = 0;
+        virtual void OnPedalboardPatched(const PedalboardPatch &patch, SharedNotification &notification) = 0;
+        virtual void OnPresetsChanged(int64_t clientId, const PresetIndex &presets, int64_t version, SharedNotification &notification) = 0;
+        virtual void OnPresetsPatched(const IndexPatch &patch, SharedNotification &notification) = 0;
         virtual void OnPresetChanged(bool changed) = 0;
         virtual void OnSnapshotModified(int64_t selectedSnapshot, bool modified) = 0;
         virtual void OnSelectedSnapshotChanged(int64_t selectedSnapshot) = 0;
         virtual void OnPluginPresetsChanged(const std::string &pluginUri) = 0;
         virtual void OnChannelSelectionChanged(int64_t clientId, const JackChannelSelection &channelSelection) = 0;
         virtual void OnVuMeterUpdate(const std::vector<VuUpdate> &updates) = 0;
-        virtual void OnBankIndexChanged(const BankIndex &bankIndex) = 0;
+        virtual void OnEffectTimingUpdate(const std::vector<EffectTiming> &timings) = 0;
+        virtual void OnBankIndexChanged(const BankIndex &bankIndex, int64_t version, SharedNotification &notification) = 0;
+        virtual void OnBankIndexPatched(const IndexPatch &patch, SharedNotification &notification) = 0;
         virtual void OnJackServerSettingsChanged(const JackServerSettings &jackServerSettings) = 0;
         virtual void OnJackConfigurationChanged(const JackConfiguration &jackServerConfiguration) = 0;
         virtual void OnLoadPluginPreset(int64_t instanceId, const std::vector<ControlValue> &controlValues) = 0;
-        virtual void OnMidiValueChanged(int64_t instanceId, const std::string &symbol, float value) = 0;
+        virtual void OnMidiValuesChanged(const std::vector<ControlValueChange> &changes) = 0;
         virtual void OnNotifyMidiListener(int64_t clientHandle, uint8_t cc0, uint8_t cc1, uint8_t cc2) = 0;
         virtual void OnNotifyPatchProperty(int64_t clientModel, uint64_t instanceId, const std::string &propertyUri, const std::string &atomJson) = 0;
         virtual void OnWifiConfigSettingsChanged(const WifiConfigSettings &wifiConfigSettings) = 0;
@@ -92,12 +136,15 @@ namespace pipedal
         // virtual void OnPatchPropertyChanged(int64_t clientId, int64_t instanceId,const std::string& propertyUri,const json_variant& value) = 0;
         virtual void OnErrorMessage(const std::string &message) = 0;
         virtual void OnLv2PluginsChanging() = 0;
+        virtual void OnLv2PluginsUpdated(const Lv2PluginListDelta &delta) = 0;
 
         virtual void OnNetworkChanging(bool hotspotConnected) = 0;
         virtual void OnHasWifiChanged(bool hasWifi) = 0;
         virtual void OnAlsaSequencerConfigurationChanged(const AlsaSequencerConfiguration &alsaSequencerConfiguration) = 0;
         virtual void Close() = 0;
         virtual void OnTone3000AuthChanged(bool value) = 0;
+        virtual void OnAudioFilesChanged(const std::string &directory) = 0;
+        virtual void OnPresetBundleProgress(const PresetBundleProgress &progress) = 0;
 
     };
 
@@ -120,6 +167,41 @@ namespace pipedal
         int audioRestartRetries = 0;
         PostHandle audioRetryPostHandle = 0;
 
+        // Bank and bank index writes are coalesced, and flushed after a delay.
+        void ScheduleStorageFlush();
+        PostHandle storageFlushPostHandle = 0;
+
+        // Plugin state changed notifications are debounced per instance, and the state is captured on a
+        // background thread, so that plugins that notify on every parameter change don't cause a full
+        // state serialization (on the model thread) for each one.
+        struct PendingLv2StateCapture
+        {
+            PostHandle postHandle = 0;
+            clock::time_point firstRequestTime;
+            bool explicitChange = false; // the plugin sent a state changed notification (which dirties the preset).
+        };
+        std::map<uint64_t, PendingLv2StateCapture> pendingLv2StateCaptures; // by instance id.
+        void ScheduleLv2StateCapture(uint64_t instanceId, bool explicitChange);
+        void CaptureLv2State(uint64_t instanceId);
+
+        // Closed-loop minimum CPU frequency for the "auto" governor setting.
+        void UpdateCpuFrequencyPolicy(const std::string &governor);
+        void ScheduleCpuFrequencyPolicyUpdate();
+        std::unique_ptr<CpuFrequencyPolicy> cpuFrequencyPolicy;
+        PostHandle cpuFrequencyPolicyPostHandle = 0;
+
+        // Idle power mode (see PiPedalConfiguration::GetIdleTimeoutMinutes).
+        void ScheduleIdleCheck();
+        void EnterIdleMode();
+        void ExitIdleMode();
+        bool idle = false;
+        PostHandle idleCheckPostHandle = 0;
+
+        // Keeps model and IR files mapped (and data decoded through the shared resource extension cached)
+        // while the pedalboard is rebuilt for a new audio configuration.
+        void RetainSharedResourcesForRebuild();
+        PostHandle sharedResourceRetentionPostHandle = 0;
+
         bool hasWifi = false;
 
         void SetHasWifi(bool hasWifi);
@@ -131,9 +213,39 @@ namespace pipedal
         std::function<void(void)> restartListener;
 
         std::unique_ptr<Lv2PluginChangeMonitor> pluginChangeMonitor;
+        std::unique_ptr<AlsaHotplugMonitor> alsaHotplugMonitor;
 
         std::unique_ptr<std::jthread> pingThread;
 
+        std::unique_ptr<std::jthread> latencyMeasurementThread;
+        bool latencyMeasurementRunning = false;
+        bool pmuProfiling = false;
+        bool denormalDetection = false;
+        std::map<int64_t, std::chrono::steady_clock::time_point> lastDenormalWarnings; // by instanceId.
+        void WarnDenormals(const std::vector<EffectTiming> &timings);
+        void OnEffectHung(const RealtimeWatchdog::HungEffect &hungEffect);
+        void DisableAndHardBypassItem(int64_t instanceId);
+        // Items hard-bypassed by DisableAndHardBypassItem() -> their own hardBypass setting, which is restored when the
+        // item is re-enabled, and which is the one that's saved. By instanceId; cleared when another preset is loaded.
+        std::map<int64_t, bool> shedItemHardBypass;
+        void RestoreShedItemHardBypass(Pedalboard &pedalboard);
+        void LatencyMeasurementThreadProc(
+            std::stop_token stopToken,
+            int64_t clientId,
+            LatencyMeasurement measurement,
+            std::function<void(const LatencyMeasurement &)> onSuccess,
+            std::function<void(const std::string &)> onError);
+
+        std::unique_ptr<std::jthread> bankSyncThread;
+        bool bankSyncRunning = false;
+        void BankSyncThreadProc(
+            std::stop_token stopToken,
+            int64_t clientId,
+            std::string peer,
+            std::function<void(const BankSyncResult &)> onSuccess,
+            std::function<void(const std::string &)> onError);
+        void SyncMediaFile(BankSyncClient &client, const BankSyncMedia &media, BankSyncResult *result);
+
         std::vector<MidiBinding> systemMidiBindings;
 
         std::unique_ptr<AvahiService> avahiService;
@@ -190,18 +302,79 @@ namespace pipedal
             }
         }
 
+        RealtimePatchPropertyRequestPool patchPropertyRequestPool; // must outlive audioHost.
         std::unique_ptr<AudioHost> audioHost;
+        std::unique_ptr<PedalboardPreloader> pedalboardPreloader; // null if preloading is disabled.
+        // direction of the most recent next/previous navigation, which is the most likely direction of the next one.
+        bool lastPresetNavigationBackward = false;
+        bool lastBankNavigationBackward = false;
+        std::shared_ptr<AudioFileJobQueue> audioFileJobQueue;
+        std::shared_ptr<const std::string> uiPluginsJson;
+        std::shared_ptr<const std::string> uiPluginsJsonGz;
+        std::string uiPluginsVersion;
+        std::shared_ptr<const std::string> pluginClassesJson;
         JackConfiguration jackConfiguration;
+        std::shared_ptr<PluginCostDatabase> pluginCostDatabase;
+        std::chrono::steady_clock::time_point lastPluginCostSave;
+        void RecordPluginCosts(const std::vector<EffectTiming> &timings);
+        // Record memory footprints of newly created plugin instances.
+        void RecordPluginMemory(Lv2Pedalboard &lv2Pedalboard);
+        PresetLoadEstimate EstimatePedalboardLoad(Pedalboard &pedalboard);
         std::shared_ptr<Lv2Pedalboard> lv2Pedalboard;
         std::filesystem::path webRoot;
 
-        std::vector<std::shared_ptr<IPiPedalModelSubscriber>> subscribers;
+        // Incremented each time clients are sent a pedalboard change. Clients apply a
+        // PedalboardPatch only if their copy is at the patch's base version.
+        int64_t pedalboardVersion = 0;
+        bool hasBroadcastPedalboard = false;
+        Pedalboard broadcastPedalboard; // deep copy of the pedalboard as of pedalboardVersion.
+
+        // The same for the preset index and the bank index, which clients update with IndexPatches.
+        int64_t presetIndexVersion = 0;
+        bool hasBroadcastPresets = false;
+        PresetIndex broadcastPresets;
+        int64_t bankIndexVersion = 0;
+        bool hasBroadcastBanks = false;
+        BankIndex broadcastBanks;
+
+        // Rebuilt each time pedalboardVersion changes. Has its own lock, so that handles can be
+        // resolved without the model mutex.
+        mutable std::mutex controlHandlesMutex;
+        std::shared_ptr<const ControlHandleTable> controlHandleTable;
+        ControlHandleAllocator controlHandleAllocator;
+        int64_t controlHandleEpochVersion = 0;
+        std::shared_ptr<const ControlHandleTable> GetControlHandleTable() const;
+
+        // Subscribers have their own lock, and are published as immutable snapshots, so that
+        // notifications can be sent without holding (or waiting for) the model mutex.
+        using SubscriberList = std::shared_ptr<const std::vector<std::shared_ptr<IPiPedalModelSubscriber>>>;
+        mutable std::mutex subscribersMutex;
+        SubscriberList subscribers = std::make_shared<const std::vector<std::shared_ptr<IPiPedalModelSubscriber>>>();
+        SubscriberList GetSubscribers() const;
+
+        // Control changes received while the model mutex was held by a slow operation.
+        struct PendingControlChange
+        {
+            int64_t clientId;
+            int64_t pedalItemId;
+            std::string symbol;
+            float value;
+        };
+        std::mutex pendingControlChangesMutex;
+        std::vector<PendingControlChange> pendingControlChanges;
+        // model mutex must be held.
+        void ApplyPendingControlChanges();
+        void ApplyControlChange(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value,
+                                const ControlHandleTable *handleTable = nullptr, const ControlHandleTable::Entry *handle = nullptr);
+        void PreviewControl(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value,
+                            const ControlHandleTable *handleTable, const ControlHandleTable::Entry *handle);
         void SetPresetChanged(int64_t clientId, bool value, bool changeSnapshotSelect = true);
         void FireSnapshotModified(int64_t snapshotIndex, bool modified);
         void FireSelectedSnapshotChanged(int64_t selectedSnapshot);
         void FirePresetsChanged(int64_t clientId);
         void FirePresetChanged(bool changed);
         void FirePluginPresetsChanged(const std::string &pluginUri);
+        void FireAudioFilesChanged(const std::filesystem::path &directory);
         void FirePedalboardChanged(int64_t clientId, bool reloadAudioThread = true);
         void FireChannelSelectionChanged(int64_t clientId);
         void FireBanksChanged(int64_t clientId);
@@ -216,18 +389,30 @@ namespace pipedal
         public:
             int64_t subscriptionHandle;
             int64_t instanceid;
+            float updatesPerSecond; // 0: the client isn't watching.
         };
         int64_t nextSubscriptionId = 1;
         std::vector<VuSubscription> activeVuSubscriptions;
+        std::vector<int64_t> activeEffectTimingSubscriptions;
 
         std::vector<MonitorPortSubscription> activeMonitorPortSubscriptions;
 
         void UpdateRealtimeVuSubscriptions();
+        void UpdateRealtimeEffectTimingSubscriptions();
+        void UpdateRealtimeAtomOutputSubscriptions();
+        void UpdatePresetPreloads();
+        void UpdatePluginCatalog();
         void UpdateRealtimeMonitorPortSubscriptions();
 
         void RestartAudio(bool useDummyAudioDriver = false);
 
+        // The selected channels that no pedalboard slot claims. (All of them, if the slots leave the main pedalboard none.)
+        JackChannelSelection GetMainChannelSelection(const JackChannelSelection &channelSelection);
+        // Build the additional slots' pedalboards, and send them to the audio host.
+        void LoadPedalboardSlots();
+
         std::vector<RealtimePatchPropertyRequest *> outstandingParameterRequests;
+        void OnPatchPropertyRequestComplete(RealtimePatchPropertyRequest *pParameter);
 
         IPiPedalModelSubscriber *GetNotificationSubscriber(int64_t clientId);
         std::atomic<bool> closed = false;
@@ -236,13 +421,16 @@ namespace pipedal
         virtual void OnNotifyLv2StateChanged(uint64_t instanceId) override;
         virtual void OnNotifyMaybeLv2StateChanged(uint64_t instanceId) override;
         virtual void OnNotifyVusSubscription(const std::vector<VuUpdate> &updates) override;
+        virtual void OnNotifyEffectTimings(const std::vector<EffectTiming> &timings) override;
+        virtual void OnNotifyOverload(const std::vector<EffectTiming> &timings) override;
         virtual void OnNotifyMonitorPort(const MonitorPortUpdate &update) override;
-        virtual void OnNotifyMidiValueChanged(int64_t instanceId, int portIndex, float value) override;
+        virtual void OnNotifyMidiValuesChanged(const std::vector<MidiValueChange> &changes) override;
         virtual void OnNotifyMidiListen(uint8_t cc0, uint8_t cc1, uint8_t cc2) override;
         virtual void OnPatchSetReply(uint64_t instanceId, LV2_URID patchSetProperty, const LV2_Atom *atomValue) override;
         virtual void OnNotifyMidiRealtimeEvent(RealtimeMidiEventType eventType) override;
         virtual void OnNotifyMidiRealtimeSnapshotRequest(int32_t snapshotIndex,int64_t snapshotRequestId) override;
         virtual void OnAlsaDriverTerminatedAbnormally() override;
+        virtual void OnNotifyIdleWake() override;
         virtual void OnAlsaSequencerDeviceAdded(int client, const std::string &clientName) override;
         virtual void OnAlsaSequencerDeviceRemoved(int client) override;
 
@@ -274,6 +462,8 @@ namespace pipedal
         PiPedalModel();
         virtual ~PiPedalModel();
 
+        void FirePresetBundleProgress(const PresetBundleProgress &progress);
+
         enum class Direction
         {
             Increase,
@@ -303,13 +493,18 @@ namespace pipedal
         }
 
         std::shared_ptr<Lv2PluginInfo> GetPluginInfo(const std::string &uri);
+        ModGui::ptr GetModGui(const std::string &uri);
 
         void SetNetworkChangedListener(NetworkChangedListener listener)
         {
             networkChangedListener = listener;
         }
 
+        // Avahi and hotspot monitoring. Deferred until audio and the web server are up; safe to call
+        // from a background thread.
         void StartHotspotMonitoring();
+        // Starts background update checks.
+        void StartUpdater();
 
         void WaitForAudioDeviceToComeOnline();
 
@@ -321,7 +516,8 @@ namespace pipedal
         void Close();
 
         void SetRestartListener(std::function<void(void)> &&listener);
-        void OnLv2PluginsChanged();
+        // Called by the plugin change monitor with the paths of bundles that were added, removed or modified.
+        void OnLv2PluginsChanged(const std::vector<std::string> &bundlePaths);
         void SetOnboarding(bool value);
         std::map<std::string,std::string> GetWifiRegulatoryDomains();
 
@@ -342,6 +538,27 @@ namespace pipedal
             std::lock_guard<std::recursive_mutex> guard(mutex);
             return pedalboard; // can return a referece because we'd lose  mutex protection
         }
+        Pedalboard GetCurrentPedalboardCopy(int64_t *version)
+        {
+            std::lock_guard<std::recursive_mutex> guard(mutex);
+            *version = pedalboardVersion;
+            return pedalboard;
+        }
+        // Serialized once, and shared by all connections until the plugin list changes.
+        std::shared_ptr<const std::string> GetUiPluginsJson();
+
+        // The plugin catalog, as served over HTTP. The version is a hash of the content, so
+        // it changes only when the plugin list does.
+        struct PluginCatalog
+        {
+            std::shared_ptr<const std::string> json;
+            std::shared_ptr<const std::string> gzipJson; // null if compression failed.
+            std::string version;
+        };
+        PluginCatalog GetPluginCatalog();
+        std::string GetPluginCatalogVersion();
+        PluginSearchResult SearchPlugins(const PluginSearchRequest &request);
+        std::shared_ptr<const std::string> GetPluginClassesJson();
         PluginUiPresets GetPluginUiPresets(const std::string &pluginUri);
         PluginPresets GetPluginPresets(const std::string &pluginUri);
 
@@ -352,9 +569,19 @@ namespace pipedal
 
         void SetPedalboardItemEnable(int64_t clientId, int64_t instanceId, bool enabled);
         void SetPedalboardItemUseModUi(int64_t clientId, int64_t instanceId, bool enabled);
+        void SetPedalboardItemHardBypass(int64_t clientId, int64_t instanceId, bool enabled);
+        void SetPedalboardItemEssential(int64_t clientId, int64_t instanceId, bool essential);
+        void SetPedalboardItemAlwaysRun(int64_t clientId, int64_t instanceId, bool alwaysRun);
         void SetControl(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value);
         void PreviewControl(int64_t clientId, int64_t pedalItemId, const std::string &symbol, float value);
 
+        // Numeric handles for (instanceId, symbol) pairs of the current pedalboard.
+        ControlHandles GetControlHandles();
+        // As SetControl/PreviewControl, but without symbol lookups. Ignored if the handle is no longer
+        // valid (see ControlHandles).
+        void SetControlByHandle(int64_t clientId, int64_t version, int32_t handle, float value);
+        void PreviewControlByHandle(int64_t clientId, int64_t version, int32_t handle, float value);
+
         void SetInputVolume(float value);
         void SetOutputVolume(float value);
         void PreviewInputVolume(float value);
@@ -370,6 +597,7 @@ namespace pipedal
         void SetSnapshot(int64_t selectedSnapshot);
 
         void GetPresets(PresetIndex *pResult);
+        void GetPresets(PresetIndex *pResult, int64_t *version);
 
         Pedalboard GetPreset(int64_t instanceId);
         void GetBank(int64_t instanceId, BankFile *pBank);
@@ -400,6 +628,12 @@ namespace pipedal
         void SetJackChannelSelection(int64_t clientId, const JackChannelSelection &channelSelection);
         JackChannelSelection GetJackChannelSelection();
 
+        // Additional pedalboards, on their own channels and cores (e.g. for a second player).
+        PedalboardSlots GetPedalboardSlots();
+        // Restarts audio, since the main pedalboard's channels change.
+        void SetPedalboardSlots(const PedalboardSlots &pedalboardSlots);
+        void SetPedalboardSlotPreset(size_t slot, int64_t bankId, int64_t presetId);
+
         void SetAlsaSequencerConfiguration(const AlsaSequencerConfiguration &alsaSequencerConfiguration);
         AlsaSequencerConfiguration GetAlsaSequencerConfiguration();
 
@@ -411,6 +645,8 @@ namespace pipedal
         void SetWifiConfigSettings(const WifiConfigSettings &wifiConfigSettings);
         WifiConfigSettings GetWifiConfigSettings();
         std::vector<std::string> GetKnownWifiNetworks();
+        // Scans for Wi-Fi networks even if audio is running.
+        void RequestWifiScan();
 
         void SetWifiDirectConfigSettings(const WifiDirectConfigSettings &wifiConfigSettings);
         WifiDirectConfigSettings GetWifiDirectConfigSettings();
@@ -418,13 +654,27 @@ namespace pipedal
         void SetGovernorSettings(const std::string &governor);
         GovernorSettings GetGovernorSettings();
 
-        int64_t AddVuSubscription(int64_t instanceId);
+        int64_t AddVuSubscription(int64_t instanceId, float updatesPerSecond = MAX_VU_UPDATES_PER_SECOND);
         void RemoveVuSubscription(int64_t subscriptionHandle);
+        // Clients that are hidden set a rate of 0. Each instance is updated at the fastest rate of its subscriptions.
+        void SetVuSubscriptionRates(const std::vector<int64_t> &subscriptionHandles, float updatesPerSecond);
+
+        // Per-effect execution times, sent to subscribers about once a second.
+        int64_t AddEffectTimingSubscription();
+        void RemoveEffectTimingSubscription(int64_t subscriptionHandle);
+        // Add hardware counter results (IPC, cache and branch miss rates) to effect timings for the current pedalboard.
+        void SetPmuProfiling(bool enabled);
+        // Report how often each effect's output contains subnormal values, in effect timings and the log.
+        void SetDenormalDetection(bool enabled);
+
+        // Estimated plugin costs at the current sample rate and block size, from measured effect timings.
+        std::vector<PluginCostEstimate> GetPluginCostEstimates();
+        PresetLoadEstimate EstimatePresetLoad(int64_t presetId);
 
         void SetSystemMidiBindings(std::vector<MidiBinding> &bindings);
         std::vector<MidiBinding> GetSystemMidiBidings();
 
-        int64_t MonitorPort(int64_t instanceId, const std::string &key, float updateInterval, PortMonitorCallback onUpdate);
+        int64_t MonitorPort(int64_t instanceId, const std::string &key, float updateInterval, PortMonitorCallback onUpdate, float epsilon = 0);
         void UnmonitorPort(int64_t subscriptionHandle);
 
         void SendGetPatchProperty(
@@ -443,14 +693,50 @@ namespace pipedal
             std::function<void(const std::string &error)> onError);
 
         BankIndex GetBankIndex() const;
+        BankIndex GetBankIndex(int64_t *version);
         void RenameBank(int64_t clientId, int64_t bankId, const std::string &newName);
         int64_t SaveBankAs(int64_t clientId, int64_t bankId, const std::string &newName);
         void OpenBank(int64_t clientId, int64_t bankId);
 
         JackHostStatus GetJackStatus()
         {
-            return this->audioHost->getJackStatus();
+            JackHostStatus status = this->audioHost->getJackStatus();
+            status.pluginMemory_ = GetPluginMemoryFootprints();
+            return status;
+        }
+        // Memory footprints of the plugins in the current pedalboard.
+        std::vector<PluginMemoryFootprint> GetPluginMemoryFootprints();
+        std::vector<AudioPeriodTraceEntry> GetAudioPeriodTrace(double seconds)
+        {
+            return this->audioHost->GetAudioPeriodTrace(seconds);
+        }
+        void ResetCpuUseStatistics()
+        {
+            this->audioHost->ResetCpuUseStatistics();
         }
+        // Record the pedalboard's input (DI) and output to the Recordings directory. Returns the file name of
+        // the recording, without the -input.wav/-output.wav suffix.
+        std::string StartRecording();
+        void StopRecording();
+        // Measures round-trip latency of the current audio configuration through a loopback cable,
+        // then runs the current preset for stressSeconds, counting xruns. The result is stored.
+        void MeasureLatency(
+            int64_t clientId, int inputChannel, int outputChannel, float stressSeconds,
+            std::function<void(const LatencyMeasurement &)> onSuccess,
+            std::function<void(const std::string &)> onError);
+        // Stored measurements; the recommended configuration for the current devices is marked.
+        std::vector<LatencyMeasurement> GetLatencyMeasurements();
+
+        // Bank sync between PiPedal servers (see BankSync.hpp).
+        BankSyncManifest GetBankSyncManifest();
+        Pedalboard GetBankSyncPreset(const std::string &bankName, const std::string &presetName);
+        // The media file with the given content hash, or an empty path.
+        std::filesystem::path GetBankSyncMediaFile(const std::string &hash);
+        // Update banks from another PiPedal server, transferring only changed presets and missing media files.
+        void SyncBanksFrom(
+            int64_t clientId, const std::string &peer,
+            std::function<void(const BankSyncResult &)> onSuccess,
+            std::function<void(const std::string &)> onError);
         JackServerSettings GetJackServerSettings();
         void SetJackServerSettings(const JackServerSettings &jackServerSettings);
 
@@ -467,7 +753,7 @@ namespace pipedal
         void SetFavorites(const std::map<std::string, bool> &favorites);
         void SetUpdatePolicy(UpdatePolicyT updatePolicy);
         void ForceUpdateCheck();
-        FileRequestResult GetFileList2(const std::string &relativePath, const UiFileProperty &fileProperty);
+        FileRequestResult GetFileList2(const std::string &relativePath, const UiFileProperty &fileProperty, const std::string &sortKey = "");
 
         void DeleteSampleFile(const std::filesystem::path &fileName);
         std::string CreateNewSampleDirectory(const std::string &relativePath, const UiFileProperty &uiFileProperty);
@@ -478,6 +764,7 @@ namespace pipedal
         bool IsInUploadsDirectory(const std::string &path);
 
         std::string UploadUserFile(const std::string &directory, int64_t instanceId, const std::string &patchProperty, const std::string &filename, std::istream &inputStream, size_t streamLength);
+        std::string UploadUserFile(const std::string &directory, int64_t instanceId, const std::string &patchProperty, const std::string &filename, const std::filesystem::path &sourceFile, size_t streamLength);
         uint64_t CreateNewPreset();
 
         bool LoadCurrentPedalboard();
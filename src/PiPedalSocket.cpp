@@ -32,6 +32,8 @@
 #include <atomic>
 #include "Ipv6Helpers.hpp"
 #include "Promise.hpp"
+#include "ThreadPool.hpp"
+#include "Task.hpp"
 #include <mutex>
 
 #include "AdminClient.hpp"
@@ -42,6 +44,15 @@
 #include "PiPedalAlsa.hpp"
 #include <filesystem>
 #include "FileEntry.hpp"
+#include "BinaryTelemetry.hpp"
+#include "PresetBundle.hpp"
+#include "SocketMessageDispatcher.hpp"
+#include "Lv2StateBlobStore.hpp"
+#include "Tracer.hpp"
+#include "CacheRegistry.hpp"
+#include "SessionReplayLog.hpp"
+#include <random>
+#include <unordered_map>
 
 using namespace std;
 using namespace pipedal;
@@ -309,6 +320,36 @@ JSON_MAP_REFERENCE(LoadPluginPresetBody, pluginInstanceId)
 JSON_MAP_REFERENCE(LoadPluginPresetBody, presetInstanceId)
 JSON_MAP_END()
 
+class SetPedalboardSlotPresetBody
+{
+public:
+    int64_t slot_ = -1;
+    int64_t bankId_ = -1;
+    int64_t presetId_ = -1;
+    DECLARE_JSON_MAP(SetPedalboardSlotPresetBody);
+};
+
+JSON_MAP_BEGIN(SetPedalboardSlotPresetBody)
+JSON_MAP_REFERENCE(SetPedalboardSlotPresetBody, slot)
+JSON_MAP_REFERENCE(SetPedalboardSlotPresetBody, bankId)
+JSON_MAP_REFERENCE(SetPedalboardSlotPresetBody, presetId)
+JSON_MAP_END()
+
+class MeasureLatencyBody
+{
+public:
+    int32_t inputChannel_ = 0;
+    int32_t outputChannel_ = 0;
+    float stressSeconds_ = 10;
+    DECLARE_JSON_MAP(MeasureLatencyBody);
+};
+
+JSON_MAP_BEGIN(MeasureLatencyBody)
+JSON_MAP_REFERENCE(MeasureLatencyBody, inputChannel)
+JSON_MAP_REFERENCE(MeasureLatencyBody, outputChannel)
+JSON_MAP_REFERENCE(MeasureLatencyBody, stressSeconds)
+JSON_MAP_END()
+
 class FromToBody
 {
 public:
@@ -323,6 +364,38 @@ JSON_MAP_REFERENCE(FromToBody, from)
 JSON_MAP_REFERENCE(FromToBody, to)
 JSON_MAP_END()
 
+class HelloBody
+{
+public:
+    std::string sessionToken_;
+    int64_t lastSequence_ = 0;
+
+    DECLARE_JSON_MAP(HelloBody);
+};
+
+JSON_MAP_BEGIN(HelloBody)
+JSON_MAP_REFERENCE(HelloBody, sessionToken)
+JSON_MAP_REFERENCE(HelloBody, lastSequence)
+JSON_MAP_END()
+
+class HelloReply
+{
+public:
+    int64_t clientId_ = -1;
+    std::string sessionToken_;
+    int64_t sequence_ = 0; // of the last event sent before this reply.
+    bool resumed_ = false;
+
+    DECLARE_JSON_MAP(HelloReply);
+};
+
+JSON_MAP_BEGIN(HelloReply)
+JSON_MAP_REFERENCE(HelloReply, clientId)
+JSON_MAP_REFERENCE(HelloReply, sessionToken)
+JSON_MAP_REFERENCE(HelloReply, sequence)
+JSON_MAP_REFERENCE(HelloReply, resumed)
+JSON_MAP_END()
+
 class MonitorResultBody
 {
 public:
@@ -341,12 +414,18 @@ class FileRequestArgs
 public:
     std::string relativePath_;
     UiFileProperty fileProperty_;
+    std::string sortKey_;
+    uint64_t pageSize_ = 0; // 0: all files.
+    std::string continuationToken_;
 
     DECLARE_JSON_MAP(FileRequestArgs);
 };
 JSON_MAP_BEGIN(FileRequestArgs)
 JSON_MAP_REFERENCE(FileRequestArgs, relativePath)
 JSON_MAP_REFERENCE(FileRequestArgs, fileProperty)
+JSON_MAP_REFERENCE(FileRequestArgs, sortKey)
+JSON_MAP_REFERENCE(FileRequestArgs, pageSize)
+JSON_MAP_REFERENCE(FileRequestArgs, continuationToken)
 JSON_MAP_END()
 
 class MonitorPortBody
@@ -355,6 +434,7 @@ public:
     int64_t instanceId_ = -1;
     std::string key_;
     float_t updateRate_ = 0;
+    float_t epsilon_ = 0;
 
     DECLARE_JSON_MAP(MonitorPortBody);
 };
@@ -362,6 +442,20 @@ JSON_MAP_BEGIN(MonitorPortBody)
 JSON_MAP_REFERENCE(MonitorPortBody, instanceId)
 JSON_MAP_REFERENCE(MonitorPortBody, key)
 JSON_MAP_REFERENCE(MonitorPortBody, updateRate)
+JSON_MAP_REFERENCE(MonitorPortBody, epsilon)
+JSON_MAP_END()
+
+class TelemetryRateBody
+{
+public:
+    bool visible_ = true;
+    float vuUpdatesPerSecond_ = MAX_VU_UPDATES_PER_SECOND;
+
+    DECLARE_JSON_MAP(TelemetryRateBody);
+};
+JSON_MAP_BEGIN(TelemetryRateBody)
+JSON_MAP_REFERENCE(TelemetryRateBody, visible)
+JSON_MAP_REFERENCE(TelemetryRateBody, vuUpdatesPerSecond)
 JSON_MAP_END()
 
 class SaveCurrentPresetAsBody
@@ -479,12 +573,58 @@ JSON_MAP_REFERENCE(PedalboardItemUseModGuiBody, instanceId)
 JSON_MAP_REFERENCE(PedalboardItemUseModGuiBody, useModUi)
 JSON_MAP_END()
 
+class PedalboardItemHardBypassBody
+{
+public:
+    int64_t clientId_ = -1;
+    int64_t instanceId_ = -1;
+    bool hardBypass_ = false;
+
+    DECLARE_JSON_MAP(PedalboardItemHardBypassBody);
+};
+JSON_MAP_BEGIN(PedalboardItemHardBypassBody)
+JSON_MAP_REFERENCE(PedalboardItemHardBypassBody, clientId)
+JSON_MAP_REFERENCE(PedalboardItemHardBypassBody, instanceId)
+JSON_MAP_REFERENCE(PedalboardItemHardBypassBody, hardBypass)
+JSON_MAP_END()
+
+class PedalboardItemEssentialBody
+{
+public:
+    int64_t clientId_ = -1;
+    int64_t instanceId_ = -1;
+    bool essential_ = false;
+
+    DECLARE_JSON_MAP(PedalboardItemEssentialBody);
+};
+JSON_MAP_BEGIN(PedalboardItemEssentialBody)
+JSON_MAP_REFERENCE(PedalboardItemEssentialBody, clientId)
+JSON_MAP_REFERENCE(PedalboardItemEssentialBody, instanceId)
+JSON_MAP_REFERENCE(PedalboardItemEssentialBody, essential)
+JSON_MAP_END()
+
+class PedalboardItemAlwaysRunBody
+{
+public:
+    int64_t clientId_ = -1;
+    int64_t instanceId_ = -1;
+    bool alwaysRun_ = false;
+
+    DECLARE_JSON_MAP(PedalboardItemAlwaysRunBody);
+};
+JSON_MAP_BEGIN(PedalboardItemAlwaysRunBody)
+JSON_MAP_REFERENCE(PedalboardItemAlwaysRunBody, clientId)
+JSON_MAP_REFERENCE(PedalboardItemAlwaysRunBody, instanceId)
+JSON_MAP_REFERENCE(PedalboardItemAlwaysRunBody, alwaysRun)
+JSON_MAP_END()
+
 
 class UpdateCurrentPedalboardBody
 {
 public:
     int64_t clientId_ = -1;
     Pedalboard pedalboard_;
+    int64_t version_ = -1;
 
     DECLARE_JSON_MAP(UpdateCurrentPedalboardBody);
 };
@@ -492,6 +632,7 @@ public:
 JSON_MAP_BEGIN(UpdateCurrentPedalboardBody)
 JSON_MAP_REFERENCE(UpdateCurrentPedalboardBody, clientId)
 JSON_MAP_REFERENCE(UpdateCurrentPedalboardBody, pedalboard)
+JSON_MAP_REFERENCE(UpdateCurrentPedalboardBody, version)
 JSON_MAP_END()
 
 class SetSnapshotsBody
@@ -554,15 +695,30 @@ class PresetsChangedBody
 {
 public:
     int64_t clientId_ = -1;
+    int64_t version_ = 0;
     PresetIndex *presets_ = nullptr;
 
     DECLARE_JSON_MAP(PresetsChangedBody);
 };
 JSON_MAP_BEGIN(PresetsChangedBody)
 JSON_MAP_REFERENCE(PresetsChangedBody, clientId)
+JSON_MAP_REFERENCE(PresetsChangedBody, version)
 JSON_MAP_REFERENCE(PresetsChangedBody, presets)
 JSON_MAP_END()
 
+class BanksChangedBody
+{
+public:
+    int64_t version_ = 0;
+    BankIndex *banks_ = nullptr;
+
+    DECLARE_JSON_MAP(BanksChangedBody);
+};
+JSON_MAP_BEGIN(BanksChangedBody)
+JSON_MAP_REFERENCE(BanksChangedBody, version)
+JSON_MAP_REFERENCE(BanksChangedBody, banks)
+JSON_MAP_END()
+
 class ControlChangedBody
 {
 public:
@@ -581,6 +737,24 @@ JSON_MAP_REFERENCE(ControlChangedBody, symbol)
 JSON_MAP_REFERENCE(ControlChangedBody, value)
 JSON_MAP_END()
 
+class ControlHandleValueBody
+{
+public:
+    int64_t clientId_;
+    int64_t version_;
+    int32_t handle_;
+    float value_;
+
+    DECLARE_JSON_MAP(ControlHandleValueBody);
+};
+
+JSON_MAP_BEGIN(ControlHandleValueBody)
+JSON_MAP_REFERENCE(ControlHandleValueBody, clientId)
+JSON_MAP_REFERENCE(ControlHandleValueBody, version)
+JSON_MAP_REFERENCE(ControlHandleValueBody, handle)
+JSON_MAP_REFERENCE(ControlHandleValueBody, value)
+JSON_MAP_END()
+
 class PatchPropertyChangedBody
 {
 public:
@@ -618,6 +792,42 @@ JSON_MAP_REFERENCE(Vst3ControlChangedBody, value)
 JSON_MAP_REFERENCE(Vst3ControlChangedBody, state)
 JSON_MAP_END()
 
+class PiPedalSocketHandler;
+
+// How long a session whose connection has closed waits for its client to reconnect.
+static constexpr std::chrono::seconds SESSION_RESUME_TIMEOUT{120};
+
+// Websocket sessions that a reconnecting client can resume (see PiPedalSocketHandler::HandleHello).
+class PiPedalSessionRegistry : public std::enable_shared_from_this<PiPedalSessionRegistry>
+{
+public:
+    PiPedalSessionRegistry(PiPedalModel &model)
+        : model(model)
+    {
+    }
+    // Returns the session's token.
+    std::string Add(const std::shared_ptr<PiPedalSocketHandler> &session);
+    void Remove(const std::string &token);
+    // Keeps a session whose connection has closed alive until it is resumed, or times out.
+    void Detach(const std::string &token, std::shared_ptr<PiPedalSocketHandler> session);
+    std::shared_ptr<PiPedalSocketHandler> Resume(const std::string &token);
+
+private:
+    void Expire(const std::string &token, uint64_t detachId);
+
+    struct DetachedSession
+    {
+        std::shared_ptr<PiPedalSocketHandler> session;
+        uint64_t detachId;
+    };
+    PiPedalModel &model;
+    std::mutex mutex;
+    std::mt19937_64 random{std::random_device{}()};
+    uint64_t nextDetachId = 0;
+    std::unordered_map<std::string, std::weak_ptr<PiPedalSocketHandler>> sessions;
+    std::unordered_map<std::string, DetachedSession> detachedSessions;
+};
+
 class PiPedalSocketHandler : public SocketHandler, public IPiPedalModelSubscriber, public std::enable_shared_from_this<PiPedalSocketHandler>
 {
 private:
@@ -627,7 +837,11 @@ private:
     }
 
     std::recursive_mutex writeMutex;
+    // Reused for every outbound message, so that serialization doesn't allocate once the buffer has grown. Guarded by writeMutex.
+    std::string outputBuffer;
     PiPedalModel &model;
+    // Async requests that modify state run here, in the order in which they were received.
+    SerialExecutor::ptr orderedRequests = SerialExecutor::Create(ThreadPool::Shared());
     static std::atomic<uint64_t> nextClientId;
     std::string imageList;
 
@@ -640,6 +854,15 @@ private:
         int64_t instanceId;
     };
     std::vector<VuSubscription> activeVuSubscriptions;
+    std::vector<int64_t> activeEffectTimingSubscriptions;
+    // As declared by the client. Hidden clients don't receive VU updates.
+    bool clientVisible = true;
+    float clientVuUpdatesPerSecond = MAX_VU_UPDATES_PER_SECOND;
+
+    float GetEffectiveVuUpdatesPerSecond()
+    {
+        return clientVisible ? clientVuUpdatesPerSecond : 0;
+    }
 
     struct PortMonitorSubscription
     {
@@ -683,6 +906,18 @@ private:
     std::mutex activePortMonitorsMutex;
     std::vector<std::shared_ptr<PortMonitorSubscription>> activePortMonitors;
     std::atomic<bool> closed = false;
+    // Set once the client has fetched the plugin list. Only those clients need plugin list updates.
+    std::atomic<bool> hasPluginList = false;
+    // Set when the client has asked for VU and monitor port output as binary frames (see BinaryTelemetry.hpp).
+    std::atomic<bool> binaryTelemetry = false;
+
+    // Resumable sessions. A client that reconnects presents its session token and the sequence number of the
+    // last event it received; the session moves to the new connection, and sends only the events that were missed.
+    std::shared_ptr<PiPedalSessionRegistry> sessionRegistry;
+    std::string sessionToken;
+    SessionReplayLog replayLog;                  // guarded by writeMutex.
+    SocketHandler *attachedConnection = nullptr; // the newer connection this session was resumed on. Guarded by writeMutex.
+    std::shared_ptr<PiPedalSocketHandler> resumedSession; // the session that this connection resumed.
 
 public:
     virtual int64_t GetClientId() { return clientId; }
@@ -702,16 +937,12 @@ public:
             return;
         finalCleanup = true;
         // avoid use after free.
-        for (int i = 0; i < this->activePortMonitors.size(); ++i)
-        {
-            model.UnmonitorPort(activePortMonitors[i]->subscriptionHandle);
-        }
-        activePortMonitors.resize(0);
-        for (int i = 0; i < this->activeVuSubscriptions.size(); ++i)
+        RemovePortMonitors();
+        RemoveTelemetrySubscriptions();
+        if (!sessionToken.empty())
         {
-            model.RemoveVuSubscription(activeVuSubscriptions[i].subscriptionHandle);
+            sessionRegistry->Remove(sessionToken);
         }
-        activeVuSubscriptions.resize(0);
 
         model.RemoveNotificationSubsription(shared_from_this());
         // Warning: potentially deleted after return.
@@ -730,8 +961,8 @@ public:
         }
     }
 
-    PiPedalSocketHandler(PiPedalModel &model)
-        : model(model), clientId(++nextClientId)
+    PiPedalSocketHandler(PiPedalModel &model, std::shared_ptr<PiPedalSessionRegistry> sessionRegistry)
+        : model(model), clientId(++nextClientId), sessionRegistry(std::move(sessionRegistry))
     {
         std::stringstream imageList;
         const std::filesystem::path &webRoot = model.GetWebRoot() / "img";
@@ -758,9 +989,10 @@ public:
 private:
     void JsonReply(int replyTo, const char *message, const char *json)
     {
-        std::stringstream s(ios_base::out);
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        outputBuffer.clear();
 
-        json_writer writer(s, true);
+        json_writer writer(outputBuffer, true);
 
         writer.start_array();
         {
@@ -779,10 +1011,7 @@ private:
         }
         writer.end_array();
 
-        {
-            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
-        }
+        this->send(outputBuffer);
     }
     // void JsonSend(const char *message, const char *json)
     // {
@@ -791,9 +1020,11 @@ private:
     template <typename T>
     void Reply(int replyTo, const char *message, const T &value)
     {
-        std::stringstream s(ios_base::out);
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        outputBuffer.clear();
+        Lv2StateBlobStore::OutOfLineScope outOfLine; // clients echo large state values back by reference.
 
-        json_writer writer(s, true);
+        json_writer writer(outputBuffer, true);
         writer.start_array();
         {
             writer.start_object();
@@ -810,18 +1041,23 @@ private:
             writer.write(value);
         }
         writer.end_array();
+        if (replyTo == -1)
         {
-            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
+            SendEvent(outputBuffer);
+        }
+        else
+        {
+            this->send(outputBuffer);
         }
     }
     void Reply(int replyTo, const char *message)
     {
         if (replyTo == -1)
             return;
-        std::stringstream s(ios_base::out);
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        outputBuffer.clear();
 
-        json_writer writer(s, true);
+        json_writer writer(outputBuffer, true);
         writer.start_array();
         {
             writer.start_object();
@@ -837,9 +1073,19 @@ private:
         }
         writer.end_array();
 
+        this->send(outputBuffer);
+    }
+
+    // Model events go through the replay log of resumable sessions. Called with writeMutex held.
+    void SendEvent(const std::string &text)
+    {
+        if (sessionToken.empty())
         {
-            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-            this->send(s.str());
+            this->send(text);
+        }
+        else
+        {
+            this->send(replayLog.Append(text));
         }
     }
 
@@ -917,7 +1163,7 @@ private:
         }
     };
     std::recursive_mutex requestMutex;
-    std::vector<IRequestReservation *> requestReservations;
+    std::unordered_map<int, IRequestReservation *> requestReservations;
     std::atomic<int> nextRequestId{1};
 
 public:
@@ -934,11 +1180,15 @@ public:
                 onError);
             {
                 std::lock_guard<std::recursive_mutex> lock(requestMutex);
-                requestReservations.push_back(reservation);
+                requestReservations[reservation->GetReservationid()] = reservation;
             }
-            std::stringstream s(ios_base::out);
+            FlushControlChanges(); // preserve message order.
+
+            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+            outputBuffer.clear();
+            Lv2StateBlobStore::OutOfLineScope outOfLine;
 
-            json_writer writer(s, true);
+            json_writer writer(outputBuffer, true);
             writer.start_array();
             {
                 writer.start_object();
@@ -952,10 +1202,7 @@ public:
                 writer.write(body);
             }
             writer.end_array();
-            {
-                std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
-                this->send(s.str());
-            }
+            this->send(outputBuffer);
         }
         catch (const std::exception &e)
         {
@@ -966,12 +1213,68 @@ public:
     template <typename T>
     void Send(const char *message, const T &body)
     {
+        FlushControlChanges(); // preserve message order.
         Reply(-1, message, body);
     }
     void Send(const char *message)
     {
+        FlushControlChanges();
         Reply(-1, message);
     }
+    // Send a notification that goes to all clients. Only the first client to send it calls makeBody() and serializes it.
+    template <typename FN>
+    void SendShared(SharedNotification &notification, const char *message, FN &&makeBody)
+    {
+        FlushControlChanges(); // preserve message order.
+        const std::string &text = notification.GetText(
+            [message, &makeBody](std::string &text)
+            {
+                Lv2StateBlobStore::OutOfLineScope outOfLine;
+                json_writer writer(text, true);
+                writer.start_array();
+                {
+                    writer.start_object();
+                    {
+                        writer.write_member("message", message);
+                    }
+                    writer.end_object();
+                    writer.write_raw(",");
+                    writer.write(makeBody());
+                }
+                writer.end_array();
+            });
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        SendEvent(text);
+    }
+
+    // Binary frames carry telemetry only. Returns false if the frame was dropped because the client isn't keeping up.
+    bool SendBinary(const std::vector<uint8_t> &frame)
+    {
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        return this->sendDroppableBinary(frame.data(), frame.size());
+    }
+    // Telemetry that a later message supersedes. Returns false if the message was dropped.
+    template <typename T>
+    bool SendDroppable(const char *message, const T &body)
+    {
+        FlushControlChanges(); // preserve message order.
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        outputBuffer.clear();
+
+        json_writer writer(outputBuffer, true);
+        writer.start_array();
+        {
+            writer.start_object();
+            {
+                writer.write_member("message", message);
+            }
+            writer.end_object();
+            writer.write_raw(",");
+            writer.write(body);
+        }
+        writer.end_array();
+        return this->sendDroppable(outputBuffer);
+    }
 
     void SendError(int replyTo, std::exception &e)
     {
@@ -982,6 +1285,34 @@ public:
         Reply(replyTo, "error", what);
     }
 
+    // Start an async request handler. Handlers that block (file I/O, storage) co_await
+    // ResumeOn(ThreadPool::Shared()) if they can run concurrently with other requests from
+    // this client, or ResumeOn(*orderedRequests) if they modify state, so that they don't
+    // stall the rest of this client's messages. Messages without replies (control changes,
+    // preset loads) must stay synchronous, since the client doesn't wait before sending the
+    // messages that depend on them.
+    void SpawnRequest(int replyTo, Task<void> &&request)
+    {
+        Spawn(RunRequest(shared_from_this(), replyTo, std::move(request)));
+    }
+    static Task<void> RunRequest(std::shared_ptr<PiPedalSocketHandler> self, int replyTo, Task<void> request)
+    {
+        std::string error;
+        try
+        {
+            co_await std::move(request);
+            co_return;
+        }
+        catch (const std::exception &e)
+        {
+            error = e.what();
+        }
+        if (!self->closed)
+        {
+            self->SendError(replyTo, error);
+        }
+    }
+
     std::shared_ptr<PortMonitorSubscription> getPortMonitorSubscription(uint64_t subscriptionId)
     {
         std::shared_ptr<PortMonitorSubscription> result;
@@ -1026,6 +1357,21 @@ public:
     void SendMonitorPortMessage_Inner(std::shared_ptr<PortMonitorSubscription> &subscription, float value)
     {
         auto subscriptionHandle_ = subscription->subscriptionHandle;
+        if (binaryTelemetry)
+        {
+            // acknowledged by an ackMonitorPortOutput message.
+            BinaryTelemetryWriter writer(BinaryTelemetryWriter::FrameType::MonitorPortOutput);
+            writer.AddMonitorPortOutput(subscriptionHandle_, value);
+            if (!SendBinary(writer.GetFrame()))
+            {
+                // no ack is coming. Send the latest value when the next update arrives.
+                std::lock_guard lock{subscription->pmMutex};
+                subscription->waitingForAck = false;
+                subscription->pendingValue = false;
+                subscription->currentValue = PortMonitorSubscription::INVALID_VALUE;
+            }
+            return;
+        }
         MonitorResultBody body;
         body.subscriptionHandle_ = subscriptionHandle_;
         body.value_ = value;
@@ -1034,46 +1380,54 @@ public:
             body,
             [this, subscriptionHandle_](const bool &result)
             {
-                // running on PiPedalSocket thread.
-                std::shared_ptr<PortMonitorSubscription> subscription = getPortMonitorSubscription(subscriptionHandle_);
-                if (!subscription)
-                    return;
-
-                float value;
-                {
-                    std::unique_lock lock{subscription->pmMutex};
-                    if (subscription->closed)
-                        return;
-                    if (subscription->pendingValue)
-                    {
-                        value = subscription->currentValue;
-                        subscription->lastValue = value;
-                        subscription->pendingValue = false;
-                        subscription->waitingForAck = true;
-
-                        lock.unlock();
-
-                        SendMonitorPortMessage_Inner(subscription, value);
-                        return;
-                    }
-                    else
-                    {
-                        subscription->waitingForAck = false;
-                    }
-                }
+                OnMonitorPortOutputAck(subscriptionHandle_);
             },
             [](const std::exception &e)
             {
                 Lv2Log::debug("Failed to monitor port output. (%s)", e.what());
             });
     }
+    void OnMonitorPortOutputAck(int64_t subscriptionHandle_)
+    {
+        // running on PiPedalSocket thread.
+        std::shared_ptr<PortMonitorSubscription> subscription = getPortMonitorSubscription(subscriptionHandle_);
+        if (!subscription)
+            return;
+
+        float value;
+        {
+            std::unique_lock lock{subscription->pmMutex};
+            if (subscription->closed)
+                return;
+            if (subscription->pendingValue)
+            {
+                value = subscription->currentValue;
+                subscription->lastValue = value;
+                subscription->pendingValue = false;
+                subscription->waitingForAck = true;
+
+                lock.unlock();
+
+                SendMonitorPortMessage_Inner(subscription, value);
+                return;
+            }
+            else
+            {
+                subscription->waitingForAck = false;
+            }
+        }
+    }
+    // No monitor port subscription from this client updates more often than this.
+    float maxMonitorPortUpdatesPerSecond = 100;
+
     void MonitorPort(int replyTo, MonitorPortBody &body)
     {
         std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+        float updateInterval = std::max(body.updateRate_, 1.0f / maxMonitorPortUpdatesPerSecond);
         int64_t subscriptionHandle = model.MonitorPort(
             body.instanceId_,
             body.key_,
-            body.updateRate_,
+            updateInterval,
             [this](int64_t subscriptionHandle_, float value)
             {
                 std::shared_ptr<PortMonitorSubscription> subscription = getPortMonitorSubscription(subscriptionHandle_);
@@ -1082,9 +1436,8 @@ public:
                 {
                     SendMonitorPortMessage(subscription, value);
                 }
-            }
-
-        );
+            },
+            std::max(body.epsilon_, 0.0f));
         {
             std::lock_guard lock(activePortMonitorsMutex);
             activePortMonitors.push_back(std::make_shared<PortMonitorSubscription>(subscriptionHandle, body.instanceId_, body.key_));
@@ -1094,761 +1447,1483 @@ public:
     }
 
     /***********************/
+    // Message handlers.
 
-    void handleMessage(int reply, int replyTo, const std::string &message, json_reader *pReader)
+    void HandleSetControl(int replyTo, json_reader *pReader)
     {
-        if (reply != -1)
-        {
-            IRequestReservation *reservation = nullptr;
-            {
-                std::lock_guard<std::recursive_mutex> guard(this->requestMutex);
-                for (auto i = this->requestReservations.begin(); i != this->requestReservations.end(); ++i)
-                {
-                    if ((*i)->GetReservationid() == reply)
-                    {
-                        reservation = (*i);
-                        requestReservations.erase(i);
-                        break;
-                    }
-                }
-            }
-            // be careful not to take down the whole server because of a client that's shutting down.
-            if (reservation != nullptr)
-            {
-                try
-                {
-                    reservation->onResult(pReader);
-                }
-                catch (const std::exception &e)
-                {
-                    Lv2Log::error("Socket: Invalid reply '%s'. (%s)", message.c_str(), e.what());
-                }
-                delete reservation;
-            }
-            else
-            {
-                Lv2Log::warning("Socket: Reply '%s' with nobody waiting.", message.c_str());
-            }
-            return;
-        }
-        if (closed)
-        {
-            this->SendError(replyTo, "Server has shut down.");
-        }
-        if (message == "setControl")
-        {
-            ControlChangedBody message;
-            pReader->read(&message);
-            this->model.SetControl(message.clientId_, message.instanceId_, message.symbol_, message.value_);
-        }
-        else if (message == "previewControl")
-        {
-            ControlChangedBody message;
-            pReader->read(&message);
-            this->model.PreviewControl(message.clientId_, message.instanceId_, message.symbol_, message.value_);
-        }
-        else if (message == "setControl")
-        {
-            ControlChangedBody message;
-            pReader->read(&message);
-            this->model.SetControl(message.clientId_, message.instanceId_, message.symbol_, message.value_);
-        }
-        else if (message == "setInputVolume")
-        {
-            float value;
-            pReader->read(&value);
-            this->model.SetInputVolume(value);
-        }
-        else if (message == "setOutputVolume")
-        {
-            float value;
-            pReader->read(&value);
-            this->model.SetOutputVolume(value);
-        }
-        else if (message == "previewInputVolume")
-        {
-            float value;
-            pReader->read(&value);
-            this->model.PreviewInputVolume(value);
-        }
-        else if (message == "previewOutputVolume")
-        {
-            float value;
-            pReader->read(&value);
-            this->model.PreviewOutputVolume(value);
-        }
+        ControlChangedBody message;
+        pReader->read(&message);
+        this->model.SetControl(message.clientId_, message.instanceId_, message.symbol_, message.value_);
+    }
 
-        else if (message == "listenForMidiEvent")
-        {
-            ListenForMidiEventBody body;
-            pReader->read(&body);
-            this->model.ListenForMidiEvent(this->clientId, body.handle_);
-        }
-        else if (message == "cancelListenForMidiEvent")
-        {
-            uint64_t handle;
-            pReader->read(&handle);
-            this->model.CancelListenForMidiEvent(this->clientId, handle);
-        }
-        else if (message == "monitorPatchProperty")
-        {
-            MonitorPatchPropertyBody body;
-            pReader->read(&body);
-            this->model.MonitorPatchProperty(this->clientId, body.clientHandle_, body.instanceId_, body.propertyUri_);
-        }
-        else if (message == "cancelMonitorPatchProperty")
-        {
-            int64_t handle;
-            pReader->read(&handle);
-            this->model.CancelMonitorPatchProperty(this->clientId, handle);
-        }
-        else if (message == "getUpdateStatus")
-        {
-            UpdateStatus updateStatus = model.GetUpdateStatus();
-            this->Reply(replyTo, "getUpdateStatus", updateStatus);
-        }
-        else if (message == "getHasWifi")
-        {
-            bool result = model.GetHasWifi();
-            this->Reply(replyTo, "getHasWifi", result);
-        }
-        else if (message == "updateNow")
-        {
-            std::string updateUrl;
-            pReader->read(&updateUrl);
-            model.UpdateNow(updateUrl);
-            bool result = true;
-            this->Reply(replyTo, "updateNow", result);
-        }
-        else if (message == "getJackStatus")
-        {
-            JackHostStatus status = model.GetJackStatus();
-            this->Reply(replyTo, "getJackStatus", status);
-        }
-        else if (message == "getAlsaDevices")
-        {
-            std::vector<AlsaDeviceInfo> devices = model.GetAlsaDevices();
-            this->Reply(replyTo, "getAlsaDevices", devices);
-        }
-        else if (message == "getKnownWifiNetworks")
+    void HandlePreviewControl(int replyTo, json_reader *pReader)
+    {
+        ControlChangedBody message;
+        pReader->read(&message);
+        this->model.PreviewControl(message.clientId_, message.instanceId_, message.symbol_, message.value_);
+    }
+
+    void HandleGetControlHandles(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "getControlHandles", model.GetControlHandles());
+    }
+
+    void HandleSetControlByHandle(int replyTo, json_reader *pReader)
+    {
+        ControlHandleValueBody message;
+        pReader->read(&message);
+        this->model.SetControlByHandle(message.clientId_, message.version_, message.handle_, message.value_);
+    }
+
+    void HandlePreviewControlByHandle(int replyTo, json_reader *pReader)
+    {
+        ControlHandleValueBody message;
+        pReader->read(&message);
+        this->model.PreviewControlByHandle(message.clientId_, message.version_, message.handle_, message.value_);
+    }
+
+    void HandleSetInputVolume(int replyTo, json_reader *pReader)
+    {
+        float value;
+        pReader->read(&value);
+        this->model.SetInputVolume(value);
+    }
+
+    void HandleSetOutputVolume(int replyTo, json_reader *pReader)
+    {
+        float value;
+        pReader->read(&value);
+        this->model.SetOutputVolume(value);
+    }
+
+    void HandlePreviewInputVolume(int replyTo, json_reader *pReader)
+    {
+        float value;
+        pReader->read(&value);
+        this->model.PreviewInputVolume(value);
+    }
+
+    void HandlePreviewOutputVolume(int replyTo, json_reader *pReader)
+    {
+        float value;
+        pReader->read(&value);
+        this->model.PreviewOutputVolume(value);
+    }
+
+    void HandleListenForMidiEvent(int replyTo, json_reader *pReader)
+    {
+        ListenForMidiEventBody body;
+        pReader->read(&body);
+        this->model.ListenForMidiEvent(this->clientId, body.handle_);
+    }
+
+    void HandleCancelListenForMidiEvent(int replyTo, json_reader *pReader)
+    {
+        uint64_t handle;
+        pReader->read(&handle);
+        this->model.CancelListenForMidiEvent(this->clientId, handle);
+    }
+
+    void HandleMonitorPatchProperty(int replyTo, json_reader *pReader)
+    {
+        MonitorPatchPropertyBody body;
+        pReader->read(&body);
+        this->model.MonitorPatchProperty(this->clientId, body.clientHandle_, body.instanceId_, body.propertyUri_);
+    }
+
+    void HandleCancelMonitorPatchProperty(int replyTo, json_reader *pReader)
+    {
+        int64_t handle;
+        pReader->read(&handle);
+        this->model.CancelMonitorPatchProperty(this->clientId, handle);
+    }
+
+    void HandleGetUpdateStatus(int replyTo, json_reader *pReader)
+    {
+        UpdateStatus updateStatus = model.GetUpdateStatus();
+        this->Reply(replyTo, "getUpdateStatus", updateStatus);
+    }
+
+    void HandleGetHasWifi(int replyTo, json_reader *pReader)
+    {
+        bool result = model.GetHasWifi();
+        this->Reply(replyTo, "getHasWifi", result);
+    }
+
+    void HandleUpdateNow(int replyTo, json_reader *pReader)
+    {
+        std::string updateUrl;
+        pReader->read(&updateUrl);
+        model.UpdateNow(updateUrl);
+        bool result = true;
+        this->Reply(replyTo, "updateNow", result);
+    }
+
+    void HandleGetJackStatus(int replyTo, json_reader *pReader)
+    {
+        JackHostStatus status = model.GetJackStatus();
+        status.webSocketQueuedBytes_ = GetWebSocketQueuedBytes();
+        status.webSocketStalledDisconnects_ = GetWebSocketStalledDisconnects();
+        status.caches_ = CacheRegistry::GetInstance().GetUsage();
+        this->Reply(replyTo, "getJackStatus", status);
+    }
+
+    void HandleGetAudioPeriodTrace(int replyTo, json_reader *pReader)
+    {
+        double seconds;
+        pReader->read(&seconds);
+        std::vector<AudioPeriodTraceEntry> trace = model.GetAudioPeriodTrace(seconds);
+        this->Reply(replyTo, "getAudioPeriodTrace", trace);
+    }
+
+    void HandleResetCpuUseStatistics(int replyTo, json_reader *pReader)
+    {
+        model.ResetCpuUseStatistics();
+        this->Reply(replyTo, "resetCpuUseStatistics");
+    }
+
+    void HandleMeasureLatency(int replyTo, json_reader *pReader)
+    {
+        MeasureLatencyBody body;
+        pReader->read(&body);
+        model.MeasureLatency(
+            clientId, body.inputChannel_, body.outputChannel_, body.stressSeconds_,
+            [this, replyTo](const LatencyMeasurement &measurement)
+            {
+                this->Reply(replyTo, "measureLatency", measurement);
+            },
+            [this, replyTo](const std::string &error)
+            {
+                this->SendError(replyTo, error);
+            });
+    }
+
+    void HandleSyncBanks(int replyTo, json_reader *pReader)
+    {
+        std::string peer;
+        pReader->read(&peer);
+        model.SyncBanksFrom(
+            clientId, peer,
+            [this, replyTo](const BankSyncResult &result)
+            {
+                this->Reply(replyTo, "syncBanks", result);
+            },
+            [this, replyTo](const std::string &error)
+            {
+                this->SendError(replyTo, error);
+            });
+    }
+
+    void HandleGetLatencyMeasurements(int replyTo, json_reader *pReader)
+    {
+        std::vector<LatencyMeasurement> measurements = model.GetLatencyMeasurements();
+        this->Reply(replyTo, "getLatencyMeasurements", measurements);
+    }
+
+    void HandleGetAlsaDevices(int replyTo, json_reader *pReader)
+    {
+        std::vector<AlsaDeviceInfo> devices = model.GetAlsaDevices();
+        this->Reply(replyTo, "getAlsaDevices", devices);
+    }
+
+    void HandleGetKnownWifiNetworks(int replyTo, json_reader *pReader)
+    {
+        std::vector<std::string> channels = this->model.GetKnownWifiNetworks();
+        this->Reply(replyTo, "getWifiChannels", channels);
+    }
+
+    void HandleRequestWifiScan(int replyTo, json_reader *pReader)
+    {
+        this->model.RequestWifiScan();
+    }
+
+    void HandleGetWifiChannels(int replyTo, json_reader *pReader)
+    {
+        std::string country;
+        pReader->read(&country);
+        std::vector<WifiChannelSelector> channels = pipedal::getWifiChannelSelectors(country.c_str());
+        this->Reply(replyTo, "getWifiChannels", channels);
+    }
+
+    void HandleGetPluginPresets(int replyTo, json_reader *pReader)
+    {
+        std::string uri;
+        pReader->read(&uri);
+        SpawnRequest(replyTo, GetPluginPresetsAsync(replyTo, std::move(uri)));
+    }
+    Task<void> GetPluginPresetsAsync(int replyTo, std::string uri)
+    {
+        co_await ResumeOn(ThreadPool::Shared());
+        this->Reply(replyTo, "getPluginPresets", this->model.GetPluginUiPresets(uri));
+    }
+
+    void HandleLoadPluginPreset(int replyTo, json_reader *pReader)
+    {
+        LoadPluginPresetBody body;
+        pReader->read(&body);
+        this->model.LoadPluginPreset(body.pluginInstanceId_, body.presetInstanceId_);
+    }
+
+    void HandleSetJackServerSettings(int replyTo, json_reader *pReader)
+    {
+        JackServerSettings jackServerSettings;
+        pReader->read(&jackServerSettings);
+        this->model.SetJackServerSettings(jackServerSettings);
+        this->Reply(replyTo, "setJackserverSettings");
+    }
+
+    void HandleStartRecording(int replyTo, json_reader *pReader)
+    {
+        std::string name = this->model.StartRecording();
+        this->Reply(replyTo, "startRecording", name);
+    }
+
+    void HandleStopRecording(int replyTo, json_reader *pReader)
+    {
+        this->model.StopRecording();
+        this->Reply(replyTo, "stopRecording");
+    }
+
+    void HandleSetPmuProfiling(int replyTo, json_reader *pReader)
+    {
+        bool enabled = false;
+        pReader->read(&enabled);
+        this->model.SetPmuProfiling(enabled);
+        this->Reply(replyTo, "setPmuProfiling");
+    }
+
+    void HandleSetDenormalDetection(int replyTo, json_reader *pReader)
+    {
+        bool enabled = false;
+        pReader->read(&enabled);
+        this->model.SetDenormalDetection(enabled);
+        this->Reply(replyTo, "setDenormalDetection");
+    }
+
+    void HandleSetGovernorSettings(int replyTo, json_reader *pReader)
+    {
+        std::string governor;
+        pReader->read(&governor);
+        std::string fromAddress = this->getFromAddress();
+        // if (!IsOnLocalSubnet(fromAddress))
+        // {
+        //     throw PiPedalException("Permission denied. Not on local subnet.");
+        // }
+        this->model.SetGovernorSettings(governor);
+        this->Reply(replyTo, "setGovernorSettings");
+    }
+
+    void HandleSetWifiConfigSettings(int replyTo, json_reader *pReader)
+    {
+        WifiConfigSettings wifiConfigSettings;
+        pReader->read(&wifiConfigSettings);
+        if (!GetAdminClient().CanUseAdminClient())
         {
-            std::vector<std::string> channels = this->model.GetKnownWifiNetworks();
-            this->Reply(replyTo, "getWifiChannels", channels);
+            throw PiPedalException("Can't change server settings when running interactively.");
         }
-        else if (message == "getWifiChannels")
+        std::string fromAddress = this->getFromAddress();
+        // if (!IsOnLocalSubnet(fromAddress))
+        // {
+        //     throw PiPedalException("Permission denied. Not on local subnet.");
+        // }
+
+        this->model.SetWifiConfigSettings(wifiConfigSettings);
+        this->Reply(replyTo, "setWifiConfigSettings");
+    }
+
+    void HandleGetWifiConfigSettings(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "getWifiConfigSettings", model.GetWifiConfigSettings());
+    }
+
+    void HandleSetWifiDirectConfigSettings(int replyTo, json_reader *pReader)
+    {
+        WifiDirectConfigSettings wifiDirectConfigSettings;
+        pReader->read(&wifiDirectConfigSettings);
+        if (!GetAdminClient().CanUseAdminClient())
         {
-            std::string country;
-            pReader->read(&country);
-            std::vector<WifiChannelSelector> channels = pipedal::getWifiChannelSelectors(country.c_str());
-            this->Reply(replyTo, "getWifiChannels", channels);
+            throw PiPedalException("Can't change server settings when running interactively.");
         }
-        else if (message == "getPluginPresets")
+        std::string fromAddress = this->getFromAddress();
+        // if (!IsOnLocalSubnet(fromAddress))
+        // {
+        //     throw PiPedalException("Permission denied. Not on local subnet.");
+        // }
+
+        this->model.SetWifiDirectConfigSettings(wifiDirectConfigSettings);
+        this->Reply(replyTo, "setWifiDirectConfigSettings");
+    }
+
+    void HandleGetWifiDirectConfigSettings(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "getWifiDirectConfigSettings", model.GetWifiDirectConfigSettings());
+    }
+
+    void HandleGetGovernorSettings(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "getGovernorSettings", model.GetGovernorSettings());
+    }
+
+    void HandleGetJackServerSettings(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "getJackServerSettings", model.GetJackServerSettings());
+    }
+
+    void HandleGetBankIndex(int replyTo, json_reader *pReader)
+    {
+        BankIndex bankIndex = model.GetBankIndex();
+        this->Reply(replyTo, "getBankIndex", bankIndex);
+    }
+
+    void HandleGetBankIndexVersioned(int replyTo, json_reader *pReader)
+    {
+        BanksChangedBody body;
+        BankIndex bankIndex = model.GetBankIndex(&body.version_);
+        body.banks_ = &bankIndex;
+        this->Reply(replyTo, "getBankIndexVersioned", body);
+    }
+
+    void HandleGetJackConfiguration(int replyTo, json_reader *pReader)
+    {
+        JackConfiguration configuration = this->model.GetJackConfiguration();
+        this->Reply(replyTo, "getJackConfiguration", configuration);
+    }
+
+    void HandleGetPluginCostEstimates(int replyTo, json_reader *pReader)
+    {
+        std::vector<PluginCostEstimate> estimates = this->model.GetPluginCostEstimates();
+        this->Reply(replyTo, "getPluginCostEstimates", estimates);
+    }
+
+    void HandleEstimatePresetLoad(int replyTo, json_reader *pReader)
+    {
+        int64_t presetId = 0;
+        pReader->read(&presetId);
+        PresetLoadEstimate estimate = this->model.EstimatePresetLoad(presetId);
+        this->Reply(replyTo, "estimatePresetLoad", estimate);
+    }
+
+    void HandleGetJackSettings(int replyTo, json_reader *pReader)
+    {
+        JackChannelSelection selection = this->model.GetJackChannelSelection();
+        this->Reply(replyTo, "getJackSettings", selection);
+    }
+
+    void HandleSaveCurrentPreset(int replyTo, json_reader *pReader)
+    {
+        this->model.SaveCurrentPreset(this->clientId);
+    }
+
+    void HandleSaveCurrentPresetAs(int replyTo, json_reader *pReader)
+    {
+        SaveCurrentPresetAsBody body;
+        pReader->read(&body);
+        int64_t result = this->model.SaveCurrentPresetAs(this->clientId, body.bankInstanceId_,body.name_, body.saveAfterInstanceId_);
+        Reply(replyTo, "saveCurrentPresetsAs", result);
+    }
+
+    void HandleSetSelectedPedalboardPlugin(int replyTo, json_reader *pReader)
+    {
+        SetSelectedPedalboardPluginBody body;
+        pReader->read(&body);
+        this->model.SetSelectedPedalboardPlugin(body.clientId_,body.pluginInstanceId_);
+    }
+
+    void HandleSavePluginPresetAs(int replyTo, json_reader *pReader)
+    {
+        SavePluginPresetAsBody body;
+        pReader->read(&body);
+        int64_t result = this->model.SavePluginPresetAs(body.instanceId_, body.name_);
+        Reply(replyTo, "saveCurrentPresetsAs", result);
+    }
+
+    void HandleGetPresets(int replyTo, json_reader *pReader)
+    {
+        PresetIndex presets;
+        this->model.GetPresets(&presets);
+        Reply(replyTo, "getPresets", presets);
+    }
+
+    void HandleGetPresetsVersioned(int replyTo, json_reader *pReader)
+    {
+        PresetIndex presets;
+        PresetsChangedBody body;
+        this->model.GetPresets(&presets, &body.version_);
+        body.presets_ = &presets;
+        Reply(replyTo, "getPresetsVersioned", body);
+    }
+
+    void HandleSetPedalboardItemEnable(int replyTo, json_reader *pReader)
+    {
+        PedalboardItemEnabledBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemEnable(body.clientId_, body.instanceId_, body.enabled_);
+    }
+
+    void HandleSetPedalboardItemUseModUi(int replyTo, json_reader *pReader)
+    {
+        PedalboardItemUseModGuiBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemUseModUi(body.clientId_, body.instanceId_, body.useModUi_);
+    }
+
+    void HandleSetPedalboardItemHardBypass(int replyTo, json_reader *pReader)
+    {
+        PedalboardItemHardBypassBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemHardBypass(body.clientId_, body.instanceId_, body.hardBypass_);
+    }
+
+    void HandleSetPedalboardItemEssential(int replyTo, json_reader *pReader)
+    {
+        PedalboardItemEssentialBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemEssential(body.clientId_, body.instanceId_, body.essential_);
+    }
+
+    void HandleSetPedalboardItemAlwaysRun(int replyTo, json_reader *pReader)
+    {
+        PedalboardItemAlwaysRunBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemAlwaysRun(body.clientId_, body.instanceId_, body.alwaysRun_);
+    }
+
+    void HandleUpdateCurrentPedalboard(int replyTo, json_reader *pReader)
+    {
         {
-            std::string uri;
-            pReader->read(&uri);
-            this->Reply(replyTo, "getPluginPresets", this->model.GetPluginUiPresets(uri));
+            UpdateCurrentPedalboardBody body;
+
+            pReader->read(&body);
+            this->model.UpdateCurrentPedalboard(body.clientId_, body.pedalboard_);
         }
-        else if (message == "loadPluginPreset")
+    }
+
+    void HandleSetSnapshot(int replyTo, json_reader *pReader)
+    {
+        int64_t snapshotIndex = -1;
+        pReader->read(&snapshotIndex);
+        this->model.SetSnapshot(snapshotIndex);
+    }
+
+    void HandleSetSnapshots(int replyTo, json_reader *pReader)
+    {
+        SetSnapshotsBody body;
+        pReader->read(&body);
+        this->model.SetSnapshots(body.snapshots_, body.selectedSnapshot_);
+    }
+
+    void HandleCurrentPedalboard(int replyTo, json_reader *pReader)
+    {
+        auto pedalboard = model.GetCurrentPedalboardCopy();
+        Reply(replyTo, "currentPedalboard", pedalboard);
+    }
+    void HandleCurrentPedalboardVersioned(int replyTo, json_reader *pReader)
+    {
+        UpdateCurrentPedalboardBody body;
+        body.pedalboard_ = model.GetCurrentPedalboardCopy(&body.version_);
+        Reply(replyTo, "currentPedalboardVersioned", body);
+    }
+
+    void HandlePlugins(int replyTo, json_reader *pReader)
+    {
+        auto uiPluginsJson = model.GetUiPluginsJson();
+        hasPluginList = true;
+        JsonReply(replyTo, "plugins", uiPluginsJson->c_str());
+    }
+
+    void HandlePluginCatalogVersion(int replyTo, json_reader *pReader)
+    {
+        // The client fetches the catalog itself from /var/pluginCatalog?v=<version>.
+        std::string version = model.GetPluginCatalogVersion();
+        hasPluginList = true;
+        Reply(replyTo, "pluginCatalogVersion", version);
+    }
+
+    void HandleSearchPlugins(int replyTo, json_reader *pReader)
+    {
+        PluginSearchRequest request;
+        pReader->read(&request);
+        PluginSearchResult result = model.SearchPlugins(request);
+        Reply(replyTo, "searchPlugins", result);
+    }
+
+    void HandlePluginClasses(int replyTo, json_reader *pReader)
+    {
+        auto pluginClassesJson = model.GetPluginClassesJson();
+        JsonReply(replyTo, "pluginClasses", pluginClassesJson->c_str());
+    }
+
+    void HandleEnableBinaryTelemetry(int replyTo, json_reader *pReader)
+    {
+        bool enable = false;
+        pReader->read(&enable);
+        binaryTelemetry = enable;
+        Reply(replyTo, "enableBinaryTelemetry", enable);
+    }
+
+    void HandleSetTelemetryRate(int replyTo, json_reader *pReader)
+    {
+        TelemetryRateBody body;
+        pReader->read(&body);
+
+        std::vector<int64_t> subscriptionHandles;
+        float updatesPerSecond;
         {
-            LoadPluginPresetBody body;
-            pReader->read(&body);
-            this->model.LoadPluginPreset(body.pluginInstanceId_, body.presetInstanceId_);
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            clientVisible = body.visible_;
+            clientVuUpdatesPerSecond = std::clamp(body.vuUpdatesPerSecond_, 1.0f, MAX_VU_UPDATES_PER_SECOND);
+            updatesPerSecond = GetEffectiveVuUpdatesPerSecond();
+            for (const auto &subscription : activeVuSubscriptions)
+            {
+                subscriptionHandles.push_back(subscription.subscriptionHandle);
+            }
         }
-        else if (message == "setJackServerSettings")
+        model.SetVuSubscriptionRates(subscriptionHandles, updatesPerSecond);
+        this->Reply(replyTo, "setTelemetryRate");
+    }
+
+    void HandleAckVuUpdate(int replyTo, json_reader *pReader)
+    {
+        std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+        if (updateRequestOutstanding > 0)
         {
-            JackServerSettings jackServerSettings;
-            pReader->read(&jackServerSettings);
-            this->model.SetJackServerSettings(jackServerSettings);
-            this->Reply(replyTo, "setJackserverSettings");
+            --updateRequestOutstanding;
         }
-        else if (message == "setGovernorSettings")
+    }
+
+    void HandleAckMonitorPortOutput(int replyTo, json_reader *pReader)
+    {
+        int64_t subscriptionHandle = -1;
+        pReader->read(&subscriptionHandle);
+        OnMonitorPortOutputAck(subscriptionHandle);
+    }
+
+    void HandleHello(int replyTo, json_reader *pReader)
+    {
+        if (pReader == nullptr)
         {
-            std::string governor;
-            pReader->read(&governor);
-            std::string fromAddress = this->getFromAddress();
-            // if (!IsOnLocalSubnet(fromAddress))
-            // {
-            //     throw PiPedalException("Permission denied. Not on local subnet.");
-            // }
-            this->model.SetGovernorSettings(governor);
-            this->Reply(replyTo, "setGovernorSettings");
+            // a client that doesn't resume sessions.
+            this->model.AddNotificationSubscription(shared_from_this());
+            Reply(replyTo, "ehlo", clientId);
+            return;
         }
-        else if (message == "setWifiConfigSettings")
+        HelloBody hello;
+        pReader->read(&hello);
+        if (sessionToken.empty() && !hello.sessionToken_.empty())
         {
-            WifiConfigSettings wifiConfigSettings;
-            pReader->read(&wifiConfigSettings);
-            if (!GetAdminClient().CanUseAdminClient())
+            std::shared_ptr<PiPedalSocketHandler> session = sessionRegistry->Resume(hello.sessionToken_);
+            if (session && session.get() != this)
             {
-                throw PiPedalException("Can't change server settings when running interactively.");
+                if (session->AttachConnection(this, replyTo, (uint64_t)hello.lastSequence_))
+                {
+                    this->resumedSession = session;
+                    return;
+                }
+                // the client has missed events that are no longer in the log, so it will fetch everything again.
+                session->Close();
             }
-            std::string fromAddress = this->getFromAddress();
-            // if (!IsOnLocalSubnet(fromAddress))
-            // {
-            //     throw PiPedalException("Permission denied. Not on local subnet.");
-            // }
-
-            this->model.SetWifiConfigSettings(wifiConfigSettings);
-            this->Reply(replyTo, "setWifiConfigSettings");
         }
-        else if (message == "getWifiConfigSettings")
+        if (sessionToken.empty())
         {
-            this->Reply(replyTo, "getWifiConfigSettings", model.GetWifiConfigSettings());
+            std::string token = sessionRegistry->Add(shared_from_this());
+            {
+                std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+                sessionToken = token;
+            }
+            this->model.AddNotificationSubscription(shared_from_this());
         }
-        else if (message == "setWifiDirectConfigSettings")
+        std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+        HelloReply reply;
+        reply.clientId_ = clientId;
+        reply.sessionToken_ = sessionToken;
+        reply.sequence_ = (int64_t)replayLog.LastSequence();
+        Reply(replyTo, "ehlo", reply);
+    }
+
+    // Moves this session onto the connection of a client that has reconnected, and sends the events that the client missed.
+    // Returns false if some of those events are no longer in the replay log.
+    bool AttachConnection(PiPedalSocketHandler *connection, int replyTo, uint64_t lastSequence)
+    {
         {
-            WifiDirectConfigSettings wifiDirectConfigSettings;
-            pReader->read(&wifiDirectConfigSettings);
-            if (!GetAdminClient().CanUseAdminClient())
+            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+            std::vector<std::string> missedEvents;
+            if (closed || !replayLog.GetMessagesAfter(lastSequence, &missedEvents))
             {
-                throw PiPedalException("Can't change server settings when running interactively.");
+                return false;
             }
-            std::string fromAddress = this->getFromAddress();
-            // if (!IsOnLocalSubnet(fromAddress))
-            // {
-            //     throw PiPedalException("Permission denied. Not on local subnet.");
-            // }
+            IWriteCallback *previousConnection = getWriteCallback();
+            attachedConnection = connection;
+            setWriteCallback(connection->getWriteCallback());
+            if (previousConnection != nullptr)
+            {
+                // a connection that dropped without our noticing yet.
+                previousConnection->close();
+            }
+            for (const auto &event : missedEvents)
+            {
+                this->send(event);
+            }
+            HelloReply reply;
+            reply.clientId_ = clientId;
+            reply.sessionToken_ = sessionToken;
+            reply.sequence_ = (int64_t)replayLog.LastSequence();
+            reply.resumed_ = true;
+            Reply(replyTo, "ehlo", reply);
+            Lv2Log::debug("Websocket session resumed. %d missed event(s) sent.", (int)missedEvents.size());
+        }
+        ResetConnectionState();
+        return true;
+    }
 
-            this->model.SetWifiDirectConfigSettings(wifiDirectConfigSettings);
-            this->Reply(replyTo, "setWifiDirectConfigSettings");
-        }
-        else if (message == "getWifiDirectConfigSettings")
+    // The connection that this session was resumed on has closed.
+    void OnResumedConnectionClosed(SocketHandler *connection)
+    {
         {
-            this->Reply(replyTo, "getWifiDirectConfigSettings", model.GetWifiDirectConfigSettings());
+            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+            if (attachedConnection != connection)
+            {
+                return; // the session has since moved to another connection.
+            }
+            attachedConnection = nullptr;
+            setWriteCallback(nullptr);
         }
+        Detach();
+    }
 
-        else if (message == "getGovernorSettings")
-        {
-            this->Reply(replyTo, "getGovernorSettings", model.GetGovernorSettings());
-        }
+    // The connection has closed, but the client may reconnect and resume the session. Model events continue
+    // to be logged in the meantime. VU and effect timing subscriptions stop; the client makes them afresh when
+    // it reconnects. Port monitors are kept, since the client keeps their handles.
+    void Detach()
+    {
+        RemoveTelemetrySubscriptions();
+        binaryTelemetry = false;
+        sessionRegistry->Detach(sessionToken, shared_from_this());
+    }
 
-        else if (message == "getJackServerSettings")
-        {
-            this->Reply(replyTo, "getJackServerSettings", model.GetJackServerSettings());
-        }
-        else if (message == "getBankIndex")
-        {
-            BankIndex bankIndex = model.GetBankIndex();
-            this->Reply(replyTo, "getBankIndex", bankIndex);
-        }
-        else if (message == "getJackConfiguration")
-        {
-            JackConfiguration configuration = this->model.GetJackConfiguration();
-            this->Reply(replyTo, "getJackConfiguration", configuration);
-        }
-        else if (message == "getJackSettings")
-        {
-            JackChannelSelection selection = this->model.GetJackChannelSelection();
-            this->Reply(replyTo, "getJackSettings", selection);
-        }
-        else if (message == "saveCurrentPreset")
+    void RemovePortMonitors()
+    {
+        std::vector<std::shared_ptr<PortMonitorSubscription>> portMonitors;
         {
-            this->model.SaveCurrentPreset(this->clientId);
+            std::lock_guard lock{activePortMonitorsMutex};
+            portMonitors = std::move(activePortMonitors);
+            activePortMonitors.clear();
         }
-        else if (message == "saveCurrentPresetAs")
+        for (auto &portMonitor : portMonitors)
         {
-            SaveCurrentPresetAsBody body;
-            pReader->read(&body);
-            int64_t result = this->model.SaveCurrentPresetAs(this->clientId, body.bankInstanceId_,body.name_, body.saveAfterInstanceId_);
-            Reply(replyTo, "saveCurrentPresetsAs", result);
-        }
-        else if (message == "setSelectedPedalboardPlugin")
-        {
-            SetSelectedPedalboardPluginBody body;
-            pReader->read(&body);
-            this->model.SetSelectedPedalboardPlugin(body.clientId_,body.pluginInstanceId_);
+            model.UnmonitorPort(portMonitor->subscriptionHandle);
         }
-        else if (message == "savePluginPresetAs")
+    }
+
+    void RemoveTelemetrySubscriptions()
+    {
+        std::vector<VuSubscription> vuSubscriptions;
+        std::vector<int64_t> effectTimingSubscriptions;
         {
-            SavePluginPresetAsBody body;
-            pReader->read(&body);
-            int64_t result = this->model.SavePluginPresetAs(body.instanceId_, body.name_);
-            Reply(replyTo, "saveCurrentPresetsAs", result);
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            vuSubscriptions = std::move(activeVuSubscriptions);
+            activeVuSubscriptions.clear();
+            effectTimingSubscriptions = std::move(activeEffectTimingSubscriptions);
+            activeEffectTimingSubscriptions.clear();
         }
-        else if (message == "getPresets")
+        for (const auto &vuSubscription : vuSubscriptions)
         {
-            PresetIndex presets;
-            this->model.GetPresets(&presets);
-            Reply(replyTo, "getPresets", presets);
+            model.RemoveVuSubscription(vuSubscription.subscriptionHandle);
         }
-        else if (message == "setPedalboardItemEnable")
+        for (int64_t subscriptionHandle : effectTimingSubscriptions)
         {
-            PedalboardItemEnabledBody body;
-            pReader->read(&body);
-            model.SetPedalboardItemEnable(body.clientId_, body.instanceId_, body.enabled_);
-        }
-        else if (message == "setPedalboardItemUseModUi") {
-            PedalboardItemUseModGuiBody body;
-            pReader->read(&body);
-            model.SetPedalboardItemUseModUi(body.clientId_, body.instanceId_, body.useModUi_);
+            model.RemoveEffectTimingSubscription(subscriptionHandle);
         }
-        else if (message == "updateCurrentPedalboard")
+    }
+
+    // Requests sent on a previous connection will never be answered. Reset their flow control.
+    void ResetConnectionState()
+    {
+        std::vector<IRequestReservation *> reservations;
         {
+            std::lock_guard<std::recursive_mutex> lock(requestMutex);
+            for (auto &reservation : requestReservations)
             {
-                UpdateCurrentPedalboardBody body;
-
-                pReader->read(&body);
-                this->model.UpdateCurrentPedalboard(body.clientId_, body.pedalboard_);
+                reservations.push_back(reservation.second);
             }
+            requestReservations.clear();
         }
-        else if (message == "setSnapshot")
-        {
-            int64_t snapshotIndex = -1;
-            pReader->read(&snapshotIndex);
-            this->model.SetSnapshot(snapshotIndex);
-        }
-        else if (message == "setSnapshots")
-        {
-            SetSnapshotsBody body;
-            pReader->read(&body);
-            this->model.SetSnapshots(body.snapshots_, body.selectedSnapshot_);
-        }
-        else if (message == "currentPedalboard")
-        {
-            auto pedalboard = model.GetCurrentPedalboardCopy();
-            Reply(replyTo, "currentPedalboard", pedalboard);
-        }
-        else if (message == "plugins")
-        {
-            auto ui_plugins = model.GetPluginHost().GetUiPlugins();
-            Reply(replyTo, "plugins", ui_plugins);
-        }
-        else if (message == "pluginClasses")
+        PiPedalException error("Connection closed.");
+        for (IRequestReservation *reservation : reservations)
         {
-            auto classes = model.GetPluginHost().GetLv2PluginClass();
-            Reply(replyTo, "pluginClasses", classes);
-        }
-        else if (message == "hello")
-        {
-            this->model.AddNotificationSubscription(shared_from_this());
-            Reply(replyTo, "ehlo", clientId);
+            try
+            {
+                reservation->onError(error);
+            }
+            catch (const std::exception &)
+            {
+            }
+            delete reservation;
         }
-        else if (message == "setJackSettings")
         {
-            JackChannelSelection jackSettings;
-            pReader->read(&jackSettings);
-            this->model.SetJackChannelSelection(this->clientId, jackSettings);
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            updateRequestOutstanding = 0;
+            // the client monitors patch properties afresh when it reconnects.
+            outstandingNotifyAtomOutputs = 0;
+            pendingNotifyAtomOutputs.clear();
         }
-        else if (message == "setShowStatusMonitor")
         {
-            bool showStatusMonitor;
-            pReader->read(&showStatusMonitor);
-            this->model.SetShowStatusMonitor(showStatusMonitor);
+            std::lock_guard lock{activePortMonitorsMutex};
+            for (auto &portMonitor : activePortMonitors)
+            {
+                std::lock_guard pmLock{portMonitor->pmMutex};
+                portMonitor->waitingForAck = false;
+                portMonitor->pendingValue = false;
+                portMonitor->currentValue = PortMonitorSubscription::INVALID_VALUE;
+            }
         }
-        else if (message == "getShowStatusMonitor")
+        if (midiValueChangedOutstanding)
         {
-            Reply(replyTo, "getShowStatusMonitor", this->model.GetShowStatusMonitor());
+            // The last batch of MIDI control changes may not have been delivered. Send it again, followed by later changes.
+            std::vector<ControlValueChange> inFlightValues = std::move(this->inFlightMidiValues);
+            std::vector<ControlValueChange> laterValues = std::move(this->deferredValues);
+            this->inFlightMidiValues.clear();
+            this->deferredValues.clear();
+            this->midiValueChangedOutstanding = false;
+            if (!inFlightValues.empty())
+            {
+                OnMidiValuesChanged(inFlightValues);
+            }
+            if (!laterValues.empty())
+            {
+                OnMidiValuesChanged(laterValues);
+            }
         }
-        else if (message == "version")
-        {
-            PiPedalVersion version(this->model);
+    }
 
-            Reply(replyTo, "version", version);
-        }
-        else if (message == "loadPreset")
-        {
-            int64_t instanceId = 0;
-            pReader->read(&instanceId);
-            model.LoadPreset(this->clientId, instanceId);
-        }
-        else if (message == "updatePresets")
+    void HandleSetJackSettings(int replyTo, json_reader *pReader)
+    {
+        JackChannelSelection jackSettings;
+        pReader->read(&jackSettings);
+        this->model.SetJackChannelSelection(this->clientId, jackSettings);
+    }
+
+    void HandleGetPedalboardSlots(int replyTo, json_reader *pReader)
+    {
+        PedalboardSlots slots = this->model.GetPedalboardSlots();
+        this->Reply(replyTo, "getPedalboardSlots", slots);
+    }
+
+    void HandleSetPedalboardSlots(int replyTo, json_reader *pReader)
+    {
+        PedalboardSlots slots;
+        pReader->read(&slots);
+        this->model.SetPedalboardSlots(slots);
+        this->Reply(replyTo, "setPedalboardSlots");
+    }
+
+    void HandleSetPedalboardSlotPreset(int replyTo, json_reader *pReader)
+    {
+        SetPedalboardSlotPresetBody body;
+        pReader->read(&body);
+        if (body.slot_ < 0)
         {
-            PresetIndex newIndex;
-            pReader->read(&newIndex);
-            bool result = model.UpdatePresets(this->clientId, newIndex);
-            this->Reply(replyTo, "updatePresets", result);
+            throw PiPedalException("Invalid pedalboard slot.");
         }
-        else if (message == "updatePluginPresets")
+        this->model.SetPedalboardSlotPreset((size_t)body.slot_, body.bankId_, body.presetId_);
+        this->Reply(replyTo, "setPedalboardSlotPreset");
+    }
+
+    void HandleSetShowStatusMonitor(int replyTo, json_reader *pReader)
+    {
+        bool showStatusMonitor;
+        pReader->read(&showStatusMonitor);
+        this->model.SetShowStatusMonitor(showStatusMonitor);
+    }
+
+    void HandleGetShowStatusMonitor(int replyTo, json_reader *pReader)
+    {
+        Reply(replyTo, "getShowStatusMonitor", this->model.GetShowStatusMonitor());
+    }
+
+    void HandleVersion(int replyTo, json_reader *pReader)
+    {
+        PiPedalVersion version(this->model);
+
+        Reply(replyTo, "version", version);
+    }
+
+    void HandleLoadPreset(int replyTo, json_reader *pReader)
+    {
+        int64_t instanceId = 0;
+        pReader->read(&instanceId);
+        model.LoadPreset(this->clientId, instanceId);
+    }
+
+    void HandleUpdatePresets(int replyTo, json_reader *pReader)
+    {
+        PresetIndex newIndex;
+        pReader->read(&newIndex);
+        bool result = model.UpdatePresets(this->clientId, newIndex);
+        this->Reply(replyTo, "updatePresets", result);
+    }
+
+    void HandleUpdatePluginPresets(int replyTo, json_reader *pReader)
+    {
+        PluginUiPresets pluginPresets;
+        pReader->read(&pluginPresets);
+        model.UpdatePluginPresets(pluginPresets);
+        this->Reply(replyTo, "updatePluginPresets", true);
+    }
+
+    void HandleMoveBank(int replyTo, json_reader *pReader)
+    {
+        FromToBody body;
+        pReader->read(&body);
+        model.MoveBank(this->clientId, body.from_, body.to_);
+        this->Reply(replyTo, "moveBank");
+    }
+
+    void HandleShutdown(int replyTo, json_reader *pReader)
+    {
+        model.RequestShutdown(false);
+        this->Reply(replyTo, "shutdown");
+    }
+
+    void HandleRestart(int replyTo, json_reader *pReader)
+    {
+        model.RequestShutdown(true);
+        this->Reply(replyTo, "restart");
+    }
+
+    void HandleDeletePresetItems(int replyTo, json_reader *pReader)
+    {
+        std::vector<int64_t> items;
+        pReader->read(&items);
+        int64_t result = model.DeletePresets(this->clientId, items);
+        this->Reply(replyTo, "deletePresetItems", result);
+    }
+
+    void HandleDeleteBankItem(int replyTo, json_reader *pReader)
+    {
+        int64_t instanceId = 0;
+        pReader->read(&instanceId);
+        uint64_t result = model.DeleteBank(this->clientId, instanceId);
+        this->Reply(replyTo, "deleteBankItem", result);
+    }
+
+    void HandleGetHasTone3000Auth(int replyTo, json_reader *pReader)
+    {
+        bool result = model.HasTone3000Auth();
+        this->Reply(replyTo, "getHasTone3000Auth", result);
+    }
+
+    void HandleRenameBank(int replyTo, json_reader *pReader)
+    {
+        RenameBankBody body;
+        pReader->read(&body);
+
+        std::stringstream tOut;
+        json_writer tWriter(tOut);
+        tWriter.write(body.newName_);
+        std::string tJson = tOut.str();
+        std::stringstream tIn(tJson);
+        json_reader tReader(tIn);
+        std::string tResult;
+        tReader.read(&tResult);
+
+        body.newName_ = tResult;
+
+        try
         {
-            PluginUiPresets pluginPresets;
-            pReader->read(&pluginPresets);
-            model.UpdatePluginPresets(pluginPresets);
-            this->Reply(replyTo, "updatePluginPresets", true);
+            model.RenameBank(this->clientId, body.bankId_, body.newName_);
+            this->Reply(replyTo, "renameBank");
         }
-        else if (message == "moveBank")
+        catch (const std::exception &e)
         {
-            FromToBody body;
-            pReader->read(&body);
-            model.MoveBank(this->clientId, body.from_, body.to_);
-            this->Reply(replyTo, "moveBank");
+            this->SendError(replyTo, std::string(e.what()));
         }
-        else if (message == "shutdown")
+    }
+
+    void HandleOpenBank(int replyTo, json_reader *pReader)
+    {
+        int64_t bankId = -1;
+        pReader->read(&bankId);
+        try
         {
-            model.RequestShutdown(false);
-            this->Reply(replyTo, "shutdown");
+            model.OpenBank(this->clientId, bankId);
+            ;
+            this->Reply(replyTo, "openBank");
         }
-        else if (message == "restart")
+        catch (const std::exception &e)
         {
-            model.RequestShutdown(true);
-            this->Reply(replyTo, "restart");
+            this->SendError(replyTo, std::string(e.what()));
         }
-        else if (message == "deletePresetItems")
+    }
+
+    void HandleSaveBankAs(int replyTo, json_reader *pReader)
+    {
+        RenameBankBody body;
+        pReader->read(&body);
+        try
         {
-            std::vector<int64_t> items;
-            pReader->read(&items);
-            int64_t result = model.DeletePresets(this->clientId, items);
-            this->Reply(replyTo, "deletePresetItems", result);
+            int64_t newId = model.SaveBankAs(this->clientId, body.bankId_, body.newName_);
+            this->Reply(replyTo, "saveBankAs", newId);
         }
-        else if (message == "deleteBankItem")
-        {
-            int64_t instanceId = 0;
-            pReader->read(&instanceId);
-            uint64_t result = model.DeleteBank(this->clientId, instanceId);
-            this->Reply(replyTo, "deleteBankItem", result);
-        } else if (message == "getHasTone3000Auth") 
+        catch (const std::exception &e)
         {
-            bool result = model.HasTone3000Auth();
-            this->Reply(replyTo, "getHasTone3000Auth", result);
+            this->SendError(replyTo, std::string(e.what()));
         }
-        else if (message == "renameBank")
-        {
-            RenameBankBody body;
-            pReader->read(&body);
+    }
+
+    void HandleNextBank(int replyTo, json_reader *pReader)
+    {
+        model.NextBank();
+    }
 
-            std::stringstream tOut;
-            json_writer tWriter(tOut);
-            tWriter.write(body.newName_);
-            std::string tJson = tOut.str();
-            std::stringstream tIn(tJson);
-            json_reader tReader(tIn);
-            std::string tResult;
-            tReader.read(&tResult);
+    void HandlePreviousBank(int replyTo, json_reader *pReader)
+    {
+        model.PreviousBank();
+    }
 
-            body.newName_ = tResult;
+    void HandleNextPreset(int replyTo, json_reader *pReader)
+    {
+        model.NextPreset();
+    }
 
-            try
-            {
-                model.RenameBank(this->clientId, body.bankId_, body.newName_);
-                this->Reply(replyTo, "renameBank");
-            }
-            catch (const std::exception &e)
-            {
-                this->SendError(replyTo, std::string(e.what()));
-            }
-        }
-        else if (message == "openBank")
-        {
-            int64_t bankId = -1;
-            pReader->read(&bankId);
-            try
+    void HandlePreviousPreset(int replyTo, json_reader *pReader)
+    {
+        model.PreviousPreset();
+    }
+
+    void HandleRenamePresetItem(int replyTo, json_reader *pReader)
+    {
+        RenamePresetBody body;
+        pReader->read(&body);
+
+        bool result = model.RenamePreset(body.clientId_, body.instanceId_, body.name_);
+        this->Reply(replyTo, "renamePresetItem", result);
+    }
+
+    void HandleCopyPreset(int replyTo, json_reader *pReader)
+    {
+        CopyPresetBody body;
+        pReader->read(&body);
+        int64_t result = model.CopyPreset(body.clientId_, body.fromId_, body.toId_);
+        this->Reply(replyTo, "copyPreset", result);
+    }
+
+    void HandleCopyPluginPreset(int replyTo, json_reader *pReader)
+    {
+        CopyPluginPresetBody body;
+        pReader->read(&body);
+        uint64_t result = model.CopyPluginPreset(body.pluginUri_, body.instanceId_);
+        this->Reply(replyTo, "copyPluginPreset", result);
+    }
+
+    void HandleSetPatchProperty(int replyTo, json_reader *pReader)
+    {
+        SetPatchPropertyBody body;
+        pReader->read(&body);
+        model.SendSetPatchProperty(clientId, body.instanceId_, body.propertyUri_, body.value_, [this, replyTo]()
+                                   { this->JsonReply(replyTo, "setPatchProperty", "true"); }, [this, replyTo](const std::string &error)
+                                   { this->SendError(replyTo, error.c_str()); });
+    }
+
+    void HandleSetPedalboardItemTitle(int replyTo, json_reader *pReader)
+    {
+        SetPedalboardItemTitleBody body;
+        pReader->read(&body);
+        model.SetPedalboardItemTitle(body.instanceId_, body.title_, body.colorKey_);
+    }
+
+    void HandleGetPatchProperty(int replyTo, json_reader *pReader)
+    {
+        GetPatchPropertyBody body;
+        pReader->read(&body);
+
+        model.SendGetPatchProperty(
+            this->clientId,
+            body.instanceId_,
+            body.propertyUri_,
+            [this, replyTo](const std::string &jsonResult)
             {
-                model.OpenBank(this->clientId, bankId);
-                ;
-                this->Reply(replyTo, "openBank");
-            }
-            catch (const std::exception &e)
+                this->JsonReply(replyTo, "getPatchProperty", jsonResult.c_str());
+            },
+            [this, replyTo](const std::string &error)
             {
-                this->SendError(replyTo, std::string(e.what()));
-            }
-        }
-        else if (message == "saveBankAs")
+                this->SendError(replyTo, error.c_str());
+            });
+    }
+
+    void HandleMonitorPort(int replyTo, json_reader *pReader)
+    {
+        MonitorPortBody body;
+        pReader->read(&body);
+
+        MonitorPort(replyTo, body);
+    }
+
+    void HandleUnmonitorPort(int replyTo, json_reader *pReader)
+    {
+        int64_t subscriptionHandle;
+        pReader->read(&subscriptionHandle);
         {
-            RenameBankBody body;
-            pReader->read(&body);
-            try
-            {
-                int64_t newId = model.SaveBankAs(this->clientId, body.bankId_, body.newName_);
-                this->Reply(replyTo, "saveBankAs", newId);
-            }
-            catch (const std::exception &e)
             {
-                this->SendError(replyTo, std::string(e.what()));
+                std::lock_guard guard(activePortMonitorsMutex);
+                for (auto i = this->activePortMonitors.begin(); i != this->activePortMonitors.end(); ++i)
+                {
+                    if ((*i)->subscriptionHandle == subscriptionHandle)
+                    {
+                        auto subscription = (*i);
+                        subscription->Close();
+
+                        this->activePortMonitors.erase(i);
+                        break;
+                    }
+                }
             }
+            model.UnmonitorPort(subscriptionHandle);
         }
-        else if (message == "nextBank")
-        {
-            model.NextBank();
-        }
-        else if (message == "previousBank")
-        {
-            model.PreviousBank();
-        }
-        else if (message == "nextPreset")
+    }
+
+    void HandleAddVuSubscription(int replyTo, json_reader *pReader)
+    {
+        int64_t instanceId = -1;
+
+        pReader->read(&instanceId);
+
+        float updatesPerSecond;
         {
-            model.NextPreset();
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            updatesPerSecond = GetEffectiveVuUpdatesPerSecond();
         }
-        else if (message == "previousPreset")
+        // not under subscriptionMutex, since the model calls OnVuMeterUpdate with its own lock held.
+        int64_t subscriptionHandle = model.AddVuSubscription(instanceId, updatesPerSecond);
+
         {
-            model.PreviousPreset();
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            activeVuSubscriptions.push_back(VuSubscription{subscriptionHandle, instanceId});
         }
+        this->Reply(replyTo, "addVuSubscription", subscriptionHandle);
+    }
 
-        else if (message == "renamePresetItem")
+    void HandleRemoveVuSubscription(int replyTo, json_reader *pReader)
+    {
+        int64_t subscriptionHandle = -1;
+        pReader->read(&subscriptionHandle);
         {
-            RenamePresetBody body;
-            pReader->read(&body);
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
 
-            bool result = model.RenamePreset(body.clientId_, body.instanceId_, body.name_);
-            this->Reply(replyTo, "renamePresetItem", result);
-        }
-        else if (message == "copyPreset")
-        {
-            CopyPresetBody body;
-            pReader->read(&body);
-            int64_t result = model.CopyPreset(body.clientId_, body.fromId_, body.toId_);
-            this->Reply(replyTo, "copyPreset", result);
-        }
-        else if (message == "copyPluginPreset")
-        {
-            CopyPluginPresetBody body;
-            pReader->read(&body);
-            uint64_t result = model.CopyPluginPreset(body.pluginUri_, body.instanceId_);
-            this->Reply(replyTo, "copyPluginPreset", result);
+            for (auto i = activeVuSubscriptions.begin(); i != activeVuSubscriptions.end(); ++i)
+            {
+                if (i->subscriptionHandle == subscriptionHandle)
+                {
+                    activeVuSubscriptions.erase(i);
+                    break;
+                }
+            }
         }
-        else if (message == "setPatchProperty")
+        model.RemoveVuSubscription(subscriptionHandle);
+    }
+
+    void HandleAddEffectTimingSubscription(int replyTo, json_reader *pReader)
+    {
+        int64_t subscriptionHandle = model.AddEffectTimingSubscription();
         {
-            SetPatchPropertyBody body;
-            pReader->read(&body);
-            model.SendSetPatchProperty(clientId, body.instanceId_, body.propertyUri_, body.value_, [this, replyTo]()
-                                       { this->JsonReply(replyTo, "setPatchProperty", "true"); }, [this, replyTo](const std::string &error)
-                                       { this->SendError(replyTo, error.c_str()); });
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            activeEffectTimingSubscriptions.push_back(subscriptionHandle);
         }
-        else if (message == "setPedalboardItemTitle")
+        this->Reply(replyTo, "addEffectTimingSubscription", subscriptionHandle);
+    }
+
+    void HandleRemoveEffectTimingSubscription(int replyTo, json_reader *pReader)
+    {
+        int64_t subscriptionHandle = -1;
+        pReader->read(&subscriptionHandle);
         {
-            SetPedalboardItemTitleBody body;
-            pReader->read(&body);
-            model.SetPedalboardItemTitle(body.instanceId_, body.title_, body.colorKey_);
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            for (auto i = activeEffectTimingSubscriptions.begin(); i != activeEffectTimingSubscriptions.end(); ++i)
+            {
+                if (*i == subscriptionHandle)
+                {
+                    activeEffectTimingSubscriptions.erase(i);
+                    break;
+                }
+            }
         }
-        else if (message == "getPatchProperty")
-        {
-            GetPatchPropertyBody body;
-            pReader->read(&body);
+        model.RemoveEffectTimingSubscription(subscriptionHandle);
+    }
+
+    void HandleImageList(int replyTo, json_reader *pReader)
+    {
+        this->Reply(replyTo, "imageList", imageList);
+    }
+
+    void HandleGetFavorites(int replyTo, json_reader *pReader)
+    {
+        std::map<std::string, bool> favorites = this->model.GetFavorites();
+        this->Reply(replyTo, "getFavorites", favorites);
+    }
+
+    void HandleSetFavorites(int replyTo, json_reader *pReader)
+    {
+        std::map<std::string, bool> favorites;
+        pReader->read(&favorites);
+        this->model.SetFavorites(favorites);
+    }
+
+    void HandleSetUpdatePolicy(int replyTo, json_reader *pReader)
+    {
+        int iPolicy;
+        pReader->read(&iPolicy);
+
+        this->model.SetUpdatePolicy((UpdatePolicyT)iPolicy);
+    }
+
+    void HandleForceUpdateCheck(int replyTo, json_reader *pReader)
+    {
+        this->model.ForceUpdateCheck();
+    }
+
+    void HandleSetSystemMidiBindings(int replyTo, json_reader *pReader)
+    {
+        std::vector<MidiBinding> bindings;
+        pReader->read(&bindings);
+        this->model.SetSystemMidiBindings(bindings);
+    }
+
+    void HandleGetSystemMidiBindings(int replyTo, json_reader *pReader)
+    {
+        std::vector<MidiBinding> bindings = this->model.GetSystemMidiBidings();
+        this->Reply(replyTo, "getSystemMidiBindings", bindings);
+    }
+
+    void HandleRequestFileList(int replyTo, json_reader *pReader)
+    {
+        throw std::runtime_error("No longer implemented.");
+    }
+
+    void HandleRequestFileList2(int replyTo, json_reader *pReader)
+    {
+        FileRequestArgs requestArgs;
+        pReader->read(&requestArgs);
+        SpawnRequest(replyTo, RequestFileList2Async(replyTo, std::move(requestArgs)));
+    }
+    Task<void> RequestFileList2Async(int replyTo, FileRequestArgs requestArgs)
+    {
+        co_await ResumeOn(ThreadPool::Shared());
+        FileRequestResult result = this->model.GetFileList2(requestArgs.relativePath_, requestArgs.fileProperty_, requestArgs.sortKey_);
+        result.SelectPage(requestArgs.sortKey_, requestArgs.pageSize_, requestArgs.continuationToken_);
+        this->Reply(replyTo, "requestFileList2", result);
+    }
+
+    void HandleNewPreset(int replyTo, json_reader *pReader)
+    {
+        int64_t presetId = this->model.CreateNewPreset();
+        this->Reply(replyTo, "newPreset", presetId);
+    }
+
+    void HandleDeleteUserFile(int replyTo, json_reader *pReader)
+    {
+        std::string fileName;
+        pReader->read(&fileName);
+
+        this->model.DeleteSampleFile(fileName);
+        this->Reply(replyTo, "deleteUserFile", true);
+    }
+
+    void HandleCreateNewSampleDirectory(int replyTo, json_reader *pReader)
+    {
+        CreateNewSampleDirectoryArgs args;
+        pReader->read(&args);
+
+        std::string newFileName = this->model.CreateNewSampleDirectory(args.relativePath_, args.uiFileProperty_);
+        this->Reply(replyTo, "createNewSampleDirectory", newFileName);
+    }
+
+    void HandleRenameFilePropertyFile(int replyTo, json_reader *pReader)
+    {
+        RenameSampleFileArgs args;
+        pReader->read(&args);
+
+        std::string newFileName = this->model.RenameFilePropertyFile(args.oldRelativePath_, args.newRelativePath_, args.uiFileProperty_);
+        this->Reply(replyTo, "renameFilePropertyFile", newFileName);
+    }
+
+    void HandleCopyFilePropertyFile(int replyTo, json_reader *pReader)
+    {
+        CopySampleFileArgs args;
+        pReader->read(&args);
+
+        std::string newFileName = this->model.CopyFilePropertyFile(args.oldRelativePath_, args.newRelativePath_, args.uiFileProperty_, args.overwrite_);
+        this->Reply(replyTo, "copyFilePropertyFile", newFileName);
+    }
+
+    void HandleGetFilePropertyDirectoryTree(int replyTo, json_reader *pReader)
+    {
+        GetFilePropertyDirectoryTreeArgs args;
+        pReader->read(&args);
+        SpawnRequest(replyTo, GetFilePropertyDirectoryTreeAsync(replyTo, std::move(args)));
+    }
+    Task<void> GetFilePropertyDirectoryTreeAsync(int replyTo, GetFilePropertyDirectoryTreeArgs args)
+    {
+        co_await ResumeOn(ThreadPool::Shared());
+        FilePropertyDirectoryTree::ptr result =
+            model.GetFilePropertydirectoryTree(
+                args.fileProperty_,
+                args.selectedPath_);
+        this->Reply(replyTo, "GetFilePropertydirectoryTree", result);
+    }
+
+    void HandleMoveAudioFile(int replyTo, json_reader *pReader)
+    {
+        MoveAudioFileArgs args;
+        pReader->read(&args);
+        this->model.MoveAudioFile(args.path_, args.from_, args.to_);
+        bool result = true;
+        this->Reply(replyTo,"moveAudioFile", result);
+    }
+
+    void HandleSetOnboarding(int replyTo, json_reader *pReader)
+    {
+        bool value;
+        pReader->read(&value);
+        this->model.SetOnboarding(value);
+    }
+
+    void HandleGetWifiRegulatoryDomains(int replyTo, json_reader *pReader)
+    {
+        auto regulatoryDomains = this->model.GetWifiRegulatoryDomains();
+        this->Reply(replyTo, "getWifiRegulatoryDomains", regulatoryDomains);
+    }
+
+    void HandleSetAlsaSequencerConfiguration(int replyTo, json_reader *pReader)
+    {
+        AlsaSequencerConfiguration config;
+        pReader->read(&config);
+        this->model.SetAlsaSequencerConfiguration(config);
+        this->Reply(replyTo, "setAlsaSequencerConfiguration");
+    }
+
+    void HandleGetAlsaSequencerConfiguration(int replyTo, json_reader *pReader)
+    {
+        AlsaSequencerConfiguration config = this->model.GetAlsaSequencerConfiguration();
+        this->Reply(replyTo, "getAlsaSequencerConfiguration", config);
+    }
+
+    void HandleGetAlsaSequencerPorts(int replyTo, json_reader *pReader)
+    {
+        std::vector<AlsaSequencerPortSelection> result = model.GetAlsaSequencerPorts();
+        this->Reply(replyTo,"getAlsaSequencerPorts", result);
+    }
+
+    void HandleRequestBankPresets(int replyTo, json_reader *pReader)
+    {
+        RequestBankPresetsBody    args;
+        pReader->read(&args);
+        auto result = this->model.RequestBankPresets(args.bankInstanceId_);
+        this->Reply(replyTo,"requestBankPresets",result);
+    }
+
+    void HandleImportPresetsFromBank(int replyTo, json_reader *pReader)
+    {
+        ImportPresetsFromBankBody args;
+        pReader->read(&args);
+        SpawnRequest(replyTo, ImportPresetsFromBankAsync(replyTo, std::move(args)));
+    }
+    Task<void> ImportPresetsFromBankAsync(int replyTo, ImportPresetsFromBankBody args)
+    {
+        co_await ResumeOn(*orderedRequests);
+        auto result = this->model.ImportPresetsFromBank(args.bankInstanceId_, args.presets_);
+        this->Reply(replyTo,"importPresetsFromBank",result);
+    }
+
+    void HandleCopyPresetsToBank(int replyTo, json_reader *pReader)
+    {
+        CopyPresetsToBankBody args;
+        pReader->read(&args);
+        SpawnRequest(replyTo, CopyPresetsToBankAsync(replyTo, std::move(args)));
+    }
+    Task<void> CopyPresetsToBankAsync(int replyTo, CopyPresetsToBankBody args)
+    {
+        co_await ResumeOn(*orderedRequests);
+        auto result = this->model.CopyPresetsToBank(args.bankInstanceId_, args.presets_);
+        this->Reply(replyTo,"copyPresetsToBank",result);
+    }
 
-            model.SendGetPatchProperty(
-                this->clientId,
-                body.instanceId_,
-                body.propertyUri_,
-                [this, replyTo](const std::string &jsonResult)
-                {
-                    this->JsonReply(replyTo, "getPatchProperty", jsonResult.c_str());
-                },
-                [this, replyTo](const std::string &error)
-                {
-                    this->SendError(replyTo, error.c_str());
-                });
-        }
-        else if (message == "monitorPort")
-        {
+    static const SocketMessageDispatcher<PiPedalSocketHandler> &MessageDispatcher()
+    {
+        static const SocketMessageDispatcher<PiPedalSocketHandler> dispatcher{
+            {"setControl", &PiPedalSocketHandler::HandleSetControl},
+            {"previewControl", &PiPedalSocketHandler::HandlePreviewControl},
+            {"getControlHandles", &PiPedalSocketHandler::HandleGetControlHandles},
+            {"setControlByHandle", &PiPedalSocketHandler::HandleSetControlByHandle},
+            {"previewControlByHandle", &PiPedalSocketHandler::HandlePreviewControlByHandle},
+            {"setInputVolume", &PiPedalSocketHandler::HandleSetInputVolume},
+            {"setOutputVolume", &PiPedalSocketHandler::HandleSetOutputVolume},
+            {"previewInputVolume", &PiPedalSocketHandler::HandlePreviewInputVolume},
+            {"previewOutputVolume", &PiPedalSocketHandler::HandlePreviewOutputVolume},
+            {"listenForMidiEvent", &PiPedalSocketHandler::HandleListenForMidiEvent},
+            {"cancelListenForMidiEvent", &PiPedalSocketHandler::HandleCancelListenForMidiEvent},
+            {"monitorPatchProperty", &PiPedalSocketHandler::HandleMonitorPatchProperty},
+            {"cancelMonitorPatchProperty", &PiPedalSocketHandler::HandleCancelMonitorPatchProperty},
+            {"getUpdateStatus", &PiPedalSocketHandler::HandleGetUpdateStatus},
+            {"getHasWifi", &PiPedalSocketHandler::HandleGetHasWifi},
+            {"updateNow", &PiPedalSocketHandler::HandleUpdateNow},
+            {"getJackStatus", &PiPedalSocketHandler::HandleGetJackStatus},
+            {"getAudioPeriodTrace", &PiPedalSocketHandler::HandleGetAudioPeriodTrace},
+            {"resetCpuUseStatistics", &PiPedalSocketHandler::HandleResetCpuUseStatistics},
+            {"measureLatency", &PiPedalSocketHandler::HandleMeasureLatency},
+            {"getLatencyMeasurements", &PiPedalSocketHandler::HandleGetLatencyMeasurements},
+            {"syncBanks", &PiPedalSocketHandler::HandleSyncBanks},
+            {"getAlsaDevices", &PiPedalSocketHandler::HandleGetAlsaDevices},
+            {"getKnownWifiNetworks", &PiPedalSocketHandler::HandleGetKnownWifiNetworks},
+            {"requestWifiScan", &PiPedalSocketHandler::HandleRequestWifiScan},
+            {"getWifiChannels", &PiPedalSocketHandler::HandleGetWifiChannels},
+            {"getPluginPresets", &PiPedalSocketHandler::HandleGetPluginPresets},
+            {"loadPluginPreset", &PiPedalSocketHandler::HandleLoadPluginPreset},
+            {"setJackServerSettings", &PiPedalSocketHandler::HandleSetJackServerSettings},
+            {"setGovernorSettings", &PiPedalSocketHandler::HandleSetGovernorSettings},
+            {"setPmuProfiling", &PiPedalSocketHandler::HandleSetPmuProfiling},
+            {"startRecording", &PiPedalSocketHandler::HandleStartRecording},
+            {"stopRecording", &PiPedalSocketHandler::HandleStopRecording},
+            {"setDenormalDetection", &PiPedalSocketHandler::HandleSetDenormalDetection},
+            {"setWifiConfigSettings", &PiPedalSocketHandler::HandleSetWifiConfigSettings},
+            {"getWifiConfigSettings", &PiPedalSocketHandler::HandleGetWifiConfigSettings},
+            {"setWifiDirectConfigSettings", &PiPedalSocketHandler::HandleSetWifiDirectConfigSettings},
+            {"getWifiDirectConfigSettings", &PiPedalSocketHandler::HandleGetWifiDirectConfigSettings},
+            {"getGovernorSettings", &PiPedalSocketHandler::HandleGetGovernorSettings},
+            {"getJackServerSettings", &PiPedalSocketHandler::HandleGetJackServerSettings},
+            {"getBankIndex", &PiPedalSocketHandler::HandleGetBankIndex},
+            {"getBankIndexVersioned", &PiPedalSocketHandler::HandleGetBankIndexVersioned},
+            {"getJackConfiguration", &PiPedalSocketHandler::HandleGetJackConfiguration},
+            {"getJackSettings", &PiPedalSocketHandler::HandleGetJackSettings},
+            {"getPluginCostEstimates", &PiPedalSocketHandler::HandleGetPluginCostEstimates},
+            {"estimatePresetLoad", &PiPedalSocketHandler::HandleEstimatePresetLoad},
+            {"saveCurrentPreset", &PiPedalSocketHandler::HandleSaveCurrentPreset},
+            {"saveCurrentPresetAs", &PiPedalSocketHandler::HandleSaveCurrentPresetAs},
+            {"setSelectedPedalboardPlugin", &PiPedalSocketHandler::HandleSetSelectedPedalboardPlugin},
+            {"savePluginPresetAs", &PiPedalSocketHandler::HandleSavePluginPresetAs},
+            {"getPresets", &PiPedalSocketHandler::HandleGetPresets},
+            {"getPresetsVersioned", &PiPedalSocketHandler::HandleGetPresetsVersioned},
+            {"setPedalboardItemEnable", &PiPedalSocketHandler::HandleSetPedalboardItemEnable},
+            {"setPedalboardItemUseModUi", &PiPedalSocketHandler::HandleSetPedalboardItemUseModUi},
+            {"setPedalboardItemHardBypass", &PiPedalSocketHandler::HandleSetPedalboardItemHardBypass},
+            {"setPedalboardItemEssential", &PiPedalSocketHandler::HandleSetPedalboardItemEssential},
+            {"setPedalboardItemAlwaysRun", &PiPedalSocketHandler::HandleSetPedalboardItemAlwaysRun},
+            {"updateCurrentPedalboard", &PiPedalSocketHandler::HandleUpdateCurrentPedalboard},
+            {"setSnapshot", &PiPedalSocketHandler::HandleSetSnapshot},
+            {"setSnapshots", &PiPedalSocketHandler::HandleSetSnapshots},
+            {"currentPedalboard", &PiPedalSocketHandler::HandleCurrentPedalboard},
+            {"currentPedalboardVersioned", &PiPedalSocketHandler::HandleCurrentPedalboardVersioned},
+            {"plugins", &PiPedalSocketHandler::HandlePlugins},
+            {"pluginCatalogVersion", &PiPedalSocketHandler::HandlePluginCatalogVersion},
+            {"searchPlugins", &PiPedalSocketHandler::HandleSearchPlugins},
+            {"pluginClasses", &PiPedalSocketHandler::HandlePluginClasses},
+            {"enableBinaryTelemetry", &PiPedalSocketHandler::HandleEnableBinaryTelemetry},
+            {"ackVuUpdate", &PiPedalSocketHandler::HandleAckVuUpdate},
+            {"setTelemetryRate", &PiPedalSocketHandler::HandleSetTelemetryRate},
+            {"ackMonitorPortOutput", &PiPedalSocketHandler::HandleAckMonitorPortOutput},
+            {"hello", &PiPedalSocketHandler::HandleHello},
+            {"setJackSettings", &PiPedalSocketHandler::HandleSetJackSettings},
+            {"getPedalboardSlots", &PiPedalSocketHandler::HandleGetPedalboardSlots},
+            {"setPedalboardSlots", &PiPedalSocketHandler::HandleSetPedalboardSlots},
+            {"setPedalboardSlotPreset", &PiPedalSocketHandler::HandleSetPedalboardSlotPreset},
+            {"setShowStatusMonitor", &PiPedalSocketHandler::HandleSetShowStatusMonitor},
+            {"getShowStatusMonitor", &PiPedalSocketHandler::HandleGetShowStatusMonitor},
+            {"version", &PiPedalSocketHandler::HandleVersion},
+            {"loadPreset", &PiPedalSocketHandler::HandleLoadPreset},
+            {"updatePresets", &PiPedalSocketHandler::HandleUpdatePresets},
+            {"updatePluginPresets", &PiPedalSocketHandler::HandleUpdatePluginPresets},
+            {"moveBank", &PiPedalSocketHandler::HandleMoveBank},
+            {"shutdown", &PiPedalSocketHandler::HandleShutdown},
+            {"restart", &PiPedalSocketHandler::HandleRestart},
+            {"deletePresetItems", &PiPedalSocketHandler::HandleDeletePresetItems},
+            {"deleteBankItem", &PiPedalSocketHandler::HandleDeleteBankItem},
+            {"getHasTone3000Auth", &PiPedalSocketHandler::HandleGetHasTone3000Auth},
+            {"renameBank", &PiPedalSocketHandler::HandleRenameBank},
+            {"openBank", &PiPedalSocketHandler::HandleOpenBank},
+            {"saveBankAs", &PiPedalSocketHandler::HandleSaveBankAs},
+            {"nextBank", &PiPedalSocketHandler::HandleNextBank},
+            {"previousBank", &PiPedalSocketHandler::HandlePreviousBank},
+            {"nextPreset", &PiPedalSocketHandler::HandleNextPreset},
+            {"previousPreset", &PiPedalSocketHandler::HandlePreviousPreset},
+            {"renamePresetItem", &PiPedalSocketHandler::HandleRenamePresetItem},
+            {"copyPreset", &PiPedalSocketHandler::HandleCopyPreset},
+            {"copyPluginPreset", &PiPedalSocketHandler::HandleCopyPluginPreset},
+            {"setPatchProperty", &PiPedalSocketHandler::HandleSetPatchProperty},
+            {"setPedalboardItemTitle", &PiPedalSocketHandler::HandleSetPedalboardItemTitle},
+            {"getPatchProperty", &PiPedalSocketHandler::HandleGetPatchProperty},
+            {"monitorPort", &PiPedalSocketHandler::HandleMonitorPort},
+            {"unmonitorPort", &PiPedalSocketHandler::HandleUnmonitorPort},
+            {"addVuSubscription", &PiPedalSocketHandler::HandleAddVuSubscription},
+            {"removeVuSubscription", &PiPedalSocketHandler::HandleRemoveVuSubscription},
+            {"addEffectTimingSubscription", &PiPedalSocketHandler::HandleAddEffectTimingSubscription},
+            {"removeEffectTimingSubscription", &PiPedalSocketHandler::HandleRemoveEffectTimingSubscription},
+            {"imageList", &PiPedalSocketHandler::HandleImageList},
+            {"getFavorites", &PiPedalSocketHandler::HandleGetFavorites},
+            {"setFavorites", &PiPedalSocketHandler::HandleSetFavorites},
+            {"setUpdatePolicy", &PiPedalSocketHandler::HandleSetUpdatePolicy},
+            {"forceUpdateCheck", &PiPedalSocketHandler::HandleForceUpdateCheck},
+            {"setSystemMidiBindings", &PiPedalSocketHandler::HandleSetSystemMidiBindings},
+            {"getSystemMidiBindings", &PiPedalSocketHandler::HandleGetSystemMidiBindings},
+            {"requestFileList", &PiPedalSocketHandler::HandleRequestFileList},
+            {"requestFileList2", &PiPedalSocketHandler::HandleRequestFileList2},
+            {"newPreset", &PiPedalSocketHandler::HandleNewPreset},
+            {"deleteUserFile", &PiPedalSocketHandler::HandleDeleteUserFile},
+            {"createNewSampleDirectory", &PiPedalSocketHandler::HandleCreateNewSampleDirectory},
+            {"renameFilePropertyFile", &PiPedalSocketHandler::HandleRenameFilePropertyFile},
+            {"copyFilePropertyFile", &PiPedalSocketHandler::HandleCopyFilePropertyFile},
+            {"getFilePropertyDirectoryTree", &PiPedalSocketHandler::HandleGetFilePropertyDirectoryTree},
+            {"moveAudioFile", &PiPedalSocketHandler::HandleMoveAudioFile},
+            {"setOnboarding", &PiPedalSocketHandler::HandleSetOnboarding},
+            {"getWifiRegulatoryDomains", &PiPedalSocketHandler::HandleGetWifiRegulatoryDomains},
+            {"setAlsaSequencerConfiguration", &PiPedalSocketHandler::HandleSetAlsaSequencerConfiguration},
+            {"getAlsaSequencerConfiguration", &PiPedalSocketHandler::HandleGetAlsaSequencerConfiguration},
+            {"getAlsaSequencerPorts", &PiPedalSocketHandler::HandleGetAlsaSequencerPorts},
+            {"requestBankPresets", &PiPedalSocketHandler::HandleRequestBankPresets},
+            {"importPresetsFromBank", &PiPedalSocketHandler::HandleImportPresetsFromBank},
+            {"copyPresetsToBank", &PiPedalSocketHandler::HandleCopyPresetsToBank},
+        };
+        return dispatcher;
+    }
 
-            MonitorPortBody body;
-            pReader->read(&body);
+    /***********************/
 
-            MonitorPort(replyTo, body);
-        }
-        else if (message == "unmonitorPort")
+    void handleMessage(int reply, int replyTo, const std::string &message, json_reader *pReader)
+    {
+        if (reply != -1)
         {
-            int64_t subscriptionHandle;
-            pReader->read(&subscriptionHandle);
+            IRequestReservation *reservation = nullptr;
             {
+                std::lock_guard<std::recursive_mutex> guard(this->requestMutex);
+                auto i = this->requestReservations.find(reply);
+                if (i != this->requestReservations.end())
                 {
-                    std::lock_guard guard(activePortMonitorsMutex);
-                    for (auto i = this->activePortMonitors.begin(); i != this->activePortMonitors.end(); ++i)
-                    {
-                        if ((*i)->subscriptionHandle == subscriptionHandle)
-                        {
-                            auto subscription = (*i);
-                            subscription->Close();
-
-                            this->activePortMonitors.erase(i);
-                            break;
-                        }
-                    }
+                    reservation = i->second;
+                    requestReservations.erase(i);
                 }
-                model.UnmonitorPort(subscriptionHandle);
             }
-        }
-        else if (message == "addVuSubscription")
-        {
-            int64_t instanceId = -1;
-
-            pReader->read(&instanceId);
-
-            int64_t subscriptionHandle = model.AddVuSubscription(instanceId);
-
-            {
-                std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
-                activeVuSubscriptions.push_back(VuSubscription{subscriptionHandle, instanceId});
-            }
-            this->Reply(replyTo, "addVuSubscription", subscriptionHandle);
-        }
-        else if (message == "removeVuSubscription")
-        {
-            int64_t subscriptionHandle = -1;
-            pReader->read(&subscriptionHandle);
+            // be careful not to take down the whole server because of a client that's shutting down.
+            if (reservation != nullptr)
             {
-                std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
-
-                for (auto i = activeVuSubscriptions.begin(); i != activeVuSubscriptions.end(); ++i)
+                try
                 {
-                    if (i->subscriptionHandle == subscriptionHandle)
-                    {
-                        activeVuSubscriptions.erase(i);
-                        break;
-                    }
+                    reservation->onResult(pReader);
+                }
+                catch (const std::exception &e)
+                {
+                    Lv2Log::error("Socket: Invalid reply '%s'. (%s)", message.c_str(), e.what());
                 }
+                delete reservation;
             }
-            model.RemoveVuSubscription(subscriptionHandle);
-        }
-        else if (message == "imageList")
-        {
-
-            this->Reply(replyTo, "imageList", imageList);
-        }
-        else if (message == "getFavorites")
-        {
-            std::map<std::string, bool> favorites = this->model.GetFavorites();
-            this->Reply(replyTo, "getFavorites", favorites);
-        }
-        else if (message == "setFavorites")
-        {
-            std::map<std::string, bool> favorites;
-            pReader->read(&favorites);
-            this->model.SetFavorites(favorites);
-        }
-        else if (message == "setUpdatePolicy")
-        {
-            int iPolicy;
-            pReader->read(&iPolicy);
-
-            this->model.SetUpdatePolicy((UpdatePolicyT)iPolicy);
-        }
-        else if (message == "forceUpdateCheck")
-        {
-            this->model.ForceUpdateCheck();
-        }
-        else if (message == "setSystemMidiBindings")
-        {
-            std::vector<MidiBinding> bindings;
-            pReader->read(&bindings);
-            this->model.SetSystemMidiBindings(bindings);
-        }
-        else if (message == "getSystemMidiBindings")
-        {
-            std::vector<MidiBinding> bindings = this->model.GetSystemMidiBidings();
-            this->Reply(replyTo, "getSystemMidiBindings", bindings);
-        }
-        else if (message == "requestFileList")
-        {
-            throw std::runtime_error("No longer implemented.");
-        }
-        else if (message == "requestFileList2")
-        {
-            FileRequestArgs requestArgs;
-            pReader->read(&requestArgs);
-            FileRequestResult result = this->model.GetFileList2(requestArgs.relativePath_, requestArgs.fileProperty_);
-            this->Reply(replyTo, "requestFileList2", result);
-        }
-        else if (message == "newPreset")
-        {
-            int64_t presetId = this->model.CreateNewPreset();
-            this->Reply(replyTo, "newPreset", presetId);
-        }
-        else if (message == "deleteUserFile")
-        {
-            std::string fileName;
-            pReader->read(&fileName);
-
-            this->model.DeleteSampleFile(fileName);
-            this->Reply(replyTo, "deleteUserFile", true);
-        }
-        else if (message == "createNewSampleDirectory")
-        {
-            CreateNewSampleDirectoryArgs args;
-            pReader->read(&args);
-
-            std::string newFileName = this->model.CreateNewSampleDirectory(args.relativePath_, args.uiFileProperty_);
-            this->Reply(replyTo, "createNewSampleDirectory", newFileName);
-        }
-        else if (message == "renameFilePropertyFile")
-        {
-            RenameSampleFileArgs args;
-            pReader->read(&args);
-
-            std::string newFileName = this->model.RenameFilePropertyFile(args.oldRelativePath_, args.newRelativePath_, args.uiFileProperty_);
-            this->Reply(replyTo, "renameFilePropertyFile", newFileName);
-        }
-        else if (message == "copyFilePropertyFile")
-        {
-            CopySampleFileArgs args;
-            pReader->read(&args);
-
-            std::string newFileName = this->model.CopyFilePropertyFile(args.oldRelativePath_, args.newRelativePath_, args.uiFileProperty_, args.overwrite_);
-            this->Reply(replyTo, "copyFilePropertyFile", newFileName);
-        }
-        else if (message == "getFilePropertyDirectoryTree")
-        {
-            GetFilePropertyDirectoryTreeArgs args;
-            pReader->read(&args);
-            FilePropertyDirectoryTree::ptr result =
-                model.GetFilePropertydirectoryTree(
-                    args.fileProperty_,
-                    args.selectedPath_);
-            this->Reply(replyTo, "GetFilePropertydirectoryTree", result);
-        }
-        else if (message == "getFilePropertyDirectoryTree")
-        {
-            GetFilePropertyDirectoryTreeArgs args;
-            pReader->read(&args);
-            FilePropertyDirectoryTree::ptr result =
-                model.GetFilePropertydirectoryTree(
-                    args.fileProperty_,
-                    args.selectedPath_);
-            this->Reply(replyTo, "GetFilePropertydirectoryTree", result);
-        }
-
-        else if (message == "moveAudioFile")
-        {
-            MoveAudioFileArgs args;
-            pReader->read(&args);
-            this->model.MoveAudioFile(args.path_, args.from_, args.to_);
-            bool result = true;
-            this->Reply(replyTo,"moveAudioFile", result);   
-        }
-        else if (message == "setOnboarding")
-        {
-            bool value;
-            pReader->read(&value);
-            this->model.SetOnboarding(value);
-        }
-        else if (message == "getWifiRegulatoryDomains")
-        {
-            auto regulatoryDomains = this->model.GetWifiRegulatoryDomains();
-            this->Reply(replyTo, "getWifiRegulatoryDomains", regulatoryDomains);
-        } else if (message == "setAlsaSequencerConfiguration")
-        {
-            AlsaSequencerConfiguration config;
-            pReader->read(&config);
-            this->model.SetAlsaSequencerConfiguration(config);
-            this->Reply(replyTo, "setAlsaSequencerConfiguration");
-        }
-        else if (message == "getAlsaSequencerConfiguration")
-        {
-            AlsaSequencerConfiguration config = this->model.GetAlsaSequencerConfiguration();
-            this->Reply(replyTo, "getAlsaSequencerConfiguration", config);
+            else
+            {
+                Lv2Log::warning("Socket: Reply '%s' with nobody waiting.", message.c_str());
+            }
+            return;
         }
-        else if (message == "getAlsaSequencerPorts")
+        if (closed)
         {
-            std::vector<AlsaSequencerPortSelection> result = model.GetAlsaSequencerPorts();
-            this->Reply(replyTo,"getAlsaSequencerPorts", result);
-        } else if (message == "requestBankPresets") {
-            
-            RequestBankPresetsBody    args;
-            pReader->read(&args);
-            auto result = this->model.RequestBankPresets(args.bankInstanceId_);
-            this->Reply(replyTo,"requestBankPresets",result);
-
-        }
-        else if (message == "importPresetsFromBank") {
-            ImportPresetsFromBankBody args;
-            pReader->read(&args);
-            auto result = this->model.ImportPresetsFromBank(args.bankInstanceId_, args.presets_);
-            this->Reply(replyTo,"importPresetsFromBank",result);
-        }
-        else if (message == "copyPresetsToBank") {
-            CopyPresetsToBankBody args;
-            pReader->read(&args);
-            auto result = this->model.CopyPresetsToBank(args.bankInstanceId_, args.presets_);
-            this->Reply(replyTo,"copyPresetsToBank",result);
+            this->SendError(replyTo, "Server has shut down.");
         }
-        else
+        TraceScope traceScope("websocket", Tracer::IsEnabled() ? Tracer::Intern(message) : nullptr);
+        if (!MessageDispatcher().Dispatch(this, message, replyTo, pReader))
         {
             Lv2Log::error("Unknown message received: %s", message.c_str());
             SendError(replyTo, std::string("Unknown message: ") + message);
@@ -1859,14 +2934,33 @@ protected:
     virtual void
     onSocketClosed() override
     {
-        SocketHandler::OnSocketClosed();
+        {
+            std::lock_guard<std::recursive_mutex> guard(this->writeMutex);
+            if (attachedConnection != nullptr)
+            {
+                return; // the session has moved to a newer connection.
+            }
+            SocketHandler::OnSocketClosed();
+        }
+        if (resumedSession)
+        {
+            resumedSession->OnResumedConnectionClosed(this);
+        }
+        else if (!sessionToken.empty() && !closed)
+        {
+            Detach();
+            return;
+        }
         this->Close();
     }
     virtual void onReceive(const std::string_view &text)
     {
-        view_istream<char> s(text);
-
-        json_reader reader(s);
+        if (resumedSession)
+        {
+            resumedSession->onReceive(text);
+            return;
+        }
+        json_reader reader(text);
         // read top level object until we have message
         int64_t replyTo = -1;
         int64_t reply = -1;
@@ -1874,39 +2968,8 @@ protected:
 
         try
         {
-            reader.consume('[');
-            reader.consume('{');
-
-            while (true)
-            {
-                if (reader.peek() == '}')
-                {
-                    reader.consume('}');
-                    break;
-                }
-                std::string name = reader.read_string();
-                reader.consume(':');
-                if (name == "reply")
-                {
-                    reader.read(&reply);
-                }
-                if (name == "replyTo")
-                {
-                    reader.read(&replyTo);
-                }
-                if (name == "message")
-                {
-                    message = reader.read_string();
-                }
-                if (reader.peek() == ',')
-                {
-                    reader.consume(',');
-                    continue;
-                }
-            }
-            if (reader.peek() == ',')
+            if (ReadSocketMessageHeader(reader, &reply, &replyTo, &message))
             {
-                reader.consume(',');
                 handleMessage(reply, replyTo, message, &reader);
             }
             else
@@ -1942,6 +3005,13 @@ private:
         Send("onLv2PluginsChanging", true);
         Flush();
     }
+    virtual void OnLv2PluginsUpdated(const Lv2PluginListDelta &delta) override
+    {
+        if (hasPluginList)
+        {
+            Send("onLv2PluginsUpdated", delta);
+        }
+    }
     virtual void OnHasWifiChanged(bool hasWifi)
     {
         Send("onHasWifiChanged", hasWifi);
@@ -1968,6 +3038,14 @@ private:
     {
         Send("onTone3000AuthChanged", value);
     }
+    virtual void OnAudioFilesChanged(const std::string &directory) override
+    {
+        Send("onAudioFilesChanged", directory);
+    }
+    virtual void OnPresetBundleProgress(const PresetBundleProgress &progress) override
+    {
+        Send("onPresetBundleProgress", progress);
+    }
 
     virtual void OnErrorMessage(const std::string &message)
     {
@@ -2024,12 +3102,23 @@ private:
         Send("onPresetChanged", changed);
     }
 
-    virtual void OnPresetsChanged(int64_t clientId, const PresetIndex &presets)
+    virtual void OnPresetsChanged(int64_t clientId, const PresetIndex &presets, int64_t version, SharedNotification &notification)
+    {
+        SendShared(notification, "onPresetsChanged",
+                   [clientId, &presets, version]()
+                   {
+                       PresetsChangedBody body;
+                       body.clientId_ = clientId;
+                       body.version_ = version;
+                       body.presets_ = const_cast<PresetIndex *>(&presets);
+                       return body;
+                   });
+    }
+    virtual void OnPresetsPatched(const IndexPatch &patch, SharedNotification &notification)
     {
-        PresetsChangedBody body;
-        body.clientId_ = clientId;
-        body.presets_ = const_cast<PresetIndex *>(&presets);
-        Send("onPresetsChanged", body);
+        SendShared(notification, "onPresetsPatched",
+                   [&patch]() -> const IndexPatch &
+                   { return patch; });
     }
     virtual void OnPluginPresetsChanged(const std::string &pluginUri)
     {
@@ -2054,9 +3143,38 @@ private:
     virtual void OnVuMeterUpdate(const std::vector<VuUpdate> &updates)
     {
         std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+        if (!clientVisible)
+        {
+            // other clients are watching these instances, but we aren't.
+            return;
+        }
         if (updateRequestOutstanding < 5) // throttle to accomodate a web page that can't keep up.
         {
             vuUpdateDropped = false;
+            if (binaryTelemetry)
+            {
+                // All updates go in one frame, acknowledged by an ackVuUpdate message.
+                BinaryTelemetryWriter writer(BinaryTelemetryWriter::FrameType::VuUpdate);
+                for (const VuUpdate &vuUpdate : updates)
+                {
+                    for (const auto &subscription : activeVuSubscriptions)
+                    {
+                        if (subscription.instanceId == vuUpdate.instanceId_)
+                        {
+                            writer.AddVuUpdate(vuUpdate);
+                            break;
+                        }
+                    }
+                }
+                if (writer.GetCount() != 0)
+                {
+                    if (SendBinary(writer.GetFrame()))
+                    {
+                        updateRequestOutstanding++;
+                    }
+                }
+                return;
+            }
             for (int i = 0; i < updates.size(); ++i)
             {
                 const VuUpdate &vuUpdate = updates[i];
@@ -2096,6 +3214,19 @@ private:
         }
     }
 
+    virtual void OnEffectTimingUpdate(const std::vector<EffectTiming> &timings)
+    {
+        bool interested;
+        {
+            std::lock_guard<std::recursive_mutex> guard(subscriptionMutex);
+            interested = activeEffectTimingSubscriptions.size() != 0;
+        }
+        if (interested)
+        {
+            SendDroppable("onEffectTimingUpdate", timings);
+        }
+    }
+
     virtual void OnVst3ControlChanged(int64_t clientId, int64_t instanceId, const std::string &key, float value, const std::string &state)
     {
         Vst3ControlChangedBody body;
@@ -2107,14 +3238,92 @@ private:
         Send("onVst3ControlChanged", body);
     }
 
+    // Control changes are coalesced by (instanceId, symbol), and sent in a single onControlChangedBatch
+    // message, either after a short delay, or when enough distinct controls have changed.
+    static constexpr std::chrono::milliseconds CONTROL_CHANGE_FLUSH_DELAY{20};
+    static constexpr size_t CONTROL_CHANGE_FLUSH_THRESHOLD = 64;
+
+    std::mutex pendingControlChangesMutex;
+    std::vector<ControlChangedBody> pendingControlChanges;
+    bool controlChangeFlushPosted = false;
+
+    void FlushControlChanges()
+    {
+        // writeMutex is held throughout so that the batch can't be overtaken by a subsequent message.
+        std::lock_guard<std::recursive_mutex> writeGuard(this->writeMutex);
+        std::vector<ControlChangedBody> batch;
+        {
+            std::lock_guard lock(pendingControlChangesMutex);
+            controlChangeFlushPosted = false;
+            if (pendingControlChanges.empty())
+            {
+                return;
+            }
+            batch.swap(pendingControlChanges);
+        }
+        Reply(-1, "onControlChangedBatch", batch);
+    }
+
     virtual void OnControlChanged(int64_t clientId, int64_t instanceId, const std::string &key, float value)
     {
-        ControlChangedBody body;
-        body.clientId_ = clientId;
-        body.instanceId_ = instanceId;
-        body.symbol_ = key;
-        body.value_ = value;
-        Send("onControlChanged", body);
+        bool flushNow = false;
+        bool postFlush = false;
+        {
+            std::lock_guard lock(pendingControlChangesMutex);
+            bool found = false;
+            for (auto &pendingChange : pendingControlChanges)
+            {
+                if (pendingChange.instanceId_ == instanceId && pendingChange.symbol_ == key)
+                {
+                    pendingChange.clientId_ = clientId;
+                    pendingChange.value_ = value;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found)
+            {
+                ControlChangedBody body;
+                body.clientId_ = clientId;
+                body.instanceId_ = instanceId;
+                body.symbol_ = key;
+                body.value_ = value;
+                pendingControlChanges.push_back(std::move(body));
+            }
+            if (pendingControlChanges.size() >= CONTROL_CHANGE_FLUSH_THRESHOLD)
+            {
+                flushNow = true;
+            }
+            else if (!controlChangeFlushPosted)
+            {
+                controlChangeFlushPosted = true;
+                postFlush = true;
+            }
+        }
+        if (postFlush)
+        {
+            std::weak_ptr<PiPedalSocketHandler> weakThis = shared_from_this();
+            try
+            {
+                model.PostDelayed(
+                    CONTROL_CHANGE_FLUSH_DELAY,
+                    [weakThis]()
+                    {
+                        if (auto self = weakThis.lock())
+                        {
+                            self->FlushControlChanges();
+                        }
+                    });
+            }
+            catch (const std::exception &)
+            {
+                flushNow = true; // no dispatcher yet.
+            }
+        }
+        if (flushNow)
+        {
+            FlushControlChanges();
+        }
     }
     virtual void OnInputVolumeChanged(float value)
     {
@@ -2127,51 +3336,59 @@ private:
         Send("onOutputVolumeChanged", value);
     }
 
-    class DeferredValue
-    {
-    public:
-        int64_t instanceId;
-        std::string symbol;
-        float value;
-    };
-
-    std::vector<DeferredValue> deferredValues;
+    std::vector<ControlValueChange> deferredValues;
+    std::vector<ControlValueChange> inFlightMidiValues; // sent, but not yet acknowledged.
     bool midiValueChangedOutstanding = false;
 
-    virtual void OnMidiValueChanged(int64_t instanceId, const std::string &symbol, float value)
+    virtual void OnMidiValuesChanged(const std::vector<ControlValueChange> &changes)
     {
         if (midiValueChangedOutstanding)
         {
-            for (size_t i = 0; i < deferredValues.size(); ++i)
+            // keep only the latest value of each control until the client catches up.
+            for (const auto &change : changes)
             {
-                auto &deferredValue = deferredValues[i];
-                if (deferredValue.instanceId == instanceId && deferredValue.symbol == symbol)
+                bool found = false;
+                for (auto &deferredValue : deferredValues)
                 {
-                    deferredValue.value = value;
-                    return;
+                    if (deferredValue.instanceId == change.instanceId && deferredValue.symbol == change.symbol)
+                    {
+                        deferredValue.value = change.value;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    deferredValues.push_back(change);
                 }
             }
-            DeferredValue newValue{instanceId, symbol, value};
-            deferredValues.push_back(newValue);
         }
         else
         {
             midiValueChangedOutstanding = true;
-            ControlChangedBody body;
-            body.clientId_ = -1;
-            body.instanceId_ = instanceId;
-            body.symbol_ = symbol;
-            body.value_ = value;
+            inFlightMidiValues = changes;
+            std::vector<ControlChangedBody> body;
+            body.reserve(changes.size());
+            for (const auto &change : changes)
+            {
+                ControlChangedBody item;
+                item.clientId_ = -1;
+                item.instanceId_ = change.instanceId;
+                item.symbol_ = change.symbol;
+                item.value_ = change.value;
+                body.push_back(std::move(item));
+            }
             Request<bool>(
-                "onMidiValueChanged", body,
+                "onMidiValuesChanged", body,
                 [this](const bool &value)
                 {
+                    this->inFlightMidiValues.clear();
                     this->midiValueChangedOutstanding = false;
                     if (this->deferredValues.size() != 0)
                     {
-                        DeferredValue value = deferredValues[0];
-                        deferredValues.erase(deferredValues.begin());
-                        this->OnMidiValueChanged(value.instanceId, value.symbol, value.value);
+                        std::vector<ControlValueChange> values = std::move(deferredValues);
+                        deferredValues.clear();
+                        this->OnMidiValuesChanged(values);
                     }
                 },
                 [](const std::exception &e) {
@@ -2279,9 +3496,22 @@ private:
         Send("onNotifyMidiListener", body);
     }
 
-    virtual void OnBankIndexChanged(const BankIndex &bankIndex)
+    virtual void OnBankIndexChanged(const BankIndex &bankIndex, int64_t version, SharedNotification &notification)
+    {
+        SendShared(notification, "onBanksChanged",
+                   [&bankIndex, version]()
+                   {
+                       BanksChangedBody body;
+                       body.version_ = version;
+                       body.banks_ = const_cast<BankIndex *>(&bankIndex);
+                       return body;
+                   });
+    }
+    virtual void OnBankIndexPatched(const IndexPatch &patch, SharedNotification &notification)
     {
-        Send("onBanksChanged", bankIndex);
+        SendShared(notification, "onBanksPatched",
+                   [&patch]() -> const IndexPatch &
+                   { return patch; });
     }
 
     virtual void OnJackServerSettingsChanged(const JackServerSettings &jackServerSettings)
@@ -2302,12 +3532,23 @@ private:
         Send("onGovernorSettingsChanged", governor);
     }
 
-    virtual void OnPedalboardChanged(int64_t clientId, const Pedalboard &pedalboard)
+    virtual void OnPedalboardChanged(int64_t clientId, const Pedalboard &pedalboard, int64_t version, SharedNotification &notification)
+    {
+        SendShared(notification, "onPedalboardChanged",
+                   [clientId, &pedalboard, version]()
+                   {
+                       UpdateCurrentPedalboardBody body;
+                       body.clientId_ = clientId;
+                       body.pedalboard_ = pedalboard;
+                       body.version_ = version;
+                       return body;
+                   });
+    }
+    virtual void OnPedalboardPatched(const PedalboardPatch &patch, SharedNotification &notification)
     {
-        UpdateCurrentPedalboardBody body;
-        body.clientId_ = clientId;
-        body.pedalboard_ = pedalboard;
-        Send("onPedalboardChanged", body);
+        SendShared(notification, "onPedalboardPatched",
+                   [&patch]() -> const PedalboardPatch &
+                   { return patch; });
     }
 
     virtual void OnItemEnabledChanged(int64_t clientId, int64_t pedalItemId, bool enabled)
@@ -2331,17 +3572,94 @@ private:
 
 std::atomic<uint64_t> PiPedalSocketHandler::nextClientId = 0;
 
+std::string PiPedalSessionRegistry::Add(const std::shared_ptr<PiPedalSocketHandler> &session)
+{
+    std::lock_guard lock{mutex};
+    std::string token;
+    do
+    {
+        std::stringstream s;
+        s << std::hex << random() << random();
+        token = s.str();
+    } while (sessions.contains(token));
+    sessions[token] = session;
+    return token;
+}
+
+void PiPedalSessionRegistry::Remove(const std::string &token)
+{
+    std::shared_ptr<PiPedalSocketHandler> detachedSession; // released after the lock.
+    std::lock_guard lock{mutex};
+    sessions.erase(token);
+    auto i = detachedSessions.find(token);
+    if (i != detachedSessions.end())
+    {
+        detachedSession = std::move(i->second.session);
+        detachedSessions.erase(i);
+    }
+}
+
+void PiPedalSessionRegistry::Detach(const std::string &token, std::shared_ptr<PiPedalSocketHandler> session)
+{
+    uint64_t detachId;
+    {
+        std::lock_guard lock{mutex};
+        detachId = ++nextDetachId;
+        detachedSessions[token] = DetachedSession{std::move(session), detachId};
+    }
+    std::weak_ptr<PiPedalSessionRegistry> weakThis = shared_from_this();
+    model.PostDelayed(
+        SESSION_RESUME_TIMEOUT,
+        [weakThis, token, detachId]()
+        {
+            if (auto registry = weakThis.lock())
+            {
+                registry->Expire(token, detachId);
+            }
+        });
+}
+
+std::shared_ptr<PiPedalSocketHandler> PiPedalSessionRegistry::Resume(const std::string &token)
+{
+    std::shared_ptr<PiPedalSocketHandler> result;
+    std::lock_guard lock{mutex};
+    auto i = sessions.find(token);
+    if (i != sessions.end())
+    {
+        result = i->second.lock();
+    }
+    detachedSessions.erase(token);
+    return result;
+}
+
+void PiPedalSessionRegistry::Expire(const std::string &token, uint64_t detachId)
+{
+    std::shared_ptr<PiPedalSocketHandler> session;
+    {
+        std::lock_guard lock{mutex};
+        auto i = detachedSessions.find(token);
+        if (i == detachedSessions.end() || i->second.detachId != detachId)
+        {
+            return; // resumed, or detached again since.
+        }
+        session = std::move(i->second.session);
+        detachedSessions.erase(i);
+    }
+    session->Close();
+}
+
 class PiPedalSocketFactory : public ISocketFactory
 {
 private:
     PiPedalModel &model;
+    std::shared_ptr<PiPedalSessionRegistry> sessionRegistry;
 
 public:
     virtual ~PiPedalSocketFactory()
     {
     }
     PiPedalSocketFactory(PiPedalModel &model)
-        : model(model)
+        : model(model), sessionRegistry(std::make_shared<PiPedalSessionRegistry>(model))
     {
     }
 
@@ -2354,7 +3672,7 @@ public:
     }
     virtual std::shared_ptr<SocketHandler> CreateHandler(const uri &request)
     {
-        return std::make_shared<PiPedalSocketHandler>(model);
+        return std::make_shared<PiPedalSocketHandler>(model, sessionRegistry);
     }
 };
 
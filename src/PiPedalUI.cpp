@@ -29,6 +29,7 @@
 #include "AutoLilvNode.hpp"
 #include "ModFileTypes.hpp"
 #include <algorithm>
+#include <sstream>
 #include "util.hpp"
 #include "MimeTypes.hpp"
 
@@ -695,6 +696,137 @@ std::string UiFileProperty::getParentModDirectory(const std::filesystem::path&pa
     return "";
 }
 
+LazyPiPedalUI::LazyPiPedalUI(const PiPedalUI::ptr &value)
+{
+    *this = value;
+}
+
+LazyPiPedalUI &LazyPiPedalUI::operator=(const PiPedalUI::ptr &value)
+{
+    if (value)
+    {
+        // a new state; copies of the previous value keep theirs.
+        this->state = std::make_shared<State>();
+        this->state->value = value;
+    }
+    else
+    {
+        this->state = nullptr;
+    }
+    return *this;
+}
+
+bool LazyPiPedalUI::empty() const
+{
+    return !state;
+}
+
+bool LazyPiPedalUI::isParsed() const
+{
+    if (!state)
+        return true;
+    std::lock_guard lock{state->mutex};
+    return !!state->value;
+}
+
+PiPedalUI::ptr LazyPiPedalUI::get() const
+{
+    if (!state)
+        return nullptr;
+    std::lock_guard lock{state->mutex};
+    if (!state->value)
+    {
+        auto value = std::make_shared<PiPedalUI>();
+        try
+        {
+            json_reader reader(state->json);
+            reader.read(value.get());
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS("Invalid cached PiPedal UI. " << e.what()));
+            value = std::make_shared<PiPedalUI>();
+        }
+        for (auto &fileProperty : value->fileProperties())
+        {
+            fileProperty->PrecalculateFileExtensions();
+        }
+        state->value = value;
+        state->json = std::string();
+    }
+    return state->value;
+}
+
+std::string LazyPiPedalUI::GetMemberJson(const std::string &memberName) const
+{
+    if (!state)
+        return "[]";
+
+    std::string json;
+    {
+        std::lock_guard lock{state->mutex};
+        if (state->value)
+        {
+            std::ostringstream s;
+            json_writer writer(s);
+            writer.write(state->value);
+            json = s.str();
+        }
+        else
+        {
+            json = state->json;
+        }
+    }
+    json_reader reader(json);
+    reader.start_object();
+    while (reader.peek() != '}')
+    {
+        std::string name = reader.read_string();
+        reader.consume(':');
+        std::string_view value = reader.read_raw();
+        if (name == memberName)
+        {
+            return std::string(value);
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+        }
+    }
+    return "[]";
+}
+
+void LazyPiPedalUI::write_json(json_writer &writer) const
+{
+    if (!state)
+    {
+        writer.write_raw("null");
+        return;
+    }
+    std::lock_guard lock{state->mutex};
+    if (state->value)
+    {
+        writer.write(state->value);
+    }
+    else
+    {
+        // copy the text without parsing it.
+        writer.write_raw(state->json.c_str());
+    }
+}
+
+void LazyPiPedalUI::read_json(json_reader &reader)
+{
+    if (reader.peek() == 'n')
+    {
+        reader.read_null();
+        this->state = nullptr;
+        return;
+    }
+    this->state = std::make_shared<State>();
+    this->state->json = reader.read_raw();
+}
+
 
 JSON_MAP_BEGIN(UiPortNotification)
 JSON_MAP_REFERENCE(UiPortNotification, portIndex)
@@ -721,6 +853,12 @@ JSON_MAP_REFERENCE(UiFileProperty, modDirectories)
 JSON_MAP_REFERENCE(UiFileProperty, useLegacyModDirectory)
 JSON_MAP_END()
 
+JSON_MAP_BEGIN(PiPedalUI)
+JSON_MAP_REFERENCE(PiPedalUI, fileProperties)
+JSON_MAP_REFERENCE(PiPedalUI, frequencyPlots)
+JSON_MAP_REFERENCE(PiPedalUI, portNotifications)
+JSON_MAP_END()
+
 JSON_MAP_BEGIN(UiFrequencyPlot)
 JSON_MAP_REFERENCE(UiFrequencyPlot, patchProperty)
 JSON_MAP_REFERENCE(UiFrequencyPlot, index)
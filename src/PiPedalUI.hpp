@@ -30,6 +30,7 @@
 #include "json.hpp"
 #include <filesystem>
 #include <set>
+#include <mutex>
 #include "ModFileTypes.hpp"
 #include "stdint.h"
 
@@ -135,9 +136,11 @@ namespace pipedal
         std::vector<std::string> modDirectories_;
         bool useLegacyModDirectory_ = false;
         std::map<std::string, std::set<std::string>> fileExtensionsByModDirectory; // non-serialized.
-        void PrecalculateFileExtensions();
 
     public:
+        // Rebuilds non-serialized state. Must be called after reading a UiFileProperty from json.
+        void PrecalculateFileExtensions();
+
         using ptr = std::shared_ptr<UiFileProperty>;
         UiFileProperty() {}
         UiFileProperty(PluginHost *pHost, const LilvNode *node, const std::filesystem::path &resourcePath);
@@ -225,6 +228,7 @@ namespace pipedal
     {
     public:
         using ptr = std::shared_ptr<PiPedalUI>;
+        PiPedalUI() {}
         PiPedalUI(PluginHost *pHost, const LilvNode *uiNode, const std::filesystem::path &resourcePath);
         PiPedalUI(
             std::vector<UiFileProperty::ptr> &&fileProperties,
@@ -262,6 +266,42 @@ namespace pipedal
         std::vector<UiFileProperty::ptr> fileProperties_;
         std::vector<UiFrequencyPlot::ptr> frequencyPlots_;
         std::vector<UiPortNotification::ptr> portNotifications_;
+
+    public:
+        DECLARE_JSON_MAP(PiPedalUI);
+    };
+
+    // A PiPedalUI that is read from the plugin cache as json text, and parsed the first time it is used.
+    // Most installed plugins are never loaded, so there's no point in parsing and keeping a PiPedalUI
+    // resident for each of them at startup. Copies share the same (lazily parsed) instance.
+    class LazyPiPedalUI : public JsonSerializable
+    {
+    public:
+        LazyPiPedalUI() {}
+        LazyPiPedalUI(const PiPedalUI::ptr &value);
+        LazyPiPedalUI &operator=(const PiPedalUI::ptr &value);
+
+        bool empty() const;
+        bool isParsed() const;
+
+        // Parses the PiPedalUI, if that hasn't been done yet.
+        PiPedalUI::ptr get() const;
+
+        // The json text of a member of the PiPedalUI (e.g. "fileProperties"), without parsing the rest
+        // of the PiPedalUI. "[]" if there is no such member.
+        std::string GetMemberJson(const std::string &memberName) const;
+
+        virtual void write_json(json_writer &writer) const override;
+        virtual void read_json(json_reader &reader) override;
+
+    private:
+        struct State
+        {
+            std::mutex mutex;
+            PiPedalUI::ptr value;
+            std::string json;
+        };
+        std::shared_ptr<State> state;
     };
 
     // utilities for validating file paths received via PiPedalFileProperty-related APIs.
@@ -0,0 +1,604 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Robin E. R. Davies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pch.h"
+#include "PipeWireDriver.hpp"
+#include "ss.hpp"
+#include "PiPedalException.hpp"
+#include "SchedulerPriority.hpp"
+#include "CpuUse.hpp"
+#include "Lv2Log.hpp"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+extern "C"
+{
+#include <pipewire/pipewire.h>
+#include <pipewire/filter.h>
+}
+
+using namespace pipedal;
+
+namespace pipedal
+{
+    static constexpr const char *PIPEWIRE_DEVICE_PREFIX = "pipewire:";
+
+    static void InitPipeWire()
+    {
+        static std::once_flag initFlag;
+        std::call_once(initFlag, []()
+                       { pw_init(nullptr, nullptr); });
+    }
+
+    static int IndexFromPortName(const std::string &s)
+    {
+        auto pos = s.find_last_of('_');
+        if (pos == std::string::npos)
+        {
+            throw std::invalid_argument("Bad port name.");
+        }
+        int v = atoi(s.c_str() + (pos + 1));
+        if (v < 0)
+        {
+            throw std::invalid_argument("Bad port name.");
+        }
+        return v;
+    }
+
+    class PipeWireDriverImpl : public AudioDriver
+    {
+    private:
+        pipedal::CpuUse cpuUse;
+        AudioDriverHost *driverHost = nullptr;
+
+        JackServerSettings jackServerSettings;
+        JackChannelSelection channelSelection;
+        AlsaSequencer::ptr alsaSequencer;
+
+        uint32_t sampleRate = 0;
+        uint32_t bufferSize = 0; // the largest period passed to the host.
+        uint32_t channels = 2;
+
+        pw_thread_loop *threadLoop = nullptr;
+        pw_filter *filter = nullptr;
+        std::vector<void *> capturePorts;  // indexed by channel.
+        std::vector<void *> playbackPorts; // indexed by channel.
+
+        // selected channels.
+        std::vector<void *> activeCapturePorts;
+        std::vector<void *> activePlaybackPorts;
+
+        // PipeWire's own DSP buffers, offset to the current chunk.
+        std::vector<float *> activeCaptureBuffers;
+        std::vector<float *> activePlaybackBuffers;
+        std::vector<float *> captureBase;
+        std::vector<float *> playbackBase;
+
+        // stand-ins for ports that don't have a buffer this cycle.
+        std::vector<float> silenceBuffer;
+        std::vector<float> scratchBuffer;
+
+        static constexpr size_t MIDI_MEMORY_BUFFER_SIZE = 32 * 1024;
+        static constexpr size_t MAX_MIDI_EVENT = 4 * 1024;
+
+        size_t midiEventCount = 0;
+        std::vector<MidiEvent> midiEvents;
+        size_t midiEventMemoryIndex = 0;
+        std::vector<uint8_t> midiEventMemory;
+
+        bool open = false;
+        bool activated = false;
+
+        // audio thread.
+        bool threadInitialized = false;
+        uint64_t expectedClockPosition = 0;
+
+        // the graph's actual quantum and rate, which may not match what we asked for.
+        std::atomic<uint32_t> graphQuantum = 0;
+        std::atomic<uint32_t> graphRate = 0;
+
+    public:
+        PipeWireDriverImpl(AudioDriverHost *driverHost)
+            : driverHost(driverHost)
+        {
+            midiEventMemory.resize(MIDI_MEMORY_BUFFER_SIZE);
+            midiEvents.resize(MAX_MIDI_EVENT);
+        }
+        virtual ~PipeWireDriverImpl()
+        {
+            Close();
+        }
+
+    private:
+        static void on_process(void *userData, spa_io_position *position)
+        {
+            ((PipeWireDriverImpl *)userData)->OnPipeWireProcess(position);
+        }
+        static void on_state_changed(void *userData, pw_filter_state old, pw_filter_state state, const char *error)
+        {
+            ((PipeWireDriverImpl *)userData)->OnStateChanged(old, state, error);
+        }
+        static const pw_filter_events filterEvents;
+
+        void OnStateChanged(pw_filter_state old, pw_filter_state state, const char *error)
+        {
+            Lv2Log::debug(SS("PipeWire filter state: " << pw_filter_state_as_string(old) << " -> " << pw_filter_state_as_string(state)));
+            if (state == PW_FILTER_STATE_ERROR)
+            {
+                Lv2Log::error(SS("PipeWire audio failed. " << (error ? error : "")));
+                this->driverHost->OnAudioTerminated();
+            }
+        }
+
+        void ReadMidiData(uint32_t periodFrames)
+        {
+            AlsaMidiMessage message;
+
+            midiEventCount = 0;
+            midiEventMemoryIndex = 0;
+            if (!alsaSequencer)
+            {
+                return;
+            }
+            bool hasPeriodEndNs = false;
+            uint64_t periodEndNs = 0;
+            uint64_t nowNs = 0;
+            while (alsaSequencer->ReadMessage(message, 0))
+            {
+                size_t messageSize = message.size;
+                if (messageSize == 0)
+                {
+                    continue;
+                }
+                if (midiEventMemoryIndex + messageSize >= this->midiEventMemory.size() || midiEventCount >= this->midiEvents.size())
+                {
+                    continue;
+                }
+                // for now, prevent META event messages from propagating.
+                if (message.data[0] == 0xFF && message.size > 1)
+                {
+                    continue;
+                }
+                if (!hasPeriodEndNs)
+                {
+                    uint64_t sec;
+                    uint32_t nsec;
+                    hasPeriodEndNs = true;
+                    periodEndNs = alsaSequencer->GetQueueRealtime(&sec, &nsec) ? sec * 1000000000ull + nsec : 0;
+                    nowNs = EffectTimingClockNs();
+                }
+                uint32_t frame = periodEndNs != 0 ? MidiEventFrame(message.RealtimeNs(), periodEndNs, sampleRate, periodFrames) : 0;
+                if (midiEventCount != 0 && frame < midiEvents[midiEventCount - 1].time)
+                {
+                    frame = midiEvents[midiEventCount - 1].time; // keep the sequence in order.
+                }
+                MidiEvent *pEvent = midiEvents.data() + midiEventCount++;
+                pEvent->time = frame;
+                pEvent->receivedNs = MidiEventReceivedNs(message.RealtimeNs(), periodEndNs, nowNs);
+                pEvent->size = messageSize;
+                pEvent->buffer = midiEventMemory.data() + midiEventMemoryIndex;
+
+                memcpy(midiEventMemory.data() + midiEventMemoryIndex, message.data, message.size);
+                midiEventMemoryIndex += messageSize;
+            }
+        }
+
+        // PipeWire data thread.
+        void OnPipeWireProcess(spa_io_position *position)
+        {
+            if (!threadInitialized)
+            {
+                // PipeWire has already made the data thread realtime; this applies our priority and cpu affinity.
+                threadInitialized = true;
+                SetThreadPriority(SchedulerPriority::RealtimeAudio);
+                cpuUse.SetStartTime(cpuUse.Now());
+            }
+            cpuUse.AddSample(ProfileCategory::Read); // waiting for the graph.
+
+            uint32_t nFrames = bufferSize;
+            if (position)
+            {
+                nFrames = (uint32_t)position->clock.duration;
+                if (expectedClockPosition != 0 && position->clock.position != expectedClockPosition)
+                {
+                    this->driverHost->OnUnderrun();
+                }
+                expectedClockPosition = position->clock.position + position->clock.duration;
+                graphQuantum.store(nFrames, std::memory_order_relaxed);
+                graphRate.store(position->clock.rate.denom, std::memory_order_relaxed);
+            }
+
+            // zero-copy: the host processes directly in PipeWire's float buffers.
+            for (size_t i = 0; i < activeCapturePorts.size(); ++i)
+            {
+                float *buffer = (float *)pw_filter_get_dsp_buffer(activeCapturePorts[i], nFrames);
+                captureBase[i] = buffer;
+            }
+            for (size_t i = 0; i < activePlaybackPorts.size(); ++i)
+            {
+                float *buffer = (float *)pw_filter_get_dsp_buffer(activePlaybackPorts[i], nFrames);
+                playbackBase[i] = buffer;
+            }
+            cpuUse.AddSample(ProfileCategory::Driver);
+
+            // If the graph quantum is larger than the buffer size the pedalboard was prepared for,
+            // process it in bufferSize chunks.
+            ReadMidiData(std::min(nFrames, bufferSize));
+            for (uint32_t offset = 0; offset < nFrames;)
+            {
+                uint32_t chunk = std::min(bufferSize, nFrames - offset);
+                for (size_t i = 0; i < captureBase.size(); ++i)
+                {
+                    activeCaptureBuffers[i] = captureBase[i] ? captureBase[i] + offset : silenceBuffer.data();
+                }
+                for (size_t i = 0; i < playbackBase.size(); ++i)
+                {
+                    activePlaybackBuffers[i] = playbackBase[i] ? playbackBase[i] + offset : scratchBuffer.data();
+                }
+                this->driverHost->OnProcess(chunk);
+                midiEventCount = 0; // all MIDI goes to the first chunk.
+                offset += chunk;
+            }
+            cpuUse.AddSample(ProfileCategory::Execute);
+            cpuUse.UpdateCpuUse();
+        }
+
+        void DestroyFilter()
+        {
+            if (filter)
+            {
+                pw_thread_loop_lock(threadLoop);
+                pw_filter_destroy(filter);
+                pw_thread_loop_unlock(threadLoop);
+                filter = nullptr;
+            }
+            if (threadLoop)
+            {
+                pw_thread_loop_stop(threadLoop);
+                pw_thread_loop_destroy(threadLoop);
+                threadLoop = nullptr;
+            }
+            capturePorts.clear();
+            playbackPorts.clear();
+        }
+
+    public:
+        virtual uint32_t GetSampleRate() override
+        {
+            return this->sampleRate;
+        }
+
+        virtual size_t GetMidiInputEventCount() override
+        {
+            return midiEventCount;
+        }
+        virtual MidiEvent *GetMidiEvents() override
+        {
+            return this->midiEvents.data();
+        }
+
+        virtual size_t InputBufferCount() const override { return activeCaptureBuffers.size(); }
+        virtual float *GetInputBuffer(size_t channel) override
+        {
+            return activeCaptureBuffers[channel];
+        }
+
+        virtual size_t OutputBufferCount() const override { return activePlaybackBuffers.size(); }
+        virtual float *GetOutputBuffer(size_t channel) override
+        {
+            return activePlaybackBuffers[channel];
+        }
+
+        virtual void SetAlsaSequencer(AlsaSequencer::ptr alsaSequencer) override
+        {
+            this->alsaSequencer = alsaSequencer;
+        }
+
+        virtual void Open(const JackServerSettings &jackServerSettings, const JackChannelSelection &channelSelection) override
+        {
+            if (open)
+            {
+                throw PiPedalStateException("Already open.");
+            }
+            this->jackServerSettings = jackServerSettings;
+            this->channelSelection = channelSelection;
+            this->sampleRate = (uint32_t)jackServerSettings.GetSampleRate();
+            this->bufferSize = jackServerSettings.GetBufferSize();
+            this->channels = GetPipeWireAudioChannels(jackServerSettings.GetAlsaInputDevice());
+            open = true;
+            try
+            {
+                OpenAudio();
+            }
+            catch (const std::exception &)
+            {
+                Close();
+                throw;
+            }
+        }
+
+    private:
+        void OpenAudio()
+        {
+            InitPipeWire();
+
+            silenceBuffer.assign(bufferSize, 0.0f);
+            scratchBuffer.assign(bufferSize, 0.0f);
+
+            threadLoop = pw_thread_loop_new("pipedal-pw", nullptr);
+            if (!threadLoop)
+            {
+                throw PiPedalStateException("Failed to create PipeWire thread loop.");
+            }
+
+            // ask for a graph quantum and rate that match the configured buffer size and sample rate.
+            std::string latency = SS(bufferSize << "/" << sampleRate);
+            std::string quantum = SS(bufferSize);
+            std::string rate = SS(sampleRate);
+            std::string nodeRate = SS("1/" << sampleRate);
+
+            filter = pw_filter_new_simple(
+                pw_thread_loop_get_loop(threadLoop),
+                "pipedal",
+                pw_properties_new(
+                    PW_KEY_MEDIA_TYPE, "Audio",
+                    PW_KEY_MEDIA_CATEGORY, "Filter",
+                    PW_KEY_MEDIA_ROLE, "DSP",
+                    PW_KEY_NODE_NAME, "pipedal",
+                    PW_KEY_NODE_DESCRIPTION, "PiPedal",
+                    PW_KEY_NODE_AUTOCONNECT, "true",
+                    PW_KEY_NODE_LATENCY, latency.c_str(),
+                    PW_KEY_NODE_RATE, nodeRate.c_str(),
+                    "node.force-quantum", quantum.c_str(),
+                    "node.force-rate", rate.c_str(),
+                    "node.always-process", "true",
+                    nullptr),
+                &filterEvents,
+                this);
+            if (!filter)
+            {
+                throw PiPedalStateException("Failed to create PipeWire filter.");
+            }
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                std::string name = SS("capture_" << i);
+                void *port = pw_filter_add_port(
+                    filter, PW_DIRECTION_INPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS, sizeof(uint32_t),
+                    pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio", PW_KEY_PORT_NAME, name.c_str(), nullptr),
+                    nullptr, 0);
+                if (!port)
+                {
+                    throw PiPedalStateException("Failed to create PipeWire input port.");
+                }
+                capturePorts.push_back(port);
+            }
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                std::string name = SS("playback_" << i);
+                void *port = pw_filter_add_port(
+                    filter, PW_DIRECTION_OUTPUT, PW_FILTER_PORT_FLAG_MAP_BUFFERS, sizeof(uint32_t),
+                    pw_properties_new(PW_KEY_FORMAT_DSP, "32 bit float mono audio", PW_KEY_PORT_NAME, name.c_str(), nullptr),
+                    nullptr, 0);
+                if (!port)
+                {
+                    throw PiPedalStateException("Failed to create PipeWire output port.");
+                }
+                playbackPorts.push_back(port);
+            }
+        }
+
+    public:
+        virtual void Activate() override
+        {
+            if (activated)
+            {
+                throw PiPedalStateException("Already activated.");
+            }
+            activated = true;
+
+            activeCapturePorts.clear();
+            for (auto &x : channelSelection.GetInputAudioPorts())
+            {
+                int sourceIndex = IndexFromPortName(x);
+                if (sourceIndex >= (int)capturePorts.size())
+                {
+                    Lv2Log::error(SS("Invalid audio input port: " << x));
+                }
+                else
+                {
+                    activeCapturePorts.push_back(capturePorts[sourceIndex]);
+                }
+            }
+            activePlaybackPorts.clear();
+            for (auto &x : channelSelection.GetOutputAudioPorts())
+            {
+                int sourceIndex = IndexFromPortName(x);
+                if (sourceIndex >= (int)playbackPorts.size())
+                {
+                    Lv2Log::error(SS("Invalid audio output port: " << x));
+                }
+                else
+                {
+                    activePlaybackPorts.push_back(playbackPorts[sourceIndex]);
+                }
+            }
+            captureBase.assign(activeCapturePorts.size(), nullptr);
+            playbackBase.assign(activePlaybackPorts.size(), nullptr);
+            activeCaptureBuffers.assign(activeCapturePorts.size(), silenceBuffer.data());
+            activePlaybackBuffers.assign(activePlaybackPorts.size(), scratchBuffer.data());
+
+            threadInitialized = false;
+            expectedClockPosition = 0;
+            cpuUse.SetPeriod(this->bufferSize, this->sampleRate);
+            cpuUse.ResetStatistics();
+
+            if (pw_thread_loop_start(threadLoop) < 0)
+            {
+                throw PiPedalStateException("Failed to start the PipeWire thread loop.");
+            }
+            pw_thread_loop_lock(threadLoop);
+            int rc = pw_filter_connect(filter, PW_FILTER_FLAG_RT_PROCESS, nullptr, 0);
+            pw_thread_loop_unlock(threadLoop);
+            if (rc < 0)
+            {
+                throw PiPedalStateException(SS("Failed to connect the PipeWire filter. " << strerror(-rc)));
+            }
+        }
+
+        virtual void Deactivate() override
+        {
+            if (!activated)
+            {
+                return;
+            }
+            activated = false;
+            pw_thread_loop_lock(threadLoop);
+            pw_filter_disconnect(filter);
+            pw_thread_loop_unlock(threadLoop);
+            pw_thread_loop_stop(threadLoop);
+            Lv2Log::debug("PipeWire filter disconnected.");
+        }
+
+        virtual void Close() override
+        {
+            if (!open)
+            {
+                return;
+            }
+            open = false;
+            Deactivate();
+            DestroyFilter();
+            activeCaptureBuffers.clear();
+            activePlaybackBuffers.clear();
+        }
+
+        virtual std::string GetConfigurationDescription() override
+        {
+            std::string result = SS(
+                "PIPEWIRE, "
+                << "pw_filter"
+                << ", " << "Native float"
+                << ", " << this->sampleRate
+                << ", " << this->bufferSize
+                << " (graph: " << graphQuantum.load() << "/" << graphRate.load() << ")"
+                << ", in: " << this->InputBufferCount() << "/" << this->channels
+                << ", out: " << this->OutputBufferCount() << "/" << this->channels);
+            return result;
+        }
+
+        virtual float CpuUse() override
+        {
+            return cpuUse.GetCpuUse();
+        }
+        virtual float CpuOverhead() override
+        {
+            return cpuUse.GetCpuOverhead();
+        }
+        virtual CpuUseStatistics GetCpuUseStatistics() override
+        {
+            return cpuUse.GetStatistics();
+        }
+        virtual void ResetCpuUseStatistics() override
+        {
+            cpuUse.ResetStatistics();
+        }
+        virtual std::optional<float> TakeRecentCpuHeadroom() override
+        {
+            return cpuUse.TakeRecentHeadroom();
+        }
+    };
+
+    const pw_filter_events PipeWireDriverImpl::filterEvents = {
+        .version = PW_VERSION_FILTER_EVENTS,
+        .state_changed = on_state_changed,
+        .process = on_process,
+    };
+
+    AudioDriver *CreatePipeWireDriver(AudioDriverHost *driverHost)
+    {
+        return new PipeWireDriverImpl(driverHost);
+    }
+
+    uint32_t GetPipeWireAudioChannels(const std::string &deviceId)
+    {
+        auto pos = deviceId.find_last_of('_');
+        if (!deviceId.starts_with(PIPEWIRE_DEVICE_PREFIX) || pos == std::string::npos)
+        {
+            throw std::runtime_error("Invalid PipeWire device name");
+        }
+        uint32_t channels = 0;
+        std::istringstream ss(deviceId.substr(pos + 1));
+        ss >> channels;
+        if (channels == 0)
+        {
+            throw std::runtime_error("Invalid PipeWire device name");
+        }
+        return channels;
+    }
+
+    bool IsPipeWireAvailable()
+    {
+        InitPipeWire();
+        pw_main_loop *loop = pw_main_loop_new(nullptr);
+        if (!loop)
+        {
+            return false;
+        }
+        bool result = false;
+        pw_context *context = pw_context_new(pw_main_loop_get_loop(loop), nullptr, 0);
+        if (context)
+        {
+            pw_core *core = pw_context_connect(context, nullptr, 0);
+            if (core)
+            {
+                result = true;
+                pw_core_disconnect(core);
+            }
+            pw_context_destroy(context);
+        }
+        pw_main_loop_destroy(loop);
+        return result;
+    }
+
+    AlsaDeviceInfo MakePipeWireDeviceInfo(uint32_t channels)
+    {
+        AlsaDeviceInfo result;
+        constexpr int PIPEWIRE_DEVICE_ID_OFFSET = 100874;
+        result.cardId_ = PIPEWIRE_DEVICE_ID_OFFSET + channels;
+        result.id_ = SS(PIPEWIRE_DEVICE_PREFIX << "channels_" << channels);
+        result.name_ = SS("PipeWire (" << channels << " channels)");
+        result.longName_ = result.name_;
+        result.sampleRates_.push_back(44100);
+        result.sampleRates_.push_back(48000);
+        result.sampleRates_.push_back(96000);
+        result.minBufferSize_ = 16;
+        result.maxBufferSize_ = 1024;
+        result.supportsCapture_ = true;
+        result.supportsPlayback_ = true;
+        return result;
+    }
+}
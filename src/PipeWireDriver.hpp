@@ -0,0 +1,47 @@
+/*
+ * MIT License
+ * 
+ * Copyright (c) 2024 Robin E. R. Davies
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "AudioDriver.hpp"
+#include "PiPedalAlsa.hpp"
+#include "JackServerSettings.hpp"
+#include <string>
+#include <vector>
+
+namespace pipedal {
+
+    // PipeWire devices have ids of the form "pipewire:channels_<n>" (see JackServerSettings::IsPipeWireAudioDevice()). The driver is a PipeWire filter node
+    // ("pipedal") with n capture ports and n playback ports; routing to hardware is left to the session
+    // manager (or pw-link).
+
+    uint32_t GetPipeWireAudioChannels(const std::string &deviceId);
+
+    // True if a PipeWire daemon is reachable from this process.
+    bool IsPipeWireAvailable();
+    AlsaDeviceInfo MakePipeWireDeviceInfo(uint32_t channels);
+
+    AudioDriver* CreatePipeWireDriver(AudioDriverHost*driverHost);
+
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "PipeWireDriver.hpp"
+#include "JackConfiguration.hpp"
+#include "ss.hpp"
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    // Copies input to output, and counts frames.
+    class PipeWireTester : private AudioDriverHost
+    {
+    public:
+        ~PipeWireTester()
+        {
+            delete audioDriver;
+        }
+
+        void Test(uint32_t channels)
+        {
+            std::string deviceId = MakePipeWireDeviceInfo(channels).id_;
+            REQUIRE(GetPipeWireAudioChannels(deviceId) == channels);
+
+            JackServerSettings serverSettings(deviceId, deviceId, 48000, 64, 3);
+
+            std::vector<std::string> inputPorts;
+            std::vector<std::string> outputPorts;
+            for (uint32_t i = 0; i < channels; ++i)
+            {
+                inputPorts.push_back(SS("system:capture_" << i));
+                outputPorts.push_back(SS("system:playback_" << i));
+            }
+            JackChannelSelection channelSelection(inputPorts, outputPorts, {});
+
+            audioDriver = CreatePipeWireDriver(this);
+            audioDriver->Open(serverSettings, channelSelection);
+            audioDriver->Activate();
+
+            REQUIRE(audioDriver->InputBufferCount() == channels);
+            REQUIRE(audioDriver->OutputBufferCount() == channels);
+
+            for (int i = 0; i < 20 && frames < 48000; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            cout << "PipeWire driver: " << frames << " frames, " << processCalls << " periods, xruns: " << xruns
+                 << " Cpu: " << audioDriver->CpuUse() << "%" << endl;
+
+            audioDriver->Deactivate();
+            audioDriver->Close();
+
+            REQUIRE(processCalls > 0);
+            REQUIRE(frames > 0);
+        }
+
+    private:
+        AudioDriver *audioDriver = nullptr;
+        std::atomic<size_t> frames = 0;
+        std::atomic<size_t> processCalls = 0;
+        std::atomic<size_t> xruns = 0;
+
+        virtual void OnProcess(size_t nFrames) override
+        {
+            size_t channels = std::min(audioDriver->InputBufferCount(), audioDriver->OutputBufferCount());
+            for (size_t c = 0; c < channels; ++c)
+            {
+                const float *input = audioDriver->GetInputBuffer(c);
+                float *output = audioDriver->GetOutputBuffer(c);
+                for (size_t i = 0; i < nFrames; ++i)
+                {
+                    output[i] = input[i];
+                }
+            }
+            frames += nFrames;
+            ++processCalls;
+        }
+        virtual void OnUnderrun() override
+        {
+            ++xruns;
+        }
+        virtual void OnAlsaDriverStopped() override {}
+        virtual void OnAudioTerminated() override {}
+    };
+}
+
+TEST_CASE("PipeWire driver smoke test", "[pipewire_driver]")
+{
+    if (!IsPipeWireAvailable())
+    {
+        WARN("No PipeWire daemon. Test skipped.");
+        return;
+    }
+    PipeWireTester tester;
+    tester.Test(2);
+}
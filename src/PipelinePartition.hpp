@@ -0,0 +1,73 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Chooses where to cut a serial chain into two pipeline stages.
+     *
+     * The stages run concurrently on different cores, so the period has to accommodate
+     * the more expensive of the two. The best cut is the one that minimizes that cost.
+     */
+    class PipelinePartition
+    {
+    public:
+        /**
+         * @brief Choose the first item of the second stage.
+         *
+         * @param costs Estimated cost of each item in the chain (0 for empty items).
+         * @param canCutBefore Whether the second stage may start at each item.
+         * @return The index of the first item of the second stage; or 0 if the chain can't be cut
+         * so that both stages have work to do.
+         */
+        static size_t ChooseCut(const std::vector<float> &costs, const std::vector<bool> &canCutBefore)
+        {
+            float total = 0;
+            for (float cost : costs)
+            {
+                total += cost;
+            }
+            size_t bestCut = 0;
+            float bestCost = 0;
+            float firstStageCost = 0;
+            for (size_t i = 1; i < costs.size(); ++i)
+            {
+                firstStageCost += costs[i - 1];
+                float secondStageCost = total - firstStageCost;
+                if (!canCutBefore[i] || firstStageCost <= 0 || secondStageCost <= 0)
+                {
+                    continue;
+                }
+                float cost = firstStageCost > secondStageCost ? firstStageCost : secondStageCost;
+                if (bestCut == 0 || cost < bestCost)
+                {
+                    bestCut = i;
+                    bestCost = cost;
+                }
+            }
+            return bestCut;
+        }
+    };
+}
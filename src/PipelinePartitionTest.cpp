@@ -0,0 +1,49 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PipelinePartition.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("PipelinePartition", "[pipeline_partition][Build][Dev]")
+{
+    // comp, drive, nam, cab, mod, delay, reverb.
+    std::vector<float> costs{0.02f, 0.03f, 0.30f, 0.10f, 0.02f, 0.05f, 0.20f};
+    std::vector<bool> anywhere(costs.size(), true);
+
+    // {comp, drive, nam} = 0.35 | {cab ... reverb} = 0.37.
+    REQUIRE(PipelinePartition::ChooseCut(costs, anywhere) == 3);
+
+    // a sidechain connection that rules out the best cut.
+    std::vector<bool> restricted = anywhere;
+    restricted[3] = false;
+    REQUIRE(PipelinePartition::ChooseCut(costs, restricted) == 4);
+
+    // equal (unknown) costs: cut in the middle.
+    REQUIRE(PipelinePartition::ChooseCut({1, 1, 1, 1}, {true, true, true, true}) == 2);
+
+    // both stages need something to do.
+    REQUIRE(PipelinePartition::ChooseCut({0, 1, 0}, {true, true, true}) == 0);
+    REQUIRE(PipelinePartition::ChooseCut({1}, {true}) == 0);
+    REQUIRE(PipelinePartition::ChooseCut({}, {}) == 0);
+    REQUIRE(PipelinePartition::ChooseCut({1, 0, 2}, {true, true, false}) == 1);
+}
@@ -33,6 +33,8 @@ extern "C"
 }
 #include <stdexcept>
 #include <string>
+#include <algorithm>
+#include <cstring>
 
 using namespace pipedal;
 
@@ -45,6 +47,7 @@ namespace pipedal::impl
         pw_main_loop *loop = nullptr;
         pw_stream *stream = nullptr;
         Callback callback;
+        uint32_t channels;
 
         std::atomic<bool> is_running_{false};
 
@@ -61,12 +64,18 @@ namespace pipedal::impl
             if ((buf = pw_stream_dequeue_buffer(stream)) == NULL)
                 return;
 
-            // Process buffer data
+            // interleaved F32 data, passed to the callback in place.
             spa_buffer *sbuf = buf->buffer;
-            for (uint32_t i = 0; i < sbuf->n_datas; i++)
+            if (sbuf->n_datas != 0 && sbuf->datas[0].data && callback)
             {
-                // Access audio data through sbuf->datas[i].data
-                // Size is sbuf->datas[i].chunk->size
+                const spa_data &data = sbuf->datas[0];
+                uint32_t offset = std::min(data.chunk->offset, data.maxsize);
+                uint32_t size = std::min(data.chunk->size, data.maxsize - offset);
+                size_t frames = size / (sizeof(float) * channels);
+                if (frames != 0)
+                {
+                    callback((const float *)(((const uint8_t *)data.data) + offset), frames);
+                }
             }
 
             pw_stream_queue_buffer(stream, buf);
@@ -96,7 +105,7 @@ namespace pipedal::impl
         PipeWireInputStreamImpl(const std::string &stream_name,
                                 uint32_t channels,
                                 uint32_t rate )
-            : is_running_(false)
+            : channels(channels), is_running_(false)
         {
 
             // Initialize PipeWire
@@ -140,7 +149,7 @@ namespace pipedal::impl
 
             const spa_pod *params[1];
             spa_audio_info_raw format = {
-                .format = SPA_AUDIO_FORMAT_S16,
+                .format = SPA_AUDIO_FORMAT_F32,
                 .flags = SPA_AUDIO_FLAG_NONE,
                 .rate = rate,
                 .channels = channels};
@@ -184,9 +193,6 @@ namespace pipedal::impl
                 loop = nullptr;
                 throw std::runtime_error("Failed to connect stream: " + std::string(strerror(-res)));
             }
-
-            // xxx: delete me
-            pw_main_loop_run(loop);
         }
 
         ~PipeWireInputStreamImpl()
@@ -207,6 +213,7 @@ namespace pipedal::impl
 
         virtual void Activate(Callback &&callback) override
         {
+            this->callback = std::move(callback);
             serviceThread = std::make_unique<std::jthread>([this]() {
                 if (!is_running_)
             {
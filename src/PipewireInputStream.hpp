@@ -40,7 +40,9 @@ namespace pipedal
         using self = PipeWireInputStream;
         using ptr = std::shared_ptr<self>;
 
-        using Callback = std::function<void(const float *data, size_t size)>;
+        // Called on the PipeWire realtime thread with interleaved frames, in PipeWire's buffer.
+        // Pass them to an AdaptiveResampler to bring them into the audio thread's clock domain.
+        using Callback = std::function<void(const float *data, size_t frames)>;
         static ptr Create(const std::string &streamName, int sampleRate, int channels);
 
         virtual void Activate(Callback &&callback) = 0;
@@ -0,0 +1,274 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "PluginCostDatabase.hpp"
+#include "ofstream_synced.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include <cmath>
+#include <fstream>
+#include <set>
+
+using namespace pipedal;
+
+PluginCostDatabase::PluginCostDatabase(const std::filesystem::path &path)
+    : path(path)
+{
+}
+
+void PluginCostDatabase::Load()
+{
+    std::lock_guard lock(mutex);
+    entries.clear();
+    changed = false;
+    if (path.empty() || !std::filesystem::exists(path))
+    {
+        return;
+    }
+    try
+    {
+        std::ifstream f(path);
+        json_reader reader(f);
+        reader.read(&entries);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't read plugin cost database " << path << ". " << e.what()));
+        entries.clear();
+    }
+}
+
+void PluginCostDatabase::Save()
+{
+    std::lock_guard lock(mutex);
+    if (!changed || path.empty())
+    {
+        return;
+    }
+    try
+    {
+        pipedal::ofstream_synced f(path);
+        json_writer writer(f, true);
+        writer.write(entries);
+        changed = false;
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't write plugin cost database " << path << ". " << e.what()));
+    }
+}
+
+const PluginCost *PluginCostDatabase::Find(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const
+{
+    for (const auto &entry : entries)
+    {
+        if (entry.uri_ == uri && entry.sampleRate_ == sampleRate && entry.blockSize_ == blockSize)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+PluginCost *PluginCostDatabase::FindOrAdd(const std::string &uri, uint32_t sampleRate, uint32_t blockSize)
+{
+    PluginCost *entry = const_cast<PluginCost *>(Find(uri, sampleRate, blockSize));
+    if (!entry)
+    {
+        PluginCost newEntry;
+        newEntry.uri_ = uri;
+        newEntry.sampleRate_ = sampleRate;
+        newEntry.blockSize_ = blockSize;
+        entries.push_back(std::move(newEntry));
+        entry = &entries.back();
+    }
+    return entry;
+}
+
+void PluginCostDatabase::Record(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, const EffectTiming &timing)
+{
+    if (timing.periods_ == 0 || sampleRate == 0 || blockSize == 0)
+    {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    PluginCost *entry = FindOrAdd(uri, sampleRate, blockSize);
+    double weight = entry->periods_;
+    double newWeight = (double)timing.periods_;
+    double total = weight + newWeight;
+    entry->meanUs_ = (float)((entry->meanUs_ * weight + timing.meanUs_ * newWeight) / total);
+    entry->p99Us_ = (float)((entry->p99Us_ * weight + timing.p99Us_ * newWeight) / total);
+    entry->periods_ = std::min(total, MAX_WEIGHT);
+    changed = true;
+}
+
+void PluginCostDatabase::RecordMemory(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, uint64_t bytes)
+{
+    if (sampleRate == 0 || blockSize == 0)
+    {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    PluginCost *entry = FindOrAdd(uri, sampleRate, blockSize);
+    double weight = entry->memorySamples_;
+    double total = weight + 1;
+    entry->memoryBytes_ = (uint64_t)((entry->memoryBytes_ * weight + (double)bytes) / total);
+    entry->memorySamples_ = std::min(total, MAX_MEMORY_WEIGHT);
+    changed = true;
+}
+
+std::optional<PluginCost> PluginCostDatabase::Get(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const
+{
+    std::lock_guard lock(mutex);
+    const PluginCost *entry = Find(uri, sampleRate, blockSize);
+    if (!entry)
+    {
+        return std::nullopt;
+    }
+    return *entry;
+}
+
+const PluginCost *PluginCostDatabase::FindClosest(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, bool (*hasValue)(const PluginCost &)) const
+{
+    const PluginCost *best = nullptr;
+    double bestDistance = 0;
+    for (const auto &entry : entries)
+    {
+        if (entry.uri_ != uri || !hasValue(entry))
+        {
+            continue;
+        }
+        double distance = std::abs(std::log2((double)entry.blockSize_ / blockSize));
+        if (entry.sampleRate_ != sampleRate)
+        {
+            distance += 100;
+        }
+        if (!best || distance < bestDistance)
+        {
+            best = &entry;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+PluginCostEstimate PluginCostDatabase::EstimateLocked(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const
+{
+    PluginCostEstimate result;
+    result.uri_ = uri;
+    if (sampleRate == 0 || blockSize == 0)
+    {
+        return result;
+    }
+    double periodUs = blockSize * 1E6 / sampleRate;
+
+    const PluginCost *memoryEntry = FindClosest(
+        uri, sampleRate, blockSize,
+        [](const PluginCost &entry)
+        { return entry.memorySamples_ != 0; });
+    if (memoryEntry)
+    {
+        result.memoryBytes_ = memoryEntry->memoryBytes_;
+    }
+
+    const PluginCost *best = FindClosest(
+        uri, sampleRate, blockSize,
+        [](const PluginCost &entry)
+        { return entry.periods_ != 0; });
+    if (!best)
+    {
+        return result;
+    }
+    result.known_ = true;
+    result.exact_ = best->sampleRate_ == sampleRate && best->blockSize_ == blockSize;
+    // cost per frame is assumed to be constant.
+    double scale = (double)blockSize / best->blockSize_;
+    result.meanLoad_ = (float)(best->meanUs_ * scale / periodUs);
+    result.p99Load_ = (float)(best->p99Us_ * scale / periodUs);
+    return result;
+}
+
+PluginCostEstimate PluginCostDatabase::Estimate(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const
+{
+    std::lock_guard lock(mutex);
+    return EstimateLocked(uri, sampleRate, blockSize);
+}
+
+std::vector<PluginCostEstimate> PluginCostDatabase::EstimateAll(uint32_t sampleRate, uint32_t blockSize) const
+{
+    std::lock_guard lock(mutex);
+    std::set<std::string> uris;
+    for (const auto &entry : entries)
+    {
+        uris.insert(entry.uri_);
+    }
+    std::vector<PluginCostEstimate> result;
+    for (const auto &uri : uris)
+    {
+        result.push_back(EstimateLocked(uri, sampleRate, blockSize));
+    }
+    return result;
+}
+
+PresetLoadEstimate PluginCostDatabase::EstimatePreset(const std::vector<std::string> &uris, uint32_t sampleRate, uint32_t blockSize) const
+{
+    std::lock_guard lock(mutex);
+    PresetLoadEstimate result;
+    for (const auto &uri : uris)
+    {
+        PluginCostEstimate estimate = EstimateLocked(uri, sampleRate, blockSize);
+        result.memoryBytes_ += estimate.memoryBytes_;
+        if (!estimate.known_)
+        {
+            result.unknownPlugins_.push_back(uri);
+            continue;
+        }
+        result.meanLoad_ += estimate.meanLoad_;
+        result.p99Load_ += estimate.p99Load_;
+    }
+    return result;
+}
+
+JSON_MAP_BEGIN(PluginCost)
+    JSON_MAP_REFERENCE(PluginCost, uri)
+    JSON_MAP_REFERENCE(PluginCost, sampleRate)
+    JSON_MAP_REFERENCE(PluginCost, blockSize)
+    JSON_MAP_REFERENCE(PluginCost, periods)
+    JSON_MAP_REFERENCE(PluginCost, meanUs)
+    JSON_MAP_REFERENCE(PluginCost, p99Us)
+    JSON_MAP_REFERENCE(PluginCost, memorySamples)
+    JSON_MAP_REFERENCE(PluginCost, memoryBytes)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(PluginCostEstimate)
+    JSON_MAP_REFERENCE(PluginCostEstimate, uri)
+    JSON_MAP_REFERENCE(PluginCostEstimate, known)
+    JSON_MAP_REFERENCE(PluginCostEstimate, exact)
+    JSON_MAP_REFERENCE(PluginCostEstimate, meanLoad)
+    JSON_MAP_REFERENCE(PluginCostEstimate, p99Load)
+    JSON_MAP_REFERENCE(PluginCostEstimate, memoryBytes)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(PresetLoadEstimate)
+    JSON_MAP_REFERENCE(PresetLoadEstimate, meanLoad)
+    JSON_MAP_REFERENCE(PresetLoadEstimate, p99Load)
+    JSON_MAP_REFERENCE(PresetLoadEstimate, memoryBytes)
+    JSON_MAP_REFERENCE(PresetLoadEstimate, unknownPlugins)
+JSON_MAP_END()
@@ -0,0 +1,119 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include "EffectTiming.hpp"
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    // Measured execution time of a plugin on this device, at one sample rate and block size.
+    class PluginCost
+    {
+    public:
+        std::string uri_;
+        uint32_t sampleRate_ = 0;
+        uint32_t blockSize_ = 0;
+        double periods_ = 0; // weight of the measurements, capped so that the averages track changes.
+        float meanUs_ = 0;
+        float p99Us_ = 0;
+        double memorySamples_ = 0; // weight of the memory measurements. 0 if the plugin's memory use hasn't been measured.
+        uint64_t memoryBytes_ = 0;   // memory used by an instance (instantiate, restore state, activate).
+
+        DECLARE_JSON_MAP(PluginCost);
+    };
+
+    // Estimated cost of a plugin (or a preset), as a fraction of the audio period.
+    class PluginCostEstimate
+    {
+    public:
+        std::string uri_;
+        bool known_ = false;
+        bool exact_ = false; // measured at the current sample rate and block size (rather than scaled).
+        float meanLoad_ = 0;
+        float p99Load_ = 0;
+        uint64_t memoryBytes_ = 0; // 0 if unknown.
+
+        DECLARE_JSON_MAP(PluginCostEstimate);
+    };
+
+    class PresetLoadEstimate
+    {
+    public:
+        float meanLoad_ = 0;
+        float p99Load_ = 0; // sum of p99s: a pessimistic estimate.
+        uint64_t memoryBytes_ = 0; // of the plugins whose memory use has been measured.
+        std::vector<std::string> unknownPlugins_;
+
+        DECLARE_JSON_MAP(PresetLoadEstimate);
+    };
+
+    /**
+     * @brief Persistent per-device database of plugin execution times, keyed by plugin uri, sample rate and block size.
+     *
+     * Fed from effect timings (either at runtime, or by pipedalProfilePlugin). Costs for a sample rate or
+     * block size that hasn't been measured are estimated by scaling the closest measurement, on the
+     * assumption that cost is proportional to the number of frames processed.
+     *
+     * Memory use per instance is recorded alongside, from footprints measured when plugins are created.
+     * Memory estimates use the measurement at the closest sample rate and block size, unscaled.
+     *
+     * Thread-safe.
+     */
+    class PluginCostDatabase
+    {
+    public:
+        static constexpr double MAX_WEIGHT = 100000; // periods.
+        static constexpr double MAX_MEMORY_WEIGHT = 8;  // measurements.
+
+        // An empty path disables persistence.
+        PluginCostDatabase(const std::filesystem::path &path = "");
+
+        void Load();
+        // Writes the database, if it has changed.
+        void Save();
+
+        void Record(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, const EffectTiming &timing);
+        void RecordMemory(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, uint64_t bytes);
+
+        std::optional<PluginCost> Get(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const;
+        PluginCostEstimate Estimate(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const;
+        std::vector<PluginCostEstimate> EstimateAll(uint32_t sampleRate, uint32_t blockSize) const;
+        PresetLoadEstimate EstimatePreset(const std::vector<std::string> &uris, uint32_t sampleRate, uint32_t blockSize) const;
+
+    private:
+        PluginCostEstimate EstimateLocked(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const;
+        const PluginCost *Find(const std::string &uri, uint32_t sampleRate, uint32_t blockSize) const;
+        PluginCost *FindOrAdd(const std::string &uri, uint32_t sampleRate, uint32_t blockSize);
+        // The closest entry for which hasValue() is true: same sample rate if possible, then the nearest block size.
+        const PluginCost *FindClosest(const std::string &uri, uint32_t sampleRate, uint32_t blockSize, bool (*hasValue)(const PluginCost &)) const;
+
+        std::filesystem::path path;
+        mutable std::mutex mutex;
+        std::vector<PluginCost> entries;
+        bool changed = false;
+    };
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PluginCostDatabase.hpp"
+#include <filesystem>
+
+using namespace pipedal;
+
+static EffectTiming MakeTiming(uint64_t periods, float meanUs, float p99Us)
+{
+    EffectTiming timing;
+    timing.periods_ = periods;
+    timing.meanUs_ = meanUs;
+    timing.p99Us_ = p99Us;
+    return timing;
+}
+
+TEST_CASE("PluginCostDatabase", "[plugin_cost_database][Build][Dev]")
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "pipedalPluginCostTest.json";
+    std::filesystem::remove(path);
+
+    const std::string reverb = "http://example.com/reverb";
+    const std::string eq = "http://example.com/eq";
+    {
+        PluginCostDatabase db(path);
+        db.Load();
+        REQUIRE(!db.Get(reverb, 48000, 64));
+
+        db.Record(reverb, 48000, 64, MakeTiming(100, 200, 400));
+        db.Record(reverb, 48000, 64, MakeTiming(300, 400, 800));
+        auto cost = db.Get(reverb, 48000, 64);
+        REQUIRE(cost);
+        REQUIRE(cost->periods_ == 400);
+        REQUIRE(std::abs(cost->meanUs_ - 350) < 0.01);
+        REQUIRE(std::abs(cost->p99Us_ - 700) < 0.01);
+
+        db.Record(eq, 48000, 64, MakeTiming(100, 40, 80));
+        db.Save();
+    }
+    {
+        PluginCostDatabase db(path);
+        db.Load();
+        auto cost = db.Get(reverb, 48000, 64);
+        REQUIRE(cost);
+        REQUIRE(std::abs(cost->meanUs_ - 350) < 0.01);
+
+        // 64 frames at 48kHz = 1333us.
+        PluginCostEstimate exact = db.Estimate(reverb, 48000, 64);
+        REQUIRE(exact.known_);
+        REQUIRE(exact.exact_);
+        REQUIRE(std::abs(exact.meanLoad_ - 350 / 1333.33) < 0.001);
+
+        // scaled to a different block size: the same load.
+        PluginCostEstimate scaled = db.Estimate(reverb, 48000, 128);
+        REQUIRE(scaled.known_);
+        REQUIRE(!scaled.exact_);
+        REQUIRE(std::abs(scaled.meanLoad_ - exact.meanLoad_) < 0.001);
+
+        // at twice the sample rate: twice the load.
+        PluginCostEstimate fast = db.Estimate(reverb, 96000, 64);
+        REQUIRE(std::abs(fast.meanLoad_ - 2 * exact.meanLoad_) < 0.001);
+
+        REQUIRE(!db.Estimate("http://example.com/unknown", 48000, 64).known_);
+
+        PresetLoadEstimate preset = db.EstimatePreset({reverb, eq, "http://example.com/unknown"}, 48000, 64);
+        REQUIRE(std::abs(preset.p99Load_ - (700 + 80) / 1333.33) < 0.001);
+        REQUIRE(preset.unknownPlugins_.size() == 1);
+
+        REQUIRE(db.EstimateAll(48000, 64).size() == 2);
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("PluginCostDatabase memory", "[plugin_cost_database][Build][Dev]")
+{
+    const std::string amp = "http://example.com/amp";
+    const std::string eq = "http://example.com/eq";
+
+    PluginCostDatabase db;
+    db.RecordMemory(amp, 48000, 64, 100 * 1024 * 1024);
+    db.RecordMemory(amp, 48000, 64, 200 * 1024 * 1024);
+    auto cost = db.Get(amp, 48000, 64);
+    REQUIRE(cost);
+    REQUIRE(cost->memoryBytes_ == 150 * 1024 * 1024);
+
+    // a memory measurement alone doesn't make the cpu cost known.
+    PluginCostEstimate estimate = db.Estimate(amp, 48000, 128);
+    REQUIRE(!estimate.known_);
+    REQUIRE(estimate.memoryBytes_ == 150 * 1024 * 1024);
+
+    db.Record(amp, 48000, 64, MakeTiming(100, 200, 400));
+    REQUIRE(db.Estimate(amp, 48000, 64).known_);
+
+    db.Record(eq, 48000, 64, MakeTiming(100, 40, 80));
+    db.RecordMemory(eq, 48000, 64, 1024);
+    PresetLoadEstimate preset = db.EstimatePreset({amp, eq}, 48000, 64);
+    REQUIRE(preset.memoryBytes_ == 150 * 1024 * 1024 + 1024);
+}
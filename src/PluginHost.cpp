@@ -29,11 +29,14 @@
 #include <functional>
 #include "Pedalboard.hpp"
 #include "Lv2Effect.hpp"
+#include "SandboxedEffect.hpp"
 #include "Lv2Pedalboard.hpp"
 #include "JackConfiguration.hpp"
 #include "lv2/urid/urid.h"
 #include "lv2/ui/ui.h"
 #include "lv2/core/lv2.h"
+#include "lv2ext/pipedal.lv2/ext/taskGroup.h"
+#include "lv2ext/pipedal.lv2/ext/AlwaysRunFeature.h"
 
 // #include "lv2.h"
 #include "lv2/atom/atom.h"
@@ -49,6 +52,8 @@
 #include "StdErrorCapture.hpp"
 #include "util.hpp"
 #include "ModFileTypes.hpp"
+#include "Lv2PluginCache.hpp"
+#include "PluginCostDatabase.hpp"
 #include <algorithm>
 
 #include "Locale.hpp"
@@ -106,7 +111,16 @@ void PluginHost::SetConfiguration(const PiPedalConfiguration &configuration)
 {
     this->vst3CachePath =
         std::filesystem::path(configuration.GetLocalStoragePath()) / "vst3cache.json";
+    this->lv2CachePath =
+        std::filesystem::path(configuration.GetLocalStoragePath()) / "lv2cache.json";
     this->vst3Enabled = configuration.IsVst3Enabled();
+    this->hostWorkerThread = std::make_shared<HostWorkerThread>(configuration.GetLv2WorkerThreads());
+    this->parallelPluginInstantiation = configuration.GetParallelPluginInstantiation();
+    const auto &serialPlugins = configuration.GetSerialInstantiationPlugins();
+    this->serialInstantiationPlugins = std::set<std::string>(serialPlugins.begin(), serialPlugins.end());
+    const auto &sandboxedPlugins = configuration.GetSandboxedPlugins();
+    this->sandboxedPlugins = std::set<std::string>(sandboxedPlugins.begin(), sandboxedPlugins.end());
+    this->configDirectory = configuration.GetDocRoot();
 }
 
 void PluginHost::LilvUris::Initialize(LilvWorld *pWorld)
@@ -299,6 +313,30 @@ std::string PluginHost::GetPluginStoragePath() const
     return pluginStoragePath;
 }
 
+std::shared_ptr<HostWorkerThread> PluginHost::GetHostWorkerThread()
+{
+    return hostWorkerThread;
+}
+
+float PluginHost::GetEstimatedPluginLoad(const std::string &uri) const
+{
+    if (!pluginCostDatabase)
+    {
+        return -1;
+    }
+    PluginCostEstimate estimate = pluginCostDatabase->Estimate(uri, (uint32_t)sampleRate, (uint32_t)maxBufferSize);
+    return estimate.known_ ? estimate.meanLoad_ : -1;
+}
+
+bool PluginHost::CanCreateEffectConcurrently(const std::string &uri) const
+{
+    if (!parallelPluginInstantiation || uri.starts_with("vst3:"))
+    {
+        return false;
+    }
+    return !serialInstantiationPlugins.contains(uri);
+}
+
 PluginHost::PluginHost()
 {
     pWorld = nullptr;
@@ -309,10 +347,13 @@ PluginHost::PluginHost()
 
     fileMetadataFeature.Prepare(mapFeature);
     lv2Features.push_back(fileMetadataFeature.GetFeature());
+    lv2Features.push_back(sharedResourceFeature.GetFeature());
+    lv2Features.push_back(fileStreamFeature.GetFeature());
 
     lv2Features.push_back(nullptr);
 
     this->urids = new Urids(mapFeature);
+    this->hostWorkerThread = std::make_shared<HostWorkerThread>();
 }
 
 void PluginHost::OnConfigurationChanged(const JackConfiguration &configuration, const JackChannelSelection &settings)
@@ -436,6 +477,15 @@ void PluginHost::LoadPluginClassesFromLilv()
     }
 }
 
+static std::string GetLilvPluginBundlePath(const LilvPlugin *lilvPlugin)
+{
+    AutoLilvNode bundleUriNode = lilv_plugin_get_bundle_uri(lilvPlugin);
+    char *lilvBundlePath = bundleUriNode ? lilv_file_uri_parse(bundleUriNode.AsUri().c_str(), nullptr) : nullptr;
+    std::string bundlePath = lilvBundlePath ? lilvBundlePath : "";
+    lilv_free(lilvBundlePath);
+    return Lv2PluginCache::NormalizeBundlePath(bundlePath);
+}
+
 void PluginHost::LoadLilv(const char *lv2Path)
 {
 
@@ -470,46 +520,54 @@ void PluginHost::LoadLilv(const char *lv2Path)
 
     LoadPluginClassesFromLilv();
 
+    // Group plugins by bundle. (Cheap: only requires manifest data.)
+    std::map<std::string, std::vector<const LilvPlugin *>> lilvPluginsByBundle;
     LILV_FOREACH(plugins, iPlugin, plugins)
     {
         const LilvPlugin *lilvPlugin = lilv_plugins_get(plugins, iPlugin);
+        lilvPluginsByBundle[GetLilvPluginBundlePath(lilvPlugin)].push_back(lilvPlugin);
+    }
 
-        std::shared_ptr<Lv2PluginInfo> pluginInfo = std::make_shared<Lv2PluginInfo>(this, pWorld, lilvPlugin);
-
-        Lv2Log::debug("Plugin: " + pluginInfo->name());
-
-        if (pluginInfo->hasCvPorts())
-        {
-            Lv2Log::debug("Plugin %s (%s) skipped. (Has CV ports).", pluginInfo->name().c_str(), pluginInfo->uri().c_str());
-        }
-        else if (pluginInfo->hasUnsupportedPatchProperties())
+    // Cached plugin info lets us skip parsing plugin data files of unchanged bundles.
+    Lv2PluginCache pluginCache(this->lv2CachePath);
+    {
+        std::set<std::string> bundlePaths;
+        for (const auto &bundle : lilvPluginsByBundle)
         {
-            Lv2Log::debug("Plugin %s (%s) skipped. (Has unsupported patch parameters).", pluginInfo->name().c_str(), pluginInfo->uri().c_str());
+            bundlePaths.insert(bundle.first);
         }
-#if !SUPPORT_MIDI
-        else if (pluginInfo->plugin_class() == LV2_MIDI_PLUGIN)
+        pluginCache.Load(lv2Path, bundlePaths);
+    }
+
+    this->pluginsByBundle.clear();
+    for (const auto &bundle : lilvPluginsByBundle)
+    {
+        std::set<std::string> pluginUris;
+        for (const LilvPlugin *lilvPlugin : bundle.second)
         {
-            Lv2Log::debug("Plugin %s (%s) skipped. (MIDI Plugin).", pluginInfo->name().c_str(), pluginInfo->uri().c_str());
+            pluginUris.insert(lilv_node_as_uri(lilv_plugin_get_uri(lilvPlugin)));
         }
-#endif
-        else if (!pluginInfo->is_valid())
+        Lv2PluginCache::PluginList bundlePlugins;
+        if (!pluginCache.TryGet(bundle.first, pluginUris, &bundlePlugins))
         {
-            auto &ports = pluginInfo->ports();
-            for (int i = 0; i < ports.size(); ++i)
+            for (const LilvPlugin *lilvPlugin : bundle.second)
             {
-                auto &port = ports[i];
-                if (!port->is_valid())
-                {
-                    Lv2Log::debug("Plugin port %s:%s is invalid.", pluginInfo->name().c_str(), port->name().c_str());
-                }
+                bundlePlugins.push_back(std::make_shared<Lv2PluginInfo>(this, pWorld, lilvPlugin));
             }
-            Lv2Log::debug("Plugin %s (%s) skipped. Not valid.", pluginInfo->name().c_str(), pluginInfo->uri().c_str());
+            pluginCache.Put(bundle.first, bundlePlugins);
         }
         else
         {
-            this->plugins_.push_back(pluginInfo);
+            for (auto &plugin : bundlePlugins)
+            {
+                plugin->Seal();
+            }
         }
+        this->pluginsByBundle[bundle.first] = std::move(bundlePlugins);
     }
+    pluginCache.Save();
+    Lv2Log::info(SS("Plugin cache: " << pluginCache.GetHits() << " bundles cached, " << pluginCache.GetMisses() << " scanned."));
+
     auto messages = stdoutCapture.GetOutputLines();
 
     for (const std::string &s : messages)
@@ -520,102 +578,382 @@ void PluginHost::LoadLilv(const char *lv2Path)
         }
     }
 
-    auto collator = Locale::GetInstance()->GetCollator();
-    auto compare = [&collator](
-                       const std::shared_ptr<Lv2PluginInfo> &left,
-                       const std::shared_ptr<Lv2PluginInfo> &right)
-    {
-        const char *pb1 = left->name().c_str();
-        const char *pb2 = right->name().c_str();
-        return collator->Compare(
-                   left->name(), right->name()) < 0;
-    };
-    std::sort(this->plugins_.begin(), this->plugins_.end(), compare);
-
-    for (auto plugin : this->plugins_)
+#if ENABLE_VST3
+    if (vst3Enabled)
     {
-        pluginsByUri[plugin->uri()] = plugin;
+        Lv2Log::info("Scanning for VST3 Plugins");
+        this->vst3Host = Vst3Host::CreateInstance(
+            this->vst3CachePath);
+        this->vst3Host->RefreshPlugins();
+    }
+#endif
+    UpdatePluginLists();
+    RebuildSearchIndex();
+};
 
-        Lv2PluginUiInfo info(this, plugin.get());
-        if (plugin->is_valid())
+bool PluginHost::IsSupportedPlugin(const Lv2PluginInfo &plugin)
+{
+    if (plugin.hasCvPorts())
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. (Has CV ports).", plugin.name().c_str(), plugin.uri().c_str());
+        return false;
+    }
+    if (plugin.hasUnsupportedPatchProperties())
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. (Has unsupported patch parameters).", plugin.name().c_str(), plugin.uri().c_str());
+        return false;
+    }
+#if !SUPPORT_MIDI
+    if (plugin.plugin_class() == LV2_MIDI_PLUGIN)
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. (MIDI Plugin).", plugin.name().c_str(), plugin.uri().c_str());
+        return false;
+    }
+#endif
+    if (!plugin.is_valid())
+    {
+        auto &ports = plugin.ports();
+        for (int i = 0; i < ports.size(); ++i)
         {
-#if 1
-            // no plugins with more than 2 inputs or outputs.
-            // no zero-input or zero-output plugins (temporarily disables midi plugins)
-            // no zero output devices (permanent, I think)
-            if (info.audio_inputs() > 2 || info.audio_outputs() > 2)
-            {
-                Lv2Log::debug(
-                    "Plugin %s (%s) skipped. %d inputs, %d outputs.", plugin->name().c_str(), plugin->uri().c_str(),
-                    (int)info.audio_inputs(), (int)info.audio_outputs());
-            }
-            else if (info.audio_inputs() == 0 && info.audio_outputs() == 0)
-            {
-                Lv2Log::debug("Plugin %s (%s) skipped. No audio i/o.", plugin->name().c_str(), plugin->uri().c_str());
-            }
-            else if (info.audio_inputs() == 0)
+            auto &port = ports[i];
+            if (!port->is_valid())
             {
-                // temporarily disable this feature.
-                Lv2Log::debug("Plugin %s (%s) skipped. No inputs.", plugin->name().c_str(), plugin->uri().c_str());
+                Lv2Log::debug("Plugin port %s:%s is invalid.", plugin.name().c_str(), port->name().c_str());
             }
+        }
+        Lv2Log::debug("Plugin %s (%s) skipped. Not valid.", plugin.name().c_str(), plugin.uri().c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PluginHost::IsSupportedUiPlugin(const Lv2PluginUiInfo &info, const Lv2PluginInfo *plugin)
+{
+#if 1
+    // no plugins with more than 2 inputs or outputs.
+    // no zero-input or zero-output plugins (temporarily disables midi plugins)
+    // no zero output devices (permanent, I think)
+    if (info.audio_inputs() > 2 || info.audio_outputs() > 2)
+    {
+        Lv2Log::debug(
+            "Plugin %s (%s) skipped. %d inputs, %d outputs.", plugin->name().c_str(), plugin->uri().c_str(),
+            (int)info.audio_inputs(), (int)info.audio_outputs());
+    }
+    else if (info.audio_inputs() == 0 && info.audio_outputs() == 0)
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. No audio i/o.", plugin->name().c_str(), plugin->uri().c_str());
+    }
+    else if (info.audio_inputs() == 0)
+    {
+        // temporarily disable this feature.
+        Lv2Log::debug("Plugin %s (%s) skipped. No inputs.", plugin->name().c_str(), plugin->uri().c_str());
+    }
 #elif SUPPORT_MIDI
-            if (info.audio_inputs() == 0 && !info.has_midi_input())
-            {
-                Lv2Log::debug("Plugin %s (%s) skipped. No inputs.", plugin->name().c_str(), plugin->uri().c_str());
-            }
-            else if (info.audio_outputs() == 0 && !info.has_midi_output())
-            {
-                Lv2Log::debug("Plugin %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
-            }
+    if (info.audio_inputs() == 0 && !info.has_midi_input())
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. No inputs.", plugin->name().c_str(), plugin->uri().c_str());
+    }
+    else if (info.audio_outputs() == 0 && !info.has_midi_output())
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
+    }
 #else
-            if (info.audio_inputs() == 0)
+    if (info.audio_inputs() == 0)
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. No audio inputs.", plugin->name().c_str(), plugin->uri().c_str());
+    }
+    else if (info.audio_outputs() == 0)
+    {
+        Lv2Log::debug("Plugin %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
+    }
+#endif
+    else
+    {
+        if (info.audio_inputs() == 0)
+        {
+            Lv2Log::debug("************* ZERO INPUTS: %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
+        }
+        return true;
+    }
+    return false;
+}
+
+void PluginHost::UpdatePluginLists()
+{
+    this->plugins_.clear();
+    this->pluginsByUri.clear();
+    this->ui_plugins_.clear();
+
+    for (const auto &bundle : pluginsByBundle)
+    {
+        for (const auto &pluginInfo : bundle.second)
+        {
+            Lv2Log::debug("Plugin: " + pluginInfo->name());
+            if (IsSupportedPlugin(*pluginInfo))
             {
-                Lv2Log::debug("Plugin %s (%s) skipped. No audio inputs.", plugin->name().c_str(), plugin->uri().c_str());
+                this->plugins_.push_back(pluginInfo);
             }
-            else if (info.audio_outputs() == 0)
+        }
+    }
+
+    auto collator = Locale::GetInstance()->GetCollator();
+    collator->Sort(
+        this->plugins_,
+        [](const std::shared_ptr<Lv2PluginInfo> &plugin)
+        {
+            return plugin->name();
+        });
+
+    for (auto plugin : this->plugins_)
+    {
+        pluginsByUri[plugin->uri()] = plugin;
+
+        Lv2PluginUiInfo info(this, plugin.get());
+        if (plugin->is_valid() && IsSupportedUiPlugin(info, plugin.get()))
+        {
+            ui_plugins_.push_back(std::move(info));
+        }
+    }
+
+#if ENABLE_VST3
+    if (this->vst3Host)
+    {
+        const auto &vst3PluginList = this->vst3Host->getPluginList();
+        for (const auto &vst3Plugin : vst3PluginList)
+        {
+            // copy not move!
+            ui_plugins_.push_back(vst3Plugin->pluginInfo_);
+        }
+        collator->Sort(
+            this->ui_plugins_,
+            [](const Lv2PluginUiInfo &plugin)
             {
-                Lv2Log::debug("Plugin %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
-            }
+                return plugin.name();
+            });
+    }
 #endif
-            else
+    uiPluginIndexByUri.clear();
+    for (size_t i = 0; i < ui_plugins_.size(); ++i)
+    {
+        uiPluginIndexByUri[ui_plugins_[i].uri()] = i;
+    }
+}
+
+PluginSearchIndex::Document PluginHost::MakeSearchDocument(const Lv2PluginUiInfo &uiPlugin) const
+{
+    PluginSearchIndex::Document document;
+    document.uri = uiPlugin.uri();
+    document.name = uiPlugin.name();
+    document.pluginDisplayType = uiPlugin.plugin_display_type();
+    document.authorName = uiPlugin.author_name();
+    document.isVst3 = uiPlugin.is_vst3();
+    document.hasModGui = uiPlugin.modGui() != nullptr;
+
+    document.pluginTypes.push_back(uiPlugin.plugin_type());
+    auto pluginClass = GetPluginClass(plugin_type_to_uri(uiPlugin.plugin_type()));
+    if (pluginClass)
+    {
+        for (const Lv2PluginClass *parent = pluginClass->parent_; parent != nullptr; parent = parent->parent_)
+        {
+            document.pluginTypes.push_back(parent->plugin_type_);
+        }
+    }
+    for (const auto &control : uiPlugin.controls())
+    {
+        document.portNames.push_back(control.name());
+        document.portNames.push_back(control.symbol());
+    }
+    return document;
+}
+
+void PluginHost::RebuildSearchIndex()
+{
+    searchIndex.Clear();
+    for (const auto &uiPlugin : ui_plugins_)
+    {
+        searchIndex.Update(MakeSearchDocument(uiPlugin));
+    }
+}
+
+PluginSearchResult PluginHost::SearchPlugins(const PluginSearchRequest &request) const
+{
+    PluginSearchIndex::Result found = searchIndex.Search(request);
+
+    PluginSearchResult result;
+    result.totalResults_ = found.totalResults;
+    result.page_ = request.page_;
+    result.pageSize_ = std::clamp<uint32_t>(request.pageSize_, 1, PluginSearchIndex::MAX_PAGE_SIZE);
+    for (const auto &uri : found.uris)
+    {
+        auto ff = uiPluginIndexByUri.find(uri);
+        if (ff != uiPluginIndexByUri.end())
+        {
+            result.plugins_.push_back(ui_plugins_[ff->second]);
+        }
+    }
+    return result;
+}
+
+static std::string UiPluginJson(const Lv2PluginUiInfo &info)
+{
+    std::string json;
+    json_writer writer(json, true);
+    writer.write(info);
+    return json;
+}
+
+bool PluginHost::ReloadBundles(
+    const std::vector<std::string> &bundlePaths,
+    const std::set<std::string> &inUsePluginUris,
+    Lv2PluginListDelta *delta)
+{
+    std::lock_guard lock(createPedalboardMutex);
+    if (!pWorld)
+    {
+        return false;
+    }
+
+    std::set<std::string> changedBundles;
+    for (const auto &path : bundlePaths)
+    {
+        std::string bundlePath = Lv2PluginCache::NormalizeBundlePath(path);
+        std::error_code ec;
+        bool isDirectory = std::filesystem::is_directory(bundlePath, ec);
+        auto oldBundle = pluginsByBundle.find(bundlePath);
+        if (oldBundle == pluginsByBundle.end())
+        {
+            if (!isDirectory)
             {
-                if (info.audio_inputs() == 0)
+                continue; // a stray file, or a deleted bundle that didn't provide plugins.
+            }
+        }
+        else
+        {
+            for (const auto &plugin : oldBundle->second)
+            {
+                if (inUsePluginUris.contains(plugin->uri()))
                 {
-                    Lv2Log::debug("************* ZERO INPUTS: %s (%s) skipped. No audio outputs.", plugin->name().c_str(), plugin->uri().c_str());
+                    Lv2Log::info(SS("Plugin " << plugin->uri() << " is in use. Full plugin reload required."));
+                    return false;
                 }
-                ui_plugins_.push_back(std::move(info));
             }
         }
+        changedBundles.insert(bundlePath);
+    }
+    if (changedBundles.empty())
+    {
+        return true;
     }
 
-#if ENABLE_VST3
-    if (vst3Enabled)
+    StdErrorCapture stdoutCapture; // captures lilv messages written to STDOUT.
+
+    std::map<std::string, std::string> oldUiPlugins;
+    for (const auto &uiPlugin : ui_plugins_)
     {
-        Lv2Log::info("Scanning for VST3 Plugins");
-        this->vst3Host = Vst3Host::CreateInstance(
-            this->vst3CachePath);
-        this->vst3Host->RefreshPlugins();
+        oldUiPlugins[uiPlugin.uri()] = UiPluginJson(uiPlugin);
+    }
 
-        const auto &vst3PluginList = this->vst3Host->getPluginList();
-        for (const auto &vst3Plugin : vst3PluginList)
+    for (const auto &bundlePath : changedBundles)
+    {
+        AutoLilvNode bundleUri = lilv_new_file_uri(pWorld, nullptr, (bundlePath + "/").c_str());
+        if (pluginsByBundle.contains(bundlePath))
         {
-            // copy not move!
-            ui_plugins_.push_back(vst3Plugin->pluginInfo_);
+            // also removes the bundle's plugins from the world's plugin list.
+            lilv_world_unload_bundle(pWorld, bundleUri);
+            pluginsByBundle.erase(bundlePath);
         }
-        auto ui_compare = [&collation](
-                              Lv2PluginUiInfo &left,
-                              Lv2PluginUiInfo &right)
+        std::error_code ec;
+        if (std::filesystem::is_directory(bundlePath, ec))
         {
-            const char *pb1 = left.name().c_str();
-            const char *pb2 = right.name().c_str();
-            return collation.compare(
-                       pb1, pb1 + left.name().size(),
-                       pb2, pb2 + right.name().size()) < 0;
-        };
-        std::sort(this->ui_plugins_.begin(), this->ui_plugins_.end(), ui_compare);
+            Lv2Log::info(SS("Loading LV2 bundle " << bundlePath));
+            lilv_world_load_bundle(pWorld, bundleUri);
+        }
     }
-#endif
-};
+
+    // Pick up plugins provided by the (re)loaded bundles.
+    bool dataBundleChanged = false;
+    std::map<std::string, Lv2PluginCache::PluginList> newBundles;
+    const LilvPlugins *plugins = lilv_world_get_all_plugins(pWorld);
+    LILV_FOREACH(plugins, iPlugin, plugins)
+    {
+        const LilvPlugin *lilvPlugin = lilv_plugins_get(plugins, iPlugin);
+        std::string bundlePath = GetLilvPluginBundlePath(lilvPlugin);
+        if (changedBundles.contains(bundlePath))
+        {
+            auto pluginInfo = std::make_shared<Lv2PluginInfo>(this, pWorld, lilvPlugin);
+            if (inUsePluginUris.contains(pluginInfo->uri()))
+            {
+                dataBundleChanged = true;
+            }
+            newBundles[bundlePath].push_back(std::move(pluginInfo));
+        }
+    }
+    for (const auto &bundlePath : changedBundles)
+    {
+        std::error_code ec;
+        if (!newBundles.contains(bundlePath) && std::filesystem::is_directory(bundlePath, ec))
+        {
+            // A bundle that doesn't provide plugins (presets, for example) can add data to any plugin.
+            dataBundleChanged = true;
+        }
+    }
+    for (auto &bundle : newBundles)
+    {
+        pluginsByBundle[bundle.first] = std::move(bundle.second);
+    }
+
+    for (const std::string &s : stdoutCapture.GetOutputLines())
+    {
+        if (s.length() != 0)
+        {
+            Lv2Log::info("lilv: " + s);
+        }
+    }
+    if (dataBundleChanged)
+    {
+        Lv2Log::info("Full plugin reload required.");
+        return false;
+    }
+
+    UpdatePluginLists();
+    {
+        std::lock_guard<std::mutex> modGuiLock(modGuiCacheMutex);
+        modGuiCache.clear();
+    }
+
+    delta->updated_.clear();
+    delta->removed_.clear();
+    for (const auto &uiPlugin : ui_plugins_)
+    {
+        auto oldPlugin = oldUiPlugins.find(uiPlugin.uri());
+        if (oldPlugin == oldUiPlugins.end())
+        {
+            delta->updated_.push_back(uiPlugin);
+        }
+        else
+        {
+            if (oldPlugin->second != UiPluginJson(uiPlugin))
+            {
+                delta->updated_.push_back(uiPlugin);
+            }
+            oldUiPlugins.erase(oldPlugin);
+        }
+    }
+    for (const auto &oldPlugin : oldUiPlugins)
+    {
+        delta->removed_.push_back(oldPlugin.first);
+    }
+    for (const auto &uri : delta->removed_)
+    {
+        searchIndex.Remove(uri);
+    }
+    for (const auto &uiPlugin : delta->updated_)
+    {
+        searchIndex.Update(MakeSearchDocument(uiPlugin));
+    }
+    Lv2Log::info(SS("Plugins reloaded: " << delta->updated_.size() << " added or updated, " << delta->removed_.size() << " removed."));
+    return true;
+}
 
 static std::vector<std::string> nodeAsStringArray(const LilvNodes *nodes)
 {
@@ -894,16 +1232,16 @@ Lv2PluginInfo::Lv2PluginInfo(PluginHost *lv2Host, LilvWorld *pWorld, const LilvP
     }
 
     AutoLilvNodes required_features = lilv_plugin_get_required_features(pPlugin);
-    this->required_features_ = nodeAsStringArray(required_features);
+    this->required_features_ = Intern(nodeAsStringArray(required_features));
 
     AutoLilvNodes supported_features = lilv_plugin_get_supported_features(pPlugin);
-    this->supported_features_ = nodeAsStringArray(supported_features);
+    this->supported_features_ = Intern(nodeAsStringArray(supported_features));
 
     AutoLilvNodes optional_features = lilv_plugin_get_optional_features(pPlugin);
-    this->optional_features_ = nodeAsStringArray(optional_features);
+    this->optional_features_ = Intern(nodeAsStringArray(optional_features));
 
     AutoLilvNodes extensions = lilv_plugin_get_extension_data(pPlugin);
-    this->extensions_ = nodeAsStringArray(extensions);
+    this->extensions_ = Intern(nodeAsStringArray(extensions));
 
     AutoLilvNode comment = lv2Host->get_comment(this->uri_);
     this->comment_ = nodeAsString(comment);
@@ -1138,8 +1476,9 @@ Lv2PluginInfo::Lv2PluginInfo(PluginHost *lv2Host, LilvWorld *pWorld, const LilvP
     {
         isValid = false;
     }
-    this->modGui_ = ModGui::Create(lv2Host, pPlugin);
+    this->modGui_ = ModGui::CreateSummary(lv2Host, pPlugin);
     this->is_valid_ = isValid;
+    Seal();
 }
 
 std::vector<std::string> supportedFeatures = {
@@ -1159,6 +1498,10 @@ std::vector<std::string> supportedFeatures = {
     LV2_CORE__inPlaceBroken,
     PIPEDAL_HOST_FEATURE,
     PIPEDAL__FILE_METADATA_FEATURE,
+    PIPEDAL__SHARED_RESOURCE_FEATURE,
+    PIPEDAL__FILE_STREAM_FEATURE,
+    PIPEDAL__ALWAYS_RUN_FEATURE,
+    LV2_TASKGROUP__taskGroup,
 
     // UI features that we can ignore, since we won't load their ui.
     "http://lv2plug.in/ns/extensions/ui#makeResident",
@@ -1175,10 +1518,68 @@ bool Lv2PluginInfo::IsSupportedFeature(const std::string &feature) const
     }
     return false;
 }
+bool Lv2PluginInfo::IsFeatureDeclared(const char *feature) const
+{
+    for (const auto &declaredFeature : required_features_)
+    {
+        if (declaredFeature == feature)
+            return true;
+    }
+    for (const auto &declaredFeature : optional_features_)
+    {
+        if (declaredFeature == feature)
+            return true;
+    }
+    return false;
+}
 Lv2PluginInfo::~Lv2PluginInfo()
 {
 }
 
+void Lv2PluginInfo::Seal()
+{
+    if (sealed_)
+    {
+        return;
+    }
+    sealed_ = true;
+
+    // ports_ keeps its type, but its pointers share ownership of one block.
+    auto portBlock = std::make_shared<std::vector<Lv2PortInfo>>();
+    portBlock->reserve(ports_.size());
+    for (const auto &port : ports_)
+    {
+        portBlock->push_back(*port);
+    }
+    std::vector<PerfectHashIndex::Entry> controls;
+    for (size_t i = 0; i < ports_.size(); ++i)
+    {
+        Lv2PortInfo *port = &(*portBlock)[i];
+        ports_[i] = std::shared_ptr<Lv2PortInfo>(portBlock, port);
+        if (port->is_control_port())
+        {
+            controls.push_back(PerfectHashIndex::Entry(port->symbol(), (int32_t)port->index()));
+        }
+    }
+    controlIndex_ = PerfectHashIndex(controls);
+}
+
+int Lv2PluginInfo::GetControlIndex(const std::string &symbol) const
+{
+    if (!sealed_)
+    {
+        for (const auto &port : ports_)
+        {
+            if (port->is_control_port() && port->symbol() == symbol)
+            {
+                return (int)port->index();
+            }
+        }
+        return -1;
+    }
+    return controlIndex_.Find(symbol);
+}
+
 bool Lv2PortInfo::is_a(PluginHost *lv2Plugins, const char *classUri)
 {
     return classes_.is_a(lv2Plugins, classUri);
@@ -1504,13 +1905,13 @@ Lv2PluginUiInfo::Lv2PluginUiInfo(PluginHost *pHost, const Lv2PluginInfo *plugin)
     {
         this->port_groups_.push_back(Lv2PluginUiPortGroup(portGroup.get()));
     }
-    auto &piPedalUI = plugin->piPedalUI();
+    const auto &piPedalUI = plugin->lazyPiPedalUI();
 
-    if (piPedalUI)
+    if (!piPedalUI.empty())
     {
-        this->fileProperties_ = piPedalUI->fileProperties();
-        this->frequencyPlots_ = piPedalUI->frequencyPlots();
-        this->uiPortNotifications_ = piPedalUI->portNotifications();
+        this->fileProperties_ = piPedalUI.GetMemberJson("fileProperties");
+        this->frequencyPlots_ = piPedalUI.GetMemberJson("frequencyPlots");
+        this->uiPortNotifications_ = piPedalUI.GetMemberJson("portNotifications");
     }
 }
 
@@ -1531,6 +1932,7 @@ std::shared_ptr<Lv2PluginInfo> PluginHost::GetPluginInfo(const std::string &uri)
 
 Lv2Pedalboard *PluginHost::UpdateLv2PedalboardStructure(Pedalboard &pedalboard, Lv2Pedalboard *existingPedalboard, Lv2PedalboardErrorList &errorList)
 {
+    std::lock_guard lock(createPedalboardMutex);
     ExistingEffectMap existingEffects;
 
     if (existingPedalboard)
@@ -1558,10 +1960,16 @@ Lv2Pedalboard *PluginHost::UpdateLv2PedalboardStructure(Pedalboard &pedalboard,
 
 Lv2Pedalboard *PluginHost::CreateLv2Pedalboard(Pedalboard &pedalboard, Lv2PedalboardErrorList &errorMessages)
 {
+    return CreateLv2Pedalboard(pedalboard, errorMessages, -1, -1);
+}
+
+Lv2Pedalboard *PluginHost::CreateLv2Pedalboard(Pedalboard &pedalboard, Lv2PedalboardErrorList &errorMessages, int inputChannels, int outputChannels)
+{
+    std::lock_guard lock(createPedalboardMutex);
     Lv2Pedalboard *pPedalboard = new Lv2Pedalboard();
     try
     {
-        pPedalboard->Prepare(this, pedalboard, errorMessages);
+        pPedalboard->Prepare(this, pedalboard, errorMessages, nullptr, inputChannels, outputChannels);
         return pPedalboard;
     }
     catch (const std::exception &e)
@@ -1594,6 +2002,49 @@ void PluginHost::fn_LilvSetPortValueFunc(const char *port_symbol,
     pResult->push_back(ControlValue(port_symbol, *(float *)value));
 }
 
+ModGui::ptr PluginHost::GetModGui(const std::string &uri)
+{
+    auto pluginInfo = GetPluginInfo(uri);
+    if (!pluginInfo || !pluginInfo->modGui())
+    {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> modGuiLock(modGuiCacheMutex);
+        ModGui::ptr result;
+        if (modGuiCache.get(uri, result))
+        {
+            return result;
+        }
+    }
+
+    ModGui::ptr result;
+    {
+        std::lock_guard lock(createPedalboardMutex);
+        std::lock_guard<std::mutex> worldLock(lilvWorldMutex);
+        if (!pWorld)
+        {
+            return nullptr;
+        }
+        AutoLilvNode uriNode = lilv_new_uri(pWorld, uri.c_str());
+        // plugin data files aren't loaded if the plugin info came from the plugin cache.
+        lilv_world_load_resource(pWorld, uriNode);
+
+        const LilvPlugin *plugin = lilv_plugins_get_by_uri(lilv_world_get_all_plugins(pWorld), uriNode);
+        if (plugin == nullptr)
+        {
+            return nullptr;
+        }
+        result = ModGui::Create(this, plugin);
+    }
+    if (result)
+    {
+        std::lock_guard<std::mutex> modGuiLock(modGuiCacheMutex);
+        modGuiCache.put(uri, result);
+    }
+    return result;
+}
+
 std::vector<ControlValue> PluginHost::LoadFactoryPluginPreset(
     PedalboardItem *pedalboardItem, const std::string &presetUri)
 {
@@ -1870,10 +2321,11 @@ static std::map<std::string,std::string> ExtractPathPropertiesFromLilvState(
 
 
 bool Lv2PluginInfo::IsPathProperty(const std::string &uri) const {
-    if (!piPedalUI_) {
-
+    PiPedalUI::ptr piPedalUI = this->piPedalUI();
+    if (!piPedalUI) {
+        return false;
     }
-    for (const UiFileProperty::ptr& fileProperty: this->piPedalUI_->fileProperties()) 
+    for (const UiFileProperty::ptr& fileProperty: piPedalUI->fileProperties()) 
     {
         if (fileProperty->patchProperty() == uri)
         {
@@ -1962,7 +2414,7 @@ PluginPresets PluginHost::GetFactoryPluginPresets(const std::string &pluginUri)
     return result;
 }
 
-IEffect *PluginHost::CreateEffect(PedalboardItem &pedalboardItem)
+IEffect *PluginHost::CreateEffect(PedalboardItem &pedalboardItem, const std::shared_ptr<RealtimeArena> &realtimeArena)
 {
     if (pedalboardItem.uri().starts_with("vst3:"))
     {
@@ -1989,7 +2441,11 @@ IEffect *PluginHost::CreateEffect(PedalboardItem &pedalboardItem)
         if (!info)
             return nullptr;
 
-        return new Lv2Effect(this, info, pedalboardItem);
+        if (sandboxedPlugins.contains(pedalboardItem.uri()))
+        {
+            return new SandboxedEffect(this, info, pedalboardItem, configDirectory);
+        }
+        return new Lv2Effect(this, info, pedalboardItem, realtimeArena);
     }
 }
 
@@ -2161,6 +2617,28 @@ void PluginHost::CheckForResourceInitialization(const std::string &pluginUri, co
     }
 }
 
+void PluginHost::RetainPathPropertyFiles(Pedalboard &pedalboard)
+{
+    for (PedalboardItem *item : pedalboard.GetAllPlugins())
+    {
+        for (const auto &pathProperty : item->pathProperties_)
+        {
+            try
+            {
+                json_variant value = MapPath(json_variant::parse(pathProperty.second));
+                if (value.is_object() && value["value"].is_string())
+                {
+                    sharedResourceFeature.RetainFile(value["value"].as_string());
+                }
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::debug(SS("RetainPathPropertyFiles: " << pathProperty.first << ": " << e.what()));
+            }
+        }
+    }
+}
+
 json_variant PluginHost::MapPath(const json_variant &json)
 {
     AtomConverter converter(GetMapFeature());
@@ -2238,7 +2716,7 @@ Lv2PatchPropertyInfo::Lv2PatchPropertyInfo(PluginHost *pluginHost, const LilvNod
 }
 
 // ffs.
-static inline bool contains(const std::vector<std::string> &vec, const std::string &value)
+static inline bool contains(const std::vector<InternedString> &vec, const std::string &value)
 {
     return std::find(vec.begin(), vec.end(), value) != vec.end();
 }
@@ -2246,6 +2724,14 @@ bool Lv2PluginInfo::WantsWorkerThread() const
 {
     return contains(this->required_features_, LV2_WORKER__schedule) || contains(this->supported_features_, LV2_WORKER__schedule);
 }
+bool Lv2PluginInfo::IsInPlaceBroken() const
+{
+    return contains(this->required_features_, LV2_CORE__inPlaceBroken) || contains(this->supported_features_, LV2_CORE__inPlaceBroken);
+}
+bool Lv2PluginInfo::IsLive() const
+{
+    return contains(this->required_features_, LV2_CORE__isLive) || contains(this->supported_features_, LV2_CORE__isLive);
+}
 // void PiPedalHostLogError(const std::string &error)
 // {
 //     Lv2Log::error("%s",error.c_str());
@@ -2287,7 +2773,7 @@ json_map::storage_type<Lv2PortInfo> Lv2PortInfo::jmap{
 
      json_map::reference("is_control_port", &Lv2PortInfo::is_control_port_),
      json_map::reference("is_audio_port", &Lv2PortInfo::is_audio_port_),
-     json_map::reference("is_atom_port", &Lv2PortInfo::is_audio_port_),
+     json_map::reference("is_atom_port", &Lv2PortInfo::is_atom_port_),
      json_map::reference("is_cv_port", &Lv2PortInfo::is_cv_port_),
      json_map::reference("connection_optional", &Lv2PortInfo::connection_optional_),
 
@@ -2312,6 +2798,7 @@ json_map::storage_type<Lv2PortInfo> Lv2PortInfo::jmap{
      MAP_REF(Lv2PortInfo, buffer_type),
      MAP_REF(Lv2PortInfo, port_group),
      MAP_REF(Lv2PortInfo, is_bypass),
+     MAP_REF(Lv2PortInfo, designation),
      MAP_REF(Lv2PortInfo, pipedal_ledColor),
 
      json_map::enum_reference("units", &Lv2PortInfo::units_, get_units_enum_converter()),
@@ -2358,6 +2845,10 @@ json_map::storage_type<Lv2PluginInfo> Lv2PluginInfo::jmap{{
     json_map::reference("hasDefaultState", &Lv2PluginInfo::hasDefaultState_),
     json_map::reference("minBlockLength", &Lv2PluginInfo::minBlockLength_),
     json_map::reference("maxBlockLength", &Lv2PluginInfo::maxBlockLength_),
+    json_map::reference("powerOf2BlockLength", &Lv2PluginInfo::powerOf2BlockLength_),
+    json_map::reference("audio_sidechain_title", &Lv2PluginInfo::audio_sidechain_title_),
+    json_map::reference("piPedalUI", &Lv2PluginInfo::piPedalUI_),
+    json_map::reference("hasUnsupportedPatchProperties", &Lv2PluginInfo::hasUnsupportedPatchProperties_),
 
 }};
 
@@ -2441,8 +2932,23 @@ json_map::storage_type<Lv2PluginUiInfo>
             json_map::reference("modGui", &Lv2PluginUiInfo::modGui_),
             json_map::reference("patchProperties", &Lv2PluginUiInfo::patchProperties_),
         }};
+JSON_MAP_BEGIN(Lv2PluginListDelta)
+JSON_MAP_REFERENCE(Lv2PluginListDelta, updated)
+JSON_MAP_REFERENCE(Lv2PluginListDelta, removed)
+JSON_MAP_END()
+
+JSON_MAP_BEGIN(PluginSearchResult)
+JSON_MAP_REFERENCE(PluginSearchResult, totalResults)
+JSON_MAP_REFERENCE(PluginSearchResult, page)
+JSON_MAP_REFERENCE(PluginSearchResult, pageSize)
+JSON_MAP_REFERENCE(PluginSearchResult, plugins)
+JSON_MAP_END()
+
 JSON_MAP_BEGIN(Lv2PatchPropertyInfo)
 JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, uri)
+JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, writable)
+JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, readable)
+JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, index)
 JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, label)
 JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, type)
 JSON_MAP_REFERENCE(Lv2PatchPropertyInfo, comment)
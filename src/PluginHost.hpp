@@ -26,11 +26,14 @@
 #include <lilv/lilv.h>
 #include "MapFeature.hpp"
 #include "FileMetadataFeature.hpp"
+#include "SharedResourceFeature.hpp"
+#include "FileStreamFeature.hpp"
 #include <filesystem>
 #include <cmath>
 #include <string>
 #include "IHost.hpp"
 #include <set>
+#include <unordered_map>
 #include "ModGui.hpp"
 
 // #include "lv2.h"
@@ -43,6 +46,10 @@
 #include "PiPedalUI.hpp"
 #include "MapPathFeature.hpp"
 #include "ModGui.hpp"
+#include "LRUCache.hpp"
+#include "InternedString.hpp"
+#include "PerfectHashIndex.hpp"
+#include "PluginSearchIndex.hpp"
 
 namespace pipedal
 {
@@ -54,6 +61,7 @@ namespace pipedal
     class PluginHost;
     class JackConfiguration;
     class JackChannelSelection;
+    class PluginCostDatabase;
 
 #ifndef LV2_PROPERTY_GETSET
 #define LV2_PROPERTY_GETSET(name)             \
@@ -141,17 +149,17 @@ namespace pipedal
     class Lv2PluginClasses
     {
     private:
-        std::vector<std::string> classes_;
+        std::vector<InternedString> classes_;
 
     public:
         Lv2PluginClasses()
         {
         }
-        Lv2PluginClasses(std::vector<std::string> classes)
-            : classes_(classes)
+        Lv2PluginClasses(const std::vector<std::string> &classes)
+            : classes_(Intern(classes))
         {
         }
-        const std::vector<std::string> &classes() const
+        const std::vector<InternedString> &classes() const
         {
             return classes_;
         }
@@ -227,10 +235,10 @@ namespace pipedal
         bool pipedal_graphicEq_ = false;
 
         bool not_on_gui_ = false;
-        std::string buffer_type_;
-        std::string port_group_;
+        InternedString buffer_type_;
+        InternedString port_group_;
 
-        std::string designation_;
+        InternedString designation_;
         bool is_bypass_ = false;
         Units units_ = Units::none;
         std::string custom_units_;
@@ -274,6 +282,28 @@ namespace pipedal
                 value = min_value_;
             return value;
         }
+        // inverse of rangeToValue.
+        float valueToRange(float value) const
+        {
+            float range;
+            if (max_value_ == min_value_)
+            {
+                return 0;
+            }
+            if (is_logarithmic_)
+            {
+                range = std::log(value / min_value_) / std::log(max_value_ / min_value_);
+            }
+            else
+            {
+                range = (value - min_value_) / (max_value_ - min_value_);
+            }
+            if (!(range >= 0)) // also catches NaN.
+                range = 0;
+            if (range > 1)
+                range = 1;
+            return range;
+        }
         LV2_PROPERTY_GETSET(symbol);
         LV2_PROPERTY_GETSET_SCALAR(index);
         LV2_PROPERTY_GETSET(name);
@@ -411,17 +441,17 @@ namespace pipedal
         uint32_t minorVersion_ = 0;
         uint32_t microVersion_ = 0;
         std::string name_;
-        std::string plugin_class_;
+        InternedString plugin_class_;
         std::string brand_;
         std::string label_;
-        std::vector<std::string> supported_features_;
-        std::vector<std::string> required_features_;
-        std::vector<std::string> optional_features_;
-        std::vector<std::string> extensions_;
+        std::vector<InternedString> supported_features_;
+        std::vector<InternedString> required_features_;
+        std::vector<InternedString> optional_features_;
+        std::vector<InternedString> extensions_;
         bool has_factory_presets_ = false;
 
-        std::string author_name_;
-        std::string author_homepage_;
+        InternedString author_name_;
+        InternedString author_homepage_;
 
         std::string comment_;
         std::vector<std::shared_ptr<Lv2PortInfo>> ports_;
@@ -431,7 +461,7 @@ namespace pipedal
         bool hasDefaultState_;
 
         bool is_valid_ = false;
-        PiPedalUI::ptr piPedalUI_;
+        LazyPiPedalUI piPedalUI_;
         ModGui::ptr modGui_;
 
         bool hasUnsupportedPatchProperties_ = false;
@@ -442,6 +472,9 @@ namespace pipedal
         float minBlockLength_ = -1;
         float maxBlockLength_ = -1;
 
+        bool sealed_ = false;
+        PerfectHashIndex controlIndex_; // control port symbol -> port index.
+
     public:
         LV2_PROPERTY_GETSET(bundle_path)
         LV2_PROPERTY_GETSET(uri)
@@ -462,17 +495,30 @@ namespace pipedal
         LV2_PROPERTY_GETSET(is_valid)
         LV2_PROPERTY_GETSET(port_groups)
         LV2_PROPERTY_GETSET(has_factory_presets)
-        LV2_PROPERTY_GETSET(piPedalUI)
+        PiPedalUI::ptr piPedalUI() const { return piPedalUI_.get(); }
+        void piPedalUI(const PiPedalUI::ptr &value) { piPedalUI_ = value; }
+        // The PiPedalUI, without forcing it to be parsed.
+        const LazyPiPedalUI &lazyPiPedalUI() const { return piPedalUI_; }
         LV2_PROPERTY_GETSET(hasUnsupportedPatchProperties)
         LV2_PROPERTY_GETSET(modGui)
         LV2_PROPERTY_GETSET(patchProperties)
         LV2_PROPERTY_GETSET(hasDefaultState)
+        // The plugin lists the feature as either a required or an optional feature.
+        bool IsFeatureDeclared(const char *feature) const;
         LV2_PROPERTY_GETSET(minBlockLength)
         LV2_PROPERTY_GETSET(maxBlockLength)
         LV2_PROPERTY_GETSET(powerOf2BlockLength)
         LV2_PROPERTY_GETSET(audio_sidechain_title)
 
         bool WantsWorkerThread() const;
+        bool IsInPlaceBroken() const;
+        bool IsLive() const; // lv2:isLive
+
+        // Call once the plugin info is complete, and before it's shared. Moves the ports into a
+        // single allocation, and builds the control port index.
+        void Seal();
+        // The port index of a control port, or -1.
+        int GetControlIndex(const std::string &symbol) const;
 
         const Lv2PortInfo &getPort(const std::string &symbol)
         {
@@ -525,6 +571,7 @@ namespace pipedal
                     return true;
                 }
             }
+            return false;
         }
         bool IsPathProperty(const std::string &uri) const;
 
@@ -717,9 +764,10 @@ namespace pipedal
 
         std::vector<Lv2PluginUiPort> controls_;
         std::vector<Lv2PluginUiPortGroup> port_groups_;
-        std::vector<UiFileProperty::ptr> fileProperties_;
-        std::vector<UiFrequencyPlot::ptr> frequencyPlots_;
-        std::vector<UiPortNotification::ptr> uiPortNotifications_;
+        // copied from the plugin's PiPedalUI as json text, so that building the catalog doesn't parse it.
+        JsonRawText fileProperties_{"[]"};
+        JsonRawText frequencyPlots_{"[]"};
+        JsonRawText uiPortNotifications_{"[]"};
         ModGui::ptr modGui_;
         std::vector<Lv2PatchPropertyInfo> patchProperties_;
 
@@ -753,6 +801,30 @@ namespace pipedal
         static json_map::storage_type<Lv2PluginUiInfo> jmap;
     };
 
+    // Changes to the ui plugin list made by an incremental plugin reload.
+    class Lv2PluginListDelta
+    {
+    public:
+        std::vector<Lv2PluginUiInfo> updated_; // added or modified plugins.
+        std::vector<std::string> removed_;     // uris of removed plugins.
+
+        bool empty() const { return updated_.empty() && removed_.empty(); }
+
+        DECLARE_JSON_MAP(Lv2PluginListDelta);
+    };
+
+    // One page of the results of a plugin search.
+    class PluginSearchResult
+    {
+    public:
+        uint64_t totalResults_ = 0;
+        uint32_t page_ = 0;
+        uint32_t pageSize_ = 0;
+        std::vector<Lv2PluginUiInfo> plugins_;
+
+        DECLARE_JSON_MAP(PluginSearchResult);
+    };
+
 }
 
 #if ENABLE_VST3
@@ -886,6 +958,7 @@ namespace pipedal
 
     private:
         bool vst3Enabled = true;
+        std::shared_ptr<HostWorkerThread> hostWorkerThread;
 
         LilvNode *get_comment(const std::string &uri);
 
@@ -895,12 +968,29 @@ namespace pipedal
         int numberOfAudioInputChannels = 1;
         int numberOfAudioOutputChannels = 1;
         double sampleRate = 48000;
+        std::mutex createPedalboardMutex;
+        std::shared_ptr<PluginCostDatabase> pluginCostDatabase;
+        std::mutex lilvWorldMutex;
+
+        // Plugin infos only hold a ModGui summary. Full ModGuis are built when they're first asked for.
+        static constexpr size_t MOD_GUI_CACHE_SIZE = 16;
+        std::mutex modGuiCacheMutex;
+        LRUCache<std::string, ModGui::ptr> modGuiCache{MOD_GUI_CACHE_SIZE};
+
+        bool parallelPluginInstantiation = true;
+        std::set<std::string> serialInstantiationPlugins;
+        std::set<std::string> sandboxedPlugins;
+        std::filesystem::path configDirectory; // for pipedal_sandbox.
 
         std::string vst3CachePath;
+        std::string lv2CachePath;
 
         std::vector<const LV2_Feature *> lv2Features;
         MapFeature mapFeature;
         FileMetadataFeature fileMetadataFeature;
+        // Shared by all plugin instances (including those in preloaded pedalboards).
+        SharedResourceFeature sharedResourceFeature;
+        FileStreamFeature fileStreamFeature;
         std::string pluginStoragePath;
 
         static void fn_LilvSetPortValueFunc(const char *port_symbol,
@@ -915,6 +1005,17 @@ namespace pipedal
         std::vector<std::shared_ptr<Lv2PluginInfo>> plugins_;
         std::map<std::string, std::shared_ptr<Lv2PluginInfo>> pluginsByUri;
         std::vector<Lv2PluginUiInfo> ui_plugins_;
+        std::unordered_map<std::string, size_t> uiPluginIndexByUri; // index into ui_plugins_.
+        PluginSearchIndex searchIndex;
+        // Every plugin lilv found (including unsupported ones), by normalized bundle path.
+        std::map<std::string, std::vector<std::shared_ptr<Lv2PluginInfo>>> pluginsByBundle;
+
+        // Rebuild plugins_, pluginsByUri and ui_plugins_ from pluginsByBundle.
+        void UpdatePluginLists();
+        PluginSearchIndex::Document MakeSearchDocument(const Lv2PluginUiInfo &uiPlugin) const;
+        void RebuildSearchIndex();
+        bool IsSupportedPlugin(const Lv2PluginInfo &plugin);
+        bool IsSupportedUiPlugin(const Lv2PluginUiInfo &info, const Lv2PluginInfo *plugin);
 
         std::map<std::string, std::shared_ptr<Lv2PluginClass>> classesMap;
 
@@ -952,14 +1053,18 @@ namespace pipedal
             return pWorld;
         }
 
+    public:
+        // IHost implementation. Public, so that the model can tell whether a new audio configuration
+        // is compatible with running plugin instances.
+        virtual size_t GetMaxAudioBufferSize() const { return maxBufferSize; }
+        virtual int GetNumberOfInputAudioChannels() const { return numberOfAudioInputChannels; }
+        virtual int GetNumberOfOutputAudioChannels() const { return numberOfAudioOutputChannels; }
+
     private:
         // IHost implementation.
         virtual void SetMaxAudioBufferSize(size_t size) { maxBufferSize = size; }
-        virtual size_t GetMaxAudioBufferSize() const { return maxBufferSize; }
         virtual size_t GetAtomBufferSize() const { return maxAtomBufferSize; }
         virtual bool HasMidiInputChannel() const { return hasMidiInputChannel; }
-        virtual int GetNumberOfInputAudioChannels() const { return numberOfAudioInputChannels; }
-        virtual int GetNumberOfOutputAudioChannels() const { return numberOfAudioOutputChannels; }
         virtual LV2_Feature *const *GetLv2Features() const { return (LV2_Feature *const *)&(this->lv2Features[0]); }
 
     public:
@@ -968,7 +1073,19 @@ namespace pipedal
 
         std::string MapResourcePath(const std::string &uri, const std::string &relativePath);
 
-        void ReloadPlugins();
+        /**
+         * @brief Reload LV2 bundles that have been added, removed or modified, without rebuilding the lilv world.
+         *
+         * @param bundlePaths Paths of the bundles that changed.
+         * @param inUsePluginUris Plugins that are currently instantiated. Their bundles can't be unloaded.
+         * @param delta Receives the changes to the ui plugin list.
+         * @returns false if the change can't be applied incrementally (a bundle that provides
+         * in-use plugins, or that doesn't provide plugins, changed). The caller must then do a full reload.
+         */
+        bool ReloadBundles(
+            const std::vector<std::string> &bundlePaths,
+            const std::set<std::string> &inUsePluginUris,
+            Lv2PluginListDelta *delta);
 
         // equivalent to LV2 MapPath AbstractPath features.
         std::string MapPath(const std::string &abstractPath);
@@ -993,7 +1110,7 @@ namespace pipedal
             uint32_t size,
             uint32_t type);
 
-        virtual IEffect *CreateEffect(PedalboardItem &pedalboardItem);
+        virtual IEffect *CreateEffect(PedalboardItem &pedalboardItem, const std::shared_ptr<RealtimeArena> &realtimeArena = nullptr);
         void LoadPluginClassesFromLilv();
         void AddJsonClassesToMap(std::shared_ptr<Lv2PluginClass> pluginClass);
 
@@ -1001,6 +1118,21 @@ namespace pipedal
         PluginHost();
         void SetPluginStoragePath(const std::filesystem::path &path);
         virtual std::string GetPluginStoragePath() const;
+        virtual std::shared_ptr<HostWorkerThread> GetHostWorkerThread() override;
+        virtual std::vector<FileStreamStatistics> GetFileStreamStatistics() override { return fileStreamFeature.GetStatistics(); }
+        virtual float GetEstimatedPluginLoad(const std::string &uri) const override;
+        virtual std::mutex &GetLilvWorldMutex() override { return lilvWorldMutex; }
+        virtual bool CanCreateEffectConcurrently(const std::string &uri) const override;
+
+        // See SharedResourceFeature::BeginRetainingResources().
+        void BeginRetainingSharedResources() { sharedResourceFeature.BeginRetainingResources(); }
+        void EndRetainingSharedResources() { sharedResourceFeature.EndRetainingResources(); }
+        // While retaining, keeps the files named by the pedalboard's path properties mapped, for plugins
+        // that load their own model and IR files.
+        void RetainPathPropertyFiles(Pedalboard &pedalboard);
+
+        // Used to balance pipelined pedalboards.
+        void SetPluginCostDatabase(const std::shared_ptr<PluginCostDatabase> &pluginCostDatabase) { this->pluginCostDatabase = pluginCostDatabase; }
 
         void SetConfiguration(const PiPedalConfiguration &configuration);
 
@@ -1008,7 +1140,10 @@ namespace pipedal
 
         IHost *asIHost() { return this; }
 
+        // CreateLv2Pedalboard and UpdateLv2PedalboardStructure may be called from the preload thread as well as the model thread.
         virtual Lv2Pedalboard *CreateLv2Pedalboard(Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList);
+        // A pedalboard with its own channel counts (for an additional pedalboard slot).
+        Lv2Pedalboard *CreateLv2Pedalboard(Pedalboard &pedalboard, Lv2PedalboardErrorList &errorList, int inputChannels, int outputChannels);
 
         virtual Lv2Pedalboard *UpdateLv2PedalboardStructure(Pedalboard &pedalboard, Lv2Pedalboard *existingPedalboard, Lv2PedalboardErrorList &errorList);
 
@@ -1027,6 +1162,14 @@ namespace pipedal
         ModGuiUris *mod_gui_uris = nullptr;
 
         void OnConfigurationChanged(const JackConfiguration &configuration, const JackChannelSelection &settings);
+        // Configure audio settings without an audio driver (pipedal_bench).
+        void SetAudioConfiguration(double sampleRate, size_t maxBufferSize, int inputChannels, int outputChannels)
+        {
+            this->sampleRate = sampleRate;
+            this->maxBufferSize = maxBufferSize;
+            this->numberOfAudioInputChannels = inputChannels;
+            this->numberOfAudioOutputChannels = outputChannels;
+        }
 
         std::shared_ptr<Lv2PluginClass> GetPluginClass(const std::string &uri) const;
         bool is_a(const std::string &class_, const std::string &target_class);
@@ -1036,7 +1179,12 @@ namespace pipedal
         const std::vector<std::shared_ptr<Lv2PluginInfo>> &GetPlugins() const { return plugins_; }
         const std::vector<Lv2PluginUiInfo> &GetUiPlugins() const { return ui_plugins_; }
 
+        PluginSearchResult SearchPlugins(const PluginSearchRequest &request) const;
+        void SetSearchFavorites(const std::map<std::string, bool> &favorites) { searchIndex.SetFavorites(favorites); }
+
         virtual std::shared_ptr<Lv2PluginInfo> GetPluginInfo(const std::string &uri) const;
+        // The full ModGui for a plugin (Lv2PluginInfo::modGui() is just a summary), or null if it has none.
+        ModGui::ptr GetModGui(const std::string &uri);
 
         static constexpr const char *DEFAULT_LV2_PATH = "/usr/lib/lv2";
 
@@ -0,0 +1,401 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "PluginSearchIndex.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+namespace
+{
+    // Field weights.
+    constexpr uint32_t NAME_WEIGHT = 4;
+    constexpr uint32_t TYPE_WEIGHT = 2; // plugin type and author.
+    constexpr uint32_t PORT_WEIGHT = 1;
+
+    // Match weights.
+    constexpr uint32_t EXACT_MATCH = 8;
+    constexpr uint32_t PREFIX_MATCH = 4;
+    constexpr uint32_t SUBSTRING_MATCH = 2;
+    constexpr uint32_t FUZZY_MATCH = 1;
+
+    constexpr size_t MIN_FUZZY_LENGTH = 4;
+
+    bool IsWordChar(char c)
+    {
+        // Bytes of multi-byte UTF-8 sequences are word characters.
+        return (c & 0x80) != 0 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+    }
+
+    char ToLower(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+        {
+            return (char)(c - 'A' + 'a');
+        }
+        return c;
+    }
+
+    std::string ToLower(const std::string &text)
+    {
+        std::string result = text;
+        for (char &c : result)
+        {
+            c = ToLower(c);
+        }
+        return result;
+    }
+
+    void AddTerms(const std::string &text, uint32_t fieldWeight, std::map<std::string, uint32_t> *terms)
+    {
+        for (const auto &word : PluginSearchIndex::Tokenize(text))
+        {
+            uint32_t &weight = (*terms)[word];
+            weight = std::max(weight, fieldWeight);
+        }
+    }
+}
+
+std::vector<std::string> PluginSearchIndex::Tokenize(const std::string &text)
+{
+    std::vector<std::string> result;
+    std::string word;
+    for (char c : text)
+    {
+        if (IsWordChar(c))
+        {
+            word.push_back(ToLower(c));
+        }
+        else if (!word.empty())
+        {
+            result.push_back(std::move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty())
+    {
+        result.push_back(std::move(word));
+    }
+    return result;
+}
+
+size_t PluginSearchIndex::EditDistance(const std::string &left, const std::string &right, size_t limit)
+{
+    size_t lengthDifference = left.length() > right.length() ? left.length() - right.length() : right.length() - left.length();
+    if (lengthDifference > limit)
+    {
+        return limit + 1;
+    }
+    // Optimal string alignment distance: transposed letters count as one edit.
+    std::vector<size_t> beforePrevious(right.length() + 1);
+    std::vector<size_t> previous(right.length() + 1);
+    std::vector<size_t> current(right.length() + 1);
+    for (size_t j = 0; j <= right.length(); ++j)
+    {
+        previous[j] = j;
+    }
+    for (size_t i = 1; i <= left.length(); ++i)
+    {
+        current[0] = i;
+        size_t rowMinimum = current[0];
+        for (size_t j = 1; j <= right.length(); ++j)
+        {
+            size_t substitution = previous[j - 1] + (left[i - 1] == right[j - 1] ? 0 : 1);
+            current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+            if (i > 1 && j > 1 && left[i - 1] == right[j - 2] && left[i - 2] == right[j - 1])
+            {
+                current[j] = std::min(current[j], beforePrevious[j - 2] + 1);
+            }
+            rowMinimum = std::min(rowMinimum, current[j]);
+        }
+        if (rowMinimum > limit)
+        {
+            return limit + 1;
+        }
+        std::swap(beforePrevious, previous);
+        std::swap(previous, current);
+    }
+    return std::min(previous[right.length()], limit + 1);
+}
+
+void PluginSearchIndex::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    terms.clear();
+    documents.clear();
+    freeDocIds.clear();
+    docIdsByUri.clear();
+}
+
+size_t PluginSearchIndex::Size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return docIdsByUri.size();
+}
+
+void PluginSearchIndex::Update(const Document &document)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    RemoveLocked(document.uri);
+
+    std::map<std::string, uint32_t> documentTerms;
+    AddTerms(document.name, NAME_WEIGHT, &documentTerms);
+    AddTerms(document.pluginDisplayType, TYPE_WEIGHT, &documentTerms);
+    AddTerms(document.authorName, TYPE_WEIGHT, &documentTerms);
+    if (document.isVst3)
+    {
+        AddTerms("vst3", TYPE_WEIGHT, &documentTerms);
+    }
+    for (const auto &portName : document.portNames)
+    {
+        AddTerms(portName, PORT_WEIGHT, &documentTerms);
+    }
+
+    DocId docId;
+    if (!freeDocIds.empty())
+    {
+        docId = freeDocIds.back();
+        freeDocIds.pop_back();
+    }
+    else
+    {
+        docId = (DocId)documents.size();
+        documents.emplace_back();
+    }
+    DocumentEntry &entry = documents[docId];
+    entry.valid = true;
+    entry.uri = document.uri;
+    entry.sortName = ToLower(document.name);
+    entry.pluginTypes = document.pluginTypes;
+    entry.hasModGui = document.hasModGui;
+    entry.terms.clear();
+    for (const auto &term : documentTerms)
+    {
+        terms[term.first][docId] = term.second;
+        entry.terms.push_back(term.first);
+    }
+    docIdsByUri[document.uri] = docId;
+}
+
+void PluginSearchIndex::Remove(const std::string &uri)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    RemoveLocked(uri);
+}
+
+void PluginSearchIndex::RemoveLocked(const std::string &uri)
+{
+    auto ff = docIdsByUri.find(uri);
+    if (ff == docIdsByUri.end())
+    {
+        return;
+    }
+    DocId docId = ff->second;
+    docIdsByUri.erase(ff);
+
+    DocumentEntry &entry = documents[docId];
+    for (const auto &term : entry.terms)
+    {
+        auto postings = terms.find(term);
+        if (postings != terms.end())
+        {
+            postings->second.erase(docId);
+            if (postings->second.empty())
+            {
+                terms.erase(postings);
+            }
+        }
+    }
+    entry = DocumentEntry();
+    freeDocIds.push_back(docId);
+}
+
+void PluginSearchIndex::SetFavorites(const std::map<std::string, bool> &favorites)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    this->favorites.clear();
+    for (const auto &favorite : favorites)
+    {
+        if (favorite.second)
+        {
+            this->favorites.insert(favorite.first);
+        }
+    }
+}
+
+void PluginSearchIndex::MatchWord(const std::string &queryWord, std::unordered_map<DocId, uint32_t> *scores) const
+{
+    auto addPostings = [scores](const Postings &postings, uint32_t matchWeight)
+    {
+        for (const auto &posting : postings)
+        {
+            uint32_t &score = (*scores)[posting.first];
+            score = std::max(score, matchWeight * posting.second);
+        }
+    };
+
+    // Exact and prefix matches are a range of the ordered term map.
+    for (auto i = terms.lower_bound(queryWord); i != terms.end() && i->first.starts_with(queryWord); ++i)
+    {
+        addPostings(i->second, i->first.length() == queryWord.length() ? EXACT_MATCH : PREFIX_MATCH);
+    }
+
+    // Substring and fuzzy matches require a scan of the vocabulary (a few thousand words).
+    bool fuzzy = queryWord.length() >= MIN_FUZZY_LENGTH;
+    size_t limit = queryWord.length() >= 8 ? 2 : 1;
+    for (const auto &term : terms)
+    {
+        const std::string &word = term.first;
+        if (word.starts_with(queryWord))
+        {
+            continue;
+        }
+        if (word.find(queryWord) != std::string::npos)
+        {
+            addPostings(term.second, SUBSTRING_MATCH);
+        }
+        else if (fuzzy)
+        {
+            // also match partially-typed words against the start of the indexed word.
+            if (EditDistance(queryWord, word, limit) <= limit ||
+                (word.length() > queryWord.length() && EditDistance(queryWord, word.substr(0, queryWord.length()), limit) <= limit))
+            {
+                addPostings(term.second, FUZZY_MATCH);
+            }
+        }
+    }
+}
+
+bool PluginSearchIndex::PassesFilters(DocId docId, const PluginSearchRequest &request) const
+{
+    const DocumentEntry &entry = documents[docId];
+    if (!entry.valid)
+    {
+        return false;
+    }
+    if (request.modGuiOnly_ && !entry.hasModGui)
+    {
+        return false;
+    }
+    if (request.favoritesOnly_ && !favorites.contains(entry.uri))
+    {
+        return false;
+    }
+    if (request.filterType_ != PluginType::Plugin && request.filterType_ != PluginType::None)
+    {
+        if (std::find(entry.pluginTypes.begin(), entry.pluginTypes.end(), request.filterType_) == entry.pluginTypes.end())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+PluginSearchIndex::Result PluginSearchIndex::Search(const PluginSearchRequest &request) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_map<DocId, uint32_t> scores;
+    std::vector<std::string> queryWords = Tokenize(request.query_);
+    if (queryWords.empty())
+    {
+        for (const auto &document : docIdsByUri)
+        {
+            scores[document.second] = 0;
+        }
+    }
+    else
+    {
+        MatchWord(queryWords[0], &scores);
+        for (size_t i = 1; i < queryWords.size() && !scores.empty(); ++i)
+        {
+            std::unordered_map<DocId, uint32_t> wordScores;
+            MatchWord(queryWords[i], &wordScores);
+            for (auto score = scores.begin(); score != scores.end();)
+            {
+                auto wordScore = wordScores.find(score->first);
+                if (wordScore == wordScores.end())
+                {
+                    score = scores.erase(score); // every query word must match.
+                }
+                else
+                {
+                    score->second += wordScore->second;
+                    ++score;
+                }
+            }
+        }
+    }
+
+    class Match
+    {
+    public:
+        const DocumentEntry *document;
+        bool favorite;
+        uint32_t score;
+    };
+    std::vector<Match> matches;
+    matches.reserve(scores.size());
+    for (const auto &score : scores)
+    {
+        if (PassesFilters(score.first, request))
+        {
+            const DocumentEntry *document = &documents[score.first];
+            matches.push_back(Match{document, favorites.contains(document->uri), score.second});
+        }
+    }
+    std::sort(
+        matches.begin(), matches.end(),
+        [](const Match &left, const Match &right)
+        {
+            if (left.favorite != right.favorite)
+            {
+                return left.favorite;
+            }
+            if (left.score != right.score)
+            {
+                return left.score > right.score;
+            }
+            if (left.document->sortName != right.document->sortName)
+            {
+                return left.document->sortName < right.document->sortName;
+            }
+            return left.document->uri < right.document->uri;
+        });
+
+    Result result;
+    result.totalResults = matches.size();
+    size_t pageSize = std::clamp<size_t>(request.pageSize_, 1, MAX_PAGE_SIZE);
+    size_t start = (size_t)request.page_ * pageSize;
+    for (size_t i = start; i < matches.size() && i < start + pageSize; ++i)
+    {
+        result.uris.push_back(matches[i].document->uri);
+    }
+    return result;
+}
+
+JSON_MAP_BEGIN(PluginSearchRequest)
+    JSON_MAP_REFERENCE(PluginSearchRequest, query)
+    json_map::enum_reference("filterType", &PluginSearchRequest::filterType_, get_plugin_type_enum_converter()),
+    JSON_MAP_REFERENCE(PluginSearchRequest, favoritesOnly)
+    JSON_MAP_REFERENCE(PluginSearchRequest, modGuiOnly)
+    JSON_MAP_REFERENCE(PluginSearchRequest, page)
+    JSON_MAP_REFERENCE(PluginSearchRequest, pageSize)
+JSON_MAP_END()
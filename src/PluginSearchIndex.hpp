@@ -0,0 +1,129 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include "PluginType.hpp"
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace pipedal
+{
+    class PluginSearchRequest
+    {
+    public:
+        std::string query_;
+        PluginType filterType_ = PluginType::Plugin; // Plugin matches any type.
+        bool favoritesOnly_ = false;
+        bool modGuiOnly_ = false;
+        uint32_t page_ = 0;
+        uint32_t pageSize_ = 50;
+
+        DECLARE_JSON_MAP(PluginSearchRequest);
+    };
+
+    /**
+     * @brief Inverted index over the plugin catalog, used to search and filter plugins without sending the whole catalog to clients.
+     *
+     * Query words match indexed words exactly, by prefix, by substring, or (for words of four or more characters)
+     * within a small edit distance, in decreasing order of score. Every query word must match. Matches in plugin
+     * names score higher than matches in types and authors, which score higher than matches in port names.
+     * Favorites are ranked ahead of other plugins.
+     *
+     * Documents can be added, replaced and removed individually, so that the index can follow incremental
+     * plugin reloads.
+     *
+     * Thread-safe.
+     */
+    class PluginSearchIndex
+    {
+    public:
+        static constexpr uint32_t MAX_PAGE_SIZE = 500;
+
+        class Document
+        {
+        public:
+            std::string uri;
+            std::string name;
+            std::string pluginDisplayType;
+            std::string authorName;
+            std::vector<PluginType> pluginTypes; // the plugin's type, and the types of its ancestor classes.
+            std::vector<std::string> portNames;  // port names and symbols.
+            bool isVst3 = false;
+            bool hasModGui = false;
+        };
+
+        class Result
+        {
+        public:
+            size_t totalResults = 0;
+            std::vector<std::string> uris; // the requested page.
+        };
+
+        void Clear();
+        // Adds a document, or replaces the document with the same uri.
+        void Update(const Document &document);
+        void Remove(const std::string &uri);
+        void SetFavorites(const std::map<std::string, bool> &favorites);
+
+        size_t Size() const;
+
+        Result Search(const PluginSearchRequest &request) const;
+
+        // Lower-cased words of text, split at ASCII punctuation and whitespace.
+        static std::vector<std::string> Tokenize(const std::string &text);
+        static size_t EditDistance(const std::string &left, const std::string &right, size_t limit);
+
+    private:
+        using DocId = uint32_t;
+
+        class DocumentEntry
+        {
+        public:
+            bool valid = false;
+            std::string uri;
+            std::string sortName; // lower-cased name.
+            std::vector<PluginType> pluginTypes;
+            bool hasModGui = false;
+            std::vector<std::string> terms;
+        };
+
+        // docId -> best field weight of the term in that document.
+        using Postings = std::unordered_map<DocId, uint32_t>;
+
+        void RemoveLocked(const std::string &uri);
+        // best score of queryWord against each document.
+        void MatchWord(const std::string &queryWord, std::unordered_map<DocId, uint32_t> *scores) const;
+        bool PassesFilters(DocId docId, const PluginSearchRequest &request) const;
+
+        mutable std::mutex mutex;
+        std::map<std::string, Postings> terms; // ordered, for prefix lookups.
+        std::vector<DocumentEntry> documents;
+        std::vector<DocId> freeDocIds;
+        std::unordered_map<std::string, DocId> docIdsByUri;
+        std::unordered_set<std::string> favorites;
+    };
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "PluginSearchIndex.hpp"
+
+using namespace pipedal;
+
+static PluginSearchIndex::Document MakeDocument(
+    const std::string &uri, const std::string &name, const std::string &author,
+    std::vector<PluginType> pluginTypes, std::vector<std::string> portNames = {})
+{
+    PluginSearchIndex::Document document;
+    document.uri = uri;
+    document.name = name;
+    document.authorName = author;
+    document.pluginDisplayType = plugin_type_to_string(pluginTypes[0]);
+    document.pluginTypes = std::move(pluginTypes);
+    document.portNames = std::move(portNames);
+    return document;
+}
+
+static std::vector<std::string> Search(const PluginSearchIndex &index, const std::string &query, PluginType filterType = PluginType::Plugin)
+{
+    PluginSearchRequest request;
+    request.query_ = query;
+    request.filterType_ = filterType;
+    return index.Search(request).uris;
+}
+
+TEST_CASE("PluginSearchIndex", "[plugin_search_index][Build][Dev]")
+{
+    REQUIRE(PluginSearchIndex::Tokenize("TooB Reverb-2 (mono)") == std::vector<std::string>{"toob", "reverb", "2", "mono"});
+    REQUIRE(PluginSearchIndex::EditDistance("reverb", "revreb", 2) == 1);
+    REQUIRE(PluginSearchIndex::EditDistance("reverb", "reverb", 2) == 0);
+    REQUIRE(PluginSearchIndex::EditDistance("chorus", "delay", 1) == 2); // limit + 1
+    REQUIRE(PluginSearchIndex::EditDistance("delay", "dleay", 1) == 1);
+
+    PluginSearchIndex index;
+    index.Update(MakeDocument("urn:reverb", "TooB Reverb", "Robin Davies", {PluginType::ReverbPlugin, PluginType::SimulatorPlugin, PluginType::Plugin}, {"Mix", "decay"}));
+    index.Update(MakeDocument("urn:delay", "TooB Delay", "Robin Davies", {PluginType::DelayPlugin, PluginType::Plugin}, {"Time", "Feedback"}));
+    index.Update(MakeDocument("urn:chorus", "Chorus", "Someone Else", {PluginType::ChorusPlugin, PluginType::ModulatorPlugin, PluginType::Plugin}, {"Rate", "Depth"}));
+    REQUIRE(index.Size() == 3);
+
+    // exact, prefix, substring and fuzzy matches.
+    REQUIRE(Search(index, "chorus") == std::vector<std::string>{"urn:chorus"});
+    REQUIRE(Search(index, "cho") == std::vector<std::string>{"urn:chorus"});
+    REQUIRE(Search(index, "verb") == std::vector<std::string>{"urn:reverb"});
+    REQUIRE(Search(index, "revreb") == std::vector<std::string>{"urn:reverb"});
+    REQUIRE(Search(index, "dleay").size() == 1);
+
+    // every query word must match; name matches rank above port matches.
+    REQUIRE(Search(index, "toob rev") == std::vector<std::string>{"urn:reverb"});
+    REQUIRE(Search(index, "chorus delay").empty());
+    REQUIRE(Search(index, "de") == std::vector<std::string>{"urn:delay", "urn:chorus", "urn:reverb"});
+
+    // type filters include subtypes.
+    REQUIRE(Search(index, "", PluginType::SimulatorPlugin) == std::vector<std::string>{"urn:reverb"});
+    REQUIRE(Search(index, "").size() == 3);
+
+    // favorites first.
+    index.SetFavorites({{"urn:reverb", true}, {"urn:delay", false}});
+    REQUIRE(Search(index, "toob") == std::vector<std::string>{"urn:reverb", "urn:delay"});
+    PluginSearchRequest favoritesRequest;
+    favoritesRequest.favoritesOnly_ = true;
+    REQUIRE(index.Search(favoritesRequest).uris == std::vector<std::string>{"urn:reverb"});
+
+    // paging.
+    PluginSearchRequest pageRequest;
+    pageRequest.pageSize_ = 2;
+    pageRequest.page_ = 1;
+    auto page = index.Search(pageRequest);
+    REQUIRE(page.totalResults == 3);
+    REQUIRE(page.uris.size() == 1);
+
+    // incremental updates.
+    index.Update(MakeDocument("urn:delay", "TooB Echo", "Robin Davies", {PluginType::DelayPlugin, PluginType::Plugin}));
+    REQUIRE(Search(index, "delay") == std::vector<std::string>{"urn:reverb", "urn:delay"}); // a favorite (fuzzy), then by type.
+    REQUIRE(Search(index, "echo") == std::vector<std::string>{"urn:delay"});
+    REQUIRE(Search(index, "feedback").empty());
+    index.Remove("urn:chorus");
+    REQUIRE(index.Size() == 2);
+    REQUIRE(Search(index, "chorus").empty());
+    index.Update(MakeDocument("urn:phaser", "Phaser", "Someone Else", {PluginType::PhaserPlugin, PluginType::ModulatorPlugin, PluginType::Plugin}));
+    REQUIRE(Search(index, "phaser") == std::vector<std::string>{"urn:phaser"});
+    REQUIRE(Search(index, "someone") == std::vector<std::string>{"urn:phaser"});
+}
@@ -26,10 +26,18 @@
 #include <sstream>
 #include "lv2/atom/atom.h"
 #include "ZipFile.hpp"
+#include "MediaBlobIndex.hpp"
 #include <set>
+#include <zlib.h>
 
 using namespace pipedal;
 
+JSON_MAP_BEGIN(PresetBundleProgress)
+    JSON_MAP_REFERENCE(PresetBundleProgress, operation)
+    JSON_MAP_REFERENCE(PresetBundleProgress, bytesProcessed)
+    JSON_MAP_REFERENCE(PresetBundleProgress, bytesTotal)
+JSON_MAP_END()
+
 static std::string ToString(const std::vector<uint8_t> &value)
 {
     const char *start = (const char *)(&value[0]);
@@ -106,6 +114,7 @@ public:
     {
         pluginUploadDirectory = model.GetPluginUploadDirectory();
         pluginUploadDirectoryString = pluginUploadDirectory.string();
+        mediaBlobIndex = &model.GetStorage().GetMediaBlobIndex();
 
         BankFile bankFile;
 
@@ -121,6 +130,7 @@ public:
     {
         pluginUploadDirectory = model.GetPluginUploadDirectory();
         pluginUploadDirectoryString = pluginUploadDirectory.string();
+        mediaBlobIndex = &model.GetStorage().GetMediaBlobIndex();
 
         PluginPresets pluginPresets;
 
@@ -134,6 +144,7 @@ public:
     }
     virtual ~PresetBundleWriterImpl() noexcept;
 
+    virtual void SetProgressCallback(PresetBundleProgressCallback &&onProgress) override { this->onProgress = std::move(onProgress); }
     virtual void WriteToFile(const std::filesystem::path &filePath) override;
 
 private:
@@ -153,12 +164,19 @@ private:
 
     std::filesystem::path pluginUploadDirectory;
     std::string pluginUploadDirectoryString;
+    MediaBlobIndex *mediaBlobIndex = nullptr;
+    PresetBundleProgressCallback onProgress;
 };
 
 void PresetBundleWriterImpl::WriteToFile(const std::filesystem::path &filePath)
 {
 
+    // Media files are stored or deflated (on a pool of threads) when the zip file is closed.
     ZipFileWriter::ptr zipFile = ZipFileWriter::Create(filePath);
+    if (onProgress)
+    {
+        zipFile->SetProgressCallback(ZipFileWriter::ProgressCallback(onProgress));
+    }
 
     for (const auto &configFile : configFiles)
     {
@@ -174,6 +192,10 @@ void PresetBundleWriterImpl::WriteToFile(const std::filesystem::path &filePath)
         zipFile->WriteFile("pluginsUsed.json", metadata.data(), metadata.length());
     }
 
+    // Media files are listed in mediaBlobs.json by content hash. Files with the same content are only stored
+    // once, under the first of their names.
+    std::map<std::string, std::string> mediaHashes;
+    std::set<std::string> storedHashes;
     for (const auto &mediaPath : mediaPaths)
     {
         std::string zipName = (std::filesystem::path("media") / std::filesystem::path(mediaPath)).string();
@@ -182,7 +204,23 @@ void PresetBundleWriterImpl::WriteToFile(const std::filesystem::path &filePath)
         {
             if (IsValidMediaPath(sourcePath)) // paranoid guard against exfiltration of non-media files.
             {
-                zipFile->WriteFile(zipName, sourcePath);
+                std::string hash;
+                try
+                {
+                    hash = mediaBlobIndex->GetHash(sourcePath);
+                }
+                catch (const std::exception &e)
+                {
+                    Lv2Log::warning(SS("Can't hash media file " << sourcePath << ". " << e.what()));
+                }
+                if (!hash.empty())
+                {
+                    mediaHashes[mediaPath] = hash;
+                }
+                if (hash.empty() || storedHashes.insert(hash).second)
+                {
+                    zipFile->WriteFile(zipName, sourcePath);
+                }
             }
             else
             {
@@ -199,81 +237,80 @@ void PresetBundleWriterImpl::WriteToFile(const std::filesystem::path &filePath)
             zipFile->WriteFile(SS(zipName << ".mdata"), metadataPath);
         }
     }
+    {
+        std::ostringstream ss;
+        json_writer writer(ss);
+        writer.write(mediaHashes);
+        std::string mediaBlobs = ss.str();
+        zipFile->WriteFile("mediaBlobs.json", mediaBlobs.data(), mediaBlobs.length());
+    }
     zipFile->Close();
 }
 
-void PresetBundleWriterImpl::GatherMediaPaths(PiPedalModel &model, BankFile &bankFile)
+static void AddStatePaths(const Lv2PluginState &state, std::set<std::string> *mediaPaths)
 {
-    for (auto &preset : bankFile.presets())
+    for (const auto &value : state.values_)
     {
-        Pedalboard &pedalboard = preset->preset();
-        auto items = pedalboard.GetAllPlugins();
-        for (auto plugin : items)
+        if (value.second.atomType_ == LV2_ATOM__Path)
         {
-            AddUsedPlugin(model, plugin->uri(), plugin->pluginName());
-            const Lv2PluginState &state = plugin->lv2State();
-            for (const auto &value : state.values_)
-            {
-                if (value.second.atomType_ == LV2_ATOM__Path)
-                {
-                    std::string path = ToString(value.second.value_);
-                    if (!mediaPaths.contains(path))
-                    {
-                        mediaPaths.insert(std::move(path));
-                    }
-                }
-            }
-            for (const auto &property : plugin->pathProperties_)
+            mediaPaths->insert(ToString(value.second.value_));
+        }
+    }
+}
+
+static void AddPathProperties(const std::map<std::string, std::string> &pathProperties, const std::string &uploadDirectory, std::set<std::string> *mediaPaths)
+{
+    for (const auto &property : pathProperties)
+    {
+        std::string path;
+        if (TryGetAtomPath(property.second, &path))
+        {
+            if (path.starts_with(uploadDirectory))
             {
-                std::string path;
-                if (TryGetAtomPath(property.second, &path))
-                {
-                    path = UnmapPath(path);
-                    if (!mediaPaths.contains(path))
-                    {
-                        mediaPaths.insert(std::move(path));
-                    }
-                }
+                path = path.substr(uploadDirectory.length() + 1);
             }
-            for (const auto &snapshot : pedalboard.snapshots())
+            mediaPaths->insert(std::move(path));
+        }
+    }
+}
+
+void PresetBundleWriter::GetMediaPaths(const Pedalboard &constPedalboard, const std::filesystem::path &uploadDirectory, std::set<std::string> *mediaPaths)
+{
+    std::string uploadDirectoryString = uploadDirectory.string();
+    Pedalboard &pedalboard = const_cast<Pedalboard &>(constPedalboard); // GetAllPlugins() isn't const.
+    for (auto plugin : pedalboard.GetAllPlugins())
+    {
+        AddStatePaths(plugin->lv2State(), mediaPaths);
+        AddPathProperties(plugin->pathProperties_, uploadDirectoryString, mediaPaths);
+    }
+    for (const auto &snapshot : pedalboard.snapshots())
+    {
+        if (snapshot)
+        {
+            for (const auto &value : snapshot->values_)
             {
-                if (snapshot)
+                if (value.isEnabled_)
                 {
-                    for (const auto &value : snapshot->values_)
-                    {
-                        if (value.isEnabled_)
-                        {
-                            const Lv2PluginState &state = value.lv2State_;
-                            for (const auto &v : state.values_)
-                            {
-                                if (v.second.atomType_ == LV2_ATOM__Path)
-                                {
-                                    std::string path = ToString(v.second.value_);
-                                    if (!mediaPaths.contains(path))
-                                    {
-                                        mediaPaths.insert(std::move(path));
-                                    }
-                                }
-                            }
-                            for (const auto &property : value.pathProperties_)
-                            {
-                                std::string path;
-                                if (TryGetAtomPath(property.second, &path))
-                                {
-                                    path = UnmapPath(path);
-                                    if (!mediaPaths.contains(path))
-                                    {
-                                        mediaPaths.insert(std::move(path));
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    AddStatePaths(value.lv2State_, mediaPaths);
+                    AddPathProperties(value.pathProperties_, uploadDirectoryString, mediaPaths);
                 }
             }
         }
     }
 }
+
+void PresetBundleWriterImpl::GatherMediaPaths(PiPedalModel &model, BankFile &bankFile)
+{
+    for (auto &preset : bankFile.presets())
+    {
+        Pedalboard &pedalboard = preset->mutablePreset();
+        for (auto plugin : pedalboard.GetAllPlugins())
+        {
+            AddUsedPlugin(model, plugin->uri(), plugin->pluginName());
+        }
+        GetMediaPaths(pedalboard, pluginUploadDirectory, &mediaPaths);
+    }
+}
 void PresetBundleWriterImpl::GatherMediaPaths(PiPedalModel &model, PluginPresets &pluginPresets)
 {
     AddUsedPlugin(model, pluginPresets.pluginUri_, "");
@@ -319,27 +356,38 @@ public:
     void LoadPresetsFile(PiPedalModel &model, const std::filesystem::path &path)
     {
         this->pluginUploadDirectory = model.GetPluginUploadDirectory();
+        this->mediaBlobIndex = &model.GetStorage().GetMediaBlobIndex();
         zipFile = ZipFileReader::Create(path);
         auto s = zipFile->GetFileInputStream("bankFile.json");
         json_reader reader(s);
         reader.read(&bankFile);
+        LoadMediaHashes();
     }
     void LoadPluginPresetFile(PiPedalModel &model, const std::filesystem::path &path)
     {
         this->pluginUploadDirectory = model.GetPluginUploadDirectory();
+        this->mediaBlobIndex = &model.GetStorage().GetMediaBlobIndex();
         zipFile = ZipFileReader::Create(path);
         auto s = zipFile->GetFileInputStream("pluginPresets.json");
         json_reader reader(s);
         reader.read(&pluginPresets);
+        LoadMediaHashes();
     }
     virtual ~PresetBundleReaderImpl() noexcept;
 
+    virtual void SetProgressCallback(PresetBundleProgressCallback &&onProgress) override { this->onProgress = std::move(onProgress); }
     virtual void ExtractMediaFiles() override;
     virtual std::string GetPresetJson() override;
     virtual std::string GetPluginPresetsJson() override;
 
 private:
+    void LoadMediaHashes();
     void ExtractMediaFile(const std::string &zipFileName);
+    void ExtractPendingFiles();
+    void LinkMediaFile(const std::string &mediaPath, const std::string &hash);
+    bool FindUploadedCopy(const std::string &zipFileName, std::filesystem::path *pResult);
+    void AddUploadedFile(const std::filesystem::path &path);
+    void ReportProgress(uint64_t bytesProcessed);
     bool IsSameFile(const std::string &zipFileName, const std::filesystem::path &filePath)
     {
         if (!zipFile->CompareFiles(zipFileName, filePath))
@@ -376,11 +424,29 @@ private:
     void RenameSnapshot(Snapshot *snapshot, const std::string oldName, const std::string &newName);
 
     std::filesystem::path pluginUploadDirectory;
+    MediaBlobIndex *mediaBlobIndex = nullptr;
     // BankFile bankFile;
     ZipFileReader::ptr zipFile;
 
+    // Content hashes of media files, by path (from mediaBlobs.json; empty for older bundles).
+    std::map<std::string, std::string> mediaHashes;
+
     BankFile bankFile;
     PluginPresets pluginPresets;
+
+    PresetBundleProgressCallback onProgress;
+    uint64_t bytesExtracted = 0;
+    uint64_t bytesTotal = 0;
+
+    // Files in the upload directory by size, for finding media files that were uploaded
+    // previously under a different name. Built on first use.
+    bool uploadedFilesScanned = false;
+    std::multimap<uint64_t, std::filesystem::path> uploadedFiles;
+    std::map<std::filesystem::path, uint32_t> uploadedFileCrcs;
+
+    // Media files to be extracted together (in parallel) once all target names have been chosen.
+    std::vector<ZipFileReader::ExtractRequest> pendingExtracts;
+    std::set<std::filesystem::path> pendingTargets;
 };
 void PresetBundleReaderImpl::RenameState(Lv2PluginState &state, const std::string oldName, const std::string &newName)
 {
@@ -505,7 +571,7 @@ void PresetBundleReaderImpl::RenameMediaFileProperty(const std::string oldName,
     // there should be a set for saved media files.
     for (auto &preset : bankFile.presets())
     {
-        Pedalboard &pedalboard = preset->preset();
+        Pedalboard &pedalboard = preset->mutablePreset();
         RenamePedalboard(pedalboard, oldName, newName);
     }
     for (auto &preset : pluginPresets.presets_)
@@ -527,9 +593,27 @@ PresetBundleReader::ptr PresetBundleReader::LoadPluginPresetsFile(PiPedalModel &
     return result;
 }
 
+void PresetBundleReaderImpl::ReportProgress(uint64_t bytesProcessed)
+{
+    if (onProgress)
+    {
+        onProgress(std::min(bytesProcessed, bytesTotal), bytesTotal);
+    }
+}
+
 void PresetBundleReaderImpl::ExtractMediaFiles()
 {
     auto zipFiles = zipFile->GetFiles();
+    bytesTotal = 0;
+    bytesExtracted = 0;
+    for (const auto &zipFileName : zipFiles)
+    {
+        if (zipFileName.starts_with("media/") && !zipFileName.ends_with('/'))
+        {
+            bytesTotal += zipFile->GetFileSize(zipFileName);
+        }
+    }
+    ReportProgress(0);
     for (const auto &zipFile : zipFiles)
     {
         if (zipFile != "bankFile.json")
@@ -540,6 +624,147 @@ void PresetBundleReaderImpl::ExtractMediaFiles()
             }
         }
     }
+    ExtractPendingFiles();
+    // media files that are only stored once, under the name of another file with the same content.
+    for (const auto &mediaHash : mediaHashes)
+    {
+        if (!zipFile->FileExists(SS("media/" << mediaHash.first)))
+        {
+            LinkMediaFile(mediaHash.first, mediaHash.second);
+        }
+    }
+    ReportProgress(bytesTotal);
+}
+
+void PresetBundleReaderImpl::LoadMediaHashes()
+{
+    if (zipFile->FileExists("mediaBlobs.json"))
+    {
+        auto s = zipFile->GetFileInputStream("mediaBlobs.json");
+        json_reader reader(s);
+        reader.read(&mediaHashes);
+    }
+}
+
+void PresetBundleReaderImpl::LinkMediaFile(const std::string &mediaPath, const std::string &hash)
+{
+    namespace fs = std::filesystem;
+    fs::path targetFileName = (this->pluginUploadDirectory / fs::path(mediaPath)).lexically_normal();
+    if (targetFileName.lexically_relative(this->pluginUploadDirectory).string().starts_with(".."))
+    {
+        Lv2Log::warning(SS("Invalid media path in preset bundle: " << mediaPath));
+        return;
+    }
+    if (fs::exists(targetFileName))
+    {
+        if (mediaBlobIndex->GetHash(targetFileName) == hash)
+        {
+            return; // already uploaded.
+        }
+    }
+    else if (mediaBlobIndex->LinkTo(hash, targetFileName))
+    {
+        std::string metadataName = SS("media/" << mediaPath << ".mdata");
+        if (zipFile->FileExists(metadataName))
+        {
+            zipFile->ExtractTo(metadataName, SS(targetFileName.string() << ".mdata"));
+        }
+        return;
+    }
+    // can't link it under its own name, so refer to the existing copy instead.
+    fs::path existingFile = mediaBlobIndex->FindFile(hash);
+    if (existingFile.empty())
+    {
+        Lv2Log::warning(SS("Media file not found in preset bundle: " << mediaPath));
+        return;
+    }
+    RenameMediaFileProperty(mediaPath, existingFile.lexically_relative(this->pluginUploadDirectory).string());
+}
+
+static uint32_t GetFileCrc(const std::filesystem::path &path)
+{
+    std::ifstream f(path, std::ios_base::binary);
+    if (!f.is_open())
+    {
+        throw std::runtime_error(SS("Can't read " << path));
+    }
+    constexpr size_t BUFFER_SIZE = 256 * 1024;
+    std::vector<char> buffer(BUFFER_SIZE);
+    uLong crc = crc32(0L, Z_NULL, 0);
+    while (f)
+    {
+        f.read(buffer.data(), (std::streamsize)BUFFER_SIZE);
+        std::streamsize nRead = f.gcount();
+        if (nRead <= 0)
+        {
+            break;
+        }
+        crc = crc32(crc, (const Bytef *)buffer.data(), (uInt)nRead);
+    }
+    return (uint32_t)crc;
+}
+
+void PresetBundleReaderImpl::AddUploadedFile(const std::filesystem::path &path)
+{
+    if (uploadedFilesScanned)
+    {
+        std::error_code ec;
+        uint64_t size = std::filesystem::file_size(path, ec);
+        if (!ec)
+        {
+            uploadedFiles.emplace(size, path);
+        }
+    }
+}
+
+bool PresetBundleReaderImpl::FindUploadedCopy(const std::string &zipFileName, std::filesystem::path *pResult)
+{
+    namespace fs = std::filesystem;
+    if (!uploadedFilesScanned)
+    {
+        uploadedFilesScanned = true;
+        std::error_code ec;
+        for (auto i = fs::recursive_directory_iterator(pluginUploadDirectory, fs::directory_options::skip_permission_denied, ec);
+             i != fs::recursive_directory_iterator();
+             i.increment(ec))
+        {
+            if (ec)
+            {
+                break;
+            }
+            if (i->is_regular_file(ec) && i->path().extension() != ".mdata")
+            {
+                uint64_t size = i->file_size(ec);
+                if (!ec)
+                {
+                    uploadedFiles.emplace(size, i->path());
+                }
+            }
+        }
+    }
+    uint64_t size = zipFile->GetFileSize(zipFileName);
+    auto range = uploadedFiles.equal_range(size);
+    if (range.first == range.second)
+    {
+        return false;
+    }
+    // the zip directory has the crc of each file, so only files with the same size and crc need to be compared.
+    uint32_t crc = zipFile->GetFileCrc(zipFileName);
+    for (auto i = range.first; i != range.second; ++i)
+    {
+        const fs::path &candidate = i->second;
+        auto crcEntry = uploadedFileCrcs.find(candidate);
+        if (crcEntry == uploadedFileCrcs.end())
+        {
+            crcEntry = uploadedFileCrcs.emplace(candidate, GetFileCrc(candidate)).first;
+        }
+        if (crcEntry->second == crc && zipFile->CompareFiles(zipFileName, candidate))
+        {
+            *pResult = candidate;
+            return true;
+        }
+    }
+    return false;
 }
 
 static void ExtractFileVersion(std::string &baseName, int &n)
@@ -596,39 +821,76 @@ void PresetBundleReaderImpl::ExtractMediaFile(const std::string &zipFileName)
         }
         std::string baseName = zipFileName.substr(6);
         fs::path targetFileName = this->pluginUploadDirectory / std::filesystem::path(baseName);
+        uint64_t fileSize = zipFile->GetFileSize(zipFileName);
         bool renamed = false;
-        while (true)
+        if (fs::exists(targetFileName) && IsSameFile(zipFileName, targetFileName))
+        {
+            // already uploaded.
+        }
+        else
         {
-            if (fs::exists(targetFileName))
+            fs::path uploadedCopy;
+            auto mediaHash = mediaHashes.find(baseName);
+            if (mediaHash != mediaHashes.end())
             {
-                if (IsSameFile(zipFileName, targetFileName))
-                {
-                    break;
-                }
-                else
+                uploadedCopy = mediaBlobIndex->FindFile(mediaHash->second);
+            }
+            if (!uploadedCopy.empty() || FindUploadedCopy(zipFileName, &uploadedCopy))
+            {
+                // the same content was uploaded under another name. Use that instead of making another copy.
+                targetFileName = uploadedCopy;
+                renamed = targetFileName != this->pluginUploadDirectory / std::filesystem::path(baseName);
+            }
+            else
+            {
+                while (fs::exists(targetFileName) || pendingTargets.contains(targetFileName))
                 {
                     renamed = true;
                     targetFileName = NextFileName(targetFileName);
                 }
-            }
-            else
-            {
-                zipFile->ExtractTo(zipFileName, targetFileName);
+                pendingTargets.insert(targetFileName);
+                pendingExtracts.push_back({zipFileName, targetFileName});
                 if (zipFile->FileExists(SS(zipFileName << ".mdata")))
                 {
-                    zipFile->ExtractTo(SS(zipFileName << ".mdata"), SS(targetFileName.string() << ".mdata"));
+                    pendingExtracts.push_back({SS(zipFileName << ".mdata"), SS(targetFileName.string() << ".mdata")});
                 }
-                break;
+                fileSize = 0; // counted by ExtractPendingFiles().
             }
         }
+        bytesExtracted += fileSize;
+        ReportProgress(bytesExtracted);
         if (renamed)
         {
-            std::string newName = fs::path(baseName).parent_path() / targetFileName.filename();
+            std::string newName = targetFileName.lexically_relative(this->pluginUploadDirectory).string();
             RenameMediaFileProperty(baseName, newName);
         }
     }
 }
 
+void PresetBundleReaderImpl::ExtractPendingFiles()
+{
+    uint64_t bytesBefore = bytesExtracted;
+    zipFile->ExtractFiles(
+        pendingExtracts,
+        [this, bytesBefore](uint64_t bytesWritten)
+        {
+            ReportProgress(bytesBefore + bytesWritten);
+        });
+    for (const auto &extracted : pendingExtracts)
+    {
+        if (extracted.path.extension() != ".mdata")
+        {
+            bytesExtracted += zipFile->GetFileSize(extracted.zipName);
+            AddUploadedFile(extracted.path);
+            // index it, so that other files in the bundle with the same content can be linked to it.
+            mediaBlobIndex->GetHash(extracted.path);
+        }
+    }
+    pendingExtracts.clear();
+    pendingTargets.clear();
+    ReportProgress(bytesExtracted);
+}
+
 std::string PresetBundleReaderImpl::GetPresetJson()
 {
     std::ostringstream ss;
@@ -667,8 +929,8 @@ public:
         metadata_["uri"] = pluginInfo->uri();
         metadata_["name"] = pluginInfo->name();
         metadata_["brand"] = pluginInfo->brand();
-        metadata_["authorName"] = pluginInfo->author_name();
-        metadata_["authorHomePage"] = pluginInfo->author_homepage();
+        metadata_["authorName"] = pluginInfo->author_name().str();
+        metadata_["authorHomePage"] = pluginInfo->author_homepage().str();
     }
     PluginMetadata(const std::string &uri, const std::string &name)
     {
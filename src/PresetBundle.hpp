@@ -21,9 +21,27 @@
 
 #include <string>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <set>
+#include "json.hpp"
 
 namespace pipedal {
     class PiPedalModel;
+    class Pedalboard;
+
+    // Progress of a preset bundle export or import, as sent to clients.
+    class PresetBundleProgress {
+    public:
+        std::string operation_; // "export", "import" or "sync"
+        uint64_t bytesProcessed_ = 0;
+        uint64_t bytesTotal_ = 0;
+
+        DECLARE_JSON_MAP(PresetBundleProgress);
+    };
+
+    // Called with the number of bytes of media files processed so far, and the total.
+    using PresetBundleProgressCallback = std::function<void(uint64_t bytesProcessed, uint64_t bytesTotal)>;
 
     class PresetBundleWriter {
     public:
@@ -32,11 +50,15 @@ namespace pipedal {
 
         virtual ~PresetBundleWriter() noexcept = 0;
 
+        virtual void SetProgressCallback(PresetBundleProgressCallback &&onProgress) = 0;
         virtual void WriteToFile(const std::filesystem::path&filePath) = 0;
 
 
         static ptr CreatePresetsFile(PiPedalModel&model,const std::string&presetJson);
         static ptr CreatePluginPresetsFile(PiPedalModel&model,const std::string&presetJson);
+
+        // Add the media files used by a preset (and its snapshots) to mediaPaths, relative to the upload directory.
+        static void GetMediaPaths(const Pedalboard &pedalboard, const std::filesystem::path &uploadDirectory, std::set<std::string> *mediaPaths);
     };
 
     class PresetBundleReader {
@@ -46,6 +68,9 @@ namespace pipedal {
 
         virtual ~PresetBundleReader() noexcept = 0;
 
+        virtual void SetProgressCallback(PresetBundleProgressCallback &&onProgress) = 0;
+        // Media files whose content is already in the upload directory are not extracted again;
+        // presets are changed to refer to the existing copy instead.
         virtual void ExtractMediaFiles() = 0;
         virtual std::string GetPresetJson() = 0;
         virtual std::string GetPluginPresetsJson() = 0;
@@ -23,11 +23,19 @@
 #include <mutex>
 #include <stdexcept>
 #include <condition_variable>
+#include <memory>
+#include <string>
+#include <vector>
+#include "IExecutor.hpp"
 
 namespace pipedal
 {
 
     // thread-safe javascript-like future.
+    //
+    // By default, Then and Catch handlers run on whichever thread resolves (or rejects) the promise,
+    // or on the thread that attaches the handler if the promise has already settled. Use On(executor)
+    // to run them on an executor (e.g. ThreadPool::Shared()) instead.
 
     template <typename T>
     class Promise;
@@ -181,7 +189,7 @@ namespace pipedal
                 std::unique_lock lock{mutex};
                 if (this->resolved || this->cancelled)
                     break;
-                if (conditionVariable != nullptr)
+                if (conditionVariable == nullptr)
                 {
                     conditionVariable = new std::condition_variable();
                 }
@@ -220,10 +228,7 @@ namespace pipedal
             }
             if (fireResult)
             {
-                thenFunction(resolvedValue);
-                ReleaseFunctions();
-                thenFunction = nullptr;
-                catchFunction = nullptr;
+                FireThen();
             }
             if (conditionVariable)
             {
@@ -259,8 +264,7 @@ namespace pipedal
             }
             if (fireCatch)
             {
-                catchFunction(this->catchMessage);
-                ReleaseFunctions();
+                FireCatch();
             }
             if (conditionVariable)
             {
@@ -315,8 +319,7 @@ namespace pipedal
             }
             if (fireThen)
             {
-                thenFunction(resolvedValue);
-                ReleaseFunctions();
+                FireThen();
             }
         }
         void Then(const ThenFunction &handler)
@@ -345,11 +348,7 @@ namespace pipedal
             }
             if (fireCatch)
             {
-                catchFunction(this->catchMessage);
-                
-                ReleaseFunctions();
-
-
+                FireCatch();
             }
         }
         bool IsReady() const
@@ -358,7 +357,58 @@ namespace pipedal
             return this->resolved;
         }
 
+        void SetExecutor(IExecutor *executor)
+        {
+            std::lock_guard lock{mutex};
+            this->executor = executor;
+        }
+
     private:
+        void FireThen()
+        {
+            if (RunOnExecutor([this]()
+                              { thenFunction(resolvedValue); ReleaseFunctions(); }))
+            {
+                return;
+            }
+            thenFunction(resolvedValue);
+            ReleaseFunctions();
+        }
+        void FireCatch()
+        {
+            if (RunOnExecutor([this]()
+                              { catchFunction(this->catchMessage); ReleaseFunctions(); }))
+            {
+                return;
+            }
+            catchFunction(this->catchMessage);
+            ReleaseFunctions();
+        }
+        // false if there's no executor, or it didn't accept the work.
+        bool RunOnExecutor(std::function<void()> &&fn)
+        {
+            IExecutor *executor;
+            {
+                std::lock_guard lock{mutex};
+                executor = this->executor;
+                if (!executor)
+                {
+                    return false;
+                }
+                ++referenceCount; // keep us alive while the work is queued.
+            }
+            bool posted = executor->Execute(
+                [this, fn = std::move(fn)]()
+                {
+                    fn();
+                    ReleaseRef();
+                });
+            if (!posted)
+            {
+                ReleaseRef(); // never the last reference: the caller holds one.
+            }
+            return posted;
+        }
         void ReleaseFunctions()
         {
             // Most importantly, release capture variables that reference a promise.
@@ -369,6 +419,7 @@ namespace pipedal
         }
 
     private:
+        IExecutor *executor = nullptr;
         bool hasWorker = false;
         bool cancelled = false;
         bool resolved = false;
@@ -445,6 +496,163 @@ namespace pipedal
             return t;
         }
 
+        template <typename U>
+        Promise<U> Then(IExecutor &executor, std::function<void(const T &value, pipedal::ResolveFunction<U> result, RejectFunction reject)> thenFn)
+        {
+            return On(executor).template Then<U>(std::move(thenFn));
+        }
+
+        // Run Then and Catch handlers of this promise on the executor. Call before attaching handlers.
+        Promise<T> On(IExecutor &executor)
+        {
+            p->SetExecutor(&executor);
+            return Promise<T>(*this);
+        }
+
+        // Resolve with the result of fn, called on the executor. Exceptions thrown by fn reject the promise.
+        static Promise<T> Run(IExecutor &executor, std::function<T()> fn)
+        {
+            Promise<T> result;
+            result.Work(
+                [&executor, fn = std::move(fn)](ResolveFunction resolve, RejectFunction reject)
+                {
+                    bool posted = executor.Execute(
+                        [fn, resolve, reject]()
+                        {
+                            try
+                            {
+                                resolve(fn());
+                            }
+                            catch (const std::exception &e)
+                            {
+                                reject(e.what());
+                            }
+                        });
+                    if (!posted)
+                    {
+                        reject("Executor is closed or busy.");
+                    }
+                });
+            return result;
+        }
+
+        // Resolves when all of the promises resolve, with their values in order, or rejects with the first rejection.
+        static Promise<std::vector<T>> All(const std::vector<Promise<T>> &promises)
+        {
+            struct State
+            {
+                std::mutex mutex;
+                std::vector<T> values;
+                size_t remaining = 0;
+                bool settled = false;
+                pipedal::ResolveFunction<std::vector<T>> resolve;
+                RejectFunction reject;
+            };
+            auto state = std::make_shared<State>();
+            state->values.resize(promises.size());
+            state->remaining = promises.size();
+
+            Promise<std::vector<T>> result;
+            result.Work(
+                [state](pipedal::ResolveFunction<std::vector<T>> resolve, RejectFunction reject)
+                {
+                    state->resolve = resolve;
+                    state->reject = reject;
+                });
+            if (promises.empty())
+            {
+                state->resolve(state->values);
+                return result;
+            }
+            for (size_t i = 0; i < promises.size(); ++i)
+            {
+                Promise<T> input = promises[i];
+                input.Then(
+                         [state, i](const T &value)
+                         {
+                             bool done;
+                             {
+                                 std::lock_guard lock{state->mutex};
+                                 state->values[i] = value;
+                                 done = --state->remaining == 0 && !state->settled;
+                                 if (done)
+                                     state->settled = true;
+                             }
+                             if (done)
+                             {
+                                 state->resolve(state->values);
+                             }
+                         })
+                    .Catch(
+                        [state](const std::string &message)
+                        {
+                            {
+                                std::lock_guard lock{state->mutex};
+                                if (state->settled)
+                                    return;
+                                state->settled = true;
+                            }
+                            state->reject(message);
+                        });
+            }
+            return result;
+        }
+
+        // Resolves with the value of the first promise to resolve, or rejects with the last rejection if all of them reject.
+        static Promise<T> Any(const std::vector<Promise<T>> &promises)
+        {
+            struct State
+            {
+                std::mutex mutex;
+                size_t remaining = 0;
+                bool settled = false;
+                ResolveFunction resolve;
+                RejectFunction reject;
+            };
+            auto state = std::make_shared<State>();
+            state->remaining = promises.size();
+
+            Promise<T> result;
+            result.Work(
+                [state](ResolveFunction resolve, RejectFunction reject)
+                {
+                    state->resolve = resolve;
+                    state->reject = reject;
+                });
+            if (promises.empty())
+            {
+                state->reject("No promises.");
+                return result;
+            }
+            for (size_t i = 0; i < promises.size(); ++i)
+            {
+                Promise<T> input = promises[i];
+                input.Then(
+                         [state](const T &value)
+                         {
+                             {
+                                 std::lock_guard lock{state->mutex};
+                                 if (state->settled)
+                                     return;
+                                 state->settled = true;
+                             }
+                             state->resolve(value);
+                         })
+                    .Catch(
+                        [state](const std::string &message)
+                        {
+                            {
+                                std::lock_guard lock{state->mutex};
+                                if (state->settled || --state->remaining != 0)
+                                    return;
+                                state->settled = true;
+                            }
+                            state->reject(message);
+                        });
+            }
+            return result;
+        }
+
         Promise<T> Catch(const CatchFunction &catchFn)
         {
             p->Catch(catchFn);
@@ -458,8 +666,15 @@ namespace pipedal
         }
         Promise<T> &operator=(const Promise<T> &other)
         {
+            if (other.p)
+            {
+                other.p->AddRef();
+            }
+            if (this->p)
+            {
+                this->p->ReleaseRef();
+            }
             this->p = other.p;
-            p->AddRef();
             return *this;
         }
         T Get()
@@ -259,3 +259,210 @@ TEST_CASE("Promise", "[promise][Build][Dev]")
 
     REQUIRE(PromiseInnerBase::allocationCount == 0);
 }
+
+namespace
+{
+    // Runs work on a new thread, and records which threads it ran on.
+    class TestExecutor : public IExecutor
+    {
+    public:
+        ~TestExecutor()
+        {
+            Join();
+        }
+        virtual bool Execute(std::function<void()> &&work) override
+        {
+            std::lock_guard lock{mutex};
+            if (closed)
+                return false;
+            threads.emplace_back(
+                [this, work = std::move(work)]()
+                {
+                    {
+                        std::lock_guard lock{mutex};
+                        threadIds.push_back(std::this_thread::get_id());
+                    }
+                    work();
+                });
+            return true;
+        }
+        void Join()
+        {
+            // work items may post further work items.
+            while (true)
+            {
+                std::thread t;
+                {
+                    std::lock_guard lock{mutex};
+                    if (threads.empty())
+                        break;
+                    t = std::move(threads.front());
+                    threads.erase(threads.begin());
+                }
+                t.join();
+            }
+        }
+        bool RanOn(std::thread::id id)
+        {
+            std::lock_guard lock{mutex};
+            for (auto threadId : threadIds)
+            {
+                if (threadId == id)
+                    return true;
+            }
+            return false;
+        }
+        bool closed = false;
+
+    private:
+        std::mutex mutex;
+        std::vector<std::thread> threads;
+        std::vector<std::thread::id> threadIds;
+    };
+}
+
+TEST_CASE("Promise executor", "[promise][Build][Dev]")
+{
+    {
+        // Then handler runs on the executor, not on the resolving thread.
+        TestExecutor executor;
+        std::thread::id thenThread;
+        Promise<int>([](ResolveFunction<int> resolve, RejectFunction reject)
+                     { resolve(1); })
+            .On(executor)
+            .Then([&thenThread](int value)
+                  {
+                      REQUIRE(value == 1);
+                      thenThread = std::this_thread::get_id(); });
+        executor.Join();
+        REQUIRE(thenThread != std::this_thread::get_id());
+        REQUIRE(executor.RanOn(thenThread));
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Catch handler runs on the executor.
+        TestExecutor executor;
+        std::thread::id catchThread;
+        Promise<int>([](ResolveFunction<int> resolve, RejectFunction reject)
+                     { reject("rejected"); })
+            .On(executor)
+            .Then([](int value)
+                  { REQUIRE(false); })
+            .Catch([&catchThread](const std::string &message)
+                   { catchThread = std::this_thread::get_id(); });
+        executor.Join();
+        REQUIRE(executor.RanOn(catchThread));
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Run + Then<U>(executor, ...)
+        TestExecutor executor;
+        int result = Promise<int>::Run(executor, []()
+                                       { return 3; })
+                         .Then<int>(executor, [](int value, ResolveFunction<int> resolve, RejectFunction reject)
+                                    { resolve(value * 2); })
+                         .Get();
+        REQUIRE(result == 6);
+        executor.Join();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Run rejects on exception, and when the executor refuses the work.
+        TestExecutor executor;
+        REQUIRE_THROWS(Promise<int>::Run(executor, []() -> int
+                                         { throw std::runtime_error("failed"); })
+                           .Get());
+        executor.Join();
+        executor.closed = true;
+        REQUIRE_THROWS(Promise<int>::Run(executor, []()
+                                         { return 1; })
+                           .Get());
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Refused continuations run inline.
+        TestExecutor executor;
+        executor.closed = true;
+        bool called = false;
+        Promise<int>([](ResolveFunction<int> resolve, RejectFunction reject)
+                     { resolve(1); })
+            .On(executor)
+            .Then([&called](int value)
+                  { called = true; });
+        REQUIRE(called);
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+}
+
+TEST_CASE("Promise All/Any", "[promise][Build][Dev]")
+{
+    {
+        TestExecutor executor;
+        std::vector<Promise<int>> promises;
+        for (int i = 0; i < 5; ++i)
+        {
+            promises.push_back(Promise<int>::Run(executor, [i]()
+                                                 {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10*(5-i)));
+                return i; }));
+        }
+        std::vector<int> result = Promise<int>::All(promises).Get();
+        REQUIRE(result.size() == 5);
+        for (int i = 0; i < 5; ++i)
+        {
+            REQUIRE(result[i] == i);
+        }
+        promises.clear();
+        executor.Join();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        REQUIRE(Promise<int>::All({}).Get().size() == 0);
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // All rejects if any input rejects.
+        TestExecutor executor;
+        std::vector<Promise<int>> promises;
+        promises.push_back(Promise<int>::Run(executor, []()
+                                             { return 1; }));
+        promises.push_back(Promise<int>::Run(executor, []() -> int
+                                             { throw std::runtime_error("failed"); }));
+        REQUIRE_THROWS(Promise<int>::All(promises).Get());
+        promises.clear();
+        executor.Join();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Any resolves with the first resolution, ignoring rejections.
+        TestExecutor executor;
+        std::vector<Promise<int>> promises;
+        promises.push_back(Promise<int>::Run(executor, []() -> int
+                                             { throw std::runtime_error("failed"); }));
+        promises.push_back(Promise<int>::Run(executor, []()
+                                             {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return 2; }));
+        promises.push_back(Promise<int>::Run(executor, []()
+                                             { return 3; }));
+        REQUIRE(Promise<int>::Any(promises).Get() == 3);
+        promises.clear();
+        executor.Join();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+    {
+        // Any rejects if all inputs reject.
+        TestExecutor executor;
+        std::vector<Promise<int>> promises;
+        for (int i = 0; i < 3; ++i)
+        {
+            promises.push_back(Promise<int>::Run(executor, []() -> int
+                                                 { throw std::runtime_error("failed"); }));
+        }
+        REQUIRE_THROWS(Promise<int>::Any(promises).Get());
+        REQUIRE_THROWS(Promise<int>::Any({}).Get());
+        promises.clear();
+        executor.Join();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+}
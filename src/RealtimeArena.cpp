@@ -0,0 +1,194 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "RealtimeArena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+
+using namespace pipedal;
+
+static std::atomic<RealtimeArena::HugePages> hugePagesSetting = RealtimeArena::HugePages::None;
+
+static size_t AlignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+void RealtimeArena::SetHugePages(HugePages hugePages)
+{
+    hugePagesSetting = hugePages;
+}
+
+RealtimeArena::HugePages RealtimeArena::GetHugePages()
+{
+    return hugePagesSetting;
+}
+
+RealtimeArena::RealtimeArena(size_t blockSize, bool useHugePages)
+    : blockSize(AlignUp(blockSize, CACHE_LINE_SIZE)), useHugePages(useHugePages)
+{
+}
+
+RealtimeArena::~RealtimeArena()
+{
+    Clear();
+}
+
+// A HUGE_PAGE_SIZE-aligned mapping, so that transparent hugepages can back it.
+static char *MapAligned(size_t size)
+{
+    size_t mappedSize = size + RealtimeArena::HUGE_PAGE_SIZE;
+    void *mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    char *start = (char *)mapping;
+    char *result = (char *)AlignUp((size_t)start, RealtimeArena::HUGE_PAGE_SIZE);
+    if (result != start)
+    {
+        munmap(start, result - start);
+    }
+    char *end = result + size;
+    char *mappedEnd = start + mappedSize;
+    if (mappedEnd != end)
+    {
+        munmap(end, mappedEnd - end);
+    }
+    return result;
+}
+
+RealtimeArena::Block &RealtimeArena::AllocateBlock(size_t minSize)
+{
+    Block block;
+    block.size = std::max(blockSize, AlignUp(minSize, CACHE_LINE_SIZE));
+
+    HugePages hugePages = useHugePages ? GetHugePages() : HugePages::None;
+    if (hugePages != HugePages::None)
+    {
+        block.size = AlignUp(block.size, HUGE_PAGE_SIZE);
+#ifdef MAP_HUGETLB
+        if (hugePages == HugePages::Explicit)
+        {
+            void *mapping = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (mapping != MAP_FAILED)
+            {
+                block.memory = (char *)mapping;
+                block.hugePages = true;
+            }
+        }
+#endif
+        if (!block.memory)
+        {
+            block.memory = MapAligned(block.size);
+#ifdef MADV_HUGEPAGE
+            block.hugePages = block.memory && madvise(block.memory, block.size, MADV_HUGEPAGE) == 0;
+#endif
+        }
+    }
+    else
+    {
+        block.size = AlignUp(block.size, 4096);
+        void *mapping = mmap(nullptr, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        block.memory = mapping == MAP_FAILED ? nullptr : (char *)mapping;
+    }
+    if (!block.memory)
+    {
+        throw std::bad_alloc();
+    }
+    // pre-fault every page now, rather than on the audio thread.
+    std::memset(block.memory, 0, block.size);
+#ifndef NO_MLOCK
+    // best effort. mlockall() will usually have locked it already.
+    block.mlocked = mlock(block.memory, block.size) == 0;
+#endif
+    blocks.push_back(block);
+    return blocks.back();
+}
+
+void *RealtimeArena::AllocateBytes(size_t size)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size = AlignUp(std::max(size, (size_t)1), CACHE_LINE_SIZE);
+
+    Block *block = blocks.empty() ? nullptr : &blocks.back();
+    if (block == nullptr || block->size - block->used < size)
+    {
+        block = &AllocateBlock(size);
+    }
+    void *result = block->memory + block->used;
+    block->used += size;
+    return result;
+}
+
+size_t RealtimeArena::BytesAllocated() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t result = 0;
+    for (const auto &block : blocks)
+    {
+        result += block.used;
+    }
+    return result;
+}
+
+size_t RealtimeArena::BytesReserved() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t result = 0;
+    for (const auto &block : blocks)
+    {
+        result += block.size;
+    }
+    return result;
+}
+
+bool RealtimeArena::UsesHugePages() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &block : blocks)
+    {
+        if (block.hugePages)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RealtimeArena::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &block : blocks)
+    {
+#ifndef NO_MLOCK
+        if (block.mlocked)
+        {
+            munlock(block.memory, block.size);
+        }
+#endif
+        munmap(block.memory, block.size);
+    }
+    blocks.clear();
+}
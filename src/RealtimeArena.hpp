@@ -0,0 +1,95 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Memory for the audio thread, allocated while a pedalboard is being prepared.
+     *
+     * Allocations are zeroed and cache-line aligned, and are carved out of a small number of
+     * large blocks which are pre-faulted and mlocked (best effort) when they are allocated, so
+     * that the audio thread never takes a page fault on them. Arenas that are created with
+     * useHugePages can be backed by transparent or explicit hugepages, depending on
+     * SetHugePages(). Memory is only released when the arena is cleared or destroyed.
+     *
+     * Allocation is thread-safe, but must not be done on the audio thread.
+     */
+    class RealtimeArena
+    {
+    public:
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+        static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+        static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+        enum class HugePages
+        {
+            None,
+            Transparent, // madvise(MADV_HUGEPAGE). Needs transparent hugepages to be enabled in the kernel.
+            Explicit,    // MAP_HUGETLB, falling back to Transparent if no hugepages have been reserved.
+        };
+        // Process-wide. Applies to blocks allocated after the call.
+        static void SetHugePages(HugePages hugePages);
+        static HugePages GetHugePages();
+
+        RealtimeArena(size_t blockSize = DEFAULT_BLOCK_SIZE, bool useHugePages = false);
+        ~RealtimeArena();
+
+        RealtimeArena(const RealtimeArena &) = delete;
+        RealtimeArena &operator=(const RealtimeArena &) = delete;
+
+        template <typename T>
+        T *Allocate(size_t count)
+        {
+            return (T *)AllocateBytes(count * sizeof(T));
+        }
+        void *AllocateBytes(size_t size);
+
+        // Bytes handed out by Allocate (including alignment padding).
+        size_t BytesAllocated() const;
+        // Bytes in the arena's blocks, all of which are resident.
+        size_t BytesReserved() const;
+        // True if any of the blocks are backed by hugepages (or have been advised to be).
+        bool UsesHugePages() const;
+
+        void Clear();
+
+    private:
+        struct Block
+        {
+            char *memory = nullptr;
+            size_t size = 0;
+            size_t used = 0;
+            bool mlocked = false;
+            bool hugePages = false;
+        };
+        Block &AllocateBlock(size_t minSize);
+
+        mutable std::mutex mutex;
+        size_t blockSize;
+        bool useHugePages;
+        std::vector<Block> blocks;
+    };
+}
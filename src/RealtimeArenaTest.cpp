@@ -0,0 +1,68 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <cstdint>
+#include "RealtimeArena.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("RealtimeArena test", "[realtime_arena][Build][Dev]")
+{
+    RealtimeArena arena(1024);
+
+    float *a = arena.Allocate<float>(10);
+    float *b = arena.Allocate<float>(10);
+    REQUIRE(((uintptr_t)a % RealtimeArena::CACHE_LINE_SIZE) == 0);
+    REQUIRE(((uintptr_t)b % RealtimeArena::CACHE_LINE_SIZE) == 0);
+    // rounded up to a whole cache line, so that buffers don't share cache lines.
+    REQUIRE((char *)b - (char *)a == RealtimeArena::CACHE_LINE_SIZE);
+    for (size_t i = 0; i < 10; ++i)
+    {
+        REQUIRE(a[i] == 0);
+        REQUIRE(b[i] == 0);
+    }
+    REQUIRE(arena.BytesAllocated() == 2 * RealtimeArena::CACHE_LINE_SIZE);
+
+    // larger than a block.
+    uint8_t *large = arena.Allocate<uint8_t>(4000);
+    REQUIRE(((uintptr_t)large % RealtimeArena::CACHE_LINE_SIZE) == 0);
+    large[3999] = 1;
+    REQUIRE(arena.BytesReserved() >= arena.BytesAllocated());
+
+    arena.Clear();
+    REQUIRE(arena.BytesAllocated() == 0);
+    REQUIRE(arena.BytesReserved() == 0);
+}
+
+TEST_CASE("RealtimeArena hugepage test", "[realtime_arena][Build][Dev]")
+{
+    auto savedHugePages = RealtimeArena::GetHugePages();
+    RealtimeArena::SetHugePages(RealtimeArena::HugePages::Transparent);
+    {
+        RealtimeArena arena(RealtimeArena::DEFAULT_BLOCK_SIZE, true);
+        float *buffer = arena.Allocate<float>(1024);
+        REQUIRE(((uintptr_t)buffer % RealtimeArena::CACHE_LINE_SIZE) == 0);
+        buffer[1023] = 1;
+        // blocks are at least a hugepage, whether or not the kernel actually backs them with one.
+        REQUIRE(arena.BytesReserved() >= RealtimeArena::HUGE_PAGE_SIZE);
+    }
+    RealtimeArena::SetHugePages(savedHugePages);
+}
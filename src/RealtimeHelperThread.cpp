@@ -0,0 +1,191 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "RealtimeHelperThread.hpp"
+#include "SchedulerPriority.hpp"
+#include "Denormals.hpp"
+#include "RealtimeWatchdog.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <chrono>
+#include <climits>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "Futex.hpp"
+
+#if defined(__aarch64__)
+#define CPU_RELAX() asm volatile("yield" ::: "memory")
+#elif defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+using namespace pipedal;
+
+int RealtimeHelperThread::DefaultHelperCpu()
+{
+    if (CpuAffinityPlan::Enabled())
+    {
+        // -1 (inherit the background cpus) if only one cpu has been set aside for realtime audio.
+        return CpuAffinityPlan::HelperCpu();
+    }
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nCpus <= 1)
+    {
+        return -1;
+    }
+    return (int)(nCpus - 1);
+}
+
+int RealtimeHelperThread::SlotHelperCpu(size_t slot)
+{
+    if (CpuAffinityPlan::Enabled())
+    {
+        const auto &cpus = CpuAffinityPlan::RealtimeCpus();
+        return slot + 1 < cpus.size() ? cpus[slot + 1] : -1;
+    }
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    // cpu 0 is left for the audio thread and everything else.
+    long cpu = nCpus - 1 - (long)slot;
+    return cpu >= 1 ? (int)cpu : -1;
+}
+
+RealtimeHelperThread::RealtimeHelperThread(int cpu)
+    : cpu(cpu)
+{
+    this->thread = std::make_unique<std::thread>([this]()
+                                                 { ThreadProc(); });
+}
+
+RealtimeHelperThread::~RealtimeHelperThread()
+{
+    closing.store(true);
+    jobSequence.fetch_add(1);
+    futex_wake(&jobSequence);
+    if (thread)
+    {
+        thread->join();
+        thread = nullptr;
+    }
+}
+
+void RealtimeHelperThread::Start(JobFn fn, void *data, uint32_t frames)
+{
+    this->jobFn = fn;
+    this->jobData = data;
+    this->jobFrames = frames;
+    jobSequence.fetch_add(1);
+    if (helperSleeping.load())
+    {
+        futex_wake(&jobSequence);
+    }
+}
+
+void RealtimeHelperThread::Wait()
+{
+    uint32_t sequence = jobSequence.load(std::memory_order_relaxed);
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (doneSequence.load(std::memory_order_acquire) == sequence)
+        {
+            return;
+        }
+        CPU_RELAX();
+    }
+    callerWaitingFor.store(sequence);
+    while (true)
+    {
+        uint32_t done = doneSequence.load();
+        if (done == sequence)
+        {
+            break;
+        }
+        futex_wait(&doneSequence, done);
+    }
+}
+
+void RealtimeHelperThread::ThreadProc()
+{
+    SetThreadName("rtHelper");
+    if (cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+        {
+            Lv2Log::warning(SS("Failed to pin realtime helper thread to cpu " << cpu));
+        }
+    }
+    SetThreadPriority(SchedulerPriority::RealtimeAudioHelper);
+    RealtimeWatchdog::AttachThread("rtHelper");
+
+    uint32_t lastSequence = 0;
+    while (true)
+    {
+        uint32_t sequence = jobSequence.load(std::memory_order_acquire);
+        if (sequence == lastSequence)
+        {
+            // spin briefly, in case the audio thread is about to post the next job.
+            for (int i = 0; i < SPIN_COUNT; ++i)
+            {
+                sequence = jobSequence.load(std::memory_order_acquire);
+                if (sequence != lastSequence)
+                {
+                    break;
+                }
+                CPU_RELAX();
+            }
+            if (sequence == lastSequence)
+            {
+                helperSleeping.store(true);
+                if (jobSequence.load() == lastSequence)
+                {
+                    futex_wait(&jobSequence, lastSequence);
+                }
+                helperSleeping.store(false);
+                continue;
+            }
+        }
+        if (closing.load())
+        {
+            return;
+        }
+        lastSequence = sequence;
+
+        // the same flush-to-zero setting as the audio thread.
+        Denormals::ApplyPolicy();
+        auto startTime = std::chrono::steady_clock::now();
+        jobFn(jobData, jobFrames);
+        auto endTime = std::chrono::steady_clock::now();
+        lastJobNs.store(
+            (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count(),
+            std::memory_order_relaxed);
+
+        doneSequence.store(sequence);
+        if (callerWaitingFor.load() == sequence)
+        {
+            futex_wake(&doneSequence);
+        }
+    }
+}
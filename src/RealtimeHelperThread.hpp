@@ -0,0 +1,98 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <memory>
+
+namespace pipedal
+{
+
+    /**
+     * @brief A realtime helper thread that executes one job per audio period on behalf of the audio thread.
+     *
+     * The audio thread posts a job with Start(), does its own share of the work, and then
+     * rendezvous with the helper in Wait(). Both sides spin briefly before falling back to
+     * a futex wait, so the handoff costs a few hundred nanoseconds when the helper core is
+     * idle, and doesn't burn a core when the audio thread is stalled on the driver.
+     *
+     * Start() and Wait() must only be called from the (single) audio thread. Every Start()
+     * must be paired with a Wait() before the next Start().
+     */
+    class RealtimeHelperThread
+    {
+    public:
+        using JobFn = void (*)(void *data, uint32_t frames);
+        using ptr = std::unique_ptr<RealtimeHelperThread>;
+
+        /**
+         * @brief Construct a helper thread.
+         *
+         * @param cpu The cpu to pin the helper thread to, or -1 to let the scheduler choose.
+         */
+        RealtimeHelperThread(int cpu = -1);
+        ~RealtimeHelperThread();
+
+        RealtimeHelperThread(const RealtimeHelperThread &) = delete;
+        RealtimeHelperThread &operator=(const RealtimeHelperThread &) = delete;
+
+        static ptr Create(int cpu = -1) { return std::make_unique<RealtimeHelperThread>(cpu); }
+
+        // Audio thread only.
+        void Start(JobFn fn, void *data, uint32_t frames);
+        // Audio thread only. Returns once the job posted by Start() has completed.
+        void Wait();
+
+        // Duration of the most recently completed job, in nanoseconds.
+        uint64_t GetLastJobNs() const { return lastJobNs.load(std::memory_order_relaxed); }
+
+        // The cpu helper threads are pinned to by default: the CpuAffinityPlan's helper cpu if there is a plan;
+        // otherwise the highest-numbered cpu, or -1 on single-core machines.
+        static int DefaultHelperCpu();
+        // The cpu for the helper thread of additional pedalboard slot `slot` (1-based): the next realtime cpu
+        // after the helper cpu if there is a CpuAffinityPlan; otherwise counting down from below the default
+        // helper cpu. -1 if there are no cpus left.
+        static int SlotHelperCpu(size_t slot);
+
+    private:
+        void ThreadProc();
+
+        static constexpr int SPIN_COUNT = 2000;
+
+        int cpu = -1;
+        // Incremented by the audio thread to post a job.
+        alignas(64) std::atomic<uint32_t> jobSequence{0};
+        // Set to the job sequence number by the helper when the job completes.
+        alignas(64) std::atomic<uint32_t> doneSequence{0};
+        // The sequence number the audio thread is blocked on (if it had to sleep).
+        std::atomic<uint32_t> callerWaitingFor{0};
+        std::atomic<bool> helperSleeping{false};
+        std::atomic<bool> closing{false};
+        std::atomic<uint64_t> lastJobNs{0};
+
+        JobFn jobFn = nullptr;
+        void *jobData = nullptr;
+        uint32_t jobFrames = 0;
+
+        std::unique_ptr<std::thread> thread;
+    };
+}
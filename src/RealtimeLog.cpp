@@ -0,0 +1,203 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "RealtimeLog.hpp"
+#include "Futex.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace pipedal;
+
+RealtimeLog::RealtimeLog(Sink sink, size_t capacity)
+    : sink(std::move(sink)),
+      capacity(capacity),
+      mask(capacity - 1)
+{
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+    {
+        throw std::invalid_argument("RealtimeLog capacity must be a power of 2.");
+    }
+    slots = std::make_unique<Slot[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+RealtimeLog::~RealtimeLog()
+{
+    Stop();
+}
+
+RealtimeLog &RealtimeLog::Global()
+{
+    static RealtimeLog instance(
+        [](LogLevel level, const char *message)
+        {
+            switch (level)
+            {
+            case LogLevel::Error:
+                Lv2Log::error("%s", message);
+                break;
+            case LogLevel::Warning:
+                Lv2Log::warning("%s", message);
+                break;
+            case LogLevel::Debug:
+                Lv2Log::debug("%s", message);
+                break;
+            case LogLevel::Info:
+            default:
+                Lv2Log::info("%s", message);
+                break;
+            }
+        });
+    return instance;
+}
+
+void RealtimeLog::Start()
+{
+    if (thread)
+    {
+        return;
+    }
+    terminate = false;
+    thread = std::make_unique<std::jthread>(
+        [this]()
+        {
+            SetThreadName("rtlog");
+            ThreadProc();
+        });
+    started = true;
+}
+
+void RealtimeLog::Stop()
+{
+    if (!thread)
+    {
+        return;
+    }
+    started = false;
+    terminate = true;
+    writeSequence.fetch_add(1);
+    futex_wake(&writeSequence);
+    thread->join();
+    thread = nullptr;
+    Drain(); // anything posted while the thread was exiting.
+}
+
+bool RealtimeLog::Post(LogLevel level, const char *message)
+{
+    if (!started.load(std::memory_order_acquire))
+    {
+        sink(level, message);
+        return true;
+    }
+
+    Slot *slot;
+    size_t position = writePosition.load(std::memory_order_relaxed);
+    while (true)
+    {
+        slot = &slots[position & mask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+        if (diff == 0)
+        {
+            if (writePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            totalDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            position = writePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    strncpy(slot->text, message, MAX_MESSAGE_LENGTH);
+    slot->text[MAX_MESSAGE_LENGTH] = '\0';
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    writeSequence.fetch_add(1);
+    if (readerWaiting.load())
+    {
+        futex_wake(&writeSequence);
+    }
+    return true;
+}
+
+bool RealtimeLog::TryRead(LogLevel *level, char *text)
+{
+    Slot *slot = &slots[readPosition & mask];
+    if (slot->sequence.load(std::memory_order_acquire) != readPosition + 1)
+    {
+        return false;
+    }
+    *level = slot->level;
+    memcpy(text, slot->text, MAX_MESSAGE_LENGTH + 1);
+    slot->sequence.store(readPosition + capacity, std::memory_order_release);
+    ++readPosition;
+    return true;
+}
+
+void RealtimeLog::Drain()
+{
+    LogLevel level;
+    char text[MAX_MESSAGE_LENGTH + 1];
+    while (TryRead(&level, text))
+    {
+        sink(level, text);
+    }
+    uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost != 0)
+    {
+        std::string message = SS(lost << " realtime log message(s) dropped.");
+        sink(LogLevel::Warning, message.c_str());
+    }
+}
+
+void RealtimeLog::ThreadProc()
+{
+    while (true)
+    {
+        uint32_t sequence = writeSequence.load();
+        Drain();
+        if (terminate)
+        {
+            break;
+        }
+        readerWaiting = true;
+        if (writeSequence.load() == sequence)
+        {
+            futex_wait_for(&writeSequence, sequence, std::chrono::milliseconds(500));
+        }
+        readerWaiting = false;
+    }
+    Drain();
+}
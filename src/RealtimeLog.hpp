@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Lv2Log.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace pipedal
+{
+    /**
+     * @brief Lock-free log queue for the audio thread and plugins.
+     *
+     * Post() copies a preformatted message into a fixed-size slot of a bounded multi-producer ring,
+     * without locking or allocating, and wakes a background thread that passes it on to the sink.
+     * Messages that don't fit are truncated; messages posted while the ring is full are dropped and
+     * counted, and the count is reported once the ring has drained.
+     *
+     * Before Start() (and after Stop()) messages are sent to the sink synchronously on the caller's thread.
+     */
+    class RealtimeLog
+    {
+    public:
+        static constexpr size_t MAX_MESSAGE_LENGTH = 255;
+        static constexpr size_t DEFAULT_CAPACITY = 256; // must be a power of 2.
+
+        using Sink = std::function<void(LogLevel level, const char *message)>;
+
+        RealtimeLog(Sink sink, size_t capacity = DEFAULT_CAPACITY);
+        ~RealtimeLog();
+
+        // The process-wide log, which writes to Lv2Log.
+        static RealtimeLog &Global();
+
+        void Start();
+        // Writes any pending messages before returning.
+        void Stop();
+
+        // Any thread. Realtime-safe once started. Returns false if the message was dropped.
+        bool Post(LogLevel level, const char *message);
+
+        uint64_t GetDroppedCount() const { return totalDropped.load(std::memory_order_relaxed); }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+            LogLevel level;
+            char text[MAX_MESSAGE_LENGTH + 1];
+        };
+
+        bool TryRead(LogLevel *level, char *text);
+        void Drain();
+        void ThreadProc();
+
+        Sink sink;
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<Slot[]> slots;
+
+        alignas(64) std::atomic<size_t> writePosition{0};
+        alignas(64) size_t readPosition = 0;
+
+        std::atomic<uint32_t> writeSequence{0};
+        std::atomic<bool> readerWaiting{false};
+        std::atomic<bool> started{false};
+        std::atomic<bool> terminate{false};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> totalDropped{0};
+        std::unique_ptr<std::jthread> thread;
+    };
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RealtimeLog.hpp"
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    struct CapturingSink
+    {
+        std::mutex mutex;
+        std::vector<std::string> messages;
+        std::vector<LogLevel> levels;
+
+        RealtimeLog::Sink GetSink()
+        {
+            return [this](LogLevel level, const char *message)
+            {
+                std::lock_guard lock(mutex);
+                messages.push_back(message);
+                levels.push_back(level);
+            };
+        }
+    };
+}
+
+TEST_CASE("RealtimeLog multiple producers", "[realtime_log][Build][Dev]")
+{
+    constexpr int THREADS = 4;
+    constexpr int MESSAGES = 2000;
+
+    CapturingSink capture;
+    {
+        RealtimeLog log(capture.GetSink(), 64);
+        log.Start();
+
+        std::vector<std::jthread> threads;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            threads.emplace_back(
+                [&log, t]()
+                {
+                    char message[64];
+                    for (int i = 0; i < MESSAGES; ++i)
+                    {
+                        snprintf(message, sizeof(message), "%d:%d", t, i);
+                        while (!log.Post(LogLevel::Info, message))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+        }
+        threads.clear();
+        log.Stop();
+    }
+
+    // every message arrives once, and each producer's messages arrive in order.
+    std::vector<int> next(THREADS, 0);
+    size_t received = 0;
+    for (const auto &message : capture.messages)
+    {
+        int t, i;
+        if (sscanf(message.c_str(), "%d:%d", &t, &i) != 2)
+        {
+            continue; // a dropped-message report.
+        }
+        REQUIRE(t >= 0);
+        REQUIRE(t < THREADS);
+        REQUIRE(i == next[t]);
+        ++next[t];
+        ++received;
+    }
+    REQUIRE(received == THREADS * MESSAGES);
+}
+
+TEST_CASE("RealtimeLog overflow", "[realtime_log][Build][Dev]")
+{
+    CapturingSink capture;
+    RealtimeLog log(capture.GetSink(), 16);
+
+    // not started: messages are delivered synchronously.
+    REQUIRE(log.Post(LogLevel::Error, "synchronous"));
+    REQUIRE(capture.messages.size() == 1);
+    REQUIRE(capture.levels[0] == LogLevel::Error);
+    capture.messages.clear();
+    capture.levels.clear();
+
+    log.Start();
+    // the consumer may be draining concurrently, so post until something is dropped.
+    size_t posted = 0;
+    while (log.GetDroppedCount() == 0)
+    {
+        if (log.Post(LogLevel::Warning, "message"))
+        {
+            ++posted;
+        }
+    }
+    log.Stop();
+
+    REQUIRE(log.GetDroppedCount() >= 1);
+    size_t delivered = 0;
+    bool reported = false;
+    for (const auto &message : capture.messages)
+    {
+        if (message == "message")
+        {
+            ++delivered;
+        }
+        else if (message.find("dropped") != std::string::npos)
+        {
+            reported = true;
+        }
+    }
+    REQUIRE(delivered == posted);
+    REQUIRE(reported);
+}
+
+TEST_CASE("RealtimeLog truncation", "[realtime_log][Build][Dev]")
+{
+    CapturingSink capture;
+    {
+        RealtimeLog log(capture.GetSink());
+        log.Start();
+        std::string longMessage(1000, 'x');
+        REQUIRE(log.Post(LogLevel::Debug, longMessage.c_str()));
+        log.Stop();
+    }
+    REQUIRE(capture.messages.size() == 1);
+    REQUIRE(capture.messages[0].length() == RealtimeLog::MAX_MESSAGE_LENGTH);
+    REQUIRE(capture.levels[0] == LogLevel::Debug);
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "RealtimePatchPropertyRequest.hpp"
+#include <stdexcept>
+
+using namespace pipedal;
+
+RealtimePatchPropertyRequestPool::RealtimePatchPropertyRequestPool(size_t initialRequests)
+{
+    std::vector<RealtimePatchPropertyRequest *> initial;
+    for (size_t i = 0; i < initialRequests; ++i)
+    {
+        initial.push_back(Acquire(true));
+    }
+    for (auto request : initial)
+    {
+        Release(request);
+    }
+}
+
+RealtimePatchPropertyRequestPool::~RealtimePatchPropertyRequestPool()
+{
+}
+
+uint8_t *RealtimePatchPropertyRequestPool::AcquireSlab()
+{
+    if (!freeSlabs.empty())
+    {
+        uint8_t *slab = freeSlabs.back();
+        freeSlabs.pop_back();
+        return slab;
+    }
+    slabs.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[LONG_ATOM_SLAB_SIZE]));
+    return slabs.back().get();
+}
+
+RealtimePatchPropertyRequest *RealtimePatchPropertyRequestPool::Acquire(bool needsLongAtomBuffer)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    RealtimePatchPropertyRequest *request = freeRequests;
+    if (request)
+    {
+        freeRequests = request->pNext;
+    }
+    else
+    {
+        requests.push_back(std::make_unique<RealtimePatchPropertyRequest>());
+        request = requests.back().get();
+    }
+    request->pNext = nullptr;
+    if (needsLongAtomBuffer)
+    {
+        request->longAtomBuffer = AcquireSlab();
+        request->longAtomCapacity = LONG_ATOM_SLAB_SIZE;
+    }
+    return request;
+}
+
+RealtimePatchPropertyRequest *RealtimePatchPropertyRequestPool::AcquireGet(
+    int64_t clientId,
+    int64_t instanceId,
+    LV2_URID uridUri,
+    const std::string &uri,
+    size_t sampleTimeout)
+{
+    // the size of the response isn't known until the audio thread receives it.
+    RealtimePatchPropertyRequest *request = Acquire(true);
+    request->requestType = RealtimePatchPropertyRequest::RequestType::PatchGet;
+    request->clientId = clientId;
+    request->instanceId = instanceId;
+    request->uridUri = uridUri;
+    request->uri = uri;
+    request->sampleTimeout = (int64_t)sampleTimeout;
+    return request;
+}
+
+RealtimePatchPropertyRequest *RealtimePatchPropertyRequestPool::AcquireSet(
+    int64_t clientId,
+    int64_t instanceId,
+    LV2_URID uridUri,
+    const LV2_Atom *atomValue,
+    size_t sampleTimeout)
+{
+    size_t size = atomValue->size + sizeof(LV2_Atom);
+    if (size > LONG_ATOM_SLAB_SIZE)
+    {
+        throw std::invalid_argument("Property value is too large.");
+    }
+    RealtimePatchPropertyRequest *request = Acquire(size > sizeof(request->atomBuffer));
+    request->requestType = RealtimePatchPropertyRequest::RequestType::PatchSet;
+    request->clientId = clientId;
+    request->instanceId = instanceId;
+    request->uridUri = uridUri;
+    request->sampleTimeout = (int64_t)sampleTimeout;
+    request->SetSize(size);
+    memcpy(request->GetBuffer(), atomValue, size);
+    return request;
+}
+
+void RealtimePatchPropertyRequestPool::Release(RealtimePatchPropertyRequest *request)
+{
+    if (request == nullptr)
+    {
+        return;
+    }
+    // release captures now; strings keep their capacity.
+    request->onPatchRequestComplete = nullptr;
+    request->onSuccess = nullptr;
+    request->onSetSuccess = nullptr;
+    request->onError = nullptr;
+    request->uri.clear();
+    request->jsonResponse.clear();
+    request->errorMessage = nullptr;
+    request->responseLength = 0;
+    request->pEffect = nullptr;
+    request->pNextActive = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (request->longAtomBuffer)
+    {
+        freeSlabs.push_back(request->longAtomBuffer);
+        request->longAtomBuffer = nullptr;
+        request->longAtomCapacity = 0;
+    }
+    request->pNext = freeRequests;
+    freeRequests = request;
+}
+
+size_t RealtimePatchPropertyRequestPool::GetAllocatedCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return requests.size();
+}
+
+size_t RealtimePatchPropertyRequestPool::GetFreeCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (auto p = freeRequests; p != nullptr; p = p->pNext)
+    {
+        ++count;
+    }
+    return count;
+}
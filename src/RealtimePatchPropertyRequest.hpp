@@ -0,0 +1,156 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "lv2/urid/urid.h"
+#include "lv2/atom/atom.h"
+
+namespace pipedal
+{
+    class Lv2Effect;
+    class RealtimePatchPropertyRequestPool;
+
+    /**
+     * @brief A patch:Get or patch:Set request sent to the audio thread.
+     *
+     * Allocated from a RealtimePatchPropertyRequestPool. Atom values that don't fit in the inline
+     * buffer use a fixed-size long-atom slab from the pool, so the audio thread never allocates.
+     */
+    class RealtimePatchPropertyRequest
+    {
+    public:
+        int64_t clientId = -1;
+        int64_t instanceId = -1;
+        LV2_URID uridUri = 0;
+        std::string uri;
+
+        enum class RequestType
+        {
+            PatchGet,
+            PatchSet
+        };
+        RequestType requestType = RequestType::PatchGet;
+
+        // Called on the host thread when the audio thread returns the request.
+        std::function<void(RealtimePatchPropertyRequest *)> onPatchRequestComplete;
+        std::function<void(const std::string &jsonResjult)> onSuccess;
+        std::function<void()> onSetSuccess;
+        std::function<void(const std::string &error)> onError;
+
+        const char *errorMessage = nullptr;
+        std::string jsonResponse;
+        int64_t sampleTimeout = 0;
+
+        RealtimePatchPropertyRequest *pNext = nullptr;
+
+        // Audio thread only: the target effect, and the next PatchGet request that is waiting for a
+        // response, set by Lv2Pedalboard::ProcessParameterRequests.
+        Lv2Effect *pEffect = nullptr;
+        RealtimePatchPropertyRequest *pNextActive = nullptr;
+
+        // Returns false if the value doesn't fit. Realtime-safe.
+        bool SetSize(size_t size)
+        {
+            if (size > sizeof(atomBuffer) && size > longAtomCapacity)
+            {
+                return false;
+            }
+            responseLength = size;
+            return true;
+        }
+        size_t GetSize() const { return responseLength; }
+        uint8_t *GetBuffer()
+        {
+            if (responseLength > sizeof(atomBuffer))
+            {
+                return longAtomBuffer;
+            }
+            return atomBuffer;
+        }
+
+    private:
+        friend class RealtimePatchPropertyRequestPool;
+
+        size_t responseLength = 0;
+        uint8_t atomBuffer[2048];
+        uint8_t *longAtomBuffer = nullptr; // a slab owned by the pool.
+        size_t longAtomCapacity = 0;
+    };
+
+    /**
+     * @brief A free list of RealtimePatchPropertyRequests, and of the long-atom slabs they use.
+     *
+     * UIs that poll patch properties (meters, tuners, file paths) issue a steady stream of requests,
+     * so requests are recycled rather than allocated and freed per request. Released requests keep
+     * the capacity of their strings, and the pool only grows if more requests are outstanding
+     * than it has ever had before. Host threads only; thread-safe.
+     */
+    class RealtimePatchPropertyRequestPool
+    {
+    public:
+        static constexpr size_t DEFAULT_INITIAL_REQUESTS = 32;
+        static constexpr size_t LONG_ATOM_SLAB_SIZE = 16 * 1024;
+
+        RealtimePatchPropertyRequestPool(size_t initialRequests = DEFAULT_INITIAL_REQUESTS);
+        ~RealtimePatchPropertyRequestPool();
+
+        RealtimePatchPropertyRequestPool(const RealtimePatchPropertyRequestPool &) = delete;
+        RealtimePatchPropertyRequestPool &operator=(const RealtimePatchPropertyRequestPool &) = delete;
+
+        RealtimePatchPropertyRequest *AcquireGet(
+            int64_t clientId,
+            int64_t instanceId,
+            LV2_URID uridUri,
+            const std::string &uri,
+            size_t sampleTimeout);
+
+        // Throws std::invalid_argument if the value is larger than LONG_ATOM_SLAB_SIZE.
+        RealtimePatchPropertyRequest *AcquireSet(
+            int64_t clientId,
+            int64_t instanceId,
+            LV2_URID uridUri,
+            const LV2_Atom *atomValue,
+            size_t sampleTimeout);
+
+        void Release(RealtimePatchPropertyRequest *request);
+
+        size_t GetAllocatedCount();
+        size_t GetFreeCount();
+
+    private:
+        RealtimePatchPropertyRequest *Acquire(bool needsLongAtomBuffer);
+        uint8_t *AcquireSlab();
+
+        std::mutex mutex;
+        std::vector<std::unique_ptr<RealtimePatchPropertyRequest>> requests;
+        std::vector<std::unique_ptr<uint8_t[]>> slabs;
+        RealtimePatchPropertyRequest *freeRequests = nullptr;
+        std::vector<uint8_t *> freeSlabs;
+    };
+}
@@ -0,0 +1,91 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RealtimePatchPropertyRequest.hpp"
+#include <set>
+
+using namespace pipedal;
+
+TEST_CASE("RealtimePatchPropertyRequestPool", "[patch_property_request_pool][Build][Dev]")
+{
+    RealtimePatchPropertyRequestPool pool(4);
+    REQUIRE(pool.GetAllocatedCount() == 4);
+    REQUIRE(pool.GetFreeCount() == 4);
+
+    // requests are recycled.
+    std::set<RealtimePatchPropertyRequest *> seen;
+    for (int i = 0; i < 100; ++i)
+    {
+        RealtimePatchPropertyRequest *request = pool.AcquireGet(1, 2, 3, "http://example.com/plugin#file", 1000);
+        REQUIRE(request->requestType == RealtimePatchPropertyRequest::RequestType::PatchGet);
+        REQUIRE(request->uri == "http://example.com/plugin#file");
+        REQUIRE(request->GetSize() == 0);
+        request->onSuccess = [](const std::string &) {};
+        seen.insert(request);
+        pool.Release(request);
+    }
+    REQUIRE(seen.size() == 1);
+    REQUIRE(pool.GetAllocatedCount() == 4);
+
+    // gets can hold responses up to a slab in size, without allocating on the audio thread.
+    {
+        RealtimePatchPropertyRequest *request = pool.AcquireGet(1, 2, 3, "", 1000);
+        REQUIRE(request->SetSize(100));
+        REQUIRE(request->SetSize(RealtimePatchPropertyRequestPool::LONG_ATOM_SLAB_SIZE));
+        request->GetBuffer()[RealtimePatchPropertyRequestPool::LONG_ATOM_SLAB_SIZE - 1] = 1;
+        REQUIRE(!request->SetSize(RealtimePatchPropertyRequestPool::LONG_ATOM_SLAB_SIZE + 1));
+        REQUIRE(request->GetSize() == RealtimePatchPropertyRequestPool::LONG_ATOM_SLAB_SIZE);
+        pool.Release(request);
+    }
+
+    // sets copy the value.
+    {
+        std::vector<uint8_t> atomData(sizeof(LV2_Atom) + 5000);
+        LV2_Atom *atom = (LV2_Atom *)atomData.data();
+        atom->size = 5000;
+        atom->type = 7;
+        atomData.back() = 0x5A;
+        RealtimePatchPropertyRequest *request = pool.AcquireSet(1, 2, 3, atom, 1000);
+        REQUIRE(request->requestType == RealtimePatchPropertyRequest::RequestType::PatchSet);
+        REQUIRE(request->GetSize() == atomData.size());
+        REQUIRE(request->GetBuffer()[atomData.size() - 1] == 0x5A);
+        pool.Release(request);
+
+        atom->size = RealtimePatchPropertyRequestPool::LONG_ATOM_SLAB_SIZE;
+        REQUIRE_THROWS(pool.AcquireSet(1, 2, 3, atom, 1000));
+    }
+
+    // the pool grows when more requests are outstanding than it has.
+    {
+        std::vector<RealtimePatchPropertyRequest *> outstanding;
+        for (int i = 0; i < 10; ++i)
+        {
+            outstanding.push_back(pool.AcquireGet(1, 2, 3, "", 1000));
+        }
+        REQUIRE(pool.GetAllocatedCount() == 10);
+        for (auto request : outstanding)
+        {
+            pool.Release(request);
+        }
+        REQUIRE(pool.GetFreeCount() == 10);
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "RealtimePedalboardSlots.hpp"
+#include "Lv2Pedalboard.hpp"
+#include <cstring>
+#include <stdexcept>
+
+using namespace pipedal;
+
+RealtimePedalboardSlots::RealtimePedalboardSlots(
+    size_t driverOutputChannels,
+    const std::vector<int> &mainInputChannels, const std::vector<int> &mainOutputChannels,
+    const std::vector<AudioPedalboardSlot> &slots)
+    : mainInputChannels(mainInputChannels),
+      mainOutputChannels(mainOutputChannels),
+      mainInputs(mainInputChannels.size() + 1),
+      mainOutputs(mainOutputChannels.size() + 1)
+{
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        const auto &slot = slots[i];
+        if (slot.inputChannels.size() == 0 || slot.inputChannels.size() > MAX_SLOT_CHANNELS ||
+            slot.outputChannels.size() == 0 || slot.outputChannels.size() > MAX_SLOT_CHANNELS)
+        {
+            throw std::invalid_argument("Invalid pedalboard slot channels.");
+        }
+        auto realtimeSlot = std::make_unique<Slot>();
+        realtimeSlot->pedalboard = slot.pedalboard;
+        realtimeSlot->inputChannels = slot.inputChannels;
+        realtimeSlot->outputChannels = slot.outputChannels;
+        realtimeSlot->inputs[slot.inputChannels.size()] = nullptr;
+        realtimeSlot->outputs[slot.outputChannels.size()] = nullptr;
+        realtimeSlot->helperThread = RealtimeHelperThread::Create(RealtimeHelperThread::SlotHelperCpu(i + 1));
+        this->slots.push_back(std::move(realtimeSlot));
+    }
+    std::vector<bool> used(driverOutputChannels);
+    auto markUsed = [&used](const std::vector<int> &channels)
+    {
+        for (int channel : channels)
+        {
+            used[channel] = true;
+        }
+    };
+    markUsed(mainOutputChannels);
+    for (const auto &slot : slots)
+    {
+        markUsed(slot.outputChannels);
+    }
+    for (size_t i = 0; i < driverOutputChannels; ++i)
+    {
+        if (!used[i])
+        {
+            unusedOutputChannels.push_back((int)i);
+        }
+    }
+}
+
+RealtimePedalboardSlots::~RealtimePedalboardSlots()
+{
+    // stop the helpers before releasing the pedalboards.
+    for (auto &slot : slots)
+    {
+        slot->helperThread = nullptr;
+    }
+}
+
+float **RealtimePedalboardSlots::GetMainInputs(float *const *driverInputs)
+{
+    for (size_t i = 0; i < mainInputChannels.size(); ++i)
+    {
+        mainInputs[i] = driverInputs[mainInputChannels[i]];
+    }
+    return mainInputs.data();
+}
+
+float **RealtimePedalboardSlots::GetMainOutputs(float *const *driverOutputs)
+{
+    for (size_t i = 0; i < mainOutputChannels.size(); ++i)
+    {
+        mainOutputs[i] = driverOutputs[mainOutputChannels[i]];
+    }
+    return mainOutputs.data();
+}
+
+void RealtimePedalboardSlots::RunSlot(void *data, uint32_t frames)
+{
+    Slot *slot = (Slot *)data;
+    // no ring buffer writer: the slot's pedalboard has no UI, so patch messages and errors stay put.
+    slot->processed = slot->pedalboard->Run(slot->inputs, slot->outputs, frames, nullptr, nullptr);
+}
+
+void RealtimePedalboardSlots::Start(float *const *driverInputs, float *const *driverOutputs, uint32_t frames)
+{
+    for (int channel : unusedOutputChannels)
+    {
+        memset(driverOutputs[channel], 0, frames * sizeof(float));
+    }
+    for (auto &slot : slots)
+    {
+        for (size_t i = 0; i < slot->inputChannels.size(); ++i)
+        {
+            slot->inputs[i] = driverInputs[slot->inputChannels[i]];
+        }
+        for (size_t i = 0; i < slot->outputChannels.size(); ++i)
+        {
+            slot->outputs[i] = driverOutputs[slot->outputChannels[i]];
+        }
+        slot->helperThread->Start(&RealtimePedalboardSlots::RunSlot, slot.get(), frames);
+    }
+}
+
+void RealtimePedalboardSlots::Wait(uint32_t frames)
+{
+    constexpr float SMOOTHING = 1.0f / 32;
+    for (auto &slot : slots)
+    {
+        slot->helperThread->Wait();
+        if (!slot->processed)
+        {
+            for (size_t i = 0; i < slot->outputChannels.size(); ++i)
+            {
+                memset(slot->outputs[i], 0, frames * sizeof(float));
+            }
+        }
+        float runUs = slot->helperThread->GetLastJobNs() * 0.001f;
+        float v = slot->runUs.load(std::memory_order_relaxed);
+        slot->runUs.store(v + (runUs - v) * SMOOTHING, std::memory_order_relaxed);
+    }
+}
+
+std::vector<float> RealtimePedalboardSlots::GetSlotRunUs() const
+{
+    std::vector<float> result;
+    for (const auto &slot : slots)
+    {
+        result.push_back(slot->runUs.load(std::memory_order_relaxed));
+    }
+    return result;
+}
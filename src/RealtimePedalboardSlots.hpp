@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "RealtimeHelperThread.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pipedal
+{
+    class Lv2Pedalboard;
+
+    // An additional pedalboard, and the audio driver channels it reads and writes.
+    struct AudioPedalboardSlot
+    {
+        std::shared_ptr<Lv2Pedalboard> pedalboard;
+        std::vector<int> inputChannels;  // audio driver channel indices.
+        std::vector<int> outputChannels;
+    };
+
+    /**
+     * @brief The audio thread's view of the pedalboard slots.
+     *
+     * Each additional slot runs on its own RealtimeHelperThread, pinned to its own core. The audio thread
+     * reads and writes the device once per period, posts the slots to their helpers, runs the main pedalboard
+     * on the channels that remain, and then waits for the helpers.
+     *
+     * Built (and destroyed) off the audio thread, and handed over with a SetPedalboardSlots message.
+     */
+    class RealtimePedalboardSlots
+    {
+    public:
+        static constexpr size_t MAX_SLOT_CHANNELS = 2;
+
+        // Pedalboards must have been activated. Driver outputs that neither the main pedalboard nor a slot
+        // writes are silenced.
+        RealtimePedalboardSlots(
+            size_t driverOutputChannels,
+            const std::vector<int> &mainInputChannels, const std::vector<int> &mainOutputChannels,
+            const std::vector<AudioPedalboardSlot> &slots);
+        ~RealtimePedalboardSlots();
+        RealtimePedalboardSlots(const RealtimePedalboardSlots &) = delete;
+        RealtimePedalboardSlots &operator=(const RealtimePedalboardSlots &) = delete;
+
+        // Audio thread. The main pedalboard's buffers (nullptr-terminated), selected from the driver's buffers.
+        float **GetMainInputs(float *const *driverInputs);
+        float **GetMainOutputs(float *const *driverOutputs);
+
+        // Audio thread. Post each slot's pedalboard to its helper thread, and silence unused outputs.
+        void Start(float *const *driverInputs, float *const *driverOutputs, uint32_t frames);
+        // Audio thread. Wait for the helpers. Outputs of slots that couldn't run are silenced.
+        void Wait(uint32_t frames);
+
+        size_t GetSlotCount() const { return slots.size(); }
+        // Smoothed helper-thread run time of each slot, in microseconds. Any thread.
+        std::vector<float> GetSlotRunUs() const;
+
+    private:
+        struct Slot
+        {
+            std::shared_ptr<Lv2Pedalboard> pedalboard;
+            std::vector<int> inputChannels;
+            std::vector<int> outputChannels;
+            float *inputs[MAX_SLOT_CHANNELS + 1];
+            float *outputs[MAX_SLOT_CHANNELS + 1];
+            bool processed = false;
+            std::atomic<float> runUs{0};
+            RealtimeHelperThread::ptr helperThread;
+        };
+        static void RunSlot(void *data, uint32_t frames);
+
+        std::vector<int> mainInputChannels;
+        std::vector<int> mainOutputChannels;
+        std::vector<int> unusedOutputChannels;
+        std::vector<float *> mainInputs; // null-terminated.
+        std::vector<float *> mainOutputs;
+        std::vector<std::unique_ptr<Slot>> slots;
+    };
+}
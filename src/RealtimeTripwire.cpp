@@ -0,0 +1,474 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "RealtimeTripwire.hpp"
+
+#if ENABLE_RT_TRIPWIRE
+
+#include "IEffect.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+// glibc's implementations, which the interposed versions below forward to.
+extern "C"
+{
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t n, size_t size);
+    void *__libc_realloc(void *p, size_t size);
+    void __libc_free(void *p);
+    void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+    constexpr size_t MAX_SITES = 256;
+    constexpr int MAX_FRAMES = 24;
+    constexpr int SKIP_FRAMES = 2; // Trip(), and the interposed function.
+
+    struct Site
+    {
+        std::atomic<uint64_t> hash{0};
+        std::atomic<bool> ready{false};
+        std::atomic<uint64_t> count{0};
+        RealtimeTripwireEvent event = RealtimeTripwireEvent::Allocation;
+        uint64_t instanceId = 0;
+        int nFrames = 0;
+        void *frames[MAX_FRAMES] = {};
+        bool reported = false; // host thread only.
+    };
+
+    constexpr size_t MAX_LOCKS = 128;
+
+    struct LockEntry
+    {
+        std::atomic<uintptr_t> address{0};
+        std::atomic<bool> priorityInheriting{false};
+        std::atomic<uint64_t> realtimeLocks{0};
+        std::atomic<uint64_t> realtimeContentions{0};
+        std::atomic<uint64_t> hostLocks{0};
+    };
+
+    // all constant-initialized, since malloc can be called before static constructors have run.
+    Site sites[MAX_SITES];
+    std::atomic<uint64_t> counts[4];
+    std::atomic<uint64_t> lockContentions{0};
+    LockEntry locks[MAX_LOCKS];
+    std::atomic<size_t> nLocks{0};
+
+    thread_local int t_armed = 0;
+    thread_local bool t_inTripwire = false;
+    thread_local IEffect *t_currentEffect = nullptr;
+
+    using pthread_mutex_lock_fn = int (*)(pthread_mutex_t *);
+    using pthread_cond_wait_fn = int (*)(pthread_cond_t *, pthread_mutex_t *);
+    using read_fn = ssize_t (*)(int, void *, size_t);
+    using write_fn = ssize_t (*)(int, const void *, size_t);
+    using nanosleep_fn = int (*)(const struct timespec *, struct timespec *);
+    using usleep_fn = int (*)(useconds_t);
+
+    pthread_mutex_lock_fn real_pthread_mutex_lock = nullptr;
+    pthread_cond_wait_fn real_pthread_cond_wait = nullptr;
+    read_fn real_read = nullptr;
+    write_fn real_write = nullptr;
+    nanosleep_fn real_nanosleep = nullptr;
+    usleep_fn real_usleep = nullptr;
+
+    template <typename FN>
+    FN NextFunction(FN &fn, const char *name)
+    {
+        if (fn == nullptr)
+        {
+            fn = (FN)dlsym(RTLD_NEXT, name);
+        }
+        return fn;
+    }
+
+    inline bool IsArmed()
+    {
+        return t_armed != 0 && !t_inTripwire;
+    }
+
+    void Trip(RealtimeTripwireEvent event)
+    {
+        t_inTripwire = true;
+        counts[(int)event].fetch_add(1, std::memory_order_relaxed);
+
+        void *frames[MAX_FRAMES];
+        int nFrames = backtrace(frames, MAX_FRAMES);
+        uint64_t instanceId = t_currentEffect != nullptr ? t_currentEffect->GetInstanceId() : 0;
+
+        // FNV-1a over everything that identifies the site.
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](uint64_t value)
+        {
+            hash = (hash ^ value) * 1099511628211ull;
+        };
+        mix((uint64_t)event);
+        mix(instanceId);
+        for (int i = SKIP_FRAMES; i < nFrames; ++i)
+        {
+            mix((uint64_t)(uintptr_t)frames[i]);
+        }
+        if (hash == 0)
+        {
+            hash = 1;
+        }
+
+        for (size_t probe = 0; probe < MAX_SITES; ++probe)
+        {
+            Site &site = sites[(hash + probe) % MAX_SITES];
+            uint64_t siteHash = site.hash.load(std::memory_order_acquire);
+            if (siteHash == 0 && site.hash.compare_exchange_strong(siteHash, hash))
+            {
+                site.event = event;
+                site.instanceId = instanceId;
+                site.nFrames = nFrames;
+                for (int i = 0; i < nFrames; ++i)
+                {
+                    site.frames[i] = frames[i];
+                }
+                site.count.store(1, std::memory_order_relaxed);
+                site.ready.store(true, std::memory_order_release);
+                break;
+            }
+            if (siteHash == hash)
+            {
+                site.count.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+        // (if the table is full, the call is counted but not recorded.)
+        t_inTripwire = false;
+    }
+
+    inline size_t LockHash(pthread_mutex_t *mutex)
+    {
+        return (size_t)(((uintptr_t)mutex >> 3) * 0x9E3779B97F4A7C15ull >> 32);
+    }
+
+    LockEntry *FindLock(pthread_mutex_t *mutex, bool add)
+    {
+        uintptr_t address = (uintptr_t)mutex;
+        size_t hash = LockHash(mutex);
+        for (size_t probe = 0; probe < MAX_LOCKS; ++probe)
+        {
+            LockEntry &entry = locks[(hash + probe) % MAX_LOCKS];
+            uintptr_t entryAddress = entry.address.load(std::memory_order_acquire);
+            if (entryAddress == address)
+            {
+                return &entry;
+            }
+            if (entryAddress == 0)
+            {
+                if (!add)
+                {
+                    return nullptr;
+                }
+                if (entry.address.compare_exchange_strong(entryAddress, address))
+                {
+                    nLocks.fetch_add(1, std::memory_order_release);
+                    return &entry;
+                }
+                if (entryAddress == address)
+                {
+                    return &entry;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    inline bool IsPriorityInheriting(pthread_mutex_t *mutex)
+    {
+        // glibc internals: PTHREAD_MUTEX_PRIO_INHERIT_NP (not exported by pthread.h) is a flag in the mutex kind.
+        constexpr int PRIO_INHERIT_KIND_FLAG = 32;
+        return (mutex->__data.__kind & PRIO_INHERIT_KIND_FLAG) != 0;
+    }
+
+    __attribute__((constructor)) void InitRealtimeTripwire()
+    {
+        NextFunction(real_pthread_mutex_lock, "pthread_mutex_lock");
+        NextFunction(real_pthread_cond_wait, "pthread_cond_wait");
+        NextFunction(real_read, "read");
+        NextFunction(real_write, "write");
+        NextFunction(real_nanosleep, "nanosleep");
+        NextFunction(real_usleep, "usleep");
+
+        // the first call to backtrace() loads libgcc_s, which must not happen on the audio thread.
+        void *frames[1];
+        backtrace(frames, 1);
+    }
+}
+
+extern "C"
+{
+    void *malloc(size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        return __libc_malloc(size);
+    }
+    void *calloc(size_t n, size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        return __libc_calloc(n, size);
+    }
+    void *realloc(void *p, size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        return __libc_realloc(p, size);
+    }
+    void free(void *p) noexcept
+    {
+        if (p != nullptr && IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Free);
+        }
+        __libc_free(p);
+    }
+    void *memalign(size_t alignment, size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        return __libc_memalign(alignment, size);
+    }
+    void *aligned_alloc(size_t alignment, size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        return __libc_memalign(alignment, size);
+    }
+    int posix_memalign(void **result, size_t alignment, size_t size) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Allocation);
+        }
+        if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        {
+            return EINVAL;
+        }
+        void *p = __libc_memalign(alignment, size);
+        if (p == nullptr)
+        {
+            return ENOMEM;
+        }
+        *result = p;
+        return 0;
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Lock);
+
+            LockEntry *entry = FindLock(mutex, true);
+            if (entry)
+            {
+                entry->priorityInheriting.store(IsPriorityInheriting(mutex), std::memory_order_relaxed);
+                entry->realtimeLocks.fetch_add(1, std::memory_order_relaxed);
+            }
+            int rc = pthread_mutex_trylock(mutex);
+            if (rc != EBUSY)
+            {
+                return rc;
+            }
+            lockContentions.fetch_add(1, std::memory_order_relaxed);
+            if (entry)
+            {
+                entry->realtimeContentions.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        else if (nLocks.load(std::memory_order_acquire) != 0 && !t_inTripwire)
+        {
+            LockEntry *entry = FindLock(mutex, false);
+            if (entry)
+            {
+                entry->hostLocks.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        return NextFunction(real_pthread_mutex_lock, "pthread_mutex_lock")(mutex);
+    }
+    int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Lock);
+        }
+        return NextFunction(real_pthread_cond_wait, "pthread_cond_wait")(cond, mutex);
+    }
+
+    ssize_t read(int fd, void *buffer, size_t size)
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Syscall);
+        }
+        return NextFunction(real_read, "read")(fd, buffer, size);
+    }
+    ssize_t write(int fd, const void *buffer, size_t size)
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Syscall);
+        }
+        return NextFunction(real_write, "write")(fd, buffer, size);
+    }
+    int nanosleep(const struct timespec *duration, struct timespec *remaining)
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Syscall);
+        }
+        return NextFunction(real_nanosleep, "nanosleep")(duration, remaining);
+    }
+    int usleep(useconds_t us)
+    {
+        if (IsArmed())
+        {
+            Trip(RealtimeTripwireEvent::Syscall);
+        }
+        return NextFunction(real_usleep, "usleep")(us);
+    }
+}
+
+RealtimeTripwire::ThreadScope::ThreadScope()
+{
+    ++t_armed;
+}
+RealtimeTripwire::ThreadScope::~ThreadScope()
+{
+    --t_armed;
+}
+
+RealtimeTripwire::EffectScope::EffectScope(IEffect *effect)
+    : previousEffect(t_currentEffect)
+{
+    t_currentEffect = effect;
+}
+RealtimeTripwire::EffectScope::~EffectScope()
+{
+    t_currentEffect = previousEffect;
+}
+
+RealtimeTripwireCounts RealtimeTripwire::GetCounts()
+{
+    RealtimeTripwireCounts result;
+    result.allocations = counts[(int)RealtimeTripwireEvent::Allocation].load(std::memory_order_relaxed);
+    result.frees = counts[(int)RealtimeTripwireEvent::Free].load(std::memory_order_relaxed);
+    result.locks = counts[(int)RealtimeTripwireEvent::Lock].load(std::memory_order_relaxed);
+    result.syscalls = counts[(int)RealtimeTripwireEvent::Syscall].load(std::memory_order_relaxed);
+    result.lockContentions = lockContentions.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::vector<RealtimeTripwireLock> RealtimeTripwire::GetLocks()
+{
+    std::vector<RealtimeTripwireLock> result;
+    for (LockEntry &entry : locks)
+    {
+        uintptr_t address = entry.address.load(std::memory_order_acquire);
+        if (address == 0)
+        {
+            continue;
+        }
+        RealtimeTripwireLock lock;
+        lock.address = address;
+        lock.priorityInheriting = entry.priorityInheriting.load(std::memory_order_relaxed);
+        lock.realtimeLocks = entry.realtimeLocks.load(std::memory_order_relaxed);
+        lock.realtimeContentions = entry.realtimeContentions.load(std::memory_order_relaxed);
+        lock.hostLocks = entry.hostLocks.load(std::memory_order_relaxed);
+        result.push_back(lock);
+    }
+    return result;
+}
+
+std::vector<RealtimeTripwireSite> RealtimeTripwire::TakeNewSites()
+{
+    std::vector<RealtimeTripwireSite> result;
+    for (Site &site : sites)
+    {
+        if (site.reported || !site.ready.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+        site.reported = true;
+
+        RealtimeTripwireSite newSite;
+        newSite.event = site.event;
+        newSite.instanceId = site.instanceId;
+        newSite.count = site.count.load(std::memory_order_relaxed);
+        int nFrames = site.nFrames - SKIP_FRAMES;
+        if (nFrames > 0)
+        {
+            char **symbols = backtrace_symbols(site.frames + SKIP_FRAMES, nFrames);
+            if (symbols)
+            {
+                for (int i = 0; i < nFrames; ++i)
+                {
+                    newSite.backtrace.push_back(symbols[i]);
+                }
+                ::free(symbols);
+            }
+        }
+        result.push_back(std::move(newSite));
+    }
+    return result;
+}
+
+#endif
+
+const char *pipedal::RealtimeTripwireEventName(RealtimeTripwireEvent event)
+{
+    switch (event)
+    {
+    case RealtimeTripwireEvent::Allocation:
+        return "allocation";
+    case RealtimeTripwireEvent::Free:
+        return "free";
+    case RealtimeTripwireEvent::Lock:
+        return "lock";
+    case RealtimeTripwireEvent::Syscall:
+        return "syscall";
+    }
+    return "unknown";
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Set to 1 (in CMakeLists.txt) to build the realtime tripwire into pipedald. Debug/diagnostic use only.
+#ifndef ENABLE_RT_TRIPWIRE
+#define ENABLE_RT_TRIPWIRE 0
+#endif
+
+namespace pipedal
+{
+    class IEffect;
+
+    enum class RealtimeTripwireEvent
+    {
+        Allocation, // malloc, calloc, realloc, posix_memalign, aligned_alloc (and therefore operator new).
+        Free,
+        Lock,       // pthread_mutex_lock, pthread_cond_wait (and therefore std::mutex, std::condition_variable).
+        Syscall,    // read, write, nanosleep, usleep.
+    };
+
+    const char *RealtimeTripwireEventName(RealtimeTripwireEvent event);
+
+    struct RealtimeTripwireCounts
+    {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t locks = 0;
+        uint64_t syscalls = 0;
+        uint64_t lockContentions = 0; // locks on a realtime thread that found the mutex already held.
+    };
+
+    // A mutex that has been locked on a realtime thread.
+    struct RealtimeTripwireLock
+    {
+        uintptr_t address = 0;
+        bool priorityInheriting = false;
+        uint64_t realtimeLocks = 0;
+        uint64_t realtimeContentions = 0; // realtime locks that had to wait for another thread.
+        uint64_t hostLocks = 0;           // locks taken by threads that are not realtime.
+    };
+
+    // A distinct call site (event, plugin, backtrace) that has been seen on a realtime thread.
+    struct RealtimeTripwireSite
+    {
+        RealtimeTripwireEvent event = RealtimeTripwireEvent::Allocation;
+        uint64_t instanceId = 0; // the effect that was running at the time, or 0 if the call was made by host code.
+        uint64_t count = 0;
+        std::vector<std::string> backtrace;
+    };
+
+    /**
+     * @brief Flags allocations, locks and blocking syscalls made on the audio thread.
+     *
+     * When built with ENABLE_RT_TRIPWIRE, malloc and friends, pthread_mutex_lock, and a handful of
+     * syscalls are interposed. Calls made while a ThreadScope is active on the calling thread
+     * (AudioHostImpl::OnProcess, and the realtime helper thread's jobs) are counted, and the first
+     * occurrence of each distinct call site is recorded with a backtrace and the instance id of the
+     * effect that was running.
+     *
+     * Mutexes locked on a realtime thread are also tracked individually, so that a realtime lock on a
+     * mutex that host threads also take, and that doesn't inherit priority, can be identified.
+     *
+     * When ENABLE_RT_TRIPWIRE is 0, the scopes compile away, and the counts are always zero.
+     */
+    class RealtimeTripwire
+    {
+    public:
+        static constexpr bool Enabled = ENABLE_RT_TRIPWIRE != 0;
+
+#if ENABLE_RT_TRIPWIRE
+        // Arms the tripwire for the current thread.
+        class ThreadScope
+        {
+        public:
+            ThreadScope();
+            ~ThreadScope();
+        };
+        // Attributes calls to an effect.
+        class EffectScope
+        {
+        public:
+            EffectScope(IEffect *effect);
+            ~EffectScope();
+
+        private:
+            IEffect *previousEffect;
+        };
+
+        static RealtimeTripwireCounts GetCounts();
+        // Host thread only. Returns sites that haven't been returned by a previous call.
+        static std::vector<RealtimeTripwireSite> TakeNewSites();
+        // Mutexes that have been locked on a realtime thread, and how often other threads hold them.
+        static std::vector<RealtimeTripwireLock> GetLocks();
+#else
+        class ThreadScope
+        {
+        };
+        class EffectScope
+        {
+        public:
+            EffectScope(IEffect *) {}
+        };
+
+        static RealtimeTripwireCounts GetCounts() { return RealtimeTripwireCounts(); }
+        static std::vector<RealtimeTripwireSite> TakeNewSites() { return std::vector<RealtimeTripwireSite>(); }
+        static std::vector<RealtimeTripwireLock> GetLocks() { return std::vector<RealtimeTripwireLock>(); }
+#endif
+    };
+}
@@ -0,0 +1,262 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "RealtimeWatchdog.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+using namespace pipedal;
+
+std::atomic<bool> RealtimeWatchdog::enabled{false};
+RealtimeWatchdog::Slot RealtimeWatchdog::slots[RealtimeWatchdog::MAX_THREADS];
+constinit thread_local RealtimeWatchdog::Slot *RealtimeWatchdog::currentSlot = nullptr;
+RealtimeWatchdog::SkippedEffect RealtimeWatchdog::skippedEffects[RealtimeWatchdog::MAX_SKIPPED_EFFECTS];
+std::atomic<size_t> RealtimeWatchdog::skippedCount{0};
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    std::mutex monitorMutex; // Start() and Stop().
+    std::condition_variable monitorCv;
+    bool stopMonitor = false;
+    std::thread monitorThread;
+    clock::duration timeout;
+    RealtimeWatchdog::HungCallback onHung;
+
+    std::mutex skipMutex; // writes to the skip list.
+
+    // Releases the calling thread's slot when the thread exits.
+    struct SlotRelease
+    {
+        std::atomic<bool> *active = nullptr;
+        std::atomic<bool> *inUse = nullptr;
+        ~SlotRelease()
+        {
+            if (inUse)
+            {
+                active->store(false, std::memory_order_release);
+                inUse->store(false, std::memory_order_release);
+            }
+        }
+    };
+    thread_local SlotRelease slotRelease;
+}
+
+void RealtimeWatchdog::AttachThread(const char *threadName)
+{
+    Slot *slot = currentSlot;
+    if (!slot)
+    {
+        for (size_t i = 0; i < MAX_THREADS; ++i)
+        {
+            bool expected = false;
+            if (slots[i].inUse.compare_exchange_strong(expected, true))
+            {
+                slot = &slots[i];
+                break;
+            }
+        }
+        if (!slot)
+        {
+            return; // more realtime threads than slots. (Not expected.)
+        }
+        slot->effect.store(nullptr);
+        slot->inPeriod.store(false);
+        currentSlot = slot;
+        slotRelease.active = &slot->active;
+        slotRelease.inUse = &slot->inUse;
+    }
+    slot->active.store(false, std::memory_order_release);
+    strncpy(slot->threadName, threadName, sizeof(slot->threadName) - 1);
+    slot->active.store(true, std::memory_order_release);
+}
+
+bool RealtimeWatchdog::IsSkippedSlow(const void *effect, int64_t instanceId, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (skippedEffects[i].effect.load(std::memory_order_acquire) == effect &&
+            skippedEffects[i].instanceId.load(std::memory_order_relaxed) == instanceId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RealtimeWatchdog::ClearSkipped(int64_t instanceId)
+{
+    std::lock_guard<std::mutex> lock(skipMutex);
+    size_t n = skippedCount.load();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (skippedEffects[i].instanceId.load() == instanceId)
+        {
+            skippedEffects[i].effect.store(nullptr, std::memory_order_release);
+        }
+    }
+}
+
+bool RealtimeWatchdog::AddSkipped(const void *effect, int64_t instanceId)
+{
+    std::lock_guard<std::mutex> lock(skipMutex);
+    size_t n = skippedCount.load();
+    size_t index = n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (skippedEffects[i].effect.load() == nullptr)
+        {
+            index = i;
+            break;
+        }
+    }
+    if (index == MAX_SKIPPED_EFFECTS)
+    {
+        return false;
+    }
+    skippedEffects[index].instanceId.store(instanceId, std::memory_order_relaxed);
+    skippedEffects[index].effect.store(effect, std::memory_order_release);
+    if (index == n)
+    {
+        skippedCount.store(n + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+void RealtimeWatchdog::Start(double timeoutSeconds, HungCallback &&callback)
+{
+    Stop();
+    std::lock_guard<std::mutex> lock(monitorMutex);
+    timeout = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeoutSeconds));
+    onHung = std::move(callback);
+    stopMonitor = false;
+    enabled = true;
+    monitorThread = std::thread([]()
+                                { MonitorThreadProc(); });
+}
+
+void RealtimeWatchdog::Stop()
+{
+    std::unique_lock<std::mutex> lock(monitorMutex);
+    if (!monitorThread.joinable())
+    {
+        return;
+    }
+    stopMonitor = true;
+    monitorCv.notify_all();
+    lock.unlock();
+    monitorThread.join();
+    lock.lock();
+    enabled = false;
+    onHung = nullptr;
+}
+
+void RealtimeWatchdog::MonitorThreadProc()
+{
+    SetThreadName("rtWatchdog");
+
+    struct Observation
+    {
+        const void *effect = nullptr;
+        uint64_t entries = 0;
+        clock::time_point effectSince;
+        bool effectReported = false;
+
+        uint64_t heartbeat = 0;
+        clock::time_point heartbeatSince;
+        bool stallReported = false;
+    };
+    Observation observations[MAX_THREADS];
+
+    clock::duration tick = std::clamp<clock::duration>(timeout / 4, std::chrono::milliseconds(5), std::chrono::milliseconds(100));
+
+    std::unique_lock<std::mutex> lock(monitorMutex);
+    while (!monitorCv.wait_for(lock, tick, []()
+                               { return stopMonitor; }))
+    {
+        auto now = clock::now();
+        for (size_t i = 0; i < MAX_THREADS; ++i)
+        {
+            Slot &slot = slots[i];
+            Observation &observation = observations[i];
+            if (!slot.active.load(std::memory_order_acquire))
+            {
+                observation = Observation();
+                continue;
+            }
+            uint64_t entries = slot.entries.load(std::memory_order_acquire);
+            const void *effect = slot.effect.load(std::memory_order_acquire);
+
+            // an effect that has been current, without a new entry, for longer than the timeout.
+            if (effect == nullptr || effect != observation.effect || entries != observation.entries)
+            {
+                observation.effect = effect;
+                observation.entries = entries;
+                observation.effectSince = now;
+                observation.effectReported = false;
+            }
+            else if (!observation.effectReported && now - observation.effectSince >= timeout)
+            {
+                observation.effectReported = true;
+                HungEffect hungEffect;
+                hungEffect.instanceId = slot.instanceId.load(std::memory_order_relaxed);
+                hungEffect.threadName = slot.threadName;
+                hungEffect.seconds = std::chrono::duration<double>(now - observation.effectSince).count();
+                if (!AddSkipped(effect, hungEffect.instanceId))
+                {
+                    Lv2Log::error("RealtimeWatchdog: too many hung effects. The effect can't be skipped.");
+                }
+                if (onHung)
+                {
+                    onHung(hungEffect);
+                }
+            }
+
+            // a period that hasn't completed, outside of plugin code (the audio thread only).
+            uint64_t heartbeat = slot.heartbeat.load(std::memory_order_relaxed);
+            bool inPeriod = slot.inPeriod.load(std::memory_order_relaxed);
+            if (heartbeat != observation.heartbeat || !inPeriod || effect != nullptr)
+            {
+                observation.heartbeat = heartbeat;
+                observation.heartbeatSince = now;
+                observation.stallReported = false;
+            }
+            else if (!observation.stallReported && now - observation.heartbeatSince >= timeout)
+            {
+                observation.stallReported = true;
+                HungEffect hungEffect;
+                hungEffect.threadName = slot.threadName;
+                hungEffect.seconds = std::chrono::duration<double>(now - observation.heartbeatSince).count();
+                if (onHung)
+                {
+                    onHung(hungEffect);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,164 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace pipedal
+{
+    /**
+     * @brief Detects plugins whose run() hangs or runs away on a realtime thread.
+     *
+     * Realtime threads that run plugins attach themselves to a slot, and publish the effect they are currently
+     * running (EffectScope) with a few relaxed stores; the audio thread also publishes a per-period heartbeat.
+     * A monitor thread samples the slots. If the same effect entry is still current after the timeout, the
+     * effect is added to the skip list, and the onHung callback is called (on the monitor thread).
+     *
+     * Skipped effects are not run again: ExecutionPlan copies their inputs to their outputs instead. An effect
+     * that never returns can't be recovered without killing the audio thread, so the skip takes effect if and
+     * when run() eventually returns.
+     */
+    class RealtimeWatchdog
+    {
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<bool> inUse{false};  // claimed by a thread.
+            std::atomic<bool> active{false}; // threadName is valid.
+            std::atomic<const void *> effect{nullptr};
+            std::atomic<int64_t> instanceId{-1};
+            std::atomic<uint64_t> entries{0};
+            std::atomic<uint64_t> heartbeat{0};
+            std::atomic<bool> inPeriod{false};
+            char threadName[16] = {};
+        };
+        struct SkippedEffect
+        {
+            std::atomic<const void *> effect{nullptr};
+            std::atomic<int64_t> instanceId{-1};
+        };
+
+    public:
+        static constexpr size_t MAX_THREADS = 8;
+        static constexpr size_t MAX_SKIPPED_EFFECTS = 16;
+
+        struct HungEffect
+        {
+            int64_t instanceId = -1; // -1 if the audio thread stalled outside of plugin code.
+            std::string threadName;
+            double seconds = 0;      // time spent in the effect when it was detected.
+        };
+        using HungCallback = std::function<void(const HungEffect &hungEffect)>;
+
+        // Host thread. onHung is called on the monitor thread, and must not call Start() or Stop().
+        static void Start(double timeoutSeconds, HungCallback &&onHung);
+        static void Stop();
+        static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+        // Realtime threads. Claims a slot for the calling thread, released when the thread exits. Calls
+        // on threads without a slot (and all calls while the watchdog isn't running) are no-ops.
+        static void AttachThread(const char *threadName);
+
+        // Audio thread, at the start and end of each period.
+        static void BeginPeriod()
+        {
+            Slot *slot = currentSlot;
+            if (slot)
+            {
+                slot->heartbeat.store(slot->heartbeat.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                slot->inPeriod.store(true, std::memory_order_relaxed);
+            }
+        }
+        static void EndPeriod()
+        {
+            Slot *slot = currentSlot;
+            if (slot)
+            {
+                slot->inPeriod.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        class PeriodScope
+        {
+        public:
+            PeriodScope() { BeginPeriod(); }
+            ~PeriodScope() { EndPeriod(); }
+            PeriodScope(const PeriodScope &) = delete;
+            PeriodScope &operator=(const PeriodScope &) = delete;
+        };
+
+        // Publishes the effect being run by the calling thread.
+        class EffectScope
+        {
+        public:
+            EffectScope(const void *effect, int64_t instanceId)
+                : slot(currentSlot)
+            {
+                if (slot)
+                {
+                    slot->instanceId.store(instanceId, std::memory_order_relaxed);
+                    slot->effect.store(effect, std::memory_order_relaxed);
+                    slot->entries.store(slot->entries.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                }
+            }
+            ~EffectScope()
+            {
+                if (slot)
+                {
+                    slot->effect.store(nullptr, std::memory_order_release);
+                }
+            }
+            EffectScope(const EffectScope &) = delete;
+            EffectScope &operator=(const EffectScope &) = delete;
+
+        private:
+            Slot *slot;
+        };
+
+        // Realtime-safe. True if the effect has been marked as hung.
+        static bool IsSkipped(const void *effect, int64_t instanceId)
+        {
+            size_t n = skippedCount.load(std::memory_order_acquire);
+            if (n == 0)
+            {
+                return false;
+            }
+            return IsSkippedSlow(effect, instanceId, n);
+        }
+        // Host thread. Lets an effect run again (e.g. after the user has re-enabled it).
+        static void ClearSkipped(int64_t instanceId);
+
+    private:
+        static bool IsSkippedSlow(const void *effect, int64_t instanceId, size_t n);
+        static bool AddSkipped(const void *effect, int64_t instanceId);
+        static void MonitorThreadProc();
+
+        static std::atomic<bool> enabled;
+        static Slot slots[MAX_THREADS];
+        static constinit thread_local Slot *currentSlot;
+        static SkippedEffect skippedEffects[MAX_SKIPPED_EFFECTS];
+        static std::atomic<size_t> skippedCount;
+    };
+}
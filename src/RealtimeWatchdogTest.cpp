@@ -0,0 +1,104 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "RealtimeWatchdog.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+
+TEST_CASE("RealtimeWatchdog test", "[realtime_watchdog][Build][Dev]")
+{
+    std::mutex mutex;
+    std::vector<RealtimeWatchdog::HungEffect> hungEffects;
+    RealtimeWatchdog::Start(0.05, [&](const RealtimeWatchdog::HungEffect &hungEffect)
+                            {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                hungEffects.push_back(hungEffect); });
+
+    int fastEffect = 0, slowEffect = 0;
+
+    std::thread audioThread([&]()
+                            {
+        RealtimeWatchdog::AttachThread("testAudio");
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        // well-behaved periods.
+        while (std::chrono::steady_clock::now() < end)
+        {
+            RealtimeWatchdog::BeginPeriod();
+            {
+                RealtimeWatchdog::EffectScope scope(&fastEffect, 1);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            RealtimeWatchdog::EndPeriod();
+        }
+        REQUIRE(!RealtimeWatchdog::IsSkipped(&fastEffect, 1));
+
+        // a runaway effect.
+        RealtimeWatchdog::BeginPeriod();
+        if (!RealtimeWatchdog::IsSkipped(&slowEffect, 2))
+        {
+            RealtimeWatchdog::EffectScope scope(&slowEffect, 2);
+            std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        }
+        RealtimeWatchdog::EndPeriod();
+        REQUIRE(RealtimeWatchdog::IsSkipped(&slowEffect, 2));
+        REQUIRE(!RealtimeWatchdog::IsSkipped(&slowEffect, 3)); // same address, different effect.
+        REQUIRE(!RealtimeWatchdog::IsSkipped(&fastEffect, 1)); });
+    audioThread.join();
+
+    RealtimeWatchdog::Stop();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        REQUIRE(hungEffects.size() == 1);
+        REQUIRE(hungEffects[0].instanceId == 2);
+        REQUIRE(hungEffects[0].threadName == "testAudio");
+        REQUIRE(hungEffects[0].seconds >= 0.05);
+    }
+
+    RealtimeWatchdog::ClearSkipped(2);
+    REQUIRE(!RealtimeWatchdog::IsSkipped(&slowEffect, 2));
+}
+
+TEST_CASE("RealtimeWatchdog stall test", "[realtime_watchdog][Build][Dev]")
+{
+    std::atomic<int> stalls{0};
+    RealtimeWatchdog::Start(0.05, [&](const RealtimeWatchdog::HungEffect &hungEffect)
+                            {
+                                if (hungEffect.instanceId == -1)
+                                {
+                                    ++stalls;
+                                } });
+    std::thread audioThread([&]()
+                            {
+        RealtimeWatchdog::AttachThread("testAudio");
+        // a period that doesn't complete, outside of any effect.
+        RealtimeWatchdog::BeginPeriod();
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        RealtimeWatchdog::EndPeriod(); });
+    audioThread.join();
+    RealtimeWatchdog::Stop();
+    REQUIRE(stalls == 1);
+}
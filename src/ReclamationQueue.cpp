@@ -0,0 +1,98 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "ReclamationQueue.hpp"
+#include "SchedulerPriority.hpp"
+#include "util.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+
+using namespace pipedal;
+
+ReclamationQueue::ReclamationQueue()
+{
+    thread = std::jthread(
+        [this](std::stop_token stopToken)
+        {
+            SetThreadName("reclaim");
+            SetThreadPriority(SchedulerPriority::Background);
+            ThreadProc(stopToken);
+        });
+}
+
+ReclamationQueue::~ReclamationQueue()
+{
+    Drain();
+    thread.request_stop();
+    thread.join();
+}
+
+void ReclamationQueue::Retire(Action &&action)
+{
+    {
+        std::lock_guard lock(mutex);
+        pending.push_back(std::move(action));
+        ++retiredCount;
+    }
+    cvWork.notify_one();
+}
+
+void ReclamationQueue::Drain()
+{
+    std::unique_lock lock(mutex);
+    uint64_t target = retiredCount;
+    cvDone.wait(lock, [this, target]()
+                { return completedCount >= target; });
+}
+
+uint64_t ReclamationQueue::GetRetiredCount() const
+{
+    std::lock_guard lock(mutex);
+    return retiredCount;
+}
+
+void ReclamationQueue::ThreadProc(std::stop_token stopToken)
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        cvWork.wait(lock, stopToken, [this]()
+                    { return !pending.empty(); });
+        if (pending.empty())
+        {
+            return; // stop requested.
+        }
+        Action action = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        try
+        {
+            action();
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("Failed to release an object. " << e.what()));
+        }
+        action = nullptr; // (captures are destroyed here, outside the lock.)
+        lock.lock();
+        ++completedCount;
+        cvDone.notify_all();
+    }
+}
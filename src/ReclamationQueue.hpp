@@ -0,0 +1,90 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace pipedal
+{
+    /**
+     * @brief Destroys retired objects on a dedicated background thread.
+     *
+     * Tearing down a pedalboard can take a long time (plugins free model weights, and join their
+     * worker threads). Objects released by the audio thread are handed to the queue, so that
+     * the thread that services realtime notifications isn't held up by their destructors.
+     */
+    class ReclamationQueue
+    {
+    public:
+        using Action = std::function<void()>;
+
+        ReclamationQueue();
+        // Destroys anything still pending.
+        ~ReclamationQueue();
+
+        ReclamationQueue(const ReclamationQueue &) = delete;
+        ReclamationQueue &operator=(const ReclamationQueue &) = delete;
+
+        // Any thread. Runs action on the reclamation thread.
+        void Retire(Action &&action);
+
+        template <typename T>
+        void Retire(std::shared_ptr<T> &&object)
+        {
+            if (object)
+            {
+                Retire(Action([object = std::move(object)]() mutable
+                              { object = nullptr; }));
+            }
+        }
+        template <typename T>
+        void Delete(T *object)
+        {
+            if (object)
+            {
+                Retire(Action([object]()
+                              { delete object; }));
+            }
+        }
+
+        // Waits until everything retired before the call has been destroyed.
+        void Drain();
+
+        uint64_t GetRetiredCount() const;
+
+    private:
+        void ThreadProc(std::stop_token stopToken);
+
+        mutable std::mutex mutex;
+        std::condition_variable_any cvWork;
+        std::condition_variable cvDone;
+        std::deque<Action> pending;
+        uint64_t retiredCount = 0;
+        uint64_t completedCount = 0;
+        std::jthread thread;
+    };
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ReclamationQueue.hpp"
+#include <atomic>
+#include <chrono>
+
+using namespace pipedal;
+
+namespace
+{
+    class SlowToDestroy
+    {
+    public:
+        SlowToDestroy(std::atomic<int> *destroyed, std::thread::id *destroyedOn)
+            : destroyed(destroyed), destroyedOn(destroyedOn)
+        {
+        }
+        ~SlowToDestroy()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            *destroyedOn = std::this_thread::get_id();
+            ++(*destroyed);
+        }
+
+    private:
+        std::atomic<int> *destroyed;
+        std::thread::id *destroyedOn;
+    };
+}
+
+TEST_CASE("ReclamationQueue", "[reclamation_queue][Build][Dev]")
+{
+    std::atomic<int> destroyed{0};
+    std::thread::id destroyedOn;
+    {
+        ReclamationQueue queue;
+
+        auto start = std::chrono::steady_clock::now();
+        queue.Retire(std::make_shared<SlowToDestroy>(&destroyed, &destroyedOn));
+        queue.Delete(new SlowToDestroy(&destroyed, &destroyedOn));
+        queue.Retire(std::shared_ptr<SlowToDestroy>()); // ignored.
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        // the caller doesn't wait for destructors.
+        REQUIRE(elapsed < std::chrono::milliseconds(20));
+        REQUIRE(queue.GetRetiredCount() == 2);
+
+        queue.Drain();
+        REQUIRE(destroyed == 2);
+        REQUIRE(destroyedOn != std::this_thread::get_id());
+
+        // an object that is still referenced elsewhere survives retirement.
+        auto shared = std::make_shared<SlowToDestroy>(&destroyed, &destroyedOn);
+        auto copy = shared;
+        queue.Retire(std::move(copy));
+        queue.Drain();
+        REQUIRE(destroyed == 2);
+        shared = nullptr;
+        REQUIRE(destroyed == 3);
+
+        // pending objects are destroyed by the destructor.
+        queue.Delete(new SlowToDestroy(&destroyed, &destroyedOn));
+    }
+    REQUIRE(destroyed == 4);
+}
@@ -23,6 +23,11 @@
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <chrono>
+#include "Futex.hpp"
 
 #ifndef NO_MLOCK
 #include <sys/mman.h>
@@ -37,6 +42,42 @@ namespace pipedal
         TimedOut,
         Closed
     };
+
+    // Up to two contiguous spans of ring buffer memory, reserved by RingBuffer::beginWrite().
+    class RingBufferWriteSpans
+    {
+    public:
+        uint8_t *data1 = nullptr;
+        size_t size1 = 0;
+        uint8_t *data2 = nullptr;
+        size_t size2 = 0;
+        // Reservation sequence number (MULTI_WRITER ring buffers only).
+        uint64_t sequence = 0;
+
+        explicit operator bool() const { return data1 != nullptr; }
+        size_t size() const { return size1 + size2; }
+
+        // Copy data into the reserved spans at the given offset, splitting at the wrap point if neccessary.
+        void write(size_t offset, const void *data, size_t bytes)
+        {
+            const uint8_t *p = (const uint8_t *)data;
+            if (offset < size1)
+            {
+                size_t n = size1 - offset;
+                if (n > bytes)
+                    n = bytes;
+                memcpy(data1 + offset, p, n);
+                p += n;
+                bytes -= n;
+                offset = size1;
+            }
+            if (bytes != 0)
+            {
+                memcpy(data2 + (offset - size1), p, bytes);
+            }
+        }
+    };
+
     template <bool MULTI_WRITER = false, bool SEMAPHORE_READER = false>
     class RingBuffer
     {
@@ -44,13 +85,84 @@ namespace pipedal
         bool mlocked = false;
         size_t ringBufferSize;
         size_t ringBufferMask;
-        int64_t readPosition = 0;  // volatile = ordering barrier wrt writePosition
-        int64_t writePosition = 0; // volatile = ordering barrier wrt/ readPosition
-        std::mutex mutex;
-        std::mutex writeMutex;
+        std::atomic<int64_t> readPosition = 0;
+        std::atomic<int64_t> writePosition = 0;
+        // MULTI_WRITER only: writers reserve space by advancing reserveCount with a CAS, and publish
+        // in reservation order by advancing commitCount. Both are unmasked, so they can't ABA.
+        alignas(64) std::atomic<uint64_t> reserveCount = 0;
+        alignas(64) std::atomic<uint64_t> commitCount = 0;
+        // SEMAPHORE_READER only: bumped by every write (and by close()), so that the reader can futex-wait
+        // on it. Writers only make a syscall if the reader is actually waiting, and never take a lock.
+        // Ring buffers that are drained by the same reader can share one (see shareReaderWakeup()).
+        struct ReaderWakeup
+        {
+            alignas(64) std::atomic<uint32_t> writeSequence = 0;
+            std::atomic<bool> readerWaiting = false;
+        };
+        ReaderWakeup ownReaderWakeup;
+        ReaderWakeup *readerWakeup = &ownReaderWakeup;
+
+        // writes that failed because the ring buffer was full.
+        alignas(64) std::atomic<uint64_t> overflowCount = 0;
+
+        std::atomic<bool> is_open = true;
 
-        bool is_open = true;
-        std::condition_variable cvRead;
+        void wakeReader()
+        {
+            readerWakeup->writeSequence.fetch_add(1, std::memory_order_seq_cst);
+            if (readerWakeup->readerWaiting.load(std::memory_order_seq_cst))
+            {
+                futex_wake(&readerWakeup->writeSequence);
+            }
+        }
+
+        // Waits until ready() returns true, the ring buffer is closed, or the deadline (if any) passes.
+        template <typename READY>
+        RingBufferStatus readerWait(READY &&ready, const std::chrono::steady_clock::time_point *deadline)
+        {
+            std::atomic<uint32_t> &writeSequence = readerWakeup->writeSequence;
+            std::atomic<bool> &readerWaiting = readerWakeup->readerWaiting;
+            while (true)
+            {
+                uint32_t sequence = writeSequence.load(std::memory_order_seq_cst);
+                if (ready())
+                {
+                    return RingBufferStatus::Ready;
+                }
+                if (!is_open)
+                {
+                    return RingBufferStatus::Closed;
+                }
+                // announce, then re-check, so that a concurrent writer either sees readerWaiting, or changes
+                // writeSequence before we wait on it.
+                readerWaiting.store(true, std::memory_order_seq_cst);
+                bool timedOut = false;
+                if (writeSequence.load(std::memory_order_seq_cst) == sequence)
+                {
+                    if (deadline)
+                    {
+                        timedOut = !futex_wait_for(
+                            &writeSequence, sequence,
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(*deadline - std::chrono::steady_clock::now()));
+                    }
+                    else
+                    {
+                        futex_wait(&writeSequence, sequence);
+                    }
+                }
+                readerWaiting.store(false, std::memory_order_relaxed);
+                if (timedOut)
+                {
+                    return ready() ? RingBufferStatus::Ready : RingBufferStatus::TimedOut;
+                }
+            }
+        }
+        template <class Clock, class Duration>
+        static std::chrono::steady_clock::time_point toSteadyClock(const std::chrono::time_point<Clock, Duration> &time_point)
+        {
+            return std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(time_point - Clock::now());
+        }
 
         size_t nextPowerOfTwo(size_t size)
         {
@@ -85,130 +197,89 @@ namespace pipedal
         {
             this->readPosition = 0;
             this->writePosition = 0;
+            this->reserveCount = 0;
+            this->commitCount = 0;
             this->is_open = true;
-            cvRead.notify_all();
+            if (SEMAPHORE_READER)
+            {
+                wakeReader();
+            }
         }
         void close()
         {
             if (SEMAPHORE_READER)
             {
                 this->is_open = false;
-                cvRead.notify_all();
+                wakeReader();
             }
         }
 
         template <class Rep, class Period>
         RingBufferStatus readWait_for(const std::chrono::duration<Rep, Period> &timeout)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
-
-                    auto status = cvRead.wait_for(lock, timeout);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+            return readerWait([this]() { return isReadReady_(); }, &deadline);
         }
 
         template <class Clock, class Duration>
         RingBufferStatus readWait_until(const std::chrono::time_point<Clock, Duration> &time_point)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
-
-                    auto status = cvRead.wait_until(lock, time_point);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            auto deadline = toSteadyClock(time_point);
+            return readerWait([this]() { return isReadReady_(); }, &deadline);
         }
         template <class Clock, class Duration>
         RingBufferStatus readWait_until(size_t size, const std::chrono::time_point<Clock, Duration> &time_point)
         {
-            while (true)
-            {
-                if (SEMAPHORE_READER)
-                {
-                    std::unique_lock lock(mutex);
-                    size_t available = readSpace_();
-                    if (available >= size)
-                    {
-                        return RingBufferStatus::Ready;
-                    }
-                    if (!is_open)
-                        return RingBufferStatus::Closed;
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            auto deadline = toSteadyClock(time_point);
+            return readerWait([this, size]() { return readSpace_() >= size; }, &deadline);
+        }
 
-                    auto status = cvRead.wait_until(lock, time_point);
-                    if (status == std::cv_status::timeout)
-                    {
-                        return RingBufferStatus::TimedOut;
-                    }
-                }
-                else
-                {
-                    static_assert("SEMAPHORE_READER is not set to true.");
-                }
-            }
+        /**
+         * @brief Wait until ready() returns true, the ring buffer is closed, or the deadline passes.
+         *
+         * For a reader that drains several ring buffers that share this ring buffer's reader wakeup; ready()
+         * is re-evaluated whenever any of them is written to.
+         */
+        template <typename READY, class Clock, class Duration>
+        RingBufferStatus readWaitAny_until(READY &&ready, const std::chrono::time_point<Clock, Duration> &time_point)
+        {
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            auto deadline = toSteadyClock(time_point);
+            return readerWait(std::forward<READY>(ready), &deadline);
         }
 
-        bool readWait()
+        /**
+         * @brief Wake the reader of `primary` (instead of the reader of this ring buffer) on every write.
+         *
+         * Must be called before either ring buffer is used.
+         */
+        void shareReaderWakeup(RingBuffer &primary)
         {
-            if (SEMAPHORE_READER)
-            {
-                while (true)
-                {
-                    std::unique_lock lock(mutex);
-                    if (isReadReady_())
-                    {
-                        return true;
-                    }
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            this->readerWakeup = primary.readerWakeup;
+        }
 
-                    if (!is_open)
-                        return false;
-                    cvRead.wait(lock);
-                }
-            }
-            else
-            {
-                static_assert("SEMAPHORE_READER is not set to true.");
-            }
+        void recordOverflow()
+        {
+            overflowCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        uint64_t getOverflowCount() const
+        {
+            return overflowCount.load(std::memory_order_relaxed);
+        }
+
+        bool readWait()
+        {
+            static_assert(SEMAPHORE_READER, "SEMAPHORE_READER is not set to true.");
+            return readerWait([this]() { return isReadReady_(); }, nullptr) == RingBufferStatus::Ready;
         }
         size_t writeSpace()
         {
             // at most ringBufferSize-1 in order to
             // to distinguish the empty buffer from the full buffer.
-            std::unique_lock lock(mutex);
-
             int64_t size = readPosition - 1 - writePosition;
             if (size < 0)
                 size += this->ringBufferSize;
@@ -217,128 +288,121 @@ namespace pipedal
 
         size_t readSpace()
         {
-            std::unique_lock lock(mutex);
             return readSpace_();
         }
 
  
-        bool write(size_t bytes, uint8_t *data)
+        /**
+         * @brief Reserve space for a write of exactly `bytes` bytes.
+         *
+         * Returns (up to) two spans that the caller fills in place, followed by a call to commitWrite(),
+         * which makes the data visible to the reader. Returns empty spans if there is not enough space.
+         *
+         * In MULTI_WRITER mode, reservation is lock-free: concurrent writers claim disjoint regions with a
+         * CAS, and copy their data in parallel. A reservation that succeeded must be committed.
+         */
+        RingBufferWriteSpans beginWrite(size_t bytes)
         {
+            RingBufferWriteSpans result;
+            size_t index;
             if (MULTI_WRITER)
             {
-                std::lock_guard writeLock{writeMutex};
-                if (writeSpace() < bytes + sizeof(bytes))
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                {
-                    std::lock_guard lock(mutex);
-                    this->writePosition = (index + bytes) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
+                uint64_t start = reserveCount.load(std::memory_order_acquire);
+                while (true)
                 {
-                    cvRead.notify_all();
+                    size_t used = (size_t)((start - (uint64_t)readPosition.load(std::memory_order_acquire)) & ringBufferMask);
+                    size_t available = this->ringBufferSize - 1 - used;
+                    if (available < bytes + sizeof(bytes))
+                    {
+                        // a stale start can make the buffer look full. Only give up if nobody else reserved in the meantime.
+                        uint64_t current = reserveCount.load(std::memory_order_acquire);
+                        if (current != start)
+                        {
+                            start = current;
+                            continue;
+                        }
+                        return result;
+                    }
+                    if (reserveCount.compare_exchange_weak(start, start + bytes, std::memory_order_acq_rel, std::memory_order_acquire))
+                    {
+                        break;
+                    }
                 }
-                return true;
+                result.sequence = start;
+                index = (size_t)(start & ringBufferMask);
             }
             else
             {
-                if (writeSpace() < sizeof(bytes) + bytes)
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
+                if (writeSpace() < bytes + sizeof(bytes))
                 {
-                    cvRead.notify_all();
+                    return result;
                 }
-                return true;
+                index = (size_t)this->writePosition.load(std::memory_order_relaxed);
+            }
+            size_t contiguous = this->ringBufferSize - index;
+            result.data1 = (uint8_t *)buffer + index;
+            if (bytes <= contiguous)
+            {
+                result.size1 = bytes;
+            }
+            else
+            {
+                result.size1 = contiguous;
+                result.data2 = (uint8_t *)buffer;
+                result.size2 = bytes - contiguous;
             }
+            return result;
         }
-        // Write two disjoint areas of memory atomically.
-        bool write(size_t bytes, uint8_t *data, size_t bytes2, uint8_t *data2)
+
+        void commitWrite(const RingBufferWriteSpans &spans)
         {
             if (MULTI_WRITER)
             {
-                std::lock_guard guard(writeMutex);
-                if (writeSpace() <= sizeof(bytes) + bytes + bytes2)
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                index = (index + bytes) & ringBufferMask;
-
-                for (size_t i = 0; i < sizeof(bytes2); ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = ((char *)&bytes2)[i];
-                }
-                index = (index + sizeof(bytes2)) & ringBufferMask;
-
-                for (size_t i = 0; i < bytes2; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data2[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes2) & ringBufferMask;
-                }
-                if (SEMAPHORE_READER)
+                // Publish in reservation order. Writers that reserved ahead of us are at most a memcpy away
+                // from committing, unless they have been preempted.
+                uint64_t start = spans.sequence;
+                uint64_t end = start + spans.size();
+                while (commitCount.load(std::memory_order_acquire) != start)
                 {
-                    cvRead.notify_all();
+                    std::this_thread::yield();
                 }
-                return true;
+                publishWritePosition((int64_t)(end & ringBufferMask));
+                commitCount.store(end, std::memory_order_release);
             }
             else
             {
-                if (writeSpace() <= sizeof(bytes2) + bytes + bytes2)
-                {
-                    return false;
-                }
-                size_t index = this->writePosition;
-                for (size_t i = 0; i < bytes; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data[i];
-                }
-                index = (index + bytes) & ringBufferMask;
-
-                for (size_t i = 0; i < sizeof(bytes2); ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = ((char *)&bytes2)[i];
-                }
-                index = (index + sizeof(bytes2)) & ringBufferMask;
-
-                for (size_t i = 0; i < bytes2; ++i)
-                {
-                    buffer[(index + i) & ringBufferMask] = data2[i];
-                }
-                {
-                    std::lock_guard lock{mutex};
-                    this->writePosition = (index + bytes2) & ringBufferMask;
-                }
+                publishWritePosition((this->writePosition.load(std::memory_order_relaxed) + spans.size()) & ringBufferMask);
+            }
+            if (SEMAPHORE_READER)
+            {
+                wakeReader();
+            }
+        }
 
-                if (SEMAPHORE_READER)
-                {
-                    cvRead.notify_all();
-                }
-                return true;
+        bool write(size_t bytes, uint8_t *data)
+        {
+            RingBufferWriteSpans spans = beginWrite(bytes);
+            if (!spans)
+            {
+                return false;
+            }
+            spans.write(0, data, bytes);
+            commitWrite(spans);
+            return true;
+        }
+        // Write two disjoint areas of memory atomically.
+        bool write(size_t bytes, uint8_t *data, size_t bytes2, uint8_t *data2)
+        {
+            RingBufferWriteSpans spans = beginWrite(bytes + sizeof(bytes2) + bytes2);
+            if (!spans)
+            {
+                return false;
             }
+            spans.write(0, data, bytes);
+            spans.write(bytes, &bytes2, sizeof(bytes2));
+            spans.write(bytes + sizeof(bytes2), data2, bytes2);
+            commitWrite(spans);
+            return true;
         }
 
         size_t read_packet(size_t maxSize, void*data) {
@@ -363,14 +427,8 @@ namespace pipedal
             if (readSpace() < bytes)
                 return false;
             int64_t readPosition = this->readPosition;
-            for (size_t i = 0; i < bytes; ++i)
-            {
-                data[i] = this->buffer[(readPosition + i) & this->ringBufferMask];
-            }
-            {
-                std::lock_guard lock{mutex};
-                this->readPosition = (readPosition + bytes) & this->ringBufferMask;
-            }
+            copyOut((size_t)readPosition, data, bytes);
+            this->readPosition.store((readPosition + bytes) & this->ringBufferMask, std::memory_order_release);
             return true;
         }
         ~RingBuffer()
@@ -386,7 +444,6 @@ namespace pipedal
         }
         bool isReadReady()
         {
-            std::lock_guard lock(mutex);
             if (isReadReady_())
                 return true;
             return !this->is_open;
@@ -398,6 +455,10 @@ namespace pipedal
         }
 
     private:
+        void publishWritePosition(int64_t position)
+        {
+            this->writePosition.store(position, std::memory_order_release);
+        }
         size_t readSpace_()
         {
             int64_t size = writePosition - readPosition;
@@ -406,15 +467,25 @@ namespace pipedal
             return size_t(size);
         }
 
-        uint32_t peekSize()
+        // copy from the ring buffer, splitting at the wrap point.
+        void copyOut(size_t index, uint8_t *data, size_t bytes)
         {
-            volatile uint32_t result;
-            uint8_t *p = (uint8_t *)&result;
-            size_t ix = this->readPosition;
-            for (size_t i = 0; i < sizeof(result); ++i)
+            size_t contiguous = this->ringBufferSize - index;
+            if (bytes <= contiguous)
+            {
+                memcpy(data, this->buffer + index, bytes);
+            }
+            else
             {
-                *p++ = this->buffer[(ix++) & ringBufferMask];
+                memcpy(data, this->buffer + index, contiguous);
+                memcpy(data + contiguous, this->buffer, bytes - contiguous);
             }
+        }
+
+        uint32_t peekSize()
+        {
+            uint32_t result;
+            copyOut((size_t)this->readPosition, (uint8_t *)&result, sizeof(result));
             return result;
         }
         bool isReadReady_()
@@ -22,14 +22,22 @@
 #include "PiPedalException.hpp"
 #include "Lv2Log.hpp"
 #include "VuUpdate.hpp"
+#include "EffectTiming.hpp"
 #include "AudioHost.hpp"
 #include "lv2/atom/atom.h"
 #include "RealtimeMidiEventType.hpp"
+#include "Tracer.hpp"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <type_traits>
 
 namespace pipedal
 {
     class IndexedSnapshot;
+    class SystemMidiDispatch;
+    class LatencyProbe;
+    class RealtimePedalboardSlots;
 
     class MidiNotifyBody
     {
@@ -51,6 +59,7 @@ namespace pipedal
         ReplaceEffect,
         EffectReplaced,
         SetValue,
+        SetValues,
         SetBypass,
         // AudioStopped,
         AudioTerminatedAbnormally, // specifically for an ALSA loss of connection.
@@ -65,12 +74,12 @@ namespace pipedal
 
         SetMonitorPortSubscription,
         FreeMonitorPortSubscription,
-        SendMonitorPortUpdate,
-        AckMonitorPortUpdate,
+        SendMonitorPortUpdates,
+        AckMonitorPortUpdates,
         ParameterRequest,
         ParameterRequestComplete,
 
-        MidiValueChanged,
+        MidiValuesChanged,
 
         OnMidiListen,
 
@@ -92,9 +101,84 @@ namespace pipedal
         RealtimeMidiEvent,
         RealtimeMidiSnapshotRequest,
 
-        SendPathPropertyBuffer,
+        SendPathPropertyBuffers,
 
+        SetEffectTimingSubscription,
+        FreeEffectTimingSubscription,
+        SendEffectTimings,
+        AckEffectTimings,
+
+        SetSystemMidiDispatch,
+        FreeSystemMidiDispatch,
+
+        SetLatencyProbe,
+        LatencyProbeComplete,
+
+        SetPedalboardSlots,
+        FreePedalboardSlots,
+
+        SetIdle,
+        IdleWake, // the audio thread left idle mode by itself.
+
+        SetAtomOutputSubscriptions,
+        FreeAtomOutputSubscriptions,
+    };
+
+    /**
+     * @brief Which realtime->host ring buffer a message travels on.
+     *
+     * The host drains Control before Telemetry, and Telemetry before Bulk, so that a burst of large
+     * atom outputs can't hold up MIDI program changes, or the return of realtime memory.
+     *
+     * Messages that free a subscription travel with the subscription's updates, since updates
+     * point into memory that the free message releases.
+     *
+     * Overflow policy: every ring buffer counts dropped writes. Telemetry updates are throttled
+     * by an acknowledgement, and are retried on a later cycle if dropped. Bulk data is dropped
+     * silently. Dropping anything else (state changes, memory ownership) logs an error.
+     */
+    enum class RingBufferClass
+    {
+        Control = 0,
+        Telemetry = 1,
+        Bulk = 2,
     };
+    constexpr size_t RING_BUFFER_CLASS_COUNT = 3;
+
+    inline RingBufferClass GetRingBufferClass(RingBufferCommand command)
+    {
+        switch (command)
+        {
+        case RingBufferCommand::SendVuUpdate:
+        case RingBufferCommand::FreeVuSubscriptions:
+        case RingBufferCommand::SendMonitorPortUpdates:
+        case RingBufferCommand::FreeMonitorPortSubscription:
+        case RingBufferCommand::SendEffectTimings:
+        case RingBufferCommand::FreeEffectTimingSubscription:
+            return RingBufferClass::Telemetry;
+        case RingBufferCommand::AtomOutput:
+        case RingBufferCommand::Lv2ErrorMessage:
+            return RingBufferClass::Bulk;
+        default:
+            return RingBufferClass::Control;
+        }
+    }
+
+    // Messages that can be dropped without losing state or leaking memory.
+    inline bool IsDroppableRingBufferCommand(RingBufferCommand command)
+    {
+        switch (command)
+        {
+        case RingBufferCommand::SendVuUpdate:
+        case RingBufferCommand::SendMonitorPortUpdates:
+        case RingBufferCommand::SendEffectTimings:
+        case RingBufferCommand::AtomOutput:
+        case RingBufferCommand::Lv2ErrorMessage:
+            return true;
+        default:
+            return false;
+        }
+    }
 
     struct RealtimeMidiEventRequest
     {
@@ -128,16 +212,90 @@ namespace pipedal
         int instanceIndex = 0;
         int portIndex = 0;
         PortMonitorCallback *callbackPtr = nullptr;
-        int sampleRate = 0;
+        int sampleInterval = 0;
+        float epsilon = 0; // deadband: changes smaller than this are not reported.
+        bool hasValue = false;
+        float lastValue = 0;
+        float sampledValue = 0;
+
+        bool HasChanged() const
+        {
+            return !hasValue || std::abs(sampledValue - lastValue) > epsilon;
+        }
+        void CommitSampledValue()
+        {
+            hasValue = true;
+            lastValue = sampledValue;
+        }
+    };
+
+    // Subscriptions with the same update interval, which are sampled on the same tick,
+    // and reported in a single message.
+    class RealtimeMonitorPortGroup
+    {
+    public:
+        int sampleInterval = 0;
         int samplesToNextCallback = 0;
+        size_t begin = 0;
+        size_t end = 0;
         bool waitingForAck = false;
-        float lastValue = -1E30;
     };
 
     class RealtimeMonitorPortSubscriptions
     {
     public:
         std::vector<RealtimeMonitorPortSubscription> subscriptions;
+        std::vector<RealtimeMonitorPortGroup> groups;
+        std::vector<MonitorPortUpdate> updateBuffer;
+
+        // Non-realtime: group subscriptions by update interval, and allocate update storage.
+        void Prepare()
+        {
+            std::stable_sort(
+                subscriptions.begin(), subscriptions.end(),
+                [](const RealtimeMonitorPortSubscription &left, const RealtimeMonitorPortSubscription &right)
+                {
+                    return left.sampleInterval < right.sampleInterval;
+                });
+            groups.clear();
+            for (size_t i = 0; i < subscriptions.size(); ++i)
+            {
+                if (groups.empty() || groups.back().sampleInterval != subscriptions[i].sampleInterval)
+                {
+                    RealtimeMonitorPortGroup group;
+                    group.sampleInterval = subscriptions[i].sampleInterval;
+                    group.samplesToNextCallback = group.sampleInterval;
+                    group.begin = i;
+                    groups.push_back(group);
+                }
+                groups.back().end = i + 1;
+            }
+            updateBuffer.resize(subscriptions.size());
+        }
+    };
+
+    class RealtimeAtomOutputSubscriptions
+    {
+    public:
+        std::vector<AtomOutputSubscription> subscriptions;
+
+        bool WantsProperty(uint64_t instanceId, LV2_URID propertyUrid) const
+        {
+            for (const auto &subscription : subscriptions)
+            {
+                if (subscription.instanceId == instanceId && (subscription.propertyUrid == 0 || subscription.propertyUrid == propertyUrid))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct MonitorPortUpdatesBody
+    {
+        RealtimeMonitorPortSubscriptions *subscriptions;
+        size_t groupIndex;
     };
 
     struct RealtimeVuBuffers
@@ -147,21 +305,36 @@ namespace pipedal
             Reset();
         }
         bool waitingForAcknowledge = false;
+        // The update interval of the fastest subscribed instance.
+        int samplesPerUpdate = 0;
 
-        const std::vector<VuUpdate> *GetResult(size_t currentSample)
+        // Moves the VUs of instances that are due on this tick into vuUpdateResponseData. Instances
+        // that aren't due keep accumulating. Returns the number of responses.
+        size_t GetResult(size_t currentSample)
         {
+            responseCount = 0;
             for (size_t i = 0; i < vuUpdateWorkingData.size(); ++i)
             {
-                vuUpdateResponseData[i] = vuUpdateWorkingData[i];
-                vuUpdateResponseData[i].sampleTime_ = currentSample;
+                if (--ticksRemaining[i] > 0)
+                {
+                    continue;
+                }
+                ticksRemaining[i] = ticksPerUpdate[i];
+                VuUpdate &response = vuUpdateResponseData[responseCount++];
+                response = vuUpdateWorkingData[i];
+                response.sampleTime_ = currentSample;
                 vuUpdateWorkingData[i].reset();
             }
-            return &vuUpdateResponseData;
+            return responseCount;
         }
 
         std::vector<int> enabledIndexes;
         std::vector<VuUpdate> vuUpdateWorkingData;
         std::vector<VuUpdate> vuUpdateResponseData;
+        // Instances subscribed at lower rates are sent every ticksPerUpdate ticks.
+        std::vector<int> ticksPerUpdate;
+        std::vector<int> ticksRemaining;
+        size_t responseCount = 0;
 
         void Reset()
         {
@@ -184,20 +357,27 @@ namespace pipedal
         bool enabled;
     };
 
-    class MidiValueChangedBody
+    class SetControlValueBody
     {
     public:
-        int64_t instanceId;
+        int effectIndex;
         int controlIndex;
         float value;
     };
 
-    class SetControlValueBody
+    // Followed by count ControlIndexValue entries.
+    class SetControlValuesBody
     {
     public:
         int effectIndex;
-        int controlIndex;
+        uint32_t rampFrames; // for entries with ramp set.
+        uint32_t count;
+    };
+    struct ControlIndexValue
+    {
+        int32_t controlIndex;
         float value;
+        bool ramp; // false for switches, enumerations and integer controls.
     };
     class SetVolumeBody
     {
@@ -268,6 +448,10 @@ namespace pipedal
             {
                 throw PiPedalStateException("Ringbuffer read failed. Did you forget to check for space?");
             }
+            if constexpr (std::is_same_v<T, RingBufferCommand>)
+            {
+                Tracer::Instant("ringbuffer", "dequeue", (int64_t)*output);
+            }
             return true;
         }
 
@@ -315,45 +499,91 @@ namespace pipedal
     {
 
     private:
-        RingBuffer<MULTI_WRITER, SEMAPHORE_READER> *ringBuffer;
+        using ring_buffer_t = RingBuffer<MULTI_WRITER, SEMAPHORE_READER>;
+        // indexed by RingBufferClass. All the same ring buffer unless the writer was constructed with one per class.
+        ring_buffer_t *ringBuffers[RING_BUFFER_CLASS_COUNT];
+
+        ring_buffer_t *getRingBuffer(RingBufferCommand command)
+        {
+            return ringBuffers[(size_t)GetRingBufferClass(command)];
+        }
+        void onOverflow(RingBufferCommand command, ring_buffer_t *ringBuffer)
+        {
+            ringBuffer->recordOverflow();
+            if (!IsDroppableRingBufferCommand(command))
+            {
+                Lv2Log::error("No space in audio service ringbuffer.");
+            }
+        }
 
     public:
         RingBufferWriter()
-            : ringBuffer(nullptr)
+            : ringBuffers{nullptr, nullptr, nullptr}
         {
         }
-        RingBufferWriter(RingBuffer<MULTI_WRITER, SEMAPHORE_READER> *ringBuffer)
-            : ringBuffer(ringBuffer)
+        RingBufferWriter(ring_buffer_t *ringBuffer)
+            : ringBuffers{ringBuffer, ringBuffer, ringBuffer}
         {
         }
-
-        void Reset() { ringBuffer->reset(); }
-        template <typename T>
-        void write(RingBufferCommand command, const T &value)
+        RingBufferWriter(ring_buffer_t *controlRingBuffer, ring_buffer_t *telemetryRingBuffer, ring_buffer_t *bulkRingBuffer)
+            : ringBuffers{controlRingBuffer, telemetryRingBuffer, bulkRingBuffer}
         {
+        }
 
-            // the goal: to atomically write the command and associated data.
-            CommandBuffer<T> buffer(command, value);
-
-            if (!ringBuffer->write(buffer.size(), (uint8_t *)&buffer))
+        void Reset()
+        {
+            for (size_t i = 0; i < RING_BUFFER_CLASS_COUNT; ++i)
             {
-                Lv2Log::error("No space in audio service ringbuffer.");
-                return;
+                bool seen = false;
+                for (size_t j = 0; j < i; ++j)
+                {
+                    seen |= ringBuffers[j] == ringBuffers[i];
+                }
+                if (!seen)
+                {
+                    ringBuffers[i]->reset();
+                }
             }
         }
-
+        // Returns false if the message was dropped because its ring buffer was full.
         template <typename T>
-        void write(RingBufferCommand command, const T &value, size_t dataLength, uint8_t *variableData)
-        {
-
-            // the goal: to atomically write the command and associated data.
-            CommandBuffer<T> buffer(command, value);
+        bool write(RingBufferCommand command, const T &value)
+        {
+            // the goal: to atomically write the command and associated data,
+            // serialized directly into the ring buffer.
+            Tracer::Instant("ringbuffer", "enqueue", (int64_t)command);
+            ring_buffer_t *ringBuffer = getRingBuffer(command);
+            RingBufferWriteSpans spans = ringBuffer->beginWrite(sizeof(RingBufferCommand) + sizeof(T));
+            if (!spans)
+            {
+                onOverflow(command, ringBuffer);
+                return false;
+            }
+            spans.write(0, &command, sizeof(command));
+            spans.write(sizeof(command), &value, sizeof(T));
+            ringBuffer->commitWrite(spans);
+            return true;
+        }
 
-            if (!ringBuffer->write(buffer.size(), (uint8_t *)&buffer, dataLength, variableData))
+        template <typename T>
+        bool write(RingBufferCommand command, const T &value, size_t dataLength, uint8_t *variableData)
+        {
+            // layout: command, value, dataLength, variableData.
+            Tracer::Instant("ringbuffer", "enqueue", (int64_t)command);
+            ring_buffer_t *ringBuffer = getRingBuffer(command);
+            constexpr size_t headerSize = sizeof(RingBufferCommand) + sizeof(T);
+            RingBufferWriteSpans spans = ringBuffer->beginWrite(headerSize + sizeof(dataLength) + dataLength);
+            if (!spans)
             {
-                Lv2Log::error("No space in audio service ringbuffer.");
-                return;
+                onOverflow(command, ringBuffer);
+                return false;
             }
+            spans.write(0, &command, sizeof(command));
+            spans.write(sizeof(command), &value, sizeof(T));
+            spans.write(headerSize, &dataLength, sizeof(dataLength));
+            spans.write(headerSize + sizeof(dataLength), variableData, dataLength);
+            ringBuffer->commitWrite(spans);
+            return true;
         }
         void Lv2StateChanged(uint64_t instanceId)
         {
@@ -379,13 +609,9 @@ namespace pipedal
         {
             write(RingBufferCommand::ParameterRequestComplete, pRequest);
         }
-        void MidiValueChanged(int64_t instanceId, int controlIndex, float value)
+        void MidiValuesChanged(size_t count, const MidiValueChange *changes)
         {
-            MidiValueChangedBody body;
-            body.instanceId = instanceId;
-            body.controlIndex = controlIndex;
-            body.value = value;
-            write(RingBufferCommand::MidiValueChanged, body);
+            write(RingBufferCommand::MidiValuesChanged, count, count * sizeof(MidiValueChange), (uint8_t *)changes);
         }
 
         void OnMidiListen(const MidiNotifyBody &body)
@@ -436,6 +662,14 @@ namespace pipedal
             body.value = value;
             write(RingBufferCommand::SetValue, body);
         }
+        void SetControlValues(int effectIndex, uint32_t rampFrames, size_t count, const ControlIndexValue *values)
+        {
+            SetControlValuesBody body;
+            body.effectIndex = effectIndex;
+            body.rampFrames = rampFrames;
+            body.count = (uint32_t)count;
+            write(RingBufferCommand::SetValues, body, count * sizeof(ControlIndexValue), (uint8_t *)values);
+        }
         void SetInputVolume(float value)
         {
             SetVolumeBody body;
@@ -459,34 +693,90 @@ namespace pipedal
             write(RingBufferCommand::FreeMonitorPortSubscription, subscriptions);
         }
 
-        void SendMonitorPortUpdate(
-            PortMonitorCallback *callback,
-            int64_t subscriptionHandle,
-            float value)
+        bool SendMonitorPortUpdates(
+            RealtimeMonitorPortSubscriptions *subscriptions,
+            size_t groupIndex,
+            size_t count,
+            const MonitorPortUpdate *updates)
         {
-            MonitorPortUpdate body{callback, subscriptionHandle, value};
-            write(RingBufferCommand::SendMonitorPortUpdate, body);
+            MonitorPortUpdatesBody body{subscriptions, groupIndex};
+            return write(RingBufferCommand::SendMonitorPortUpdates, body, count * sizeof(MonitorPortUpdate), (uint8_t *)updates);
         }
 
-        void SendVuUpdate(const std::vector<VuUpdate> *pUpdates)
+        bool SendVuUpdate(const RealtimeVuBuffers *pUpdates)
         {
-            write(RingBufferCommand::SendVuUpdate, pUpdates);
+            return write(RingBufferCommand::SendVuUpdate, pUpdates);
         }
         void AckVuUpdate()
         {
             bool value = true;
             write(RingBufferCommand::AckVuUpdate, value);
         }
-        void AckMonitorPortUpdate(int64_t subscriptionHandle)
+        void SetSystemMidiDispatch(SystemMidiDispatch *systemMidiDispatch)
         {
-            // we assume no padding between the command and the data, so we can do an atomic write.
-
-            write(RingBufferCommand::AckMonitorPortUpdate, subscriptionHandle);
+            write(RingBufferCommand::SetSystemMidiDispatch, systemMidiDispatch);
+        }
+        void FreeSystemMidiDispatch(SystemMidiDispatch *systemMidiDispatch)
+        {
+            write(RingBufferCommand::FreeSystemMidiDispatch, systemMidiDispatch);
+        }
+        void SetPedalboardSlots(RealtimePedalboardSlots *slots)
+        {
+            write(RingBufferCommand::SetPedalboardSlots, slots);
+        }
+        void FreePedalboardSlots(RealtimePedalboardSlots *slots)
+        {
+            write(RingBufferCommand::FreePedalboardSlots, slots);
+        }
+        void SetLatencyProbe(LatencyProbe *probe)
+        {
+            write(RingBufferCommand::SetLatencyProbe, probe);
+        }
+        void LatencyProbeComplete(LatencyProbe *probe)
+        {
+            write(RingBufferCommand::LatencyProbeComplete, probe);
+        }
+        void SetIdle(bool idle)
+        {
+            write(RingBufferCommand::SetIdle, idle);
+        }
+        void IdleWake()
+        {
+            write(RingBufferCommand::IdleWake, (uint64_t)0);
+        }
+        void SetEffectTimingSubscription(RealtimeEffectTimings *timings)
+        {
+            write(RingBufferCommand::SetEffectTimingSubscription, timings);
+        }
+        void FreeEffectTimingSubscription(RealtimeEffectTimings *timings)
+        {
+            write(RingBufferCommand::FreeEffectTimingSubscription, timings);
+        }
+        bool SendEffectTimings(const RealtimeEffectTimings *timings)
+        {
+            return write(RingBufferCommand::SendEffectTimings, timings);
+        }
+        void AckEffectTimings()
+        {
+            bool value = true;
+            write(RingBufferCommand::AckEffectTimings, value);
+        }
+        void AckMonitorPortUpdates(const MonitorPortUpdatesBody &body)
+        {
+            write(RingBufferCommand::AckMonitorPortUpdates, body);
         }
         void SetVuSubscriptions(RealtimeVuBuffers *configuration)
         {
             write(RingBufferCommand::SetVuSubscriptions, configuration);
         }
+        void SetAtomOutputSubscriptions(RealtimeAtomOutputSubscriptions *subscriptions)
+        {
+            write(RingBufferCommand::SetAtomOutputSubscriptions, subscriptions);
+        }
+        void FreeAtomOutputSubscriptions(RealtimeAtomOutputSubscriptions *subscriptions)
+        {
+            write(RingBufferCommand::FreeAtomOutputSubscriptions, subscriptions);
+        }
         void LoadSnapshot(IndexedSnapshot *snapshot)
         {
             write(RingBufferCommand::LoadSnapshot, snapshot);
@@ -542,9 +832,9 @@ namespace pipedal
             size_t length = strlen(message);
             write(RingBufferCommand::Lv2ErrorMessage, instanceId, length, (uint8_t *)message);
         }
-        void SendPathPropertyBuffer(PatchPropertyWriter::Buffer *buffer)
+        bool SendPathPropertyBuffers(size_t count, PatchPropertyWriter::Buffer *const *buffers)
         {
-            write(RingBufferCommand::SendPathPropertyBuffer, buffer);
+            return write(RingBufferCommand::SendPathPropertyBuffers, count, count * sizeof(PatchPropertyWriter::Buffer *), (uint8_t *)buffers);
         }
     };
 
@@ -563,6 +853,27 @@ namespace pipedal
             : RingBufferWriter<false, true>(ringBuffer)
         {
         }
+        RealtimeRingBufferWriter(
+            RingBuffer<false, true> *controlRingBuffer,
+            RingBuffer<false, true> *telemetryRingBuffer,
+            RingBuffer<false, true> *bulkRingBuffer)
+            : RingBufferWriter<false, true>(controlRingBuffer, telemetryRingBuffer, bulkRingBuffer)
+        {
+        }
+
+        // Audio thread. Patch properties that clients are listening to; atom outputs for anything else
+        // are dropped before they reach the ring buffer. Owned by the audio host.
+        void SetAtomOutputFilter(const RealtimeAtomOutputSubscriptions *subscriptions)
+        {
+            this->atomOutputSubscriptions = subscriptions;
+        }
+        bool WantsAtomOutput(uint64_t instanceId, LV2_URID propertyUrid) const
+        {
+            return atomOutputSubscriptions != nullptr && atomOutputSubscriptions->WantsProperty(instanceId, propertyUrid);
+        }
+
+    private:
+        const RealtimeAtomOutputSubscriptions *atomOutputSubscriptions = nullptr;
     };
 
 } // namespace
\ No newline at end of file
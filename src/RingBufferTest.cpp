@@ -0,0 +1,207 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include <thread>
+#include <vector>
+#include <atomic>
+#include "RingBuffer.hpp"
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    struct TestMessage
+    {
+        uint32_t producer;
+        uint32_t sequence;
+        uint64_t check;
+    };
+}
+
+TEST_CASE("RingBuffer multi-writer test", "[ring_buffer][Build][Dev]")
+{
+    constexpr uint32_t N_PRODUCERS = 4;
+    constexpr uint32_t N_MESSAGES = 100000;
+
+    // small, so that writes wrap frequently and producers regularly find the buffer full.
+    RingBuffer<true, false> ringBuffer(1024, false);
+
+    std::atomic<bool> start{false};
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < N_PRODUCERS; ++producer)
+    {
+        producers.emplace_back(
+            [&ringBuffer, &start, producer]()
+            {
+                while (!start)
+                {
+                    std::this_thread::yield();
+                }
+                for (uint32_t i = 0; i < N_MESSAGES; ++i)
+                {
+                    TestMessage message{producer, i, ((uint64_t)producer << 32) ^ i ^ 0x5555AAAA5555AAAAull};
+                    while (!ringBuffer.write(sizeof(message), (uint8_t *)&message))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    start = true;
+
+    std::vector<uint32_t> nextSequence(N_PRODUCERS, 0);
+    bool ok = true;
+    for (uint64_t received = 0; received < (uint64_t)N_PRODUCERS * N_MESSAGES;)
+    {
+        if (ringBuffer.readSpace() < sizeof(TestMessage))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        TestMessage message;
+        ringBuffer.read(sizeof(message), (uint8_t *)&message);
+        ++received;
+        // messages from each producer arrive intact, and in order.
+        if (message.producer >= N_PRODUCERS ||
+            message.check != (((uint64_t)message.producer << 32) ^ message.sequence ^ 0x5555AAAA5555AAAAull) ||
+            message.sequence != nextSequence[message.producer])
+        {
+            ok = false;
+            break;
+        }
+        ++nextSequence[message.producer];
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+    REQUIRE(ok);
+}
+
+TEST_CASE("RingBuffer semaphore reader test", "[ring_buffer][Build][Dev]")
+{
+    constexpr uint32_t N_MESSAGES = 100000;
+
+    RingBuffer<false, true> ringBuffer(1024, false);
+
+    // nothing written: timed waits time out.
+    REQUIRE(ringBuffer.readWait_for(std::chrono::milliseconds(1)) == RingBufferStatus::TimedOut);
+    REQUIRE(ringBuffer.readWait_until(std::chrono::system_clock::now() + std::chrono::milliseconds(1)) == RingBufferStatus::TimedOut);
+
+    std::thread producer(
+        [&ringBuffer]()
+        {
+            for (uint32_t i = 0; i < N_MESSAGES; ++i)
+            {
+                TestMessage message{0, i, i ^ 0x5555AAAA5555AAAAull};
+                while (!ringBuffer.write(sizeof(message), (uint8_t *)&message))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+
+    bool ok = true;
+    for (uint32_t i = 0; i < N_MESSAGES; ++i)
+    {
+        if (ringBuffer.readWait_until(sizeof(TestMessage), std::chrono::steady_clock::now() + std::chrono::seconds(10)) != RingBufferStatus::Ready)
+        {
+            ok = false;
+            break;
+        }
+        TestMessage message;
+        ringBuffer.read(sizeof(message), (uint8_t *)&message);
+        if (message.sequence != i || message.check != (i ^ 0x5555AAAA5555AAAAull))
+        {
+            ok = false;
+            break;
+        }
+    }
+    producer.join();
+    REQUIRE(ok);
+
+    // close() releases a blocked reader.
+    std::thread closer(
+        [&ringBuffer]()
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ringBuffer.close();
+        });
+    REQUIRE(ringBuffer.readWait() == false);
+    closer.join();
+    REQUIRE(ringBuffer.readWait_for(std::chrono::seconds(1)) == RingBufferStatus::Closed);
+}
+
+TEST_CASE("RingBuffer shared reader wakeup test", "[ring_buffer][Build][Dev]")
+{
+    constexpr uint32_t N_MESSAGES = 10000;
+
+    RingBuffer<false, true> primary(1024, false);
+    RingBuffer<false, true> secondary(1024, false);
+    secondary.shareReaderWakeup(primary);
+
+    auto ready = [&]() {
+        return primary.readSpace() >= sizeof(TestMessage) || secondary.readSpace() >= sizeof(TestMessage);
+    };
+    REQUIRE(primary.readWaitAny_until(ready, std::chrono::steady_clock::now() + std::chrono::milliseconds(1)) == RingBufferStatus::TimedOut);
+
+    // writes to the secondary ring buffer wake a reader waiting on the primary.
+    std::thread producer(
+        [&secondary]()
+        {
+            for (uint32_t i = 0; i < N_MESSAGES; ++i)
+            {
+                TestMessage message{1, i, i ^ 0x5555AAAA5555AAAAull};
+                while (!secondary.write(sizeof(message), (uint8_t *)&message))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    bool ok = true;
+    for (uint32_t i = 0; i < N_MESSAGES; ++i)
+    {
+        if (primary.readWaitAny_until(ready, std::chrono::steady_clock::now() + std::chrono::seconds(10)) != RingBufferStatus::Ready)
+        {
+            ok = false;
+            break;
+        }
+        TestMessage message;
+        secondary.read(sizeof(message), (uint8_t *)&message);
+        if (message.sequence != i)
+        {
+            ok = false;
+            break;
+        }
+    }
+    producer.join();
+    REQUIRE(ok);
+
+    // closing the primary releases the shared reader.
+    primary.close();
+    REQUIRE(primary.readWaitAny_until(ready, std::chrono::steady_clock::now() + std::chrono::seconds(1)) == RingBufferStatus::Closed);
+
+    REQUIRE(secondary.getOverflowCount() == 0);
+    secondary.recordOverflow();
+    REQUIRE(secondary.getOverflowCount() == 1);
+    REQUIRE(primary.getOverflowCount() == 0);
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "SandboxChannel.hpp"
+#include "Futex.hpp"
+#include "PiPedalException.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+static constexpr uint32_t SANDBOX_CHANNEL_MAGIC = 0x58444253; // "SBDX"
+static constexpr uint32_t SANDBOX_CHANNEL_VERSION = 1;
+
+static size_t AlignUp(size_t value)
+{
+    return (value + 63) & ~(size_t)63;
+}
+
+size_t SandboxChannel::MemorySize(const Layout &layout)
+{
+    return AlignUp(sizeof(Header)) +
+           AlignUp(layout.controls * sizeof(float)) * 2 +
+           AlignUp((size_t)(layout.inputCapacity + layout.outputCapacity) * layout.maxFrames * sizeof(float)) +
+           AlignUp(layout.configCapacity);
+}
+
+SandboxChannel::SandboxChannel(int fd, void *memory, size_t size)
+    : fd(fd), memory(memory), size(size)
+{
+    char *p = (char *)memory;
+    header = (Header *)p;
+    p += AlignUp(sizeof(Header));
+    inputControls = (float *)p;
+    p += AlignUp(header->layout.controls * sizeof(float));
+    outputControls = (float *)p;
+    p += AlignUp(header->layout.controls * sizeof(float));
+    audio = (float *)p;
+    p += AlignUp((size_t)(header->layout.inputCapacity + header->layout.outputCapacity) * header->layout.maxFrames * sizeof(float));
+    config = p;
+}
+
+SandboxChannel::~SandboxChannel()
+{
+    munmap(memory, size);
+    close(fd);
+}
+
+std::unique_ptr<SandboxChannel> SandboxChannel::Create(const Layout &layout)
+{
+    size_t size = MemorySize(layout);
+    int fd = memfd_create("pipedal-sandbox", MFD_CLOEXEC);
+    if (fd == -1)
+    {
+        throw PiPedalException(SS("Can't create sandbox shared memory. " << strerror(errno)));
+    }
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        int error = errno;
+        close(fd);
+        throw PiPedalException(SS("Can't create sandbox shared memory. " << strerror(error)));
+    }
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        int error = errno;
+        close(fd);
+        throw PiPedalException(SS("Can't map sandbox shared memory. " << strerror(error)));
+    }
+    // (the memfd is zero-filled.)
+    Header *header = new (memory) Header();
+    header->magic = SANDBOX_CHANNEL_MAGIC;
+    header->version = SANDBOX_CHANNEL_VERSION;
+    header->layout = layout;
+    header->requestSeq.store(0, std::memory_order_relaxed);
+    header->responseSeq.store(0, std::memory_order_relaxed);
+    header->state.store((uint32_t)SandboxState::Stopped, std::memory_order_relaxed);
+    return std::unique_ptr<SandboxChannel>(new SandboxChannel(fd, memory, size));
+}
+
+std::unique_ptr<SandboxChannel> SandboxChannel::Attach(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header))
+    {
+        throw PiPedalException("Invalid sandbox shared memory.");
+    }
+    size_t size = (size_t)st.st_size;
+    void *memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED)
+    {
+        throw PiPedalException(SS("Can't map sandbox shared memory. " << strerror(errno)));
+    }
+    const Header *header = (const Header *)memory;
+    if (header->magic != SANDBOX_CHANNEL_MAGIC || header->version != SANDBOX_CHANNEL_VERSION || MemorySize(header->layout) != size)
+    {
+        munmap(memory, size);
+        throw PiPedalException("Sandbox shared memory version mismatch.");
+    }
+    return std::unique_ptr<SandboxChannel>(new SandboxChannel(fd, memory, size));
+}
+
+void SandboxChannel::SetState(SandboxState state)
+{
+    header->state.store((uint32_t)state, std::memory_order_release);
+}
+
+void SandboxChannel::SetConfig(const std::string &config)
+{
+    if (config.size() > header->layout.configCapacity)
+    {
+        throw PiPedalException("Sandbox configuration is too large.");
+    }
+    std::memcpy(this->config, config.data(), config.size());
+    header->configSize = (uint32_t)config.size();
+}
+
+std::string SandboxChannel::GetConfig() const
+{
+    return std::string(config, std::min(header->configSize, header->layout.configCapacity));
+}
+
+void SandboxChannel::PostRequest(uint32_t frames)
+{
+    header->frames = frames;
+    header->requestSeq.store(header->requestSeq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    futex_wake_shared(&header->requestSeq);
+}
+
+bool SandboxChannel::WaitForResponse(std::chrono::nanoseconds timeout)
+{
+    using clock = std::chrono::steady_clock;
+    uint32_t requestSeq = header->requestSeq.load(std::memory_order_relaxed);
+    clock::time_point deadline = clock::now() + timeout;
+    while (true)
+    {
+        uint32_t responseSeq = header->responseSeq.load(std::memory_order_acquire);
+        if (responseSeq == requestSeq)
+        {
+            return true;
+        }
+        if (header->state.load(std::memory_order_acquire) != (uint32_t)SandboxState::Running)
+        {
+            return false;
+        }
+        if (!futex_wait_for_shared(&header->responseSeq, responseSeq, deadline - clock::now()))
+        {
+            return header->responseSeq.load(std::memory_order_acquire) == requestSeq;
+        }
+    }
+}
+
+void SandboxChannel::BeginServing()
+{
+    header->responseSeq.store(header->requestSeq.load(std::memory_order_acquire), std::memory_order_release);
+    futex_wake_shared(&header->responseSeq);
+    SetState(SandboxState::Running);
+}
+
+bool SandboxChannel::WaitForRequest(uint32_t *seq, std::chrono::nanoseconds timeout)
+{
+    uint32_t lastSeq = header->responseSeq.load(std::memory_order_relaxed);
+    uint32_t requestSeq = header->requestSeq.load(std::memory_order_acquire);
+    if (requestSeq == lastSeq)
+    {
+        futex_wait_for_shared(&header->requestSeq, lastSeq, timeout);
+        requestSeq = header->requestSeq.load(std::memory_order_acquire);
+        if (requestSeq == lastSeq)
+        {
+            return false;
+        }
+    }
+    *seq = requestSeq;
+    return true;
+}
+
+void SandboxChannel::PostResponse(uint32_t seq)
+{
+    header->responseSeq.store(seq, std::memory_order_release);
+    futex_wake_shared(&header->responseSeq);
+}
@@ -0,0 +1,136 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pipedal
+{
+    enum class SandboxState : uint32_t
+    {
+        Starting = 0, // the sandbox process is loading the plugin.
+        Running = 1,  // the sandbox is serving requests.
+        Stopped = 2,  // the sandbox process has exited (or failed to load the plugin).
+    };
+
+    /**
+     * @brief Shared memory through which pipedald and a pipedal_sandbox process exchange audio for one plugin.
+     *
+     * A memfd holds a header, input control values, output control values, input and output audio buffers, and
+     * the JSON of the pedalboard item that the sandbox should instantiate. Requests and responses are
+     * sequence numbers on two process-shared futexes: the host writes inputs and controls, and bumps
+     * requestSeq; the sandbox runs the plugin, writes outputs, and sets responseSeq to the request it served.
+     * Buffers belong to the host while responseSeq == requestSeq, and to the sandbox otherwise.
+     */
+    class SandboxChannel
+    {
+    public:
+        struct Layout
+        {
+            double sampleRate = 48000;
+            uint32_t maxFrames = 0;
+            uint32_t inputCapacity = 0;
+            uint32_t outputCapacity = 0;
+            uint32_t controls = 0;
+            uint32_t configCapacity = 0;
+        };
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t version;
+            Layout layout;
+
+            // Written by the host before the sandbox is started.
+            uint32_t inputs;           // audio input buffers in use.
+            uint32_t outputs;          // audio output buffers in use.
+            uint32_t noInputChannels;  // the argument to IEffect::PrepareNoInputEffect.
+            uint32_t hostInputChannels;
+            uint32_t hostOutputChannels;
+            uint32_t configSize;
+
+            // Request: written by the host, and published by requestSeq.
+            alignas(64) std::atomic<uint32_t> requestSeq;
+            uint32_t frames;
+            uint32_t bypass;
+
+            // Response: published by the sandbox.
+            alignas(64) std::atomic<uint32_t> responseSeq;
+            std::atomic<uint32_t> state;
+        };
+
+        // Host: allocates the shared memory.
+        static std::unique_ptr<SandboxChannel> Create(const Layout &layout);
+        // Sandbox: maps shared memory that was created by the host, and inherited as fd.
+        static std::unique_ptr<SandboxChannel> Attach(int fd);
+
+        ~SandboxChannel();
+        SandboxChannel(const SandboxChannel &) = delete;
+        SandboxChannel &operator=(const SandboxChannel &) = delete;
+
+        int Fd() const { return fd; }
+        Header *GetHeader() const { return header; }
+        SandboxState GetState() const { return (SandboxState)header->state.load(std::memory_order_acquire); }
+        void SetState(SandboxState state);
+
+        float *InputBuffer(uint32_t index) const { return audio + (size_t)index * header->layout.maxFrames; }
+        float *OutputBuffer(uint32_t index) const { return audio + (size_t)(header->layout.inputCapacity + index) * header->layout.maxFrames; }
+        float *InputControls() const { return inputControls; }
+        float *OutputControls() const { return outputControls; }
+
+        void SetConfig(const std::string &config);
+        std::string GetConfig() const;
+
+        // Host side. Realtime-safe.
+        bool IsResponsePending() const
+        {
+            return header->responseSeq.load(std::memory_order_acquire) != header->requestSeq.load(std::memory_order_relaxed);
+        }
+        void PostRequest(uint32_t frames);
+        // Returns false if the sandbox hasn't responded to the last request within the timeout.
+        bool WaitForResponse(std::chrono::nanoseconds timeout);
+
+        // Sandbox side.
+        // Discard any request that was made before the sandbox started, and start serving.
+        void BeginServing();
+        // Returns false on timeout. Otherwise *seq is the request to serve.
+        bool WaitForRequest(uint32_t *seq, std::chrono::nanoseconds timeout);
+        void PostResponse(uint32_t seq);
+
+    private:
+        SandboxChannel(int fd, void *memory, size_t size);
+        static size_t MemorySize(const Layout &layout);
+
+        int fd;
+        void *memory;
+        size_t size;
+        Header *header;
+        float *inputControls;
+        float *outputControls;
+        float *audio;
+        char *config;
+    };
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SandboxChannel.hpp"
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace pipedal;
+using namespace std::chrono_literals;
+
+// Stands in for pipedal_sandbox: output = 2 * input; output controls = input controls + 1.
+static void ServeDoubler(int fd, uint32_t requests)
+{
+    auto channel = SandboxChannel::Attach(fd);
+    auto *header = channel->GetHeader();
+    channel->BeginServing();
+    while (requests != 0)
+    {
+        uint32_t seq;
+        if (!channel->WaitForRequest(&seq, 5s))
+        {
+            _exit(2);
+        }
+        for (uint32_t c = 0; c < header->inputs; ++c)
+        {
+            const float *input = channel->InputBuffer(c);
+            float *output = channel->OutputBuffer(c);
+            for (uint32_t i = 0; i < header->frames; ++i)
+            {
+                output[i] = input[i] * 2;
+            }
+        }
+        for (uint32_t i = 0; i < header->layout.controls; ++i)
+        {
+            channel->OutputControls()[i] = channel->InputControls()[i] + 1;
+        }
+        channel->PostResponse(seq);
+        --requests;
+    }
+    channel->SetState(SandboxState::Stopped);
+}
+
+TEST_CASE("SandboxChannel test", "[sandbox_channel][Build][Dev]")
+{
+    SandboxChannel::Layout layout;
+    layout.maxFrames = 64;
+    layout.inputCapacity = 2;
+    layout.outputCapacity = 2;
+    layout.controls = 3;
+    layout.configCapacity = 256;
+    auto channel = SandboxChannel::Create(layout);
+    auto *header = channel->GetHeader();
+    header->inputs = 2;
+    header->outputs = 2;
+    channel->SetConfig("{\"uri\": \"urn:test\"}");
+    REQUIRE(channel->GetConfig() == "{\"uri\": \"urn:test\"}");
+    REQUIRE(channel->GetState() == SandboxState::Stopped);
+
+    // a request made before the sandbox starts is discarded.
+    channel->PostRequest(16);
+    REQUIRE(channel->IsResponsePending());
+    REQUIRE(!channel->WaitForResponse(1ms));
+
+    constexpr uint32_t REQUESTS = 100;
+    pid_t pid = fork();
+    REQUIRE(pid != -1);
+    if (pid == 0)
+    {
+        ServeDoubler(dup(channel->Fd()), REQUESTS);
+        _exit(0);
+    }
+    while (channel->GetState() != SandboxState::Running)
+    {
+        std::this_thread::sleep_for(1ms);
+    }
+    REQUIRE(!channel->IsResponsePending());
+
+    for (uint32_t request = 0; request < REQUESTS; ++request)
+    {
+        uint32_t frames = 1 + request % layout.maxFrames;
+        for (uint32_t c = 0; c < 2; ++c)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                channel->InputBuffer(c)[i] = (float)(request + c + i);
+            }
+        }
+        channel->InputControls()[1] = (float)request;
+        channel->PostRequest(frames);
+        REQUIRE(channel->WaitForResponse(5s));
+        REQUIRE(!channel->IsResponsePending());
+        for (uint32_t c = 0; c < 2; ++c)
+        {
+            for (uint32_t i = 0; i < frames; ++i)
+            {
+                REQUIRE(channel->OutputBuffer(c)[i] == (float)(request + c + i) * 2);
+            }
+        }
+        REQUIRE(channel->OutputControls()[1] == (float)request + 1);
+    }
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    // no response from a sandbox that has stopped.
+    REQUIRE(channel->GetState() == SandboxState::Stopped);
+    channel->PostRequest(16);
+    REQUIRE(!channel->WaitForResponse(10ms));
+}
@@ -0,0 +1,400 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "SandboxedEffect.hpp"
+#include "IHost.hpp"
+#include "PluginHost.hpp"
+#include "Pedalboard.hpp"
+#include "PiPedalException.hpp"
+#include "Lv2Log.hpp"
+#include "json.hpp"
+#include "ss.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+// the channel's fd, as seen by pipedal_sandbox.
+static constexpr int SANDBOX_CHANNEL_FD = 3;
+static constexpr int MAX_SANDBOX_RESTARTS = 5;
+static constexpr size_t SANDBOX_CONFIG_CAPACITY = 1024 * 1024;
+
+fs::path SandboxedEffect::GetSandboxExecutablePath()
+{
+    // installed alongside pipedald.
+    return fs::read_symlink("/proc/self/exe").parent_path() / "pipedal_sandbox";
+}
+
+SandboxedEffect::SandboxedEffect(
+    IHost *pHost,
+    const std::shared_ptr<Lv2PluginInfo> &info,
+    PedalboardItem &pedalboardItem,
+    const fs::path &configDirectory)
+    : info(info),
+      instanceId(pedalboardItem.instanceId()),
+      pluginName(pedalboardItem.pluginName()),
+      sampleRate(pHost->GetSampleRate()),
+      configDirectory(configDirectory),
+      pluginStoragePath(pHost->GetPluginStoragePath()),
+      bypass(pedalboardItem.isEnabled())
+{
+    size_t nPorts = info->ports().size();
+    isInputControl.resize(nPorts);
+    defaultInputControlValues.resize(nPorts);
+    controlValues.resize(nPorts);
+    outputControlValues.resize(nPorts);
+
+    for (const auto &port : info->ports())
+    {
+        uint32_t portIndex = port->index();
+        if (port->is_audio_port())
+        {
+            if (port->is_sidechain())
+            {
+                continue; // the sandbox connects sidechain inputs to silence.
+            }
+            if (port->is_input())
+            {
+                ++inputAudioPorts;
+            }
+            else
+            {
+                ++outputAudioPorts;
+            }
+        }
+        else if (port->is_control_port() && port->is_input())
+        {
+            isInputControl.at(portIndex) = true;
+            defaultInputControlValues.at(portIndex) = port->default_value();
+            controlValues.at(portIndex) = port->default_value();
+        }
+    }
+    maxInputControl = isInputControl.size();
+    while (maxInputControl != 0 && !isInputControl.at(maxInputControl - 1))
+    {
+        --maxInputControl;
+    }
+    for (const auto &controlValue : pedalboardItem.controlValues())
+    {
+        int index = info->GetControlIndex(controlValue.key());
+        if (index >= 0 && (size_t)index < controlValues.size())
+        {
+            controlValues[index] = controlValue.value();
+        }
+    }
+    inputBuffers.resize(inputAudioPorts);
+    outputBuffers.resize(outputAudioPorts);
+
+    SandboxChannel::Layout layout;
+    layout.sampleRate = sampleRate;
+    layout.maxFrames = (uint32_t)pHost->GetMaxAudioBufferSize();
+    layout.inputCapacity = (uint32_t)std::max(inputAudioPorts, 2);
+    layout.outputCapacity = (uint32_t)std::max(outputAudioPorts, 2);
+    layout.controls = (uint32_t)nPorts;
+    layout.configCapacity = SANDBOX_CONFIG_CAPACITY;
+    channel = SandboxChannel::Create(layout);
+
+    auto *header = channel->GetHeader();
+    header->hostInputChannels = (uint32_t)pHost->GetNumberOfInputAudioChannels();
+    header->hostOutputChannels = (uint32_t)pHost->GetNumberOfOutputAudioChannels();
+    header->bypass = bypass;
+
+    std::stringstream s;
+    json_writer writer(s, true);
+    writer.write(pedalboardItem);
+    channel->SetConfig(s.str());
+}
+
+SandboxedEffect::~SandboxedEffect()
+{
+    if (supervisorThread)
+    {
+        supervisorThread->request_stop();
+        supervisorCv.notify_all();
+        supervisorThread = nullptr; // joins, after stopping the sandbox.
+    }
+}
+
+int SandboxedEffect::GetControlIndex(const std::string &symbol) const
+{
+    return info->GetControlIndex(symbol);
+}
+
+void SandboxedEffect::SetControl(int index, float value)
+{
+    if (index == -1)
+    {
+        SetBypass(value != 0);
+    }
+    else
+    {
+        controlValues[index] = value;
+    }
+}
+
+float SandboxedEffect::GetControlValue(int index) const
+{
+    if (index == -1)
+    {
+        return this->bypass ? 1 : 0;
+    }
+    return controlValues[index];
+}
+
+float SandboxedEffect::GetOutputControlValue(int index) const
+{
+    if (index >= 0 && (size_t)index < outputControlValues.size())
+    {
+        return outputControlValues[index];
+    }
+    return 0;
+}
+
+void SandboxedEffect::PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize)
+{
+    // the same buffer arrangement that Lv2Effect::PrepareNoInputEffect makes in the sandbox.
+    if (outputAudioPorts == 0)
+    {
+        inputBuffers.resize(std::max(numberOfInputs, inputAudioPorts));
+        outputBuffers.resize(0);
+    }
+    else if (inputAudioPorts == 0)
+    {
+        inputBuffers.resize(numberOfInputs);
+        outputBuffers.resize(std::max(numberOfInputs, outputAudioPorts));
+    }
+    auto *header = channel->GetHeader();
+    if (inputBuffers.size() > header->layout.inputCapacity || outputBuffers.size() > header->layout.outputCapacity)
+    {
+        throw PiPedalStateException("Too many sandbox audio channels.");
+    }
+    header->noInputChannels = (uint32_t)numberOfInputs;
+}
+
+void SandboxedEffect::Activate()
+{
+    if (!supervisorThread)
+    {
+        auto *header = channel->GetHeader();
+        header->inputs = (uint32_t)inputBuffers.size();
+        header->outputs = (uint32_t)outputBuffers.size();
+        supervisorThread = std::make_unique<std::jthread>(
+            [this](std::stop_token stopToken)
+            { SupervisorProc(stopToken); });
+    }
+}
+
+void SandboxedEffect::PassThrough(uint32_t frames)
+{
+    size_t inputs = inputBuffers.size();
+    for (size_t i = 0; i < outputBuffers.size(); ++i)
+    {
+        float *output = outputBuffers[i];
+        if (inputs == 0)
+        {
+            std::fill(output, output + frames, 0.0f);
+        }
+        else
+        {
+            float *input = inputBuffers[std::min(i, inputs - 1)];
+            if (input != output)
+            {
+                std::copy(input, input + frames, output);
+            }
+        }
+    }
+}
+
+void SandboxedEffect::Run(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter)
+{
+    auto *header = channel->GetHeader();
+    bool haveOutput = false;
+    if (channel->GetState() != SandboxState::Running)
+    {
+        requestPending = false;
+    }
+    else
+    {
+        if (requestPending)
+        {
+            // the sandbox has had a whole period to process the previous request; don't wait for it for more than half of this one.
+            std::chrono::nanoseconds timeout{(int64_t)(frames * 0.5E9 / sampleRate)};
+            if (channel->WaitForResponse(timeout))
+            {
+                requestPending = false;
+                haveOutput = true;
+            }
+            else
+            {
+                latePeriods.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (haveOutput)
+        {
+            uint32_t responseFrames = std::min(header->frames, frames);
+            for (size_t i = 0; i < outputBuffers.size(); ++i)
+            {
+                const float *source = channel->OutputBuffer((uint32_t)i);
+                std::copy(source, source + responseFrames, outputBuffers[i]);
+                std::fill(outputBuffers[i] + responseFrames, outputBuffers[i] + frames, 0.0f);
+            }
+            std::copy(channel->OutputControls(), channel->OutputControls() + outputControlValues.size(), outputControlValues.begin());
+        }
+        if (!requestPending)
+        {
+            for (size_t i = 0; i < inputBuffers.size(); ++i)
+            {
+                std::copy(inputBuffers[i], inputBuffers[i] + frames, channel->InputBuffer((uint32_t)i));
+            }
+            std::copy(controlValues.begin(), controlValues.end(), channel->InputControls());
+            header->bypass = bypass;
+            channel->PostRequest(frames);
+            requestPending = true;
+        }
+    }
+    if (!haveOutput)
+    {
+        PassThrough(frames);
+    }
+}
+
+pid_t SandboxedEffect::Spawn()
+{
+    std::string executable = GetSandboxExecutablePath().string();
+    std::string fdArg = SS(SANDBOX_CHANNEL_FD);
+    std::string parentArg = SS(getpid());
+    std::vector<const char *> argv{
+        executable.c_str(),
+        "--fd", fdArg.c_str(),
+        "--parent", parentArg.c_str(),
+        configDirectory.c_str(),
+        pluginStoragePath.c_str(),
+        nullptr};
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    // (dup2 clears FD_CLOEXEC on the copy.)
+    posix_spawn_file_actions_adddup2(&fileActions, channel->Fd(), SANDBOX_CHANNEL_FD);
+
+    pid_t pid = -1;
+    int rc = posix_spawn(&pid, executable.c_str(), &fileActions, nullptr, (char *const *)argv.data(), environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+    if (rc != 0)
+    {
+        Lv2Log::error(SS("Sandbox: can't start " << executable << ". " << strerror(rc)));
+        return -1;
+    }
+    return pid;
+}
+
+bool SandboxedEffect::WaitForStop(std::stop_token &stopToken, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(supervisorMutex);
+    return supervisorCv.wait_for(lock, stopToken, timeout, []()
+                                 { return false; }) ||
+           stopToken.stop_requested();
+}
+
+void SandboxedEffect::SupervisorProc(std::stop_token stopToken)
+{
+    SetThreadName("sandbox");
+    using clock = std::chrono::steady_clock;
+
+    int failures = 0;
+    uint64_t reportedLatePeriods = 0;
+    clock::time_point lastLateReport = clock::now();
+
+    while (!stopToken.stop_requested())
+    {
+        channel->SetState(SandboxState::Starting);
+        pid_t pid = Spawn();
+        if (pid != -1)
+        {
+            Lv2Log::info(SS("Sandbox: started '" << pluginName << "' (pid " << pid << ")."));
+            clock::time_point started = clock::now();
+            int status = 0;
+            while (true)
+            {
+                if (waitpid(pid, &status, WNOHANG) == pid)
+                {
+                    break;
+                }
+                if (WaitForStop(stopToken, std::chrono::milliseconds(50)))
+                {
+                    kill(pid, SIGTERM);
+                    for (int i = 0; i < 20 && waitpid(pid, &status, WNOHANG) != pid; ++i)
+                    {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                    }
+                    if (waitpid(pid, &status, WNOHANG) != pid)
+                    {
+                        kill(pid, SIGKILL);
+                        waitpid(pid, &status, 0);
+                    }
+                    channel->SetState(SandboxState::Stopped);
+                    return;
+                }
+                clock::time_point now = clock::now();
+                if (now - lastLateReport >= std::chrono::seconds(10))
+                {
+                    lastLateReport = now;
+                    uint64_t late = latePeriods.load(std::memory_order_relaxed);
+                    if (late != reportedLatePeriods)
+                    {
+                        Lv2Log::warning(SS("Sandbox: '" << pluginName << "' missed " << (late - reportedLatePeriods) << " periods."));
+                        reportedLatePeriods = late;
+                    }
+                }
+            }
+            channel->SetState(SandboxState::Stopped);
+            if (WIFSIGNALED(status))
+            {
+                Lv2Log::error(SS("Sandbox: '" << pluginName << "' crashed (" << strsignal(WTERMSIG(status)) << ")."));
+            }
+            else
+            {
+                Lv2Log::error(SS("Sandbox: '" << pluginName << "' exited with status " << WEXITSTATUS(status) << "."));
+            }
+            if (clock::now() - started > std::chrono::minutes(1))
+            {
+                failures = 0;
+            }
+        }
+        channel->SetState(SandboxState::Stopped);
+        if (++failures > MAX_SANDBOX_RESTARTS)
+        {
+            Lv2Log::error(SS("Sandbox: '" << pluginName << "' has failed too many times, and won't be restarted."));
+            return;
+        }
+        if (WaitForStop(stopToken, std::chrono::milliseconds(1000 << std::min(failures - 1, 4))))
+        {
+            return;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "IEffect.hpp"
+#include "SandboxChannel.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    class IHost;
+    class Lv2PluginInfo;
+    class PedalboardItem;
+
+    /**
+     * @brief An LV2 plugin that runs in a pipedal_sandbox process, so that a crash in the plugin doesn't take
+     * down pipedald.
+     *
+     * Audio and control values are exchanged through a SandboxChannel. Processing is pipelined: each period,
+     * Run() collects the output of the previous period's request and posts a new one, so the sandbox runs on
+     * another core in parallel with the rest of the pedalboard, at the cost of one period of latency.
+     * While the sandbox is starting, restarting, or late, the input is passed through unprocessed.
+     *
+     * A supervisor thread restarts the sandbox if it exits, with back-off; the pedalboard isn't rebuilt.
+     * Patch properties, MIDI and LV2 state changes made after the sandbox has started are not forwarded.
+     */
+    class SandboxedEffect : public IEffect
+    {
+    public:
+        SandboxedEffect(
+            IHost *pHost,
+            const std::shared_ptr<Lv2PluginInfo> &info,
+            PedalboardItem &pedalboardItem,
+            const std::filesystem::path &configDirectory);
+        virtual ~SandboxedEffect();
+
+        static std::filesystem::path GetSandboxExecutablePath();
+
+        virtual uint64_t GetInstanceId() const override { return instanceId; }
+        virtual bool IsLv2Effect() const override { return false; }
+        virtual uint64_t GetMaxInputControl() const override { return maxInputControl; }
+        virtual bool IsInputControl(uint64_t index) const override { return index < isInputControl.size() && isInputControl[index]; }
+        virtual float GetDefaultInputControlValue(uint64_t index) const override { return defaultInputControlValues.at(index); }
+
+        virtual int GetControlIndex(const std::string &symbol) const override;
+        virtual void SetControl(int index, float value) override;
+        virtual float GetControlValue(int index) const override;
+        virtual float GetOutputControlValue(int index) const override;
+        virtual void SetBypass(bool enable) override { this->bypass = enable; }
+
+        virtual void SetPatchProperty(LV2_URID uridUri, size_t size, LV2_Atom *value) override {}
+        virtual void RequestPatchProperty(LV2_URID uridUri) override {}
+        virtual void RequestAllPathPatchProperties() override {}
+
+        virtual int GetNumberOfInputAudioPorts() const override { return inputAudioPorts; }
+        virtual int GetNumberOfOutputAudioPorts() const override { return outputAudioPorts; }
+        virtual int GetNumberOfInputAudioBuffers() const override { return (int)inputBuffers.size(); }
+        virtual int GetNumberOfOutputAudioBuffers() const override { return (int)outputBuffers.size(); }
+        virtual float *GetAudioInputBuffer(int index) const override { return inputBuffers.at(index); }
+        virtual float *GetAudioOutputBuffer(int index) const override { return outputBuffers.at(index); }
+        virtual void SetAudioInputBuffer(int index, float *buffer) override { inputBuffers.at(index) = buffer; }
+        virtual void SetAudioOutputBuffer(int index, float *buffer) override { outputBuffers.at(index) = buffer; }
+        virtual void ResetAtomBuffers() override {}
+
+        virtual bool GetRequestStateChangedNotification() const override { return requestStateChangedNotification; }
+        virtual void SetRequestStateChangedNotification(bool value) override { requestStateChangedNotification = value; }
+
+        virtual void PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize) override;
+
+        virtual void Activate() override;
+        virtual void Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter) override;
+        virtual void Deactivate() override {}
+
+        virtual bool IsVst3() const override { return false; }
+        virtual bool GetLv2State(Lv2PluginState *state) override { return false; }
+        virtual void SetLv2State(Lv2PluginState &state) override {}
+
+        virtual bool HasErrorMessage() const override { return false; }
+        virtual const char *TakeErrorMessage() override { return ""; }
+
+    private:
+        void PassThrough(uint32_t frames);
+        pid_t Spawn();
+        void SupervisorProc(std::stop_token stopToken);
+        bool WaitForStop(std::stop_token &stopToken, std::chrono::milliseconds timeout);
+
+        std::shared_ptr<Lv2PluginInfo> info;
+        uint64_t instanceId;
+        std::string pluginName;
+        double sampleRate;
+        std::filesystem::path configDirectory;
+        std::filesystem::path pluginStoragePath;
+
+        int inputAudioPorts = 0;
+        int outputAudioPorts = 0;
+        std::vector<float *> inputBuffers;
+        std::vector<float *> outputBuffers;
+
+        uint64_t maxInputControl = 0;
+        std::vector<bool> isInputControl;
+        std::vector<float> defaultInputControlValues;
+        std::vector<float> controlValues;
+        std::vector<float> outputControlValues;
+        bool bypass = true;
+        bool requestStateChangedNotification = false;
+
+        std::unique_ptr<SandboxChannel> channel;
+        bool requestPending = false;               // audio thread only.
+        std::atomic<uint64_t> latePeriods{0};      // written by the audio thread.
+
+        std::mutex supervisorMutex;
+        std::condition_variable_any supervisorCv;
+        std::unique_ptr<std::jthread> supervisorThread;
+    };
+}
@@ -22,9 +22,14 @@
 #include "memory.h"
 #include "sched.h"
 #include "ss.hpp"
+#include "CpuList.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <pthread.h>
 
 #include <unistd.h> // for nice().
+#include <sys/resource.h> // for setpriority().
+#include <sys/syscall.h> // for ioprio_set.
 
 
 using namespace pipedal;
@@ -33,6 +38,8 @@ static constexpr int EXPECTED_RT_THREAD_PRIORITY_MAX = 95;
 
 static constexpr int RT_AUDIO_THREAD_PRIORITY = 90; // one above pipewire.
 
+static constexpr int RT_AUDIO_HELPER_THREAD_PRIORITY = 90; // same as the audio thread; pinned to a different core.
+
 static constexpr int RT_AUDIOSERVICE_THREAD_PRIORITY = 85; // one above pipewire service thread
 
 static constexpr int RT_LV2SCHEDULER_THREAD_PRIORITY = 5;
@@ -40,6 +47,108 @@ static constexpr int RT_LV2SCHEDULER_THREAD_PRIORITY = 5;
 static constexpr int RT_WEBSERVER_THREAD_PRIORITY = -1;
 
 static constexpr int NICE_WEBSERVER_PROCESS_PRIORITY = -9; // above chrome renderer, below pipewire..
+static constexpr int NICE_BACKGROUND_THREAD_PRIORITY = 10;
+
+// from linux/ioprio.h, which glibc doesn't wrap.
+static constexpr int IOPRIO_CLASS_SHIFT = 13;
+static constexpr int IOPRIO_CLASS_IDLE = 3;
+static constexpr int IOPRIO_WHO_PROCESS = 1;
+
+std::vector<int> CpuAffinityPlan::realtimeCpus;
+std::vector<int> CpuAffinityPlan::backgroundCpus;
+
+void CpuAffinityPlan::Configure(const std::string &realtimeCpuList)
+{
+    realtimeCpus.clear();
+    backgroundCpus.clear();
+
+    std::vector<int> cpus = ParseCpuList(realtimeCpuList);
+    if (cpus.empty())
+    {
+        return;
+    }
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    std::vector<int> realtime;
+    for (int cpu : cpus)
+    {
+        if (cpu < nCpus && cpu < CPU_SETSIZE)
+        {
+            realtime.push_back(cpu);
+        }
+        else
+        {
+            Lv2Log::warning(SS("CPU affinity: cpu " << cpu << " does not exist."));
+        }
+    }
+    std::vector<int> background;
+    for (int cpu = 0; cpu < nCpus && cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (std::find(realtime.begin(), realtime.end(), cpu) == realtime.end())
+        {
+            background.push_back(cpu);
+        }
+    }
+    if (realtime.empty() || background.empty())
+    {
+        Lv2Log::warning(SS("CPU affinity: realtime cpus '" << realtimeCpuList << "' ignored. At least one cpu must be left for background tasks."));
+        return;
+    }
+    realtimeCpus = std::move(realtime);
+    backgroundCpus = std::move(background);
+    Lv2Log::info(SS("CPU affinity: realtime cpus " << FormatCpuList(realtimeCpus) << ", background cpus " << FormatCpuList(backgroundCpus) << "."));
+}
+
+int CpuAffinityPlan::AudioCpu()
+{
+    return realtimeCpus.empty() ? -1 : realtimeCpus[0];
+}
+int CpuAffinityPlan::HelperCpu()
+{
+    return realtimeCpus.size() < 2 ? -1 : realtimeCpus[1];
+}
+
+static void setAffinity(const std::vector<int> &cpus, const char *priorityName)
+{
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus)
+    {
+        CPU_SET(cpu, &cpuSet);
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0)
+    {
+        Lv2Log::warning(SS("Failed to set cpu affinity for " << priorityName << " (" << strerror(result) << ")"));
+    }
+}
+
+void CpuAffinityPlan::SetBackgroundAffinity()
+{
+    if (Enabled())
+    {
+        setAffinity(backgroundCpus, "Background");
+    }
+}
+
+static void applyCpuAffinityPlan(SchedulerPriority priority)
+{
+    if (!CpuAffinityPlan::Enabled())
+    {
+        return;
+    }
+    switch (priority)
+    {
+    case SchedulerPriority::RealtimeAudio:
+        setAffinity({CpuAffinityPlan::AudioCpu()}, "RealtimeAudio");
+        break;
+    case SchedulerPriority::RealtimeAudioHelper:
+        // pinned by RealtimeHelperThread.
+        break;
+    default:
+        setAffinity(CpuAffinityPlan::BackgroundCpus(), "Background");
+        break;
+    }
+}
 
 bool pipedal::IsRtPreemptKernel(SchedulerPriority priority)
 {
@@ -118,11 +227,15 @@ void pipedal::SetThreadPriority(SchedulerPriority priority)
 {
 
 #if defined(__linux__)
+    applyCpuAffinityPlan(priority);
     switch (priority)
     {
     case SchedulerPriority::RealtimeAudio:
         SetPriority(RT_AUDIO_THREAD_PRIORITY, "RealtimeAudio");
         break;
+    case SchedulerPriority::RealtimeAudioHelper:
+        SetPriority(RT_AUDIO_HELPER_THREAD_PRIORITY, "RealtimeAudioHelper");
+        break;
     case SchedulerPriority::AudioService:
         SetPriority(RT_AUDIOSERVICE_THREAD_PRIORITY, "AudioService");
         break;
@@ -143,6 +256,34 @@ void pipedal::SetThreadPriority(SchedulerPriority priority)
             }
         }
         break;
+    case SchedulerPriority::Background:
+        {
+            // SCHED_OTHER with a per-thread (linux) nice value.
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            sched_setscheduler(0, SCHED_OTHER, &param);
+            if (setpriority(PRIO_PROCESS, (id_t)gettid(), NICE_BACKGROUND_THREAD_PRIORITY) != 0)
+            {
+                Lv2Log::warning("Failed to set background thread priority.");
+            }
+        }
+        break;
+    case SchedulerPriority::BackgroundBatch:
+        {
+            // nice and ionice values are per-thread on linux, and are inherited by child processes.
+            struct sched_param param;
+            memset(&param, 0, sizeof(param));
+            sched_setscheduler(0, SCHED_OTHER, &param);
+            if (setpriority(PRIO_PROCESS, (id_t)gettid(), NICE_BACKGROUND_THREAD_PRIORITY) != 0)
+            {
+                Lv2Log::warning("Failed to set background thread priority.");
+            }
+            if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, (int)gettid(), IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0)
+            {
+                Lv2Log::warning("Failed to set background thread I/O priority.");
+            }
+        }
+        break;
     default:
         Lv2Log::error("Invalid scheduler priority.");
         throw std::runtime_error("Invalid value.");
@@ -19,15 +19,53 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 namespace pipedal {
     enum class SchedulerPriority {
         RealtimeAudio, // the audio service thread.
+        RealtimeAudioHelper, // helper threads that process part of a pedalboard on behalf of the audio thread.
         AudioService, // non-realtime servicing of AudioThread responses.
         Lv2Scheduler, // LV2 Scheduler service thread.
         WebServerThread, // Web server threads.
+        Background, // non-urgent work that must not compete with the web server or the audio services (e.g. preloading presets).
+        BackgroundBatch, // as Background, but also in the idle I/O class (e.g. ffmpeg jobs that scan audio files).
     };
 
     bool IsRtPreemptKernel(SchedulerPriority priority);
 
+    // Also applies the CpuAffinityPlan, if there is one.
     void SetThreadPriority(SchedulerPriority priority);
+
+    /**
+     * @brief Which cores PiPedal threads run on.
+     *
+     * The first realtime cpu runs the audio thread, and the second (if there is one) runs the
+     * parallel split helper thread. Everything else (web server, LV2 workers, ffmpeg jobs, &c) runs
+     * on the remaining cpus. The realtime cpus should also be excluded from general scheduling with
+     * the isolcpus= kernel parameter (see BootConfig), so that other processes stay off them too.
+     *
+     * Configure once at startup, before starting any threads.
+     */
+    class CpuAffinityPlan
+    {
+    public:
+        // realtimeCpus: a cpu list (e.g. "2-3"). Empty to let the scheduler decide. Throws std::invalid_argument.
+        static void Configure(const std::string &realtimeCpus);
+
+        static bool Enabled() { return !realtimeCpus.empty(); }
+        static const std::vector<int> &RealtimeCpus() { return realtimeCpus; }
+        static const std::vector<int> &BackgroundCpus() { return backgroundCpus; }
+        static int AudioCpu(); // -1 if not configured.
+        static int HelperCpu(); // -1 if not configured.
+
+        // Pins the calling thread to the background cpus. Threads and processes started by the
+        // calling thread inherit its affinity.
+        static void SetBackgroundAffinity();
+
+    private:
+        static std::vector<int> realtimeCpus;
+        static std::vector<int> backgroundCpus;
+    };
 }
\ No newline at end of file
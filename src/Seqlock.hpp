@@ -0,0 +1,93 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace pipedal
+{
+    // A seqlock-protected copy of T, stored as atomic words so that concurrent reads are well-defined.
+    // An odd sequence number means a write is in progress; writers claim the section by
+    // incrementing from even to odd, so more than one thread may write (rarely) without corrupting it.
+    //
+    // Address-free, so it may live in shared memory (see MetricsPage).
+    template <typename T>
+    struct Seqlock
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static constexpr size_t N_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<uint64_t> words[N_WORDS] = {};
+
+        void Write(const T &value)
+        {
+            uint64_t buffer[N_WORDS] = {};
+            memcpy(buffer, &value, sizeof(T));
+
+            uint32_t seq = sequence.load(std::memory_order_relaxed);
+            while (true)
+            {
+                if ((seq & 1) == 0 && sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    break;
+                }
+                seq = sequence.load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < N_WORDS; ++i)
+            {
+                words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        // Lock-free. Retries while a writer is mid-update.
+        T Read() const
+        {
+            uint64_t buffer[N_WORDS];
+            while (true)
+            {
+                uint32_t seq0 = sequence.load(std::memory_order_acquire);
+                if (seq0 & 1)
+                {
+                    continue;
+                }
+                for (size_t i = 0; i < N_WORDS; ++i)
+                {
+                    buffer[i] = words[i].load(std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == seq0)
+                {
+                    break;
+                }
+            }
+            T result;
+            memcpy(&result, buffer, sizeof(T));
+            return result;
+        }
+    };
+}
@@ -0,0 +1,75 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "SessionReplayLog.hpp"
+#include <stdexcept>
+
+using namespace pipedal;
+
+SessionReplayLog::SessionReplayLog(size_t maxMessages, size_t maxBytes)
+    : maxMessages(maxMessages), maxBytes(maxBytes)
+{
+}
+
+const std::string &SessionReplayLog::Append(const std::string &message)
+{
+    if (message.size() < 2 || message[0] != '[' || message[1] != '{')
+    {
+        throw std::invalid_argument("SessionReplayLog: invalid message.");
+    }
+    ++lastSequence;
+    std::string text;
+    text.reserve(message.size() + 32);
+    text.append("[{\"seq\":");
+    text.append(std::to_string(lastSequence));
+    if (message[2] != '}')
+    {
+        text.append(",");
+    }
+    text.append(message, 2, std::string::npos);
+
+    bytes += text.size();
+    messages.push_back(std::move(text));
+    while (messages.size() > 1 && (messages.size() > maxMessages || bytes > maxBytes))
+    {
+        bytes -= messages.front().size();
+        messages.pop_front();
+    }
+    return messages.back();
+}
+
+bool SessionReplayLog::GetMessagesAfter(uint64_t sequence, std::vector<std::string> *result) const
+{
+    if (sequence > lastSequence)
+    {
+        return false; // not a sequence number from this session.
+    }
+    uint64_t firstSequence = lastSequence - messages.size() + 1;
+    if (sequence + 1 < firstSequence)
+    {
+        return false;
+    }
+    for (size_t i = (size_t)(sequence + 1 - firstSequence); i < messages.size(); ++i)
+    {
+        result->push_back(messages[i]);
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Bounded log of the model events sent to a websocket session, so that a client that reconnects
+     * can be sent only the events it missed.
+     *
+     * Each event is given the next sequence number, which is added to the message header as "seq".
+     * The oldest events are discarded once the log exceeds its message or byte limit; a client that
+     * missed a discarded event has to fetch the full state again.
+     *
+     * Not thread-safe. The socket handler guards it with its write mutex.
+     */
+    class SessionReplayLog
+    {
+    public:
+        SessionReplayLog(size_t maxMessages = 512, size_t maxBytes = 2 * 1024 * 1024);
+
+        // message: a websocket message ([{header},body]). Returns the message with its sequence number added.
+        const std::string &Append(const std::string &message);
+
+        uint64_t LastSequence() const { return lastSequence; }
+
+        // Appends the messages that follow `sequence`, oldest first. Returns false if any have been discarded.
+        bool GetMessagesAfter(uint64_t sequence, std::vector<std::string> *result) const;
+
+        size_t size() const { return messages.size(); }
+
+    private:
+        size_t maxMessages;
+        size_t maxBytes;
+        size_t bytes = 0;
+        uint64_t lastSequence = 0;
+        std::deque<std::string> messages; // messages[0] has sequence lastSequence - messages.size() + 1.
+    };
+}
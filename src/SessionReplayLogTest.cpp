@@ -0,0 +1,67 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SessionReplayLog.hpp"
+#include <string>
+#include <vector>
+
+using namespace pipedal;
+
+TEST_CASE("SessionReplayLog", "[session_replay_log][Build][Dev]")
+{
+    SessionReplayLog log(3, 1024 * 1024);
+
+    REQUIRE(log.Append(R"([{"message":"onPresetChanged"},true])") == R"([{"seq":1,"message":"onPresetChanged"},true])");
+    REQUIRE(log.Append(R"([{}])") == R"([{"seq":2}])");
+    log.Append(R"([{"message":"onBanksChanged"},3])");
+    REQUIRE(log.LastSequence() == 3);
+
+    std::vector<std::string> messages;
+    REQUIRE(log.GetMessagesAfter(1, &messages));
+    REQUIRE(messages.size() == 2);
+    REQUIRE(messages[1] == R"([{"seq":3,"message":"onBanksChanged"},3])");
+
+    messages.clear();
+    REQUIRE(log.GetMessagesAfter(3, &messages));
+    REQUIRE(messages.empty());
+    // from some other session.
+    REQUIRE(!log.GetMessagesAfter(4, &messages));
+
+    // the log rolls over.
+    log.Append(R"([{"message":"onBanksChanged"},4])");
+    REQUIRE(log.size() == 3);
+    REQUIRE(log.GetMessagesAfter(1, &messages));
+    messages.clear();
+    REQUIRE(!log.GetMessagesAfter(0, &messages));
+
+    SECTION("byte limit")
+    {
+        SessionReplayLog smallLog(100, 64);
+        for (int i = 0; i < 10; ++i)
+        {
+            smallLog.Append(R"([{"message":"onBanksChanged"},)" + std::to_string(i) + "]");
+        }
+        REQUIRE(smallLog.size() == 1);
+        REQUIRE(smallLog.LastSequence() == 10);
+        REQUIRE(smallLog.GetMessagesAfter(9, &messages));
+    }
+}
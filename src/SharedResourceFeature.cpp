@@ -0,0 +1,505 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "SharedResourceFeature.hpp"
+#include "Blake3.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+SharedResourceFeature::SharedResourceFeature()
+{
+    feature.URI = PIPEDAL__SHARED_RESOURCE_FEATURE;
+    feature.data = &interface;
+    interface.handle = (void *)this;
+    interface.acquireResource = &SharedResourceFeature::S_acquireResource;
+    interface.acquireDerivedResource = &SharedResourceFeature::S_acquireDerivedResource;
+    interface.releaseResource = &SharedResourceFeature::S_releaseResource;
+}
+
+SharedResourceFeature::~SharedResourceFeature()
+{
+    for (Entry *entry : retainedFiles)
+    {
+        --entry->references;
+    }
+    size_t unreleased = 0;
+    for (const auto &entry : entries)
+    {
+        if (entry.second->references != 0)
+        {
+            ++unreleased;
+        }
+    }
+    if (unreleased != 0)
+    {
+        Lv2Log::warning(SS("SharedResourceFeature: " << unreleased << " resource(s) were not released."));
+    }
+    // The plugin libraries that supplied the free functions may already have been unloaded.
+    for (auto &derivedEntry : derived)
+    {
+        derivedEntry.second->freeDerivedData = nullptr;
+    }
+}
+
+SharedResourceFeature::Entry::~Entry()
+{
+    if (mapAddress)
+    {
+        munmap(mapAddress, mapSize);
+    }
+    if (freeDerivedData)
+    {
+        freeDerivedData(const_cast<void *>(resource.data));
+    }
+}
+
+static PIPEDAL_SharedResource_Status ErrnoStatus(int error)
+{
+    switch (error)
+    {
+    case ENOENT:
+    case ENOTDIR:
+    case ENAMETOOLONG:
+    case ELOOP:
+        return PIPEDAL_SHARED_RESOURCE_INVALID_PATH;
+    case EACCES:
+    case EPERM:
+        return PIPEDAL_SHARED_RESOURCE_PERMISSION_DENIED;
+    default:
+        return PIPEDAL_SHARED_RESOURCE_ERR_UNKNOWN;
+    }
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::GetFileIdentity(const fs::path &path, FileIdentity *identity)
+{
+    if (!path.is_absolute())
+    {
+        return PIPEDAL_SHARED_RESOURCE_INVALID_PATH;
+    }
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+    {
+        return ErrnoStatus(errno);
+    }
+    if (!S_ISREG(st.st_mode))
+    {
+        return PIPEDAL_SHARED_RESOURCE_INVALID_PATH;
+    }
+    identity->device = (uint64_t)st.st_dev;
+    identity->inode = (uint64_t)st.st_ino;
+    identity->size = (int64_t)st.st_size;
+    identity->lastModifiedNs = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::AcquireFile(
+    const fs::path &path, const FileIdentity &identity,
+    Entry **result, std::unique_lock<std::mutex> &lock)
+{
+    auto knownHash = knownHashes.find(identity);
+    if (knownHash != knownHashes.end())
+    {
+        auto file = files.find(knownHash->second);
+        if (file != files.end())
+        {
+            ++file->second->references;
+            *result = file->second.get();
+            return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+        }
+    }
+
+    // Map and hash the file without holding the lock.
+    // (Uploaded files are replaced by renaming, never modified in place, so the mapping stays valid.)
+    lock.unlock();
+    auto entry = std::make_unique<Entry>();
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            int error = errno;
+            lock.lock();
+            return ErrnoStatus(error);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            int error = errno;
+            close(fd);
+            lock.lock();
+            return ErrnoStatus(error);
+        }
+        if (st.st_size != 0)
+        {
+            void *address = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address == MAP_FAILED)
+            {
+                int error = errno;
+                close(fd);
+                lock.lock();
+                return ErrnoStatus(error);
+            }
+            entry->mapAddress = address;
+            entry->mapSize = (size_t)st.st_size;
+        }
+        close(fd);
+    }
+    Blake3Hasher hasher;
+    hasher.Update(entry->mapAddress, entry->mapSize);
+    entry->contentHash = hasher.FinalizeHex();
+
+    lock.lock();
+    knownHashes[identity] = entry->contentHash;
+
+    auto file = files.find(entry->contentHash);
+    if (file != files.end())
+    {
+        // Identical content, under another name (or mapped by another thread while we were hashing).
+        ++file->second->references;
+        *result = file->second.get();
+        return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+    }
+    entry->references = 1;
+    entry->resource.data = entry->mapAddress;
+    entry->resource.size = entry->mapSize;
+    entry->resource.contentHash = entry->contentHash.c_str();
+    *result = entry.get();
+    entries[&entry->resource] = entry.get();
+    files[entry->contentHash] = std::move(entry);
+    return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+}
+
+std::unique_ptr<SharedResourceFeature::Entry> SharedResourceFeature::ReleaseEntry(Entry *entry)
+{
+    if (--entry->references != 0 || retainCount != 0)
+    {
+        return nullptr;
+    }
+    std::unique_ptr<Entry> result;
+    entries.erase(&entry->resource);
+    if (entry->key.empty())
+    {
+        auto file = files.find(entry->contentHash);
+        result = std::move(file->second);
+        files.erase(file);
+    }
+    else
+    {
+        auto derivedEntry = derived.find(DerivedKey(entry->contentHash, entry->key));
+        result = std::move(derivedEntry->second);
+        derived.erase(derivedEntry);
+    }
+    return result;
+}
+
+std::vector<std::unique_ptr<SharedResourceFeature::Entry>> SharedResourceFeature::TakeUnreferencedEntries()
+{
+    std::vector<std::unique_ptr<Entry>> result;
+    for (auto i = files.begin(); i != files.end();)
+    {
+        if (i->second->references == 0)
+        {
+            entries.erase(&i->second->resource);
+            result.push_back(std::move(i->second));
+            i = files.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    for (auto i = derived.begin(); i != derived.end();)
+    {
+        if (i->second->references == 0 && !i->second->building)
+        {
+            entries.erase(&i->second->resource);
+            result.push_back(std::move(i->second));
+            i = derived.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+    return result;
+}
+
+void SharedResourceFeature::BeginRetainingResources()
+{
+    std::lock_guard lock{mutex};
+    ++retainCount;
+}
+
+void SharedResourceFeature::EndRetainingResources()
+{
+    std::vector<std::unique_ptr<Entry>> released; // freed after the lock has been released.
+    std::lock_guard lock{mutex};
+    if (retainCount == 0)
+    {
+        return;
+    }
+    if (--retainCount == 0)
+    {
+        for (Entry *entry : retainedFiles)
+        {
+            --entry->references;
+        }
+        retainedFiles.clear();
+        released = TakeUnreferencedEntries();
+    }
+}
+
+void SharedResourceFeature::RetainFile(const fs::path &path)
+{
+    FileIdentity identity;
+    if (GetFileIdentity(path, &identity) != PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        return;
+    }
+    std::unique_ptr<Entry> released; // freed after the lock has been released.
+    std::unique_lock lock{mutex};
+    if (retainCount == 0)
+    {
+        return;
+    }
+    Entry *entry = nullptr;
+    if (AcquireFile(path, identity, &entry, lock) != PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        return;
+    }
+    if (retainCount == 0)
+    {
+        // retention ended while the file was being mapped.
+        released = ReleaseEntry(entry);
+        return;
+    }
+    retainedFiles.push_back(entry);
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::AcquireResource(const fs::path &path, const PIPEDAL_SharedResource **resource)
+{
+    *resource = nullptr;
+    FileIdentity identity;
+    auto status = GetFileIdentity(path, &identity);
+    if (status != PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        return status;
+    }
+    std::unique_lock lock{mutex};
+    Entry *entry = nullptr;
+    status = AcquireFile(path, identity, &entry, lock);
+    if (status == PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        *resource = &entry->resource;
+    }
+    return status;
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::AcquireDerivedResource(
+    const fs::path &path,
+    const std::string &key,
+    PIPEDAL_SharedResource_BuildFn build,
+    void *context,
+    const PIPEDAL_SharedResource **resource)
+{
+    *resource = nullptr;
+    if (key.empty() || build == nullptr)
+    {
+        return PIPEDAL_SHARED_RESOURCE_ERR_UNKNOWN;
+    }
+    FileIdentity identity;
+    auto status = GetFileIdentity(path, &identity);
+    if (status != PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        return status;
+    }
+
+    std::unique_ptr<Entry> releasedFile; // freed after the lock has been released.
+    std::unique_lock lock{mutex};
+
+    // Returns true if the derived data is (now) available; false if it needs to be built.
+    auto findDerived = [this, &lock, &key, resource](const std::string &contentHash)
+    {
+        while (true)
+        {
+            auto derivedEntry = derived.find(DerivedKey(contentHash, key));
+            if (derivedEntry == derived.end())
+            {
+                return false;
+            }
+            if (derivedEntry->second->building)
+            {
+                buildCompleted.wait(lock);
+                continue;
+            }
+            ++derivedEntry->second->references;
+            *resource = &derivedEntry->second->resource;
+            return true;
+        }
+    };
+
+    // Cached derived data for a file we have seen before doesn't require mapping the file.
+    auto knownHash = knownHashes.find(identity);
+    if (knownHash != knownHashes.end())
+    {
+        std::string contentHash = knownHash->second;
+        if (findDerived(contentHash))
+        {
+            return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+        }
+    }
+
+    Entry *file = nullptr;
+    status = AcquireFile(path, identity, &file, lock);
+    if (status != PIPEDAL_SHARED_RESOURCE_SUCCESS)
+    {
+        return status;
+    }
+    if (findDerived(file->contentHash))
+    {
+        releasedFile = ReleaseEntry(file);
+        return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+    }
+
+    DerivedKey derivedKey(file->contentHash, key);
+    auto newEntry = std::make_unique<Entry>();
+    Entry *entry = newEntry.get();
+    entry->contentHash = file->contentHash;
+    entry->key = key;
+    entry->building = true;
+    entry->references = 1;
+    derived[derivedKey] = std::move(newEntry);
+
+    // Build without holding the lock. Other requests for the same data wait for the build to complete.
+    lock.unlock();
+    void *derivedData = nullptr;
+    uint64_t derivedSize = 0;
+    void (*freeDerivedData)(void *) = nullptr;
+    int built = build(context, file->resource.data, file->resource.size, &derivedData, &derivedSize, &freeDerivedData);
+    lock.lock();
+
+    entry->building = false;
+    buildCompleted.notify_all();
+    releasedFile = ReleaseEntry(file);
+    if (!built)
+    {
+        derived.erase(derivedKey);
+        Lv2Log::warning(SS("SharedResourceFeature: failed to build " << key << " for " << path));
+        return PIPEDAL_SHARED_RESOURCE_BUILD_FAILED;
+    }
+    entry->freeDerivedData = freeDerivedData;
+    entry->resource.data = derivedData;
+    entry->resource.size = derivedSize;
+    entry->resource.contentHash = entry->contentHash.c_str();
+    entries[&entry->resource] = entry;
+    *resource = &entry->resource;
+    return PIPEDAL_SHARED_RESOURCE_SUCCESS;
+}
+
+void SharedResourceFeature::ReleaseResource(const PIPEDAL_SharedResource *resource)
+{
+    std::unique_ptr<Entry> released;
+    std::lock_guard lock{mutex};
+    auto entry = entries.find(resource);
+    if (entry == entries.end())
+    {
+        Lv2Log::error("SharedResourceFeature: releaseResource called with an invalid resource.");
+        return;
+    }
+    if (entry->second->references == 0)
+    {
+        Lv2Log::error("SharedResourceFeature: releaseResource called for a resource that has already been released.");
+        return;
+    }
+    released = ReleaseEntry(entry->second);
+}
+
+size_t SharedResourceFeature::GetResourceCount()
+{
+    std::lock_guard lock{mutex};
+    return entries.size();
+}
+
+uint64_t SharedResourceFeature::GetResourceBytes()
+{
+    std::lock_guard lock{mutex};
+    uint64_t result = 0;
+    for (const auto &entry : entries)
+    {
+        result += entry.second->resource.size;
+    }
+    return result;
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::S_acquireResource(
+    PIPEDAL_SHARED_RESOURCE_Handle handle,
+    const char *absolute_path,
+    const PIPEDAL_SharedResource **resource)
+{
+    try
+    {
+        return ((SharedResourceFeature *)handle)->AcquireResource(absolute_path, resource);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("SharedResourceFeature: " << e.what()));
+        *resource = nullptr;
+        return PIPEDAL_SHARED_RESOURCE_ERR_UNKNOWN;
+    }
+}
+
+PIPEDAL_SharedResource_Status SharedResourceFeature::S_acquireDerivedResource(
+    PIPEDAL_SHARED_RESOURCE_Handle handle,
+    const char *absolute_path,
+    const char *key,
+    PIPEDAL_SharedResource_BuildFn build,
+    void *context,
+    const PIPEDAL_SharedResource **resource)
+{
+    try
+    {
+        return ((SharedResourceFeature *)handle)->AcquireDerivedResource(absolute_path, key ? key : "", build, context, resource);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("SharedResourceFeature: " << e.what()));
+        *resource = nullptr;
+        return PIPEDAL_SHARED_RESOURCE_ERR_UNKNOWN;
+    }
+}
+
+void SharedResourceFeature::S_releaseResource(
+    PIPEDAL_SHARED_RESOURCE_Handle handle,
+    const PIPEDAL_SharedResource *resource)
+{
+    if (resource)
+    {
+        ((SharedResourceFeature *)handle)->ReleaseResource(resource);
+    }
+}
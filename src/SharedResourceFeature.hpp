@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "lv2ext/pipedal.lv2/ext/SharedResourceFeature.h"
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Host side of the sharedResource LV2 extension.
+     *
+     * One per PluginHost, so resources are shared between all plugin instances, including
+     * instances in preloaded pedalboards. Files are memory-mapped once per distinct content
+     * (BLAKE3 hash), and derived data is built once per (content, key).
+     */
+    class SharedResourceFeature
+    {
+    public:
+        SharedResourceFeature();
+        ~SharedResourceFeature();
+        SharedResourceFeature(const SharedResourceFeature &) = delete;
+        SharedResourceFeature &operator=(const SharedResourceFeature &) = delete;
+
+        const LV2_Feature *GetFeature() { return &feature; }
+
+        PIPEDAL_SharedResource_Status AcquireResource(const std::filesystem::path &path, const PIPEDAL_SharedResource **resource);
+        PIPEDAL_SharedResource_Status AcquireDerivedResource(
+            const std::filesystem::path &path,
+            const std::string &key,
+            PIPEDAL_SharedResource_BuildFn build,
+            void *context,
+            const PIPEDAL_SharedResource **resource);
+        void ReleaseResource(const PIPEDAL_SharedResource *resource);
+
+        // Number of resources currently held (including retained resources), and the bytes they occupy.
+        size_t GetResourceCount();
+        uint64_t GetResourceBytes();
+
+        // While retaining, resources that are no longer referenced stay mapped (and derived data stays
+        // built), so that a pedalboard rebuild reacquires them without touching the disk. Calls nest;
+        // unreferenced resources are freed when the last retainer ends.
+        // Decoded data is only retained for plugins that use the shared resource extension.
+        void BeginRetainingResources();
+        void EndRetainingResources();
+        // While retaining, keeps a file mapped on behalf of a plugin that loads the file itself (e.g. a model
+        // or IR file named by a path property), so that the plugin's reads are served from memory. Released
+        // when the last retainer ends.
+        void RetainFile(const std::filesystem::path &path);
+
+    private:
+        struct FileIdentity
+        {
+            uint64_t device = 0;
+            uint64_t inode = 0;
+            int64_t size = 0;
+            int64_t lastModifiedNs = 0;
+
+            auto operator<=>(const FileIdentity &) const = default;
+        };
+        struct Entry
+        {
+            PIPEDAL_SharedResource resource{};
+            std::string contentHash;
+            std::string key;         // empty for file mappings.
+            size_t references = 0;
+
+            // file mappings.
+            void *mapAddress = nullptr;
+            size_t mapSize = 0;
+
+            // derived data.
+            bool building = false;
+            void (*freeDerivedData)(void *) = nullptr;
+
+            ~Entry();
+        };
+        using DerivedKey = std::pair<std::string, std::string>; // (contentHash, key)
+
+        static PIPEDAL_SharedResource_Status GetFileIdentity(const std::filesystem::path &path, FileIdentity *identity);
+        // Called with the lock held. May release the lock while the file is mapped and hashed.
+        PIPEDAL_SharedResource_Status AcquireFile(
+            const std::filesystem::path &path, const FileIdentity &identity,
+            Entry **entry, std::unique_lock<std::mutex> &lock);
+        // Called with the lock held. Returns the entry if it is no longer referenced, so that it
+        // can be freed after the lock has been released.
+        std::unique_ptr<Entry> ReleaseEntry(Entry *entry);
+        // Called with the lock held.
+        std::vector<std::unique_ptr<Entry>> TakeUnreferencedEntries();
+
+        static PIPEDAL_SharedResource_Status S_acquireResource(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const char *absolute_path,
+            const PIPEDAL_SharedResource **resource);
+        static PIPEDAL_SharedResource_Status S_acquireDerivedResource(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const char *absolute_path,
+            const char *key,
+            PIPEDAL_SharedResource_BuildFn build,
+            void *context,
+            const PIPEDAL_SharedResource **resource);
+        static void S_releaseResource(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const PIPEDAL_SharedResource *resource);
+
+        LV2_Feature feature;
+        PIPEDAL_SharedResource_Interface interface;
+
+        std::mutex mutex;
+        std::condition_variable buildCompleted;
+        // content hashes of files we've seen, so that cached derived data can be found without rehashing.
+        std::map<FileIdentity, std::string> knownHashes;
+        std::unordered_map<std::string, std::unique_ptr<Entry>> files; // by content hash.
+        std::map<DerivedKey, std::unique_ptr<Entry>> derived;
+        std::unordered_map<const PIPEDAL_SharedResource *, Entry *> entries;
+        size_t retainCount = 0;
+        std::vector<Entry *> retainedFiles;
+    };
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SharedResourceFeature.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static void WriteTestFile(const fs::path &path, const std::string &content)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream f(path, std::ios_base::trunc | std::ios_base::binary);
+    f << content;
+}
+
+static int g_buildCount = 0;
+static int g_freeCount = 0;
+
+static void FreeUpperCase(void *data)
+{
+    ++g_freeCount;
+    delete[] (char *)data;
+}
+
+// Derived data: the file contents in upper case.
+static int BuildUpperCase(void *context, const void *fileData, uint64_t fileSize, void **derivedData, uint64_t *derivedSize, void (**freeDerivedData)(void *))
+{
+    ++g_buildCount;
+    char *result = new char[fileSize];
+    for (uint64_t i = 0; i < fileSize; ++i)
+    {
+        result[i] = (char)toupper(((const char *)fileData)[i]);
+    }
+    *derivedData = result;
+    *derivedSize = fileSize;
+    *freeDerivedData = &FreeUpperCase;
+    return 1;
+}
+
+TEST_CASE("SharedResourceFeature file sharing", "[shared_resource][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "SharedResourceTest";
+    fs::remove_all(directory);
+    fs::path fileA = directory / "a.nam";
+    fs::path fileB = directory / "copy of a.nam";
+    fs::path fileC = directory / "c.nam";
+    WriteTestFile(fileA, "model weights");
+    WriteTestFile(fileB, "model weights");
+    WriteTestFile(fileC, "other weights");
+
+    SharedResourceFeature feature;
+    const PIPEDAL_SharedResource_Interface *interface = (const PIPEDAL_SharedResource_Interface *)feature.GetFeature()->data;
+
+    const PIPEDAL_SharedResource *a1 = nullptr;
+    const PIPEDAL_SharedResource *a2 = nullptr;
+    const PIPEDAL_SharedResource *b = nullptr;
+    const PIPEDAL_SharedResource *c = nullptr;
+    REQUIRE(interface->acquireResource(interface->handle, fileA.c_str(), &a1) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireResource(interface->handle, fileA.c_str(), &a2) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireResource(interface->handle, fileB.c_str(), &b) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireResource(interface->handle, fileC.c_str(), &c) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+
+    // identical content is mapped once.
+    REQUIRE(a1 == a2);
+    REQUIRE(a1 == b);
+    REQUIRE(a1 != c);
+    REQUIRE(a1->size == 13);
+    REQUIRE(memcmp(a1->data, "model weights", 13) == 0);
+    REQUIRE(strlen(a1->contentHash) == 64);
+    REQUIRE(feature.GetResourceCount() == 2);
+
+    interface->releaseResource(interface->handle, a1);
+    interface->releaseResource(interface->handle, a2);
+    REQUIRE(feature.GetResourceCount() == 2);
+    interface->releaseResource(interface->handle, b);
+    interface->releaseResource(interface->handle, c);
+    REQUIRE(feature.GetResourceCount() == 0);
+    REQUIRE(feature.GetResourceBytes() == 0);
+
+    const PIPEDAL_SharedResource *missing = nullptr;
+    REQUIRE(interface->acquireResource(interface->handle, (directory / "missing.nam").c_str(), &missing) == PIPEDAL_SHARED_RESOURCE_INVALID_PATH);
+    REQUIRE(missing == nullptr);
+    REQUIRE(interface->acquireResource(interface->handle, "relative.nam", &missing) == PIPEDAL_SHARED_RESOURCE_INVALID_PATH);
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("SharedResourceFeature derived data", "[shared_resource][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "SharedResourceTest";
+    fs::remove_all(directory);
+    fs::path fileA = directory / "a.wav";
+    fs::path fileB = directory / "b.wav";
+    WriteTestFile(fileA, "impulse");
+    WriteTestFile(fileB, "impulse");
+
+    g_buildCount = 0;
+    g_freeCount = 0;
+    SharedResourceFeature feature;
+    const PIPEDAL_SharedResource_Interface *interface = (const PIPEDAL_SharedResource_Interface *)feature.GetFeature()->data;
+
+    const PIPEDAL_SharedResource *d1 = nullptr;
+    const PIPEDAL_SharedResource *d2 = nullptr;
+    const PIPEDAL_SharedResource *other = nullptr;
+    REQUIRE(interface->acquireDerivedResource(interface->handle, fileA.c_str(), "upper", &BuildUpperCase, nullptr, &d1) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireDerivedResource(interface->handle, fileB.c_str(), "upper", &BuildUpperCase, nullptr, &d2) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireDerivedResource(interface->handle, fileA.c_str(), "upper-v2", &BuildUpperCase, nullptr, &other) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(d1 == d2);
+    REQUIRE(d1 != other);
+    REQUIRE(g_buildCount == 2);
+    REQUIRE(memcmp(d1->data, "IMPULSE", 7) == 0);
+    // the source file isn't held once the derived data has been built.
+    REQUIRE(feature.GetResourceCount() == 2);
+
+    interface->releaseResource(interface->handle, d1);
+    interface->releaseResource(interface->handle, d2);
+    interface->releaseResource(interface->handle, other);
+    REQUIRE(g_freeCount == 2);
+    REQUIRE(feature.GetResourceCount() == 0);
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("SharedResourceFeature retains released resources", "[shared_resource][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "SharedResourceTest";
+    fs::remove_all(directory);
+    fs::path fileA = directory / "a.wav";
+    WriteTestFile(fileA, "impulse");
+
+    g_buildCount = 0;
+    g_freeCount = 0;
+    SharedResourceFeature feature;
+    const PIPEDAL_SharedResource_Interface *interface = (const PIPEDAL_SharedResource_Interface *)feature.GetFeature()->data;
+
+    const PIPEDAL_SharedResource *d1 = nullptr;
+    const PIPEDAL_SharedResource *d2 = nullptr;
+    const PIPEDAL_SharedResource *f1 = nullptr;
+    const PIPEDAL_SharedResource *f2 = nullptr;
+    REQUIRE(interface->acquireDerivedResource(interface->handle, fileA.c_str(), "upper", &BuildUpperCase, nullptr, &d1) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireResource(interface->handle, fileA.c_str(), &f1) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+
+    // a pedalboard rebuild: everything is released, then reacquired.
+    feature.BeginRetainingResources();
+    interface->releaseResource(interface->handle, d1);
+    interface->releaseResource(interface->handle, f1);
+    REQUIRE(g_freeCount == 0);
+    REQUIRE(feature.GetResourceCount() == 2);
+
+    REQUIRE(interface->acquireDerivedResource(interface->handle, fileA.c_str(), "upper", &BuildUpperCase, nullptr, &d2) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(interface->acquireResource(interface->handle, fileA.c_str(), &f2) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(d2 == d1);
+    REQUIRE(f2 == f1);
+    REQUIRE(g_buildCount == 1);
+
+    // resources that are still referenced survive the end of retention; the others are freed.
+    interface->releaseResource(interface->handle, f2);
+    feature.EndRetainingResources();
+    REQUIRE(feature.GetResourceCount() == 1);
+    REQUIRE(g_freeCount == 0);
+
+    interface->releaseResource(interface->handle, d2);
+    REQUIRE(g_freeCount == 1);
+    REQUIRE(feature.GetResourceCount() == 0);
+
+    fs::remove_all(directory);
+}
+
+TEST_CASE("SharedResourceFeature retains files for plugins that load them", "[shared_resource][Build][Dev]")
+{
+    fs::path directory = fs::temp_directory_path() / "SharedResourceTest";
+    fs::remove_all(directory);
+    fs::path fileA = directory / "model.nam";
+    WriteTestFile(fileA, "model");
+
+    SharedResourceFeature feature;
+    const PIPEDAL_SharedResource_Interface *interface = (const PIPEDAL_SharedResource_Interface *)feature.GetFeature()->data;
+
+    // ignored when not retaining.
+    feature.RetainFile(fileA);
+    REQUIRE(feature.GetResourceCount() == 0);
+
+    feature.BeginRetainingResources();
+    feature.RetainFile(fileA);
+    feature.RetainFile(directory / "missing.nam");
+    REQUIRE(feature.GetResourceCount() == 1);
+    REQUIRE(feature.GetResourceBytes() == 5);
+
+    // an extension-aware plugin shares the mapping.
+    const PIPEDAL_SharedResource *f1 = nullptr;
+    REQUIRE(interface->acquireResource(interface->handle, fileA.c_str(), &f1) == PIPEDAL_SHARED_RESOURCE_SUCCESS);
+    REQUIRE(feature.GetResourceCount() == 1);
+    REQUIRE(memcmp(f1->data, "model", 5) == 0);
+
+    feature.EndRetainingResources();
+    REQUIRE(feature.GetResourceCount() == 1);
+    interface->releaseResource(interface->handle, f1);
+    REQUIRE(feature.GetResourceCount() == 0);
+
+    fs::remove_all(directory);
+}
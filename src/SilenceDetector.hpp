@@ -0,0 +1,96 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstdint>
+
+namespace pipedal
+{
+    /**
+     * @brief Decides when an effect can stop running because its input and output are silent.
+     *
+     * An effect goes idle once both its input and its output have stayed below the threshold for the
+     * hold time. Waiting for the output to go quiet as well measures the effect's tail, so reverb and
+     * delay trails are not cut off. It wakes as soon as its input rises above the threshold,
+     * or when it has input messages to process.
+     *
+     * Realtime-safe. Call ShouldRun() before each period, and Update() after periods in which the effect ran.
+     */
+    class SilenceDetector
+    {
+    public:
+        static constexpr float DEFAULT_THRESHOLD = 3.1623e-5f; // -90dBFS
+        static constexpr double DEFAULT_HOLD_SECONDS = 3.0;
+
+        SilenceDetector(double sampleRate, double holdSeconds = DEFAULT_HOLD_SECONDS, float threshold = DEFAULT_THRESHOLD)
+            : threshold(threshold),
+              holdFrames((uint64_t)(sampleRate * holdSeconds))
+        {
+        }
+
+        // Returns false if the effect can be skipped this period. An idle effect also wakes if it has
+        // input messages, which would otherwise be discarded without the effect seeing them.
+        bool ShouldRun(float inputPeak, bool hasInputMessages = false)
+        {
+            this->inputPeak = inputPeak;
+            if (idle)
+            {
+                if (inputPeak <= threshold && !hasInputMessages)
+                {
+                    return false;
+                }
+                idle = false;
+                waking = true;
+                silentFrames = 0;
+                return true;
+            }
+            waking = false;
+            return true;
+        }
+        void Update(float outputPeak, uint32_t frames)
+        {
+            if (inputPeak <= threshold && outputPeak <= threshold)
+            {
+                silentFrames += frames;
+                if (silentFrames >= holdFrames)
+                {
+                    idle = true;
+                }
+            }
+            else
+            {
+                silentFrames = 0;
+            }
+        }
+
+        bool IsIdle() const { return idle; }
+        // True for the first period after waking.
+        bool IsWaking() const { return waking; }
+
+    private:
+        float threshold;
+        uint64_t holdFrames;
+        uint64_t silentFrames = 0;
+        float inputPeak = 0;
+        bool idle = false;
+        bool waking = false;
+    };
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SilenceDetector.hpp"
+
+using namespace pipedal;
+
+TEST_CASE("SilenceDetector", "[silence_detector][Build][Dev]")
+{
+    constexpr double SAMPLE_RATE = 48000;
+    constexpr uint32_t FRAMES = 64;
+    constexpr float LOUD = 0.1f;
+    constexpr float QUIET = 1e-6f;
+    const size_t holdPeriods = (size_t)(SAMPLE_RATE * SilenceDetector::DEFAULT_HOLD_SECONDS / FRAMES);
+
+    SilenceDetector detector(SAMPLE_RATE);
+
+    // signal keeps it running.
+    for (size_t i = 0; i < holdPeriods * 2; ++i)
+    {
+        REQUIRE(detector.ShouldRun(LOUD));
+        detector.Update(LOUD, FRAMES);
+    }
+    REQUIRE(!detector.IsIdle());
+
+    // a tail: input silent, output still sounding. The hold time starts when the output goes quiet.
+    for (size_t i = 0; i < holdPeriods * 2; ++i)
+    {
+        REQUIRE(detector.ShouldRun(QUIET));
+        detector.Update(LOUD, FRAMES);
+    }
+    REQUIRE(!detector.IsIdle());
+
+    size_t periods = 0;
+    while (detector.ShouldRun(QUIET))
+    {
+        detector.Update(QUIET, FRAMES);
+        ++periods;
+        REQUIRE(periods <= holdPeriods + 1);
+    }
+    REQUIRE(detector.IsIdle());
+    REQUIRE(periods >= holdPeriods);
+
+    // stays idle while silent.
+    for (size_t i = 0; i < 100; ++i)
+    {
+        REQUIRE(!detector.ShouldRun(QUIET));
+    }
+
+    // wakes immediately when signal returns, and reports waking for one period only.
+    REQUIRE(detector.ShouldRun(LOUD));
+    REQUIRE(detector.IsWaking());
+    REQUIRE(!detector.IsIdle());
+    detector.Update(LOUD, FRAMES);
+    REQUIRE(detector.ShouldRun(LOUD));
+    REQUIRE(!detector.IsWaking());
+    detector.Update(LOUD, FRAMES);
+
+    // a brief silence isn't enough.
+    for (size_t i = 0; i < holdPeriods / 2; ++i)
+    {
+        REQUIRE(detector.ShouldRun(QUIET));
+        detector.Update(QUIET, FRAMES);
+    }
+    REQUIRE(detector.ShouldRun(LOUD));
+    detector.Update(LOUD, FRAMES);
+    for (size_t i = 0; i < holdPeriods / 2; ++i)
+    {
+        REQUIRE(detector.ShouldRun(QUIET));
+        detector.Update(QUIET, FRAMES);
+    }
+    REQUIRE(!detector.IsIdle());
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "SilenceGate.hpp"
+#include "Lv2Effect.hpp"
+#include "PluginHost.hpp"
+#include "Pedalboard.hpp"
+#include "lv2ext/pipedal.lv2/ext/AlwaysRunFeature.h"
+#include "VuUpdate.hpp"
+#include <algorithm>
+#include <cstring>
+
+using namespace pipedal;
+
+SilenceGate::SilenceGate(IEffect *effect, bool withBufferStaging, double sampleRate)
+    : effect(effect),
+      lv2Effect(effect->IsLv2Effect() ? (Lv2Effect *)effect : nullptr),
+      withBufferStaging(withBufferStaging),
+      detector(sampleRate)
+{
+}
+
+// Effects whose sound depends on LFO state that advances while they are silent.
+static bool IsModulationEffect(PluginType pluginType)
+{
+    switch (pluginType)
+    {
+    case PluginType::ModulatorPlugin:
+    case PluginType::ChorusPlugin:
+    case PluginType::FlangerPlugin:
+    case PluginType::PhaserPlugin:
+    case PluginType::OscillatorPlugin:
+    case PluginType::GeneratorPlugin:
+    case PluginType::ConstantPlugin:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool SilenceGate::CanGate(Lv2Effect *effect, const Lv2PluginInfo *pluginInfo, const PedalboardItem &item)
+{
+    if (!pluginInfo || item.alwaysRun() || pluginInfo->IsLive() ||
+        pluginInfo->IsFeatureDeclared(PIPEDAL__ALWAYS_RUN_FEATURE) ||
+        IsModulationEffect(uri_to_plugin_type(pluginInfo->plugin_class())))
+    {
+        return false;
+    }
+    return effect->GetNumberOfInputAudioPorts() != 0 &&
+           effect->GetNumberOfOutputAudioPorts() != 0 &&
+           effect->GetNumberOfMidiInputPorts() == 0 &&
+           effect->GetNumberOfSidechainAudioBuffers() == 0;
+}
+
+float SilenceGate::InputPeak(uint32_t frames) const
+{
+    float peak = 0;
+    int n = effect->GetNumberOfInputAudioBuffers();
+    for (int i = 0; i < n; ++i)
+    {
+        VuAbsMax(effect->GetAudioInputBuffer(i), frames, &peak);
+    }
+    return peak;
+}
+
+float SilenceGate::OutputPeak(uint32_t frames) const
+{
+    float peak = 0;
+    int n = effect->GetNumberOfOutputAudioBuffers();
+    for (int i = 0; i < n; ++i)
+    {
+        VuAbsMax(effect->GetAudioOutputBuffer(i), frames, &peak);
+    }
+    return peak;
+}
+
+void SilenceGate::ZeroOutputs(uint32_t frames)
+{
+    int n = effect->GetNumberOfOutputAudioBuffers();
+    for (int i = 0; i < n; ++i)
+    {
+        memset(effect->GetAudioOutputBuffer(i), 0, frames * sizeof(float));
+    }
+}
+
+void SilenceGate::FadeInOutputs(uint32_t frames)
+{
+    if (frames == 0)
+    {
+        return;
+    }
+    float dx = 1.0f / frames;
+    int n = effect->GetNumberOfOutputAudioBuffers();
+    for (int c = 0; c < n; ++c)
+    {
+        float *output = effect->GetAudioOutputBuffer(c);
+        for (uint32_t i = 0; i < frames; ++i)
+        {
+            output[i] *= i * dx;
+        }
+    }
+}
+
+void SilenceGate::Run(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter)
+{
+    if (!detector.ShouldRun(InputPeak(frames), effect->HasPendingInputMessages()))
+    {
+        ZeroOutputs(frames);
+        return;
+    }
+    if (!lv2Effect)
+    {
+        effect->Run(frames, realtimeRingBufferWriter);
+    }
+    else if (withBufferStaging)
+    {
+        lv2Effect->Lv2Effect::RunWithBufferStaging(frames, realtimeRingBufferWriter);
+    }
+    else
+    {
+        lv2Effect->Lv2Effect::Run(frames, realtimeRingBufferWriter);
+    }
+    if (detector.IsWaking())
+    {
+        FadeInOutputs(frames);
+    }
+    detector.Update(OutputPeak(frames), frames);
+}
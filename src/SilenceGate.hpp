@@ -0,0 +1,69 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "SilenceDetector.hpp"
+#include <cstdint>
+
+namespace pipedal
+{
+    class IEffect;
+    class Lv2Effect;
+    class Lv2PluginInfo;
+    class PedalboardItem;
+    class RealtimeRingBufferWriter;
+
+    /**
+     * @brief Runs an Lv2Effect only while it has something to do.
+     *
+     * Once the effect's input and output have been silent for a while (see SilenceDetector), the effect
+     * is no longer run, and its outputs are zeroed instead. An idle effect is still run in periods where
+     * it has input messages (patch:Set, worker responses), which would otherwise be lost. When signal returns, the effect's first period
+     * of output is faded in, to mask any discontinuity in state that was frozen while it was idle.
+     */
+    class SilenceGate
+    {
+    public:
+        SilenceGate(IEffect *effect, bool withBufferStaging, double sampleRate);
+
+        // Effects that produce sound without audio input (instruments, players), effects that must run in
+        // real time (lv2:isLive), modulation effects whose LFOs would stop, and plugins or pedalboard items
+        // that opt out (the PiPedal alwaysRun feature, PedalboardItem::alwaysRun()) are never idled.
+        static bool CanGate(Lv2Effect *effect, const Lv2PluginInfo *pluginInfo, const PedalboardItem &item);
+
+        // Audio thread. The caller opens the RealtimeTripwire scope for the effect.
+        void Run(uint32_t frames, RealtimeRingBufferWriter *realtimeRingBufferWriter);
+
+        IEffect *GetEffect() const { return effect; }
+        bool IsIdle() const { return detector.IsIdle(); }
+
+    private:
+        float InputPeak(uint32_t frames) const;
+        float OutputPeak(uint32_t frames) const;
+        void ZeroOutputs(uint32_t frames);
+        void FadeInOutputs(uint32_t frames);
+
+        IEffect *effect;
+        Lv2Effect *lv2Effect; // null if effect is not an Lv2Effect.
+        bool withBufferStaging;
+        SilenceDetector detector;
+    };
+}
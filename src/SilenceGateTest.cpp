@@ -0,0 +1,132 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SilenceGate.hpp"
+#include "IEffect.hpp"
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    // Stands in for a plugin with an atom input port: a message is pending until the effect is run
+    // (the plugin receives it) or the host resets the atom buffers at the end of the period (it's lost).
+    class MessageEffect : public IEffect
+    {
+    public:
+        MessageEffect(float *input, float *output) : input(input), output(output) {}
+
+        float *input;
+        float *output;
+        bool messagePending = false;
+        uint32_t messagesReceived = 0;
+        uint32_t runCount = 0;
+
+        virtual uint64_t GetInstanceId() const override { return 0; }
+        virtual bool IsLv2Effect() const override { return false; }
+        virtual uint64_t GetMaxInputControl() const override { return 0; }
+        virtual bool IsInputControl(uint64_t index) const override { return false; }
+        virtual float GetDefaultInputControlValue(uint64_t index) const override { return 0; }
+        virtual int GetControlIndex(const std::string &symbol) const override { return -1; }
+        virtual void SetControl(int index, float value) override {}
+        virtual void SetPatchProperty(LV2_URID uridUri, size_t size, LV2_Atom *value) override { messagePending = true; }
+        virtual void RequestPatchProperty(LV2_URID uridUri) override {}
+        virtual void RequestAllPathPatchProperties() override {}
+        virtual float GetControlValue(int index) const override { return 0; }
+        virtual void SetBypass(bool enable) override {}
+        virtual float GetOutputControlValue(int controlIndex) const override { return 0; }
+        virtual int GetNumberOfInputAudioPorts() const override { return 1; }
+        virtual int GetNumberOfOutputAudioPorts() const override { return 1; }
+        virtual int GetNumberOfInputAudioBuffers() const override { return 1; }
+        virtual int GetNumberOfOutputAudioBuffers() const override { return 1; }
+        virtual float *GetAudioInputBuffer(int index) const override { return input; }
+        virtual float *GetAudioOutputBuffer(int index) const override { return output; }
+        virtual void ResetAtomBuffers() override { messagePending = false; }
+        virtual bool HasPendingInputMessages() const override { return messagePending; }
+        virtual bool GetRequestStateChangedNotification() const override { return false; }
+        virtual void SetRequestStateChangedNotification(bool value) override {}
+        virtual void PrepareNoInputEffect(int numberOfInputs, size_t maxBufferSize) override {}
+        virtual void SetAudioInputBuffer(int index, float *buffer) override { input = buffer; }
+        virtual void SetAudioOutputBuffer(int index, float *buffer) override { output = buffer; }
+        virtual void Activate() override {}
+        virtual void Run(uint32_t samples, RealtimeRingBufferWriter *realtimeRingBufferWriter) override
+        {
+            ++runCount;
+            if (messagePending)
+            {
+                ++messagesReceived;
+                messagePending = false;
+            }
+            for (uint32_t i = 0; i < samples; ++i)
+            {
+                output[i] = input[i];
+            }
+        }
+        virtual void Deactivate() override {}
+        virtual bool IsVst3() const override { return false; }
+        virtual bool GetLv2State(Lv2PluginState *state) override { return false; }
+        virtual void SetLv2State(Lv2PluginState &state) override {}
+        virtual bool HasErrorMessage() const override { return false; }
+        virtual const char *TakeErrorMessage() override { return nullptr; }
+    };
+}
+
+TEST_CASE("SilenceGate delivers messages to idle effects", "[silence_gate][Build][Dev]")
+{
+    constexpr double SAMPLE_RATE = 48000;
+    constexpr uint32_t FRAMES = 64;
+    const size_t holdPeriods = (size_t)(SAMPLE_RATE * SilenceDetector::DEFAULT_HOLD_SECONDS / FRAMES);
+
+    std::vector<float> input(FRAMES, 0.0f);
+    std::vector<float> output(FRAMES, 0.0f);
+    MessageEffect effect(input.data(), output.data());
+    SilenceGate gate(&effect, false, SAMPLE_RATE);
+
+    // one period of the audio thread: run the gate, then discard this period's atom input.
+    auto runPeriod = [&]()
+    {
+        gate.Run(FRAMES, nullptr);
+        effect.ResetAtomBuffers();
+    };
+
+    for (size_t i = 0; i < holdPeriods + 2; ++i)
+    {
+        runPeriod();
+    }
+    REQUIRE(gate.IsIdle());
+    uint32_t idleRunCount = effect.runCount;
+    runPeriod();
+    REQUIRE(effect.runCount == idleRunCount);
+
+    // a patch:Set to the idle effect (e.g. loading a model while the guitar is silent).
+    effect.SetPatchProperty(0, 0, nullptr);
+    runPeriod();
+    REQUIRE(effect.messagesReceived == 1);
+    REQUIRE(!gate.IsIdle());
+
+    // with no further input, it goes idle again after the hold time.
+    for (size_t i = 0; i < holdPeriods + 2; ++i)
+    {
+        runPeriod();
+    }
+    REQUIRE(gate.IsIdle());
+}
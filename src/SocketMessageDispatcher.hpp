@@ -0,0 +1,113 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "json.hpp"
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace pipedal
+{
+    /**
+     * @brief Maps websocket message names to handler member functions.
+     *
+     * Built once (typically as a function-local static), then shared by all connections. Dispatch is
+     * a single hash lookup, no matter how many messages there are.
+     */
+    template <typename HANDLER>
+    class SocketMessageDispatcher
+    {
+    public:
+        using Handler = void (HANDLER::*)(int replyTo, json_reader *pReader);
+
+        SocketMessageDispatcher(std::initializer_list<std::pair<const std::string_view, Handler>> handlers)
+            : handlers(handlers)
+        {
+        }
+        template <typename ITERATOR>
+        SocketMessageDispatcher(ITERATOR begin, ITERATOR end)
+            : handlers(begin, end)
+        {
+        }
+
+        // Returns false if there is no handler for the message.
+        bool Dispatch(HANDLER *target, std::string_view message, int replyTo, json_reader *pReader) const
+        {
+            auto i = handlers.find(message);
+            if (i == handlers.end())
+            {
+                return false;
+            }
+            (target->*(i->second))(replyTo, pReader);
+            return true;
+        }
+        size_t size() const { return handlers.size(); }
+
+    private:
+        std::unordered_map<std::string_view, Handler> handlers;
+    };
+
+    // Reads the header of a websocket message: [{"message": ..., "reply": ..., "replyTo": ...}, body].
+    // Returns true if a body follows, in which case the reader is left positioned at the body.
+    inline bool ReadSocketMessageHeader(json_reader &reader, int64_t *reply, int64_t *replyTo, std::string *message)
+    {
+        reader.consume('[');
+        reader.consume('{');
+
+        while (true)
+        {
+            if (reader.peek() == '}')
+            {
+                reader.consume('}');
+                break;
+            }
+            std::string name = reader.read_string();
+            reader.consume(':');
+            if (name == "reply")
+            {
+                reader.read(reply);
+            }
+            if (name == "replyTo")
+            {
+                reader.read(replyTo);
+            }
+            if (name == "message")
+            {
+                *message = reader.read_string();
+            }
+            if (reader.peek() == ',')
+            {
+                reader.consume(',');
+                continue;
+            }
+        }
+        if (reader.peek() == ',')
+        {
+            reader.consume(',');
+            return true;
+        }
+        return false;
+    }
+}
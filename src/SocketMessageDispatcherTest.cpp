@@ -0,0 +1,214 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SocketMessageDispatcher.hpp"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    class TestControlBody
+    {
+    public:
+        int64_t clientId_ = -1;
+        int64_t instanceId_ = -1;
+        std::string symbol_;
+        float value_ = 0;
+
+        DECLARE_JSON_MAP(TestControlBody);
+    };
+
+    class TestSocketHandler
+    {
+    public:
+        int controls = 0;
+        int others = 0;
+        float lastValue = 0;
+        int lastReplyTo = 0;
+
+        void HandleControl(int replyTo, json_reader *pReader)
+        {
+            TestControlBody body;
+            pReader->read(&body);
+            lastValue = body.value_;
+            ++controls;
+        }
+        void HandleOther(int replyTo, json_reader *pReader)
+        {
+            lastReplyTo = replyTo;
+            if (pReader)
+            {
+                int64_t value;
+                pReader->read(&value);
+            }
+            ++others;
+        }
+    };
+}
+
+JSON_MAP_BEGIN(TestControlBody)
+    JSON_MAP_REFERENCE(TestControlBody, clientId)
+    JSON_MAP_REFERENCE(TestControlBody, instanceId)
+    JSON_MAP_REFERENCE(TestControlBody, symbol)
+    JSON_MAP_REFERENCE(TestControlBody, value)
+JSON_MAP_END()
+
+// the websocket API has about 110 messages.
+static constexpr int OTHER_MESSAGES = 110;
+
+static std::vector<std::string> &OtherMessageNames()
+{
+    static std::vector<std::string> names;
+    if (names.empty())
+    {
+        for (int i = 0; i < OTHER_MESSAGES; ++i)
+        {
+            names.push_back("otherMessage" + std::to_string(i));
+        }
+    }
+    return names;
+}
+
+static SocketMessageDispatcher<TestSocketHandler> MakeDispatcher()
+{
+    // (the names must outlive the dispatcher.)
+    std::vector<std::pair<const std::string_view, SocketMessageDispatcher<TestSocketHandler>::Handler>> entries;
+    entries.push_back({"setControl", &TestSocketHandler::HandleControl});
+    for (const auto &name : OtherMessageNames())
+    {
+        entries.push_back({name, &TestSocketHandler::HandleOther});
+    }
+    return SocketMessageDispatcher<TestSocketHandler>(entries.begin(), entries.end());
+}
+
+static void Receive(const SocketMessageDispatcher<TestSocketHandler> &dispatcher, TestSocketHandler &handler, std::string_view text)
+{
+    json_reader reader(text);
+    int64_t reply = -1, replyTo = -1;
+    std::string message;
+    bool hasBody = ReadSocketMessageHeader(reader, &reply, &replyTo, &message);
+    REQUIRE(dispatcher.Dispatch(&handler, message, (int)replyTo, hasBody ? &reader : nullptr));
+}
+
+TEST_CASE("Socket message dispatch", "[socket_message_dispatcher][Build][Dev]")
+{
+    auto dispatcher = MakeDispatcher();
+    REQUIRE(dispatcher.size() == OTHER_MESSAGES + 1);
+
+    TestSocketHandler handler;
+    Receive(dispatcher, handler, R"([{"message":"setControl"},{"clientId":1,"instanceId":2,"symbol":"gain","value":0.5}])");
+    REQUIRE(handler.controls == 1);
+    REQUIRE(handler.lastValue == 0.5f);
+
+    Receive(dispatcher, handler, R"([{"message":"otherMessage7","replyTo":23},17])");
+    REQUIRE(handler.others == 1);
+    REQUIRE(handler.lastReplyTo == 23);
+
+    Receive(dispatcher, handler, R"([{"replyTo":24,"message":"otherMessage109"}])");
+    REQUIRE(handler.others == 2);
+    REQUIRE(handler.lastReplyTo == 24);
+
+    json_reader reader(std::string_view(R"([{"message":"noSuchMessage"}])"));
+    int64_t reply = -1, replyTo = -1;
+    std::string message;
+    ReadSocketMessageHeader(reader, &reply, &replyTo, &message);
+    REQUIRE(!dispatcher.Dispatch(&handler, message, (int)replyTo, nullptr));
+}
+
+TEST_CASE("Socket message dispatch benchmark", "[socket_message_dispatcher_benchmark][Dev]")
+{
+    using namespace std::chrono;
+    constexpr int MESSAGES = 200000;
+
+    // mostly control changes (a room full of phones turning knobs), with other messages spread across the API.
+    std::vector<std::string> messages;
+    for (int i = 0; i < MESSAGES; ++i)
+    {
+        if (i % 4 != 3)
+        {
+            messages.push_back(
+                R"([{"message":"setControl"},{"clientId":12,"instanceId":34,"symbol":"gain","value":)" +
+                std::to_string(i * 0.001) + "}]");
+        }
+        else
+        {
+            messages.push_back(
+                R"([{"message":")" + OtherMessageNames()[(i * 7) % OTHER_MESSAGES] + R"(","replyTo":)" +
+                std::to_string(i) + "},17]");
+        }
+    }
+
+    auto dispatcher = MakeDispatcher();
+    TestSocketHandler handler;
+
+    auto start = steady_clock::now();
+    for (const auto &text : messages)
+    {
+        json_reader reader{std::string_view(text)};
+        int64_t reply = -1, replyTo = -1;
+        std::string message;
+        bool hasBody = ReadSocketMessageHeader(reader, &reply, &replyTo, &message);
+        dispatcher.Dispatch(&handler, message, (int)replyTo, hasBody ? &reader : nullptr);
+    }
+    double dispatchSeconds = duration_cast<nanoseconds>(steady_clock::now() - start).count() * 1E-9;
+    REQUIRE(handler.controls + handler.others == MESSAGES);
+
+    // the same work, finding the handler with a chain of string comparisons (setControl first).
+    std::vector<std::string> chain;
+    chain.push_back("setControl");
+    for (const auto &name : OtherMessageNames())
+    {
+        chain.push_back(name);
+    }
+    start = steady_clock::now();
+    for (const auto &text : messages)
+    {
+        json_reader reader{std::string_view(text)};
+        int64_t reply = -1, replyTo = -1;
+        std::string message;
+        bool hasBody = ReadSocketMessageHeader(reader, &reply, &replyTo, &message);
+        for (size_t i = 0; i < chain.size(); ++i)
+        {
+            if (message == chain[i])
+            {
+                if (i == 0)
+                {
+                    handler.HandleControl((int)replyTo, &reader);
+                }
+                else
+                {
+                    handler.HandleOther((int)replyTo, hasBody ? &reader : nullptr);
+                }
+                break;
+            }
+        }
+    }
+    double chainSeconds = duration_cast<nanoseconds>(steady_clock::now() - start).count() * 1E-9;
+    REQUIRE(handler.controls + handler.others == 2 * MESSAGES);
+
+    std::cout << "Socket message dispatch benchmark (" << OTHER_MESSAGES + 1 << " messages, 1 core)" << std::endl;
+    std::cout << "    dispatch table: " << (uint64_t)(MESSAGES / dispatchSeconds) << " messages/s" << std::endl;
+    std::cout << "    if/else chain:  " << (uint64_t)(MESSAGES / chainSeconds) << " messages/s" << std::endl;
+}
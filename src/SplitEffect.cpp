@@ -220,6 +220,7 @@ int SplitEffect::GetControlIndex(const std::string &symbol) const
 void SplitEffect::Activate()
 {
     activated = true;
+    warmUpSamples = 0;
     updateMixFunction();
     snapToMixTarget();
 
@@ -305,6 +306,7 @@ void SplitEffect::snapToMixTarget()
     this->blendDxRTop = 0;
     this->blendDxLBottom = 0;
     this->blendDxRBottom = 0;
+    selectPostMix();
 }
 
 void SplitEffect::mixToTarget()
@@ -318,6 +320,7 @@ void SplitEffect::mixToTarget()
     this->blendDxRTop = dxScale * (this->targetBlendRTop - this->blendRTop);
     this->blendDxLBottom = dxScale * (this->targetBlendLBottom - this->blendLBottom);
     this->blendDxRBottom = dxScale * (this->targetBlendRBottom - this->blendRBottom);
+    selectPostMix();
 }
 
 void SplitEffect::mixTo(float value)
@@ -404,7 +407,17 @@ void SplitEffect::SetControl(int index, float value)
 
             if (splitType == SplitType::Ab)
             {
-                mixTo(selectA ? -1 : 1);
+                if (IsChainDormant(selectA))
+                {
+                    // wake the chain, and crossfade once it has warmed up (in PostMix).
+                    warmUpSamples = std::max((int32_t)(sampleRate * WARM_UP_TIME_S), (int32_t)1);
+                    selectPostMix();
+                }
+                else
+                {
+                    warmUpSamples = 0;
+                    mixTo(selectA ? -1 : 1);
+                }
             }
         }
         break;
@@ -22,7 +22,9 @@
 #include "IEffect.hpp"
 #include "PiPedalException.hpp"
 #include "PiPedalMath.hpp"
+#include "AudioMixKernels.hpp"
 #include <assert.h>
+#include <algorithm>
 #include <string>
 #include <unordered_map>
 
@@ -76,6 +78,8 @@ namespace pipedal
 
 
         const double MIX_TRANSITION_TIME_S = 0.1;
+        // A dormant chain runs for this long before it is crossfaded in, so that its plugins don't start from stale state.
+        const double WARM_UP_TIME_S = 0.05;
         double sampleRate;
 
         std::unordered_map<std::string,int> controlIndex;
@@ -124,161 +128,150 @@ namespace pipedal
 
         bool activated = false;
 
+        // In A/B mode, once the crossfade has finished, the deselected chain is dormant, and the pedalboard doesn't run it.
+        bool topChainDormant = false;
+        bool bottomChainDormant = false;
+        bool topChainCanBeDormant = true;
+        bool bottomChainCanBeDormant = true;
+        int32_t warmUpSamples = 0;
+
+        // The mix functions are specialized at compile time on the split type, channel counts and (for the post-mix)
+        // whether the gains are ramping, so that the per-period code doesn't branch on the split's configuration.
         using MixFunction = void (SplitEffect::*)(uint32_t frames);
 
-        MixFunction preAbTop;
-        MixFunction preAbBottom;
+        MixFunction preMixTop = nullptr;
+        MixFunction preMixBottom = nullptr;
+        MixFunction postMix = nullptr;
 
-        void Copy(float *input, float *output, uint32_t frames)
+        template <bool LR_SPLIT, bool TOP, size_t INPUTS, size_t CHAIN_INPUTS>
+        void preMixT(uint32_t frames)
         {
-            for (int i = 0; i < frames; ++i)
+            const std::vector<float *> &chainInputs = TOP ? this->topInputs : this->bottomInputs;
+            for (size_t c = 0; c < CHAIN_INPUTS; ++c)
             {
-                output[i] = input[i];
+                // L/R splits send the left input to the top chain, and the right input to the bottom chain.
+                constexpr size_t LR_SOURCE = (INPUTS == 1 || TOP) ? 0 : 1;
+                size_t source = LR_SPLIT ? LR_SOURCE : (INPUTS == 1 ? 0 : c);
+                CopyAudio(this->inputs[source], chainInputs[c], frames);
             }
         }
 
-        void abTopMonoMono(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-        }
-        void abTopMonoStereo(uint32_t frames)
+        template <bool LR_SPLIT, bool TOP>
+        static MixFunction selectPreMix(size_t inputs, size_t chainInputs)
         {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-            Copy(this->inputs[0], this->topInputs[1], frames);
-        }
-        void abTopStereoStereo(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-            Copy(this->inputs[1], this->topInputs[1], frames);
+            if (inputs == 1)
+            {
+                return chainInputs == 1 ? &SplitEffect::preMixT<LR_SPLIT, TOP, 1, 1> : &SplitEffect::preMixT<LR_SPLIT, TOP, 1, 2>;
+            }
+            return chainInputs == 1 ? &SplitEffect::preMixT<LR_SPLIT, TOP, 2, 1> : &SplitEffect::preMixT<LR_SPLIT, TOP, 2, 2>;
         }
 
-        void abBottomMonoMono(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->bottomInputs[0], frames);
-        }
-        void abBottomMonoStereo(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->bottomInputs[0], frames);
-            Copy(this->inputs[0], this->bottomInputs[1], frames);
-        }
-        void abBottomStereoStereo(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->bottomInputs[0], frames);
-            Copy(this->inputs[1], this->bottomInputs[1], frames);
-        }
-        void lrTopMonoMono(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-        }
-        void lrTopMonoStereo(uint32_t frames)
+        template <size_t OUTPUTS>
+        void mixStatic(uint32_t offset, uint32_t frames)
         {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-            Copy(this->inputs[0], this->topInputs[1], frames);
-        }
-        void lrTopStereoStereo(uint32_t frames)
-        {
-            Copy(this->inputs[0], this->topInputs[0], frames);
-            Copy(this->inputs[0], this->topInputs[1], frames);
+            MixAudio(
+                this->mixBottomInputs[0] + offset, this->blendLBottom,
+                this->mixTopInputs[0] + offset, this->blendLTop,
+                this->outputBuffers[0] + offset, frames);
+            if constexpr (OUTPUTS == 2)
+            {
+                MixAudio(
+                    this->mixBottomInputs[1] + offset, this->blendRBottom,
+                    this->mixTopInputs[1] + offset, this->blendRTop,
+                    this->outputBuffers[1] + offset, frames);
+            }
         }
 
-        void lrBottomMonoMono(uint32_t frames)
+        // Static post-mix when the other chain is dormant (and its output buffers are stale).
+        template <size_t OUTPUTS, bool TOP>
+        void postMixSoloT(uint32_t frames)
         {
-            Copy(this->inputs[0], this->bottomInputs[0], frames);
+            ScaleAudio(
+                TOP ? this->mixTopInputs[0] : this->mixBottomInputs[0], TOP ? this->blendLTop : this->blendLBottom,
+                this->outputBuffers[0], frames);
+            if constexpr (OUTPUTS == 2)
+            {
+                ScaleAudio(
+                    TOP ? this->mixTopInputs[1] : this->mixBottomInputs[1], TOP ? this->blendRTop : this->blendRBottom,
+                    this->outputBuffers[1], frames);
+            }
         }
-        void lrBottomMonoStereo(uint32_t frames)
+
+        template <size_t OUTPUTS, bool RAMP>
+        void postMixT(uint32_t frames)
         {
-            Copy(this->inputs[0], this->bottomInputs[0], frames);
-            Copy(this->inputs[0], this->bottomInputs[1], frames);
+            if constexpr (!RAMP)
+            {
+                mixStatic<OUTPUTS>(0, frames);
+            }
+            else
+            {
+                uint32_t framesThisTime = this->blendFadeSamples < frames ? this->blendFadeSamples : frames;
+                MixAudioRamp(
+                    this->mixBottomInputs[0], blendLBottom, blendDxLBottom,
+                    this->mixTopInputs[0], blendLTop, blendDxLTop,
+                    this->outputBuffers[0], framesThisTime);
+                this->blendLTop += framesThisTime * this->blendDxLTop;
+                this->blendLBottom += framesThisTime * this->blendDxLBottom;
+                if constexpr (OUTPUTS == 2)
+                {
+                    MixAudioRamp(
+                        this->mixBottomInputs[1], blendRBottom, blendDxRBottom,
+                        this->mixTopInputs[1], blendRTop, blendDxRTop,
+                        this->outputBuffers[1], framesThisTime);
+                    this->blendRTop += framesThisTime * this->blendDxRTop;
+                    this->blendRBottom += framesThisTime * this->blendDxRBottom;
+                }
+                this->blendFadeSamples -= framesThisTime;
+                if (this->blendFadeSamples == 0)
+                {
+                    snapToMixTarget(); // selects the static post-mix.
+                    if (framesThisTime != frames)
+                    {
+                        mixStatic<OUTPUTS>(framesThisTime, frames - framesThisTime);
+                    }
+                }
+            }
         }
-        void lrBottomStereoStereo(uint32_t frames)
+
+        void selectPostMix()
         {
-            Copy(this->inputs[1], this->bottomInputs[0], frames);
-            Copy(this->inputs[1], this->bottomInputs[1], frames);
+            bool ramp = this->blendFadeSamples != 0;
+            bool abStatic = splitType == SplitType::Ab && !ramp && this->warmUpSamples == 0;
+            this->topChainDormant = abStatic && this->topChainCanBeDormant && this->blendLTop == 0 && this->blendRTop == 0;
+            this->bottomChainDormant = abStatic && this->bottomChainCanBeDormant && this->blendLBottom == 0 && this->blendRBottom == 0;
+            if (this->topChainDormant)
+            {
+                this->postMix = this->outputBuffers.size() <= 1 ? &SplitEffect::postMixSoloT<1, false> : &SplitEffect::postMixSoloT<2, false>;
+            }
+            else if (this->bottomChainDormant)
+            {
+                this->postMix = this->outputBuffers.size() <= 1 ? &SplitEffect::postMixSoloT<1, true> : &SplitEffect::postMixSoloT<2, true>;
+            }
+            else if (this->outputBuffers.size() <= 1)
+            {
+                this->postMix = ramp ? &SplitEffect::postMixT<1, true> : &SplitEffect::postMixT<1, false>;
+            }
+            else
+            {
+                this->postMix = ramp ? &SplitEffect::postMixT<2, true> : &SplitEffect::postMixT<2, false>;
+            }
         }
 
         void updateMixFunction()
         {
             if (activated)
             {
-
                 // Input Mix Functions.
                 if (splitType != SplitType::Lr)
                 {
-                    if (this->inputs.size() == 1)
-                    {
-                        if (this->topInputs.size() == 1)
-                            this->preAbTop = &SplitEffect::abTopMonoMono;
-                        else
-                        {
-                            this->preAbTop = &SplitEffect::abTopMonoStereo;
-                        }
-                        if (this->bottomInputs.size() == 1)
-                        {
-                            this->preAbBottom = &SplitEffect::abBottomMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbBottom = &SplitEffect::abBottomMonoStereo;
-                        }
-                    }
-                    else
-                    {
-                        if (this->topInputs.size() == 1)
-                        {
-                            this->preAbTop == &SplitEffect::abTopMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbTop = &SplitEffect::abTopStereoStereo;
-                        }
-                        if (this->bottomInputs.size() == 1)
-                        {
-                            this->preAbBottom == &SplitEffect::abBottomMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbBottom = &SplitEffect::abBottomStereoStereo;
-                        }
-                    }
+                    this->preMixTop = selectPreMix<false, true>(this->inputs.size(), this->topInputs.size());
+                    this->preMixBottom = selectPreMix<false, false>(this->inputs.size(), this->bottomInputs.size());
                 }
                 else
                 {
-                    if (this->inputs.size() == 1)
-                    {
-                        if (this->topInputs.size() == 1)
-                            this->preAbTop = &SplitEffect::lrTopMonoMono;
-                        else
-                        {
-                            this->preAbTop = &SplitEffect::lrTopMonoStereo;
-                        }
-                        if (this->bottomInputs.size() == 1)
-                        {
-                            this->preAbBottom = &SplitEffect::lrBottomMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbBottom = &SplitEffect::lrBottomMonoStereo;
-                        }
-                    }
-                    else
-                    {
-                        if (this->topInputs.size() == 1)
-                        {
-                            this->preAbTop == &SplitEffect::lrTopMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbTop = &SplitEffect::lrTopStereoStereo;
-                        }
-                        if (this->bottomInputs.size() == 1)
-                        {
-                            this->preAbBottom == &SplitEffect::lrBottomMonoMono;
-                        }
-                        else
-                        {
-                            this->preAbBottom = &SplitEffect::lrBottomStereoStereo;
-                        }
-                    }
+                    this->preMixTop = selectPreMix<true, true>(this->inputs.size(), this->topInputs.size());
+                    this->preMixBottom = selectPreMix<true, false>(this->inputs.size(), this->bottomInputs.size());
                 }
                 if (splitType == SplitType::Ab)
                 {
@@ -399,122 +392,51 @@ namespace pipedal
         {
             outputBuffers[index] = buffer;
         }
-        void PreMix(uint32_t frames)
+        // True if the chain is currently silent in A/B mode, and need not be run.
+        bool IsChainDormant(bool topChain) const { return topChain ? topChainDormant : bottomChainDormant; }
+        // A chain that contains a sidechain source read from outside the chain must keep running, or the reader would
+        // get a stale buffer. Call before Activate().
+        void SetChainCanBeDormant(bool topChain, bool value)
         {
-            (this->*preAbTop)(frames);
-            (this->*preAbBottom)(frames);
+            (topChain ? topChainCanBeDormant : bottomChainCanBeDormant) = value;
         }
-
-        void PostMixMono(uint32_t frames)
+        // Zeroes the inputs of a dormant chain (which the pre-mix doesn't write), when it has to be run.
+        void SilenceChainInputs(bool topChain, uint32_t frames)
         {
-            uint32_t ix = 0;
-
-            float *top = this->mixTopInputs[0];
-            float *bottom = this->mixBottomInputs[0];
-            float *output = this->outputBuffers[0];
-
-            while (frames)
+            for (float *input : topChain ? this->topInputs : this->bottomInputs)
             {
-                if (this->blendFadeSamples != 0)
-                {
-                    uint32_t framesThisTime = this->blendFadeSamples < frames ? this->blendFadeSamples : frames;
-                    for (uint32_t i = 0; i < framesThisTime; ++i)
-                    {
-                        output[ix] = blendLBottom * bottom[ix] + blendLTop * top[ix];
-                        ++ix;
-
-                        this->blendLTop += this->blendDxLTop;
-                        this->blendLBottom += this->blendDxLBottom;
-                    }
-                    this->blendFadeSamples -= framesThisTime;
-                    frames -= framesThisTime;
-                    if (blendFadeSamples == 0)
-                    {
-                        this->blendLTop = this->targetBlendLTop;
-                        this->blendLBottom = this->targetBlendLBottom;
-                        this->blendDxLTop = this->blendDxLBottom = 0;
-                    }
-                }
-                else
-                {
-                    float blendTop = this->blendLTop;
-                    float blendBottom = this->blendLBottom;
-                    while (frames--)
-                    {
-                        output[ix] = blendBottom * bottom[ix] + blendTop * top[ix];
-                        ++ix;
-                    }
-                    return;
-                }
+                std::fill(input, input + frames, 0.0f);
             }
         }
 
-        void PostMixStereo(uint32_t frames)
+        void PreMix(uint32_t frames)
         {
-            uint32_t ix = 0;
-
-            float *top = this->mixTopInputs[0];
-            float *bottom = this->mixBottomInputs[0];
-            float *output = this->outputBuffers[0];
-
-            float *topR = this->mixTopInputs[1];
-            float *bottomR = this->mixBottomInputs[1];
-            float *outputR = this->outputBuffers[1];
+            if (!topChainDormant)
+            {
+                (this->*preMixTop)(frames);
+            }
+            if (!bottomChainDormant)
+            {
+                (this->*preMixBottom)(frames);
+            }
+        }
 
-            while (frames != 0)
+        void PostMix(uint32_t frames)
+        {
+            if (this->warmUpSamples != 0)
             {
-                if (this->blendFadeSamples != 0)
+                if ((uint32_t)this->warmUpSamples <= frames)
                 {
-                    uint32_t framesThisTime = this->blendFadeSamples < frames ? this->blendFadeSamples : frames;
-                    for (int i = 0; i < framesThisTime; ++i)
-                    {
-                        output[ix] = blendLBottom * bottom[ix] + blendLTop * top[ix];
-                        outputR[ix] = blendRBottom * bottomR[ix] + blendRTop * topR[ix];
-                        ++ix;
-
-                        this->blendLTop += this->blendDxLTop;
-                        this->blendRTop += this->blendDxRTop;
-                        this->blendLBottom += this->blendDxLBottom;
-                        this->blendRBottom += this->blendDxRBottom;
-                    }
-                    blendFadeSamples -= framesThisTime;
-                    frames -= framesThisTime;
-                    if (blendFadeSamples == 0)
-                    {
-                        this->blendLTop = this->targetBlendLTop;
-                        this->blendRTop = this->targetBlendRTop;
-                        this->blendLBottom = this->targetBlendLBottom;
-                        this->blendRBottom = this->targetBlendRBottom;
-                        this->blendDxLTop = this->blendDxRTop = this->blendDxLBottom = this->blendDxRBottom = 0;
-                    }
+                    // the newly selected chain has warmed up. Crossfade to it.
+                    this->warmUpSamples = 0;
+                    mixTo(selectA ? -1 : 1);
                 }
                 else
                 {
-                    float blendLTop = this->blendLTop;
-                    float blendRTop = this->blendRTop;
-                    float blendLBottom = this->blendLBottom;
-                    float blendRBottom = this->blendRBottom;
-
-                    for (int i = 0; i < frames; ++i)
-                    {
-                        output[ix] = blendLBottom * bottom[ix] + blendLTop * top[ix];
-                        outputR[ix] = blendRBottom * bottomR[ix] + blendRTop * topR[ix];
-                        ++ix;
-                    }
-                    return;
+                    this->warmUpSamples -= frames;
                 }
             }
-        }
-        void PostMix(uint32_t frames)
-        {
-            if (this->outputBuffers.size() == 1)
-            {
-                PostMixMono(frames);
-            }
-            else
-            {
-                PostMixStereo(frames);
-            }
+            (this->*postMix)(frames);
         }
 
         virtual bool GetRequestStateChangedNotification() const  { return false; }
@@ -19,14 +19,58 @@
 
 #include "StateInterface.hpp"
 #include "ss.hpp"
-#include "Base64.hpp"
+#include "Base64Codec.hpp"
 #include "json.hpp"
 #include <sstream>
 #include <string.h>
 #include "Lv2Log.hpp"
+#include "HtmlHelper.hpp"
+#include "Lv2StateBlobStore.hpp"
+#include <zlib.h>
 
 using namespace pipedal;
 
+// Values at least this large are compressed.
+static constexpr size_t COMPRESSION_THRESHOLD = 4096;
+// Sanity limit for the declared size of a compressed value.
+static constexpr uint64_t MAX_DECOMPRESSED_SIZE = 1024 * 1024 * 1024;
+
+static bool ZlibCompress(const std::vector<uint8_t> &input, std::vector<uint8_t> *output)
+{
+    uLongf outputSize = compressBound((uLong)input.size());
+    output->resize(outputSize);
+    // state is compressed every time it's sent to clients, so favor speed.
+    if (compress2(output->data(), &outputSize, input.data(), (uLong)input.size(), Z_BEST_SPEED) != Z_OK)
+    {
+        return false;
+    }
+    output->resize(outputSize);
+    return true;
+}
+
+static bool ZlibDecompress(const std::vector<uint8_t> &input, uint64_t size, std::vector<uint8_t> *output)
+{
+    if (size > MAX_DECOMPRESSED_SIZE)
+    {
+        return false;
+    }
+    output->resize(size);
+    uLongf outputSize = (uLongf)size;
+    if (uncompress(output->data(), &outputSize, input.data(), (uLong)input.size()) != Z_OK || outputSize != size)
+    {
+        return false;
+    }
+    return true;
+}
+
+static uint64_t HashStateEntry(const std::string &key, const std::string &atomType, int32_t flags, const void *value, size_t size)
+{
+    uint64_t crc = HtmlHelper::crc64(key);
+    crc = HtmlHelper::crc64(atomType, crc);
+    crc = HtmlHelper::crc64((uint8_t *)&flags, sizeof(flags), crc);
+    return HtmlHelper::crc64((uint8_t *)value, size, crc);
+}
+
 LV2_State_Status StateInterface::FnStateStoreFunction(
     LV2_State_Handle handle,
     uint32_t key,
@@ -60,18 +104,19 @@ LV2_State_Status StateInterface::StateStoreFunction(
     Lv2PluginState &state = pCallState->state;
 
     std::string  strKey = map.UridToString(key);
+    std::string atomType = map.UridToString(type);
+    // entries are summed, so that the hash doesn't depend on the order in which they are stored.
+    pCallState->hash += HashStateEntry(strKey, atomType, (int32_t)flags, value, size);
+    if (pCallState->hashOnly)
+    {
+        return LV2_State_Status::LV2_STATE_SUCCESS;
+    }
+
     Lv2PluginStateEntry& entry = state.values_[strKey];
 
-    std::string atomType = map.UridToString(type);
     entry.atomType_ = atomType;
     entry.flags_ = flags;
-    entry.value_.resize(size);
-    uint8_t *p = (uint8_t*)value;
-
-    for (size_t i = 0; i < size; ++i)
-    {
-        entry.value_[i] = p[i];
-    }
+    entry.value_ = Lv2StateValue(value, size);
     return LV2_State_Status::LV2_STATE_SUCCESS;
 }
 
@@ -105,7 +150,37 @@ static void CheckState(LV2_State_Status status)
     }
     throw std::logic_error(lv2Error);
 }
-Lv2PluginState StateInterface::Save()
+bool StateInterface::SaveHash(uint64_t *hash)
+{
+    SaveCallState callState;
+    callState.pThis = this;
+    callState.status = LV2_State_Status::LV2_STATE_SUCCESS;
+    callState.hashOnly = true;
+
+    LV2_Feature **features = &(this->features[0]);
+    LV2_Handle instanceHandle = lilv_instance_get_handle(pInstance);
+    try
+    {
+        LV2_State_Status status =
+            pluginStateInterface->save(
+                instanceHandle,
+                FnStateStoreFunction,
+                (LV2_State_Handle)&callState,
+                LV2_STATE_IS_POD | LV2_STATE_IS_PORTABLE,
+                features);
+        CheckState(status);
+        CheckState(callState.status);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::debug(SS("State save failed. " << e.what()));
+        return false;
+    }
+    *hash = callState.hash;
+    return true;
+}
+
+Lv2PluginState StateInterface::Save(uint64_t *hash)
 {
     SaveCallState callState;
     callState.pThis = this;
@@ -131,6 +206,10 @@ Lv2PluginState StateInterface::Save()
         Lv2Log::debug(SS("State save failed. " << e.what()));
         return Lv2PluginState(); // an invalid state.
     }
+    if (hash)
+    {
+        *hash = callState.hash;
+    }
 
     return std::move(callState.state);
 }
@@ -223,6 +302,12 @@ void Lv2PluginState::read_json(json_reader &reader) {
 }
 
 
+const std::vector<uint8_t> &Lv2StateValue::Empty()
+{
+    static const std::vector<uint8_t> empty;
+    return empty;
+}
+
 void Lv2PluginStateEntry::write_json(json_writer &writer) const
 {
     writer.start_object();
@@ -248,8 +333,32 @@ void Lv2PluginStateEntry::write_json(json_writer &writer) const
         }
         writer.write_member("value",*(float*)&(value_[0]));
     } else {
-        std::string base64 = macaron::Base64::Encode(value_);
-        writer.write_member("value",base64);
+        // large values are compressed, if that helps.
+        const std::vector<uint8_t> *payload = &value_.get();
+        std::vector<uint8_t> compressed;
+        if (value_.size() >= COMPRESSION_THRESHOLD && ZlibCompress(value_.get(), &compressed) && compressed.size() < value_.size() - value_.size() / 8)
+        {
+            payload = &compressed;
+            writer.write_member("encoding","zlib");
+            writer.write_raw(",");
+            writer.write_member("size",(uint64_t)value_.size());
+            writer.write_raw(",");
+        }
+        if (payload->size() >= Lv2StateBlobStore::OUT_OF_LINE_THRESHOLD && Lv2StateBlobStore::IsOutOfLine())
+        {
+            try
+            {
+                std::string key = Lv2StateBlobStore::GetInstance()->Put(*payload);
+                writer.write_member("valueRef",key);
+                writer.end_object();
+                return;
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::warning(SS("Can't store LV2 state value out-of-line. " << e.what()));
+            }
+        }
+        writer.write_member("value",Base64Encode(*payload));
     }
     writer.end_object();
 }
@@ -264,23 +373,63 @@ void Lv2PluginStateEntry::read_json(json_reader &reader)
     {
         std::string v;
         reader.read_member("value",&v);
-        value_.resize(v.length()+1);
-        for (size_t i = 0; i < v.length(); ++i)
-        {
-            value_[i] = (uint8_t)v[i];
-        }
-        value_[v.length()] = 0;
+        value_ = Lv2StateValue(v.c_str(), v.length()+1); // including the terminating null.
     } else if (atomType_ == LV2_ATOM__Float)
     {
         float v;
         reader.read_member("value",&v);
-        value_.resize(sizeof(float));
-        float *pVal = (float*)&(value_[0]);
-        *pVal = v;
+        value_ = Lv2StateValue(&v, sizeof(v));
     } else {
-        std::string v;
-        reader.read_member("value",&v);
-        value_ = macaron::Base64::Decode(v);
+        std::vector<uint8_t> value;
+        std::string encoding;
+        uint64_t size = 0;
+        while (true)
+        {
+            std::string name;
+            reader.read(&name);
+            reader.consume(':');
+            if (name == "encoding")
+            {
+                reader.read(&encoding);
+            } else if (name == "size")
+            {
+                reader.read(&size);
+            } else if (name == "valueRef")
+            {
+                std::string key;
+                reader.read(&key);
+                auto store = Lv2StateBlobStore::GetInstance();
+                if (!store || !store->Get(key,&value))
+                {
+                    throw std::runtime_error(SS("LV2 state value " << key << " is missing."));
+                }
+            } else if (name == "value")
+            {
+                std::string v;
+                reader.read(&v);
+                value = Base64Decode(v);
+            } else {
+                throw std::logic_error("Expecting property 'value'");
+            }
+            if (reader.peek() != ',')
+            {
+                break;
+            }
+            reader.consume(',');
+        }
+        if (encoding == "zlib")
+        {
+            std::vector<uint8_t> decompressed;
+            if (!ZlibDecompress(value, size, &decompressed))
+            {
+                throw std::runtime_error("Invalid compressed LV2 state value.");
+            }
+            value = std::move(decompressed);
+        } else if (!encoding.empty())
+        {
+            throw std::runtime_error(SS("Unsupported LV2 state value encoding: " << encoding));
+        }
+        value_ = std::move(value);
     }
     reader.end_object();
 }
@@ -315,6 +464,16 @@ bool Lv2PluginStateEntry::operator==(const Lv2PluginStateEntry&other) const
     return this->atomType_ == other.atomType_ && this->value_ == other.value_;
 }
 
+uint64_t Lv2PluginState::Hash() const
+{
+    uint64_t hash = 0;
+    for (const auto &value : values_)
+    {
+        hash += HashStateEntry(value.first, value.second.atomType_, value.second.flags_, value.second.value_.data(), value.second.value_.size());
+    }
+    return hash;
+}
+
 bool Lv2PluginState::IsEqual(const Lv2PluginState&other) const
 {
     if (other.isValid_ != this->isValid_) return false;
@@ -22,6 +22,8 @@
 #include "lilv/lilv.h"
 #include "lv2/state/state.h"
 #include <cstddef>
+#include <memory>
+#include <vector>
 #include "json_variant.hpp"
 #include "MapFeature.hpp"
 #include "IHost.hpp"
@@ -29,11 +31,51 @@
 
 namespace pipedal
 {
+    /**
+     * @brief An immutable, shared LV2 state value.
+     *
+     * State values can be large (convolution IRs, neural models). Copies of a value share the
+     * same bytes, so copying Lv2PluginStates, PedalboardItems and Pedalboards (for broadcasts,
+     * saves, snapshots and the previous-pedalboard diff) doesn't copy the values. Assigning a
+     * new value replaces the shared bytes rather than modifying them.
+     */
+    class Lv2StateValue
+    {
+    public:
+        Lv2StateValue() {}
+        Lv2StateValue(std::vector<uint8_t> &&value)
+            : value(std::make_shared<const std::vector<uint8_t>>(std::move(value))) {}
+        Lv2StateValue(const std::vector<uint8_t> &value)
+            : value(std::make_shared<const std::vector<uint8_t>>(value)) {}
+        Lv2StateValue(const void *data, size_t size)
+            : value(std::make_shared<const std::vector<uint8_t>>((const uint8_t *)data, (const uint8_t *)data + size)) {}
+
+        const std::vector<uint8_t> &get() const { return value ? *value : Empty(); }
+        operator const std::vector<uint8_t> &() const { return get(); }
+
+        size_t size() const { return value ? value->size() : 0; }
+        bool empty() const { return size() == 0; }
+        const uint8_t *data() const { return get().data(); }
+        const uint8_t &operator[](size_t index) const { return (*value)[index]; }
+        std::vector<uint8_t>::const_iterator begin() const { return get().begin(); }
+        std::vector<uint8_t>::const_iterator end() const { return get().end(); }
+
+        bool operator==(const Lv2StateValue &other) const { return value == other.value || get() == other.get(); }
+        bool operator!=(const Lv2StateValue &other) const { return !(*this == other); }
+
+        // True if both values share the same bytes.
+        bool IsSharedWith(const Lv2StateValue &other) const { return value != nullptr && value == other.value; }
+
+    private:
+        static const std::vector<uint8_t> &Empty();
+        std::shared_ptr<const std::vector<uint8_t>> value;
+    };
+
     class Lv2PluginStateEntry: public JsonSerializable {
     public:
         std::int32_t flags_ = 0;
         std::string atomType_;
-        std::vector<uint8_t> value_;
+        Lv2StateValue value_;
 
         bool operator==(const Lv2PluginStateEntry&other) const;
     private:
@@ -55,6 +97,9 @@ namespace pipedal
         bool operator==(const Lv2PluginState&other) const { return IsEqual(other); }
         bool operator!=(const Lv2PluginState&other) const { return !IsEqual(other); }
 
+        // Independent of the order in which values were stored. Matches the hash computed by StateInterface::SaveHash().
+        uint64_t Hash() const;
+
         std::string ToString() const;
     private:
         virtual void write_json(json_writer &writer) const;
@@ -74,7 +119,9 @@ namespace pipedal
             const LV2_State_Interface *pluginStateInterface);
 
     public:
-        Lv2PluginState Save();
+        Lv2PluginState Save(uint64_t *hash = nullptr);
+        // Hashes the plugin's current state, without copying it. Returns false if the plugin's save failed.
+        bool SaveHash(uint64_t *hash);
         void Restore(const Lv2PluginState &state);
         void RestoreState(LilvState *pLv2State);
 
@@ -97,6 +144,8 @@ namespace pipedal
             StateInterface *pThis;
             LV2_State_Status status;
             Lv2PluginState state;
+            bool hashOnly = false;
+            uint64_t hash = 0;
         };
         struct RestoreCallState
         {
@@ -0,0 +1,140 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "StaticFileCache.hpp"
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace pipedal;
+
+std::string StaticFileCache::FileStatus::ETag() const
+{
+    std::ostringstream s;
+    s << '"' << std::hex << mtimeNs << '-' << size << '"';
+    return s.str();
+}
+
+StaticFileCache::StaticFileCache(size_t maxBytes, size_t maxEntrySize, const std::string &name)
+    : maxBytes(maxBytes), maxEntrySize(maxEntrySize)
+{
+    cacheRegistration = CacheRegistry::GetInstance().Register(
+        name, CachePriority::Discardable,
+        [this]()
+        { return GetCachedBytes(); },
+        [this](TrimLevel)
+        { Clear(); });
+}
+
+bool StaticFileCache::GetFileStatus(const std::filesystem::path &path, FileStatus *status)
+{
+    struct stat fStat;
+    if (stat(path.c_str(), &fStat) != 0 || !S_ISREG(fStat.st_mode))
+    {
+        return false;
+    }
+    status->size = (size_t)fStat.st_size;
+    status->mtime = fStat.st_mtim.tv_sec;
+    status->mtimeNs = (int64_t)fStat.st_mtim.tv_sec * 1000000000LL + fStat.st_mtim.tv_nsec;
+    return true;
+}
+
+std::shared_ptr<const std::string> StaticFileCache::GetContent(const std::filesystem::path &path, const FileStatus &status)
+{
+    if (status.size > maxEntrySize)
+    {
+        return nullptr;
+    }
+    std::string key = path.string();
+    {
+        std::lock_guard lock{mutex};
+        auto ff = index.find(key);
+        if (ff != index.end())
+        {
+            auto iter = ff->second;
+            if (iter->status.mtimeNs == status.mtimeNs && iter->status.size == status.size)
+            {
+                lruList.splice(lruList.begin(), lruList, iter);
+                ++hits;
+                return iter->content;
+            }
+            // stale.
+            cachedBytes -= iter->content->size();
+            lruList.erase(iter);
+            index.erase(ff);
+        }
+    }
+
+    // Read outside the lock. (Concurrent misses on the same file just read it twice.)
+    std::ifstream f(path, std::ios::in | std::ios::binary);
+    if (!f)
+    {
+        return nullptr;
+    }
+    std::string content;
+    content.resize(status.size);
+    f.read(content.data(), (std::streamsize)status.size);
+    if ((size_t)f.gcount() != status.size)
+    {
+        return nullptr; // modified while we were reading it.
+    }
+    auto result = std::make_shared<const std::string>(std::move(content));
+
+    std::lock_guard lock{mutex};
+    if (!index.contains(key))
+    {
+        lruList.push_front(Entry{key, status, result});
+        index[key] = lruList.begin();
+        cachedBytes += result->size();
+        Evict();
+    }
+    return result;
+}
+
+void StaticFileCache::Evict()
+{
+    while (cachedBytes > maxBytes && !lruList.empty())
+    {
+        auto &last = lruList.back();
+        cachedBytes -= last.content->size();
+        index.erase(last.path);
+        lruList.pop_back();
+    }
+}
+
+size_t StaticFileCache::GetCachedBytes() const
+{
+    std::lock_guard lock{mutex};
+    return cachedBytes;
+}
+size_t StaticFileCache::GetHits() const
+{
+    std::lock_guard lock{mutex};
+    return hits;
+}
+
+void StaticFileCache::Clear()
+{
+    std::lock_guard lock{mutex};
+    // content still being sent is kept alive by its shared_ptr.
+    lruList.clear();
+    index.clear();
+    cachedBytes = 0;
+}
@@ -0,0 +1,94 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "CacheRegistry.hpp"
+#include <cstddef>
+#include <ctime>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pipedal
+{
+    /**
+     * @brief In-memory LRU cache of static web files (the React bundle, images, fonts).
+     *
+     * Entries are validated against the file's mtime and size on each lookup (a stat, which
+     * doesn't read the file), so an edited file is reloaded. Files larger than
+     * maxEntrySize aren't cached; they should be streamed from disk instead.
+     *
+     * The cache registers itself with the CacheRegistry, and is emptied under memory pressure.
+     */
+    class StaticFileCache
+    {
+    public:
+        class FileStatus
+        {
+        public:
+            size_t size = 0;
+            int64_t mtimeNs = 0;
+            time_t mtime = 0;
+
+            // A strong entity tag derived from mtime and size.
+            std::string ETag() const;
+        };
+
+        StaticFileCache(size_t maxBytes = 16 * 1024 * 1024, size_t maxEntrySize = 2 * 1024 * 1024, const std::string &name = "static files");
+
+        // false if the file doesn't exist, or isn't a regular file.
+        static bool GetFileStatus(const std::filesystem::path &path, FileStatus *status);
+
+        // The file's contents, or nullptr if the file is too large to cache, or can't be read.
+        std::shared_ptr<const std::string> GetContent(const std::filesystem::path &path, const FileStatus &status);
+
+        size_t GetMaxEntrySize() const { return maxEntrySize; }
+        size_t GetCachedBytes() const;
+        size_t GetHits() const;
+        void Clear();
+
+    private:
+        class Entry
+        {
+        public:
+            std::string path;
+            FileStatus status;
+            std::shared_ptr<const std::string> content;
+        };
+        using EntryList = std::list<Entry>;
+
+        void Evict();
+
+        size_t maxBytes;
+        size_t maxEntrySize;
+
+        mutable std::mutex mutex;
+        size_t cachedBytes = 0;
+        size_t hits = 0;
+        EntryList lruList; // most recently used first.
+        std::unordered_map<std::string, EntryList::iterator> index;
+
+        CacheRegistry::Registration::ptr cacheRegistration; // declared last, so that it's destroyed first.
+    };
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "StaticFileCache.hpp"
+#include <fstream>
+#include <thread>
+#include <chrono>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static void WriteFile(const fs::path &path, const std::string &content)
+{
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f << content;
+}
+
+TEST_CASE("StaticFileCache", "[static_file_cache][Build][Dev]")
+{
+    fs::path dir = fs::temp_directory_path() / "pipedalStaticFileCacheTest";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+
+    fs::path a = dir / "a.js";
+    fs::path b = dir / "b.js";
+    fs::path big = dir / "big.js";
+    WriteFile(a, std::string(100, 'a'));
+    WriteFile(b, std::string(100, 'b'));
+    WriteFile(big, std::string(1000, 'c'));
+
+    StaticFileCache cache(250, 500);
+
+    StaticFileCache::FileStatus status;
+    REQUIRE(!StaticFileCache::GetFileStatus(dir / "missing.js", &status));
+    REQUIRE(!StaticFileCache::GetFileStatus(dir, &status)); // directories aren't served.
+
+    SECTION("hits and etags")
+    {
+        REQUIRE(StaticFileCache::GetFileStatus(a, &status));
+        REQUIRE(status.size == 100);
+        auto content = cache.GetContent(a, status);
+        REQUIRE(content);
+        REQUIRE(*content == std::string(100, 'a'));
+        REQUIRE(cache.GetHits() == 0);
+
+        auto content2 = cache.GetContent(a, status);
+        REQUIRE(content2 == content);
+        REQUIRE(cache.GetHits() == 1);
+        REQUIRE(cache.GetCachedBytes() == 100);
+
+        StaticFileCache::FileStatus status2;
+        REQUIRE(StaticFileCache::GetFileStatus(a, &status2));
+        REQUIRE(status2.ETag() == status.ETag());
+    }
+    SECTION("modified files are reloaded")
+    {
+        REQUIRE(StaticFileCache::GetFileStatus(a, &status));
+        std::string etag = status.ETag();
+        REQUIRE(cache.GetContent(a, status));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        WriteFile(a, std::string(120, 'x'));
+        REQUIRE(StaticFileCache::GetFileStatus(a, &status));
+        REQUIRE(status.ETag() != etag);
+        auto content = cache.GetContent(a, status);
+        REQUIRE(*content == std::string(120, 'x'));
+        REQUIRE(cache.GetCachedBytes() == 120);
+    }
+    SECTION("large files aren't cached")
+    {
+        REQUIRE(StaticFileCache::GetFileStatus(big, &status));
+        REQUIRE(!cache.GetContent(big, status));
+        REQUIRE(cache.GetCachedBytes() == 0);
+    }
+    SECTION("least recently used files are evicted")
+    {
+        fs::path c = dir / "c.js";
+        WriteFile(c, std::string(100, 'c'));
+
+        StaticFileCache::FileStatus statusA, statusB, statusC;
+        REQUIRE(StaticFileCache::GetFileStatus(a, &statusA));
+        REQUIRE(StaticFileCache::GetFileStatus(b, &statusB));
+        REQUIRE(StaticFileCache::GetFileStatus(c, &statusC));
+
+        cache.GetContent(a, statusA);
+        cache.GetContent(b, statusB);
+        cache.GetContent(a, statusA); // a is now most recently used.
+        cache.GetContent(c, statusC); // evicts b.
+        REQUIRE(cache.GetCachedBytes() == 200);
+
+        size_t hits = cache.GetHits();
+        cache.GetContent(a, statusA);
+        REQUIRE(cache.GetHits() == hits + 1);
+        cache.GetContent(b, statusB);
+        REQUIRE(cache.GetHits() == hits + 1); // b was reloaded.
+    }
+    SECTION("trimmed under memory pressure")
+    {
+        REQUIRE(StaticFileCache::GetFileStatus(b, &status));
+        auto content = cache.GetContent(b, status);
+        REQUIRE(cache.GetCachedBytes() != 0);
+        CacheRegistry::GetInstance().Trim(TrimLevel::Critical);
+        REQUIRE(cache.GetCachedBytes() == 0);
+        REQUIRE(*content == std::string(100, 'b')); // still valid.
+    }
+    fs::remove_all(dir);
+}
@@ -31,10 +31,14 @@
 #include "Lv2Log.hpp"
 #include <map>
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <cstring>
+#include <unistd.h>
 #include "PiPedalUI.hpp"
 #include "PluginHost.hpp"
 #include "ss.hpp"
 #include "ofstream_synced.hpp"
+#include "Lv2StateBlobStore.hpp"
 #include "ModFileTypes.hpp"
 #include <set>
 #include <MimeTypes.hpp>
@@ -43,12 +47,14 @@
 #include "Utf8Utils.hpp"
 #include "AtomConverter.hpp"
 #include "FileBrowserFilesFeature.hpp"
+#include "PresetBundle.hpp"
 
 using namespace pipedal;
 namespace fs = std::filesystem;
 
 const char *BANK_EXTENSION = ".bank";
 const char *BANKS_FILENAME = "index.banks";
+const char *BANK_FILE_INDEX_EXTENSION = ".index";
 
 #define USER_SETTINGS_FILENAME "userSettings.json";
 
@@ -63,6 +69,100 @@ Storage::Storage()
     SetDataRoot("~/var/PiPedal");
 }
 
+Storage::~Storage()
+{
+    try
+    {
+        FlushPendingWrites();
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("Failed to save presets. " << e.what()));
+    }
+}
+
+// Write to a temporary file, fsync it, and rename it into place, so that a crash or power
+// failure leaves either the old file or the new one. Syncs only this file (and its directory),
+// rather than the whole file system.
+static void WriteFileAtomically(const std::filesystem::path &path, const std::string &content)
+{
+    std::filesystem::path tempPath = path.string() + ".$$$";
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1)
+    {
+        throw PiPedalException(SS("Can't write to " << path << ". " << strerror(errno)));
+    }
+    const char *p = content.data();
+    size_t remaining = content.size();
+    bool failed = false;
+    while (remaining != 0)
+    {
+        ssize_t written = ::write(fd, p, remaining);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            failed = true;
+            break;
+        }
+        p += written;
+        remaining -= (size_t)written;
+    }
+    if (!failed && ::fdatasync(fd) != 0)
+    {
+        failed = true;
+    }
+    int savedErrno = errno;
+    ::close(fd);
+    if (failed)
+    {
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        throw PiPedalException(SS("Can't write to " << path << ". " << strerror(savedErrno)));
+    }
+    std::filesystem::rename(tempPath, path);
+
+    int dirFd = ::open(path.parent_path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd != -1)
+    {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+template <typename T>
+static std::string ToJsonString(const T &value)
+{
+    std::ostringstream s;
+    json_writer writer(s, true);
+    writer.write(value);
+    return s.str();
+}
+
+void Storage::SetWriteBehind(std::function<void()> &&onWritePending)
+{
+    if (!onWritePending)
+    {
+        FlushPendingWrites();
+    }
+    this->onWritePending = std::move(onWritePending);
+}
+
+void Storage::FlushPendingWrites()
+{
+    if (currentBankDirty)
+    {
+        auto indexEntry = this->bankIndex.getBankIndexEntry(this->bankIndex.selectedBank());
+        WriteBankFile(indexEntry.name(), this->currentBank);
+        currentBankDirty = false;
+    }
+    if (bankIndexDirty)
+    {
+        WriteBankIndex();
+        bankIndexDirty = false;
+    }
+}
+
 inline bool isSafeCharacter(char c)
 {
     return (c >= '0' && c <= '9') | (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '-';
@@ -248,12 +348,59 @@ static void removeFileNoThrow(const std::filesystem::path &path)
     }
 }
 
+// Identifies the installed factory presets by file metadata only, so that an unchanged install
+// can be detected at startup without reading or parsing anything.
+static std::string FactoryPresetsStamp(const fs::path &presetsConfigDirectory)
+{
+    std::stringstream s;
+    for (const char *fileName : {"banks.versionInfo", "Default+Bank.bank"})
+    {
+        fs::path path = presetsConfigDirectory / fileName;
+        std::error_code ec;
+        auto size = fs::file_size(path, ec);
+        if (ec)
+        {
+            s << fileName << ":-;";
+            continue;
+        }
+        auto writeTime = fs::last_write_time(path, ec);
+        s << fileName << ":" << size << ":" << writeTime.time_since_epoch().count() << ";";
+    }
+    return s.str();
+}
+
+static std::string ReadStampFile(const fs::path &path)
+{
+    std::ifstream f(path);
+    std::string result;
+    std::getline(f, result);
+    return result;
+}
 
 void Storage::UpgradeFactoryPresets()
 {
     auto presetsDirectory = this->GetPresetsDirectory();
     auto presetsConfigDirectory = this->configRoot / "default_presets" / "presets";
 
+    fs::path stampFile = presetsDirectory / "factoryPresets.stamp";
+    std::string stamp = FactoryPresetsStamp(presetsConfigDirectory);
+    if (ReadStampFile(stampFile) == stamp)
+    {
+        return; // fast path: nothing has changed since the last upgrade.
+    }
+    UpgradeFactoryPresets_(presetsDirectory, presetsConfigDirectory);
+    try
+    {
+        WriteFileAtomically(stampFile, stamp);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't write " << stampFile << ". " << e.what()));
+    }
+}
+
+void Storage::UpgradeFactoryPresets_(const fs::path &presetsDirectory, const fs::path &presetsConfigDirectory)
+{
     using namespace ::pipedal::implementation;
 
     BrowserFilesVersionInfo defaultConfigPresetsVersion;
@@ -307,6 +454,9 @@ void Storage::UpgradeFactoryPresets()
             SaveBankFile(name, bankFile);
             this->bankIndex.addBank(-1, name);
             this->SaveBankIndex();
+
+            presetsVersion.Version(defaultConfigPresetsVersion.Version());
+            presetsVersion.Save(defaultPresetsVersionFile);
         }
         else
         {
@@ -331,13 +481,13 @@ void Storage::UpgradeFactoryPresets()
             for (size_t i = 0; i < pFactoryPresetsBank->presets().size(); ++i)
             {
                 auto &preset = pFactoryPresetsBank->presets()[i];
-                nameToPositionIndex[preset->preset().name()] = i;
+                nameToPositionIndex[preset->name()] = i;
             }
 
             // merge new presets into the existing ones (overwriting as neccessary)
             for (auto &newPresetEntry : newFactoryPresets.presets())
             {
-                const std::string name = newPresetEntry->preset().name();
+                const std::string name = newPresetEntry->name();
 
                 auto f = nameToPositionIndex.find(name);
                 if (f != nameToPositionIndex.end())
@@ -364,6 +514,7 @@ void Storage::Initialize()
     {
         std::filesystem::create_directories(this->GetPresetsDirectory());
         std::filesystem::create_directories(this->GetPluginPresetsDirectory());
+        Lv2StateBlobStore::SetInstance(std::make_shared<Lv2StateBlobStore>(this->dataRoot / "lv2_state"));
 
         MaybeCopyDefaultPresets();
     }
@@ -382,6 +533,7 @@ void Storage::Initialize()
     catch (const std::exception &)
     {
     }
+    LoadPedalboardSlots();
     LoadAlsaSequencerConfiguration();
 
     LoadWifiConfigSettings();
@@ -442,6 +594,10 @@ std::filesystem::path Storage::GetChannelSelectionFileName()
 {
     return this->dataRoot / "JackChannelSelection.json";
 }
+std::filesystem::path Storage::GetPedalboardSlotsFileName()
+{
+    return this->dataRoot / "PedalboardSlots.json";
+}
 std::filesystem::path Storage::GetAlsaSequencerConfigurationFileName()
 {
     return this->dataRoot / "MidiDevices.json";
@@ -455,6 +611,11 @@ std::filesystem::path Storage::GetBankFileName(const std::string &name) const
     std::string fileName = SafeEncodeName(name) + BANK_EXTENSION;
     return this->GetPresetsDirectory() / fileName;
 }
+std::filesystem::path Storage::GetBankFileIndexName(const std::string &name) const
+{
+    std::string fileName = SafeEncodeName(name) + BANK_EXTENSION + BANK_FILE_INDEX_EXTENSION;
+    return this->GetPresetsDirectory() / fileName;
+}
 
 void Storage::LoadBankIndex()
 {
@@ -525,10 +686,23 @@ void Storage::SavePluginPresetIndex()
 
 void Storage::SaveBankIndex()
 {
-    pipedal::ofstream_synced os;
-    os.open(GetIndexFileName(), std::ios_base::trunc);
-    json_writer writer(os, true);
-    writer.write(this->bankIndex);
+    if (onWritePending)
+    {
+        // only notify on the first deferred write; the flush picks up everything after it.
+        bool wasPending = HasPendingWrites();
+        bankIndexDirty = true;
+        if (!wasPending)
+        {
+            onWritePending();
+        }
+        return;
+    }
+    WriteBankIndex();
+}
+
+void Storage::WriteBankIndex()
+{
+    WriteFileAtomically(GetIndexFileName(), ToJsonString(this->bankIndex));
 }
 
 void Storage::ReIndex()
@@ -573,63 +747,84 @@ void Storage::CreateBank(const std::string &name)
     this->SaveBankIndex();
 }
 
-void Storage::GetBankFile(int64_t instanceId, BankFile *pBank) const
+void Storage::GetBankFile(int64_t instanceId, BankFile *pBank)
 {
+    FlushPendingWrites(); // the current bank may not have been written yet.
     auto indexEntry = this->bankIndex.getBankIndexEntry(instanceId);
-    auto name = indexEntry.name();
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::ifstream is(fileName);
-    json_reader reader(is);
-    reader.read(pBank);
+    LoadBankFile(indexEntry.name(), pBank);
     pBank->name(indexEntry.name());
 }
 
-void Storage::LoadBankFile(const std::string &name, BankFile *pBank)
+std::vector<std::filesystem::path> Storage::GetBankFilePaths(int64_t instanceId) const
 {
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::ifstream is(fileName);
-    json_reader reader(is);
-    reader.read(pBank);
+    const auto &indexEntry = this->bankIndex.getBankIndexEntry(instanceId);
+    return {GetBankFileName(indexEntry.name()), GetBankFileIndexName(indexEntry.name())};
 }
 
-void Storage::SaveBankFile(const std::string &name, const BankFile &bankFile)
+void Storage::LoadBankFile(const std::string &name, BankFile *pBank)
 {
-    std::filesystem::path fileName = GetBankFileName(name);
-    std::filesystem::path backupFile = ((std::string)fileName) + ".$$$";
-    if (std::filesystem::exists(backupFile))
+    FlushPendingWrites();
+    // Presets are parsed on demand, using the bank's sidecar index to locate them.
+    std::filesystem::path indexFileName = GetBankFileIndexName(name);
+    auto newIndex = pBank->LoadIndexed(GetBankFileName(name), indexFileName);
+    if (newIndex)
     {
-        std::filesystem::remove(backupFile);
+        WriteBankFileIndex(indexFileName, newIndex.value());
     }
-    if (std::filesystem::exists(fileName))
+}
+
+void Storage::SaveBankFile(const std::string &name, BankFile &bankFile)
+{
+    // keep writes in order.
+    FlushPendingWrites();
+    WriteBankFile(name, bankFile);
+}
+
+void Storage::WriteBankFile(const std::string &name, BankFile &bankFile)
+{
+    std::filesystem::path fileName = GetBankFileName(name);
+    BankFileIndex index;
+    Lv2StateBlobStore::OutOfLineScope outOfLine; // large state values are stored separately, by hash.
+    if (binaryBankFiles)
     {
-        std::filesystem::rename(fileName, backupFile);
+        // binary bank files carry their own index.
+        WriteFileAtomically(fileName, bankFile.SerializeBinary(&index));
+        bankFile.Attach(fileName, &index);
+        return;
     }
+    WriteFileAtomically(fileName, bankFile.Serialize(&index));
+    // drop parsed presets that are now on disk.
+    bankFile.Attach(fileName, &index);
+    WriteBankFileIndex(GetBankFileIndexName(name), index);
+}
+
+void Storage::WriteBankFileIndex(const std::filesystem::path &path, const BankFileIndex &index)
+{
+    // The index is a cache. If it doesn't get written, the bank file gets rescanned on the next load.
     try
     {
-        pipedal::ofstream_synced s;
-        s.open(fileName, std::ios_base::trunc);
-        json_writer writer(s, true);
-        writer.write(bankFile);
-        if (std::filesystem::exists(backupFile))
-        {
-            std::filesystem::remove(backupFile);
-        }
+        WriteFileAtomically(path, ToJsonString(index));
     }
     catch (const std::exception &e)
     {
-        std::filesystem::remove(fileName);
-        if (std::filesystem::exists(backupFile))
-        {
-            std::filesystem::rename(backupFile, fileName);
-        }
-        throw;
+        Lv2Log::warning(SS("Failed to write bank index. " << e.what()));
     }
 }
 
 void Storage::SaveCurrentBank()
 {
+    if (onWritePending)
+    {
+        bool wasPending = HasPendingWrites();
+        currentBankDirty = true;
+        if (!wasPending)
+        {
+            onWritePending();
+        }
+        return;
+    }
     auto indexEntry = this->bankIndex.getBankIndexEntry(this->bankIndex.selectedBank());
-    SaveBankFile(indexEntry.name(), this->currentBank);
+    WriteBankFile(indexEntry.name(), this->currentBank);
 }
 
 const Pedalboard &Storage::GetCurrentPreset()
@@ -747,14 +942,14 @@ int64_t Storage::ImportPresetsFromBank(int64_t bankInstanceId, const std::vector
     std::set<std::string> existingNames;
 
     for (auto&preset: this->currentBank.presets()) {
-        existingNames.insert(preset->preset().name());
+        existingNames.insert(preset->name());
     }
     BankFile bankFile;
     LoadBankFile(indexEntry.name(),&bankFile);
     int64_t lastPresetId = -1;
     for (auto &presetEntry: bankFile.presets()) {
         if (presetsSet.contains(presetEntry->instanceId())) {
-            std::string uniqueName = makeUniqueName(presetEntry->preset().name(),existingNames);
+            std::string uniqueName = makeUniqueName(presetEntry->name(),existingNames);
             existingNames.insert(uniqueName);
             Pedalboard t = presetEntry->preset();
             t.name(uniqueName);
@@ -779,11 +974,11 @@ int64_t Storage::CopyPresetsToBank(int64_t bankInstanceId, const std::vector<int
     std::set<std::string> existingNames;
 
     for (auto&preset: bankFile.presets()) {
-        existingNames.insert(preset->preset().name());
+        existingNames.insert(preset->name());
     }
     for (auto &presetEntry: this->currentBank.presets()) {
         if (presetsSet.contains(presetEntry->instanceId())) {
-            std::string uniqueName = makeUniqueName(presetEntry->preset().name(),existingNames);
+            std::string uniqueName = makeUniqueName(presetEntry->name(),existingNames);
             existingNames.insert(uniqueName);
             Pedalboard t = presetEntry->preset();
             t.name(uniqueName);
@@ -803,7 +998,7 @@ std::vector<PresetIndexEntry> Storage::RequestBankPresets(int64_t bankInstanceId
     LoadBankFile(indexEntry.name(),&bankFile);
     for (auto &preset: bankFile.presets()) {
         result.push_back(
-            PresetIndexEntry(preset->instanceId(),preset->preset().name())
+            PresetIndexEntry(preset->instanceId(),preset->name())
         );
     }
     return result;
@@ -854,7 +1049,7 @@ void Storage::GetPresetIndex(PresetIndex *pResult)
     {
         PresetIndexEntry entry;
         entry.instanceId(item->instanceId());
-        entry.name(item->preset().name());
+        entry.name(item->name());
         pResult->presets().push_back(entry);
     }
 }
@@ -988,7 +1183,7 @@ int64_t Storage::CopyPreset(int64_t fromId, int64_t toId)
     if (toId == -1)
     {
         Pedalboard newPedalboard = fromItem.preset();
-        std::string name = GetPresetCopyName(fromItem.preset().name());
+        std::string name = GetPresetCopyName(fromItem.name());
         newPedalboard.name(name);
         result = this->currentBank.addPreset(newPedalboard, fromId);
     }
@@ -1154,8 +1349,66 @@ void Storage::SaveChannelSelection()
     }
 }
 
+void Storage::LoadPedalboardSlots()
+{
+    auto fileName = this->GetPedalboardSlotsFileName();
+    if (std::filesystem::exists(fileName))
+    {
+        try
+        {
+            std::ifstream s(fileName);
+            json_reader reader(s);
+            PedalboardSlots slots;
+            reader.read(&slots);
+            slots.Validate();
+            this->pedalboardSlots = std::move(slots);
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error("Error reading %s: %s", fileName.c_str(), e.what());
+        }
+    }
+}
+void Storage::SavePedalboardSlots()
+{
+    auto fileName = this->GetPedalboardSlotsFileName();
+    try
+    {
+        pipedal::ofstream_synced s(fileName);
+        json_writer writer(s, false);
+        writer.write(this->pedalboardSlots);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error("I/O error writing %s: %s", fileName.c_str(), e.what());
+        throw PiPedalStateException("Unexpected error writing pedalboard slots file.");
+    }
+}
+void Storage::SetPedalboardSlots(const PedalboardSlots &pedalboardSlots)
+{
+    pedalboardSlots.Validate();
+    this->pedalboardSlots = pedalboardSlots;
+    SavePedalboardSlots();
+}
+
+Pedalboard Storage::GetPresetFromBank(int64_t bankId, int64_t presetId)
+{
+    if (bankId == bankIndex.selectedBank())
+    {
+        return GetPreset(presetId);
+    }
+    BankFile bankFile;
+    GetBankFile(bankId, &bankFile);
+    if (!bankFile.hasItem(presetId))
+    {
+        throw PiPedalException("Preset not found.");
+    }
+    return bankFile.getItem(presetId).preset();
+}
+
 void Storage::RenameBank(int64_t bankId, const std::string &newName)
 {
+    FlushPendingWrites();
     auto existingBank = this->bankIndex.getEntryByName(newName);
     if (existingBank != nullptr)
     {
@@ -1174,12 +1427,18 @@ void Storage::RenameBank(int64_t bankId, const std::string &newName)
         s << "Unable to rename the bank. (" << e.what() << ")";
         throw PiPedalException(s.str());
     }
+    {
+        // the index stays valid, since the bank file's inode doesn't change.
+        std::error_code ec;
+        std::filesystem::rename(GetBankFileIndexName(entry.name()), GetBankFileIndexName(newName), ec);
+    }
     entry.name(newName);
     SaveBankIndex();
 }
 
 int64_t Storage::SaveBankAs(int64_t bankId, const std::string &newName)
 {
+    FlushPendingWrites();
     auto existingBank = this->bankIndex.getEntryByName(newName);
     if (existingBank != nullptr)
     {
@@ -1222,6 +1481,8 @@ int64_t Storage::GetBankByMidiBankNumber(uint8_t bankNumber)
 }
 int64_t Storage::DeleteBank(int64_t bankId)
 {
+    // the current bank must be written before the selection moves.
+    FlushPendingWrites();
     auto &entries = this->bankIndex.entries();
 
     for (size_t i = 0; i < entries.size(); ++i)
@@ -1231,6 +1492,7 @@ int64_t Storage::DeleteBank(int64_t bankId)
         if (entry.instanceId() == bankId)
         {
             std::filesystem::path fileName = this->GetBankFileName(entry.name());
+            std::filesystem::path indexFileName = this->GetBankFileIndexName(entry.name());
             entries.erase(entries.begin() + i);
 
             int64_t newSelection;
@@ -1264,6 +1526,8 @@ int64_t Storage::DeleteBank(int64_t bankId)
             }
             this->SaveBankIndex();
             std::filesystem::remove(fileName);
+            std::error_code ec;
+            std::filesystem::remove(indexFileName, ec);
             return newSelection;
         }
     }
@@ -1327,20 +1591,161 @@ int64_t Storage::UploadBank(BankFile &bankFile, int64_t uploadAfter)
         s << baseName << "(" << n++ << ")";
         bankFile.name(s.str());
     }
-    std::filesystem::path path = this->GetBankFileName(bankFile.name());
-    pipedal::ofstream_synced f(path);
-    if (!f.is_open())
-    {
-        throw PiPedalException("Can't write to bank file.");
-    }
-    json_writer writer(f, true);
-    writer.write(bankFile);
+    SaveBankFile(bankFile.name(), bankFile);
 
     lastBank = this->bankIndex.addBank(lastBank, bankFile.name());
     this->SaveBankIndex();
     return lastBank;
 }
 
+BankSyncManifest Storage::GetBankSyncManifest()
+{
+    namespace fs = std::filesystem;
+    BankSyncManifest manifest;
+    const fs::path &uploadDirectory = GetPluginUploadDirectory();
+    std::set<std::string> mediaPaths;
+    for (const auto &entry : bankIndex.entries())
+    {
+        BankFile bankFile;
+        LoadBankFile(entry.name(), &bankFile);
+        BankSyncBank bank;
+        bank.name_ = entry.name();
+        for (const auto &preset : bankFile.presets())
+        {
+            const Pedalboard &pedalboard = preset->preset();
+            bank.presets_.push_back(BankSyncPreset{preset->name(), BankSync::GetPresetHash(pedalboard)});
+            PresetBundleWriter::GetMediaPaths(pedalboard, uploadDirectory, &mediaPaths);
+        }
+        manifest.banks_.push_back(std::move(bank));
+    }
+
+    MediaBlobIndex &mediaBlobIndex = GetMediaBlobIndex();
+    for (const auto &mediaPath : mediaPaths)
+    {
+        for (const std::string &path : {mediaPath, SS(mediaPath << ".mdata")})
+        {
+            fs::path filePath = (uploadDirectory / path).lexically_normal();
+            std::string relativePath = filePath.lexically_relative(uploadDirectory).string();
+            std::error_code ec;
+            if (relativePath.empty() || relativePath.starts_with("..") || !fs::is_regular_file(filePath, ec))
+            {
+                continue;
+            }
+            try
+            {
+                BankSyncMedia media;
+                media.path_ = relativePath;
+                media.hash_ = mediaBlobIndex.GetHash(filePath);
+                media.size_ = fs::file_size(filePath);
+                manifest.media_.push_back(std::move(media));
+            }
+            catch (const std::exception &e)
+            {
+                Lv2Log::warning(SS("Can't hash media file " << filePath << ". " << e.what()));
+            }
+        }
+    }
+    return manifest;
+}
+
+Pedalboard Storage::GetBankSyncPreset(const std::string &bankName, const std::string &presetName)
+{
+    if (!bankIndex.hasName(bankName))
+    {
+        throw PiPedalArgumentException("Bank not found.");
+    }
+    BankFile bankFile;
+    LoadBankFile(bankName, &bankFile);
+    for (const auto &preset : bankFile.presets())
+    {
+        if (preset->name() == presetName)
+        {
+            return preset->preset();
+        }
+    }
+    throw PiPedalArgumentException("Preset not found.");
+}
+
+bool Storage::SyncBank(const std::string &bankName, const std::vector<std::string> &presetNames, const std::map<std::string, Pedalboard> &changedPresets)
+{
+    if (presetNames.empty())
+    {
+        throw PiPedalException("Invalid bank.");
+    }
+    bool isNewBank = !bankIndex.hasName(bankName);
+    bool isCurrentBank = !isNewBank && bankIndex.getBankIndexEntry(bankIndex.selectedBank()).name() == bankName;
+
+    BankFile loadedBank;
+    BankFile *bankFile = isCurrentBank ? &currentBank : &loadedBank;
+    if (!isNewBank && !isCurrentBank)
+    {
+        LoadBankFile(bankName, &loadedBank);
+    }
+    bankFile->name(bankName);
+
+    // Keep the instanceIds of existing presets, so that clients' selections and indexes stay valid.
+    int64_t nextInstanceId = bankFile->nextInstanceId();
+    int64_t selectedPreset = bankFile->selectedPreset();
+    bool currentPresetChanged = false;
+    std::map<std::string, std::unique_ptr<BankFileEntry>> existingPresets;
+    for (auto &entry : bankFile->presets())
+    {
+        nextInstanceId = std::max(nextInstanceId, entry->instanceId());
+        std::string name = entry->name();
+        existingPresets[name] = std::move(entry);
+    }
+    std::vector<std::unique_ptr<BankFileEntry>> presets;
+    for (const auto &name : presetNames)
+    {
+        std::unique_ptr<BankFileEntry> entry;
+        auto existingPreset = existingPresets.find(name);
+        if (existingPreset != existingPresets.end())
+        {
+            entry = std::move(existingPreset->second);
+            existingPresets.erase(existingPreset);
+        }
+        auto changedPreset = changedPresets.find(name);
+        if (changedPreset != changedPresets.end())
+        {
+            if (!entry)
+            {
+                entry = std::make_unique<BankFileEntry>();
+                entry->instanceId(++nextInstanceId);
+            }
+            else if (entry->instanceId() == selectedPreset)
+            {
+                currentPresetChanged = true;
+            }
+            entry->preset(changedPreset->second);
+        }
+        else if (!entry)
+        {
+            throw PiPedalException(SS("Preset " << name << " is missing."));
+        }
+        presets.push_back(std::move(entry));
+    }
+    bankFile->presets() = std::move(presets);
+    bankFile->nextInstanceId(nextInstanceId);
+    if (!bankFile->hasItem(selectedPreset))
+    {
+        bankFile->selectedPreset(bankFile->presets()[0]->instanceId());
+        currentPresetChanged = true;
+    }
+
+    if (isCurrentBank)
+    {
+        SaveCurrentBank();
+        return currentPresetChanged;
+    }
+    SaveBankFile(bankName, *bankFile);
+    if (isNewBank)
+    {
+        bankIndex.addBank(-1, bankName);
+        SaveBankIndex();
+    }
+    return false;
+}
+
 void Storage::SetGovernorSettings(const std::string &governor)
 {
     userSettings.governor_ = governor;
@@ -1470,10 +1875,8 @@ void Storage::SaveCurrentPreset(const CurrentPreset &currentPreset)
     try
     {
         std::filesystem::path path = GetCurrentPresetPath();
-
-        pipedal::ofstream_synced f(path);
-        json_writer writer(f, true);
-        writer.write(currentPreset);
+        Lv2StateBlobStore::OutOfLineScope outOfLine;
+        WriteFileAtomically(path, ToJsonString(currentPreset));
     }
     catch (std::exception &)
     {
@@ -1587,9 +1990,11 @@ void Storage::MergePluginPresets(const std::string &pluginUri, const PluginPrese
         {
             throw PiPedalException(SS("Can't write to " << path));
         }
+        Lv2StateBlobStore::OutOfLineScope outOfLine;
         json_writer writer(os, true);
         writer.write(existingPresets);
     }
+    pluginPresetsCache.erase(pluginUri);
     if (std::filesystem::exists(path))
     {
         std::filesystem::remove(path);
@@ -1630,9 +2035,11 @@ void Storage::SavePluginPresets(const std::string &pluginUri, const PluginPreset
         {
             throw PiPedalException(SS("Can't write to " << path));
         }
+        Lv2StateBlobStore::OutOfLineScope outOfLine;
         json_writer writer(os, true);
         writer.write(presets);
     }
+    pluginPresetsCache.erase(pluginUri);
     if (std::filesystem::exists(path))
     {
         std::filesystem::remove(path);
@@ -1650,12 +2057,17 @@ void Storage::SavePluginPresets(const std::string &pluginUri, const PluginPreset
     }
 }
 
-PluginPresets Storage::GetPluginPresets(const std::string &pluginUri) const
+std::shared_ptr<const PluginPresets> Storage::GetCachedPluginPresets(const std::string &pluginUri) const
 {
-    PluginPresets result;
+    auto f = pluginPresetsCache.find(pluginUri);
+    if (f != pluginPresetsCache.end())
+    {
+        return f->second;
+    }
+    auto result = std::make_shared<PluginPresets>();
     if (!HasPluginPresets(pluginUri))
     {
-        result.pluginUri_ = pluginUri;
+        result->pluginUri_ = pluginUri;
         return result;
     }
     std::filesystem::path path = GetPluginPresetPath(pluginUri);
@@ -1666,12 +2078,19 @@ PluginPresets Storage::GetPluginPresets(const std::string &pluginUri) const
         return result;
     }
     json_reader reader(s);
-    reader.read(&result);
+    reader.read(result.get());
+    pluginPresetsCache[pluginUri] = result;
     return result;
 }
+
+PluginPresets Storage::GetPluginPresets(const std::string &pluginUri) const
+{
+    return *GetCachedPluginPresets(pluginUri);
+}
 PluginUiPresets Storage::GetPluginUiPresets(const std::string &pluginUri) const
 {
-    PluginPresets presets = GetPluginPresets(pluginUri);
+    auto cachedPresets = GetCachedPluginPresets(pluginUri);
+    const PluginPresets &presets = *cachedPresets;
     PluginUiPresets result;
     result.pluginUri_ = presets.pluginUri_;
     for (size_t i = 0; i < presets.presets_.size(); ++i)
@@ -1687,7 +2106,8 @@ PluginUiPresets Storage::GetPluginUiPresets(const std::string &pluginUri) const
 
 PluginPresetValues Storage::GetPluginPresetValues(const std::string &pluginUri, uint64_t instanceId)
 {
-    auto presets = GetPluginPresets(pluginUri);
+    auto cachedPresets = GetCachedPluginPresets(pluginUri);
+    const PluginPresets &presets = *cachedPresets;
     for (const auto &preset : presets.presets_)
     {
         if (preset.instanceId_ == instanceId)
@@ -1955,6 +2375,45 @@ void Storage::SetSystemMidiBindings(const std::vector<MidiBinding> &bindings)
         writer.write(bindings);
     }
 }
+std::vector<LatencyMeasurement> Storage::GetLatencyMeasurements()
+{
+    std::vector<LatencyMeasurement> result;
+    std::filesystem::path fileName = this->dataRoot / "config" / "LatencyMeasurements.json";
+    std::ifstream f;
+    f.open(fileName);
+    if (f.is_open())
+    {
+        try
+        {
+            json_reader reader(f);
+            reader.read(&result);
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::warning(SS("Failed to read " << fileName << ". " << e.what()));
+            result.clear();
+        }
+    }
+    return result;
+}
+
+void Storage::AddLatencyMeasurement(const LatencyMeasurement &measurement)
+{
+    std::vector<LatencyMeasurement> measurements = GetLatencyMeasurements();
+    std::erase_if(measurements, [&measurement](const LatencyMeasurement &m)
+                  { return m.SameConfiguration(measurement); });
+    measurements.push_back(measurement);
+
+    std::filesystem::path fileName = this->dataRoot / "config" / "LatencyMeasurements.json";
+    pipedal::ofstream_synced f;
+    f.open(fileName);
+    if (f.is_open())
+    {
+        json_writer writer(f, true);
+        writer.write(measurements);
+    }
+}
+
 static bool hasBinding(std::vector<MidiBinding> &bindings, const std::string &name)
 {
     for (auto &binding : bindings)
@@ -2086,6 +2545,7 @@ static bool isInfoFile(const FileEntry &l)
 }
 
 static void AddFilesToResult(
+    UploadDirectoryIndex &directoryIndex,
     FileRequestResult &result,
     const ModFileTypes::ModDirectory *modDirectoryInfo, // yyx
     const UiFileProperty &fileProperty,
@@ -2101,18 +2561,20 @@ static void AddFilesToResult(
     std::set<std::string> validExtensions = fileProperty.GetPermittedFileExtensions(
         modDirectoryInfo ? modDirectoryInfo->modType : "");
 
+    // (collation sort key, file)
+    std::vector<std::pair<std::string, FileEntry>> files;
     try
     {
-        for (auto const &dir_entry : std::filesystem::directory_iterator(rootPath))
+        for (auto const &dir_entry : directoryIndex.GetEntries(rootPath))
         {
-            if (!IsValidUtf8(dir_entry.path().string()))
+            const fs::path path = rootPath / dir_entry.name;
+            if (!IsValidUtf8(dir_entry.name))
             {
-                Lv2Log::warning("Invalid UTF-8 name in directory: " + dir_entry.path().string());
+                Lv2Log::warning("Invalid UTF-8 name in directory: " + path.string());
                 continue; // skip invalid UTF-8 names.
             }
-            const auto &path = dir_entry.path();
-            auto name = path.filename().string();
-            if (dir_entry.is_regular_file())
+            const auto &name = dir_entry.name;
+            if (dir_entry.isRegularFile)
             {
                 std::string extension = UiFileProperty::GetFileExtension(path);
 
@@ -2123,14 +2585,13 @@ static void AddFilesToResult(
 
                     if (match && !name.starts_with("."))
                     {
-                        resultFiles.push_back(
-                            FileEntry(path, name, false, false));
+                        files.emplace_back(dir_entry.sortKey, FileEntry(path, name, false, false));
                     }
                 }
             }
-            else if (dir_entry.is_directory())
+            else if (dir_entry.isDirectory)
             {
-                resultFiles.push_back(FileEntry{path, name, true, fs::is_symlink(path)});
+                files.emplace_back(dir_entry.sortKey, FileEntry{path, name, true, dir_entry.isSymlink});
             }
         }
     }
@@ -2140,12 +2601,12 @@ static void AddFilesToResult(
             SS("GetFileList failed. " << rootPath.string() << " - " << error.what()));
     }
 
-    // sort lexicographically
-
-    auto collator = Locale::GetInstance()->GetCollator();
+    // sort lexicographically, using the index's precomputed collation keys.
 
-    std::sort(resultFiles.begin(), resultFiles.end(), [&collator](const FileEntry &l, const FileEntry &r)
+    std::sort(files.begin(), files.end(), [](const std::pair<std::string, FileEntry> &left, const std::pair<std::string, FileEntry> &right)
               {
+        const FileEntry &l = left.second;
+        const FileEntry &r = right.second;
         if (l.isDirectory_ != r.isDirectory_)
         {
             return l.isDirectory_ > r.isDirectory_;
@@ -2156,15 +2617,21 @@ static void AddFilesToResult(
         {
             return lIsInfoFile > rIsInfoFile;
         }
-        return collator->Compare(l.displayName_,r.displayName_) < 0; });
+        return left.first < right.first; });
+    for (auto &file : files)
+    {
+        resultFiles.push_back(std::move(file.second));
+    }
 }
 
 static void AddTracksToResult(
+    UploadDirectoryIndex &directoryIndex,
     const fs::path &audioRootDirectory,
     FileRequestResult &result,
     const ModFileTypes::ModDirectory *modDirectoryInfo, // yyx
     const UiFileProperty &fileProperty,
-    const fs::path &rootPath)
+    const fs::path &rootPath,
+    AudioFileSortKey sortKey)
 {
 
     if (!fs::exists(rootPath))
@@ -2186,22 +2653,23 @@ static void AddTracksToResult(
     try
     {
         // Add directories first.
+        std::vector<UploadDirectoryIndex::Entry> directories;
         try
         {
-            for (auto const &dir_entry : std::filesystem::directory_iterator(rootPath))
+            for (auto const &dir_entry : directoryIndex.GetEntries(rootPath))
             {
-                if (!IsValidUtf8(dir_entry.path().string()))
+                const fs::path path = rootPath / dir_entry.name;
+                if (!IsValidUtf8(dir_entry.name))
                 {
-                    Lv2Log::warning("Invalid UTF-8 name in directory: " + dir_entry.path().string());
+                    Lv2Log::warning("Invalid UTF-8 name in directory: " + path.string());
                     continue; // skip invalid UTF-8 names.
                 }
-                const auto &path = dir_entry.path();
-                auto name = path.filename().string();
+                const auto &name = dir_entry.name;
                 try
                 {
-                    if (dir_entry.is_directory())
+                    if (dir_entry.isDirectory)
                     {
-                        resultFiles.push_back(FileEntry{path, name, true, dir_entry.is_symlink()});
+                        directories.push_back(dir_entry);
                     }
                 }
                 catch (const std::exception &e)
@@ -2215,32 +2683,27 @@ static void AddTracksToResult(
             throw std::logic_error(
                 SS("AddTracksToResult failed to enumerate directories. " << rootPath.string() << " - " << error.what()));
         }
-        auto collator = Locale::GetInstance()->GetCollator();
+        // directories only at this point, so the index's collation keys are the whole ordering.
         std::sort(
-            resultFiles.begin(),
-            resultFiles.end(),
-            [collator](const FileEntry &l, const FileEntry &r)
+            directories.begin(),
+            directories.end(),
+            [](const UploadDirectoryIndex::Entry &l, const UploadDirectoryIndex::Entry &r)
             {
-                if (l.isDirectory_ != r.isDirectory_)
-                {
-                    return l.isDirectory_ > r.isDirectory_;
-                }
-                bool lIsInfoFile = isInfoFile(l);
-                bool rIsInfoFile = isInfoFile(r);
-                if (lIsInfoFile != rIsInfoFile)
-                {
-                    return lIsInfoFile < rIsInfoFile;
-                }
-
-                return collator->Compare(l.displayName_, r.displayName_) < 0;
+                return l.sortKey < r.sortKey;
             });
+        for (const auto &directory : directories)
+        {
+            resultFiles.push_back(FileEntry{rootPath / directory.name, directory.name, true, directory.isSymlink});
+        }
         // Add audio files.
         auto audioFiles = AudioDirectoryInfo::Create(rootPath,
                                                      GetShadowIndexDirectory(audioRootDirectory, rootPath));
 
         try
         {
-            for (const auto &audioFile : audioFiles->GetFiles())
+            std::vector<AudioFileMetadata> files = audioFiles->GetFiles();
+            AudioDirectoryInfo::SortFiles(files, sortKey);
+            for (const auto &audioFile : files)
             {
                 fs::path audioFilePath = rootPath / audioFile.fileName();
                 std::string extension = UiFileProperty::GetFileExtension(audioFilePath);
@@ -2267,7 +2730,7 @@ static void AddTracksToResult(
     }
 }
 
-FileRequestResult Storage::GetModFileList2(const std::string &relativePath, const UiFileProperty &fileProperty)
+FileRequestResult Storage::GetModFileList2(const std::string &relativePath, const UiFileProperty &fileProperty, const std::string &sortKey)
 {
     FileRequestResult result;
     const fs::path &uploadsDirectory = GetPluginUploadDirectory();
@@ -2352,11 +2815,11 @@ FileRequestResult Storage::GetModFileList2(const std::string &relativePath, cons
 
     if (IsInAudioTracksDirectory(relativePath))
     {
-        AddTracksToResult(this->GetPluginUploadDirectory(), result, rootModDirectory, fileProperty, relativePath);
+        AddTracksToResult(GetUploadDirectoryIndex(), this->GetPluginUploadDirectory(), result, rootModDirectory, fileProperty, relativePath, ParseAudioFileSortKey(sortKey));
     }
     else
     {
-        AddFilesToResult(result, rootModDirectory, fileProperty, relativePath);
+        AddFilesToResult(GetUploadDirectoryIndex(), result, rootModDirectory, fileProperty, relativePath);
     }
     result.currentDirectory_ = relativePath;
     return result;
@@ -2376,7 +2839,7 @@ static bool IsChildDirectory(const fs::path &child, const fs::path &parent)
     return true;
 }
 
-FileRequestResult Storage::GetFileList2(const std::string &relativePath_, const UiFileProperty &fileProperty)
+FileRequestResult Storage::GetFileList2(const std::string &relativePath_, const UiFileProperty &fileProperty, const std::string &sortKey)
 {
     std::string absolutePath = relativePath_;
     if (!ensureNoDotDot(absolutePath))
@@ -2385,7 +2848,7 @@ FileRequestResult Storage::GetFileList2(const std::string &relativePath_, const
     }
     if (hasSyntheticModRoot(fileProperty))
     {
-        return Storage::GetModFileList2(absolutePath, fileProperty);
+        return Storage::GetModFileList2(absolutePath, fileProperty, sortKey);
     }
 
     FileRequestResult result;
@@ -2452,11 +2915,11 @@ FileRequestResult Storage::GetFileList2(const std::string &relativePath_, const
 
     if (IsInAudioTracksDirectory(absolutePath))
     {
-        AddTracksToResult(GetPluginUploadDirectory(), result, pModDirectory, fileProperty, absolutePath);
+        AddTracksToResult(GetUploadDirectoryIndex(), GetPluginUploadDirectory(), result, pModDirectory, fileProperty, absolutePath, ParseAudioFileSortKey(sortKey));
     }
     else
     {
-        AddFilesToResult(result, pModDirectory, fileProperty, absolutePath);
+        AddFilesToResult(GetUploadDirectoryIndex(), result, pModDirectory, fileProperty, absolutePath);
     }
     return result;
 }
@@ -2566,10 +3029,9 @@ bool Storage::IsValidArtworkFile(const std::filesystem::path &fullPath)
     }
     return false;
 }
-std::string Storage::UploadUserFile(const std::string &directory,
-                                    UiFileProperty::ptr uiFileProperty,
-                                    const std::string &filename,
-                                    std::istream &stream, size_t contentLength)
+std::filesystem::path Storage::GetUserFileUploadPath(const std::string &directory,
+                                                     const UiFileProperty &uiFileProperty,
+                                                     const std::string &filename)
 {
     std::filesystem::path path;
     if (directory.length() != 0)
@@ -2590,25 +3052,36 @@ std::string Storage::UploadUserFile(const std::string &directory,
         throw std::logic_error("Permission denied. Path is outside the upload storage directory.");
     }
 
-    if (!(uiFileProperty->IsValidExtension(relativePath) || IsValidArtworkFile(path)))
+    if (!(uiFileProperty.IsValidExtension(relativePath) || IsValidArtworkFile(path)))
     {
         throw std::logic_error("Permission denied. Invalid file extension for this directory.");
     }
+    return path;
+}
+
+std::string Storage::UploadUserFile(const std::string &directory,
+                                    UiFileProperty::ptr uiFileProperty,
+                                    const std::string &filename,
+                                    std::istream &stream, size_t contentLength)
+{
+    std::filesystem::path path = GetUserFileUploadPath(directory, *uiFileProperty, filename);
 
+    // Write to a temporary file in the destination directory, and rename it into place
+    // once complete, so that a failed upload never leaves a truncated file (or destroys
+    // an existing one).
+    std::filesystem::path tempPath = path.string() + ".$$$";
+    try
     {
-        try
+        std::filesystem::create_directories(path.parent_path());
         {
-            std::filesystem::create_directories(path.parent_path());
-
-            pipedal::ofstream_synced f(path, std::ios_base::trunc | std::ios_base::binary);
+            pipedal::ofstream_synced f(tempPath, std::ios_base::trunc | std::ios_base::binary);
             if (!f.is_open())
             {
                 throw std::logic_error(SS("Can't create file " << path << "."));
             }
-            std::vector<uint8_t> buffer;
-            size_t BUFFER_SIZE = 64 * 1024;
-            buffer.resize(BUFFER_SIZE);
-            char *pBuffer = (char *)&(buffer[0]);
+            constexpr size_t BUFFER_SIZE = 64 * 1024;
+            std::vector<char> buffer(BUFFER_SIZE);
+            char *pBuffer = buffer.data();
             while (contentLength != 0)
             {
                 size_t thisTime = std::min(BUFFER_SIZE, contentLength);
@@ -2625,16 +3098,84 @@ std::string Storage::UploadUserFile(const std::string &directory,
                 contentLength -= thisTime;
             }
         }
-        catch (const std::exception &e)
-        {
-            Lv2Log::error(SS("Upload failed. " << e.what()));
-            std::filesystem::remove(path);
-            throw;
-        }
+        std::filesystem::rename(tempPath, path);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("Upload failed. " << e.what()));
+        std::error_code ec;
+        std::filesystem::remove(tempPath, ec);
+        throw;
     }
+    DeduplicateUpload(path);
     return path.string();
 }
 
+std::string Storage::UploadUserFile(const std::string &directory,
+                                    UiFileProperty::ptr uiFileProperty,
+                                    const std::string &filename,
+                                    const std::filesystem::path &sourceFile, size_t contentLength)
+{
+    std::filesystem::path path = GetUserFileUploadPath(directory, *uiFileProperty, filename);
+
+    std::filesystem::create_directories(path.parent_path());
+
+    // The upload has already been spooled to disk. If it's on the same filesystem,
+    // move it into place instead of copying it a second time.
+    std::error_code ec;
+    std::filesystem::rename(sourceFile, path, ec);
+    if (!ec)
+    {
+        DeduplicateUpload(path);
+        return path.string();
+    }
+    std::ifstream f(sourceFile, std::ios_base::in | std::ios_base::binary);
+    if (!f.is_open())
+    {
+        throw std::runtime_error(SS("Can't open file " << sourceFile << "."));
+    }
+    return UploadUserFile(directory, uiFileProperty, filename, f, contentLength);
+}
+
+UploadDirectoryIndex &Storage::GetUploadDirectoryIndex() const
+{
+    std::lock_guard<std::mutex> lock(uploadDirectoryIndexMutex);
+    if (!uploadDirectoryIndex)
+    {
+        Collator::ptr collator = Locale::GetInstance()->GetCollator();
+        uploadDirectoryIndex = std::make_unique<UploadDirectoryIndex>(
+            GetPluginUploadDirectory(),
+            [collator](const std::string &name)
+            {
+                return collator->GetSortKey(name);
+            });
+    }
+    return *uploadDirectoryIndex;
+}
+
+MediaBlobIndex &Storage::GetMediaBlobIndex()
+{
+    std::lock_guard<std::mutex> lock(mediaBlobIndexMutex);
+    if (!mediaBlobIndex)
+    {
+        mediaBlobIndex = std::make_unique<MediaBlobIndex>(GetPluginUploadDirectory());
+    }
+    return *mediaBlobIndex;
+}
+
+void Storage::DeduplicateUpload(const std::filesystem::path &path)
+{
+    // Not fatal; the upload succeeded, it just takes more space than it needs to.
+    try
+    {
+        GetMediaBlobIndex().Deduplicate(path);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't deduplicate " << path << ". " << e.what()));
+    }
+}
+
 std::string Storage::CreateNewSampleDirectory(const std::string &relativePath, const UiFileProperty &uiFileProperty)
 {
     if (uiFileProperty.directory().empty())
@@ -2802,59 +3343,59 @@ std::string Storage::CopyFilePropertyFile(
 
 void Storage::FillSampleDirectoryTree(FilePropertyDirectoryTree *node, const std::filesystem::path &directory) const
 {
-    for (auto child : std::filesystem::directory_iterator(directory))
+    std::vector<UploadDirectoryIndex::Entry> children = GetUploadDirectoryIndex().GetEntries(directory);
+    std::sort(children.begin(), children.end(),
+              [](const UploadDirectoryIndex::Entry &left, const UploadDirectoryIndex::Entry &right)
+              {
+                  return left.sortKey < right.sortKey;
+              });
+    for (const auto &child : children)
     {
-        if (!IsValidUtf8(child.path().string()))
+        const fs::path childPath = directory / child.name;
+        if (!IsValidUtf8(child.name))
         {
-            Lv2Log::warning("Invalid UTF-8 name in directory: " + child.path().string());
+            Lv2Log::warning("Invalid UTF-8 name in directory: " + childPath.string());
             // skip invalid UTF-8 paths.
             continue;
         }
-        if (child.is_directory())
+        if (child.isDirectory)
         {
-            const auto &childPath = child.path();
             FilePropertyDirectoryTree::ptr childTree = std::make_unique<FilePropertyDirectoryTree>(childPath);
             FillSampleDirectoryTree(childTree.get(), childPath);
             node->children_.push_back(std::move(childTree));
         }
     }
-    auto collator = Locale::GetInstance()->GetCollator();
-    std::sort(node->children_.begin(), node->children_.end(),
-              [&collator](const FilePropertyDirectoryTree::ptr &left, const FilePropertyDirectoryTree::ptr &right)
-              {
-                  return collator->Compare(left->directoryName_, right->directoryName_) < 0;
-              });
 }
 
-static void GetAllExtensions(std::set<std::string> &result, const std::filesystem::path &path)
+static void GetAllExtensions(UploadDirectoryIndex &directoryIndex, std::set<std::string> &result, const std::filesystem::path &path)
 {
     assert(fs::is_directory(path));
 
-    for (const auto &dirEnt : fs::directory_iterator(path))
+    for (const auto &dirEnt : directoryIndex.GetEntries(path))
     {
-        if (!IsValidUtf8(dirEnt.path().string()))
+        fs::path childPath = path / dirEnt.name;
+        if (!IsValidUtf8(dirEnt.name))
         {
             // skip invalid UTF-8 paths.
-            Lv2Log::warning("Invalid UTF-8 name in directory: " + dirEnt.path().string());
+            Lv2Log::warning("Invalid UTF-8 name in directory: " + childPath.string());
             continue;
         }
-        if (dirEnt.is_directory())
+        if (dirEnt.isDirectory)
         {
-            GetAllExtensions(result, dirEnt.path());
+            GetAllExtensions(directoryIndex, result, childPath);
         }
         else
         {
-            std::string filename = dirEnt.path().filename();
-            if (dirEnt.path().has_extension())
+            if (childPath.has_extension())
             {
-                std::string extension = dirEnt.path().extension();
+                std::string extension = childPath.extension();
                 result.insert(extension);
             }
         }
     }
 }
 
-static std::set<std::string> GetAllExtensions(const std::filesystem::path &path)
+static std::set<std::string> GetAllExtensions(UploadDirectoryIndex &directoryIndex, const std::filesystem::path &path)
 {
     std::set<std::string> result;
     if (fs::is_regular_file(path))
@@ -2863,7 +3404,7 @@ static std::set<std::string> GetAllExtensions(const std::filesystem::path &path)
     }
     else
     {
-        GetAllExtensions(result, path);
+        GetAllExtensions(directoryIndex, result, path);
     }
     return result;
 }
@@ -2882,7 +3423,7 @@ FilePropertyDirectoryTree::ptr Storage::GetFilePropertydirectoryTree(const UiFil
         throw std::runtime_error(SS("Permission denied: " << selectedPath));
     }
 
-    std::set<std::string> fileExtensions = GetAllExtensions(selectedPath);
+    std::set<std::string> fileExtensions = GetAllExtensions(GetUploadDirectoryIndex(), selectedPath);
 
     if (hasSyntheticModRoot(uiFileProperty))
     {
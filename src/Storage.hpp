@@ -30,8 +30,17 @@
 #include "WifiDirectConfigSettings.hpp"
 #include "FileEntry.hpp"
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <functional>
 #include "FilePropertyDirectoryTree.hpp"
 #include "AlsaSequencer.hpp"
+#include "MediaBlobIndex.hpp"
+#include "BankSync.hpp"
+#include "UploadDirectoryIndex.hpp"
+#include "LatencyProbe.hpp"
+#include "PedalboardSlots.hpp"
+#include <mutex>
 
 
 namespace pipedal {
@@ -80,6 +89,7 @@ private:
 private:
     void FillSampleDirectoryTree(FilePropertyDirectoryTree*node, const std::filesystem::path&directory) const;
     void UpgradeFactoryPresets();
+    void UpgradeFactoryPresets_(const std::filesystem::path &presetsDirectory, const std::filesystem::path &presetsConfigDirectory);
     void MaybeCopyDefaultPresets();
     static std::string SafeEncodeName(const std::string& name);
     static std::string SafeDecodeName(const std::string& name);
@@ -87,7 +97,9 @@ private:
     std::filesystem::path GetPluginPresetsDirectory() const;
     std::filesystem::path GetIndexFileName() const;
     std::filesystem::path GetBankFileName(const std::string & name) const;
+    std::filesystem::path GetBankFileIndexName(const std::string & name) const;
     std::filesystem::path GetChannelSelectionFileName();
+    std::filesystem::path GetPedalboardSlotsFileName();
     std::filesystem::path GetAlsaSequencerConfigurationFileName();
     std::filesystem::path GetCurrentPresetPath() const;
     std::filesystem::path GetTone3000AuthPath() const;
@@ -101,15 +113,22 @@ private:
     void LoadChannelSelection();
     void SaveChannelSelection();
 
+    void LoadPedalboardSlots();
+    void SavePedalboardSlots();
+
     void LoadAlsaSequencerConfiguration();
     void SaveAlsaSequencerConfiguration();
 
 
-    void SaveBankFile(const std::string& name,const BankFile&bankFile);
+    void SaveBankFile(const std::string& name,BankFile&bankFile);
+    void WriteBankFile(const std::string& name,BankFile&bankFile);
+    void WriteBankFileIndex(const std::filesystem::path &path,const BankFileIndex&index);
+    void WriteBankIndex();
     void LoadBankFile(const std::string &name,BankFile *pBank);
     std::string GetPresetCopyName(const std::string &name);
     bool isJackChannelSelectionValid = false;
     JackChannelSelection jackChannelSelection;
+    PedalboardSlots pedalboardSlots;
 
     AlsaSequencerConfiguration alsaSequencerConfiguration;;
 
@@ -117,8 +136,34 @@ private:
     WifiDirectConfigSettings wifiDirectConfigSettings;
 
     UserSettings userSettings;
+
+    std::function<void()> onWritePending;
+    bool binaryBankFiles = false;
+    bool currentBankDirty = false;
+    bool bankIndexDirty = false;
+
+    std::mutex mediaBlobIndexMutex;
+    MediaBlobIndex::ptr mediaBlobIndex;
+    mutable std::mutex uploadDirectoryIndexMutex;
+    mutable UploadDirectoryIndex::ptr uploadDirectoryIndex;
+    UploadDirectoryIndex &GetUploadDirectoryIndex() const;
+    void DeduplicateUpload(const std::filesystem::path &path);
 public:
     Storage();
+    ~Storage();
+
+    /**
+     * @brief Defer writes of the current bank and the bank index, so that bursts of edits are coalesced.
+     *
+     * onWritePending is called (from within the Storage call that deferred the write) when there is
+     * no write already pending; the caller must arrange to call FlushPendingWrites() later.
+     * Pass nullptr to write synchronously again (after flushing pending writes).
+     */
+    void SetWriteBehind(std::function<void()> &&onWritePending);
+    void FlushPendingWrites();
+    bool HasPendingWrites() const { return currentBankDirty || bankIndexDirty; }
+    // Write bank files in binary format (see BinaryBank.hpp) instead of json.
+    void SetBinaryBankFiles(bool value) { binaryBankFiles = value; }
     void Initialize();
     void CreateBank(const std::string & name);
 
@@ -157,10 +202,19 @@ public:
     void SetPresetIndex(const PresetIndex &presetIndex);
     Pedalboard GetPreset(int64_t instanceId) const;
     int64_t GetPresetByProgramNumber(uint8_t program) const;
-    void GetBankFile(int64_t instanceId,BankFile*pResult) const;
+    void GetBankFile(int64_t instanceId,BankFile*pResult);
+    // The bank's file and its sidecar index file.
+    std::vector<std::filesystem::path> GetBankFilePaths(int64_t instanceId) const;
     int64_t UploadPreset(const BankFile&bankFile, int64_t uploadAfter);
     int64_t UploadBank(BankFile&bankFile, int64_t uploadAfter);
 
+    // Bank sync (see BankSync.hpp).
+    BankSyncManifest GetBankSyncManifest();
+    Pedalboard GetBankSyncPreset(const std::string &bankName, const std::string &presetName);
+    // Make the named bank hold presetNames, in order. Presets are taken from changedPresets, or else from the
+    // existing bank by name. The bank is created if it doesn't exist. Returns true if the current preset changed.
+    bool SyncBank(const std::string &bankName, const std::vector<std::string> &presetNames, const std::map<std::string, Pedalboard> &changedPresets);
+
     
     bool LoadPreset(int64_t presetId);
     int64_t DeletePresets(const std::vector<int64_t>& presetInstanceIds);
@@ -179,14 +233,20 @@ public:
     bool IsInAudioTracksDirectory(const std::filesystem::path&path) const;
     bool IsValidArtworkFile(const std::filesystem::path& fullPath);
     
-    FileRequestResult GetFileList2(const std::string&relativePath,const UiFileProperty&fileProperty);
+    // sortKey orders audio track listings (see ParseAudioFileSortKey()). Other listings ignore it.
+    FileRequestResult GetFileList2(const std::string&relativePath,const UiFileProperty&fileProperty, const std::string &sortKey = "");
 
-    FileRequestResult GetModFileList2(const std::string &relativePath,const UiFileProperty &fileProperty);
+    FileRequestResult GetModFileList2(const std::string &relativePath,const UiFileProperty &fileProperty, const std::string &sortKey = "");
 
 
     void SetJackChannelSelection(const JackChannelSelection&channelSelection);
     JackChannelSelection GetJackChannelSelection(const JackConfiguration &jackConfiguration);
 
+    void SetPedalboardSlots(const PedalboardSlots &pedalboardSlots);
+    const PedalboardSlots &GetPedalboardSlots() const { return pedalboardSlots; }
+    // A preset from any bank (not just the current bank). Throws if it doesn't exist.
+    Pedalboard GetPresetFromBank(int64_t bankId, int64_t presetId);
+
     // returns true if services needs to be updated.
     bool SetWifiConfigSettings(const WifiConfigSettings & wifiConfigSettings);
     WifiConfigSettings GetWifiConfigSettings();
@@ -213,10 +273,15 @@ private:
     void LoadPluginPresetIndex();
     void SavePluginPresetIndex();
 
+    // Plugin presets, parsed on first request, and discarded when the plugin's preset file is written.
+    mutable std::unordered_map<std::string, std::shared_ptr<const PluginPresets>> pluginPresetsCache;
+    std::shared_ptr<const PluginPresets> GetCachedPluginPresets(const std::string &pluginUri) const;
+
 
     std::filesystem::path GetPluginPresetPath(const std::string &pluginUri) const;
     bool IsValidSampleFileName(const std::filesystem::path&fileName);
     std::filesystem::path MakeUserFilePath(const std::string &directory, const std::string&filename);
+    std::filesystem::path GetUserFileUploadPath(const std::string &directory, const UiFileProperty &uiFileProperty, const std::string &filename);
     void ToAbstractPaths(PluginPreset&pluginPreset);
     void FromAbstractPaths(PluginPreset&pluginPreset);
 
@@ -251,9 +316,17 @@ public:
     bool GetShowStatusMonitor() const;
     void SetSystemMidiBindings(const std::vector<MidiBinding>&bindings);
     std::vector<MidiBinding> GetSystemMidiBindings();
+    std::vector<LatencyMeasurement> GetLatencyMeasurements();
+    // Replaces any measurement of the same configuration.
+    void AddLatencyMeasurement(const LatencyMeasurement &measurement);
     void DeleteSampleFile(const std::filesystem::path &fileName);
     std::string UploadUserFile(const std::string &directory, 
         std::shared_ptr<UiFileProperty> uiFileProperty ,const std::string&filename,std::istream&stream, size_t contentLength);
+    // Moves an already-spooled upload into place (copying only if it's on another filesystem).
+    std::string UploadUserFile(const std::string &directory, 
+        std::shared_ptr<UiFileProperty> uiFileProperty ,const std::string&filename,const std::filesystem::path&sourceFile, size_t contentLength);
+    // Content hashes of uploaded media files. Uploads with the same content as an existing file are hard-linked to it.
+    MediaBlobIndex &GetMediaBlobIndex();
     std::string CreateNewSampleDirectory(const std::string&relativePath, const UiFileProperty&uiFileProperty);
     std::string RenameFilePropertyFile(
         const std::string&oldRelativePath,
@@ -0,0 +1,145 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "SwitchLatencyMonitor.hpp"
+#include "EffectTiming.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+JSON_MAP_BEGIN(SwitchLatencyStatistics)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, stage)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, switches)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, meanMs)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, p50Ms)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, p99Ms)
+    JSON_MAP_REFERENCE(SwitchLatencyStatistics, maxMs)
+JSON_MAP_END()
+
+SwitchLatencyMonitor &SwitchLatencyMonitor::GetInstance()
+{
+    static SwitchLatencyMonitor instance;
+    return instance;
+}
+
+void SwitchLatencyMonitor::OnMidiDispatched(uint64_t receivedNs)
+{
+    uint64_t now = EffectTimingClockNs();
+    if (receivedNs == 0 || receivedNs > now)
+    {
+        receivedNs = now;
+    }
+    this->receivedNs.store(receivedNs, std::memory_order_relaxed);
+    this->dispatchedNs.store(now, std::memory_order_relaxed);
+    this->instantiateNs.store(0, std::memory_order_relaxed);
+    state.store(State::Dispatched, std::memory_order_release);
+}
+
+void SwitchLatencyMonitor::OnNotified()
+{
+    if (state.load(std::memory_order_acquire) != State::Dispatched)
+    {
+        return;
+    }
+    notifiedNs.store(EffectTimingClockNs(), std::memory_order_relaxed);
+    State expected = State::Dispatched;
+    state.compare_exchange_strong(expected, State::Notified, std::memory_order_release);
+}
+
+void SwitchLatencyMonitor::AddInstantiateTime(uint64_t ns)
+{
+    if (state.load(std::memory_order_acquire) == State::Notified)
+    {
+        instantiateNs.fetch_add(ns, std::memory_order_relaxed);
+    }
+}
+
+void SwitchLatencyMonitor::OnSubmitted()
+{
+    if (state.load(std::memory_order_acquire) != State::Notified)
+    {
+        return;
+    }
+    submittedNs.store(EffectTimingClockNs(), std::memory_order_relaxed);
+    State expected = State::Notified;
+    state.compare_exchange_strong(expected, State::Submitted, std::memory_order_release);
+}
+
+void SwitchLatencyMonitor::OnAcknowledged()
+{
+    // a submitted change is still on its way to the audio thread.
+    State expected = State::Notified;
+    state.compare_exchange_strong(expected, State::Idle, std::memory_order_relaxed);
+}
+
+void SwitchLatencyMonitor::OnApplied()
+{
+    if (state.load(std::memory_order_acquire) != State::Submitted)
+    {
+        return;
+    }
+    uint64_t appliedNs = EffectTimingClockNs();
+    uint64_t received = receivedNs.load(std::memory_order_relaxed);
+    uint64_t dispatched = dispatchedNs.load(std::memory_order_relaxed);
+    uint64_t notified = notifiedNs.load(std::memory_order_relaxed);
+    uint64_t submitted = submittedNs.load(std::memory_order_relaxed);
+    uint64_t instantiate = instantiateNs.load(std::memory_order_relaxed);
+
+    uint64_t model = submitted - notified;
+    instantiate = std::min(instantiate, model);
+
+    histograms[Midi].Record(dispatched - received);
+    histograms[Notify].Record(notified - dispatched);
+    histograms[Model].Record(model - instantiate);
+    histograms[Instantiate].Record(instantiate);
+    histograms[Audio].Record(appliedNs - submitted);
+    histograms[Total].Record(appliedNs - received);
+
+    state.store(State::Idle, std::memory_order_relaxed);
+}
+
+std::vector<SwitchLatencyStatistics> SwitchLatencyMonitor::GetStatistics() const
+{
+    static const char *stageNames[StageCount] = {"midi", "notify", "model", "instantiate", "audio", "total"};
+
+    std::vector<SwitchLatencyStatistics> result;
+    for (size_t i = 0; i < StageCount; ++i)
+    {
+        CpuStageStatistics statistics;
+        histograms[i].GetStatistics(&statistics);
+
+        SwitchLatencyStatistics stage;
+        stage.stage_ = stageNames[i];
+        stage.switches_ = statistics.periods_;
+        stage.meanMs_ = statistics.meanUs_ * 0.001f;
+        stage.p50Ms_ = statistics.p50Us_ * 0.001f;
+        stage.p99Ms_ = statistics.p99Us_ * 0.001f;
+        stage.maxMs_ = statistics.maxUs_ * 0.001f;
+        result.push_back(std::move(stage));
+    }
+    return result;
+}
+
+void SwitchLatencyMonitor::Reset()
+{
+    for (auto &histogram : histograms)
+    {
+        histogram.RequestReset();
+    }
+}
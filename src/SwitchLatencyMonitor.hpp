@@ -0,0 +1,108 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "json.hpp"
+#include "CpuUse.hpp"
+
+namespace pipedal
+{
+    // Time taken by one stage of a MIDI-triggered preset or snapshot change.
+    class SwitchLatencyStatistics
+    {
+    public:
+        std::string stage_; // "midi", "notify", "model", "instantiate", "audio", or "total".
+        uint64_t switches_ = 0;
+        float meanMs_ = 0;
+        float p50Ms_ = 0;
+        float p99Ms_ = 0;
+        float maxMs_ = 0;
+
+        DECLARE_JSON_MAP(SwitchLatencyStatistics);
+    };
+
+    /**
+     * @brief Times the path from a footswitch MIDI message to the first audio period that runs with the new
+     * preset or snapshot.
+     *
+     * Stages:
+     *   midi:        arrival at the ALSA sequencer -> dispatched by the audio thread.
+     *   notify:      audio thread -> service thread.
+     *   model:       preset/snapshot load in PiPedalModel, excluding plugin instantiation.
+     *   instantiate: creating the new Lv2Pedalboard.
+     *   audio:       handed to the audio thread -> first period processed with it.
+     *
+     * Only one change is in flight at a time (the audio thread defers MIDI until the model acknowledges a change),
+     * so each stage just records a timestamp. Changes that don't reach the audio thread (e.g. no preset for the
+     * program number) are abandoned when the model acknowledges the request. Histograms are written by the audio
+     * thread only.
+     */
+    class SwitchLatencyMonitor
+    {
+    public:
+        static SwitchLatencyMonitor &GetInstance();
+
+        // Audio thread. receivedNs is the EffectTimingClockNs() time the MIDI message arrived (0 if unknown).
+        void OnMidiDispatched(uint64_t receivedNs);
+        // Service thread.
+        void OnNotified();
+        void AddInstantiateTime(uint64_t ns);
+        // Call before sending the new pedalboard or snapshot to the audio thread.
+        void OnSubmitted();
+        // Service thread, when the model has finished handling the request.
+        void OnAcknowledged();
+        // Audio thread, when the new pedalboard or snapshot is applied.
+        void OnApplied();
+
+        std::vector<SwitchLatencyStatistics> GetStatistics() const;
+        void Reset();
+
+    private:
+        enum class State : uint32_t
+        {
+            Idle,
+            Dispatched,
+            Notified,
+            Submitted
+        };
+        enum Stage
+        {
+            Midi,
+            Notify,
+            Model,
+            Instantiate,
+            Audio,
+            Total,
+            StageCount
+        };
+        std::atomic<State> state{State::Idle};
+        std::atomic<uint64_t> receivedNs{0};
+        std::atomic<uint64_t> dispatchedNs{0};
+        std::atomic<uint64_t> notifiedNs{0};
+        std::atomic<uint64_t> instantiateNs{0};
+        std::atomic<uint64_t> submittedNs{0};
+
+        CpuUseHistogram histograms[StageCount];
+    };
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SwitchLatencyMonitor.hpp"
+#include "EffectTiming.hpp"
+#include <thread>
+
+using namespace pipedal;
+
+static const SwitchLatencyStatistics &GetStage(const std::vector<SwitchLatencyStatistics> &stages, const std::string &name)
+{
+    for (const auto &stage : stages)
+    {
+        if (stage.stage_ == name)
+        {
+            return stage;
+        }
+    }
+    throw std::runtime_error("Stage not found.");
+}
+
+TEST_CASE("SwitchLatencyMonitor", "[switch_latency_monitor][Build][Dev]")
+{
+    SwitchLatencyMonitor monitor;
+
+    // a complete switch.
+    uint64_t receivedNs = EffectTimingClockNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    monitor.OnMidiDispatched(receivedNs);
+    monitor.OnNotified();
+    monitor.AddInstantiateTime(1000000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    monitor.OnSubmitted();
+    monitor.OnApplied();
+
+    auto stages = monitor.GetStatistics();
+    REQUIRE(stages.size() == 6);
+    REQUIRE(GetStage(stages, "total").switches_ == 1);
+    REQUIRE(GetStage(stages, "midi").maxMs_ >= 1.5f);
+    REQUIRE(GetStage(stages, "instantiate").maxMs_ >= 0.9f);
+    REQUIRE(GetStage(stages, "model").maxMs_ >= 1.5f);
+    REQUIRE(GetStage(stages, "total").maxMs_ >= 5.0f);
+
+    // a switch that never reaches the audio thread is abandoned.
+    monitor.OnMidiDispatched(0);
+    monitor.OnNotified();
+    monitor.OnAcknowledged();
+    monitor.OnApplied();
+    REQUIRE(GetStage(monitor.GetStatistics(), "total").switches_ == 1);
+
+    // pedalboard changes that weren't triggered by MIDI aren't recorded.
+    monitor.OnSubmitted();
+    monitor.OnApplied();
+    REQUIRE(GetStage(monitor.GetStatistics(), "total").switches_ == 1);
+
+    monitor.OnMidiDispatched(0);
+    monitor.OnNotified();
+    monitor.OnSubmitted();
+    monitor.OnAcknowledged();
+    monitor.OnApplied();
+    REQUIRE(GetStage(monitor.GetStatistics(), "total").switches_ == 2);
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "SysfsSampler.hpp"
+#include "CpuTemperatureMonitor.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static int OpenReadOnly(const fs::path &path)
+{
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+// sysfs attributes are regenerated on each read from offset 0, so the file can stay open.
+static bool ReadNumber(int fd, int base, uint64_t *value)
+{
+    if (fd == -1)
+    {
+        return false;
+    }
+    char buffer[32];
+    ssize_t n = pread(fd, buffer, sizeof(buffer) - 1, 0);
+    if (n <= 0)
+    {
+        return false;
+    }
+    buffer[n] = 0;
+    char *end = nullptr;
+    *value = strtoull(buffer, &end, base);
+    return end != buffer;
+}
+
+static uint64_t Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+std::shared_ptr<SysfsSampler> SysfsSampler::GetShared()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<SysfsSampler> instance;
+
+    std::lock_guard lock{mutex};
+    auto result = instance.lock();
+    if (!result)
+    {
+        result = std::make_shared<SysfsSampler>();
+        result->Start();
+        instance = result;
+    }
+    return result;
+}
+
+SysfsSampler::SysfsSampler(const fs::path &sysfsRoot)
+{
+    for (size_t cpu = 0; cpu < MAX_CPUS; ++cpu)
+    {
+        fs::path cpuPath = sysfsRoot / "devices/system/cpu" / SS("cpu" << cpu);
+        std::error_code ec;
+        if (!fs::exists(cpuPath, ec))
+        {
+            break;
+        }
+        cpuFreqFds.push_back(OpenReadOnly(cpuPath / "cpufreq/scaling_cur_freq"));
+    }
+    for (const auto &zone : CpuTemperatureMonitor::FindCpuThermalZones(sysfsRoot / "class/thermal"))
+    {
+        int fd = OpenReadOnly(zone / "temp");
+        if (fd != -1)
+        {
+            temperatureFds.push_back(fd);
+        }
+    }
+    // The firmware device's name varies between Raspberry Pi models (e.g. soc:firmware, soc@107c000000:firmware).
+    std::error_code ec;
+    for (const auto &bus : fs::directory_iterator(sysfsRoot / "devices/platform", ec))
+    {
+        std::error_code ec2;
+        for (const auto &device : fs::directory_iterator(bus.path(), ec2))
+        {
+            if (device.path().filename().string().ends_with(":firmware"))
+            {
+                throttledFd = OpenReadOnly(device.path() / "get_throttled");
+                if (throttledFd != -1)
+                {
+                    break;
+                }
+            }
+        }
+        if (throttledFd != -1)
+        {
+            break;
+        }
+    }
+    current.cpuCount = (uint32_t)cpuFreqFds.size();
+}
+
+SysfsSampler::~SysfsSampler()
+{
+    Stop();
+    for (int fd : cpuFreqFds)
+    {
+        if (fd != -1)
+        {
+            close(fd);
+        }
+    }
+    for (int fd : temperatureFds)
+    {
+        close(fd);
+    }
+    if (throttledFd != -1)
+    {
+        close(throttledFd);
+    }
+}
+
+void SysfsSampler::Start()
+{
+    Stop();
+    Sample();
+    terminate = false;
+    thread = std::make_unique<std::jthread>([this]()
+                                            { ThreadProc(); });
+}
+
+void SysfsSampler::Stop()
+{
+    if (thread)
+    {
+        terminate = true;
+        thread->join();
+        thread = nullptr;
+    }
+}
+
+void SysfsSampler::Sample(bool sampleTemperature)
+{
+    uint32_t freqMin = UINT32_MAX;
+    uint32_t freqMax = 0;
+    for (size_t cpu = 0; cpu < cpuFreqFds.size(); ++cpu)
+    {
+        uint64_t value;
+        uint32_t freq = ReadNumber(cpuFreqFds[cpu], 10, &value) ? (uint32_t)value : 0;
+        current.cpuFreqKhz[cpu] = freq;
+        cpuFreqKhz[cpu].store(freq, std::memory_order_relaxed);
+        if (freq != 0)
+        {
+            freqMin = std::min(freqMin, freq);
+            freqMax = std::max(freqMax, freq);
+        }
+    }
+    current.cpuFreqMinKhz = freqMax == 0 ? 0 : freqMin;
+    current.cpuFreqMaxKhz = freqMax;
+
+    if (sampleTemperature)
+    {
+        float temperature = INVALID_TEMPERATURE;
+        for (int fd : temperatureFds)
+        {
+            uint64_t value;
+            if (ReadNumber(fd, 10, &value))
+            {
+                temperature = std::max(temperature, value / 1000.0f); // millidegrees.
+            }
+        }
+        current.temperatureC = temperature;
+        temperatureC.store(temperature, std::memory_order_relaxed);
+
+        uint64_t value;
+        current.throttled = ReadNumber(throttledFd, 16, &value) ? (int32_t)value : -1;
+        throttled.store(current.throttled, std::memory_order_relaxed);
+    }
+    current.sampleTimeNs = Now();
+    snapshot.Write(current);
+}
+
+void SysfsSampler::ThreadProc()
+{
+    SetThreadName("sysfsSampler");
+    int tick = 0;
+    while (!terminate)
+    {
+        if (idle.load(std::memory_order_relaxed))
+        {
+            std::this_thread::sleep_for(FREQUENCY_PERIOD * TEMPERATURE_TICKS);
+            Sample(true);
+            continue;
+        }
+        std::this_thread::sleep_for(FREQUENCY_PERIOD);
+        Sample(++tick % TEMPERATURE_TICKS == 0);
+    }
+}
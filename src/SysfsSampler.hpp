@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "Seqlock.hpp"
+#include "CpuTemperatureMonitor.hpp"
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Samples CPU frequencies, CPU temperature and Raspberry Pi firmware throttling flags from sysfs.
+     *
+     * One thread reads the sysfs files at a fixed low rate, through file descriptors that stay open, and
+     * publishes the results without locks. The status monitor, the CPU frequency policy and the audio
+     * period trace all read from the process-wide instance instead of opening sysfs files themselves.
+     */
+    class SysfsSampler
+    {
+    public:
+        static constexpr size_t MAX_CPUS = 64;
+        static constexpr std::chrono::milliseconds FREQUENCY_PERIOD{100};
+        static constexpr int TEMPERATURE_TICKS = 10; // temperature and throttling, in FREQUENCY_PERIODs.
+
+        static constexpr float INVALID_TEMPERATURE = CpuTemperatureMonitor::INVALID_TEMPERATURE;
+
+        // Throttling flags, as reported by the Raspberry Pi firmware (vcgencmd get_throttled).
+        static constexpr int32_t THROTTLED_UNDER_VOLTAGE = 0x1;
+        static constexpr int32_t THROTTLED_FREQUENCY_CAPPED = 0x2;
+        static constexpr int32_t THROTTLED_THROTTLED = 0x4;
+        static constexpr int32_t THROTTLED_SOFT_TEMPERATURE_LIMIT = 0x8;
+        // The same flags, shifted: the condition has occurred since boot.
+        static constexpr int THROTTLED_OCCURRED_SHIFT = 16;
+
+        struct Snapshot
+        {
+            uint64_t sampleTimeNs = 0; // CLOCK_MONOTONIC. 0 before the first sample.
+            uint32_t cpuCount = 0;
+            uint32_t cpuFreqMinKhz = 0; // 0 if not available.
+            uint32_t cpuFreqMaxKhz = 0;
+            float temperatureC = INVALID_TEMPERATURE;
+            int32_t throttled = -1; // THROTTLED_* flags. -1 if not available.
+            uint32_t cpuFreqKhz[MAX_CPUS] = {};
+        };
+
+        // The process-wide sampler. Its thread runs while anyone holds a reference.
+        static std::shared_ptr<SysfsSampler> GetShared();
+
+        // sysfsRoot: normally /sys.
+        explicit SysfsSampler(const std::filesystem::path &sysfsRoot = "/sys");
+        ~SysfsSampler();
+        SysfsSampler(const SysfsSampler &) = delete;
+        SysfsSampler &operator=(const SysfsSampler &) = delete;
+
+        void Start();
+        void Stop();
+
+        // While idle, frequencies aren't sampled, and temperature and throttling are sampled every
+        // TEMPERATURE_TICKS * FREQUENCY_PERIOD.
+        void SetIdle(bool idle) { this->idle.store(idle, std::memory_order_relaxed); }
+
+        // Reads the files now. Called by the sampler thread.
+        void Sample(bool sampleTemperature = true);
+
+        // Lock-free.
+        Snapshot GetSnapshot() const { return snapshot.Read(); }
+
+        // Realtime-safe.
+        uint32_t GetCpuFrequencyKhz(int cpu) const
+        {
+            return (cpu >= 0 && (size_t)cpu < MAX_CPUS) ? cpuFreqKhz[cpu].load(std::memory_order_relaxed) : 0;
+        }
+        float GetTemperatureC() const { return temperatureC.load(std::memory_order_relaxed); }
+        int32_t GetThrottled() const { return throttled.load(std::memory_order_relaxed); }
+
+    private:
+        void ThreadProc();
+
+        std::vector<int> cpuFreqFds; // -1 for cpus without cpufreq.
+        std::vector<int> temperatureFds;
+        int throttledFd = -1;
+
+        Snapshot current; // sampler thread only.
+        Seqlock<Snapshot> snapshot;
+        std::atomic<uint32_t> cpuFreqKhz[MAX_CPUS] = {};
+        std::atomic<float> temperatureC{INVALID_TEMPERATURE};
+        std::atomic<int32_t> throttled{-1};
+
+        std::atomic<bool> terminate{false};
+        std::atomic<bool> idle{false};
+        std::unique_ptr<std::jthread> thread;
+    };
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "SysfsSampler.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static void WriteFile(const fs::path &path, const std::string &text)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream f(path);
+    f << text;
+}
+
+TEST_CASE("SysfsSampler", "[sysfs_sampler][Build][Dev]")
+{
+    fs::path root = fs::temp_directory_path() / "pipedalSysfsSamplerTest";
+    fs::remove_all(root);
+    WriteFile(root / "devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "1500000\n");
+    WriteFile(root / "devices/system/cpu/cpu1/cpufreq/scaling_cur_freq", "600000\n");
+    fs::create_directories(root / "devices/system/cpu/cpu2"); // no cpufreq.
+    WriteFile(root / "class/thermal/thermal_zone0/type", "cpu-thermal\n");
+    WriteFile(root / "class/thermal/thermal_zone0/temp", "51234\n");
+    WriteFile(root / "class/thermal/thermal_zone1/type", "gpu-thermal\n");
+    WriteFile(root / "class/thermal/thermal_zone1/temp", "90000\n");
+    WriteFile(root / "devices/platform/soc/soc:firmware/get_throttled", "50005\n");
+
+    {
+        SysfsSampler sampler(root);
+        sampler.Sample();
+        SysfsSampler::Snapshot snapshot = sampler.GetSnapshot();
+        REQUIRE(snapshot.sampleTimeNs != 0);
+        REQUIRE(snapshot.cpuCount == 3);
+        REQUIRE(snapshot.cpuFreqKhz[0] == 1500000);
+        REQUIRE(snapshot.cpuFreqKhz[1] == 600000);
+        REQUIRE(snapshot.cpuFreqKhz[2] == 0);
+        REQUIRE(snapshot.cpuFreqMinKhz == 600000);
+        REQUIRE(snapshot.cpuFreqMaxKhz == 1500000);
+        REQUIRE(std::abs(snapshot.temperatureC - 51.234f) < 0.001f);
+        REQUIRE(snapshot.throttled == 0x50005);
+        REQUIRE((snapshot.throttled & SysfsSampler::THROTTLED_UNDER_VOLTAGE) != 0);
+        REQUIRE((snapshot.throttled & (SysfsSampler::THROTTLED_THROTTLED << SysfsSampler::THROTTLED_OCCURRED_SHIFT)) != 0);
+        REQUIRE(sampler.GetCpuFrequencyKhz(1) == 600000);
+        REQUIRE(sampler.GetCpuFrequencyKhz(64) == 0);
+
+        // the files stay open, and are re-read.
+        WriteFile(root / "devices/system/cpu/cpu1/cpufreq/scaling_cur_freq", "1800000\n");
+        WriteFile(root / "class/thermal/thermal_zone0/temp", "60000\n");
+        sampler.Sample(false);
+        snapshot = sampler.GetSnapshot();
+        REQUIRE(snapshot.cpuFreqMaxKhz == 1800000);
+        REQUIRE(std::abs(snapshot.temperatureC - 51.234f) < 0.001f); // not sampled.
+        sampler.Sample(true);
+        REQUIRE(sampler.GetTemperatureC() == 60.0f);
+    }
+    {
+        // not a Raspberry Pi, no thermal zones.
+        fs::remove_all(root / "devices/platform");
+        fs::remove_all(root / "class");
+        SysfsSampler sampler(root);
+        sampler.Start();
+        SysfsSampler::Snapshot snapshot = sampler.GetSnapshot();
+        REQUIRE(snapshot.throttled == -1);
+        REQUIRE(snapshot.temperatureC == SysfsSampler::INVALID_TEMPERATURE);
+        sampler.Stop();
+    }
+    fs::remove_all(root);
+}
@@ -1,4 +1,4 @@
-// Copyright (c) 2022 Robin Davies
+// Copyright (c) 2026 Robin E. R. Davies
 //
 // Permission is hereby granted, free of charge, to any person obtaining a copy of
 // this software and associated documentation files (the "Software"), to deal in
@@ -17,46 +17,25 @@
 // IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
-#pragma once
 
+#include "Task.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
 
+using namespace pipedal;
 
-#include <type_traits>
-// maintains ownership of allocated buffers.
-
-namespace pipedal {
-
-
-class BufferPool {
-    std::vector<void*> allocatedBuffers;
-
-public: 
-    ~BufferPool() {
-        Clear();
+void pipedal::task_detail::LogDetachedTaskError(std::exception_ptr error)
+{
+    try
+    {
+        std::rethrow_exception(error);
     }
-    template <typename TYPE>
-    TYPE *AllocateBuffer(size_t size)
+    catch (const std::exception &e)
     {
-        TYPE *result= new TYPE[size];
-        for (int i = 0; i < size; ++i)
-        {
-            result[i] = 0;
-        }
-        allocatedBuffers.push_back(result);
-        return result;
+        Lv2Log::error(SS("Unhandled exception in task. " << e.what()));
     }
-
-    void Clear() {
-        for (int i = 0; i < allocatedBuffers.size(); ++i)
-        {
-            delete[] (char*)(allocatedBuffers[i]);
-        }
-        allocatedBuffers.resize(0);
+    catch (...)
+    {
+        Lv2Log::error("Unhandled exception in task.");
     }
-
-
-};
-
-
-
-} // namespace.
\ No newline at end of file
+}
@@ -0,0 +1,322 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "IExecutor.hpp"
+#include "Promise.hpp"
+
+namespace pipedal
+{
+    // C++20 coroutines for request handlers.
+    //
+    // A Task<T> is lazy: it starts when it is co_awaited, or when it is passed to Spawn().
+    //
+    //     Task<int> CountFilesAsync(std::string path)
+    //     {
+    //         co_await ResumeOn(ThreadPool::Shared()); // continue on a pool thread.
+    //         co_return CountFiles(path);
+    //     }
+    //
+    // A Task resumes its awaiter on whichever thread it completes on.
+
+    template <typename T>
+    class Task;
+
+    namespace task_detail
+    {
+        class TaskPromiseBase
+        {
+        public:
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+                template <typename PROMISE>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<PROMISE> handle) noexcept
+                {
+                    TaskPromiseBase &promise = handle.promise();
+                    if (promise.continuation)
+                    {
+                        return promise.continuation;
+                    }
+                    if (promise.detached)
+                    {
+                        handle.destroy();
+                    }
+                    return std::noop_coroutine();
+                }
+                void await_resume() noexcept {}
+            };
+            FinalAwaiter final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() noexcept
+            {
+                error = std::current_exception();
+            }
+
+            std::coroutine_handle<> continuation;
+            bool detached = false;
+            std::exception_ptr error;
+        };
+
+        template <typename T>
+        class TaskPromise : public TaskPromiseBase
+        {
+        public:
+            Task<T> get_return_object() noexcept;
+            void return_value(T value) { result = std::move(value); }
+            T GetResult()
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+                return std::move(*result);
+            }
+
+        private:
+            std::optional<T> result;
+        };
+
+        template <>
+        class TaskPromise<void> : public TaskPromiseBase
+        {
+        public:
+            Task<void> get_return_object() noexcept;
+            void return_void() {}
+            void GetResult()
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+    }
+
+    template <typename T = void>
+    class [[nodiscard]] Task
+    {
+    public:
+        using promise_type = task_detail::TaskPromise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        Task() {}
+        explicit Task(handle_type handle) : handle(handle) {}
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+        Task &operator=(Task &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (handle)
+                    handle.destroy();
+                handle = std::exchange(other.handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+        ~Task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        class Awaiter
+        {
+        public:
+            Awaiter(handle_type handle) : handle(handle) {}
+            bool await_ready() noexcept { return !handle || handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaitingCoroutine) noexcept
+            {
+                handle.promise().continuation = awaitingCoroutine;
+                return handle;
+            }
+            T await_resume()
+            {
+                if (!handle)
+                {
+                    throw std::logic_error("Task has no coroutine.");
+                }
+                return handle.promise().GetResult();
+            }
+
+        private:
+            handle_type handle;
+        };
+
+        Awaiter operator co_await() && noexcept { return Awaiter(handle); }
+
+        // Start the task, and let it free itself when it completes. Unhandled exceptions are logged and discarded.
+        void Detach()
+        {
+            handle_type h = std::exchange(handle, nullptr);
+            if (h)
+            {
+                h.promise().detached = true;
+                h.resume();
+            }
+        }
+
+    private:
+        handle_type handle;
+    };
+
+    namespace task_detail
+    {
+        template <typename T>
+        inline Task<T> TaskPromise<T>::get_return_object() noexcept
+        {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept
+        {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+
+        void LogDetachedTaskError(std::exception_ptr error);
+
+        inline Task<void> DetachedTask(Task<void> task)
+        {
+            try
+            {
+                co_await std::move(task);
+            }
+            catch (...)
+            {
+                LogDetachedTaskError(std::current_exception());
+            }
+        }
+    }
+
+    // Start a task without waiting for it. The task runs on the calling thread until its first suspension.
+    inline void Spawn(Task<void> &&task)
+    {
+        task_detail::DetachedTask(std::move(task)).Detach();
+    }
+
+    // co_await ResumeOn(executor): continue the coroutine on the executor. Continues on the
+    // current thread if the executor doesn't accept the work.
+    class ResumeOn
+    {
+    public:
+        ResumeOn(IExecutor &executor) : executor(executor) {}
+
+        bool await_ready() noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            return executor.Execute([handle]()
+                                    { handle.resume(); });
+        }
+        void await_resume() noexcept {}
+
+    private:
+        IExecutor &executor;
+    };
+
+    // co_await promise: the value of the promise, or throws std::runtime_error if the promise was rejected.
+    template <typename T>
+    class PromiseAwaiter
+    {
+    public:
+        PromiseAwaiter(Promise<T> promise) : promise(std::move(promise)) {}
+
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            // Handlers may fire (and resume the coroutine, destroying *this) before Then() returns.
+            // Don't touch members after attaching them.
+            Promise<T> p = promise;
+            PromiseAwaiter *self = this;
+            p.Then(
+                 [self, handle](const T &value)
+                 {
+                     self->value = value;
+                     handle.resume();
+                 })
+                .Catch(
+                    [self, handle](const std::string &message)
+                    {
+                        self->errorMessage = message;
+                        self->rejected = true;
+                        handle.resume();
+                    });
+        }
+        T await_resume()
+        {
+            if (rejected)
+            {
+                throw std::runtime_error(errorMessage);
+            }
+            return std::move(*value);
+        }
+
+    private:
+        Promise<T> promise;
+        std::optional<T> value;
+        bool rejected = false;
+        std::string errorMessage;
+    };
+
+    template <typename T>
+    PromiseAwaiter<T> operator co_await(Promise<T> promise)
+    {
+        return PromiseAwaiter<T>(std::move(promise));
+    }
+
+    namespace task_detail
+    {
+        template <typename T>
+        Task<void> ResolvePromise(Task<T> task, ResolveFunction<T> resolve, RejectFunction reject)
+        {
+            std::string error;
+            try
+            {
+                resolve(co_await std::move(task));
+                co_return;
+            }
+            catch (const std::exception &e)
+            {
+                error = e.what();
+            }
+            reject(error);
+        }
+    }
+
+    // Start a task, and return a Promise that settles when it completes.
+    template <typename T>
+    Promise<T> ToPromise(Task<T> &&task)
+    {
+        Promise<T> result;
+        result.Work(
+            [&task](ResolveFunction<T> resolve, RejectFunction reject)
+            {
+                Spawn(task_detail::ResolvePromise<T>(std::move(task), resolve, reject));
+            });
+        return result;
+    }
+}
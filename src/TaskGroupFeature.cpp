@@ -0,0 +1,341 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "TaskGroupFeature.hpp"
+#include "SchedulerPriority.hpp"
+#include "Denormals.hpp"
+#include "RealtimeWatchdog.hpp"
+#include "EffectTiming.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include "Futex.hpp"
+#include <mutex>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__aarch64__)
+#define CPU_RELAX() asm volatile("yield" ::: "memory")
+#elif defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+using namespace pipedal;
+
+TaskGroupPool &TaskGroupPool::GetInstance()
+{
+    static std::mutex instanceMutex;
+    static std::unique_ptr<TaskGroupPool> instance;
+
+    std::lock_guard lock{instanceMutex};
+    if (!instance)
+    {
+        instance = std::unique_ptr<TaskGroupPool>(new TaskGroupPool());
+    }
+    return *instance;
+}
+
+std::vector<int> TaskGroupPool::GetPoolCpus()
+{
+    std::vector<int> result;
+    if (CpuAffinityPlan::Enabled())
+    {
+        int audioCpu = CpuAffinityPlan::AudioCpu();
+        for (int cpu : CpuAffinityPlan::RealtimeCpus())
+        {
+            if (cpu != audioCpu && result.size() < MAX_WORKERS)
+            {
+                result.push_back(cpu);
+            }
+        }
+        return result;
+    }
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    // cpu 0 is left for the audio thread and everything else.
+    for (long cpu = nCpus - 1; cpu >= 1 && result.size() < MAX_WORKERS; --cpu)
+    {
+        result.push_back((int)cpu);
+    }
+    return result;
+}
+
+TaskGroupPool::TaskGroupPool()
+{
+    for (int cpu : GetPoolCpus())
+    {
+        workers.push_back(std::make_unique<std::thread>([this, cpu]()
+                                                        { ThreadProc(cpu); }));
+    }
+    Lv2Log::info(SS("Task group pool started with " << workers.size() << " helper thread(s)."));
+}
+
+TaskGroupPool::~TaskGroupPool()
+{
+    closing.store(true);
+    wakeSequence.fetch_add(1);
+    futex_wake(&wakeSequence);
+    for (auto &worker : workers)
+    {
+        worker->join();
+    }
+    workers.clear();
+}
+
+uint32_t TaskGroupPool::ExecuteTasks(bool isHelper)
+{
+    uint32_t executed = 0;
+    uint64_t current = claim.load(std::memory_order_acquire);
+    while (true)
+    {
+        uint32_t index = (uint32_t)current;
+        uint32_t nTasks = (uint32_t)(current >> 32);
+        if (index >= nTasks)
+        {
+            break;
+        }
+        // a successful claim pins the job: it can't complete (and be replaced) until this task completes.
+        if (!claim.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            continue;
+        }
+        LV2_TaskGroup_Task_Function fn = jobFn.load(std::memory_order_relaxed);
+        void *data = jobData.load(std::memory_order_relaxed);
+        if (isHelper)
+        {
+            uint64_t startNs = EffectTimingClockNs();
+            fn(data, index);
+            helperNs.fetch_add(EffectTimingClockNs() - startNs, std::memory_order_relaxed);
+            helperTasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            fn(data, index);
+        }
+        ++executed;
+        completed.fetch_add(1);
+        if (isHelper && callerWaiting.load())
+        {
+            futex_wake(&completed);
+        }
+        current = claim.load(std::memory_order_acquire);
+    }
+    return executed;
+}
+
+void TaskGroupPool::RunTasks(LV2_TaskGroup_Task_Function fn, void *data, uint32_t nTasks, RunResult *result)
+{
+    *result = RunResult();
+    if (nTasks == 0)
+    {
+        return;
+    }
+    if (nTasks == 1 || workers.empty() || busy.exchange(true, std::memory_order_acquire))
+    {
+        for (uint32_t i = 0; i < nTasks; ++i)
+        {
+            fn(data, i);
+        }
+        return;
+    }
+    jobFn.store(fn, std::memory_order_relaxed);
+    jobData.store(data, std::memory_order_relaxed);
+    completed.store(0, std::memory_order_relaxed);
+    helperTasks.store(0, std::memory_order_relaxed);
+    helperNs.store(0, std::memory_order_relaxed);
+    claim.store(((uint64_t)nTasks) << 32, std::memory_order_release);
+
+    wakeSequence.fetch_add(1);
+    if (sleepingWorkers.load() != 0)
+    {
+        futex_wake(&wakeSequence);
+    }
+
+    ExecuteTasks(false);
+
+    // Every task has been claimed, so we're only waiting for tasks that helpers are running.
+    uint64_t waitStartNs = EffectTimingClockNs();
+    bool done = false;
+    for (int i = 0; i < SPIN_COUNT; ++i)
+    {
+        if (completed.load(std::memory_order_acquire) == nTasks)
+        {
+            done = true;
+            break;
+        }
+        CPU_RELAX();
+    }
+    if (!done)
+    {
+        // Don't spin indefinitely: without a cpu plan, a helper may share our cpu.
+        callerWaiting.store(true);
+        while (true)
+        {
+            uint32_t n = completed.load();
+            if (n == nTasks)
+            {
+                break;
+            }
+            futex_wait(&completed, n);
+        }
+        callerWaiting.store(false);
+    }
+    result->waitNs = EffectTimingClockNs() - waitStartNs;
+    result->helperTasks = helperTasks.load(std::memory_order_relaxed);
+    result->helperNs = helperNs.load(std::memory_order_relaxed);
+
+    busy.store(false, std::memory_order_release);
+}
+
+void TaskGroupPool::ThreadProc(int cpu)
+{
+    SetThreadName("rtTaskGroup");
+    if (cpu >= 0)
+    {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(cpu, &cpuSet);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0)
+        {
+            Lv2Log::warning(SS("Failed to pin task group thread to cpu " << cpu));
+        }
+    }
+    SetThreadPriority(SchedulerPriority::RealtimeAudioHelper);
+    RealtimeWatchdog::AttachThread("rtTaskGroup");
+
+    uint32_t lastSequence = 0;
+    while (true)
+    {
+        uint32_t sequence = wakeSequence.load(std::memory_order_acquire);
+        if (sequence == lastSequence)
+        {
+            for (int i = 0; i < SPIN_COUNT; ++i)
+            {
+                sequence = wakeSequence.load(std::memory_order_acquire);
+                if (sequence != lastSequence)
+                {
+                    break;
+                }
+                CPU_RELAX();
+            }
+            if (sequence == lastSequence)
+            {
+                sleepingWorkers.fetch_add(1);
+                futex_wait(&wakeSequence, lastSequence);
+                sleepingWorkers.fetch_sub(1);
+                continue;
+            }
+        }
+        if (closing.load())
+        {
+            return;
+        }
+        lastSequence = sequence;
+        // the same flush-to-zero setting as the audio thread.
+        Denormals::ApplyPolicy();
+        // Late wakeups find the queue empty, and go back to waiting.
+        ExecuteTasks(true);
+    }
+}
+
+JSON_MAP_BEGIN(TaskGroupTiming)
+    JSON_MAP_REFERENCE(TaskGroupTiming, instanceId)
+    JSON_MAP_REFERENCE(TaskGroupTiming, calls)
+    JSON_MAP_REFERENCE(TaskGroupTiming, tasks)
+    JSON_MAP_REFERENCE(TaskGroupTiming, helperTaskPercent)
+    JSON_MAP_REFERENCE(TaskGroupTiming, runUs)
+    JSON_MAP_REFERENCE(TaskGroupTiming, helperUs)
+    JSON_MAP_REFERENCE(TaskGroupTiming, waitUs)
+JSON_MAP_END()
+
+TaskGroupFeature::TaskGroupFeature()
+{
+    featureData.handle = (void *)this;
+    featureData.get_concurrency = &FN_get_concurrency;
+    featureData.run_tasks = &FN_run_tasks;
+
+    feature.URI = LV2_TASKGROUP__taskGroup;
+    feature.data = &featureData;
+}
+
+void TaskGroupFeature::Initialize()
+{
+    this->pool = &TaskGroupPool::GetInstance();
+}
+
+uint32_t TaskGroupFeature::FN_get_concurrency(LV2_TaskGroup_Handle handle)
+{
+    TaskGroupFeature *self = (TaskGroupFeature *)handle;
+    return self->pool ? self->pool->GetConcurrency() : 1;
+}
+
+uint32_t TaskGroupFeature::FN_run_tasks(LV2_TaskGroup_Handle handle, LV2_TaskGroup_Task_Function task, void *data, uint32_t nTasks)
+{
+    return ((TaskGroupFeature *)handle)->RunTasks(task, data, nTasks);
+}
+
+static void smooth(std::atomic<float> &value, float sample)
+{
+    constexpr float SMOOTHING = 1.0f / 32;
+    float v = value.load(std::memory_order_relaxed);
+    value.store(v + (sample - v) * SMOOTHING, std::memory_order_relaxed);
+}
+
+uint32_t TaskGroupFeature::RunTasks(LV2_TaskGroup_Task_Function task, void *data, uint32_t nTasks)
+{
+    TaskGroupPool::RunResult result;
+    uint64_t startNs = EffectTimingClockNs();
+    if (pool)
+    {
+        pool->RunTasks(task, data, nTasks, &result);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < nTasks; ++i)
+        {
+            task(data, i);
+        }
+    }
+    uint64_t runNs = EffectTimingClockNs() - startNs;
+
+    calls.fetch_add(1, std::memory_order_relaxed);
+    tasks.fetch_add(nTasks, std::memory_order_relaxed);
+    helperTasks.fetch_add(result.helperTasks, std::memory_order_relaxed);
+    smooth(runUs, runNs * 0.001f);
+    smooth(helperUs, result.helperNs * 0.001f);
+    smooth(waitUs, result.waitNs * 0.001f);
+    return result.helperTasks;
+}
+
+TaskGroupTiming TaskGroupFeature::GetTiming(int64_t instanceId) const
+{
+    TaskGroupTiming result;
+    result.instanceId_ = instanceId;
+    result.calls_ = calls.load(std::memory_order_relaxed);
+    result.tasks_ = tasks.load(std::memory_order_relaxed);
+    result.helperTaskPercent_ = result.tasks_ == 0 ? 0 : helperTasks.load(std::memory_order_relaxed) * 100.0f / result.tasks_;
+    result.runUs_ = runUs.load(std::memory_order_relaxed);
+    result.helperUs_ = helperUs.load(std::memory_order_relaxed);
+    result.waitUs_ = waitUs.load(std::memory_order_relaxed);
+    return result;
+}
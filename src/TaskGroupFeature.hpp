@@ -0,0 +1,140 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "lv2ext/pipedal.lv2/ext/taskGroup.h"
+#include <lv2/core/lv2.h>
+#include "json.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief The host side of the taskGroup LV2 extension: a process-wide pool of pinned realtime helper threads.
+     *
+     * One task group runs at a time. A caller that finds the pool busy runs all of its tasks serially
+     * on its own thread, so RunTasks() never blocks waiting for another caller. The calling thread takes
+     * tasks from the same queue as the helpers, and only ever waits for tasks that a helper has already
+     * started.
+     */
+    class TaskGroupPool
+    {
+    public:
+        struct RunResult
+        {
+            uint32_t helperTasks = 0; // tasks that ran on helper threads.
+            uint64_t helperNs = 0;    // total execution time of those tasks.
+            uint64_t waitNs = 0;      // time the caller spent waiting for helper tasks to complete.
+        };
+
+        // Host thread. Starts the helper threads on first use.
+        static TaskGroupPool &GetInstance();
+
+        ~TaskGroupPool();
+        TaskGroupPool(const TaskGroupPool &) = delete;
+        TaskGroupPool &operator=(const TaskGroupPool &) = delete;
+
+        // Helper threads plus the calling thread.
+        uint32_t GetConcurrency() const { return (uint32_t)(workers.size() + 1); }
+
+        // Realtime-safe.
+        void RunTasks(LV2_TaskGroup_Task_Function fn, void *data, uint32_t nTasks, RunResult *result);
+
+    private:
+        TaskGroupPool();
+
+        // Pool cpus: the realtime cpus other than the audio cpu if there is a CpuAffinityPlan; otherwise
+        // every cpu but cpu 0.
+        static std::vector<int> GetPoolCpus();
+        static constexpr size_t MAX_WORKERS = 3;
+        static constexpr int SPIN_COUNT = 2000;
+
+        void ThreadProc(int cpu);
+        // Returns the number of tasks executed.
+        uint32_t ExecuteTasks(bool isHelper);
+
+        // Task queue: (nTasks << 32) | next task index.
+        alignas(64) std::atomic<uint64_t> claim{0};
+        alignas(64) std::atomic<uint32_t> completed{0};
+        std::atomic<LV2_TaskGroup_Task_Function> jobFn{nullptr};
+        std::atomic<void *> jobData{nullptr};
+        std::atomic<uint32_t> helperTasks{0};
+        std::atomic<uint64_t> helperNs{0};
+
+        alignas(64) std::atomic<bool> busy{false};
+        std::atomic<uint32_t> wakeSequence{0};
+        std::atomic<uint32_t> sleepingWorkers{0};
+        std::atomic<bool> callerWaiting{false};
+        std::atomic<bool> closing{false};
+
+        std::vector<std::unique_ptr<std::thread>> workers;
+    };
+
+    // Smoothed task group statistics for a plugin that uses the taskGroup extension.
+    class TaskGroupTiming
+    {
+    public:
+        int64_t instanceId_ = -1;
+        uint64_t calls_ = 0;
+        uint64_t tasks_ = 0;
+        float helperTaskPercent_ = 0; // percentage of tasks that ran on helper threads.
+        float runUs_ = 0;             // duration of run_tasks(), per call.
+        float helperUs_ = 0;          // helper thread time, per call.
+        float waitUs_ = 0;            // time spent waiting for helper threads to finish, per call.
+
+        DECLARE_JSON_MAP(TaskGroupTiming);
+    };
+
+    class TaskGroupFeature
+    {
+    public:
+        TaskGroupFeature();
+        // Host thread.
+        void Initialize();
+        bool IsInitialized() const { return pool != nullptr; }
+        const LV2_Feature *GetFeature() { return &feature; }
+
+        // Host thread.
+        TaskGroupTiming GetTiming(int64_t instanceId) const;
+
+    private:
+        static uint32_t FN_get_concurrency(LV2_TaskGroup_Handle handle);
+        static uint32_t FN_run_tasks(LV2_TaskGroup_Handle handle, LV2_TaskGroup_Task_Function task, void *data, uint32_t nTasks);
+
+        uint32_t RunTasks(LV2_TaskGroup_Task_Function task, void *data, uint32_t nTasks);
+
+        TaskGroupPool *pool = nullptr;
+        LV2_Feature feature;
+        LV2_TaskGroup featureData;
+
+        // written by the realtime thread that runs the plugin; read by the host.
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> helperTasks{0};
+        std::atomic<float> runUs{0};
+        std::atomic<float> helperUs{0};
+        std::atomic<float> waitUs{0};
+    };
+}
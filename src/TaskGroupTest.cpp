@@ -0,0 +1,117 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "TaskGroupFeature.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    struct TaskCounts
+    {
+        static constexpr uint32_t N_TASKS = 64;
+        std::atomic<uint32_t> runs[N_TASKS];
+
+        TaskCounts()
+        {
+            for (auto &run : runs)
+            {
+                run.store(0);
+            }
+        }
+        static void Task(void *data, uint32_t taskIndex)
+        {
+            TaskCounts *self = (TaskCounts *)data;
+            // enough work to give the helpers a chance to take some of it.
+            volatile double x = 0;
+            for (int i = 0; i < 2000; ++i)
+            {
+                x = x + i * 0.5;
+            }
+            self->runs[taskIndex].fetch_add(1);
+        }
+        bool RanOnce() const
+        {
+            for (const auto &run : runs)
+            {
+                if (run.load() != 1)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+}
+
+TEST_CASE("TaskGroup runs every task once", "[task_group][Build][Dev]")
+{
+    TaskGroupFeature feature;
+    feature.Initialize();
+    const LV2_TaskGroup *taskGroup = (const LV2_TaskGroup *)feature.GetFeature()->data;
+    REQUIRE(taskGroup->get_concurrency(taskGroup->handle) >= 1);
+
+    uint64_t helperTasks = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+        TaskCounts counts;
+        helperTasks += taskGroup->run_tasks(taskGroup->handle, &TaskCounts::Task, &counts, TaskCounts::N_TASKS);
+        REQUIRE(counts.RanOnce());
+    }
+    TaskGroupTiming timing = feature.GetTiming(7);
+    REQUIRE(timing.instanceId_ == 7);
+    REQUIRE(timing.calls_ == 200);
+    REQUIRE(timing.tasks_ == 200 * TaskCounts::N_TASKS);
+    REQUIRE(timing.helperTaskPercent_ == helperTasks * 100.0f / timing.tasks_);
+}
+
+TEST_CASE("TaskGroup concurrent callers", "[task_group][Build][Dev]")
+{
+    // Only one task group runs on the pool at a time; the other caller runs its tasks inline.
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t)
+    {
+        threads.emplace_back([&failed]()
+                             {
+            TaskGroupFeature feature;
+            feature.Initialize();
+            const LV2_TaskGroup *taskGroup = (const LV2_TaskGroup *)feature.GetFeature()->data;
+            for (int i = 0; i < 100; ++i)
+            {
+                TaskCounts counts;
+                taskGroup->run_tasks(taskGroup->handle, &TaskCounts::Task, &counts, TaskCounts::N_TASKS);
+                if (!counts.RanOnce())
+                {
+                    failed = true;
+                }
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    REQUIRE(!failed);
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Task.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <future>
+#include <thread>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    Task<int> AddAsync(int a, int b)
+    {
+        co_return a + b;
+    }
+    Task<int> AddOnPoolAsync(ThreadPool &pool, int a, int b)
+    {
+        co_await ResumeOn(pool);
+        REQUIRE(ThreadPool::IsPoolThread());
+        int result = co_await AddAsync(a, b);
+        co_return result;
+    }
+    Task<int> ThrowAsync()
+    {
+        throw std::runtime_error("Expected exception.");
+        co_return 0;
+    }
+}
+
+TEST_CASE("Task", "[task][Build][Dev]")
+{
+    ThreadPool pool("taskTest", 2);
+
+    SECTION("co_await, ResumeOn and Spawn")
+    {
+        std::promise<int> result;
+        auto run = [&]() -> Task<void>
+        {
+            int sum = co_await AddOnPoolAsync(pool, 2, 3);
+            result.set_value(sum);
+        };
+        Spawn(run());
+        REQUIRE(result.get_future().get() == 5);
+    }
+    SECTION("exceptions propagate to the awaiter")
+    {
+        std::promise<bool> result;
+        auto run = [&]() -> Task<void>
+        {
+            bool thrown = false;
+            try
+            {
+                co_await ThrowAsync();
+            }
+            catch (const std::exception &)
+            {
+                thrown = true;
+            }
+            result.set_value(thrown);
+        };
+        Spawn(run());
+        REQUIRE(result.get_future().get());
+
+        // unhandled exceptions in a spawned task are logged.
+        auto unhandled = []() -> Task<void>
+        {
+            co_await ThrowAsync();
+        };
+        Spawn(unhandled());
+    }
+    SECTION("Promise bridge")
+    {
+        int value = ToPromise(AddOnPoolAsync(pool, 4, 5)).Get();
+        REQUIRE(value == 9);
+        REQUIRE_THROWS(ToPromise(ThrowAsync()).Get());
+
+        std::promise<int> result;
+        auto run = [&]() -> Task<void>
+        {
+            int a = co_await Promise<int>::Run(pool, []()
+                                               { return 7; });
+            try
+            {
+                co_await Promise<int>::Run(pool, []() -> int
+                                           { throw std::runtime_error("rejected"); });
+                a = -1;
+            }
+            catch (const std::exception &e)
+            {
+                REQUIRE(std::string(e.what()) == "rejected");
+            }
+            result.set_value(a);
+        };
+        Spawn(run());
+        REQUIRE(result.get_future().get() == 7);
+        pool.WaitForIdle();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+
+    SECTION("SerialExecutor keeps order")
+    {
+        auto serial = SerialExecutor::Create(pool);
+        std::mutex mutex;
+        std::vector<int> order;
+        std::atomic<int> running{0};
+        std::atomic<bool> overlapped{false};
+        for (int i = 0; i < 100; ++i)
+        {
+            serial->Execute(
+                [&, i]()
+                {
+                    if (++running != 1)
+                    {
+                        overlapped = true;
+                    }
+                    {
+                        std::lock_guard lock{mutex};
+                        order.push_back(i);
+                    }
+                    --running;
+                });
+        }
+        pool.WaitForIdle();
+        REQUIRE(!overlapped);
+        REQUIRE(order.size() == 100);
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(order[i] == i);
+        }
+    }
+}
@@ -19,6 +19,11 @@
 
 #include "TemporaryFile.hpp"
 #include <fstream>
+#include <cerrno>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace pipedal;
 
@@ -28,26 +33,32 @@ TemporaryFile::TemporaryFile(const std::filesystem::path&directory)
     namespace fs = std::filesystem;
     fs::create_directories(directory);
 
-    // Generate a unique filename
+    // Generate a unique filename. O_EXCL makes the check-and-create atomic, since temporary
+    // files may be created concurrently by several threads.
+    static const char alphanum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    thread_local std::mt19937 random{std::random_device{}()};
+    std::uniform_int_distribution<size_t> distribution(0, sizeof(alphanum) - 2);
+
     std::string filename;
-    do {
+    while (true)
+    {
         std::string random_string(8, '\0');
-        const char alphanum[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-        
-        srand(static_cast<unsigned int>(time(nullptr)));
         for (int i = 0; i < 8; ++i) {
-            random_string[i] = alphanum[rand() % (sizeof(alphanum) - 1)];
+            random_string[i] = alphanum[distribution(random)];
         }
-        
         filename = directory / ("temp_" + random_string + ".tmp");
-    } while (fs::exists(filename));
 
-    // Create the file
-    std::ofstream file(filename);
-    if (!file) {
-        throw std::runtime_error("Failed to create temporary file");
+        int fd = open(filename.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd != -1)
+        {
+            close(fd);
+            break;
+        }
+        if (errno != EEXIST)
+        {
+            throw std::runtime_error("Failed to create temporary file");
+        }
     }
-    file.close();
 
     this->path = filename;
 
@@ -0,0 +1,200 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "ThreadPool.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include "ss.hpp"
+#include <algorithm>
+
+using namespace pipedal;
+
+static thread_local bool isPoolThread = false;
+
+ThreadPool::ThreadPool(
+    const std::string &threadName,
+    size_t threads,
+    SchedulerPriority priority,
+    size_t maxPendingWork)
+    : threadName(threadName),
+      priority(priority),
+      threadCount(std::max(threads, (size_t)1)),
+      maxPendingWork(maxPendingWork)
+{
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        this->threads.emplace_back([this]()
+                                   { ThreadProc(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    Close();
+}
+
+ThreadPool &ThreadPool::Shared()
+{
+    static ThreadPool sharedPool(
+        "pool",
+        std::clamp((size_t)std::thread::hardware_concurrency(), (size_t)1, DEFAULT_MAX_THREADS),
+        SchedulerPriority::Background);
+    return sharedPool;
+}
+
+bool ThreadPool::IsPoolThread()
+{
+    return isPoolThread;
+}
+
+bool ThreadPool::Execute(std::function<void()> &&work)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (closing || queue.size() >= maxPendingWork)
+    {
+        return false;
+    }
+    queue.push_back(std::move(work));
+    cv.notify_one();
+    return true;
+}
+
+void ThreadPool::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closing)
+        {
+            return;
+        }
+        closing = true;
+        cv.notify_all();
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    threads.clear();
+}
+
+size_t ThreadPool::GetPendingWorkCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return queue.size() + runningWork;
+}
+
+void ThreadPool::WaitForIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCv.wait(lock, [this]()
+                { return queue.empty() && runningWork == 0; });
+}
+
+void ThreadPool::ThreadProc()
+{
+    SetThreadName(threadName);
+    SetThreadPriority(priority);
+    isPoolThread = true;
+
+    while (true)
+    {
+        std::function<void()> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this]()
+                    { return closing || !queue.empty(); });
+            if (queue.empty())
+            {
+                return; // closing, and drained.
+            }
+            work = std::move(queue.front());
+            queue.pop_front();
+            ++runningWork;
+        }
+        try
+        {
+            work();
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("ThreadPool: unhandled exception. " << e.what()));
+        }
+        work = nullptr; // release captures before reporting idle.
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --runningWork;
+            if (queue.empty() && runningWork == 0)
+            {
+                idleCv.notify_all();
+            }
+        }
+    }
+}
+
+SerialExecutor::ptr SerialExecutor::Create(IExecutor &executor)
+{
+    return ptr(new SerialExecutor(executor));
+}
+
+bool SerialExecutor::Execute(std::function<void()> &&work)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(work));
+        if (draining)
+        {
+            return true;
+        }
+        draining = true;
+    }
+    auto self = shared_from_this();
+    if (!executor.Execute([self]()
+                          { self->Drain(); }))
+    {
+        Drain(); // the target won't take it; keep order by running the queue here.
+    }
+    return true;
+}
+
+void SerialExecutor::Drain()
+{
+    while (true)
+    {
+        std::function<void()> work;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.empty())
+            {
+                draining = false;
+                return;
+            }
+            work = std::move(queue.front());
+            queue.pop_front();
+        }
+        try
+        {
+            work();
+        }
+        catch (const std::exception &e)
+        {
+            Lv2Log::error(SS("SerialExecutor: unhandled exception. " << e.what()));
+        }
+    }
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SchedulerPriority.hpp"
+#include "IExecutor.hpp"
+
+namespace pipedal
+{
+
+    /**
+     * @brief A fixed set of worker threads with a bounded work queue.
+     *
+     * Used to move blocking work (file scans, directory trees, storage I/O) off the web server
+     * threads and other latency-sensitive threads. Work items are run in the order in which they
+     * were posted. Exceptions thrown by work items are logged and discarded.
+     */
+    class ThreadPool : public IExecutor
+    {
+    public:
+        static constexpr size_t DEFAULT_MAX_THREADS = 4;
+        static constexpr size_t DEFAULT_MAX_PENDING_WORK = 256;
+
+        ThreadPool(
+            const std::string &threadName,
+            size_t threads,
+            SchedulerPriority priority = SchedulerPriority::Background,
+            size_t maxPendingWork = DEFAULT_MAX_PENDING_WORK);
+        virtual ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief The pipedald-wide pool.
+         *
+         * Threads run at background priority (on the background cpus, if a CpuAffinityPlan
+         * is configured). Thread count is min(hardware concurrency, DEFAULT_MAX_THREADS).
+         */
+        static ThreadPool &Shared();
+
+        // Returns false if the pool is closed, or if the queue is full.
+        virtual bool Execute(std::function<void()> &&work) override;
+
+        // Stop accepting work, run work that has already been queued, and join the worker threads.
+        void Close();
+
+        size_t GetThreadCount() const { return threadCount; }
+        size_t GetPendingWorkCount();
+
+        // Wait until there is no queued or running work. Test use only.
+        void WaitForIdle();
+
+        // True if the current thread is a worker thread of any ThreadPool.
+        static bool IsPoolThread();
+
+    private:
+        void ThreadProc();
+
+        std::string threadName;
+        SchedulerPriority priority;
+        size_t threadCount;
+        size_t maxPendingWork;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::condition_variable idleCv;
+        bool closing = false;
+        size_t runningWork = 0;
+        std::deque<std::function<void()>> queue;
+        std::vector<std::thread> threads;
+    };
+
+    /**
+     * @brief Runs work items one at a time, in the order in which they were posted, on another executor.
+     *
+     * Use to keep requests that must not be reordered (e.g. from one websocket client) in order,
+     * while still running them off the calling thread.
+     */
+    class SerialExecutor : public IExecutor, public std::enable_shared_from_this<SerialExecutor>
+    {
+    protected:
+        SerialExecutor(IExecutor &executor) : executor(executor) {}
+
+    public:
+        using ptr = std::shared_ptr<SerialExecutor>;
+
+        // The target executor must outlive the SerialExecutor.
+        static ptr Create(IExecutor &executor);
+
+        // If the target executor doesn't accept the work, runs queued work on the calling thread.
+        virtual bool Execute(std::function<void()> &&work) override;
+
+    private:
+        void Drain();
+
+        IExecutor &executor;
+        std::mutex mutex;
+        bool draining = false;
+        std::deque<std::function<void()>> queue;
+    };
+}
@@ -0,0 +1,124 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ThreadPool.hpp"
+#include "Promise.hpp"
+#include <atomic>
+#include <future>
+
+using namespace pipedal;
+using namespace std;
+
+TEST_CASE("ThreadPool", "[thread_pool][Build][Dev]")
+{
+    SECTION("runs work on pool threads")
+    {
+        ThreadPool pool("poolTest", 3);
+        std::atomic<int> count{0};
+        std::atomic<bool> allOnPoolThreads{true};
+        for (int i = 0; i < 50; ++i)
+        {
+            REQUIRE(pool.Execute(
+                [&]()
+                {
+                    if (!ThreadPool::IsPoolThread())
+                    {
+                        allOnPoolThreads = false;
+                    }
+                    ++count;
+                }));
+        }
+        pool.WaitForIdle();
+        REQUIRE(count == 50);
+        REQUIRE(allOnPoolThreads);
+        REQUIRE(!ThreadPool::IsPoolThread());
+        REQUIRE(pool.GetPendingWorkCount() == 0);
+    }
+    SECTION("bounded queue, and Close drains queued work")
+    {
+        ThreadPool pool("poolTest", 1, SchedulerPriority::Background, 2);
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::atomic<int> count{0};
+
+        REQUIRE(pool.Execute([released]()
+                             { released.wait(); }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50)); // let the worker take the blocking work.
+
+        REQUIRE(pool.Execute([&]()
+                             { ++count; }));
+        REQUIRE(pool.Execute([&]()
+                             { ++count; }));
+        REQUIRE(!pool.Execute([&]()
+                              { ++count; })); // full.
+
+        release.set_value();
+        pool.Close();
+        REQUIRE(count == 2);
+        REQUIRE(!pool.Execute([&]()
+                              { ++count; })); // closed.
+    }
+    SECTION("exceptions don't kill worker threads")
+    {
+        ThreadPool pool("poolTest", 1);
+        std::atomic<int> count{0};
+        pool.Execute([]()
+                     { throw std::runtime_error("Expected exception."); });
+        pool.Execute([&]()
+                     { ++count; });
+        pool.WaitForIdle();
+        REQUIRE(count == 1);
+    }
+    SECTION("Promise continuations on the pool")
+    {
+        ThreadPool pool("poolTest", 2);
+        std::vector<Promise<int>> promises;
+        for (int i = 0; i < 8; ++i)
+        {
+            promises.push_back(Promise<int>::Run(pool, [i]()
+                                                 {
+                REQUIRE(ThreadPool::IsPoolThread());
+                return i * i; }));
+        }
+        std::vector<int> squares = Promise<int>::All(promises).Get();
+        REQUIRE(squares.size() == 8);
+        for (int i = 0; i < 8; ++i)
+        {
+            REQUIRE(squares[i] == i * i);
+        }
+
+        std::atomic<bool> onPoolThread{false};
+        std::promise<void> done;
+        Promise<int>([](ResolveFunction<int> resolve, RejectFunction reject)
+                     { resolve(1); })
+            .On(pool)
+            .Then([&](int value)
+                  {
+                onPoolThread = ThreadPool::IsPoolThread();
+                done.set_value(); });
+        done.get_future().wait();
+        REQUIRE(onPoolThread);
+        promises.clear();
+        pool.WaitForIdle();
+    }
+    REQUIRE(PromiseInnerBase::allocationCount == 0);
+}
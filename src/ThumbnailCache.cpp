@@ -0,0 +1,315 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "ThumbnailCache.hpp"
+#include "AudioFilesDb.hpp"
+#include "Lv2Log.hpp"
+#include "ss.hpp"
+#include "ofstream_synced.hpp"
+#include <chrono>
+#include <unistd.h>
+
+using namespace pipedal;
+using namespace pipedal::impl;
+namespace fs = std::filesystem;
+
+static int64_t NowSeconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+ThumbnailCache::ThumbnailCache(
+    const std::filesystem::path &cacheDirectory,
+    uint64_t maxBytes,
+    int64_t evictionGraceSeconds,
+    const std::string &entryExtension)
+    : cacheDirectory(cacheDirectory), entryExtension(entryExtension), maxBytes(maxBytes), evictionGraceSeconds(evictionGraceSeconds)
+{
+    fs::create_directories(cacheDirectory);
+    // remove files orphaned by an interrupted Put().
+    for (const auto &dirEntry : fs::directory_iterator(cacheDirectory))
+    {
+        if (dirEntry.path().extension() == ".$$$")
+        {
+            std::error_code ec;
+            fs::remove(dirEntry.path(), ec);
+        }
+    }
+    db = std::make_unique<ThumbnailCacheDb>(cacheDirectory / "index.db");
+    cachedBytes = (uint64_t)db->GetTotalSize();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Evict(); // in case the budget has been reduced.
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    Lv2Log::debug(SS("Thumbnail cache: " << hits << " hits, " << misses << " misses, " << evictions << " evictions."));
+}
+
+std::string ThumbnailCache::MakeKey(const std::filesystem::path &file, int64_t lastModified, int32_t width, int32_t height)
+{
+    return SS(file.string() << '|' << lastModified << '|' << width << 'x' << height);
+}
+
+std::string ThumbnailCache::MakeKey(const std::filesystem::path &file, int64_t lastModified)
+{
+    return SS(file.string() << '|' << lastModified);
+}
+
+std::filesystem::path ThumbnailCache::GetEntryPath(int64_t idEntry) const
+{
+    return cacheDirectory / SS(idEntry << entryExtension);
+}
+
+std::filesystem::path ThumbnailCache::Get(const std::string &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    try
+    {
+        int64_t now = NowSeconds();
+        if (MemoryEntry *memoryEntry = memoryIndex.find(key))
+        {
+            memoryEntry->lastAccess = now;
+            if (now - memoryEntry->lastAccessWritten >= ACCESS_TIME_RESOLUTION_SECONDS)
+            {
+                db->Touch(memoryEntry->idEntry, now);
+                memoryEntry->lastAccessWritten = now;
+            }
+            ++hits;
+            return GetEntryPath(memoryEntry->idEntry);
+        }
+
+        ThumbnailCacheEntry entry;
+        if (db->Lookup(key, &entry))
+        {
+            fs::path path = GetEntryPath(entry.idEntry);
+            if (fs::exists(path))
+            {
+                db->Touch(entry.idEntry, now);
+                MemoryEntry memoryEntry;
+                memoryEntry.idEntry = entry.idEntry;
+                memoryEntry.lastAccess = now;
+                memoryEntry.lastAccessWritten = now;
+                memoryIndex.put(key, memoryEntry);
+                ++hits;
+                return path;
+            }
+            RemoveEntry(entry.idEntry, key, entry.size);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Thumbnail cache lookup failed: " << e.what()));
+    }
+    ++misses;
+    return fs::path();
+}
+
+std::filesystem::path ThumbnailCache::Put(const std::string &key, const std::vector<uint8_t> &data)
+{
+    if (data.empty() || data.size() > maxBytes)
+    {
+        return fs::path();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    fs::path tempPath;
+    try
+    {
+        ThumbnailCacheEntry existingEntry;
+        if (db->Lookup(key, &existingEntry))
+        {
+            RemoveEntry(existingEntry.idEntry, key, existingEntry.size);
+        }
+
+        int64_t now = NowSeconds();
+        int64_t idEntry = db->Insert(key, (int64_t)data.size(), now);
+        fs::path path = GetEntryPath(idEntry);
+        tempPath = path;
+        tempPath.replace_extension(".$$$");
+        {
+            ofstream_synced f(tempPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            if (!f.is_open())
+            {
+                throw std::runtime_error(SS("Can't write to " << tempPath));
+            }
+            f.write((const char *)data.data(), data.size());
+            if (!f)
+            {
+                throw std::runtime_error(SS("Can't write to " << tempPath));
+            }
+        }
+        fs::rename(tempPath, path);
+        tempPath.clear();
+
+        cachedBytes += data.size();
+        MemoryEntry memoryEntry;
+        memoryEntry.idEntry = idEntry;
+        memoryEntry.lastAccess = now;
+        memoryEntry.lastAccessWritten = now;
+        memoryIndex.put(key, memoryEntry);
+
+        Evict();
+        return path;
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't add thumbnail to the thumbnail cache: " << e.what()));
+        if (!tempPath.empty())
+        {
+            std::error_code ec;
+            fs::remove(tempPath, ec);
+        }
+        try
+        {
+            ThumbnailCacheEntry entry;
+            if (db->Lookup(key, &entry))
+            {
+                RemoveEntry(entry.idEntry, key, entry.size);
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        return fs::path();
+    }
+}
+
+std::filesystem::path ThumbnailCache::GetTemporaryPath()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return cacheDirectory / SS("t" << getpid() << "-" << (nextTemporaryFile++) << ".$$$");
+}
+
+std::filesystem::path ThumbnailCache::PutFile(const std::string &key, const std::filesystem::path &file)
+{
+    std::error_code ec;
+    uint64_t size = fs::file_size(file, ec);
+    if (ec || size == 0 || size > maxBytes)
+    {
+        fs::remove(file, ec);
+        return fs::path();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    try
+    {
+        ThumbnailCacheEntry existingEntry;
+        if (db->Lookup(key, &existingEntry))
+        {
+            RemoveEntry(existingEntry.idEntry, key, existingEntry.size);
+        }
+
+        int64_t now = NowSeconds();
+        int64_t idEntry = db->Insert(key, (int64_t)size, now);
+        fs::path path = GetEntryPath(idEntry);
+        fs::rename(file, path);
+
+        cachedBytes += size;
+        MemoryEntry memoryEntry;
+        memoryEntry.idEntry = idEntry;
+        memoryEntry.lastAccess = now;
+        memoryEntry.lastAccessWritten = now;
+        memoryIndex.put(key, memoryEntry);
+
+        Evict();
+        return path;
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::warning(SS("Can't add " << file << " to the cache: " << e.what()));
+        fs::remove(file, ec);
+        try
+        {
+            ThumbnailCacheEntry entry;
+            if (db->Lookup(key, &entry))
+            {
+                RemoveEntry(entry.idEntry, key, entry.size);
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+        return fs::path();
+    }
+}
+
+void ThumbnailCache::RemoveEntry(int64_t idEntry, const std::string &key, int64_t size)
+{
+    std::error_code ec;
+    fs::remove(GetEntryPath(idEntry), ec);
+    db->Delete(idEntry);
+    memoryIndex.erase(key);
+    cachedBytes -= std::min<uint64_t>(cachedBytes, (uint64_t)size);
+}
+
+void ThumbnailCache::Evict()
+{
+    constexpr size_t BATCH_SIZE = 32;
+
+    int64_t now = NowSeconds();
+    while (cachedBytes > maxBytes)
+    {
+        bool progress = false;
+        for (const auto &entry : db->GetLeastRecentlyUsed(BATCH_SIZE))
+        {
+            int64_t lastAccess = entry.lastAccess;
+            MemoryEntry *memoryEntry = memoryIndex.find(entry.cacheKey);
+            if (memoryEntry)
+            {
+                lastAccess = memoryEntry->lastAccess;
+            }
+            if (now - lastAccess < evictionGraceSeconds)
+            {
+                if (lastAccess != entry.lastAccess)
+                {
+                    // the index's access time is stale. Record the real one, so it sorts correctly next time.
+                    db->Touch(entry.idEntry, lastAccess);
+                    memoryEntry->lastAccessWritten = lastAccess;
+                    progress = true;
+                }
+                continue;
+            }
+            RemoveEntry(entry.idEntry, entry.cacheKey, entry.size);
+            ++evictions;
+            progress = true;
+            if (cachedBytes <= maxBytes)
+            {
+                break;
+            }
+        }
+        if (!progress)
+        {
+            break; // everything left is in use. Try again on the next Put().
+        }
+    }
+}
+
+ThumbnailCache::Stats ThumbnailCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.evictions = evictions;
+    result.cachedBytes = cachedBytes;
+    result.maxBytes = maxBytes;
+    return result;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "LRUCache.hpp"
+
+namespace pipedal
+{
+    namespace impl
+    {
+        class ThumbnailCacheDb;
+    }
+
+    /**
+     * @brief A disk cache of generated thumbnails, with a byte budget and least-recently-used eviction.
+     *
+     * Thumbnails are stored as files in the cache directory, so that a cached thumbnail can be
+     * served straight from disk, without copying it out of a directory's index into a temporary
+     * file. The cache is indexed (with access times) in an SQLite database in the cache directory;
+     * recently used entries are also indexed in memory, so that hits don't touch the database.
+     *
+     * Keys include the source file's last-modified time, so entries for modified files are
+     * never served; they age out instead.
+     *
+     * Also used (with a different entryExtension) as the cache of decoded compressed audio files.
+     */
+    class ThumbnailCache
+    {
+    public:
+        using ptr = std::shared_ptr<ThumbnailCache>;
+
+        // Entries used this recently aren't evicted, since they may not have been served yet.
+        static constexpr int64_t DEFAULT_EVICTION_GRACE_SECONDS = 10;
+
+        ThumbnailCache(
+            const std::filesystem::path &cacheDirectory,
+            uint64_t maxBytes,
+            int64_t evictionGraceSeconds = DEFAULT_EVICTION_GRACE_SECONDS,
+            const std::string &entryExtension = ".jpg");
+        ~ThumbnailCache();
+
+        ThumbnailCache(const ThumbnailCache &) = delete;
+        ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+
+        static ptr Create(const std::filesystem::path &cacheDirectory, uint64_t maxBytes)
+        {
+            return std::make_shared<ThumbnailCache>(cacheDirectory, maxBytes);
+        }
+
+        static std::string MakeKey(const std::filesystem::path &file, int64_t lastModified, int32_t width, int32_t height);
+        static std::string MakeKey(const std::filesystem::path &file, int64_t lastModified);
+
+        // The path of the cached thumbnail, or an empty path if the thumbnail isn't cached.
+        std::filesystem::path Get(const std::string &key);
+        // Add a thumbnail to the cache. Returns the path of the cached thumbnail, or an empty path if it couldn't be stored.
+        std::filesystem::path Put(const std::string &key, const std::vector<uint8_t> &data);
+
+        // A path in the cache directory at which to write data for PutFile(). Removed at startup if it's left behind.
+        std::filesystem::path GetTemporaryPath();
+        // Move a file (written to GetTemporaryPath()) into the cache. Returns the path of the cached file,
+        // or an empty path if it couldn't be stored, in which case the file is deleted.
+        std::filesystem::path PutFile(const std::string &key, const std::filesystem::path &file);
+
+        class Stats
+        {
+        public:
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t evictions = 0;
+            uint64_t cachedBytes = 0;
+            uint64_t maxBytes = 0;
+        };
+        Stats GetStats() const;
+
+    private:
+        class MemoryEntry
+        {
+        public:
+            int64_t idEntry = -1;
+            int64_t lastAccess = 0;        // seconds since the epoch.
+            int64_t lastAccessWritten = 0; // the access time recorded in the index.
+        };
+
+        // Access times are only written to the index when they're this stale, to spare the SD card.
+        static constexpr int64_t ACCESS_TIME_RESOLUTION_SECONDS = 60;
+        static constexpr size_t MEMORY_INDEX_SIZE = 2048;
+
+        std::filesystem::path GetEntryPath(int64_t idEntry) const;
+        void Evict(); // mutex held.
+        void RemoveEntry(int64_t idEntry, const std::string &key, int64_t size);
+
+        std::filesystem::path cacheDirectory;
+        std::string entryExtension;
+        uint64_t nextTemporaryFile = 0;
+        uint64_t maxBytes;
+        int64_t evictionGraceSeconds;
+
+        mutable std::mutex mutex;
+        std::unique_ptr<impl::ThumbnailCacheDb> db;
+        LRUCache<std::string, MemoryEntry> memoryIndex{MEMORY_INDEX_SIZE};
+        uint64_t cachedBytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+}
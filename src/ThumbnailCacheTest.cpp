@@ -0,0 +1,142 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "ThumbnailCache.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+static std::vector<uint8_t> MakeThumbnail(size_t size, uint8_t value)
+{
+    return std::vector<uint8_t>(size, value);
+}
+
+TEST_CASE("ThumbnailCache", "[thumbnail_cache][Build][Dev]")
+{
+    fs::path cacheDirectory = fs::temp_directory_path() / "ThumbnailCacheTest";
+    fs::remove_all(cacheDirectory);
+
+    SECTION("hits and misses")
+    {
+        ThumbnailCache cache(cacheDirectory, 10000);
+        std::string key = ThumbnailCache::MakeKey("/music/a.flac", 1000, 240, 240);
+        REQUIRE(cache.Get(key).empty());
+
+        fs::path path = cache.Put(key, MakeThumbnail(100, 1));
+        REQUIRE(!path.empty());
+        REQUIRE(fs::file_size(path) == 100);
+        REQUIRE(cache.Get(key) == path);
+
+        // a modified source file has a different key.
+        REQUIRE(cache.Get(ThumbnailCache::MakeKey("/music/a.flac", 2000, 240, 240)).empty());
+
+        auto stats = cache.GetStats();
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.misses == 2);
+        REQUIRE(stats.cachedBytes == 100);
+    }
+    SECTION("persists across instances")
+    {
+        std::string key = ThumbnailCache::MakeKey("/music/a.flac", 1000, 240, 240);
+        fs::path path;
+        {
+            ThumbnailCache cache(cacheDirectory, 10000);
+            path = cache.Put(key, MakeThumbnail(100, 1));
+        }
+        ThumbnailCache cache(cacheDirectory, 10000);
+        REQUIRE(cache.GetStats().cachedBytes == 100);
+        REQUIRE(cache.Get(key) == path);
+    }
+    SECTION("replaces existing entries")
+    {
+        ThumbnailCache cache(cacheDirectory, 10000);
+        std::string key = ThumbnailCache::MakeKey("/music/a.flac", 1000, 240, 240);
+        fs::path oldPath = cache.Put(key, MakeThumbnail(100, 1));
+        fs::path newPath = cache.Put(key, MakeThumbnail(200, 2));
+        REQUIRE(!fs::exists(oldPath));
+        REQUIRE(fs::file_size(newPath) == 200);
+        REQUIRE(cache.GetStats().cachedBytes == 200);
+    }
+    SECTION("evicts least recently used entries")
+    {
+        ThumbnailCache cache(cacheDirectory, 1000, 0);
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 20; ++i)
+        {
+            paths.push_back(cache.Put(ThumbnailCache::MakeKey("/music/a.flac", i, 240, 240), MakeThumbnail(100, (uint8_t)i)));
+            REQUIRE(!paths.back().empty());
+        }
+        auto stats = cache.GetStats();
+        REQUIRE(stats.cachedBytes <= 1000);
+        REQUIRE(stats.evictions == 10);
+        REQUIRE(fs::exists(paths.back()));
+        size_t files = 0;
+        for (const auto &path : paths)
+        {
+            if (fs::exists(path))
+            {
+                ++files;
+            }
+        }
+        REQUIRE(files == 10);
+    }
+    SECTION("doesn't evict entries in use")
+    {
+        ThumbnailCache cache(cacheDirectory, 1000);
+        for (int i = 0; i < 20; ++i)
+        {
+            REQUIRE(!cache.Put(ThumbnailCache::MakeKey("/music/a.flac", i, 240, 240), MakeThumbnail(100, (uint8_t)i)).empty());
+        }
+        REQUIRE(cache.GetStats().evictions == 0);
+    }
+    SECTION("adds files")
+    {
+        ThumbnailCache cache(cacheDirectory, 10000, ThumbnailCache::DEFAULT_EVICTION_GRACE_SECONDS, ".flac");
+        std::string key = ThumbnailCache::MakeKey("/music/a.mp3", 1000);
+
+        fs::path tempPath = cache.GetTemporaryPath();
+        REQUIRE(tempPath.parent_path() == cacheDirectory);
+        {
+            std::ofstream f(tempPath, std::ios_base::binary);
+            f << std::string(300, 'x');
+        }
+        fs::path path = cache.PutFile(key, tempPath);
+        REQUIRE(!path.empty());
+        REQUIRE(path.extension() == ".flac");
+        REQUIRE(!fs::exists(tempPath));
+        REQUIRE(fs::file_size(path) == 300);
+        REQUIRE(cache.Get(key) == path);
+        REQUIRE(cache.GetStats().cachedBytes == 300);
+
+        // too large for the cache.
+        tempPath = cache.GetTemporaryPath();
+        {
+            std::ofstream f(tempPath, std::ios_base::binary);
+            f << std::string(20000, 'x');
+        }
+        REQUIRE(cache.PutFile(ThumbnailCache::MakeKey("/music/b.mp3", 1000), tempPath).empty());
+        REQUIRE(!fs::exists(tempPath));
+    }
+    fs::remove_all(cacheDirectory);
+}
@@ -0,0 +1,272 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "Tracer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_set>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+using namespace pipedal;
+
+namespace
+{
+    // All fields are atomic so that WriteTrace() can run while writers are active. sequence is the
+    // event's write index + 1 once the event is complete; readers discard events whose sequence changes.
+    struct TraceEvent
+    {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> startNs{0};
+        std::atomic<uint64_t> durationNs{0};
+        std::atomic<const char *> category{nullptr};
+        std::atomic<const char *> name{nullptr};
+        std::atomic<int64_t> arg{0};
+        std::atomic<int32_t> tid{0};
+        std::atomic<char> phase{0};
+    };
+
+    struct EventCopy
+    {
+        uint64_t startNs;
+        uint64_t durationNs;
+        const char *category;
+        const char *name;
+        int64_t arg;
+        int32_t tid;
+        char phase;
+    };
+
+    std::atomic<TraceEvent *> events{nullptr};
+    std::atomic<uint64_t> writeIndex{0};
+    std::mutex controlMutex;
+
+    thread_local int32_t currentTid = 0;
+
+    int32_t CurrentTid()
+    {
+        if (currentTid == 0)
+        {
+            currentTid = (int32_t)syscall(SYS_gettid);
+        }
+        return currentTid;
+    }
+
+    void WriteJsonString(std::ostream &s, const char *text)
+    {
+        s << '"';
+        for (const char *p = text; *p != '\0'; ++p)
+        {
+            char c = *p;
+            if (c == '"' || c == '\\')
+            {
+                s << '\\' << c;
+            }
+            else if ((unsigned char)c < 0x20)
+            {
+                static const char hex[] = "0123456789abcdef";
+                s << "\\u00" << hex[(c >> 4) & 0x0F] << hex[c & 0x0F];
+            }
+            else
+            {
+                s << c;
+            }
+        }
+        s << '"';
+    }
+
+    std::string GetThreadName(int32_t tid)
+    {
+        std::ifstream f("/proc/self/task/" + std::to_string(tid) + "/comm");
+        std::string name;
+        if (f.is_open())
+        {
+            std::getline(f, name);
+        }
+        return name;
+    }
+
+    void WriteTimeUs(std::ostream &s, uint64_t ns)
+    {
+        // integer arithmetic, so that long uptimes don't lose ns precision.
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+        s << buffer;
+    }
+}
+
+std::atomic<bool> Tracer::enabled{false};
+
+uint64_t Tracer::Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void Tracer::Start()
+{
+    std::lock_guard lock(controlMutex);
+    enabled.store(false);
+    if (events.load() == nullptr)
+    {
+        // never freed: writers may be holding the pointer.
+        events.store(new TraceEvent[CAPACITY]);
+    }
+    writeIndex.store(0);
+    enabled.store(true, std::memory_order_release);
+}
+
+void Tracer::Stop()
+{
+    std::lock_guard lock(controlMutex);
+    enabled.store(false);
+}
+
+void Tracer::Record(char phase, const char *category, const char *name, uint64_t startNs, uint64_t durationNs, int64_t arg)
+{
+    TraceEvent *buffer = events.load(std::memory_order_acquire);
+    if (buffer == nullptr)
+    {
+        return;
+    }
+    uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &event = buffer[index % CAPACITY];
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.startNs.store(startNs, std::memory_order_relaxed);
+    event.durationNs.store(durationNs, std::memory_order_relaxed);
+    event.category.store(category, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    event.tid.store(CurrentTid(), std::memory_order_relaxed);
+    event.phase.store(phase, std::memory_order_relaxed);
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+const char *Tracer::Intern(const std::string &text)
+{
+    // Bounded, since names may come from clients (e.g. websocket message names).
+    static constexpr size_t MAX_INTERNED_STRINGS = 4096;
+    static std::mutex internMutex;
+    static auto *strings = new std::unordered_set<std::string>(); // never freed: events may refer to it at exit.
+
+    std::lock_guard lock(internMutex);
+    auto i = strings->find(text);
+    if (i != strings->end())
+    {
+        return i->c_str();
+    }
+    if (strings->size() >= MAX_INTERNED_STRINGS)
+    {
+        return "(other)";
+    }
+    return strings->insert(text).first->c_str();
+}
+
+void Tracer::WriteTrace(std::ostream &s)
+{
+    std::vector<EventCopy> copies;
+    TraceEvent *buffer = events.load(std::memory_order_acquire);
+    if (buffer != nullptr)
+    {
+        uint64_t end = writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+        copies.reserve(end - begin);
+        for (uint64_t index = begin; index < end; ++index)
+        {
+            TraceEvent &event = buffer[index % CAPACITY];
+            if (event.sequence.load(std::memory_order_acquire) != index + 1)
+            {
+                continue; // still being written, or already overwritten.
+            }
+            EventCopy copy;
+            copy.startNs = event.startNs.load(std::memory_order_relaxed);
+            copy.durationNs = event.durationNs.load(std::memory_order_relaxed);
+            copy.category = event.category.load(std::memory_order_relaxed);
+            copy.name = event.name.load(std::memory_order_relaxed);
+            copy.arg = event.arg.load(std::memory_order_relaxed);
+            copy.tid = event.tid.load(std::memory_order_relaxed);
+            copy.phase = event.phase.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (event.sequence.load(std::memory_order_relaxed) != index + 1)
+            {
+                continue;
+            }
+            copies.push_back(copy);
+        }
+    }
+
+    int pid = (int)getpid();
+    s << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+
+    std::set<int32_t> tids;
+    for (const auto &copy : copies)
+    {
+        tids.insert(copy.tid);
+    }
+    for (int32_t tid : tids)
+    {
+        std::string threadName = GetThreadName(tid);
+        if (threadName.empty())
+        {
+            continue; // the thread has exited.
+        }
+        s << (first ? "\n" : ",\n");
+        first = false;
+        s << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+        WriteJsonString(s, threadName.c_str());
+        s << "}}";
+    }
+
+    for (const auto &copy : copies)
+    {
+        s << (first ? "\n" : ",\n");
+        first = false;
+        s << "{\"ph\":\"" << copy.phase << "\",\"cat\":";
+        WriteJsonString(s, copy.category);
+        s << ",\"name\":";
+        WriteJsonString(s, copy.name);
+        s << ",\"pid\":" << pid << ",\"tid\":" << copy.tid << ",\"ts\":";
+        WriteTimeUs(s, copy.startNs);
+        if (copy.phase == 'X')
+        {
+            s << ",\"dur\":";
+            WriteTimeUs(s, copy.durationNs);
+        }
+        else
+        {
+            s << ",\"s\":\"t\"";
+        }
+        if (copy.arg != NO_ARG)
+        {
+            s << ",\"args\":{\"arg\":" << copy.arg << "}";
+        }
+        s << "}";
+    }
+    s << "\n]}\n";
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace pipedal
+{
+    /**
+     * @brief Low-overhead event tracing for the realtime and host pipelines.
+     *
+     * Trace points are compiled in, and cost a single relaxed load while tracing is disabled. When enabled,
+     * events are written into a fixed-size process-wide ring with one atomic increment, so recording is wait-free
+     * and safe on the audio thread. The most recent CAPACITY events are kept.
+     *
+     * WriteTrace() writes the ring in Chrome JSON trace format, which ui.perfetto.dev opens directly, so audio
+     * periods, plugin runs, worker requests and websocket messages appear on one timeline.
+     *
+     * Category and name strings are not copied: they must be string literals, or strings returned by Intern().
+     */
+    class Tracer
+    {
+    public:
+        static constexpr size_t CAPACITY = 256 * 1024; // events.
+        static constexpr int64_t NO_ARG = INT64_MIN;
+
+        static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+        // Clears the ring and starts recording. Not on the audio thread (allocates the first time).
+        static void Start();
+        static void Stop();
+
+        // CLOCK_MONOTONIC ns, the same clock as AudioPeriodTrace::Now().
+        static uint64_t Now();
+
+        static void Complete(const char *category, const char *name, uint64_t startNs, uint64_t endNs, int64_t arg = NO_ARG)
+        {
+            if (IsEnabled())
+            {
+                Record('X', category, name, startNs, endNs >= startNs ? endNs - startNs : 0, arg);
+            }
+        }
+        static void Instant(const char *category, const char *name, int64_t arg = NO_ARG)
+        {
+            if (IsEnabled())
+            {
+                Record('i', category, name, Now(), 0, arg);
+            }
+        }
+
+        // A permanent copy of text, for names that aren't literals. Not on the audio thread.
+        static const char *Intern(const std::string &text);
+
+        static void WriteTrace(std::ostream &s);
+
+    private:
+        static void Record(char phase, const char *category, const char *name, uint64_t startNs, uint64_t durationNs, int64_t arg);
+
+        static std::atomic<bool> enabled;
+    };
+
+    // Records a complete event covering the lifetime of the scope.
+    class TraceScope
+    {
+    public:
+        TraceScope(const char *category, const char *name, int64_t arg = Tracer::NO_ARG)
+        {
+            if (Tracer::IsEnabled() && name != nullptr)
+            {
+                this->category = category;
+                this->name = name;
+                this->arg = arg;
+                this->startNs = Tracer::Now();
+            }
+        }
+        ~TraceScope()
+        {
+            if (name != nullptr)
+            {
+                Tracer::Complete(category, name, startNs, Tracer::Now(), arg);
+            }
+        }
+        TraceScope(const TraceScope &) = delete;
+        TraceScope &operator=(const TraceScope &) = delete;
+
+    private:
+        const char *category = nullptr;
+        const char *name = nullptr;
+        int64_t arg = Tracer::NO_ARG;
+        uint64_t startNs = 0;
+    };
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Tracer.hpp"
+#include "json.hpp"
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace pipedal;
+
+namespace
+{
+    class TraceFile
+    {
+    public:
+        class Event
+        {
+        public:
+            std::string ph_;
+            std::string cat_;
+            std::string name_;
+            int64_t tid_ = 0;
+            double ts_ = 0;
+            double dur_ = 0;
+
+            DECLARE_JSON_MAP(Event);
+        };
+        std::vector<Event> traceEvents_;
+
+        DECLARE_JSON_MAP(TraceFile);
+    };
+
+    JSON_MAP_BEGIN(TraceFile::Event)
+    JSON_MAP_REFERENCE(TraceFile::Event, ph)
+    JSON_MAP_REFERENCE(TraceFile::Event, cat)
+    JSON_MAP_REFERENCE(TraceFile::Event, name)
+    JSON_MAP_REFERENCE(TraceFile::Event, tid)
+    JSON_MAP_REFERENCE(TraceFile::Event, ts)
+    JSON_MAP_REFERENCE(TraceFile::Event, dur)
+    JSON_MAP_END()
+
+    JSON_MAP_BEGIN(TraceFile)
+    JSON_MAP_REFERENCE(TraceFile, traceEvents)
+    JSON_MAP_END()
+
+    TraceFile ReadTrace()
+    {
+        std::stringstream s;
+        Tracer::WriteTrace(s);
+        json_reader reader(s);
+        TraceFile result;
+        reader.read(&result);
+        return result;
+    }
+    size_t Count(const TraceFile &trace, const std::string &name)
+    {
+        size_t result = 0;
+        for (const auto &event : trace.traceEvents_)
+        {
+            if (event.name_ == name)
+            {
+                ++result;
+            }
+        }
+        return result;
+    }
+}
+
+TEST_CASE("Tracer", "[tracer][Build][Dev]")
+{
+    Tracer::Stop();
+    Tracer::Instant("test", "dropped");
+    Tracer::Start();
+    REQUIRE(Tracer::IsEnabled());
+
+    Tracer::Complete("test", "complete", 1000000, 1002500, 7);
+    Tracer::Instant("test", "instant");
+    {
+        TraceScope scope("test", Tracer::Intern("quoted \"name\""));
+    }
+    Tracer::Stop();
+    Tracer::Instant("test", "dropped");
+
+    TraceFile trace = ReadTrace();
+    REQUIRE(Count(trace, "dropped") == 0);
+    REQUIRE(Count(trace, "instant") == 1);
+    REQUIRE(Count(trace, "quoted \"name\"") == 1);
+    REQUIRE(Count(trace, "thread_name") == 1);
+    for (const auto &event : trace.traceEvents_)
+    {
+        if (event.name_ == "complete")
+        {
+            REQUIRE(event.ph_ == "X");
+            REQUIRE(event.ts_ == 1000.0);
+            REQUIRE(event.dur_ == 2.5);
+        }
+    }
+
+    // Start() clears the previous trace.
+    Tracer::Start();
+    Tracer::Stop();
+    REQUIRE(ReadTrace().traceEvents_.empty());
+}
+
+TEST_CASE("Tracer wraps", "[tracer][Build][Dev]")
+{
+    Tracer::Start();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([]()
+                             {
+            for (size_t i = 0; i < Tracer::CAPACITY; ++i)
+            {
+                Tracer::Instant("test","event");
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    Tracer::Stop();
+
+    TraceFile trace = ReadTrace();
+    // the most recent events only. (Exited threads have no thread_name records.)
+    REQUIRE(Count(trace, "event") == Tracer::CAPACITY);
+}
@@ -142,9 +142,18 @@ void UnixSocket::Close()
     if (data->socket != -1)
     {
         close(data->socket);
+        data->socket = -1;
         unlink(data->localAddress.sun_path);
     }
 }
+
+void UnixSocket::Shutdown()
+{
+    if (data->socket != -1)
+    {
+        shutdown(data->socket, SHUT_RDWR);
+    }
+}
 UnixSocket::~UnixSocket()
 {
     Close();
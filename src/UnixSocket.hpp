@@ -81,6 +81,14 @@ namespace pipedal {
 
         void Close();
 
+        /**
+         * @brief Wake any thread blocked in Receive on this socket.
+         * 
+         * Receive returns zero bytes once the socket has been shut down. 
+         * The socket must still be closed with Close().
+         */
+        void Shutdown();
+
 
         size_t Send(const void*buffer, size_t length);
         size_t Receive(void *buffer, size_t length);
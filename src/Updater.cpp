@@ -28,7 +28,6 @@
 #include <poll.h>
 #include "Lv2Log.hpp"
 #include "SysExec.hpp"
-#include "json_variant.hpp"
 #include "ss.hpp"
 #include "Lv2Log.hpp"
 #include <algorithm>
@@ -38,6 +37,8 @@
 #include <fstream>
 #include "TemporaryFile.hpp"
 #include <limits>
+#include <sys/wait.h>
+#include <random>
 
 using namespace pipedal;
 namespace fs = std::filesystem;
@@ -76,6 +77,7 @@ private:
     std::filesystem::path workingDirectory;
     std::filesystem::path updateStatusCacheFile;
     std::filesystem::path githubResponseHeaderFilename;
+    std::filesystem::path githubReleasesCacheFilename;
 
     GithubResponseHeaders githubResponseHeaders;
 
@@ -93,11 +95,19 @@ private:
         RetryAfter(std::chrono::duration_cast<clock::duration>(duration));
     }
 
+    clock::duration GetPollingInterval(const GithubResponseHeaders &headers);
+    void SaveCachedReleases(const std::vector<GithubRelease> &releases);
+
     void SaveRetryTime(const std::chrono::system_clock::time_point &time);
     clock::time_point LoadRetryTime();
 
     std::string GetUpdateFilename(const std::string &url);
     std::string GetSignatureUrl(const std::string &url);
+    UpdateRelease GetUpdateRelease(const std::string &url);
+    bool DownloadDelta(
+        const UpdateRelease &release,
+        const std::filesystem::path &downloadFilePath,
+        const std::filesystem::path &downloadSignaturePath);
 
     UpdatePolicyT updatePolicy = UpdatePolicyT::ReleaseOrBeta;
     using UpdateReleasePredicate = std::function<bool(const GithubRelease &githubRelease)>;
@@ -188,7 +198,8 @@ void UpdaterImpl::SetCachedUpdateStatus(UpdateStatus &updateStatus)
 UpdaterImpl::UpdaterImpl(const std::filesystem::path &workingDirectory)
     : workingDirectory(workingDirectory),
       updateStatusCacheFile(workingDirectory / "updateStatus.json"),
-      githubResponseHeaderFilename(workingDirectory / "githubHeaders.json")
+      githubResponseHeaderFilename(workingDirectory / "githubHeaders.json"),
+      githubReleasesCacheFilename(workingDirectory / "githubReleases.json")
 {
     this->githubResponseHeaders.Load(githubResponseHeaderFilename);
     cachedUpdateStatus = GetCachedUpdateStatus();
@@ -351,29 +362,28 @@ void UpdaterImpl::ThreadProc()
     }
 }
 
-GithubAsset::GithubAsset(json_variant &v)
-{
-    auto o = v.as_object();
-    this->name = o->at("name").as_string();
-    this->browser_download_url = o->at("browser_download_url").as_string();
-    this->updated_at = o->at("updated_at").as_string();
-}
-GithubRelease::GithubRelease(json_variant &v)
-{
-    auto o = v.as_object();
-    this->name = o->at("name").as_string();
-    this->draft = o->at("draft").as_bool();
-    this->prerelease = o->at("prerelease").as_bool();
-    this->body = o->at("body").as_string();
+JSON_MAP_BEGIN(GithubAsset)
+json_map::reference("name", &GithubAsset::name),
+json_map::reference("browser_download_url", &GithubAsset::browser_download_url),
+JSON_MAP_END();
 
-    auto assets = o->at("assets").as_array();
-    for (size_t i = 0; i < assets->size(); ++i)
-    {
-        auto &el = assets->at(i);
-        this->assets.push_back(GithubAsset(el));
-    }
-    this->published_at = o->at("published_at").as_string();
-}
+JSON_MAP_BEGIN(GithubRelease)
+json_map::reference("draft", &GithubRelease::draft),
+json_map::reference("prerelease", &GithubRelease::prerelease),
+json_map::reference("name", &GithubRelease::name),
+json_map::reference("assets", &GithubRelease::assets),
+json_map::reference("published_at", &GithubRelease::published_at),
+JSON_MAP_END();
+
+class GithubErrorResponse
+{
+public:
+    std::string message_ = "Unknown error.";
+    DECLARE_JSON_MAP(GithubErrorResponse);
+};
+JSON_MAP_BEGIN(GithubErrorResponse)
+JSON_MAP_REFERENCE(GithubErrorResponse, message)
+JSON_MAP_END();
 
 
 
@@ -503,6 +513,18 @@ UpdateRelease UpdaterImpl::getUpdateRelease(
         updateRelease.assetName_ = asset->name;
         updateRelease.updateUrl_ = asset->browser_download_url;
         updateRelease.gpgSignatureUrl_ = pgpKey->browser_download_url;
+
+        auto *delta = githubRelease.GetDeltaForAsset(asset->name, currentVersion);
+        if (delta)
+        {
+            auto *deltaPgpKey = githubRelease.GetGpgKeyForAsset(delta->name);
+            if (deltaPgpKey)
+            {
+                updateRelease.deltaFromVersion_ = currentVersion;
+                updateRelease.deltaUrl_ = delta->browser_download_url;
+                updateRelease.deltaGpgSignatureUrl_ = deltaPgpKey->browser_download_url;
+            }
+        }
         return updateRelease;
     }
     return UpdateRelease();
@@ -560,6 +582,8 @@ JSON_MAP_REFERENCE(GithubResponseHeaders, ratelimit_limit)
 JSON_MAP_REFERENCE(GithubResponseHeaders, ratelimit_remaining)
 JSON_MAP_REFERENCE(GithubResponseHeaders, ratelimit_used)
 JSON_MAP_REFERENCE(GithubResponseHeaders, ratelimit_resource)
+JSON_MAP_REFERENCE(GithubResponseHeaders, etag)
+JSON_MAP_REFERENCE(GithubResponseHeaders, last_modified)
 JSON_MAP_END();
 
 void GithubResponseHeaders::Load(const std::filesystem::path &FILENAME)
@@ -629,6 +653,8 @@ GithubResponseHeaders::GithubResponseHeaders(const std::filesystem::path path)
         if (pos != std::string::npos)
         {
             std::string tag = line.substr(0, pos);
+            // HTTP/1.1 header names aren't lower-case.
+            std::transform(tag.begin(), tag.end(), tag.begin(), [](unsigned char c) { return (char)std::tolower(c); });
             ++pos;
             while (pos < line.length() && line[pos] == ' ')
             {
@@ -664,6 +690,14 @@ GithubResponseHeaders::GithubResponseHeaders(const std::filesystem::path path)
             {
                 pResult = &ratelimit_used_;
             }
+            else if (tag == "etag")
+            {
+                etag_ = value;
+            }
+            else if (tag == "last-modified")
+            {
+                last_modified_ = value;
+            }
             if (pResult)
             {
                 std::istringstream ss{value};
@@ -734,6 +768,60 @@ void UpdaterImpl::CheckForUpdate(bool useCache)
     }
 }
 
+static std::string ConditionalRequestHeaders(const GithubResponseHeaders &headers)
+{
+    // (validators are single-quoted for the shell, so don't use one that contains a single quote)
+    std::string result;
+    if (!headers.etag_.empty() && headers.etag_.find('\'') == std::string::npos)
+    {
+        result += SS(" -H 'If-None-Match: " << headers.etag_ << "'");
+    }
+    if (!headers.last_modified_.empty() && headers.last_modified_.find('\'') == std::string::npos)
+    {
+        result += SS(" -H 'If-Modified-Since: " << headers.last_modified_ << "'");
+    }
+    return result;
+}
+
+UpdaterImpl::clock::duration UpdaterImpl::GetPollingInterval(const GithubResponseHeaders &headers)
+{
+    // The unauthenticated rate limit is shared by every device behind the same NAT address.
+    // Poll less often as it gets used up, and add some jitter so that devices that started
+    // at the same time don't all poll at the same time.
+    using namespace std::chrono;
+    clock::duration interval = duration_cast<clock::duration>(hours(8));
+    if (headers.ratelimit_limit_ != 0)
+    {
+        if (headers.ratelimit_remaining_ < headers.ratelimit_limit_ / 4)
+        {
+            interval = duration_cast<clock::duration>(hours(20));
+        }
+        else if (headers.ratelimit_remaining_ < headers.ratelimit_limit_ / 2)
+        {
+            interval = duration_cast<clock::duration>(hours(12));
+        }
+    }
+    static std::minstd_rand random{std::random_device{}()};
+    std::uniform_int_distribution<int> jitterMinutes{0, 59};
+    return interval + duration_cast<clock::duration>(minutes(jitterMinutes(random)));
+}
+
+void UpdaterImpl::SaveCachedReleases(const std::vector<GithubRelease> &releases)
+{
+    try
+    {
+        pipedal::ofstream_synced f{githubReleasesCacheFilename};
+        json_writer writer{f};
+        writer.write(releases);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("Unable to write cached github releases. " << e.what()));
+        std::error_code ec;
+        fs::remove(githubReleasesCacheFilename, ec);
+    }
+}
+
 UpdateStatus UpdaterImpl::DoUpdate(bool forReleaseGenerator)
 {
     UpdateStatus updateResult;
@@ -753,6 +841,14 @@ UpdateStatus UpdaterImpl::DoUpdate(bool forReleaseGenerator)
     TemporaryFile headerFile{workingDirectory};
     std::string args = SS("-s -L " << GITHUB_RELEASES_URL << " -D " << headerFile.str());
 
+    // Conditional request, if we have the releases from the last request. Github doesn't count
+    // "304 Not Modified" responses against the rate limit.
+    bool haveCachedReleases = fs::exists(githubReleasesCacheFilename);
+    if (haveCachedReleases)
+    {
+        args += ConditionalRequestHeaders(this->githubResponseHeaders);
+    }
+
     updateResult.errorMessage_ = "";
 
     auto result = sysExecForOutput("curl", args);
@@ -763,60 +859,73 @@ UpdateStatus UpdaterImpl::DoUpdate(bool forReleaseGenerator)
     }
     else
     {
-        // hard throttling for github.
-        RetryAfter(std::chrono::duration_cast<clock::duration>(std::chrono::hours(8)));
-
         GithubResponseHeaders githubHeaders{headerFile.Path()};
+        if (githubHeaders.code_ == 304 && githubHeaders.etag_.empty())
+        {
+            githubHeaders.etag_ = this->githubResponseHeaders.etag_;
+            githubHeaders.last_modified_ = this->githubResponseHeaders.last_modified_;
+        }
         this->githubResponseHeaders = githubHeaders;
         this->githubResponseHeaders.Save(githubResponseHeaderFilename);
 
-        if (githubHeaders.code_ != 200)
+        // hard throttling for github.
+        RetryAfter(GetPollingInterval(githubHeaders));
+
+        std::vector<GithubRelease> releases;
+        if (githubHeaders.code_ == 304 && haveCachedReleases)
         {
-            if (
-                githubHeaders.ratelimit_limit_ != 0 &&
-                githubHeaders.ratelimit_limit_ == githubHeaders.ratelimit_used_)
+            Lv2Log::info("Updater: releases have not changed.");
+            try
             {
-                std::time_t time = std::chrono::system_clock::to_time_t(githubHeaders.ratelimit_reset_);
-                std::string strTime = std::ctime(&time);
-
-                this->RetryAfter(githubHeaders.ratelimit_reset_ - githubHeaders.date_);
-                throw std::runtime_error(SS("Github API rate limit exceeded. Retrying at " << strTime));
+                std::ifstream f{githubReleasesCacheFilename};
+                json_reader reader(f);
+                reader.read(&releases);
             }
-        }
-
-        if (result.output.length() == 0)
-        {
-            throw std::runtime_error("Server has no internet access.");
-        }
-        std::stringstream ss(result.output);
-        json_reader reader(ss);
-        json_variant vResult(reader);
-
-        if (vResult.is_object())
-        {
-            // an HTML error.
-            updateResult.isOnline_ = false;
-            auto o = vResult.as_object();
-            std::string message = "Unknown error.";
-            if (o->at("message").is_string())
+            catch (const std::exception &e)
             {
-                message = o->at("message").as_string();
+                fs::remove(githubReleasesCacheFilename); // make an unconditional request next time.
+                throw std::runtime_error(SS("Invalid cached releases. " << e.what()));
             }
-            throw std::runtime_error(SS("Github Service error: " << message));
-        }
-        else if (!vResult.is_array())
-        {
-            throw std::runtime_error("Invalid file format error.");
         }
         else
         {
-            json_variant::array_ptr vArray = vResult.as_array();
+            if (githubHeaders.code_ != 200)
+            {
+                if (
+                    githubHeaders.ratelimit_limit_ != 0 &&
+                    githubHeaders.ratelimit_limit_ == githubHeaders.ratelimit_used_)
+                {
+                    std::time_t time = std::chrono::system_clock::to_time_t(githubHeaders.ratelimit_reset_);
+                    std::string strTime = std::ctime(&time);
+
+                    this->RetryAfter(githubHeaders.ratelimit_reset_ - githubHeaders.date_);
+                    throw std::runtime_error(SS("Github API rate limit exceeded. Retrying at " << strTime));
+                }
+            }
+
+            if (result.output.length() == 0)
+            {
+                throw std::runtime_error("Server has no internet access.");
+            }
+            std::stringstream ss(result.output);
+            json_reader reader(ss);
 
-            std::vector<GithubRelease> releases;
-            for (size_t i = 0; i < vArray->size(); ++i)
+            if (reader.peek() == '{')
+            {
+                // an HTML error.
+                updateResult.isOnline_ = false;
+                GithubErrorResponse errorResponse;
+                reader.read(&errorResponse);
+                throw std::runtime_error(SS("Github Service error: " << errorResponse.message_));
+            }
+            else if (reader.peek() != '[')
+            {
+                throw std::runtime_error("Invalid file format error.");
+            }
+            std::vector<GithubRelease> allReleases;
+            reader.read(&allReleases);
+            for (auto &release : allReleases)
             {
-                auto &el = vArray->at(i);
-                GithubRelease release{el};
                 if (!release.draft && release.GetDownloadForCurrentArchitecture() != nullptr)
                 {
                     if (release.name.find("Experimental") == std::string::npos) // experimental releases do not participate in auto-updates (not even for dev stream)
@@ -825,47 +934,48 @@ UpdateStatus UpdaterImpl::DoUpdate(bool forReleaseGenerator)
                     }
                 }
             }
-            std::sort(
-                releases.begin(),
-                releases.end(),
-                [](const GithubRelease &left, const GithubRelease &right)
-                {
-                    return left.published_at > right.published_at; // latest date first.
-                });
-            updateResult.releaseOnlyRelease_ = getUpdateRelease(
-                releases,
-                updateResult.currentVersion_,
-                [](const GithubRelease &githubRelease)
-                {
-                    return !githubRelease.prerelease &&
-                           githubRelease.name.find("Release") != std::string::npos;
-                });
-
-            updateResult.releaseOrBetaRelease_ = getUpdateRelease(
-                releases,
-                updateResult.currentVersion_,
-                [](const GithubRelease &githubRelease)
-                {
-                    return !githubRelease.prerelease &&
-                           (githubRelease.name.find("Release") != std::string::npos ||
-                            githubRelease.name.find("Beta") != std::string::npos);
-                });
-            updateResult.devRelease_ = getUpdateRelease(
-                releases,
-                updateResult.currentVersion_,
-                [](const GithubRelease &githubRelease)
-                {
-                    return true;
-                });
+            SaveCachedReleases(releases);
+        }
+        std::sort(
+            releases.begin(),
+            releases.end(),
+            [](const GithubRelease &left, const GithubRelease &right)
+            {
+                return left.published_at > right.published_at; // latest date first.
+            });
+        updateResult.releaseOnlyRelease_ = getUpdateRelease(
+            releases,
+            updateResult.currentVersion_,
+            [](const GithubRelease &githubRelease)
+            {
+                return !githubRelease.prerelease &&
+                       githubRelease.name.find("Release") != std::string::npos;
+            });
+
+        updateResult.releaseOrBetaRelease_ = getUpdateRelease(
+            releases,
+            updateResult.currentVersion_,
+            [](const GithubRelease &githubRelease)
+            {
+                return !githubRelease.prerelease &&
+                       (githubRelease.name.find("Release") != std::string::npos ||
+                        githubRelease.name.find("Beta") != std::string::npos);
+            });
+        updateResult.devRelease_ = getUpdateRelease(
+            releases,
+            updateResult.currentVersion_,
+            [](const GithubRelease &githubRelease)
+            {
+                return true;
+            });
 #ifdef TEST_UPDATE
-            updateResult.releaseOrBetaRelease_.upgradeVersionDisplayName_ = "PiPedal v1.2.41-Beta";
-            updateResult.devRelease_.upgradeVersionDisplayName_ = "PiPedal v1.2.39-Experimental";
-            updateResult.devRelease_.upgradeVersion_ = "1.2.39";
-            updateResult.devRelease_.updateAvailable_ = false;
+        updateResult.releaseOrBetaRelease_.upgradeVersionDisplayName_ = "PiPedal v1.2.41-Beta";
+        updateResult.devRelease_.upgradeVersionDisplayName_ = "PiPedal v1.2.39-Experimental";
+        updateResult.devRelease_.upgradeVersion_ = "1.2.39";
+        updateResult.devRelease_.updateAvailable_ = false;
 #endif
-            updateResult.isValid_ = true;
-            updateResult.isOnline_ = true;
-        }
+        updateResult.isValid_ = true;
+        updateResult.isOnline_ = true;
     }
     return updateResult;
 }
@@ -875,7 +985,9 @@ bool UpdateRelease::operator==(const UpdateRelease &other) const
            (upgradeVersion_ == other.upgradeVersion_) &&
            (upgradeVersionDisplayName_ == other.upgradeVersionDisplayName_) &&
            (assetName_ == other.assetName_) &&
-           (updateUrl_ == other.updateUrl_);
+           (updateUrl_ == other.updateUrl_) &&
+           (deltaFromVersion_ == other.deltaFromVersion_) &&
+           (deltaUrl_ == other.deltaUrl_);
 }
 
 bool UpdateStatus::operator==(const UpdateStatus &other) const
@@ -969,6 +1081,19 @@ const GithubAsset *GithubRelease::GetGpgKeyForAsset(const std::string &name) con
     }
     return nullptr;
 }
+const GithubAsset *GithubRelease::GetDeltaForAsset(const std::string &name, const std::string &fromVersion) const
+{
+    std::string targetName = SS(name << ".from_" << fromVersion << ".zstpatch");
+
+    for (auto &asset : assets)
+    {
+        if (asset.name == targetName)
+        {
+            return &asset;
+        }
+    }
+    return nullptr;
+}
 const GithubAsset *GithubRelease::GetDownloadForCurrentArchitecture() const
 {
     // deb package names end in {DEBIAN_ARCHITECTURE}.deb
@@ -1026,6 +1151,23 @@ std::string UpdaterImpl::GetUpdateFilename(const std::string &url)
     }
     throw std::runtime_error("Permission denied. Invalid url.");
 }
+
+UpdateRelease UpdaterImpl::GetUpdateRelease(const std::string &url)
+{
+    if (this->currentResult.releaseOnlyRelease_.UpdateUrl() == url)
+    {
+        return this->currentResult.releaseOnlyRelease_;
+    }
+    if (this->currentResult.releaseOrBetaRelease_.UpdateUrl() == url)
+    {
+        return this->currentResult.releaseOrBetaRelease_;
+    }
+    if (this->currentResult.devRelease_.UpdateUrl() == url)
+    {
+        return this->currentResult.devRelease_;
+    }
+    throw std::runtime_error("Permission denied. Invalid url.");
+}
 static std::string unCRLF(const std::string &text)
 {
     std::ostringstream ss;
@@ -1205,7 +1347,7 @@ static void checkCurlHttpResponse(std::string errorCode)
     {
         throw std::runtime_error(SS("Download failed. Invalid curl response: " << errorCode));
     }
-    if (code == 200)
+    if (code == 200 || code == 206) // 206: a resumed (partial content) download.
     {
         return;
     }
@@ -1219,6 +1361,45 @@ static void checkCurlHttpResponse(std::string errorCode)
         throw std::runtime_error(message);
     }
 }
+static constexpr int CURL_RANGE_ERROR = 33; // the server doesn't support byte ranges.
+
+// Download url to path. Data is written to path.part, which is kept if the download is interrupted,
+// so that the next attempt resumes where this one left off (with an HTTP Range request) instead
+// of starting over.
+static void resumableDownload(const std::string &url, const std::filesystem::path &path)
+{
+    fs::path partPath = path.string() + ".part";
+
+    const std::string responseOption = "-w \"%{response_code}\"";
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        std::string args = SS(
+            "-s -L " << responseOption
+                     << " --retry 3 --limit-rate " << UPDATE_DOWNLOAD_RATE_LIMIT
+                     << " -C - " << url << " -o " << partPath.c_str());
+        auto curlOutput = sysExecForOutput("/usr/bin/curl", args);
+        std::string responseCode = unCRLF(curlOutput.output);
+        bool rangeError =
+            (WIFEXITED(curlOutput.exitCode) && WEXITSTATUS(curlOutput.exitCode) == CURL_RANGE_ERROR) ||
+            responseCode == "416";
+        if (rangeError && attempt == 0)
+        {
+            // The partial file can't be resumed (it's stale, or the server doesn't do ranges). Start over.
+            Lv2Log::info(SS("Can't resume download of " << url << ". Restarting."));
+            fs::remove(partPath);
+            continue;
+        }
+        if (curlOutput.exitCode != EXIT_SUCCESS || badOutput(partPath))
+        {
+            Lv2Log::error(SS("Update download failed. " << responseCode));
+            throw std::runtime_error("PiPedal server does not have access to the internet.");
+        }
+        checkCurlHttpResponse(responseCode);
+        fs::rename(partPath, path);
+        return;
+    }
+}
+
 void UpdaterImpl::RetryAfter(clock::duration delay)
 {
     namespace chron = std::chrono;
@@ -1275,13 +1456,81 @@ UpdaterImpl::clock::time_point UpdaterImpl::LoadRetryTime()
     return clock::now();
 }
 
+// Reconstruct the update package from the package of the currently installed version (kept in the
+// downloads directory from the previous update) and a much smaller binary patch. Returns false if
+// there's no usable delta, in which case the caller downloads the full package.
+bool UpdaterImpl::DownloadDelta(
+    const UpdateRelease &release,
+    const std::filesystem::path &downloadFilePath,
+    const std::filesystem::path &downloadSignaturePath)
+{
+    if (release.DeltaUrl().empty() || release.DeltaFromVersion() != UpdateStatus().CurrentVersion())
+    {
+        return false;
+    }
+    if (!WhitelistDownloadUrl(release.DeltaUrl()) || !WhitelistDownloadUrl(release.DeltaGpgSignatureUrl()))
+    {
+        return false;
+    }
+    if (!fs::exists("/usr/bin/zstd"))
+    {
+        return false;
+    }
+    auto downloadDirectory = downloadFilePath.parent_path();
+    fs::path basePath = downloadDirectory / SS("pipedal_" << release.DeltaFromVersion() << "_" << (DEBIAN_ARCHITECTURE) << ".deb");
+    fs::path baseSignaturePath = SS(basePath.string() << ".asc");
+    if (!fs::exists(basePath) || !fs::exists(baseSignaturePath))
+    {
+        return false;
+    }
+    fs::path deltaPath = SS(downloadFilePath.string() << ".zstpatch");
+    fs::path deltaSignaturePath = SS(deltaPath.string() << ".asc");
+    try
+    {
+        ValidateSignature(basePath, baseSignaturePath);
+
+        resumableDownload(release.DeltaUrl(), deltaPath);
+        resumableDownload(release.DeltaGpgSignatureUrl(), deltaSignaturePath);
+        // don't feed anything we don't trust to zstd.
+        ValidateSignature(deltaPath, deltaSignaturePath);
+
+        std::string args = SS(
+            "-d -q -f --long=31 --patch-from=" << basePath.c_str()
+                                               << " " << deltaPath.c_str()
+                                               << " -o " << downloadFilePath.c_str());
+        auto zstdOutput = sysExecForOutput("/usr/bin/zstd", args);
+        if (zstdOutput.exitCode != EXIT_SUCCESS || badOutput(downloadFilePath))
+        {
+            throw std::runtime_error(SS("Can't apply update patch. " << zstdOutput.output));
+        }
+        resumableDownload(release.GpgSignatureUrl(), downloadSignaturePath);
+
+        // The reconstructed package must carry the same signature as the full package would.
+        ValidateSignature(downloadFilePath, downloadSignaturePath);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::info(SS("Delta update failed. Downloading the full package. " << e.what()));
+        fs::remove(deltaPath);
+        fs::remove(deltaSignaturePath);
+        fs::remove(downloadFilePath);
+        fs::remove(downloadSignaturePath);
+        return false;
+    }
+    fs::remove(deltaPath);
+    fs::remove(deltaSignaturePath);
+    return true;
+}
+
 void UpdaterImpl::DownloadUpdate(const std::string &url, std::filesystem::path *file, std::filesystem::path *signatureFile)
 {
     std::string filename, signatureUrl;
+    UpdateRelease release;
     {
         std::lock_guard lock{mutex};
         filename = GetUpdateFilename(url);
         signatureUrl = GetSignatureUrl(url);
+        release = GetUpdateRelease(url);
     }
 
     // Only permit downloading of updates from the github releases for the pipedal project.
@@ -1301,33 +1550,32 @@ void UpdaterImpl::DownloadUpdate(const std::string &url, std::filesystem::path *
     auto downloadFilePath = downloadDirectory / filename;
     auto downloadSignaturePath = downloadDirectory / SS(filename << ".asc");
 
-    try
+    if (fs::exists(downloadFilePath) && fs::exists(downloadSignaturePath))
     {
-        fs::remove(downloadFilePath);
-        fs::remove(downloadSignaturePath);
-
-        const std::string responseOption = "-w \"%{response_code}\"";
-#ifdef WIN32
-        responseOption = "-w \"%%{response_code}\""; // windows shell requires doubling of the %%.
-#endif
-        std::string args = SS("-s -L " << responseOption << " " << url << " -o " << downloadFilePath.c_str());
-        auto curlOutput = sysExecForOutput("/usr/bin/curl", args);
-        if (curlOutput.exitCode != EXIT_SUCCESS || badOutput(downloadFilePath))
+        // Downloaded previously (e.g. the install was cancelled). Don't fetch it again if it's still good.
+        try
         {
-            Lv2Log::error(SS("Update download failed. " << unCRLF(curlOutput.output)));
-            throw std::runtime_error("PiPedal server does not have access to the internet.");
+            ValidateSignature(downloadFilePath, downloadSignaturePath);
+            *file = downloadFilePath;
+            *signatureFile = downloadSignaturePath;
+            return;
         }
-        checkCurlHttpResponse(curlOutput.output);
+        catch (const std::exception &e)
+        {
+            Lv2Log::info(SS("Downloading update again. " << e.what()));
+        }
+    }
 
-        args = SS("-s -L " << responseOption << " " << signatureUrl << " -o " << downloadSignaturePath.c_str());
+    try
+    {
+        fs::remove(downloadFilePath);
+        fs::remove(downloadSignaturePath);
 
-        curlOutput = sysExecForOutput("/usr/bin/curl", args);
-        if (curlOutput.exitCode != EXIT_SUCCESS || badOutput(downloadSignaturePath))
+        if (!DownloadDelta(release, downloadFilePath, downloadSignaturePath))
         {
-            Lv2Log::error(SS("Update download failed. " << unCRLF(curlOutput.output)));
-            throw std::runtime_error("PiPedal server does not have access to the internet.");
+            resumableDownload(url, downloadFilePath);
+            resumableDownload(signatureUrl, downloadSignaturePath);
         }
-        checkCurlHttpResponse(curlOutput.output);
 
         try
         {
@@ -1379,6 +1627,9 @@ JSON_MAP_REFERENCE(UpdateRelease, upgradeVersionDisplayName)
 JSON_MAP_REFERENCE(UpdateRelease, assetName)
 JSON_MAP_REFERENCE(UpdateRelease, updateUrl)
 JSON_MAP_REFERENCE(UpdateRelease, gpgSignatureUrl)
+JSON_MAP_REFERENCE(UpdateRelease, deltaFromVersion)
+JSON_MAP_REFERENCE(UpdateRelease, deltaUrl)
+JSON_MAP_REFERENCE(UpdateRelease, deltaGpgSignatureUrl)
 JSON_MAP_END();
 
 JSON_MAP_BEGIN(UpdateStatus)
@@ -66,6 +66,12 @@
 
 #define PGP_UPDATE_KEYRING_PATH "/var/pipedal/config/gpg"
 
+// Maximum download rate for updates (curl --limit-rate syntax), so that downloads
+// don't starve clients connected to the PiPedal hotspot.
+#ifndef UPDATE_DOWNLOAD_RATE_LIMIT
+#define UPDATE_DOWNLOAD_RATE_LIMIT "2M"
+#endif
+
 inline bool WhitelistDownloadUrl(const std::string &downloadUrl)
 {
     return downloadUrl.starts_with(GITHUB_DOWNLOAD_PREFIX);
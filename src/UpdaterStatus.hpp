@@ -46,6 +46,9 @@ namespace pipedal {
         std::string assetName_;                 // filename only
         std::string updateUrl_;                 // url from which to download the .deb file.
         std::string gpgSignatureUrl_;                 // url from which to download the .deb.asc file.
+        std::string deltaFromVersion_;          // installed version the delta patch applies to. Empty if there's no delta.
+        std::string deltaUrl_;                  // url from which to download the delta patch.
+        std::string deltaGpgSignatureUrl_;      // url from which to download the delta patch's .asc file.
         void UpdateForCurrentVersion(const std::string&currentVersion);
     public:
 
@@ -55,6 +58,9 @@ namespace pipedal {
         const std::string &AssetName() const { return assetName_; }
         const std::string &UpdateUrl() const { return updateUrl_; }
         const std::string &GpgSignatureUrl() const { return gpgSignatureUrl_;}
+        const std::string &DeltaFromVersion() const { return deltaFromVersion_; }
+        const std::string &DeltaUrl() const { return deltaUrl_; }
+        const std::string &DeltaGpgSignatureUrl() const { return deltaGpgSignatureUrl_; }
         bool operator==(const UpdateRelease &other) const;
         DECLARE_JSON_MAP(UpdateRelease);
     };
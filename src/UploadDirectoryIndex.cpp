@@ -0,0 +1,276 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "UploadDirectoryIndex.hpp"
+#include "Lv2Log.hpp"
+#include "util.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+UploadDirectoryIndex::UploadDirectoryIndex(const fs::path &rootDirectory, SortKeyFunction &&getSortKey)
+    : rootDirectory(rootDirectory.lexically_normal()), getSortKey(std::move(getSortKey))
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd == -1)
+    {
+        Lv2Log::warning("UploadDirectoryIndex: Failed to initialize inotify. Directory listings will not be cached.");
+    }
+}
+
+UploadDirectoryIndex::~UploadDirectoryIndex()
+{
+    if (inotifyFd != -1)
+    {
+        close(inotifyFd); // (removes all watches)
+        inotifyFd = -1;
+    }
+}
+
+bool UploadDirectoryIndex::ReadEntry(const fs::path &path, Entry *entry)
+{
+    std::error_code ec;
+    fs::file_status linkStatus = fs::symlink_status(path, ec);
+    if (ec || !fs::exists(linkStatus))
+    {
+        return false;
+    }
+    entry->name = path.filename().string();
+    entry->isSymlink = fs::is_symlink(linkStatus);
+    fs::file_status status = entry->isSymlink ? fs::status(path, ec) : linkStatus;
+    entry->isDirectory = !ec && fs::is_directory(status);
+    entry->isRegularFile = !ec && fs::is_regular_file(status);
+    entry->sortKey = getSortKey ? getSortKey(entry->name) : std::string();
+    return true;
+}
+
+std::vector<UploadDirectoryIndex::Entry> UploadDirectoryIndex::ReadDirectory(const fs::path &directory)
+{
+    std::vector<Entry> result;
+    for (const auto &dirEntry : fs::directory_iterator(directory))
+    {
+        Entry entry;
+        entry.name = dirEntry.path().filename().string();
+        std::error_code ec;
+        entry.isSymlink = dirEntry.is_symlink(ec);
+        entry.isDirectory = dirEntry.is_directory(ec);
+        entry.isRegularFile = dirEntry.is_regular_file(ec);
+        if (getSortKey)
+        {
+            entry.sortKey = getSortKey(entry.name);
+        }
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+std::vector<UploadDirectoryIndex::Entry> UploadDirectoryIndex::GetEntries(const fs::path &directory_)
+{
+    fs::path directory = directory_.lexically_normal();
+    if (!directory.has_filename() && directory.has_parent_path())
+    {
+        directory = directory.parent_path(); // (trailing '/')
+    }
+    if (inotifyFd == -1 || !IsSubdirectory(directory, rootDirectory))
+    {
+        return ReadDirectory(directory);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    ProcessEvents();
+
+    auto ff = directories.find(directory);
+    if (ff != directories.end())
+    {
+        return ff->second.entries;
+    }
+    if (watches.size() >= MAX_WATCHES)
+    {
+        return ReadDirectory(directory);
+    }
+    // Watch first, then read, so that no change is missed. Events for changes that the read already saw
+    // are harmless, since applying them is idempotent.
+    int watch = inotify_add_watch(inotifyFd, directory.c_str(), WATCH_MASK);
+    if (watch == -1)
+    {
+        return ReadDirectory(directory);
+    }
+    if (watches.contains(watch))
+    {
+        // The same directory, reached through a symlink. Cache it under one path only.
+        return ReadDirectory(directory);
+    }
+    std::vector<Entry> entries;
+    try
+    {
+        entries = ReadDirectory(directory);
+    }
+    catch (const std::exception &)
+    {
+        inotify_rm_watch(inotifyFd, watch);
+        throw;
+    }
+    watches[watch] = directory;
+    Directory &cached = directories[directory];
+    cached.watch = watch;
+    cached.entries = entries;
+    return entries;
+}
+
+void UploadDirectoryIndex::UpdateEntry(Directory &directory, const fs::path &path)
+{
+    std::string name = path.filename().string();
+    auto ff = std::find_if(directory.entries.begin(), directory.entries.end(),
+                           [&name](const Entry &entry)
+                           { return entry.name == name; });
+    Entry entry;
+    if (ReadEntry(path, &entry))
+    {
+        if (ff == directory.entries.end())
+        {
+            directory.entries.push_back(std::move(entry));
+        }
+        else
+        {
+            *ff = std::move(entry);
+        }
+    }
+    else if (ff != directory.entries.end())
+    {
+        directory.entries.erase(ff);
+    }
+}
+
+void UploadDirectoryIndex::RemoveDirectory(const fs::path &directory, bool removeWatch)
+{
+    auto ff = directories.find(directory);
+    if (ff == directories.end())
+    {
+        return;
+    }
+    if (removeWatch)
+    {
+        inotify_rm_watch(inotifyFd, ff->second.watch);
+    }
+    watches.erase(ff->second.watch);
+    directories.erase(ff);
+}
+
+void UploadDirectoryIndex::RemoveSubtree(const fs::path &directory)
+{
+    // Cached listings are keyed by path, so listings for a directory that was moved or deleted, and
+    // for all of its subdirectories, are no longer valid.
+    auto i = directories.lower_bound(directory);
+    while (i != directories.end() && IsSubdirectory(i->first, directory))
+    {
+        auto next = std::next(i);
+        RemoveDirectory(i->first, true);
+        i = next;
+    }
+}
+
+void UploadDirectoryIndex::ProcessEvents()
+{
+    alignas(struct inotify_event) char buffer[16384];
+    while (true)
+    {
+        ssize_t nRead = read(inotifyFd, buffer, sizeof(buffer));
+        if (nRead <= 0)
+        {
+            if (nRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break; // EAGAIN: no more events.
+        }
+        for (ssize_t i = 0; i < nRead;)
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buffer + i);
+            i += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                // events were lost.
+                ClearLocked();
+                continue;
+            }
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end())
+            {
+                continue;
+            }
+            fs::path directoryPath = watch->second;
+            if (event->mask & IN_IGNORED)
+            {
+                // the watch was removed by the kernel.
+                RemoveDirectory(directoryPath, false);
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT))
+            {
+                RemoveSubtree(directoryPath);
+                continue;
+            }
+            if (event->len == 0)
+            {
+                continue;
+            }
+            fs::path childPath = directoryPath / event->name;
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)))
+            {
+                RemoveSubtree(childPath);
+            }
+            auto directory = directories.find(directoryPath);
+            if (directory != directories.end())
+            {
+                UpdateEntry(directory->second, childPath);
+            }
+        }
+    }
+}
+
+void UploadDirectoryIndex::ClearLocked()
+{
+    for (const auto &watch : watches)
+    {
+        inotify_rm_watch(inotifyFd, watch.first);
+    }
+    watches.clear();
+    directories.clear();
+}
+
+void UploadDirectoryIndex::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ClearLocked();
+}
+
+size_t UploadDirectoryIndex::CachedDirectoryCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ProcessEvents();
+    return directories.size();
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Cached directory listings for the plugin upload directory.
+     *
+     * A directory is read from disk the first time it is listed, and an inotify watch is placed on it.
+     * Subsequent listings are served from memory, after applying any pending inotify events to the cached
+     * listings. Events are drained synchronously on each call, so changes made by this process are always
+     * visible to the next listing.
+     *
+     * Directories outside the root, or that can't be watched, are read from disk on every call.
+     *
+     * Entries carry the collation sort key of their name (see Collator::GetSortKey()), generated once
+     * when the entry is read, rather than each time a listing is sorted.
+     */
+    class UploadDirectoryIndex
+    {
+    public:
+        using ptr = std::unique_ptr<UploadDirectoryIndex>;
+
+        struct Entry
+        {
+            std::string name;
+            bool isDirectory = false; // (following symlinks)
+            bool isRegularFile = false; // (following symlinks)
+            bool isSymlink = false;
+            std::string sortKey; // empty if there is no sort key function.
+        };
+        using SortKeyFunction = std::function<std::string(const std::string &name)>;
+
+        UploadDirectoryIndex(const std::filesystem::path &rootDirectory, SortKeyFunction &&getSortKey = nullptr);
+        ~UploadDirectoryIndex();
+        UploadDirectoryIndex(const UploadDirectoryIndex &) = delete;
+        UploadDirectoryIndex &operator=(const UploadDirectoryIndex &) = delete;
+
+        // The entries of a directory, in no particular order. Throws std::filesystem::filesystem_error
+        // if the directory can't be read.
+        std::vector<Entry> GetEntries(const std::filesystem::path &directory);
+
+        // Discards all cached listings.
+        void Clear();
+
+        size_t CachedDirectoryCount();
+
+    private:
+        struct Directory
+        {
+            int watch = -1;
+            std::vector<Entry> entries;
+        };
+
+        static constexpr size_t MAX_WATCHES = 4096;
+
+        void ProcessEvents();
+        void ClearLocked();
+        void RemoveDirectory(const std::filesystem::path &directory, bool removeWatch);
+        void RemoveSubtree(const std::filesystem::path &directory);
+        void UpdateEntry(Directory &directory, const std::filesystem::path &path);
+        std::vector<Entry> ReadDirectory(const std::filesystem::path &directory);
+        bool ReadEntry(const std::filesystem::path &path, Entry *entry);
+
+        std::filesystem::path rootDirectory;
+        SortKeyFunction getSortKey;
+        std::mutex mutex;
+        int inotifyFd = -1;
+        std::map<std::filesystem::path, Directory> directories;
+        std::map<int, std::filesystem::path> watches;
+    };
+}
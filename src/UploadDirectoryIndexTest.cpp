@@ -0,0 +1,108 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "UploadDirectoryIndex.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static bool HasEntry(const std::vector<UploadDirectoryIndex::Entry> &entries, const std::string &name, bool isDirectory = false)
+{
+    return std::any_of(entries.begin(), entries.end(),
+                       [&](const UploadDirectoryIndex::Entry &entry)
+                       { return entry.name == name && entry.isDirectory == isDirectory; });
+}
+
+TEST_CASE("UploadDirectoryIndex", "[upload_directory_index][Build][Dev]")
+{
+    fs::path root = fs::temp_directory_path() / "pipedal_upload_directory_index_test";
+    fs::remove_all(root);
+    fs::create_directories(root / "models" / "sub");
+    std::ofstream(root / "models" / "a.nam") << "a";
+
+    UploadDirectoryIndex index(root);
+
+    auto entries = index.GetEntries(root / "models");
+    REQUIRE(entries.size() == 2);
+    REQUIRE(HasEntry(entries, "a.nam"));
+    REQUIRE(HasEntry(entries, "sub", true));
+    REQUIRE(index.CachedDirectoryCount() == 1);
+    REQUIRE(index.GetEntries(root / "models/").size() == 2); // same listing.
+    REQUIRE(index.CachedDirectoryCount() == 1);
+
+    // changes are visible to the next listing.
+    std::ofstream(root / "models" / "b.nam") << "b";
+    fs::remove(root / "models" / "a.nam");
+    entries = index.GetEntries(root / "models");
+    REQUIRE(entries.size() == 2);
+    REQUIRE(HasEntry(entries, "b.nam"));
+    REQUIRE(!HasEntry(entries, "a.nam"));
+
+    fs::rename(root / "models" / "b.nam", root / "models" / "c.nam");
+    entries = index.GetEntries(root / "models");
+    REQUIRE(HasEntry(entries, "c.nam"));
+    REQUIRE(!HasEntry(entries, "b.nam"));
+
+    // listings of moved directories are discarded.
+    std::ofstream(root / "models" / "sub" / "d.nam") << "d";
+    REQUIRE(HasEntry(index.GetEntries(root / "models" / "sub"), "d.nam"));
+    REQUIRE(index.CachedDirectoryCount() == 2);
+    fs::rename(root / "models" / "sub", root / "models" / "sub2");
+    REQUIRE(index.CachedDirectoryCount() == 1);
+    entries = index.GetEntries(root / "models");
+    REQUIRE(HasEntry(entries, "sub2", true));
+    REQUIRE(!HasEntry(entries, "sub", true));
+    REQUIRE(HasEntry(index.GetEntries(root / "models" / "sub2"), "d.nam"));
+    REQUIRE_THROWS(index.GetEntries(root / "models" / "sub"));
+
+    fs::remove_all(root / "models");
+    REQUIRE(index.CachedDirectoryCount() == 0);
+    REQUIRE_THROWS(index.GetEntries(root / "models"));
+
+    fs::remove_all(root);
+}
+
+TEST_CASE("UploadDirectoryIndex sort keys", "[upload_directory_index][Build][Dev]")
+{
+    fs::path root = fs::temp_directory_path() / "pipedal_upload_directory_index_sort_test";
+    fs::remove_all(root);
+    fs::create_directories(root);
+    std::ofstream(root / "Abc.nam") << "a";
+
+    UploadDirectoryIndex index(root, [](const std::string &name)
+                               { return "key:" + name; });
+    auto entries = index.GetEntries(root);
+    REQUIRE(entries.size() == 1);
+    REQUIRE(entries[0].sortKey == "key:Abc.nam");
+
+    std::ofstream(root / "Def.nam") << "d";
+    entries = index.GetEntries(root);
+    REQUIRE(entries.size() == 2);
+    for (const auto &entry : entries)
+    {
+        REQUIRE(entry.sortKey == "key:" + entry.name);
+    }
+    fs::remove_all(root);
+}
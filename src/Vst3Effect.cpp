@@ -43,8 +43,6 @@
 #include "pluginterfaces/vst/ivstaudioprocessor.h"
 #include "pluginterfaces/vst/ivstunits.h"
 #include "public.sdk/source/vst/utility/stringconvert.h"
-#include "public.sdk/source/vst/hosting/eventlist.h"
-#include "public.sdk/source/vst/hosting/parameterchanges.h"
 #include "public.sdk/source/vst/hosting/processdata.h"
 #include "pluginterfaces/vst/ivstaudioprocessor.h"
 #include "pluginterfaces/vst/ivstmidicontrollers.h"
@@ -199,12 +197,9 @@ void Vst3EffectImpl::SetControl(int index, float value)
 	double normalizedValue = controller->plainParamToNormalized(paramId, value);
 	this->controller->setParamNormalized(paramId, normalizedValue);
 
-	{
-		RtInversionGuard inversionGuard; // boost priority to prevent priority inversion.
-		std::lock_guard guard{parameterMutex};
-
-		paramTransferrer.addChange(paramId, normalizedValue, 0);
-	}
+	// control changes arrive on the audio thread (from the realtime control ring), so they can go
+	// straight into the preallocated input queue. IEffect control changes don't carry a sample offset.
+	inputParameterChanges.addChange(paramId, normalizedValue, 0);
 	if (!isProcessing)
 	{
 		Run(0, nullptr); // pump parameter changes on UI thread.
@@ -223,8 +218,9 @@ void Vst3EffectImpl::Load(uint64_t instanceId, const Vst3PluginInfo &info, IHost
 
 	size_t nControls = info.pluginInfo_.controls().size();
 
-	inputParameterChanges.setMaxParameters(nControls);
-	outputParameterChanges.setMaxParameters(nControls);
+	// MIDI-mapped parameters may not be controls, so leave room for them too.
+	inputParameterChanges.setMaxParameters(nControls + kMaxExtraParameters);
+	outputParameterChanges.setMaxParameters(nControls + kMaxExtraParameters);
 
 	lv2ToVstParam.resize(nControls);
 	parameterValues.resize(nControls);
@@ -286,7 +282,6 @@ void Vst3EffectImpl::Load(uint64_t instanceId, const Vst3PluginInfo &info, IHost
 	this->controller = plugProvider->getController();
 	controller->queryInterface(IMidiMapping::iid, (void **)&midiMapping);
 
-	paramTransferrer.setMaxParameters(1000);
 	if (midiMapping)
 		midiCCMapping = initMidiCtrlerAssignment(component, midiMapping);
 
@@ -320,8 +315,6 @@ void Vst3EffectImpl::Load(uint64_t instanceId, const Vst3PluginInfo &info, IHost
 
 	controller->setComponentHandler(&componentHandler);
 
-	paramTransferrer.setMaxParameters(1000);
-
 	if (midiMapping)
 		midiCCMapping = initMidiCtrlerAssignment(component, midiMapping);
 
@@ -457,11 +450,7 @@ void Vst3EffectImpl::preprocess(Buffers &buffers, int64_t continousFrames)
 	processContext.continousTimeSamples = continousFrames;
 	assignBusBuffers(buffers, processData);
 
-	{
-		std::lock_guard guard{parameterMutex};
-
-		paramTransferrer.transferChangesTo(inputParameterChanges);
-	}
+	paramTransferrer.transferChangesTo(inputParameterChanges);
 	outputParameterChanges.clearQueue();
 }
 
@@ -558,10 +547,8 @@ bool Vst3EffectImpl::processVstEvent(const IMidiClient::Event &event, int32 port
 	if (vstEvent)
 	{
 		vstEvent->busIndex = port;
-		if (eventList.addEvent(*vstEvent) != kResultOk)
-		{
-			assert(false && "Event was not added to EventList!");
-		}
+		// (dropped if the preallocated event list is full.)
+		eventList.addEvent(*vstEvent);
 
 		return true;
 	}
@@ -587,12 +574,9 @@ bool Vst3EffectImpl::processParamChange(const IMidiClient::Event &event, int32 p
 		int32 index = 0;
 		IParamValueQueue *queue =
 			inputParameterChanges.addParameterData((*paramChange).first, index);
-		if (queue)
+		if (queue) // (points are dropped if the preallocated queues are full.)
 		{
-			if (queue->addPoint(event.timestamp, (*paramChange).second, index) != kResultOk)
-			{
-				assert(false && "Parameter point was not added to ParamValueQueue!");
-			}
+			queue->addPoint(event.timestamp, (*paramChange).second, index);
 		}
 
 		return true;
@@ -681,11 +665,6 @@ void Vst3EffectImpl::transferControllerStateToComponent()
 	OPtr<IRtStream> bStream = this->streamPool.AllocateBStream();
 	assert(GetRefCount(bStream.get()) == 1);
 
-	RtInversionGuard inversionGuard; // boost priority to prevent priority inversion.
-	std::lock_guard guard{parameterMutex};
-
-	paramTransferrer.removeChanges();
-
 	// assume that parameters are straightforward and uncomplicated if they
 	// didn't provide BStream-based state management
 	// Vst2 used to do this. It's not clear that this is still legal in Vst3.
@@ -694,8 +673,7 @@ void Vst3EffectImpl::transferControllerStateToComponent()
 	{
 		ParamID paramId = lv2ToVstParam[index];
 		paramTransferrer.addChange(paramId,
-									controller->plainParamToNormalized(paramId, parameterValues[index]),
-									0);
+									controller->plainParamToNormalized(paramId, parameterValues[index]));
 	}
 	if (!this->isProcessing)
 	{
@@ -25,11 +25,23 @@
 #include "ss.hpp"
 #include "PluginHost.hpp"
 #include "vst3/Vst3Host.hpp"
+#include "SandboxedEffect.hpp"
 #include "Lv2Log.hpp"
 #include <unordered_map>
 #include <set>
 #include <unordered_set>
 #include <filesystem>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <spawn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "public.sdk/source/vst/hosting/module.h"
 #include "public.sdk/source/vst/hosting/hostclasses.h"
 #include "public.sdk/source/vst/hosting/plugprovider.h"
@@ -58,6 +70,11 @@ using namespace VST3::Hosting;
 using namespace Steinberg;
 using namespace Steinberg::Vst;
 
+extern char **environ;
+
+// a module that takes longer than this to describe itself is assumed to have hung.
+static constexpr int VST3_SCAN_TIMEOUT_MS = 30000;
+
 namespace pipedal
 {
 
@@ -94,12 +111,18 @@ namespace pipedal
 		void LoadPluginCache();
 		void SavePluginCache();
 
-		bool havePluginsChanged() const;
+		using ModuleCache = std::vector<std::unique_ptr<Vst3ModuleCacheEntry>>;
+		ModuleCache moduleCache;
 		PluginList pluginList;
 
+		void UpdatePlugins(bool rescanAll);
+		void ScanModules(ModuleCache &entries);
+		static bool ScanModuleInHelper(Vst3ModuleCacheEntry &entry);
+
 		void EnsureContext();
 		std::unique_ptr<Vst3PluginInfo> MakeDetailedPluginInfo(const PluginFactory &factory, const ClassInfo &classInfo, const std::string &path);
 
+	public:
 		void MakeVst3Info(const std::filesystem::path &path, Vst3Host::PluginList &list);
 	};
 
@@ -505,63 +528,267 @@ void Vst3HostImpl::MakeVst3Info(const std::filesystem::path &path, Vst3Host::Plu
 	}
 }
 
-bool Vst3HostImpl::havePluginsChanged() const
+// Last-write time and size of a module. (.vst3 modules are usually bundle directories.)
+static void GetModuleStamp(const std::string &path, int64_t *lastWriteTime, uint64_t *size)
 {
-
-	std::unordered_set<std::string> modules;
-
-	for (const auto &plugin : pluginList)
+	namespace fs = std::filesystem;
+	*lastWriteTime = 0;
+	*size = 0;
+	std::error_code ec;
+	auto addFile = [&](const fs::path &file)
+	{
+		std::error_code fileEc;
+		int64_t t = fs::last_write_time(file, fileEc).time_since_epoch().count();
+		if (!fileEc)
+		{
+			*lastWriteTime = std::max(*lastWriteTime, t);
+		}
+		uintmax_t fileSize = fs::file_size(file, fileEc);
+		if (!fileEc)
+		{
+			*size += fileSize;
+		}
+	};
+	if (fs::is_directory(path, ec))
 	{
-		if (!std::filesystem::exists(plugin->filePath_))
+		for (auto it = fs::recursive_directory_iterator(path, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec))
 		{
-			return true;
+			if (it->is_regular_file(ec))
+			{
+				addFile(it->path());
+			}
 		}
-		modules.insert(plugin->filePath_);
 	}
-	Module::PathList pathList = Module::getModulePaths();
-
-	for (const auto &path : pathList)
+	else
 	{
-		if (!modules.contains(path))
+		addFile(path);
+	}
+}
+
+Vst3Host::PluginList Vst3Host::ScanModule(const std::string &modulePath)
+{
+	Vst3HostImpl host("");
+	PluginList result;
+	host.MakeVst3Info(std::filesystem::path(modulePath), result);
+	return result;
+}
+
+// Describe the module in a short-lived pipedal_sandbox process, so that a module that crashes or hangs
+// while loading doesn't take pipedald down with it.
+bool Vst3HostImpl::ScanModuleInHelper(Vst3ModuleCacheEntry &entry)
+{
+	std::string executable = SandboxedEffect::GetSandboxExecutablePath().string();
+	int fds[2];
+	if (pipe2(fds, O_CLOEXEC) != 0)
+	{
+		Lv2Log::error(SS("Vst3 scan: can't create pipe. " << strerror(errno)));
+		return false;
+	}
+	std::vector<const char *> argv{
+		executable.c_str(),
+		"--vst3-scan", entry.path_.c_str(),
+		nullptr};
+
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_adddup2(&fileActions, fds[1], STDOUT_FILENO);
+	pid_t pid = -1;
+	int rc = posix_spawn(&pid, executable.c_str(), &fileActions, nullptr, (char *const *)argv.data(), environ);
+	posix_spawn_file_actions_destroy(&fileActions);
+	close(fds[1]);
+	if (rc != 0)
+	{
+		close(fds[0]);
+		Lv2Log::error(SS("Vst3 scan: can't start " << executable << ". " << strerror(rc)));
+		return false;
+	}
+
+	std::string output;
+	bool timedOut = false;
+	char buffer[4096];
+	while (true)
+	{
+		pollfd pfd{fds[0], POLLIN, 0};
+		int nReady = poll(&pfd, 1, VST3_SCAN_TIMEOUT_MS);
+		if (nReady == 0)
 		{
-			return true;
+			timedOut = true;
+			kill(pid, SIGKILL);
+			break;
+		}
+		if (nReady < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
 		}
+		ssize_t nRead = read(fds[0], buffer, sizeof(buffer));
+		if (nRead < 0 && errno == EINTR)
+			continue;
+		if (nRead <= 0)
+			break;
+		output.append(buffer, (size_t)nRead);
 	}
-	return false;
+	close(fds[0]);
+
+	int status = 0;
+	while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+	{
+	}
+	if (timedOut)
+	{
+		Lv2Log::error(SS("Vst3 scan: " << entry.path_ << " timed out."));
+		return false;
+	}
+	if (WIFSIGNALED(status))
+	{
+		Lv2Log::error(SS("Vst3 scan: " << entry.path_ << " crashed (" << strsignal(WTERMSIG(status)) << ")."));
+		return false;
+	}
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+	{
+		Lv2Log::error(SS("Vst3 scan: " << entry.path_ << " failed to load."));
+		return false;
+	}
+	try
+	{
+		json_reader reader{std::string_view(output)};
+		reader.read(&entry.plugins_);
+	}
+	catch (const std::exception &e)
+	{
+		Lv2Log::error(SS("Vst3 scan: invalid response for " << entry.path_ << ". " << e.what()));
+		return false;
+	}
+	return true;
 }
 
-const Vst3Host::PluginList &Vst3HostImpl::RefreshPlugins()
+void Vst3HostImpl::ScanModules(ModuleCache &entries)
 {
-	if (cacheFilePath.length() != 0)
+	if (entries.empty())
 	{
-		LoadPluginCache();
+		return;
 	}
-	if (havePluginsChanged())
+	std::error_code ec;
+	bool haveHelper = std::filesystem::exists(SandboxedEffect::GetSandboxExecutablePath(), ec);
+	if (!haveHelper)
 	{
-		RescanPlugins();
+		// (e.g. test executables.) Scan in-process, one module at a time.
+		Lv2Log::warning("Vst3 scan: pipedal_sandbox not found. Scanning modules in-process.");
+		for (auto &entry : entries)
+		{
+			MakeVst3Info(std::filesystem::path(entry->path_), entry->plugins_);
+		}
+		return;
+	}
+	std::atomic<size_t> nextEntry = 0;
+	auto worker = [&entries, &nextEntry]()
+	{
+		while (true)
+		{
+			size_t i = nextEntry.fetch_add(1);
+			if (i >= entries.size())
+			{
+				break;
+			}
+			Vst3ModuleCacheEntry &entry = *entries[i];
+			entry.scanFailed_ = !ScanModuleInHelper(entry);
+		}
+	};
+	size_t nThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), entries.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < nThreads; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto &thread : threads)
+	{
+		thread.join();
 	}
-	return pluginList;
 }
 
-const Vst3Host::PluginList &Vst3HostImpl::RescanPlugins()
+void Vst3HostImpl::UpdatePlugins(bool rescanAll)
 {
 	Module::PathList pathList = Module::getModulePaths();
 
-	PluginList list;
+	std::unordered_map<std::string, std::unique_ptr<Vst3ModuleCacheEntry>> cachedEntries;
+	for (auto &entry : moduleCache)
+	{
+		cachedEntries[entry->path_] = std::move(entry);
+	}
+	size_t cachedCount = cachedEntries.size();
+
+	ModuleCache modules;
+	ModuleCache toScan;
+	size_t reused = 0;
+	for (const auto &path : pathList)
+	{
+		auto entry = std::make_unique<Vst3ModuleCacheEntry>();
+		entry->path_ = path;
+		GetModuleStamp(path, &entry->lastWriteTime_, &entry->size_);
 
-	// pathList.insert(pathList.begin(),"/home/pi/.vst3/mda-vst3.vst3");
+		auto cached = cachedEntries.find(path);
+		if (!rescanAll && cached != cachedEntries.end() && cached->second &&
+			cached->second->lastWriteTime_ == entry->lastWriteTime_ && cached->second->size_ == entry->size_)
+		{
+			modules.push_back(std::move(cached->second));
+			++reused;
+		}
+		else
+		{
+			toScan.push_back(std::move(entry));
+			modules.push_back(nullptr); // filled in after scanning.
+		}
+	}
+	if (toScan.size() != 0)
+	{
+		Lv2Log::info(SS("Vst3: scanning " << toScan.size() << " new or changed module(s)."));
+	}
+	ScanModules(toScan);
+	for (size_t i = 0, iScanned = 0; i < modules.size(); ++i)
+	{
+		if (!modules[i])
+		{
+			modules[i] = std::move(toScan[iScanned++]);
+		}
+	}
 
-	for (auto &path : pathList)
+	// first instance takes precedence (e.g. ~/.vst3 takes precedence over /usr/lib/vst3 )
+	PluginList list;
+	std::unordered_set<std::string> uids;
+	for (const auto &module : modules)
 	{
-		if (path == std::string("/home/pi/.vst3/mda-vst3.vst3"))
+		for (const auto &plugin : module->plugins_)
 		{
-			Lv2Log::debug("Processing MDA plugins");
+			if (uids.insert(plugin->uid_).second)
+			{
+				list.push_back(std::make_unique<Vst3PluginInfo>(*plugin));
+			}
 		}
-		filesystem::path p{path};
-		MakeVst3Info(p, list);
 	}
+	bool changed = toScan.size() != 0 || reused != cachedCount;
+	this->moduleCache = std::move(modules);
 	this->pluginList = std::move(list);
-	SavePluginCache();
+	if (changed)
+	{
+		SavePluginCache();
+	}
+}
+
+const Vst3Host::PluginList &Vst3HostImpl::RefreshPlugins()
+{
+	if (cacheFilePath.length() != 0)
+	{
+		LoadPluginCache();
+	}
+	UpdatePlugins(false);
+	return pluginList;
+}
+
+const Vst3Host::PluginList &Vst3HostImpl::RescanPlugins()
+{
+	UpdatePlugins(true);
 	return pluginList;
 }
 
@@ -685,9 +912,17 @@ void Vst3HostImpl::LoadPluginCache()
 		std::ifstream f(cacheFilePath);
 		if (f.is_open())
 		{
-			json_reader reader(f);
-
-			reader.read(&(this->pluginList));
+			try
+			{
+				json_reader reader(f);
+				reader.read(&(this->moduleCache));
+			}
+			catch (const std::exception &)
+			{
+				// e.g. the older whole-list format. Rescan.
+				Lv2Log::info("Vst3: plugin cache is out of date.");
+				this->moduleCache.clear();
+			}
 		}
 	}
 }
@@ -700,7 +935,7 @@ void Vst3HostImpl::SavePluginCache()
 		{
 			json_writer writer(f);
 
-			writer.write(this->pluginList);
+			writer.write(this->moduleCache);
 		}
 	}
 }
@@ -716,3 +951,11 @@ Lv2PluginUiInfo *Vst3HostImpl::GetPluginInfo(const std::string &uri)
 	}
 	return nullptr;
 }
+
+JSON_MAP_BEGIN(Vst3ModuleCacheEntry)
+JSON_MAP_REFERENCE(Vst3ModuleCacheEntry, path)
+JSON_MAP_REFERENCE(Vst3ModuleCacheEntry, lastWriteTime)
+JSON_MAP_REFERENCE(Vst3ModuleCacheEntry, size)
+JSON_MAP_REFERENCE(Vst3ModuleCacheEntry, scanFailed)
+JSON_MAP_REFERENCE(Vst3ModuleCacheEntry, plugins)
+JSON_MAP_END()
@@ -19,15 +19,235 @@
 
 #include "pch.h"
 #include "VuUpdate.hpp"
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 using namespace pipedal;
 
+#if defined(__SSE2__)
+// NaN samples are ignored, as in the scalar code: maxps returns its second operand if either is NaN.
+static inline __m128 AbsPs(__m128 v)
+{
+    return _mm_and_ps(v, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+static inline float HorizontalMax(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+static inline float HorizontalSum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+template <bool RMS>
+static void AbsMaxStereo(
+    const float *inputL, const float *inputR, uint32_t samples,
+    float *maxValueL, float *maxValueR,
+    float *sumOfSquaresL, float *sumOfSquaresR)
+{
+    float maxL = *maxValueL;
+    float maxR = *maxValueR;
+    float sumL = 0;
+    float sumR = 0;
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        __m128 vMaxL = _mm_set1_ps(maxL);
+        __m128 vMaxR = _mm_set1_ps(maxR);
+        __m128 vSumL = _mm_setzero_ps();
+        __m128 vSumR = _mm_setzero_ps();
+        for (; i + 4 <= samples; i += 4)
+        {
+            __m128 l = _mm_loadu_ps(inputL + i);
+            __m128 r = _mm_loadu_ps(inputR + i);
+            vMaxL = _mm_max_ps(AbsPs(l), vMaxL);
+            vMaxR = _mm_max_ps(AbsPs(r), vMaxR);
+            if (RMS)
+            {
+                vSumL = _mm_add_ps(vSumL, _mm_mul_ps(l, l));
+                vSumR = _mm_add_ps(vSumR, _mm_mul_ps(r, r));
+            }
+        }
+        maxL = HorizontalMax(vMaxL);
+        maxR = HorizontalMax(vMaxR);
+        if (RMS)
+        {
+            sumL = HorizontalSum(vSumL);
+            sumR = HorizontalSum(vSumR);
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        float32x4_t vMaxL = vdupq_n_f32(maxL);
+        float32x4_t vMaxR = vdupq_n_f32(maxR);
+        float32x4_t vSumL = vdupq_n_f32(0);
+        float32x4_t vSumR = vdupq_n_f32(0);
+        for (; i + 4 <= samples; i += 4)
+        {
+            float32x4_t l = vld1q_f32(inputL + i);
+            float32x4_t r = vld1q_f32(inputR + i);
+            vMaxL = vmaxnmq_f32(vMaxL, vabsq_f32(l));
+            vMaxR = vmaxnmq_f32(vMaxR, vabsq_f32(r));
+            if (RMS)
+            {
+                vSumL = vmlaq_f32(vSumL, l, l);
+                vSumR = vmlaq_f32(vSumR, r, r);
+            }
+        }
+        maxL = vmaxvq_f32(vMaxL);
+        maxR = vmaxvq_f32(vMaxR);
+        if (RMS)
+        {
+            sumL = vaddvq_f32(vSumL);
+            sumR = vaddvq_f32(vSumR);
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        float l = inputL[i];
+        float r = inputR[i];
+        maxL = std::max(maxL, std::abs(l));
+        maxR = std::max(maxR, std::abs(r));
+        if (RMS)
+        {
+            sumL += l * l;
+            sumR += r * r;
+        }
+    }
+    *maxValueL = maxL;
+    *maxValueR = maxR;
+    if (RMS)
+    {
+        *sumOfSquaresL += sumL;
+        *sumOfSquaresR += sumR;
+    }
+}
+
+template <bool RMS>
+static void AbsMax(const float *input, uint32_t samples, float *maxValue, float *sumOfSquares)
+{
+    float maxV = *maxValue;
+    float sum = 0;
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    {
+        // two accumulators, to hide the latency of maxps.
+        __m128 vMax0 = _mm_set1_ps(maxV);
+        __m128 vMax1 = vMax0;
+        __m128 vSum0 = _mm_setzero_ps();
+        __m128 vSum1 = _mm_setzero_ps();
+        for (; i + 8 <= samples; i += 8)
+        {
+            __m128 v0 = _mm_loadu_ps(input + i);
+            __m128 v1 = _mm_loadu_ps(input + i + 4);
+            vMax0 = _mm_max_ps(AbsPs(v0), vMax0);
+            vMax1 = _mm_max_ps(AbsPs(v1), vMax1);
+            if (RMS)
+            {
+                vSum0 = _mm_add_ps(vSum0, _mm_mul_ps(v0, v0));
+                vSum1 = _mm_add_ps(vSum1, _mm_mul_ps(v1, v1));
+            }
+        }
+        maxV = HorizontalMax(_mm_max_ps(vMax0, vMax1));
+        if (RMS)
+        {
+            sum = HorizontalSum(_mm_add_ps(vSum0, vSum1));
+        }
+    }
+#elif defined(__ARM_NEON)
+    {
+        float32x4_t vMax0 = vdupq_n_f32(maxV);
+        float32x4_t vMax1 = vMax0;
+        float32x4_t vSum0 = vdupq_n_f32(0);
+        float32x4_t vSum1 = vdupq_n_f32(0);
+        for (; i + 8 <= samples; i += 8)
+        {
+            float32x4_t v0 = vld1q_f32(input + i);
+            float32x4_t v1 = vld1q_f32(input + i + 4);
+            vMax0 = vmaxnmq_f32(vMax0, vabsq_f32(v0));
+            vMax1 = vmaxnmq_f32(vMax1, vabsq_f32(v1));
+            if (RMS)
+            {
+                vSum0 = vmlaq_f32(vSum0, v0, v0);
+                vSum1 = vmlaq_f32(vSum1, v1, v1);
+            }
+        }
+        maxV = vmaxvq_f32(vmaxq_f32(vMax0, vMax1));
+        if (RMS)
+        {
+            sum = vaddvq_f32(vaddq_f32(vSum0, vSum1));
+        }
+    }
+#endif
+    for (; i < samples; ++i)
+    {
+        float v = input[i];
+        maxV = std::max(maxV, std::abs(v));
+        if (RMS)
+        {
+            sum += v * v;
+        }
+    }
+    *maxValue = maxV;
+    if (RMS)
+    {
+        *sumOfSquares += sum;
+    }
+}
+
+void pipedal::VuAbsMax(const float *input, uint32_t samples, float *maxValue, float *sumOfSquares)
+{
+    if (sumOfSquares)
+    {
+        AbsMax<true>(input, samples, maxValue, sumOfSquares);
+    }
+    else
+    {
+        AbsMax<false>(input, samples, maxValue, nullptr);
+    }
+}
+
+void pipedal::VuAbsMaxStereo(
+    const float *inputL, const float *inputR, uint32_t samples,
+    float *maxValueL, float *maxValueR,
+    float *sumOfSquaresL, float *sumOfSquaresR)
+{
+    if (sumOfSquaresL && sumOfSquaresR)
+    {
+        AbsMaxStereo<true>(inputL, inputR, samples, maxValueL, maxValueR, sumOfSquaresL, sumOfSquaresR);
+    }
+    else
+    {
+        AbsMaxStereo<false>(inputL, inputR, samples, maxValueL, maxValueR, nullptr, nullptr);
+        if (sumOfSquaresL)
+        {
+            VuAbsMax(inputL, samples, maxValueL, sumOfSquaresL);
+        }
+        if (sumOfSquaresR)
+        {
+            VuAbsMax(inputR, samples, maxValueR, sumOfSquaresR);
+        }
+    }
+}
+
 
 JSON_MAP_BEGIN(VuUpdate)
     JSON_MAP_REFERENCE(VuUpdate,instanceId)
     JSON_MAP_REFERENCE(VuUpdate,sampleTime)
     JSON_MAP_REFERENCE(VuUpdate,isStereoInput)
     JSON_MAP_REFERENCE(VuUpdate,isStereoOutput)
+    JSON_MAP_REFERENCE(VuUpdate,isIdle)
     JSON_MAP_REFERENCE(VuUpdate,inputMaxValueL)
     JSON_MAP_REFERENCE(VuUpdate,inputMaxValueR)
     JSON_MAP_REFERENCE(VuUpdate,outputMaxValueL)
@@ -20,9 +20,19 @@
 #pragma once
 
 #include "json.hpp"
+#include <algorithm>
 
 namespace pipedal
 {
+    // Update *maxValue with the peak absolute value of a buffer, and optionally add the sum of squares
+    // of its samples to *sumOfSquares (for RMS). Vectorized with SSE2 or NEON where available.
+    void VuAbsMax(const float *input, uint32_t samples, float *maxValue, float *sumOfSquares = nullptr);
+    // As VuAbsMax, for a stereo pair, measured in a single pass.
+    void VuAbsMaxStereo(
+        const float *inputL, const float *inputR, uint32_t samples,
+        float *maxValueL, float *maxValueR,
+        float *sumOfSquaresL = nullptr, float *sumOfSquaresR = nullptr);
+
     class VuUpdate
     {
     public:
@@ -30,6 +40,7 @@ namespace pipedal
         long sampleTime_ = 0;
         bool isStereoInput_ = false;
         bool isStereoOutput_ = false;
+        bool isIdle_ = false; // the effect is not being run, because its input is silent.
         float inputMaxValueL_ = 0;
         float inputMaxValueR_ = 0;
         float outputMaxValueL_ = 0;
@@ -45,37 +56,35 @@ namespace pipedal
         
         void AccumulateVu(float *value,float *input, uint32_t samples)
         {
-                        
-            float v = *value;
-            for (uint32_t i = 0; i < samples; ++i)
-            {
-                float t = std::abs(input[i]);
-                if (t > v) {
-                    v = t;
-                }
-            }
-            *value = v;
+            VuAbsMax(input, samples, value);
         }
         void AccumulateInputs(float* input, uint32_t samples)
         {
-            AccumulateVu(&inputMaxValueL_,input,samples);
-
+            VuAbsMax(input, samples, &inputMaxValueL_);
         }
         void AccumulateInputs(float* inputL, float*inputR, uint32_t samples)
         {
-            AccumulateVu(&inputMaxValueL_,inputL,samples);
-            AccumulateVu(&inputMaxValueR_,inputR,samples);
-
+            VuAbsMaxStereo(inputL, inputR, samples, &inputMaxValueL_, &inputMaxValueR_);
         }
         void AccumulateOutputs(float* output, uint32_t samples)
         {
-            AccumulateVu(&outputMaxValueL_,output,samples);
-
+            VuAbsMax(output, samples, &outputMaxValueL_);
         }
         void AccumulateOutputs(float* outputL, float*outputR, uint32_t samples)
         {
-            AccumulateVu(&outputMaxValueL_,outputL,samples);
-            AccumulateVu(&outputMaxValueR_,outputR,samples);
+            VuAbsMaxStereo(outputL, outputR, samples, &outputMaxValueL_, &outputMaxValueR_);
+        }
+
+        // Accumulate peak values that have already been measured.
+        void AccumulateInputPeaks(float peakL, float peakR = 0)
+        {
+            inputMaxValueL_ = std::max(inputMaxValueL_, peakL);
+            inputMaxValueR_ = std::max(inputMaxValueR_, peakR);
+        }
+        void AccumulateOutputPeaks(float peakL, float peakR = 0)
+        {
+            outputMaxValueL_ = std::max(outputMaxValueL_, peakL);
+            outputMaxValueR_ = std::max(outputMaxValueR_, peakR);
         }
 
         DECLARE_JSON_MAP(VuUpdate);
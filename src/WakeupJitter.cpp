@@ -0,0 +1,90 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "WakeupJitter.hpp"
+
+using namespace pipedal;
+
+void WakeupJitter::Reset()
+{
+    for (auto &bucket : buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    totalNs.store(0, std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    earlyWakeups.store(0, std::memory_order_relaxed);
+}
+
+void WakeupJitter::Add(uint64_t lateNs)
+{
+    // (single writer, so no read-modify-write atomics.)
+    size_t bucket = (size_t)(lateNs / BUCKET_NS);
+    if (bucket >= BUCKETS)
+    {
+        bucket = BUCKETS - 1;
+    }
+    buckets[bucket].store(buckets[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    totalNs.store(totalNs.load(std::memory_order_relaxed) + lateNs, std::memory_order_relaxed);
+    if (lateNs > maxNs.load(std::memory_order_relaxed))
+    {
+        maxNs.store(lateNs, std::memory_order_relaxed);
+    }
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+double WakeupJitter::MeanUs() const
+{
+    uint64_t n = count.load(std::memory_order_relaxed);
+    if (n == 0)
+    {
+        return 0;
+    }
+    return totalNs.load(std::memory_order_relaxed) * 0.001 / n;
+}
+
+double WakeupJitter::PercentileUs(double p) const
+{
+    uint64_t total = 0;
+    for (const auto &bucket : buckets)
+    {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0)
+    {
+        return 0;
+    }
+    uint64_t threshold = (uint64_t)(p * total + 0.5);
+    if (threshold == 0)
+    {
+        threshold = 1;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= threshold)
+        {
+            return (i + 1) * BUCKET_NS * 0.001;
+        }
+    }
+    return BUCKETS * BUCKET_NS * 0.001;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace pipedal
+{
+    /**
+     * @brief How late timer-scheduled audio wakeups are, relative to the time they asked for.
+     *
+     * A histogram of 10us buckets, which gives the percentiles needed to choose a per-device safety
+     * margin. Add() and AddEarlyWakeup() are called by the audio thread only, and are realtime-safe. The
+     * readers may be called from any thread (they see a slightly stale picture while the audio thread runs).
+     */
+    class WakeupJitter
+    {
+    public:
+        static constexpr uint64_t BUCKET_NS = 10'000;
+        static constexpr size_t BUCKETS = 500; // up to 5ms. Later wakeups are counted in the last bucket.
+
+        WakeupJitter() { Reset(); }
+
+        // Not while the audio thread is adding samples.
+        void Reset();
+
+        void Add(uint64_t lateNs);
+        // A wakeup that came before the data was ready, and had to sleep again.
+        void AddEarlyWakeup() { earlyWakeups.store(earlyWakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+        uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+        uint64_t EarlyWakeups() const { return earlyWakeups.load(std::memory_order_relaxed); }
+        double MeanUs() const;
+        double MaxUs() const { return maxNs.load(std::memory_order_relaxed) * 0.001; }
+        // The lateness (rounded up to a bucket boundary) that fraction p (0..1) of wakeups didn't exceed.
+        double PercentileUs(double p) const;
+
+    private:
+        std::atomic<uint32_t> buckets[BUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+        std::atomic<uint64_t> earlyWakeups;
+    };
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "WakeupJitter.hpp"
+#include <cmath>
+
+using namespace pipedal;
+
+TEST_CASE("WakeupJitter percentiles", "[wakeup_jitter][Build][Dev]")
+{
+    WakeupJitter jitter;
+    REQUIRE(jitter.Count() == 0);
+    REQUIRE(jitter.PercentileUs(0.99) == 0);
+
+    // 98 wakeups 5us late, one 125us late, one 20ms late.
+    for (int i = 0; i < 98; ++i)
+    {
+        jitter.Add(5'000);
+    }
+    jitter.Add(125'000);
+    jitter.Add(20'000'000);
+    jitter.AddEarlyWakeup();
+
+    REQUIRE(jitter.Count() == 100);
+    REQUIRE(jitter.EarlyWakeups() == 1);
+    REQUIRE(jitter.PercentileUs(0.5) == 10.0);
+    REQUIRE(jitter.PercentileUs(0.98) == 10.0);
+    REQUIRE(jitter.PercentileUs(0.99) == 130.0);
+    // off the end of the histogram.
+    REQUIRE(jitter.PercentileUs(1.0) == WakeupJitter::BUCKETS * WakeupJitter::BUCKET_NS * 0.001);
+    REQUIRE(jitter.MaxUs() == 20'000.0);
+    REQUIRE(std::abs(jitter.MeanUs() - (98 * 5.0 + 125.0 + 20'000.0) / 100) < 1e-9);
+
+    jitter.Reset();
+    REQUIRE(jitter.Count() == 0);
+    REQUIRE(jitter.MaxUs() == 0);
+}
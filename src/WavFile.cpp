@@ -0,0 +1,371 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "WavFile.hpp"
+#include "ss.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace pipedal;
+
+static_assert(std::endian::native == std::endian::little, "WAV sample conversion assumes a little-endian host.");
+
+namespace
+{
+    constexpr uint16_t WAVE_FORMAT_PCM = 1;
+    constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+    constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    constexpr size_t READ_CHUNK_FRAMES = 1024;
+
+    uint16_t Le16(const uint8_t *p)
+    {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+    uint32_t Le32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    void PutLe16(uint8_t *p, uint16_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    void PutLe32(uint8_t *p, uint32_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+        p[2] = (uint8_t)(v >> 16);
+        p[3] = (uint8_t)(v >> 24);
+    }
+}
+
+WavReader::~WavReader()
+{
+    Close();
+}
+
+void WavReader::Close()
+{
+    if (file)
+    {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+void WavReader::Open(const std::filesystem::path &path)
+{
+    Close();
+    file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        throw std::runtime_error(SS("Can't open " << path << ". " << strerror(errno)));
+    }
+    try
+    {
+        uint8_t header[12];
+        if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        {
+            throw std::runtime_error("Not a WAV file.");
+        }
+        bool hasFormat = false;
+        uint16_t formatTag = 0;
+        uint16_t bitsPerSample = 0;
+        while (true)
+        {
+            uint8_t chunkHeader[8];
+            if (fread(chunkHeader, 1, sizeof(chunkHeader), file) != sizeof(chunkHeader))
+            {
+                throw std::runtime_error("No data chunk.");
+            }
+            uint32_t chunkSize = Le32(chunkHeader + 4);
+            if (memcmp(chunkHeader, "fmt ", 4) == 0)
+            {
+                if (chunkSize < 16)
+                {
+                    throw std::runtime_error("Invalid fmt chunk.");
+                }
+                std::vector<uint8_t> fmt(chunkSize);
+                if (fread(fmt.data(), 1, chunkSize, file) != chunkSize)
+                {
+                    throw std::runtime_error("Unexpected end of file.");
+                }
+                formatTag = Le16(&fmt[0]);
+                channels = Le16(&fmt[2]);
+                sampleRate = Le32(&fmt[4]);
+                bitsPerSample = Le16(&fmt[14]);
+                if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 26)
+                {
+                    formatTag = Le16(&fmt[24]); // first two bytes of the SubFormat GUID.
+                }
+                hasFormat = true;
+                if (chunkSize & 1)
+                {
+                    fseek(file, 1, SEEK_CUR);
+                }
+            }
+            else if (memcmp(chunkHeader, "data", 4) == 0)
+            {
+                if (!hasFormat)
+                {
+                    throw std::runtime_error("Missing fmt chunk.");
+                }
+                if (channels == 0)
+                {
+                    throw std::runtime_error("Invalid channel count.");
+                }
+                if (formatTag == WAVE_FORMAT_PCM && (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32))
+                {
+                    sampleFormat = SampleFormat::Int;
+                }
+                else if (formatTag == WAVE_FORMAT_IEEE_FLOAT && (bitsPerSample == 32 || bitsPerSample == 64))
+                {
+                    sampleFormat = SampleFormat::Float;
+                }
+                else
+                {
+                    throw std::runtime_error(SS("Unsupported sample format (format " << formatTag << ", " << bitsPerSample << " bits)."));
+                }
+                bytesPerSample = bitsPerSample / 8;
+                frameCount = chunkSize / (bytesPerSample * channels);
+                framesRemaining = frameCount;
+                readBuffer.resize(READ_CHUNK_FRAMES * bytesPerSample * channels);
+                return;
+            }
+            else
+            {
+                if (fseek(file, chunkSize + (chunkSize & 1), SEEK_CUR) != 0)
+                {
+                    throw std::runtime_error("Unexpected end of file.");
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        Close();
+        throw std::runtime_error(SS("Can't read " << path << ". " << e.what()));
+    }
+}
+
+float WavReader::GetSample(const uint8_t *p) const
+{
+    if (sampleFormat == SampleFormat::Float)
+    {
+        if (bytesPerSample == 4)
+        {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        double v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v;
+    }
+    switch (bytesPerSample)
+    {
+    case 1:
+        return ((int)p[0] - 128) * (1.0f / 128);
+    case 2:
+        return (int16_t)Le16(p) * (1.0f / 32768);
+    case 3:
+        return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) * (1.0f / 2147483648.0f);
+    default:
+        return (int32_t)Le32(p) * (1.0f / 2147483648.0f);
+    }
+}
+
+size_t WavReader::Read(float **buffers, size_t nBuffers, size_t frames)
+{
+    if (!file)
+    {
+        throw std::runtime_error("WAV file is not open.");
+    }
+    size_t frameBytes = bytesPerSample * channels;
+    size_t framesRead = 0;
+    while (framesRead < frames && framesRemaining != 0)
+    {
+        size_t thisTime = std::min({frames - framesRead, READ_CHUNK_FRAMES, (size_t)framesRemaining});
+        size_t actual = fread(readBuffer.data(), frameBytes, thisTime, file);
+        for (size_t i = 0; i < actual; ++i)
+        {
+            const uint8_t *frame = readBuffer.data() + i * frameBytes;
+            for (size_t c = 0; c < nBuffers; ++c)
+            {
+                size_t sourceChannel = std::min(c, (size_t)channels - 1);
+                buffers[c][framesRead + i] = GetSample(frame + sourceChannel * bytesPerSample);
+            }
+        }
+        framesRead += actual;
+        if (actual != thisTime)
+        {
+            framesRemaining = 0; // truncated file.
+            break;
+        }
+        framesRemaining -= actual;
+    }
+    return framesRead;
+}
+
+WavWriter::~WavWriter()
+{
+    try
+    {
+        Close();
+    }
+    catch (const std::exception &)
+    {
+    }
+}
+
+void WavWriter::Open(const std::filesystem::path &path, uint32_t channels, uint32_t sampleRate)
+{
+    Close();
+    if (channels == 0)
+    {
+        throw std::runtime_error("Invalid channel count.");
+    }
+    file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        throw std::runtime_error(SS("Can't write to " << path << ". " << strerror(errno)));
+    }
+    this->channels = channels;
+    this->sampleRate = sampleRate;
+    this->frameCount = 0;
+    this->preallocatedOffset = 0;
+    WriteHeader(); // a placeholder until Close().
+}
+
+static constexpr size_t WAV_HEADER_SIZE = 12 + 8 + 18 + 8 + 4 + 8; // RIFF, fmt, fact, data.
+
+void WavWriter::WriteHeader()
+{
+    uint64_t dataBytes64 = frameCount * channels * sizeof(float);
+    uint32_t dataBytes = dataBytes64 > 0xFFFFFFFFull - WAV_HEADER_SIZE ? 0xFFFFFFFFu - (uint32_t)WAV_HEADER_SIZE : (uint32_t)dataBytes64;
+
+    uint8_t header[WAV_HEADER_SIZE];
+    uint8_t *p = header;
+    memcpy(p, "RIFF", 4);
+    PutLe32(p + 4, (uint32_t)(WAV_HEADER_SIZE - 8) + dataBytes);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+
+    memcpy(p, "fmt ", 4);
+    PutLe32(p + 4, 18);
+    PutLe16(p + 8, WAVE_FORMAT_IEEE_FLOAT);
+    PutLe16(p + 10, (uint16_t)channels);
+    PutLe32(p + 12, sampleRate);
+    PutLe32(p + 16, sampleRate * channels * (uint32_t)sizeof(float));
+    PutLe16(p + 20, (uint16_t)(channels * sizeof(float)));
+    PutLe16(p + 22, 32);
+    PutLe16(p + 24, 0); // cbSize
+    p += 8 + 18;
+
+    memcpy(p, "fact", 4); // required for non-PCM formats.
+    PutLe32(p + 4, 4);
+    PutLe32(p + 8, (uint32_t)std::min(frameCount, (uint64_t)0xFFFFFFFFu));
+    p += 12;
+
+    memcpy(p, "data", 4);
+    PutLe32(p + 4, dataBytes);
+
+    if (fseek(file, 0, SEEK_SET) != 0 || fwrite(header, 1, sizeof(header), file) != sizeof(header))
+    {
+        throw std::runtime_error("Can't write WAV header.");
+    }
+}
+
+void WavWriter::Write(float *const *buffers, size_t frames)
+{
+    if (!file)
+    {
+        throw std::runtime_error("WAV file is not open.");
+    }
+    writeBuffer.resize(frames * channels);
+    float *p = writeBuffer.data();
+    for (size_t i = 0; i < frames; ++i)
+    {
+        for (size_t c = 0; c < channels; ++c)
+        {
+            *p++ = buffers[c][i];
+        }
+    }
+    if (preallocationBytes != 0)
+    {
+        Preallocate(WAV_HEADER_SIZE + (frameCount + frames) * channels * sizeof(float));
+    }
+    if (fwrite(writeBuffer.data(), sizeof(float) * channels, frames, file) != frames)
+    {
+        throw std::runtime_error("Can't write WAV file.");
+    }
+    frameCount += frames;
+}
+
+void WavWriter::Preallocate(uint64_t endOffset)
+{
+    if (endOffset <= preallocatedOffset)
+    {
+        return;
+    }
+    uint64_t length = std::max(preallocationBytes, endOffset - preallocatedOffset);
+    // failure (e.g. a file system that doesn't support it) is harmless. Don't try again.
+    if (fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, (off_t)preallocatedOffset, (off_t)length) != 0)
+    {
+        preallocationBytes = 0;
+        return;
+    }
+    preallocatedOffset += length;
+}
+
+void WavWriter::Close()
+{
+    if (file)
+    {
+        FILE *f = file;
+        try
+        {
+            WriteHeader();
+            if (preallocatedOffset != 0)
+            {
+                // release the unused preallocation.
+                fflush(f);
+                if (ftruncate(fileno(f), (off_t)(WAV_HEADER_SIZE + frameCount * channels * sizeof(float))) != 0)
+                {
+                    throw std::runtime_error(SS("Can't write WAV file. " << strerror(errno)));
+                }
+            }
+        }
+        catch (const std::exception &)
+        {
+            fclose(f);
+            file = nullptr;
+            throw;
+        }
+        fclose(f);
+        file = nullptr;
+    }
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace pipedal
+{
+    /**
+     * @brief Streaming WAV file reader.
+     *
+     * Reads 8/16/24/32-bit integer PCM and 32/64-bit float files (including WAVE_FORMAT_EXTENSIBLE), and
+     * converts them to deinterleaved float samples. Throws std::runtime_error on errors.
+     */
+    class WavReader
+    {
+    public:
+        WavReader() {}
+        WavReader(const std::filesystem::path &path) { Open(path); }
+        ~WavReader();
+        WavReader(const WavReader &) = delete;
+        WavReader &operator=(const WavReader &) = delete;
+
+        void Open(const std::filesystem::path &path);
+        void Close();
+        bool IsOpen() const { return file != nullptr; }
+
+        uint32_t GetChannels() const { return channels; }
+        uint32_t GetSampleRate() const { return sampleRate; }
+        uint64_t GetFrameCount() const { return frameCount; }
+
+        // Read up to `frames` frames into `buffers[0..nBuffers)`. Extra buffers get copies of the last
+        // channel in the file; extra file channels are discarded. Returns the number of frames read, which is
+        // less than `frames` only at the end of the file.
+        size_t Read(float **buffers, size_t nBuffers, size_t frames);
+
+    private:
+        enum class SampleFormat
+        {
+            Int,
+            Float
+        };
+        float GetSample(const uint8_t *p) const;
+
+        FILE *file = nullptr;
+        SampleFormat sampleFormat = SampleFormat::Int;
+        uint32_t channels = 0;
+        uint32_t sampleRate = 0;
+        uint32_t bytesPerSample = 0;
+        uint64_t frameCount = 0;
+        uint64_t framesRemaining = 0;
+        std::vector<uint8_t> readBuffer;
+    };
+
+    /**
+     * @brief Streaming WAV file writer. Writes 32-bit float files.
+     *
+     * The RIFF header is completed by Close() (or the destructor).
+     */
+    class WavWriter
+    {
+    public:
+        WavWriter() {}
+        WavWriter(const std::filesystem::path &path, uint32_t channels, uint32_t sampleRate) { Open(path, channels, sampleRate); }
+        ~WavWriter();
+        WavWriter(const WavWriter &) = delete;
+        WavWriter &operator=(const WavWriter &) = delete;
+
+        void Open(const std::filesystem::path &path, uint32_t channels, uint32_t sampleRate);
+        void Close();
+        bool IsOpen() const { return file != nullptr; }
+
+        uint32_t GetChannels() const { return channels; }
+        uint64_t GetFrameCount() const { return frameCount; }
+
+        // buffers[0..GetChannels()) each hold `frames` samples.
+        void Write(float *const *buffers, size_t frames);
+
+        // Reserve disk space (fallocate) in chunks of `bytes` ahead of the write position, so that long
+        // recordings get contiguous extents, and writes don't stall on block allocation. Best effort;
+        // the file size isn't changed.
+        void SetPreallocation(uint64_t bytes) { preallocationBytes = bytes; }
+
+    private:
+        void WriteHeader();
+        void Preallocate(uint64_t endOffset);
+
+        FILE *file = nullptr;
+        uint32_t channels = 0;
+        uint32_t sampleRate = 0;
+        uint64_t frameCount = 0;
+        uint64_t preallocationBytes = 0;
+        uint64_t preallocatedOffset = 0;
+        std::vector<float> writeBuffer;
+    };
+}
@@ -0,0 +1,176 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#include "pch.h"
+#include "catch.hpp"
+#include "WavFile.hpp"
+#include "AudioRecorder.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+using namespace pipedal;
+using namespace std;
+
+static std::filesystem::path TempWavPath(const char *name)
+{
+    return std::filesystem::temp_directory_path() / name;
+}
+
+TEST_CASE("WAV file round trip", "[wav_file][Build][Dev]")
+{
+    auto path = TempWavPath("pipedalWavFileTest.wav");
+    constexpr size_t FRAMES = 3000;
+
+    std::vector<float> left(FRAMES), right(FRAMES);
+    for (size_t i = 0; i < FRAMES; ++i)
+    {
+        left[i] = (float)i / FRAMES;
+        right[i] = -(float)i / FRAMES;
+    }
+    {
+        WavWriter writer(path, 2, 48000);
+        float *buffers[2]{left.data(), right.data()};
+        // in uneven pieces.
+        writer.Write(buffers, 1000);
+        float *rest[2]{left.data() + 1000, right.data() + 1000};
+        writer.Write(rest, FRAMES - 1000);
+        REQUIRE(writer.GetFrameCount() == FRAMES);
+    }
+    {
+        WavReader reader(path);
+        REQUIRE(reader.GetChannels() == 2);
+        REQUIRE(reader.GetSampleRate() == 48000);
+        REQUIRE(reader.GetFrameCount() == FRAMES);
+
+        std::vector<float> l(FRAMES + 10), r(FRAMES + 10), extra(FRAMES + 10);
+        float *buffers[3]{l.data(), r.data(), extra.data()};
+        size_t framesRead = reader.Read(buffers, 3, 2000);
+        REQUIRE(framesRead == 2000);
+        float *rest[3]{l.data() + 2000, r.data() + 2000, extra.data() + 2000};
+        REQUIRE(reader.Read(rest, 3, 2000) == FRAMES - 2000);
+        REQUIRE(reader.Read(rest, 3, 2000) == 0);
+
+        for (size_t i = 0; i < FRAMES; ++i)
+        {
+            REQUIRE(l[i] == left[i]);
+            REQUIRE(r[i] == right[i]);
+            REQUIRE(extra[i] == right[i]); // extra buffers copy the last channel.
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("WAV file 16-bit PCM", "[wav_file][Build][Dev]")
+{
+    auto path = TempWavPath("pipedalWavFile16Test.wav");
+    {
+        // mono, 16-bit, with an extra chunk before the data.
+        const uint8_t file[] = {
+            'R', 'I', 'F', 'F', 50, 0, 0, 0, 'W', 'A', 'V', 'E',
+            'f', 'm', 't', ' ', 16, 0, 0, 0,
+            1, 0, 1, 0, 0x44, 0xAC, 0, 0, 0x88, 0x58, 0x01, 0, 2, 0, 16, 0,
+            'L', 'I', 'S', 'T', 1, 0, 0, 0, 'x', 0,
+            'd', 'a', 't', 'a', 6, 0, 0, 0,
+            0x00, 0x40, 0x00, 0xC0, 0xFF, 0x7F};
+        FILE *f = fopen(path.c_str(), "wb");
+        REQUIRE(f != nullptr);
+        fwrite(file, 1, sizeof(file), f);
+        fclose(f);
+    }
+    WavReader reader(path);
+    REQUIRE(reader.GetChannels() == 1);
+    REQUIRE(reader.GetSampleRate() == 44100);
+    REQUIRE(reader.GetFrameCount() == 3);
+    float samples[3];
+    float *buffers[1]{samples};
+    REQUIRE(reader.Read(buffers, 1, 3) == 3);
+    REQUIRE(samples[0] == 0.5f);
+    REQUIRE(samples[1] == -0.5f);
+    REQUIRE(samples[2] == 32767.0f / 32768);
+    reader.Close();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Audio recorder", "[wav_file][Build][Dev]")
+{
+    auto directory = TempWavPath("pipedalAudioRecorderTest");
+    std::filesystem::remove_all(directory);
+    constexpr uint32_t FRAMES = 64;
+    constexpr uint32_t PERIODS = 20;
+
+    float input[FRAMES], left[FRAMES], right[FRAMES];
+    float *inputs[1]{input};
+    float *outputs[2]{left, right};
+
+    AudioRecorder recorder(1024 * 1024);
+    auto basePath = recorder.Start(directory);
+    REQUIRE(recorder.IsRecording());
+    for (uint32_t period = 0; period < PERIODS; ++period)
+    {
+        for (uint32_t i = 0; i < FRAMES; ++i)
+        {
+            input[i] = (float)(period * FRAMES + i);
+            left[i] = -input[i];
+            right[i] = input[i] * 2;
+        }
+        recorder.Write(inputs, 1, outputs, 2, FRAMES, 48000);
+    }
+    recorder.Stop();
+    REQUIRE(!recorder.IsRecording());
+    REQUIRE(recorder.GetFramesWritten() == FRAMES * PERIODS);
+    REQUIRE(recorder.GetDroppedFrames() == 0);
+
+    {
+        WavReader reader(basePath.string() + "-input.wav");
+        REQUIRE(reader.GetChannels() == 1);
+        REQUIRE(reader.GetFrameCount() == FRAMES * PERIODS);
+    }
+    {
+        // the unused preallocation is released on close.
+        auto outputPath = std::filesystem::path(basePath.string() + "-output.wav");
+        REQUIRE(std::filesystem::file_size(outputPath) < FRAMES * PERIODS * 2 * sizeof(float) + 1024);
+
+        WavReader reader(outputPath);
+        REQUIRE(reader.GetChannels() == 2);
+        REQUIRE(reader.GetFrameCount() == FRAMES * PERIODS);
+        std::vector<float> l(FRAMES * PERIODS), r(FRAMES * PERIODS);
+        float *buffers[2]{l.data(), r.data()};
+        REQUIRE(reader.Read(buffers, 2, FRAMES * PERIODS) == FRAMES * PERIODS);
+        for (size_t i = 0; i < FRAMES * PERIODS; ++i)
+        {
+            REQUIRE(l[i] == -(float)i);
+            REQUIRE(r[i] == 2 * (float)i);
+        }
+    }
+
+    // overflow drops periods, rather than blocking.
+    AudioRecorder smallRecorder(4096);
+    smallRecorder.Start(directory);
+    for (uint32_t period = 0; period < 100; ++period)
+    {
+        smallRecorder.Write(inputs, 1, outputs, 2, FRAMES, 48000);
+    }
+    smallRecorder.Stop();
+    REQUIRE(smallRecorder.GetDroppedFrames() != 0);
+    REQUIRE(smallRecorder.GetFramesWritten() + smallRecorder.GetDroppedFrames() == 100 * FRAMES);
+
+    std::filesystem::remove_all(directory);
+}
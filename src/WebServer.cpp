@@ -41,24 +41,50 @@
 
 
 #include <mutex>
+#include <atomic>
+#include <chrono>
 #include "WebServer.hpp"
 
 #include "Uri.hpp"
 #include "ss.hpp"
 
 #include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/extensions/permessage_deflate/enabled.hpp>
 
 #include <websocketpp/server.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/post.hpp>
 
 #include "WebServerLog.hpp"
+#include "StaticFileCache.hpp"
 #include "TemporaryFile.hpp"
 
 using namespace pipedal;
 using namespace std;
 
 static const bool ENABLE_KEEP_ALIVE = true;
+// Websocket messages smaller than this are sent uncompressed, even if permessage-deflate was negotiated.
+static const size_t MIN_DEFLATE_MESSAGE_SIZE = 1024;
 static const std::filesystem::path WEB_TEMP_DIR{"/var/pipedal/web_temp"};
 
+// Outbound websocket limits. A client that stops reading (e.g. a phone that went to sleep while connected)
+// first loses telemetry, and is then disconnected, so that its send buffer can't grow without bound.
+static const size_t DROP_TELEMETRY_BYTES = 64 * 1024;
+static const size_t STALLED_SESSION_BYTES = 4 * 1024 * 1024;
+static const std::chrono::seconds STALLED_SESSION_TIMEOUT{30}; // time spent over DROP_TELEMETRY_BYTES.
+
+static std::atomic<size_t> webSocketQueuedBytes{0};
+static std::atomic<uint64_t> webSocketStalledDisconnects{0};
+
+size_t pipedal::GetWebSocketQueuedBytes()
+{
+    return webSocketQueuedBytes.load();
+}
+uint64_t pipedal::GetWebSocketStalledDisconnects()
+{
+    return webSocketStalledDisconnects.load();
+}
+
 using tcp = boost::asio::ip::tcp; // from <boost/asio/ip/tcp.hpp>
 
 const size_t MAX_READ_SIZE = 512 * 1024 * 1024;
@@ -532,6 +558,16 @@ public:
 
     typedef request_with_file_upload request_type;
 
+    // RFC 7692 permessage-deflate, for clients that offer it.
+    struct permessage_deflate_config
+    {
+        typedef type::request_type request_type;
+        static const bool allow_disabling_context_takeover = true;
+        static const uint8_t minimum_outgoing_window_bits = 8;
+    };
+    typedef websocketpp::extensions::permessage_deflate::enabled<permessage_deflate_config>
+        permessage_deflate_type;
+
     struct transport_config : public base::transport_config
     {
         typedef type::concurrency_type concurrency_type;
@@ -639,36 +675,84 @@ std::string GetFromAddress(const tcp::socket &socket)
     return s.str();
 }
 
-static bool encoding_allowed(const std::string&acceptEncodingHeader,const std::string&encoding)
+double pipedal::encoding_quality(const std::string&acceptEncodingHeader,const std::string&encoding)
 {
-    auto npos = acceptEncodingHeader.find(encoding);
-    if (npos == std::string::npos)
-        return false;
+    // e.g. "gzip, deflate, br;q=1.0, *;q=0.5"
+    double wildcardQuality = 0;
     std::vector<std::string> encodings = split(acceptEncodingHeader, ',');
     for (auto &e : encodings)
     {
-        if (e.starts_with(encoding)) {
-            if (e.length() == encoding.length())
-                return true;
-            if (e[encoding.length()] == ';')
-                return true;
+        while (e.starts_with(' '))
+        {
+            e.erase(0, 1);
+        }
+        std::string name = e;
+        double quality = 1.0;
+        auto semicolon = e.find(';');
+        if (semicolon != std::string::npos)
+        {
+            name = e.substr(0, semicolon);
+            auto qPos = e.find("q=", semicolon);
+            if (qPos != std::string::npos)
+            {
+                quality = std::strtod(e.c_str() + qPos + 2, nullptr);
+            }
+        }
+        while (name.ends_with(' '))
+        {
+            name.pop_back();
+        }
+        if (name == encoding)
+        {
+            return quality;
+        }
+        if (name == "*")
+        {
+            wildcardQuality = quality;
         }
     }
-    return false;
+    return wildcardQuality;
 }
 
-static bool can_use_gzip_encoding(
-    const std::string &acceptEncodingHeader, 
-    const std::filesystem::path &filename, 
-    std::filesystem::path *gzName)
+bool pipedal::encoding_allowed(const std::string&acceptEncodingHeader,const std::string&encoding)
 {
-    if (!encoding_allowed(acceptEncodingHeader, "gzip"))
-        return false;
-    *gzName = filename.string() + ".gz";
-    if (std::filesystem::exists(*gzName)) {
-        return true;    
+    return encoding_quality(acceptEncodingHeader, encoding) > 0;
+}
+
+// Precompressed siblings of static files, in order of preference when the client rates them equally.
+static const struct
+{
+    const char *encoding;
+    const char *extension;
+} precompressedEncodings[] = {
+    {"br", ".br"},
+    {"gzip", ".gz"},
+};
+
+// Pick the best precompressed sibling of filename (e.g. index.js.br) that the client accepts.
+// Returns the content encoding, or nullptr if the plain file should be sent.
+static const char *select_precompressed_encoding(
+    const std::string &acceptEncodingHeader,
+    const std::filesystem::path &filename,
+    std::filesystem::path *encodedName)
+{
+    const char *result = nullptr;
+    double bestQuality = 0;
+    for (const auto &precompressed : precompressedEncodings)
+    {
+        double quality = encoding_quality(acceptEncodingHeader, precompressed.encoding);
+        if (quality > bestQuality)
+        {
+            std::filesystem::path candidate = filename.string() + precompressed.extension;
+            if (std::filesystem::exists(candidate))
+            {
+                bestQuality = quality;
+                *encodedName = candidate;
+                result = precompressed.encoding;
+            }
+        }
     }
-    return false;
+    return result;
 }
 
 
@@ -684,6 +768,8 @@ namespace pipedal
         int port = -1;
         std::filesystem::path rootPath;
         int threads = 1;
+        int requestWorkerThreads = 2;
+        std::unique_ptr<boost::asio::thread_pool> requestWorkerPool;
         size_t maxUploadSize = 512 * 1024 * 1024;
 
         std::unique_ptr<std::thread> pBgThread;
@@ -725,10 +811,13 @@ namespace pipedal
             server::connection_type &request;
 
         public:
+            bool notModified = false;
+
             HttpResponseImpl(server::connection_type &request)
                 : request(request)
             {
             }
+            bool isNotModified() const { return notModified; }
             virtual void set(const std::string &key, const std::string &value) { request.replace_header(key, value); }
             virtual void setContentLength(size_t size)
             {
@@ -756,6 +845,12 @@ namespace pipedal
                 request.set_body_file(path,deleteWhenDone);
             }
 
+            virtual void setNotModified() override
+            {
+                notModified = true;
+                request.set_body("");
+            }
+
             virtual void keepAlive(bool value) override
             {
                 if ((!value) || (!ENABLE_KEEP_ALIVE))
@@ -767,6 +862,7 @@ namespace pipedal
 
         server m_endpoint;
         bool logHttpRequests = false;
+        StaticFileCache staticFileCache;
 
         class WebSocketSession : public std::enable_shared_from_this<WebSocketSession>, public SocketHandler::IWriteCallback
         {
@@ -783,13 +879,96 @@ namespace pipedal
                 webSocket = nullptr;
             }
 
+            std::mutex backpressureMutex;
+            size_t queuedBytes = 0; // contribution to webSocketQueuedBytes.
+            bool backlogged = false;
+            std::chrono::steady_clock::time_point backloggedSince;
+
+            // Returns false if the message should be dropped. Disconnects a session that has stopped reading.
+            bool CheckBackpressure(bool droppable)
+            {
+                size_t buffered = webSocket->get_buffered_amount();
+                bool stalled = false;
+                {
+                    std::lock_guard lock(backpressureMutex);
+                    webSocketQueuedBytes += buffered;
+                    webSocketQueuedBytes -= queuedBytes;
+                    queuedBytes = buffered;
+
+                    if (buffered <= DROP_TELEMETRY_BYTES)
+                    {
+                        backlogged = false;
+                        return true;
+                    }
+                    auto now = std::chrono::steady_clock::now();
+                    if (!backlogged)
+                    {
+                        backlogged = true;
+                        backloggedSince = now;
+                    }
+                    stalled = buffered > STALLED_SESSION_BYTES || now - backloggedSince > STALLED_SESSION_TIMEOUT;
+                }
+                if (stalled)
+                {
+                    ++webSocketStalledDisconnects;
+                    Lv2Log::info(SS("WebSocketSession stalled. Disconnecting. (" << fromAddress << ", " << buffered << " bytes queued)"));
+                    webSocket->close(websocketpp::close::status::going_away, "Client not reading.");
+                    return false;
+                }
+                return !droppable;
+            }
+            void ReleaseQueuedBytes()
+            {
+                std::lock_guard lock(backpressureMutex);
+                webSocketQueuedBytes -= queuedBytes;
+                queuedBytes = 0;
+            }
+
+            bool sendMessage(const void *data, size_t size, websocketpp::frame::opcode::value opcode, bool compress, bool droppable = false)
+            {
+                if (!CheckBackpressure(droppable))
+                {
+                    return false;
+                }
+                using message_type = server::connection_type::message_type;
+                auto message = std::make_shared<message_type>(message_type::con_msg_man_ptr(), opcode, size);
+                message->append_payload(data, size);
+                // only takes effect if the client negotiated permessage-deflate.
+                message->set_compressed(compress);
+                webSocket->send(message);
+                return true;
+            }
             virtual void writeCallback(const std::string &text)
             {
                 if (webSocket)
                 {
-                    webSocket->send(text, websocketpp::frame::opcode::text);
+                    sendMessage(text.data(), text.size(), websocketpp::frame::opcode::text, text.size() >= MIN_DEFLATE_MESSAGE_SIZE);
                 }
             }
+            virtual void writeBinaryCallback(const void *data, size_t size)
+            {
+                if (webSocket)
+                {
+                    // packed floats don't compress well.
+                    sendMessage(data, size, websocketpp::frame::opcode::binary, false);
+                }
+            }
+            virtual bool writeDroppableCallback(const std::string &text)
+            {
+                if (webSocket)
+                {
+                    return sendMessage(text.data(), text.size(), websocketpp::frame::opcode::text, text.size() >= MIN_DEFLATE_MESSAGE_SIZE, true);
+                }
+                return false;
+            }
+            virtual bool writeDroppableBinaryCallback(const void *data, size_t size)
+            {
+                if (webSocket)
+                {
+                    return sendMessage(data, size, websocketpp::frame::opcode::binary, false, true);
+                }
+                return false;
+            }
             virtual std::string getFromAddress() const
             {
                 return fromAddress;
@@ -798,6 +977,7 @@ namespace pipedal
         public:
             ~WebSocketSession()
             {
+                ReleaseQueuedBytes();
                 if (this->socketHandler)
                 {
                     this->socketHandler->onSocketClosed();
@@ -994,11 +1174,57 @@ namespace pipedal
             addrOnly = address.substr(0,portPos);
             port = address.substr(portPos);
         }
+        bool WantsRequestHandler(server::connection_ptr &con)
+        {
+            try
+            {
+                uri requestUri(con->get_uri()->str().c_str());
+                HttpRequestImpl req(con->get_request());
+                for (auto requestHandler : this->request_handlers)
+                {
+                    if (requestHandler->wants(req.method(), requestUri))
+                    {
+                        return true;
+                    }
+                }
+            }
+            catch (const std::exception &)
+            {
+                // let HandleHttpRequest report it.
+            }
+            return false;
+        }
+
         void on_http(connection_hdl hdl)
         {
             // Upgrade our connection handle to a full connection_ptr
-
             server::connection_ptr con = m_endpoint.get_con_from_hdl(hdl);
+
+            // Dynamic requests (uploads, preset bundle imports, thumbnails) can take a long time,
+            // so they run on the request worker pool, leaving the I/O threads free to service websockets.
+            // Static files are served directly.
+            if (requestWorkerPool && WantsRequestHandler(con))
+            {
+                con->defer_http_response();
+                boost::asio::post(
+                    *requestWorkerPool,
+                    [this, con]() mutable
+                    {
+                        HandleHttpRequest(con);
+                        websocketpp::lib::error_code ec;
+                        con->send_http_response(ec);
+                        if (ec)
+                        {
+                            Lv2Log::debug(SS("Failed to send deferred http response. " << ec.message()));
+                        }
+                    });
+                return;
+            }
+            HandleHttpRequest(con);
+        }
+
+        void HandleHttpRequest(server::connection_ptr con)
+        {
             auto &request = con->get_request();
 
             std::string origin = con->get_request_header(HttpField::origin);
@@ -1092,6 +1318,11 @@ namespace pipedal
                                 ServerError(*con, ec.message());
                                 return;
                             }
+                            if (res.isNotModified())
+                            {
+                                con->set_status(websocketpp::http::status_code::not_modified);
+                                return;
+                            }
                             con->set_status(websocketpp::http::status_code::ok);
                             return;
                         }
@@ -1115,6 +1346,11 @@ namespace pipedal
                                 ServerError(*con, ec.message());
                                 return;
                             }
+                            if (res.isNotModified())
+                            {
+                                con->set_status(websocketpp::http::status_code::not_modified);
+                                return;
+                            }
                             con->set_status(websocketpp::http::status_code::ok);
                             return;
                         }
@@ -1153,9 +1389,7 @@ namespace pipedal
                 }
             }
 
-            std::ifstream file;
             std::filesystem::path filename = con->get_resource();
-            std::string response;
             if (requestUri.segment_count() == 0)
             {
                 filename = this->rootPath / "index.html";
@@ -1172,12 +1406,13 @@ namespace pipedal
 
             std::string mimeType = mime_type(filename);
 
-            std::filesystem::path gzName;
+            std::filesystem::path encodedName;
 
-            if (can_use_gzip_encoding(req.get(HttpField::accept_encoding) ,filename,&gzName) )
-            {   
-                filename = gzName;
-                res.set(HttpField::content_encoding,"gzip");
+            const char *contentEncoding = select_precompressed_encoding(req.get(HttpField::accept_encoding), filename, &encodedName);
+            if (contentEncoding)
+            {
+                filename = encodedName;
+                res.set(HttpField::content_encoding, contentEncoding);
             }
 
             if (req.method() != HttpVerb::get)
@@ -1186,19 +1421,13 @@ namespace pipedal
                 return;
             }
 
-            file.open(filename.c_str(), std::ios::in);
-            if (!file)
+            StaticFileCache::FileStatus fileStatus;
+            if (!StaticFileCache::GetFileStatus(filename, &fileStatus))
             {
                 NotFound(*con, requestUri.str());
                 return;
             }
-
-            file.seekg(0, std::ios::end);
-            response.reserve(file.tellg());
-            file.seekg(0, std::ios::beg);
-
-            response.assign((std::istreambuf_iterator<char>(file)),
-                            std::istreambuf_iterator<char>());
+            std::string etag = fileStatus.ETag();
 
             res.set("Content-Type", mimeType);
 
@@ -1209,9 +1438,28 @@ namespace pipedal
 
             res.set(HttpField::access_control_allow_origin, origin);
             res.set(HttpField::date, HtmlHelper::timeToHttpDate(time(nullptr)));
-            res.setContentLength(response.length());
+            res.set(HttpField::etag, etag);
+            res.set(HttpField::LastModified, HtmlHelper::timeToHttpDate(fileStatus.mtime));
+            res.set(HttpField::vary, HttpField::accept_encoding);
 
-            con->set_body(response);
+            if (req.get(HttpField::if_none_match) == etag)
+            {
+                con->set_status(websocketpp::http::status_code::not_modified);
+                return;
+            }
+
+            auto content = staticFileCache.GetContent(filename, fileStatus);
+            if (content)
+            {
+                res.setContentLength(content->length());
+                con->set_body(*content);
+            }
+            else
+            {
+                // too large to cache: stream it from the file.
+                res.setContentLength(fileStatus.size);
+                res.setBodyFile(filename, false);
+            }
             con->set_status(websocketpp::http::status_code::ok);
         }
 
@@ -1289,7 +1537,13 @@ namespace pipedal
                 m_endpoint.listen(tcp::v6(), (uint16_t)port);
                 m_endpoint.start_accept();
 
-                // Start IOC service threads.
+                if (requestWorkerThreads > 0)
+                {
+                    requestWorkerPool = std::make_unique<boost::asio::thread_pool>(requestWorkerThreads);
+                }
+
+                // Start IOC service threads. (websocketpp runs each connection's handlers on
+                // a per-connection strand, so messages on one websocket stay in order.)
                 std::vector<std::thread> v;
                 v.reserve(threads - 1);
                 for (auto i = threads - 1; i > 0; --i)
@@ -1311,6 +1565,11 @@ namespace pipedal
                 {
                     thread.join();
                 }
+                if (requestWorkerPool)
+                {
+                    requestWorkerPool->join();
+                    requestWorkerPool = nullptr;
+                }
                 Lv2Log::info("Web server terminated.");
             }
             catch (websocketpp::exception const &e)
@@ -1347,6 +1606,10 @@ namespace pipedal
         {
             this->logHttpRequests = enableLogging;
         }
+        virtual void SetRequestWorkerThreads(int threads)
+        {
+            this->requestWorkerThreads = threads;
+        }
 
         virtual void StopListening()
         {
@@ -44,6 +44,7 @@ public:
     virtual void setBodyFile(std::shared_ptr<TemporaryFile>&temporaryFile) = 0;
     virtual void setBodyFile(std::filesystem::path&path, bool deleteWhenDone) = 0;
     virtual void clearBody() = 0; // but leave the file size intact (e.g for a HEAD request).
+    virtual void setNotModified() = 0; // reply with 304 Not Modified, and no body.
 
     virtual void  keepAlive(bool value)  = 0;
 };
@@ -74,12 +75,21 @@ public:
     constexpr static const char * location = "Location";
     constexpr static const char* accept_encoding = "Accept-Encoding";
     constexpr static const char* content_encoding = "Content-Encoding";
+    constexpr static const char* etag = "ETag";
+    constexpr static const char* if_none_match = "If-None-Match";
+    constexpr static const char* vary = "Vary";
 };
 
 
 //xxx move this to HtmlHelpers.
 std::string last_modified(const std::filesystem::path& path);
 
+// The q-value an Accept-Encoding header gives to a content encoding (e.g. "gzip"), or 0 if the encoding is not acceptable.
+double encoding_quality(const std::string&acceptEncodingHeader,const std::string&encoding);
+
+// true if an Accept-Encoding header allows the given content encoding (e.g. "gzip").
+bool encoding_allowed(const std::string&acceptEncodingHeader,const std::string&encoding);
+
 class WebServerImpl;
 
 class SocketHandler {
@@ -90,6 +100,11 @@ public:
         virtual void close() = 0;
 
         virtual void writeCallback(const std::string& text) = 0;
+        virtual void writeBinaryCallback(const void *data, size_t size) = 0;
+        // Telemetry that a newer message will supersede. Returns false if the message was
+        // dropped because the client isn't keeping up.
+        virtual bool writeDroppableCallback(const std::string &text) = 0;
+        virtual bool writeDroppableBinaryCallback(const void *data, size_t size) = 0;
         virtual std::string getFromAddress() const = 0;
     };
 
@@ -101,6 +116,7 @@ public:
     void setWriteCallback(IWriteCallback *writeCallback) {
         writeCallback_ = writeCallback;
     }
+    IWriteCallback *getWriteCallback() const { return writeCallback_; }
 
 public:
     virtual void onSocketClosed() = 0;
@@ -116,6 +132,27 @@ public:
             writeCallback_->writeCallback(text);
         }
     }
+    void sendBinary(const void *data, size_t size) {
+        if (writeCallback_ != nullptr)
+        {
+            writeCallback_->writeBinaryCallback(data, size);
+        }
+    }
+    // Returns false if the message was dropped.
+    bool sendDroppable(const std::string &text) {
+        if (writeCallback_ != nullptr)
+        {
+            return writeCallback_->writeDroppableCallback(text);
+        }
+        return false;
+    }
+    bool sendDroppableBinary(const void *data, size_t size) {
+        if (writeCallback_ != nullptr)
+        {
+            return writeCallback_->writeDroppableBinaryCallback(data, size);
+        }
+        return false;
+    }
     virtual void OnSocketClosed()
     {
         writeCallback_ = nullptr;
@@ -233,11 +270,18 @@ public:
 
 };
 
+// Bytes waiting in websocket send buffers, summed over all sessions (as of each session's last send).
+size_t GetWebSocketQueuedBytes();
+// Sessions that were disconnected because they stopped reading.
+uint64_t GetWebSocketStalledDisconnects();
+
 class WebServer {
 public:
     virtual ~WebServer() { }
 
     virtual void SetLogHttpRequests(bool enableLogging) = 0;
+    // Threads that run RequestHandlers, off the I/O threads. 0 to run them on the I/O threads. Call before RunInBackground().
+    virtual void SetRequestWorkerThreads(int threads) = 0;
     virtual void DisplayIpAddresses() = 0;
 
     virtual void AddRequestHandler(std::shared_ptr<RequestHandler> requestHandler) = 0;
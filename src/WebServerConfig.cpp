@@ -40,6 +40,8 @@
 #include "util.hpp"
 #include "HtmlHelper.hpp"
 #include "WebServerMod.hpp"
+#include "MetricsPage.hpp"
+#include "Tracer.hpp"
 
 #define OLD_PRESET_EXTENSION ".piPreset"
 #define PRESET_EXTENSION ".piPreset"
@@ -104,6 +106,26 @@ static bool IsZipFile(const std::filesystem::path &path)
     return c[0] == 0x50 && c[1] == 0x4B && c[2] == 0x03 && c[3] == 0x04;
 }
 
+// Forwards preset bundle progress to clients, limited to whole-percent changes.
+static PresetBundleProgressCallback MakeProgressCallback(PiPedalModel *model, const std::string &operation)
+{
+    auto lastPercent = std::make_shared<int>(-1);
+    return [model, operation, lastPercent](uint64_t bytesProcessed, uint64_t bytesTotal)
+    {
+        int percent = bytesTotal == 0 ? 100 : (int)(bytesProcessed * 100 / bytesTotal);
+        if (percent == *lastPercent)
+        {
+            return;
+        }
+        *lastPercent = percent;
+        PresetBundleProgress progress;
+        progress.operation_ = operation;
+        progress.bytesProcessed_ = bytesProcessed;
+        progress.bytesTotal_ = bytesTotal;
+        model->FirePresetBundleProgress(progress);
+    };
+}
+
 class ExtensionChecker
 {
 public:
@@ -189,6 +211,10 @@ public:
         {
             return true;
         }
+        else if (segment == "AudioPeaks")
+        {
+            return true;
+        }
         else if (segment == "Tone3000Auth")
         {
             return true;
@@ -250,7 +276,7 @@ public:
     void GetPluginPresets(const uri &request_uri, std::string *pName, std::string *pContent)
     {
         std::string pluginUri = request_uri.query("id");
-        auto plugin = model->GetPluginHost().GetPluginInfo(pluginUri);
+        auto plugin = model->GetPluginInfo(pluginUri);
         *pName = plugin->name();
 
         PluginPresets pluginPresets = model->GetPluginPresets(pluginUri);
@@ -338,6 +364,7 @@ public:
 
                 TemporaryFile tmpFile{WEB_TEMP_DIR};
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePluginPresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile.Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile.Path());
 
@@ -356,6 +383,7 @@ public:
 
                 TemporaryFile tmpFile{WEB_TEMP_DIR};
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile.Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile.Path());
 
@@ -373,6 +401,7 @@ public:
 
                 TemporaryFile tmpFile{WEB_TEMP_DIR};
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile.Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile.Path());
 
@@ -472,6 +501,7 @@ public:
 
                 std::shared_ptr<TemporaryFile> tmpFile = std::make_shared<TemporaryFile>(WEB_TEMP_DIR);
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePluginPresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile->Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile->Path());
 
@@ -489,6 +519,7 @@ public:
 
                 std::shared_ptr<TemporaryFile> tmpFile = std::make_shared<TemporaryFile>(WEB_TEMP_DIR);
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile->Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile->Path());
 
@@ -506,6 +537,7 @@ public:
 
                 std::shared_ptr<TemporaryFile> tmpFile = std::make_shared<TemporaryFile>(WEB_TEMP_DIR);
                 PresetBundleWriter::ptr presetbundleWriter = PresetBundleWriter::CreatePresetsFile(*(this->model), content);
+                presetbundleWriter->SetProgressCallback(MakeProgressCallback(this->model, "export"));
                 presetbundleWriter->WriteToFile(tmpFile->Path());
                 size_t contentLength = std::filesystem::file_size(tmpFile->Path());
 
@@ -551,6 +583,30 @@ public:
                 // If we get here, the file was not found in the directory.
                 throw PiPedalException("File not found in directory.");
             }
+            else if (segment == "AudioPeaks")
+            {
+                fs::path path = model->GetStorage().FromAbstractPathString(request_uri.query("path"));
+
+                if (!fs::exists(path) || !this->model->IsInUploadsDirectory(path) || HasDotDot(path))
+                {
+                    throw PiPedalException("File not found.");
+                }
+                AudioDirectoryInfo::Ptr audioDirectory = CreateDirectoryInfo(path.parent_path());
+                audioDirectory->GetFiles(); // ensure that the .index file is up to date.
+                std::vector<uint8_t> peaks = audioDirectory->GetPeaks(path.filename());
+
+                std::string etag = SS('"' << std::hex << HtmlHelper::crc64(peaks.data(), peaks.size()) << '"');
+                res.set(HttpField::content_type, "application/octet-stream");
+                res.set(HttpField::cache_control, "no-cache");
+                res.set(HttpField::etag, etag);
+                if (req.get(HttpField::if_none_match) == etag)
+                {
+                    res.setNotModified();
+                    return;
+                }
+                res.setContentLength(peaks.size());
+                res.setBody(std::string((const char *)peaks.data(), peaks.size()));
+            }
             else if (segment == "Thumbnail")
             {
                 ThumbnailTemporaryFile thumbnailTemporaryFile;
@@ -788,6 +844,7 @@ public:
                 if (IsZipFile(filePath))
                 {
                     auto presetReader = PresetBundleReader::LoadPluginPresetsFile(*(this->model), filePath);
+                    presetReader->SetProgressCallback(MakeProgressCallback(this->model, "import"));
                     presetReader->ExtractMediaFiles();
 
                     std::stringstream ss(presetReader->GetPluginPresetsJson());
@@ -823,6 +880,7 @@ public:
                 if (IsZipFile(filePath))
                 {
                     auto presetReader = PresetBundleReader::LoadPresetsFile(*(this->model), filePath);
+                    presetReader->SetProgressCallback(MakeProgressCallback(this->model, "import"));
                     presetReader->ExtractMediaFiles();
 
                     std::stringstream ss(presetReader->GetPresetJson());
@@ -865,6 +923,7 @@ public:
                 if (IsZipFile(filePath))
                 {
                     auto presetReader = PresetBundleReader::LoadPresetsFile(*(this->model), filePath);
+                    presetReader->SetProgressCallback(MakeProgressCallback(this->model, "import"));
                     presetReader->ExtractMediaFiles();
 
                     std::stringstream ss(presetReader->GetPresetJson());
@@ -970,7 +1029,16 @@ public:
                     }
                     else
                     {
-                        outputFileName = this->model->UploadUserFile(directory, instanceId, patchProperty, filename, req.get_body_input_stream(), req.content_length());
+                        if (req.content_length() == 0)
+                        {
+                            outputFileName = this->model->UploadUserFile(directory, instanceId, patchProperty, filename, req.get_body_input_stream(), 0);
+                        }
+                        else
+                        {
+                            // the body has already been spooled to disk in bounded chunks; move it into place.
+                            outputFileName = this->model->UploadUserFile(directory, instanceId, patchProperty, filename, req.get_body_temporary_file(), req.content_length());
+                            FileSystemSync();
+                        }
                     }
 
                     if (outputFileName.is_relative())
@@ -1120,6 +1188,305 @@ public:
     }
 };
 
+/*
+   The plugin catalog (the same json as the websocket "plugins" request). Clients request
+   /var/pluginCatalog?v=<version>, where version (a hash of the content) comes from the websocket
+   "pluginCatalogVersion" request, so the browser cache can answer reconnects until plugins change.
+*/
+class PluginCatalogIntercept : public RequestHandler
+{
+    PiPedalModel *model;
+
+public:
+    PluginCatalogIntercept(PiPedalModel *model)
+        : RequestHandler("/var/pluginCatalog"),
+          model(model)
+    {
+    }
+    virtual ~PluginCatalogIntercept() {}
+
+private:
+    // Returns the body to send, or nullptr if the client's copy is current.
+    std::shared_ptr<const std::string> SetHeaders(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res)
+    {
+        PiPedalModel::PluginCatalog catalog = model->GetPluginCatalog();
+
+        bool useGzip = catalog.gzipJson && encoding_allowed(req.get(HttpField::accept_encoding), "gzip");
+        std::string etag = "\"" + catalog.version + (useGzip ? "-gz\"" : "\"");
+
+        res.set(HttpField::content_type, "application/json");
+        res.set(HttpField::etag, etag);
+        res.set(HttpField::vary, HttpField::accept_encoding);
+        if (request_uri.query("v") == catalog.version)
+        {
+            res.set(HttpField::cache_control, CACHE_CONTROL_INDEFINITELY);
+        }
+        else
+        {
+            res.set(HttpField::cache_control, "no-cache");
+        }
+        if (req.get(HttpField::if_none_match) == etag)
+        {
+            res.setNotModified();
+            return nullptr;
+        }
+        if (useGzip)
+        {
+            res.set(HttpField::content_encoding, "gzip");
+            return catalog.gzipJson;
+        }
+        return catalog.json;
+    }
+
+public:
+    virtual void head_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        auto body = SetHeaders(request_uri, req, res);
+        if (body)
+        {
+            res.setContentLength(body->length());
+        }
+    }
+
+    virtual void get_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        auto body = SetHeaders(request_uri, req, res);
+        if (body)
+        {
+            res.setContentLength(body->length());
+            res.setBody(*body);
+        }
+    }
+};
+
+/*
+   Audio status metrics in Prometheus text format, read from the shared metrics page.
+*/
+class MetricsIntercept : public RequestHandler
+{
+public:
+    MetricsIntercept()
+        : RequestHandler("/var/metrics")
+    {
+    }
+    virtual ~MetricsIntercept() {}
+
+private:
+    std::string SetHeaders(HttpResponse &res)
+    {
+        std::string body = MetricsPage::ToPrometheusText(MetricsPage::GetInstance().Read());
+        res.set(HttpField::content_type, "text/plain; version=0.0.4; charset=utf-8");
+        res.set(HttpField::cache_control, "no-cache");
+        res.setContentLength(body.length());
+        return body;
+    }
+
+public:
+    virtual void head_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        SetHeaders(res);
+    }
+
+    virtual void get_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        res.setBody(SetHeaders(res));
+    }
+};
+
+/*
+   Resources for incremental bank sync between PiPedal servers (see BankSync.hpp):
+
+      /var/sync/manifest                          content hashes of all presets, and of the media files they use.
+      /var/sync/preset?bank=<name>&preset=<name>  a preset (json).
+      /var/sync/media?hash=<hash>                 a media file, by content hash.
+*/
+class BankSyncIntercept : public RequestHandler
+{
+    PiPedalModel *model;
+
+public:
+    BankSyncIntercept(PiPedalModel *model)
+        : RequestHandler("/var/sync"),
+          model(model)
+    {
+    }
+    virtual ~BankSyncIntercept() {}
+
+private:
+    // Returns the json body, or sets *pFile for media files.
+    std::string SetHeaders(const uri &request_uri, HttpResponse &res, std::filesystem::path *pFile)
+    {
+        std::string segment = request_uri.segment_count() == 3 ? request_uri.segment(2) : "";
+        res.set(HttpField::cache_control, "no-cache");
+        if (segment == "media")
+        {
+            *pFile = model->GetBankSyncMediaFile(request_uri.query("hash"));
+            if (pFile->empty())
+            {
+                throw PiPedalException("Not found");
+            }
+            res.set(HttpField::content_type, "application/octet-stream");
+            res.setContentLength(std::filesystem::file_size(*pFile));
+            return "";
+        }
+        std::ostringstream s;
+        json_writer writer(s, true);
+        if (segment == "manifest")
+        {
+            writer.write(model->GetBankSyncManifest());
+        }
+        else if (segment == "preset")
+        {
+            writer.write(model->GetBankSyncPreset(request_uri.query("bank"), request_uri.query("preset")));
+        }
+        else
+        {
+            throw PiPedalException("Not found");
+        }
+        std::string body = s.str();
+        res.set(HttpField::content_type, "application/json");
+        res.setContentLength(body.length());
+        return body;
+    }
+
+    void SetError(const std::exception &e, std::error_code &ec)
+    {
+        if (strcmp(e.what(), "Not found") == 0 || strcmp(e.what(), "Preset not found.") == 0 || strcmp(e.what(), "Bank not found.") == 0)
+        {
+            ec = boost::system::errc::make_error_code(boost::system::errc::no_such_file_or_directory);
+        }
+        else
+        {
+            ec = boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+        }
+    }
+
+public:
+    virtual void head_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        try
+        {
+            std::filesystem::path file;
+            SetHeaders(request_uri, res, &file);
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e, ec);
+        }
+    }
+
+    virtual void get_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        try
+        {
+            std::filesystem::path file;
+            std::string body = SetHeaders(request_uri, res, &file);
+            if (!file.empty())
+            {
+                res.setBodyFile(file, false);
+            }
+            else
+            {
+                res.setBody(body);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e, ec);
+        }
+    }
+};
+
+class TraceIntercept : public RequestHandler
+{
+public:
+    TraceIntercept()
+        : RequestHandler("/var/trace")
+    {
+    }
+    virtual ~TraceIntercept() {}
+
+private:
+    std::string SetHeaders(const uri &request_uri, HttpResponse &res)
+    {
+        // ?enable=1 or ?enable=0 starts or stops tracing. Otherwise, return the trace (Chrome JSON trace format).
+        std::string enable = request_uri.query("enable");
+        std::string body;
+        if (enable.length() != 0)
+        {
+            if (enable == "0" || enable == "false")
+            {
+                Tracer::Stop();
+                body = "Tracing stopped.\n";
+            }
+            else
+            {
+                Tracer::Start();
+                body = "Tracing started.\n";
+            }
+            res.set(HttpField::content_type, "text/plain; charset=utf-8");
+        }
+        else
+        {
+            std::stringstream s;
+            Tracer::WriteTrace(s);
+            body = s.str();
+            res.set(HttpField::content_type, "application/json");
+            res.set(HttpField::content_disposition, "attachment; filename=\"pipedal_trace.json\"");
+        }
+        res.set(HttpField::cache_control, "no-cache");
+        res.setContentLength(body.length());
+        return body;
+    }
+
+public:
+    virtual void head_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        res.set(HttpField::content_type, "application/json");
+        res.set(HttpField::cache_control, "no-cache");
+    }
+
+    virtual void get_response(
+        const uri &request_uri,
+        HttpRequest &req,
+        HttpResponse &res,
+        std::error_code &ec) override
+    {
+        res.setBody(SetHeaders(request_uri, res));
+    }
+};
+
 void pipedal::ConfigureWebServer(
     WebServer &server,
     PiPedalModel &model,
@@ -1129,6 +1496,18 @@ void pipedal::ConfigureWebServer(
     std::shared_ptr<RequestHandler> interceptConfig{new InterceptConfig(port, maxUploadSize)};
     server.AddRequestHandler(interceptConfig);
 
+    std::shared_ptr<PluginCatalogIntercept> pluginCatalogIntercept = std::make_shared<PluginCatalogIntercept>(&model);
+    server.AddRequestHandler(pluginCatalogIntercept);
+
+    std::shared_ptr<MetricsIntercept> metricsIntercept = std::make_shared<MetricsIntercept>();
+    server.AddRequestHandler(metricsIntercept);
+
+    std::shared_ptr<TraceIntercept> traceIntercept = std::make_shared<TraceIntercept>();
+    server.AddRequestHandler(traceIntercept);
+
+    std::shared_ptr<BankSyncIntercept> bankSyncIntercept = std::make_shared<BankSyncIntercept>(&model);
+    server.AddRequestHandler(bankSyncIntercept);
+
     std::shared_ptr<DownloadIntercept> downloadIntercept = std::make_shared<DownloadIntercept>(&model);
     server.AddRequestHandler(downloadIntercept);
 
@@ -23,11 +23,16 @@
 
 #include "WebServerMod.hpp"
 #include <filesystem>
+#include <map>
+#include <mutex>
 #include "json_variant.hpp"
 #include "ss.hpp"
 #include "ModTemplateGenerator.hpp"
 #include "HtmlHelper.hpp"
 #include "MimeTypes.hpp"
+#include "StaticFileCache.hpp"
+#include "CacheRegistry.hpp"
+#include "GzipCompress.hpp"
 
 using namespace pipedal;
 namespace fs = std::filesystem;
@@ -48,6 +53,12 @@ namespace pipedal::impl
             : super("/resources"),
               model(model)
         {
+            cacheRegistration = CacheRegistry::GetInstance().Register(
+                "ModGui templates", CachePriority::Regenerable,
+                [this]()
+                { return GetGeneratedTemplateBytes(); },
+                [this](TrimLevel)
+                { ClearGeneratedTemplates(); });
         }
         virtual bool wants(const std::string &method, const uri &request_uri) const override;
 
@@ -64,9 +75,68 @@ namespace pipedal::impl
             std::error_code &ec) override;
 
     private:
-        std::string GenerateTemplate(
+        struct GeneratedTemplate
+        {
+            std::shared_ptr<Lv2PluginInfo> pluginInfo; // plugin reloads produce a new Lv2PluginInfo.
+            ModTemplate::ptr modTemplate;              // changes when the template file changes.
+            std::shared_ptr<const std::string> content;
+            std::shared_ptr<const std::string> gzipContent; // null if compression failed.
+            std::string etag;
+        };
+
+        // Where a resource request resolves to, memoized because a board with several MOD GUIs
+        // requests dozens of resources on each load.
+        struct ResolvedResource
+        {
+            std::shared_ptr<Lv2PluginInfo> pluginInfo; // plugin reloads produce a new Lv2PluginInfo.
+            fs::path path;
+            std::string mimeType;
+        };
+        std::mutex resolvedResourcesMutex;
+        std::map<std::pair<std::string, std::string>, ResolvedResource> resolvedResources; // by (plugin uri, resource).
+
+        // Contents of small resource files. Entries are revalidated with a stat on each request.
+        StaticFileCache resourceFileCache{8 * 1024 * 1024, 512 * 1024, "ModGui resources"};
+
+        // false if the resource doesn't exist.
+        bool ResolveResource(
+            const uri &request_uri,
+            const std::string &ns,
+            std::shared_ptr<Lv2PluginInfo> pluginInfo,
+            ResolvedResource *result);
+
+        void SendResourceFile(
+            HttpRequest &req,
+            HttpResponse &res,
+            const ResolvedResource &resource);
+
+        // Generated content depends only on the plugin and template file, so it is shared by
+        // all instances of a plugin, and all requests for it.
+        std::mutex generatedTemplatesMutex;
+        std::map<std::pair<std::string, fs::path>, GeneratedTemplate> generatedTemplates; // by (plugin uri, template file).
+
+        GeneratedTemplate GetGeneratedTemplate(
             const fs::path &templateFile,
-            std::shared_ptr<Lv2PluginInfo> pluginInfo);
+            std::shared_ptr<Lv2PluginInfo> pluginInfo,
+            ModGui::ptr modGui);
+
+        void SendGeneratedTemplate(
+            HttpRequest &req,
+            HttpResponse &res,
+            const std::string &mimeType,
+            const fs::path &templateFile,
+            std::shared_ptr<Lv2PluginInfo> pluginInfo,
+            ModGui::ptr modGui);
+
+        std::string GenerateTemplate(
+            const ModTemplate &modTemplate,
+            std::shared_ptr<Lv2PluginInfo> pluginInfo,
+            const ModGui &modGui);
+
+        size_t GetGeneratedTemplateBytes();
+        void ClearGeneratedTemplates();
+
+        CacheRegistry::Registration::ptr cacheRegistration; // declared last, so that it's destroyed first.
     };
 }
 
@@ -96,20 +166,16 @@ void ModWebInterceptImpl::head_response(
     res.clearBody();
 }
 
-static void setCacheControl(HttpResponse &res, const fs::path &path)
+static const char *RESOURCE_CACHE_CONTROL = "public, max-age=31536000"; // 1 year. URLs are cache-busted with the plugin version.
+
+static bool isNotModified(HttpRequest &req, HttpResponse &res, const std::string &etag)
 {
-    if (fs::exists(path))
-    {
-        res.set("Cache-Control", "public, max-age=31536000"); // 1 month
-        auto lastModified = std::filesystem::last_write_time(path);
-        res.set(HttpField::LastModified, HtmlHelper::timeToHttpDate(lastModified));
-        // Set ETag for cache validation
-        res.set("ETag", pipedal::HtmlHelper::generateEtag(path));
-    }
-    else
+    if (!etag.empty() && req.get(HttpField::if_none_match) == etag)
     {
-        res.set("Cache-Control", "no-cache, no-store, must-revalidate");
+        res.setNotModified();
+        return true;
     }
+    return false;
 }
 void ModWebInterceptImpl::get_response(
     const uri &request_uri,
@@ -127,14 +193,10 @@ void ModWebInterceptImpl::get_response(
         if (!ns.empty())
         {
             pluginInfo = model->GetPluginInfo(ns);
-            if (!pluginInfo)
-            {
-                throw std::runtime_error("Plugin not found.");
-            }
         }
-        if (!pluginInfo->modGui())
+        if (!pluginInfo)
         {
-            throw std::runtime_error("Plugin does not have a ModGui.");
+            throw std::runtime_error("Plugin not found.");
         }
         if (request_uri.segment_count() < 2)
         {
@@ -143,112 +205,35 @@ void ModWebInterceptImpl::get_response(
         if (request_uri.segment(0) != "resources")
         {
             throw std::runtime_error("Invalid request URI: expected 'resources'.");
-        }   
-        std::string segment = request_uri.segment(1);
-        if (segment == "_")
+        }
+        if (request_uri.segment(1) == "_" && request_uri.segment_count() >= 3)
         {
-            segment = request_uri.segment(2);
-            if (segment == "iconTemplate")
-            {
-                res.set("Content-Type", "text/html");
-                res.setBody(GenerateTemplate(
-                    pluginInfo->modGui()->iconTemplate(),
-                    pluginInfo));
-                setCacheControl(res, pluginInfo->modGui()->iconTemplate());
-            }
-            else if (segment == "stylesheet")
-            {
-                res.set("Content-Type", "text/css");
-                res.setBody(GenerateTemplate(
-                    pluginInfo->modGui()->stylesheet(),
-                    pluginInfo));
-                setCacheControl(res, pluginInfo->modGui()->stylesheet());
-
-            }
-
-            else if (segment == "screenshot")
-            {
-                std::filesystem::path path = pluginInfo->modGui()->screenshot();
-                if (!fs::exists(path))
-                {
-                    ec =  std::make_error_code(std::errc::no_such_file_or_directory);
-                    return;
-                }
-                if (!fs::is_regular_file(path))
-                {
-                    throw std::runtime_error("Screenshot is not a regular file: " + path.string());
-                }
-
-                size_t size = fs::file_size(path);
-                std::string mimeType = MimeTypes::instance().MimeTypeFromExtension(path.extension().string());
-                if (mimeType.empty())
-                {
-                    throw std::runtime_error("Unknown file type for screenshot: " + path.string());
-                }
-                res.setBodyFile(
-                    path,
-                    false); // delete when done
-                res.set("Content-Type", mimeType);
-                res.setContentLength(size);
-                setCacheControl(res, path);
-
-            }
-            else if (segment == "thumbnail")
+            std::string segment = request_uri.segment(2);
+            if (segment == "iconTemplate" || segment == "stylesheet")
             {
-                std::filesystem::path path = pluginInfo->modGui()->thumbnail();
-                if (!fs::exists(path))
+                ModGui::ptr modGui = model->GetModGui(ns);
+                if (!modGui)
                 {
-                    throw std::runtime_error("Thumbnail not found: " + path.string());
+                    throw std::runtime_error("Plugin does not have a ModGui.");
                 }
-                if (!fs::is_regular_file(path))
+                if (segment == "iconTemplate")
                 {
-                    throw std::runtime_error("Thumbnail is not a regular file: " + path.string());
+                    SendGeneratedTemplate(req, res, "text/html", modGui->iconTemplate(), pluginInfo, modGui);
                 }
-
-                size_t size = fs::file_size(path);
-                std::string mimeType = MimeTypes::instance().MimeTypeFromExtension(path.extension().string());
-                if (mimeType.empty())
+                else
                 {
-                    throw std::runtime_error("Unknown file type for thumbnail: " + path.string());
+                    SendGeneratedTemplate(req, res, "text/css", modGui->stylesheet(), pluginInfo, modGui);
                 }
-                res.setBodyFile(
-                    path,
-                    false); // delete when done
-                res.set("Content-Type", mimeType);
-                setCacheControl(res, path);
-                res.setContentLength(size);
-            } else {
-                throw std::runtime_error("Unknown resource: _/" + segment);
+                return;
             }
         }
-        else
+        ResolvedResource resource;
+        if (!ResolveResource(request_uri, ns, pluginInfo, &resource))
         {
-            // a request for a plugin resource file.
-            fs::path resourcefile = pluginInfo->modGui()->resourceDirectory();
-            for (size_t i = 1; i < request_uri.segment_count(); ++i)
-            {
-                resourcefile /= request_uri.segment(i);
-            }
-            if (!fs::exists(resourcefile) && !fs::is_regular_file(resourcefile))
-            {
-                ec =  std::make_error_code(std::errc::no_such_file_or_directory);
-                return;
-            }
-            size_t size = fs::file_size(resourcefile);
-            std::string mimeType = MimeTypes::instance().MimeTypeFromExtension(resourcefile.extension().string());
-            if (mimeType.empty())
-            {
-                throw std::runtime_error("Unknown file type for resource: " + resourcefile.string());
-            }
-            res.setBodyFile(
-                resourcefile,
-                false); // delete when done
-            res.set("Content-Type", mimeType);
-            Lv2Log::debug(SS("ModWebIntercept: Serving resource file: " << resourcefile.string() << " (" << size << " bytes)"));
-            Lv2Log::debug(SS("    url: " << request_uri.str()));
-            setCacheControl(res, resourcefile);
-            res.setContentLength(size);
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return;
         }
+        SendResourceFile(req, res, resource);
     }
     catch (const std::exception &e)
     {
@@ -258,6 +243,125 @@ void ModWebInterceptImpl::get_response(
     }
 }
 
+bool ModWebInterceptImpl::ResolveResource(
+    const uri &request_uri,
+    const std::string &ns,
+    std::shared_ptr<Lv2PluginInfo> pluginInfo,
+    ResolvedResource *result)
+{
+    std::string resourceKey;
+    for (size_t i = 1; i < request_uri.segment_count(); ++i)
+    {
+        resourceKey += '/';
+        resourceKey += request_uri.segment(i);
+    }
+    auto key = std::make_pair(ns, resourceKey);
+    {
+        std::lock_guard<std::mutex> lock(resolvedResourcesMutex);
+        auto ff = resolvedResources.find(key);
+        if (ff != resolvedResources.end() && ff->second.pluginInfo == pluginInfo)
+        {
+            *result = ff->second;
+            return true;
+        }
+    }
+
+    ModGui::ptr modGui = model->GetModGui(ns);
+    if (!modGui)
+    {
+        throw std::runtime_error("Plugin does not have a ModGui.");
+    }
+    fs::path path;
+    std::string segment = request_uri.segment(1);
+    if (segment == "_")
+    {
+        if (request_uri.segment_count() < 3)
+        {
+            throw std::runtime_error("Invalid request URI.");
+        }
+        segment = request_uri.segment(2);
+        if (segment == "screenshot")
+        {
+            path = modGui->screenshot();
+        }
+        else if (segment == "thumbnail")
+        {
+            path = modGui->thumbnail();
+        }
+        else
+        {
+            throw std::runtime_error("Unknown resource: _/" + segment);
+        }
+    }
+    else
+    {
+        // a request for a plugin resource file.
+        path = modGui->resourceDirectory();
+        for (size_t i = 1; i < request_uri.segment_count(); ++i)
+        {
+            path /= request_uri.segment(i);
+        }
+    }
+    if (!fs::exists(path))
+    {
+        return false;
+    }
+    if (!fs::is_regular_file(path))
+    {
+        throw std::runtime_error("Resource is not a regular file: " + path.string());
+    }
+    std::string mimeType = MimeTypes::instance().MimeTypeFromExtension(path.extension().string());
+    if (mimeType.empty())
+    {
+        throw std::runtime_error("Unknown file type for resource: " + path.string());
+    }
+
+    result->pluginInfo = pluginInfo;
+    result->path = path;
+    result->mimeType = mimeType;
+
+    std::lock_guard<std::mutex> lock(resolvedResourcesMutex);
+    resolvedResources[key] = *result;
+    return true;
+}
+
+void ModWebInterceptImpl::SendResourceFile(
+    HttpRequest &req,
+    HttpResponse &res,
+    const ResolvedResource &resource)
+{
+    StaticFileCache::FileStatus fileStatus;
+    if (!StaticFileCache::GetFileStatus(resource.path, &fileStatus))
+    {
+        throw std::runtime_error("File not found: " + resource.path.string());
+    }
+    std::string etag = fileStatus.ETag();
+
+    res.set("Content-Type", resource.mimeType);
+    res.set("Cache-Control", RESOURCE_CACHE_CONTROL);
+    res.set(HttpField::LastModified, HtmlHelper::timeToHttpDate(fileStatus.mtime));
+    res.set("ETag", etag);
+    if (isNotModified(req, res, etag))
+    {
+        return;
+    }
+    auto content = resourceFileCache.GetContent(resource.path, fileStatus);
+    if (content)
+    {
+        res.setContentLength(content->length());
+        res.setBody(*content);
+    }
+    else
+    {
+        // too large to cache: stream it from the file.
+        fs::path path = resource.path;
+        res.setBodyFile(
+            path,
+            false); // delete when done
+        res.setContentLength(fileStatus.size);
+    }
+}
+
 static std::string makeCns(const std::string &encodedUri, int64_t instanceId)
 {
     std::stringstream ss;
@@ -284,16 +388,105 @@ static std::string makeCns(const std::string &encodedUri, int64_t instanceId)
     return ss.str();
 }
 
-std::string ModWebInterceptImpl::GenerateTemplate(
+size_t ModWebInterceptImpl::GetGeneratedTemplateBytes()
+{
+    std::lock_guard lock{generatedTemplatesMutex};
+    size_t result = 0;
+    for (const auto &[key, generatedTemplate] : generatedTemplates)
+    {
+        result += generatedTemplate.content ? generatedTemplate.content->size() : 0;
+        result += generatedTemplate.gzipContent ? generatedTemplate.gzipContent->size() : 0;
+    }
+    return result;
+}
+
+void ModWebInterceptImpl::ClearGeneratedTemplates()
+{
+    {
+        std::lock_guard lock{generatedTemplatesMutex};
+        generatedTemplates.clear();
+    }
+    std::lock_guard lock{resolvedResourcesMutex};
+    resolvedResources.clear();
+}
+
+ModWebInterceptImpl::GeneratedTemplate ModWebInterceptImpl::GetGeneratedTemplate(
     const fs::path &templateFile,
-    std::shared_ptr<Lv2PluginInfo> pluginInfo)
+    std::shared_ptr<Lv2PluginInfo> pluginInfo,
+    ModGui::ptr modGui)
 {
     if (!fs::exists(templateFile))
     {
         throw std::runtime_error("File not found. " + templateFile.string());
     }
+    ModTemplate::ptr modTemplate = ModTemplate::Load(templateFile);
 
-    json_variant context = MakeModGuiTemplateData(pluginInfo);
+    auto key = std::make_pair(pluginInfo->uri(), templateFile);
+    {
+        std::lock_guard<std::mutex> lock(generatedTemplatesMutex);
+        auto ff = generatedTemplates.find(key);
+        if (ff != generatedTemplates.end() && ff->second.pluginInfo == pluginInfo && ff->second.modTemplate == modTemplate)
+        {
+            return ff->second;
+        }
+    }
+
+    GeneratedTemplate result;
+    result.pluginInfo = pluginInfo;
+    result.modTemplate = modTemplate;
+    result.content = std::make_shared<const std::string>(GenerateTemplate(*modTemplate, pluginInfo, *modGui));
+    result.gzipContent = GzipCompress(*result.content);
+    result.etag = SS('"' << std::hex << HtmlHelper::crc64(*result.content) << '"');
+
+    std::lock_guard<std::mutex> lock(generatedTemplatesMutex);
+    generatedTemplates[key] = result;
+    return result;
+}
+
+void ModWebInterceptImpl::SendGeneratedTemplate(
+    HttpRequest &req,
+    HttpResponse &res,
+    const std::string &mimeType,
+    const fs::path &templateFile,
+    std::shared_ptr<Lv2PluginInfo> pluginInfo,
+    ModGui::ptr modGui)
+{
+    GeneratedTemplate generated = GetGeneratedTemplate(templateFile, pluginInfo, modGui);
+
+    bool useGzip = generated.gzipContent && encoding_allowed(req.get(HttpField::accept_encoding), "gzip");
+    // the content also depends on the plugin, so the etag is derived from the content, not the template file.
+    std::string etag = generated.etag;
+    if (useGzip)
+    {
+        etag.insert(etag.length() - 1, "-gz");
+    }
+
+    res.set("Content-Type", mimeType);
+    res.set("Cache-Control", RESOURCE_CACHE_CONTROL);
+    res.set("ETag", etag);
+    res.set(HttpField::vary, HttpField::accept_encoding);
+    if (isNotModified(req, res, etag))
+    {
+        return;
+    }
+    if (useGzip)
+    {
+        res.set(HttpField::content_encoding, "gzip");
+        res.setContentLength(generated.gzipContent->length());
+        res.setBody(*generated.gzipContent);
+    }
+    else
+    {
+        res.setBody(*generated.content);
+    }
+}
+
+std::string ModWebInterceptImpl::GenerateTemplate(
+    const ModTemplate &modTemplate,
+    std::shared_ptr<Lv2PluginInfo> pluginInfo,
+    const ModGui &modGui)
+{
+    json_variant context = MakeModGuiTemplateData(pluginInfo, modGui);
     int64_t version = pluginInfo->minorVersion() * 1000 +
                       pluginInfo->microVersion();
 
@@ -304,7 +497,5 @@ std::string ModWebInterceptImpl::GenerateTemplate(
     std::string cns = makeCns(encodedUri, version);
     context["_cns"] = cns;
 
-    return GenerateFromTemplateFile(
-        templateFile,
-        context);
+    return modTemplate.Render(context);
 }
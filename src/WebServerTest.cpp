@@ -54,3 +54,18 @@ TEST_CASE("WebServer shutdown", "[webServerShutdown][Build][Dev]")
     }
 
 }
+
+TEST_CASE("Accept-Encoding quality", "[acceptEncoding][Build][Dev]")
+{
+    REQUIRE(encoding_quality("gzip, deflate, br", "br") == 1.0);
+    REQUIRE(encoding_quality("gzip, deflate", "br") == 0);
+    REQUIRE(encoding_quality("gzip;q=0.8, br;q=0.5", "br") == 0.5);
+    REQUIRE(encoding_quality("gzip;q=0.8, br;q=0.5", "gzip") == 0.8);
+    REQUIRE(encoding_quality("br;q=0, *;q=0.3", "br") == 0);
+    REQUIRE(encoding_quality("br;q=0, *;q=0.3", "gzip") == 0.3);
+    REQUIRE(encoding_quality("x-gzip", "gzip") == 0);
+
+    REQUIRE(encoding_allowed("gzip, br", "gzip"));
+    REQUIRE(!encoding_allowed("gzip;q=0, br", "gzip"));
+    REQUIRE(!encoding_allowed("", "gzip"));
+}
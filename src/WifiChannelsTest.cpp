@@ -170,6 +170,9 @@ void TestBookwormRegDbLoad()
     std::filesystem::path dbPath = "test_data/debian_bookworm_regulatory.db";
     RegDb regdb{dbPath};
     REQUIRE(regdb.IsValid());
+    REQUIRE(regdb.IsCurrent());
+    REQUIRE(regdb.getWifiRegulations("CA").reg_alpha2 == "CA");
+    REQUIRE(regdb.getWifiRegulations("US").reg_alpha2 == "US");
 }
 void TestP2pChannels()
 {
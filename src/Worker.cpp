@@ -35,38 +35,94 @@
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "Worker.hpp"
-#include <mutex>
+#include <algorithm>
+#include <climits>
 #include <lv2/lv2plug.in/ns/ext/worker/worker.h>
 #include "Lv2Log.hpp"
 #include <iostream>
 #include <utility>
 #include "util.hpp"
 #include "SchedulerPriority.hpp"
+#include "Tracer.hpp"
+
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 using namespace pipedal;
 
 const int RING_BUFFER_SIZE = 64 * 1024;
 
+static inline void futex_wait(std::atomic<uint32_t> *address, uint32_t expectedValue)
+{
+    syscall(SYS_futex, (uint32_t *)address, FUTEX_WAIT_PRIVATE, expectedValue, nullptr, nullptr, 0);
+}
+static inline void futex_wake(std::atomic<uint32_t> *address)
+{
+    syscall(SYS_futex, (uint32_t *)address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static inline int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Request ring packets: RequestHeader, followed by the request data.
+struct RequestHeader
+{
+    uint32_t size;
+    int64_t scheduledNs;
+};
+
+JSON_MAP_BEGIN(Lv2WorkerStats)
+JSON_MAP_REFERENCE(Lv2WorkerStats, threads)
+JSON_MAP_REFERENCE(Lv2WorkerStats, workers)
+JSON_MAP_REFERENCE(Lv2WorkerStats, requests)
+JSON_MAP_REFERENCE(Lv2WorkerStats, queueDepth)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxQueueDepth)
+JSON_MAP_REFERENCE(Lv2WorkerStats, meanLatencyMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxLatencyMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, meanRunMs)
+JSON_MAP_REFERENCE(Lv2WorkerStats, maxRunMs)
+JSON_MAP_END()
+
 Worker::Worker(const std::shared_ptr<HostWorkerThread> &pHostWorker, LilvInstance *lilvInstance_, const LV2_Worker_Interface *workerInterface_)
     : lilvInstance(lilvInstance_),
       pHostWorker(pHostWorker),
+      requestRingBuffer(RING_BUFFER_SIZE),
       responseRingBuffer(RING_BUFFER_SIZE),
       workerInterface(workerInterface_)
 {
 
     responseBuffer.resize(16 * 1024);
+    if (workerInterface)
+    {
+        // start the thread now, even if the plugin didn't declare that it wants one,
+        // since it can't be started from the audio thread.
+        pHostWorker->StartThread();
+    }
+    pHostWorker->AddWorker(this);
 }
 
 void Worker::Close()
 {
+    if (closed.exchange(true))
     {
-        std::lock_guard lock(outstandingRequestMutex);
-        if (closed)
-            return;
-        closed = true;
-        exiting = true;
+        return;
     }
     WaitForAllResponses();
+    pHostWorker->RemoveWorker(this);
+    DiscardPendingRequests(); // if WaitForAllResponses() timed out.
+}
+void Worker::Reopen()
+{
+    if (!closed.load())
+    {
+        return;
+    }
+    pHostWorker->StartThread();
+    pHostWorker->AddWorker(this);
+    closed.store(false, std::memory_order_release);
 }
 Worker::~Worker()
 {
@@ -81,33 +137,19 @@ LV2_Worker_Status Worker::worker_respond_fn(LV2_Worker_Respond_Handle handle, ui
 
 LV2_Worker_Status Worker::WorkerRespond(uint32_t size, const void *data)
 {
+    // header and data in one write, so that the audio thread never sees a partial response.
+    RingBufferWriteSpans spans = responseRingBuffer.beginWrite(sizeof(size) + size);
+    if (!spans)
     {
-        std::lock_guard lock(outstandingRequestMutex);
-        ++outstandingResponses;
-    }
-    LV2_Worker_Status status;
-    if (responseRingBuffer.writeSpace() < sizeof(size) + size)
-    {
-        {
-            Lv2Log::warning(SS("LV2 Worker response too large: " << size << " bytes."));
-            std::lock_guard lock(outstandingRequestMutex);
-            --outstandingResponses;
-            // no need to notify, because outstandingRequests will be decremented after return.
-        }
+        Lv2Log::warning(SS("LV2 Worker response too large: " << size << " bytes."));
         return LV2_WORKER_ERR_NO_SPACE;
     }
-    else
-    {
-        if (!responseRingBuffer.write(sizeof(size), (uint8_t *)&size))
-        {
-            throw std::logic_error("Response queue sync lost.");
-        }
-        if (!responseRingBuffer.write(size, (uint8_t *)data))
-        {
-            throw std::logic_error("Response queue sync lost.");
-        }
-        return LV2_WORKER_SUCCESS;
-    }
+    spans.write(0, &size, sizeof(size));
+    spans.write(sizeof(size), data, size);
+    // counted before the request is retired in RunBackgroundTask(), so that the counts are never both zero while a response is in flight.
+    outstandingResponses.fetch_add(1);
+    responseRingBuffer.commitWrite(spans);
+    return LV2_WORKER_SUCCESS;
 }
 
 bool Worker::EmitResponses()
@@ -115,7 +157,7 @@ bool Worker::EmitResponses()
     bool emitted = false;
     while (true)
     {
-        if (!responseRingBuffer.isReadReady())
+        if (!responseRingBuffer.isReadReady(sizeof(uint32_t)))
         {
             break;
         }
@@ -129,14 +171,14 @@ bool Worker::EmitResponses()
         }
         uint8_t *pResponse = &(responseBuffer[0]);
 
-        responseRingBuffer.read(size, pResponse);
-
-        workerInterface->work_response(lilvInstance->lv2_handle, size, pResponse);
+        if (!responseRingBuffer.read(size, pResponse))
         {
-            std::lock_guard lock(outstandingRequestMutex);
-            --outstandingResponses;
-            cvOutstandingRequests.notify_all(); // must be done WITH the lock, since we may be destructed after the mutex is released.
+            throw std::logic_error("Response queue sync lost.");
         }
+
+        TraceScope traceScope("worker", "response");
+        workerInterface->work_response(lilvInstance->lv2_handle, size, pResponse);
+        outstandingResponses.fetch_sub(1);
     }
     return emitted;
 }
@@ -151,12 +193,9 @@ void Worker::WaitForAllResponses()
         // can't do condition_variable::wait_until due to OS restrictions.
         // instead, sleep briefly, waiting for wait tasks to complete.
         bool gotResponse = EmitResponses();
+        if (outstandingRequests.load() == 0 && outstandingResponses.load() == 0)
         {
-            std::unique_lock lock(outstandingRequestMutex);
-            if (outstandingRequests == 0 && outstandingResponses == 0)
-            {
-                break;
-            }
+            break;
         }
         // pump the plugin with a zero-length buffer.
         
@@ -174,21 +213,69 @@ LV2_Worker_Status Worker::ScheduleWork(
     uint32_t size,
     const void *data)
 {
+    // Called from plugin run() methods on the audio thread. Must not take locks.
+    if (workerInterface == nullptr)
+    {
+        return LV2_Worker_Status::LV2_WORKER_ERR_UNKNOWN;
+    }
+    if (closed.load(std::memory_order_acquire) || pHostWorker->Closed())
     {
-        std::lock_guard lock(outstandingRequestMutex);
-        ++outstandingRequests;
+        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+    }
+    RequestHeader header{size, NowNs()};
+    RingBufferWriteSpans spans = requestRingBuffer.beginWrite(sizeof(header) + size);
+    if (!spans)
+    {
+        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
     }
-    LV2_Worker_Status status = this->pHostWorker->ScheduleWork(this, size, data);
-    if (status != LV2_Worker_Status::LV2_WORKER_SUCCESS)
+    spans.write(0, &header, sizeof(header));
+    spans.write(sizeof(header), data, size);
+    // count the request before a worker thread can see it.
+    outstandingRequests.fetch_add(1);
+    pHostWorker->OnRequestScheduled();
+    requestRingBuffer.commitWrite(spans);
+    Tracer::Instant("worker", "schedule");
+
+    pHostWorker->Wake();
+    return LV2_Worker_Status::LV2_WORKER_SUCCESS;
+}
+
+void Worker::RunPendingRequests(std::vector<uint8_t> &dataBuffer)
+{
+    while (requestRingBuffer.isReadReady(sizeof(RequestHeader)))
     {
+        RequestHeader header;
+        requestRingBuffer.read(sizeof(header), (uint8_t *)&header);
+        pHostWorker->OnRequestStarted();
+        if (header.size > dataBuffer.size())
         {
-            std::lock_guard lock(outstandingRequestMutex);
-            --outstandingRequests;
-            cvOutstandingRequests.notify_all(); // must be done WITH the lock!
-            return status; 
+            dataBuffer.resize(header.size);
         }
+        uint8_t *pData = &(dataBuffer[0]);
+        if (!requestRingBuffer.read(header.size, pData))
+        {
+            throw PiPedalStateException("Worker ringbuffer read failed.");
+        }
+        int64_t startNs = NowNs();
+        {
+            TraceScope traceScope("worker", "work");
+            RunBackgroundTask(header.size, pData);
+        }
+        pHostWorker->RecordRequest(startNs - header.scheduledNs, NowNs() - startNs);
+    }
+}
+
+void Worker::DiscardPendingRequests()
+{
+    std::vector<uint8_t> discardBuffer;
+    while (requestRingBuffer.isReadReady(sizeof(RequestHeader)))
+    {
+        RequestHeader header;
+        requestRingBuffer.read(sizeof(header), (uint8_t *)&header);
+        pHostWorker->OnRequestStarted();
+        discardBuffer.resize(header.size);
+        requestRingBuffer.read(header.size, discardBuffer.data());
     }
-    return status;
 }
 
 void HostWorkerThread::ThreadProc() noexcept
@@ -197,133 +284,195 @@ void HostWorkerThread::ThreadProc() noexcept
     SetThreadName("lv2_worker");
     SetThreadPriority(SchedulerPriority::Lv2Scheduler);
 
+    std::vector<uint8_t> dataBuffer(16 * 1024);
 
     try
     {
         while (true)
         {
-            if (!requestRingBuffer.readWait())
-            {
-                return;
-            }
-            uint32_t size;
-
-            Worker *pWorker;
-
-            if (!requestRingBuffer.read(sizeof(size), (uint8_t *)&size))
-            {
-                throw PiPedalStateException("Working ringbuffer read failed.");
-            }
+            uint32_t sequence = wakeSequence.load();
+            bool closing = closed.load();
 
-            if (!requestRingBuffer.read(sizeof(pWorker), (uint8_t *)&pWorker))
+            bool ranRequests = RunPendingRequests(dataBuffer);
+            if (closing && !ranRequests)
             {
-                throw PiPedalStateException("Worker ringbuffer read failed.");
-            }
-            size -= sizeof(pWorker);
-
-            if (size > dataBuffer.size())
-            {
-                dataBuffer.resize(size);
-            }
-            uint8_t *pData = &(dataBuffer[0]);
-            if (!requestRingBuffer.read(size, pData))
-            {
-                throw PiPedalStateException("Worker ringbuffer read failed.");
+                // requests scheduled before Close() have all run (or are running on other threads).
+                break;
             }
-            if (pWorker == nullptr) // signals close.
+            if (!ranRequests)
             {
-                break;
+                ++sleepingThreads;
+                if (wakeSequence.load() == sequence)
+                {
+                    futex_wait(&wakeSequence, sequence);
+                }
+                --sleepingThreads;
             }
-            pWorker->RunBackgroundTask(size, pData);
         }
     }
     catch (const std::exception &e)
     {
         Lv2Log::error("Lv2 Worker thread proc exited abnormally. (%s)", e.what());
     }
-    requestRingBuffer.close();
 }
 
-HostWorkerThread::HostWorkerThread()
+bool HostWorkerThread::RunPendingRequests(std::vector<uint8_t> &dataBuffer)
+{
+    bool ranRequests = false;
+    while (true)
+    {
+        // claim a worker that has requests, and that isn't running on another thread.
+        Worker *worker = nullptr;
+        {
+            std::lock_guard lock(workersMutex);
+            for (auto i = workers.begin(); i != workers.end(); ++i)
+            {
+                if (!(*i)->running && (*i)->HasPendingRequests())
+                {
+                    worker = *i;
+                    worker->running = true;
+                    // to the back of the line, so that busy plugins don't starve the others.
+                    workers.erase(i);
+                    workers.push_back(worker);
+                    break;
+                }
+            }
+        }
+        if (!worker)
+        {
+            return ranRequests;
+        }
+        try
+        {
+            worker->RunPendingRequests(dataBuffer);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(workersMutex);
+            worker->running = false;
+            cvWorkers.notify_all();
+            throw;
+        }
+        {
+            std::lock_guard lock(workersMutex);
+            worker->running = false;
+            cvWorkers.notify_all();
+        }
+        ranRequests = true;
+    }
+}
+
+HostWorkerThread::HostWorkerThread(size_t threadCount)
+    : threadCount(std::max<size_t>(1, threadCount))
 {
-    this->dataBuffer.resize(16*1024);
 }
 
 bool HostWorkerThread::StartThread()
 {
-    if (!pThread)
+    std::lock_guard lock(workersMutex);
+    if (closed)
+    {
+        return false;
+    }
+    if (!started)
     {
-        if (closed) {
-            return false;
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            threads.push_back(std::make_unique<std::thread>([this]()
+                                                            { this->ThreadProc(); }));
         }
-        pThread = std::make_unique<std::thread>([this]()
-                                                { this->ThreadProc(); });
-    }    
+        started = true;
+    }
     return true;
 }
 
 void HostWorkerThread::Close()
 {
-
+    if (!closed.exchange(true))
     {
-        std::lock_guard lock{submitMutex};
-        if (pThread) {
-            if (!closed)
-            {
-                closed = true;
-                ScheduleWorkNoLock(nullptr, 0, nullptr);
-            }
-        }
+        Wake();
     }
 }
 HostWorkerThread::~HostWorkerThread()
 {
-    if (pThread)
+    // ask worker threads to terminate.
+    Close();
+    for (auto &thread : threads)
     {
-        // ask worker thread to terminate.
-        Close();
-        pThread->join();
-        pThread = nullptr;
+        thread->join();
     }
+    threads.clear();
 }
 
-LV2_Worker_Status HostWorkerThread::ScheduleWork(Worker *worker, size_t size, const void *data)
+void HostWorkerThread::OnRequestScheduled()
 {
-    std::lock_guard lock(submitMutex);
-
-    if (!StartThread()) { // ensures thread is running, when plugins haven't declared they want a worker thread.
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
-    }
-    if (exiting )
+    int64_t depth = queueDepth.fetch_add(1) + 1;
+    int64_t maxDepth = maxQueueDepth.load(std::memory_order_relaxed);
+    while (depth > maxDepth && !maxQueueDepth.compare_exchange_weak(maxDepth, depth, std::memory_order_relaxed))
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
     }
-    if (worker == nullptr)
+}
+
+void HostWorkerThread::Wake()
+{
+    wakeSequence.fetch_add(1);
+    if (sleepingThreads.load() != 0)
     {
-        exiting = true;
+        futex_wake(&wakeSequence);
     }
-    return ScheduleWorkNoLock(worker, size, data);
-
 }
-LV2_Worker_Status HostWorkerThread::ScheduleWorkNoLock(Worker *worker, size_t size, const void *data)
+
+void HostWorkerThread::RecordRequest(int64_t latencyNs, int64_t runNs)
 {
+    std::lock_guard lock(statsMutex);
+    ++completedRequests;
+    totalLatencyNs += latencyNs;
+    maxLatencyNs = std::max(maxLatencyNs, latencyNs);
+    totalRunNs += runNs;
+    maxRunNs = std::max(maxRunNs, runNs);
+}
 
-    if (requestRingBuffer.writeSpace() < sizeof(worker) + sizeof(size) + size)
+Lv2WorkerStats HostWorkerThread::GetStats()
+{
+    Lv2WorkerStats result;
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+        std::lock_guard lock(workersMutex);
+        result.threads_ = started ? (uint32_t)threadCount : 0;
+        result.workers_ = (uint32_t)workers.size();
     }
-    size_t packetSizeL = (size + sizeof(worker));
-    uint32_t packetSize = (uint32_t)(packetSizeL);
-    if (packetSizeL != packetSize)
+    result.queueDepth_ = std::max<int64_t>(0, queueDepth.load());
+    result.maxQueueDepth_ = maxQueueDepth.load();
     {
-        return LV2_Worker_Status::LV2_WORKER_ERR_NO_SPACE;
+        std::lock_guard lock(statsMutex);
+        result.requests_ = completedRequests;
+        if (completedRequests != 0)
+        {
+            result.meanLatencyMs_ = (float)(totalLatencyNs / (double)completedRequests * 1E-6);
+            result.meanRunMs_ = (float)(totalRunNs / (double)completedRequests * 1E-6);
+        }
+        result.maxLatencyMs_ = (float)(maxLatencyNs * 1E-6);
+        result.maxRunMs_ = (float)(maxRunNs * 1E-6);
     }
+    return result;
+}
 
-    requestRingBuffer.write(sizeof(packetSize), (uint8_t *)&packetSize);
-    requestRingBuffer.write(sizeof(worker), (uint8_t *)&worker);
-    requestRingBuffer.write(size, (uint8_t *)data);
-    
-    return LV2_Worker_Status::LV2_WORKER_SUCCESS;
+void HostWorkerThread::AddWorker(Worker *worker)
+{
+    std::lock_guard lock(workersMutex);
+    workers.push_back(worker);
+}
+
+void HostWorkerThread::RemoveWorker(Worker *worker)
+{
+    std::unique_lock lock(workersMutex);
+    auto i = std::find(workers.begin(), workers.end(), worker);
+    if (i != workers.end())
+    {
+        workers.erase(i);
+    }
+    // the worker may be deleted as soon as we return.
+    cvWorkers.wait(lock, [worker]()
+                   { return !worker->running; });
 }
 
 void Worker::RunBackgroundTask(size_t size, uint8_t *data)
@@ -334,14 +483,5 @@ void Worker::RunBackgroundTask(size_t size, uint8_t *data)
     {
         Lv2Log::error(SS("Unhandled exception on LV2 Worker thread: " << e.what()));
     }
-    {
-        std::lock_guard lock { this->outstandingRequestMutex};
-        --this->outstandingRequests;
-        if (this->outstandingRequests == 0)
-        {
-            this->cvOutstandingRequests.notify_all();
-        }
-
-    }
-
+    --this->outstandingRequests;
 }
@@ -31,54 +31,113 @@
 #include "lv2/urid/urid.h"
 #include "lv2/atom/atom.h"
 #include "lv2/worker/worker.h"
-#include "condition_variable"
+#include <condition_variable>
 #include <atomic>
 
 #include <map>
 #include <string>
 #include <mutex>
 #include <thread>
+#include <vector>
 #include "RingBuffer.hpp"
+#include "json.hpp"
 #include <memory>
-#include "inverting_mutex.hpp"
 
 
 namespace pipedal {
 
     class Worker;
 
+    // LV2 worker pool statistics, reported in JackHostStatus.
+    class Lv2WorkerStats
+    {
+    public:
+        uint32_t threads_ = 0;
+        uint32_t workers_ = 0;
+        uint64_t requests_ = 0;   // completed requests.
+        int64_t queueDepth_ = 0;  // requests that have been scheduled, but haven't started.
+        int64_t maxQueueDepth_ = 0;
+        float meanLatencyMs_ = 0; // from ScheduleWork() until the request starts running.
+        float maxLatencyMs_ = 0;
+        float meanRunMs_ = 0;
+        float maxRunMs_ = 0;
+
+        DECLARE_JSON_MAP(Lv2WorkerStats);
+    };
+
+    // A pool of threads that run LV2 Worker requests, shared by all plugins.
+    //
+    // Workers queue requests on their own lock-free request ring, and wake the pool with a
+    // futex, so that scheduling work from the audio thread never blocks. A Worker's requests
+    // run on one thread at a time, in the order they were scheduled, as the LV2 worker spec
+    // requires. Different Workers' requests run in parallel, so a slow model load in one
+    // plugin doesn't hold up another plugin's requests.
     class HostWorkerThread {
     public:
-        HostWorkerThread();
+        static constexpr size_t DEFAULT_THREAD_COUNT = 2;
+
+        HostWorkerThread(size_t threadCount = DEFAULT_THREAD_COUNT);
         ~HostWorkerThread();
 
+        // Start the pool's threads, if they aren't already running.
         bool StartThread();
+        // Stops the threads, after running requests that have already been scheduled.
         void Close();
-        bool Closed() const { return closed || pThread == nullptr; }
-        LV2_Worker_Status ScheduleWork(Worker*worker, size_t size, const void*data);
+        bool Closed() const { return closed || !started; }
+
+        Lv2WorkerStats GetStats();
     private:
-        LV2_Worker_Status ScheduleWorkNoLock(Worker*worker, size_t size, const void*data);
-        std::atomic<bool> closed = false;
-        std::unique_ptr<std::thread> pThread;
-        void ThreadProc() noexcept;
+        friend class Worker;
+        void AddWorker(Worker *worker);
+        // Waits for any request of the worker's that is currently running.
+        void RemoveWorker(Worker *worker);
+
+        // Realtime-safe.
+        void OnRequestScheduled();
+        void Wake();
 
-        RingBuffer<false,true> requestRingBuffer;
-        bool exiting = false;
-        inverting_mutex submitMutex;
+        void OnRequestStarted() { queueDepth.fetch_sub(1); }
+        void RecordRequest(int64_t latencyNs, int64_t runNs);
 
-        std::vector<uint8_t> dataBuffer;
+        bool RunPendingRequests(std::vector<uint8_t> &dataBuffer);
+        void ThreadProc() noexcept;
 
+        size_t threadCount;
+        std::atomic<bool> closed = false;
+        std::atomic<bool> started = false;
+        std::vector<std::unique_ptr<std::thread>> threads;
+
+        alignas(64) std::atomic<uint32_t> wakeSequence{0};
+        std::atomic<int32_t> sleepingThreads{0};
+        alignas(64) std::atomic<int64_t> queueDepth{0};
+        std::atomic<int64_t> maxQueueDepth{0};
+
+        std::mutex workersMutex;
+        std::condition_variable cvWorkers;
+        std::vector<Worker *> workers;
+
+        std::mutex statsMutex;
+        uint64_t completedRequests = 0;
+        int64_t totalLatencyNs = 0;
+        int64_t maxLatencyNs = 0;
+        int64_t totalRunNs = 0;
+        int64_t maxRunNs = 0;
     };
 
 	class Worker {
 
 	private:
+        friend class HostWorkerThread;
+
         std::shared_ptr<HostWorkerThread> pHostWorker = nullptr;
         LilvInstance*lilvInstance;
         const LV2_Worker_Interface*workerInterface;
 
         std::atomic<bool> closed = false;
-        std::atomic<bool> exiting = false;
+        bool running = false; // a pool thread is running this worker's requests. Guarded by HostWorkerThread::workersMutex.
+        // audio thread -> worker thread. Single writer, single reader, no locks.
+        RingBuffer<false,false> requestRingBuffer;
+        // worker thread -> audio thread.
         RingBuffer<true,false> responseRingBuffer;
 
         std::vector<uint8_t> responseBuffer;
@@ -88,17 +147,23 @@ namespace pipedal {
 
         LV2_Worker_Status WorkerRespond(uint32_t size,const void*data);
 
-        inverting_mutex outstandingRequestMutex;
-        std::condition_variable cvOutstandingRequests;
-        int64_t outstandingRequests = 0;
-        int64_t outstandingResponses = 0;
+        std::atomic<int64_t> outstandingRequests = 0;
+        std::atomic<int64_t> outstandingResponses = 0;
         void WaitForAllResponses();
+
+        bool HasPendingRequests() { return requestRingBuffer.isReadReady(sizeof(uint32_t)); }
+        void DiscardPendingRequests();
+        // Worker thread only.
+        void RunPendingRequests(std::vector<uint8_t> &dataBuffer);
 	public:
 		Worker(const std::shared_ptr<HostWorkerThread>& pHostWorker,LilvInstance *instance, const LV2_Worker_Interface *iface);
         ~Worker();
         
         void Close();
+        // Resume a worker that was closed when its plugin was deactivated.
+        void Reopen();
 
+        // Realtime-safe and lock-free.
         LV2_Worker_Status ScheduleWork(
             uint32_t size,
             const void *data);
@@ -106,7 +171,9 @@ namespace pipedal {
         void RunBackgroundTask(size_t size, uint8_t*data);
         
         bool EmitResponses();
+        // Realtime-safe. True if there are worker responses that have not yet been delivered to the plugin.
+        bool HasPendingResponses() const { return outstandingResponses.load() != 0; }
 
 
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,233 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include "pch.h"
+#include "catch.hpp"
+#include "Worker.hpp"
+#include <chrono>
+#include <thread>
+
+using namespace pipedal;
+using namespace std;
+
+namespace
+{
+    struct TestPlugin
+    {
+        std::atomic<int> workCount{0};
+        std::atomic<int32_t> lastRequest{-1};
+        std::atomic<bool> outOfOrder{false};
+        std::atomic<int> concurrentRequests{0};
+        std::atomic<bool> overlapped{false};
+        std::chrono::milliseconds workDelay{0};
+        // audio thread only.
+        int responseCount = 0;
+        int64_t responseSum = 0;
+    };
+
+    LV2_Worker_Status work(
+        LV2_Handle instance,
+        LV2_Worker_Respond_Function respond,
+        LV2_Worker_Respond_Handle handle,
+        uint32_t size,
+        const void *data)
+    {
+        TestPlugin *plugin = (TestPlugin *)instance;
+        if (++plugin->concurrentRequests != 1)
+        {
+            plugin->overlapped = true;
+        }
+        int32_t request = *(const int32_t *)data;
+        if (request <= plugin->lastRequest.exchange(request))
+        {
+            plugin->outOfOrder = true;
+        }
+        if (plugin->workDelay.count() != 0)
+        {
+            std::this_thread::sleep_for(plugin->workDelay);
+        }
+        ++plugin->workCount;
+        --plugin->concurrentRequests;
+        return respond(handle, size, data);
+    }
+
+    LV2_Worker_Status work_response(LV2_Handle instance, uint32_t size, const void *body)
+    {
+        TestPlugin *plugin = (TestPlugin *)instance;
+        REQUIRE(size == sizeof(int32_t));
+        ++plugin->responseCount;
+        plugin->responseSum += *(const int32_t *)body;
+        return LV2_WORKER_SUCCESS;
+    }
+
+    const LV2_Worker_Interface workerInterface{work, work_response, nullptr};
+
+    void WaitForResponses(Worker &worker, TestPlugin &plugin, int count)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        while (plugin.responseCount < count)
+        {
+            worker.EmitResponses();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            REQUIRE(std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10));
+        }
+    }
+}
+
+TEST_CASE("LV2 Worker", "[lv2_worker][Build][Dev]")
+{
+    TestPlugin plugin;
+    LilvInstance instance{};
+    instance.lv2_handle = &plugin;
+
+    SECTION("scheduled work runs, and responses are delivered")
+    {
+        auto hostWorker = std::make_shared<HostWorkerThread>();
+        Worker worker(hostWorker, &instance, &workerInterface);
+
+        constexpr int N_REQUESTS = 1000;
+        int64_t expectedSum = 0;
+        for (int32_t i = 0; i < N_REQUESTS; ++i)
+        {
+            while (worker.ScheduleWork(sizeof(i), &i) != LV2_WORKER_SUCCESS)
+            {
+                // the request ring is full.
+                worker.EmitResponses();
+                std::this_thread::yield();
+            }
+            expectedSum += i;
+        }
+        WaitForResponses(worker, plugin, N_REQUESTS);
+        REQUIRE(plugin.workCount == N_REQUESTS);
+        REQUIRE(plugin.responseSum == expectedSum);
+    }
+    SECTION("Close() drains outstanding requests")
+    {
+        plugin.workDelay = std::chrono::milliseconds(5);
+        auto hostWorker = std::make_shared<HostWorkerThread>();
+        Worker worker(hostWorker, &instance, &workerInterface);
+        constexpr int N_REQUESTS = 20;
+        for (int32_t i = 0; i < N_REQUESTS; ++i)
+        {
+            REQUIRE(worker.ScheduleWork(sizeof(i), &i) == LV2_WORKER_SUCCESS);
+        }
+        worker.Close();
+        REQUIRE(plugin.workCount == N_REQUESTS);
+        REQUIRE(plugin.responseCount == N_REQUESTS);
+
+        int32_t value = 0;
+        REQUIRE(worker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_ERR_NO_SPACE);
+    }
+    SECTION("Reopen() resumes a closed worker")
+    {
+        auto hostWorker = std::make_shared<HostWorkerThread>();
+        Worker worker(hostWorker, &instance, &workerInterface);
+        int32_t value = 1;
+        REQUIRE(worker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_SUCCESS);
+        worker.Close();
+        REQUIRE(plugin.responseCount == 1);
+
+        worker.Reopen();
+        value = 2;
+        REQUIRE(worker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_SUCCESS);
+        WaitForResponses(worker, plugin, 2);
+        REQUIRE(plugin.responseSum == 3);
+        REQUIRE(!plugin.outOfOrder);
+    }
+    SECTION("closing the host thread runs requests that were already scheduled")
+    {
+        plugin.workDelay = std::chrono::milliseconds(5);
+        auto hostWorker = std::make_shared<HostWorkerThread>();
+        auto worker = std::make_unique<Worker>(hostWorker, &instance, &workerInterface);
+        constexpr int N_REQUESTS = 10;
+        for (int32_t i = 0; i < N_REQUESTS; ++i)
+        {
+            REQUIRE(worker->ScheduleWork(sizeof(i), &i) == LV2_WORKER_SUCCESS);
+        }
+        hostWorker->Close();
+        int32_t value = 0;
+        REQUIRE(worker->ScheduleWork(sizeof(value), &value) == LV2_WORKER_ERR_NO_SPACE);
+
+        worker = nullptr; // Close(), then delete, while the thread may still be running.
+        hostWorker = nullptr;
+        REQUIRE(plugin.workCount == N_REQUESTS);
+        REQUIRE(plugin.responseCount == N_REQUESTS);
+    }
+    SECTION("requests run in order per worker, and in parallel across workers")
+    {
+        auto hostWorker = std::make_shared<HostWorkerThread>(4);
+        constexpr size_t N_WORKERS = 4;
+        constexpr int N_REQUESTS = 200;
+        TestPlugin plugins[N_WORKERS];
+        LilvInstance instances[N_WORKERS]{};
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (size_t i = 0; i < N_WORKERS; ++i)
+        {
+            instances[i].lv2_handle = &plugins[i];
+            workers.push_back(std::make_unique<Worker>(hostWorker, &instances[i], &workerInterface));
+        }
+        for (int32_t request = 0; request < N_REQUESTS; ++request)
+        {
+            for (size_t i = 0; i < N_WORKERS; ++i)
+            {
+                REQUIRE(workers[i]->ScheduleWork(sizeof(request), &request) == LV2_WORKER_SUCCESS);
+            }
+        }
+        for (size_t i = 0; i < N_WORKERS; ++i)
+        {
+            WaitForResponses(*workers[i], plugins[i], N_REQUESTS);
+            REQUIRE(plugins[i].workCount == N_REQUESTS);
+            REQUIRE(!plugins[i].outOfOrder);
+            REQUIRE(!plugins[i].overlapped);
+        }
+        auto stats = hostWorker->GetStats();
+        REQUIRE(stats.threads_ == 4);
+        REQUIRE(stats.workers_ == N_WORKERS);
+        REQUIRE(stats.requests_ == N_WORKERS * N_REQUESTS);
+        REQUIRE(stats.queueDepth_ == 0);
+        REQUIRE(stats.maxQueueDepth_ > 0);
+        REQUIRE(stats.maxLatencyMs_ >= stats.meanLatencyMs_);
+    }
+    SECTION("a slow request doesn't hold up other workers")
+    {
+        auto hostWorker = std::make_shared<HostWorkerThread>(2);
+        TestPlugin slowPlugin;
+        slowPlugin.workDelay = std::chrono::milliseconds(1000);
+        LilvInstance slowInstance{};
+        slowInstance.lv2_handle = &slowPlugin;
+        Worker slowWorker(hostWorker, &slowInstance, &workerInterface);
+        Worker worker(hostWorker, &instance, &workerInterface);
+
+        int32_t value = 1;
+        REQUIRE(slowWorker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_SUCCESS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto startTime = std::chrono::steady_clock::now();
+        REQUIRE(worker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_SUCCESS);
+        WaitForResponses(worker, plugin, 1);
+        REQUIRE(std::chrono::steady_clock::now() - startTime < std::chrono::milliseconds(500));
+        REQUIRE(slowPlugin.workCount == 0);
+    }
+    SECTION("plugins without a worker interface can't schedule work")
+    {
+        auto hostWorker = std::make_shared<HostWorkerThread>();
+        Worker worker(hostWorker, &instance, nullptr);
+        int32_t value = 0;
+        REQUIRE(worker.ScheduleWork(sizeof(value), &value) == LV2_WORKER_ERR_UNKNOWN);
+    }
+}
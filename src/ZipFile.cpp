@@ -23,7 +23,20 @@
 #include <map>
 #include "ss.hpp"
 #include "Finally.hpp"
+#include "TemporaryFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
 
 using namespace pipedal;
 
@@ -62,20 +75,58 @@ public:
                 nameMap[name] = i;
             }
         }
+        MapFile();
     }
     virtual ~ZipFileImpl();
     virtual const std::vector<std::string>& GetFiles() override;
     virtual bool CompareFiles(const std::string &zipName, const std::filesystem::path& path) override;
-    virtual void ExtractTo(const std::string &zipName, const std::filesystem::path &path) override;
+    virtual void ExtractTo(const std::string &zipName, const std::filesystem::path &path, const ProgressCallback &onProgress) override;
     virtual zip_file_input_stream GetFileInputStream(const std::string& filename,size_t bufferSize = 16*1024) override;
     virtual size_t GetFileSize(const std::string&filename) override;
+    virtual uint32_t GetFileCrc(const std::string&filename) override;
     virtual bool FileExists(const std::string &zipName) const override;
+    virtual void ExtractFiles(const std::vector<ExtractRequest> &files, const ProgressCallback &onProgress, size_t threads) override;
 
 private:
+    // The location of a stored or deflated entry in the mapped zip file, from the central directory.
+    struct DirectEntry
+    {
+        uint64_t localHeaderOffset = 0;
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        uint32_t crc = 0;
+        uint16_t method = 0;
+    };
+
+    void MapFile();
+    void ReadCentralDirectory();
+    uint64_t GetDeclaredSize(const std::string &zipName);
+    void ExtractDirect(const DirectEntry &entry, const std::filesystem::path &path, std::atomic<uint64_t> *bytesWritten);
+    void ExtractThreadProc(const std::vector<ExtractRequest> *requests);
+
+    static constexpr size_t EXTRACT_BUFFER_SIZE = 256 * 1024;
+    // deflate can't do better than about 1032:1. A larger ratio in the directory means a corrupt or hostile zip file.
+    static constexpr uint64_t MAX_COMPRESSION_RATIO = 1100;
+
     std::vector<std::string> files;
     std::map<std::string, zip_int64_t> nameMap; // avoid o(2) extraction operations.
     const std::filesystem::path path;
     zip_t *zipFile = nullptr;
+
+    int fd = -1;
+    const uint8_t *mappedData = nullptr;
+    size_t mappedSize = 0;
+    // entries that can be extracted from the mapped file without libzip. Encrypted entries,
+    // other compression methods, and zip64 archives go through libzip instead.
+    std::map<std::string, DirectEntry> directEntries;
+
+    std::mutex extractMutex;
+    std::condition_variable extractProgress;
+    std::mutex libzipMutex; // zip_t isn't thread-safe.
+    size_t nextExtractRequest = 0;
+    size_t extractRequestsDone = 0;
+    std::atomic<uint64_t> bytesExtracted{0};
+    std::string extractError;
 };
 
 ZipFileReader::ptr ZipFileReader::Create(const std::filesystem::path &path)
@@ -84,6 +135,16 @@ ZipFileReader::ptr ZipFileReader::Create(const std::filesystem::path &path)
 }
 ZipFileImpl::~ZipFileImpl()
 {
+    if (mappedData)
+    {
+        munmap((void *)mappedData, mappedSize);
+        mappedData = nullptr;
+    }
+    if (fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
     if (zipFile)
     {
         zip_close(zipFile);
@@ -91,6 +152,106 @@ ZipFileImpl::~ZipFileImpl()
     }
 }
 
+static inline uint16_t ReadU16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+static inline uint32_t ReadU32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void ZipFileImpl::MapFile()
+{
+    // If the file can't be mapped, everything is extracted with libzip.
+    fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        return;
+    }
+    void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+    {
+        return;
+    }
+    mappedData = (const uint8_t *)p;
+    mappedSize = (size_t)st.st_size;
+    ReadCentralDirectory();
+}
+
+void ZipFileImpl::ReadCentralDirectory()
+{
+    constexpr size_t EOCD_SIZE = 22;
+    constexpr size_t CENTRAL_HEADER_SIZE = 46;
+    if (mappedSize < EOCD_SIZE)
+    {
+        return;
+    }
+    // The end of central directory record is followed by a comment of up to 64K.
+    size_t minEocd = mappedSize > EOCD_SIZE + 0xFFFF ? mappedSize - EOCD_SIZE - 0xFFFF : 0;
+    size_t eocd = mappedSize - EOCD_SIZE;
+    while (ReadU32(mappedData + eocd) != 0x06054b50)
+    {
+        if (eocd == minEocd)
+        {
+            return;
+        }
+        --eocd;
+    }
+    const uint8_t *p = mappedData + eocd;
+    uint16_t nEntries = ReadU16(p + 10);
+    uint32_t directorySize = ReadU32(p + 12);
+    uint32_t directoryOffset = ReadU32(p + 16);
+    if (nEntries == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF)
+    {
+        return; // zip64.
+    }
+    if ((uint64_t)directoryOffset + directorySize > eocd)
+    {
+        return;
+    }
+    const uint8_t *entry = mappedData + directoryOffset;
+    const uint8_t *end = entry + directorySize;
+    for (uint16_t i = 0; i < nEntries; ++i)
+    {
+        if (end - entry < (ptrdiff_t)CENTRAL_HEADER_SIZE || ReadU32(entry) != 0x02014b50)
+        {
+            directEntries.clear();
+            return;
+        }
+        uint16_t flags = ReadU16(entry + 8);
+        uint16_t method = ReadU16(entry + 10);
+        size_t nameLength = ReadU16(entry + 28);
+        size_t extraLength = ReadU16(entry + 30);
+        size_t commentLength = ReadU16(entry + 32);
+        size_t entryLength = CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if ((size_t)(end - entry) < entryLength)
+        {
+            directEntries.clear();
+            return;
+        }
+        DirectEntry directEntry;
+        directEntry.crc = ReadU32(entry + 16);
+        directEntry.compressedSize = ReadU32(entry + 20);
+        directEntry.size = ReadU32(entry + 24);
+        directEntry.localHeaderOffset = ReadU32(entry + 42);
+        directEntry.method = method;
+
+        bool encrypted = (flags & 1) != 0;
+        if (!encrypted && (method == ZIP_CM_STORE || method == ZIP_CM_DEFLATE) && directEntry.compressedSize != 0xFFFFFFFF && directEntry.size != 0xFFFFFFFF && directEntry.localHeaderOffset != 0xFFFFFFFF)
+        {
+            std::string name((const char *)entry + CENTRAL_HEADER_SIZE, nameLength);
+            directEntries[name] = directEntry;
+        }
+        entry += entryLength;
+    }
+}
+
 const std::vector<std::string>& ZipFileImpl::GetFiles()
 {
     return files;
@@ -175,7 +336,7 @@ bool ZipFileImpl::CompareFiles(const std::string &zipName, const std::filesystem
 }
 
 
-void ZipFileImpl::ExtractTo(const std::string &zipName, const std::filesystem::path &path)
+void ZipFileImpl::ExtractTo(const std::string &zipName, const std::filesystem::path &path, const ProgressCallback &onProgress)
 {
     auto fi = nameMap.find(zipName);
 
@@ -206,9 +367,16 @@ void ZipFileImpl::ExtractTo(const std::string &zipName, const std::filesystem::p
         throw std::runtime_error(SS("Unable to open " << path));
     }
 
-    constexpr int BUFFER_SIZE = 64 * 1024;
+    zip_stat_t zipStat;
+    if (zip_stat_index(zipFile, fileIndex, 0, &zipStat) < 0 || (zipStat.valid & ZIP_STAT_SIZE) == 0)
+    {
+        throw std::runtime_error(SS("Failed to get file stats: " << zip_strerror(zipFile)));
+    }
+
+    constexpr int BUFFER_SIZE = 256 * 1024;
     std::vector<char> vBuff(BUFFER_SIZE);
     char *pBuff = (char *)&(vBuff[0]);
+    uint64_t bytesWritten = 0;
     while (true)
     {
         zip_int64_t nRead = zip_fread(fIn, pBuff, BUFFER_SIZE);
@@ -220,11 +388,284 @@ void ZipFileImpl::ExtractTo(const std::string &zipName, const std::filesystem::p
             const char *strError = zip_error_strerror(error);
             throw std::runtime_error(SS("Error reading zip content file." << strError));
         }
+        if (bytesWritten + (uint64_t)nRead > zipStat.size)
+        {
+            throw std::runtime_error(SS("Zip content file " << zipName << " is larger than its declared size."));
+        }
         fo.write(pBuff, (std::streamsize)nRead);
         if (!fo)
         {
             throw std::runtime_error(SS("Unable to write to " << path));
         }
+        bytesWritten += (uint64_t)nRead;
+        if (onProgress)
+        {
+            onProgress(bytesWritten);
+        }
+    }
+}
+
+uint64_t ZipFileImpl::GetDeclaredSize(const std::string &zipName)
+{
+    auto directEntry = directEntries.find(zipName);
+    if (directEntry != directEntries.end())
+    {
+        return directEntry->second.size;
+    }
+    return GetFileSize(zipName);
+}
+
+void ZipFileImpl::ExtractDirect(const DirectEntry &entry, const std::filesystem::path &path, std::atomic<uint64_t> *bytesWritten)
+{
+    constexpr size_t LOCAL_HEADER_SIZE = 30;
+    if (entry.localHeaderOffset + LOCAL_HEADER_SIZE > mappedSize || ReadU32(mappedData + entry.localHeaderOffset) != 0x04034b50)
+    {
+        throw std::runtime_error(SS("Invalid zip file header for " << path.filename()));
+    }
+    const uint8_t *header = mappedData + entry.localHeaderOffset;
+    uint64_t dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + ReadU16(header + 26) + ReadU16(header + 28);
+    if (dataOffset + entry.compressedSize > mappedSize)
+    {
+        throw std::runtime_error(SS("Truncated zip content file " << path.filename()));
+    }
+    if (entry.method == ZIP_CM_STORE ? entry.compressedSize != entry.size : entry.size > entry.compressedSize * MAX_COMPRESSION_RATIO + 1024)
+    {
+        throw std::runtime_error(SS("Invalid size for zip content file " << path.filename()));
+    }
+    const uint8_t *data = mappedData + dataOffset;
+
+    std::filesystem::create_directories(path.parent_path());
+    int outFd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (outFd == -1)
+    {
+        throw std::runtime_error(SS("Unable to open " << path));
+    }
+    bool succeeded = false;
+    Finally closeOutput{[outFd, &path, &succeeded]()
+                        {
+                            close(outFd);
+                            if (!succeeded)
+                            {
+                                std::error_code ec;
+                                std::filesystem::remove(path, ec);
+                            }
+                        }};
+
+    auto writeAll = [outFd, &path](const uint8_t *p, size_t n)
+    {
+        while (n != 0)
+        {
+            ssize_t nWritten = write(outFd, p, n);
+            if (nWritten < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::runtime_error(SS("Unable to write to " << path));
+            }
+            p += nWritten;
+            n -= (size_t)nWritten;
+        }
+    };
+
+    uLong crc = crc32(0, nullptr, 0);
+    uint64_t written = 0;
+    if (entry.method == ZIP_CM_STORE)
+    {
+        // copy_file_range lets the kernel copy the data (or share extents) without a trip through user space.
+        bool useCopyFileRange = true;
+        while (written < entry.size)
+        {
+            size_t chunk = (size_t)std::min<uint64_t>(entry.size - written, EXTRACT_BUFFER_SIZE * 4);
+            crc = crc32(crc, data + written, (uInt)chunk);
+            size_t copied = 0;
+            while (useCopyFileRange && copied < chunk)
+            {
+                loff_t offset = (loff_t)(dataOffset + written + copied);
+                ssize_t n = copy_file_range(fd, &offset, outFd, nullptr, chunk - copied, 0);
+                if (n <= 0)
+                {
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    useCopyFileRange = false; // e.g. EXDEV or ENOSYS on older kernels.
+                    break;
+                }
+                copied += (size_t)n;
+            }
+            if (copied < chunk)
+            {
+                writeAll(data + written + copied, chunk - copied);
+            }
+            written += chunk;
+            *bytesWritten += chunk;
+        }
+    }
+    else
+    {
+        z_stream stream{};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        {
+            throw std::runtime_error("inflateInit2 failed.");
+        }
+        Finally endStream{[&stream]()
+                          { inflateEnd(&stream); }};
+        std::vector<uint8_t> buffer(EXTRACT_BUFFER_SIZE);
+        stream.next_in = (Bytef *)data;
+        stream.avail_in = (uInt)entry.compressedSize;
+        while (true)
+        {
+            stream.next_out = buffer.data();
+            stream.avail_out = (uInt)buffer.size();
+            int result = inflate(&stream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END)
+            {
+                throw std::runtime_error(SS("Invalid compressed data in zip content file " << path.filename()));
+            }
+            size_t n = buffer.size() - stream.avail_out;
+            // Checked as the data streams out, so a zip bomb fails after writing no more than it declared.
+            if (written + n > entry.size)
+            {
+                throw std::runtime_error(SS("Zip content file " << path.filename() << " is larger than its declared size."));
+            }
+            crc = crc32(crc, buffer.data(), (uInt)n);
+            writeAll(buffer.data(), n);
+            written += n;
+            *bytesWritten += n;
+            if (result == Z_STREAM_END)
+            {
+                break;
+            }
+            if (n == 0 && stream.avail_in == 0)
+            {
+                throw std::runtime_error(SS("Truncated zip content file " << path.filename()));
+            }
+        }
+    }
+    if (written != entry.size || (uint32_t)crc != entry.crc)
+    {
+        throw std::runtime_error(SS("Zip content file " << path.filename() << " is corrupt."));
+    }
+    succeeded = true;
+}
+
+void ZipFileImpl::ExtractThreadProc(const std::vector<ExtractRequest> *requests)
+{
+    while (true)
+    {
+        const ExtractRequest *request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(extractMutex);
+            if (nextExtractRequest < requests->size() && extractError.empty())
+            {
+                request = &(*requests)[nextExtractRequest++];
+            }
+        }
+        if (!request)
+        {
+            break;
+        }
+        try
+        {
+            auto directEntry = directEntries.find(request->zipName);
+            if (directEntry != directEntries.end())
+            {
+                ExtractDirect(directEntry->second, request->path, &bytesExtracted);
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(libzipMutex);
+                uint64_t lastBytesWritten = 0;
+                ExtractTo(request->zipName, request->path,
+                          [this, &lastBytesWritten](uint64_t bytesWritten)
+                          {
+                              bytesExtracted += bytesWritten - lastBytesWritten;
+                              lastBytesWritten = bytesWritten;
+                          });
+            }
+        }
+        catch (const std::exception &e)
+        {
+            std::lock_guard<std::mutex> lock(extractMutex);
+            if (extractError.empty())
+            {
+                extractError = e.what();
+            }
+        }
+        std::lock_guard<std::mutex> lock(extractMutex);
+        ++extractRequestsDone;
+        extractProgress.notify_all();
+    }
+}
+
+void ZipFileImpl::ExtractFiles(const std::vector<ExtractRequest> &requests, const ProgressCallback &onProgress, size_t threads)
+{
+    if (requests.empty())
+    {
+        return;
+    }
+    // Refuse up front if the declared sizes won't fit; ExtractDirect() and ExtractTo() enforce the declared sizes.
+    uint64_t declaredSize = 0;
+    std::set<std::filesystem::path> targetDirectories;
+    for (const auto &request : requests)
+    {
+        if (!FileExists(request.zipName))
+        {
+            throw std::runtime_error(SS("Zip content file not found: " << request.zipName));
+        }
+        declaredSize += GetDeclaredSize(request.zipName);
+        targetDirectories.insert(request.path.parent_path());
+    }
+    for (const auto &directory : targetDirectories)
+    {
+        std::filesystem::create_directories(directory);
+        if (std::filesystem::space(directory).available < declaredSize)
+        {
+            throw std::runtime_error(SS("Not enough disk space to extract " << requests.size() << " file(s) (" << declaredSize << " bytes)."));
+        }
+    }
+
+    if (threads == 0)
+    {
+        unsigned int nCpus = std::thread::hardware_concurrency();
+        threads = nCpus == 0 ? 1 : nCpus;
+    }
+    threads = std::min(threads, requests.size());
+
+    nextExtractRequest = 0;
+    extractRequestsDone = 0;
+    bytesExtracted = 0;
+    extractError.clear();
+
+    std::vector<std::thread> extractThreads;
+    for (size_t i = 0; i < threads; ++i)
+    {
+        extractThreads.emplace_back([this, &requests]()
+                                    { ExtractThreadProc(&requests); });
+    }
+    {
+        std::unique_lock<std::mutex> lock(extractMutex);
+        while (extractRequestsDone < requests.size() && extractError.empty())
+        {
+            extractProgress.wait_for(lock, std::chrono::milliseconds(250));
+            if (onProgress)
+            {
+                uint64_t done = bytesExtracted;
+                lock.unlock();
+                onProgress(done);
+                lock.lock();
+            }
+        }
+    }
+    for (auto &thread : extractThreads)
+    {
+        thread.join();
+    }
+    if (!extractError.empty())
+    {
+        throw std::runtime_error(extractError);
+    }
+    if (onProgress)
+    {
+        onProgress(bytesExtracted);
     }
 }
 
@@ -313,11 +754,25 @@ size_t ZipFileImpl::GetFileSize(const std::string&filename)
     return stat.size;
 }
 
+uint32_t ZipFileImpl::GetFileCrc(const std::string&filename)
+{
+    zip_stat_t stat;
+    if (zip_stat(zipFile,filename.c_str(),0,&stat) < 0)
+    {
+        throw std::runtime_error("File not found.");
+    }
+    if ((stat.valid & ZIP_STAT_CRC) == 0)
+    {
+        throw std::runtime_error("Failed to get file crc.");
+    }
+    return stat.crc;
+}
+
 class ZipFileWriterImpl : public ZipFileWriter
 {
 public:
-    ZipFileWriterImpl(const std::filesystem::path &path)
-        : path(path)
+    ZipFileWriterImpl(const std::filesystem::path &path, size_t compressionThreads)
+        : path(path), compressionThreads(compressionThreads)
     {
         int errorOp = 0;
         zipFile = zip_open(path.c_str(), ZIP_CREATE | ZIP_TRUNCATE, &errorOp);
@@ -325,46 +780,169 @@ public:
         {
             throw std::runtime_error("Can't open zip file.");
         }
+        if (this->compressionThreads == 0)
+        {
+            unsigned int nCpus = std::thread::hardware_concurrency();
+            this->compressionThreads = nCpus > 1 ? nCpus - 1 : 1;
+        }
     }
     virtual ~ZipFileWriterImpl();
 
     virtual void Close() override; 
 
+    virtual void SetProgressCallback(ProgressCallback &&onProgress) override { this->onProgress = std::move(onProgress); }
     virtual void WriteFile(const std::string &zipFilename,  const std::filesystem::path&sourceFilePath) override;
     virtual void WriteFile(const std::string&filename, const void*buffer, size_t length) override;
+
+    void OnCloseProgress(double progress);
 private:
+    // A file to be deflated on a compression thread.
+    struct PendingFile
+    {
+        std::string zipName;
+        std::filesystem::path path;
+        uint64_t size = 0;
+    };
+    // A temporary zip file holding the deflated content of some of the pending files.
+    struct PartFile
+    {
+        std::unique_ptr<TemporaryFile> file;
+        zip_t *zip = nullptr;
+    };
+
+    void AddFile(const std::string &zipName, const std::filesystem::path &sourcePath, bool store);
+    void CompressPendingFiles();
+    void CompressionThreadProc(std::vector<PartFile> *parts);
+    PartFile ClosePart(zip_t *partZip, std::unique_ptr<TemporaryFile> file);
+    void ReportProgress(uint64_t bytesProcessed);
+
+    static constexpr uint64_t PART_SIZE = 32 * 1024 * 1024;
+
     std::map<std::string, zip_int64_t> nameMap; // avoid o(2) extraction operations.
     const std::filesystem::path path;
     zip_t *zipFile = nullptr;
+    size_t compressionThreads;
+    ProgressCallback onProgress;
+    uint64_t totalBytes = 0;
+    uint64_t compressedBytes = 0;
+
+    std::vector<PendingFile> pendingFiles;
+    std::vector<PartFile> partFiles;
+
+    std::mutex compressionMutex;
+    std::condition_variable compressionProgress;
+    size_t nextPendingFile = 0;
+    uint64_t bytesCompressed = 0;
+    std::string compressionError;
 };
 
-ZipFileWriter::ptr ZipFileWriter::Create(const std::filesystem::path &path)
+ZipFileWriter::ptr ZipFileWriter::Create(const std::filesystem::path &path, size_t compressionThreads)
+{
+    return std::make_unique<ZipFileWriterImpl>(path, compressionThreads);
+}
+
+bool ZipFileWriter::IsStoredFileType(const std::filesystem::path &path)
+{
+    static const std::set<std::string> storedExtensions{
+        ".wav", ".flac", ".mp3", ".ogg", ".opus", ".m4a", ".aac", ".aif", ".aiff", ".wv",
+        ".zip", ".gz", ".xz", ".bz2", ".zst", ".7z",
+        ".png", ".jpg", ".jpeg", ".webp"};
+    std::string extension = path.extension().string();
+    for (char &c : extension)
+    {
+        c = (char)std::tolower((unsigned char)c);
+    }
+    return storedExtensions.contains(extension);
+}
+
+static void ZipProgressCallback(zip_t *zip, double progress, void *userData);
+
+void ZipFileWriterImpl::ReportProgress(uint64_t bytesProcessed)
 {
-    return std::make_unique<ZipFileWriterImpl>(path);
+    if (onProgress)
+    {
+        onProgress(std::min(bytesProcessed, totalBytes), totalBytes);
+    }
 }
 
 void ZipFileWriterImpl::Close() {
     if (zipFile) {
-        zip_close(zipFile);
+        Finally cleanup{[this]() {
+            if (zipFile)
+            {
+                zip_discard(zipFile);
+                zipFile = nullptr;
+            }
+            for (auto &part : partFiles)
+            {
+                if (part.zip)
+                {
+                    zip_discard(part.zip);
+                }
+            }
+            partFiles.clear();
+        }};
+        CompressPendingFiles();
+        if (onProgress)
+        {
+            zip_register_progress_callback_with_state(zipFile, 0.01, ZipProgressCallback, nullptr, this);
+        }
+        if (zip_close(zipFile) < 0)
+        {
+            std::string message = zip_strerror(zipFile);
+            throw std::runtime_error(SS("Failed to write zip file. " << message));
+        }
         zipFile = nullptr;
+        ReportProgress(totalBytes);
     }
 }
+
+static void ZipProgressCallback(zip_t *zip, double progress, void *userData)
+{
+    ((ZipFileWriterImpl *)userData)->OnCloseProgress(progress);
+}
+
 ZipFileWriterImpl::~ZipFileWriterImpl()
 {
-    Close();
+    try
+    {
+        Close();
+    }
+    catch (const std::exception &)
+    {
+    }
 }
 
-void ZipFileWriterImpl::WriteFile(const std::string &filename, const std::filesystem::path &path)
+void ZipFileWriterImpl::AddFile(const std::string &zipName, const std::filesystem::path &sourcePath, bool store)
 {
     zip_error_t error;
-    zip_source_t *source = zip_source_file_create(path.c_str(),0,-1,&error);
+    zip_source_t *source = zip_source_file_create(sourcePath.c_str(),0,-1,&error);
     if (!source) {
-        throw std::runtime_error(SS("Unable to create zip source for file " << path));
+        throw std::runtime_error(SS("Unable to create zip source for file " << sourcePath));
     }
-    if (zip_file_add(zipFile,filename.c_str(),source,ZIP_FL_ENC_UTF_8) < 0)
+    zip_int64_t index = zip_file_add(zipFile,zipName.c_str(),source,ZIP_FL_ENC_UTF_8);
+    if (index < 0)
     {
         zip_source_free(source);
-        throw std::runtime_error(SS("Unable to create add file  " << path));
+        throw std::runtime_error(SS("Unable to create add file  " << sourcePath));
+    }
+    if (store)
+    {
+        zip_set_file_compression(zipFile, (zip_uint64_t)index, ZIP_CM_STORE, 0);
+    }
+}
+
+void ZipFileWriterImpl::WriteFile(const std::string &filename, const std::filesystem::path &path)
+{
+    uint64_t size = std::filesystem::file_size(path);
+    totalBytes += size;
+    if (IsStoredFileType(path) || compressionThreads <= 1 || size == 0)
+    {
+        AddFile(filename, path, IsStoredFileType(path));
+    }
+    else
+    {
+        pendingFiles.push_back(PendingFile{filename, path, size});
     }
 }
 void ZipFileWriterImpl::WriteFile(const std::string&filename, const void*buffer, size_t length) 
@@ -376,4 +954,181 @@ void ZipFileWriterImpl::WriteFile(const std::string&filename, const void*buffer,
         zip_source_free(source);
         throw std::runtime_error(SS("Failed to add file to zip: " << zip_strerror(zipFile)));
     }
+    totalBytes += length;
+}
+
+ZipFileWriterImpl::PartFile ZipFileWriterImpl::ClosePart(zip_t *partZip, std::unique_ptr<TemporaryFile> file)
+{
+    if (zip_close(partZip) < 0)
+    {
+        std::string message = zip_strerror(partZip);
+        zip_discard(partZip);
+        throw std::runtime_error(SS("Failed to compress zip content. " << message));
+    }
+    // reopen for reading, so that the main zip file can copy the deflated data.
+    int errorOp = 0;
+    PartFile result;
+    result.zip = zip_open(file->Path().c_str(), ZIP_RDONLY, &errorOp);
+    if (result.zip == nullptr)
+    {
+        throw std::runtime_error("Can't open zip file.");
+    }
+    result.file = std::move(file);
+    return result;
+}
+
+void ZipFileWriterImpl::CompressionThreadProc(std::vector<PartFile> *parts)
+{
+    // Each thread deflates files into temporary zip files of about PART_SIZE bytes; zip_close() of
+    // the temporary zip file does the compression.
+    zip_t *partZip = nullptr;
+    std::unique_ptr<TemporaryFile> partFile;
+    uint64_t partBytes = 0;
+    try
+    {
+        while (true)
+        {
+            PendingFile *pendingFile = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(compressionMutex);
+                if (nextPendingFile < pendingFiles.size() && compressionError.empty())
+                {
+                    pendingFile = &pendingFiles[nextPendingFile++];
+                }
+            }
+            if (pendingFile == nullptr || (partZip && partBytes >= PART_SIZE))
+            {
+                if (partZip)
+                {
+                    zip_t *t = partZip;
+                    partZip = nullptr;
+                    parts->push_back(ClosePart(t, std::move(partFile)));
+
+                    std::lock_guard<std::mutex> lock(compressionMutex);
+                    bytesCompressed += partBytes;
+                    partBytes = 0;
+                    compressionProgress.notify_all();
+                }
+                if (pendingFile == nullptr)
+                {
+                    break;
+                }
+            }
+            if (!partZip)
+            {
+                partFile = std::make_unique<TemporaryFile>(path.parent_path());
+                int errorOp = 0;
+                partZip = zip_open(partFile->Path().c_str(), ZIP_CREATE | ZIP_TRUNCATE, &errorOp);
+                if (partZip == nullptr)
+                {
+                    throw std::runtime_error("Can't create temporary zip file.");
+                }
+            }
+            zip_error_t error;
+            zip_source_t *source = zip_source_file_create(pendingFile->path.c_str(), 0, -1, &error);
+            if (!source)
+            {
+                throw std::runtime_error(SS("Unable to create zip source for file " << pendingFile->path));
+            }
+            if (zip_file_add(partZip, pendingFile->zipName.c_str(), source, ZIP_FL_ENC_UTF_8) < 0)
+            {
+                zip_source_free(source);
+                throw std::runtime_error(SS("Unable to create add file  " << pendingFile->path));
+            }
+            partBytes += pendingFile->size;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        if (partZip)
+        {
+            zip_discard(partZip);
+        }
+        std::lock_guard<std::mutex> lock(compressionMutex);
+        if (compressionError.empty())
+        {
+            compressionError = e.what();
+        }
+        compressionProgress.notify_all();
+    }
+}
+
+void ZipFileWriterImpl::CompressPendingFiles()
+{
+    if (pendingFiles.empty())
+    {
+        return;
+    }
+    uint64_t pendingBytes = 0;
+    for (const auto &pendingFile : pendingFiles)
+    {
+        pendingBytes += pendingFile.size;
+    }
+    size_t nThreads = std::min(compressionThreads, pendingFiles.size());
+    std::vector<std::vector<PartFile>> threadParts(nThreads);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < nThreads; ++i)
+    {
+        threads.emplace_back([this, &threadParts, i]()
+                             { CompressionThreadProc(&threadParts[i]); });
+    }
+    {
+        std::unique_lock<std::mutex> lock(compressionMutex);
+        while (bytesCompressed < pendingBytes && compressionError.empty())
+        {
+            compressionProgress.wait_for(lock, std::chrono::milliseconds(250));
+            uint64_t done = bytesCompressed;
+            lock.unlock();
+            ReportProgress(done);
+            lock.lock();
+        }
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    for (auto &parts : threadParts)
+    {
+        for (auto &part : parts)
+        {
+            partFiles.push_back(std::move(part));
+        }
+    }
+    if (!compressionError.empty())
+    {
+        throw std::runtime_error(compressionError);
+    }
+
+    // copy the deflated data into the zip file without recompressing it.
+    for (auto &part : partFiles)
+    {
+        zip_int64_t nEntries = zip_get_num_entries(part.zip, 0);
+        for (zip_int64_t i = 0; i < nEntries; ++i)
+        {
+            const char *name = zip_get_name(part.zip, (zip_uint64_t)i, ZIP_FL_ENC_RAW);
+#if LIBZIP_VERSION_MAJOR > 1 || (LIBZIP_VERSION_MAJOR == 1 && LIBZIP_VERSION_MINOR >= 10)
+            // (zip_source_zip() is deprecated from 1.10, which would break the -Werror build.)
+            zip_source_t *source = zip_source_zip_file(zipFile, part.zip, (zip_uint64_t)i, ZIP_FL_COMPRESSED, 0, -1, nullptr);
+#else
+            zip_source_t *source = zip_source_zip(zipFile, part.zip, (zip_uint64_t)i, ZIP_FL_COMPRESSED, 0, -1);
+#endif
+            if (name == nullptr || source == nullptr)
+            {
+                throw std::runtime_error(SS("Failed to add file to zip: " << zip_strerror(zipFile)));
+            }
+            if (zip_file_add(zipFile, name, source, ZIP_FL_ENC_UTF_8) < 0)
+            {
+                zip_source_free(source);
+                throw std::runtime_error(SS("Failed to add file to zip: " << zip_strerror(zipFile)));
+            }
+        }
+    }
+    compressedBytes = pendingBytes;
+    pendingFiles.clear();
+}
+
+void ZipFileWriterImpl::OnCloseProgress(double progress)
+{
+    // zip_close() copies the deflated data, and stores or compresses everything else.
+    ReportProgress(compressedBytes + (uint64_t)(progress * (double)(totalBytes - compressedBytes)));
 }
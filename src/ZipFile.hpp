@@ -18,6 +18,8 @@
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -68,11 +70,25 @@ namespace pipedal {
         ZipFileReader&operator=(const ZipFileReader&) = delete;
         virtual ~ZipFileReader();
 
+        // Called with the number of bytes written so far.
+        using ProgressCallback = std::function<void(uint64_t bytesWritten)>;
+
         virtual const std::vector<std::string>& GetFiles() = 0;
-        virtual void ExtractTo(const std::string &zipName, const std::filesystem::path& path) = 0;
+        virtual void ExtractTo(const std::string &zipName, const std::filesystem::path& path, const ProgressCallback &onProgress = nullptr) = 0;
+
+        struct ExtractRequest {
+            std::string zipName;
+            std::filesystem::path path;
+        };
+        // Extracts several files on up to `threads` threads (0: one per core). onProgress is called on the
+        // calling thread with the total number of bytes written so far. Refuses to start if the declared
+        // sizes won't fit on the target filesystem, and fails any entry whose content exceeds its declared size.
+        virtual void ExtractFiles(const std::vector<ExtractRequest> &files, const ProgressCallback &onProgress = nullptr, size_t threads = 0) = 0;
         virtual bool CompareFiles(const std::string &zipName, const std::filesystem::path& path) = 0;
         virtual zip_file_input_stream GetFileInputStream(const std::string& filename,size_t bufferSize = 16*1024) = 0;
         virtual size_t GetFileSize(const std::string&filename) = 0;
+        // The CRC-32 of the file's uncompressed content, as recorded in the zip directory.
+        virtual uint32_t GetFileCrc(const std::string&filename) = 0;
         virtual bool FileExists(const std::string&fileName) const = 0;
 
     };
@@ -87,7 +103,15 @@ namespace pipedal {
     public:
         using self = ZipFileWriter();
         using ptr = std::shared_ptr<ZipFileWriter>;
-        static ptr Create(const std::filesystem::path &path);
+        // Called during Close() with the number of bytes of content processed so far, and the total.
+        using ProgressCallback = std::function<void(uint64_t bytesProcessed, uint64_t bytesTotal)>;
+
+        // Files are deflated on compressionThreads threads when the zip file is closed (0: one per core, less one).
+        static ptr Create(const std::filesystem::path &path, size_t compressionThreads = 0);
+
+        // Whether files of this type are stored rather than deflated: data that is already compressed,
+        // or audio, which deflate shrinks too little to be worth the time.
+        static bool IsStoredFileType(const std::filesystem::path &path);
 
         ZipFileWriter(const ZipFileReader&) = delete;
         ZipFileWriter&operator=(const ZipFileWriter&) = delete;
@@ -95,6 +119,7 @@ namespace pipedal {
 
         virtual void Close() = 0;
 
+        virtual void SetProgressCallback(ProgressCallback &&onProgress) = 0;
         virtual void WriteFile(const std::string &filename, const std::filesystem::path&path) =  0;
         virtual void WriteFile(const std::string&filename, const void*buffer, size_t length) = 0;
     };
@@ -0,0 +1,892 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * pipedal_bench: a headless benchmark for complete pedalboards.
+ *
+ * Loads a saved preset through the same path the server uses (Storage -> PluginHost -> Lv2Pedalboard::Prepare),
+ * and runs it on a free-running DummyAudioDriver, as fast as the pedalboard can go. Reports throughput, per-period
+ * latency percentiles, and the number of allocations made on the audio thread. Suitable for CI: results can be
+ * written as JSON, and --max-p99-percent / --fail-on-allocation produce a non-zero exit code on regressions.
+ *
+ * With --render, the preset is used to render a WAV file offline instead (e.g. to reamp a DI track, or to
+ * produce reference output for A/B comparisons of plugin builds).
+ */
+
+#include "pch.h"
+#include "PiPedalModel.hpp"
+#include "PiPedalConfiguration.hpp"
+#include "Pedalboard.hpp"
+#include "Lv2Pedalboard.hpp"
+#include "Lv2Log.hpp"
+#include "RingBufferReader.hpp"
+#include "CommandLineParser.hpp"
+#include "DummyAudioDriver.hpp"
+#include "WavFile.hpp"
+#include "EffectTiming.hpp"
+#include "json.hpp"
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include "ss.hpp"
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+/* *** Audio-thread allocation counting.
+ *
+ * Only operator new is counted. Allocations made by C code (malloc) in plugins are not visible here.
+ */
+
+static thread_local bool t_countAllocations = false;
+static std::atomic<uint64_t> realtimeAllocations{0};
+
+static inline void CountAllocation()
+{
+    if (t_countAllocations)
+    {
+        realtimeAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void *operator new(size_t size)
+{
+    CountAllocation();
+    void *p = malloc(size == 0 ? 1 : size);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    CountAllocation();
+    return malloc(size == 0 ? 1 : size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    CountAllocation();
+    void *p = nullptr;
+    if (posix_memalign(&p, std::max(sizeof(void *), (size_t)alignment), size == 0 ? 1 : size) != 0)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    free(p);
+}
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    free(p);
+}
+
+// discards data written to the realtime ring buffer.
+
+using WriterRingbuffer = RingBuffer<false, true>;
+
+class RingBufferSink
+{
+public:
+    RingBufferSink(WriterRingbuffer &writerRingBuffer)
+        : writerRingbuffer(writerRingBuffer)
+    {
+        thread = std::make_unique<std::thread>(
+            [this]()
+            {
+                ThreadProc();
+            });
+    }
+    void Close()
+    {
+        if (!closed)
+        {
+            closed = true;
+            writerRingbuffer.close();
+            thread->join();
+            thread = nullptr;
+        }
+    }
+    ~RingBufferSink()
+    {
+        Close();
+    }
+
+private:
+    void ThreadProc()
+    {
+        std::vector<uint8_t> dataVector(1024);
+        uint8_t *data = dataVector.data();
+        while (true)
+        {
+            RingBufferStatus status = writerRingbuffer.readWait_for(std::chrono::milliseconds(10));
+            if (status == RingBufferStatus::Closed)
+            {
+                break;
+            }
+            if (status == RingBufferStatus::Ready)
+            {
+                size_t available = writerRingbuffer.readSpace();
+                while (available != 0)
+                {
+                    size_t thisTime = std::min(dataVector.size(), available);
+                    writerRingbuffer.read(thisTime, data);
+                    available -= thisTime;
+                }
+            }
+        }
+    }
+    bool closed = false;
+
+    std::unique_ptr<std::thread> thread;
+    WriterRingbuffer &writerRingbuffer;
+};
+
+struct BenchOptions
+{
+    std::string presetName;
+    std::string presetFileName;
+    std::string bankName;
+    std::string periodSizes = "16,32,64,128,256";
+    std::string outputFileName;
+    float benchmarkSeconds = 10;
+    float warmupSeconds = 1;
+    uint32_t sampleRate = 48000;
+    int channels = 2;
+    bool waitForWork = false;
+    bool failOnAllocation = false;
+    float maxP99Percent = 0; // 0: don't check.
+    std::string inputFileName;  // --render input.
+    std::string renderFileName; // --render output.
+    float tailSeconds = 0;
+    uint32_t subBlockFrames = 0; // 0: don't benchmark sub-block processing.
+};
+
+class BenchResult
+{
+public:
+    uint32_t periodSize_ = 0;
+    uint32_t subBlockFrames_ = 0;
+    uint32_t sampleRate_ = 0;
+    uint64_t periods_ = 0;
+    double framesPerSecond_ = 0;
+    double realtimeFactor_ = 0;
+    double budgetUs_ = 0;
+    double meanUs_ = 0;
+    double p50Us_ = 0;
+    double p90Us_ = 0;
+    double p99Us_ = 0;
+    double p999Us_ = 0;
+    double maxUs_ = 0;
+    uint64_t overruns_ = 0;
+    uint64_t realtimeAllocations_ = 0;
+    // mean cost of each additional sub-block, compared with running whole periods.
+    double subBlockOverheadUs_ = 0;
+
+    DECLARE_JSON_MAP(BenchResult);
+};
+
+JSON_MAP_BEGIN(BenchResult)
+JSON_MAP_REFERENCE(BenchResult, periodSize)
+JSON_MAP_REFERENCE(BenchResult, subBlockFrames)
+JSON_MAP_REFERENCE(BenchResult, sampleRate)
+JSON_MAP_REFERENCE(BenchResult, periods)
+JSON_MAP_REFERENCE(BenchResult, framesPerSecond)
+JSON_MAP_REFERENCE(BenchResult, realtimeFactor)
+JSON_MAP_REFERENCE(BenchResult, budgetUs)
+JSON_MAP_REFERENCE(BenchResult, meanUs)
+JSON_MAP_REFERENCE(BenchResult, p50Us)
+JSON_MAP_REFERENCE(BenchResult, p90Us)
+JSON_MAP_REFERENCE(BenchResult, p99Us)
+JSON_MAP_REFERENCE(BenchResult, p999Us)
+JSON_MAP_REFERENCE(BenchResult, maxUs)
+JSON_MAP_REFERENCE(BenchResult, overruns)
+JSON_MAP_REFERENCE(BenchResult, realtimeAllocations)
+JSON_MAP_REFERENCE(BenchResult, subBlockOverheadUs)
+JSON_MAP_END()
+
+/* *** Drives the pedalboard from the dummy driver's audio thread. */
+class BenchDriverHost : public AudioDriverHost
+{
+public:
+    BenchDriverHost(
+        Lv2Pedalboard *lv2Pedalboard,
+        RealtimeRingBufferWriter *ringBufferWriter,
+        uint32_t sampleRate,
+        uint64_t warmupPeriods,
+        uint64_t periods,
+        uint32_t subBlockFrames)
+        : lv2Pedalboard(lv2Pedalboard),
+          ringBufferWriter(ringBufferWriter),
+          warmupPeriods(warmupPeriods),
+          periods(periods),
+          subBlockFrames(subBlockFrames)
+    {
+        periodNs.resize(periods);
+
+        // A decaying 110Hz tone, repeated once a second, so that plugins don't get to run on silence.
+        testSignal.resize(sampleRate);
+        for (size_t i = 0; i < testSignal.size(); ++i)
+        {
+            double t = (double)i / sampleRate;
+            testSignal[i] = (float)(0.25 * std::exp(-3.0 * t) * std::sin(2 * M_PI * 110 * t));
+        }
+    }
+
+    void SetDriver(AudioDriver *audioDriver)
+    {
+        this->audioDriver = audioDriver;
+        inputBuffers.resize(std::max(audioDriver->InputBufferCount(), lv2Pedalboard->GetInputBuffers().size()));
+        outputBuffers.resize(std::max(audioDriver->OutputBufferCount(), lv2Pedalboard->GetoutputBuffers().size()));
+    }
+
+    bool IsDone() const { return done.load(); }
+
+    const std::vector<uint64_t> &GetPeriodNs() const { return periodNs; }
+    uint64_t GetElapsedNs() const { return measureEndNs - measureStartNs; }
+
+    virtual void OnProcess(size_t nFrames) override
+    {
+        if (done.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        for (size_t i = 0; i < inputBuffers.size(); ++i)
+        {
+            inputBuffers[i] = audioDriver->GetInputBuffer(std::min(i, audioDriver->InputBufferCount() - 1));
+        }
+        for (size_t i = 0; i < outputBuffers.size(); ++i)
+        {
+            outputBuffers[i] = audioDriver->GetOutputBuffer(std::min(i, audioDriver->OutputBufferCount() - 1));
+        }
+        for (size_t i = 0; i < nFrames; ++i)
+        {
+            inputBuffers[0][i] = testSignal[signalIndex];
+            if (++signalIndex == testSignal.size())
+            {
+                signalIndex = 0;
+            }
+        }
+        for (size_t c = 1; c < audioDriver->InputBufferCount(); ++c)
+        {
+            std::copy(inputBuffers[0], inputBuffers[0] + nFrames, audioDriver->GetInputBuffer(c));
+        }
+
+        bool measuring = periodIndex >= warmupPeriods;
+
+        uint64_t startNs = EffectTimingClockNs();
+        if (measuring && periodIndex == warmupPeriods)
+        {
+            measureStartNs = startNs;
+        }
+        t_countAllocations = measuring;
+        lv2Pedalboard->RunSubBlocks(
+            inputBuffers.data(), outputBuffers.data(), (uint32_t)nFrames, subBlockFrames,
+            lv2Pedalboard, OnSubBlock, ringBufferWriter);
+        t_countAllocations = false;
+        uint64_t endNs = EffectTimingClockNs();
+
+        if (measuring)
+        {
+            periodNs[periodIndex - warmupPeriods] = endNs - startNs;
+        }
+        if (++periodIndex == warmupPeriods + periods)
+        {
+            measureEndNs = endNs;
+            done.store(true);
+        }
+    }
+    virtual void OnUnderrun() override {}
+    virtual void OnAlsaDriverStopped() override {}
+    virtual void OnAudioTerminated() override
+    {
+        done.store(true);
+    }
+
+private:
+    static void OnSubBlock(void *handle, uint32_t offset, uint32_t frames)
+    {
+        if (offset != 0)
+        {
+            ((Lv2Pedalboard *)handle)->ResetAtomBuffers();
+        }
+    }
+
+    Lv2Pedalboard *lv2Pedalboard;
+    RealtimeRingBufferWriter *ringBufferWriter;
+    AudioDriver *audioDriver = nullptr;
+    uint64_t warmupPeriods;
+    uint64_t periods;
+    uint32_t subBlockFrames;
+    uint64_t periodIndex = 0;
+    uint64_t measureStartNs = 0;
+    uint64_t measureEndNs = 0;
+    std::atomic<bool> done{false};
+
+    std::vector<float> testSignal;
+    size_t signalIndex = 0;
+
+    std::vector<float *> inputBuffers;
+    std::vector<float *> outputBuffers;
+    std::vector<uint64_t> periodNs;
+};
+
+/* *** Renders the pedalboard offline, driven by a free-running dummy driver that reads and writes WAV files. */
+class RenderDriverHost : public AudioDriverHost
+{
+public:
+    RenderDriverHost(Lv2Pedalboard *lv2Pedalboard, RealtimeRingBufferWriter *ringBufferWriter)
+        : lv2Pedalboard(lv2Pedalboard),
+          ringBufferWriter(ringBufferWriter)
+    {
+    }
+    void SetDriver(AudioDriver *audioDriver)
+    {
+        this->audioDriver = audioDriver;
+        inputBuffers.resize(std::max(audioDriver->InputBufferCount(), lv2Pedalboard->GetInputBuffers().size()));
+        outputBuffers.resize(std::max(audioDriver->OutputBufferCount(), lv2Pedalboard->GetoutputBuffers().size()));
+    }
+    void SetDone() { done.store(true); }
+    bool IsDone() const { return done.load(); }
+    bool Failed() const { return failed.load(); }
+
+    virtual void OnProcess(size_t nFrames) override
+    {
+        for (size_t i = 0; i < inputBuffers.size(); ++i)
+        {
+            inputBuffers[i] = audioDriver->GetInputBuffer(std::min(i, audioDriver->InputBufferCount() - 1));
+        }
+        for (size_t i = 0; i < outputBuffers.size(); ++i)
+        {
+            outputBuffers[i] = audioDriver->GetOutputBuffer(std::min(i, audioDriver->OutputBufferCount() - 1));
+        }
+        lv2Pedalboard->Run(inputBuffers.data(), outputBuffers.data(), (uint32_t)nFrames, ringBufferWriter);
+    }
+    virtual void OnUnderrun() override {}
+    virtual void OnAlsaDriverStopped() override {}
+    virtual void OnAudioTerminated() override
+    {
+        failed.store(true);
+        done.store(true);
+    }
+
+private:
+    Lv2Pedalboard *lv2Pedalboard;
+    RealtimeRingBufferWriter *ringBufferWriter;
+    AudioDriver *audioDriver = nullptr;
+    std::atomic<bool> done{false};
+    std::atomic<bool> failed{false};
+    std::vector<float *> inputBuffers;
+    std::vector<float *> outputBuffers;
+};
+
+static void RenderPedalboard(Lv2Pedalboard *lv2Pedalboard, const BenchOptions &options, uint32_t periodSize)
+{
+    uint32_t channels = (uint32_t)std::max(lv2Pedalboard->GetInputBuffers().size(), lv2Pedalboard->GetoutputBuffers().size());
+    std::vector<std::string> inputPorts, outputPorts;
+    for (uint32_t i = 0; i < channels; ++i)
+    {
+        inputPorts.push_back(SS("system::capture_" << i));
+        outputPorts.push_back(SS("system::playback_" << i));
+    }
+    JackServerSettings serverSettings("dummy", "dummy", options.sampleRate, periodSize, 3);
+    JackChannelSelection channelSelection(inputPorts, outputPorts, {});
+
+    WriterRingbuffer writerRingbuffer;
+    RealtimeRingBufferWriter ringBufferWriter(&writerRingbuffer);
+    RingBufferSink ringBufferSink(writerRingbuffer);
+
+    RenderDriverHost driverHost(lv2Pedalboard, &ringBufferWriter);
+
+    DummyAudioDriverOptions driverOptions;
+    driverOptions.freeRunning = true;
+    driverOptions.inputFile = options.inputFileName;
+    driverOptions.outputFile = options.renderFileName;
+    driverOptions.tailSeconds = options.tailSeconds;
+    driverOptions.onRenderComplete = [&driverHost]()
+    {
+        driverHost.SetDone();
+    };
+    {
+        std::unique_ptr<AudioDriver> audioDriver{CreateDummyAudioDriver(&driverHost, SS("dummy:channels_" << channels), driverOptions)};
+        audioDriver->Open(serverSettings, channelSelection);
+        driverHost.SetDriver(audioDriver.get());
+        audioDriver->Activate();
+        while (!driverHost.IsDone())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        audioDriver->Deactivate();
+        audioDriver->Close();
+    }
+    ringBufferSink.Close();
+    if (driverHost.Failed())
+    {
+        throw std::runtime_error("Rendering failed.");
+    }
+}
+
+static std::vector<uint32_t> ParsePeriodSizes(const std::string &text)
+{
+    std::vector<uint32_t> result;
+    std::stringstream s(text);
+    std::string item;
+    while (std::getline(s, item, ','))
+    {
+        uint32_t value = (uint32_t)std::strtoul(item.c_str(), nullptr, 10);
+        if (value == 0 || value > 4096)
+        {
+            throw std::runtime_error(SS("Invalid period size: '" << item << "'."));
+        }
+        result.push_back(value);
+    }
+    if (result.empty())
+    {
+        throw std::runtime_error("No period sizes specified.");
+    }
+    return result;
+}
+
+static double PercentileUs(const std::vector<uint64_t> &sortedNs, double percentile)
+{
+    if (sortedNs.empty())
+    {
+        return 0;
+    }
+    size_t index = std::min(sortedNs.size() - 1, (size_t)(sortedNs.size() * percentile));
+    return sortedNs[index] * 0.001;
+}
+
+static void LoadBenchPreset(PiPedalModel &model, const BenchOptions &options)
+{
+    if (options.presetFileName.length() != 0)
+    {
+        std::ifstream f(options.presetFileName);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Unable to load preset file " << options.presetFileName << "."));
+        }
+        BankFile bankFile;
+        try
+        {
+            json_reader reader(f);
+            reader.read(&bankFile);
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error(SS("Invalid file format:  " << options.presetFileName << ". " << e.what()));
+        }
+        if (bankFile.presets().size() != 1)
+        {
+            throw std::runtime_error(SS("Invalid preset file. Expecting one preset, but " << bankFile.presets().size() << " presets were found."));
+        }
+        Pedalboard pedalboard = bankFile.presets()[0]->preset();
+        model.SetPedalboard(-1, pedalboard);
+        return;
+    }
+    if (options.presetName.length() == 0)
+    {
+        throw std::runtime_error("You must specify either a preset name or a preset file.");
+    }
+    if (options.bankName.length() != 0)
+    {
+        BankIndex bankIndex = model.GetBankIndex();
+        for (const auto &entry : bankIndex.entries())
+        {
+            if (entry.name() == options.bankName)
+            {
+                BankFile bankFile;
+                model.GetBank(entry.instanceId(), &bankFile);
+                for (const auto &preset : bankFile.presets())
+                {
+                    if (preset->name() == options.presetName)
+                    {
+                        Pedalboard pedalboard = preset->preset();
+                        model.SetPedalboard(-1, pedalboard);
+                        return;
+                    }
+                }
+                throw std::runtime_error(SS("Preset '" << options.presetName << "' not found in bank '" << options.bankName << "'."));
+            }
+        }
+        throw std::runtime_error(SS("Bank '" << options.bankName << "' not found."));
+    }
+
+    PresetIndex presetIndex;
+    model.GetPresets(&presetIndex);
+    for (const auto &preset : presetIndex.presets())
+    {
+        if (preset.name() == options.presetName)
+        {
+            model.LoadPreset(-1, preset.instanceId());
+            return;
+        }
+    }
+    throw std::runtime_error(SS("Preset '" << options.presetName << "' not found."));
+}
+
+static BenchResult RunBenchmark(Lv2Pedalboard *lv2Pedalboard, const BenchOptions &options, uint32_t periodSize, uint32_t subBlockFrames)
+{
+    uint32_t channels = (uint32_t)std::max(lv2Pedalboard->GetInputBuffers().size(), lv2Pedalboard->GetoutputBuffers().size());
+    std::vector<std::string> inputPorts, outputPorts;
+    for (uint32_t i = 0; i < channels; ++i)
+    {
+        inputPorts.push_back(SS("system::capture_" << i));
+        outputPorts.push_back(SS("system::playback_" << i));
+    }
+    JackServerSettings serverSettings("dummy", "dummy", options.sampleRate, periodSize, 3);
+    JackChannelSelection channelSelection(inputPorts, outputPorts, {});
+
+    uint64_t warmupPeriods = std::max((uint64_t)1, (uint64_t)(options.warmupSeconds * options.sampleRate / periodSize));
+    uint64_t periods = std::max((uint64_t)1, (uint64_t)(options.benchmarkSeconds * options.sampleRate / periodSize));
+
+    WriterRingbuffer writerRingbuffer;
+    RealtimeRingBufferWriter ringBufferWriter(&writerRingbuffer);
+    RingBufferSink ringBufferSink(writerRingbuffer);
+
+    BenchDriverHost driverHost(lv2Pedalboard, &ringBufferWriter, options.sampleRate, warmupPeriods, periods, subBlockFrames);
+
+    realtimeAllocations = 0;
+    {
+        std::unique_ptr<AudioDriver> audioDriver{CreateDummyAudioDriver(&driverHost, SS("dummy:channels_" << channels), true)};
+        audioDriver->Open(serverSettings, channelSelection);
+        driverHost.SetDriver(audioDriver.get());
+        audioDriver->Activate();
+        while (!driverHost.IsDone())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        audioDriver->Deactivate();
+        audioDriver->Close();
+    }
+    ringBufferSink.Close();
+
+    std::vector<uint64_t> sortedNs = driverHost.GetPeriodNs();
+    std::sort(sortedNs.begin(), sortedNs.end());
+
+    BenchResult result;
+    result.periodSize_ = periodSize;
+    result.subBlockFrames_ = subBlockFrames;
+    result.sampleRate_ = options.sampleRate;
+    result.periods_ = periods;
+    result.budgetUs_ = periodSize * 1000000.0 / options.sampleRate;
+
+    double elapsedS = driverHost.GetElapsedNs() * 1E-9;
+    result.framesPerSecond_ = elapsedS > 0 ? (periods * periodSize) / elapsedS : 0;
+    result.realtimeFactor_ = result.framesPerSecond_ / options.sampleRate;
+
+    double totalNs = 0;
+    for (uint64_t ns : sortedNs)
+    {
+        totalNs += ns;
+        if (ns * 0.001 > result.budgetUs_)
+        {
+            ++result.overruns_;
+        }
+    }
+    result.meanUs_ = totalNs * 0.001 / sortedNs.size();
+    result.p50Us_ = PercentileUs(sortedNs, 0.5);
+    result.p90Us_ = PercentileUs(sortedNs, 0.9);
+    result.p99Us_ = PercentileUs(sortedNs, 0.99);
+    result.p999Us_ = PercentileUs(sortedNs, 0.999);
+    result.maxUs_ = sortedNs.back() * 0.001;
+    result.realtimeAllocations_ = realtimeAllocations.load();
+    return result;
+}
+
+static void WaitForSchedulerWork(Lv2Pedalboard *lv2Pedalboard, uint32_t periodSize)
+{
+    std::vector<float> bufferVector(periodSize * 4);
+    float *inputBuffers[2]{bufferVector.data(), bufferVector.data() + periodSize};
+    float *outputBuffers[2]{bufferVector.data() + 2 * periodSize, bufferVector.data() + 3 * periodSize};
+
+    WriterRingbuffer writerRingbuffer;
+    RealtimeRingBufferWriter ringBufferWriter(&writerRingbuffer);
+    RingBufferSink ringBufferSink(writerRingbuffer);
+
+    // idle, pumping the pedalboard occasionally to allow inital scheduler work to complete.
+    using clock = std::chrono::steady_clock;
+    auto waitStart = clock::now();
+    while (clock::now() - waitStart < std::chrono::seconds(3))
+    {
+        lv2Pedalboard->Run(inputBuffers, outputBuffers, periodSize, &ringBufferWriter);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    ringBufferSink.Close();
+}
+
+static int benchPedalboard(const BenchOptions &options)
+{
+    std::vector<uint32_t> periodSizes = ParsePeriodSizes(options.periodSizes);
+    uint32_t maxPeriodSize = *std::max_element(periodSizes.begin(), periodSizes.end());
+
+    /*** Initialize the model */
+    PiPedalModel model;
+    Lv2Log::log_level(LogLevel::Error);
+    fs::path doc_root = "/etc/pipedal/config";
+    PiPedalConfiguration configuration;
+    try
+    {
+        configuration.Load(doc_root, "");
+    }
+    catch (const std::exception &e)
+    {
+        throw std::runtime_error(SS("Unable to read configuration from '" << (doc_root / "config.json") << "'. (" << e.what() << ")"));
+    }
+
+    model.Init(configuration);
+    model.LoadLv2PluginInfo();
+    // model.Load(); don't start audio.
+
+    model.GetPluginHost().SetAudioConfiguration(options.sampleRate, maxPeriodSize, options.channels, options.channels);
+
+    LoadBenchPreset(model, options);
+
+    /* *** Prepare the audio thread pedalboard. */
+    auto lv2Pedalboard = model.GetLv2Pedalboard();
+    lv2Pedalboard->Activate();
+
+    if (options.waitForWork)
+    {
+        WaitForSchedulerWork(lv2Pedalboard.get(), periodSizes[0]);
+    }
+
+    if (options.renderFileName.length() != 0)
+    {
+        RenderPedalboard(lv2Pedalboard.get(), options, maxPeriodSize);
+        lv2Pedalboard->Deactivate();
+        cout << "Rendered " << options.inputFileName << " to " << options.renderFileName
+             << " through preset " << model.GetCurrentPedalboardCopy().name() << "." << endl;
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<BenchResult> results;
+    for (uint32_t periodSize : periodSizes)
+    {
+        results.push_back(RunBenchmark(lv2Pedalboard.get(), options, periodSize, 0));
+        if (options.subBlockFrames != 0 && options.subBlockFrames < periodSize)
+        {
+            const BenchResult &wholePeriods = results.back();
+            BenchResult result = RunBenchmark(lv2Pedalboard.get(), options, periodSize, options.subBlockFrames);
+            uint32_t subBlocks = (periodSize + options.subBlockFrames - 1) / options.subBlockFrames;
+            result.subBlockOverheadUs_ = (result.meanUs_ - wholePeriods.meanUs_) / (subBlocks - 1);
+            results.push_back(result);
+        }
+    }
+    lv2Pedalboard->Deactivate();
+
+    /* *** Report */
+    cout << "Preset: " << model.GetCurrentPedalboardCopy().name() << endl;
+    cout << std::fixed << std::setprecision(1);
+    cout << setw(8) << "period" << setw(6) << "sub" << setw(10) << "x rt" << setw(11) << "budget" << setw(10) << "mean"
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max"
+         << setw(10) << "overruns" << setw(8) << "allocs" << endl;
+    for (const auto &result : results)
+    {
+        cout << setw(8) << result.periodSize_ << setw(6) << (result.subBlockFrames_ == 0 ? result.periodSize_ : result.subBlockFrames_)
+             << setw(10) << result.realtimeFactor_ << setw(11) << result.budgetUs_
+             << setw(10) << result.meanUs_ << setw(10) << result.p50Us_ << setw(10) << result.p90Us_
+             << setw(10) << result.p99Us_ << setw(10) << result.p999Us_ << setw(10) << result.maxUs_
+             << setw(10) << result.overruns_ << setw(8) << result.realtimeAllocations_ << endl;
+    }
+    cout << "(times in microseconds. x rt: frames per second / sample rate)" << endl;
+    for (const auto &result : results)
+    {
+        if (result.subBlockFrames_ != 0)
+        {
+            cout << "Sub-block overhead (period " << result.periodSize_ << ", sub-block " << result.subBlockFrames_
+                 << "): " << result.subBlockOverheadUs_ << "us per additional sub-block." << endl;
+        }
+    }
+
+    if (options.outputFileName.length() != 0)
+    {
+        std::ofstream f(options.outputFileName);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't write to " << options.outputFileName << "."));
+        }
+        json_writer writer(f, false);
+        writer.write(results);
+    }
+
+    bool failed = false;
+    for (const auto &result : results)
+    {
+        if (options.failOnAllocation && result.realtimeAllocations_ != 0)
+        {
+            cerr << "Error: " << result.realtimeAllocations_ << " allocations on the audio thread (period size " << result.periodSize_ << ")." << endl;
+            failed = true;
+        }
+        if (options.maxP99Percent != 0 && result.p99Us_ > result.budgetUs_ * options.maxP99Percent / 100)
+        {
+            cerr << "Error: p99 period time of " << result.p99Us_ << "us exceeds " << options.maxP99Percent << "% of the "
+                 << result.budgetUs_ << "us budget (period size " << result.periodSize_ << ")." << endl;
+            failed = true;
+        }
+    }
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        BenchOptions options;
+        bool help = false;
+        CommandLineParser commandLineParser;
+        commandLineParser.AddOption("p", "preset-file", &options.presetFileName);
+        commandLineParser.AddOption("b", "bank", &options.bankName);
+        commandLineParser.AddOption("", "periods", &options.periodSizes);
+        commandLineParser.AddOption("r", "rate", &options.sampleRate);
+        commandLineParser.AddOption("c", "channels", &options.channels);
+        commandLineParser.AddOption("s", "seconds", &options.benchmarkSeconds);
+        commandLineParser.AddOption("", "warmup", &options.warmupSeconds);
+        commandLineParser.AddOption("w", "wait-for-work", &options.waitForWork);
+        commandLineParser.AddOption("o", "output", &options.outputFileName);
+        commandLineParser.AddOption("", "fail-on-allocation", &options.failOnAllocation);
+        commandLineParser.AddOption("", "max-p99-percent", &options.maxP99Percent);
+        commandLineParser.AddOption("i", "input", &options.inputFileName);
+        commandLineParser.AddOption("", "render", &options.renderFileName);
+        commandLineParser.AddOption("", "tail", &options.tailSeconds);
+        commandLineParser.AddOption("", "sub-block", &options.subBlockFrames);
+        commandLineParser.AddOption("h", "help", &help);
+
+        commandLineParser.Parse(argc, (const char **)argv);
+
+        bool argumentError = false;
+        if (!help && commandLineParser.Arguments().size() != 1 && options.presetFileName.length() == 0)
+        {
+            cerr << "Error: You must supply either a preset name, or a preset file name" << endl;
+            argumentError = true;
+        }
+
+        if (options.renderFileName.length() != 0)
+        {
+            if (options.inputFileName.length() == 0)
+            {
+                cerr << "Error: --render requires an --input file." << endl;
+                argumentError = true;
+            }
+            else
+            {
+                // render at the input file's sample rate.
+                options.sampleRate = WavReader(options.inputFileName).GetSampleRate();
+            }
+        }
+
+        if (options.channels != 1 && options.channels != 2)
+        {
+            cerr << "Error: --channels must be 1 or 2." << endl;
+            argumentError = true;
+        }
+
+        if (argumentError || help)
+        {
+            cout << "pipedal_bench - Benchmark a PiPedal preset" << endl;
+            cout << "Copyright (c) 2026 Robin E. R. Davies" << endl;
+            cout << endl;
+            cout << "Syntax:  pipedal_bench [preset_name] [options...]" << endl;
+            cout << "         where preset_name is the name of a PiPedal preset in the current bank." << endl;
+            cout << endl;
+            cout << "          The preset is run faster than realtime on the dummy audio driver, once " << endl;
+            cout << "          for each period size." << endl;
+            cout << endl;
+            cout << "Options:" << endl;
+            cout << "    -p, --preset-file filename:" << endl;
+            cout << "          Load the specified preset file. " << endl;
+            cout << "    -b, --bank bank_name:" << endl;
+            cout << "          Look for preset_name in the named bank instead of the current bank. " << endl;
+            cout << "    --periods n,n,...:" << endl;
+            cout << "          Period sizes to run, in frames. Defaults to 16,32,64,128,256" << endl;
+            cout << "    -r, --rate sample_rate:" << endl;
+            cout << "          Defaults to 48000." << endl;
+            cout << "    -c, --channels 1|2:" << endl;
+            cout << "          Number of audio input and output channels. Defaults to 2." << endl;
+            cout << "    -s, --seconds time_in_seconds: " << endl;
+            cout << "          The number of seconds of audio to process for each period size." << endl;
+            cout << "    --warmup time_in_seconds: " << endl;
+            cout << "          Seconds of audio to process before measuring. Defaults to 1." << endl;
+            cout << "    -w, --wait-for-work: " << endl;
+            cout << "          Assume that plugins will load data on the LV2 scheduler thread." << endl;
+            cout << "    -o, --output filename:" << endl;
+            cout << "          Write results to a JSON file." << endl;
+            cout << "    --fail-on-allocation:" << endl;
+            cout << "          Exit with an error if operator new is called on the audio thread." << endl;
+            cout << "    --max-p99-percent percent:" << endl;
+            cout << "          Exit with an error if the 99th percentile period time exceeds " << endl;
+            cout << "          the given percentage of the period's time budget." << endl;
+            cout << "    --render filename.wav:" << endl;
+            cout << "          Instead of benchmarking, process the --input file through the preset, " << endl;
+            cout << "          and write the result to a 32-bit float WAV file. Uses the largest " << endl;
+            cout << "          --periods size, and the input file's sample rate." << endl;
+            cout << "    -i, --input filename.wav:" << endl;
+            cout << "          The input file for --render." << endl;
+            cout << "    --tail time_in_seconds:" << endl;
+            cout << "          Seconds of silence to process after the input (e.g. for reverb tails)." << endl;
+            cout << "    --sub-block frames:" << endl;
+            cout << "          Also run each larger period size in sub-blocks of this many frames" << endl;
+            cout << "          (see subBlockFrames in config.json), and report the cost of each " << endl;
+            cout << "          additional sub-block." << endl;
+            cout << "    -h, --help:  display this message." << endl;
+            cout << endl;
+            return help ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        if (commandLineParser.Arguments().size() != 0)
+        {
+            options.presetName = commandLineParser.Arguments()[0];
+        }
+
+        return benchPedalboard(options);
+    }
+    catch (const std::exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -17,6 +17,8 @@
 // IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+#pragma once
+
 /// @brief A mutex that handles priority-inversion.
 /// The thread priority of a thread that holds the mutex is boosted to the highest priority of waiting threads, thereby avoiding priority inversion.
 ///
@@ -44,6 +46,12 @@ public:
     using native_handle_type = pthread_mutex_t *;
 
     inverting_mutex()
+        : inverting_mutex(PTHREAD_MUTEX_DEFAULT)
+    {
+    }
+
+protected:
+    inverting_mutex(int mutexType)
     {
 
         pthread_mutexattr_t mta;
@@ -52,14 +60,21 @@ public:
         if (rc != 0)
             throw_system_error(rc);
 
-        rc = pthread_mutexattr_setprotocol(&mta, PTHREAD_PRIO_INHERIT);
-        if (rc != 0)
-            throw_system_error(rc);
-
-        rc = pthread_mutex_init(&mutex, &mta);
+        rc = pthread_mutexattr_settype(&mta, mutexType);
+        if (rc == 0)
+        {
+            rc = pthread_mutexattr_setprotocol(&mta, PTHREAD_PRIO_INHERIT);
+        }
+        if (rc == 0)
+        {
+            rc = pthread_mutex_init(&mutex, &mta);
+        }
+        pthread_mutexattr_destroy(&mta);
         if (rc != 0)
             throw_system_error(rc);
     }
+
+public:
     ~inverting_mutex()
     {
         pthread_mutex_destroy(&mutex);
@@ -191,4 +206,14 @@ private:
         throw std::logic_error(strerror(e));
     }
     pthread_mutex_t mutex;
-};
\ No newline at end of file
+};
+
+/// @brief A recursive mutex that handles priority-inversion.
+class inverting_recursive_mutex : public inverting_mutex
+{
+public:
+    inverting_recursive_mutex()
+        : inverting_mutex(PTHREAD_MUTEX_RECURSIVE)
+    {
+    }
+};
@@ -22,6 +22,7 @@
 #include <sstream>
 #include <cstdint>
 #include <string>
+#include <chrono>
 
 #include "json.hpp"
 #include "json_variant.hpp"
@@ -158,6 +159,218 @@ TEST_CASE("json smart ptrs", "[json_smart_ptrs][Build][Dev]")
     }
 }
 
+TEST_CASE("json scanner", "[json_scanner][Build][Dev]")
+{
+    {
+        // escapes that straddle the eight-byte scanning window.
+        std::string json = "\"0123456\\\"89abcdef\\\\ghijklm\\u00e9\\ud83d\\ude00\\n\"";
+        json_reader reader{std::string_view(json)};
+        std::string value = reader.read_string();
+        REQUIRE(value == "0123456\"89abcdef\\ghijklm\xC3\xA9\xF0\x9F\x98\x80\n");
+        REQUIRE(reader.is_complete());
+    }
+    {
+        std::string json = "/* comment */ [ -12, 3.5e-2, 18446744073709551615, // trailing\n 1e3 ]";
+        json_reader reader{std::string_view(json)};
+        reader.consume('[');
+        int i;
+        reader.read(&i);
+        REQUIRE(i == -12);
+        reader.consume(',');
+        double d;
+        reader.read(&d);
+        REQUIRE(d == 3.5e-2);
+        reader.consume(',');
+        unsigned long long ull;
+        reader.read(&ull);
+        REQUIRE(ull == 18446744073709551615ULL);
+        reader.consume(',');
+        float f;
+        reader.read(&f);
+        REQUIRE(f == 1000.0f);
+        reader.consume(']');
+        REQUIRE(reader.is_complete());
+    }
+    {
+        std::string json = "{\"a\": [1, {\"b\": \"}\"}], \"c\": 7}";
+        json_reader reader{std::string_view(json)};
+        reader.start_object();
+        REQUIRE(reader.read_string() == "a");
+        reader.consume(':');
+        reader.skip_property();
+        reader.consume(',');
+        REQUIRE(reader.read_string() == "c");
+        reader.consume(':');
+        REQUIRE(reader.tell() == json.find(':', json.find("\"c\"")) + 1);
+        int c;
+        reader.read(&c);
+        REQUIRE(c == 7);
+        reader.end_object();
+    }
+    {
+        std::string json = "[1, 2";
+        json_reader reader{std::string_view(json)};
+        std::vector<int> values;
+        REQUIRE_THROWS(reader.read(&values));
+    }
+}
+
+TEST_CASE("json string writer", "[json_string_writer][Build][Dev]")
+{
+    JsonTestTarget target;
+    target.string_ = "tab\there \"quoted\" \\ \xC3\xA9\xF0\x9F\x98\x80 plain ascii text";
+    target.float_ = 0.1f;
+    target.double_ = 3.25E19;
+    for (bool compressed : {true, false})
+    {
+        std::stringstream s;
+        {
+            json_writer writer(s, compressed);
+            writer.write(target);
+        }
+        std::string buffer;
+        {
+            json_writer writer(buffer, compressed);
+            writer.write(target);
+        }
+        REQUIRE(buffer == s.str());
+    }
+    std::string buffer;
+    json_writer writer(buffer);
+    writer.write(target.string_);
+    REQUIRE(buffer == "\"tab\\there \\\"quoted\\\" \\\\ \\u00E9\\uD83D\\uDE00 plain ascii text\"");
+
+    buffer.clear();
+    writer.write(target.float_);
+    writer.write_raw(",");
+    writer.write(target.double_);
+    writer.write_raw(",");
+    writer.write(-17);
+    writer.write_raw(",");
+    writer.write(std::numeric_limits<unsigned long long>::max());
+    REQUIRE(buffer == "0.100000001,3.25e+19,-17,18446744073709551615");
+}
+
+TEST_CASE("json reader benchmark", "[json_benchmark][Dev]")
+{
+    using namespace std::chrono;
+    constexpr int OBJECTS = 20000;
+    constexpr int ITERATIONS = 10;
+
+    std::stringstream os;
+    {
+        json_writer writer(os);
+        os << '[';
+        for (int i = 0; i < OBJECTS; ++i)
+        {
+            if (i != 0)
+            {
+                os << ',';
+            }
+            JsonTestTarget target;
+            target.string_ = "http://two-play.com/plugins/toob-amp#" + std::to_string(i);
+            target.double_ = i * 0.3183;
+            writer.write(target);
+        }
+        os << ']';
+    }
+    std::string json = os.str();
+
+    auto readAll = [](json_reader &reader)
+    {
+        int count = 0;
+        reader.consume('[');
+        while (reader.peek() != ']')
+        {
+            JsonTestTarget target;
+            reader.read(&target);
+            ++count;
+            if (reader.peek() == ',')
+            {
+                reader.consume(',');
+            }
+        }
+        reader.consume(']');
+        return count;
+    };
+
+    auto start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        std::stringstream s(json);
+        json_reader reader(s);
+        REQUIRE(readAll(reader) == OBJECTS);
+    }
+    auto streamTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        json_reader reader{std::string_view(json)};
+        REQUIRE(readAll(reader) == OBJECTS);
+    }
+    auto viewTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    double mb = json.size() * (double)ITERATIONS / (1024.0 * 1024.0);
+    std::cout << "json reader benchmark (" << json.size() / 1024 << "KB)" << std::endl;
+    std::cout << "    std::istream:     " << mb / (streamTime * 1E-9) << " MB/s" << std::endl;
+    std::cout << "    std::string_view: " << mb / (viewTime * 1E-9) << " MB/s" << std::endl;
+}
+
+TEST_CASE("json writer benchmark", "[json_benchmark][Dev]")
+{
+    using namespace std::chrono;
+    constexpr int OBJECTS = 20000;
+    constexpr int ITERATIONS = 10;
+
+    std::vector<JsonTestTarget> targets(OBJECTS);
+    for (int i = 0; i < OBJECTS; ++i)
+    {
+        targets[i].string_ = "http://two-play.com/plugins/toob-amp#" + std::to_string(i);
+        targets[i].double_ = i * 0.3183;
+        targets[i].float_ = i * 0.173f;
+    }
+    auto writeAll = [&targets](json_writer &writer)
+    {
+        writer.start_array();
+        for (size_t i = 0; i < targets.size(); ++i)
+        {
+            if (i != 0)
+            {
+                writer.write_raw(",");
+            }
+            writer.write(targets[i]);
+        }
+        writer.end_array();
+    };
+
+    size_t size = 0;
+    auto start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        std::stringstream s;
+        json_writer writer(s);
+        writeAll(writer);
+        size = s.str().size();
+    }
+    auto streamTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        std::string buffer;
+        json_writer writer(buffer);
+        writeAll(writer);
+        REQUIRE(buffer.size() == size);
+    }
+    auto bufferTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    double mb = size * (double)ITERATIONS / (1024.0 * 1024.0);
+    std::cout << "json writer benchmark (" << size / 1024 << "KB)" << std::endl;
+    std::cout << "    std::ostream: " << mb / (streamTime * 1E-9) << " MB/s" << std::endl;
+    std::cout << "    std::string:  " << mb / (bufferTime * 1E-9) << " MB/s" << std::endl;
+}
+
 template <typename U>
 U & VariantAs(json_variant& v)
 {
@@ -333,3 +546,110 @@ TEST_CASE("json variants", "[json_variants][Build][Dev]")
     REQUIRE(json_object::allocation_count() == 0);
     REQUIRE(json_array::allocation_count() == 0);
 }
+
+namespace
+{
+    // counts allocations passed through to the default resource.
+    class CountingMemoryResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            return std::pmr::get_default_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+
+    // a patch-property-like payload: nested objects with short arrays.
+    std::string MakeVariantTestDocument(int items)
+    {
+        std::stringstream s;
+        s << "{\"uri\": \"http://two-play.com/plugins/toob-convolution-reverb#impulseFile\", \"items\": [";
+        for (int i = 0; i < items; ++i)
+        {
+            if (i != 0)
+            {
+                s << ",";
+            }
+            s << "{\"id\": " << i << ", \"name\": \"item" << i << "\", \"range\": [0, 1, " << i << "], \"enabled\": true,"
+              << " \"position\": {\"x\": 0.5, \"y\": " << (i * 0.25) << "}}";
+        }
+        s << "]}";
+        return s.str();
+    }
+}
+
+TEST_CASE("json variant memory resource", "[json_variants][Build][Dev]")
+{
+    std::string json = MakeVariantTestDocument(100);
+    json_variant expected = json_variant::parse(json);
+
+    CountingMemoryResource heap;
+    size_t heapAllocations;
+    {
+        json_variant v = json_variant::parse(json, &heap);
+        REQUIRE(v == expected);
+        heapAllocations = heap.allocations;
+    }
+
+    CountingMemoryResource upstream;
+    {
+        std::pmr::monotonic_buffer_resource arena(&upstream);
+        {
+            json_variant v = json_variant::parse(json, &arena);
+            REQUIRE(v == expected);
+            REQUIRE(v["items"][5]["position"]["y"].as_number() == 1.25);
+
+            // nodes added later come from the node's own resource, not the current one.
+            v["items"].as_array()->push_back(json_variant::make_object());
+            REQUIRE(v["items"].size() == 101);
+        }
+        REQUIRE(upstream.allocations < heapAllocations / 20);
+    }
+    expected = json_variant();
+    REQUIRE(json_object::allocation_count() == 0);
+    REQUIRE(json_array::allocation_count() == 0);
+}
+
+TEST_CASE("json variant parse benchmark", "[json_benchmark][Dev]")
+{
+    using namespace std::chrono;
+    constexpr int ITERATIONS = 20;
+    std::string json = MakeVariantTestDocument(2000);
+
+    CountingMemoryResource heap;
+    auto start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        json_variant v = json_variant::parse(json, &heap);
+        REQUIRE(v.size() == 2);
+    }
+    auto heapTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    CountingMemoryResource upstream;
+    start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        std::pmr::monotonic_buffer_resource arena(&upstream);
+        json_variant v = json_variant::parse(json, &arena);
+        REQUIRE(v.size() == 2);
+    }
+    auto arenaTime = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+    std::cout << "json_variant parse benchmark (" << json.size() / 1024 << "KB)" << std::endl;
+    std::cout << "    heap:  " << heapTime * 1E-6 / ITERATIONS << " ms/parse, "
+              << heap.allocations / ITERATIONS << " node allocations/parse" << std::endl;
+    std::cout << "    arena: " << arenaTime * 1E-6 / ITERATIONS << " ms/parse, "
+              << upstream.allocations / ITERATIONS << " block allocations/parse" << std::endl;
+}
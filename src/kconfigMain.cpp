@@ -58,6 +58,8 @@
 #include "CommandLineParser.hpp"
 #include "PrettyPrinter.hpp"
 #include "SysExec.hpp"
+#include <future>
+#include <iostream>
 
 
 using namespace ftxui;
@@ -638,6 +640,42 @@ void kconfigUi(void)
 }
 
 
+static int setIsolatedCpus(const std::string &cpuList)
+{
+    try
+    {
+        BootConfig bootConfig;
+        if (!bootConfig.CanWriteConfig())
+        {
+            throw std::runtime_error("Unrecognized boot loader. Unable to reconfigure the kernel.");
+        }
+        bootConfig.IsolatedCpus(cpuList);
+        if (!bootConfig.Changed())
+        {
+            std::cout << "No changes." << std::endl;
+            return EXIT_SUCCESS;
+        }
+        std::promise<std::string> result;
+        bootConfig.WriteConfiguration(
+            [&result](bool success, std::string errorMessage)
+            {
+                result.set_value(success ? "" : errorMessage);
+            });
+        std::string errorMessage = result.get_future().get();
+        if (!errorMessage.empty())
+        {
+            throw std::runtime_error(errorMessage);
+        }
+        std::cout << "Reboot to apply the changes." << std::endl;
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
+
 void printHelp()
 {
     using namespace std;
@@ -666,6 +704,14 @@ void printHelp()
         << Indent(0)
         << "These settings have no effect on PREEMT_RT kernels (like Raspberry Pi OS), since PREEMPT_RT kernels turn these features on by default."
         << "\n\n"
+        << "Options:"
+        << "\n\n"
+        << Indent(20)
+        << HangingIndent()
+        << "   --isolcpus <cpus>\tReserve cpus for realtime audio (e.g. 3, or 2-3) by setting the isolcpus and nohz_full kernel arguments, without displaying the user interface. "
+        << "'none' removes them. Set realtimeCpus in /etc/pipedal/config/config.json to the same cpus."
+        << "\n\n"
+        << Indent(0)
         << "pipedal_kconfig needs to run with root privileges."
         << "\n\n"
         ;
@@ -677,7 +723,9 @@ int main(int argc, char**argv)
 {
     bool help = false;
     bool noSudo = false;
+    std::string isolatedCpus;
     CommandLineParser cmdline;
+    cmdline.AddOption("--isolcpus",&isolatedCpus);
     cmdline.AddOption("-h",&help);
     cmdline.AddOption("--help",&help);
     cmdline.AddOption("--no-sudo",&noSudo); // undocumented option to allow debugging of most of the code, except for the finial privileged bits.
@@ -705,6 +753,11 @@ int main(int argc, char**argv)
     }
 
 
+    if (!isolatedCpus.empty())
+    {
+        return setIsolatedCpus(isolatedCpus == "none" ? "" : isolatedCpus);
+    }
+
     kconfigUi();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+/*
+ *   Copyright (c) 2026 Robin E. R. Davies
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef PIPEDAL_ALWAYS_RUN_FEATURE_H
+#define PIPEDAL_ALWAYS_RUN_FEATURE_H
+
+#define PIPEDAL__ALWAYS_RUN_FEATURE "http://github.com/rerdavies/pipedal/ext/#alwaysRun"
+
+/*
+    Opts a plugin out of idling.
+
+    PiPedal stops running effects whose input and output have been silent for a while, and fades
+    their output in when signal returns. Plugins whose sound depends on state that advances while
+    they are silent (LFO phase, sequencers, loopers) can declare this feature, as either an
+    lv2:optionalFeature or an lv2:requiredFeature, to be run every period. There is no feature data.
+
+        <http://example.com/plugins/tremolo>
+            lv2:optionalFeature <http://github.com/rerdavies/pipedal/ext/#alwaysRun> .
+*/
+
+#endif
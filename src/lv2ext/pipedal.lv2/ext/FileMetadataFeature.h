@@ -28,6 +28,14 @@
 
 #define PIPEDAL__FILE_METADATA_FEATURE "http://github.com/rerdavies/pipedal/ext/#fileMetadata"
 
+/**
+   Read-only metadata key: the absolute path of a decoded (FLAC) copy of a compressed audio file, if the host
+   has one. Plugins that play audio files can open the decoded file instead, and avoid decoding during playback.
+   getFileMetadata() returns 0 if there is no decoded copy. The decoded file may be deleted once the plugin
+   has opened it, so plugins should open it promptly, and keep it open.
+*/
+#define PIPEDAL__FILE_METADATA_DECODED_FILE_KEY "http://github.com/rerdavies/pipedal/ext/#decodedFile"
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -0,0 +1,156 @@
+/*
+ *   Copyright (c) 2026 Robin E. R. Davies
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef PIPEDAL_FILE_STREAM_FEATURE_H
+#define PIPEDAL_FILE_STREAM_FEATURE_H
+#include "lv2/core/lv2.h"
+#include <stdint.h>
+
+#define PIPEDAL__FILE_STREAM_FEATURE "http://github.com/rerdavies/pipedal/ext/#fileStream"
+
+/*
+    Host read-ahead for plugins that stream files from disk (file players, loopers, samplers).
+
+    The host opens the file, and keeps a read-ahead window of the file in locked memory, filled
+    by a host i/o thread. The plugin reads from the window on the realtime thread without blocking.
+
+    Seeking outside the read-ahead window would normally mean a period or two of silence while
+    the window is refilled. To avoid that, plugins can set cue points: offsets that the plugin
+    expects to seek to (the start of the file, loop points, markers, the current playback position
+    before a seek is committed). The host keeps a window of data at each cue point in locked memory;
+    seeks that land in a cue window are served from it immediately, while the read-ahead window is
+    refilled behind it. Cue point 0 is set to the start of the file when the stream is opened.
+
+    open() and close() may block, and must not be called on the realtime thread. All other
+    functions are realtime-safe and non-blocking, and must be called only from the plugin's
+    realtime thread (i.e. from run()).
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    typedef void *PIPEDAL_FILE_STREAM_Handle;
+
+    typedef struct PIPEDAL_FileStream PIPEDAL_FileStream; ///< Opaque stream handle.
+
+    typedef enum
+    {
+        PIPEDAL_FILE_STREAM_SUCCESS = 0,           /**< Completed successfully. */
+        PIPEDAL_FILE_STREAM_INVALID_PATH = 1,      /**< File does not exist, or is not a regular file. */
+        PIPEDAL_FILE_STREAM_PERMISSION_DENIED = 2, /**< Permission denied. */
+        PIPEDAL_FILE_STREAM_ERR_UNKNOWN = 3,       /**< Unknown error. */
+        PIPEDAL_FILE_STREAM_INVALID_PARAMETER = 4, /**< An invalid parameter was supplied. */
+    } PIPEDAL_FileStream_Status;
+
+    typedef enum
+    {
+        PIPEDAL_FILE_STREAM_SEQUENTIAL = 0, /**< Mostly sequential reads, occasional seeks. */
+        PIPEDAL_FILE_STREAM_RANDOM = 1,     /**< Frequent seeks (e.g. a sampler). Use cue points generously. */
+    } PIPEDAL_FileStream_AccessPattern;
+
+    typedef struct
+    {
+        /**
+            Opaque host data.
+        */
+        PIPEDAL_FILE_STREAM_Handle handle;
+
+        /**
+          Open a file for streaming.
+          @param handle MUST be the `handle` member of this struct.
+          @param absolute_path The absolute path of a file.
+          @param accessPattern The expected access pattern.
+          @param readAheadBytes Size of the read-ahead window, in bytes. 0 selects the host default (1MB).
+          @param cueWindowBytes Size of each cue window, in bytes. 0 selects the host default (256KB).
+          @param status Receives a status code indicating success or failure.
+          @return A stream, or NULL if the file could not be opened.
+
+          Not realtime-safe. Call from instantiate(), or from a worker thread.
+        */
+        PIPEDAL_FileStream *(*open)(
+            PIPEDAL_FILE_STREAM_Handle handle,
+            const char *absolute_path,
+            PIPEDAL_FileStream_AccessPattern accessPattern,
+            uint64_t readAheadBytes,
+            uint64_t cueWindowBytes,
+            PIPEDAL_FileStream_Status *status);
+
+        /**
+          Close a stream.
+
+          Not realtime-safe. Call from cleanup(), or from a worker thread, once the realtime thread
+          has stopped using the stream.
+        */
+        void (*close)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+
+        /**
+          The size of the file, in bytes.
+        */
+        uint64_t (*size)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+
+        /**
+          Read data at the current position, and advance the position by the number of bytes read.
+          @return The number of bytes read. Less than `bytes` if the end of the file was reached, or if
+          the data isn't available yet. Never blocks.
+        */
+        uint64_t (*read)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, void *buffer, uint64_t bytes);
+
+        /**
+          The current read position.
+        */
+        uint64_t (*tell)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+
+        /**
+          Set the current read position.
+        */
+        void (*seek)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint64_t position);
+
+        /**
+          The number of bytes that can currently be read without starving.
+        */
+        uint64_t (*available)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream);
+
+        /**
+          Set a cue point.
+          @param cueIndex The index of the cue point: 0 to maxCuePoints()-1.
+          @param position The file position of the cue point.
+          @return PIPEDAL_FILE_STREAM_INVALID_PARAMETER if the index is out of range.
+
+          The cue window is loaded asynchronously. Seeks to the cue point are served from the cue
+          window once it has been loaded.
+        */
+        PIPEDAL_FileStream_Status (*setCuePoint)(PIPEDAL_FILE_STREAM_Handle handle, PIPEDAL_FileStream *stream, uint32_t cueIndex, uint64_t position);
+
+        /**
+          The number of cue points per stream.
+        */
+        uint32_t (*maxCuePoints)(PIPEDAL_FILE_STREAM_Handle handle);
+
+    } PIPEDAL_FileStream_Interface;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPEDAL_FILE_STREAM_FEATURE_H
@@ -0,0 +1,161 @@
+/*
+ *   Copyright (c) 2026 Robin E. R. Davies
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef PIPEDAL_SHARED_RESOURCE_FEATURE_H
+#define PIPEDAL_SHARED_RESOURCE_FEATURE_H
+#include "lv2/core/lv2.h"
+#include <stdint.h>
+
+#define PIPEDAL__SHARED_RESOURCE_FEATURE "http://github.com/rerdavies/pipedal/ext/#sharedResource"
+
+/*
+    Host-shared, read-only resource files.
+
+    When a pedalboard contains several instances of a plugin that load the same model or impulse
+    response file (an A/B split, or the same plugin in a preloaded pedalboard), each instance
+    would normally load and keep its own copy of the data. With this feature, plugins ask the host
+    for the file instead. The host memory-maps each distinct file once, identifies it by the
+    hash of its contents, and hands out reference-counted, immutable views of it to every
+    instance that asks. Files with identical content are shared even if they have different paths.
+
+    Plugins that convert file data into another form (parsed model weights, FFT'd impulse response
+    partitions) can have the host cache the converted form too, with acquireDerivedResource().
+    The conversion runs once per (file content, key) pair, and the result is shared in the same way.
+
+    All functions are thread-safe, but may block for a long time (they perform file i/o). They must
+    not be called from the realtime thread. Call them from instantiate(), or from a worker thread.
+    Resources may be released from any non-realtime thread, including from the plugin's cleanup()
+    method. Resources that have not been released when the plugin is freed are leaked.
+*/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    typedef void *PIPEDAL_SHARED_RESOURCE_Handle;
+
+    typedef enum
+    {
+        PIPEDAL_SHARED_RESOURCE_SUCCESS = 0,           /**< Completed successfully. */
+        PIPEDAL_SHARED_RESOURCE_INVALID_PATH = 1,      /**< File does not exist, or is not a regular file. */
+        PIPEDAL_SHARED_RESOURCE_PERMISSION_DENIED = 2, /**< Permission denied. */
+        PIPEDAL_SHARED_RESOURCE_ERR_UNKNOWN = 3,       /**< Unknown error. */
+        PIPEDAL_SHARED_RESOURCE_BUILD_FAILED = 4,      /**< The plugin's build function failed. */
+    } PIPEDAL_SharedResource_Status;
+
+    /**
+        An immutable, shared resource.
+
+        The data pointer remains valid until the resource is released with releaseResource().
+        Plugins MUST NOT write to the data.
+    */
+    typedef struct
+    {
+        const void *data;        /**< File contents (or the derived data). */
+        uint64_t size;           /**< Size of the data, in bytes. */
+        const char *contentHash; /**< BLAKE3 hash of the file contents, as 64 lower-case hex digits. */
+    } PIPEDAL_SharedResource;
+
+    /**
+        Build derived data from the contents of a file.
+
+        @param context The `context` parameter passed to acquireDerivedResource().
+        @param fileData The contents of the file.
+        @param fileSize The size of the file, in bytes.
+        @param derivedData Receives a pointer to the derived data.
+        @param derivedSize Receives the size of the derived data, in bytes (used for accounting only).
+        @param freeDerivedData Receives a function that frees the derived data.
+        @return Non-zero if successful.
+
+        The build function is called at most once for any given (content, key) pair while a resource
+        is held. It runs on the thread that called acquireDerivedResource(). Derived data is freed by the
+        host, by calling freeDerivedData, once the last reference to the resource has been released, so
+        freeDerivedData must not depend on the plugin instance that built it (a static function in the 
+        plugin library is fine).
+    */
+    typedef int (*PIPEDAL_SharedResource_BuildFn)(
+        void *context,
+        const void *fileData,
+        uint64_t fileSize,
+        void **derivedData,
+        uint64_t *derivedSize,
+        void (**freeDerivedData)(void *derivedData));
+
+    typedef struct
+    {
+        /**
+            Opaque host data.
+        */
+        PIPEDAL_SHARED_RESOURCE_Handle handle;
+
+        /**
+           Acquire a shared, read-only view of a file's contents.
+          @param handle MUST be the `handle` member of this struct.
+          @param absolute_path The absolute path of a file.
+          @param resource Receives the shared resource.
+          @return A status code indicating success or failure.
+
+          Each successful call must be balanced by a call to releaseResource().
+        */
+        PIPEDAL_SharedResource_Status (*acquireResource)(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const char *absolute_path,
+            const PIPEDAL_SharedResource **resource);
+
+        /**
+           Acquire shared data derived from a file's contents.
+          @param handle MUST be the `handle` member of this struct.
+          @param absolute_path The absolute path of a file.
+          @param key A plugin-defined key (typically a URI) that identifies the kind of derived data. Include
+                  anything that affects the result (e.g. a format version, or the sample rate) in the key.
+          @param build A function that builds the derived data, if it's not already cached.
+          @param context Passed to build.
+          @param resource Receives the shared resource. `data` and `size` are the derived data; `contentHash`
+                  is the hash of the source file.
+          @return A status code indicating success or failure.
+
+          Each successful call must be balanced by a call to releaseResource().
+        */
+        PIPEDAL_SharedResource_Status (*acquireDerivedResource)(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const char *absolute_path,
+            const char *key,
+            PIPEDAL_SharedResource_BuildFn build,
+            void *context,
+            const PIPEDAL_SharedResource **resource);
+
+        /**
+           Release a resource returned by acquireResource() or acquireDerivedResource().
+          @param handle MUST be the `handle` member of this struct.
+          @param resource The resource to release.
+        */
+        void (*releaseResource)(
+            PIPEDAL_SHARED_RESOURCE_Handle handle,
+            const PIPEDAL_SharedResource *resource);
+    } PIPEDAL_SharedResource_Interface;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIPEDAL_SHARED_RESOURCE_FEATURE_H
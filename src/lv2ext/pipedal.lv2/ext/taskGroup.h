@@ -0,0 +1,157 @@
+/*
+ *   Copyright (c) 2026 Robin E. R. Davies
+ *   All rights reserved.
+
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+
+ *   The above copyright notice and this permission notice shall be included in all
+ *   copies or substantial portions of the Software.
+
+ *   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *   AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *   LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *   OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *   SOFTWARE.
+ */
+
+#ifndef PIPEDAL_TASKGROUP_H
+#define PIPEDAL_TASKGROUP_H
+
+#define LV2_TASKGROUP_URI "http://two-play.com/ns/ext/taskGroup"
+#define LV2_TASKGROUP_PREFIX LV2_TASKGROUP_URI "#"
+#define LV2_TASKGROUP__taskGroup LV2_TASKGROUP_PREFIX "taskGroup"  ///< http://two-play.com/ns/ext/taskGroup#taskGroup >
+
+/**
+   @defgroup taskgroup LV2_TaskGroup
+   @ingroup lv2
+
+   Lets a plugin split the work of a single call to run() across several cores.
+
+   Plugins that are expensive enough to benefit from multiple cores (neural amp models, long
+   convolution reverbs) should not start threads of their own. Plugin threads compete with the
+   host's realtime threads for the same cores, don't know which cores the host has set aside
+   for audio, and can't be scheduled with bounded latency. This feature gives plugins access to
+   a small pool of realtime helper threads that the host owns, pinned to the host's realtime cores.
+
+   The model is fork/join. A plugin calls `run_tasks()` from within `run()` with a task function
+   and a task count. Task indices are handed out to the calling thread and to the host's helper
+   threads on a first-come, first-served basis; `run_tasks()` returns once every task has
+   completed. The calling thread always executes tasks itself, and never waits for a task that a
+   helper thread has not already started; so the worst-case cost of `run_tasks()` is the cost of
+   running all tasks serially, plus the cost of the longest single task. If the helper threads are
+   busy (e.g. with another plugin's task group on another realtime thread), all tasks run serially
+   on the calling thread.
+
+   Tasks should be roughly equal in size, and there should be at least as many tasks as
+   `get_concurrency()` returns. Task functions run on realtime threads, and must observe the same
+   rules as run(): no memory allocation, no locks, no file i/o.
+
+   The host keeps per-plugin statistics on how much work ran on helper threads.
+
+   Declare the feature with lv2:optionalFeature (or lv2:requiredFeature) in the plugin's manifest.
+   The host only provides the feature to plugins that declare it.
+
+   @{
+*/
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void*
+  LV2_TaskGroup_Handle; ///< Opaque handle for the taskGroup:taskGroup feature.
+
+/**
+   A task function.
+
+   @param data The `data` parameter passed to `run_tasks()`.
+   @param taskIndex The index of the task to run, in the range [0,nTasks).
+*/
+typedef void (*LV2_TaskGroup_Task_Function)(void *data, uint32_t taskIndex);
+
+/**
+   Feature data for taskGroup:taskGroup (@ref LV2_TASKGROUP__taskGroup).
+*/
+typedef struct {
+  /**
+     Opaque host data.
+  */
+   LV2_TaskGroup_Handle handle;
+
+  /**
+     The maximum number of threads (including the calling thread) that may execute tasks concurrently.
+
+     @param handle MUST be the `handle` member of this struct.
+
+     @return A value of 1 or more. 1 indicates that all tasks will run serially on the calling thread.
+
+     May be called from any thread. The value does not change over the lifetime of the plugin instance.
+  */
+   uint32_t (*get_concurrency)(LV2_TaskGroup_Handle handle);
+
+  /**
+     Run a group of tasks, and wait for all of them to complete.
+
+     @param handle MUST be the `handle` member of this struct.
+
+     @param task The task function.
+
+     @param data Data passed to the task function.
+
+     @param nTasks The number of tasks to run.
+
+     @return The number of tasks that were executed on host helper threads. Zero if all tasks
+     ran on the calling thread.
+
+     Realtime-safe. Must only be called from within the plugin's run() method. Calls may not be nested: 
+     task functions must not call run_tasks().
+
+     Example:
+     [code]
+         static void processChannel(void *data, uint32_t taskIndex)
+         {
+             MyPlugin *self = (MyPlugin*)data;
+             self->ProcessChannel(taskIndex);
+         }
+
+         void MyPlugin::Run(uint32_t nSamples)
+         {
+             this->nSamples = nSamples;
+             if (taskGroup) 
+             {
+                 taskGroup->run_tasks(taskGroup->handle,processChannel,this,nChannels);
+             } else {
+                 for (uint32_t i = 0; i < nChannels; ++i) 
+                 {
+                     ProcessChannel(i);
+                 }
+             }
+         }
+     [/code]
+  */
+   uint32_t (*run_tasks)(
+      LV2_TaskGroup_Handle handle,
+      LV2_TaskGroup_Task_Function task,
+      void *data,
+      uint32_t nTasks);
+
+} LV2_TaskGroup;
+
+/**
+   @}
+*/
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // PIPEDAL_TASKGROUP_H
@@ -36,16 +36,20 @@
 #include "AdminClient.hpp"
 #include "CommandLineParser.hpp"
 #include "Lv2SystemdLogger.hpp"
+#include "RealtimeLog.hpp"
 #include <sys/stat.h>
 #include <boost/asio.hpp>
 #include "HtmlHelper.hpp"
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <future>
 #include "AlsaDriver.hpp"
 
 #include <signal.h>
 #include <semaphore.h>
 #include "SchedulerPriority.hpp"
+#include "ThreadPool.hpp"
 #include "AudioFiles.hpp"
 
 #include <systemd/sd-daemon.h>
@@ -76,6 +80,31 @@ void throwSystemError(int error)
 {
 }
 
+// Logs the duration of each startup phase, so that boot-time regressions show up in the journal.
+class StartupTimer
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    template <typename FN>
+    void Run(const char *phase, FN &&fn)
+    {
+        clock::time_point phaseStart = clock::now();
+        fn();
+        clock::time_point now = clock::now();
+        Lv2Log::info(SS(
+            "Startup: " << phase << " " << Milliseconds(now - phaseStart) << "ms"
+                        << " (" << Milliseconds(now - startTime) << "ms since start)"));
+    }
+
+private:
+    static int64_t Milliseconds(clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    }
+    clock::time_point startTime = clock::now();
+};
+
 static bool isJackServiceRunning()
 {
     // look for the jack shmem .
@@ -268,11 +297,24 @@ int main(int argc, char *argv[])
         }
     }
 
+    RealtimeLog::Global().Start();
+    StartupTimer startupTimer;
+
     if (portOption.length() != 0)
     {
         configuration.SetSocketServerEndpoint(portOption);
     }
 
+    try
+    {
+        // applied to the main thread by SetThreadPriority below, and inherited by everything it starts.
+        CpuAffinityPlan::Configure(configuration.GetRealtimeCpus());
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("Invalid realtimeCpus setting. " << e.what()));
+    }
+
     // clean up orphaned temporary files.
     const std::filesystem::path webTempDirectory = "/var/pipedal/web_temp";
     if (!webTempDirectory.empty())
@@ -303,6 +345,7 @@ int main(int argc, char *argv[])
         Lv2Log::info("Document root: %s Threads: %d", doc_root.c_str(), (int)threads);
 
         server->SetLogHttpRequests(configuration.LogHttpRequests());
+        server->SetRequestWorkerThreads((int)configuration.GetRequestWorkerThreads());
     }
     catch (const std::exception &e)
     {
@@ -375,10 +418,22 @@ int main(int argc, char *argv[])
                     raise(SIGTERM); // throws an exception under gdb, but correctly restarts the service when running live.
                 });
 
-            model.Init(configuration);
+            startupTimer.Run("storage", [&]()
+                             { model.Init(configuration); });
+
+            // ALSA devices can take a while to appear at boot. Wait for them while the plugins load.
+            auto audioDeviceWait = std::async(
+                std::launch::async,
+                [&]()
+                {
+                    startupTimer.Run("audio device", [&]()
+                                     { model.WaitForAudioDeviceToComeOnline(); });
+                });
 
             // Get heavy IO out of the way before letting dependent (Jack/ALSA) services run.
-            model.LoadLv2PluginInfo();
+            startupTimer.Run("plugins", [&]()
+                             { model.LoadLv2PluginInfo(); });
+            audioDeviceWait.get();
             if (systemd)
             {
                 // Tell systemd we're done.
@@ -387,8 +442,6 @@ int main(int argc, char *argv[])
                            (unsigned long)getpid());
             }
 
-            model.WaitForAudioDeviceToComeOnline();
-
 #if JACK_HOST
             if (systemd)
             {
@@ -423,17 +476,39 @@ int main(int argc, char *argv[])
             }
 #endif
 
-            model.Load();
+            startupTimer.Run("audio", [&]()
+                             { model.Load(); });
 
-            auto pipedalSocketFactory = MakePiPedalSocketFactory(model);
+            startupTimer.Run(
+                "web server",
+                [&]()
+                {
+                    auto pipedalSocketFactory = MakePiPedalSocketFactory(model);
 
-            server->AddSocketFactory(pipedalSocketFactory);
+                    server->AddSocketFactory(pipedalSocketFactory);
 
-            ConfigureWebServer(*server, model, port, configuration.GetMaxUploadSize());
+                    ConfigureWebServer(*server, model, port, configuration.GetMaxUploadSize());
+                    server->RunInBackground(-1);
+                });
             {
-                server->RunInBackground(-1);
-
-                model.StartHotspotMonitoring();
+                // Avahi, hotspot and update checks make D-Bus calls that can stall at boot time. Audio
+                // and the web UI don't depend on them, so start them in the background.
+                std::thread deferredStartup(
+                    [&]()
+                    {
+                        SetThreadName("startup");
+                        try
+                        {
+                            startupTimer.Run("avahi and hotspot", [&]()
+                                             { model.StartHotspotMonitoring(); });
+                            startupTimer.Run("updater", [&]()
+                                             { model.StartUpdater(); });
+                        }
+                        catch (const std::exception &e)
+                        {
+                            Lv2Log::error(SS("Deferred startup failed. " << e.what()));
+                        }
+                    });
 
                 {
                     sigwait(&sigSet, &sig);
@@ -443,6 +518,7 @@ int main(int argc, char *argv[])
                         sd_notify(0, "STOPPING=1");
                     }
                 }
+                deferredStartup.join();
             }
 
             Lv2Log::info("Closing audio session.");
@@ -452,8 +528,11 @@ int main(int argc, char *argv[])
             Lv2Log::info("Stopping web server.");
             server->ShutDown(5000);
             server->Join();
+
+            ThreadPool::Shared().Close();
         }
         Lv2Log::info("Shutdown complete.");
+        RealtimeLog::Global().Stop();
 
         FreeAlsaGlobals();
 
@@ -1,16 +1,22 @@
 #include "PiPedalModel.hpp"
 #include "PiPedalConfiguration.hpp"
 #include "Pedalboard.hpp"
+#include "Lv2Pedalboard.hpp"
 #include "Lv2Log.hpp"
 #include "RingBufferReader.hpp"
 #include "CommandLineParser.hpp"
+#include "CpuTemperatureMonitor.hpp"
+#include "json.hpp"
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include "ss.hpp"
 
 // apt install google-perftools
 #include <gperftools/profiler.h>
-#include "ArmPerformanceCounters.hpp"
+#include "PerfCounterGroup.hpp"
 
 using namespace pipedal;
 using namespace std;
@@ -87,20 +93,25 @@ struct ProfileOptions
     bool noProfile = false;
     bool waitForWork = false;
     size_t frameSize = 64;
+
+    // Matrix mode.
+    std::string plugins;     // comma-separated plugin URIs.
+    std::string sampleRates; // comma-separated.
+    std::string blockSizes;  // comma-separated.
+    std::string controls;    // "name:symbol=value,symbol=value;name2:..."
+    float warmupSeconds = 5;
+    float maxWarmupSeconds = 120;
+    std::string jsonFilename;
+    std::string csvFilename;
+
+    bool IsMatrix() const
+    {
+        return plugins.length() != 0 || sampleRates.length() != 0 || blockSizes.length() != 0 || controls.length() != 0 || jsonFilename.length() != 0 || csvFilename.length() != 0;
+    }
 };
 
-void profilePlugin(const ProfileOptions &profileOptions)
+static void InitModel(PiPedalModel &model)
 {
-
-#ifdef PIPEDAL_AARCH64
-    CacheMissCounter cacheMissCounter;
-#endif
-
-    size_t nFrames = profileOptions.frameSize;
-    Lv2Log::log_level(LogLevel::Info);
-
-    /*** Initialize the model */
-    PiPedalModel model;
     Lv2Log::log_level(LogLevel::Error);
     fs::path doc_root = "/etc/pipedal/config";
     PiPedalConfiguration configuration;
@@ -120,11 +131,10 @@ void profilePlugin(const ProfileOptions &profileOptions)
     model.LoadLv2PluginInfo();
 
     // model.Load(); don't start audio.
+}
 
-    /* *** Load the preset.  */
-
-    bool presetValid = false;
-
+static void LoadProfilePreset(PiPedalModel &model, const ProfileOptions &profileOptions)
+{
     if (profileOptions.presetName.length() != 0)
     {
         PresetIndex presetIndex;
@@ -161,7 +171,7 @@ void profilePlugin(const ProfileOptions &profileOptions)
             reader.read(&bankFile);
             if (bankFile.presets().size() != 1)
             {
-                throw new std::runtime_error(SS("Invalid preset file. Expection one preset, but " << bankFile.presets().size() << " presets were found."));
+                throw std::runtime_error(SS("Invalid preset file. Expecting one preset, but " << bankFile.presets().size() << " presets were found."));
             }
             Pedalboard pedalboard = (bankFile.presets()[0]->preset());
             model.SetPedalboard(-1,pedalboard);
@@ -175,6 +185,22 @@ void profilePlugin(const ProfileOptions &profileOptions)
     {
         throw std::runtime_error("You must specify either a preset name or a preset file.");
     }
+}
+
+void profilePlugin(const ProfileOptions &profileOptions)
+{
+
+    PerfCounterGroup perfCounters;
+
+    size_t nFrames = profileOptions.frameSize;
+    Lv2Log::log_level(LogLevel::Info);
+
+    /*** Initialize the model */
+    PiPedalModel model;
+    InitModel(model);
+
+    /* *** Load the preset.  */
+    LoadProfilePreset(model, profileOptions);
 
     auto pedalboard = model.GetCurrentPedalboardCopy();
     cout << "uri: " << pedalboard.items()[0].uri() << endl;
@@ -226,9 +252,8 @@ void profilePlugin(const ProfileOptions &profileOptions)
     {
         ProfilerStart(profileOptions.outputFilename.c_str());
     }
-#ifdef PIPEDAL_AARCH64
-    cacheMissCounter.start();
-#endif
+    perfCounters.Reset();
+    perfCounters.Enable();
 
     auto startTime = std::chrono::system_clock::now();
 
@@ -240,26 +265,496 @@ void profilePlugin(const ProfileOptions &profileOptions)
 
     auto elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
 
-#ifdef PIPEDAL_AARCH64
-    cacheMissCounter.stop();
-#endif
+    perfCounters.Disable();
     if (!profileOptions.noProfile)
     {
         ProfilerStop();
     }
     std::chrono::milliseconds us = std::chrono::duration_cast<chrono::milliseconds>(elapsedTime);
     std::cout << "Ellapsed time: " << (us.count() / 1000.0) << "s" << endl;
-#ifdef PIPEDAL_AARCH64
-    std::cout << "L1 Cache Misses: " << cacheMissCounter.get_l1_misses() << endl;
-    // non-functional on Raspberry PI OS.
-    // std::cout << "L2 Cache Misses: " << cacheMissCounter.get_l2_misses()  << endl;
-#endif
+    PmuSample counts;
+    if (perfCounters.Read(&counts))
+    {
+        for (size_t i = 0; i < PMU_EVENT_COUNT; ++i)
+        {
+            PmuEvent event = (PmuEvent)i;
+            if (perfCounters.HasEvent(event))
+            {
+                std::cout << PerfCounterGroup::EventName(event) << ": " << counts[event] << endl;
+            }
+        }
+        if (counts[PmuEvent::Cycles] != 0 && perfCounters.HasEvent(PmuEvent::Instructions))
+        {
+            std::cout << "IPC: " << (double)counts[PmuEvent::Instructions] / counts[PmuEvent::Cycles] << endl;
+        }
+    }
+    else
+    {
+        std::cout << "Performance counters not available." << endl;
+    }
 
     ringBufferSink.Close();
 
     lv2Pedalboard->Deactivate();
 }
 
+/* *** Matrix mode: profile every combination of plugin, sample rate, block size and control state. */
+
+struct ControlState
+{
+    std::string name;
+    std::vector<std::pair<std::string, float>> values;
+};
+
+class ProfileResult
+{
+public:
+    std::string plugin_;
+    std::string controlState_;
+    uint32_t sampleRate_ = 0;
+    uint32_t blockSize_ = 0;
+    double warmupSeconds_ = 0;
+    bool steadyState_ = false;
+    uint64_t periods_ = 0;
+    double budgetUs_ = 0;
+    double meanUs_ = 0;
+    double p50Us_ = 0;
+    double p90Us_ = 0;
+    double p99Us_ = 0;
+    double p999Us_ = 0;
+    double maxUs_ = 0;
+    double cpuPercent_ = 0;     // mean / budget.
+    double realtimeFactor_ = 0; // budget / mean.
+    double startTemperatureC_ = CpuTemperatureMonitor::INVALID_TEMPERATURE;
+    double endTemperatureC_ = CpuTemperatureMonitor::INVALID_TEMPERATURE;
+    double ipc_ = 0; // 0 if performance counters are not available.
+
+    DECLARE_JSON_MAP(ProfileResult);
+};
+
+JSON_MAP_BEGIN(ProfileResult)
+JSON_MAP_REFERENCE(ProfileResult, plugin)
+JSON_MAP_REFERENCE(ProfileResult, controlState)
+JSON_MAP_REFERENCE(ProfileResult, sampleRate)
+JSON_MAP_REFERENCE(ProfileResult, blockSize)
+JSON_MAP_REFERENCE(ProfileResult, warmupSeconds)
+JSON_MAP_REFERENCE(ProfileResult, steadyState)
+JSON_MAP_REFERENCE(ProfileResult, periods)
+JSON_MAP_REFERENCE(ProfileResult, budgetUs)
+JSON_MAP_REFERENCE(ProfileResult, meanUs)
+JSON_MAP_REFERENCE(ProfileResult, p50Us)
+JSON_MAP_REFERENCE(ProfileResult, p90Us)
+JSON_MAP_REFERENCE(ProfileResult, p99Us)
+JSON_MAP_REFERENCE(ProfileResult, p999Us)
+JSON_MAP_REFERENCE(ProfileResult, maxUs)
+JSON_MAP_REFERENCE(ProfileResult, cpuPercent)
+JSON_MAP_REFERENCE(ProfileResult, realtimeFactor)
+JSON_MAP_REFERENCE(ProfileResult, startTemperatureC)
+JSON_MAP_REFERENCE(ProfileResult, endTemperatureC)
+JSON_MAP_REFERENCE(ProfileResult, ipc)
+JSON_MAP_END()
+
+static std::vector<std::string> SplitList(const std::string &text, char separator)
+{
+    std::vector<std::string> result;
+    std::stringstream s(text);
+    std::string item;
+    while (std::getline(s, item, separator))
+    {
+        if (item.length() != 0)
+        {
+            result.push_back(item);
+        }
+    }
+    return result;
+}
+
+static std::vector<uint32_t> ParseUIntList(const std::string &text, const char *what, uint32_t minValue, uint32_t maxValue)
+{
+    std::vector<uint32_t> result;
+    for (const auto &item : SplitList(text, ','))
+    {
+        uint32_t value = (uint32_t)std::strtoul(item.c_str(), nullptr, 10);
+        if (value < minValue || value > maxValue)
+        {
+            throw std::runtime_error(SS("Invalid " << what << ": '" << item << "'."));
+        }
+        result.push_back(value);
+    }
+    return result;
+}
+
+// "name:symbol=value,symbol=value;name2:symbol=value"
+static std::vector<ControlState> ParseControlStates(const std::string &text)
+{
+    std::vector<ControlState> result;
+    for (const auto &stateText : SplitList(text, ';'))
+    {
+        ControlState state;
+        std::string valuesText = stateText;
+        size_t colon = stateText.find(':');
+        if (colon != std::string::npos)
+        {
+            state.name = stateText.substr(0, colon);
+            valuesText = stateText.substr(colon + 1);
+        }
+        for (const auto &assignment : SplitList(valuesText, ','))
+        {
+            size_t equals = assignment.find('=');
+            if (equals == std::string::npos || equals == 0)
+            {
+                throw std::runtime_error(SS("Invalid control value: '" << assignment << "'. Expecting symbol=value."));
+            }
+            char *end = nullptr;
+            std::string valueText = assignment.substr(equals + 1);
+            float value = std::strtof(valueText.c_str(), &end);
+            if (end == valueText.c_str() || *end != '\0')
+            {
+                throw std::runtime_error(SS("Invalid control value: '" << assignment << "'."));
+            }
+            state.values.push_back(std::make_pair(assignment.substr(0, equals), value));
+        }
+        if (state.name.length() == 0)
+        {
+            state.name = SS("state" << (result.size() + 1));
+        }
+        result.push_back(std::move(state));
+    }
+    if (result.empty())
+    {
+        result.push_back(ControlState{"default", {}});
+    }
+    return result;
+}
+
+static Pedalboard MakePluginPedalboard(PiPedalModel &model, const std::string &uri)
+{
+    auto pluginInfo = model.GetPluginHost().GetPluginInfo(uri);
+    if (!pluginInfo)
+    {
+        throw std::runtime_error(SS("Plugin not found: " << uri));
+    }
+    Pedalboard pedalboard;
+    pedalboard.name(pluginInfo->name());
+
+    PedalboardItem item = pedalboard.MakeEmptyItem();
+    item.uri(uri);
+    item.pluginName(pluginInfo->name());
+    for (const auto &port : pluginInfo->ports())
+    {
+        if (port->is_control_port() && port->is_input())
+        {
+            item.controlValues().push_back(ControlValue(port->symbol().c_str(), port->default_value()));
+        }
+    }
+    pedalboard.items().push_back(std::move(item));
+    return pedalboard;
+}
+
+static Pedalboard ApplyControlState(const Pedalboard &pedalboard, const ControlState &controlState)
+{
+    Pedalboard result = pedalboard;
+    auto plugins = result.GetAllPlugins();
+    for (const auto &value : controlState.values)
+    {
+        bool found = false;
+        for (PedalboardItem *item : plugins)
+        {
+            if (item->GetControlValue(value.first) != nullptr)
+            {
+                item->SetControlValue(value.first, value.second);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            throw std::runtime_error(SS("Control '" << value.first << "' not found (control state " << controlState.name << ")."));
+        }
+    }
+    return result;
+}
+
+static double PercentileUs(const std::vector<uint64_t> &sortedNs, double percentile)
+{
+    if (sortedNs.empty())
+    {
+        return 0;
+    }
+    size_t index = std::min(sortedNs.size() - 1, (size_t)(sortedNs.size() * percentile));
+    return sortedNs[index] * 0.001;
+}
+
+static float ReadTemperature(CpuTemperatureMonitor *temperatureMonitor)
+{
+    return temperatureMonitor ? temperatureMonitor->GetTemperatureC() : CpuTemperatureMonitor::INVALID_TEMPERATURE;
+}
+
+class MatrixRunner
+{
+public:
+    MatrixRunner(Lv2Pedalboard *lv2Pedalboard, uint32_t blockSize, RealtimeRingBufferWriter *ringBufferWriter)
+        : lv2Pedalboard(lv2Pedalboard), blockSize(blockSize), ringBufferWriter(ringBufferWriter)
+    {
+        // A quiet 220Hz-ish test tone. Silence lets some plugins take denormal or gated fast paths.
+        bufferVector.resize(blockSize * 4);
+        for (uint32_t i = 0; i < blockSize; ++i)
+        {
+            float value = 0.1f * std::sin(i * 0.0288f);
+            bufferVector[i] = value;
+            bufferVector[blockSize + i] = value;
+        }
+        inputBuffers[0] = bufferVector.data();
+        inputBuffers[1] = bufferVector.data() + blockSize;
+        outputBuffers[0] = bufferVector.data() + 2 * blockSize;
+        outputBuffers[1] = bufferVector.data() + 3 * blockSize;
+    }
+    void Run()
+    {
+        lv2Pedalboard->Run(inputBuffers, outputBuffers, blockSize, ringBufferWriter);
+    }
+
+private:
+    Lv2Pedalboard *lv2Pedalboard;
+    uint32_t blockSize;
+    RealtimeRingBufferWriter *ringBufferWriter;
+    std::vector<float> bufferVector;
+    float *inputBuffers[2];
+    float *outputBuffers[2];
+};
+
+// Run one-second chunks until the mean period time of the last three chunks is within 2%,
+// and CPU temperature has stopped climbing. Returns false if maxWarmupSeconds was reached first.
+static bool WarmUp(MatrixRunner &runner, const ProfileOptions &options, CpuTemperatureMonitor *temperatureMonitor, double *pWarmupSeconds)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr size_t STEADY_CHUNKS = 3;
+    constexpr double MAX_MEAN_VARIATION = 0.02;
+    constexpr float MAX_TEMPERATURE_RISE_C = 0.5f;
+
+    std::vector<double> chunkMeans;
+    std::vector<float> chunkTemperatures;
+    auto warmupStart = clock::now();
+    bool steady = false;
+    while (true)
+    {
+        auto chunkStart = clock::now();
+        uint64_t periods = 0;
+        clock::time_point now;
+        do
+        {
+            runner.Run();
+            ++periods;
+            now = clock::now();
+        } while (now - chunkStart < std::chrono::seconds(1));
+
+        chunkMeans.push_back(std::chrono::duration<double>(now - chunkStart).count() / periods);
+        chunkTemperatures.push_back(ReadTemperature(temperatureMonitor));
+
+        double elapsed = std::chrono::duration<double>(now - warmupStart).count();
+        if (elapsed >= options.warmupSeconds && chunkMeans.size() >= STEADY_CHUNKS)
+        {
+            auto first = chunkMeans.end() - STEADY_CHUNKS;
+            double minMean = *std::min_element(first, chunkMeans.end());
+            double maxMean = *std::max_element(first, chunkMeans.end());
+            bool timingSteady = (maxMean - minMean) <= maxMean * MAX_MEAN_VARIATION;
+
+            float t0 = chunkTemperatures[chunkTemperatures.size() - STEADY_CHUNKS];
+            float t1 = chunkTemperatures.back();
+            bool thermalSteady = t0 == CpuTemperatureMonitor::INVALID_TEMPERATURE ||
+                                 t1 == CpuTemperatureMonitor::INVALID_TEMPERATURE ||
+                                 t1 - t0 <= MAX_TEMPERATURE_RISE_C;
+            if (timingSteady && thermalSteady)
+            {
+                steady = true;
+                break;
+            }
+        }
+        if (elapsed >= options.maxWarmupSeconds)
+        {
+            break;
+        }
+    }
+    *pWarmupSeconds = std::chrono::duration<double>(clock::now() - warmupStart).count();
+    return steady;
+}
+
+static ProfileResult ProfileCombination(
+    PiPedalModel &model,
+    const ProfileOptions &options,
+    CpuTemperatureMonitor *temperatureMonitor,
+    uint32_t sampleRate,
+    uint32_t blockSize)
+{
+    using clock = std::chrono::steady_clock;
+
+    ProfileResult result;
+    result.sampleRate_ = sampleRate;
+    result.blockSize_ = blockSize;
+    result.budgetUs_ = blockSize * 1000000.0 / sampleRate;
+
+    auto lv2Pedalboard = model.GetLv2Pedalboard();
+    lv2Pedalboard->Activate();
+
+    WriterRingbuffer writerRingbuffer;
+    RealtimeRingBufferWriter ringBufferWriter(&writerRingbuffer);
+    RingBufferSink ringBufferSink(writerRingbuffer);
+
+    MatrixRunner runner(lv2Pedalboard.get(), blockSize, &ringBufferWriter);
+    runner.Run();
+
+    if (options.waitForWork)
+    {
+        auto waitStart = clock::now();
+        while (clock::now() - waitStart < std::chrono::seconds(3))
+        {
+            runner.Run();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100)); // the scheduler thread runs.
+        }
+    }
+
+    result.steadyState_ = WarmUp(runner, options, temperatureMonitor, &result.warmupSeconds_);
+
+    uint64_t periods = std::max((uint64_t)1, (uint64_t)(options.benchmark_seconds * sampleRate / blockSize));
+    std::vector<uint64_t> periodNs;
+    periodNs.reserve(periods);
+
+    PerfCounterGroup perfCounters;
+    result.startTemperatureC_ = ReadTemperature(temperatureMonitor);
+    perfCounters.Reset();
+    perfCounters.Enable();
+    for (uint64_t i = 0; i < periods; ++i)
+    {
+        auto start = clock::now();
+        runner.Run();
+        periodNs.push_back((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+    perfCounters.Disable();
+    result.endTemperatureC_ = ReadTemperature(temperatureMonitor);
+
+    ringBufferSink.Close();
+    lv2Pedalboard->Deactivate();
+
+    PmuSample counts;
+    if (perfCounters.Read(&counts) && counts[PmuEvent::Cycles] != 0 && perfCounters.HasEvent(PmuEvent::Instructions))
+    {
+        result.ipc_ = (double)counts[PmuEvent::Instructions] / counts[PmuEvent::Cycles];
+    }
+
+    std::sort(periodNs.begin(), periodNs.end());
+    double totalNs = 0;
+    for (uint64_t ns : periodNs)
+    {
+        totalNs += ns;
+    }
+    result.periods_ = periods;
+    result.meanUs_ = totalNs * 0.001 / periodNs.size();
+    result.p50Us_ = PercentileUs(periodNs, 0.5);
+    result.p90Us_ = PercentileUs(periodNs, 0.9);
+    result.p99Us_ = PercentileUs(periodNs, 0.99);
+    result.p999Us_ = PercentileUs(periodNs, 0.999);
+    result.maxUs_ = periodNs.back() * 0.001;
+    result.cpuPercent_ = result.meanUs_ * 100 / result.budgetUs_;
+    result.realtimeFactor_ = result.meanUs_ > 0 ? result.budgetUs_ / result.meanUs_ : 0;
+    return result;
+}
+
+static void WriteCsv(const std::string &filename, const std::vector<ProfileResult> &results)
+{
+    std::ofstream f(filename);
+    if (!f.is_open())
+    {
+        throw std::runtime_error(SS("Can't write to " << filename << "."));
+    }
+    f << "plugin,controlState,sampleRate,blockSize,warmupSeconds,steadyState,periods,budgetUs,meanUs,p50Us,p90Us,p99Us,p999Us,maxUs,cpuPercent,realtimeFactor,startTemperatureC,endTemperatureC,ipc" << endl;
+    for (const auto &r : results)
+    {
+        f << '"' << r.plugin_ << "\",\"" << r.controlState_ << "\"," << r.sampleRate_ << ',' << r.blockSize_ << ','
+          << r.warmupSeconds_ << ',' << (r.steadyState_ ? "true" : "false") << ',' << r.periods_ << ','
+          << r.budgetUs_ << ',' << r.meanUs_ << ',' << r.p50Us_ << ',' << r.p90Us_ << ',' << r.p99Us_ << ','
+          << r.p999Us_ << ',' << r.maxUs_ << ',' << r.cpuPercent_ << ',' << r.realtimeFactor_ << ','
+          << r.startTemperatureC_ << ',' << r.endTemperatureC_ << ',' << r.ipc_ << endl;
+    }
+}
+
+void profileMatrix(const ProfileOptions &options)
+{
+    std::vector<uint32_t> sampleRates = ParseUIntList(options.sampleRates.length() != 0 ? options.sampleRates : "48000", "sample rate", 8000, 384000);
+    std::vector<uint32_t> blockSizes = ParseUIntList(
+        options.blockSizes.length() != 0 ? options.blockSizes : std::to_string(options.frameSize), "block size", 1, 4096);
+    std::vector<ControlState> controlStates = ParseControlStates(options.controls);
+    uint32_t maxBlockSize = *std::max_element(blockSizes.begin(), blockSizes.end());
+
+    PiPedalModel model;
+    InitModel(model);
+
+    // (name, pedalboard) for each plugin, or for the selected preset.
+    std::vector<std::pair<std::string, Pedalboard>> targets;
+    if (options.plugins.length() != 0)
+    {
+        for (const auto &uri : SplitList(options.plugins, ','))
+        {
+            targets.push_back(std::make_pair(uri, MakePluginPedalboard(model, uri)));
+        }
+    }
+    else
+    {
+        LoadProfilePreset(model, options);
+        Pedalboard pedalboard = model.GetCurrentPedalboardCopy();
+        targets.push_back(std::make_pair(pedalboard.name(), pedalboard));
+    }
+
+    CpuTemperatureMonitor::ptr temperatureMonitor = CpuTemperatureMonitor::Get();
+
+    std::vector<ProfileResult> results;
+    cout << std::fixed << std::setprecision(1);
+    cout << setw(8) << "rate" << setw(7) << "block" << setw(10) << "budget" << setw(10) << "mean"
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "p99.9" << setw(10) << "max"
+         << setw(8) << "cpu%" << setw(8) << "warmup" << setw(8) << "temp" << "  " << "control state" << endl;
+    for (const auto &target : targets)
+    {
+        cout << target.first << endl;
+        for (const auto &controlState : controlStates)
+        {
+            Pedalboard pedalboard = ApplyControlState(target.second, controlState);
+            for (uint32_t sampleRate : sampleRates)
+            {
+                for (uint32_t blockSize : blockSizes)
+                {
+                    model.GetPluginHost().SetAudioConfiguration(sampleRate, maxBlockSize, 2, 2);
+                    model.SetPedalboard(-1, pedalboard);
+
+                    ProfileResult result = ProfileCombination(model, options, temperatureMonitor.get(), sampleRate, blockSize);
+                    result.plugin_ = target.first;
+                    result.controlState_ = controlState.name;
+
+                    cout << setw(8) << result.sampleRate_ << setw(7) << result.blockSize_ << setw(10) << result.budgetUs_
+                         << setw(10) << result.meanUs_ << setw(10) << result.p50Us_ << setw(10) << result.p90Us_
+                         << setw(10) << result.p99Us_ << setw(10) << result.p999Us_ << setw(10) << result.maxUs_
+                         << setw(8) << result.cpuPercent_ << setw(7) << result.warmupSeconds_ << (result.steadyState_ ? " " : "*")
+                         << setw(8) << result.endTemperatureC_ << "  " << result.controlState_ << endl;
+                    results.push_back(std::move(result));
+                }
+            }
+        }
+    }
+    cout << "(times in microseconds. *: thermal/timing steady state not reached within --max-warmup.)" << endl;
+
+    if (options.jsonFilename.length() != 0)
+    {
+        std::ofstream f(options.jsonFilename);
+        if (!f.is_open())
+        {
+            throw std::runtime_error(SS("Can't write to " << options.jsonFilename << "."));
+        }
+        json_writer writer(f, false);
+        writer.write(results);
+    }
+    if (options.csvFilename.length() != 0)
+    {
+        WriteCsv(options.csvFilename, results);
+    }
+}
+
 int main(int argc, char **argv)
 {
     try
@@ -273,14 +768,22 @@ int main(int argc, char **argv)
         commandLineParser.AddOption("p", "preset-file", &presetFileName);
         commandLineParser.AddOption("o", "output", &profileOptions.outputFilename);
         commandLineParser.AddOption("s", "seconds", &profileOptions.benchmark_seconds);
+        commandLineParser.AddOption("", "plugins", &profileOptions.plugins);
+        commandLineParser.AddOption("", "rates", &profileOptions.sampleRates);
+        commandLineParser.AddOption("", "blocks", &profileOptions.blockSizes);
+        commandLineParser.AddOption("", "controls", &profileOptions.controls);
+        commandLineParser.AddOption("", "warmup", &profileOptions.warmupSeconds);
+        commandLineParser.AddOption("", "max-warmup", &profileOptions.maxWarmupSeconds);
+        commandLineParser.AddOption("", "json", &profileOptions.jsonFilename);
+        commandLineParser.AddOption("", "csv", &profileOptions.csvFilename);
         commandLineParser.AddOption("h", "help", &help);
 
         commandLineParser.Parse(argc, (const char **)argv);
 
         bool argumentError = false;
-        if (commandLineParser.Arguments().size() == 1 && presetFileName.length() == 0)
+        if (commandLineParser.Arguments().size() == 0 && presetFileName.length() == 0 && profileOptions.plugins.length() == 0)
         {
-            cerr << "Error: You must supply either a preset name, or a preset file name" << endl;
+            cerr << "Error: You must supply a preset name, a preset file name, or --plugins" << endl;
             argumentError = true;
         }
 
@@ -295,6 +798,10 @@ int main(int argc, char **argv)
             cout << "          A google-perf profile capture will be written to " << endl;
             cout << "          /tmp/profilePlugin.perf" << endl;
             cout << endl;
+            cout << "          If any of the matrix options (--plugins, --rates, --blocks, --controls, --json, --csv)" << endl;
+            cout << "          are given, every combination is warmed up to a steady state and timed instead, " << endl;
+            cout << "          and no perf file is written." << endl;
+            cout << endl;
             cout << "Options:" << endl;
             cout << "    --no-profile:" << endl;
             cout << "          do NOT generate a perf file." << endl;
@@ -307,6 +814,22 @@ int main(int argc, char **argv)
             cout << "          Assume that the plugin will load data on the LV2 scheduler thread." << endl;
             cout << "    -s, --seconds time_in_seconds: " << endl;
             cout << "          The number of seconds of audio to process." << endl;
+            cout << "    --plugins uri,uri...:" << endl;
+            cout << "          Profile each plugin (with default control values) instead of a preset." << endl;
+            cout << "    --rates rate,rate...:" << endl;
+            cout << "          Sample rates to profile. Defaults to 48000." << endl;
+            cout << "    --blocks size,size...:" << endl;
+            cout << "          Block sizes to profile. Defaults to 64." << endl;
+            cout << "    --controls \"name:symbol=value,symbol=value;name2:symbol=value...\":" << endl;
+            cout << "          Named control states to profile. Values are applied to every plugin" << endl;
+            cout << "          that has a control with the given symbol." << endl;
+            cout << "    --warmup seconds:" << endl;
+            cout << "          Minimum warm-up time for each run. Defaults to 5." << endl;
+            cout << "    --max-warmup seconds:" << endl;
+            cout << "          Give up waiting for a timing and thermal steady state after this long." << endl;
+            cout << "          Defaults to 120." << endl;
+            cout << "    --json filename, --csv filename:" << endl;
+            cout << "          Write matrix results (mean and percentile period times in microseconds)." << endl;
             cout << "    -h, --help:  display this message." << endl;
             cout << endl;
             return help ? EXIT_SUCCESS : EXIT_FAILURE;
@@ -318,7 +841,14 @@ int main(int argc, char **argv)
         }
         profileOptions.presetFileName = presetFileName;
 
-        profilePlugin(profileOptions);
+        if (profileOptions.IsMatrix())
+        {
+            profileMatrix(profileOptions);
+        }
+        else
+        {
+            profilePlugin(profileOptions);
+        }
     }
     catch (const std::exception &e)
     {
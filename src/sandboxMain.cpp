@@ -0,0 +1,263 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * pipedal_sandbox: hosts a single LV2 plugin on behalf of pipedald (see SandboxedEffect).
+ *
+ * Started by pipedald, with the SandboxChannel shared memory inherited as a file descriptor. Not intended
+ * to be run by hand.
+ *
+ * pipedal_sandbox --vst3-scan <module> describes the effects in one VST3 module as json on stdout, so that
+ * pipedald's VST3 scan survives modules that crash while loading.
+ */
+
+#include "pch.h"
+#include "SandboxChannel.hpp"
+#include "PluginHost.hpp"
+#include "PiPedalConfiguration.hpp"
+#include "Pedalboard.hpp"
+#include "Lv2Effect.hpp"
+#include "Denormals.hpp"
+#include "SchedulerPriority.hpp"
+#include "CommandLineParser.hpp"
+#include "Lv2Log.hpp"
+#include "json.hpp"
+#include "ss.hpp"
+#include <iostream>
+#include <vector>
+#include <sys/prctl.h>
+#include <csignal>
+#include <cerrno>
+#include <unistd.h>
+#ifdef ENABLE_VST3
+#include "vst3/Vst3Host.hpp"
+#endif
+
+using namespace pipedal;
+namespace fs = std::filesystem;
+
+static int RunSandbox(SandboxChannel &channel, pid_t parentPid, const fs::path &configDirectory, const fs::path &pluginStoragePath)
+{
+    auto *header = channel.GetHeader();
+
+    PiPedalConfiguration configuration;
+    configuration.Load(configDirectory, "");
+
+    PedalboardItem item;
+    {
+        std::stringstream s(channel.GetConfig());
+        json_reader reader(s);
+        reader.read(&item);
+    }
+
+    PluginHost pluginHost;
+    pluginHost.SetConfiguration(configuration);
+    pluginHost.SetPluginStoragePath(pluginStoragePath);
+    pluginHost.LoadLilv(configuration.GetLv2Path().c_str());
+    pluginHost.SetAudioConfiguration(
+        header->layout.sampleRate, header->layout.maxFrames,
+        (int)header->hostInputChannels, (int)header->hostOutputChannels);
+
+    auto info = pluginHost.GetPluginInfo(item.uri());
+    if (!info)
+    {
+        throw std::runtime_error(SS("Plugin not found: " << item.uri()));
+    }
+    // (not PluginHost::CreateEffect, which would sandbox the plugin again.)
+    std::unique_ptr<IEffect> effect{new Lv2Effect(&pluginHost, info, item, nullptr)};
+    if (effect->HasErrorMessage())
+    {
+        throw std::runtime_error(effect->TakeErrorMessage());
+    }
+    effect->PrepareNoInputEffect((int)header->noInputChannels, header->layout.maxFrames);
+    if (effect->GetNumberOfInputAudioBuffers() != (int)header->inputs || effect->GetNumberOfOutputAudioBuffers() != (int)header->outputs)
+    {
+        throw std::runtime_error("Audio buffer arrangement doesn't match pipedald's.");
+    }
+    for (uint32_t i = 0; i < header->inputs; ++i)
+    {
+        effect->SetAudioInputBuffer((int)i, channel.InputBuffer(i));
+    }
+    for (uint32_t i = 0; i < header->outputs; ++i)
+    {
+        float *output = channel.OutputBuffer(i);
+        std::fill(output, output + header->layout.maxFrames, 0.0f);
+        effect->SetAudioOutputBuffer((int)i, output);
+    }
+    std::vector<float> silence(header->layout.maxFrames);
+    for (int i = 0; i < effect->GetNumberOfSidechainAudioBuffers(); ++i)
+    {
+        effect->SetAudioSidechainBuffer(i, silence.data());
+    }
+
+    uint32_t controls = header->layout.controls;
+    std::vector<float> lastControlValues(controls);
+    for (uint32_t i = 0; i < controls; ++i)
+    {
+        lastControlValues[i] = effect->GetControlValue((int)i);
+    }
+    bool bypass = effect->GetControlValue(-1) != 0;
+
+    SetThreadPriority(SchedulerPriority::RealtimeAudioHelper);
+    effect->Activate();
+    channel.BeginServing();
+
+    while (true)
+    {
+        uint32_t seq;
+        if (!channel.WaitForRequest(&seq, std::chrono::seconds(1)))
+        {
+            if (getppid() != parentPid)
+            {
+                break;
+            }
+            continue;
+        }
+        Denormals::ApplyPolicy();
+        const float *controlValues = channel.InputControls();
+        for (uint32_t i = 0; i < controls; ++i)
+        {
+            if (controlValues[i] != lastControlValues[i] && effect->IsInputControl(i))
+            {
+                lastControlValues[i] = controlValues[i];
+                effect->SetControl((int)i, controlValues[i]);
+            }
+        }
+        if ((header->bypass != 0) != bypass)
+        {
+            bypass = header->bypass != 0;
+            effect->SetBypass(bypass);
+        }
+        effect->ResetAtomBuffers();
+        effect->Run(header->frames, nullptr);
+
+        float *outputControls = channel.OutputControls();
+        for (uint32_t i = 0; i < controls; ++i)
+        {
+            outputControls[i] = effect->GetOutputControlValue((int)i);
+        }
+        channel.PostResponse(seq);
+    }
+    effect->Deactivate();
+    return EXIT_SUCCESS;
+}
+
+#ifdef ENABLE_VST3
+static int ScanVst3Module(const std::string &modulePath)
+{
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+    // the json result gets the real stdout. Anything the module prints goes to stderr.
+    int resultFd = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    Vst3Host::PluginList plugins = Vst3Host::ScanModule(modulePath);
+
+    std::string result;
+    json_writer writer(result);
+    writer.write(plugins);
+    const char *p = result.c_str();
+    size_t remaining = result.size();
+    while (remaining != 0)
+    {
+        ssize_t nWritten = write(resultFd, p, remaining);
+        if (nWritten < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return EXIT_FAILURE;
+        }
+        p += nWritten;
+        remaining -= (size_t)nWritten;
+    }
+    close(resultFd);
+    return EXIT_SUCCESS;
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    int fd = -1;
+    pid_t parentPid = -1;
+    std::string vst3ScanPath;
+    CommandLineParser parser;
+    parser.AddOption("f", "fd", &fd);
+    parser.AddOption("p", "parent", &parentPid);
+    parser.AddOption("--vst3-scan", &vst3ScanPath);
+    try
+    {
+        parser.Parse(argc, (const char **)argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "pipedal_sandbox: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (vst3ScanPath.length() != 0)
+    {
+#ifdef ENABLE_VST3
+        try
+        {
+            return ScanVst3Module(vst3ScanPath);
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "pipedal_sandbox: " << e.what() << std::endl;
+            return EXIT_FAILURE;
+        }
+#else
+        std::cerr << "pipedal_sandbox: VST3 support is not enabled." << std::endl;
+        return EXIT_FAILURE;
+#endif
+    }
+    if (fd == -1 || parentPid == -1 || parser.Arguments().size() != 2)
+    {
+        std::cerr << "pipedal_sandbox: started by pipedald. Not intended to be run directly." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // die with pipedald.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (getppid() != parentPid)
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::unique_ptr<SandboxChannel> channel;
+    try
+    {
+        channel = SandboxChannel::Attach(fd);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "pipedal_sandbox: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    try
+    {
+        return RunSandbox(*channel, parentPid, parser.Arguments()[0], parser.Arguments()[1]);
+    }
+    catch (const std::exception &e)
+    {
+        Lv2Log::error(SS("pipedal_sandbox: " << e.what()));
+        channel->SetState(SandboxState::Stopped);
+        return EXIT_FAILURE;
+    }
+}
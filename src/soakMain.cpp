@@ -0,0 +1,1162 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+/*
+ * pipedal_soak: a long-running xrun soak test for a live pipedald instance.
+ *
+ * Drives a running server through its websocket API the way an energetic user would (preset loads,
+ * snapshot changes, bypass toggles, control sweeps), optionally with background stress (file
+ * uploads, thumbnail generation, Wi-Fi scans), while the server runs on real audio hardware.
+ *
+ * Xruns are counted from the server's JackHostStatus, and timestamped from the audio period trace,
+ * which also supplies latency spikes (periods whose process time exceeds a percentage of the period).
+ * Server memory use is sampled from /proc when the tool runs on the same machine as pipedald.
+ *
+ * The report gives per-hour xrun, spike and memory growth figures, and lists every xrun with the
+ * activities that overlapped it.
+ */
+
+#include "pch.h"
+#include "CommandLineParser.hpp"
+#include "SocketMessageDispatcher.hpp"
+#include "Banks.hpp"
+#include "Pedalboard.hpp"
+#include "PluginHost.hpp"
+#include "AudioHost.hpp"
+#include "AudioPeriodTrace.hpp"
+#include "HtmlHelper.hpp"
+#include "util.hpp"
+#include "json.hpp"
+#include "ss.hpp"
+#include <websocketpp/config/asio_no_tls_client.hpp>
+#include <websocketpp/client.hpp>
+#include <boost/asio.hpp>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <random>
+#include <algorithm>
+#include <fstream>
+#include <cmath>
+#include <cstdlib>
+#include <csignal>
+#include <unordered_map>
+
+using namespace pipedal;
+using namespace std;
+namespace fs = std::filesystem;
+
+using WebSocketClient = websocketpp::client<websocketpp::config::asio_client>;
+
+struct SoakOptions
+{
+    std::string host = "127.0.0.1";
+    int port = 80;
+    double hours = 8;
+    uint32_t seed = 0;
+    double actionIntervalSeconds = 0.5;
+    double stressIntervalSeconds = 5;
+    std::string stress = "wifi,thumbnail,upload";
+    std::string thumbnailPath;
+    std::string uploadFile;
+    std::string uploadDirectory;
+    double spikePercent = 80;
+    double correlationWindowSeconds = 0.5;
+    int64_t pid = -1;
+    std::string reportFileName = "soak_report.json";
+};
+
+static std::atomic<bool> g_terminate{false};
+
+static void OnSignal(int)
+{
+    g_terminate = true;
+}
+
+/* *** Report */
+
+class SoakHour
+{
+public:
+    int32_t hour_ = 0;
+    uint64_t xruns_ = 0;
+    uint64_t spikes_ = 0;
+    uint64_t actions_ = 0;
+    int64_t rssStartKb_ = -1;
+    int64_t rssEndKb_ = -1;
+    int64_t rssMaxKb_ = -1;
+    int64_t rssGrowthKb_ = 0;
+
+    DECLARE_JSON_MAP(SoakHour);
+};
+JSON_MAP_BEGIN(SoakHour)
+JSON_MAP_REFERENCE(SoakHour, hour)
+JSON_MAP_REFERENCE(SoakHour, xruns)
+JSON_MAP_REFERENCE(SoakHour, spikes)
+JSON_MAP_REFERENCE(SoakHour, actions)
+JSON_MAP_REFERENCE(SoakHour, rssStartKb)
+JSON_MAP_REFERENCE(SoakHour, rssEndKb)
+JSON_MAP_REFERENCE(SoakHour, rssMaxKb)
+JSON_MAP_REFERENCE(SoakHour, rssGrowthKb)
+JSON_MAP_END()
+
+class SoakXrun
+{
+public:
+    double time_ = 0;   // seconds since the start of the soak.
+    std::string kind_;  // "capture", "playback", or "status" (counted by the server, but not in the trace).
+    float processUs_ = 0;
+    std::vector<std::string> activities_;
+
+    DECLARE_JSON_MAP(SoakXrun);
+};
+JSON_MAP_BEGIN(SoakXrun)
+JSON_MAP_REFERENCE(SoakXrun, time)
+JSON_MAP_REFERENCE(SoakXrun, kind)
+JSON_MAP_REFERENCE(SoakXrun, processUs)
+JSON_MAP_REFERENCE(SoakXrun, activities)
+JSON_MAP_END()
+
+class SoakActivityCount
+{
+public:
+    std::string activity_;
+    uint64_t count_ = 0;
+    uint64_t xruns_ = 0; // xruns that overlapped this kind of activity.
+    uint64_t failures_ = 0;
+
+    DECLARE_JSON_MAP(SoakActivityCount);
+};
+JSON_MAP_BEGIN(SoakActivityCount)
+JSON_MAP_REFERENCE(SoakActivityCount, activity)
+JSON_MAP_REFERENCE(SoakActivityCount, count)
+JSON_MAP_REFERENCE(SoakActivityCount, xruns)
+JSON_MAP_REFERENCE(SoakActivityCount, failures)
+JSON_MAP_END()
+
+class SoakReport
+{
+public:
+    std::string host_;
+    uint32_t seed_ = 0;
+    double seconds_ = 0;
+    double periodUs_ = 0;
+    double spikeThresholdUs_ = 0;
+    uint64_t xruns_ = 0;
+    uint64_t spikes_ = 0;
+    int64_t rssStartKb_ = -1;
+    int64_t rssEndKb_ = -1;
+    double rssGrowthKbPerHour_ = 0;
+    std::vector<SoakHour> hours_;
+    std::vector<SoakActivityCount> activities_;
+    std::vector<SoakXrun> xrunDetails_;
+
+    DECLARE_JSON_MAP(SoakReport);
+};
+JSON_MAP_BEGIN(SoakReport)
+JSON_MAP_REFERENCE(SoakReport, host)
+JSON_MAP_REFERENCE(SoakReport, seed)
+JSON_MAP_REFERENCE(SoakReport, seconds)
+JSON_MAP_REFERENCE(SoakReport, periodUs)
+JSON_MAP_REFERENCE(SoakReport, spikeThresholdUs)
+JSON_MAP_REFERENCE(SoakReport, xruns)
+JSON_MAP_REFERENCE(SoakReport, spikes)
+JSON_MAP_REFERENCE(SoakReport, rssStartKb)
+JSON_MAP_REFERENCE(SoakReport, rssEndKb)
+JSON_MAP_REFERENCE(SoakReport, rssGrowthKbPerHour)
+JSON_MAP_REFERENCE(SoakReport, hours)
+JSON_MAP_REFERENCE(SoakReport, activities)
+JSON_MAP_REFERENCE(SoakReport, xrunDetails)
+JSON_MAP_END()
+
+// The same body the server expects for setControl.
+class SoakControlChangedBody
+{
+public:
+    int64_t clientId_ = -1;
+    int64_t instanceId_ = -1;
+    std::string symbol_;
+    float value_ = 0;
+
+    DECLARE_JSON_MAP(SoakControlChangedBody);
+};
+JSON_MAP_BEGIN(SoakControlChangedBody)
+JSON_MAP_REFERENCE(SoakControlChangedBody, clientId)
+JSON_MAP_REFERENCE(SoakControlChangedBody, instanceId)
+JSON_MAP_REFERENCE(SoakControlChangedBody, symbol)
+JSON_MAP_REFERENCE(SoakControlChangedBody, value)
+JSON_MAP_END()
+
+// The same body the server expects for setPedalboardItemEnable.
+class SoakItemEnabledBody
+{
+public:
+    int64_t clientId_ = -1;
+    int64_t instanceId_ = -1;
+    bool enabled_ = true;
+
+    DECLARE_JSON_MAP(SoakItemEnabledBody);
+};
+JSON_MAP_BEGIN(SoakItemEnabledBody)
+JSON_MAP_REFERENCE(SoakItemEnabledBody, clientId)
+JSON_MAP_REFERENCE(SoakItemEnabledBody, instanceId)
+JSON_MAP_REFERENCE(SoakItemEnabledBody, enabled)
+JSON_MAP_END()
+
+/* *** Websocket client */
+
+class SoakClient
+{
+public:
+    SoakClient()
+    {
+        client.clear_access_channels(websocketpp::log::alevel::all);
+        client.clear_error_channels(websocketpp::log::elevel::all);
+        client.init_asio();
+        client.set_message_handler(
+            [this](websocketpp::connection_hdl, WebSocketClient::message_ptr msg)
+            {
+                OnMessage(msg->get_payload());
+            });
+        client.set_close_handler(
+            [this](websocketpp::connection_hdl)
+            {
+                OnClosed();
+            });
+        client.set_fail_handler(
+            [this](websocketpp::connection_hdl)
+            {
+                OnClosed();
+            });
+    }
+    ~SoakClient()
+    {
+        Close();
+    }
+
+    void Connect(const std::string &url)
+    {
+        std::promise<void> opened;
+        auto openedFuture = opened.get_future();
+        client.set_open_handler(
+            [&opened](websocketpp::connection_hdl)
+            {
+                opened.set_value();
+            });
+        websocketpp::lib::error_code ec;
+        auto connection = client.get_connection(url, ec);
+        if (ec)
+        {
+            throw std::runtime_error(SS("Can't connect to " << url << ". " << ec.message()));
+        }
+        hdl = connection->get_handle();
+        client.connect(connection);
+        thread = std::thread([this]()
+                             { client.run(); });
+        if (openedFuture.wait_for(std::chrono::seconds(10)) != std::future_status::ready)
+        {
+            throw std::runtime_error(SS("Timed out connecting to " << url));
+        }
+        clientId = Request<int64_t>("hello");
+    }
+    void Close()
+    {
+        if (thread.joinable())
+        {
+            websocketpp::lib::error_code ec;
+            client.close(hdl, websocketpp::close::status::going_away, "", ec);
+            client.stop();
+            thread.join();
+        }
+    }
+    bool IsClosed() const { return closed; }
+    int64_t ClientId() const { return clientId; }
+
+    template <typename BODY>
+    void Post(const std::string &message, const BODY &body)
+    {
+        Send(FormatMessage(message, -1, ToJson(body)));
+    }
+
+    template <typename RESULT>
+    RESULT Request(const std::string &message)
+    {
+        return Parse<RESULT>(RequestText(message, ""));
+    }
+    template <typename RESULT, typename BODY>
+    RESULT Request(const std::string &message, const BODY &body)
+    {
+        return Parse<RESULT>(RequestText(message, ToJson(body)));
+    }
+
+private:
+    template <typename T>
+    static std::string ToJson(const T &value)
+    {
+        std::string result;
+        json_writer writer(result, true);
+        writer.write(value);
+        return result;
+    }
+    template <typename T>
+    static T Parse(const std::string &text)
+    {
+        json_reader reader(std::string_view(text));
+        int64_t reply = -1, replyTo = -1;
+        std::string message;
+        if (!ReadSocketMessageHeader(reader, &reply, &replyTo, &message))
+        {
+            throw std::runtime_error(SS("Reply '" << message << "' has no body."));
+        }
+        if (message == "error")
+        {
+            std::string error;
+            reader.read(&error);
+            throw std::runtime_error(error);
+        }
+        T result;
+        reader.read(&result);
+        return result;
+    }
+
+    static std::string FormatMessage(const std::string &message, int64_t replyTo, const std::string &body)
+    {
+        std::stringstream s;
+        s << "[{\"message\":" << json_writer::encode_string(message);
+        if (replyTo != -1)
+        {
+            s << ",\"replyTo\":" << replyTo;
+        }
+        s << "}";
+        if (!body.empty())
+        {
+            s << "," << body;
+        }
+        s << "]";
+        return s.str();
+    }
+
+    std::string RequestText(const std::string &message, const std::string &body)
+    {
+        std::future<std::string> future;
+        int64_t replyTo;
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            replyTo = nextReplyTo++;
+            future = pending[replyTo].get_future();
+        }
+        Send(FormatMessage(message, replyTo, body));
+        if (future.wait_for(std::chrono::seconds(60)) != std::future_status::ready)
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending.erase(replyTo);
+            throw std::runtime_error(SS("Timed out waiting for a reply to '" << message << "'."));
+        }
+        return future.get();
+    }
+
+    void Send(const std::string &text)
+    {
+        if (closed)
+        {
+            throw std::runtime_error("Connection closed.");
+        }
+        std::lock_guard<std::mutex> lock(sendMutex);
+        websocketpp::lib::error_code ec;
+        client.send(hdl, text, websocketpp::frame::opcode::text, ec);
+        if (ec)
+        {
+            throw std::runtime_error(SS("Send failed. " << ec.message()));
+        }
+    }
+
+    void OnMessage(const std::string &text)
+    {
+        // notifications (vu updates, monitor values &c) are ignored.
+        try
+        {
+            json_reader reader(std::string_view(text));
+            int64_t reply = -1, replyTo = -1;
+            std::string message;
+            ReadSocketMessageHeader(reader, &reply, &replyTo, &message);
+            if (reply == -1)
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            auto i = pending.find(reply);
+            if (i != pending.end())
+            {
+                i->second.set_value(text);
+                pending.erase(i);
+            }
+        }
+        catch (const std::exception &)
+        {
+        }
+    }
+    void OnClosed()
+    {
+        closed = true;
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        for (auto &i : pending)
+        {
+            i.second.set_exception(std::make_exception_ptr(std::runtime_error("Connection closed.")));
+        }
+        pending.clear();
+    }
+
+    WebSocketClient client;
+    websocketpp::connection_hdl hdl;
+    std::thread thread;
+    std::atomic<bool> closed{false};
+    int64_t clientId = -1;
+    std::mutex sendMutex;
+    std::mutex pendingMutex;
+    int64_t nextReplyTo = 1;
+    std::unordered_map<int64_t, std::promise<std::string>> pending;
+};
+
+/* *** Plain HTTP requests for the stress activities */
+
+// Returns the HTTP status code.
+static int HttpRequest(const std::string &host, int port, const std::string &method, const std::string &target, const std::string &body)
+{
+    using boost::asio::ip::tcp;
+    boost::asio::io_context io;
+    tcp::resolver resolver(io);
+    tcp::socket socket(io);
+    boost::asio::connect(socket, resolver.resolve(host, std::to_string(port)));
+
+    std::string header = SS(
+        method << " " << target << " HTTP/1.0\r\n"
+               << "Host: " << host << "\r\n"
+               << "Content-Type: application/octet-stream\r\n"
+               << "Content-Length: " << body.length() << "\r\n"
+               << "Connection: close\r\n\r\n");
+    boost::asio::write(socket, boost::asio::buffer(header));
+    if (!body.empty())
+    {
+        boost::asio::write(socket, boost::asio::buffer(body));
+    }
+    std::string response;
+    boost::system::error_code ec;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(response), ec);
+    if (ec && ec != boost::asio::error::eof)
+    {
+        throw boost::system::system_error(ec);
+    }
+    // "HTTP/1.1 200 OK"
+    int status = 0;
+    size_t pos = response.find(' ');
+    if (pos != std::string::npos)
+    {
+        status = std::atoi(response.c_str() + pos + 1);
+    }
+    return status;
+}
+
+static std::string Query(const std::string &value)
+{
+    return HtmlHelper::encode_url_segment(value, true);
+}
+
+/* *** Server memory */
+
+static int64_t FindPipedaldPid()
+{
+    std::error_code ec;
+    for (const auto &entry : fs::directory_iterator("/proc", ec))
+    {
+        std::string name = entry.path().filename().string();
+        if (name.empty() || !std::all_of(name.begin(), name.end(), ::isdigit))
+        {
+            continue;
+        }
+        std::ifstream f(entry.path() / "comm");
+        std::string comm;
+        if (std::getline(f, comm) && comm == "pipedald")
+        {
+            return std::stoll(name);
+        }
+    }
+    return -1;
+}
+
+static int64_t ReadRssKb(int64_t pid)
+{
+    if (pid <= 0)
+    {
+        return -1;
+    }
+    std::ifstream f(SS("/proc/" << pid << "/status"));
+    std::string line;
+    while (std::getline(f, line))
+    {
+        if (line.starts_with("VmRSS:"))
+        {
+            return std::atoll(line.c_str() + 6);
+        }
+    }
+    return -1;
+}
+
+/* *** The soak test */
+
+class SoakTest
+{
+public:
+    SoakTest(const SoakOptions &options)
+        : options(options),
+          random(options.seed)
+    {
+    }
+
+    int Run()
+    {
+        std::string url = SS("ws://" << options.host << ":" << options.port << "/pipedal");
+        cout << "Connecting to " << url << endl;
+        actionClient.Connect(url);
+        monitorClient.Connect(url);
+
+        pid = options.pid;
+        if (pid == -1)
+        {
+            pid = FindPipedaldPid();
+        }
+        if (pid == -1)
+        {
+            cout << "pipedald is not running on this machine. Memory use will not be reported." << endl;
+        }
+
+        presets = actionClient.Request<PresetIndex>("getPresets");
+        RefreshPedalboard();
+        for (auto &plugin : actionClient.Request<std::vector<Lv2PluginUiInfo>>("plugins"))
+        {
+            std::vector<Lv2PluginUiPort> controls;
+            for (auto &control : plugin.controls())
+            {
+                if (control.is_input() && !control.not_on_gui() && !control.is_bypass() && control.max_value() > control.min_value())
+                {
+                    controls.push_back(control);
+                }
+            }
+            pluginControls[plugin.uri()] = std::move(controls);
+        }
+
+        JackHostStatus status = monitorClient.Request<JackHostStatus>("getJackStatus");
+        if (!status.active_)
+        {
+            cout << "Warning: audio is not running on the server. " << status.errorMessage_ << endl;
+        }
+        lastUnderruns = status.underruns_;
+
+        startTime = std::chrono::steady_clock::now();
+        endSeconds = options.hours * 3600;
+
+        std::thread monitorThread([this]()
+                                  { MonitorThreadProc(); });
+        std::thread stressThread([this]()
+                                 { StressThreadProc(); });
+
+        cout << "Running for " << options.hours << " hour(s). Seed: " << options.seed << endl;
+        while (!Done())
+        {
+            try
+            {
+                RunAction();
+            }
+            catch (const std::exception &e)
+            {
+                if (actionClient.IsClosed())
+                {
+                    cerr << "Error: lost the connection to the server." << endl;
+                    g_terminate = true;
+                    break;
+                }
+                cerr << "Warning: " << e.what() << endl;
+            }
+            Sleep(options.actionIntervalSeconds);
+        }
+        monitorThread.join();
+        stressThread.join();
+
+        WriteReport();
+        return report.xruns_ == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+private:
+    struct Activity
+    {
+        double start = 0;
+        double end = 0;
+        std::string kind;
+        std::string detail;
+    };
+    struct XrunEvent
+    {
+        double time;
+        std::string kind;
+        float processUs;
+    };
+
+    double Now() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    bool Done() const
+    {
+        return g_terminate || Now() >= endSeconds;
+    }
+    void Sleep(double seconds)
+    {
+        auto until = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (!g_terminate && std::chrono::steady_clock::now() < until)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min(100, (int)(seconds * 1000) + 1)));
+        }
+    }
+
+    SoakHour &Hour(double time)
+    {
+        size_t hour = (size_t)(time / 3600);
+        while (report.hours_.size() <= hour)
+        {
+            SoakHour h;
+            h.hour_ = (int32_t)report.hours_.size();
+            report.hours_.push_back(h);
+        }
+        return report.hours_[hour];
+    }
+
+    void LogActivity(double start, const std::string &kind, const std::string &detail, bool failed = false)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Activity activity{start, Now(), kind, detail};
+        activities.push_back(activity);
+        auto &count = ActivityCount(kind);
+        ++count.count_;
+        if (failed)
+        {
+            ++count.failures_;
+        }
+        ++Hour(start).actions_;
+    }
+    SoakActivityCount &ActivityCount(const std::string &kind)
+    {
+        for (auto &count : report.activities_)
+        {
+            if (count.activity_ == kind)
+            {
+                return count;
+            }
+        }
+        SoakActivityCount count;
+        count.activity_ = kind;
+        report.activities_.push_back(count);
+        return report.activities_.back();
+    }
+
+    /* *** Foreground activities */
+
+    void RefreshPedalboard()
+    {
+        pedalboard = actionClient.Request<Pedalboard>("currentPedalboard");
+    }
+
+    PedalboardItem *RandomPlugin()
+    {
+        auto plugins = pedalboard.GetAllPlugins();
+        if (plugins.empty())
+        {
+            return nullptr;
+        }
+        return plugins[std::uniform_int_distribution<size_t>(0, plugins.size() - 1)(random)];
+    }
+
+    void RunAction()
+    {
+        // weights: preset load 1, snapshot 2, bypass 3, control sweep 4.
+        int action = std::uniform_int_distribution<int>(0, 9)(random);
+        double start = Now();
+        if (action < 1)
+        {
+            if (presets.presets().empty())
+            {
+                return;
+            }
+            auto &preset = presets.presets()[std::uniform_int_distribution<size_t>(0, presets.presets().size() - 1)(random)];
+            actionClient.Post("loadPreset", preset.instanceId());
+            // currentPedalboard is serviced after the load completes, which gives the activity a meaningful end time.
+            RefreshPedalboard();
+            LogActivity(start, "loadPreset", preset.name());
+        }
+        else if (action < 3)
+        {
+            std::vector<int64_t> snapshots;
+            for (size_t i = 0; i < pedalboard.snapshots().size(); ++i)
+            {
+                if (pedalboard.snapshots()[i])
+                {
+                    snapshots.push_back((int64_t)i);
+                }
+            }
+            if (snapshots.empty())
+            {
+                return;
+            }
+            int64_t index = snapshots[std::uniform_int_distribution<size_t>(0, snapshots.size() - 1)(random)];
+            actionClient.Post("setSnapshot", index);
+            RefreshPedalboard();
+            LogActivity(start, "setSnapshot", SS("snapshot " << index));
+        }
+        else if (action < 6)
+        {
+            PedalboardItem *item = RandomPlugin();
+            if (!item)
+            {
+                return;
+            }
+            SoakItemEnabledBody body;
+            body.clientId_ = actionClient.ClientId();
+            body.instanceId_ = item->instanceId();
+            body.enabled_ = !item->isEnabled();
+            item->isEnabled(body.enabled_);
+            actionClient.Post("setPedalboardItemEnable", body);
+            LogActivity(start, "bypass", SS(item->pluginName() << (body.enabled_ ? " on" : " off")));
+        }
+        else
+        {
+            PedalboardItem *item = RandomPlugin();
+            if (!item)
+            {
+                return;
+            }
+            auto &controls = pluginControls[item->uri()];
+            if (controls.empty())
+            {
+                return;
+            }
+            const auto &control = controls[std::uniform_int_distribution<size_t>(0, controls.size() - 1)(random)];
+            const ControlValue *currentValue = item->GetControlValue(control.symbol());
+            float original = currentValue ? currentValue->value() : control.default_value();
+
+            // a one-second sweep from min to max and back, at the rate of a fast-moving UI dial.
+            constexpr int STEPS = 25;
+            SoakControlChangedBody body;
+            body.clientId_ = actionClient.ClientId();
+            body.instanceId_ = item->instanceId();
+            body.symbol_ = control.symbol();
+            for (int i = 0; i <= 2 * STEPS && !g_terminate; ++i)
+            {
+                int step = i <= STEPS ? i : 2 * STEPS - i;
+                body.value_ = control.min_value() + (control.max_value() - control.min_value()) * step / STEPS;
+                actionClient.Post("setControl", body);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            body.value_ = original;
+            actionClient.Post("setControl", body);
+            LogActivity(start, "controlSweep", SS(item->pluginName() << ":" << control.symbol()));
+        }
+    }
+
+    /* *** Background stress */
+
+    void StressThreadProc()
+    {
+        std::vector<std::string> kinds;
+        for (const auto &kind : split(options.stress, ','))
+        {
+            if (kind == "thumbnail" && options.thumbnailPath.empty())
+            {
+                cout << "Thumbnail stress disabled: no --thumbnail-file." << endl;
+            }
+            else if (kind == "upload" && (options.uploadFile.empty() || options.uploadDirectory.empty()))
+            {
+                cout << "Upload stress disabled: requires --upload-file and --upload-directory." << endl;
+            }
+            else if (kind == "wifi" || kind == "thumbnail" || kind == "upload")
+            {
+                kinds.push_back(kind);
+            }
+            else if (!kind.empty())
+            {
+                cerr << "Warning: unknown --stress activity '" << kind << "'." << endl;
+            }
+        }
+        if (kinds.empty())
+        {
+            return;
+        }
+        std::string uploadBody;
+        if (!options.uploadFile.empty())
+        {
+            std::ifstream f(options.uploadFile, std::ios::binary);
+            uploadBody.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        }
+        std::mt19937 stressRandom(options.seed + 1);
+        while (!Done())
+        {
+            const std::string &kind = kinds[std::uniform_int_distribution<size_t>(0, kinds.size() - 1)(stressRandom)];
+            double start = Now();
+            bool failed = false;
+            std::string detail;
+            try
+            {
+                if (kind == "wifi")
+                {
+                    monitorClient.Post("requestWifiScan", true);
+                }
+                else if (kind == "thumbnail")
+                {
+                    // vary the size, so that the server generates a new thumbnail each time.
+                    int size = std::uniform_int_distribution<int>(64, 512)(stressRandom);
+                    detail = SS(size << "x" << size);
+                    int status = HttpRequest(options.host, options.port, "GET",
+                                             SS("/var/Thumbnail?path=" << Query(options.thumbnailPath) << "&w=" << size << "&h=" << size),
+                                             "");
+                    failed = status != 200;
+                }
+                else if (kind == "upload")
+                {
+                    std::string filename = "pipedal_soak" + fs::path(options.uploadFile).extension().string();
+                    detail = SS(uploadBody.length() << " bytes");
+                    int status = HttpRequest(options.host, options.port, "POST",
+                                             SS("/var/uploadUserFile?id=-1&directory=" << Query(options.uploadDirectory)
+                                                                                      << "&filename=" << Query(filename)),
+                                             uploadBody);
+                    failed = status != 200;
+                }
+            }
+            catch (const std::exception &e)
+            {
+                failed = true;
+                detail = e.what();
+            }
+            LogActivity(start, kind, detail, failed);
+            Sleep(options.stressIntervalSeconds);
+        }
+    }
+
+    /* *** Monitoring */
+
+    void MonitorThreadProc()
+    {
+        double lastTraceTime = -1;
+        while (true)
+        {
+            bool done = Done();
+            try
+            {
+                Poll(&lastTraceTime);
+            }
+            catch (const std::exception &e)
+            {
+                cerr << "Warning: " << e.what() << endl;
+            }
+            if (done)
+            {
+                break;
+            }
+            Sleep(1.0);
+        }
+    }
+
+    void Poll(double *lastTraceTime)
+    {
+        auto trace = monitorClient.Request<std::vector<AudioPeriodTraceEntry>>("getAudioPeriodTrace", 2.0);
+        double now = Now(); // entry times are relative to the most recent period, which is (near enough) now.
+        JackHostStatus status = monitorClient.Request<JackHostStatus>("getJackStatus");
+        int64_t rssKb = ReadRssKb(pid);
+
+        if (periodUs == 0 && trace.size() > 16)
+        {
+            std::vector<double> intervals;
+            for (size_t i = 1; i < trace.size(); ++i)
+            {
+                intervals.push_back(trace[i].time_ - trace[i - 1].time_);
+            }
+            std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+            periodUs = intervals[intervals.size() / 2] * 1E6;
+        }
+        double spikeThresholdUs = periodUs * options.spikePercent / 100;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uint64_t tracedXruns = 0;
+        for (const auto &entry : trace)
+        {
+            double time = now + entry.time_;
+            if (time <= *lastTraceTime)
+            {
+                continue;
+            }
+            if (entry.event_ == "r" || entry.event_ == "w")
+            {
+                xruns.push_back(XrunEvent{time, entry.event_ == "r" ? "capture" : "playback", entry.processUs_});
+                ++tracedXruns;
+            }
+            else if (periodUs != 0 && entry.processUs_ > spikeThresholdUs)
+            {
+                ++report.spikes_;
+                ++Hour(time).spikes_;
+            }
+        }
+        if (!trace.empty())
+        {
+            // a little slack for jitter in the mapping of server time onto local time.
+            *lastTraceTime = std::max(*lastTraceTime, now + trace.back().time_ - periodUs * 0.5E-6);
+        }
+
+        // the status count is authoritative. Xruns it reports that weren't in the trace are placed at the poll time.
+        uint64_t underruns = status.underruns_ - std::min(lastUnderruns, status.underruns_);
+        lastUnderruns = status.underruns_;
+        for (uint64_t i = tracedXruns; i < underruns; ++i)
+        {
+            xruns.push_back(XrunEvent{now, "status", 0});
+        }
+        uint64_t newXruns = std::max(underruns, tracedXruns);
+        report.xruns_ += newXruns;
+        SoakHour &hour = Hour(now);
+        hour.xruns_ += newXruns;
+        if (rssKb != -1)
+        {
+            if (hour.rssStartKb_ == -1)
+            {
+                hour.rssStartKb_ = rssKb;
+            }
+            hour.rssEndKb_ = rssKb;
+            hour.rssMaxKb_ = std::max(hour.rssMaxKb_, rssKb);
+            hour.rssGrowthKb_ = hour.rssEndKb_ - hour.rssStartKb_;
+            if (report.rssStartKb_ == -1)
+            {
+                report.rssStartKb_ = rssKb;
+            }
+            report.rssEndKb_ = rssKb;
+        }
+        if (newXruns != 0)
+        {
+            cout << std::fixed << std::setprecision(1) << now << "s: " << newXruns << " xrun(s). Total: " << report.xruns_ << endl;
+        }
+    }
+
+    /* *** Report */
+
+    void WriteReport()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        report.host_ = options.host;
+        report.seed_ = options.seed;
+        report.seconds_ = Now();
+        report.periodUs_ = periodUs;
+        report.spikeThresholdUs_ = periodUs * options.spikePercent / 100;
+        if (report.rssStartKb_ != -1 && report.seconds_ > 0)
+        {
+            report.rssGrowthKbPerHour_ = (report.rssEndKb_ - report.rssStartKb_) * 3600.0 / report.seconds_;
+        }
+
+        for (const auto &xrun : xruns)
+        {
+            SoakXrun detail;
+            detail.time_ = xrun.time;
+            detail.kind_ = xrun.kind;
+            detail.processUs_ = xrun.processUs;
+            std::vector<std::string> overlappingKinds;
+            for (const auto &activity : activities)
+            {
+                if (activity.start <= xrun.time + 0.1 && activity.end >= xrun.time - options.correlationWindowSeconds)
+                {
+                    detail.activities_.push_back(activity.detail.empty() ? activity.kind : activity.kind + " " + activity.detail);
+                    if (std::find(overlappingKinds.begin(), overlappingKinds.end(), activity.kind) == overlappingKinds.end())
+                    {
+                        overlappingKinds.push_back(activity.kind);
+                    }
+                }
+            }
+            for (const auto &kind : overlappingKinds)
+            {
+                ++ActivityCount(kind).xruns_;
+            }
+            report.xrunDetails_.push_back(std::move(detail));
+        }
+
+        {
+            std::ofstream f(options.reportFileName);
+            if (!f)
+            {
+                cerr << "Error: Can't write to " << options.reportFileName << endl;
+            }
+            json_writer writer(f, false);
+            writer.write(report);
+        }
+
+        cout << endl;
+        cout << "Soak test: " << std::fixed << std::setprecision(2) << report.seconds_ / 3600 << " hour(s)" << endl;
+        cout << "   xruns: " << report.xruns_ << "  spikes (> " << std::setprecision(0) << report.spikeThresholdUs_ << "us): " << report.spikes_ << endl;
+        if (report.rssStartKb_ != -1)
+        {
+            cout << "   pipedald RSS: " << report.rssStartKb_ << "KB -> " << report.rssEndKb_ << "KB ("
+                 << std::setprecision(1) << report.rssGrowthKbPerHour_ << "KB/hour)" << endl;
+        }
+        cout << endl;
+        cout << "   hour    xruns   spikes  actions  rss growth (KB)" << endl;
+        for (const auto &hour : report.hours_)
+        {
+            cout << "   " << std::setw(4) << hour.hour_ << " " << std::setw(8) << hour.xruns_ << " " << std::setw(8) << hour.spikes_
+                 << " " << std::setw(8) << hour.actions_ << " " << std::setw(8) << hour.rssGrowthKb_ << endl;
+        }
+        cout << endl;
+        cout << "   activity             count   xruns  failures" << endl;
+        for (const auto &count : report.activities_)
+        {
+            cout << "   " << std::left << std::setw(16) << count.activity_ << std::right << std::setw(9) << count.count_
+                 << std::setw(8) << count.xruns_ << std::setw(10) << count.failures_ << endl;
+        }
+        cout << endl;
+        cout << "Report written to " << options.reportFileName << endl;
+    }
+
+    SoakOptions options;
+    std::mt19937 random;
+    SoakClient actionClient;  // foreground activities.
+    SoakClient monitorClient; // polling, and wifi scans.
+    int64_t pid = -1;
+
+    PresetIndex presets;
+    Pedalboard pedalboard;
+    std::map<std::string, std::vector<Lv2PluginUiPort>> pluginControls;
+
+    std::chrono::steady_clock::time_point startTime;
+    double endSeconds = 0;
+    uint64_t lastUnderruns = 0;
+    double periodUs = 0;
+
+    std::mutex mutex;
+    std::vector<Activity> activities;
+    std::vector<XrunEvent> xruns;
+    SoakReport report;
+};
+
+int main(int argc, char **argv)
+{
+    try
+    {
+        SoakOptions options;
+        options.seed = (uint32_t)std::random_device()();
+        bool help = false;
+        bool noStress = false;
+        CommandLineParser commandLineParser;
+        commandLineParser.AddOption("", "host", &options.host);
+        commandLineParser.AddOption("p", "port", &options.port);
+        commandLineParser.AddOption("", "hours", &options.hours);
+        commandLineParser.AddOption("", "seed", &options.seed);
+        commandLineParser.AddOption("", "interval", &options.actionIntervalSeconds);
+        commandLineParser.AddOption("", "stress", &options.stress);
+        commandLineParser.AddOption("", "no-stress", &noStress);
+        commandLineParser.AddOption("", "stress-interval", &options.stressIntervalSeconds);
+        commandLineParser.AddOption("", "thumbnail-file", &options.thumbnailPath);
+        commandLineParser.AddOption("", "upload-file", &options.uploadFile);
+        commandLineParser.AddOption("", "upload-directory", &options.uploadDirectory);
+        commandLineParser.AddOption("", "spike-percent", &options.spikePercent);
+        commandLineParser.AddOption("", "window", &options.correlationWindowSeconds);
+        commandLineParser.AddOption("", "pid", &options.pid);
+        commandLineParser.AddOption("o", "output", &options.reportFileName);
+        commandLineParser.AddOption("h", "help", &help);
+
+        commandLineParser.Parse(argc, (const char **)argv);
+        if (noStress)
+        {
+            options.stress = "";
+        }
+
+        bool argumentError = false;
+        if (commandLineParser.Arguments().size() != 0)
+        {
+            cerr << "Error: Unexpected argument." << endl;
+            argumentError = true;
+        }
+        if (options.hours <= 0 || options.actionIntervalSeconds <= 0 || options.stressIntervalSeconds <= 0)
+        {
+            cerr << "Error: --hours, --interval and --stress-interval must be greater than zero." << endl;
+            argumentError = true;
+        }
+
+        if (argumentError || help)
+        {
+            cout << "pipedal_soak - Xrun soak test for a running PiPedal server" << endl;
+            cout << "Copyright (c) 2026 Robin E. R. Davies" << endl;
+            cout << endl;
+            cout << "Syntax:  pipedal_soak [options...]" << endl;
+            cout << endl;
+            cout << "          Loads presets, selects snapshots, toggles bypass, and sweeps controls through" << endl;
+            cout << "          the websocket API while pipedald runs on real audio hardware, and reports xruns," << endl;
+            cout << "          latency spikes and pipedald memory growth per hour, along with the activities" << endl;
+            cout << "          that overlapped each xrun. Exits with a non-zero exit code if there were xruns." << endl;
+            cout << endl;
+            cout << "Options:" << endl;
+            cout << "    --host hostname:" << endl;
+            cout << "          The server to test. Defaults to 127.0.0.1" << endl;
+            cout << "    -p, --port port:" << endl;
+            cout << "          The server's web port. Defaults to 80." << endl;
+            cout << "    --hours hours:" << endl;
+            cout << "          How long to run. Defaults to 8." << endl;
+            cout << "    --seed n:" << endl;
+            cout << "          Random seed, to repeat a previous run's sequence of activities." << endl;
+            cout << "    --interval seconds:" << endl;
+            cout << "          Time between foreground activities. Defaults to 0.5." << endl;
+            cout << "    --stress wifi,thumbnail,upload:" << endl;
+            cout << "          Background stress activities. Defaults to all three." << endl;
+            cout << "    --no-stress:" << endl;
+            cout << "          Don't run background stress activities." << endl;
+            cout << "    --stress-interval seconds:" << endl;
+            cout << "          Time between background stress activities. Defaults to 5." << endl;
+            cout << "    --thumbnail-file path:" << endl;
+            cout << "          An audio file on the server with embedded artwork, for thumbnail stress." << endl;
+            cout << "    --upload-file filename:" << endl;
+            cout << "          A local file to upload repeatedly, for upload stress." << endl;
+            cout << "    --upload-directory path:" << endl;
+            cout << "          The upload directory on the server (e.g. /var/pipedal/audio_uploads/shared/audio/Tracks)." << endl;
+            cout << "    --spike-percent percent:" << endl;
+            cout << "          Periods whose process time exceeds this percentage of the period are " << endl;
+            cout << "          counted as latency spikes. Defaults to 80." << endl;
+            cout << "    --window seconds:" << endl;
+            cout << "          Activities that ended up to this long before an xrun are considered to " << endl;
+            cout << "          overlap it. Defaults to 0.5." << endl;
+            cout << "    --pid pid:" << endl;
+            cout << "          The pipedald process id. Found automatically when running on the server." << endl;
+            cout << "    -o, --output filename:" << endl;
+            cout << "          Where to write the JSON report. Defaults to soak_report.json" << endl;
+            return argumentError ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+
+        signal(SIGINT, OnSignal);
+        signal(SIGTERM, OnSignal);
+
+        SoakTest soakTest(options);
+        return soakTest.Run();
+    }
+    catch (const std::exception &e)
+    {
+        cerr << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -25,8 +25,8 @@
 #include "Vst3Effect.hpp"
 #include <vector>
 
-#include "RtInversionGuard.hpp"
 #include "Vst3RtStream.hpp"
+#include "Vst3RtParameterChanges.hpp"
 
 #pragma once
 
@@ -192,7 +192,6 @@ namespace pipedal
 		void SendControlChanges(RealtimeRingBufferWriter *realtimeRingBufferWriter);
 		//--------------------------------------------------------------------
 	private:
-		std::mutex parameterMutex;
 		Buffers buffers;
 		std::vector<ParamID> lv2ToVstParam;
 		std::vector<float> parameterValues;
@@ -213,15 +212,16 @@ namespace pipedal
 		int32 blockSize = 0;
 		HostProcessData processData;
 		ProcessContext processContext;
-		EventList eventList;
-		ParameterChanges inputParameterChanges;
-		ParameterChanges outputParameterChanges;
+		static constexpr size_t kMaxExtraParameters = 128;
+		// preallocated in Load(), so that process() doesn't allocate.
+		RtEventList eventList;
+		RtParameterChanges inputParameterChanges;
+		RtParameterChanges outputParameterChanges;
+		RtParameterChangeTransfer paramTransferrer; // changes made off the audio thread.
 		IComponent *component = nullptr;
 		IEditController *controller = nullptr;
 		FUnknownPtr<IAudioProcessor> processor;
 
-		ParameterChangeTransfer paramTransferrer;
-
 		MidiCCMapping midiCCMapping;
 		// IMediaServerPtr mediaServer;
 		bool isProcessing = false;
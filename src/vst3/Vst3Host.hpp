@@ -54,6 +54,17 @@ namespace Steinberg
         }
     };
 
+    // Scan results for one VST3 module, cached until the module's path, last-write time or size changes.
+    struct Vst3ModuleCacheEntry {
+        std::string path_;
+        int64_t lastWriteTime_ = 0;
+        uint64_t size_ = 0;
+        bool scanFailed_ = false; // (not retried until the module changes.)
+        std::vector<std::unique_ptr<Vst3PluginInfo>> plugins_;
+
+        DECLARE_JSON_MAP(Vst3ModuleCacheEntry);
+    };
+
     class Vst3Host {
     
     public:
@@ -72,6 +83,9 @@ namespace Steinberg
 
         static Ptr CreateInstance(const std::string &cacheFilePath = "");
 
+        // Load one module and describe its effects, in the current process. (pipedal_sandbox --vst3-scan)
+        static PluginList ScanModule(const std::string &modulePath);
+
     public:
          class Private { // private use.
          public:
@@ -0,0 +1,283 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2026 Robin E. R. Davies
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include "pluginterfaces/vst/ivstparameterchanges.h"
+#include "pluginterfaces/vst/ivstevents.h"
+#include <vector>
+#include <cstddef>
+#include "RingBuffer.hpp"
+
+namespace pipedal
+{
+    using namespace Steinberg;
+    using namespace Steinberg::Vst;
+
+    // Fixed-capacity replacements for the VST3 SDK's hosting ParameterChanges, ParamValueQueue and
+    // EventList, which grow (and therefore allocate) on the audio thread. Storage is allocated by
+    // setMaxParameters()/setMaxEvents() when the effect is loaded; once full, further points or
+    // events are dropped.
+    //
+    // Instances are owned by Vst3EffectImpl, so reference counting is a no-op.
+
+    class RtParamValueQueue : public IParamValueQueue
+    {
+    public:
+        static constexpr int32 kMaxPoints = 64;
+
+        void setParameterId(ParamID id)
+        {
+            this->paramId = id;
+            this->pointCount = 0;
+        }
+        void clear() { pointCount = 0; }
+
+        ParamID PLUGIN_API getParameterId() override { return paramId; }
+        int32 PLUGIN_API getPointCount() override { return pointCount; }
+        tresult PLUGIN_API getPoint(int32 index, int32 &sampleOffset, ParamValue &value) override
+        {
+            if (index < 0 || index >= pointCount)
+            {
+                return kResultFalse;
+            }
+            sampleOffset = points[index].sampleOffset;
+            value = points[index].value;
+            return kResultTrue;
+        }
+        tresult PLUGIN_API addPoint(int32 sampleOffset, ParamValue value, int32 &index) override
+        {
+            // points must be in sample-offset order. A point at the same offset replaces the previous one.
+            int32 i = pointCount;
+            while (i > 0 && points[i - 1].sampleOffset > sampleOffset)
+            {
+                --i;
+            }
+            if (i > 0 && points[i - 1].sampleOffset == sampleOffset)
+            {
+                points[i - 1].value = value;
+                index = i - 1;
+                return kResultTrue;
+            }
+            if (pointCount == kMaxPoints)
+            {
+                return kResultFalse;
+            }
+            for (int32 j = pointCount; j > i; --j)
+            {
+                points[j] = points[j - 1];
+            }
+            points[i] = Point{sampleOffset, value};
+            ++pointCount;
+            index = i;
+            return kResultTrue;
+        }
+
+        tresult PLUGIN_API queryInterface(const TUID _iid, void **obj) override
+        {
+            if (FUnknownPrivate::iidEqual(_iid, IParamValueQueue::iid) || FUnknownPrivate::iidEqual(_iid, FUnknown::iid))
+            {
+                *obj = static_cast<IParamValueQueue *>(this);
+                return kResultOk;
+            }
+            *obj = nullptr;
+            return kNoInterface;
+        }
+        uint32 PLUGIN_API addRef() override { return 1000; }
+        uint32 PLUGIN_API release() override { return 1000; }
+
+    private:
+        struct Point
+        {
+            int32 sampleOffset;
+            ParamValue value;
+        };
+        ParamID paramId = kNoParamId;
+        int32 pointCount = 0;
+        Point points[kMaxPoints];
+    };
+
+    class RtParameterChanges : public IParameterChanges
+    {
+    public:
+        // Not realtime-safe.
+        void setMaxParameters(size_t maxParameters)
+        {
+            queues.resize(maxParameters);
+            parameterCount = 0;
+        }
+        void clearQueue()
+        {
+            parameterCount = 0;
+        }
+
+        // Convenience for host code: adds a single point.
+        bool addChange(ParamID id, ParamValue value, int32 sampleOffset)
+        {
+            int32 index;
+            IParamValueQueue *queue = addParameterData(id, index);
+            if (!queue)
+            {
+                return false;
+            }
+            return queue->addPoint(sampleOffset, value, index) == kResultTrue;
+        }
+
+        int32 PLUGIN_API getParameterCount() override { return parameterCount; }
+        IParamValueQueue *PLUGIN_API getParameterData(int32 index) override
+        {
+            if (index < 0 || index >= parameterCount)
+            {
+                return nullptr;
+            }
+            return &queues[index];
+        }
+        IParamValueQueue *PLUGIN_API addParameterData(const ParamID &id, int32 &index) override
+        {
+            for (int32 i = 0; i < parameterCount; ++i)
+            {
+                if (queues[i].getParameterId() == id)
+                {
+                    index = i;
+                    return &queues[i];
+                }
+            }
+            if ((size_t)parameterCount == queues.size())
+            {
+                return nullptr;
+            }
+            index = parameterCount++;
+            RtParamValueQueue &queue = queues[index];
+            queue.setParameterId(id);
+            return &queue;
+        }
+
+        tresult PLUGIN_API queryInterface(const TUID _iid, void **obj) override
+        {
+            if (FUnknownPrivate::iidEqual(_iid, IParameterChanges::iid) || FUnknownPrivate::iidEqual(_iid, FUnknown::iid))
+            {
+                *obj = static_cast<IParameterChanges *>(this);
+                return kResultOk;
+            }
+            *obj = nullptr;
+            return kNoInterface;
+        }
+        uint32 PLUGIN_API addRef() override { return 1000; }
+        uint32 PLUGIN_API release() override { return 1000; }
+
+    private:
+        std::vector<RtParamValueQueue> queues;
+        int32 parameterCount = 0;
+    };
+
+    class RtEventList : public IEventList
+    {
+    public:
+        static constexpr size_t kDefaultMaxEvents = 512;
+
+        RtEventList()
+        {
+            setMaxEvents(kDefaultMaxEvents);
+        }
+        // Not realtime-safe.
+        void setMaxEvents(size_t maxEvents)
+        {
+            events.resize(maxEvents);
+            eventCount = 0;
+        }
+        void clear() { eventCount = 0; }
+
+        int32 PLUGIN_API getEventCount() override { return eventCount; }
+        tresult PLUGIN_API getEvent(int32 index, Event &e) override
+        {
+            if (index < 0 || index >= eventCount)
+            {
+                return kInvalidArgument;
+            }
+            e = events[index];
+            return kResultTrue;
+        }
+        tresult PLUGIN_API addEvent(Event &e) override
+        {
+            if ((size_t)eventCount == events.size())
+            {
+                return kResultFalse;
+            }
+            events[eventCount++] = e;
+            return kResultTrue;
+        }
+
+        tresult PLUGIN_API queryInterface(const TUID _iid, void **obj) override
+        {
+            if (FUnknownPrivate::iidEqual(_iid, IEventList::iid) || FUnknownPrivate::iidEqual(_iid, FUnknown::iid))
+            {
+                *obj = static_cast<IEventList *>(this);
+                return kResultOk;
+            }
+            *obj = nullptr;
+            return kNoInterface;
+        }
+        uint32 PLUGIN_API addRef() override { return 1000; }
+        uint32 PLUGIN_API release() override { return 1000; }
+
+    private:
+        std::vector<Event> events;
+        int32 eventCount = 0;
+    };
+
+    // Passes parameter changes made off the audio thread (e.g. by IComponentHandler::restartComponent)
+    // to the audio thread, without locking. Single writer, single reader.
+    class RtParameterChangeTransfer
+    {
+    public:
+        RtParameterChangeTransfer()
+            : ringBuffer(16 * 1024, false)
+        {
+        }
+        // Non-realtime thread. Returns false if the audio thread has fallen behind.
+        bool addChange(ParamID id, ParamValue value)
+        {
+            Change change{id, value};
+            return ringBuffer.write(sizeof(change), (uint8_t *)&change);
+        }
+        // Audio thread.
+        void transferChangesTo(RtParameterChanges &parameterChanges)
+        {
+            Change change;
+            while (ringBuffer.readSpace() >= sizeof(change))
+            {
+                ringBuffer.read(sizeof(change), (uint8_t *)&change);
+                parameterChanges.addChange(change.id, change.value, 0);
+            }
+        }
+
+    private:
+        struct Change
+        {
+            ParamID id;
+            ParamValue value;
+        };
+        RingBuffer<false, false> ringBuffer;
+    };
+}
@@ -1,14 +1,21 @@
 #!/bin/bash
 npm run build && \
-#remove any existing .gz files.
+#remove any existing precompressed files.
 if ls dist/assets/index*.js.gz 1> /dev/null 2>&1; then
     rm dist/assets/index*.js.gz
 fi
-# generate a .gz file for each index*.js file
+if ls dist/assets/index*.js.br 1> /dev/null 2>&1; then
+    rm dist/assets/index*.js.br
+fi
+# generate .gz and .br files for each index*.js file
 
 if ls dist/assets/index*.js 1> /dev/null 2>&1; then
     for file in dist/assets/index*.js; do
     # generate a .gz file
         gzip -c $file > $file.gz
+    # generate a .br file (served in preference to .gz to browsers that accept it)
+        if command -v brotli > /dev/null 2>&1; then
+            brotli -q 11 -c $file > $file.br
+        fi
     done
 fi
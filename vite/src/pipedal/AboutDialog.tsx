@@ -9,6 +9,7 @@ import Divider from '@mui/material/Divider';
 import ArrowBackIcon from '@mui/icons-material/ArrowBack';
 
 import JackHostStatus from './JackHostStatus';
+import EffectTimingView from './EffectTimingView';
 import { PiPedalError } from './PiPedalError';
 import DialogEx from './DialogEx';
 
@@ -216,6 +217,14 @@ const AboutDialog = class extends Component<AboutDialogProps, AboutDialogState>
                                     {this.model.serverVersion?.osVersion ?? ""}
                                 </Typography>
                             </div>
+
+                            <Divider />
+                            <Typography noWrap display="block" variant="caption"  >
+                                PLUGIN TIMING
+                            </Typography>
+                            <div style={{ marginBottom: 16 }}>
+                                {this.props.open && (<EffectTimingView />)}
+                            </div>
                         </div><div style={{marginLeft: 24, marginRight: 24}}>
 
                             <Divider />
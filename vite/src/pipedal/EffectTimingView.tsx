@@ -0,0 +1,110 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+import React from 'react';
+import Typography from '@mui/material/Typography';
+import { PiPedalModel, PiPedalModelFactory, EffectTimingInfo, EffectTimingSubscriptionHandle } from './PiPedalModel';
+
+
+interface EffectTimingViewProps {
+};
+
+interface EffectTimingViewState {
+    timings: EffectTimingInfo[];
+};
+
+function fmtUs(value: number): string {
+    if (value >= 1000) {
+        return (value / 1000).toFixed(2) + "ms";
+    }
+    return value.toFixed(0) + "µs";
+}
+
+function fmtPmu(timing: EffectTimingInfo): string {
+    if (!timing.pmu || timing.ipc < 0) {
+        return "";
+    }
+    let result = ", IPC " + timing.ipc.toFixed(2);
+    if (timing.l1dMpki >= 0) {
+        result += ", L1D " + timing.l1dMpki.toFixed(1) + "/ki";
+    }
+    if (timing.l2Mpki >= 0) {
+        result += ", L2 " + timing.l2Mpki.toFixed(2) + "/ki";
+    }
+    if (timing.branchMpki >= 0) {
+        result += ", br " + timing.branchMpki.toFixed(1) + "/ki";
+    }
+    return result;
+}
+
+function fmtSubnormals(timing: EffectTimingInfo): string {
+    if (timing.subnormalPercent === undefined || timing.subnormalPercent <= 0) {
+        return "";
+    }
+    return ", subnormals in " + timing.subnormalPercent.toFixed(1) + "% of periods";
+}
+
+// Per-plugin execution times on the audio thread, while mounted.
+export default class EffectTimingView extends React.Component<EffectTimingViewProps, EffectTimingViewState> {
+    model: PiPedalModel;
+    subscriptionHandle?: EffectTimingSubscriptionHandle;
+
+    constructor(props: EffectTimingViewProps) {
+        super(props);
+        this.model = PiPedalModelFactory.getInstance();
+        this.state = {
+            timings: []
+        };
+        this.onTimingsUpdated = this.onTimingsUpdated.bind(this);
+    }
+
+    onTimingsUpdated(timings: EffectTimingInfo[]) {
+        this.setState({ timings: timings });
+    }
+
+    componentDidMount() {
+        this.subscriptionHandle = this.model.addEffectTimingSubscription(this.onTimingsUpdated);
+    }
+    componentWillUnmount() {
+        if (this.subscriptionHandle) {
+            this.model.removeEffectTimingSubscription(this.subscriptionHandle);
+            this.subscriptionHandle = undefined;
+        }
+    }
+
+    render() {
+        let pedalboard = this.model.pedalboard.get();
+        return (
+            <div>
+                {this.state.timings.map((timing) => {
+                    let item = pedalboard.maybeGetItem(timing.instanceId);
+                    if (!item || item.isSplit()) {
+                        return null;
+                    }
+                    let name = item.title !== "" ? item.title : (item.pluginName ?? "");
+                    return (
+                        <Typography key={timing.instanceId} noWrap display="block" variant="body2" style={{ marginBottom: 0, marginLeft: 24 }}>
+                            {name}: {fmtUs(timing.meanUs)} mean, {fmtUs(timing.p99Us)} p99, {fmtUs(timing.maxUs)} max{fmtPmu(timing)}{fmtSubnormals(timing)}
+                        </Typography>
+                    );
+                })}
+            </div>
+        );
+    }
+}
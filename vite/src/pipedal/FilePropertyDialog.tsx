@@ -254,6 +254,7 @@ export default withStyles(
                 openGuitarMlHelp: false
             };
             this.requestScroll = true;
+            this.onAudioFilesChanged = this.onAudioFilesChanged.bind(this);
         }
         getFullScreen() {
             return document.documentElement.clientWidth < 450 || document.documentElement.clientHeight < 450;
@@ -561,13 +562,37 @@ export default withStyles(
 
         private requestScroll: boolean = false;
 
+        private onAudioFilesChanged(directory: string) {
+            if (!this.mounted || !this.props.open || this.state.loading) {
+                return;
+            }
+            if (directory !== this.state.currentDirectory) {
+                return;
+            }
+            // Metadata for tracks in this directory has been updated in the background. Refresh
+            // the list in place, without showing the loading state.
+            let navPath = this.state.navDirectory;
+            this.model.requestFileList2(navPath, this.props.fileProperty)
+                .then((filesResult) => {
+                    if (!this.mounted || navPath !== this.state.navDirectory) {
+                        return;
+                    }
+                    filesResult.files.splice(0, 0, { pathname: "", displayName: "<none>", isDirectory: false, isProtected: true });
+                    this.setState({ fileResult: filesResult });
+                }).catch(() => {
+                    // ignored. The list refreshes the next time the directory is opened.
+                });
+        }
+
         componentDidMount() {
             super.componentDidMount();
             this.mounted = true;
+            this.model.onAudioFilesChanged.addEventHandler(this.onAudioFilesChanged);
             this.requestFiles(this.state.navDirectory)
             this.requestScroll = true;
         }
         componentWillUnmount() {
+            this.model.onAudioFilesChanged.removeEventHandler(this.onAudioFilesChanged);
             this.stopAutoScroll();
             this.cancelProgressTimeout();
 
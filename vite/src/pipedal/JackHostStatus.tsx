@@ -61,6 +61,38 @@ function areSameFrequency(max: number, min: number): boolean {
     // return false;
 }
 
+export interface CacheUsage {
+    name: string;
+    bytes: number;
+    priority: number; // 0: discardable, 1: regenerable, 2: expensive.
+}
+
+export interface PluginMemoryFootprint {
+    instanceId: number;
+    uri: string;
+    instantiateBytes: number;
+    restoreBytes: number; // state restore, where most plugins load models and impulse files.
+    activateBytes: number;
+    exclusive: boolean; // false if other plugins were created at the same time (and the figures include them).
+}
+
+export interface SwitchLatencyStatistics {
+    stage: string; // "midi", "notify", "model", "instantiate", "audio", or "total".
+    switches: number;
+    meanMs: number;
+    p50Ms: number;
+    p99Ms: number;
+    maxMs: number;
+}
+
+export interface XrunRecoveryStatistics {
+    recoveries: number;
+    restarts: number; // recoveries that had to reopen the audio devices.
+    lastUs: number;
+    meanUs: number;
+    maxUs: number;
+}
+
 export default class JackHostStatus {
     deserialize(input: any): JackHostStatus {
         this.active = input.active;
@@ -74,11 +106,53 @@ export default class JackHostStatus {
         this.cpuFreqMin = input.cpuFreqMin;
         this.hasCpuGovernor = input.hasCpuGovernor;
         this.governor = input.governor;
+        this.throttled = input.throttled ?? -1;
+        this.realtimeTripwire = input.realtimeTripwire ?? false;
+        this.realtimeAllocations = input.realtimeAllocations ?? 0;
+        this.realtimeLocks = input.realtimeLocks ?? 0;
+        this.realtimeLockContentions = input.realtimeLockContentions ?? 0;
+        this.realtimeSyscalls = input.realtimeSyscalls ?? 0;
+        this.webSocketQueuedBytes = input.webSocketQueuedBytes ?? 0;
+        this.webSocketStalledDisconnects = input.webSocketStalledDisconnects ?? 0;
+        this.caches = input.caches ?? [];
+        this.pluginMemory = input.pluginMemory ?? [];
+        this.xrunRecovery = input.xrunRecovery;
+        this.switchLatency = input.switchLatency ?? [];
+        this.droppedControlMessages = input.droppedControlMessages ?? 0;
+        this.droppedTelemetryMessages = input.droppedTelemetryMessages ?? 0;
+        this.droppedBulkMessages = input.droppedBulkMessages ?? 0;
+        this.pedalboardSlotUs = input.pedalboardSlotUs ?? [];
+        this.recording = input.recording ?? false;
+        this.recordedFrames = input.recordedFrames ?? 0;
+        this.droppedRecordingFrames = input.droppedRecordingFrames ?? 0;
+        this.monoModeEffects = input.monoModeEffects ?? 0;
+        this.monoModeSavedLoad = input.monoModeSavedLoad ?? 0;
+        let cpuUseStatistics = input.cpuUseStatistics;
+        this.hasHeadroom = !!cpuUseStatistics && cpuUseStatistics.periodUs !== 0
+            && cpuUseStatistics.stages.some((stage: any) => stage.stage === "process" && stage.periods !== 0);
+        this.headroomPercent = cpuUseStatistics?.headroomPercent ?? 100;
         return this;
     }
     hasTemperature(): boolean {
         return this.temperaturemC >= -100000;
     }
+    switchLatencyTotal(): SwitchLatencyStatistics | undefined {
+        let total = this.switchLatency.find((stage) => stage.stage === "total");
+        return total && total.switches !== 0 ? total : undefined;
+    }
+    switchLatencyDescription(): string {
+        return this.switchLatency
+            .filter((stage) => stage.switches !== 0)
+            .map((stage) => stage.stage + ": p50 " + stage.p50Ms.toFixed(1) + " ms, p99 " + stage.p99Ms.toFixed(1) + " ms")
+            .join("\n");
+    }
+    throttledDisplay(): string {
+        // Raspberry Pi firmware get_throttled flags that are currently active.
+        if (this.throttled <= 0) return "";
+        if ((this.throttled & 0x1) !== 0) return "Under-voltage";
+        if ((this.throttled & 0xE) !== 0) return "Throttled";
+        return "";
+    }
     active: boolean = false;
     errorMessage: string = "";
     restarting: boolean = false;
@@ -90,6 +164,29 @@ export default class JackHostStatus {
     cpuFreqMin: number = 0;
     hasCpuGovernor: boolean = false;
     governor: string = "";
+    throttled: number = -1; // firmware throttling flags, or -1 if not available.
+    realtimeTripwire: boolean = false;
+    realtimeAllocations: number = 0;
+    realtimeLocks: number = 0;
+    realtimeLockContentions: number = 0;
+    realtimeSyscalls: number = 0;
+    webSocketQueuedBytes: number = 0; // bytes waiting in websocket send buffers, all clients.
+    webSocketStalledDisconnects: number = 0;
+    caches: CacheUsage[] = []; // memory use of caches that are trimmed under memory pressure.
+    pluginMemory: PluginMemoryFootprint[] = []; // plugins in the current pedalboard.
+    xrunRecovery?: XrunRecoveryStatistics; // time taken to restart audio after xruns.
+    switchLatency: SwitchLatencyStatistics[] = []; // footswitch MIDI message -> first period with the new preset, by stage.
+    droppedControlMessages: number = 0; // audio-thread messages dropped because their ring buffer was full.
+    droppedTelemetryMessages: number = 0;
+    droppedBulkMessages: number = 0;
+    pedalboardSlotUs: number[] = []; // helper-thread run time of each additional pedalboard slot.
+    recording: boolean = false;
+    recordedFrames: number = 0;
+    droppedRecordingFrames: number = 0; // frames lost because the recorder's disk writes fell behind.
+    monoModeEffects: number = 0; // dual-mode plugins running mono.
+    monoModeSavedLoad: number = 0; // estimated load they save, as a fraction of the period.
+    hasHeadroom: boolean = false;
+    headroomPercent: number = 100; // 100 - (p99.9 processing time as a % of the period).
 
     static getCpuInfo(label: string, status?: JackHostStatus): React.ReactNode {
         if (!status) {
@@ -177,10 +274,40 @@ export default class JackHostStatus {
                             CPU:&nbsp;{cpuDisplay(status.cpuUsage)}&nbsp;&nbsp;
                         </Typography>
                     </span>
+                    {status.hasHeadroom && (
+                        <span style={{ color: status.headroomPercent < 15 ? RED_COLOR : GREEN_COLOR }}>
+                            <Typography variant="caption" color="inherit">
+                                Headroom:&nbsp;{cpuDisplay(status.headroomPercent)}&nbsp;&nbsp;
+                            </Typography>
+                        </span>
+                    )}
 
                     <span style={{ color: GREEN_COLOR }}>
                         <Typography variant="caption" color="inherit">{tempDisplay(status.temperaturemC)}</Typography>
                     </span>
+                    {status.switchLatencyTotal() && (
+                        <span style={{ color: GREEN_COLOR }} title={status.switchLatencyDescription()}>
+                            <Typography variant="caption" color="inherit">
+                                &nbsp;&nbsp;Switch:&nbsp;{status.switchLatencyTotal()!.p50Ms.toFixed(0)}&nbsp;ms
+                            </Typography>
+                        </span>
+                    )}
+                    {status.throttledDisplay() !== "" && (
+                        <span style={{ color: RED_COLOR }}>
+                            <Typography variant="caption" color="inherit">&nbsp;&nbsp;{status.throttledDisplay()}</Typography>
+                        </span>
+                    )}
+                    {status.realtimeTripwire && (
+                        <span style={{
+                            color: (status.realtimeAllocations + status.realtimeLocks + status.realtimeSyscalls) !== 0
+                                ? RED_COLOR : GREEN_COLOR
+                        }}>
+                            <Typography variant="caption" color="inherit">
+                                &nbsp;&nbsp;RT&nbsp;alloc/lock/sys:&nbsp;{status.realtimeAllocations}/{status.realtimeLocks}/{status.realtimeSyscalls}
+                                {status.realtimeLockContentions !== 0 && (<>&nbsp;(lock&nbsp;waits:&nbsp;{status.realtimeLockContentions})</>)}
+                            </Typography>
+                        </span>
+                    )}
 
                 </div>
             );
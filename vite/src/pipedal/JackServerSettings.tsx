@@ -30,6 +30,9 @@ export default class JackServerSettings {
         this.sampleRate = input.sampleRate;
         this.bufferSize = input.bufferSize;
         this.numberOfBuffers = input.numberOfBuffers;
+        this.alsaMmap = input.alsaMmap ?? false;
+        this.alsaInputClockMaster = input.alsaInputClockMaster ?? false;
+        this.alsaTimerScheduling = input.alsaTimerScheduling ?? false;
         return this;
     }
     // constructor(alsaDevice: string, sampleRate?: number, bufferSize?: number, numberOfBuffers?: number)
@@ -53,6 +56,9 @@ export default class JackServerSettings {
     sampleRate = 48000;
     bufferSize = 64;
     numberOfBuffers = 3;
+    alsaMmap = false;
+    alsaInputClockMaster = false;
+    alsaTimerScheduling = false;
 
     /**
      * Configure this instance to use the dummy audio device. This mirrors the
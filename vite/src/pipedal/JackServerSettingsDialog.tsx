@@ -532,6 +532,36 @@ const JackServerSettingsDialog = withStyles(
             });
         }
 
+        handleAlsaMmapChanged(checked: boolean) {
+            let settings = this.state.jackServerSettings.clone();
+            settings.alsaMmap = checked;
+            settings.valid = false;
+            this.setState({
+                jackServerSettings: settings,
+                okEnabled: isOkEnabled(settings, this.state.alsaDevices)
+            });
+        }
+
+        handleAlsaTimerSchedulingChanged(checked: boolean) {
+            let settings = this.state.jackServerSettings.clone();
+            settings.alsaTimerScheduling = checked;
+            settings.valid = false;
+            this.setState({
+                jackServerSettings: settings,
+                okEnabled: isOkEnabled(settings, this.state.alsaDevices)
+            });
+        }
+
+        handleAlsaInputClockMasterChanged(checked: boolean) {
+            let settings = this.state.jackServerSettings.clone();
+            settings.alsaInputClockMaster = checked;
+            settings.valid = false;
+            this.setState({
+                jackServerSettings: settings,
+                okEnabled: isOkEnabled(settings, this.state.alsaDevices)
+            });
+        }
+
         applySettings() {
             const settings = this.state.jackServerSettings.clone();
             settings.valid = true;
@@ -756,6 +786,23 @@ const JackServerSettingsDialog = withStyles(
                                     </FormControl>
                                 </div>
                             </div>
+                            <FormControlLabel style={{ marginLeft: 12, marginTop: 8 }}
+                                control={<Checkbox checked={this.state.jackServerSettings.alsaMmap}
+                                    onChange={(e, c) => this.handleAlsaMmapChanged(c)} />}
+                                label={<Typography variant="body2">Zero-copy (mmap) transfers, if supported</Typography>}
+                            />
+                            <FormControlLabel style={{ marginLeft: 12, marginTop: 0 }}
+                                control={<Checkbox checked={this.state.jackServerSettings.alsaTimerScheduling}
+                                    onChange={(e, c) => this.handleAlsaTimerSchedulingChanged(c)} />}
+                                label={<Typography variant="body2">Timer-scheduled wakeups</Typography>}
+                            />
+                            {this.state.jackServerSettings.alsaInputDevice !== this.state.jackServerSettings.alsaOutputDevice && (
+                                <FormControlLabel style={{ marginLeft: 12, marginTop: 0 }}
+                                    control={<Checkbox checked={this.state.jackServerSettings.alsaInputClockMaster}
+                                        onChange={(e, c) => this.handleAlsaInputClockMasterChanged(c)} />}
+                                    label={<Typography variant="body2">Use the input device's clock (the output is resampled)</Typography>}
+                                />
+                            )}
                             <Typography display="block" variant="caption" style={{ textAlign: "left", marginTop: 12, marginLeft: 24 }}
                                 color="textSecondary">
                                 Latency: {this.state.latencyText}
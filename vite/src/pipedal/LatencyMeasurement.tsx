@@ -0,0 +1,71 @@
+// Copyright (c) 2026 Robin E. R. Davies
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+export default class LatencyMeasurement {
+    deserialize(input: any): LatencyMeasurement {
+        this.inputDevice = input.inputDevice;
+        this.outputDevice = input.outputDevice;
+        this.sampleRate = input.sampleRate;
+        this.bufferSize = input.bufferSize;
+        this.numberOfBuffers = input.numberOfBuffers;
+        this.inputChannel = input.inputChannel;
+        this.outputChannel = input.outputChannel;
+        this.signalDetected = input.signalDetected;
+        this.latencyFrames = input.latencyFrames;
+        this.latencyMs = input.latencyMs;
+        this.peakRatio = input.peakRatio;
+        this.signalLevelDb = input.signalLevelDb;
+        this.stressSeconds = input.stressSeconds;
+        this.xruns = input.xruns;
+        this.cpuUsage = input.cpuUsage;
+        this.stable = input.stable;
+        this.time = input.time;
+        this.recommended = input.recommended;
+        return this;
+    }
+    static deserialize_array(input: any[]): LatencyMeasurement[] {
+        let result: LatencyMeasurement[] = [];
+        for (let item of input) {
+            result.push(new LatencyMeasurement().deserialize(item));
+        }
+        return result;
+    }
+
+    inputDevice: string = "";
+    outputDevice: string = "";
+    sampleRate: number = 0;
+    bufferSize: number = 0;
+    numberOfBuffers: number = 0;
+    inputChannel: number = 0;
+    outputChannel: number = 0;
+
+    signalDetected: boolean = false;
+    latencyFrames: number = 0;
+    latencyMs: number = 0;
+    peakRatio: number = 0;
+    signalLevelDb: number = -96;
+
+    stressSeconds: number = 0;
+    xruns: number = 0;
+    cpuUsage: number = 0;
+    stable: boolean = false;
+    time: string = "";
+    recommended: boolean = false; // the lowest-latency stable configuration for the current devices.
+}
@@ -19,7 +19,7 @@
 
 import React, { ReactNode, SyntheticEvent, CSSProperties, Fragment, ReactElement } from 'react';
 
-import { PiPedalModel, PiPedalModelFactory, FavoritesList } from './PiPedalModel';
+import { PiPedalModel, PiPedalModelFactory, FavoritesList, PluginCostEstimate } from './PiPedalModel';
 import { UiPlugin, PluginType } from './Lv2Plugin';
 import TextField from '@mui/material/TextField';
 import ButtonBase from '@mui/material/ButtonBase';
@@ -179,7 +179,8 @@ type PluginGridState = {
     grid_cell_columns: number,
     minimumItemWidth: number,
     favoritesList: FavoritesList,
-    uiPlugins: UiPlugin[]
+    uiPlugins: UiPlugin[],
+    pluginCosts: { [uri: string]: PluginCostEstimate }
     //gridItems: UiPlugin[];
 
 
@@ -215,7 +216,8 @@ export const LoadPluginDialog =
                     grid_cell_columns: this.getCellColumns(document.documentElement.clientWidth),
                     minimumItemWidth: props.minimumItemWidth ? props.minimumItemWidth : 220,
                     favoritesList: this.model.favorites.get(),
-                    uiPlugins: this.model.ui_plugins.get()
+                    uiPlugins: this.model.ui_plugins.get(),
+                    pluginCosts: {}
 
                 };
 
@@ -314,6 +316,31 @@ export const LoadPluginDialog =
                     uiPlugins: this.model.ui_plugins.get()
 
                 });
+                this.model.getPluginCostEstimates()
+                    .then((estimates) => {
+                        if (!this.mounted) return;
+                        let pluginCosts: { [uri: string]: PluginCostEstimate } = {};
+                        for (let estimate of estimates) {
+                            pluginCosts[estimate.uri] = estimate;
+                        }
+                        this.setState({ pluginCosts: pluginCosts });
+                    })
+                    .catch(() => { /* not critical. */ });
+            }
+            cost_indicator(uiPlugin?: UiPlugin): string {
+                if (!uiPlugin) return "";
+                let estimate = this.state.pluginCosts[uiPlugin.uri];
+                if (!estimate) return "";
+                let parts: string[] = [];
+                if (estimate.known) {
+                    let percent = estimate.meanLoad * 100;
+                    parts.push((estimate.exact ? "" : "~") + (percent < 1 ? "<1" : percent.toFixed(0)) + "% CPU");
+                }
+                if (estimate.memoryBytes >= 1024 * 1024) {
+                    parts.push((estimate.memoryBytes / (1024 * 1024)).toFixed(0) + "\u00A0MB");
+                }
+                if (parts.length === 0) return "";
+                return "\u00A0(" + parts.join(", ") + ")";
             }
             componentWillUnmount() {
                 this.cancelSearchTimeout();
@@ -460,7 +487,7 @@ export const LoadPluginDialog =
                 if (!uiPlugin) {
                     return (<Fragment />);
                 } else {
-                    let stereoIndicator = "\u00A0" + this.stereo_indicator(uiPlugin)
+                    let stereoIndicator = "\u00A0" + this.stereo_indicator(uiPlugin) + this.cost_indicator(uiPlugin);
                     if (uiPlugin.author_name !== "") {
                         if (uiPlugin.author_homepage !== "") {
                             return (<Fragment>
@@ -82,6 +82,9 @@ export class PedalboardItem implements Deserializable<PedalboardItem> {
         this.useModUi = input.useModUi ?? false;
         this.iconColor = input.iconColor??"";
         this.sideChainInputId = input.sideChainInputId ?? -1;
+        this.hardBypass = input.hardBypass ?? false;
+        this.essential = input.essential ?? false;
+        this.alwaysRun = input.alwaysRun ?? false;
 
         return this;
     }
@@ -219,6 +222,9 @@ export class PedalboardItem implements Deserializable<PedalboardItem> {
     useModUi: boolean = false; // true if this item should use the mod-ui.
     iconColor: string = "";
     sideChainInputId: number = -1; // -1 means no sidechain input.
+    hardBypass: boolean = false; // true if the plugin should not run at all while bypassed.
+    essential: boolean = false; // true if overload protection should never bypass the plugin.
+    alwaysRun: boolean = false; // true if the plugin should run even while its input and output are silent.
 };
 
 export class SnapshotValue {
@@ -377,6 +383,8 @@ export class Pedalboard implements Deserializable<Pedalboard> {
         this.selectedSnapshot = input.selectedSnapshot;
         this.pathProperties = input.pathProperties;
         this.selectedPlugin = input.selectedPlugin??-1;
+        this.parallelSplits = input.parallelSplits ?? false;
+        this.pipeline = input.pipeline ?? false;
         return this;
     }
 
@@ -393,6 +401,8 @@ export class Pedalboard implements Deserializable<Pedalboard> {
     selectedSnapshot: number = -1;
     pathProperties: {[Name: string]: string} = {};
     selectedPlugin: number = -1;
+    parallelSplits: boolean = false;
+    pipeline: boolean = false; // run the chain as two stages on two cores, with one period of extra latency.
 
     // yields all items in the pedalboard, including split items. Splits are yielded before their children.
     *itemsGenerator(): Generator<PedalboardItem, void, undefined> {
@@ -29,7 +29,7 @@ import ScreenOrientation from './ScreenOrientation';
 import PiPedalSocket, { PiPedalMessageHeader } from './PiPedalSocket';
 import { nullCast } from './Utility'
 import { JackConfiguration, JackChannelSelection } from './Jack';
-import { BankIndex } from './Banks';
+import { BankIndex, BankIndexEntry } from './Banks';
 import JackHostStatus from './JackHostStatus';
 import JackServerSettings from './JackServerSettings';
 import MidiBinding from './MidiBinding';
@@ -37,6 +37,7 @@ import { PluginUiPresets } from './PluginPreset';
 import WifiConfigSettings from './WifiConfigSettings';
 import WifiDirectConfigSettings from './WifiDirectConfigSettings';
 import GovernorSettings from './GovernorSettings';
+import LatencyMeasurement from './LatencyMeasurement';
 import WifiChannel from './WifiChannel';
 import AlsaDeviceInfo from './AlsaDeviceInfo';
 import { AndroidHostInterface, FakeAndroidHost } from './AndroidHost';
@@ -173,10 +174,45 @@ export class FileRequestResult {
     isProtected: boolean = false;
     breadcrumbs: BreadcrumbEntry[] = [];
     currentDirectory: string = "";
+    totalFiles: number = 0;
+    continuationToken: string = ""; // empty on the last page.
+};
+
+export interface PluginSearchRequest {
+    query: string;
+    filterType: PluginType; // PluginType.Plugin matches any type.
+    favoritesOnly: boolean;
+    modGuiOnly: boolean;
+    page: number;
+    pageSize: number;
+};
+
+export class PluginSearchResult {
+    deserialize(input: any): PluginSearchResult {
+        this.totalResults = input.totalResults;
+        this.page = input.page;
+        this.pageSize = input.pageSize;
+        this.plugins = UiPlugin.deserialize_array(input.plugins);
+        return this;
+    }
+    totalResults: number = 0;
+    page: number = 0;
+    pageSize: number = 0;
+    plugins: UiPlugin[] = [];
 };
 
 export type PluginPresetsChangedHandler = (pluginUri: string) => void;
 
+// Result of syncing banks from another PiPedal server.
+export interface BankSyncResult {
+    banksUpdated: number;
+    presetsTransferred: number;
+    presetsUnchanged: number;
+    mediaFilesTransferred: number;
+    mediaFilesLinked: number;
+    bytesTransferred: number;
+}
+
 export interface PluginPresetsChangedHandle {
     _id: number;
     _handler: PluginPresetsChangedHandler;
@@ -210,12 +246,62 @@ export interface VuUpdateInfo {
     sampleTime: number; // in samples.
     isStereoInput: boolean;
     isStereoOutput: boolean;
+    isIdle: boolean; // the effect isn't being run, because its input is silent.
     inputMaxValueL: number;
     inputMaxValueR: number;
     outputMaxValueL: number;
     outputMaxValueR: number;
 };
 
+export interface EffectTimingInfo {
+    instanceId: number;
+    periods: number; // number of times the effect ran during the update interval.
+    minUs: number;
+    meanUs: number;
+    p99Us: number;
+    maxUs: number;
+    // Hardware counters, when PMU profiling is enabled. Rates are -1 if not available.
+    pmu: boolean;
+    cyclesPerPeriod: number;
+    instructionsPerPeriod: number;
+    ipc: number;
+    l1dMpki: number; // misses per 1000 instructions.
+    l2Mpki: number;
+    branchMpki: number;
+    stalledCyclesPercent: number;
+    // Percentage of periods with subnormal output, when denormal detection is enabled; otherwise -1.
+    subnormalPercent: number;
+};
+
+export type EffectTimingHandler = (timings: EffectTimingInfo[]) => void;
+
+export interface PluginCostEstimate {
+    uri: string;
+    known: boolean;
+    exact: boolean; // measured at the current sample rate and buffer size (rather than scaled).
+    meanLoad: number; // fraction of the audio period.
+    p99Load: number;
+    memoryBytes: number; // memory used by an instance. 0 if unknown.
+};
+
+export interface PresetLoadEstimate {
+    meanLoad: number;
+    p99Load: number;
+    memoryBytes: number;
+    unknownPlugins: string[]; // plugins that haven't been measured yet.
+};
+
+export interface EffectTimingSubscriptionHandle {
+
+};
+
+class EffectTimingSubscriptionHandleImpl implements EffectTimingSubscriptionHandle {
+    constructor(callback: EffectTimingHandler) {
+        this.callback = callback;
+    }
+    callback: EffectTimingHandler;
+};
+
 export interface MonitorPortHandle {
 };
 export interface ControlValueChangedHandle {
@@ -442,8 +528,72 @@ interface RenamePresetBody {
 
 interface PresetsChangedBody {
     clientId: number,
+    version: number,
     presets: PresetIndex
 }
+interface BanksChangedBody {
+    version: number,
+    banks: BankIndex
+}
+interface IndexPatchEntry {
+    instanceId: number;
+    name: string;
+    position: number;
+}
+interface IndexPatchBody {
+    clientId: number;
+    baseVersion: number;
+    version: number;
+    selectedInstanceId: number;
+    presetChanged: boolean;
+    removed: number[];
+    added: IndexPatchEntry[]; // inserted at their positions, after removals.
+    renamed: IndexPatchEntry[];
+    order: number[]; // instanceIds of all entries, if entries have moved.
+}
+
+// Returns null if the patch doesn't fit the entries.
+function applyIndexPatch<T extends { instanceId: number, name: string }>(
+    entries: T[], patch: IndexPatchBody, makeEntry: (instanceId: number, name: string) => T): T[] | null {
+    let removed = new Set<number>(patch.removed);
+    let result = entries.filter((entry) => !removed.has(entry.instanceId));
+    if (result.length + removed.size !== entries.length) {
+        return null;
+    }
+    for (let added of patch.added) {
+        if (added.position < 0 || added.position > result.length) {
+            return null;
+        }
+        result.splice(added.position, 0, makeEntry(added.instanceId, added.name));
+    }
+    let byId = new Map<number, T>();
+    for (let entry of result) {
+        byId.set(entry.instanceId, entry);
+    }
+    for (let renamed of patch.renamed) {
+        let entry = byId.get(renamed.instanceId);
+        if (!entry) {
+            return null;
+        }
+        entry.name = renamed.name;
+    }
+    if (patch.order.length !== 0) {
+        if (patch.order.length !== result.length) {
+            return null;
+        }
+        let ordered: T[] = [];
+        for (let instanceId of patch.order) {
+            let entry = byId.get(instanceId);
+            if (!entry) {
+                return null;
+            }
+            byId.delete(instanceId);
+            ordered.push(entry);
+        }
+        result = ordered;
+    }
+    return result;
+}
 interface PedalboardItemEnableBody {
     clientId: number,
     instanceId: number,
@@ -452,6 +602,22 @@ interface PedalboardItemEnableBody {
 interface PedalboardChangedBody {
     clientId: number;
     pedalboard: Pedalboard;
+    version?: number;
+}
+// An incremental pedalboard update. Applies only to a copy of the pedalboard at baseVersion.
+interface PedalboardPatchBody {
+    clientId: number;
+    baseVersion: number;
+    version: number;
+    name: string;
+    input_volume_db: number;
+    output_volume_db: number;
+    nextInstanceId: number;
+    selectedSnapshot: number;
+    selectedPlugin: number;
+    parallelSplits: boolean;
+    pipeline: boolean;
+    items: any[]; // non-split items whose settings changed, keyed by instanceId.
 }
 interface ControlChangedBody {
     clientId: number;
@@ -459,6 +625,27 @@ interface ControlChangedBody {
     symbol: string;
     value: number;
 };
+interface ControlHandle {
+    instanceId: number;
+    symbol: string;
+    handle: number;
+};
+interface ControlHandlesBody {
+    version: number;
+    handles: ControlHandle[];
+};
+interface ControlHandleValueBody {
+    clientId: number;
+    version: number;
+    handle: number;
+    value: number;
+};
+interface HelloReply {
+    clientId: number;
+    sessionToken: string;
+    sequence: number;
+    resumed: boolean;
+};
 interface Vst3ControlChangedBody {
     clientId: number;
     instanceId: number;
@@ -477,9 +664,17 @@ export interface SnapshotModifiedEvent {
 };
 
 
+export interface PresetBundleProgress {
+    operation: string; // "export" or "import"
+    bytesProcessed: number;
+    bytesTotal: number;
+}
+
 export class PiPedalModel //implements PiPedalModel 
 {
     clientId: number = -1;
+    // Identifies the server-side session, so that it can be resumed after a dropped connection.
+    private sessionToken: string = "";
 
     serverVersion?: PiPedalVersion;
     countryCodes: { [Name: string]: string } = {};
@@ -504,6 +699,10 @@ export class PiPedalModel //implements PiPedalModel
 
     hasWifiDevice: ObservableProperty<boolean> = new ObservableProperty<boolean>(false);
     onSnapshotModified: ObservableEvent<SnapshotModifiedEvent> = new ObservableEvent<SnapshotModifiedEvent>();
+    // Fired with the (absolute) directory path when background metadata scans for a directory complete.
+    onAudioFilesChanged: ObservableEvent<string> = new ObservableEvent<string>();
+    // Fired while preset bundles (and their media files) are being exported or imported.
+    onPresetBundleProgress: ObservableEvent<PresetBundleProgress> = new ObservableEvent<PresetBundleProgress>();
 
     ui_plugins: ObservableProperty<UiPlugin[]>
         = new ObservableProperty<UiPlugin[]>([]);
@@ -570,6 +769,7 @@ export class PiPedalModel //implements PiPedalModel
 
         this.onSocketError = this.onSocketError.bind(this);
         this.onSocketMessage = this.onSocketMessage.bind(this);
+        this.onSocketBinaryMessage = this.onSocketBinaryMessage.bind(this);
         this.onSocketReconnecting = this.onSocketReconnecting.bind(this);
         this.onSocketReconnected = this.onSocketReconnected.bind(this);
         this.onVisibilityChanged = this.onVisibilityChanged.bind(this);
@@ -658,30 +858,287 @@ export class PiPedalModel //implements PiPedalModel
         }
     }
 
+    private pedalboardVersion: number = -1;
+    private pedalboardResyncPending: boolean = false;
+
+    private setPedalboardVersion(version: number) {
+        if (version !== this.pedalboardVersion) {
+            this.pedalboardVersion = version;
+            this.refreshControlHandles();
+        }
+    }
+
+    // Numeric handles for setControl/previewControl, keyed by `${instanceId}:${symbol}`.
+    private controlHandles: Map<string, number> = new Map<string, number>();
+    private controlHandlesVersion: number = -1;
+    private controlHandlesRequestPending: boolean = false;
+    private controlHandlesRefreshNeeded: boolean = false;
+
+    private refreshControlHandles() {
+        if (this.controlHandlesRequestPending) {
+            this.controlHandlesRefreshNeeded = true;
+            return;
+        }
+        this.controlHandlesRequestPending = true;
+        this.controlHandlesRefreshNeeded = false;
+        this.getWebSocket().request<ControlHandlesBody>("getControlHandles")
+            .then((body) => {
+                let handles = new Map<string, number>();
+                for (let handle of body.handles) {
+                    handles.set(handle.instanceId + ":" + handle.symbol, handle.handle);
+                }
+                this.controlHandles = handles;
+                this.controlHandlesVersion = body.version;
+            })
+            .catch(() => {
+                // fall back to setControl messages with symbols.
+                this.controlHandles = new Map<string, number>();
+            })
+            .finally(() => {
+                this.controlHandlesRequestPending = false;
+                if (this.controlHandlesRefreshNeeded) {
+                    this.refreshControlHandles();
+                }
+            });
+    }
+
+    private applyPedalboardPatch(patch: PedalboardPatchBody) {
+        if (patch.baseVersion !== this.pedalboardVersion) {
+            this.resyncPedalboard();
+            return;
+        }
+        let pedalboard = this.pedalboard.get().clone();
+        try {
+            for (let item of patch.items) {
+                pedalboard.replaceItem(item.instanceId, new PedalboardItem().deserialize(item));
+            }
+        } catch (e) {
+            this.resyncPedalboard();
+            return;
+        }
+        pedalboard.name = patch.name;
+        pedalboard.input_volume_db = patch.input_volume_db;
+        pedalboard.output_volume_db = patch.output_volume_db;
+        pedalboard.nextInstanceId = patch.nextInstanceId;
+        pedalboard.selectedSnapshot = patch.selectedSnapshot;
+        pedalboard.selectedPlugin = patch.selectedPlugin;
+        pedalboard.parallelSplits = patch.parallelSplits;
+        pedalboard.pipeline = patch.pipeline;
+        this.setPedalboardVersion(patch.version);
+        this.setModelPedalboard(pedalboard);
+    }
+
+    // Our copy of the pedalboard has diverged from the server's. Fetch the whole thing.
+    private resyncPedalboard() {
+        if (this.pedalboardResyncPending) {
+            return; // patches that arrive in the meantime are superseded by the reply.
+        }
+        this.pedalboardResyncPending = true;
+        this.getWebSocket().request<PedalboardChangedBody>("currentPedalboardVersioned")
+            .then((body) => {
+                this.pedalboardResyncPending = false;
+                this.setPedalboardVersion(body.version ?? -1);
+                this.setModelPedalboard(new Pedalboard().deserialize(body.pedalboard));
+            })
+            .catch((error) => {
+                this.pedalboardResyncPending = false;
+                this.showAlert(error);
+            });
+    }
+
+    private presetsVersion: number = -1;
+    private presetsResyncPending: boolean = false;
+
+    private applyPresetsPatch(patch: IndexPatchBody) {
+        if (patch.baseVersion !== this.presetsVersion) {
+            this.resyncPresets();
+            return;
+        }
+        let presets = this.presets.get().clone();
+        let entries = applyIndexPatch(presets.presets, patch,
+            (instanceId, name) => new PresetIndexEntry().deserialize({ instanceId: instanceId, name: name }));
+        if (entries === null) {
+            this.resyncPresets();
+            return;
+        }
+        presets.presets = entries;
+        presets.selectedInstanceId = patch.selectedInstanceId;
+        presets.presetChanged = patch.presetChanged;
+        this.presetsVersion = patch.version;
+        this.presets.set(presets);
+        this.presetChanged.set(presets.presetChanged);
+    }
+
+    private resyncPresets() {
+        if (this.presetsResyncPending) {
+            return; // patches that arrive in the meantime are superseded by the reply.
+        }
+        this.presetsResyncPending = true;
+        this.getWebSocket().request<PresetsChangedBody>("getPresetsVersioned")
+            .then((body) => {
+                this.presetsResyncPending = false;
+                this.setModelPresets(body);
+            })
+            .catch((error) => {
+                this.presetsResyncPending = false;
+                this.showAlert(error);
+            });
+    }
+
+    private setModelPresets(body: PresetsChangedBody) {
+        let presets = new PresetIndex().deserialize(body.presets);
+        this.presetsVersion = body.version;
+        this.presets.set(presets);
+        this.presetChanged.set(presets.presetChanged);
+    }
+
+    private banksVersion: number = -1;
+    private banksResyncPending: boolean = false;
+
+    private applyBanksPatch(patch: IndexPatchBody) {
+        if (patch.baseVersion !== this.banksVersion) {
+            this.resyncBanks();
+            return;
+        }
+        let banks = this.banks.get().clone();
+        let entries = applyIndexPatch(banks.entries, patch,
+            (instanceId, name) => new BankIndexEntry().deserialize({ instanceId: instanceId, name: name }));
+        if (entries === null) {
+            this.resyncBanks();
+            return;
+        }
+        banks.entries = entries;
+        banks.selectedBank = patch.selectedInstanceId;
+        this.banksVersion = patch.version;
+        this.banks.set(banks);
+    }
+
+    private resyncBanks() {
+        if (this.banksResyncPending) {
+            return;
+        }
+        this.banksResyncPending = true;
+        this.getWebSocket().request<BanksChangedBody>("getBankIndexVersioned")
+            .then((body) => {
+                this.banksResyncPending = false;
+                this.setModelBanks(body);
+            })
+            .catch((error) => {
+                this.banksResyncPending = false;
+                this.showAlert(error);
+            });
+    }
+
+    private setModelBanks(body: BanksChangedBody) {
+        this.banksVersion = body.version;
+        this.banks.set(new BankIndex().deserialize(body.banks));
+    }
+
     private setModelPedalboard(pedalboard: Pedalboard) {
         this.removeInvalidSidechains(pedalboard);
         this.pedalboard.set(pedalboard);
         this.selectedSnapshot.set(pedalboard.selectedSnapshot);
         this.updateEnabledItems(pedalboard);
     }
+    private async enableBinaryTelemetry(): Promise<void> {
+        try {
+            await this.getWebSocket().request<boolean>("enableBinaryTelemetry", true);
+        } catch (ignored) {
+            // older server. VU and monitor port updates stay JSON.
+        }
+        await this.sendTelemetryRate(true);
+    }
+
+    // VU frame rate wanted by this client. The server stops sending VUs to hidden clients.
+    vuUpdatesPerSecond: number = 30;
+
+    private async sendTelemetryRate(visible: boolean): Promise<void> {
+        try {
+            await this.webSocket?.request<void>("setTelemetryRate", {
+                visible: visible,
+                vuUpdatesPerSecond: this.vuUpdatesPerSecond
+            });
+        } catch (ignored) {
+            // older server.
+        }
+    }
+
+    // Binary telemetry frames. See BinaryTelemetry.hpp on the server for the layout.
+    private onSocketBinaryMessage(data: ArrayBuffer) {
+        const VU_UPDATE_FRAME = 1;
+        const MONITOR_PORT_OUTPUT_FRAME = 2;
+
+        let view = new DataView(data);
+        if (view.byteLength < 8) {
+            return;
+        }
+        let frameType = view.getUint32(0, true);
+        let count = view.getUint32(4, true);
+
+        if (frameType === VU_UPDATE_FRAME) {
+            for (let i = 0; i < count; ++i) {
+                let offset = 8 + i * 32;
+                let flags = view.getUint32(offset + 12, true);
+                let vuUpdate: VuUpdateInfo = {
+                    instanceId: Number(view.getBigInt64(offset, true)),
+                    sampleTime: view.getInt32(offset + 8, true),
+                    isStereoInput: (flags & 1) !== 0,
+                    isStereoOutput: (flags & 2) !== 0,
+                    isIdle: (flags & 4) !== 0,
+                    inputMaxValueL: view.getFloat32(offset + 16, true),
+                    inputMaxValueR: view.getFloat32(offset + 20, true),
+                    outputMaxValueL: view.getFloat32(offset + 24, true),
+                    outputMaxValueR: view.getFloat32(offset + 28, true)
+                };
+                let item = this.vuSubscriptions[vuUpdate.instanceId];
+                if (item) {
+                    for (let j = 0; j < item.subscribers.length; ++j) {
+                        item.subscribers[j].callback(vuUpdate);
+                    }
+                }
+            }
+            this.webSocket?.send("ackVuUpdate");
+        } else if (frameType === MONITOR_PORT_OUTPUT_FRAME) {
+            for (let i = 0; i < count; ++i) {
+                let offset = 8 + i * 16;
+                let subscriptionHandle = Number(view.getBigInt64(offset, true));
+                let value = view.getFloat32(offset + 8, true);
+                for (let subscription of this.monitorPortSubscriptions) {
+                    if (subscription.subscriptionHandle === subscriptionHandle) {
+                        subscription.onUpdated(value);
+                        break;
+                    }
+                }
+                this.webSocket?.send("ackMonitorPortOutput", subscriptionHandle);
+            }
+        }
+    }
+
+    private handleControlChanged(controlChangedBody: ControlChangedBody) {
+        if (controlChangedBody.clientId !== this.clientId) {
+            this.lastControlMessageWasSentbyMe = false;
+        }
+        if (this.lastControlMessageWasSentbyMe) {
+            return; // shortcut!
+        }
+
+        this._setPedalboardControlValue(
+            controlChangedBody.instanceId,
+            controlChangedBody.symbol,
+            controlChangedBody.value,
+            false // do NOT notify the server of the change.
+        );
+    }
     onSocketMessage(header: PiPedalMessageHeader, body?: any) {
 
         let message = header.message;
         if (message === "onControlChanged") {
-            let controlChangedBody = body as ControlChangedBody;
-            if (body.clientId !== this.clientId) {
-                this.lastControlMessageWasSentbyMe = false;
-            }
-            if (this.lastControlMessageWasSentbyMe) {
-                return; // shortcut!
+            this.handleControlChanged(body as ControlChangedBody);
+        }
+        else if (message === "onControlChangedBatch") {
+            for (let controlChangedBody of body as ControlChangedBody[]) {
+                this.handleControlChanged(controlChangedBody);
             }
-
-            this._setPedalboardControlValue(
-                controlChangedBody.instanceId,
-                controlChangedBody.symbol,
-                controlChangedBody.value,
-                false // do NOT notify the server of the change.
-            );
         }
         else if (message === "onOutputVolumeChanged") {
             let value = body as number;
@@ -756,10 +1213,9 @@ export class PiPedalModel //implements PiPedalModel
             }
             this.presetChanged.set(changed);
         } else if (message === "onPresetsChanged") {
-            let presetsChangedBody = body as PresetsChangedBody;
-            let presets = new PresetIndex().deserialize(presetsChangedBody.presets);
-            this.presets.set(presets);
-            this.presetChanged.set(presets.presetChanged);
+            this.setModelPresets(body as PresetsChangedBody);
+        } else if (message === "onPresetsPatched") {
+            this.applyPresetsPatch(body as IndexPatchBody);
         } else if (message === "onPluginPresetsChanged") {
             let pluginUri = body as string;
             this.handlePluginPresetsChanged(pluginUri);
@@ -788,7 +1244,10 @@ export class PiPedalModel //implements PiPedalModel
             );
         } else if (message === "onPedalboardChanged") {
             let pedalChangedBody = body as PedalboardChangedBody;
+            this.setPedalboardVersion(pedalChangedBody.version ?? -1);
             this.setModelPedalboard(new Pedalboard().deserialize(pedalChangedBody.pedalboard));
+        } else if (message === "onPedalboardPatched") {
+            this.applyPedalboardPatch(body as PedalboardPatchBody);
 
         } else if (message === "onMidiValueChanged") {
             let controlChangedBody = body as ControlChangedBody;
@@ -802,6 +1261,20 @@ export class PiPedalModel //implements PiPedalModel
                 this.webSocket?.reply(header.replyTo, "onMidiValueChanged", true);
             }
 
+        } else if (message === "onMidiValuesChanged") {
+            let controlChangedBodies = body as ControlChangedBody[];
+            for (let controlChangedBody of controlChangedBodies) {
+                this._setPedalboardControlValue(
+                    controlChangedBody.instanceId,
+                    controlChangedBody.symbol,
+                    controlChangedBody.value,
+                    false // do NOT notify the server of the change.
+                );
+            }
+            if (header.replyTo) {
+                this.webSocket?.reply(header.replyTo, "onMidiValuesChanged", true);
+            }
+
         } else if (message === "onNotifyMidiListener") {
             let notifyBody = body as { clientHandle: number, cc0: number, cc1: number, cc2: number };
             let clientHandle = notifyBody.clientHandle as number;
@@ -843,8 +1316,9 @@ export class PiPedalModel //implements PiPedalModel
             newSettings.governor = governor;
             this.governorSettings.set(newSettings);
         } else if (message === "onBanksChanged") {
-            let banks = new BankIndex().deserialize(body);
-            this.banks.set(banks);
+            this.setModelBanks(body as BanksChangedBody);
+        } else if (message === "onBanksPatched") {
+            this.applyBanksPatch(body as IndexPatchBody);
         } else if (message === "onVuUpdate") {
             let vuUpdate = body as VuUpdateInfo;
             let item = this.vuSubscriptions[vuUpdate.instanceId];
@@ -856,6 +1330,11 @@ export class PiPedalModel //implements PiPedalModel
             if (header.replyTo) {
                 this.webSocket?.reply(header.replyTo, "onVuUpdate", true);
             }
+        } else if (message === "onEffectTimingUpdate") {
+            let timings = body as EffectTimingInfo[];
+            for (let subscriber of this.effectTimingSubscribers) {
+                subscriber.callback(timings);
+            }
         } else if (message === "onSystemMidiBindingsChanged") {
             let bindings = MidiBinding.deserialize_array(body);
             this.systemMidiBindings.set(bindings);
@@ -864,9 +1343,17 @@ export class PiPedalModel //implements PiPedalModel
 
         } else if (message == "onTone3000AuthChanged") {
             this.hasTone3000Auth.set(body as boolean);
+        } else if (message === "onAudioFilesChanged") {
+            this.onAudioFilesChanged.fire(body as string);
+        } else if (message === "onPresetBundleProgress") {
+            this.onPresetBundleProgress.fire(body as PresetBundleProgress);
         }
         else if (message === "onLv2PluginsChanging") {
             this.onLv2PluginsChanging();
+        } else if (message === "onLv2PluginsUpdated") {
+            this.onLv2PluginsUpdated(
+                UiPlugin.deserialize_array(body.updated),
+                body.removed as string[]);
         } else if (message === "onUpdateStatusChanged") {
             let updateStatus = new UpdateStatus().deserialize(body);
             this.onUpdateStatusChanged(updateStatus);
@@ -976,6 +1463,21 @@ export class PiPedalModel //implements PiPedalModel
         // this.webSocket?.reconnect(); // let the server do it for us.
 
     }
+    onLv2PluginsUpdated(updated: UiPlugin[], removed: string[]): void {
+        let removedUris = new Set<string>(removed);
+        for (let plugin of updated) {
+            removedUris.add(plugin.uri);
+        }
+        let plugins = this.ui_plugins.get().filter((plugin) => !removedUris.has(plugin.uri));
+        plugins.push(...updated);
+        plugins.sort((left, right) => left.name.localeCompare(right.name));
+        this.ui_plugins.set(plugins);
+
+        this.uiPluginsByUri = new Map<string, UiPlugin>();
+        for (let i of plugins) {
+            this.uiPluginsByUri.set(i.uri, i);
+        }
+    }
     setError(message: string): void {
         this.errorMessage.set(message);
         this.setState(State.Error);
@@ -1036,6 +1538,8 @@ export class PiPedalModel //implements PiPedalModel
             return; // page unloading. do NOT change the UI.
         }
         this.vuSubscriptions = [];
+        this.effectTimingSubscribers = [];
+        this.effectTimingServerHandle = undefined;
         this.monitorPatchPropertyListeners = [];
 
         if (this.isAndroidHosted()) {
@@ -1060,8 +1564,8 @@ export class PiPedalModel //implements PiPedalModel
 
         if (this.visibilityState.get() === VisibilityState.Hidden) return;
 
-        // reload state, but not configuration.
-        this.clientId = await this.getWebSocket().request<number>("hello");
+        let resumed = await this.hello();
+        await this.enableBinaryTelemetry();
 
         let newServerVersion = this.serverVersion = await this.getWebSocket().request<PiPedalVersion>("version");
         if (newServerVersion.serverVersion !== this.serverVersion.serverVersion) {
@@ -1069,9 +1573,27 @@ export class PiPedalModel //implements PiPedalModel
             return;
         }
 
-        // anything could have changed while we were disconnected.
+        if (resumed) {
+            // the server has sent the events we missed while we were disconnected.
+            this.setState(State.Ready);
+            return;
+        }
+        // anything could have changed while we were disconnected. Reload state, but not configuration.
         await this.loadServerState();
     }
+
+    // Returns true if the server resumed our previous session.
+    private async hello(): Promise<boolean> {
+        let webSocket = this.getWebSocket();
+        let reply = await webSocket.request<HelloReply>("hello", {
+            sessionToken: this.sessionToken,
+            lastSequence: webSocket.lastEventSequence
+        });
+        this.clientId = reply.clientId;
+        this.sessionToken = reply.sessionToken;
+        webSocket.lastEventSequence = reply.sequence;
+        return reply.resumed;
+    }
     private makeSocketServerUrl(hostName: string, port: number): string {
         return "ws://" + hostName + ":" + port + "/pipedal";
 
@@ -1127,6 +1649,23 @@ export class PiPedalModel //implements PiPedalModel
         }
     }
 
+    // Waveform peaks for an audio file, in the binary format described in AudioPeaks.hpp. null on error.
+    async getAudioFilePeaks(filePath: string): Promise<ArrayBuffer | null> {
+        try {
+            let url =
+                this.varServerUrl
+                + "AudioPeaks?path=" + encodeURIComponent(filePath);
+
+            let response = await fetch(url);
+            if (!response.ok) {
+                return null;
+            }
+            return await response.arrayBuffer();
+        } catch (e) {
+            return null;
+        }
+    }
+
 
     maxFileUploadSize: number = 512 * 1024 * 1024;
     maxPresetUploadSize: number = 1024 * 1024;
@@ -1171,6 +1710,7 @@ export class PiPedalModel //implements PiPedalModel
             this.socketServerUrl,
             {
                 onMessageReceived: this.onSocketMessage,
+                onBinaryMessageReceived: this.onSocketBinaryMessage,
                 onError: this.onSocketError,
                 onConnectionLost: this.onSocketConnectionLost,
                 onReconnect: this.onSocketReconnected,
@@ -1188,7 +1728,8 @@ export class PiPedalModel //implements PiPedalModel
         try {
             this.countryCodes = await this.getWebSocket().request<{ [Name: string]: string }>("getWifiRegulatoryDomains");
 
-            this.clientId = (await this.getWebSocket().request<number>("hello")) as number;
+            await this.hello();
+            await this.enableBinaryTelemetry();
 
             this.preloadImages((await this.getWebSocket().request<string>("imageList")));
         } catch (error) {
@@ -1197,6 +1738,20 @@ export class PiPedalModel //implements PiPedalModel
         }
         return await this.loadServerState();
     }
+    // The catalog URL changes only when the server's plugins do, so the browser cache
+    // can satisfy it across reconnects.
+    private async loadPluginCatalog(): Promise<any> {
+        try {
+            let version = await this.getWebSocket().request<string>("pluginCatalogVersion");
+            let response = await fetch(this.varServerUrl + "pluginCatalog?v=" + encodeURIComponent(version));
+            if (response.ok) {
+                return await response.json();
+            }
+        } catch (e) {
+        }
+        return await this.getWebSocket().request<any>("plugins");
+    }
+
     async loadServerState(): Promise<boolean> {
         try {
             this.serverVersion = await this.getWebSocket().request<PiPedalVersion>("version");
@@ -1206,27 +1761,26 @@ export class PiPedalModel //implements PiPedalModel
             this.hasWifiDevice.set(await this.getWebSocket().request<boolean>("getHasWifi"));
 
             this.ui_plugins.set(
-                UiPlugin.deserialize_array(await this.getWebSocket().request<any>("plugins"))
+                UiPlugin.deserialize_array(await this.loadPluginCatalog())
             );
             // index ui plugins.
             this.uiPluginsByUri = new Map<string, UiPlugin>();
             for (let i of this.ui_plugins.get()) {
                 this.uiPluginsByUri.set(i.uri, i);
             }
-            this.setModelPedalboard(
-                new Pedalboard().deserialize(
-                    await this.getWebSocket().request<Pedalboard>("currentPedalboard")
-                )
-            );
+            let currentPedalboard = await this.getWebSocket().request<PedalboardChangedBody>("currentPedalboardVersioned");
+            // (re)connected: handles from a previous connection may not be valid.
+            this.controlHandles = new Map<string, number>();
+            this.pedalboardVersion = currentPedalboard.version ?? -1;
+            this.refreshControlHandles();
+            this.setModelPedalboard(new Pedalboard().deserialize(currentPedalboard.pedalboard));
             this.plugin_classes.set(new PluginClass().deserialize(
                 await this.getWebSocket().request<any>("pluginClasses")
             ));
             this.validatePluginClasses(this.plugin_classes.get());
 
-            this.presets.set(
-                new PresetIndex().deserialize(
-                    await this.getWebSocket().request<PresetIndex>("getPresets")
-                )
+            this.setModelPresets(
+                await this.getWebSocket().request<PresetsChangedBody>("getPresetsVersioned")
             );
             this.wifiConfigSettings.set(
                 new WifiConfigSettings().deserialize(
@@ -1259,7 +1813,7 @@ export class PiPedalModel //implements PiPedalModel
             this.hasTone3000Auth.set(
                 await this.getWebSocket().request<boolean>("getHasTone3000Auth")
             );
-            this.banks.set(new BankIndex().deserialize(await this.getWebSocket().request<any>("getBankIndex")));
+            this.setModelBanks(await this.getWebSocket().request<BanksChangedBody>("getBankIndexVersioned"));
 
             this.favorites.set(await this.getWebSocket().request<FavoritesList>("getFavorites"));
 
@@ -1330,6 +1884,7 @@ export class PiPedalModel //implements PiPedalModel
     enterBackgroundState_() {
         if (this.state.get() !== State.Background) {
             console.log("Entering background state.");
+            this.sendTelemetryRate(false);
             this.visibilityState.set(VisibilityState.Hidden);
             this.setState(State.Background);
             this.webSocket?.enterBackgroundState();
@@ -1711,6 +2266,57 @@ export class PiPedalModel //implements PiPedalModel
     }
 
 
+    setPedalboardItemHardBypass(instanceId: number, hardBypass: boolean): void {
+        let pedalboard = this.pedalboard.get();
+        if (pedalboard === undefined) throw new PiPedalStateError("Pedalboard not ready.");
+        let newPedalboard = pedalboard.clone();
+        let item = newPedalboard.getItem(instanceId);
+        if (hardBypass !== item.hardBypass) {
+            item.hardBypass = hardBypass;
+            this.setModelPedalboard(newPedalboard);
+            let body = {
+                clientId: this.clientId,
+                instanceId: instanceId,
+                hardBypass: hardBypass
+            };
+            this.webSocket?.send("setPedalboardItemHardBypass", body);
+        }
+    }
+
+    setPedalboardItemEssential(instanceId: number, essential: boolean): void {
+        let pedalboard = this.pedalboard.get();
+        if (pedalboard === undefined) throw new PiPedalStateError("Pedalboard not ready.");
+        let newPedalboard = pedalboard.clone();
+        let item = newPedalboard.getItem(instanceId);
+        if (essential !== item.essential) {
+            item.essential = essential;
+            this.setModelPedalboard(newPedalboard);
+            let body = {
+                clientId: this.clientId,
+                instanceId: instanceId,
+                essential: essential
+            };
+            this.webSocket?.send("setPedalboardItemEssential", body);
+        }
+    }
+
+    setPedalboardItemAlwaysRun(instanceId: number, alwaysRun: boolean): void {
+        let pedalboard = this.pedalboard.get();
+        if (pedalboard === undefined) throw new PiPedalStateError("Pedalboard not ready.");
+        let newPedalboard = pedalboard.clone();
+        let item = newPedalboard.getItem(instanceId);
+        if (alwaysRun !== item.alwaysRun) {
+            item.alwaysRun = alwaysRun;
+            this.setModelPedalboard(newPedalboard);
+            let body = {
+                clientId: this.clientId,
+                instanceId: instanceId,
+                alwaysRun: alwaysRun
+            };
+            this.webSocket?.send("setPedalboardItemAlwaysRun", body);
+        }
+    }
+
     getPedalboardItemEnabled(instanceId: number): boolean {
         if (!this.pedalboard.get().hasItem(instanceId)) return false;
         let item = this.pedalboard.get().getItem(instanceId);
@@ -1801,6 +2407,18 @@ export class PiPedalModel //implements PiPedalModel
 
     }
     private _setServerControl(message: string, instanceId: number, key: string, value: number) {
+        let handle = this.controlHandles.get(instanceId + ":" + key);
+        if (handle !== undefined) {
+            // skips symbol lookups on the server.
+            let handleBody: ControlHandleValueBody = {
+                clientId: this.clientId,
+                version: this.controlHandlesVersion,
+                handle: handle,
+                value: value
+            };
+            this.webSocket?.send(message + "ByHandle", handleBody);
+            return;
+        }
         let body: ControlChangedBody = {
             clientId: this.clientId,
             instanceId: instanceId,
@@ -2167,13 +2785,28 @@ export class PiPedalModel //implements PiPedalModel
         return nullCast(this.webSocket)
             .request<string[]>('requestFileList', piPedalFileProperty);
     }
-    requestFileList2(relativeDirectoryPath: string, piPedalFileProperty: UiFileProperty): Promise<FileRequestResult> {
+    // pageSize 0 requests all files. Pass the previous result's continuationToken to get the next page.
+    // sortKey orders audio track listings: "position" (default), "title", "artist", "album", "duration" or "fileName".
+    requestFileList2(
+        relativeDirectoryPath: string, piPedalFileProperty: UiFileProperty,
+        pageSize: number = 0, continuationToken: string = "", sortKey: string = ""
+    ): Promise<FileRequestResult> {
         return nullCast(this.webSocket)
             .request<FileRequestResult>('requestFileList2',
-                { relativePath: relativeDirectoryPath, fileProperty: piPedalFileProperty }
+                {
+                    relativePath: relativeDirectoryPath, fileProperty: piPedalFileProperty,
+                    sortKey: sortKey, pageSize: pageSize, continuationToken: continuationToken
+                }
             );
     }
 
+    // Searches the plugin catalog on the server, returning one page of results.
+    async searchPlugins(request: PluginSearchRequest): Promise<PluginSearchResult> {
+        return new PluginSearchResult().deserialize(
+            await nullCast(this.webSocket).request<any>('searchPlugins', request)
+        );
+    }
+
     deleteUserFile(fileName: string): Promise<boolean> {
         return nullCast(this.webSocket).request<boolean>('deleteUserFile', fileName);
     }
@@ -2261,7 +2894,8 @@ export class PiPedalModel //implements PiPedalModel
 
     monitorPortSubscriptions: MonitorPortHandleImpl[] = [];
 
-    monitorPort(instanceId: number, key: string, updateRateSeconds: number, onUpdated: (value: number) => void): MonitorPortHandle {
+    // epsilon: changes smaller than epsilon are not reported.
+    monitorPort(instanceId: number, key: string, updateRateSeconds: number, onUpdated: (value: number) => void, epsilon: number = 0): MonitorPortHandle {
         let result = new MonitorPortHandleImpl(instanceId, key, onUpdated);
         this.monitorPortSubscriptions.push(result);
         if (!this.webSocket) return result;
@@ -2271,7 +2905,8 @@ export class PiPedalModel //implements PiPedalModel
             {
                 instanceId: instanceId,
                 key: key,
-                updateRate: updateRateSeconds
+                updateRate: updateRateSeconds,
+                epsilon: epsilon
             })
             .then((handle) => {
                 if (result.valid) {
@@ -2359,6 +2994,42 @@ export class PiPedalModel //implements PiPedalModel
         }
 
     }
+    effectTimingSubscribers: EffectTimingSubscriptionHandleImpl[] = [];
+    effectTimingServerHandle?: number;
+
+    // Per-effect execution times, updated about once a second. Timing has a small cost on the audio thread, 
+    // so only subscribe while the timings are being displayed.
+    addEffectTimingSubscription(handler: EffectTimingHandler): EffectTimingSubscriptionHandle {
+        let result = new EffectTimingSubscriptionHandleImpl(handler);
+        if (!this.webSocket) return result;
+
+        this.effectTimingSubscribers.push(result);
+        if (this.effectTimingSubscribers.length === 1) {
+            this.webSocket.request<number>("addEffectTimingSubscription")
+                .then((subscriptionHandle) => {
+                    if (this.effectTimingSubscribers.length === 0) {
+                        this.webSocket?.send("removeEffectTimingSubscription", subscriptionHandle);
+                    } else {
+                        this.effectTimingServerHandle = subscriptionHandle;
+                    }
+                });
+        }
+        return result;
+    }
+
+    removeEffectTimingSubscription(handle: EffectTimingSubscriptionHandle): void {
+        let handleImpl = handle as EffectTimingSubscriptionHandleImpl;
+        let index = this.effectTimingSubscribers.indexOf(handleImpl);
+        if (index === -1) {
+            return;
+        }
+        this.effectTimingSubscribers.splice(index, 1);
+        if (this.effectTimingSubscribers.length === 0 && this.effectTimingServerHandle !== undefined) {
+            this.webSocket?.send("removeEffectTimingSubscription", this.effectTimingServerHandle);
+            this.effectTimingServerHandle = undefined;
+        }
+    }
+
     private isClosed = false;
     close() {
         if (!this.isClosed) {
@@ -2478,6 +3149,52 @@ export class PiPedalModel //implements PiPedalModel
         return result;
     }
 
+    // Measures round-trip latency of the current audio configuration through a loopback cable
+    // (inputChannel <- outputChannel), then runs the current preset for stressSeconds, counting xruns.
+    measureLatency(inputChannel: number, outputChannel: number, stressSeconds: number): Promise<LatencyMeasurement> {
+        return new Promise<LatencyMeasurement>((resolve, reject) => {
+            if (!this.webSocket) {
+                reject("No connection to server.");
+            } else {
+                this.webSocket.request<any>("measureLatency", { inputChannel: inputChannel, outputChannel: outputChannel, stressSeconds: stressSeconds })
+                    .then((data) => {
+                        resolve(new LatencyMeasurement().deserialize(data));
+                    })
+                    .catch(error => reject(error));
+            }
+        });
+    }
+
+    getLatencyMeasurements(): Promise<LatencyMeasurement[]> {
+        return new Promise<LatencyMeasurement[]>((resolve, reject) => {
+            if (!this.webSocket) {
+                reject("No connection to server.");
+            } else {
+                this.webSocket.request<any[]>("getLatencyMeasurements")
+                    .then((data) => {
+                        resolve(LatencyMeasurement.deserialize_array(data));
+                    })
+                    .catch(error => reject(error));
+            }
+        });
+    }
+
+    // Update banks from another PiPedal server ("host" or "host:port"). Only changed presets and
+    // missing media files are transferred. Progress is reported as "sync" preset bundle progress.
+    syncBanksFrom(peer: string): Promise<BankSyncResult> {
+        return new Promise<BankSyncResult>((resolve, reject) => {
+            if (!this.webSocket) {
+                reject("No connection to server.");
+            } else {
+                this.webSocket.request<BankSyncResult>("syncBanks", peer)
+                    .then((data) => {
+                        resolve(data);
+                    })
+                    .catch(error => reject(error));
+            }
+        });
+    }
+
     presetCache: { [uri: string]: PluginUiPresets } = {};
 
 
@@ -3095,6 +3812,21 @@ export class PiPedalModel //implements PiPedalModel
     }
 
 
+    // Add hardware counter results to effect timings (server-side diagnostic; adds audio thread overhead).
+    setPmuProfiling(enabled: boolean): void {
+        this.webSocket?.send("setPmuProfiling", enabled);
+    }
+
+    // Report plugins that produce subnormal output in effect timings (server-side diagnostic).
+    setDenormalDetection(enabled: boolean): void {
+        this.webSocket?.send("setDenormalDetection", enabled);
+    }
+
+    // Scan for Wi-Fi networks. Scans are otherwise suspended while audio is running.
+    requestWifiScan(): void {
+        this.webSocket?.send("requestWifiScan");
+    }
+
     getKnownWifiNetworks(): Promise<string[]> {
         let result = new Promise<string[]>((resolve, reject) => {
             if (!this.webSocket) {
@@ -3424,6 +4156,18 @@ export class PiPedalModel //implements PiPedalModel
         }
         throw new Error("No connection.");
     }
+    async getPluginCostEstimates(): Promise<PluginCostEstimate[]> {
+        if (this.webSocket) {
+            return await this.webSocket.request<PluginCostEstimate[]>("getPluginCostEstimates");
+        }
+        throw new Error("No connection.");
+    }
+    async estimatePresetLoad(presetId: number): Promise<PresetLoadEstimate> {
+        if (this.webSocket) {
+            return await this.webSocket.request<PresetLoadEstimate>("estimatePresetLoad", presetId);
+        }
+        throw new Error("No connection.");
+    }
     async getAlsaSequencerPorts(): Promise<AlsaSequencerPortSelection[]> {
         if (this.webSocket) {
             let result = await this.webSocket.request<AlsaSequencerPortSelection[]>("getAlsaSequencerPorts");
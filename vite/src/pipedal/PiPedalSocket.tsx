@@ -32,12 +32,14 @@ export type PiPedalMessageHeader = {
     replyTo?: number;
     reply?: number;
     message: string;
+    seq?: number; // sequence number of a server event, when the session is resumable.
 }
 type ReplyHandler = (header: PiPedalMessageHeader, body: any | null) => void;
 
 
 export interface PiPedalSocketListener {
     onMessageReceived: (header: PiPedalMessageHeader, body: any | null) => void;
+    onBinaryMessageReceived: (data: ArrayBuffer) => void;
     onError: (message: string, exception?: Error) => void;
     onConnectionLost: () => void;
     onReconnect: () => void;
@@ -56,6 +58,8 @@ class PiPedalSocket {
     retryCount: number = 0;
     retryDelay: number = 0;
     totalRetryDelay: number = 0;
+    // The last server event received. Sent when reconnecting, so that the server can send only the events that were missed.
+    lastEventSequence: number = 0;
 
     constructor(
         url: string,
@@ -138,7 +142,11 @@ class PiPedalSocket {
             }
         });
     }
-    handleMessage(event: MessageEvent<string>): any {
+    handleMessage(event: MessageEvent<string | ArrayBuffer>): any {
+        if (event.data instanceof ArrayBuffer) {
+            this.listener.onBinaryMessageReceived(event.data);
+            return;
+        }
         try {
             let message: any = JSON.parse(event.data);
             if (!Array.isArray(message)) {
@@ -159,6 +167,9 @@ class PiPedalSocket {
                 if (header.message === "error") {
                     throw new PiPedalStateError("Server error: " + body);
                 }
+                if (header.seq !== undefined) {
+                    this.lastEventSequence = header.seq;
+                }
                 this.listener.onMessageReceived(header, body);
             }
         } catch (error) {
@@ -269,6 +280,7 @@ class PiPedalSocket {
         return new Promise<WebSocket>((resolve, reject) => {
             try {
                 let ws = new WebSocket(this.url);
+                ws.binaryType = "arraybuffer";
 
                 let self = this;
 
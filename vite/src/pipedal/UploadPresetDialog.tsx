@@ -19,7 +19,8 @@
 
 import React from 'react';
 import Button from '@mui/material/Button';
-import {PiPedalModel,PiPedalModelFactory} from './PiPedalModel';
+import {PiPedalModel,PiPedalModelFactory,PresetBundleProgress} from './PiPedalModel';
+import LinearProgress from '@mui/material/LinearProgress';
 
 import DialogEx from './DialogEx';
 import DialogTitle from '@mui/material/DialogTitle';
@@ -46,6 +47,7 @@ export interface UploadPresetDialogProps {
 
 export interface UploadPresetDialogState {
     fullScreen: boolean;
+    importProgress: number | null;
 };
 
 export default class UploadPresetDialog extends ResizeResponsiveComponent<UploadPresetDialogProps, UploadPresetDialogState> {
@@ -55,7 +57,8 @@ export default class UploadPresetDialog extends ResizeResponsiveComponent<Upload
     constructor(props: UploadPresetDialogProps) {
         super(props);
         this.state = {
-            fullScreen: false
+            fullScreen: false,
+            importProgress: null
         };
         this.model = PiPedalModelFactory.getInstance();
 
@@ -69,15 +72,21 @@ export default class UploadPresetDialog extends ResizeResponsiveComponent<Upload
     }
 
 
+    private handlePresetBundleProgress = (progress: PresetBundleProgress) => {
+        if (!this.mounted || progress.operation !== "import") return;
+        let percent = progress.bytesTotal === 0 ? 100 : progress.bytesProcessed * 100 / progress.bytesTotal;
+        this.setState({ importProgress: percent });
+    };
+
     componentDidMount() {
         super.componentDidMount();
         this.mounted = true;
-        
+        this.model.onPresetBundleProgress.addEventHandler(this.handlePresetBundleProgress);
     }
     componentWillUnmount() {
         super.componentWillUnmount();
         this.mounted = false;
-        
+        this.model.onPresetBundleProgress.removeEventHandler(this.handlePresetBundleProgress);
     }
 
     componentDidUpdate() {
@@ -104,6 +113,9 @@ export default class UploadPresetDialog extends ResizeResponsiveComponent<Upload
         } catch(error) {
             this.model.showAlert(error +"");
         };
+        if (this.mounted) {
+            this.setState({ importProgress: null });
+        }
         this.props.onClose();
     }
     handleDrop(e: React.DragEvent<HTMLDivElement>) {
@@ -180,6 +192,9 @@ export default class UploadPresetDialog extends ResizeResponsiveComponent<Upload
                     >
                         <Typography  noWrap color="textSecondary" align="center" variant="caption" style={{verticalAlign: "middle"}} >Drop files here</Typography>
                     </div>
+                    {this.state.importProgress !== null && (
+                        <LinearProgress variant="determinate" value={this.state.importProgress} style={{ marginTop: 16 }} />
+                    )}
                 </DialogContent>
 
                 <DialogActions>
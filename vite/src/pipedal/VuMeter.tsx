@@ -254,12 +254,15 @@ export const VuMeter =
             requestedStereoState: boolean = false;
 
             private currentDisplayValue: string | null = null;
-            updateText(telltaleDb: number)
+            updateText(telltaleDb: number, idle: boolean)
             {
 
                 if (this.textRef.current) {
                     let displayValue: string; 
-                    if (telltaleDb <= MIN_DB)
+                    if (idle)
+                    {
+                        displayValue = "idle";
+                    } else if (telltaleDb <= MIN_DB)
                     {
                         displayValue = "-";
                     } else {
@@ -363,11 +366,13 @@ export const VuMeter =
                 }
                 if (this.props.displayText)
                 {
+                    // the effect is skipped while its input is silent.
+                    let idle = this.props.display === "output" && vuInfo.isIdle === true;
                     if (this.state.isStereo)
                     {
-                        this.updateText(Math.max(this.telltaleStateL.telltaleHoldValue,this.telltaleStateR.telltaleHoldValue));
+                        this.updateText(Math.max(this.telltaleStateL.telltaleHoldValue,this.telltaleStateR.telltaleHoldValue), idle);
                     } else {
-                        this.updateText(this.telltaleStateL.telltaleHoldValue);
+                        this.updateText(this.telltaleStateL.telltaleHoldValue, idle);
                     }
                 }
             }
@@ -165,6 +165,7 @@ const WifiConfigDialog = withStyles(
             }
         }
         requestKnownWifiNetworks() {
+            this.model.requestWifiScan();
             this.model.getKnownWifiNetworks()
                 .then((networks: string[]) => {
                     if (this.mounted) {